@@ -70,6 +70,17 @@ fi
 
 
 
+# If the privileged helper (gsmartcontrol-agent --dbus) is installed and lets
+# us run smartctl (the "disk" group), root is not needed.
+if [ "$GSMARTCONTROL_SU" = "" ] && [ "$(id -u)" != "0" ] \
+		&& [ -f "@CMAKE_INSTALL_FULL_DATADIR@/dbus-1/system-services/org.gsmartcontrol.Agent.service" ] \
+		&& id -nG | grep -qw "disk"; then
+	eval "\"$EXEC_BIN\" $final_args_quoted";
+	exit $?;
+fi
+
+
+
 # They're basically the same, only the order is different.
 # pkexec is for PolKit.
 # sux requires xterm to ask for the password.
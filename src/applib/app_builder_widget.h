@@ -15,8 +15,10 @@ Copyright:
 #include <glibmm.h>
 #include <glibmm/i18n.h>
 #include <gtkmm.h>
+#include <gio/gio.h>  // g_resources_get_info
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <utility>
 
@@ -28,6 +30,11 @@ Copyright:
 
 
 
+/// GResource path prefix of the compiled-in UI files
+inline constexpr std::string_view app_builder_ui_resource_prefix = "/org/gsmartcontrol/ui";
+
+
+
 /// Connect member function (callback) to signal \ref signal_name on widget
 /// \ref ui_element, where \ref ui_element is the widget's gtkbuilder name.
 /// This allows easy attaching of gtkbuilder widget signals to member functions.
@@ -141,9 +148,17 @@ std::shared_ptr<Child> AppBuilderWidget<Child, MultiInstance, WidgetType>::creat
 
 	std::string error_msg;
 
-	auto ui_path = hz::data_file_find("ui", std::string(Child::ui_name) + ".glade");
 	try {
-		auto ui = Gtk::Builder::create_from_file(hz::fs_path_to_string(ui_path));  // may throw
+		// Prefer the UI compiled into the binary (see gui/ui/CMakeLists.txt), it doesn't have
+		// to be located and read from disk. Fall back to the installed files if it's not there.
+		Glib::RefPtr<Gtk::Builder> ui;
+		const std::string resource_path = std::string(app_builder_ui_resource_prefix) + "/" + std::string(Child::ui_name) + ".glade";
+		if (g_resources_get_info(resource_path.c_str(), G_RESOURCE_LOOKUP_FLAGS_NONE, nullptr, nullptr, nullptr)) {
+			ui = Gtk::Builder::create_from_resource(resource_path);  // may throw
+		} else {
+			auto ui_path = hz::data_file_find("ui", std::string(Child::ui_name) + ".glade");
+			ui = Gtk::Builder::create_from_file(hz::fs_path_to_string(ui_path));  // may throw
+		}
 
 		Child* raw_obj = nullptr;
 		ui->get_widget_derived({Child::ui_name.data(), Child::ui_name.size()}, raw_obj);  // Calls Child's constructor
@@ -0,0 +1,72 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>  // std::max
+
+#include "app_cancellation.h"
+
+
+
+void AppCancellation::cancel()
+{
+	cancelled_ = true;
+}
+
+
+
+void AppCancellation::set_deadline(std::chrono::steady_clock::time_point deadline)
+{
+	// The epoch of steady_clock is far in the past, this never clashes with no_deadline.
+	deadline_ = deadline.time_since_epoch().count();
+}
+
+
+
+void AppCancellation::set_timeout(std::chrono::steady_clock::duration timeout)
+{
+	if (timeout <= std::chrono::steady_clock::duration::zero()) {
+		deadline_ = no_deadline;
+	} else {
+		set_deadline(std::chrono::steady_clock::now() + timeout);
+	}
+}
+
+
+
+bool AppCancellation::is_cancelled() const
+{
+	return cancelled_ || get_deadline_passed();
+}
+
+
+
+bool AppCancellation::get_deadline_passed() const
+{
+	const auto deadline = deadline_.load();
+	return deadline != no_deadline && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline;
+}
+
+
+
+std::optional<std::chrono::steady_clock::duration> AppCancellation::get_time_left() const
+{
+	const auto deadline = deadline_.load();
+	if (deadline == no_deadline) {
+		return std::nullopt;
+	}
+	const auto left = std::chrono::steady_clock::duration(deadline) - std::chrono::steady_clock::now().time_since_epoch();
+	return std::max(left, std::chrono::steady_clock::duration::zero());
+}
+
+
+
+
+/// @}
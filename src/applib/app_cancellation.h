@@ -0,0 +1,76 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef APP_CANCELLATION_H
+#define APP_CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+
+
+
+/// Cancellation token of a long operation (e.g. a drive scan), shared between the operation
+/// and whoever controls it. The operation checks is_cancelled() between its steps (the executors
+/// created by a factory with this token stop their commands, see CommandExecutor::set_cancellation()).
+/// The token is cancelled explicitly with cancel(), or implicitly when its deadline passes.
+/// This class is thread-safe.
+class AppCancellation {
+	public:
+
+		/// Cancel the operation
+		void cancel();
+
+		/// Set a deadline after which the token counts as cancelled (see get_deadline_passed()).
+		void set_deadline(std::chrono::steady_clock::time_point deadline);
+
+		/// Set the deadline to \c timeout from now. 0 or less removes the deadline.
+		void set_timeout(std::chrono::steady_clock::duration timeout);
+
+		/// Check whether the operation should stop: cancel() was called or the deadline has passed
+		[[nodiscard]] bool is_cancelled() const;
+
+		/// Check whether the deadline has passed (as opposed to an explicit cancel())
+		[[nodiscard]] bool get_deadline_passed() const;
+
+		/// Get the time left until the deadline. std::nullopt if there is no deadline.
+		[[nodiscard]] std::optional<std::chrono::steady_clock::duration> get_time_left() const;
+
+
+	private:
+
+		/// "No deadline" value of deadline_
+		static constexpr std::chrono::steady_clock::rep no_deadline = 0;
+
+		std::atomic<bool> cancelled_ = false;  ///< Set by cancel()
+		std::atomic<std::chrono::steady_clock::rep> deadline_ = no_deadline;  ///< Deadline, as time since epoch
+
+};
+
+
+/// A reference-counting pointer to AppCancellation
+using AppCancellationPtr = std::shared_ptr<AppCancellation>;
+
+
+
+/// Check whether \c cancellation is set and cancelled
+[[nodiscard]] inline bool app_is_cancelled(const AppCancellationPtr& cancellation)
+{
+	return cancellation && cancellation->is_cancelled();
+}
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,419 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef APP_COROUTINE_H
+#define APP_COROUTINE_H
+
+#include <glib.h>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "command_executor.h"
+
+
+/*
+Coroutines running in a Glib main context.
+
+An AppTask is a coroutine which waits (co_await) for the commands, timeouts, etc.
+without blocking the main context and without running nested main loops; the
+main context resumes it when the awaited operation completes. Any number of tasks
+may be waiting in the same context (thread) at once. For example:
+
+	AppTask<bool> fetch_twice(CommandExecutor& ex)
+	{
+		if (!co_await app_co_execute(ex)) {
+			co_return false;
+		}
+		co_await app_co_sleep(std::chrono::seconds(1));
+		co_return co_await app_co_execute(ex);
+	}
+
+	app_task_start(fetch_twice(ex), [](bool success) { ... });
+
+Tasks are started lazily: either co_await them from another task, or start them
+with app_task_start() from regular code. The awaitables must be used in a thread
+with a running (thread-default) main context.
+*/
+
+
+
+template<typename T>
+class AppTask;
+
+
+
+namespace internal {
+
+	/// Result storage of AppTask promises
+	template<typename T>
+	class AppTaskPromiseResult {
+		public:
+
+			/// Store the result
+			void return_value(T value)
+			{
+				value_.emplace(std::move(value));
+			}
+
+			/// Take the result, rethrowing the exception (if any)
+			T take_result()
+			{
+				if (exception_) {
+					std::rethrow_exception(exception_);
+				}
+				return std::move(value_.value());
+			}
+
+			/// Call the completion callback of a started task
+			void call_finished_callback()
+			{
+				if (finished_callback_) {
+					finished_callback_(take_result());
+				}
+			}
+
+			/// Store the completion callback of a started task
+			void set_finished_callback(std::function<void(T)> callback)
+			{
+				finished_callback_ = std::move(callback);
+			}
+
+			/// Store the exception
+			void unhandled_exception()
+			{
+				exception_ = std::current_exception();
+			}
+
+		protected:
+
+			std::optional<T> value_;  ///< Returned value
+			std::exception_ptr exception_;  ///< Thrown exception
+			std::function<void(T)> finished_callback_;  ///< Completion callback, see app_task_start()
+	};
+
+
+	/// Result storage of AppTask<void> promises
+	template<>
+	class AppTaskPromiseResult<void> {
+		public:
+
+			/// Finish
+			void return_void()
+			{ }
+
+			/// Rethrow the exception (if any)
+			void take_result()
+			{
+				if (exception_) {
+					std::rethrow_exception(exception_);
+				}
+			}
+
+			/// Call the completion callback of a started task
+			void call_finished_callback()
+			{
+				take_result();
+				if (finished_callback_) {
+					finished_callback_();
+				}
+			}
+
+			/// Store the completion callback of a started task
+			void set_finished_callback(std::function<void()> callback)
+			{
+				finished_callback_ = std::move(callback);
+			}
+
+			/// Store the exception
+			void unhandled_exception()
+			{
+				exception_ = std::current_exception();
+			}
+
+		protected:
+
+			std::exception_ptr exception_;  ///< Thrown exception
+			std::function<void()> finished_callback_;  ///< Completion callback, see app_task_start()
+	};
+
+
+	/// Promise of AppTask
+	template<typename T>
+	class AppTaskPromise : public AppTaskPromiseResult<T> {
+		public:
+
+			/// Create the task object
+			AppTask<T> get_return_object()
+			{
+				return AppTask<T>(std::coroutine_handle<AppTaskPromise>::from_promise(*this));
+			}
+
+			/// Tasks are started lazily
+			std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			/// Resume the awaiting task, or finish a started one
+			auto final_suspend() noexcept
+			{
+				struct FinalAwaiter {
+					bool await_ready() noexcept
+					{
+						return false;
+					}
+
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<AppTaskPromise> handle) noexcept
+					{
+						AppTaskPromise& promise = handle.promise();
+						if (promise.continuation_) {
+							return promise.continuation_;
+						}
+						// Started with app_task_start(), nobody owns the frame.
+						// An exception thrown by a started task has nowhere to go, so it terminates.
+						promise.call_finished_callback();
+						handle.destroy();
+						return std::noop_coroutine();
+					}
+
+					void await_resume() noexcept
+					{ }
+				};
+				return FinalAwaiter{};
+			}
+
+			/// Set the coroutine to resume when this one finishes
+			void set_continuation(std::coroutine_handle<> continuation)
+			{
+				continuation_ = continuation;
+			}
+
+		private:
+
+			std::coroutine_handle<> continuation_;  ///< Awaiting coroutine, if any
+	};
+
+}
+
+
+
+/// A coroutine task returning T. It's started lazily, by co_await-ing it
+/// or by passing it to app_task_start(). Move-only.
+template<typename T = void>
+class [[nodiscard]] AppTask {
+	public:
+
+		using promise_type = internal::AppTaskPromise<T>;
+
+
+		/// Constructor, used by the promise
+		explicit AppTask(std::coroutine_handle<promise_type> handle)
+				: handle_(handle)
+		{ }
+
+		/// Deleted
+		AppTask(const AppTask& other) = delete;
+
+		/// Move constructor
+		AppTask(AppTask&& other) noexcept
+				: handle_(std::exchange(other.handle_, nullptr))
+		{ }
+
+		/// Deleted
+		AppTask& operator=(const AppTask& other) = delete;
+
+		/// Move assignment
+		AppTask& operator=(AppTask&& other) noexcept
+		{
+			if (this != &other) {
+				if (handle_) {
+					handle_.destroy();
+				}
+				handle_ = std::exchange(other.handle_, nullptr);
+			}
+			return *this;
+		}
+
+		/// Destructor. Destroys the coroutine if it hasn't been started with app_task_start().
+		/// Don't destroy an awaited task before it finishes.
+		~AppTask()
+		{
+			if (handle_) {
+				handle_.destroy();
+			}
+		}
+
+
+		/// Awaiter interface. The task is started and the awaiting coroutine is
+		/// resumed with its result when it finishes.
+		bool await_ready() const noexcept
+		{
+			return !handle_ || handle_.done();
+		}
+
+		/// Awaiter interface
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+		{
+			handle_.promise().set_continuation(awaiting);
+			return handle_;
+		}
+
+		/// Awaiter interface. Returns the result or rethrows the exception of the task.
+		T await_resume()
+		{
+			return handle_.promise().take_result();
+		}
+
+
+		/// Release the coroutine handle (used by app_task_start())
+		std::coroutine_handle<promise_type> release()
+		{
+			return std::exchange(handle_, nullptr);
+		}
+
+
+	private:
+
+		std::coroutine_handle<promise_type> handle_;  ///< Coroutine, nullptr if moved from or released
+
+};
+
+
+
+/// Start a task from regular (non-coroutine) code. It runs until its first suspension
+/// point before this function returns, then it is resumed by the main context.
+/// \c finished_callback (if any) is called with its result when it finishes.
+/// The task frame is destroyed automatically after that.
+template<typename T>
+void app_task_start(AppTask<T> task, std::type_identity_t<std::function<void(T)>> finished_callback = nullptr)
+{
+	auto handle = task.release();
+	handle.promise().set_finished_callback(std::move(finished_callback));
+	handle.resume();
+}
+
+
+/// Start a task from regular (non-coroutine) code, see app_task_start().
+inline void app_task_start(AppTask<void> task, std::function<void()> finished_callback = nullptr)
+{
+	auto handle = task.release();
+	handle.promise().set_finished_callback(std::move(finished_callback));
+	handle.resume();
+}
+
+
+
+namespace internal {
+
+	/// Attach a one-shot source to the thread-default main context, resuming \c handle when dispatched
+	inline void app_co_attach_resume_source(GSource* source, std::coroutine_handle<> handle)
+	{
+		g_source_set_callback(source, [](gpointer data) -> gboolean {
+			std::coroutine_handle<>::from_address(data).resume();
+			return FALSE;
+		}, handle.address(), nullptr);
+		g_source_attach(source, g_main_context_get_thread_default());
+		g_source_unref(source);
+	}
+
+}
+
+
+
+/// Awaitable that suspends the coroutine for \c duration, letting the main context
+/// run other things meanwhile.
+[[nodiscard]] inline auto app_co_sleep(std::chrono::milliseconds duration)
+{
+	struct SleepAwaiter {
+		std::chrono::milliseconds duration;  ///< Sleep duration
+
+		bool await_ready() const noexcept
+		{
+			return duration.count() <= 0;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) const
+		{
+			internal::app_co_attach_resume_source(g_timeout_source_new(guint(duration.count())), handle);
+		}
+
+		void await_resume() const noexcept
+		{ }
+	};
+	return SleepAwaiter{duration};
+}
+
+
+
+/// Awaitable that lets the main context process the pending events before continuing
+/// (e.g. to keep the GUI responsive during a long computation).
+[[nodiscard]] inline auto app_co_yield()
+{
+	struct YieldAwaiter {
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) const
+		{
+			internal::app_co_attach_resume_source(g_idle_source_new(), handle);
+		}
+
+		void await_resume() const noexcept
+		{ }
+	};
+	return YieldAwaiter{};
+}
+
+
+
+/// Awaitable that executes the command of \c executor with CommandExecutor::execute_async()
+/// and resumes the coroutine when it exits. The result is the same as that of
+/// CommandExecutor::execute(). The executor must stay alive until then.
+[[nodiscard]] inline auto app_co_execute(CommandExecutor& executor)
+{
+	struct ExecuteAwaiter {
+		CommandExecutor& executor;  ///< Executor
+		bool executed = false;  ///< Execution result
+
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			// This is always called from the main context, never from execute_async() itself.
+			executor.execute_async([this, handle](bool result) {
+				executed = result;
+				handle.resume();
+			});
+		}
+
+		bool await_resume() const noexcept
+		{
+			return executed;
+		}
+	};
+	return ExecuteAwaiter{executor};
+}
+
+
+
+#endif
+
+/// @}
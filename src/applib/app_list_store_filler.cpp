@@ -0,0 +1,106 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <utility>
+
+#include "app_list_store_filler.h"
+
+
+
+AppListStoreFiller::~AppListStoreFiller()
+{
+	cancel();
+}
+
+
+
+void AppListStoreFiller::start(Glib::RefPtr<Gtk::ListStore> list_store, std::size_t count, RowSetter set_row,
+		std::size_t first_count, std::chrono::microseconds slice_time)
+{
+	cancel();
+	if (!list_store || !set_row) {
+		return;
+	}
+	list_store_ = std::move(list_store);
+	set_row_ = std::move(set_row);
+	count_ = count;
+	appended_count_ = 0;
+	slice_time_ = slice_time;
+
+	for (const std::size_t end = std::min(first_count, count_); appended_count_ < end; ++appended_count_) {
+		Gtk::TreeRow row = *(list_store_->append());
+		set_row_(row, appended_count_);
+	}
+
+	if (appended_count_ < count_) {
+		// Default idle priority is below the redraw priority, so the first rows are drawn before the rest is added.
+		idle_connection_ = Glib::signal_idle().connect(sigc::mem_fun(*this, &AppListStoreFiller::on_idle));
+	} else {
+		reset();
+	}
+}
+
+
+
+void AppListStoreFiller::cancel()
+{
+	idle_connection_.disconnect();
+	reset();
+}
+
+
+
+bool AppListStoreFiller::is_running() const
+{
+	return idle_connection_.connected();
+}
+
+
+
+std::size_t AppListStoreFiller::get_appended_count() const
+{
+	return appended_count_;
+}
+
+
+
+bool AppListStoreFiller::on_idle()
+{
+	// At least one row per slice, so that a slow setter still makes progress
+	const auto deadline = std::chrono::steady_clock::now() + slice_time_;
+	do {
+		Gtk::TreeRow row = *(list_store_->append());
+		set_row_(row, appended_count_);
+		++appended_count_;
+	} while (appended_count_ < count_ && std::chrono::steady_clock::now() < deadline);
+
+	if (appended_count_ < count_) {
+		return true;  // continue
+	}
+	reset();
+	return false;  // disconnect
+}
+
+
+
+void AppListStoreFiller::reset()
+{
+	list_store_.reset();
+	set_row_ = nullptr;
+	count_ = 0;
+}
+
+
+
+
+
+/// @}
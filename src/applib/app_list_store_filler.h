@@ -0,0 +1,95 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef APP_LIST_STORE_FILLER_H
+#define APP_LIST_STORE_FILLER_H
+
+#include <gtkmm.h>
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <functional>
+
+
+
+/// Appends rows to a Gtk::ListStore in idle time slices, so that filling a table with
+/// thousands of rows doesn't block the main loop. The first rows (about a screenful) are
+/// appended immediately, the rest in idle callbacks, each taking at most the slice time;
+/// the redraws run in between. The rows should be supplied in their display order, so
+/// that a sorted list store doesn't have to move them.
+/// The fill is cancelled by cancel(), by starting a new one, or by destruction.
+class AppListStoreFiller {
+	public:
+
+		/// Sets the cells of row number \c index
+		using RowSetter = std::function<void(Gtk::TreeRow& row, std::size_t index)>;
+
+		/// Number of rows appended immediately by default
+		static constexpr std::size_t default_first_count = 100;
+
+		/// Maximum duration of an idle callback by default
+		static constexpr std::chrono::milliseconds default_slice_time {8};
+
+
+		/// Constructor
+		AppListStoreFiller() = default;
+
+		/// Deleted
+		AppListStoreFiller(const AppListStoreFiller&) = delete;
+
+		/// Deleted
+		AppListStoreFiller& operator=(const AppListStoreFiller&) = delete;
+
+		/// Destructor, cancels the fill
+		~AppListStoreFiller();
+
+
+		/// Append \c count rows to \c list_store, calling \c set_row for each. The first
+		/// \c first_count rows are appended before returning. A running fill is cancelled first.
+		/// \c set_row must stay valid until the fill is finished or cancelled.
+		void start(Glib::RefPtr<Gtk::ListStore> list_store, std::size_t count, RowSetter set_row,
+				std::size_t first_count = default_first_count,
+				std::chrono::microseconds slice_time = default_slice_time);
+
+		/// Stop appending the rows. The rows appended so far stay in the list store.
+		void cancel();
+
+		/// Check whether some rows are still to be appended
+		[[nodiscard]] bool is_running() const;
+
+		/// Get the number of rows appended so far
+		[[nodiscard]] std::size_t get_appended_count() const;
+
+
+	private:
+
+		/// Append a slice of rows. \return true if more rows remain.
+		bool on_idle();
+
+		/// Release the list store and the setter
+		void reset();
+
+
+		Glib::RefPtr<Gtk::ListStore> list_store_;  ///< List store being filled
+		RowSetter set_row_;  ///< Row setter
+		std::size_t count_ = 0;  ///< Total number of rows
+		std::size_t appended_count_ = 0;  ///< Number of rows appended so far
+		std::chrono::microseconds slice_time_ = default_slice_time;  ///< Maximum duration of an idle callback
+		sigc::connection idle_connection_;  ///< Pending on_idle()
+
+};
+
+
+
+
+
+#endif
+
+/// @}
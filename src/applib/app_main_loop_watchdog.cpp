@@ -0,0 +1,260 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>  // std::max
+#include <ctime>
+#include <string_view>
+
+#include "fmt/format.h"
+#include "hz/debug.h"
+#include "hz/format_unit.h"  // format_date
+
+#include "app_main_loop_watchdog.h"
+#include "app_trace.h"
+
+
+
+namespace {
+
+	/// Global watchdog
+	struct WatchdogGlobal {
+		std::mutex mutex;  ///< Protects watchdog
+		std::shared_ptr<AppMainLoopWatchdog> watchdog;  ///< Watchdog
+	};
+
+
+	/// Get the global watchdog
+	WatchdogGlobal& watchdog_get_global_ref()
+	{
+		static WatchdogGlobal global;
+		return global;
+	}
+
+
+	/// Check if a comma-separated list contains \c name
+	bool span_list_contains(std::string_view list, std::string_view name)
+	{
+		while (!list.empty()) {
+			const std::string_view::size_type end = list.find(", ");
+			if (list.substr(0, end) == name) {
+				return true;
+			}
+			if (end == std::string_view::npos) {
+				break;
+			}
+			list.remove_prefix(end + 2);
+		}
+		return false;
+	}
+
+}
+
+
+
+AppMainLoopWatchdog::~AppMainLoopWatchdog()
+{
+	stop();
+}
+
+
+
+void AppMainLoopWatchdog::start(std::chrono::milliseconds threshold, std::size_t max_stalls)
+{
+	if (is_running()) {
+		return;
+	}
+
+	threshold_ = std::max(threshold, std::chrono::milliseconds(1));
+	// Short enough for the heartbeat lateness to be measured precisely, long enough not to wake up too often
+	interval_ = std::max(threshold_ / 2, std::chrono::milliseconds(10));
+	max_stalls_ = std::max<std::size_t>(max_stalls, 1);
+	stall_count_ = 0;
+	max_latency_ = {};
+
+	app_trace_set_watched_thread();
+	last_beat_ns_.store(app_trace_now(), std::memory_order_relaxed);
+
+	main_context_ = g_main_context_ref_thread_default();
+	GSource* source = g_timeout_source_new(static_cast<guint>(interval_.count()));
+	g_source_set_priority(source, G_PRIORITY_HIGH);  // measure the dispatch latency, not the time spent in other sources of the same iteration
+	g_source_set_callback(source, &on_heartbeat_timeout, this, nullptr);
+	heartbeat_id_ = g_source_attach(source, main_context_);
+	g_source_unref(source);
+
+	{
+		const std::scoped_lock lock(sampler_mutex_);
+		sampler_stop_ = false;
+		sampled_spans_.clear();
+	}
+	sampler_thread_ = std::thread(&AppMainLoopWatchdog::sampler_thread_func, this);
+
+	debug_out_info("app", DBG_FUNC_MSG << "Watching main loop stalls over " << threshold_.count() << " ms.\n");
+}
+
+
+
+void AppMainLoopWatchdog::stop()
+{
+	if (sampler_thread_.joinable()) {
+		{
+			const std::scoped_lock lock(sampler_mutex_);
+			sampler_stop_ = true;
+		}
+		sampler_cond_.notify_all();
+		sampler_thread_.join();
+	}
+	if (heartbeat_id_ != 0) {
+		GSource* source = g_main_context_find_source_by_id(main_context_, heartbeat_id_);
+		if (source)
+			g_source_destroy(source);
+		heartbeat_id_ = 0;
+	}
+	if (main_context_) {
+		g_main_context_unref(main_context_);
+		main_context_ = nullptr;
+	}
+}
+
+
+
+bool AppMainLoopWatchdog::is_running() const
+{
+	return heartbeat_id_ != 0;
+}
+
+
+
+std::chrono::milliseconds AppMainLoopWatchdog::get_threshold() const
+{
+	return threshold_;
+}
+
+
+
+const std::deque<AppMainLoopStall>& AppMainLoopWatchdog::get_stalls() const
+{
+	return stalls_;
+}
+
+
+
+std::uint64_t AppMainLoopWatchdog::get_stall_count() const
+{
+	return stall_count_;
+}
+
+
+
+std::chrono::milliseconds AppMainLoopWatchdog::get_max_latency() const
+{
+	return max_latency_;
+}
+
+
+
+std::string AppMainLoopWatchdog::format_stalls() const
+{
+	std::string text = fmt::format("Main loop stalls over {} ms: {}, longest dispatch latency: {} ms\n",
+			threshold_.count(), stall_count_, max_latency_.count());
+	// The most recent first
+	for (auto iter = stalls_.rbegin(); iter != stalls_.rend(); ++iter) {
+		text += fmt::format("{}  {:>6} ms  {}\n",
+				hz::format_date("%Y-%m-%d %H:%M:%S", std::chrono::system_clock::to_time_t(iter->time), true),
+				iter->duration.count(), (iter->spans.empty() ? std::string("[no span]") : iter->spans));
+	}
+	return text;
+}
+
+
+
+void AppMainLoopWatchdog::on_heartbeat()
+{
+	const std::int64_t now_ns = app_trace_now();
+	const std::int64_t late_ns = now_ns - last_beat_ns_.exchange(now_ns, std::memory_order_relaxed)
+			- std::chrono::duration_cast<std::chrono::nanoseconds>(interval_).count();
+	const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(std::max<std::int64_t>(late_ns, 0)));
+
+	std::string spans;
+	{
+		const std::scoped_lock lock(sampler_mutex_);
+		spans.swap(sampled_spans_);
+	}
+
+	max_latency_ = std::max(max_latency_, latency);
+	if (latency < threshold_) {
+		return;
+	}
+
+	++stall_count_;
+	debug_out_warn("app", "Main loop stalled for " << latency.count() << " ms"
+			<< (spans.empty() ? std::string() : (" in " + spans)) << ".\n");
+
+	stalls_.push_back({std::chrono::system_clock::now(), latency, std::move(spans)});
+	while (stalls_.size() > max_stalls_) {
+		stalls_.pop_front();
+	}
+}
+
+
+
+gboolean AppMainLoopWatchdog::on_heartbeat_timeout(gpointer data)
+{
+	static_cast<AppMainLoopWatchdog*>(data)->on_heartbeat();
+	return G_SOURCE_CONTINUE;
+}
+
+
+
+void AppMainLoopWatchdog::sampler_thread_func()
+{
+	const auto threshold_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(threshold_).count();
+	const auto interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(interval_).count();
+	const auto sample_period = std::max(threshold_ / 4, std::chrono::milliseconds(5));
+
+	std::unique_lock lock(sampler_mutex_);
+	while (!sampler_cond_.wait_for(lock, sample_period, [this]() { return sampler_stop_; })) {
+		const std::int64_t overdue_ns = app_trace_now() - last_beat_ns_.load(std::memory_order_relaxed) - interval_ns;
+		if (overdue_ns < threshold_ns) {
+			continue;
+		}
+		const char* span = app_trace_get_watched_span();
+		if (span && !span_list_contains(sampled_spans_, span)) {
+			if (!sampled_spans_.empty()) {
+				sampled_spans_ += ", ";
+			}
+			sampled_spans_ += span;
+		}
+	}
+}
+
+
+
+void app_main_loop_watchdog_set_global(std::shared_ptr<AppMainLoopWatchdog> watchdog)
+{
+	auto& global = watchdog_get_global_ref();
+	const std::scoped_lock lock(global.mutex);
+	global.watchdog = std::move(watchdog);
+}
+
+
+
+std::shared_ptr<AppMainLoopWatchdog> app_main_loop_watchdog_get_global()
+{
+	auto& global = watchdog_get_global_ref();
+	const std::scoped_lock lock(global.mutex);
+	return global.watchdog;
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,141 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef APP_MAIN_LOOP_WATCHDOG_H
+#define APP_MAIN_LOOP_WATCHDOG_H
+
+#include <glib.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+
+/// A main loop stall, recorded by AppMainLoopWatchdog
+struct AppMainLoopStall {
+	std::chrono::system_clock::time_point time;  ///< When the stall ended
+	std::chrono::milliseconds duration = {};  ///< How long the main loop didn't dispatch anything
+	std::string spans;  ///< The spans (see AppTraceSpan) seen active in the main thread during the stall, comma-separated
+};
+
+
+
+/// Measures the dispatch latency of the main loop and records each stall over a threshold,
+/// together with the AppTraceSpan that was active in the main thread at the time.
+/// A heartbeat timeout is attached to the thread-default main context of the thread calling start();
+/// a sampler thread looks at app_trace_get_watched_span() while the heartbeat is overdue.
+/// The stalls are logged to the debug log as well.
+/// All the methods must be called from the thread which called start().
+class AppMainLoopWatchdog {
+	public:
+
+		/// Constructor
+		AppMainLoopWatchdog() = default;
+
+		/// Deleted
+		AppMainLoopWatchdog(const AppMainLoopWatchdog& other) = delete;
+
+		/// Deleted
+		AppMainLoopWatchdog(AppMainLoopWatchdog&& other) = delete;
+
+		/// Deleted
+		AppMainLoopWatchdog& operator=(const AppMainLoopWatchdog&) = delete;
+
+		/// Deleted
+		AppMainLoopWatchdog& operator=(AppMainLoopWatchdog&&) = delete;
+
+		/// Destructor, calls stop().
+		~AppMainLoopWatchdog();
+
+
+		/// Start watching. The calling thread becomes the watched thread (see app_trace_set_watched_thread()).
+		/// The main loop is stalled if it doesn't dispatch the heartbeat for \c threshold longer than scheduled.
+		void start(std::chrono::milliseconds threshold, std::size_t max_stalls = 100);
+
+		/// Stop watching. The recorded stalls are kept.
+		void stop();
+
+		/// Check if start() was called and stop() wasn't called yet
+		[[nodiscard]] bool is_running() const;
+
+
+		/// Get the stall threshold
+		[[nodiscard]] std::chrono::milliseconds get_threshold() const;
+
+		/// Get the most recent stalls, the oldest first
+		[[nodiscard]] const std::deque<AppMainLoopStall>& get_stalls() const;
+
+		/// Get the number of stalls since start(), including the ones not kept anymore
+		[[nodiscard]] std::uint64_t get_stall_count() const;
+
+		/// Get the longest dispatch latency since start()
+		[[nodiscard]] std::chrono::milliseconds get_max_latency() const;
+
+		/// Format the statistics and the recent stalls as text
+		[[nodiscard]] std::string format_stalls() const;
+
+
+	private:
+
+		/// Heartbeat callback, records the stall if it was late
+		void on_heartbeat();
+
+		/// Heartbeat timeout callback
+		static gboolean on_heartbeat_timeout(gpointer data);
+
+		/// Sampler thread function
+		void sampler_thread_func();
+
+
+		std::chrono::milliseconds threshold_ = {};  ///< Stall threshold
+		std::chrono::milliseconds interval_ = {};  ///< Heartbeat interval
+		std::size_t max_stalls_ = 0;  ///< Maximum number of stalls kept
+
+		guint heartbeat_id_ = 0;  ///< Heartbeat timeout source
+		GMainContext* main_context_ = nullptr;  ///< Context the heartbeat is attached to
+
+		std::atomic<std::int64_t> last_beat_ns_ = 0;  ///< Time of the last heartbeat, see app_trace_now()
+
+		std::thread sampler_thread_;  ///< Sampler thread
+		std::mutex sampler_mutex_;  ///< Protects sampler_stop_ and sampled_spans_
+		std::condition_variable sampler_cond_;  ///< Wakes up the sampler thread on stop()
+		bool sampler_stop_ = false;  ///< Whether the sampler thread must exit
+		std::string sampled_spans_;  ///< Spans seen during the current stall, comma-separated
+
+		std::deque<AppMainLoopStall> stalls_;  ///< Recent stalls
+		std::uint64_t stall_count_ = 0;  ///< Number of stalls since start()
+		std::chrono::milliseconds max_latency_ = {};  ///< Longest latency since start()
+
+};
+
+
+
+/// Set the watchdog of the application main loop, shown in the diagnostics window.
+/// nullptr to unset.
+void app_main_loop_watchdog_set_global(std::shared_ptr<AppMainLoopWatchdog> watchdog);
+
+
+/// Get the watchdog set by app_main_loop_watchdog_set_global(), may be nullptr.
+[[nodiscard]] std::shared_ptr<AppMainLoopWatchdog> app_main_loop_watchdog_get_global();
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,110 @@
+/******************************************************************************
+ License: GNU General Public License v3.0 only
+ Copyright:
+ 	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+ ******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "app_regex.h"
+
+
+
+namespace {
+
+
+	/// Maximum number of cached patterns. Most patterns are literals, but
+	/// some are built at runtime (e.g. with app_regex_escape()).
+	constexpr std::size_t app_regex_cache_max_size = 1024;
+
+
+	/// Hash for heterogeneous (string_view) lookups
+	struct AppRegexPatternHash {
+		using is_transparent = void;
+
+		std::size_t operator()(std::string_view s) const
+		{
+			return std::hash<std::string_view>()(s);
+		}
+	};
+
+
+	/// Compiled pattern cache
+	struct AppRegexCache {
+		std::shared_mutex mutex;  ///< Protects \c patterns
+		std::unordered_map<std::string, std::shared_ptr<const std::regex>, AppRegexPatternHash, std::equal_to<>> patterns;  ///< Pattern => compiled regex
+
+		std::atomic<std::uint64_t> hits = 0;  ///< Lookups which found a compiled pattern
+		std::atomic<std::uint64_t> misses = 0;  ///< Lookups which had to compile
+		std::atomic<std::int64_t> compile_time_usec = 0;  ///< Total compilation time on misses
+	};
+
+
+	/// Get the process-wide cache
+	AppRegexCache& get_app_regex_cache()
+	{
+		static AppRegexCache cache;
+		return cache;
+	}
+
+}
+
+
+
+std::shared_ptr<const std::regex> app_regex_re_cached(std::string_view perl_pattern)
+{
+	auto& cache = get_app_regex_cache();
+
+	{
+		const std::shared_lock lock(cache.mutex);
+		if (auto iter = cache.patterns.find(perl_pattern); iter != cache.patterns.end()) {
+			cache.hits.fetch_add(1, std::memory_order_relaxed);
+			return iter->second;
+		}
+	}
+
+	// Compile outside the lock. If another thread compiled the same pattern
+	// meanwhile, the first one inserted wins. This throws std::regex_error on invalid patterns.
+	const auto start_time = std::chrono::steady_clock::now();
+	auto re = std::make_shared<const std::regex>(app_regex_re(std::string(perl_pattern)));
+	const auto compile_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+
+	cache.misses.fetch_add(1, std::memory_order_relaxed);
+	cache.compile_time_usec.fetch_add(compile_time.count(), std::memory_order_relaxed);
+
+	const std::unique_lock lock(cache.mutex);
+	if (cache.patterns.size() >= app_regex_cache_max_size) {
+		return re;  // don't cache it
+	}
+	return cache.patterns.try_emplace(std::string(perl_pattern), std::move(re)).first->second;
+}
+
+
+
+AppRegexCacheStats app_regex_get_cache_stats()
+{
+	auto& cache = get_app_regex_cache();
+
+	AppRegexCacheStats stats;
+	stats.hits = cache.hits.load(std::memory_order_relaxed);
+	stats.misses = cache.misses.load(std::memory_order_relaxed);
+	stats.compile_time = std::chrono::microseconds(cache.compile_time_usec.load(std::memory_order_relaxed));
+
+	const std::shared_lock lock(cache.mutex);
+	stats.size = cache.patterns.size();
+	return stats;
+}
+
+
+
+
+/// @}
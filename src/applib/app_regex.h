@@ -12,8 +12,11 @@
 #ifndef APP_REGEX_H
 #define APP_REGEX_H
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -74,6 +77,31 @@ inline std::regex app_regex_re(const std::string& perl_pattern)
 
 
 
+/// Statistics of the compiled pattern cache, see app_regex_re_cached().
+struct AppRegexCacheStats {
+	std::uint64_t hits = 0;  ///< Number of lookups which found a compiled pattern
+	std::uint64_t misses = 0;  ///< Number of lookups which had to compile the pattern
+	std::chrono::microseconds compile_time{0};  ///< Total time spent compiling the patterns on misses
+	std::size_t size = 0;  ///< Number of cached patterns
+};
+
+
+
+/// Get a compiled regular expression for a pattern in "/pattern/modifiers" form
+/// (see app_regex_re()) from a process-wide cache, compiling it on first use.
+/// The patterns are literals in most of the call sites, so they're never evicted,
+/// but the cache stops growing after a limit (the patterns are compiled each time then).
+/// Thread-safe.
+[[nodiscard]] std::shared_ptr<const std::regex> app_regex_re_cached(std::string_view perl_pattern);
+
+
+/// Get the compiled pattern cache statistics. Thread-safe.
+[[nodiscard]] AppRegexCacheStats app_regex_get_cache_stats();
+
+
+
+
+
 /// Partially match a string against a regular expression.
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const std::regex& re, const std::string& str)
@@ -86,7 +114,7 @@ inline bool app_regex_partial_match(const std::regex& re, const std::string& str
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const std::string& perl_pattern, const std::string& str)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str);
 }
 
 
@@ -94,7 +122,7 @@ inline bool app_regex_partial_match(const std::string& perl_pattern, const std::
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const char* perl_pattern, const std::string& str)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str);
 }
 
 
@@ -111,7 +139,7 @@ inline bool app_regex_partial_match(const std::regex& re, const std::string& str
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const std::string& perl_pattern, const std::string& str, std::smatch& matches)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str, matches);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str, matches);
 }
 
 
@@ -119,7 +147,7 @@ inline bool app_regex_partial_match(const std::string& perl_pattern, const std::
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const char* perl_pattern, const std::string& str, std::smatch& matches)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str, matches);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str, matches);
 }
 
 
@@ -143,7 +171,7 @@ inline bool app_regex_partial_match(const std::regex& re, const std::string& str
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const std::string& perl_pattern, const std::string& str, std::string* first_submatch)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str, first_submatch);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str, first_submatch);
 }
 
 
@@ -151,7 +179,7 @@ inline bool app_regex_partial_match(const std::string& perl_pattern, const std::
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const char* perl_pattern, const std::string& str, std::string* first_submatch)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str, first_submatch);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str, first_submatch);
 }
 
 
@@ -178,7 +206,7 @@ inline bool app_regex_partial_match(const std::regex& re, const std::string& str
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const std::string& perl_pattern, const std::string& str, std::vector<std::string*> matches_vector)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str, matches_vector);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str, matches_vector);
 }
 
 
@@ -186,7 +214,7 @@ inline bool app_regex_partial_match(const std::string& perl_pattern, const std::
 /// \return true if a match was found.
 inline bool app_regex_partial_match(const char* perl_pattern, const std::string& str, std::vector<std::string*> matches_vector)
 {
-	return app_regex_partial_match(app_regex_re(perl_pattern), str, matches_vector);
+	return app_regex_partial_match(*app_regex_re_cached(perl_pattern), str, matches_vector);
 }
 
 
@@ -205,7 +233,7 @@ inline bool app_regex_full_match(const std::regex& re, const std::string& str)
 /// \return true if a match was found.
 inline bool app_regex_full_match(const std::string& perl_pattern, const std::string& str)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str);
 }
 
 
@@ -213,7 +241,7 @@ inline bool app_regex_full_match(const std::string& perl_pattern, const std::str
 /// \return true if a match was found.
 inline bool app_regex_full_match(const char* perl_pattern, const std::string& str)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str);
 }
 
 
@@ -230,7 +258,7 @@ inline bool app_regex_full_match(const std::regex& re, const std::string& str, s
 /// \return true if a match was found.
 inline bool app_regex_full_match(const std::string& perl_pattern, const std::string& str, std::smatch& matches)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str, matches);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str, matches);
 }
 
 
@@ -238,7 +266,7 @@ inline bool app_regex_full_match(const std::string& perl_pattern, const std::str
 /// \return true if a match was found.
 inline bool app_regex_full_match(const char* perl_pattern, const std::string& str, std::smatch& matches)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str, matches);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str, matches);
 }
 
 
@@ -262,7 +290,7 @@ inline bool app_regex_full_match(const std::regex& re, const std::string& str, s
 /// \return true if a match was found.
 inline bool app_regex_full_match(const std::string& perl_pattern, const std::string& str, std::string* first_submatch)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str, first_submatch);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str, first_submatch);
 }
 
 
@@ -270,7 +298,7 @@ inline bool app_regex_full_match(const std::string& perl_pattern, const std::str
 /// \return true if a match was found.
 inline bool app_regex_full_match(const char* perl_pattern, const std::string& str, std::string* first_submatch)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str, first_submatch);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str, first_submatch);
 }
 
 
@@ -297,7 +325,7 @@ inline bool app_regex_full_match(const std::regex& re, const std::string& str, s
 /// \return true if a match was found.
 inline bool app_regex_full_match(const std::string& perl_pattern, const std::string& str, std::vector<std::string*> matches_vector)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str, matches_vector);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str, matches_vector);
 }
 
 
@@ -305,7 +333,7 @@ inline bool app_regex_full_match(const std::string& perl_pattern, const std::str
 /// \return true if a match was found.
 inline bool app_regex_full_match(const char* perl_pattern, const std::string& str, std::vector<std::string*> matches_vector)
 {
-	return app_regex_full_match(app_regex_re(perl_pattern), str, matches_vector);
+	return app_regex_full_match(*app_regex_re_cached(perl_pattern), str, matches_vector);
 }
 
 
@@ -326,7 +354,7 @@ inline void app_regex_replace(const std::regex& re, const std::string& replaceme
 /// \return number of replacements made.
 inline void app_regex_replace(const std::string& perl_pattern, const std::string& replacement, std::string& subject)
 {
-	app_regex_replace(app_regex_re(perl_pattern), replacement, subject);
+	app_regex_replace(*app_regex_re_cached(perl_pattern), replacement, subject);
 }
 
 
@@ -335,7 +363,7 @@ inline void app_regex_replace(const std::string& perl_pattern, const std::string
 /// \return number of replacements made.
 inline void app_regex_replace(const char* perl_pattern, const std::string& replacement, std::string& subject)
 {
-	app_regex_replace(app_regex_re(perl_pattern), replacement, subject);
+	app_regex_replace(*app_regex_re_cached(perl_pattern), replacement, subject);
 }
 
 
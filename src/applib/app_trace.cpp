@@ -0,0 +1,221 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "app_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+
+
+namespace {
+
+
+	/// Trace state
+	struct TraceState {
+		std::mutex mutex;  ///< Protects the ring buffer
+		std::vector<AppTraceSpanRecord> ring;  ///< Ring buffer
+		std::size_t next = 0;  ///< Next position to write to
+		bool wrapped = false;  ///< Whether the old spans are being overwritten
+	};
+
+
+	/// Whether the tracing is enabled
+	std::atomic<bool> s_trace_enabled = false;
+
+
+	/// Innermost span active in the watched thread
+	std::atomic<const char*> s_watched_span = nullptr;
+
+
+	/// Whether the current thread is the watched thread
+	thread_local bool s_is_watched_thread = false;
+
+
+	/// Get the trace state
+	TraceState& get_trace_state()
+	{
+		static TraceState state;
+		return state;
+	}
+
+
+	/// Get the time point all the trace times are relative to
+	std::chrono::steady_clock::time_point get_trace_epoch()
+	{
+		static const auto epoch = std::chrono::steady_clock::now();
+		return epoch;
+	}
+
+
+	/// Get a small number identifying the current thread (Chrome trace "tid")
+	std::uint32_t get_trace_thread_index()
+	{
+		static std::atomic<std::uint32_t> next_index = 1;
+		thread_local const std::uint32_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+
+
+}
+
+
+
+void app_trace_set_enabled(bool enabled, std::size_t capacity)
+{
+	[[maybe_unused]] const auto epoch = get_trace_epoch();  // initialize it before any span starts
+
+	auto& state = get_trace_state();
+	{
+		const std::scoped_lock lock(state.mutex);
+		state.ring.clear();
+		state.ring.shrink_to_fit();
+		if (enabled) {
+			state.ring.resize(std::max<std::size_t>(capacity, 1));
+		}
+		state.next = 0;
+		state.wrapped = false;
+	}
+	s_trace_enabled.store(enabled, std::memory_order_release);
+}
+
+
+
+bool app_trace_get_enabled()
+{
+	return s_trace_enabled.load(std::memory_order_relaxed);
+}
+
+
+
+std::int64_t app_trace_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - get_trace_epoch()).count();
+}
+
+
+
+void app_trace_add_span(const char* name, const char* category, std::int64_t start_ns, std::int64_t end_ns, std::string detail)
+{
+	if (!app_trace_get_enabled()) {
+		return;
+	}
+	AppTraceSpanRecord record {name, category, start_ns, std::max<std::int64_t>(end_ns - start_ns, 0),
+			get_trace_thread_index(), std::move(detail)};
+
+	auto& state = get_trace_state();
+	const std::scoped_lock lock(state.mutex);
+	if (state.ring.empty()) {  // disabled concurrently
+		return;
+	}
+	state.ring[state.next] = std::move(record);
+	if (++state.next == state.ring.size()) {
+		state.next = 0;
+		state.wrapped = true;
+	}
+}
+
+
+
+std::vector<AppTraceSpanRecord> app_trace_get_spans()
+{
+	std::vector<AppTraceSpanRecord> spans;
+
+	auto& state = get_trace_state();
+	const std::scoped_lock lock(state.mutex);
+	const std::size_t count = state.wrapped ? state.ring.size() : state.next;
+	const std::size_t first = state.wrapped ? state.next : 0;
+	spans.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		spans.push_back(state.ring[(first + i) % state.ring.size()]);
+	}
+	return spans;
+}
+
+
+
+std::string app_trace_export_chrome_json()
+{
+	nlohmann::json events = nlohmann::json::array();
+
+	for (const auto& record : app_trace_get_spans()) {
+		nlohmann::json event = {
+			{"name", record.name},
+			{"cat", record.category},
+			{"ph", "X"},
+			{"ts", static_cast<double>(record.start_ns) / 1000.},
+			{"dur", static_cast<double>(record.duration_ns) / 1000.},
+			{"pid", 1},
+			{"tid", record.thread_index},
+		};
+		if (!record.detail.empty()) {
+			event["args"] = {{"detail", record.detail}};
+		}
+		events.push_back(std::move(event));
+	}
+
+	const nlohmann::json doc = {
+		{"traceEvents", std::move(events)},
+		{"displayTimeUnit", "ms"},
+	};
+	// Replace invalid UTF-8 (e.g. in device names) instead of throwing
+	return doc.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+
+
+void app_trace_set_watched_thread()
+{
+	s_is_watched_thread = true;
+}
+
+
+
+const char* app_trace_get_watched_span()
+{
+	return s_watched_span.load(std::memory_order_relaxed);
+}
+
+
+
+const char* app_trace_enter_watched_span(const char* name)
+{
+	if (!s_is_watched_thread) {
+		return nullptr;
+	}
+	return s_watched_span.exchange(name, std::memory_order_relaxed);
+}
+
+
+
+void app_trace_leave_watched_span(const char* previous)
+{
+	if (s_is_watched_thread) {
+		s_watched_span.store(previous, std::memory_order_relaxed);
+	}
+}
+
+
+
+std::error_code app_trace_write_chrome_json(const hz::fs::path& file)
+{
+	return hz::fs_file_put_contents(file, app_trace_export_chrome_json());
+}
+
+
+
+
+/// @}
@@ -0,0 +1,146 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef APP_TRACE_H
+#define APP_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "hz/fs.h"
+
+
+
+/// Enable or disable span tracing. When enabled, finished spans are recorded into a
+/// ring buffer of \c capacity spans (the oldest ones are overwritten), which is cleared.
+void app_trace_set_enabled(bool enabled, std::size_t capacity = 65536);
+
+
+/// Check whether span tracing is enabled
+[[nodiscard]] bool app_trace_get_enabled();
+
+
+/// Get the current monotonic time for tracing, in nanoseconds since tracing was first enabled
+[[nodiscard]] std::int64_t app_trace_now();
+
+
+/// Record a finished span which started at \c start_ns and ended at \c end_ns (see app_trace_now()).
+/// \c name and \c category must be string literals (or otherwise outlive the tracing).
+/// \c detail is shown as span argument, if not empty. Does nothing if tracing is disabled.
+void app_trace_add_span(const char* name, const char* category, std::int64_t start_ns, std::int64_t end_ns,
+		std::string detail = {});
+
+
+/// A recorded span
+struct AppTraceSpanRecord {
+	const char* name = nullptr;  ///< Span name
+	const char* category = nullptr;  ///< Span category
+	std::int64_t start_ns = 0;  ///< Start time (see app_trace_now())
+	std::int64_t duration_ns = 0;  ///< Duration
+	std::uint32_t thread_index = 0;  ///< Thread which recorded the span
+	std::string detail;  ///< Span argument
+};
+
+
+/// Get the recorded spans, oldest first. Empty if tracing is disabled.
+[[nodiscard]] std::vector<AppTraceSpanRecord> app_trace_get_spans();
+
+
+/// Export the recorded spans in Chrome trace event JSON format (as understood by
+/// chrome://tracing and Perfetto).
+[[nodiscard]] std::string app_trace_export_chrome_json();
+
+
+/// Write app_trace_export_chrome_json() output to a file
+std::error_code app_trace_write_chrome_json(const hz::fs::path& file);
+
+
+/// Make the calling thread (usually the main thread) the watched thread. The innermost
+/// AppTraceSpan active in it is published (regardless of whether tracing is enabled)
+/// so that other threads can see what it's doing (see app_trace_get_watched_span()).
+void app_trace_set_watched_thread();
+
+
+/// Get the name of the innermost span active in the watched thread, nullptr if none.
+/// May be called from any thread.
+[[nodiscard]] const char* app_trace_get_watched_span();
+
+
+/// Publish \c name as the innermost span if called from the watched thread.
+/// \return the previously published span, to be passed to app_trace_leave_watched_span().
+[[nodiscard]] const char* app_trace_enter_watched_span(const char* name);
+
+
+/// Restore the span returned by app_trace_enter_watched_span(). Does nothing if not called
+/// from the watched thread.
+void app_trace_leave_watched_span(const char* previous);
+
+
+
+/// A scoped span. Records the time between its construction and destruction if
+/// tracing was enabled at construction. This is cheap (an atomic load and a thread-local check)
+/// if tracing is disabled.
+/// \c name and \c category must be string literals.
+class AppTraceSpan {
+	public:
+
+		/// Constructor
+		explicit AppTraceSpan(const char* name, const char* category = "app", std::string detail = {})
+				: name_(name), category_(category), watched_parent_(app_trace_enter_watched_span(name))
+		{
+			if (app_trace_get_enabled()) {
+				detail_ = std::move(detail);
+				start_ns_ = app_trace_now();
+			}
+		}
+
+		/// Deleted
+		AppTraceSpan(const AppTraceSpan& other) = delete;
+
+		/// Deleted
+		AppTraceSpan(AppTraceSpan&& other) = delete;
+
+		/// Deleted
+		AppTraceSpan& operator=(const AppTraceSpan&) = delete;
+
+		/// Deleted
+		AppTraceSpan& operator=(AppTraceSpan&&) = delete;
+
+		/// Destructor, records the span
+		~AppTraceSpan()
+		{
+			if (start_ns_ >= 0) {
+				app_trace_add_span(name_, category_, start_ns_, app_trace_now(), std::move(detail_));
+			}
+			app_trace_leave_watched_span(watched_parent_);
+		}
+
+
+	private:
+
+		const char* name_ = nullptr;  ///< Span name
+		const char* category_ = nullptr;  ///< Span category
+		std::string detail_;  ///< Span argument
+		std::int64_t start_ns_ = -1;  ///< Start time, -1 if tracing was disabled
+		const char* watched_parent_ = nullptr;  ///< Span published before this one in the watched thread
+
+};
+
+
+
+
+#endif
+
+/// @}
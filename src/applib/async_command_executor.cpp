@@ -11,10 +11,14 @@ Copyright:
 
 #include <glibmm.h>
 
+#include <algorithm>  // std::max, std::min
 #include <string>
+#include <mutex>
+#include <utility>
 #include <sys/types.h>
 #include <cerrno>  // errno (not std::errno, it may be a macro)
 #include <array>
+#include <vector>
 
 #ifdef _WIN32
 // 	#include <io.h>  // close()
@@ -23,11 +27,23 @@ Copyright:
 // 	#include <unistd.h>  // close()
 #endif
 
+#ifdef __linux__
+	#include <glib-unix.h>  // g_unix_fd_source_new()
+	#include <fcntl.h>  // O_CLOEXEC, etc.
+	#include <signal.h>  // sigset_t
+	#include <spawn.h>  // posix_spawnp()
+	#include <sys/syscall.h>  // SYS_pidfd_open
+	#include <unistd.h>  // pipe2(), close()
+	#include <cstring>  // std::strerror
+#endif
+
 #include "hz/process_signal.h"  // hz::process_signal_send, win32's W*
 #include "hz/debug.h"
 #include "hz/fs.h"
 
+#include "app_trace.h"
 #include "async_command_executor.h"
+#include "async_command_executor_win32.h"
 #include "build_config.h"
 
 
@@ -68,8 +84,7 @@ extern "C" {
 	inline gboolean cmdex_on_term_timeout(gpointer data)
 	{
 		DBG_FUNCTION_ENTER_MSG;
-		auto* self = static_cast<AsyncCommandExecutor*>(data);
-		self->try_stop(hz::Signal::Terminate);
+		AsyncCommandExecutor::on_stop_timeout(static_cast<AsyncCommandExecutor*>(data), hz::Signal::Terminate);
 		return FALSE;  // one-time call
 	}
 
@@ -78,22 +93,121 @@ extern "C" {
 	inline gboolean cmdex_on_kill_timeout(gpointer data)
 	{
 		DBG_FUNCTION_ENTER_MSG;
-		auto* self = static_cast<AsyncCommandExecutor*>(data);
-		self->try_stop(hz::Signal::Kill);
+		AsyncCommandExecutor::on_stop_timeout(static_cast<AsyncCommandExecutor*>(data), hz::Signal::Kill);
 		return FALSE;  // one-time call
 	}
 
 
+#ifdef __linux__
+	/// Child process pidfd readiness callback. The pidfd becomes readable when the child exits.
+	inline gboolean cmdex_on_pidfd_ready([[maybe_unused]] gint fd, [[maybe_unused]] GIOCondition cond, gpointer data)
+	{
+		return AsyncCommandExecutor::on_child_pidfd_ready(static_cast<AsyncCommandExecutor*>(data));
+	}
+#endif
+
+
 
 }  // extern "C"
 
 
 
+namespace {
+
+	/// Attach \c source to \c context and release our reference to it.
+	/// \return The source ID, valid within \c context.
+	inline guint cmdex_attach_source(GSource* source, GMainContext* context)
+	{
+		const guint id = g_source_attach(source, context);
+		g_source_unref(source);
+		return id;
+	}
+
+
+	/// Convert a typed source callback to GSourceFunc for g_source_set_callback()
+	/// (same as G_SOURCE_FUNC(), which is not available in older glib versions).
+	template<typename Func>
+	inline GSourceFunc cmdex_source_func(Func* func)
+	{
+		return reinterpret_cast<GSourceFunc>(reinterpret_cast<void (*)()>(func));
+	}
+
+
+	/// Get the channel buffer size for an expected output size: twice as much, so that a larger
+	/// than usual output fits as well, but not less than \c configured_size.
+	inline gsize cmdex_channel_buffer_size(gsize configured_size, std::size_t expected_size)
+	{
+		constexpr gsize max_buffer_size = 64UL * 1024UL * 1024UL;
+		return std::max(configured_size, std::min<gsize>(expected_size * 2, max_buffer_size));
+	}
+
+
+	/// Remove a source with ID \c id (if it's still present) from \c context.
+	inline void cmdex_destroy_source(guint id, GMainContext* context)
+	{
+		if (id != 0) {
+			GSource* source = g_main_context_find_source_by_id(context, id);
+			if (source)
+				g_source_destroy(source);
+		}
+	}
+
+
+#ifdef __linux__
+
+	/// Open a pidfd (a file descriptor referring to a process) for \c pid.
+	/// \return -1 if it's not supported (kernels before 5.3), or on error.
+	inline int cmdex_pidfd_open(pid_t pid)
+	{
+	#ifdef SYS_pidfd_open
+		return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+	#else
+		static_cast<void>(pid);
+		return -1;
+	#endif
+	}
+
+
+	/// Close both ends of a pipe created with pipe2(), if open
+	inline void cmdex_close_pipe(std::array<int, 2>& fds)
+	{
+		for (int& fd : fds) {
+			if (fd >= 0) {
+				close(fd);
+				fd = -1;
+			}
+		}
+	}
+
+
+	/// A null-terminated array of C strings pointing to \c strings,
+	/// as needed by posix_spawnp(). \c strings must outlive it.
+	inline std::vector<char*> cmdex_make_c_string_array(const std::vector<std::string>& strings)
+	{
+		std::vector<char*> ret;
+		ret.reserve(strings.size() + 1);
+		for (const auto& s : strings) {
+			ret.push_back(const_cast<char*>(s.c_str()));
+		}
+		ret.push_back(nullptr);
+		return ret;
+	}
+
+#endif
+
+}
+
+
+
 
 AsyncCommandExecutor::AsyncCommandExecutor(AsyncCommandExecutor::exited_callback_func_t exited_cb)
 		: timer_(g_timer_new()),
 		exited_callback_(std::move(exited_cb))
-{ }
+{
+	// Only the last errors are looked at (see CommandExecutor::import_error()), and the
+	// executors may be reused for days, so don't let the list grow (e.g. on repeated I/O errors).
+	set_max_errors(16);
+}
 
 
 
@@ -105,6 +219,15 @@ AsyncCommandExecutor::~AsyncCommandExecutor()
 
 	g_timer_destroy(timer_);
 
+	if (main_context_)
+		g_main_context_unref(main_context_);
+
+	// Don't let the Windows backend deliver events to a destroyed object
+	if (win32_child_) {
+		win32_child_->detach();
+		win32_child_.reset();
+	}
+
 	// no need to destroy the channels - stopped_cleanup() calls
 	// cleanup_members(), which deletes them.
 }
@@ -131,6 +254,22 @@ bool AsyncCommandExecutor::execute()
 	str_stdout_.clear();
 	str_stderr_.clear();
 
+	// Allocate for the usual output of this command upfront
+	const std::size_t expected_stdout_size = std::exchange(expected_stdout_size_, 0);
+	const std::size_t expected_stderr_size = std::exchange(expected_stderr_size_, 0);
+	str_stdout_.reserve(expected_stdout_size);
+	str_stderr_.reserve(expected_stderr_size);
+
+	execute_start_time_ = std::chrono::steady_clock::now();
+	timing_ = ExecutionTiming();
+
+	// All our event sources are attached to the thread-default main context of the
+	// calling thread. This allows running executors in worker threads which have their
+	// own main context, without touching the (GUI) main loop.
+	if (main_context_)
+		g_main_context_unref(main_context_);
+	main_context_ = g_main_context_ref_thread_default();
+
 
 	// Set the locale for a child to Classic - otherwise it may mangle the output.
 	// TODO: Disable this for JSON format.
@@ -149,6 +288,11 @@ bool AsyncCommandExecutor::execute()
 	const std::vector<std::string> envp = Glib::ArrayHandler<std::string>::array_to_vector(child_env.release(),
 			Glib::OWNERSHIP_DEEP);
 
+	// The current directory is process-wide, so don't let parallel executors
+	// change and restore it concurrently.
+	static std::mutex s_spawn_cwd_mutex;
+	const std::scoped_lock cwd_lock(s_spawn_cwd_mutex);
+
 	// Set the current directory to application directory so CWD does not interfere with finding binaries.
 	auto current_path = hz::fs::current_path();
 	bool path_changed = false;
@@ -167,7 +311,35 @@ bool AsyncCommandExecutor::execute()
 	std::vector<std::string> argvp = {command_exec_};
 	argvp.insert(argvp.end(), command_args_.begin(), command_args_.end());
 
+	// The span is recorded when the child exits (see on_child_watch_handler()).
+	trace_start_ns_ = app_trace_get_enabled() ? app_trace_now() : -1;
+
 	// Execute the command
+#ifdef __linux__
+	// g_spawn_*() forks, which gets expensive with large heaps, and its child watch relies
+	// on SIGCHLD. posix_spawn() avoids copying the address space (it uses vfork semantics),
+	// and a pidfd reports the exit as a plain file descriptor event.
+	if (!posix_spawn_child(argvp, envp)) {
+		// Restore CWD
+		if (path_changed) {
+			std::error_code dummy_ec;
+			hz::fs::current_path(current_path, dummy_ec);
+		}
+		return false;
+	}
+#elif defined _WIN32
+	// GLib's win32 fd channels read the pipes with a helper thread per channel, byte by byte.
+	// Overlapped I/O on named pipes, serviced by one completion port thread for all the
+	// children, reads the output in large chunks instead.
+	if (!win32_spawn_child(argvp, envp)) {
+		// Restore CWD
+		if (path_changed) {
+			std::error_code dummy_ec;
+			hz::fs::current_path(current_path, dummy_ec);
+		}
+		return false;
+	}
+#else
 	try {
 		Glib::spawn_async_with_pipes(Glib::get_current_dir(), argvp, envp,
 				Glib::SpawnFlags::SPAWN_SEARCH_PATH | Glib::SpawnFlags::SPAWN_DO_NOT_REAP_CHILD,
@@ -184,6 +356,7 @@ bool AsyncCommandExecutor::execute()
 		}
 		return false;
 	}
+#endif
 
 	// Restore CWD
 	if (path_changed) {
@@ -191,21 +364,34 @@ bool AsyncCommandExecutor::execute()
 		hz::fs::current_path(current_path, dummy_ec);
 	}
 
+#ifndef _WIN32
+	if (execution_policy_ != CommandExecutionPolicy()) {
+		cmdex_apply_execution_policy(static_cast<int>(pid_), execution_policy_, cgroup_root_);
+	}
+#endif
+
 	g_timer_start(timer_);  // start the timer
+	timing_.spawn_latency = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - execute_start_time_);
 
+#ifdef _WIN32
+	// The output and the exit are delivered by win32_child_ (see win32_spawn_child()).
+	streaming_active_ = streaming_;
+	this->running_ = true;  // the process is running now.
+	DBG_FUNCTION_EXIT_MSG;
+	return true;
+#else
 
-	#ifdef _WIN32
-		channel_stdout_ = g_io_channel_win32_new_fd(fd_stdout_);
-		channel_stderr_ = g_io_channel_win32_new_fd(fd_stderr_);
-	#else
-		channel_stdout_ = g_io_channel_unix_new(fd_stdout_);
-		channel_stderr_ = g_io_channel_unix_new(fd_stderr_);
-	#endif
+	channel_stdout_ = g_io_channel_unix_new(fd_stdout_);
+	channel_stderr_ = g_io_channel_unix_new(fd_stderr_);
 
 	// The internal encoding is always UTF8. To read command output correctly, use
 	// "" for binary data, or set io encoding to current locale.
 	// If using locales, call g_locale_to_utf8() or g_convert() afterwards.
 
+	// Streaming mode reads the pipes directly (unbuffered, non-blocking) in chunks.
+	streaming_active_ = streaming_;
+
 	// blocking writes if the pipe is full helps for small-pipe systems (see man 7 pipe).
 	const int channel_flags = ~G_IO_FLAG_NONBLOCK;
 
@@ -218,14 +404,24 @@ bool AsyncCommandExecutor::execute()
 		// a double-shutdown.
 		// g_io_channel_set_close_on_unref(channel_stdout_, true);  // close() on fd
 		g_io_channel_set_encoding(channel_stdout_, nullptr, nullptr);  // binary IO
-		g_io_channel_set_flags(channel_stdout_, GIOFlags(g_io_channel_get_flags(channel_stdout_) & channel_flags), nullptr);
-		g_io_channel_set_buffer_size(channel_stdout_, channel_stdout_buffer_size_);
+		if (streaming_active_) {
+			g_io_channel_set_buffered(channel_stdout_, FALSE);
+			g_io_channel_set_flags(channel_stdout_, GIOFlags(g_io_channel_get_flags(channel_stdout_) | G_IO_FLAG_NONBLOCK), nullptr);
+		} else {
+			g_io_channel_set_flags(channel_stdout_, GIOFlags(g_io_channel_get_flags(channel_stdout_) & channel_flags), nullptr);
+			g_io_channel_set_buffer_size(channel_stdout_, cmdex_channel_buffer_size(channel_stdout_buffer_size_, expected_stdout_size));
+		}
 	}
 	if (channel_stderr_) {
 		// g_io_channel_set_close_on_unref(channel_stderr_, true);  // close() on fd
 		g_io_channel_set_encoding(channel_stderr_, nullptr, nullptr);  // binary IO
-		g_io_channel_set_flags(channel_stderr_, GIOFlags(g_io_channel_get_flags(channel_stderr_) & channel_flags), nullptr);
-		g_io_channel_set_buffer_size(channel_stderr_, channel_stderr_buffer_size_);
+		if (streaming_active_) {
+			g_io_channel_set_buffered(channel_stderr_, FALSE);
+			g_io_channel_set_flags(channel_stderr_, GIOFlags(g_io_channel_get_flags(channel_stderr_) | G_IO_FLAG_NONBLOCK), nullptr);
+		} else {
+			g_io_channel_set_flags(channel_stderr_, GIOFlags(g_io_channel_get_flags(channel_stderr_) & channel_flags), nullptr);
+			g_io_channel_set_buffer_size(channel_stderr_, cmdex_channel_buffer_size(channel_stderr_buffer_size_, expected_stderr_size));
+		}
 	}
 
 
@@ -233,25 +429,165 @@ bool AsyncCommandExecutor::execute()
 	// Channel reader callback must be called before other stuff so that the loss is minimal.
 	const int io_priority = G_PRIORITY_HIGH;
 
-	this->event_source_id_stdout_ = g_io_add_watch_full(channel_stdout_, io_priority, cond,
-			&cmdex_on_channel_io_stdout, this, nullptr);
-// 	g_io_channel_unref(channel_stdout_);  // g_io_add_watch_full() holds its own reference
+	// Note: The watch sources hold their own channel references.
+	GSource* source_stdout = g_io_create_watch(channel_stdout_, cond);
+	g_source_set_priority(source_stdout, io_priority);
+	g_source_set_callback(source_stdout, cmdex_source_func(&cmdex_on_channel_io_stdout), this, nullptr);
+	this->event_source_id_stdout_ = cmdex_attach_source(source_stdout, main_context_);
 
-	this->event_source_id_stderr_ = g_io_add_watch_full(channel_stderr_, io_priority, cond,
-			&cmdex_on_channel_io_stderr, this, nullptr);
-// 	g_io_channel_unref(channel_stderr_);  // g_io_add_watch_full() holds its own reference
+	GSource* source_stderr = g_io_create_watch(channel_stderr_, cond);
+	g_source_set_priority(source_stderr, io_priority);
+	g_source_set_callback(source_stderr, cmdex_source_func(&cmdex_on_channel_io_stderr), this, nullptr);
+	this->event_source_id_stderr_ = cmdex_attach_source(source_stderr, main_context_);
 
 
-	// If using SPAWN_DO_NOT_REAP_CHILD, this is needed to avoid zombies.
-	// Note: Do NOT use glibmm slot, it doesn't work here.
-	// (the child stops being a zombie as soon as wait*() exits and this handler is called).
-	g_child_watch_add(this->pid_, &cmdex_child_watch_handler, this);
+	attach_child_watch();
 
 
 	this->running_ = true;  // the process is running now.
 
 	DBG_FUNCTION_EXIT_MSG;
 	return true;
+#endif
+}
+
+
+
+#ifdef __linux__
+
+bool AsyncCommandExecutor::posix_spawn_child(const std::vector<std::string>& argv, const std::vector<std::string>& envp)
+{
+	const std::vector<char*> c_argv = cmdex_make_c_string_array(argv);
+	const std::vector<char*> c_envp = cmdex_make_c_string_array(envp);
+
+	// Our ends of the pipes must not leak into the other children
+	std::array<int, 2> stdout_pipe = {-1, -1}, stderr_pipe = {-1, -1};
+	if (pipe2(stdout_pipe.data(), O_CLOEXEC) != 0 || pipe2(stderr_pipe.data(), O_CLOEXEC) != 0) {
+		push_error(Error<int>("errno", ErrorLevel::Error, errno));
+		cmdex_close_pipe(stdout_pipe);
+		cmdex_close_pipe(stderr_pipe);
+		return false;
+	}
+
+	// Same as g_spawn_*(): stdin from /dev/null, the child ends of the pipes as stdout / stderr
+	// (dup2() clears their close-on-exec flag), the other descriptors closed.
+	posix_spawn_file_actions_t file_actions;
+	posix_spawn_file_actions_init(&file_actions);
+	posix_spawn_file_actions_addopen(&file_actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+	posix_spawn_file_actions_adddup2(&file_actions, stdout_pipe[1], STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&file_actions, stderr_pipe[1], STDERR_FILENO);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+	posix_spawn_file_actions_addclosefrom_np(&file_actions, STDERR_FILENO + 1);
+#endif
+
+	// Don't let the child inherit our signal mask and handlers
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	sigset_t signals;
+	sigemptyset(&signals);
+	posix_spawnattr_setsigmask(&attr, &signals);
+	sigfillset(&signals);
+	posix_spawnattr_setsigdefault(&attr, &signals);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+	pid_t pid = 0;
+	const int spawn_error = posix_spawnp(&pid, c_argv.front(), &file_actions, &attr, c_argv.data(), c_envp.data());
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&file_actions);
+	close(stdout_pipe[1]);
+	close(stderr_pipe[1]);
+
+	if (spawn_error != 0) {
+		close(stdout_pipe[0]);
+		close(stderr_pipe[0]);
+		// Same message as g_spawn_*()
+		push_error(Error<void>("gspawn", ErrorLevel::Error,
+				"Failed to execute child process \"" + argv.front() + "\" (" + std::strerror(spawn_error) + ")"));
+		return false;
+	}
+
+	pid_ = pid;
+	fd_stdout_ = stdout_pipe[0];
+	fd_stderr_ = stderr_pipe[0];
+	pidfd_ = cmdex_pidfd_open(pid);  // -1 if not supported, attach_child_watch() falls back to a child watch then
+	return true;
+}
+
+#endif
+
+
+
+#ifdef _WIN32
+
+bool AsyncCommandExecutor::win32_spawn_child(const std::vector<std::string>& argv, const std::vector<std::string>& envp)
+{
+	Win32ChildProcessCallbacks callbacks;
+	// These are called in main_context_, and never after the child is detached.
+	callbacks.on_output = [this](bool is_stderr, std::string_view data) {
+		const Channel channel_type = is_stderr ? Channel::StandardError : Channel::StandardOutput;
+		(is_stderr ? str_stderr_ : str_stdout_).append(data);
+		if (streaming_active_ && output_chunk_callback_) {
+			output_chunk_callback_(channel_type, data);
+		}
+		if (!is_stderr) {
+			update_first_byte_time();
+		}
+	};
+	callbacks.on_exit = [this](int exit_code) {
+		on_child_watch_handler(pid_, exit_code, this);
+	};
+
+	void* process_handle = nullptr;
+	std::string error_msg;
+	win32_child_ = win32_child_process_start(argv, envp, main_context_, std::move(callbacks), process_handle, error_msg);
+	if (!win32_child_) {
+		push_error(Error<void>("gspawn", ErrorLevel::Error,
+				"Failed to execute child process \"" + argv.front() + "\" (" + error_msg + ")"));
+		return false;
+	}
+	pid_ = static_cast<GPid>(process_handle);
+	return true;
+}
+
+#endif
+
+
+
+gboolean AsyncCommandExecutor::on_child_pidfd_ready(AsyncCommandExecutor* self)
+{
+#ifdef __linux__
+	// The pidfd source replaces the glib child watch, so reap the child here, like it does.
+	int waitpid_status = 0;
+	if (waitpid(self->pid_, &waitpid_status, WNOHANG) != self->pid_) {
+		return TRUE;  // not exited yet (should not happen), wait for the next readiness
+	}
+	on_child_watch_handler(self->pid_, waitpid_status, self);
+#else
+	static_cast<void>(self);
+#endif
+	return FALSE;  // one-time call
+}
+
+
+
+void AsyncCommandExecutor::attach_child_watch()
+{
+#ifdef __linux__
+	if (pidfd_ >= 0) {
+		GSource* source_pidfd = g_unix_fd_source_new(pidfd_, G_IO_IN);
+		g_source_set_callback(source_pidfd, cmdex_source_func(&cmdex_on_pidfd_ready), this, nullptr);
+		cmdex_attach_source(source_pidfd, main_context_);
+		return;
+	}
+#endif
+
+	// If using SPAWN_DO_NOT_REAP_CHILD, this is needed to avoid zombies.
+	// Note: Do NOT use glibmm slot, it doesn't work here.
+	// (the child stops being a zombie as soon as wait*() exits and this handler is called).
+	GSource* source_child = g_child_watch_source_new(this->pid_);
+	g_source_set_callback(source_child, cmdex_source_func(&cmdex_child_watch_handler), this, nullptr);
+	cmdex_attach_source(source_child, main_context_);
 }
 
 
@@ -298,11 +634,17 @@ void AsyncCommandExecutor::set_stop_timeouts(std::chrono::milliseconds term_time
 
 	unset_stop_timeouts();
 
-	if (term_timeout_msec.count() != 0)
-		event_source_id_term = g_timeout_add(guint(term_timeout_msec.count()), &cmdex_on_term_timeout, this);
+	if (term_timeout_msec.count() != 0) {
+		GSource* source_term = g_timeout_source_new(guint(term_timeout_msec.count()));
+		g_source_set_callback(source_term, &cmdex_on_term_timeout, this, nullptr);
+		event_source_id_term = cmdex_attach_source(source_term, main_context_);
+	}
 
-	if (kill_timeout_msec.count() != 0)
-		event_source_id_kill = g_timeout_add(guint(kill_timeout_msec.count()), &cmdex_on_kill_timeout, this);
+	if (kill_timeout_msec.count() != 0) {
+		GSource* source_kill = g_timeout_source_new(guint(kill_timeout_msec.count()));
+		g_source_set_callback(source_kill, &cmdex_on_kill_timeout, this, nullptr);
+		event_source_id_kill = cmdex_attach_source(source_kill, main_context_);
+	}
 
 	DBG_FUNCTION_EXIT_MSG;
 }
@@ -312,19 +654,11 @@ void AsyncCommandExecutor::set_stop_timeouts(std::chrono::milliseconds term_time
 void AsyncCommandExecutor::unset_stop_timeouts()
 {
 	DBG_FUNCTION_ENTER_MSG;
-	if (event_source_id_term != 0) {
-		GSource* source_term = g_main_context_find_source_by_id(nullptr, event_source_id_term);
-		if (source_term)
-			g_source_destroy(source_term);
-		event_source_id_term = 0;
-	}
+	cmdex_destroy_source(event_source_id_term, main_context_);
+	event_source_id_term = 0;
 
-	if (event_source_id_kill != 0) {
-		GSource* source_kill = g_main_context_find_source_by_id(nullptr, event_source_id_kill);
-		if (source_kill)
-			g_source_destroy(source_kill);
-		event_source_id_kill = 0;
-	}
+	cmdex_destroy_source(event_source_id_kill, main_context_);
+	event_source_id_kill = 0;
 	DBG_FUNCTION_EXIT_MSG;
 }
 
@@ -385,12 +719,29 @@ void AsyncCommandExecutor::on_child_watch_handler([[maybe_unused]] GPid arg_pid,
 	self->child_watch_handler_called_ = true;
 	self->running_ = false;  // process is not running anymore
 
-	// These are needed because Windows doesn't read the remaining data otherwise.
-	g_io_channel_flush(self->channel_stdout_, nullptr);
-	on_channel_io(self->channel_stdout_, GIOCondition(0), self, Channel::StandardOutput);
+	self->timing_.runtime = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - self->execute_start_time_);
+	self->timing_.kill_signal = self->kill_signal_sent_;
+
+	if (self->trace_start_ns_ >= 0) {
+		std::string command = self->command_exec_;
+		for (const auto& arg : self->command_args_) {
+			command += " " + arg;
+		}
+		app_trace_add_span("AsyncCommandExecutor::execute", "executor", self->trace_start_ns_, app_trace_now(), std::move(command));
+		self->trace_start_ns_ = -1;
+	}
 
-	g_io_channel_flush(self->channel_stderr_, nullptr);
-	on_channel_io(self->channel_stderr_, GIOCondition(0), self, Channel::StandardError);
+	// Read the remaining data. There are no channels with the Windows backend,
+	// it delivers all the output before the exit.
+	if (self->channel_stdout_) {
+		g_io_channel_flush(self->channel_stdout_, nullptr);
+		on_channel_io(self->channel_stdout_, GIOCondition(0), self, Channel::StandardOutput);
+	}
+	if (self->channel_stderr_) {
+		g_io_channel_flush(self->channel_stderr_, nullptr);
+		on_channel_io(self->channel_stderr_, GIOCondition(0), self, Channel::StandardError);
+	}
 
 	if (self->channel_stdout_) {
 		g_io_channel_shutdown(self->channel_stdout_, FALSE, nullptr);
@@ -407,17 +758,8 @@ void AsyncCommandExecutor::on_child_watch_handler([[maybe_unused]] GPid arg_pid,
 	// Remove fd IO callbacks. They may actually be removed already (note sure about this).
 	// This will force calling the iochannel callback (they may not be called
 	// otherwise at all if there was no output).
-	if (self->event_source_id_stdout_ != 0) {
-		GSource* source_stdout = g_main_context_find_source_by_id(nullptr, self->event_source_id_stdout_);
-		if (source_stdout)
-			g_source_destroy(source_stdout);
-	}
-
-	if (self->event_source_id_stderr_ != 0) {
-		GSource* source_stderr = g_main_context_find_source_by_id(nullptr, self->event_source_id_stderr_);
-		if (source_stderr)
-			g_source_destroy(source_stderr);
-	}
+	cmdex_destroy_source(self->event_source_id_stdout_, self->main_context_);
+	cmdex_destroy_source(self->event_source_id_stderr_, self->main_context_);
 
 	// Close std pipes.
 	// The channel closes them now.
@@ -460,6 +802,39 @@ gboolean AsyncCommandExecutor::on_channel_io(GIOChannel* channel,
 	}
 	DBG_ASSERT_RETURN(output_str, false);
 
+	if (self->streaming_active_) {
+		// The channel is unbuffered and non-blocking, so just drain the pipe.
+		// This is also called after the child exits, to read the remaining data.
+		std::array<gchar, 16UL * 1024UL> chunk_buf = {0};
+		while (true) {
+			GError* channel_error = nullptr;
+			gsize bytes_read = 0;
+			const GIOStatus status = g_io_channel_read_chars(channel, chunk_buf.data(), chunk_buf.size(), &bytes_read, &channel_error);
+			if (bytes_read != 0) {
+				output_str->append(chunk_buf.data(), bytes_read);
+				if (self->output_chunk_callback_) {
+					self->output_chunk_callback_(channel_type, std::string_view(chunk_buf.data(), bytes_read));
+				}
+			}
+			if (channel_error) {
+				self->push_error(Error<void>("giochannel", ErrorLevel::Error, channel_error->message));
+				g_error_free(channel_error);
+				break;
+			}
+			if (status == G_IO_STATUS_ERROR || status == G_IO_STATUS_EOF) {
+				continue_events = false;
+				break;
+			}
+			if (status == G_IO_STATUS_AGAIN || bytes_read == 0) {
+				break;  // nothing more for now
+			}
+		}
+		if (channel_type == Channel::StandardOutput) {
+			self->update_first_byte_time();
+		}
+		return gboolean(continue_events);
+	}
+
 
 	// while there's anything to read, read it
 	do {
@@ -484,12 +859,24 @@ gboolean AsyncCommandExecutor::on_channel_io(GIOChannel* channel,
 
 // 	DBG_FUNCTION_EXIT_MSG;
 
+	if (channel_type == Channel::StandardOutput) {
+		self->update_first_byte_time();
+	}
+
 	// false if the source should be removed, true otherwise.
 	return gboolean(continue_events);
 }
 
 
 
+void AsyncCommandExecutor::on_stop_timeout(AsyncCommandExecutor* self, hz::Signal sig)
+{
+	self->timing_.timed_out = true;
+	self->try_stop(sig);
+}
+
+
+
 bool AsyncCommandExecutor::stopped_cleanup_needed() const
 {
 	return (child_watch_handler_called_);
@@ -516,6 +903,43 @@ void AsyncCommandExecutor::set_buffer_sizes(gsize stdout_buffer_size, gsize stde
 
 
 
+void AsyncCommandExecutor::set_expected_output_sizes(std::size_t stdout_size, std::size_t stderr_size)
+{
+	expected_stdout_size_ = stdout_size;
+	expected_stderr_size_ = stderr_size;
+}
+
+
+
+void AsyncCommandExecutor::set_streaming(bool enabled)
+{
+	streaming_ = enabled;
+}
+
+
+
+bool AsyncCommandExecutor::get_streaming() const
+{
+	return streaming_;
+}
+
+
+
+void AsyncCommandExecutor::set_execution_policy(CommandExecutionPolicy policy, hz::fs::path cgroup_root)
+{
+	execution_policy_ = std::move(policy);
+	cgroup_root_ = std::move(cgroup_root);
+}
+
+
+
+void AsyncCommandExecutor::set_output_chunk_callback(AsyncCommandExecutor::output_chunk_func_t func)
+{
+	output_chunk_callback_ = std::move(func);
+}
+
+
+
 std::string AsyncCommandExecutor::get_stdout_str(bool clear_existing)
 {
 	// debug_out_dump("app", str_stdout_);
@@ -529,6 +953,13 @@ std::string AsyncCommandExecutor::get_stdout_str(bool clear_existing)
 
 
 
+std::string AsyncCommandExecutor::take_stdout_str()
+{
+	return std::exchange(str_stdout_, std::string());
+}
+
+
+
 std::string AsyncCommandExecutor::get_stderr_str(bool clear_existing)
 {
 	if (clear_existing) {
@@ -541,6 +972,13 @@ std::string AsyncCommandExecutor::get_stderr_str(bool clear_existing)
 
 
 
+std::size_t AsyncCommandExecutor::get_stderr_size() const
+{
+	return str_stderr_.size();
+}
+
+
+
 double AsyncCommandExecutor::get_execution_time_sec()
 {
 	gulong microsec = 0;
@@ -549,6 +987,13 @@ double AsyncCommandExecutor::get_execution_time_sec()
 
 
 
+const AsyncCommandExecutor::ExecutionTiming& AsyncCommandExecutor::get_execution_timing() const
+{
+	return timing_;
+}
+
+
+
 void AsyncCommandExecutor::set_exit_status_translator(AsyncCommandExecutor::exit_status_translator_func_t func)
 {
 	translator_func_ = std::move(func);
@@ -563,16 +1008,37 @@ void AsyncCommandExecutor::set_exited_callback(AsyncCommandExecutor::exited_call
 
 
 
+void AsyncCommandExecutor::update_first_byte_time()
+{
+	if (!timing_.time_to_first_byte.has_value() && !str_stdout_.empty()) {
+		timing_.time_to_first_byte = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - execute_start_time_);
+	}
+}
+
+
+
 void AsyncCommandExecutor::cleanup_members()
 {
 	kill_signal_sent_ = 0;
 	child_watch_handler_called_ = false;
 	pid_ = 0;
+#ifdef __linux__
+	if (pidfd_ >= 0) {
+		close(pidfd_);
+	}
+#endif
+	pidfd_ = -1;
 	waitpid_status_ = 0;
 	event_source_id_stdout_ = 0;
 	event_source_id_stderr_ = 0;
 	fd_stdout_ = 0;
 	fd_stderr_ = 0;
+	streaming_active_ = false;
+	if (win32_child_) {
+		win32_child_->detach();
+		win32_child_.reset();
+	}
 }
 
 
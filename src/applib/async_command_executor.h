@@ -9,12 +9,22 @@ Copyright:
 
 #include <glib.h>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <chrono>
+#include <optional>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <memory>
 
 #include "hz/process_signal.h"  // hz::SIGNAL_*
 #include "hz/error_holder.h"
+#include "hz/fs.h"
 
+#include "command_executor_policy.h"
+
+
+class Win32ChildProcess;
 
 
 /// Command executor.
@@ -22,6 +32,8 @@ Copyright:
 /// 1. Add a callback to signal_exited.
 /// 2. Manually poll stopped_cleanup_needed().
 /// In both cases, stopped_cleanup() must be called afterwards.
+/// The event sources are attached to the thread-default main context of the thread
+/// calling execute(), so the executor may be used in worker threads with their own context.
 class AsyncCommandExecutor : public hz::ErrorHolder {
 	public:
 
@@ -114,9 +126,37 @@ class AsyncCommandExecutor : public hz::ErrorHolder {
 		/// Another way is to delay the command exit so that the event source callback
 		/// catches on and reads the buffer.
 		// Use 0 to ignore the parameter. Call this before execute().
+		/// The buffer sizes are not used in streaming mode, see set_streaming().
 		void set_buffer_sizes(gsize stdout_buffer_size = 0, gsize stderr_buffer_size = 0);
 
 
+		/// Set the expected output sizes of the next execute() (e.g. from the earlier executions
+		/// of the same command, see CommandOutputSizes). The output strings are reserved for them,
+		/// so that a large output doesn't grow them through repeated reallocation, and the channel
+		/// buffers are enlarged to hold twice as much (see set_buffer_sizes() for why).
+		/// Use 0 if unknown. Call this before execute(), it applies to one execution only.
+		void set_expected_output_sizes(std::size_t stdout_size, std::size_t stderr_size);
+
+
+		/// Enable or disable the streaming mode. In streaming mode, the channels are
+		/// unbuffered and non-blocking, and the data is drained into the output strings
+		/// in chunks as soon as it arrives (and when the child exits), so the output size
+		/// is not limited by the channel buffer sizes. Each chunk is also passed to the
+		/// chunk callback, if set. In Windows, the output is always read in chunks (see
+		/// win32_child_process_start()), so only the chunk callback depends on this.
+		/// Call this before execute().
+		void set_streaming(bool enabled);
+
+
+		/// Check whether the streaming mode is enabled.
+		[[nodiscard]] bool get_streaming() const;
+
+
+		/// Set the resource controls (niceness, I/O priority, cgroup) to apply to the spawned
+		/// processes, see cmdex_apply_execution_policy(). Call this before execute().
+		void set_execution_policy(CommandExecutionPolicy policy, hz::fs::path cgroup_root);
+
+
 
 		/// If stdout_make_str_as_available_ is false, call this after stopped_cleanup(),
 		/// before next execute(). If it's true, you may call this before the command has
@@ -128,10 +168,32 @@ class AsyncCommandExecutor : public hz::ErrorHolder {
 		[[nodiscard]] std::string get_stderr_str(bool clear_existing = false);
 
 
+		/// Get the size of the stderr data, without copying it
+		[[nodiscard]] std::size_t get_stderr_size() const;
+
+
+		/// Move the stdout data out, leaving it empty. Unlike get_stdout_str(true),
+		/// this doesn't copy the data (and doesn't keep the buffer capacity).
+		[[nodiscard]] std::string take_stdout_str();
+
+
 		/// Return execution time, in seconds. Call this after execute().
 		[[maybe_unused]] double get_execution_time_sec();
 
 
+		/// Timing of an execution, measured from the execute() call
+		struct ExecutionTiming {
+			std::chrono::microseconds spawn_latency{0};  ///< Time until the process was started
+			std::optional<std::chrono::microseconds> time_to_first_byte;  ///< Time until the first stdout byte, unset if there was no output
+			std::chrono::microseconds runtime{0};  ///< Time until the process exited
+			bool timed_out = false;  ///< A stop timeout (see set_stop_timeouts()) expired
+			int kill_signal = 0;  ///< Signal sent to the process to stop it, 0 if none
+		};
+
+		/// Get the timing of the last execution. Call this after the command has exited.
+		[[nodiscard]] const ExecutionTiming& get_execution_timing() const;
+
+
 		/// Set exit status translator callback, disconnecting the old one.
 		/// Call only before execute().
 		void set_exit_status_translator(exit_status_translator_func_t func);
@@ -152,14 +214,32 @@ class AsyncCommandExecutor : public hz::ErrorHolder {
 		};
 
 
+		/// A function that receives the output chunks in streaming mode.
+		/// The chunk is valid only during the call. The chunks are appended to the
+		/// output strings regardless of this callback.
+		using output_chunk_func_t = std::function<void(Channel channel, std::string_view chunk)>;
+
+
+		/// Set output chunk callback (streaming mode only), disconnecting the old one.
+		/// The callback is called from the main context the executor runs in.
+		void set_output_chunk_callback(output_chunk_func_t func);
+
+
+
 		// Callbacks (Note: These are called by the real callbacks)
 
 		/// Child watch handler
 		static void on_child_watch_handler(GPid arg_pid, int waitpid_status, gpointer data);
 
+		/// Child pidfd readiness handler (Linux, see attach_child_watch())
+		static gboolean on_child_pidfd_ready(AsyncCommandExecutor* self);
+
 		/// Channel I/O handler
 		static gboolean on_channel_io(GIOChannel* channel, GIOCondition cond, AsyncCommandExecutor* self, Channel channel_type);
 
+		/// Stop timeout handler
+		static void on_stop_timeout(AsyncCommandExecutor* self, hz::Signal sig);
+
 
 	private:
 
@@ -167,6 +247,24 @@ class AsyncCommandExecutor : public hz::ErrorHolder {
 		/// Clean up the member variables and shut down the channels if needed.
 		void cleanup_members();
 
+		/// Start the child with posix_spawn() and watch for its exit with a pidfd.
+		/// This is used instead of g_spawn_*() in Linux, see execute().
+		/// \return false if it failed (the error is pushed then).
+		bool posix_spawn_child(const std::vector<std::string>& argv, const std::vector<std::string>& envp);
+
+		/// Start the child with win32_child_process_start(), which reads its output with
+		/// overlapped I/O and reports its exit, replacing the channels and the child watch.
+		/// This is used instead of g_spawn_*() in Windows, see execute().
+		/// \return false if it failed (the error is pushed then).
+		bool win32_spawn_child(const std::vector<std::string>& argv, const std::vector<std::string>& envp);
+
+		/// Attach the child exit watch to main_context_. This is a pidfd watch
+		/// if posix_spawn_child() opened one, a glib child watch otherwise.
+		void attach_child_watch();
+
+		/// Set the first byte time in timing_ if it's not set and there is some stdout data.
+		void update_first_byte_time();
+
 
 
 		// default command and its args. std::strings, not ustrings.
@@ -179,10 +277,16 @@ class AsyncCommandExecutor : public hz::ErrorHolder {
 		bool child_watch_handler_called_ = false;  ///< true after child_watch_handler callback, before stopped_cleanup().
 
 		GPid pid_ = 0;  ///< Process ID. int in Unix, pointer in win32
+		int pidfd_ = -1;  ///< Linux process file descriptor of the child, -1 if not used
 		int waitpid_status_ = 0;  ///< After the command is stopped, before cleanup, this will be available (waitpid() status).
 
 
+		GMainContext* main_context_ = nullptr;  ///< Main context the event sources are attached to (thread-default at execute()). NOT affected by cleanup_members().
+
 		GTimer* timer_ = nullptr;  ///< Keeps track of elapsed time since command execution. Value is not used by this class, but may be handy.
+		std::chrono::steady_clock::time_point execute_start_time_;  ///< Time of the last execute() call
+		ExecutionTiming timing_;  ///< Timing of the last execution
+		std::int64_t trace_start_ns_ = -1;  ///< Execution start time for tracing (see app_trace_now()), -1 if tracing is disabled.
 
 		guint event_source_id_term = 0;  ///< Timeout event source ID for SIGTERM.
 		guint event_source_id_kill = 0;  ///< Timeout event source ID for SIGKILL.
@@ -194,9 +298,20 @@ class AsyncCommandExecutor : public hz::ErrorHolder {
 		GIOChannel* channel_stdout_ = nullptr;  ///< stdout channel
 		GIOChannel* channel_stderr_ = nullptr;  ///< stderr channel
 
+		std::shared_ptr<Win32ChildProcess> win32_child_;  ///< Windows child process backend (used instead of the channels)
+
 		gsize channel_stdout_buffer_size_ = 100UL * 1024UL;  ///< stdout channel buffer size. NOT affected by cleanup_members(). 100K.
 		gsize channel_stderr_buffer_size_ = 10UL * 1024UL;  ///< stderr channel buffer size. NOT affected by cleanup_members(). 10K.
 
+		std::size_t expected_stdout_size_ = 0;  ///< See set_expected_output_sizes(). Reset by execute().
+		std::size_t expected_stderr_size_ = 0;  ///< See set_expected_output_sizes(). Reset by execute().
+
+		bool streaming_ = false;  ///< Streaming mode requested. NOT affected by cleanup_members().
+		bool streaming_active_ = false;  ///< Streaming mode is used for the current execution.
+
+		CommandExecutionPolicy execution_policy_;  ///< Resource controls of the spawned processes. NOT affected by cleanup_members().
+		hz::fs::path cgroup_root_;  ///< cgroup2 mount point for execution_policy_. NOT affected by cleanup_members().
+
 		guint event_source_id_stdout_ = 0;  ///< IO watcher event source ID for stdout
 		guint event_source_id_stderr_ = 0;  ///< IO watcher event source ID for stderr
 
@@ -212,6 +327,9 @@ class AsyncCommandExecutor : public hz::ErrorHolder {
 		// "command exited" signal callback.
 		exited_callback_func_t exited_callback_{ };  ///< Exit notifier function. NOT affected by cleanup_members().
 
+		// Streaming mode chunk callback.
+		output_chunk_func_t output_chunk_callback_{ };  ///< Output chunk receiver. NOT affected by cleanup_members().
+
 };
 
 
@@ -0,0 +1,555 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include "hz/win32_tools.h"  // win32_utf8_to_utf16
+	#include "hz/string_sprintf.h"
+#endif
+
+#include "hz/debug.h"
+
+#include "async_command_executor_win32.h"
+
+
+
+std::string win32_make_command_line(const std::vector<std::string>& argv)
+{
+	std::string command_line;
+	for (const std::string& arg : argv) {
+		if (!command_line.empty()) {
+			command_line += ' ';
+		}
+		if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos) {
+			command_line += arg;
+			continue;
+		}
+		// Backslashes are literal, unless they precede a quote (escaped or closing)
+		command_line += '"';
+		std::size_t backslashes = 0;
+		for (const char c : arg) {
+			if (c == '\\') {
+				++backslashes;
+				continue;
+			}
+			if (c == '"') {
+				command_line.append(backslashes * 2 + 1, '\\');
+			} else {
+				command_line.append(backslashes, '\\');
+			}
+			backslashes = 0;
+			command_line += c;
+		}
+		command_line.append(backslashes * 2, '\\');
+		command_line += '"';
+	}
+	return command_line;
+}
+
+
+
+#ifdef _WIN32
+
+namespace {
+
+	/// Size of a pipe read
+	constexpr DWORD win32_pipe_read_size = 16UL * 1024UL;
+
+
+	/// An output pipe of a child, read with overlapped I/O
+	struct Win32PipeReader {
+		OVERLAPPED overlapped = {};  ///< Must be the first member, the completions point to it
+		HANDLE pipe = INVALID_HANDLE_VALUE;  ///< Server (reading) end of the pipe
+		std::array<char, win32_pipe_read_size> buffer = {};  ///< Read buffer
+		bool is_stderr = false;  ///< stderr, not stdout
+		bool open = false;  ///< No EOF yet
+	};
+
+
+	/// An event delivered to the main context of a child
+	struct Win32ChildEvent {
+		std::shared_ptr<Win32ChildProcess> child;  ///< Keeps the child alive until delivered
+		bool exited = false;  ///< Exit event, otherwise output
+		bool is_stderr = false;  ///< Output channel
+		std::string data;  ///< Output
+		int exit_code = 0;  ///< Exit code
+	};
+
+
+	class Win32ChildProcessImpl;
+
+
+	/// The I/O completion port shared by all the children, with its thread
+	class Win32ProcessIoPort {
+		public:
+
+			/// Get the port, starting it if needed. \return nullptr on error.
+			static Win32ProcessIoPort* get()
+			{
+				static Win32ProcessIoPort* port = []() -> Win32ProcessIoPort* {
+					HANDLE iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+					if (iocp == nullptr) {
+						debug_out_error("app", DBG_FUNC_MSG << "Cannot create an I/O completion port, error " << GetLastError() << ".\n");
+						return nullptr;
+					}
+					auto* new_port = new Win32ProcessIoPort(iocp);  // lives until the program exits
+					std::thread(&Win32ProcessIoPort::run, new_port).detach();
+					return new_port;
+				}();
+				return port;
+			}
+
+
+			/// Get the completion port handle
+			[[nodiscard]] HANDLE get_handle() const
+			{
+				return iocp_;
+			}
+
+
+			/// Keep the child alive until it's finished, see remove().
+			void add(const std::shared_ptr<Win32ChildProcessImpl>& child);
+
+
+			/// Forget a finished child
+			void remove(Win32ChildProcessImpl* child)
+			{
+				const std::scoped_lock lock(mutex_);
+				children_.erase(child);
+			}
+
+
+		private:
+
+			/// Constructor
+			explicit Win32ProcessIoPort(HANDLE iocp) : iocp_(iocp)
+			{ }
+
+			/// Service the completions (the port thread)
+			void run();
+
+
+			HANDLE iocp_ = nullptr;  ///< Completion port
+			std::mutex mutex_;  ///< Protects children_
+			std::map<Win32ChildProcessImpl*, std::shared_ptr<Win32ChildProcessImpl>> children_;  ///< Running children (key is the completion key)
+
+	};
+
+
+
+	/// Win32ChildProcess implementation
+	class Win32ChildProcessImpl : public Win32ChildProcess, public std::enable_shared_from_this<Win32ChildProcessImpl> {
+		public:
+
+			/// Constructor
+			Win32ChildProcessImpl(GMainContext* context, Win32ChildProcessCallbacks callbacks)
+					: context_(g_main_context_ref(context)), callbacks_(std::move(callbacks))
+			{
+				stdout_reader_.is_stderr = false;
+				stderr_reader_.is_stderr = true;
+			}
+
+			/// Deleted
+			Win32ChildProcessImpl(const Win32ChildProcessImpl& other) = delete;
+
+			/// Deleted
+			Win32ChildProcessImpl(Win32ChildProcessImpl&& other) = delete;
+
+			/// Deleted
+			Win32ChildProcessImpl& operator=(const Win32ChildProcessImpl& other) = delete;
+
+			/// Deleted
+			Win32ChildProcessImpl& operator=(Win32ChildProcessImpl&& other) = delete;
+
+			/// Destructor
+			~Win32ChildProcessImpl() override
+			{
+				for (auto* reader : {&stdout_reader_, &stderr_reader_}) {
+					if (reader->pipe != INVALID_HANDLE_VALUE) {
+						CloseHandle(reader->pipe);
+					}
+				}
+				if (wait_handle_ != nullptr) {
+					// Waits for the exit callback if it's running. It doesn't hold a reference, so this is not its thread.
+					UnregisterWaitEx(wait_handle_, INVALID_HANDLE_VALUE);
+				}
+				if (process_ != nullptr) {
+					CloseHandle(process_);
+				}
+				g_main_context_unref(context_);
+			}
+
+
+			// Reimplemented
+			void detach() override
+			{
+				detached_ = true;
+			}
+
+
+			/// Create the pipes and start the process. \return false on error.
+			bool start(Win32ProcessIoPort& port, const std::vector<std::string>& argv,
+					const std::vector<std::string>& envp, HANDLE& process_handle, std::string& error_msg);
+
+
+			/// Handle a completion on the port thread. \c overlapped is nullptr for the exit notification,
+			/// and points to start_overlapped_ for the request to issue the first reads.
+			void on_completion(OVERLAPPED* overlapped, bool success, DWORD bytes);
+
+
+		private:
+
+			/// Create a pipe, returning the inheritable client (writing) end. \return nullptr on error.
+			HANDLE create_pipe(Win32ProcessIoPort& port, Win32PipeReader& reader, std::string& error_msg);
+
+			/// Issue the next read on a pipe, closing it on EOF. Port thread.
+			void start_read(Win32PipeReader& reader);
+
+			/// Deliver the exit event if the process exited and both pipes are closed
+			void finish_if_done();
+
+			/// Deliver an event to the main context
+			void post_event(std::unique_ptr<Win32ChildEvent> event);
+
+			/// Idle callback in the main context
+			static gboolean on_event(gpointer data);
+
+
+			GMainContext* context_ = nullptr;  ///< Main context of the events
+			Win32ChildProcessCallbacks callbacks_;  ///< Event receivers
+			std::atomic<bool> detached_ = false;  ///< detach() was called
+
+			Win32PipeReader stdout_reader_;  ///< stdout pipe
+			Win32PipeReader stderr_reader_;  ///< stderr pipe
+			HANDLE process_ = nullptr;  ///< Our own process handle
+			HANDLE wait_handle_ = nullptr;  ///< RegisterWaitForSingleObject() handle, unregistered in the destructor
+			OVERLAPPED start_overlapped_ = {};  ///< Marks the completion packet which issues the first reads
+			// Once start() posts the first reads, the members below are used by the port thread only.
+			bool exited_ = false;  ///< The process exited (port thread)
+			bool finished_ = false;  ///< The exit event was delivered (port thread)
+			Win32ProcessIoPort* port_ = nullptr;  ///< The port
+
+	};
+
+
+
+	void Win32ProcessIoPort::add(const std::shared_ptr<Win32ChildProcessImpl>& child)
+	{
+		const std::scoped_lock lock(mutex_);
+		children_[child.get()] = child;
+	}
+
+
+
+	void Win32ProcessIoPort::run()
+	{
+		while (true) {
+			DWORD bytes = 0;
+			ULONG_PTR key = 0;
+			OVERLAPPED* overlapped = nullptr;
+			const BOOL success = GetQueuedCompletionStatus(iocp_, &bytes, &key, &overlapped, INFINITE);
+			if (success == FALSE && overlapped == nullptr) {
+				debug_out_error("app", DBG_FUNC_MSG << "I/O completion port failure, error " << GetLastError() << ".\n");
+				continue;
+			}
+
+			std::shared_ptr<Win32ChildProcessImpl> child;
+			{
+				const std::scoped_lock lock(mutex_);
+				if (auto iter = children_.find(reinterpret_cast<Win32ChildProcessImpl*>(key)); iter != children_.end()) {
+					child = iter->second;
+				}
+			}
+			if (child) {
+				child->on_completion(overlapped, success == TRUE, bytes);
+			}
+		}
+	}
+
+
+
+	bool Win32ChildProcessImpl::start(Win32ProcessIoPort& port, const std::vector<std::string>& argv,
+			const std::vector<std::string>& envp, HANDLE& process_handle, std::string& error_msg)
+	{
+		port_ = &port;
+		// Registered first, the completion key must be known to the port before any I/O
+		port.add(shared_from_this());
+
+		HANDLE stdout_client = create_pipe(port, stdout_reader_, error_msg);
+		HANDLE stderr_client = (stdout_client != nullptr) ? create_pipe(port, stderr_reader_, error_msg) : nullptr;
+
+		SECURITY_ATTRIBUTES inheritable = {sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+		HANDLE stdin_null = CreateFileW(L"NUL", GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+				&inheritable, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		auto close_client_handles = [&]() {
+			for (HANDLE h : {stdout_client, stderr_client, stdin_null}) {
+				if (h != nullptr && h != INVALID_HANDLE_VALUE) {
+					CloseHandle(h);
+				}
+			}
+		};
+
+		if (stdout_client == nullptr || stderr_client == nullptr || stdin_null == INVALID_HANDLE_VALUE) {
+			if (error_msg.empty()) {
+				error_msg = hz::string_sprintf("Cannot open the NUL device, error %lu.", GetLastError());
+			}
+			close_client_handles();
+			port.remove(this);
+			return false;
+		}
+
+		// Only these handles are inherited, so that the children started concurrently
+		// don't keep each other's pipes open (which would delay the EOFs).
+		std::array<HANDLE, 3> inherited_handles = {stdin_null, stdout_client, stderr_client};
+		SIZE_T attr_size = 0;
+		InitializeProcThreadAttributeList(nullptr, 1, 0, &attr_size);
+		std::vector<unsigned char> attr_buffer(attr_size);
+		auto* attr_list = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attr_buffer.data());
+		InitializeProcThreadAttributeList(attr_list, 1, 0, &attr_size);
+		UpdateProcThreadAttribute(attr_list, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+				inherited_handles.data(), inherited_handles.size() * sizeof(HANDLE), nullptr, nullptr);
+
+		STARTUPINFOEXW startup_info = {};
+		startup_info.StartupInfo.cb = sizeof(startup_info);
+		startup_info.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+		startup_info.StartupInfo.hStdInput = stdin_null;
+		startup_info.StartupInfo.hStdOutput = stdout_client;
+		startup_info.StartupInfo.hStdError = stderr_client;
+		startup_info.lpAttributeList = attr_list;
+
+		std::wstring command_line = hz::win32_utf8_to_utf16(win32_make_command_line(argv));
+
+		std::wstring environment;
+		for (const auto& var : envp) {
+			environment += hz::win32_utf8_to_utf16(var);
+			environment += L'\0';
+		}
+		environment += L'\0';
+
+		PROCESS_INFORMATION process_info = {};
+		const BOOL created = CreateProcessW(nullptr, command_line.data(), nullptr, nullptr, TRUE,
+				CREATE_NO_WINDOW | CREATE_UNICODE_ENVIRONMENT | EXTENDED_STARTUPINFO_PRESENT,
+				environment.data(), nullptr, &startup_info.StartupInfo, &process_info);
+		const DWORD create_error = GetLastError();
+
+		DeleteProcThreadAttributeList(attr_list);
+		// The child has its own copies now; the pipes report EOF when it closes them.
+		close_client_handles();
+
+		if (created == FALSE) {
+			error_msg = hz::string_sprintf("Cannot execute \"%s\", error %lu.", argv.empty() ? "" : argv.front().c_str(), create_error);
+			port.remove(this);
+			return false;
+		}
+		CloseHandle(process_info.hThread);
+		process_ = process_info.hProcess;
+
+		HANDLE caller_handle = nullptr;
+		DuplicateHandle(GetCurrentProcess(), process_, GetCurrentProcess(), &caller_handle, 0, FALSE, DUPLICATE_SAME_ACCESS);
+		process_handle = caller_handle;
+
+		// The first reads are issued by the port thread, so that the pipe and exit state is never
+		// touched by two threads at once (the exit callback may run as soon as it's registered).
+		if (PostQueuedCompletionStatus(port.get_handle(), 0, reinterpret_cast<ULONG_PTR>(this), &start_overlapped_) == FALSE) {
+			// Nothing is queued for us yet, so the port thread doesn't touch the state. Deliver the exit without the output.
+			debug_out_error("app", DBG_FUNC_MSG << "Cannot start reading the output, error " << GetLastError() << ".\n");
+			stdout_reader_.open = false;
+			stderr_reader_.open = false;
+		}
+
+		// The exit is posted to the port too, so that it's ordered with the reads
+		auto exit_callback = [](PVOID data, [[maybe_unused]] BOOLEAN timed_out) {
+			auto* self = static_cast<Win32ChildProcessImpl*>(data);
+			PostQueuedCompletionStatus(self->port_->get_handle(), 0, reinterpret_cast<ULONG_PTR>(self), nullptr);
+		};
+		if (RegisterWaitForSingleObject(&wait_handle_, process_, exit_callback, this, INFINITE, WT_EXECUTEONLYONCE) == FALSE) {
+			debug_out_error("app", DBG_FUNC_MSG << "Cannot wait for the process exit, error " << GetLastError() << ".\n");
+			wait_handle_ = nullptr;
+			PostQueuedCompletionStatus(port.get_handle(), 0, reinterpret_cast<ULONG_PTR>(this), nullptr);  // don't hang
+		}
+		return true;
+	}
+
+
+
+	HANDLE Win32ChildProcessImpl::create_pipe(Win32ProcessIoPort& port, Win32PipeReader& reader, std::string& error_msg)
+	{
+		static std::atomic<unsigned long> pipe_counter = 0;
+		const std::wstring name = hz::win32_utf8_to_utf16(hz::string_sprintf("\\\\.\\pipe\\gsmartcontrol-%lu-%lu",
+				GetCurrentProcessId(), ++pipe_counter));
+
+		reader.pipe = CreateNamedPipeW(name.c_str(),
+				PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+				PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+				1, 0, win32_pipe_read_size, 0, nullptr);
+		if (reader.pipe == INVALID_HANDLE_VALUE) {
+			error_msg = hz::string_sprintf("Cannot create a pipe, error %lu.", GetLastError());
+			return nullptr;
+		}
+
+		SECURITY_ATTRIBUTES inheritable = {sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+		HANDLE client = CreateFileW(name.c_str(), GENERIC_WRITE, 0, &inheritable, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (client == INVALID_HANDLE_VALUE) {
+			error_msg = hz::string_sprintf("Cannot open a pipe, error %lu.", GetLastError());
+			return nullptr;
+		}
+
+		if (CreateIoCompletionPort(reader.pipe, port.get_handle(), reinterpret_cast<ULONG_PTR>(this), 0) == nullptr) {
+			error_msg = hz::string_sprintf("Cannot associate a pipe with the completion port, error %lu.", GetLastError());
+			CloseHandle(client);
+			return nullptr;
+		}
+		reader.open = true;
+		return client;
+	}
+
+
+
+	void Win32ChildProcessImpl::start_read(Win32PipeReader& reader)
+	{
+		reader.overlapped = OVERLAPPED();
+		// The completion is queued to the port even if this finishes immediately
+		if (ReadFile(reader.pipe, reader.buffer.data(), DWORD(reader.buffer.size()), nullptr, &reader.overlapped) == FALSE
+				&& GetLastError() != ERROR_IO_PENDING) {
+			reader.open = false;  // ERROR_BROKEN_PIPE: the child closed its end
+			finish_if_done();
+		}
+	}
+
+
+
+	void Win32ChildProcessImpl::on_completion(OVERLAPPED* overlapped, bool success, DWORD bytes)
+	{
+		if (overlapped == nullptr) {
+			exited_ = true;
+			finish_if_done();
+			return;
+		}
+		if (overlapped == &start_overlapped_) {
+			start_read(stdout_reader_);
+			start_read(stderr_reader_);
+			return;
+		}
+
+		Win32PipeReader& reader = (overlapped == &stdout_reader_.overlapped) ? stdout_reader_ : stderr_reader_;
+		if (!success) {
+			reader.open = false;  // ERROR_BROKEN_PIPE: the child closed its end
+			finish_if_done();
+			return;
+		}
+		if (bytes > 0) {
+			auto event = std::make_unique<Win32ChildEvent>();
+			event->is_stderr = reader.is_stderr;
+			event->data.assign(reader.buffer.data(), bytes);
+			post_event(std::move(event));
+		}
+		start_read(reader);
+	}
+
+
+
+	void Win32ChildProcessImpl::finish_if_done()
+	{
+		if (finished_ || !exited_ || stdout_reader_.open || stderr_reader_.open) {
+			return;
+		}
+		finished_ = true;
+
+		DWORD exit_code = 0;
+		GetExitCodeProcess(process_, &exit_code);
+
+		auto event = std::make_unique<Win32ChildEvent>();
+		event->exited = true;
+		event->exit_code = static_cast<int>(exit_code);
+		post_event(std::move(event));
+
+		port_->remove(this);  // the event keeps us alive
+	}
+
+
+
+	void Win32ChildProcessImpl::post_event(std::unique_ptr<Win32ChildEvent> event)
+	{
+		event->child = shared_from_this();
+		// Not g_main_context_invoke(), which may call the function right here if the context is free.
+		// Same-priority idle sources are dispatched in order, so the output precedes the exit.
+		GSource* source = g_idle_source_new();
+		g_source_set_priority(source, G_PRIORITY_HIGH);
+		g_source_set_callback(source, &Win32ChildProcessImpl::on_event, event.release(),
+				[](gpointer data) { delete static_cast<Win32ChildEvent*>(data); });
+		g_source_attach(source, context_);
+		g_source_unref(source);
+	}
+
+
+
+	gboolean Win32ChildProcessImpl::on_event(gpointer data)
+	{
+		const auto* event = static_cast<Win32ChildEvent*>(data);
+		auto* self = static_cast<Win32ChildProcessImpl*>(event->child.get());
+		if (self->detached_) {
+			return FALSE;
+		}
+		if (event->exited) {
+			if (self->callbacks_.on_exit) {
+				self->callbacks_.on_exit(event->exit_code);
+			}
+		} else if (self->callbacks_.on_output) {
+			self->callbacks_.on_output(event->is_stderr, event->data);
+		}
+		return FALSE;  // one-time call
+	}
+
+}
+
+#endif
+
+
+
+Win32ChildProcessPtr win32_child_process_start(const std::vector<std::string>& argv,
+		const std::vector<std::string>& envp, GMainContext* context, Win32ChildProcessCallbacks callbacks,
+		void*& process_handle, std::string& error_msg)
+{
+#ifdef _WIN32
+	Win32ProcessIoPort* port = Win32ProcessIoPort::get();
+	if (!port) {
+		error_msg = "Cannot create an I/O completion port.";
+		return nullptr;
+	}
+	auto child = std::make_shared<Win32ChildProcessImpl>(context, std::move(callbacks));
+	HANDLE handle = nullptr;
+	if (!child->start(*port, argv, envp, handle, error_msg)) {
+		return nullptr;
+	}
+	process_handle = handle;
+	return child;
+#else
+	static_cast<void>(argv);
+	static_cast<void>(envp);
+	static_cast<void>(context);
+	static_cast<void>(callbacks);
+	static_cast<void>(process_handle);
+	error_msg = "Not supported on this platform.";
+	return nullptr;
+#endif
+}
+
+
+
+
+/// @}
@@ -0,0 +1,77 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef ASYNC_COMMAND_EXECUTOR_WIN32_H
+#define ASYNC_COMMAND_EXECUTOR_WIN32_H
+
+#include <glib.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+/// Build a Windows command line from the arguments, quoting them so that
+/// CommandLineToArgvW() (and the C runtime) split it back into the same arguments.
+[[nodiscard]] std::string win32_make_command_line(const std::vector<std::string>& argv);
+
+
+
+/// Events of a child process started by win32_child_process_start(),
+/// called in the main context passed to it.
+struct Win32ChildProcessCallbacks {
+	/// Output data, on stdout if \c is_stderr is false. The data is valid only during the call.
+	std::function<void(bool is_stderr, std::string_view data)> on_output;
+
+	/// The process exited and all its output has been delivered
+	std::function<void(int exit_code)> on_exit;
+};
+
+
+
+/// A child process whose stdout and stderr are read through overlapped named pipes.
+/// All the children share one I/O completion port serviced by one thread, and their exits are
+/// waited for by the system thread pool, so there are no per-pipe (or per-child) helper threads,
+/// unlike with GLib's spawn and channel emulation. Windows only.
+class Win32ChildProcess {
+	public:
+
+		/// Stop delivering the events (the receiver is going away). The process keeps running.
+		/// Call in the main context passed to win32_child_process_start().
+		virtual void detach() = 0;
+
+		/// Destructor
+		virtual ~Win32ChildProcess() = default;
+
+};
+
+
+/// Child process handle
+using Win32ChildProcessPtr = std::shared_ptr<Win32ChildProcess>;
+
+
+
+/// Start a child process with the arguments (the first one is the program, looked up in PATH)
+/// and environment ("NAME=value" strings). \c process_handle receives a process handle
+/// (a HANDLE, to be closed by the caller). The events are delivered in \c context.
+/// \return nullptr on error (with \c error_msg set), or if not supported (non-Windows).
+[[nodiscard]] Win32ChildProcessPtr win32_child_process_start(const std::vector<std::string>& argv,
+		const std::vector<std::string>& envp, GMainContext* context, Win32ChildProcessCallbacks callbacks,
+		void*& process_handle, std::string& error_msg);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,316 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_benchmarks
+/// \weakgroup applib_benchmarks
+/// @{
+
+/*
+Parser benchmark. Runs SmartctlParser::create(), parse() and
+StoragePropertyProcessor::process_properties() for every parser type over
+all files in a corpus directory (captured smartctl -x / -x --json outputs),
+and reports time and allocations per operation for each phase.
+
+Usage: bench_smartctl_parser <corpus_dir> [iterations]
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "hz/fs.h"
+#include "hz/main_tools.h"
+#include "hz/string_num.h"
+#include "libdebug/libdebug.h"
+#include "applib/smartctl_parser.h"
+#include "applib/storage_device.h"
+#include "applib/storage_property_descr.h"
+
+
+
+namespace {
+
+	std::atomic<std::uint64_t> s_alloc_count{0};  ///< Number of allocations since program start
+	std::atomic<std::uint64_t> s_alloc_bytes{0};  ///< Number of allocated bytes since program start
+
+}
+
+
+
+// Global allocation counters. Other forms of operator new / delete call these.
+
+void* operator new(std::size_t size)
+{
+	s_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	s_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+
+void operator delete(void* p, [[maybe_unused]] std::size_t size) noexcept
+{
+	std::free(p);
+}
+
+
+void operator delete[](void* p, [[maybe_unused]] std::size_t size) noexcept
+{
+	std::free(p);
+}
+
+
+
+
+namespace {
+
+
+	/// Accumulated cost of a benchmark phase
+	struct PhaseStats {
+		std::uint64_t ops = 0;  ///< Number of operations
+		std::chrono::nanoseconds time{0};  ///< Total time
+		std::uint64_t allocs = 0;  ///< Total number of allocations
+		std::uint64_t bytes = 0;  ///< Total number of allocated bytes
+
+		/// Add another stats object to this one
+		void add(const PhaseStats& other)
+		{
+			ops += other.ops;
+			time += other.time;
+			allocs += other.allocs;
+			bytes += other.bytes;
+		}
+	};
+
+
+
+	/// Measures time and allocations between construction and stop()
+	class PhaseMeter {
+		public:
+
+			/// Start measuring
+			PhaseMeter()
+					: start_allocs_(s_alloc_count.load(std::memory_order_relaxed)),
+					start_bytes_(s_alloc_bytes.load(std::memory_order_relaxed)),
+					start_time_(std::chrono::steady_clock::now())
+			{ }
+
+			/// Stop measuring and add the result to \c stats as one operation
+			void stop(PhaseStats& stats) const
+			{
+				const auto end_time = std::chrono::steady_clock::now();
+				stats.ops += 1;
+				stats.time += std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time_);
+				stats.allocs += s_alloc_count.load(std::memory_order_relaxed) - start_allocs_;
+				stats.bytes += s_alloc_bytes.load(std::memory_order_relaxed) - start_bytes_;
+			}
+
+		private:
+			std::uint64_t start_allocs_ = 0;
+			std::uint64_t start_bytes_ = 0;
+			std::chrono::steady_clock::time_point start_time_;
+	};
+
+
+
+	/// Benchmark phases
+	enum class Phase {
+		Create,  ///< SmartctlParser::create()
+		Parse,  ///< SmartctlParser::parse()
+		Process,  ///< StoragePropertyProcessor::process_properties()
+	};
+
+
+	/// Get phase name
+	std::string get_phase_name(Phase phase)
+	{
+		switch (phase) {
+			case Phase::Create: return "create";
+			case Phase::Parse: return "parse";
+			case Phase::Process: return "process";
+		}
+		return {};
+	}
+
+
+	/// Get parser name, e.g. "ata/json"
+	std::string get_parser_name(SmartctlParserType type, SmartctlOutputFormat format)
+	{
+		std::string name;
+		switch (type) {
+			case SmartctlParserType::Basic: name = "basic"; break;
+			case SmartctlParserType::Ata: name = "ata"; break;
+			case SmartctlParserType::Nvme: name = "nvme"; break;
+		}
+		return name + (format == SmartctlOutputFormat::Json ? "/json" : "/text");
+	}
+
+
+
+	/// Print one report line
+	void print_stats_line(const std::string& file, const std::string& parser, Phase phase, const PhaseStats& stats)
+	{
+		if (stats.ops == 0) {
+			return;
+		}
+		const auto ops = static_cast<double>(stats.ops);
+		std::cout << fmt::format("{:<40} {:<12} {:<8} {:>14.0f} {:>12.1f} {:>14.0f}\n",
+				file, parser, get_phase_name(phase),
+				static_cast<double>(stats.time.count()) / ops,
+				static_cast<double>(stats.allocs) / ops,
+				static_cast<double>(stats.bytes) / ops);
+	}
+
+
+
+	/// Run the benchmark on one file, \c iterations times for each parser type.
+	/// Adds the results to \c totals.
+	void bench_file(const std::string& name, const std::string& output, int iterations,
+			std::map<std::tuple<std::string, Phase>, PhaseStats>& totals)
+	{
+		auto format = SmartctlParser::detect_output_format(output);
+		if (!format) {
+			std::cerr << name << ": " << format.error().message() << ", skipping.\n";
+			return;
+		}
+
+		for (auto type : {SmartctlParserType::Basic, SmartctlParserType::Ata, SmartctlParserType::Nvme}) {
+			if (!SmartctlParser::create(type, format.value())) {
+				continue;  // no such parser
+			}
+			const std::string parser_name = get_parser_name(type, format.value());
+			std::map<Phase, PhaseStats> stats;
+			std::string parse_error;
+
+			for (int i = 0; i < iterations; ++i) {
+				PhaseMeter create_meter;
+				auto parser = SmartctlParser::create(type, format.value());
+				create_meter.stop(stats[Phase::Create]);
+
+				PhaseMeter parse_meter;
+				auto parse_status = parser->parse(output);
+				parse_meter.stop(stats[Phase::Parse]);
+
+				if (!parse_status) {
+					parse_error = parse_status.error().message();
+					break;  // e.g. NVMe parser over ATA data
+				}
+
+				// Detect the drive type the same way StorageDevice does. This is not measured.
+				StorageDevice drive(name);
+				drive.detect_drive_type_from_properties(parser->get_property_repository());
+
+				PhaseMeter process_meter;
+				auto processed = StoragePropertyProcessor::process_properties(parser->take_property_repository(), drive.get_detected_type());
+				process_meter.stop(stats[Phase::Process]);
+			}
+
+			if (!parse_error.empty()) {
+				std::cout << fmt::format("{:<40} {:<12} parse error: {}\n", name, parser_name, parse_error);
+				continue;
+			}
+			for (const auto& [phase, phase_stats] : stats) {
+				print_stats_line(name, parser_name, phase, phase_stats);
+				totals[{parser_name, phase}].add(phase_stats);
+			}
+		}
+	}
+
+}
+
+
+
+/// Main function of the benchmark
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([argc, argv]()
+	{
+		if (argc < 2) {
+			std::cerr << "Usage: " << argv[0] << " <corpus_dir> [iterations]\n";
+			return EXIT_FAILURE;
+		}
+		debug_register_domain("app");
+		debug_register_domain("hz");
+
+		const hz::fs::path dir = hz::fs_path_from_string(argv[1]);
+		int iterations = 20;
+		if (argc > 2 && (!hz::string_is_numeric_nolocale(std::string(argv[2]), iterations) || iterations < 1)) {
+			std::cerr << "Invalid number of iterations: " << argv[2] << "\n";
+			return EXIT_FAILURE;
+		}
+
+		// Sort the files so that the output is stable
+		std::vector<hz::fs::path> files;
+		std::error_code ec;
+		for (const auto& entry : hz::fs::directory_iterator(dir, ec)) {
+			if (entry.is_regular_file(ec)) {
+				files.push_back(entry.path());
+			}
+		}
+		if (ec) {
+			std::cerr << "Cannot read directory \"" << argv[1] << "\": " << ec.message() << "\n";
+			return EXIT_FAILURE;
+		}
+		std::sort(files.begin(), files.end());
+
+		std::cout << fmt::format("{:<40} {:<12} {:<8} {:>14} {:>12} {:>14}\n",
+				"file", "parser", "phase", "ns/op", "allocs/op", "bytes/op");
+
+		std::map<std::tuple<std::string, Phase>, PhaseStats> totals;
+		for (const auto& file : files) {
+			std::string output;
+			const int max_size = 10*1024*1024;  // 10M
+			if (auto file_ec = hz::fs_file_get_contents(file, output, max_size)) {
+				std::cerr << hz::fs_path_to_string(file) << ": " << file_ec.message() << ", skipping.\n";
+				continue;
+			}
+			bench_file(hz::fs_path_to_string(file.filename()), output, iterations, totals);
+		}
+
+		std::cout << "\n";
+		for (const auto& [key, stats] : totals) {
+			print_stats_line("[all files]", std::get<0>(key), std::get<1>(key), stats);
+		}
+
+		return EXIT_SUCCESS;
+	});
+}
+
+
+
+
+/// @}
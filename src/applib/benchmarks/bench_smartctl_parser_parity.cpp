@@ -0,0 +1,328 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_benchmarks
+/// \weakgroup applib_benchmarks
+/// @{
+
+/*
+Text / JSON ATA parser parity harness. For each corpus sample captured in both
+formats (two files with the same name and different extensions, e.g. "drive1.txt"
+with smartctl -x and "drive1.json" with smartctl -x --json; the format is detected
+from the contents), parses and processes each file with the ATA parser of its
+format, compares the processed property repositories by (section, generic_name),
+and reports the throughput of both parsers per drive class.
+
+The properties present in both repositories are compared by value and warning level.
+The displayed strings (reported / readable values, names) differ between the formats
+by design and are only counted. Properties present in one format only are counted,
+and listed with -v.
+
+The exit status is non-zero if any shared property has a different value or warning.
+
+Usage: bench_smartctl_parser_parity [-v] <corpus_dir> [iterations]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "hz/fs.h"
+#include "hz/main_tools.h"
+#include "hz/string_num.h"
+#include "libdebug/libdebug.h"
+#include "applib/smartctl_parser.h"
+#include "applib/storage_device.h"
+#include "applib/storage_property_descr.h"
+#include "applib/storage_property_diff.h"
+
+
+
+namespace {
+
+
+	/// A corpus sample, captured in both formats
+	struct ParitySample {
+		std::string name;  ///< File name without extension
+		std::string text_output;  ///< Text format output
+		std::string json_output;  ///< JSON format output
+	};
+
+
+
+	/// Result of parsing and processing an output
+	struct ParseResult {
+		std::optional<StoragePropertyRepository> properties;  ///< Processed properties, unset on parse error
+		std::string error;  ///< Parse error
+		StorageDeviceDetectedType drive_type = StorageDeviceDetectedType::Unknown;  ///< Drive type detected from the properties
+		std::chrono::nanoseconds time{0};  ///< Total time of all iterations
+	};
+
+
+
+	/// Parse and process \c output with the ATA parser of \c format, \c iterations times
+	ParseResult parse_ata(const std::string& name, const std::string& output, SmartctlOutputFormat format, int iterations)
+	{
+		ParseResult result;
+		for (int i = 0; i < iterations; ++i) {
+			const auto start_time = std::chrono::steady_clock::now();
+
+			auto parser = SmartctlParser::create(SmartctlParserType::Ata, format);
+			if (auto parse_status = parser->parse(output); !parse_status) {
+				result.error = parse_status.error().message();
+				return result;
+			}
+			StorageDevice drive(name);
+			drive.detect_drive_type_from_properties(parser->get_property_repository());
+			auto processed = StoragePropertyProcessor::process_properties(parser->take_property_repository(), drive.get_detected_type());
+
+			result.time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+			result.drive_type = drive.get_detected_type();
+			result.properties = std::move(processed);
+		}
+		return result;
+	}
+
+
+
+	/// Parity of one sample
+	struct ParityStats {
+		std::uint64_t shared = 0;  ///< Properties present in both formats
+		std::uint64_t value_mismatches = 0;  ///< Shared properties with a different value or warning level
+		std::uint64_t string_mismatches = 0;  ///< Shared properties with the same value, but different displayed strings
+		std::uint64_t text_only = 0;  ///< Properties present in the text output only
+		std::uint64_t json_only = 0;  ///< Properties present in the JSON output only
+	};
+
+
+
+	/// Get "section/generic_name" of a property
+	std::string get_property_key(const StorageProperty& p)
+	{
+		return StoragePropertySectionExt::get_storable_name(p.section) + "/" + p.generic_name;
+	}
+
+
+
+	/// Compare the text and JSON repositories, printing the value mismatches (and with
+	/// \c verbose, the properties present in one format only).
+	ParityStats compare_repositories(const std::string& name, const StoragePropertyRepository& text_props,
+			const StoragePropertyRepository& json_props, bool verbose)
+	{
+		ParityStats stats;
+		const StoragePropertyDiff diff = storage_property_repository_diff(text_props, json_props);
+
+		for (const auto& change : diff.changes) {
+			switch (change.type) {
+				case StoragePropertyChange::Type::Added:
+					++stats.json_only;
+					if (verbose) {
+						std::cout << fmt::format("{}: json only: {} = {}\n", name,
+								get_property_key(change.new_property.value()), change.new_property->format_value());
+					}
+					break;
+				case StoragePropertyChange::Type::Removed:
+					++stats.text_only;
+					if (verbose) {
+						std::cout << fmt::format("{}: text only: {} = {}\n", name,
+								get_property_key(change.old_property.value()), change.old_property->format_value());
+					}
+					break;
+				case StoragePropertyChange::Type::Changed:
+				{
+					const StorageProperty& text_p = change.old_property.value();
+					const StorageProperty& json_p = change.new_property.value();
+					if (text_p.value == json_p.value && text_p.warning_level == json_p.warning_level) {
+						++stats.string_mismatches;
+						break;
+					}
+					++stats.value_mismatches;
+					std::cout << fmt::format("{}: MISMATCH: {}: text \"{}\" (warning {}), json \"{}\" (warning {})\n", name,
+							get_property_key(text_p), text_p.format_value(), static_cast<int>(text_p.warning_level),
+							json_p.format_value(), static_cast<int>(json_p.warning_level));
+					break;
+				}
+			}
+		}
+		stats.shared = json_props.get_properties().size() - stats.json_only;
+		return stats;
+	}
+
+
+
+	/// Throughput of the parsers for a drive class
+	struct ClassStats {
+		std::uint64_t samples = 0;  ///< Number of samples
+		std::uint64_t ops = 0;  ///< Number of parses of each format
+		std::uint64_t text_bytes = 0;  ///< Total size of the parsed text outputs
+		std::uint64_t json_bytes = 0;  ///< Total size of the parsed JSON outputs
+		std::chrono::nanoseconds text_time{0};  ///< Total time of the text parser
+		std::chrono::nanoseconds json_time{0};  ///< Total time of the JSON parser
+	};
+
+
+
+	/// Print one throughput line
+	void print_class_line(const std::string& drive_class, const ClassStats& stats)
+	{
+		if (stats.ops == 0) {
+			return;
+		}
+		const auto ops = static_cast<double>(stats.ops);
+		const auto text_ns = static_cast<double>(stats.text_time.count());
+		const auto json_ns = static_cast<double>(stats.json_time.count());
+		// bytes per ns * 1000 = MB/s
+		std::cout << fmt::format("{:<16} {:>8} {:>14.0f} {:>10.1f} {:>14.0f} {:>10.1f} {:>12.2f}\n",
+				drive_class, stats.samples,
+				text_ns / ops, text_ns > 0 ? static_cast<double>(stats.text_bytes) / text_ns * 1000. : 0.,
+				json_ns / ops, json_ns > 0 ? static_cast<double>(stats.json_bytes) / json_ns * 1000. : 0.,
+				text_ns > 0 ? json_ns / text_ns : 0.);
+	}
+
+
+
+	/// Find the samples captured in both formats in \c dir
+	std::vector<ParitySample> load_samples(const hz::fs::path& dir, std::error_code& ec)
+	{
+		std::map<std::string, ParitySample> samples;
+		for (const auto& entry : hz::fs::directory_iterator(dir, ec)) {
+			if (!entry.is_regular_file(ec)) {
+				continue;
+			}
+			std::string output;
+			const int max_size = 10*1024*1024;  // 10M
+			if (auto file_ec = hz::fs_file_get_contents(entry.path(), output, max_size)) {
+				std::cerr << hz::fs_path_to_string(entry.path()) << ": " << file_ec.message() << ", skipping.\n";
+				continue;
+			}
+			auto format = SmartctlParser::detect_output_format(output);
+			if (!format) {
+				std::cerr << hz::fs_path_to_string(entry.path()) << ": " << format.error().message() << ", skipping.\n";
+				continue;
+			}
+			const std::string name = hz::fs_path_to_string(entry.path().stem());
+			auto& sample = samples[name];
+			sample.name = name;
+			(format.value() == SmartctlOutputFormat::Json ? sample.json_output : sample.text_output) = std::move(output);
+		}
+
+		std::vector<ParitySample> result;
+		for (auto& entry : samples) {  // sorted by name, so that the output is stable
+			if (!entry.second.text_output.empty() && !entry.second.json_output.empty()) {
+				result.push_back(std::move(entry.second));
+			}
+		}
+		return result;
+	}
+
+}
+
+
+
+/// Main function of the harness
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([argc, argv]()
+	{
+		std::vector<std::string> args(argv + 1, argv + argc);
+		const bool verbose = (!args.empty() && args.front() == "-v");
+		if (verbose) {
+			args.erase(args.begin());
+		}
+		if (args.empty()) {
+			std::cerr << "Usage: " << argv[0] << " [-v] <corpus_dir> [iterations]\n";
+			return EXIT_FAILURE;
+		}
+		debug_register_domain("app");
+		debug_register_domain("hz");
+
+		int iterations = 20;
+		if (args.size() > 1 && (!hz::string_is_numeric_nolocale(args[1], iterations) || iterations < 1)) {
+			std::cerr << "Invalid number of iterations: " << args[1] << "\n";
+			return EXIT_FAILURE;
+		}
+
+		std::error_code ec;
+		const std::vector<ParitySample> samples = load_samples(hz::fs_path_from_string(args[0]), ec);
+		if (ec) {
+			std::cerr << "Cannot read directory \"" << args[0] << "\": " << ec.message() << "\n";
+			return EXIT_FAILURE;
+		}
+		if (samples.empty()) {
+			std::cerr << "No samples captured in both text and JSON formats in \"" << args[0] << "\".\n";
+			return EXIT_FAILURE;
+		}
+
+		std::map<std::string, ClassStats> class_stats;
+		ParityStats total_parity;
+		std::uint64_t parse_errors = 0;
+
+		std::cout << fmt::format("{:<40} {:>8} {:>10} {:>10} {:>10} {:>10}\n",
+				"sample", "shared", "mismatch", "strings", "text only", "json only");
+
+		for (const auto& sample : samples) {
+			const ParseResult text = parse_ata(sample.name, sample.text_output, SmartctlOutputFormat::Text, iterations);
+			const ParseResult json = parse_ata(sample.name, sample.json_output, SmartctlOutputFormat::Json, iterations);
+			if (!text.properties || !json.properties) {
+				std::cout << fmt::format("{:<40} parse error: {}\n", sample.name, !text.properties ? text.error : json.error);
+				++parse_errors;
+				continue;
+			}
+
+			const ParityStats parity = compare_repositories(sample.name, text.properties.value(), json.properties.value(), verbose);
+			std::cout << fmt::format("{:<40} {:>8} {:>10} {:>10} {:>10} {:>10}\n", sample.name,
+					parity.shared, parity.value_mismatches, parity.string_mismatches, parity.text_only, parity.json_only);
+			total_parity.shared += parity.shared;
+			total_parity.value_mismatches += parity.value_mismatches;
+			total_parity.string_mismatches += parity.string_mismatches;
+			total_parity.text_only += parity.text_only;
+			total_parity.json_only += parity.json_only;
+
+			// The JSON output has the more reliable drive type
+			auto& stats = class_stats[StorageDeviceDetectedTypeExt::get_storable_name(json.drive_type)];
+			stats.samples += 1;
+			stats.ops += static_cast<std::uint64_t>(iterations);
+			stats.text_bytes += sample.text_output.size() * static_cast<std::uint64_t>(iterations);
+			stats.json_bytes += sample.json_output.size() * static_cast<std::uint64_t>(iterations);
+			stats.text_time += text.time;
+			stats.json_time += json.time;
+		}
+
+		std::cout << fmt::format("{:<40} {:>8} {:>10} {:>10} {:>10} {:>10}\n\n", "[all samples]",
+				total_parity.shared, total_parity.value_mismatches, total_parity.string_mismatches,
+				total_parity.text_only, total_parity.json_only);
+
+		std::cout << fmt::format("{:<16} {:>8} {:>14} {:>10} {:>14} {:>10} {:>12}\n",
+				"drive class", "samples", "text ns/op", "text MB/s", "json ns/op", "json MB/s", "json/text");
+		ClassStats all_stats;
+		for (const auto& [drive_class, stats] : class_stats) {
+			print_class_line(drive_class, stats);
+			all_stats.samples += stats.samples;
+			all_stats.ops += stats.ops;
+			all_stats.text_bytes += stats.text_bytes;
+			all_stats.json_bytes += stats.json_bytes;
+			all_stats.text_time += stats.text_time;
+			all_stats.json_time += stats.json_time;
+		}
+		print_class_line("[all]", all_stats);
+
+		return (total_parity.value_mismatches == 0 && parse_errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+/// @}
@@ -0,0 +1,198 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_benchmarks
+/// \weakgroup applib_benchmarks
+/// @{
+
+/*
+Text attribute table benchmark. Splits the lines of "smartctl -A" attribute tables
+(old, old without UPDATED and brief formats, including -v variants) into columns
+with the regexps the text ATA parser used before, and with
+SmartctlTextParserHelper::tokenize_ata_attribute_line(). Reports the time per line
+of each, and fails if their results differ.
+
+Usage: bench_smartctl_text_ata_attributes [iterations]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "hz/main_tools.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+#include "applib/app_regex.h"
+#include "applib/smartctl_text_parser_helper.h"
+
+
+
+namespace {
+
+
+	/// Attribute lines with their formats
+	const std::vector<std::pair<SmartctlTextAtaAttributeFormat, std::string>> s_attribute_lines = {
+		{SmartctlTextAtaAttributeFormat::Old, "  1 Raw_Read_Error_Rate     0x000f   117   099   006    Pre-fail  Always       -       158590016"},
+		{SmartctlTextAtaAttributeFormat::Old, "  5 Reallocated_Sector_Ct   0x0033   100   100   036    Pre-fail  Always       -       0"},
+		{SmartctlTextAtaAttributeFormat::Old, "  9 Power_On_Minutes        0x0032   092   092   000    Old_age   Always       -       1720h+30m"},
+		{SmartctlTextAtaAttributeFormat::Old, "190 Airflow_Temperature_Cel 0x0022   071   059   045    Old_age   Always   In_the_past 29 (Min/Max 23/41)"},
+		{SmartctlTextAtaAttributeFormat::Old, "240 Head flying hours       0x0000   100   253   000    Old_age   Offline      -       3225 (3 105 0)"},
+		{SmartctlTextAtaAttributeFormat::NoUpdated, "  1 Raw_Read_Error_Rate     0x000b   100   100   016    Pre-fail     -       0"},
+		{SmartctlTextAtaAttributeFormat::NoUpdated, "194 Temperature_Celsius     0x0002   222   222   000    Old_age      -       27"},
+		{SmartctlTextAtaAttributeFormat::Brief, "  1 Raw_Read_Error_Rate     PO-R--   100   100   062    -    0"},
+		{SmartctlTextAtaAttributeFormat::Brief, "  5 Reallocated_Sector_Ct   PO--CK   ---   ---   ---    -    0"},
+		{SmartctlTextAtaAttributeFormat::Brief, "194 Temperature_Celsius     -O---K   222   222   000    -    27 (Min/Max 12/48)"},
+		{SmartctlTextAtaAttributeFormat::Brief, "241 Total_LBAs_Written      -O--CK   100   253   000    -    0x00000a1b2c3d"},
+	};
+
+
+
+	/// Columns of a line, split by either method
+	struct Columns {
+		std::vector<std::string> values;  ///< Column values, trimmed
+
+		bool operator==(const Columns& other) const = default;
+	};
+
+
+
+	/// Regexp-based splitting, as done by SmartctlTextAtaParser before
+	class RegexSplitter {
+		public:
+
+			RegexSplitter()
+			{
+				const std::string space_re = "[ \\t]+";
+				const std::string old_base_re = R"([ \t]*([0-9]+) ([^ \t\n]+(?:[^0-9\t\n]+)*))" + space_re + "(0x[a-fA-F0-9]+)" + space_re;
+				const std::string brief_base_re = R"([ \t]*([0-9]+) ([^ \t\n]+))" + space_re + "([A-Z+-]{2,})" + space_re;
+				const std::string vals_re = "([0-9-]+)" + space_re + "([0-9-]+)" + space_re + "([0-9-]+)" + space_re;
+				const std::string word_re = "([^ \\t\\n]+)" + space_re;
+				const std::string raw_re = "(.+)[ \\t]*";
+				re_old_up_ = app_regex_re("/" + old_base_re + vals_re + word_re + word_re + word_re + raw_re + "/mi");
+				re_old_noup_ = app_regex_re("/" + old_base_re + vals_re + word_re + word_re + raw_re + "/mi");
+				re_brief_ = app_regex_re("/" + brief_base_re + vals_re + word_re + raw_re + "/mi");
+			}
+
+			/// Split the line. \return false if it didn't match.
+			bool split(SmartctlTextAtaAttributeFormat format, const std::string& line, Columns& columns) const
+			{
+				std::string id, name, flag, value, worst, threshold, attr_type, update_type, when_failed, raw_value;
+				bool matched = false;
+				switch (format) {
+					case SmartctlTextAtaAttributeFormat::Old:
+						matched = app_regex_full_match(re_old_up_, line,
+								{&id, &name, &flag, &value, &worst, &threshold, &attr_type, &update_type, &when_failed, &raw_value});
+						break;
+					case SmartctlTextAtaAttributeFormat::NoUpdated:
+						matched = app_regex_full_match(re_old_noup_, line,
+								{&id, &name, &flag, &value, &worst, &threshold, &attr_type, &when_failed, &raw_value});
+						break;
+					case SmartctlTextAtaAttributeFormat::Brief:
+						matched = app_regex_full_match(re_brief_, line,
+								{&id, &name, &flag, &value, &worst, &threshold, &when_failed, &raw_value});
+						break;
+				}
+				columns.values = {id, hz::string_trim_copy(name), flag, value, worst, threshold,
+						attr_type, update_type, when_failed, hz::string_trim_copy(raw_value)};
+				return matched;
+			}
+
+		private:
+			std::regex re_old_up_;
+			std::regex re_old_noup_;
+			std::regex re_brief_;
+	};
+
+
+
+	/// Tokenizer-based splitting
+	bool tokenizer_split(SmartctlTextAtaAttributeFormat format, const std::string& line, Columns& columns)
+	{
+		SmartctlTextAtaAttributeFields f;
+		const bool matched = SmartctlTextParserHelper::tokenize_ata_attribute_line(line, format, f);
+		columns.values = {std::string(f.id), std::string(f.name), std::string(f.flag), std::string(f.value),
+				std::string(f.worst), std::string(f.threshold), std::string(f.attr_type), std::string(f.update_type),
+				std::string(f.when_failed), std::string(f.raw_value)};
+		return matched;
+	}
+
+
+
+	/// Run \c func over all lines \c iterations times. \return nanoseconds per line.
+	template<typename Func>
+	double measure(int iterations, Func&& func)
+	{
+		std::size_t matched = 0;
+		const auto start_time = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i) {
+			for (const auto& [format, line] : s_attribute_lines) {
+				matched += static_cast<std::size_t>(func(format, line));
+			}
+		}
+		const auto end_time = std::chrono::steady_clock::now();
+		if (matched != static_cast<std::size_t>(iterations) * s_attribute_lines.size()) {
+			std::cerr << "Not all lines were matched.\n";
+		}
+		const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+		return static_cast<double>(ns) / (static_cast<double>(iterations) * static_cast<double>(s_attribute_lines.size()));
+	}
+
+}
+
+
+
+/// Main function of the benchmark
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([argc, argv]()
+	{
+		int iterations = 10000;
+		if (argc > 1 && (!hz::string_is_numeric_nolocale(std::string(argv[1]), iterations) || iterations < 1)) {
+			std::cerr << "Invalid number of iterations: " << argv[1] << "\n";
+			return EXIT_FAILURE;
+		}
+
+		const RegexSplitter regex_splitter;
+
+		// Both methods must give the same result
+		for (const auto& [format, line] : s_attribute_lines) {
+			Columns regex_columns, tokenizer_columns;
+			const bool regex_matched = regex_splitter.split(format, line, regex_columns);
+			const bool tokenizer_matched = tokenizer_split(format, line, tokenizer_columns);
+			if (regex_matched != tokenizer_matched || regex_columns != tokenizer_columns) {
+				std::cerr << "Results differ for line: " << line << "\n";
+				return EXIT_FAILURE;
+			}
+		}
+
+		const double regex_ns = measure(iterations, [&regex_splitter](SmartctlTextAtaAttributeFormat format, const std::string& line) {
+			Columns columns;
+			return regex_splitter.split(format, line, columns);
+		});
+		const double tokenizer_ns = measure(iterations, [](SmartctlTextAtaAttributeFormat format, const std::string& line) {
+			Columns columns;
+			return tokenizer_split(format, line, columns);
+		});
+
+		std::cout << fmt::format("{:<12} {:>14}\n", "method", "ns/line");
+		std::cout << fmt::format("{:<12} {:>14.0f}\n", "regex", regex_ns);
+		std::cout << fmt::format("{:<12} {:>14.0f}\n", "tokenizer", tokenizer_ns);
+		std::cout << fmt::format("\nSpeedup: {:.1f}x\n", tokenizer_ns > 0 ? regex_ns / tokenizer_ns : 0.);
+
+		return EXIT_SUCCESS;
+	});
+}
+
+
+
+
+/// @}
@@ -0,0 +1,319 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_benchmarks
+/// \weakgroup applib_benchmarks
+/// @{
+
+/*
+Linux drive detection benchmark. Generates synthetic /proc/partitions, /proc/devices,
+/proc/scsi/scsi and /proc/scsi/sg/devices files for 10, 1000 and 10000 disks
+(with and without a set of RAID controllers: 3ware, Areca, Adaptec and HP),
+points the "system/linux_proc_*" config keys at them, and times detect_drives_linux()
+end to end. Smartctl and the RAID CLI tools are not run: a mock executor factory
+returns synthetic "smartctl --info" outputs, so the time is that of the detection
+itself (file parsing, filtering, output parsing and merging).
+
+The per-device probing is used (not "smartctl --scan-open"), since that's the path
+which scales with the number of block devices.
+
+Usage: bench_storage_detector_linux [max_parallel_detectors] [iterations]
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "hz/fs.h"
+#include "hz/main_tools.h"
+#include "hz/string_num.h"
+#include "libdebug/libdebug.h"
+#include "rconfig/rconfig.h"
+#include "applib/command_executor.h"
+#include "applib/command_executor_factory.h"
+#include "applib/gsc_settings.h"
+#include "applib/storage_detector_linux.h"
+
+
+
+namespace {
+
+
+	/// Number of populated ports on each RAID controller
+	constexpr int raid_populated_ports = 8;
+
+
+	/// Number of commands run by the mock executors
+	std::atomic<std::uint64_t> s_execution_count{0};
+
+
+
+	/// Mock smartctl executor. Returns an "smartctl --info" output for each
+	/// device, and the "empty port" output for the RAID ports past raid_populated_ports.
+	class BenchSmartctlExecutor : public CommandExecutor {
+		public:
+
+			// Reimplemented
+			bool execute() override
+			{
+				s_execution_count.fetch_add(1, std::memory_order_relaxed);
+
+				const std::vector<std::string> args = get_command_args();
+				const std::string device = args.empty() ? std::string() : args.back();
+				std::string type;
+				if (auto iter = std::find(args.begin(), args.end(), "-d"); iter != args.end() && iter + 1 != args.end()) {
+					type = *(iter + 1);
+				}
+
+				// RAID ports are specified as "type,N" or "type,N/E"
+				int port = 0;
+				if (const auto comma_pos = type.find(','); comma_pos != std::string::npos) {
+					hz::string_is_numeric_nolocale(type.substr(comma_pos + 1, type.find('/', comma_pos) - comma_pos - 1), port, false);
+				}
+
+				if (port >= raid_populated_ports) {
+					set_error_msg("Smartctl exited with status 2.");
+					set_stdout_buffer(std::make_shared<const std::string>(get_header()
+							+ "Read Device Identity failed: empty IDENTIFY data\n"));
+					return true;
+				}
+
+				set_error_msg(std::string());
+				set_stdout_buffer(std::make_shared<const std::string>(get_header()
+						+ "=== START OF INFORMATION SECTION ===\n"
+						+ "Device Model:     BENCH DISK\n"
+						+ "Serial Number:    " + device + (type.empty() ? "" : "-" + type) + "\n"
+						+ "User Capacity:    1,000,204,886,016 bytes [1.00 TB]\n"
+						+ "Sector Size:      512 bytes logical/physical\n"
+						+ "SMART support is: Available - device has SMART capability.\n"
+						+ "SMART support is: Enabled\n"
+						+ "\n"
+						+ "=== START OF READ SMART DATA SECTION ===\n"
+						+ "SMART overall-health self-assessment test result: PASSED\n"));
+				return true;
+			}
+
+
+		private:
+
+			/// Get the version header of the output
+			static std::string get_header()
+			{
+				return "smartctl 7.4 2023-08-01 r5530 [x86_64-linux-6.8.0] (local build)\n"
+						"Copyright (C) 2002-23, Bruce Allen, Christian Franke, www.smartmontools.org\n\n";
+			}
+	};
+
+
+
+	/// Mock RAID CLI (tw_cli, cli64) executor. Returns an empty output, so that the
+	/// detectors fall back to scanning the controller ports with smartctl.
+	class BenchCliExecutor : public CommandExecutor {
+		public:
+
+			// Reimplemented
+			bool execute() override
+			{
+				s_execution_count.fetch_add(1, std::memory_order_relaxed);
+				set_error_msg("Command not found.");
+				set_stdout_buffer(std::make_shared<const std::string>());
+				return true;
+			}
+	};
+
+
+
+	/// Executor factory creating the mock executors
+	class BenchExecutorFactory : public CommandExecutorFactory {
+		protected:
+
+			// Reimplemented
+			std::shared_ptr<CommandExecutor> construct_executor(ExecutorType type) override
+			{
+				if (type == ExecutorType::Smartctl) {
+					return std::make_shared<BenchSmartctlExecutor>();
+				}
+				return std::make_shared<BenchCliExecutor>();
+			}
+	};
+
+
+
+	/// Get the name of the n-th sd disk ("sda", ..., "sdz", "sdaa", ...)
+	std::string get_sd_name(std::size_t n)
+	{
+		std::string suffix;
+		++n;
+		while (n > 0) {
+			--n;
+			suffix.insert(suffix.begin(), static_cast<char>('a' + n % 26));
+			n /= 26;
+		}
+		return "sd" + suffix;
+	}
+
+
+
+	/// Write the synthetic /proc files for \c disk_count disks (every fourth one NVMe, the others
+	/// SCSI / SATA, each with a partition) to \c dir, and point the config keys at them.
+	/// \return false on error.
+	bool write_proc_tree(const hz::fs::path& dir, std::size_t disk_count, bool with_raid)
+	{
+		std::string partitions = "major minor  #blocks  name\n\n";
+		std::string devices = "Character devices:\n  1 mem\n  4 tty\n 21 sg\n\nBlock devices:\n  7 loop\n  8 sd\n  9 md\n259 blkext\n";
+		std::string scsi = "Attached devices:\n";
+		std::string sg_devices;
+
+		std::size_t sd_count = 0, nvme_count = 0;
+		for (std::size_t i = 0; i < disk_count; ++i) {
+			if (i % 4 == 3) {
+				const std::string name = "nvme" + std::to_string(nvme_count++) + "n1";
+				partitions += fmt::format(" 259 {:>7} 976762584 {}\n", 2 * i, name);
+				partitions += fmt::format(" 259 {:>7} 976761560 {}p1\n", 2 * i + 1, name);
+				continue;
+			}
+			const std::size_t sd_num = sd_count++;
+			const std::string name = get_sd_name(sd_num);
+			partitions += fmt::format("   8 {:>7} 976762584 {}\n", 16 * sd_num, name);
+			partitions += fmt::format("   8 {:>7} 976761560 {}1\n", 16 * sd_num + 1, name);
+
+			// One SCSI host per 16 disks, like a few HBAs
+			const std::size_t host = sd_num / 16, id = sd_num % 16;
+			scsi += fmt::format("Host: scsi{} Channel: 00 Id: {:02} Lun: 00\n"
+					"  Vendor: ATA      Model: BENCH DISK       Rev: 0001\n"
+					"  Type:   Direct-Access                    ANSI  SCSI revision: 05\n", host, id);
+			sg_devices += fmt::format("{}\t0\t{}\t0\t0\t1\t32\t0\t1\n", host, id);
+		}
+
+		if (with_raid) {
+			devices += "251 twa\n252 aac\n";
+
+			// The controllers are on their own hosts, after the HBAs
+			const std::size_t first_host = sd_count / 16 + 1;
+			const std::vector<std::string> controllers = {
+				"  Vendor: AMCC     Model: 9650SE-8LP DISK  Rev: 4.10\n",  // 3ware
+				"  Vendor: Areca    Model: ARC-1680-VOL#000 Rev: R001\n",  // Areca without enclosures
+				"  Vendor: Adaptec  Model: RAID5            Rev: V1.0\n",  // Adaptec
+				"  Vendor: HP       Model: P420i            Rev: 8.32\n",  // HP Smart Array
+			};
+			for (std::size_t i = 0; i < controllers.size(); ++i) {
+				scsi += fmt::format("Host: scsi{} Channel: 00 Id: 00 Lun: 00\n{}"
+						"  Type:   RAID                             ANSI  SCSI revision: 05\n", first_host + i, controllers[i]);
+				sg_devices += fmt::format("{}\t0\t0\t0\t12\t1\t32\t0\t1\n", first_host + i);
+			}
+		}
+
+		std::error_code ec;
+		hz::fs::create_directories(dir, ec);
+		const std::vector<std::pair<std::string, const std::string*>> files = {
+			{"partitions", &partitions},
+			{"devices", &devices},
+			{"scsi", &scsi},
+			{"sg_devices", &sg_devices},
+		};
+		for (const auto& [name, contents] : files) {
+			if (!ec) {
+				ec = hz::fs_file_put_contents(dir / name, *contents);
+			}
+		}
+		if (ec) {
+			std::cerr << "Cannot write to \"" << hz::fs_path_to_string(dir) << "\": " << ec.message() << "\n";
+			return false;
+		}
+
+		rconfig::set_data("system/linux_proc_partitions_path", hz::fs_path_to_string(dir / "partitions"));
+		rconfig::set_data("system/linux_proc_devices_path", hz::fs_path_to_string(dir / "devices"));
+		rconfig::set_data("system/linux_proc_scsi_scsi_path", hz::fs_path_to_string(dir / "scsi"));
+		rconfig::set_data("system/linux_proc_scsi_sg_devices_path", hz::fs_path_to_string(dir / "sg_devices"));
+		return true;
+	}
+
+}
+
+
+
+/// Main function of the benchmark
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([argc, argv]()
+	{
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		int max_parallel = 1;
+		if (argc > 1 && (!hz::string_is_numeric_nolocale(std::string(argv[1]), max_parallel) || max_parallel < 1)) {
+			std::cerr << "Usage: " << argv[0] << " [max_parallel_detectors] [iterations]\n";
+			return EXIT_FAILURE;
+		}
+		int iterations = 3;
+		if (argc > 2 && (!hz::string_is_numeric_nolocale(std::string(argv[2]), iterations) || iterations < 1)) {
+			std::cerr << "Invalid number of iterations: " << argv[2] << "\n";
+			return EXIT_FAILURE;
+		}
+
+		init_default_settings();
+		rconfig::set_data("system/linux_detection_backend", std::string("proc"));
+		rconfig::set_data("system/use_scan_open_detection", false);
+		rconfig::set_data("system/linux_max_parallel_detectors", max_parallel);
+
+		std::error_code ec;
+		const hz::fs::path tmp_dir = hz::fs::temp_directory_path(ec) / fmt::format("gsc_bench_detector_{}",
+				std::chrono::steady_clock::now().time_since_epoch().count());
+		if (ec) {
+			std::cerr << "Cannot get the temporary directory: " << ec.message() << "\n";
+			return EXIT_FAILURE;
+		}
+
+		auto ex_factory = std::make_shared<BenchExecutorFactory>();
+
+		std::cout << fmt::format("{:>8} {:<6} {:>8} {:>12} {:>14} {:>14}\n",
+				"disks", "raid", "drives", "commands", "ms/detect", "us/disk");
+
+		int status = EXIT_SUCCESS;
+		for (const std::size_t disk_count : {std::size_t(10), std::size_t(1000), std::size_t(10000)}) {
+			for (const bool with_raid : {false, true}) {
+				if (!write_proc_tree(tmp_dir / fmt::format("{}{}", disk_count, with_raid ? "_raid" : ""), disk_count, with_raid)) {
+					status = EXIT_FAILURE;
+					break;
+				}
+
+				std::chrono::nanoseconds time{0};
+				std::size_t drive_count = 0;
+				s_execution_count = 0;
+				for (int i = 0; i < iterations; ++i) {
+					std::vector<StorageDevicePtr> drives;
+					const auto start_time = std::chrono::steady_clock::now();
+					[[maybe_unused]] auto detect_status = detect_drives_linux(drives, ex_factory);
+					time += std::chrono::steady_clock::now() - start_time;
+					drive_count = drives.size();
+				}
+
+				const double ms = static_cast<double>(time.count()) / 1e6 / iterations;
+				std::cout << fmt::format("{:>8} {:<6} {:>8} {:>12} {:>14.2f} {:>14.2f}\n",
+						disk_count, with_raid ? "yes" : "no", drive_count, s_execution_count.load() / static_cast<std::uint64_t>(iterations),
+						ms, ms * 1000. / static_cast<double>(disk_count));
+			}
+		}
+
+		hz::fs::remove_all(tmp_dir, ec);
+		return status;
+	});
+}
+
+
+
+
+/// @}
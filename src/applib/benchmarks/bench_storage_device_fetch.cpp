@@ -0,0 +1,265 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_benchmarks
+/// \weakgroup applib_benchmarks
+/// @{
+
+/*
+Per-drive refresh benchmark. Runs StorageDevice::fetch_full_data_and_parse() (with a
+changed and an unchanged output), SelfTest::update() and a scan of the drives of unknown
+type (basic and full fetch, or StorageDevice::fetch_all_data_and_parse()) for a number of drives,
+with the commands answered by CommandExecutorFactoryMock from a captured smartctl
+output, and reports time and allocations per drive for each phase. No processes
+are spawned, so this measures the code above the executors only.
+
+The exact command lines are learned by running each operation once against an
+empty corpus (see CommandExecutorMockCorpus::get_misses()), so they follow the
+current settings and the drive type. The captured output (smartctl -x, in the
+format smartctl is run with by default, i.e. JSON) is used for all of them.
+
+Usage: bench_storage_device_fetch <smartctl_output_file> [drives] [iterations]
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "hz/fs.h"
+#include "hz/main_tools.h"
+#include "hz/string_num.h"
+#include "libdebug/libdebug.h"
+#include "applib/command_executor_mock.h"
+#include "applib/gsc_settings.h"
+#include "applib/selftest.h"
+#include "applib/smartctl_parser.h"
+#include "applib/storage_device.h"
+
+
+
+namespace {
+
+	std::atomic<std::uint64_t> s_alloc_count{0};  ///< Number of allocations since program start
+	std::atomic<std::uint64_t> s_alloc_bytes{0};  ///< Number of allocated bytes since program start
+
+}
+
+
+
+// Global allocation counters. Other forms of operator new / delete call these.
+
+void* operator new(std::size_t size)
+{
+	s_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	s_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+
+void operator delete(void* p, [[maybe_unused]] std::size_t size) noexcept
+{
+	std::free(p);
+}
+
+
+void operator delete[](void* p, [[maybe_unused]] std::size_t size) noexcept
+{
+	std::free(p);
+}
+
+
+
+
+namespace {
+
+
+	/// Get the detected type of the drive an output belongs to
+	StorageDeviceDetectedType get_output_drive_type(const std::string& output)
+	{
+		auto format = SmartctlParser::detect_output_format(output);
+		if (!format) {
+			return StorageDeviceDetectedType::Unknown;
+		}
+		auto parser = SmartctlParser::create(SmartctlParserType::Basic, format.value());
+		if (!parser || !parser->parse(output)) {
+			return StorageDeviceDetectedType::Unknown;
+		}
+		StorageDevice drive("/dev/null");
+		drive.detect_drive_type_from_properties(parser->get_property_repository());
+		return drive.get_detected_type();
+	}
+
+
+
+	/// Run \c func for each drive \c iterations times and print the time and allocations per drive.
+	/// \return false if \c func failed.
+	bool bench_phase(const std::string& name, const std::vector<StorageDevicePtr>& drives, int iterations,
+			const std::function<std::string(const StorageDevicePtr& drive)>& func)
+	{
+		const std::uint64_t start_allocs = s_alloc_count.load(std::memory_order_relaxed);
+		const std::uint64_t start_bytes = s_alloc_bytes.load(std::memory_order_relaxed);
+		const auto start_time = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < iterations; ++i) {
+			for (const auto& drive : drives) {
+				if (const std::string error = func(drive); !error.empty()) {
+					std::cerr << name << ": " << drive->get_device() << ": " << error << "\n";
+					return false;
+				}
+			}
+		}
+
+		const auto time = std::chrono::steady_clock::now() - start_time;
+		const auto ops = static_cast<double>(drives.size()) * iterations;
+		std::cout << fmt::format("{:<24} {:>14.0f} {:>12.1f} {:>14.0f}\n", name,
+				static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count()) / ops,
+				static_cast<double>(s_alloc_count.load(std::memory_order_relaxed) - start_allocs) / ops,
+				static_cast<double>(s_alloc_bytes.load(std::memory_order_relaxed) - start_bytes) / ops);
+		return true;
+	}
+
+}
+
+
+
+/// Main function of the benchmark
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([argc, argv]()
+	{
+		if (argc < 2) {
+			std::cerr << "Usage: " << argv[0] << " <smartctl_output_file> [drives] [iterations]\n";
+			return EXIT_FAILURE;
+		}
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		int drive_count = 100;
+		if (argc > 2 && (!hz::string_is_numeric_nolocale(std::string(argv[2]), drive_count) || drive_count < 1)) {
+			std::cerr << "Invalid number of drives: " << argv[2] << "\n";
+			return EXIT_FAILURE;
+		}
+		int iterations = 10;
+		if (argc > 3 && (!hz::string_is_numeric_nolocale(std::string(argv[3]), iterations) || iterations < 1)) {
+			std::cerr << "Invalid number of iterations: " << argv[3] << "\n";
+			return EXIT_FAILURE;
+		}
+
+		init_default_settings();
+
+		std::string output;
+		const int max_size = 10*1024*1024;  // 10M
+		if (auto ec = hz::fs_file_get_contents(hz::fs_path_from_string(argv[1]), output, max_size)) {
+			std::cerr << argv[1] << ": " << ec.message() << "\n";
+			return EXIT_FAILURE;
+		}
+		const StorageDeviceDetectedType type = get_output_drive_type(output);
+		if (type == StorageDeviceDetectedType::Unknown) {
+			std::cerr << argv[1] << ": Cannot detect the drive type from the output.\n";
+			return EXIT_FAILURE;
+		}
+
+		std::vector<StorageDevicePtr> drives;
+		for (int i = 0; i < drive_count; ++i) {
+			auto drive = std::make_shared<StorageDevice>(fmt::format("/dev/bench{}", i));
+			drive->set_detected_type(type);
+			drives.push_back(std::move(drive));
+		}
+
+		auto corpus = std::make_shared<CommandExecutorMockCorpus>();
+		auto ex_factory = std::make_shared<CommandExecutorFactoryMock>(corpus);
+		auto smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+
+		auto fetch = [&smartctl_ex](const StorageDevicePtr& drive) -> std::string {
+			auto status = drive->fetch_full_data_and_parse(smartctl_ex);
+			return status ? std::string() : status.error().message();
+		};
+		auto update_test = [&smartctl_ex](const StorageDevicePtr& drive) -> std::string {
+			SelfTest test(drive, SelfTest::TestType::ShortTest);
+			auto status = test.update(smartctl_ex);
+			return status ? std::string() : status.error().message();
+		};
+
+		// A scan of drives of unknown type, with the basic data fetched first
+		auto scan_two_step = [&smartctl_ex](const StorageDevicePtr& drive) -> std::string {
+			drive->set_detected_type(StorageDeviceDetectedType::Unknown);
+			auto status = drive->fetch_basic_data_and_parse(smartctl_ex);
+			if (status) {
+				status = drive->fetch_full_data_and_parse(smartctl_ex);
+			}
+			return status ? std::string() : status.error().message();
+		};
+		// The same, with a single smartctl run per drive
+		auto scan_single = [&smartctl_ex](const StorageDevicePtr& drive) -> std::string {
+			drive->set_detected_type(StorageDeviceDetectedType::Unknown);
+			auto status = drive->fetch_all_data_and_parse(smartctl_ex);
+			return status ? std::string() : status.error().message();
+		};
+
+		// Learn the command lines
+		for (const auto& drive : drives) {
+			[[maybe_unused]] auto fetch_error = fetch(drive);
+			[[maybe_unused]] auto update_error = update_test(drive);
+			[[maybe_unused]] auto scan_error = scan_single(drive);  // the basic data command line too, after a failure
+			drive->set_detected_type(type);
+		}
+		const auto commands = corpus->get_misses();
+		for (const auto& args : commands) {
+			corpus->add(args, output);
+		}
+		corpus->clear_misses();
+
+		std::cout << fmt::format("{} drives, {} command lines, type {}\n\n", drives.size(), commands.size(),
+				StorageDeviceDetectedTypeExt::get_storable_name(type));
+		std::cout << fmt::format("{:<24} {:>14} {:>12} {:>14}\n", "phase", "ns/drive", "allocs/drive", "bytes/drive");
+
+		// Each drive parses its output on the first fetch only, the next ones find it unchanged.
+		const bool ok = bench_phase("fetch (parse)", drives, 1, fetch)
+				&& bench_phase("fetch (unchanged)", drives, iterations, fetch)
+				&& bench_phase("selftest update", drives, iterations, update_test)
+				&& bench_phase("scan (basic + full)", drives, iterations, scan_two_step)
+				&& bench_phase("scan (single run)", drives, iterations, scan_single);
+
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+/// @}
@@ -0,0 +1,408 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_benchmarks
+/// \weakgroup applib_benchmarks
+/// @{
+
+/*
+Smartctl simulator for load tests. It's used in place of smartctl (set "system/smartctl_binary"
+to it) and serves saved smartctl outputs per device and option set, with a configurable
+latency, failure and timeout injection, and a limit on the number of commands accessing
+the same controller at once. This makes the executor pool, parallel scan and scheduler
+benchmarks reproducible without any real drives.
+
+The configuration file is given by the GSC_SMARTCTL_SIMULATOR_CONFIG environment variable:
+
+{
+	"seed": 1,  // optional; the random decisions are reproducible for the same sequence of commands
+	"state_dir": "/tmp/smartctl_sim",  // invocation counters and controller locks; required for both
+	"version_file": "version.txt",  // "smartctl -V" output; optional
+	"defaults": { ...device settings... },  // applied to all devices, overridden per device
+	"controllers": {"hba0": {"max_concurrent": 1}},
+	"devices": {
+		"/dev/sda": {
+			"type": "sat",  // for --scan-open; optional
+			"controller": "hba0",  // optional
+			"outputs": [  // the first entry whose options all appear in the arguments is used
+				{"options": ["--json=o", "-x"], "file": "sda_full.json"},
+				{"options": ["-i"], "file": "sda_info.txt"},
+				{"options": [], "file": "sda_info.txt", "exit_status": 0}
+			],
+			"exit_status": 0,  // default exit status of the outputs
+			"latency_ms": {"distribution": "lognormal", "median": 150, "sigma": 0.6},
+			"failure_rate": 0.01,  // probability of failing with failure_exit_status
+			"failure_exit_status": 2,
+			"timeout_rate": 0.001,  // probability of hanging for hang_ms before answering
+			"hang_ms": 3600000
+		}
+	}
+}
+
+The file names are relative to the configuration file. The latency distributions are
+"fixed" (value), "uniform" (min, max), "normal" (mean, stddev), "lognormal" (median, sigma)
+and "exponential" (mean), all in milliseconds. The latency is spent while holding the
+controller slot, like a real command would.
+
+"smartctl --scan-open" and "--scan" list the configured devices (as JSON with --json).
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/file.h>
+	#include <unistd.h>
+#endif
+
+#include "fmt/format.h"
+#include "nlohmann/json.hpp"
+
+#include "hz/fs.h"
+
+
+
+namespace {
+
+
+	/// Exit status if the simulator itself fails (bit 1 of the smartctl exit status: device open failed)
+	constexpr int simulator_error_exit_status = 2;
+
+
+	/// Print a simulator error in the smartctl style and return simulator_error_exit_status
+	int simulator_error(const std::string& message)
+	{
+		std::cout << "smartctl simulator: " << message << "\n";
+		return simulator_error_exit_status;
+	}
+
+
+
+	/// Get a device setting, falling back to the defaults
+	template<typename T>
+	T get_setting(const nlohmann::json& device, const nlohmann::json& defaults, const std::string& key, T default_value)
+	{
+		if (device.contains(key)) {
+			return device.at(key).get<T>();
+		}
+		if (defaults.contains(key)) {
+			return defaults.at(key).get<T>();
+		}
+		return default_value;
+	}
+
+
+
+	/// Get a random latency according to a distribution description
+	std::chrono::milliseconds get_latency(const nlohmann::json& latency, std::mt19937_64& rng)
+	{
+		if (!latency.is_object()) {
+			return std::chrono::milliseconds(0);
+		}
+		const auto distribution = latency.value("distribution", std::string("fixed"));
+		double ms = 0;
+		if (distribution == "fixed") {
+			ms = latency.value("value", 0.);
+		} else if (distribution == "uniform") {
+			ms = std::uniform_real_distribution<double>(latency.value("min", 0.), latency.value("max", 0.))(rng);
+		} else if (distribution == "normal") {
+			ms = std::normal_distribution<double>(latency.value("mean", 0.), latency.value("stddev", 0.))(rng);
+		} else if (distribution == "lognormal") {
+			ms = std::lognormal_distribution<double>(std::log(std::max(latency.value("median", 1.), 1e-3)), latency.value("sigma", 0.))(rng);
+		} else if (distribution == "exponential") {
+			ms = std::exponential_distribution<double>(1. / std::max(latency.value("mean", 1.), 1e-3))(rng);
+		} else {
+			std::cerr << "smartctl simulator: Unknown latency distribution \"" << distribution << "\", ignoring.\n";
+		}
+		return std::chrono::milliseconds(static_cast<std::int64_t>(std::max(ms, 0.)));
+	}
+
+
+
+	/// Sanitize a device name or a controller name for use in a file name
+	std::string get_state_file_name(std::string name)
+	{
+		std::replace_if(name.begin(), name.end(), [](char c) {
+			return !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '.');
+		}, '_');
+		return name;
+	}
+
+
+
+#ifndef _WIN32
+
+	/// An exclusive lock of a file, released when the process exits (even if killed)
+	class FileLock {
+		public:
+
+			/// Open the file (creating it if needed) and wait for an exclusive lock.
+			/// If \c try_only is true, don't wait (see get_locked()).
+			explicit FileLock(const hz::fs::path& file, bool try_only = false)
+			{
+				fd_ = ::open(file.c_str(), O_RDWR | O_CREAT, 0644);
+				if (fd_ != -1 && ::flock(fd_, LOCK_EX | (try_only ? LOCK_NB : 0)) == 0) {
+					locked_ = true;
+				}
+			}
+
+			/// Deleted
+			FileLock(const FileLock& other) = delete;
+
+			/// Deleted
+			FileLock& operator=(const FileLock& other) = delete;
+
+			/// Unlock and close
+			~FileLock()
+			{
+				if (fd_ != -1) {
+					::close(fd_);  // releases the lock
+				}
+			}
+
+			/// Check whether the lock is held
+			[[nodiscard]] bool get_locked() const
+			{
+				return locked_;
+			}
+
+			/// Get the file descriptor
+			[[nodiscard]] int get_fd() const
+			{
+				return fd_;
+			}
+
+		private:
+			int fd_ = -1;  ///< File descriptor
+			bool locked_ = false;  ///< Whether the lock is held
+	};
+
+
+	/// Increment the invocation counter of a device in the state directory.
+	/// \return the previous value, or nullopt on error.
+	std::optional<std::uint64_t> increment_invocation_counter(const hz::fs::path& state_dir, const std::string& device)
+	{
+		const FileLock lock(state_dir / (get_state_file_name(device) + ".count"));
+		if (!lock.get_locked()) {
+			return std::nullopt;
+		}
+		std::string contents(32, '\0');
+		const auto size = ::pread(lock.get_fd(), contents.data(), contents.size(), 0);
+		contents.resize(size > 0 ? static_cast<std::size_t>(size) : 0);
+		const std::uint64_t count = contents.empty() ? 0 : std::strtoull(contents.c_str(), nullptr, 10);
+
+		const std::string new_contents = std::to_string(count + 1);
+		if (::ftruncate(lock.get_fd(), 0) != 0
+				|| ::pwrite(lock.get_fd(), new_contents.data(), new_contents.size(), 0) != static_cast<ssize_t>(new_contents.size())) {
+			return std::nullopt;
+		}
+		return count;
+	}
+
+
+	/// Acquire one of \c max_concurrent slots of a controller, waiting until one is free
+	std::unique_ptr<FileLock> acquire_controller_slot(const hz::fs::path& state_dir, const std::string& controller, int max_concurrent)
+	{
+		const std::string base = get_state_file_name(controller);
+		while (true) {
+			for (int slot = 0; slot < max_concurrent; ++slot) {
+				auto lock = std::make_unique<FileLock>(state_dir / fmt::format("{}.slot{}", base, slot), true);
+				if (lock->get_locked()) {
+					return lock;
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	}
+
+#endif
+
+
+
+	/// Print the --scan / --scan-open output for the configured devices
+	void print_scan_output(const nlohmann::json& config, bool json)
+	{
+		const nlohmann::json& devices = config.value("devices", nlohmann::json::object());
+		if (json) {
+			nlohmann::json root;
+			root["json_format_version"] = {1, 0};
+			root["smartctl"] = {{"version", {7, 4}}, {"exit_status", 0}};
+			root["devices"] = nlohmann::json::array();
+			for (const auto& [name, device] : devices.items()) {
+				const auto type = device.value("type", std::string("sat"));
+				root["devices"].push_back({{"name", name}, {"info_name", name}, {"type", type},
+						{"protocol", type == "nvme" ? "NVMe" : "ATA"}});
+			}
+			std::cout << root.dump(2) << "\n";
+			return;
+		}
+		for (const auto& [name, device] : devices.items()) {
+			std::cout << fmt::format("{} -d {} # {}, {} device\n", name, device.value("type", std::string("sat")),
+					name, device.value("type", std::string("sat")) == "nvme" ? "NVMe" : "ATA");
+		}
+	}
+
+
+
+	/// Run the simulator with smartctl arguments
+	int run_simulator(const std::vector<std::string>& args)
+	{
+		const char* config_env = std::getenv("GSC_SMARTCTL_SIMULATOR_CONFIG");
+		if (!config_env || std::string(config_env).empty()) {
+			return simulator_error("GSC_SMARTCTL_SIMULATOR_CONFIG is not set.");
+		}
+		const hz::fs::path config_file = hz::fs_path_from_string(config_env);
+		const hz::fs::path config_dir = config_file.parent_path();
+
+		std::string config_str;
+		if (auto ec = hz::fs_file_get_contents(config_file, config_str, 10*1024*1024)) {
+			return simulator_error(fmt::format("Cannot read \"{}\": {}", config_env, ec.message()));
+		}
+		const nlohmann::json config = nlohmann::json::parse(config_str, nullptr, false, true);
+		if (config.is_discarded() || !config.is_object()) {
+			return simulator_error(fmt::format("Cannot parse \"{}\".", config_env));
+		}
+
+		auto has_arg = [&args](const std::string& arg) {
+			return std::find(args.begin(), args.end(), arg) != args.end();
+		};
+		const bool json = std::any_of(args.begin(), args.end(), [](const std::string& arg) { return arg.starts_with("--json") || arg == "-j"; });
+
+		if (has_arg("-V") || has_arg("--version")) {
+			std::string version = "smartctl 7.4 2023-08-01 r5530 [x86_64-linux] (smartctl simulator)\n";
+			if (config.contains("version_file")) {
+				if (auto ec = hz::fs_file_get_contents(config_dir / hz::fs_path_from_string(config.at("version_file").get<std::string>()), version, 1024*1024)) {
+					return simulator_error(fmt::format("Cannot read the version file: {}", ec.message()));
+				}
+			}
+			std::cout << version;
+			return 0;
+		}
+		if (has_arg("--scan") || has_arg("--scan-open")) {
+			print_scan_output(config, json);
+			return 0;
+		}
+
+		if (args.empty() || args.back().starts_with("-")) {
+			return simulator_error("No device specified.");
+		}
+		const std::string& device_name = args.back();
+		const nlohmann::json defaults = config.value("defaults", nlohmann::json::object());
+		const nlohmann::json devices = config.value("devices", nlohmann::json::object());
+		if (!devices.contains(device_name)) {
+			std::cout << fmt::format("Smartctl open device: {} failed: No such device\n", device_name);
+			return simulator_error_exit_status;
+		}
+		const nlohmann::json& device = devices.at(device_name);
+
+		// The random decisions depend on the seed, the command and the invocation number,
+		// so that the same sequence of commands gets the same latencies and failures.
+		const hz::fs::path state_dir = config.contains("state_dir")
+				? hz::fs_path_from_string(config.at("state_dir").get<std::string>()) : hz::fs::path();
+		std::error_code ec;
+		if (!state_dir.empty()) {
+			hz::fs::create_directories(state_dir, ec);
+		}
+		std::uint64_t invocation = std::random_device()();
+#ifndef _WIN32
+		if (!state_dir.empty()) {
+			if (auto count = increment_invocation_counter(state_dir, device_name)) {
+				invocation = count.value();
+			}
+		}
+#endif
+		std::string joined_args;
+		for (const auto& arg : args) {
+			joined_args += arg + " ";
+		}
+		std::seed_seq seed{config.value("seed", std::uint64_t(0)), std::hash<std::string>()(joined_args), invocation};
+		std::mt19937_64 rng(seed);
+		std::uniform_real_distribution<double> probability(0., 1.);
+
+		// Select the output
+		std::optional<nlohmann::json> output;
+		for (const auto& entry : device.value("outputs", nlohmann::json::array())) {
+			const auto options = entry.value("options", std::vector<std::string>());
+			if (std::all_of(options.begin(), options.end(), has_arg)) {
+				output = entry;
+				break;
+			}
+		}
+		if (!output.has_value()) {
+			return simulator_error(fmt::format("No output configured for \"{}\" with these options.", device_name));
+		}
+
+		// Occupy the controller for the duration of the command
+#ifndef _WIN32
+		std::unique_ptr<FileLock> controller_slot;
+		if (const auto controller = get_setting<std::string>(device, defaults, "controller", {}); !controller.empty()) {
+			const int max_concurrent = config.value("controllers", nlohmann::json::object())
+					.value(controller, nlohmann::json::object()).value("max_concurrent", 0);
+			if (max_concurrent > 0) {
+				if (state_dir.empty()) {
+					return simulator_error("Controller limits require \"state_dir\".");
+				}
+				controller_slot = acquire_controller_slot(state_dir, controller, max_concurrent);
+			}
+		}
+#endif
+
+		const bool hang = probability(rng) < get_setting<double>(device, defaults, "timeout_rate", 0.);
+		const bool fail = probability(rng) < get_setting<double>(device, defaults, "failure_rate", 0.);
+		std::this_thread::sleep_for(get_latency(get_setting<nlohmann::json>(device, defaults, "latency_ms", {}), rng));
+		if (hang) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(get_setting<std::int64_t>(device, defaults, "hang_ms", 3600 * 1000)));
+		}
+
+		if (fail) {
+			std::cout << "smartctl 7.4 2023-08-01 r5530 [x86_64-linux] (smartctl simulator)\n\n"
+					<< fmt::format("Smartctl open device: {} failed: Input/output error (injected failure)\n", device_name);
+			return get_setting<int>(device, defaults, "failure_exit_status", simulator_error_exit_status);
+		}
+
+		std::string contents;
+		const hz::fs::path file = config_dir / hz::fs_path_from_string(output->value("file", std::string()));
+		if (auto file_ec = hz::fs_file_get_contents(file, contents, 100*1024*1024)) {
+			return simulator_error(fmt::format("Cannot read \"{}\": {}", hz::fs_path_to_string(file), file_ec.message()));
+		}
+		std::cout << contents;
+		std::cout.flush();
+		return output->value("exit_status", get_setting<int>(device, defaults, "exit_status", 0));
+	}
+
+}
+
+
+
+/// Main function of the simulator
+int main(int argc, char** argv)
+{
+	std::vector<std::string> args(argv + (argc > 0 ? 1 : 0), argv + argc);
+	try {
+		return run_simulator(args);
+	}
+	catch (const std::exception& e) {
+		return simulator_error(fmt::format("Invalid configuration: {}", e.what()));
+	}
+}
+
+
+
+
+/// @}
@@ -11,11 +11,24 @@ Copyright:
 
 #include <glibmm.h>
 #include <glibmm/i18n.h>
-#include <glib.h>  // g_usleep()
+#include <glib.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>  // std::ceil
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "command_executor.h"
+#include "command_executor_stats.h"
 #include "build_config.h"
+#include "hz/fs.h"
 #include "hz/string_algo.h"
+#include "rconfig/rconfig.h"
 
 
 
@@ -28,6 +41,562 @@ cmdex_signal_execute_finish_t& cmdex_sync_signal_execute_finish()
 
 
 
+extern "C" {
+
+	/// Tick timeout callback of CommandExecutor::execute(). It only needs to wake up the loop.
+	inline gboolean cmdex_on_tick_timeout([[maybe_unused]] gpointer data)
+	{
+		return TRUE;  // continue
+	}
+
+
+	/// Idle callback emitting cmdex_sync_signal_execute_finish() in the default main context
+	inline gboolean cmdex_on_execute_finish_idle(gpointer data)
+	{
+		cmdex_sync_signal_execute_finish().emit(*static_cast<const CommandExecutorResult*>(data));
+		return FALSE;  // remove the source
+	}
+
+
+	/// Destroy-notify for cmdex_on_execute_finish_idle() data
+	inline void cmdex_on_execute_finish_idle_destroy(gpointer data)
+	{
+		delete static_cast<CommandExecutorResult*>(data);
+	}
+
+
+	/// Idle / timeout callback of cmdex_invoke_later() and cmdex_invoke_after()
+	inline gboolean cmdex_on_invoke_later_idle(gpointer data)
+	{
+		(*static_cast<std::function<void()>*>(data))();
+		return FALSE;  // remove the source
+	}
+
+
+	/// Destroy-notify for cmdex_on_invoke_later_idle() data
+	inline void cmdex_on_invoke_later_idle_destroy(gpointer data)
+	{
+		delete static_cast<std::function<void()>*>(data);
+	}
+
+}
+
+
+
+/// Result of an execution shared with the identical executions collapsed into it.
+/// All the members are protected by the running command limit mutex.
+struct CommandExecutorSharedResult {
+	bool finished = false;  ///< Set when the execution finished and the members below are valid
+	bool executed = false;  ///< Whether the command was spawned
+	CommandOutputPtr std_output;  ///< Stdout data
+	std::string std_error;  ///< Stderr data
+	std::string error_msg;  ///< Error message, if any
+	std::vector<GMainContext*> waiting_contexts;  ///< Contexts of the blocking executions waiting for the result
+	std::vector<std::pair<GMainContext*, std::function<void(const CommandExecutorSharedResult&)>>> async_followers;  ///< Asynchronous executions waiting for the result
+};
+
+
+
+namespace {
+
+	/// Maximum rate of TickStatus::Running / TickStatus::Stopping ticks in CommandExecutor::execute()
+	constexpr std::chrono::milliseconds cmdex_tick_interval(50);
+
+	/// The polling interval the waiting loop in CommandExecutor::execute() used to sleep for
+	constexpr double cmdex_legacy_poll_interval_sec = 0.05;
+
+	std::atomic<std::uint64_t> s_cmdex_wait_executions{0};  ///< See CommandExecutorWaitStats
+	std::atomic<std::int64_t> s_cmdex_wait_saved_usec{0};  ///< See CommandExecutorWaitStats
+
+
+	/// Interval of the backstop wakeups of the executions waiting for a free slot
+	constexpr std::chrono::milliseconds cmdex_slot_wait_interval(100);
+
+
+	/// Call \c func from \c context (nullptr means the default one) when it's idle.
+	/// Unlike g_main_context_invoke(), this never calls it right away.
+	void cmdex_invoke_later(GMainContext* context, std::function<void()> func)
+	{
+		GSource* source = g_idle_source_new();
+		g_source_set_priority(source, G_PRIORITY_DEFAULT);
+		g_source_set_callback(source, &cmdex_on_invoke_later_idle,
+				new std::function<void()>(std::move(func)), &cmdex_on_invoke_later_idle_destroy);
+		g_source_attach(source, context);
+		g_source_unref(source);
+	}
+
+
+	/// Call \c func from \c context (nullptr means the default one) after \c delay
+	void cmdex_invoke_after(GMainContext* context, std::chrono::steady_clock::duration delay, std::function<void()> func)
+	{
+		const auto delay_msec = std::chrono::ceil<std::chrono::milliseconds>(delay);
+		GSource* source = g_timeout_source_new(static_cast<guint>(std::max<std::int64_t>(delay_msec.count(), 0)));
+		g_source_set_callback(source, &cmdex_on_invoke_later_idle,
+				new std::function<void()>(std::move(func)), &cmdex_on_invoke_later_idle_destroy);
+		g_source_attach(source, context);
+		g_source_unref(source);
+	}
+
+
+	/// An execution waiting for a free slot
+	struct CmdexSlotWaiter {
+		CommandPriority priority = CommandPriority::Interactive;  ///< Priority class, raised by the more important collapsed executions
+		std::chrono::steady_clock::time_point wait_start;  ///< Time the waiting started
+		std::string collapse_key;  ///< See CommandExecutor::get_collapse_key(). Empty if the result is not shared.
+		std::string domain;  ///< Serialization domain, see CommandExecutor::set_serialization_domain(). May be empty.
+		std::shared_ptr<CommandExecutorSharedResult> result;  ///< Result shared with the collapsed executions, nullptr if not shared
+		GMainContext* context = nullptr;  ///< Main context of the execution
+		std::function<void()> start_func;  ///< Starts an asynchronous execution. Empty for the blocking ones.
+		bool granted = false;  ///< Set when a blocking execution got the slot
+	};
+
+
+	/// State of the process-wide running command limit
+	struct CmdexSlots {
+		std::mutex mutex;  ///< Protects all the members
+		std::vector<std::shared_ptr<CmdexSlotWaiter>> waiters;  ///< Waiting executions, in order of arrival
+		std::chrono::steady_clock::duration priority_aging = std::chrono::seconds(10);  ///< See cmdex_set_priority_aging()
+		CommandDomainLimits domain_limits;  ///< See cmdex_set_domain_limits()
+		std::map<std::string, std::size_t, std::less<>> domain_running;  ///< Serialization domain -> number of its running commands
+		CommandExecutorQueueStats stats;  ///< Current state and statistics
+	};
+
+
+	/// Get the process-wide running command limit state
+	CmdexSlots& cmdex_get_slots()
+	{
+		static CmdexSlots slots;
+		return slots;
+	}
+
+
+	/// Number of slots held by the current thread. The commands executed from
+	/// a nested main loop iteration (e.g. a GUI callback while another command runs)
+	/// cannot wait for the outer execution to finish, so they don't wait at all.
+	thread_local std::size_t t_cmdex_held_slots = 0;
+
+
+	/// Check whether a new command may be run. The mutex must be locked.
+	bool cmdex_slot_available(const CmdexSlots& slots)
+	{
+		return slots.stats.max_running == 0 || slots.stats.running < slots.stats.max_running;
+	}
+
+
+	/// Check whether the limit of a serialization domain allows a new command. The mutex must be locked.
+	bool cmdex_domain_slot_available(const CmdexSlots& slots, const std::string& domain)
+	{
+		if (domain.empty()) {
+			return true;
+		}
+		auto limit_iter = slots.domain_limits.find(cmdex_get_domain_family(domain));
+		if (limit_iter == slots.domain_limits.end() || limit_iter->second == 0) {
+			return true;
+		}
+		auto running_iter = slots.domain_running.find(domain);
+		return running_iter == slots.domain_running.end() || running_iter->second < limit_iter->second;
+	}
+
+
+	/// Account for a command taking a slot. The mutex must be locked.
+	void cmdex_add_running(CmdexSlots& slots, const std::string& domain)
+	{
+		++slots.stats.running;
+		if (!domain.empty()) {
+			++slots.domain_running[domain];
+		}
+	}
+
+
+	/// Account for a command giving up its slot. The mutex must be locked.
+	void cmdex_remove_running(CmdexSlots& slots, const std::string& domain)
+	{
+		DBG_ASSERT(slots.stats.running > 0);
+		--slots.stats.running;
+		if (auto iter = slots.domain_running.find(domain); iter != slots.domain_running.end() && --iter->second == 0) {
+			slots.domain_running.erase(iter);
+		}
+	}
+
+
+	/// Account for a finished wait for a slot. The mutex must be locked.
+	void cmdex_add_slot_wait(CmdexSlots& slots, std::chrono::steady_clock::time_point wait_start)
+	{
+		const auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wait_start);
+		++slots.stats.waits;
+		slots.stats.total_wait_time += waited;
+		slots.stats.max_wait_time = std::max(slots.stats.max_wait_time, waited);
+	}
+
+
+	/// Find a waiting execution with the same collapse key to share the result of, raising its
+	/// priority to \c priority if needed. For a \c blocking execution, the blocking executions waiting
+	/// in its \c context are skipped (a nested execution cannot wait for the outer one). The mutex must be locked.
+	/// \return nullptr if there is none.
+	std::shared_ptr<CmdexSlotWaiter> cmdex_find_collapse_target(CmdexSlots& slots, const std::string& collapse_key,
+			CommandPriority priority, bool blocking, GMainContext* context)
+	{
+		if (collapse_key.empty()) {
+			return nullptr;
+		}
+		for (const auto& waiter : slots.waiters) {
+			if (waiter->collapse_key == collapse_key
+					&& !(blocking && !waiter->start_func && waiter->context == context)) {
+				waiter->priority = std::min(waiter->priority, priority);
+				++slots.stats.collapsed;
+				debug_out_dump("app", DBG_FUNC_MSG << "Sharing the result of an identical waiting command (priority "
+						<< cmdex_get_priority_name(waiter->priority) << ").\n");
+				return waiter;
+			}
+		}
+		return nullptr;
+	}
+
+
+	/// Add a waiting execution to the queue. The mutex must be locked.
+	std::shared_ptr<CmdexSlotWaiter> cmdex_add_waiter(CmdexSlots& slots, GMainContext* context, CommandPriority priority,
+			const std::string& collapse_key, const std::string& domain, std::function<void()> start_func)
+	{
+		if (cmdex_slot_available(slots)) {
+			++slots.stats.domain_waits;  // waiting for the domain only
+		}
+		auto waiter = std::make_shared<CmdexSlotWaiter>();
+		waiter->priority = priority;
+		waiter->wait_start = std::chrono::steady_clock::now();
+		waiter->collapse_key = collapse_key;
+		waiter->domain = domain;
+		if (!collapse_key.empty()) {
+			waiter->result = std::make_shared<CommandExecutorSharedResult>();
+		}
+		waiter->context = context;
+		waiter->start_func = std::move(start_func);
+		slots.waiters.push_back(waiter);
+		++slots.stats.queued;
+		slots.stats.max_queued = std::max(slots.stats.max_queued, slots.stats.queued);
+		return waiter;
+	}
+
+
+	/// Iterate \c context until \c done returns true. The mutex must be locked by \c lock.
+	/// The one handing over the slot (or the result) wakes up our context; the timeout is just a backstop.
+	void cmdex_wait_in_context(GMainContext* context, std::unique_lock<std::mutex>& lock, const std::function<bool()>& done)
+	{
+		GSource* wait_source = g_timeout_source_new(guint(cmdex_slot_wait_interval.count()));
+		g_source_set_callback(wait_source, &cmdex_on_tick_timeout, nullptr, nullptr);
+		g_source_attach(wait_source, context);
+
+		while (!done()) {
+			lock.unlock();
+			g_main_context_iteration(context, TRUE);
+			lock.lock();
+		}
+
+		g_source_destroy(wait_source);
+		g_source_unref(wait_source);
+	}
+
+
+	/// Give the free slots to the waiting executions, most important (see cmdex_get_priority_rank()) first.
+	/// The executions of the full serialization domains keep waiting without holding up the others.
+	/// The asynchronous ones are started in their main contexts, the blocking ones are woken up. The mutex must be locked.
+	void cmdex_hand_over_slots(CmdexSlots& slots)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		// The ties go to the one waiting the longest
+		auto get_order = [&](const std::shared_ptr<CmdexSlotWaiter>& waiter) {
+			return std::pair(cmdex_get_priority_rank(waiter->priority, now - waiter->wait_start, slots.priority_aging), waiter->wait_start);
+		};
+		while (!slots.waiters.empty() && cmdex_slot_available(slots)) {
+			auto best = slots.waiters.end();
+			for (auto iter = slots.waiters.begin(); iter != slots.waiters.end(); ++iter) {
+				if (cmdex_domain_slot_available(slots, (*iter)->domain)
+						&& (best == slots.waiters.end() || get_order(*iter) < get_order(*best))) {
+					best = iter;
+				}
+			}
+			if (best == slots.waiters.end()) {
+				break;  // all of them wait for their domains
+			}
+			const std::shared_ptr<CmdexSlotWaiter> waiter = *best;
+			slots.waiters.erase(best);
+			--slots.stats.queued;
+			cmdex_add_running(slots, waiter->domain);
+			cmdex_add_slot_wait(slots, waiter->wait_start);
+			if (waiter->start_func) {
+				cmdex_invoke_later(waiter->context, std::move(waiter->start_func));
+			} else {
+				waiter->granted = true;
+				g_main_context_wakeup(waiter->context);
+			}
+		}
+	}
+
+
+	/// Set the result of an execution and pass it to the executions which were collapsed into it
+	void cmdex_share_result(const std::shared_ptr<CommandExecutorSharedResult>& result, bool executed,
+			CommandOutputPtr std_output, std::string std_error, std::string error_msg)
+	{
+		auto& slots = cmdex_get_slots();
+		const std::lock_guard lock(slots.mutex);
+		result->executed = executed;
+		result->std_output = std::move(std_output);
+		result->std_error = std::move(std_error);
+		result->error_msg = std::move(error_msg);
+		result->finished = true;
+		for (GMainContext* context : result->waiting_contexts) {
+			g_main_context_wakeup(context);
+		}
+		for (auto& [context, func] : result->async_followers) {
+			cmdex_invoke_later(context, [func = std::move(func), result]() {
+				func(*result);
+			});
+		}
+		result->async_followers.clear();
+	}
+
+
+	/// Slot of a blocking execution, see cmdex_acquire_slot()
+	struct CmdexSlotTicket {
+		bool collapsed = false;  ///< If true, no slot is held, and \c result is the (finished) result of an identical execution
+		std::shared_ptr<CommandExecutorSharedResult> result;  ///< Result to share with the collapsed executions, may be nullptr
+	};
+
+
+	/// Acquire a running command slot in serialization domain \c domain, waiting (and iterating \c context)
+	/// until one is free. If an identical execution is waiting already, wait for its result instead.
+	CmdexSlotTicket cmdex_acquire_slot(GMainContext* context, CommandPriority priority, const std::string& collapse_key,
+			const std::string& domain)
+	{
+		auto& slots = cmdex_get_slots();
+		std::unique_lock lock(slots.mutex);
+
+		if (t_cmdex_held_slots > 0 || (cmdex_slot_available(slots) && cmdex_domain_slot_available(slots, domain))) {
+			cmdex_add_running(slots, domain);
+			++t_cmdex_held_slots;
+			return {};
+		}
+
+		if (auto target = cmdex_find_collapse_target(slots, collapse_key, priority, true, context)) {
+			std::shared_ptr<CommandExecutorSharedResult> result = target->result;
+			result->waiting_contexts.push_back(context);
+			cmdex_wait_in_context(context, lock, [&result]() { return result->finished; });
+			result->waiting_contexts.erase(std::find(result->waiting_contexts.begin(), result->waiting_contexts.end(), context));
+			return {true, result};
+		}
+
+		const auto waiter = cmdex_add_waiter(slots, context, priority, collapse_key, domain, nullptr);
+		cmdex_wait_in_context(context, lock, [&waiter]() { return waiter->granted; });
+		++t_cmdex_held_slots;  // the running count is increased by the one handing it over
+		return {false, waiter->result};
+	}
+
+
+	/// Release a slot acquired with cmdex_acquire_slot()
+	void cmdex_release_slot(const std::string& domain)
+	{
+		auto& slots = cmdex_get_slots();
+		const std::lock_guard lock(slots.mutex);
+		DBG_ASSERT(t_cmdex_held_slots > 0);
+		cmdex_remove_running(slots, domain);
+		--t_cmdex_held_slots;
+		cmdex_hand_over_slots(slots);
+	}
+
+
+	/// Acquire a running command slot in serialization domain \c domain without blocking. \c start_func
+	/// is called right away if a slot is free, or from \c context when one becomes free. If an identical
+	/// execution is waiting already, \c collapsed_func is called from \c context with its result instead.
+	/// \return The result to share with the executions collapsed into this one, may be nullptr.
+	std::shared_ptr<CommandExecutorSharedResult> cmdex_acquire_slot_async(GMainContext* context, CommandPriority priority,
+			const std::string& collapse_key, const std::string& domain, std::function<void()> start_func,
+			std::function<void(const CommandExecutorSharedResult& result)> collapsed_func)
+	{
+		auto& slots = cmdex_get_slots();
+		{
+			const std::lock_guard lock(slots.mutex);
+			if (!cmdex_slot_available(slots) || !cmdex_domain_slot_available(slots, domain)) {
+				if (auto target = cmdex_find_collapse_target(slots, collapse_key, priority, false, context)) {
+					target->result->async_followers.emplace_back(context, std::move(collapsed_func));
+					return nullptr;
+				}
+				return cmdex_add_waiter(slots, context, priority, collapse_key, domain, std::move(start_func))->result;
+			}
+			cmdex_add_running(slots, domain);
+		}
+		start_func();
+		return nullptr;
+	}
+
+
+	/// Release a slot acquired with cmdex_acquire_slot_async()
+	void cmdex_release_async_slot(const std::string& domain)
+	{
+		auto& slots = cmdex_get_slots();
+		const std::lock_guard lock(slots.mutex);
+		cmdex_remove_running(slots, domain);
+		cmdex_hand_over_slots(slots);
+	}
+
+
+	/// Holds a running command slot of a blocking execution for its lifetime
+	class CmdexSlotGuard {
+		public:
+
+			/// Constructor, acquires the slot (or waits for the result of an identical execution, see get_collapsed())
+			CmdexSlotGuard(GMainContext* context, CommandPriority priority, const std::string& collapse_key, std::string domain)
+					: ticket_(cmdex_acquire_slot(context, priority, collapse_key, domain)), domain_(std::move(domain))
+			{ }
+
+			/// Deleted
+			CmdexSlotGuard(const CmdexSlotGuard& other) = delete;
+
+			/// Deleted
+			CmdexSlotGuard(CmdexSlotGuard&& other) = delete;
+
+			/// Deleted
+			CmdexSlotGuard& operator=(const CmdexSlotGuard& other) = delete;
+
+			/// Deleted
+			CmdexSlotGuard& operator=(CmdexSlotGuard&& other) = delete;
+
+			/// Destructor, releases the slot
+			~CmdexSlotGuard()
+			{
+				if (!ticket_.collapsed) {
+					cmdex_release_slot(domain_);
+				}
+			}
+
+			/// If true, the execution was collapsed into an identical one, and holds no slot.
+			/// get_collapsed_result() is its result.
+			[[nodiscard]] bool get_collapsed() const
+			{
+				return ticket_.collapsed;
+			}
+
+			/// Get the result of the execution this one was collapsed into
+			[[nodiscard]] const CommandExecutorSharedResult& get_collapsed_result() const
+			{
+				return *ticket_.result;
+			}
+
+			/// Pass the result of the execution to the executions collapsed into it, if any
+			void share_result(bool executed, CommandExecutor& executor) const
+			{
+				if (!ticket_.collapsed && ticket_.result) {
+					cmdex_share_result(ticket_.result, executed, executor.get_stdout_buffer(),
+							executor.get_stderr_str(), executor.get_error_msg());
+				}
+			}
+
+		private:
+
+			CmdexSlotTicket ticket_;  ///< Acquired slot
+			std::string domain_;  ///< Serialization domain of the slot
+
+	};
+
+
+	/// Emit cmdex_sync_signal_execute_finish(). The execution loggers are GUI objects,
+	/// so if we're running inside a worker thread's main context, the emission is
+	/// deferred to the default main context.
+	void cmdex_emit_execute_finish(const CommandExecutorResult& result)
+	{
+		GMainContext* context = g_main_context_get_thread_default();
+		if (context == nullptr || context == g_main_context_default()) {
+			cmdex_sync_signal_execute_finish().emit(result);
+			return;
+		}
+		g_main_context_invoke_full(nullptr, G_PRIORITY_DEFAULT, &cmdex_on_execute_finish_idle,
+				new CommandExecutorResult(result), &cmdex_on_execute_finish_idle_destroy);
+	}
+
+
+	/// Get the adaptive stop timeout settings ("system/adaptive_timeout_*").
+	/// \return std::nullopt if the adaptive timeouts are disabled.
+	std::optional<CommandAdaptiveTimeoutSettings> cmdex_get_adaptive_timeout_settings()
+	{
+		if (!rconfig::get_data<bool>("system/adaptive_timeouts_enabled")) {
+			return std::nullopt;
+		}
+		CommandAdaptiveTimeoutSettings settings;
+		settings.min_timeout = std::chrono::milliseconds(std::max(1, rconfig::get_data<int>("system/adaptive_timeout_min_msec")));
+		settings.max_timeout = std::chrono::seconds(std::max(1, rconfig::get_data<int>("system/adaptive_timeout_max_sec")));
+		settings.multiplier = std::max(1., rconfig::get_data<double>("system/adaptive_timeout_multiplier"));
+		return settings;
+	}
+
+
+	/// Check whether smartctl \c args skip a drive in standby ("-n" / "--nocheck" other than "never"),
+	/// so that the command can't be held up by the drive spinning up.
+	bool cmdex_get_args_standby_aware(const std::vector<std::string>& args)
+	{
+		for (std::size_t i = 0; i < args.size(); ++i) {
+			std::string_view mode;
+			if (args[i].starts_with("--nocheck=")) {
+				mode = std::string_view(args[i]).substr(std::string_view("--nocheck=").size());
+			} else if ((args[i] == "-n" || args[i] == "--nocheck") && i + 1 < args.size()) {
+				mode = args[i + 1];
+			}
+			if (!mode.empty() && !mode.starts_with("never")) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+}
+
+
+
+CommandExecutorWaitStats cmdex_get_wait_stats()
+{
+	CommandExecutorWaitStats stats;
+	stats.executions = s_cmdex_wait_executions.load();
+	stats.saved_latency = std::chrono::microseconds(s_cmdex_wait_saved_usec.load());
+	return stats;
+}
+
+
+
+void cmdex_set_max_running_commands(std::size_t max_running)
+{
+	auto& slots = cmdex_get_slots();
+	const std::lock_guard lock(slots.mutex);
+	slots.stats.max_running = max_running;
+	cmdex_hand_over_slots(slots);
+}
+
+
+
+void cmdex_set_domain_limits(CommandDomainLimits limits)
+{
+	auto& slots = cmdex_get_slots();
+	const std::lock_guard lock(slots.mutex);
+	slots.domain_limits = std::move(limits);
+	cmdex_hand_over_slots(slots);
+}
+
+
+
+void cmdex_set_priority_aging(std::chrono::steady_clock::duration aging)
+{
+	auto& slots = cmdex_get_slots();
+	const std::lock_guard lock(slots.mutex);
+	slots.priority_aging = std::max(aging, std::chrono::steady_clock::duration::zero());
+}
+
+
+
+CommandExecutorQueueStats cmdex_get_queue_stats()
+{
+	auto& slots = cmdex_get_slots();
+	const std::lock_guard lock(slots.mutex);
+	return slots.stats;
+}
+
+
+
 CommandExecutor::CommandExecutor(std::string command_name, std::vector<std::string> command_args)
 		: CommandExecutor()
 {
@@ -47,10 +616,33 @@ CommandExecutor::CommandExecutor()
 
 void CommandExecutor::set_command(std::string command_name, std::vector<std::string> command_args)
 {
-	cmdex_.set_command(command_name, command_args);
 	// keep a copy locally to avoid locking on get() every time
 	command_name_ = std::move(command_name);
 	command_args_ = std::move(command_args);
+	statistics_keys_.reset();
+	serialization_domain_.clear();
+	apply_command();
+}
+
+
+
+void CommandExecutor::set_statistics_keys(std::string device, std::string options)
+{
+	statistics_keys_ = std::pair(std::move(device), std::move(options));
+}
+
+
+
+void CommandExecutor::set_serialization_domain(std::string domain)
+{
+	serialization_domain_ = std::move(domain);
+}
+
+
+
+const std::string& CommandExecutor::get_serialization_domain() const
+{
+	return serialization_domain_;
 }
 
 
@@ -69,40 +661,172 @@ std::vector<std::string> CommandExecutor::get_command_args() const
 
 
 
+void CommandExecutor::set_remote_host(RemoteHostPtr host)
+{
+	if (host != remote_host_) {
+		remote_host_ = std::move(host);
+		apply_command();
+	}
+}
+
+
+
+RemoteHostPtr CommandExecutor::get_remote_host() const
+{
+	return remote_host_;
+}
+
+
+
+void CommandExecutor::set_operation(CommandOperation operation)
+{
+	operation_ = operation;
+}
+
+
+
+CommandOperation CommandExecutor::get_operation() const
+{
+	return operation_;
+}
+
+
+
+void CommandExecutor::set_priority(CommandPriority priority)
+{
+	priority_ = priority;
+}
+
+
+
+CommandPriority CommandExecutor::get_priority() const
+{
+	return priority_;
+}
+
+
+
+void CommandExecutor::set_cancellation(AppCancellationPtr cancellation)
+{
+	cancellation_ = std::move(cancellation);
+}
+
+
+
+AppCancellationPtr CommandExecutor::get_cancellation() const
+{
+	return cancellation_;
+}
+
+
+
 bool CommandExecutor::execute()
 {
 	set_error_msg("");  // clear old error if present
+	stdout_.reset();
+	shared_stderr_.reset();
 
 	const bool slot_connected = !(signal_execute_tick().slots().begin() == signal_execute_tick().slots().end());
 
 	if (slot_connected && !signal_execute_tick().emit(TickStatus::Starting))
 		return false;
 
+	// Don't start anything for a cancelled operation (e.g. the rest of an abandoned scan)
+	auto check_cancelled = [this, slot_connected]() {
+		if (!app_is_cancelled(cancellation_)) {
+			return false;
+		}
+		debug_out_info("app", DBG_FUNC_MSG << "The operation was cancelled, not executing " << get_command_name() << ".\n");
+		set_error_msg(_("The operation was cancelled."));
+		if (slot_connected)
+			signal_execute_tick().emit(TickStatus::Failed);
+		return true;
+	};
+	if (check_cancelled()) {
+		return false;
+	}
+
+	GMainContext* context = g_main_context_get_thread_default();
+
+	// Wait until the rate limit of the controller allows another command, keeping the context running.
+	if (const auto rate_wait = prepare_execution_policy(); rate_wait > std::chrono::steady_clock::duration::zero()) {
+		const auto deadline = std::chrono::steady_clock::now() + rate_wait;
+		GSource* wait_source = g_timeout_source_new(guint(cmdex_tick_interval.count()));
+		g_source_set_callback(wait_source, &cmdex_on_tick_timeout, nullptr, nullptr);
+		g_source_attach(wait_source, context);
+		while (std::chrono::steady_clock::now() < deadline && !app_is_cancelled(cancellation_)) {
+			g_main_context_iteration(context, TRUE);
+		}
+		g_source_destroy(wait_source);
+		g_source_unref(wait_source);
+		if (check_cancelled()) {
+			return false;
+		}
+	}
+
+	// Wait for a free slot if too many commands are running already (in total or on the same controller).
+	const CmdexSlotGuard slot_guard(context, priority_, get_collapse_key(), serialization_domain_);
+
+	// An identical command was waiting already, and we got its result.
+	if (slot_guard.get_collapsed()) {
+		const CommandExecutorSharedResult& result = slot_guard.get_collapsed_result();
+		adopt_shared_result(result);
+		if (slot_connected)
+			signal_execute_tick().emit(result.executed ? TickStatus::Stopped : TickStatus::Failed);
+		return result.executed;
+	}
+
+	apply_expected_output_sizes();
 	if (!cmdex_.execute()) {  // try to execute
 		debug_out_error("app", DBG_FUNC_MSG << "cmdex_.execute() failed.\n");
 		import_error();  // get error from cmdex and display warnings if needed
+		add_statistics_sample(false);
 
 		// emit this for execution loggers
-		cmdex_sync_signal_execute_finish().emit(CommandExecutorResult(get_command_name(),
-				get_command_args(), get_stdout_str(), get_stderr_str(), get_error_msg()));
+		stdout_ = std::make_shared<const std::string>(cmdex_.take_stdout_str());
+		cmdex_emit_execute_finish(CommandExecutorResult(get_command_name(),
+				get_command_args(), stdout_, get_stderr_str(), get_error_msg()));
+		slot_guard.share_result(false, *this);
 
 		if (slot_connected)
 			signal_execute_tick().emit(TickStatus::Failed);
 		return false;
 	}
 
+	apply_adaptive_timeouts();
+
 	bool stop_requested = false;  // stop requested from tick function
 	bool signals_sent = false;  // stop signals sent
 
+	// The event sources of cmdex_ (child watch, I/O channels, stop timeouts) live in
+	// the thread-default main context, so we just block on it until something happens.
+	// The tick timeout source guarantees periodic wakeups for the tick function, which
+	// is called at most once per cmdex_tick_interval.
+	GSource* tick_source = g_timeout_source_new(guint(cmdex_tick_interval.count()));
+	g_source_set_callback(tick_source, &cmdex_on_tick_timeout, nullptr, nullptr);
+	g_source_attach(tick_source, context);
+
+	auto last_tick_time = std::chrono::steady_clock::now() - cmdex_tick_interval;
+
 	while(!cmdex_.stopped_cleanup_needed()) {
 
-		if (!stop_requested) {  // running and no stop requested yet
+		const auto now = std::chrono::steady_clock::now();
+		const bool tick_due = (now - last_tick_time >= cmdex_tick_interval);
+		if (tick_due) {
+			last_tick_time = now;
+		}
+
+		if (!stop_requested && tick_due) {  // running and no stop requested yet
 			// call the tick function with "running" periodically.
 			// if it returns false, try to stop.
 			if (slot_connected && !signal_execute_tick().emit(TickStatus::Running)) {
 				debug_out_info("app", DBG_FUNC_MSG << "execute_tick slot returned false, trying to stop the program.\n");
 				stop_requested = true;
 			}
+			if (!stop_requested && app_is_cancelled(cancellation_)) {
+				debug_out_info("app", DBG_FUNC_MSG << "The operation was cancelled, trying to stop the program.\n");
+				stop_requested = true;
+			}
 		}
 
 
@@ -121,30 +845,35 @@ bool CommandExecutor::execute()
 
 
 		// alert the tick function
-		if (stop_requested && slot_connected) {
+		if (stop_requested && slot_connected && tick_due) {
 			signal_execute_tick().emit(TickStatus::Stopping);  // ignore returned value here
 		}
 
-
 		// Without this, no event sources will be processed and the program will
 		// hang waiting for the child to exit (the watch handler won't be called).
-		// Note: If you have an idle callback, g_main_context_pending() will
-		// always return true (until the idle callback returns false and unregisters itself).
-		while(g_main_context_pending(nullptr) != FALSE) {
-			g_main_context_iteration(nullptr, FALSE);
-		}
-
-		const gulong sleep_us = 50UL * 1000UL;  // 50 msec. avoids 100% CPU usage.
-		g_usleep(sleep_us);
+		// This blocks until at least one source (possibly the tick timeout) is dispatched.
+		g_main_context_iteration(context, TRUE);
 	}
 
+	g_source_destroy(tick_source);
+	g_source_unref(tick_source);
+
+	// Account for the time the fixed-interval polling would have slept after the child exited.
+	const double exec_sec = cmdex_.get_execution_time_sec();
+	const double poll_sec = std::ceil(exec_sec / cmdex_legacy_poll_interval_sec) * cmdex_legacy_poll_interval_sec;
+	++s_cmdex_wait_executions;
+	s_cmdex_wait_saved_usec += static_cast<std::int64_t>((poll_sec - exec_sec) * 1'000'000.);
+
 	// command exited, do a cleanup.
 	cmdex_.stopped_cleanup();
 	import_error();  // get error from cmdex and display warnings if needed
 
 	// emit this for execution loggers
-	cmdex_sync_signal_execute_finish().emit(CommandExecutorResult(get_command_name(),
-			get_command_args(), get_stdout_str(), get_stderr_str(), get_error_msg()));
+	stdout_ = std::make_shared<const std::string>(cmdex_.take_stdout_str());  // no copy
+	add_statistics_sample(true);
+	cmdex_emit_execute_finish(CommandExecutorResult(get_command_name(),
+			get_command_args(), stdout_, get_stderr_str(), get_error_msg()));
+	slot_guard.share_result(true, *this);
 
 	if (slot_connected)
 		signal_execute_tick().emit(TickStatus::Stopped);  // last call
@@ -154,6 +883,112 @@ bool CommandExecutor::execute()
 
 
 
+void CommandExecutor::execute_async(execute_finished_func_t finished_func)
+{
+	set_error_msg("");  // clear old error if present
+	stdout_.reset();
+	shared_stderr_.reset();
+	async_shared_result_.reset();
+
+	async_finished_func_ = std::move(finished_func);
+	async_context_ = g_main_context_get_thread_default();
+	if (!async_context_) {
+		async_context_ = g_main_context_default();
+	}
+
+	// If no slot is free, this is called from async_context_ later.
+	auto acquire_slot = [this]() {
+		async_domain_ = serialization_domain_;
+		async_shared_result_ = cmdex_acquire_slot_async(async_context_, priority_, get_collapse_key(), async_domain_, [this]() {
+			start_async_execution();
+		}, [this](const CommandExecutorSharedResult& result) {
+			// An identical command was waiting already, and we got its result.
+			adopt_shared_result(result);
+			const execute_finished_func_t func = std::move(async_finished_func_);
+			async_finished_func_ = nullptr;
+			if (func) {
+				func(result.executed);
+			}
+		});
+	};
+
+	// Wait until the rate limit of the controller allows another command
+	if (const auto rate_wait = prepare_execution_policy(); rate_wait > std::chrono::steady_clock::duration::zero()) {
+		cmdex_invoke_after(async_context_, rate_wait, std::move(acquire_slot));
+	} else {
+		acquire_slot();
+	}
+}
+
+
+
+void CommandExecutor::start_async_execution()
+{
+	apply_expected_output_sizes();
+	if (!cmdex_.execute()) {  // try to execute
+		debug_out_error("app", DBG_FUNC_MSG << "cmdex_.execute() failed.\n");
+		import_error();  // get error from cmdex and display warnings if needed
+		add_statistics_sample(false);
+
+		// emit this for execution loggers
+		stdout_ = std::make_shared<const std::string>(cmdex_.take_stdout_str());
+		cmdex_emit_execute_finish(CommandExecutorResult(get_command_name(),
+				get_command_args(), stdout_, get_stderr_str(), get_error_msg()));
+		if (async_shared_result_) {
+			cmdex_share_result(std::exchange(async_shared_result_, nullptr), false, stdout_, get_stderr_str(), get_error_msg());
+		}
+		cmdex_release_async_slot(async_domain_);
+
+		// This may be called from execute_async(), so report it later.
+		cmdex_invoke_later(async_context_, [func = std::move(async_finished_func_)]() {
+			if (func) {
+				func(false);
+			}
+		});
+		async_finished_func_ = nullptr;
+		return;
+	}
+
+	apply_adaptive_timeouts();
+
+	// This is called from the child watch handler, which may not clean up after itself.
+	cmdex_.set_exited_callback([this]() {
+		cmdex_invoke_later(async_context_, [this]() {
+			finish_async_execution();
+		});
+	});
+}
+
+
+
+void CommandExecutor::finish_async_execution()
+{
+	cmdex_.set_exited_callback(nullptr);
+
+	// command exited, do a cleanup.
+	cmdex_.stopped_cleanup();
+	import_error();  // get error from cmdex and display warnings if needed
+
+	// emit this for execution loggers
+	stdout_ = std::make_shared<const std::string>(cmdex_.take_stdout_str());  // no copy
+	add_statistics_sample(true);
+	cmdex_emit_execute_finish(CommandExecutorResult(get_command_name(),
+			get_command_args(), stdout_, get_stderr_str(), get_error_msg()));
+	if (async_shared_result_) {
+		cmdex_share_result(std::exchange(async_shared_result_, nullptr), true, stdout_, get_stderr_str(), get_error_msg());
+	}
+	cmdex_release_async_slot(async_domain_);
+
+	// The callback may start another execution
+	const execute_finished_func_t func = std::move(async_finished_func_);
+	async_finished_func_ = nullptr;
+	if (func) {
+		func(true);
+	}
+}
+
+
+
 void CommandExecutor::set_forced_kill_timeout(std::chrono::milliseconds timeout_msec)
 {
 	forced_kill_timeout_msec_ = timeout_msec;
@@ -203,15 +1038,52 @@ void CommandExecutor::set_buffer_sizes(gsize stdout_buffer_size, gsize stderr_bu
 
 
 
+void CommandExecutor::set_streaming(bool enabled)
+{
+	cmdex_.set_streaming(enabled);
+}
+
+
+
+void CommandExecutor::set_output_chunk_callback(AsyncCommandExecutor::output_chunk_func_t func)
+{
+	output_chunk_callback_set_ = static_cast<bool>(func);
+	cmdex_.set_output_chunk_callback(std::move(func));
+}
+
+
+
 std::string CommandExecutor::get_stdout_str(bool clear_existing)
 {
-	return cmdex_.get_stdout_str(clear_existing);
+	if (!stdout_) {  // not finished yet
+		return cmdex_.get_stdout_str(clear_existing);
+	}
+	std::string ret = *stdout_;
+	if (clear_existing) {
+		stdout_.reset();
+	}
+	return ret;
+}
+
+
+
+CommandOutputPtr CommandExecutor::get_stdout_buffer() const
+{
+	static const CommandOutputPtr empty_output = std::make_shared<const std::string>();
+	return stdout_ ? stdout_ : empty_output;
 }
 
 
 
 std::string CommandExecutor::get_stderr_str(bool clear_existing)
 {
+	if (shared_stderr_.has_value()) {
+		std::string ret = shared_stderr_.value();
+		if (clear_existing) {
+			shared_stderr_->clear();
+		}
+		return ret;
+	}
 	return cmdex_.get_stderr_str(clear_existing);
 }
 
@@ -240,6 +1112,151 @@ void CommandExecutor::set_running_msg(const std::string& msg)
 
 
 
+void CommandExecutor::add_statistics_sample(bool spawned)
+{
+	CommandExecutionSample sample;
+	if (statistics_keys_.has_value()) {
+		sample.device = statistics_keys_->first;
+		sample.options = statistics_keys_->second;
+		sample.operation = operation_;
+	} else {
+		std::vector<std::string> command = {hz::fs_path_to_string(hz::fs_path_from_string(command_name_).filename())};
+		command.insert(command.end(), command_args_.begin(), command_args_.end());
+		sample.options = hz::string_join(command, " ");
+	}
+	sample.spawned = spawned;
+	if (spawned) {
+		const auto& timing = cmdex_.get_execution_timing();
+		sample.spawn_latency = timing.spawn_latency;
+		sample.time_to_first_byte = timing.time_to_first_byte;
+		sample.runtime = timing.runtime;
+		sample.timed_out = timing.timed_out;
+		sample.killed = (timing.kill_signal != 0);
+		sample.bytes_out = stdout_ ? stdout_->size() : 0;
+		sample.bytes_err = cmdex_.get_stderr_size();
+	}
+	cmdex_stats_add_sample(sample);
+}
+
+
+
+void CommandExecutor::apply_adaptive_timeouts()
+{
+	// Only the device commands have per-device statistics to learn from
+	if (!statistics_keys_.has_value() || statistics_keys_->first.empty()) {
+		return;
+	}
+	auto settings = cmdex_get_adaptive_timeout_settings();
+	if (!settings.has_value()) {
+		return;
+	}
+	// A full fetch may have to spin the drive up, or wait for its error recovery.
+	// Stopping it in the middle of an ATA command is worse than waiting.
+	if (operation_ == CommandOperation::Refresh && !cmdex_get_args_standby_aware(command_args_)) {
+		return;
+	}
+	settings->kill_delay = forced_kill_timeout_msec_;
+
+	const auto stats = cmdex_stats_get_device_operation(statistics_keys_->first, operation_);
+	const CommandStopTimeouts timeouts = cmdex_stats_compute_timeouts(stats ? &stats.value() : nullptr, settings.value());
+	debug_out_dump("app", DBG_FUNC_MSG << "Stop timeouts for " << statistics_keys_->first << ": "
+			<< timeouts.term_timeout.count() << " / " << timeouts.kill_timeout.count() << " ms.\n");
+	cmdex_.set_stop_timeouts(timeouts.term_timeout, timeouts.kill_timeout);
+}
+
+
+
+void CommandExecutor::apply_expected_output_sizes()
+{
+	// The statistics are keyed by the device and option set, nothing to look up otherwise
+	if (!statistics_keys_.has_value()) {
+		return;
+	}
+	const auto sizes = cmdex_stats_get_output_sizes(statistics_keys_->first, statistics_keys_->second);
+	if (sizes.has_value()) {
+		cmdex_.set_expected_output_sizes(static_cast<std::size_t>(sizes->get_expected_stdout()),
+				static_cast<std::size_t>(sizes->get_expected_stderr()));
+	}
+}
+
+
+
+void CommandExecutor::reset_for_reuse()
+{
+	// Translators: {command} will be replaced by command name.
+	running_msg_ = _("Running {command}...");
+	set_error_msg("");
+	cmdex_.set_output_chunk_callback(nullptr);
+	output_chunk_callback_set_ = false;
+	set_remote_host(nullptr);
+	operation_ = CommandOperation::Other;
+	priority_ = CommandPriority::Interactive;
+	cancellation_.reset();
+	stdout_.reset();
+	shared_stderr_.reset();
+	// This keeps the string capacity
+	static_cast<void>(cmdex_.get_stdout_str(true));
+	static_cast<void>(cmdex_.get_stderr_str(true));
+}
+
+
+
+std::chrono::steady_clock::duration CommandExecutor::prepare_execution_policy()
+{
+	const CommandExecutionPolicy policy = cmdex_get_execution_policy(operation_);
+
+	// The process controls are for local processes only. For remote commands, they would apply to ssh.
+	cmdex_.set_execution_policy(remote_host_ ? CommandExecutionPolicy() : policy,
+			hz::fs_path_from_string(rconfig::get_data<std::string>("system/linux_cgroup_path")));
+
+	// The statistics device key is the device file (prefixed by the remote host), i.e. the controller.
+	if (policy.rate_per_sec <= 0. || !statistics_keys_.has_value()) {
+		return {};
+	}
+	const auto wait = cmdex_get_rate_limiter().reserve(statistics_keys_->first,
+			policy.rate_per_sec, policy.rate_burst, std::chrono::steady_clock::now());
+	if (wait > std::chrono::steady_clock::duration::zero()) {
+		debug_out_dump("app", DBG_FUNC_MSG << "Rate limit of \"" << statistics_keys_->first << "\" reached, delaying the command by "
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(wait).count() << " ms.\n");
+	}
+	return wait;
+}
+
+
+
+std::string CommandExecutor::get_collapse_key() const
+{
+	if (!statistics_keys_.has_value() || statistics_keys_->first.empty() || output_chunk_callback_set_) {
+		return {};
+	}
+	std::vector<std::string> command = {remote_host_ ? remote_host_->get_destination() : std::string(), command_name_};
+	command.insert(command.end(), command_args_.begin(), command_args_.end());
+	return hz::string_join(command, "\n");
+}
+
+
+
+void CommandExecutor::adopt_shared_result(const CommandExecutorSharedResult& result)
+{
+	stdout_ = result.std_output;
+	shared_stderr_ = result.std_error;
+	set_error_msg(result.error_msg);
+}
+
+
+
+void CommandExecutor::apply_command()
+{
+	if (remote_host_) {
+		auto [ssh_command, ssh_args] = remote_host_->wrap_command(command_name_, command_args_);
+		cmdex_.set_command(std::move(ssh_command), std::move(ssh_args));
+	} else {
+		cmdex_.set_command(command_name_, command_args_);
+	}
+}
+
+
+
 void CommandExecutor::set_error_header(const std::string& msg)
 {
 	error_header_ = msg;
@@ -276,13 +1293,13 @@ sigc::signal<bool, CommandExecutor::TickStatus>& CommandExecutor::signal_execute
 void CommandExecutor::import_error()
 {
 	AsyncCommandExecutor::error_list_t errors = cmdex_.get_errors();  // these are not clones
-	hz::ErrorBase* e = nullptr;
+	std::shared_ptr<hz::ErrorBase> e;  // shared with the list, no need to clone
 	if (!errors.empty())
-		e = errors.back()->clone();
+		e = errors.back();
 	cmdex_.clear_errors();  // and clear them
 
 	if (e) {  // if error is present, alert the user
-		on_error_warn(e);
+		on_error_warn(e.get());
 	}
 }
 
@@ -304,6 +1321,13 @@ void CommandExecutor::set_error_msg(const std::string& error_msg)
 
 
 
+void CommandExecutor::set_stdout_buffer(CommandOutputPtr output)
+{
+	stdout_ = std::move(output);
+}
+
+
+
 std::string CommandExecutor::get_running_msg() const
 {
 	return running_msg_;
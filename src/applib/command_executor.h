@@ -15,19 +15,33 @@ Copyright:
 #include <sigc++/sigc++.h>
 #include <string>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <utility>
 
 #include "hz/error_holder.h"
 #include "hz/process_signal.h"  // hz::SIGNAL_*
 
+#include "app_cancellation.h"
 #include "async_command_executor.h"
+#include "command_executor_policy.h"
+#include "command_executor_remote.h"
+
+
+
+/// Shared immutable command output. The output of a command is handed from the executor
+/// to its users (device, parsers, execution log) through this, without being copied.
+using CommandOutputPtr = std::shared_ptr<const std::string>;
 
 
 
 /// Information about a finished command.
 struct CommandExecutorResult {
 	CommandExecutorResult(std::string arg_command, std::vector<std::string> arg_parameters,
-			std::string arg_std_output, std::string arg_std_error, std::string arg_error_message)
+			CommandOutputPtr arg_std_output, std::string arg_std_error, std::string arg_error_message)
 			: command(std::move(arg_command)),
 			parameters(std::move(arg_parameters)),
 			std_output(std::move(arg_std_output)),
@@ -37,7 +51,7 @@ struct CommandExecutorResult {
 
 	const std::string command;  ///< Executed command
 	const std::vector<std::string> parameters;  ///< Command parameters
-	const std::string std_output;  ///< Stdout data
+	const CommandOutputPtr std_output;  ///< Stdout data. Never nullptr.
 	const std::string std_error;  ///< Stderr data
 	const std::string error_message;  ///< Execution error message
 };
@@ -53,12 +67,75 @@ cmdex_signal_execute_finish_t& cmdex_sync_signal_execute_finish();
 
 
 
+/// Statistics of the waits in CommandExecutor::execute()
+struct CommandExecutorWaitStats {
+	std::uint64_t executions = 0;  ///< Number of commands waited for
+	std::chrono::microseconds saved_latency{0};  ///< Total waiting time avoided compared to the former 50 ms polling
+};
+
+
+/// Get CommandExecutor::execute() wait statistics since program start. Thread-safe.
+[[nodiscard]] CommandExecutorWaitStats cmdex_get_wait_stats();
+
+
+
+/// Statistics of the process-wide limit on simultaneously running commands,
+/// see cmdex_set_max_running_commands().
+struct CommandExecutorQueueStats {
+	std::size_t max_running = 0;  ///< Current limit, 0 if unlimited
+	std::size_t running = 0;  ///< Number of commands currently running
+	std::size_t queued = 0;  ///< Number of commands currently waiting for a free slot (queue depth)
+	std::size_t max_queued = 0;  ///< Maximum queue depth since program start
+	std::uint64_t waits = 0;  ///< Number of commands which had to wait for a free slot
+	std::chrono::microseconds total_wait_time{0};  ///< Total time spent waiting for a free slot
+	std::chrono::microseconds max_wait_time{0};  ///< Longest wait for a free slot
+	std::uint64_t collapsed = 0;  ///< Number of commands which shared the result of an identical waiting one instead of running
+	std::uint64_t domain_waits = 0;  ///< Number of commands which had to wait only because their serialization domain was full
+};
+
+
+/// Limit the number of commands run by CommandExecutor::execute() simultaneously,
+/// in all threads. The executions over the limit wait for a free slot (while still
+/// iterating their main context). 0 means unlimited (default). Thread-safe.
+/// The waiting executions get the free slots in the order of their priority classes
+/// (see CommandExecutor::set_priority() and cmdex_set_priority_aging()). A waiting execution
+/// of the same command on the same host as another waiting one doesn't wait for a slot of its own,
+/// it shares the result of the other one (see CommandExecutorQueueStats::collapsed).
+void cmdex_set_max_running_commands(std::size_t max_running);
+
+
+/// Limit the number of commands running simultaneously in each serialization domain (controller,
+/// see CommandExecutor::set_serialization_domain()), by domain family. This is in addition to
+/// cmdex_set_max_running_commands(); the commands of a full domain wait for a slot the same way,
+/// without holding up the commands of the other domains. Empty (default) means unlimited. Thread-safe.
+void cmdex_set_domain_limits(CommandDomainLimits limits);
+
+
+/// Set how long an execution waits for a slot before it's promoted to the next more important
+/// priority class (see cmdex_get_priority_rank()). Zero disables the promotion. Default: 10 seconds. Thread-safe.
+void cmdex_set_priority_aging(std::chrono::steady_clock::duration aging);
+
+
+/// Get the running command limit statistics. Thread-safe.
+[[nodiscard]] CommandExecutorQueueStats cmdex_get_queue_stats();
+
+
+
+
+
+/// Result of an execution shared with the identical executions collapsed into it, see cmdex_set_max_running_commands()
+struct CommandExecutorSharedResult;
+
 
 
 /// Synchronous AsyncCommandExecutor (command executor) with ticking support.
+/// See also execute_async() and app_coroutine.h for executing without blocking.
 class CommandExecutor : public sigc::trackable {
 	public:
 
+		/// Callback for execute_async(). The argument is the same as the return value of execute().
+		using execute_finished_func_t = std::function<void(bool executed)>;
+
 		/// Constructor
 		CommandExecutor();
 
@@ -83,9 +160,22 @@ class CommandExecutor : public sigc::trackable {
 		virtual ~CommandExecutor() = default;
 
 
-		/// Set command to execute and its parameters
+		/// Set command to execute and its parameters. This also resets the statistics keys.
 		void set_command(std::string command_name, std::vector<std::string> command_args);
 
+		/// Set the keys the executions of the current command are accounted under in
+		/// the execution statistics (see cmdex_stats_get()). If not set, the command
+		/// is not device-specific, and its option set is the command name with all the parameters.
+		void set_statistics_keys(std::string device, std::string options);
+
+		/// Set the serialization domain of the current command (see cmdex_get_serialization_domain()),
+		/// for the per-domain running command limits (see cmdex_set_domain_limits()).
+		/// Empty means none. This is reset by set_command().
+		void set_serialization_domain(std::string domain);
+
+		/// Get the serialization domain set by set_serialization_domain()
+		[[nodiscard]] const std::string& get_serialization_domain() const;
+
 
 		/// Get command to execute
 		[[nodiscard]] std::string get_command_name() const;
@@ -95,6 +185,41 @@ class CommandExecutor : public sigc::trackable {
 		[[nodiscard]] std::vector<std::string> get_command_args() const;
 
 
+		/// Execute the commands on a remote host (over SSH) instead of locally. nullptr means locally.
+		/// The command name and arguments stay the local ones in get_command_name(),
+		/// get_command_args() and the execution statistics.
+		void set_remote_host(RemoteHostPtr host);
+
+		/// Get the remote host the commands are executed on. nullptr if they're executed locally.
+		[[nodiscard]] RemoteHostPtr get_remote_host() const;
+
+
+		/// Set the operation type the commands are executed for. It selects the execution
+		/// policy (priorities, cgroup, rate limit; see cmdex_get_execution_policy()) of the
+		/// following executions. This is not reset by set_command().
+		void set_operation(CommandOperation operation);
+
+		/// Get the operation type set by set_operation()
+		[[nodiscard]] CommandOperation get_operation() const;
+
+
+		/// Set the priority class of the following executions when they wait for a free slot
+		/// (see cmdex_set_max_running_commands()). This is not reset by set_command(). Default: Interactive.
+		void set_priority(CommandPriority priority);
+
+		/// Get the priority class set by set_priority()
+		[[nodiscard]] CommandPriority get_priority() const;
+
+
+		/// Set the cancellation token of the operation the commands are executed for (nullptr for none).
+		/// When it's cancelled, execute() doesn't start new commands (it fails with an error) and
+		/// stops the running one, as if the tick slot requested it. This is not reset by set_command().
+		void set_cancellation(AppCancellationPtr cancellation);
+
+		/// Get the cancellation token set by set_cancellation()
+		[[nodiscard]] AppCancellationPtr get_cancellation() const;
+
+
 		/// Execute the command. The function will return only after the command exits.
 		/// Calls signal_execute_tick signal repeatedly while doing stuff.
 		/// Note: If the command _was_ executed, but there was an error,
@@ -103,6 +228,17 @@ class CommandExecutor : public sigc::trackable {
 		virtual bool execute();
 
 
+		/// Execute the command without waiting for it to exit. This returns immediately,
+		/// without iterating the main context. \c finished_func is called from the thread-default
+		/// main context of the calling thread when the command exits (never from this function),
+		/// after which the results are available as after execute(). If the running command limit
+		/// (see cmdex_set_max_running_commands()) is reached, the command is started when a slot
+		/// becomes free, also without blocking.
+		/// signal_execute_tick() is not emitted. Use try_stop() and set_stop_timeouts() to stop the
+		/// command. The executor must not be destroyed or executed again until \c finished_func is called.
+		void execute_async(execute_finished_func_t finished_func);
+
+
 		/// Set timeout (in ms) to send SIGKILL after sending SIGTERM.
 		/// Used if manual stop was requested through ticker.
 		void set_forced_kill_timeout(std::chrono::milliseconds timeout_msec);
@@ -135,10 +271,21 @@ class CommandExecutor : public sigc::trackable {
 		/// See AsyncCommandExecutor::set_buffer_sizes() for details. Call this before execute().
 		void set_buffer_sizes(gsize stdout_buffer_size = 0, gsize stderr_buffer_size = 0);
 
+		/// See AsyncCommandExecutor::set_streaming() for details. Call this before execute().
+		void set_streaming(bool enabled);
+
+		/// See AsyncCommandExecutor::set_output_chunk_callback() for details. Call this before execute().
+		void set_output_chunk_callback(AsyncCommandExecutor::output_chunk_func_t func);
+
 		/// See AsyncCommandExecutor::get_stdout_str() for details.
+		/// After execute(), this returns a copy of get_stdout_buffer().
 		[[nodiscard]] std::string get_stdout_str(bool clear_existing = false);
 
-		/// See AsyncCommandExecutor::get_stderr_str() for details.
+		/// Get the stdout data of the last execute() without copying it. Never nullptr.
+		[[nodiscard]] CommandOutputPtr get_stdout_buffer() const;
+
+		/// See AsyncCommandExecutor::get_stderr_str() for details. If the execution shared the result of
+		/// an identical one, this is its stderr data.
 		[[nodiscard]] std::string get_stderr_str(bool clear_existing = false);
 
 		/// See AsyncCommandExecutor::set_exit_status_translator() for details.
@@ -154,6 +301,12 @@ class CommandExecutor : public sigc::trackable {
 		void set_running_msg(const std::string& msg);
 
 
+		/// Prepare a finished executor for being handed out again (see CommandExecutorFactory::set_pooled()).
+		/// This resets the per-use settings (running message, error, chunk callback, remote host, operation, priority, cancellation) and clears the
+		/// output, keeping the allocated stderr buffer (the stdout buffer is handed out, see get_stdout_buffer()).
+		virtual void reset_for_reuse();
+
+
 		/// Set error header string. See get_error_msg()
 		void set_error_header(const std::string& msg);
 
@@ -190,6 +343,9 @@ class CommandExecutor : public sigc::trackable {
 		/// Import the last error from cmdex_ and clear all errors there.
 		virtual void import_error();
 
+		/// Add the last execution to the execution statistics
+		void add_statistics_sample(bool spawned);
+
 
 		/// The warnings are already printed via debug_* in cmdex.
 		/// Override if needed.
@@ -200,6 +356,11 @@ class CommandExecutor : public sigc::trackable {
 		void set_error_msg(const std::string& error_msg);
 
 
+		/// Set the stdout data of the last execution, as returned by get_stdout_buffer().
+		/// For the executors which reimplement execute() without spawning a process.
+		void set_stdout_buffer(CommandOutputPtr output);
+
+
 		/// Get "running" message
 		[[nodiscard]] std::string get_running_msg() const;
 
@@ -210,10 +371,47 @@ class CommandExecutor : public sigc::trackable {
 
 	private:
 
+		/// Pass the command (wrapped for the remote host, if any) to cmdex_
+		void apply_command();
+
+		/// Set the stop timeouts of the started command from the execution statistics of its device
+		/// and operation (see cmdex_stats_compute_timeouts()), unless disabled in the config.
+		/// The full fetches which may wake the drive up (not using "-n standby") are left alone.
+		void apply_adaptive_timeouts();
+
+		/// Presize the output buffers of cmdex_ for the output sizes of the earlier executions
+		/// of the same command (see CommandOutputSizes). Called before each execution.
+		void apply_expected_output_sizes();
+
+		/// Pass the execution policy of the operation to cmdex_ and reserve a start with the rate limiter.
+		/// \return how long to wait before starting the command.
+		[[nodiscard]] std::chrono::steady_clock::duration prepare_execution_policy();
+
+		/// Get the key the identical executions share the results by (see cmdex_set_max_running_commands()).
+		/// Empty if the execution cannot share the result: not a device command, or its output is streamed.
+		[[nodiscard]] std::string get_collapse_key() const;
+
+		/// Take the result of the identical execution this one was collapsed into
+		void adopt_shared_result(const CommandExecutorSharedResult& result);
+
+		/// Spawn the command of execute_async() after a running command slot was acquired
+		void start_async_execution();
+
+		/// Finish the execute_async() command after it exited
+		void finish_async_execution();
+
+
 		AsyncCommandExecutor cmdex_;  ///< Command executor
 
 		std::string command_name_;  ///< Command name
 		std::vector<std::string> command_args_;  ///< Command arguments
+		RemoteHostPtr remote_host_;  ///< Remote host to execute the command on. nullptr if local.
+		std::optional<std::pair<std::string, std::string>> statistics_keys_;  ///< Device and option set for execution statistics
+		std::string serialization_domain_;  ///< Serialization domain of the command, may be empty
+		CommandOperation operation_ = CommandOperation::Other;  ///< Operation type, selects the execution policy
+		CommandPriority priority_ = CommandPriority::Interactive;  ///< Priority class when waiting for a slot
+		bool output_chunk_callback_set_ = false;  ///< Whether the output is streamed to a callback
+		AppCancellationPtr cancellation_;  ///< Cancellation token, may be nullptr
 
 		std::string running_msg_;  ///< "Running" message (to show in the dialogs, etc.)
 
@@ -222,6 +420,14 @@ class CommandExecutor : public sigc::trackable {
 		std::string error_msg_;  ///< Execution error message
 		std::string error_header_;  ///< The error message may have this prepended to it.
 
+		CommandOutputPtr stdout_;  ///< Stdout data of the last execute(), taken from cmdex_ when the command finishes
+		std::optional<std::string> shared_stderr_;  ///< Stderr data of the last execute() if it shared the result of another one
+
+		execute_finished_func_t async_finished_func_;  ///< Callback of the running execute_async()
+		GMainContext* async_context_ = nullptr;  ///< Main context of the running execute_async()
+		std::string async_domain_;  ///< Serialization domain the slot of the running execute_async() was acquired in
+		std::shared_ptr<CommandExecutorSharedResult> async_shared_result_;  ///< Result of the running execute_async() to share with the collapsed executions, may be nullptr
+
 
 		/// This signal is emitted whenever something happens with the execution
 		/// (the status is changed), and periodically while the process is running.
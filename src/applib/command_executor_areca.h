@@ -21,6 +21,10 @@ Copyright:
 #include "command_executor.h"
 
 
+// Forward declaration, see command_executor_gui.h
+class CommandExecutorGui;
+
+
 
 
 /// Executor for cli (Areca utility)
@@ -88,12 +92,12 @@ void ArecaCliExecutorGeneric<ExecutorPolicy>::import_error()
 	AsyncCommandExecutor& cmdex = this->get_async_executor();
 	AsyncCommandExecutor::error_list_t errors = cmdex.get_errors();  // these are not clones
 
-	hz::ErrorBase* e = nullptr;
+	std::shared_ptr<hz::ErrorBase> e;  // shared with the list, no need to clone
 	// find the last relevant error.
 	for (const auto& error : std::ranges::reverse_view(errors)) {
 		// ignore iochannel errors, they may mask the real errors
 		if (error->get_type() != "giochannel" && error->get_type() != "custom") {
-			e = error->clone();
+			e = error;
 			break;
 		}
 	}
@@ -101,7 +105,7 @@ void ArecaCliExecutorGeneric<ExecutorPolicy>::import_error()
 	cmdex.clear_errors();  // and clear them
 
 	if (e) {  // if error is present, alert the user
-		on_error_warn(e);
+		on_error_warn(e.get());
 	}
 }
 
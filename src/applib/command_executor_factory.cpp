@@ -9,50 +9,173 @@ Copyright:
 /// \weakgroup applib
 /// @{
 
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include "hz/debug.h"
 #include "command_executor_factory.h"
-#include "smartctl_executor_gui.h"
+#include "smartctl_executor.h"
 #include "command_executor_areca.h"
 #include "command_executor_3ware.h"
 
 
 
-CommandExecutorFactory::CommandExecutorFactory(bool use_gui, Gtk::Window* parent)
-		: use_gui_(use_gui), parent_(parent)
-{ }
+namespace {
+
+	/// Maximum number of idle executors of each type kept in a pool
+	constexpr std::size_t cmdex_pool_max_idle = 16;
+
+}
+
+
+
+/// Pool of released executors, by type
+struct CommandExecutorFactory::Pool {
+	mutable std::mutex mutex;  ///< Protects all the members
+	std::vector<std::pair<ExecutorType, std::shared_ptr<CommandExecutor>>> idle;  ///< Released executors
+	CommandExecutorPoolStats stats;  ///< Statistics
+};
 
 
 
 std::shared_ptr<CommandExecutor> CommandExecutorFactory::create_executor(CommandExecutorFactory::ExecutorType type)
+{
+	const std::shared_ptr<Pool> pool = pool_;
+	if (!pool) {
+		auto ex = construct_executor(type);
+		ex->set_remote_host(remote_host_);
+		ex->set_cancellation(cancellation_);
+		ex->set_priority(priority_);
+		return ex;
+	}
+
+	std::shared_ptr<CommandExecutor> ex;
+	{
+		const std::lock_guard lock(pool->mutex);
+		for (auto iter = pool->idle.rbegin(); iter != pool->idle.rend(); ++iter) {
+			if (iter->first == type) {
+				ex = std::move(iter->second);
+				pool->idle.erase(std::next(iter).base());
+				++pool->stats.reused;
+				break;
+			}
+		}
+	}
+	if (!ex) {
+		ex = construct_executor(type);
+		const std::lock_guard lock(pool->mutex);
+		++pool->stats.created;
+	}
+	ex->set_remote_host(remote_host_);  // reset_for_reuse() unsets it
+	ex->set_cancellation(cancellation_);  // same
+	ex->set_priority(priority_);  // same
+
+	// The returned pointer owns "ex"; when it's released, the executor is put back
+	// into the pool (unless the pool is gone or full).
+	const std::weak_ptr<Pool> weak_pool = pool;
+	CommandExecutor* raw_ex = ex.get();
+	return {raw_ex, [ex = std::move(ex), weak_pool, type]([[maybe_unused]] CommandExecutor* ptr) mutable {
+		if (auto locked_pool = weak_pool.lock()) {
+			ex->reset_for_reuse();
+			const std::lock_guard lock(locked_pool->mutex);
+			const auto same_type = std::count_if(locked_pool->idle.begin(), locked_pool->idle.end(),
+					[type](const auto& entry) { return entry.first == type; });
+			if (static_cast<std::size_t>(same_type) < cmdex_pool_max_idle) {
+				locked_pool->idle.emplace_back(type, std::move(ex));
+			}
+		}
+		ex.reset();
+	}};
+}
+
+
+
+void CommandExecutorFactory::set_pooled(bool pooled)
+{
+	if (pooled && !pool_) {
+		pool_ = std::make_shared<Pool>();
+	} else if (!pooled) {
+		pool_.reset();  // the handed-out executors are destroyed normally then
+	}
+}
+
+
+
+bool CommandExecutorFactory::get_pooled() const
+{
+	return static_cast<bool>(pool_);
+}
+
+
+
+CommandExecutorPoolStats CommandExecutorFactory::get_pool_stats() const
+{
+	const std::shared_ptr<Pool> pool = pool_;
+	if (!pool) {
+		return {};
+	}
+	const std::lock_guard lock(pool->mutex);
+	CommandExecutorPoolStats stats = pool->stats;
+	stats.idle = pool->idle.size();
+	return stats;
+}
+
+
+
+void CommandExecutorFactory::set_remote_host(RemoteHostPtr host)
+{
+	remote_host_ = std::move(host);
+}
+
+
+
+RemoteHostPtr CommandExecutorFactory::get_remote_host() const
+{
+	return remote_host_;
+}
+
+
+
+void CommandExecutorFactory::set_cancellation(AppCancellationPtr cancellation)
+{
+	cancellation_ = std::move(cancellation);
+}
+
+
+
+AppCancellationPtr CommandExecutorFactory::get_cancellation() const
+{
+	return cancellation_;
+}
+
+
+
+void CommandExecutorFactory::set_priority(CommandPriority priority)
+{
+	priority_ = priority;
+}
+
+
+
+CommandPriority CommandExecutorFactory::get_priority() const
+{
+	return priority_;
+}
+
+
+
+std::shared_ptr<CommandExecutor> CommandExecutorFactory::construct_executor(CommandExecutorFactory::ExecutorType type)
 {
 	switch (type) {
 		case ExecutorType::Smartctl:
-		{
-			if (use_gui_) {
-				auto ex = std::make_shared<SmartctlExecutorGui>();
-				ex->create_running_dialog(parent_);  // dialog parent
-				return ex;
-			}
 			return std::make_shared<SmartctlExecutor>();
-		}
 		case ExecutorType::TwCli:
-		{
-			if (use_gui_) {
-				auto ex = std::make_shared<TwCliExecutorGui>();
-				ex->create_running_dialog(parent_);  // dialog parent
-				return ex;
-			}
 			return std::make_shared<TwCliExecutor>();
-		}
 		case ExecutorType::ArecaCli:
-		{
-			if (use_gui_) {
-				auto ex = std::make_shared<ArecaCliExecutorGui>();
-				ex->create_running_dialog(parent_);  // dialog parent
-				return ex;
-			}
 			return std::make_shared<ArecaCliExecutor>();
-		}
 	}
 
 	DBG_ASSERT(0);
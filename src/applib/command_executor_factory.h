@@ -12,20 +12,27 @@ Copyright:
 #ifndef COMMAND_EXECUTOR_FACTORY_H
 #define COMMAND_EXECUTOR_FACTORY_H
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 #include "command_executor.h"
 
 
-// Forward declaration
-namespace Gtk {
-	class Window;
-}
+
+/// Statistics of a pooled CommandExecutorFactory, see CommandExecutorFactory::set_pooled().
+struct CommandExecutorPoolStats {
+	std::uint64_t created = 0;  ///< Number of executors constructed
+	std::uint64_t reused = 0;  ///< Number of executors handed out again from the pool
+	std::size_t idle = 0;  ///< Number of executors currently in the pool
+};
 
 
 
 /// This class allows you to create new executors for different commands,
 /// without carrying the GUI/CLI stuff manually.
+/// This class constructs non-GUI executors only, see CommandExecutorFactoryGui
+/// for the GUI version. It has no Gtk dependency, so it may be used by non-GUI programs.
 class CommandExecutorFactory {
 	public:
 
@@ -37,18 +44,105 @@ class CommandExecutorFactory {
 		};
 
 
-		/// Constructor. If \c use_gui is true, specify \c parent for the GUI dialogs.
-		explicit CommandExecutorFactory(bool use_gui, Gtk::Window* parent = nullptr);
+		/// Defaulted
+		CommandExecutorFactory() = default;
+
+		/// Deleted
+		CommandExecutorFactory(const CommandExecutorFactory& other) = delete;
+
+		/// Deleted
+		CommandExecutorFactory(CommandExecutorFactory&& other) = delete;
+
+		/// Deleted
+		CommandExecutorFactory& operator=(const CommandExecutorFactory& other) = delete;
+
+		/// Deleted
+		CommandExecutorFactory& operator=(CommandExecutorFactory&& other) = delete;
+
+		/// Virtual destructor
+		virtual ~CommandExecutorFactory() = default;
+
+
+		/// Create a new executor instance according to \c type.
+		/// If the factory is pooled, a previously released executor of the same type
+		/// may be returned instead. Thread-safe.
+		[[nodiscard]] std::shared_ptr<CommandExecutor> create_executor(ExecutorType type);
+
+
+		/// Enable or disable executor pooling. In pooled mode, the executors are
+		/// not destroyed when the last reference to them goes away, but are kept
+		/// (with their output buffers) and returned by the subsequent create_executor() calls.
+		/// This is useful for long-lived factories which run a lot of short commands.
+		/// Note that the running command limit (cmdex_set_max_running_commands()) applies
+		/// to all the executors regardless of pooling.
+		/// Call this before the factory is shared with other threads.
+		void set_pooled(bool pooled);
+
+
+		/// Check whether executor pooling is enabled.
+		[[nodiscard]] bool get_pooled() const;
+
+
+		/// Get pool statistics. Thread-safe.
+		[[nodiscard]] CommandExecutorPoolStats get_pool_stats() const;
+
+
+		/// Make the created executors run their commands on a remote host (over SSH, see RemoteHost).
+		/// nullptr (default) means locally.
+		/// Call this before the factory is shared with other threads.
+		void set_remote_host(RemoteHostPtr host);
+
+
+		/// Get the remote host the created executors run their commands on. nullptr if locally.
+		[[nodiscard]] RemoteHostPtr get_remote_host() const;
 
 
-		/// Create a new executor instance according to \c type and the constructor parameters.
-		std::shared_ptr<CommandExecutor> create_executor(ExecutorType type);
+		/// Set the cancellation token of the created executors (see CommandExecutor::set_cancellation()),
+		/// nullptr for none. It only affects the executors created afterwards.
+		/// Call this while the factory is not used by other threads.
+		void set_cancellation(AppCancellationPtr cancellation);
+
+
+		/// Get the cancellation token of the created executors, may be nullptr
+		[[nodiscard]] AppCancellationPtr get_cancellation() const;
+
+
+		/// Set the priority class of the created executors (see CommandExecutor::set_priority()).
+		/// It only affects the executors created afterwards.
+		/// Call this while the factory is not used by other threads.
+		void set_priority(CommandPriority priority);
+
+
+		/// Get the priority class of the created executors
+		[[nodiscard]] CommandPriority get_priority() const;
+
+
+		/// Check whether this factory constructs GUI executors.
+		/// GUI executors may only be used from the main thread.
+		[[nodiscard]] virtual bool get_use_gui() const
+		{
+			return false;
+		}
+
+
+	protected:
+
+		/// Construct a new executor instance according to \c type.
+		/// Override this to construct a different kind of executors.
+		virtual std::shared_ptr<CommandExecutor> construct_executor(ExecutorType type);
 
 
 	private:
 
-		bool use_gui_ = false;  ///< Whether to construct GUI executors or not.
-		Gtk::Window* parent_ = nullptr;  ///< Parent window for dialogs
+		struct Pool;
+
+		std::shared_ptr<Pool> pool_;  ///< Executor pool, shared with the deleters of the handed-out executors. nullptr if not pooled.
+
+		RemoteHostPtr remote_host_;  ///< Remote host of the created executors. nullptr if local.
+
+		AppCancellationPtr cancellation_;  ///< Cancellation token of the created executors, may be nullptr
+
+		CommandPriority priority_ = CommandPriority::Interactive;  ///< Priority class of the created executors
 
 };
 
@@ -59,6 +153,23 @@ using CommandExecutorFactoryPtr = std::shared_ptr<CommandExecutorFactory>;
 
 
 
+/// Get a factory for use in worker threads. GUI executors may only be used from
+/// the main thread, so a non-GUI factory is returned in place of a GUI one.
+inline CommandExecutorFactoryPtr command_executor_factory_for_worker_threads(const CommandExecutorFactoryPtr& factory)
+{
+	if (factory->get_use_gui()) {
+		auto worker_factory = std::make_shared<CommandExecutorFactory>();
+		worker_factory->set_pooled(factory->get_pooled());
+		worker_factory->set_remote_host(factory->get_remote_host());
+		worker_factory->set_cancellation(factory->get_cancellation());
+		worker_factory->set_priority(factory->get_priority());
+		return worker_factory;
+	}
+	return factory;
+}
+
+
+
 
 #endif
 
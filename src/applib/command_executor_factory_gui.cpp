@@ -0,0 +1,58 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2008 - 2021 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "hz/debug.h"
+#include "command_executor_factory_gui.h"
+#include "smartctl_executor_gui.h"
+#include "command_executor_areca.h"
+#include "command_executor_3ware.h"
+
+
+
+CommandExecutorFactoryGui::CommandExecutorFactoryGui(Gtk::Window* parent)
+		: parent_(parent)
+{ }
+
+
+
+std::shared_ptr<CommandExecutor> CommandExecutorFactoryGui::construct_executor(CommandExecutorFactory::ExecutorType type)
+{
+	switch (type) {
+		case ExecutorType::Smartctl:
+		{
+			auto ex = std::make_shared<SmartctlExecutorGui>();
+			ex->create_running_dialog(parent_);  // dialog parent
+			return ex;
+		}
+		case ExecutorType::TwCli:
+		{
+			auto ex = std::make_shared<TwCliExecutorGui>();
+			ex->create_running_dialog(parent_);  // dialog parent
+			return ex;
+		}
+		case ExecutorType::ArecaCli:
+		{
+			auto ex = std::make_shared<ArecaCliExecutorGui>();
+			ex->create_running_dialog(parent_);  // dialog parent
+			return ex;
+		}
+	}
+
+	DBG_ASSERT(0);
+	return std::make_shared<CommandExecutorGui>();
+}
+
+
+
+
+
+
+/// @}
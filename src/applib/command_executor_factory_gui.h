@@ -0,0 +1,59 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2008 - 2021 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef COMMAND_EXECUTOR_FACTORY_GUI_H
+#define COMMAND_EXECUTOR_FACTORY_GUI_H
+
+#include <memory>
+
+#include "command_executor_factory.h"
+
+
+// Forward declaration
+namespace Gtk {
+	class Window;
+}
+
+
+
+/// Command executor factory which constructs GUI executors (with "running" dialogs).
+class CommandExecutorFactoryGui : public CommandExecutorFactory {
+	public:
+
+		/// Constructor. Specify \c parent for the GUI dialogs.
+		explicit CommandExecutorFactoryGui(Gtk::Window* parent = nullptr);
+
+
+		/// Reimplemented from CommandExecutorFactory
+		[[nodiscard]] bool get_use_gui() const override
+		{
+			return true;
+		}
+
+
+	protected:
+
+		/// Construct a new GUI executor instance according to \c type.
+		std::shared_ptr<CommandExecutor> construct_executor(ExecutorType type) override;
+
+
+	private:
+
+		Gtk::Window* parent_ = nullptr;  ///< Parent window for dialogs
+
+};
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,128 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <thread>
+#include <utility>
+
+#include "command_executor_mock.h"
+
+
+
+void CommandExecutorMockCorpus::add(std::vector<std::string> args, CommandExecutorMockResponse response)
+{
+	if (!response.std_output) {
+		response.std_output = std::make_shared<const std::string>();
+	}
+	responses_.insert_or_assign(std::move(args), std::move(response));
+}
+
+
+
+void CommandExecutorMockCorpus::add(std::vector<std::string> args, std::string output, std::chrono::microseconds delay)
+{
+	add(std::move(args), CommandExecutorMockResponse {
+		.std_output = std::make_shared<const std::string>(std::move(output)),
+		.error_message = {},
+		.delay = delay,
+	});
+}
+
+
+
+const CommandExecutorMockResponse* CommandExecutorMockCorpus::find(const std::vector<std::string>& args) const
+{
+	if (auto iter = responses_.find(args); iter != responses_.end()) {
+		hit_count_.fetch_add(1, std::memory_order_relaxed);
+		return &iter->second;
+	}
+	const std::scoped_lock lock(misses_mutex_);
+	misses_.insert(args);
+	return nullptr;
+}
+
+
+
+std::set<std::vector<std::string>> CommandExecutorMockCorpus::get_misses() const
+{
+	const std::scoped_lock lock(misses_mutex_);
+	return misses_;
+}
+
+
+
+void CommandExecutorMockCorpus::clear_misses()
+{
+	const std::scoped_lock lock(misses_mutex_);
+	misses_.clear();
+}
+
+
+
+std::uint64_t CommandExecutorMockCorpus::get_hit_count() const
+{
+	return hit_count_.load(std::memory_order_relaxed);
+}
+
+
+
+CommandExecutorMock::CommandExecutorMock(CommandExecutorMockCorpusPtr corpus)
+		: corpus_(std::move(corpus))
+{ }
+
+
+
+bool CommandExecutorMock::execute()
+{
+	if (app_is_cancelled(get_cancellation())) {
+		set_error_msg("The operation was cancelled.");
+		set_stdout_buffer(std::make_shared<const std::string>());
+		return false;
+	}
+
+	const CommandExecutorMockResponse* response = corpus_->find(get_command_args());
+	if (!response) {
+		set_error_msg("The command has no canned response.");
+		set_stdout_buffer(std::make_shared<const std::string>());
+		return false;
+	}
+
+	if (response->delay.count() > 0) {
+		std::this_thread::sleep_for(response->delay);
+	}
+	set_error_msg(response->error_message);
+	set_stdout_buffer(response->std_output);
+	return true;
+}
+
+
+
+CommandExecutorFactoryMock::CommandExecutorFactoryMock(CommandExecutorMockCorpusPtr corpus)
+		: corpus_(std::move(corpus))
+{ }
+
+
+
+const CommandExecutorMockCorpusPtr& CommandExecutorFactoryMock::get_corpus() const
+{
+	return corpus_;
+}
+
+
+
+std::shared_ptr<CommandExecutor> CommandExecutorFactoryMock::construct_executor([[maybe_unused]] ExecutorType type)
+{
+	return std::make_shared<CommandExecutorMock>(corpus_);
+}
+
+
+
+
+/// @}
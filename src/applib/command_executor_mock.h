@@ -0,0 +1,130 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef COMMAND_EXECUTOR_MOCK_H
+#define COMMAND_EXECUTOR_MOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "command_executor.h"
+#include "command_executor_factory.h"
+
+
+
+/// A canned response of CommandExecutorMock
+struct CommandExecutorMockResponse {
+	CommandOutputPtr std_output;  ///< Stdout data, shared by all the executions. nullptr means empty.
+	std::string error_message;  ///< Execution error message, e.g. as translated from a non-zero exit status
+	std::chrono::microseconds delay{0};  ///< Simulated execution time (the executing thread sleeps)
+};
+
+
+
+/// In-memory corpus of canned command responses, keyed by the command arguments
+/// (without the command name, which depends on the configuration).
+/// Fill it before it's shared with the executors; the lookups are thread-safe.
+class CommandExecutorMockCorpus {
+	public:
+
+		/// Add (or replace) a response for the command arguments
+		void add(std::vector<std::string> args, CommandExecutorMockResponse response);
+
+		/// Add (or replace) a response with \c output as stdout
+		void add(std::vector<std::string> args, std::string output, std::chrono::microseconds delay = {});
+
+		/// Find a response for the command arguments. Returns nullptr if there is none, and
+		/// remembers the arguments (see get_misses()). Thread-safe.
+		[[nodiscard]] const CommandExecutorMockResponse* find(const std::vector<std::string>& args) const;
+
+		/// Get the argument lists find() had no response for. This allows filling the corpus
+		/// with the exact command lines the code under test uses, by running it once. Thread-safe.
+		[[nodiscard]] std::set<std::vector<std::string>> get_misses() const;
+
+		/// Forget the misses. Thread-safe.
+		void clear_misses();
+
+		/// Get the number of find() calls which returned a response. Thread-safe.
+		[[nodiscard]] std::uint64_t get_hit_count() const;
+
+	private:
+
+		std::map<std::vector<std::string>, CommandExecutorMockResponse> responses_;  ///< Responses by arguments
+
+		mutable std::mutex misses_mutex_;  ///< Mutex for misses_
+		mutable std::set<std::vector<std::string>> misses_;  ///< Arguments without a response
+		mutable std::atomic<std::uint64_t> hit_count_ = 0;  ///< Number of found responses
+
+};
+
+
+/// A reference-counting pointer to CommandExecutorMockCorpus
+using CommandExecutorMockCorpusPtr = std::shared_ptr<CommandExecutorMockCorpus>;
+
+
+
+/// Executor returning the canned responses of a corpus instead of running the commands.
+/// Used for benchmarking and profiling the code above the executors without
+/// the process creation noise.
+class CommandExecutorMock : public CommandExecutor {
+	public:
+
+		/// Constructor
+		explicit CommandExecutorMock(CommandExecutorMockCorpusPtr corpus);
+
+		/// Reimplemented. Fails (returns false) if the corpus has no response for the command.
+		bool execute() override;
+
+	private:
+
+		CommandExecutorMockCorpusPtr corpus_;  ///< Response corpus
+
+};
+
+
+
+/// Executor factory creating CommandExecutorMock executors (for all executor types)
+/// sharing a corpus.
+class CommandExecutorFactoryMock : public CommandExecutorFactory {
+	public:
+
+		/// Constructor
+		explicit CommandExecutorFactoryMock(CommandExecutorMockCorpusPtr corpus);
+
+		/// Get the corpus
+		[[nodiscard]] const CommandExecutorMockCorpusPtr& get_corpus() const;
+
+	protected:
+
+		/// Reimplemented
+		std::shared_ptr<CommandExecutor> construct_executor(ExecutorType type) override;
+
+	private:
+
+		CommandExecutorMockCorpusPtr corpus_;  ///< Response corpus
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
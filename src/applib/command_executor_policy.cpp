@@ -0,0 +1,348 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>  // std::strerror
+
+#ifndef _WIN32
+	#include <sys/resource.h>  // setpriority()
+#endif
+#ifdef __linux__
+	#include <sys/syscall.h>  // SYS_ioprio_set
+	#include <unistd.h>
+#endif
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+#include "rconfig/rconfig.h"
+
+#include "command_executor_policy.h"
+
+
+
+namespace {
+
+	/// Read a policy setting
+	template<typename T>
+	T cmdex_get_policy_setting(CommandOperation operation, std::string_view name)
+	{
+		return rconfig::get_data<T>("system/exec_policy/" + std::string(cmdex_get_operation_name(operation)) + "/" + std::string(name));
+	}
+
+
+	/// Serialization domains of the devices registered by detection
+	struct CmdexDeviceDomains {
+		std::mutex mutex;  ///< Protects domains
+		std::map<std::string, std::string, std::less<>> domains;  ///< Device key -> domain
+	};
+
+
+	/// Get the registered serialization domains
+	CmdexDeviceDomains& cmdex_get_device_domains()
+	{
+		static CmdexDeviceDomains domains;
+		return domains;
+	}
+
+
+#ifdef __linux__
+
+	/// ioprio_set() "which" argument for a single process (linux/ioprio.h)
+	constexpr int cmdex_ioprio_who_process = 1;
+
+	/// Bit shift of the class in an I/O priority value (linux/ioprio.h)
+	constexpr int cmdex_ioprio_class_shift = 13;
+
+
+	/// Get the kernel I/O class number
+	int cmdex_get_ioprio_class_number(CommandIoPriorityClass io_class)
+	{
+		switch (io_class) {
+			case CommandIoPriorityClass::Default: break;
+			case CommandIoPriorityClass::RealTime: return 1;
+			case CommandIoPriorityClass::BestEffort: return 2;
+			case CommandIoPriorityClass::Idle: return 3;
+		}
+		return 0;
+	}
+
+
+	/// Write a value to a cgroup interface file
+	bool cmdex_write_cgroup_file(const hz::fs::path& file, const std::string& value)
+	{
+		if (auto ec = hz::fs_file_put_contents(file, value)) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot write \"" << value << "\" to \""
+					<< hz::fs_path_to_string(file) << "\": " << ec.message() << "\n");
+			return false;
+		}
+		return true;
+	}
+
+#endif
+
+}
+
+
+
+CommandExecutionPolicy cmdex_get_execution_policy(CommandOperation operation)
+{
+	CommandExecutionPolicy policy;
+	policy.nice = std::clamp(cmdex_get_policy_setting<int>(operation, "nice"), 0, 19);
+	const auto io_class_name = cmdex_get_policy_setting<std::string>(operation, "io_class");
+	if (auto io_class = cmdex_parse_io_priority_class(io_class_name)) {
+		policy.io_class = io_class.value();
+	} else {
+		debug_out_warn("app", DBG_FUNC_MSG << "Invalid I/O class \"" << io_class_name << "\" of "
+				<< cmdex_get_operation_name(operation) << " operations, ignoring.\n");
+	}
+	policy.io_level = std::clamp(cmdex_get_policy_setting<int>(operation, "io_level"), 0, 7);
+	policy.cgroup = cmdex_get_policy_setting<std::string>(operation, "cgroup");
+	policy.cgroup_cpu_max = cmdex_get_policy_setting<std::string>(operation, "cgroup_cpu_max");
+	policy.cgroup_io_max = cmdex_get_policy_setting<std::string>(operation, "cgroup_io_max");
+	policy.rate_per_sec = std::max(0., cmdex_get_policy_setting<double>(operation, "rate_per_sec"));
+	policy.rate_burst = std::max(1, cmdex_get_policy_setting<int>(operation, "rate_burst"));
+	return policy;
+}
+
+
+
+std::string_view cmdex_get_operation_name(CommandOperation operation)
+{
+	switch (operation) {
+		case CommandOperation::Other: return "other";
+		case CommandOperation::Scan: return "scan";
+		case CommandOperation::Refresh: return "refresh";
+		case CommandOperation::SelfTest: return "selftest";
+	}
+	return "other";
+}
+
+
+
+std::string_view cmdex_get_priority_name(CommandPriority priority)
+{
+	switch (priority) {
+		case CommandPriority::Interactive: return "interactive";
+		case CommandPriority::SelfTestPoll: return "selftest_poll";
+		case CommandPriority::BackgroundRefresh: return "background_refresh";
+		case CommandPriority::Bulk: return "bulk";
+	}
+	return "interactive";
+}
+
+
+
+std::int64_t cmdex_get_priority_rank(CommandPriority priority,
+		std::chrono::steady_clock::duration waited, std::chrono::steady_clock::duration aging)
+{
+	auto rank = static_cast<std::int64_t>(priority);
+	if (aging > std::chrono::steady_clock::duration::zero() && waited > std::chrono::steady_clock::duration::zero()) {
+		rank -= static_cast<std::int64_t>(waited / aging);
+	}
+	return rank;
+}
+
+
+
+std::optional<CommandIoPriorityClass> cmdex_parse_io_priority_class(std::string_view name)
+{
+	const std::string_view trimmed = hz::string_trim_view(name);
+	if (trimmed.empty() || hz::string_iequals(trimmed, "default")) {
+		return CommandIoPriorityClass::Default;
+	}
+	if (hz::string_iequals(trimmed, "realtime")) {
+		return CommandIoPriorityClass::RealTime;
+	}
+	if (hz::string_iequals(trimmed, "best-effort")) {
+		return CommandIoPriorityClass::BestEffort;
+	}
+	if (hz::string_iequals(trimmed, "idle")) {
+		return CommandIoPriorityClass::Idle;
+	}
+	return std::nullopt;
+}
+
+
+
+void cmdex_apply_execution_policy([[maybe_unused]] int pid, [[maybe_unused]] const CommandExecutionPolicy& policy,
+		[[maybe_unused]] const hz::fs::path& cgroup_root)
+{
+#ifndef _WIN32
+	if (policy.nice > 0) {
+		// The child has our niceness at this point.
+		errno = 0;
+		const int current = getpriority(PRIO_PROCESS, 0);
+		if (errno == 0 && setpriority(PRIO_PROCESS, static_cast<id_t>(pid), std::min(current + policy.nice, 19)) != 0) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot set the niceness of process " << pid << ": " << std::strerror(errno) << "\n");
+		}
+	}
+#endif
+
+#ifdef __linux__
+	if (policy.io_class != CommandIoPriorityClass::Default) {
+		const int level = (policy.io_class == CommandIoPriorityClass::Idle ? 0 : policy.io_level);
+		const int ioprio = (cmdex_get_ioprio_class_number(policy.io_class) << cmdex_ioprio_class_shift) | level;
+		if (syscall(SYS_ioprio_set, cmdex_ioprio_who_process, pid, ioprio) != 0) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot set the I/O priority of process " << pid << ": " << std::strerror(errno) << "\n");
+		}
+	}
+
+	if (!policy.cgroup.empty() && !cgroup_root.empty()) {
+		// The controllers used by the limits must be enabled in cgroup.subtree_control
+		// of the parent group, which is up to the administrator.
+		const hz::fs::path group = cgroup_root / hz::fs_path_from_string(policy.cgroup);
+		std::error_code ec;
+		hz::fs::create_directories(group, ec);
+		if (ec) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot create cgroup \"" << hz::fs_path_to_string(group) << "\": " << ec.message() << "\n");
+			return;
+		}
+		if (!policy.cgroup_cpu_max.empty()) {
+			cmdex_write_cgroup_file(group / "cpu.max", policy.cgroup_cpu_max);
+		}
+		if (!policy.cgroup_io_max.empty()) {
+			cmdex_write_cgroup_file(group / "io.max", policy.cgroup_io_max);
+		}
+		cmdex_write_cgroup_file(group / "cgroup.procs", hz::number_to_string_nolocale(pid));
+	}
+#endif
+}
+
+
+
+std::chrono::steady_clock::duration CommandRateLimiter::reserve(const std::string& key, double rate_per_sec, int burst,
+		std::chrono::steady_clock::time_point now)
+{
+	if (rate_per_sec <= 0.) {
+		return {};
+	}
+	const double capacity = std::max(1, burst);
+
+	const std::scoped_lock lock(mutex_);
+	auto [iter, inserted] = buckets_.try_emplace(key);
+	Bucket& bucket = iter->second;
+	if (inserted) {
+		bucket.tokens = capacity;
+	} else if (now > bucket.updated) {
+		const double elapsed_sec = std::chrono::duration<double>(now - bucket.updated).count();
+		bucket.tokens = std::min(capacity, bucket.tokens + elapsed_sec * rate_per_sec);
+	}
+	bucket.updated = std::max(bucket.updated, now);
+
+	bucket.tokens -= 1.;
+	if (bucket.tokens >= 0.) {
+		return {};
+	}
+	return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(-bucket.tokens / rate_per_sec));
+}
+
+
+
+void CommandRateLimiter::clear()
+{
+	const std::scoped_lock lock(mutex_);
+	buckets_.clear();
+}
+
+
+
+CommandRateLimiter& cmdex_get_rate_limiter()
+{
+	static CommandRateLimiter limiter;
+	return limiter;
+}
+
+
+
+std::string cmdex_get_serialization_domain(const std::string& device_key, std::string_view type_argument)
+{
+	// The port follows the comma; the type may be prefixed by the protocol ("sat+megaraid,0").
+	if (const auto comma_pos = type_argument.find(','); comma_pos != std::string_view::npos) {
+		std::string_view type = type_argument.substr(0, comma_pos);
+		if (const auto plus_pos = type.rfind('+'); plus_pos != std::string_view::npos) {
+			type.remove_prefix(plus_pos + 1);
+		}
+		return hz::string_to_lower_copy(std::string(type)) + ":" + device_key;
+	}
+
+	auto& registry = cmdex_get_device_domains();
+	const std::scoped_lock lock(registry.mutex);
+	if (auto iter = registry.domains.find(device_key); iter != registry.domains.end()) {
+		return iter->second;
+	}
+	return {};
+}
+
+
+
+void cmdex_set_device_domain(const std::string& device_key, std::string domain)
+{
+	auto& registry = cmdex_get_device_domains();
+	const std::scoped_lock lock(registry.mutex);
+	if (domain.empty()) {
+		registry.domains.erase(device_key);
+	} else {
+		registry.domains.insert_or_assign(device_key, std::move(domain));
+	}
+}
+
+
+
+std::string_view cmdex_get_domain_family(std::string_view domain)
+{
+	return domain.substr(0, domain.find(':'));
+}
+
+
+
+std::optional<CommandDomainLimits> cmdex_parse_domain_limits(std::string_view str)
+{
+	CommandDomainLimits limits;
+	for (const std::string_view entry : hz::string_split_view(str, ';', true)) {
+		const std::string_view trimmed = hz::string_trim_view(entry);
+		if (trimmed.empty()) {
+			continue;
+		}
+		const auto colon_pos = trimmed.find(':');
+		if (colon_pos == std::string_view::npos) {
+			return std::nullopt;
+		}
+		const std::string family = hz::string_to_lower_copy(hz::string_trim_copy(trimmed.substr(0, colon_pos)));
+		int limit = 0;
+		if (family.empty() || !hz::string_is_numeric_nolocale(hz::string_trim_copy(trimmed.substr(colon_pos + 1)), limit)
+				|| limit < 0) {
+			return std::nullopt;
+		}
+		limits.insert_or_assign(family, static_cast<std::size_t>(limit));
+	}
+	return limits;
+}
+
+
+
+CommandDomainLimits cmdex_get_domain_limits()
+{
+	const auto setting = rconfig::get_data<std::string>("system/controller_max_running_commands");
+	auto limits = cmdex_parse_domain_limits(setting);
+	if (!limits.has_value()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Invalid controller command limits \"" << setting << "\", ignoring.\n");
+		return {};
+	}
+	return limits.value();
+}
+
+
+
+
+/// @}
@@ -0,0 +1,190 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef COMMAND_EXECUTOR_POLICY_H
+#define COMMAND_EXECUTOR_POLICY_H
+
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "hz/fs.h"
+
+
+
+/// Operation a command is executed for, see CommandExecutor::set_operation().
+/// Each operation type has its own execution policy.
+enum class CommandOperation {
+	Other,  ///< Anything else (e.g. enabling SMART)
+	Scan,  ///< Basic data fetch of drive detection
+	Refresh,  ///< Full data fetch
+	SelfTest,  ///< Self-test start, abort and status polls
+};
+
+
+
+/// Scheduling class of a command waiting for a free running command slot, see
+/// CommandExecutor::set_priority() and cmdex_set_max_running_commands().
+/// The waiting commands are started in this order, but waiting promotes them
+/// (see cmdex_get_priority_rank()), so that the less important ones are not starved.
+enum class CommandPriority {
+	Interactive,  ///< Requested by the user (default)
+	SelfTestPoll,  ///< Self-test status polls
+	BackgroundRefresh,  ///< Scheduled refreshes, exporter scrapes
+	Bulk,  ///< Bulk operations, reports, collection runs
+};
+
+
+
+/// I/O scheduling class of the Linux I/O schedulers (see ionice(1))
+enum class CommandIoPriorityClass {
+	Default,  ///< Unchanged (inherited)
+	RealTime,  ///< Real-time
+	BestEffort,  ///< Best-effort
+	Idle,  ///< Idle: only when nobody else needs the disk
+};
+
+
+
+/// Resource controls for the processes of an operation type. The defaults change nothing.
+///
+/// The priorities and the cgroup are applied to the local child process right after it
+/// has been spawned (posix_spawn() cannot do that in the child), so at most its first few
+/// microseconds run with the inherited ones. The commands run on remote hosts are not affected.
+/// The rate limit applies per controller, i.e. per device file (on each remote host separately),
+/// so the drives behind the same RAID controller (-d megaraid,N etc.) share it.
+struct CommandExecutionPolicy {
+	int nice = 0;  ///< Niceness increment of the process, 0 - 19. 0 keeps the inherited niceness.
+	CommandIoPriorityClass io_class = CommandIoPriorityClass::Default;  ///< I/O scheduling class (Linux only)
+	int io_level = 4;  ///< I/O priority within the RealTime and BestEffort classes, 0 (highest) - 7
+	std::string cgroup;  ///< cgroup v2 group (relative to the cgroup2 mount) to move the process into, created if needed. Linux only.
+	std::string cgroup_cpu_max;  ///< If not empty, written to "cpu.max" of the group (e.g. "20000 100000" for 20% of a CPU)
+	std::string cgroup_io_max;  ///< If not empty, written to "io.max" of the group (e.g. "8:0 rbps=10485760 riops=100")
+	double rate_per_sec = 0.;  ///< Maximum sustained number of commands per second per controller, 0 means unlimited
+	int rate_burst = 1;  ///< Number of commands per controller which may be started at once before the rate applies
+
+	/// Comparison
+	bool operator==(const CommandExecutionPolicy& other) const = default;
+};
+
+
+
+/// Get the policy of an operation type from the config
+/// ("system/exec_policy/<scan|refresh|selftest|other>/<setting>" keys).
+[[nodiscard]] CommandExecutionPolicy cmdex_get_execution_policy(CommandOperation operation);
+
+
+/// Get the config key component of an operation type ("scan", "refresh", "selftest", "other")
+[[nodiscard]] std::string_view cmdex_get_operation_name(CommandOperation operation);
+
+
+/// Get the config name of a priority class ("interactive", "selftest_poll", "background_refresh", "bulk")
+[[nodiscard]] std::string_view cmdex_get_priority_name(CommandPriority priority);
+
+
+/// Get the scheduling rank of a command waiting for a slot, lower ranks are started first.
+/// Each \c aging interval of waiting promotes the command by one priority class, so a Bulk command
+/// which waited for 3 intervals ranks like a fresh Interactive one. Zero \c aging disables the promotion.
+[[nodiscard]] std::int64_t cmdex_get_priority_rank(CommandPriority priority,
+		std::chrono::steady_clock::duration waited, std::chrono::steady_clock::duration aging);
+
+
+/// Parse an I/O class name: "" or "default", "realtime", "best-effort", "idle" (case-insensitive)
+[[nodiscard]] std::optional<CommandIoPriorityClass> cmdex_parse_io_priority_class(std::string_view name);
+
+
+/// Apply the process-level parts of \c policy (niceness, I/O priority, cgroup) to a running process.
+/// The failures are reported as warnings only; the command keeps running either way.
+/// \c cgroup_root is the cgroup2 mount point. On non-Linux systems, only the niceness is applied.
+void cmdex_apply_execution_policy(int pid, const CommandExecutionPolicy& policy, const hz::fs::path& cgroup_root);
+
+
+
+/// Token bucket rate limiter of command starts per key (controller). Thread-safe.
+class CommandRateLimiter {
+	public:
+
+		/// Reserve a start for \c key with the given rate and burst. The reservation is made
+		/// immediately, so that the waiting callers start in order.
+		/// \return how long the caller has to wait before starting (zero if it may start right away).
+		[[nodiscard]] std::chrono::steady_clock::duration reserve(const std::string& key, double rate_per_sec, int burst,
+				std::chrono::steady_clock::time_point now);
+
+
+		/// Forget all the keys
+		void clear();
+
+
+	private:
+
+		/// Bucket state of a key
+		struct Bucket {
+			double tokens = 0.;  ///< Available tokens, negative if reserved in advance
+			std::chrono::steady_clock::time_point updated;  ///< Time the tokens were last updated
+		};
+
+		std::mutex mutex_;  ///< Protects buckets_
+		std::map<std::string, Bucket, std::less<>> buckets_;  ///< Key -> bucket
+
+};
+
+
+
+/// Get the process-wide rate limiter of CommandExecutor
+[[nodiscard]] CommandRateLimiter& cmdex_get_rate_limiter();
+
+
+
+/// Get the serialization domain of the commands of a device: the controller its passthrough
+/// commands go through, so that their concurrency can be limited (see cmdex_set_domain_limits()).
+/// The types with ports ("3ware,N", "areca,N/E", "cciss,N", "sat+megaraid,N", ...) map to the
+/// controller device node, e.g. "3ware:/dev/twa0". The devices registered by detection (see
+/// cmdex_set_device_domain()) map to their registered domain, e.g. the SCSI host of their HBA.
+/// \c device_key is the device, prefixed by the remote host (as in the execution statistics).
+/// \return an empty string if the device is independent.
+[[nodiscard]] std::string cmdex_get_serialization_domain(const std::string& device_key, std::string_view type_argument);
+
+
+/// Register the serialization domain of a device found by detection, e.g. "aacraid:host2" for
+/// a drive behind an Adaptec controller. An empty \c domain removes it. Thread-safe.
+void cmdex_set_device_domain(const std::string& device_key, std::string domain);
+
+
+/// Get the family of a serialization domain: the device type or the driver before the colon ("3ware")
+[[nodiscard]] std::string_view cmdex_get_domain_family(std::string_view domain);
+
+
+/// Maximum numbers of simultaneously running commands per serialization domain, by domain family.
+/// The domains of the other families are only subject to the global limit.
+using CommandDomainLimits = std::map<std::string, std::size_t, std::less<>>;
+
+
+/// Parse the domain limits: semicolon-separated "family:limit" pairs, e.g. "3ware:1;areca:1".
+/// \return std::nullopt if invalid.
+[[nodiscard]] std::optional<CommandDomainLimits> cmdex_parse_domain_limits(std::string_view str);
+
+
+/// Get the domain limits from the config ("system/controller_max_running_commands" key).
+/// Invalid settings are reported and ignored.
+[[nodiscard]] CommandDomainLimits cmdex_get_domain_limits();
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,131 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>
+#include <algorithm>  // std::all_of, std::any_of, std::none_of
+#include <cctype>
+
+#include "hz/debug.h"
+#include "hz/fs.h"
+#include "hz/string_algo.h"
+#include "rconfig/rconfig.h"
+
+#include "command_executor_remote.h"
+
+
+
+RemoteHost::RemoteHost(std::string destination, std::string ssh_binary, hz::fs::path control_dir,
+		std::chrono::seconds control_persist, std::string smartctl_binary)
+		: destination_(std::move(destination)),
+		ssh_binary_(std::move(ssh_binary)),
+		control_dir_(std::move(control_dir)),
+		control_persist_(control_persist),
+		smartctl_binary_(std::move(smartctl_binary))
+{ }
+
+
+
+const std::string& RemoteHost::get_destination() const
+{
+	return destination_;
+}
+
+
+
+const std::string& RemoteHost::get_smartctl_binary() const
+{
+	return smartctl_binary_;
+}
+
+
+
+std::pair<std::string, std::vector<std::string>> RemoteHost::wrap_command(
+		const std::string& command, const std::vector<std::string>& args) const
+{
+	// ssh joins its arguments with spaces and passes the result to the remote shell
+	std::string remote_command = remote_host_shell_quote(command);
+	for (const auto& arg : args) {
+		remote_command += " " + remote_host_shell_quote(arg);
+	}
+
+	// %C is a hash of the local host, remote host, port and user, so there's one master per host.
+	const std::string control_path = hz::fs_path_to_string(control_dir_ / "gsc-ssh-%C");
+
+	std::vector<std::string> ssh_args = {
+		"-o", "BatchMode=yes",  // never ask for passwords, we have no terminal
+		"-o", "ControlMaster=auto",
+		"-o", "ControlPath=" + control_path,
+		"-o", "ControlPersist=" + (control_persist_.count() > 0 ? std::to_string(control_persist_.count()) : std::string("no")),
+		"-T",  // no pseudo-terminal
+		"--", destination_,
+		remote_command
+	};
+	return {ssh_binary_, std::move(ssh_args)};
+}
+
+
+
+bool remote_host_is_valid_destination(std::string_view destination)
+{
+	return !destination.empty() && destination.front() != '-'
+			&& std::none_of(destination.begin(), destination.end(),
+					[](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0 || std::iscntrl(static_cast<unsigned char>(c)) != 0; });
+}
+
+
+
+std::string remote_host_shell_quote(const std::string& str)
+{
+	const bool safe = !str.empty() && std::all_of(str.begin(), str.end(), [](char c) {
+		return std::isalnum(static_cast<unsigned char>(c)) != 0 || std::string_view("-_./=:,@%+").find(c) != std::string_view::npos;
+	});
+	if (safe) {
+		return str;
+	}
+	// Inside single quotes everything is literal, except the single quote itself.
+	return "'" + hz::string_replace_copy(str, "'", "'\\''") + "'";
+}
+
+
+
+std::vector<RemoteHostPtr> remote_hosts_get_configured()
+{
+	std::vector<std::string> destinations;
+	hz::string_split(rconfig::get_data<std::string>("system/remote_hosts"), ';', destinations, true);
+
+	const auto ssh_binary = rconfig::get_data<std::string>("system/ssh_binary");
+	const auto control_persist = std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/ssh_control_persist_sec")));
+	const auto smartctl_binary = rconfig::get_data<std::string>("system/remote_smartctl_binary");
+	const hz::fs::path control_dir = hz::fs_path_from_string(Glib::get_user_runtime_dir());
+
+	std::vector<RemoteHostPtr> hosts;
+	for (auto& destination : destinations) {
+		hz::string_trim(destination);
+		if (destination.empty()) {
+			continue;
+		}
+		if (!remote_host_is_valid_destination(destination)) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Invalid remote host \"" << destination << "\", ignoring.\n");
+			continue;
+		}
+		const bool duplicate = std::any_of(hosts.begin(), hosts.end(),
+				[&destination](const RemoteHostPtr& host) { return host->get_destination() == destination; });
+		if (!duplicate) {
+			hosts.push_back(std::make_shared<RemoteHost>(destination, ssh_binary, control_dir, control_persist, smartctl_binary));
+		}
+	}
+	return hosts;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,88 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef COMMAND_EXECUTOR_REMOTE_H
+#define COMMAND_EXECUTOR_REMOTE_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hz/fs_ns.h"
+
+
+
+/// A remote host to execute the commands on, over SSH.
+/// All the commands for the same host share one SSH connection (OpenSSH ControlMaster),
+/// so only the first command of a host pays for the TCP / authentication handshake.
+/// Authentication must not be interactive (e.g. key-based, with an agent).
+class RemoteHost {
+	public:
+
+		/// Constructor. \c destination is an SSH destination ([user@]host), see remote_host_is_valid_destination().
+		/// The commands are wrapped into \c ssh_binary invocations, with the control sockets
+		/// in \c control_dir. The master connection stays open for \c control_persist
+		/// after the last command (0 means it's closed right after it).
+		RemoteHost(std::string destination, std::string ssh_binary, hz::fs::path control_dir,
+				std::chrono::seconds control_persist, std::string smartctl_binary);
+
+
+		/// Get the SSH destination
+		[[nodiscard]] const std::string& get_destination() const;
+
+		/// Get the smartctl binary on the remote host
+		[[nodiscard]] const std::string& get_smartctl_binary() const;
+
+
+		/// Get the ssh command and its arguments which execute \c command with \c args on the host.
+		/// The remote command line is quoted for a POSIX shell.
+		[[nodiscard]] std::pair<std::string, std::vector<std::string>> wrap_command(
+				const std::string& command, const std::vector<std::string>& args) const;
+
+
+	private:
+
+		std::string destination_;  ///< SSH destination
+		std::string ssh_binary_;  ///< Local ssh binary
+		hz::fs::path control_dir_;  ///< Directory of the ControlMaster sockets
+		std::chrono::seconds control_persist_;  ///< How long the master connection stays open after the last command
+		std::string smartctl_binary_;  ///< Remote smartctl binary
+
+};
+
+
+/// A reference-counting pointer to RemoteHost
+using RemoteHostPtr = std::shared_ptr<const RemoteHost>;
+
+
+
+/// Check whether \c destination may be used as an SSH destination. It must be non-empty,
+/// must not start with '-' (so that it's not taken as an option) and must not contain whitespace.
+[[nodiscard]] bool remote_host_is_valid_destination(std::string_view destination);
+
+
+/// Quote \c str for a POSIX shell. Strings consisting of safe characters only are returned as they are.
+[[nodiscard]] std::string remote_host_shell_quote(const std::string& str);
+
+
+/// Get the remote hosts from "system/remote_hosts" config key (semicolon-separated SSH destinations).
+/// Invalid destinations are ignored (with a warning).
+[[nodiscard]] std::vector<RemoteHostPtr> remote_hosts_get_configured();
+
+
+
+
+#endif
+
+/// @}
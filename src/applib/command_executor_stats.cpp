@@ -0,0 +1,305 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "command_executor_stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+#include "fmt/format.h"
+#include "hz/format_unit.h"
+
+
+
+void CommandDurationHistogram::add(std::chrono::microseconds duration)
+{
+	const auto usec = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+	// Index of the highest set bit, 0 for 0 and 1.
+	const auto bucket = std::min<std::size_t>(usec == 0 ? 0 : static_cast<std::size_t>(std::bit_width(usec) - 1), bucket_count - 1);
+	++buckets_[bucket];
+	++count_;
+	total_ += std::chrono::microseconds(usec);
+	max_ = std::max(max_, std::chrono::microseconds(usec));
+}
+
+
+
+std::uint64_t CommandDurationHistogram::get_count() const
+{
+	return count_;
+}
+
+
+
+std::chrono::microseconds CommandDurationHistogram::get_total() const
+{
+	return total_;
+}
+
+
+
+std::chrono::microseconds CommandDurationHistogram::get_max() const
+{
+	return max_;
+}
+
+
+
+std::chrono::microseconds CommandDurationHistogram::get_percentile(double fraction) const
+{
+	if (count_ == 0) {
+		return std::chrono::microseconds(0);
+	}
+	const auto target = static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0., 1.) * static_cast<double>(count_)));
+	std::uint64_t seen = 0;
+	for (std::size_t i = 0; i < bucket_count - 1; ++i) {
+		seen += buckets_[i];
+		if (seen >= std::max<std::uint64_t>(target, 1)) {
+			return std::min(std::chrono::microseconds(std::int64_t(1) << (i + 1)), max_);
+		}
+	}
+	return max_;
+}
+
+
+
+std::uint32_t CommandDurationHistogram::get_bucket(std::size_t index) const
+{
+	return index < bucket_count ? buckets_[index] : 0;
+}
+
+
+
+void CommandExecutionStats::add(const CommandExecutionSample& sample)
+{
+	++executions;
+	if (!sample.spawned) {
+		++failures;
+		return;
+	}
+	if (sample.timed_out) {
+		++timeouts;
+		++consecutive_timeouts;
+	}
+	if (sample.killed) {
+		++kills;
+	}
+	if (!sample.timed_out && !sample.killed) {
+		completed_runtime.add(sample.runtime);
+		consecutive_timeouts = 0;
+	}
+	bytes_out += sample.bytes_out;
+	spawn_latency.add(sample.spawn_latency);
+	if (sample.time_to_first_byte.has_value()) {
+		time_to_first_byte.add(sample.time_to_first_byte.value());
+	}
+	runtime.add(sample.runtime);
+}
+
+
+
+void CommandOutputSizes::add(const CommandExecutionSample& sample)
+{
+	if (!sample.spawned || sample.timed_out || sample.killed) {
+		return;
+	}
+	++executions;
+	last_stdout = sample.bytes_out;
+	max_stdout = std::max(max_stdout, sample.bytes_out);
+	last_stderr = sample.bytes_err;
+	max_stderr = std::max(max_stderr, sample.bytes_err);
+}
+
+
+
+std::uint64_t CommandOutputSizes::get_expected_stdout() const
+{
+	return std::max(last_stdout + last_stdout / 16, max_stdout);
+}
+
+
+
+std::uint64_t CommandOutputSizes::get_expected_stderr() const
+{
+	return std::max(last_stderr + last_stderr / 16, max_stderr);
+}
+
+
+
+namespace {
+
+	/// Global statistics
+	struct CommandExecutionStatsHolder {
+		std::mutex mutex;  ///< Protects stats
+		CommandExecutionStatsSnapshot stats;  ///< Statistics
+	};
+
+
+	/// Get the global statistics holder
+	CommandExecutionStatsHolder& get_stats_holder()
+	{
+		static CommandExecutionStatsHolder holder;
+		return holder;
+	}
+
+
+	/// Format a duration in milliseconds
+	std::string format_stats_duration(std::chrono::microseconds duration)
+	{
+		return fmt::format("{:.1f} ms", static_cast<double>(duration.count()) / 1000.);
+	}
+
+
+	/// Format the statistics of one map
+	void format_stats_map(const std::map<std::string, CommandExecutionStats>& map, std::string& output)
+	{
+		std::vector<std::pair<const std::string*, const CommandExecutionStats*>> sorted;
+		sorted.reserve(map.size());
+		for (const auto& [key, stats] : map) {
+			sorted.emplace_back(&key, &stats);
+		}
+		std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+			return a.second->runtime.get_total() > b.second->runtime.get_total();
+		});
+
+		for (const auto& [key, stats] : sorted) {
+			output += fmt::format("  {}: {} runs", *key, stats->executions);
+			if (stats->failures != 0) {
+				output += fmt::format(" ({} failed)", stats->failures);
+			}
+			if (stats->runtime.get_count() != 0) {
+				output += fmt::format(", runtime p50 {} / p90 {} / max {} (total {})",
+						format_stats_duration(stats->runtime.get_percentile(0.5)),
+						format_stats_duration(stats->runtime.get_percentile(0.9)),
+						format_stats_duration(stats->runtime.get_max()),
+						format_stats_duration(stats->runtime.get_total()));
+				output += fmt::format(", spawn p50 {}", format_stats_duration(stats->spawn_latency.get_percentile(0.5)));
+			}
+			if (stats->time_to_first_byte.get_count() != 0) {
+				output += fmt::format(", first byte p50 {}", format_stats_duration(stats->time_to_first_byte.get_percentile(0.5)));
+			}
+			output += fmt::format(", {} out, {} timeouts, {} kills\n", hz::format_size(stats->bytes_out), stats->timeouts, stats->kills);
+		}
+	}
+
+}
+
+
+
+void cmdex_stats_add_sample(const CommandExecutionSample& sample)
+{
+	auto& holder = get_stats_holder();
+	const std::scoped_lock lock(holder.mutex);
+	if (!sample.device.empty()) {
+		holder.stats.by_device[sample.device].add(sample);
+		holder.stats.by_device_operation[{sample.device, sample.operation}].add(sample);
+	}
+	holder.stats.by_options[sample.options].add(sample);
+	holder.stats.output_sizes[{sample.device, sample.options}].add(sample);
+}
+
+
+
+CommandExecutionStatsSnapshot cmdex_stats_get()
+{
+	auto& holder = get_stats_holder();
+	const std::scoped_lock lock(holder.mutex);
+	return holder.stats;
+}
+
+
+
+std::optional<CommandExecutionStats> cmdex_stats_get_device_operation(const std::string& device, CommandOperation operation)
+{
+	auto& holder = get_stats_holder();
+	const std::scoped_lock lock(holder.mutex);
+	if (auto iter = holder.stats.by_device_operation.find({device, operation}); iter != holder.stats.by_device_operation.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+std::optional<CommandOutputSizes> cmdex_stats_get_output_sizes(const std::string& device, const std::string& options)
+{
+	auto& holder = get_stats_holder();
+	const std::scoped_lock lock(holder.mutex);
+	if (auto iter = holder.stats.output_sizes.find({device, options});
+			iter != holder.stats.output_sizes.end() && iter->second.executions != 0) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+void cmdex_stats_clear()
+{
+	auto& holder = get_stats_holder();
+	const std::scoped_lock lock(holder.mutex);
+	holder.stats = {};
+}
+
+
+
+CommandStopTimeouts cmdex_stats_compute_timeouts(const CommandExecutionStats* stats,
+		const CommandAdaptiveTimeoutSettings& settings)
+{
+	const auto min_timeout = std::max(settings.min_timeout, std::chrono::milliseconds(1));
+	const auto max_timeout = std::max(settings.max_timeout, min_timeout);
+
+	std::chrono::milliseconds term_timeout = max_timeout;
+	if (stats && stats->completed_runtime.get_count() >= std::max<std::uint64_t>(settings.min_samples, 1)) {
+		const auto percentile = stats->completed_runtime.get_percentile(settings.percentile);
+		term_timeout = std::chrono::milliseconds(static_cast<std::int64_t>(
+				std::ceil(static_cast<double>(percentile.count()) * std::max(settings.multiplier, 1.) / 1000.)));
+	}
+	if (stats && ((stats->completed_runtime.get_count() == 0 && stats->timeouts != 0) || stats->consecutive_timeouts >= 2)) {
+		// It doesn't answer, don't wait for it as long as for the others
+		term_timeout = min_timeout;
+	}
+
+	CommandStopTimeouts timeouts;
+	timeouts.term_timeout = std::clamp(term_timeout, min_timeout, max_timeout);
+	timeouts.kill_timeout = timeouts.term_timeout + std::max(settings.kill_delay, std::chrono::milliseconds(1));
+	return timeouts;
+}
+
+
+
+std::string cmdex_stats_format(const CommandExecutionStatsSnapshot& stats)
+{
+	std::string output;
+	if (!stats.by_device.empty()) {
+		output += "By device:\n";
+		format_stats_map(stats.by_device, output);
+	}
+	if (!stats.by_options.empty()) {
+		if (!output.empty()) {
+			output += "\n";
+		}
+		output += "By command options:\n";
+		format_stats_map(stats.by_options, output);
+	}
+	if (output.empty()) {
+		output = "No commands executed.\n";
+	}
+	return output;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,202 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef COMMAND_EXECUTOR_STATS_H
+#define COMMAND_EXECUTOR_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "command_executor_policy.h"
+
+
+
+/// A compact duration histogram with power-of-2 microsecond buckets.
+/// Bucket i holds the durations in [2^i, 2^(i+1)) usec (bucket 0 includes 0),
+/// the last bucket holds everything longer.
+class CommandDurationHistogram {
+	public:
+
+		/// Number of buckets. 2^31 usec is about 36 minutes.
+		static constexpr std::size_t bucket_count = 32;
+
+
+		/// Add a duration
+		void add(std::chrono::microseconds duration);
+
+		/// Get the number of added durations
+		[[nodiscard]] std::uint64_t get_count() const;
+
+		/// Get the sum of all added durations
+		[[nodiscard]] std::chrono::microseconds get_total() const;
+
+		/// Get the longest added duration
+		[[nodiscard]] std::chrono::microseconds get_max() const;
+
+		/// Get the approximate duration below which \c fraction (0 - 1) of the durations are.
+		/// This is the upper bound of the bucket the percentile falls into, capped by get_max().
+		[[nodiscard]] std::chrono::microseconds get_percentile(double fraction) const;
+
+		/// Get the number of durations in a bucket
+		[[nodiscard]] std::uint32_t get_bucket(std::size_t index) const;
+
+
+	private:
+
+		std::array<std::uint32_t, bucket_count> buckets_ = {};  ///< Counts per bucket
+		std::uint64_t count_ = 0;  ///< Number of durations
+		std::chrono::microseconds total_{0};  ///< Sum of durations
+		std::chrono::microseconds max_{0};  ///< Longest duration
+
+};
+
+
+
+/// Measurements of a single command execution
+struct CommandExecutionSample {
+	std::string device;  ///< Device the command was run for, empty if not device-specific
+	std::string options;  ///< Command option set (e.g. smartctl options, without the device)
+	CommandOperation operation = CommandOperation::Other;  ///< Operation the command was executed for
+	bool spawned = true;  ///< False if the command could not be started
+	std::chrono::microseconds spawn_latency{0};  ///< Time spent starting the process
+	std::optional<std::chrono::microseconds> time_to_first_byte;  ///< Time until the first stdout byte, unset if there was no output
+	std::chrono::microseconds runtime{0};  ///< Time until the process exited
+	std::uint64_t bytes_out = 0;  ///< Size of stdout data
+	std::uint64_t bytes_err = 0;  ///< Size of stderr data
+	bool timed_out = false;  ///< A stop timeout expired
+	bool killed = false;  ///< The process was sent a signal to stop it
+};
+
+
+
+/// Aggregated statistics of command executions
+struct CommandExecutionStats {
+	std::uint64_t executions = 0;  ///< Number of executions, including the failed ones
+	std::uint64_t failures = 0;  ///< Number of commands which could not be started
+	std::uint64_t timeouts = 0;  ///< Number of executions with expired stop timeouts
+	std::uint64_t kills = 0;  ///< Number of executions stopped by a signal from us
+	std::uint64_t bytes_out = 0;  ///< Total size of stdout data
+
+	CommandDurationHistogram spawn_latency;  ///< Spawn latency
+	CommandDurationHistogram time_to_first_byte;  ///< Time to first stdout byte (executions with output only)
+	CommandDurationHistogram runtime;  ///< Total runtime
+	CommandDurationHistogram completed_runtime;  ///< Runtime of the executions which were neither timed out nor killed
+	std::uint64_t consecutive_timeouts = 0;  ///< Timed out executions since the last completed one
+
+	/// Add a sample
+	void add(const CommandExecutionSample& sample);
+};
+
+
+
+/// Output sizes of the completed executions of a command (a device and an option set).
+/// The same command on the same device gives nearly the same output each time, so the next
+/// execution can allocate its buffers for it upfront.
+struct CommandOutputSizes {
+	std::uint64_t executions = 0;  ///< Number of completed executions
+	std::uint64_t last_stdout = 0;  ///< stdout size of the last execution
+	std::uint64_t max_stdout = 0;  ///< Largest stdout size
+	std::uint64_t last_stderr = 0;  ///< stderr size of the last execution
+	std::uint64_t max_stderr = 0;  ///< Largest stderr size
+
+	/// Add a sample. The executions which were not started, timed out or killed are ignored,
+	/// since their output is incomplete.
+	void add(const CommandExecutionSample& sample);
+
+	/// Get the expected stdout size of the next execution: the last size with a margin for
+	/// the growing logs, but at least the largest size. 0 if unknown.
+	[[nodiscard]] std::uint64_t get_expected_stdout() const;
+
+	/// Get the expected stderr size of the next execution, see get_expected_stdout()
+	[[nodiscard]] std::uint64_t get_expected_stderr() const;
+};
+
+
+
+/// Command execution statistics, by device and by option set
+struct CommandExecutionStatsSnapshot {
+	std::map<std::string, CommandExecutionStats> by_device;  ///< Device -> stats. Not device-specific commands are not included.
+	std::map<std::string, CommandExecutionStats> by_options;  ///< Option set -> stats
+	std::map<std::pair<std::string, CommandOperation>, CommandExecutionStats> by_device_operation;  ///< Device and operation -> stats
+	std::map<std::pair<std::string, std::string>, CommandOutputSizes> output_sizes;  ///< Device (possibly empty) and option set -> output sizes
+};
+
+
+
+/// Add an execution sample to the global statistics. Thread-safe.
+void cmdex_stats_add_sample(const CommandExecutionSample& sample);
+
+
+/// Get the global statistics collected since program start (or the last clear). Thread-safe.
+[[nodiscard]] CommandExecutionStatsSnapshot cmdex_stats_get();
+
+
+/// Get the global statistics of a device for one operation type (see by_device_operation in
+/// CommandExecutionStatsSnapshot), without copying the rest. Thread-safe.
+/// \return std::nullopt if there were no such executions.
+[[nodiscard]] std::optional<CommandExecutionStats> cmdex_stats_get_device_operation(const std::string& device, CommandOperation operation);
+
+
+/// Get the output sizes of a command (see output_sizes in CommandExecutionStatsSnapshot),
+/// without copying the rest. Thread-safe.
+/// \return std::nullopt if the command never completed.
+[[nodiscard]] std::optional<CommandOutputSizes> cmdex_stats_get_output_sizes(const std::string& device, const std::string& options);
+
+
+/// Clear the global statistics. Thread-safe.
+void cmdex_stats_clear();
+
+
+/// Parameters of the adaptive stop timeouts, see cmdex_stats_compute_timeouts()
+struct CommandAdaptiveTimeoutSettings {
+	double percentile = 0.99;  ///< Runtime percentile of the completed executions the timeout is based on
+	double multiplier = 4.;  ///< The timeout is the percentile multiplied by this
+	std::uint64_t min_samples = 3;  ///< Minimum number of completed executions for the percentile to be used
+	std::chrono::milliseconds min_timeout = std::chrono::seconds(30);  ///< Lower bound (above the spin-up time), also used for dead ports
+	std::chrono::milliseconds max_timeout = std::chrono::minutes(5);  ///< Upper bound, also used without enough samples
+	std::chrono::milliseconds kill_delay = std::chrono::seconds(3);  ///< Time between SIGTERM and SIGKILL
+};
+
+
+/// Stop timeouts of a command, since its start (see CommandExecutor::set_stop_timeouts())
+struct CommandStopTimeouts {
+	std::chrono::milliseconds term_timeout{0};  ///< Send SIGTERM after this
+	std::chrono::milliseconds kill_timeout{0};  ///< Send SIGKILL after this, larger than term_timeout
+};
+
+
+/// Compute the stop timeouts of a command from the statistics of the same device and operation (may be nullptr):
+/// - With at least \c min_samples completed executions, their runtime percentile times \c multiplier.
+/// - If the command never completed for this device and timed out before, or the last two executions
+///   timed out (a dead port), \c min_timeout.
+/// - Otherwise (not enough data), \c max_timeout.
+/// The result is clamped to [min_timeout, max_timeout].
+[[nodiscard]] CommandStopTimeouts cmdex_stats_compute_timeouts(const CommandExecutionStats* stats,
+		const CommandAdaptiveTimeoutSettings& settings);
+
+
+
+/// Format the statistics as human-readable text, one line per device / option set,
+/// slowest (by total runtime) first.
+[[nodiscard]] std::string cmdex_stats_format(const CommandExecutionStatsSnapshot& stats);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,95 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_examples
+/// \weakgroup applib_examples
+/// @{
+
+/*
+Runs many commands concurrently in one thread with app_co_execute(), without
+nested main loops. Each task executes a command, waits a bit, and executes it
+again. The running command limit makes the tasks queue for the command slots.
+
+Usage: example_command_coroutines [tasks]
+*/
+
+#include <glib.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "hz/main_tools.h"
+#include "hz/string_num.h"
+#include "applib/app_coroutine.h"
+
+
+
+namespace {
+
+	/// Execute a command twice, with a pause in between.
+	/// \return The total output size, or -1 if the command couldn't be executed.
+	AppTask<int> run_task(int index)
+	{
+		CommandExecutor ex("/bin/sh", {"-c", "sleep 0.1; echo task " + std::to_string(index)});
+		int output_size = 0;
+		for (int i = 0; i < 2; ++i) {
+			if (i > 0) {
+				co_await app_co_sleep(std::chrono::milliseconds(50));
+			}
+			if (!co_await app_co_execute(ex)) {
+				co_return -1;
+			}
+			output_size += static_cast<int>(ex.get_stdout_buffer()->size());
+		}
+		co_return output_size;
+	}
+
+}
+
+
+
+/// Main function of the example
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([argc, argv]()
+	{
+		int num_tasks = 100;
+		if (argc > 1) {
+			num_tasks = hz::string_to_number_nolocale<int>(argv[1]);
+		}
+
+		cmdex_set_max_running_commands(16);
+
+		const auto start_time = std::chrono::steady_clock::now();
+		int finished = 0, failed = 0;
+		for (int i = 0; i < num_tasks; ++i) {
+			app_task_start(run_task(i), [&finished, &failed](int output_size) {
+				++finished;
+				failed += static_cast<int>(output_size < 0);
+			});
+		}
+
+		// All the tasks are resumed from here
+		while (finished < num_tasks) {
+			g_main_context_iteration(nullptr, TRUE);
+		}
+
+		const auto msec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+		const CommandExecutorQueueStats stats = cmdex_get_queue_stats();
+		std::cout << num_tasks << " tasks finished in " << msec << " ms, " << failed << " failed, "
+				<< stats.max_queued << " commands queued at most.\n";
+
+		return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+
+/// @}
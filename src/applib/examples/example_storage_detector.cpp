@@ -35,7 +35,7 @@ int main()
 	// 	sd.add_match_patterns(match_patterns);
 		sd.add_blacklist_patterns(blacklist_patterns);
 
-		auto ex_factory = std::make_shared<CommandExecutorFactory>(false);
+		auto ex_factory = std::make_shared<CommandExecutorFactory>();
 		auto fetch_error = sd.detect_and_fetch_basic_data(drives, ex_factory);
 		if (!fetch_error) {
 			std::cerr << fetch_error.error().message() << "\n";
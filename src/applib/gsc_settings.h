@@ -45,15 +45,110 @@ inline void init_default_settings()
 	rconfig::set_default_data("system/win32_areca_enc_max_scan_port", 36);  // 1-128 (areca with enclosures). The last RAID port to scan if no other method is available
 	rconfig::set_default_data("system/win32_areca_enc_max_enclosure", 3);  // 1-8 (areca with enclosures). The last RAID enclosure to scan if no other method is available
 	rconfig::set_default_data("system/win32_areca_neonc_max_scan_port", 24);  // 1-24 (areca without enclosures). The last RAID port to scan if no other method is available
+	rconfig::set_default_data("system/win32_max_parallel_detectors", 3);  // number of windows detection backends (--scan-open and PhysicalDriveN, 3ware, Areca) to run simultaneously. 1 disables parallel detection.
 
 	rconfig::set_default_data("system/smartctl_options", "");  // default options on ALL commands
+	rconfig::set_default_data("system/smartctl_version_cache", rconfig::json::object());  // "smartctl -V" result of the binary last used (with its mtime and size), maintained automatically.
 	rconfig::set_default_data("system/smartctl_device_options", "");  // dev1:val1;dev2:val2;... format, each bin2ascii-encoded.
+	rconfig::set_default_data("system/smartctl_max_parallel_fetches", 1);  // number of drives to query simultaneously when scanning. 1 disables parallel queries.
+	rconfig::set_default_data("system/smartctl_max_log_entries", 0);  // maximum number of error log / self-test log entries to parse into properties (the most recent ones). 0 means all.
+	rconfig::set_default_data("system/smartctl_json_embed_text_output", false);  // fetch the JSON data with --json=o, embedding the text output. It doubles the data size; otherwise the text is fetched when it's viewed or saved.
+	rconfig::set_default_data("system/adaptive_timeouts_enabled", false);  // stop the device commands which take much longer than they usually do for the same device (learned from the execution statistics), or which timed out before. The full fetches which may wake the drive up are never stopped.
+	rconfig::set_default_data("system/adaptive_timeout_min_msec", 30000);  // lower bound of the adaptive timeouts, also used for the ports which never answered. Keep it above the spin-up time of the drives.
+	rconfig::set_default_data("system/adaptive_timeout_max_sec", 300);  // upper bound of the adaptive timeouts, also used for the devices without enough statistics
+	rconfig::set_default_data("system/adaptive_timeout_multiplier", 4.);  // adaptive timeout = the 99th percentile of the device's runtimes times this
+	rconfig::set_default_data("system/scan_timeout_sec", 0);  // stop the drive scan after this long, keeping the drives found so far. 0 means no limit.
+	rconfig::set_default_data("system/inventory_file", "");  // query the drives listed in this inventory file (see storage_inventory.h) on startup, without scanning for them. Empty means scan.
+	rconfig::set_default_data("system/inventory_reconcile", false);  // after loading the inventory drives, scan for drives in the background, adding the ones missing from the inventory and reporting the inventory drives not found.
+	rconfig::set_default_data("system/fetch_slow_threshold_msec", 2000);  // drives whose basic data fetch took longer than this the previous times are started first, on all but one of the parallel fetch threads.
+	rconfig::set_default_data("system/fetch_latencies", rconfig::json::object());  // drive ID (or device, if unknown) -> recent basic data fetch latency (msec), maintained automatically.
+	rconfig::set_default_data("system/device_type_cache", rconfig::json::object());  // drive -> "-d" type which worked when smartctl needed one, maintained automatically.
+	rconfig::set_default_data("system/drive_identities", rconfig::json::object());  // drive identity (WWN, model and serial number) -> stable drive ID and its last location, maintained automatically.
+	rconfig::set_default_data("system/nvme_controller_data_ttl_sec", 30);  // the other namespaces of an NVMe controller fetched within this long after one of them reuse its health information and logs, fetching only the namespace information. 0 disables.
+	rconfig::set_default_data("system/collect_max_parallel_fetches", 4);  // number of drives to query simultaneously in gsmartcontrol-collect (see --jobs).
+	// Execution policies of the smartctl commands per operation type (see CommandExecutionPolicy). The defaults change nothing.
+	for (const char* operation : {"scan", "refresh", "selftest", "other"}) {
+		const std::string prefix = std::string("system/exec_policy/") + operation + "/";
+		rconfig::set_default_data(prefix + "nice", 0);  // niceness increment, 0 - 19.
+		rconfig::set_default_data(prefix + "io_class", "");  // I/O class (Linux): "", "realtime", "best-effort" or "idle".
+		rconfig::set_default_data(prefix + "io_level", 4);  // I/O priority in the realtime and best-effort classes, 0 (highest) - 7.
+		rconfig::set_default_data(prefix + "cgroup", "");  // cgroup v2 group (Linux), relative to system/linux_cgroup_path. Empty to disable.
+		rconfig::set_default_data(prefix + "cgroup_cpu_max", "");  // "cpu.max" of the group, e.g. "20000 100000". Empty to leave as is.
+		rconfig::set_default_data(prefix + "cgroup_io_max", "");  // "io.max" of the group, e.g. "8:0 riops=100". Empty to leave as is.
+		rconfig::set_default_data(prefix + "rate_per_sec", 0.);  // maximum commands per second per controller (device file). 0 means unlimited.
+		rconfig::set_default_data(prefix + "rate_burst", 1);  // commands per controller allowed at once before the rate applies.
+	}
+	rconfig::set_default_data("system/linux_cgroup_path", "/sys/fs/cgroup");  // cgroup2 mount point.
+
+	rconfig::set_default_data("system/exporter_refresh_interval_sec", 300);  // how often gsmartcontrol-exporter refreshes each drive's data (see --refresh-interval).
+	rconfig::set_default_data("system/exporter_max_data_age_sec", 900);  // gsmartcontrol-exporter doesn't export drive data older than this (see --max-age).
+	rconfig::set_default_data("system/exporter_standby_aware", false);  // don't spin up the drives in standby mode in gsmartcontrol-exporter (see --standby-aware). Their last data is exported until it's too old.
+	rconfig::set_default_data("system/exporter_fetch_profile", "monitoring");  // "full" or "monitoring". What gsmartcontrol-exporter retrieves from each drive. The metrics need monitoring only.
+	rconfig::set_default_data("system/exporter_ioctl_poll", false);  // between smartctl fetches, refresh the health, attributes and temperature of local Linux ATA / NVMe drives with ioctls in gsmartcontrol-exporter. Needs root.
+	rconfig::set_default_data("system/exporter_full_refresh_interval_sec", 3600);  // with exporter_ioctl_poll, how often gsmartcontrol-exporter still runs smartctl to refresh everything.
+	rconfig::set_default_data("system/exporter_risk_rank_count", 10);  // gsmartcontrol-exporter exports the rank of this many most at-risk drives (the ones with non-zero risk scores).
+	rconfig::set_default_data("system/alert_rules", "warning_alert;reallocated_increase;selftest_failure");  // semicolon-separated alert rules gsmartcontrol-exporter evaluates on each drive's property changes (see StorageAlertRule).
+	rconfig::set_default_data("system/alert_rule_debounce_sec", 3600);  // don't repeat an alert of the same rule on the same drive sooner than this.
+	rconfig::set_default_data("system/alert_drive_debounce_sec", 300);  // don't send alerts of any rule on the same drive sooner than this after the previous one.
+	rconfig::set_default_data("system/alert_batch_interval_sec", 60);  // hold the alerts for this long so that they are delivered together. 0 delivers them right away.
+	rconfig::set_default_data("system/alert_max_batch_size", 100);  // deliver the held alerts right away when there are this many. 0 means unlimited.
+	rconfig::set_default_data("system/alert_exec_hook", "");  // command to run for each batch of alerts, with the JSON batch as its last argument. Empty to disable.
+	rconfig::set_default_data("system/alert_webhook_url", "");  // URL to POST each batch of alerts to (as JSON, using curl). Empty to disable.
+	rconfig::set_default_data("system/alert_syslog", false);  // log the alerts to syslog.
+	rconfig::set_default_data("system/curl_binary", "curl");  // used for the alert webhooks and the history uploads. Must be in PATH or use absolute path.
+	rconfig::set_default_data("system/agent_refresh_interval_sec", 60);  // how often gsmartcontrol-agent refreshes the drives' data (see --refresh-interval).
+	rconfig::set_default_data("system/agent_snapshot_interval", 60);  // gsmartcontrol-agent re-sends a full snapshot of a drive after this many deltas. 0 sends it only once.
+	rconfig::set_default_data("system/agent_fetch_profile", "monitoring");  // "full" or "monitoring". What gsmartcontrol-agent retrieves from each drive.
+	rconfig::set_default_data("system/agent_dbus_bus", "system");  // "system" or "session". The bus "gsmartcontrol-agent --dbus" publishes the drive data on.
+	rconfig::set_default_data("system/use_privileged_helper", true);  // when not running as root, run smartctl through "gsmartcontrol-agent --dbus" and start with its cached drive data (Unix only).
+	rconfig::set_default_data("system/fleet_selftest_max_running", 0);  // maximum number of self-tests run at the same time by gsmartcontrol-selftest. 0 means unlimited.
+	rconfig::set_default_data("system/fleet_selftest_max_per_controller", 2);  // maximum number of self-tests on the same HBA / RAID controller. 0 means unlimited.
+	rconfig::set_default_data("system/fleet_selftest_max_per_enclosure", 4);  // maximum number of self-tests in the same enclosure (SAS expander). 0 means unlimited.
+	rconfig::set_default_data("system/fleet_selftest_max_parallel_commands", 4);  // number of drives gsmartcontrol-selftest starts / polls simultaneously.
+	rconfig::set_default_data("system/max_running_commands", 8);  // maximum number of smartctl (and other) commands running at the same time, in all threads. 0 means unlimited.
+	rconfig::set_default_data("system/controller_max_running_commands", "3ware:1;areca:1;cciss:1");  // maximum number of smartctl commands running at the same time on each controller, by "-d" type or driver ("aacraid"), semicolon-separated. The other controllers and the plain drives are unlimited.
+	rconfig::set_default_data("system/worker_threads", 0);  // number of the worker pool threads (detection, fetching, property processing, virtual drive loading). 0 means the number of CPU cores, but at least 8. Applied on startup.
+	rconfig::set_default_data("system/command_priority_aging_sec", 10);  // a command waiting for a free slot this long is promoted to the next more important priority class (bulk, background refresh, self-test poll, interactive). 0 disables it.
+	rconfig::set_default_data("system/smart_history_enabled", true);  // record the raw SMART values of each full data fetch for trends (see StorageHistory).
+	rconfig::set_default_data("system/smartd_attrlog_prefix", "/var/lib/smartmontools/attrlog.");  // the "-A" prefix of smartd. The new lines of its attribute logs are imported into the SMART history after each scan. Empty to disable.
+	rconfig::set_default_data("system/history_sink_url", "");  // URL to POST the new SMART history samples to (compressed columnar chunks, using curl, see StorageHistorySink). Empty to disable.
+	rconfig::set_default_data("system/history_sink_spool_dir", "");  // chunks waiting for upload are kept here. Empty means "history_spool" in the config directory.
+	rconfig::set_default_data("system/history_sink_max_chunk_points", 10000);  // a history chunk is uploaded when it has this many samples...
+	rconfig::set_default_data("system/history_sink_max_chunk_interval_sec", 3600);  // ...or when its first sample is this old.
+	rconfig::set_default_data("system/history_sink_max_upload_rate", 16384);  // average history upload rate limit, bytes per second. 0 means unlimited.
+	rconfig::set_default_data("system/history_sink_max_spool_size_mb", 64);  // the oldest history chunks are dropped when the collector is unreachable for long. 0 means unlimited.
+	rconfig::set_default_data("system/warning_rules_file", "");  // JSON file with additional warning rules (site-specific thresholds, see StorageWarningRules). Empty means built-in rules only.
+
+	rconfig::set_default_data("system/remote_hosts", "");  // semicolon-separated SSH destinations ([user@]host) whose drives are detected and queried over SSH. Non-interactive authentication is required.
+	rconfig::set_default_data("system/remote_smartctl_binary", "smartctl");  // smartctl binary on the remote hosts.
+	rconfig::set_default_data("system/remote_max_parallel_hosts", 8);  // number of remote hosts to detect the drives on simultaneously.
+	rconfig::set_default_data("system/remote_agent_binary", "gsmartcontrol-agent");  // gsmartcontrol-agent binary on the remote hosts, run over SSH by the fleet view.
+	rconfig::set_default_data("system/ssh_binary", "ssh");  // OpenSSH client. Must be in PATH or use absolute path.
+	rconfig::set_default_data("system/ssh_control_persist_sec", 600);  // how long the shared SSH connection to a remote host stays open after its last command. 0 closes it right away.
+
+	rconfig::set_default_data("system/raid_scan_max_parallel_probes", 1);  // number of RAID controller ports to probe simultaneously. Some controllers can't handle more than 1.
+	rconfig::set_default_data("system/raid_scan_max_empty_ports", 0);  // stop a brute-force RAID port scan after this many empty ports in a row. 0 disables.
+	rconfig::set_default_data("system/raid_port_map_sweep_interval_sec", 86400);  // rescans probe only the RAID ports which held drives before, sweeping all the ports at most this often (or when a drive is gone). 0 always sweeps.
+	rconfig::set_default_data("system/raid_port_map", rconfig::json::object());  // populated RAID ports of each controller, maintained automatically.
+	rconfig::set_default_data("system/raid_cli_inventory_ttl_sec", 30);  // reuse the drive lists reported by the RAID vendor CLI tools (tw_cli, Areca CLI) for this long
 
 	rconfig::set_default_data("system/linux_udev_byid_path", "/dev/disk/by-id");  // linux hard disk device links here
 	rconfig::set_default_data("system/linux_proc_partitions_path", "/proc/partitions");  // file in linux /proc/partitions format
 	rconfig::set_default_data("system/linux_proc_devices_path", "/proc/devices");  // file in linux /proc/devices format
 	rconfig::set_default_data("system/linux_proc_scsi_scsi_path", "/proc/scsi/scsi");  // file in linux /proc/scsi/scsi format
 	rconfig::set_default_data("system/linux_proc_scsi_sg_devices_path", "/proc/scsi/sg/devices");  // file in linux /proc/scsi/sg/devices format
+	rconfig::set_default_data("system/linux_sysfs_path", "/sys");  // linux sysfs mount point
+	rconfig::set_default_data("system/linux_proc_diskstats_path", "/proc/diskstats");  // file in linux /proc/diskstats format
+	rconfig::set_default_data("system/io_load_guard_enabled", false);  // delay the scans and the scheduled refreshes of the drives busy with I/O (Linux only, see /proc/diskstats).
+	rconfig::set_default_data("system/io_load_max_queue_depth", 4.);  // a drive is busy if more I/Os than this are in flight. 0 disables the check.
+	rconfig::set_default_data("system/io_load_max_latency_msec", 50.);  // a drive is busy if its average I/O latency is higher than this. 0 disables the check.
+	rconfig::set_default_data("system/io_load_scan_max_wait_sec", 30);  // how long a scan waits for a busy drive before querying it anyway.
+	rconfig::set_default_data("system/io_load_refresh_max_defer_sec", 600);  // how long a scheduled refresh of a busy drive may be deferred.
+	rconfig::set_default_data("system/use_scan_open_detection", true);  // detect the drives with a single "smartctl --scan-open" (Linux and other non-Windows systems), probing each device only if it fails.
+	rconfig::set_default_data("system/scan_fetch_full_data", false);  // fetch the full data of each drive during the scan with a single smartctl run, instead of only the basic data (the full data is fetched separately when needed).
+	rconfig::set_default_data("system/scan_identity_probe", true);  // during the scan, fetch the identity of all the drives first (smartctl -i), so that they're shown sooner, and their health and capabilities at a lower priority afterwards. Not used with system/scan_fetch_full_data.
+	rconfig::set_default_data("system/linux_detection_backend", "auto");  // "sysfs", "proc", or "auto" (sysfs if available)
+	rconfig::set_default_data("system/linux_max_parallel_detectors", 1);  // number of linux detection backends (partitions, 3ware, areca, ...) to run simultaneously. 1 disables parallel detection.
 	rconfig::set_default_data("system/linux_3ware_max_scan_port", 23);  // 0-127 (3ware). The last RAID port to scan if no other method is available
 	rconfig::set_default_data("system/linux_areca_enc_max_scan_port", 36);  // 1-128 (areca with enclosures). The last RAID port to scan if no other method is available
 	rconfig::set_default_data("system/linux_areca_enc_max_enclosure", 4);  // 1-8 (areca with enclosures). The last RAID enclosure to scan if no other method is available
@@ -64,14 +159,37 @@ inline void init_default_settings()
 	rconfig::set_default_data("system/device_blacklist_patterns", "");  // semicolon-separated Regex patterns
 
 	rconfig::set_default_data("gui/drive_data_open_save_dir", "");
+	rconfig::set_default_data("gui/virtual_import_page_size", 100);  // number of virtual devices shown at once after loading a directory or a tar archive of smartctl outputs.
+	rconfig::set_default_data("gui/fleet_page_size", 200);  // number of drives shown at once in the fleet view.
 
 	rconfig::set_default_data("gui/show_smart_capable_only", false);  // show smart-capable drives only
 	rconfig::set_default_data("gui/scan_on_startup", true);  // scan drives on startup
+	rconfig::set_default_data("gui/use_drive_cache", true);  // show the drives from the previous run while scanning on startup
+	rconfig::set_default_data("gui/hotplug_rescan", true);  // add / remove drives on hotplug events (Linux only)
+	rconfig::set_default_data("gui/watch_output_directory", "");  // show the smartctl outputs in this directory (e.g. written by a cron job, see contrib/cron-based_noadmin) as virtual drives, re-parsing each one when it's rewritten (Linux only). Empty means disabled.
+	rconfig::set_default_data("gui/auto_refresh_info_windows", false);  // periodically re-read the data of the drives with open info windows
+	rconfig::set_default_data("gui/auto_refresh_icons", false);  // periodically re-read the data of all the SMART-enabled drives in the main window
+	rconfig::set_default_data("gui/auto_refresh_min_interval_sec", 60);  // refresh interval of the changing drives (temperature, reallocated / pending sectors)
+	rconfig::set_default_data("gui/auto_refresh_max_interval_sec", 1800);  // the interval doubles up to this while the drive stays the same
+	rconfig::set_default_data("gui/auto_refresh_max_parallel", 1);  // number of drives to refresh simultaneously. 0 means unlimited.
+	rconfig::set_default_data("gui/bulk_operations_max_parallel", 4);  // number of selected drives the bulk operations (enable SMART, re-read, save outputs) run on simultaneously.
+	rconfig::set_default_data("gui/auto_refresh_standby_aware", false);  // don't spin up the drives in standby mode for periodic refreshes (smartctl -n standby). Their last data is shown until they wake up.
+	rconfig::set_default_data("gui/drive_data_memory_budget_mib", 256);  // when the data of the drives in the main window takes more memory than this, the least recently viewed ones are compacted (compressed output, warnings-only properties) until it fits. 0 means unlimited.
+	rconfig::set_default_data("gui/prefetch_full_data", true);  // fetch the full data of the selected / hovered drive and of the drives with health warnings in the background, so that their info windows open at once
+	rconfig::set_default_data("gui/prefetch_delay_msec", 500);  // a drive must stay selected or hovered this long to be prefetched
+	rconfig::set_default_data("gui/prefetch_max_age_sec", 60);  // the info window shows the (pre)fetched full data if it's not older than this, instead of fetching it again
+	rconfig::set_default_data("gui/hwmon_temperature_interval_sec", 10);  // sample the drive temperatures through the kernel hwmon interface (drivetemp, nvme) this often, without smartctl. 0 disables it. Linux only.
+	rconfig::set_default_data("gui/selective_selftest_radius_mib", 512);  // selective self-test of error areas tests this much before and after each LBA recorded in the error / self-test logs
+	rconfig::set_default_data("gui/io_performance_interval_msec", 2000);  // /proc/diskstats sampling interval of the I/O performance tabs and icons. 0 disables them. Linux only.
+	rconfig::set_default_data("gui/main_loop_stall_threshold_msec", 0);  // record the main loop stalls longer than this, with the active trace span, in the debug log and the diagnostics window. 0 disables it, unless --trace-file is given (then 50 is used).
+	rconfig::set_default_data("gui/change_notification_interval_msec", 0);  // deliver the drive changes to the icons and windows at most this often, so that a burst of them (bulk operations, parallel refreshes) is redrawn once. 0 means once per main loop iteration.
 
 	rconfig::set_default_data("gui/smartctl_output_filename_format", "{model}_{serial}_{date}.json");  // when suggesting filename
 
 	rconfig::set_default_data("gui/icons_show_device_name", false);  // text under icons
 	rconfig::set_default_data("gui/icons_show_serial_number", false);  // text under icons
+	rconfig::set_default_data("gui/icons_show_io_performance", false);  // text under icons: current IOPS and I/O latency (see gui/io_performance_interval_msec)
+	rconfig::set_default_data("gui/icons_grouping", "none");  // group the icons: "none", "controller", "host"
 
 	rconfig::set_default_data("gui/main_window/default_size_w", 0);
 	rconfig::set_default_data("gui/main_window/default_size_h", 0);
@@ -80,6 +198,10 @@ inline void init_default_settings()
 
 	rconfig::set_default_data("gui/info_window/default_size_w", 0);
 	rconfig::set_default_data("gui/info_window/default_size_h", 0);
+	rconfig::set_default_data("gui/info_window/pool_size", 2);  // number of closed info windows kept for reuse (0 disables reuse)
+
+	rconfig::set_default_data("gui/executor_log/max_size_kb", 32768);  // memory limit of the execution log; the oldest entries are dropped. 0 means unlimited.
+	rconfig::set_default_data("gui/executor_log/compress", true);  // compress the output of older execution log entries
 }
 
 
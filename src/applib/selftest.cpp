@@ -28,13 +28,170 @@ Copyright:
 #include "storage_device_detected_type.h"
 #include "storage_property.h"
 #include "smartctl_text_ata_parser.h"
+#include "smartctl_json_ata_parser.h"
+#include "smartctl_json_nvme_parser.h"
+#include "smartctl_json_parser_helpers.h"
 #include "selftest.h"
-#include "storage_property_descr.h"
 #include "smartctl_version_parser.h"
 #include "app_regex.h"
 
 
 
+namespace {
+
+	/// Self-test status, as reported by a status poll
+	struct SelfTestPollResult {
+		SelfTestStatus status = SelfTestStatus::Unknown;  ///< Status
+		std::optional<int8_t> remaining_percent;  ///< Remaining percent (if in progress). std::nullopt if not reported.
+	};
+
+
+	/// Convert ATA self-test status to SelfTestStatus
+	SelfTestStatus get_self_test_status_from_ata(AtaStorageSelftestEntry::Status status)
+	{
+		switch (status) {
+			case AtaStorageSelftestEntry::Status::InProgress:
+				return SelfTestStatus::InProgress;
+			case AtaStorageSelftestEntry::Status::Unknown:
+				return SelfTestStatus::Unknown;
+			case AtaStorageSelftestEntry::Status::Reserved:
+				return SelfTestStatus::Reserved;
+			case AtaStorageSelftestEntry::Status::CompletedNoError:
+				return SelfTestStatus::CompletedNoError;
+			case AtaStorageSelftestEntry::Status::AbortedByHost:
+				return SelfTestStatus::ManuallyAborted;
+			case AtaStorageSelftestEntry::Status::Interrupted:
+				return SelfTestStatus::Interrupted;
+			case AtaStorageSelftestEntry::Status::FatalOrUnknown:
+			case AtaStorageSelftestEntry::Status::ComplUnknownFailure:
+			case AtaStorageSelftestEntry::Status::ComplElectricalFailure:
+			case AtaStorageSelftestEntry::Status::ComplServoFailure:
+			case AtaStorageSelftestEntry::Status::ComplReadFailure:
+			case AtaStorageSelftestEntry::Status::ComplHandlingDamage:
+				return SelfTestStatus::CompletedWithError;
+		}
+		return SelfTestStatus::Unknown;
+	}
+
+
+	/// Convert the NVMe result of a finished self-test to SelfTestStatus
+	SelfTestStatus get_self_test_status_from_nvme(NvmeSelfTestResultType result)
+	{
+		switch (result) {
+			case NvmeSelfTestResultType::Unknown:
+				return SelfTestStatus::Unknown;
+			case NvmeSelfTestResultType::CompletedNoError:
+				return SelfTestStatus::CompletedNoError;
+			case NvmeSelfTestResultType::AbortedSelfTestCommand:
+				return SelfTestStatus::ManuallyAborted;
+			case NvmeSelfTestResultType::AbortedControllerReset:
+			case NvmeSelfTestResultType::AbortedNamespaceRemoved:
+			case NvmeSelfTestResultType::AbortedFormatNvmCommand:
+			case NvmeSelfTestResultType::AbortedUnknownReason:
+			case NvmeSelfTestResultType::AbortedSanitizeOperation:
+				return SelfTestStatus::Interrupted;
+			case NvmeSelfTestResultType::FatalOrUnknownTestError:
+			case NvmeSelfTestResultType::CompletedUnknownFailedSegment:
+			case NvmeSelfTestResultType::CompletedFailedSegments:
+				return SelfTestStatus::CompletedWithError;
+		}
+		return SelfTestStatus::Unknown;
+	}
+
+
+	/// Get the test status from JSON output. Only the status fields are read; no properties
+	/// are created, and no descriptions or warnings are generated, so this is cheap enough
+	/// to be called often for many drives.
+	hz::ExpectedValue<SelfTestPollResult, SelfTestExecutionError> get_poll_result_from_json(std::string_view output, bool nvme)
+	{
+		using namespace SmartctlJsonParserHelpers;
+
+		auto parsed_json = parse_json_document(output, false);
+		if (!parsed_json) {
+			return hz::Unexpected(SelfTestExecutionError::ParseError,
+					fmt::format(fmt::runtime(_("Cannot parse smartctl output: {}")), parsed_json.error().message()));
+		}
+		const nlohmann::json& json_root_node = parsed_json.value();
+
+		SelfTestPollResult result;
+
+		if (nvme) {
+			// If no test is active, the operation may be absent, or set to None.
+			auto operation_val = get_node_data_optional<uint8_t>(json_root_node, "nvme_self_test_log/current_self_test_operation/value");
+			if (operation_val.has_value()
+					&& SmartctlJsonNvmeParser::decode_self_test_operation(operation_val.value()) != NvmeSelfTestCurrentOperationType::None) {
+				result.status = SelfTestStatus::InProgress;
+				if (auto completion_val = get_node_data_optional<uint8_t>(json_root_node, "nvme_self_test_log/current_self_test_completion_percent");
+						completion_val.has_value()) {
+					result.remaining_percent = static_cast<int8_t>(100 - completion_val.value());
+				}
+				return result;
+			}
+
+			// No test is active. The first self-test table entry is the latest.
+			auto table_node = get_node(json_root_node, "nvme_self_test_log/table");
+			if (!table_node.has_value() || !table_node.value()->is_array() || table_node.value()->empty()) {
+				return hz::Unexpected(SelfTestExecutionError::ReportUnsupported, _("The drive doesn't report the test status."));
+			}
+			const auto& latest = table_node.value()->front();
+			result.status = get_self_test_status_from_nvme((find_node(latest, "self_test_result/value") != nullptr)
+					? SmartctlJsonNvmeParser::decode_self_test_result(get_node_data_optional<int32_t>(latest, "self_test_result/value").value_or(-1))
+					: NvmeSelfTestResultType::Unknown);
+			return result;
+		}
+
+		// ATA:
+		// Note: Since the self-test log is sometimes late
+		// and in undetermined order (sorting by hours is too rough),
+		// we use the "self-test status" capability.
+		auto sse = SmartctlJsonAtaParser::parse_selftest_status(json_root_node);
+		if (!sse.has_value()) {
+			return hz::Unexpected(SelfTestExecutionError::ReportUnsupported, _("The drive doesn't report the test status."));
+		}
+		result.status = get_self_test_status_from_ata(sse->status);
+		result.remaining_percent = sse->remaining_percent;
+		return result;
+	}
+
+
+	/// Get the test status from text output (old smartctl versions). This uses the full parser,
+	/// but skips the property processing (descriptions, warnings).
+	hz::ExpectedValue<SelfTestPollResult, SelfTestExecutionError> get_poll_result_from_text(std::string_view output, bool nvme)
+	{
+		std::shared_ptr<SmartctlParser> parser = SmartctlParser::create(
+				nvme ? SmartctlParserType::Nvme : SmartctlParserType::Ata, SmartctlOutputFormat::Text);
+		DBG_ASSERT_RETURN(parser, hz::Unexpected(SelfTestExecutionError::ParseError, _("Cannot create parser.")));
+
+		auto parse_status = parser->parse(output);
+		if (!parse_status) {
+			return hz::Unexpected(SelfTestExecutionError::ParseError,
+					fmt::format(fmt::runtime(_("Cannot parse smartctl output: {}")), parse_status.error().message()));
+		}
+		const auto& property_repo = parser->get_property_repository();
+
+		// Only ATA has a text parser. Note: Since the self-test log is sometimes late
+		// and in undetermined order (sorting by hours is too rough), we use the "self-test status" capability.
+		const StorageProperty* p = nullptr;
+		for (const auto& e : property_repo.get_properties()) {
+			if (e.is_value_type<AtaStorageSelftestEntry>() && e.get_value<AtaStorageSelftestEntry>().test_num == 0
+					&& e.generic_name == "ata_smart_data/self_test/status/_merged") {
+				p = &e;
+			}
+		}
+		if (!p) {
+			return hz::Unexpected(SelfTestExecutionError::ReportUnsupported, _("The drive doesn't report the test status."));
+		}
+
+		SelfTestPollResult result;
+		result.status = get_self_test_status_from_ata(p->get_value<AtaStorageSelftestEntry>().status);
+		result.remaining_percent = p->get_value<AtaStorageSelftestEntry>().remaining_percent;
+		return result;
+	}
+
+}
+
+
+
 SelfTestStatusSeverity get_self_test_status_severity(SelfTestStatus s)
 {
 	static const std::unordered_map<SelfTestStatus, SelfTestStatusSeverity> m {
@@ -61,6 +218,7 @@ std::string SelfTest::get_test_displayable_name(SelfTest::TestType type)
 			{TestType::ShortTest,        _("Short Self-Test")},
 			{TestType::LongTest,         _("Extended Self-Test")},
 			{TestType::Conveyance,       _("Conveyance Self-Test")},
+			{TestType::Selective,        _("Selective Self-Test")},
 	};
 	if (auto iter = m.find(type); iter != m.end()) {
 		return iter->second;
@@ -70,6 +228,20 @@ std::string SelfTest::get_test_displayable_name(SelfTest::TestType type)
 
 
 
+void SelfTest::set_selective_spans(std::vector<SelfTestLbaSpan> spans)
+{
+	selective_spans_ = std::move(spans);
+}
+
+
+
+const std::vector<SelfTestLbaSpan>& SelfTest::get_selective_spans() const
+{
+	return selective_spans_;
+}
+
+
+
 bool SelfTest::is_active() const
 {
 	return (status_ == SelfTestStatus::InProgress);
@@ -145,13 +317,14 @@ std::chrono::seconds SelfTest::get_min_duration_seconds() const
 		case TestType::ShortTest: prop_name = "ata_smart_data/self_test/polling_minutes/short"; break;
 		case TestType::LongTest: prop_name = "ata_smart_data/self_test/polling_minutes/extended"; break;
 		case TestType::Conveyance: prop_name = "ata_smart_data/self_test/polling_minutes/conveyance"; break;
+		case TestType::Selective: return (total_duration_ = 0s);  // depends on the spans, judged by the progress
 	}
 
-	const StorageProperty p = drive_->get_property_repository().lookup_property(prop_name,
+	const StorageProperty* p = drive_->get_property_repository().find_property(prop_name,
 			StoragePropertySection::Capabilities);
 
 	// p stores it as uint64_t
-	return (total_duration_ = (p.empty() ? 0s : p.get_value<std::chrono::seconds>()));
+	return (total_duration_ = (!p ? 0s : p->get_value<std::chrono::seconds>()));
 }
 
 
@@ -165,13 +338,14 @@ bool SelfTest::is_supported() const
 		switch (type_) {
 //			case TestType::ImmediateOffline:
 			case TestType::Conveyance:
+			case TestType::Selective:
 				return false;  // not supported by nvme
 			case TestType::ShortTest:
 			case TestType::LongTest:
 			{
 				// Both short and long should be supported if the drive has a self-test log
-				const StorageProperty p = drive_->get_property_repository().lookup_property("nvme_self_test_log/_exists");
-				return (!p.empty() && p.get_value<bool>());
+				const StorageProperty* p = drive_->get_property_repository().find_property("nvme_self_test_log/_exists");
+				return (p && p->get_value<bool>());
 			}
 		}
 
@@ -193,10 +367,16 @@ bool SelfTest::is_supported() const
 			case TestType::Conveyance:
 				prop_name = "ata_smart_data/capabilities/conveyance_self_test_supported";
 				break;
+			case TestType::Selective:
+				if (selective_spans_.empty() || selective_spans_.size() > selftest_max_selective_spans) {
+					return false;
+				}
+				prop_name = "ata_smart_data/capabilities/selective_self_test_supported";
+				break;
 		}
 
-		const StorageProperty p = drive_->get_property_repository().lookup_property(prop_name);
-		return (!p.empty() && p.get_value<bool>());
+		const StorageProperty* p = drive_->get_property_repository().find_property(prop_name);
+		return (p && p->get_value<bool>());
 	}
 
 	return false;
@@ -221,20 +401,31 @@ hz::ExpectedVoid<SelfTestExecutionError> SelfTest::start(const std::shared_ptr<C
 				fmt::format(fmt::runtime(_("{} is unsupported by this drive.")), type_name));
 	}
 
-	std::string test_param;
+	std::vector<std::string> test_params;
 	switch(type_) {
-//		case TestType::ImmediateOffline: test_param = "offline"; break;
-		case TestType::ShortTest: test_param = "short"; break;
-		case TestType::LongTest: test_param = "long"; break;
-		case TestType::Conveyance: test_param = "conveyance"; break;
+//		case TestType::ImmediateOffline: test_params = {"offline"}; break;
+		case TestType::ShortTest: test_params = {"short"}; break;
+		case TestType::LongTest: test_params = {"long"}; break;
+		case TestType::Conveyance: test_params = {"conveyance"}; break;
+		case TestType::Selective:
+			// smartctl accepts a "-t select,START-END" for each span
+			for (const auto& span : selective_spans_) {
+				test_params.push_back(fmt::format("select,{}-{}", span.start, span.end));
+			}
+			break;
 		// no default - this way we get warned by compiler if we're not listing all of them.
 	}
-	if (test_param.empty()) {
+	if (test_params.empty()) {
 		return hz::Unexpected(SelfTestExecutionError::InvalidTestType, _("Invalid test specified."));
 	}
 
+	std::vector<std::string> command_options;
+	for (const auto& test_param : test_params) {
+		command_options.push_back("--test=" + test_param);
+	}
+
 	std::string output;
-	auto execute_status = drive_->execute_device_smartctl({"--test=" + test_param}, smartctl_ex, output);
+	auto execute_status = drive_->execute_device_smartctl(command_options, smartctl_ex, output, false, CommandOperation::SelfTest);
 
 	if (!execute_status.has_value()) {
 		std::string message = execute_status.error().message();
@@ -269,6 +460,7 @@ hz::ExpectedVoid<SelfTestExecutionError> SelfTest::start(const std::shared_ptr<C
 	last_seen_percent_ = 90;
 	poll_in_seconds_ = std::chrono::seconds(5);  // first update() in 5 seconds
 	timer_.start();
+	start_timer_.start();
 
 	drive_->set_test_is_active(true);
 
@@ -277,6 +469,24 @@ hz::ExpectedVoid<SelfTestExecutionError> SelfTest::start(const std::shared_ptr<C
 
 
 
+void SelfTest::resume()
+{
+	if (!drive_) {
+		return;
+	}
+	// Same as start(), but the test progress is unknown until update().
+	status_ = SelfTestStatus::InProgress;
+	remaining_percent_ = -1;
+	last_seen_percent_ = -1;
+	poll_in_seconds_ = std::chrono::seconds(0);  // update() now
+	timer_.start();
+	start_timer_.start();
+
+	drive_->set_test_is_active(true);
+}
+
+
+
 // abort test.
 hz::ExpectedVoid<SelfTestExecutionError> SelfTest::force_stop(const std::shared_ptr<CommandExecutor>& smartctl_ex)
 {
@@ -302,7 +512,7 @@ hz::ExpectedVoid<SelfTestExecutionError> SelfTest::force_stop(const std::shared_
 
 	// To abort non-captive short, long and conveyance tests, use "--abort".
 	std::string output;
-	auto execute_status = drive_->execute_device_smartctl({"--abort"}, smartctl_ex, output);
+	auto execute_status = drive_->execute_device_smartctl({"--abort"}, smartctl_ex, output, false, CommandOperation::SelfTest);
 
 	if (!execute_status) {
 		std::string message = execute_status.error().message();
@@ -353,21 +563,20 @@ hz::ExpectedVoid<SelfTestExecutionError> SelfTest::update(const std::shared_ptr<
 		return hz::Unexpected(SelfTestExecutionError::InternalError, _("Internal Error: Drive must not be NULL."));
 	}
 
-	SmartctlParserType parser_type = SmartctlParserType::Ata;
-	if (drive_->get_detected_type() == StorageDeviceDetectedType::Nvme) {
-		parser_type = SmartctlParserType::Nvme;
-	}
-	auto parser_format = SmartctlVersionParser::get_default_format(parser_type);
+	const bool nvme = (drive_->get_detected_type() == StorageDeviceDetectedType::Nvme);
+	const auto parser_format = SmartctlVersionParser::get_default_format(nvme ? SmartctlParserType::Nvme : SmartctlParserType::Ata);
 
 	// ATA shows status in capabilities; NVMe shows it in self-test log.
-	std::vector<std::string> command_options = {"--capabilities", "--log=selftest"};
+	std::vector<std::string> command_options;
 	if (parser_format == SmartctlOutputFormat::Json) {
-		// --json flags: o means include original output (just in case).
-		command_options.emplace_back("--json=o");
+		// Only the status fields are read, so request only the needed section, without the original output.
+		command_options = {(nvme ? "--log=selftest" : "--capabilities"), "--json"};
+	} else {
+		command_options = {"--capabilities", "--log=selftest"};
 	}
 
 	std::string output;
-	auto execute_status = drive_->execute_device_smartctl(command_options, smartctl_ex, output);
+	auto execute_status = drive_->execute_device_smartctl(command_options, smartctl_ex, output, false, CommandOperation::SelfTest);
 
 	if (!execute_status) {
 		std::string message = execute_status.error().message();
@@ -375,117 +584,14 @@ hz::ExpectedVoid<SelfTestExecutionError> SelfTest::update(const std::shared_ptr<
 				fmt::format(fmt::runtime(_("Sending command to drive failed: {}")), message));
 	}
 
-
-	std::shared_ptr<SmartctlParser> parser = SmartctlParser::create(parser_type, parser_format);
-	DBG_ASSERT_RETURN(parser, hz::Unexpected(SelfTestExecutionError::ParseError, _("Cannot create parser.")));
-
-	auto parse_status = parser->parse(output);
-	if (!parse_status) {
-		return hz::Unexpected(SelfTestExecutionError::ParseError,
-				fmt::format(fmt::runtime(_("Cannot parse smartctl output: {}")), parse_status.error().message()));
+	auto poll_result = (parser_format == SmartctlOutputFormat::Json
+			? get_poll_result_from_json(output, nvme) : get_poll_result_from_text(output, nvme));
+	if (!poll_result) {
+		return hz::Unexpected(SelfTestExecutionError(poll_result.error().data()), poll_result.error().message());
 	}
-	const auto property_repo = StoragePropertyProcessor::process_properties(
-			parser->get_property_repository(), drive_->get_detected_type());
-
-
-	if (drive_->get_detected_type() == StorageDeviceDetectedType::Nvme) {
-
-		const StorageProperty current_operation = property_repo.lookup_property("nvme_self_test_log/current_self_test_operation/value/_decoded");
-
-		// If no test is active, the property may be absent, or set to None.
-		if (!current_operation.empty()
-				&& current_operation.get_value<std::string>() != NvmeSelfTestCurrentOperationTypeExt::get_storable_name(NvmeSelfTestCurrentOperationType::None)) {
-			status_ = SelfTestStatus::InProgress;
-
-			auto remaining_percent = property_repo.lookup_property("nvme_self_test_log/current_self_test_completion_percent");
-			if (!remaining_percent.empty()) {
-				remaining_percent_ = static_cast<int8_t>(100 - remaining_percent.get_value<int64_t>());
-			}
-		} else {  // no test is active
-			// The first self-test table entry is the latest.
-			std::optional<NvmeStorageSelftestEntry> entry;
-			for (const auto& e : property_repo.get_properties()) {
-				if (e.is_value_type<NvmeStorageSelftestEntry>() && e.get_value<NvmeStorageSelftestEntry>().test_num == 1) {
-					entry = e.get_value<NvmeStorageSelftestEntry>();
-				}
-			}
-			if (!entry) {
-				return hz::Unexpected(SelfTestExecutionError::ReportUnsupported, _("The drive doesn't report the test status."));
-			}
-
-			switch (entry->result) {
-				case NvmeSelfTestResultType::Unknown:
-					status_ = SelfTestStatus::Unknown;
-					break;
-				case NvmeSelfTestResultType::CompletedNoError:
-					status_ = SelfTestStatus::CompletedNoError;
-					break;
-				case NvmeSelfTestResultType::AbortedSelfTestCommand:
-					status_ = SelfTestStatus::ManuallyAborted;
-					break;
-				case NvmeSelfTestResultType::AbortedControllerReset:
-				case NvmeSelfTestResultType::AbortedNamespaceRemoved:
-				case NvmeSelfTestResultType::AbortedFormatNvmCommand:
-				case NvmeSelfTestResultType::AbortedUnknownReason:
-				case NvmeSelfTestResultType::AbortedSanitizeOperation:
-					status_ = SelfTestStatus::Interrupted;
-					break;
-				case NvmeSelfTestResultType::FatalOrUnknownTestError:
-				case NvmeSelfTestResultType::CompletedUnknownFailedSegment:
-				case NvmeSelfTestResultType::CompletedFailedSegments:
-					status_ = SelfTestStatus::CompletedWithError;
-					break;
-			}
-		}
-
-	} else {
-		// ATA:
-		// Note: Since the self-test log is sometimes late
-		// and in undetermined order (sorting by hours is too rough),
-		// we use the "self-test status" capability.
-		StorageProperty p;
-		for (const auto& e : property_repo.get_properties()) {
-			if (!e.is_value_type<AtaStorageSelftestEntry>() || e.get_value<AtaStorageSelftestEntry>().test_num != 0
-					|| e.generic_name != "ata_smart_data/self_test/status/_merged")
-				continue;
-			p = e;
-		}
-		if (p.empty()) {
-			return hz::Unexpected(SelfTestExecutionError::ReportUnsupported, _("The drive doesn't report the test status."));
-		}
-
-		switch (p.get_value<AtaStorageSelftestEntry>().status) {
-			case AtaStorageSelftestEntry::Status::InProgress:
-				status_ = SelfTestStatus::InProgress;
-				break;
-			case AtaStorageSelftestEntry::Status::Unknown:
-				status_ = SelfTestStatus::Unknown;
-				break;
-			case AtaStorageSelftestEntry::Status::Reserved:
-				status_ = SelfTestStatus::Reserved;
-				break;
-			case AtaStorageSelftestEntry::Status::CompletedNoError:
-				status_ = SelfTestStatus::CompletedNoError;
-				break;
-			case AtaStorageSelftestEntry::Status::AbortedByHost:
-				status_ = SelfTestStatus::ManuallyAborted;
-				break;
-			case AtaStorageSelftestEntry::Status::Interrupted:
-				status_ = SelfTestStatus::Interrupted;
-				break;
-			case AtaStorageSelftestEntry::Status::FatalOrUnknown:
-			case AtaStorageSelftestEntry::Status::ComplUnknownFailure:
-			case AtaStorageSelftestEntry::Status::ComplElectricalFailure:
-			case AtaStorageSelftestEntry::Status::ComplServoFailure:
-			case AtaStorageSelftestEntry::Status::ComplReadFailure:
-			case AtaStorageSelftestEntry::Status::ComplHandlingDamage:
-				status_ = SelfTestStatus::CompletedWithError;
-				break;
-		}
-
-		if (status_ == SelfTestStatus::InProgress) {
-			remaining_percent_ = p.get_value<AtaStorageSelftestEntry>().remaining_percent;
-		}
+	status_ = poll_result->status;
+	if (status_ == SelfTestStatus::InProgress && poll_result->remaining_percent.has_value()) {
+		remaining_percent_ = poll_result->remaining_percent.value();
 	}
 
 	// Note that the test needs 90% to complete, not 100. It starts at 90%
@@ -498,8 +604,15 @@ hz::ExpectedVoid<SelfTestExecutionError> SelfTest::update(const std::shared_ptr<
 
 		const std::chrono::seconds total = get_min_duration_seconds();
 
-		if (total <= 0s) {  // unknown
-			poll_in_seconds_ = 15s;  // just a guess, quick enough for nvme
+		if (total <= 0s) {  // unknown (e.g. nvme)
+			// Poll about once per 1% of progress, judging by the progress so far.
+			// This keeps the number of polls low for long tests on many drives.
+			poll_in_seconds_ = 15s;
+			const auto elapsed = std::chrono::seconds(static_cast<int64_t>(start_timer_.elapsed()));
+			const int completed_percent = 100 - remaining_percent_;
+			if (remaining_percent_ >= 0 && completed_percent > 0) {
+				poll_in_seconds_ = std::clamp(elapsed / completed_percent, std::chrono::seconds(15s), std::chrono::seconds(60s));
+			}
 
 		} else {
 			// seconds per 10%. use double, because e.g. 60sec test gives silly values with int.
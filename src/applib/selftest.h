@@ -13,14 +13,17 @@ Copyright:
 #define SELFTEST_H
 
 #include <glibmm.h>
+#include <array>
 #include <memory>
 #include <string>
 #include <cstdint>
 #include <chrono>
 #include <unordered_map>
+#include <vector>
 
 #include "storage_device.h"
 #include "command_executor.h"
+#include "selftest_selective.h"
 #include "hz/error_container.h"
 
 
@@ -54,25 +57,21 @@ enum class SelfTestStatus {
 
 /// Helper structure for enum-related functions
 struct SelfTestStatusExt
-		: public hz::EnumHelper<
+		: public hz::EnumTableHelper<
 				SelfTestStatus,
-				SelfTestStatusExt,
-				Glib::ustring>
+				SelfTestStatusExt>
 {
 	static constexpr EnumType default_value = EnumType::Unknown;
 
-	static std::unordered_map<EnumType, std::pair<std::string, Glib::ustring>> build_enum_map()
-	{
-		return {
-			{SelfTestStatus::Unknown, {"unknown", _("Unknown")}},
-			{SelfTestStatus::InProgress, {"in_progress", _("In Progress")}},
-			{SelfTestStatus::ManuallyAborted, {"manually_aborted", _("Manually Aborted")}},
-			{SelfTestStatus::Interrupted, {"interrupted", _("Interrupted")}},
-			{SelfTestStatus::CompletedNoError, {"completed_no_error", _("Completed Successfully")}},
-			{SelfTestStatus::CompletedWithError, {"completed_with_error", _("Completed With Errors")}},
-			{SelfTestStatus::Reserved, {"reserved", _("Reserved")}},
-		};
-	}
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{SelfTestStatus::Unknown, "unknown", N_("Unknown")},
+		{SelfTestStatus::InProgress, "in_progress", N_("In Progress")},
+		{SelfTestStatus::ManuallyAborted, "manually_aborted", N_("Manually Aborted")},
+		{SelfTestStatus::Interrupted, "interrupted", N_("Interrupted")},
+		{SelfTestStatus::CompletedNoError, "completed_no_error", N_("Completed Successfully")},
+		{SelfTestStatus::CompletedWithError, "completed_with_error", N_("Completed With Errors")},
+		{SelfTestStatus::Reserved, "reserved", N_("Reserved")},
+	});
 
 };
 
@@ -102,7 +101,8 @@ class SelfTest {
 //			ImmediateOffline,  ///< Immediate offline, not supported
 			ShortTest,  ///< Short self-test
 			LongTest,  ///< Extended (a.k.a. long) self-test
-			Conveyance  ///< Conveyance self-test
+			Conveyance,  ///< Conveyance self-test
+			Selective,  ///< Selective self-test of the LBA spans set with set_selective_spans() (ATA only)
 		};
 
 
@@ -116,6 +116,15 @@ class SelfTest {
 		{ }
 
 
+		/// Set the LBA spans of a selective self-test (at most selftest_max_selective_spans).
+		/// This must be called before start().
+		void set_selective_spans(std::vector<SelfTestLbaSpan> spans);
+
+
+		/// Get the LBA spans of a selective self-test
+		[[nodiscard]] const std::vector<SelfTestLbaSpan>& get_selective_spans() const;
+
+
 		/// Check if the test is currently active
 		[[nodiscard]] bool is_active() const;
 
@@ -157,6 +166,12 @@ class SelfTest {
 		[[nodiscard]] hz::ExpectedVoid<SelfTestExecutionError> start(const std::shared_ptr<CommandExecutor>& smartctl_ex = nullptr);
 
 
+		/// Take over a test which is already running on the drive (e.g. started by a previous
+		/// run of the program). This object must be newly constructed. Call update() right away
+		/// to get the actual status; if no test is running, update() reports that.
+		void resume();
+
+
 		/// Abort the running test.
 		/// \return error message on error, empty string on success.
 		[[nodiscard]] hz::ExpectedVoid<SelfTestExecutionError> force_stop(const std::shared_ptr<CommandExecutor>& smartctl_ex = nullptr);
@@ -171,6 +186,7 @@ class SelfTest {
 
 		StorageDevicePtr drive_;  ///< Drive to run the tests on
 		TestType type_ = TestType::ShortTest;  ///< Test type
+		std::vector<SelfTestLbaSpan> selective_spans_;  ///< LBA spans of a selective self-test
 
 		// status variables:
 		SelfTestStatus status_ = SelfTestStatus::Unknown;  ///< Current status of the test as reported by the drive
@@ -180,6 +196,7 @@ class SelfTest {
 		std::chrono::seconds poll_in_seconds_ = std::chrono::seconds(-1);  ///< The user is asked to poll after this much seconds have passed.
 
 		Glib::Timer timer_;  ///< Counts time since the last percent change
+		Glib::Timer start_timer_;  ///< Counts time since the test start
 
 };
 
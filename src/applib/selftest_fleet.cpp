@@ -0,0 +1,482 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+#include "build_config.h"
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+#include "rconfig/rconfig.h"
+
+#include "app_regex.h"
+#include "worker_threads.h"
+#include "selftest_fleet.h"
+
+
+
+namespace {
+
+	/// Version of the state file format. Files with a different version are ignored.
+	constexpr int state_format_version = 1;
+
+	/// Maximum state file size to load
+	constexpr int state_max_size = 10*1024*1024;  // 10M
+
+	/// Poll interval while there are pending tests waiting for a free slot
+	constexpr std::chrono::seconds pending_poll_interval(30);
+
+
+	/// Get the storable name of a test type
+	std::string get_test_type_storable_name(SelfTest::TestType type)
+	{
+		switch (type) {
+			case SelfTest::TestType::ShortTest: return "short";
+			case SelfTest::TestType::LongTest: return "long";
+			case SelfTest::TestType::Conveyance: return "conveyance";
+			case SelfTest::TestType::Selective: return "selective";
+		}
+		return "unknown";
+	}
+
+
+	/// Get the current time, seconds since epoch
+	std::int64_t get_current_time()
+	{
+		return std::chrono::duration_cast<std::chrono::seconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+}
+
+
+
+SelfTestFleet::SelfTestFleet(SelfTest::TestType type, Limits limits, hz::fs::path state_file)
+		: type_(type), limits_(limits), state_file_(std::move(state_file))
+{ }
+
+
+
+std::error_code SelfTestFleet::load()
+{
+	std::error_code ec;
+	if (!hz::fs::exists(state_file_, ec)) {
+		return {};
+	}
+
+	std::string contents;
+	if (auto read_ec = hz::fs_file_get_contents(state_file_, contents, state_max_size)) {
+		return read_ec;
+	}
+
+	const nlohmann::json doc = nlohmann::json::parse(contents, nullptr, false);
+	if (!doc.is_object() || doc.value("format_version", 0) != state_format_version
+			|| !doc.contains("jobs") || !doc["jobs"].is_array()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Self-test state file \"" << hz::fs_path_to_string(state_file_)
+				<< "\" has invalid format, ignoring.\n");
+		return {};
+	}
+	if (doc.value("test_type", std::string()) != get_test_type_storable_name(type_)) {
+		debug_out_info("app", DBG_FUNC_MSG << "Self-test state file is for a different test type, starting a new run.\n");
+		return {};
+	}
+
+	jobs_.clear();
+	slots_.clear();
+	for (const auto& j : doc["jobs"]) {
+		try {
+			SelfTestFleetJob job;
+			job.key = j.at("key").get<std::string>();
+			job.device = j.value("device", std::string());
+			job.controller = j.value("controller", std::string());
+			job.enclosure = j.value("enclosure", std::string());
+			job.state = SelfTestFleetJobStateExt::get_by_storable_name(j.value("state", std::string()));
+			job.result = SelfTestStatusExt::get_by_storable_name(j.value("result", std::string()));
+			job.remaining_percent = j.value("remaining_percent", -1);
+			job.start_time = j.value("start_time", std::int64_t(0));
+			job.end_time = j.value("end_time", std::int64_t(0));
+			job.error = j.value("error", std::string());
+			if (!find_job(job.key)) {
+				jobs_.push_back(std::move(job));
+			}
+		}
+		catch (const nlohmann::json::exception& e) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Invalid self-test state entry: " << e.what() << "\n");
+		}
+	}
+	return {};
+}
+
+
+
+void SelfTestFleet::set_drives(const std::vector<StorageDevicePtr>& drives)
+{
+	slots_.clear();
+
+	// Keep the jobs without drives (from load()) at the end, so that they're still reported.
+	std::vector<SelfTestFleetJob> old_jobs = std::move(jobs_);
+	jobs_.clear();
+
+	for (const auto& drive : drives) {
+		if (!drive || drive->get_is_virtual()) {
+			continue;
+		}
+		const std::string key = get_drive_key(*drive);
+		if (find_job(key)) {
+			continue;  // the same drive listed twice
+		}
+
+		auto old_iter = std::find_if(old_jobs.begin(), old_jobs.end(),
+				[&key](const SelfTestFleetJob& job) { return job.key == key; });
+		SelfTestFleetJob job;
+		if (old_iter != old_jobs.end()) {
+			job = std::move(*old_iter);
+			old_jobs.erase(old_iter);
+		}
+		job.key = key;
+		job.device = drive->get_device_with_type();
+		const std::string sysfs_path = get_sysfs_device_path(*drive);
+		job.controller = get_controller_key(*drive, sysfs_path);
+		job.enclosure = get_enclosure_key(*drive, sysfs_path);
+
+		Slot slot;
+		slot.job_index = jobs_.size();
+		slot.drive = drive;
+		if (job.state == SelfTestFleetJobState::Running) {  // started by a previous run
+			slot.test = std::make_shared<SelfTest>(drive, type_);
+			slot.test->resume();
+			slot.next_poll = std::chrono::steady_clock::now();
+		}
+		slots_.push_back(slot);
+		jobs_.push_back(std::move(job));
+	}
+
+	for (auto& job : old_jobs) {
+		jobs_.push_back(std::move(job));
+	}
+}
+
+
+
+bool SelfTestFleet::run_once(const CommandExecutorFactoryPtr& ex_factory)
+{
+	const auto now = std::chrono::steady_clock::now();
+
+	// The tests to start, and the ones to poll. Starting counts towards the limits right away.
+	// When a poll finishes a test, another pass is made to start the tests waiting for its slot.
+	bool changed = false;
+	for (bool first_pass = true; ; first_pass = false) {
+		std::vector<Slot*> to_start, to_poll;
+		for (auto& slot : slots_) {
+			SelfTestFleetJob& job = jobs_.at(slot.job_index);
+			if (first_pass && job.state == SelfTestFleetJobState::Running && slot.test && slot.next_poll <= now) {
+				to_poll.push_back(&slot);
+			}
+		}
+		for (auto& slot : slots_) {
+			SelfTestFleetJob& job = jobs_.at(slot.job_index);
+			if (job.state == SelfTestFleetJobState::Pending && get_can_start(job)) {
+				job.state = SelfTestFleetJobState::Running;  // reserve the slot, the limits count it
+				to_start.push_back(&slot);
+			}
+		}
+		if (to_start.empty() && to_poll.empty()) {
+			if (changed) {
+				save();
+			}
+			return std::any_of(jobs_.cbegin(), jobs_.cend(), [](const SelfTestFleetJob& job) {
+				return job.state == SelfTestFleetJobState::Pending || job.state == SelfTestFleetJobState::Running;
+			});
+		}
+
+		// Each task touches only its own slot, job and drive.
+		std::vector<Slot*> tasks = to_poll;
+		tasks.insert(tasks.end(), to_start.begin(), to_start.end());
+		const std::size_t poll_count = to_poll.size();
+
+		app_run_worker_tasks(tasks.size(), std::max(std::size_t(1), limits_.max_parallel_commands), [&](std::size_t i) {
+			Slot& slot = *tasks[i];
+			SelfTestFleetJob& job = jobs_.at(slot.job_index);
+			auto smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+
+			if (i >= poll_count) {  // start
+				// The capabilities (test support, durations) are needed to start a test.
+				// The drive type may not be known yet, if the caller didn't fetch the basic data.
+				if (slot.drive->get_parse_status() != StorageDevice::ParseStatus::Full) {
+					if (auto fetch_status = slot.drive->fetch_all_data_and_parse(smartctl_ex); !fetch_status) {
+						job.state = SelfTestFleetJobState::Failed;
+						job.error = fetch_status.error().message();
+						return;
+					}
+				}
+				auto test = std::make_shared<SelfTest>(slot.drive, type_);
+				if (auto start_status = test->start(smartctl_ex); !start_status) {
+					job.state = SelfTestFleetJobState::Failed;
+					job.error = start_status.error().message();
+					return;
+				}
+				slot.test = test;
+				job.start_time = get_current_time();
+				job.remaining_percent = test->get_remaining_percent();
+				slot.next_poll = std::chrono::steady_clock::now() + test->get_poll_in_seconds();
+				return;
+			}
+
+			// poll
+			smartctl_ex->set_priority(CommandPriority::SelfTestPoll);
+			if (auto update_status = slot.test->update(smartctl_ex); !update_status) {
+				job.state = SelfTestFleetJobState::Failed;
+				job.error = update_status.error().message();
+				job.end_time = get_current_time();
+				slot.test.reset();
+				return;
+			}
+			if (slot.test->is_active()) {
+				job.remaining_percent = slot.test->get_remaining_percent();
+				slot.next_poll = std::chrono::steady_clock::now() + slot.test->get_poll_in_seconds();
+			} else {
+				job.state = SelfTestFleetJobState::Finished;
+				job.result = slot.test->get_status();
+				job.remaining_percent = -1;
+				job.end_time = get_current_time();
+				slot.test.reset();
+			}
+		});
+
+		for (const Slot* slot : tasks) {
+			const auto& job = jobs_.at(slot->job_index);
+			debug_out_info("app", DBG_FUNC_MSG << job.device << ": " << SelfTestFleetJobStateExt::get_storable_name(job.state)
+					<< (job.error.empty() ? std::string() : (": " + job.error)) << "\n");
+		}
+
+		changed = true;
+	}
+}
+
+
+
+void SelfTestFleet::abort_all(const CommandExecutorFactoryPtr& ex_factory)
+{
+	std::vector<Slot*> tasks;
+	for (auto& slot : slots_) {
+		if (slot.test && jobs_.at(slot.job_index).state == SelfTestFleetJobState::Running) {
+			tasks.push_back(&slot);
+		}
+	}
+
+	app_run_worker_tasks(tasks.size(), std::max(std::size_t(1), limits_.max_parallel_commands), [&](std::size_t i) {
+		Slot& slot = *tasks[i];
+		SelfTestFleetJob& job = jobs_.at(slot.job_index);
+		auto smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+		if (auto stop_status = slot.test->force_stop(smartctl_ex); !stop_status) {
+			job.error = stop_status.error().message();
+		}
+		job.state = SelfTestFleetJobState::Finished;
+		job.result = slot.test->get_status();
+		job.remaining_percent = -1;
+		job.end_time = get_current_time();
+		slot.test.reset();
+	});
+
+	save();
+}
+
+
+
+std::chrono::seconds SelfTestFleet::get_next_poll_in() const
+{
+	const auto now = std::chrono::steady_clock::now();
+	std::chrono::seconds next = pending_poll_interval;
+	for (const auto& slot : slots_) {
+		if (slot.test && jobs_.at(slot.job_index).state == SelfTestFleetJobState::Running) {
+			next = std::min(next, std::chrono::duration_cast<std::chrono::seconds>(
+					std::max(slot.next_poll - now, std::chrono::steady_clock::duration::zero())));
+		}
+	}
+	return next;
+}
+
+
+
+const std::vector<SelfTestFleetJob>& SelfTestFleet::get_jobs() const
+{
+	return jobs_;
+}
+
+
+
+std::error_code SelfTestFleet::get_save_error() const
+{
+	return save_error_;
+}
+
+
+
+std::string SelfTestFleet::get_drive_key(const StorageDevice& drive)
+{
+	std::string serial = drive.get_serial_number();
+	if (!serial.empty()) {
+		return serial;
+	}
+	return drive.get_device_with_type();
+}
+
+
+
+std::string SelfTestFleet::get_controller_key(const StorageDevice& drive, const std::string& sysfs_device_path)
+{
+	// RAID controller ports, e.g. "areca,3/1", "3ware,5", "megaraid,2".
+	const std::string type_arg = drive.get_type_argument();
+	if (const auto comma_pos = type_arg.find(','); comma_pos != std::string::npos) {
+		return "raid:" + drive.get_device() + ":" + type_arg.substr(0, comma_pos);
+	}
+
+	// The last PCI function in the sysfs path is the host adapter (or the NVMe drive itself).
+	std::vector<std::string> components;
+	hz::string_split(sysfs_device_path, '/', components, true);
+	for (auto iter = components.rbegin(); iter != components.rend(); ++iter) {
+		if (app_regex_full_match("/^[0-9a-f]{4}:[0-9a-f]{2}:[0-9a-f]{2}\\.[0-9a-f]$/i", *iter)) {
+			return "pci:" + *iter;
+		}
+	}
+
+	return "drive:" + drive.get_device_with_type();
+}
+
+
+
+std::string SelfTestFleet::get_enclosure_key(const StorageDevice& drive, const std::string& sysfs_device_path)
+{
+	// Areca with enclosures: "areca,<port>/<enclosure>"
+	const std::string type_arg = drive.get_type_argument();
+	std::string enclosure;
+	if (app_regex_partial_match("/^areca,[0-9]+\\/([0-9]+)$/", type_arg, &enclosure)) {
+		return "raid:" + drive.get_device() + ":" + enclosure;
+	}
+
+	// SAS expander. The one nearest to the drive is its enclosure.
+	std::vector<std::string> components;
+	hz::string_split(sysfs_device_path, '/', components, true);
+	for (auto iter = components.rbegin(); iter != components.rend(); ++iter) {
+		if (iter->rfind("expander-", 0) == 0) {
+			return "sas:" + *iter;
+		}
+	}
+
+	return {};
+}
+
+
+
+std::string SelfTestFleet::get_sysfs_device_path([[maybe_unused]] const StorageDevice& drive)
+{
+	if constexpr(BuildEnv::is_kernel_linux()) {
+		if (drive.get_type_argument().find(',') != std::string::npos) {
+			return {};  // behind a RAID controller, the device is the controller
+		}
+		std::error_code ec;
+		// Resolve /dev/disk/by-id/... links
+		hz::fs::path dev = hz::fs::canonical(hz::fs_path_from_string(drive.get_device()), ec);
+		if (ec) {
+			return {};
+		}
+		static const rconfig::Key<std::string> sysfs_path("system/linux_sysfs_path");
+		const auto sysfs_dir = hz::fs_path_from_string(sysfs_path.get());
+		for (const auto* class_dir : {"block", "class/nvme"}) {
+			hz::fs::path path = hz::fs::canonical(sysfs_dir / class_dir / dev.filename(), ec);
+			if (!ec) {
+				return hz::fs_path_to_string(path);
+			}
+		}
+	}
+	return {};
+}
+
+
+
+hz::fs::path SelfTestFleet::get_default_state_file()
+{
+	return hz::fs_get_user_config_dir() / "gsmartcontrol" / "selftest_fleet.json";
+}
+
+
+
+void SelfTestFleet::save()
+{
+	nlohmann::json doc;
+	doc["format_version"] = state_format_version;
+	doc["test_type"] = get_test_type_storable_name(type_);
+	nlohmann::json& jobs_json = doc["jobs"];
+	jobs_json = nlohmann::json::array();
+
+	for (const auto& job : jobs_) {
+		nlohmann::json j;
+		j["key"] = job.key;
+		j["device"] = job.device;
+		j["controller"] = job.controller;
+		j["enclosure"] = job.enclosure;
+		j["state"] = SelfTestFleetJobStateExt::get_storable_name(job.state);
+		j["result"] = SelfTestStatusExt::get_storable_name(job.result);
+		j["remaining_percent"] = job.remaining_percent;
+		j["start_time"] = job.start_time;
+		j["end_time"] = job.end_time;
+		j["error"] = job.error;
+		jobs_json.push_back(std::move(j));
+	}
+
+	std::error_code ec;
+	hz::fs::create_directories(state_file_.parent_path(), ec);  // ignore errors, the write will report them
+	save_error_ = hz::fs_file_put_contents_atomic(state_file_, doc.dump(4));
+	if (save_error_) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot write self-test state file \"" << hz::fs_path_to_string(state_file_)
+				<< "\": " << save_error_.message() << "\n");
+	}
+}
+
+
+
+SelfTestFleetJob* SelfTestFleet::find_job(const std::string& key)
+{
+	auto iter = std::find_if(jobs_.begin(), jobs_.end(), [&key](const SelfTestFleetJob& job) { return job.key == key; });
+	return (iter != jobs_.end() ? &(*iter) : nullptr);
+}
+
+
+
+bool SelfTestFleet::get_can_start(const SelfTestFleetJob& job) const
+{
+	std::size_t running = 0, same_controller = 0, same_enclosure = 0;
+	for (const auto& other : jobs_) {
+		if (other.state != SelfTestFleetJobState::Running) {
+			continue;
+		}
+		++running;
+		if (other.controller == job.controller) {
+			++same_controller;
+		}
+		if (!job.enclosure.empty() && other.enclosure == job.enclosure) {
+			++same_enclosure;
+		}
+	}
+	return (limits_.max_running == 0 || running < limits_.max_running)
+			&& (limits_.max_per_controller == 0 || same_controller < limits_.max_per_controller)
+			&& (limits_.max_per_enclosure == 0 || same_enclosure < limits_.max_per_enclosure);
+}
+
+
+
+
+
+
+/// @}
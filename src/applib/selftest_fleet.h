@@ -0,0 +1,198 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef SELFTEST_FLEET_H
+#define SELFTEST_FLEET_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hz/fs.h"
+
+#include "command_executor_factory.h"
+#include "selftest.h"
+#include "storage_device.h"
+
+
+
+/// State of a drive in a fleet self-test run
+enum class SelfTestFleetJobState {
+	Pending,  ///< Waiting to be started
+	Running,  ///< The test is running on the drive
+	Finished,  ///< The test finished (see SelfTestFleetJob::result)
+	Failed,  ///< The test couldn't be started or monitored (see SelfTestFleetJob::error)
+};
+
+
+
+/// Helper structure for enum-related functions
+struct SelfTestFleetJobStateExt
+		: public hz::EnumTableHelper<
+				SelfTestFleetJobState,
+				SelfTestFleetJobStateExt>
+{
+	static constexpr EnumType default_value = EnumType::Pending;
+
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{SelfTestFleetJobState::Pending, "pending", N_("Pending")},
+		{SelfTestFleetJobState::Running, "running", N_("Running")},
+		{SelfTestFleetJobState::Finished, "finished", N_("Finished")},
+		{SelfTestFleetJobState::Failed, "failed", N_("Failed")},
+	});
+
+};
+
+
+
+/// A drive in a fleet self-test run. This is what's stored in the state file.
+struct SelfTestFleetJob {
+	std::string key;  ///< Drive identity, see SelfTestFleet::get_drive_key()
+	std::string device;  ///< Device with type, for display
+	std::string controller;  ///< Controller group, see SelfTestFleet::get_controller_key()
+	std::string enclosure;  ///< Enclosure group (may be empty), see SelfTestFleet::get_enclosure_key()
+	SelfTestFleetJobState state = SelfTestFleetJobState::Pending;  ///< State
+	SelfTestStatus result = SelfTestStatus::Unknown;  ///< Test result, if finished
+	int remaining_percent = -1;  ///< Last reported remaining percent, -1 if unknown
+	std::int64_t start_time = 0;  ///< Test start time, seconds since epoch. 0 if not started.
+	std::int64_t end_time = 0;  ///< Test end time, seconds since epoch. 0 if not finished.
+	std::string error;  ///< Error message, if failed
+};
+
+
+
+/// Runs a self-test on many drives, limiting the number of tests running at the same time
+/// on the same controller (HBA / RAID card) and in the same enclosure, since they slow
+/// each other down. The tests are started and polled using SelfTest, in worker threads
+/// with pooled executors. The progress is saved to a state file after each change,
+/// so that the run can be resumed (with the running tests re-attached) after a restart.
+///
+/// The caller calls run_once() every get_next_poll_in() until it returns false.
+/// This class is not thread-safe; run_once() uses worker threads internally.
+class SelfTestFleet {
+	public:
+
+		/// Concurrency limits. 0 means unlimited.
+		struct Limits {
+			std::size_t max_running = 0;  ///< Maximum number of running tests
+			std::size_t max_per_controller = 0;  ///< Maximum number of running tests per controller
+			std::size_t max_per_enclosure = 0;  ///< Maximum number of running tests per enclosure
+			std::size_t max_parallel_commands = 1;  ///< Maximum number of smartctl commands run at the same time
+		};
+
+
+		/// Constructor
+		SelfTestFleet(SelfTest::TestType type, Limits limits, hz::fs::path state_file);
+
+
+		/// Load the state of a previous run from the state file. A missing file is not an error.
+		/// A file with a different test type is ignored (a new run is started).
+		[[nodiscard]] std::error_code load();
+
+
+		/// Set the drives to test. The drives already known from load() are matched by
+		/// get_drive_key(); their running tests are re-attached, and their finished tests are not repeated.
+		/// The basic data of the drives should be fetched first (see StorageDetector::fetch_basic_data()),
+		/// otherwise their serial numbers are unknown and they're keyed by their devices.
+		void set_drives(const std::vector<StorageDevicePtr>& drives);
+
+
+		/// Start the pending tests (within the limits) and poll the running tests which are due.
+		/// The state file is written if anything changed.
+		/// \return true if there are pending or running tests left.
+		bool run_once(const CommandExecutorFactoryPtr& ex_factory);
+
+
+		/// Abort all the running tests. The state file is written.
+		void abort_all(const CommandExecutorFactoryPtr& ex_factory);
+
+
+		/// Get the time until run_once() should be called again
+		[[nodiscard]] std::chrono::seconds get_next_poll_in() const;
+
+
+		/// Get the jobs, in the order of set_drives() (the jobs from load() without drives are last).
+		[[nodiscard]] const std::vector<SelfTestFleetJob>& get_jobs() const;
+
+
+		/// Get the state file error of the last write, if any
+		[[nodiscard]] std::error_code get_save_error() const;
+
+
+		/// Get the drive identity: serial number, or device with type if it has no serial number.
+		[[nodiscard]] static std::string get_drive_key(const StorageDevice& drive);
+
+
+		/// Get the controller group of a drive. RAID-controller drives (type argument with a port,
+		/// e.g. "areca,3/1") are grouped by their controller device. Otherwise, \c sysfs_device_path
+		/// (the resolved /sys/block/<name> path in Linux) is used to find the PCI function of the
+		/// host adapter. If neither is available, the drive is its own group.
+		[[nodiscard]] static std::string get_controller_key(const StorageDevice& drive, const std::string& sysfs_device_path);
+
+
+		/// Get the enclosure group of a drive: the Areca enclosure (e.g. "areca,3/1"), or the
+		/// SAS expander in \c sysfs_device_path. Empty if not in an enclosure.
+		[[nodiscard]] static std::string get_enclosure_key(const StorageDevice& drive, const std::string& sysfs_device_path);
+
+
+		/// Get the resolved sysfs path of a drive's block device (Linux only, empty otherwise)
+		[[nodiscard]] static std::string get_sysfs_device_path(const StorageDevice& drive);
+
+
+		/// Get the default state file ("$HOME/.config/gsmartcontrol/selftest_fleet.json" in UNIX).
+		[[nodiscard]] static hz::fs::path get_default_state_file();
+
+
+	private:
+
+		/// Write the state file
+		void save();
+
+		/// Find the job of a drive key. \return nullptr if not found.
+		SelfTestFleetJob* find_job(const std::string& key);
+
+		/// Check whether a pending job can be started without exceeding the limits
+		[[nodiscard]] bool get_can_start(const SelfTestFleetJob& job) const;
+
+
+		/// A drive and its test
+		struct Slot {
+			std::size_t job_index = 0;  ///< Index in jobs_
+			StorageDevicePtr drive;  ///< The drive
+			std::shared_ptr<SelfTest> test;  ///< The running test, if any
+			std::chrono::steady_clock::time_point next_poll;  ///< When the test should be polled
+		};
+
+		SelfTest::TestType type_;  ///< Test type
+		Limits limits_;  ///< Limits
+		hz::fs::path state_file_;  ///< State file
+
+		std::vector<SelfTestFleetJob> jobs_;  ///< Jobs, persisted
+		std::vector<Slot> slots_;  ///< Drives of the jobs, by set_drives()
+		std::error_code save_error_;  ///< Last save() error
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,164 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+#include "hz/string_num.h"
+#include "app_regex.h"
+#include "storage_property.h"
+#include "selftest_selective.h"
+
+
+
+std::optional<std::uint64_t> selftest_parse_lba(std::string_view str)
+{
+	std::string digits;
+	int base = 10;
+	if (str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+		digits = std::string(str.substr(2));
+		base = 16;
+	} else {
+		// Skip the digit grouping of the locale-formatted numbers
+		for (const char c : str) {
+			if (c >= '0' && c <= '9') {
+				digits += c;
+			}
+		}
+	}
+	std::uint64_t lba = 0;
+	if (digits.empty() || !hz::string_is_numeric_nolocale(digits, lba, true, base)) {
+		return std::nullopt;
+	}
+	return lba;
+}
+
+
+
+std::vector<std::uint64_t> selftest_get_error_lbas(const StoragePropertyRepository& properties)
+{
+	std::vector<std::uint64_t> lbas;
+	for (const auto& p : properties.get_properties()) {
+		if (p.is_value_type<AtaStorageErrorBlock>()) {
+			// 0 means the LBA is not reported
+			if (const auto lba = p.get_value<AtaStorageErrorBlock>().lba; lba != 0) {
+				lbas.push_back(lba);
+			}
+		} else if (p.is_value_type<AtaStorageSelftestEntry>()) {
+			if (auto lba = selftest_parse_lba(p.get_value<AtaStorageSelftestEntry>().lba_of_first_error); lba.has_value()) {
+				lbas.push_back(lba.value());
+			}
+		}
+	}
+	std::sort(lbas.begin(), lbas.end());
+	lbas.erase(std::unique(lbas.begin(), lbas.end()), lbas.end());
+	return lbas;
+}
+
+
+
+std::uint64_t selftest_get_logical_sector_size(const StoragePropertyRepository& properties)
+{
+	// "512 bytes logical, 4096 bytes physical", "4096 bytes logical/physical"
+	for (const auto* name : {"physical_block_size/_and/logical_block_size", "logical_block_size"}) {
+		const StorageProperty* p = properties.find_property(name);
+		if (!p) {
+			continue;
+		}
+		if (p->is_value_type<std::int64_t>() && p->get_value<std::int64_t>() > 0) {
+			return static_cast<std::uint64_t>(p->get_value<std::int64_t>());
+		}
+		std::string size_str;
+		std::uint64_t size = 0;
+		if (p->is_value_type<std::string>()
+				&& app_regex_partial_match("/([0-9]+) bytes(?: logical|$)/i", p->get_value<std::string>(), &size_str)
+				&& hz::string_is_numeric_nolocale(size_str, size) && size > 0) {
+			return size;
+		}
+	}
+	return 512;
+}
+
+
+
+std::optional<std::uint64_t> selftest_get_max_lba(const StoragePropertyRepository& properties)
+{
+	const StorageProperty* p = properties.find_property("user_capacity/bytes");
+	if (!p || !p->is_value_type<std::int64_t>() || p->get_value<std::int64_t>() <= 0) {
+		return std::nullopt;
+	}
+	const std::uint64_t sectors = static_cast<std::uint64_t>(p->get_value<std::int64_t>()) / selftest_get_logical_sector_size(properties);
+	if (sectors == 0) {
+		return std::nullopt;
+	}
+	return sectors - 1;
+}
+
+
+
+std::vector<SelfTestLbaSpan> selftest_plan_selective_spans(std::vector<std::uint64_t> lbas,
+		std::uint64_t radius, std::optional<std::uint64_t> max_lba, std::size_t max_spans)
+{
+	std::sort(lbas.begin(), lbas.end());
+
+	std::vector<SelfTestLbaSpan> spans;
+	for (const std::uint64_t lba : lbas) {
+		if (max_lba.has_value() && lba > max_lba.value()) {
+			continue;  // from a different drive (or a wrong capacity)
+		}
+		SelfTestLbaSpan span;
+		span.start = (lba > radius ? lba - radius : 0);
+		span.end = (std::numeric_limits<std::uint64_t>::max() - lba > radius ? lba + radius : std::numeric_limits<std::uint64_t>::max());
+		if (max_lba.has_value()) {
+			span.end = std::min(span.end, max_lba.value());
+		}
+
+		// The LBAs are sorted, so only the last span may overlap
+		if (!spans.empty() && (spans.back().end == std::numeric_limits<std::uint64_t>::max() || span.start <= spans.back().end + 1)) {
+			spans.back().end = std::max(spans.back().end, span.end);
+		} else {
+			spans.push_back(span);
+		}
+	}
+
+	// Merge the closest ones until they fit
+	while (max_spans > 0 && spans.size() > max_spans) {
+		std::size_t closest = 0;
+		for (std::size_t i = 1; i + 1 < spans.size(); ++i) {
+			if (spans[i + 1].start - spans[i].end < spans[closest + 1].start - spans[closest].end) {
+				closest = i;
+			}
+		}
+		spans[closest].end = spans[closest + 1].end;
+		spans.erase(spans.begin() + static_cast<std::ptrdiff_t>(closest) + 1);
+	}
+
+	return spans;
+}
+
+
+
+std::uint64_t selftest_get_spans_sector_count(const std::vector<SelfTestLbaSpan>& spans)
+{
+	std::uint64_t count = 0;
+	for (const auto& span : spans) {
+		count += span.end - span.start + 1;
+	}
+	return count;
+}
+
+
+
+
+
+
+/// @}
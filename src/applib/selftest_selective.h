@@ -0,0 +1,73 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef SELFTEST_SELECTIVE_H
+#define SELFTEST_SELECTIVE_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "storage_property_repository.h"
+
+
+
+/// An LBA span of a selective self-test. Both ends are inclusive.
+struct SelfTestLbaSpan {
+	std::uint64_t start = 0;  ///< First LBA
+	std::uint64_t end = 0;  ///< Last LBA
+
+	/// Comparison
+	bool operator==(const SelfTestLbaSpan& other) const = default;
+};
+
+
+/// Maximum number of spans in one selective self-test (ATA selective self-test log limit)
+constexpr std::size_t selftest_max_selective_spans = 5;
+
+
+
+/// Parse the "LBA of first error" of a self-test log entry (decimal, possibly with
+/// digit grouping, or hexadecimal with 0x prefix). \return std::nullopt if there is no LBA ("-").
+[[nodiscard]] std::optional<std::uint64_t> selftest_parse_lba(std::string_view str);
+
+
+/// Get the LBAs recorded in the ATA error log and the self-test log, sorted and unique.
+[[nodiscard]] std::vector<std::uint64_t> selftest_get_error_lbas(const StoragePropertyRepository& properties);
+
+
+/// Get the logical sector size of a drive, 512 if not reported.
+[[nodiscard]] std::uint64_t selftest_get_logical_sector_size(const StoragePropertyRepository& properties);
+
+
+/// Get the last LBA of a drive, computed from its capacity. \return std::nullopt if the capacity is unknown.
+[[nodiscard]] std::optional<std::uint64_t> selftest_get_max_lba(const StoragePropertyRepository& properties);
+
+
+/// Plan the spans of a selective self-test covering \c radius sectors around each LBA.
+/// The spans are clamped to \c max_lba (if set) and sorted; overlapping and adjacent spans are merged.
+/// If there are more than \c max_spans spans, the ones with the smallest gaps between them
+/// are merged, so the test covers the gaps too.
+[[nodiscard]] std::vector<SelfTestLbaSpan> selftest_plan_selective_spans(std::vector<std::uint64_t> lbas,
+		std::uint64_t radius, std::optional<std::uint64_t> max_lba, std::size_t max_spans = selftest_max_selective_spans);
+
+
+/// Get the number of sectors covered by the spans
+[[nodiscard]] std::uint64_t selftest_get_spans_sector_count(const std::vector<SelfTestLbaSpan>& spans);
+
+
+
+
+#endif
+
+/// @}
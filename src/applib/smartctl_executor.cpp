@@ -15,15 +15,20 @@ Copyright:
 #include "hz/win32_tools.h"
 #include "rconfig/rconfig.h"
 #include "app_regex.h"
+#include "storage_settings.h"
 #include "hz/fs.h"
+#include "hz/string_algo.h"
 #include "build_config.h"
+#include <memory>
+#include <string_view>
 #include <vector>
 
 
 
 hz::fs::path get_smartctl_binary()
 {
-	auto smartctl_binary = hz::fs_path_from_string(rconfig::get_data<std::string>("system/smartctl_binary"));
+	static const rconfig::Key<std::string> smartctl_binary_key("system/smartctl_binary");
+	auto smartctl_binary = hz::fs_path_from_string(smartctl_binary_key.get());
 
 	if (BuildEnv::is_kernel_family_windows()) {
 		// Look in smartmontools installation directory.
@@ -81,9 +86,43 @@ hz::fs::path get_smartctl_binary()
 
 
 
+namespace {
+
+	/// Convert the newlines to unix ones and remove the leading whitespace, copying
+	/// the output only if it needs any of that (the trailing whitespace is kept).
+	CommandOutputPtr normalize_smartctl_output(CommandOutputPtr output)
+	{
+		const std::string& str = *output;
+		const bool needs_trim = !str.empty() && std::string_view(" \t\r\n").find(str.front()) != std::string_view::npos;
+		if (needs_trim || str.find('\r') != std::string::npos) {  // '\r' is needed for windows
+			return std::make_shared<const std::string>(hz::string_any_to_unix_copy(hz::string_trim_view(str)));
+		}
+		return output;
+	}
+
+
+	/// Get the type argument of the last "-d" / "--device" option, empty if none
+	std::string get_smartctl_type_argument(const std::vector<std::string>& device_opts)
+	{
+		std::string type_arg;
+		for (std::size_t i = 0; i < device_opts.size(); ++i) {
+			const std::string& opt = device_opts[i];
+			if ((opt == "-d" || opt == "--device") && i + 1 < device_opts.size()) {
+				type_arg = device_opts[++i];
+			} else if (opt.starts_with("--device=")) {
+				type_arg = opt.substr(std::string_view("--device=").size());
+			}
+		}
+		return type_arg;
+	}
+
+}
+
+
+
 hz::ExpectedVoid<SmartctlExecutorError> execute_smartctl(const std::string& device, const std::vector<std::string>& device_opts,
 		const std::vector<std::string>& command_options,
-		std::shared_ptr<CommandExecutor> smartctl_ex, std::string& smartctl_output)
+		std::shared_ptr<CommandExecutor> smartctl_ex, CommandOutputPtr& smartctl_output, CommandOperation operation)
 {
 	// win32 doesn't have slashes in devices names. For others, check that slash is present.
 	if (!BuildEnv::is_kernel_family_windows()) {
@@ -97,49 +136,62 @@ hz::ExpectedVoid<SmartctlExecutorError> execute_smartctl(const std::string& devi
 
 	if (!smartctl_ex)  // if it doesn't exist, create a default one
 		smartctl_ex = std::make_shared<SmartctlExecutor>();
+	smartctl_ex->set_operation(operation);
 
-	auto smartctl_binary = get_smartctl_binary();
+	// The local smartctl binary setting is irrelevant for remote hosts
+	const RemoteHostPtr remote_host = smartctl_ex->get_remote_host();
+	auto smartctl_binary = remote_host ? hz::fs_path_from_string(remote_host->get_smartctl_binary()) : get_smartctl_binary();
 
 	if (smartctl_binary.empty()) {
 		debug_out_error("app", DBG_FUNC_MSG << "Smartctl binary is not set in config.\n");
 		return hz::Unexpected(SmartctlExecutorError::NoBinary, _("Smartctl binary is not specified in configuration."));
 	}
 
-	auto smartctl_def_options_str = hz::string_trim_copy(rconfig::get_data<std::string>("system/smartctl_options"));
-	std::vector<std::string> smartctl_options;
-	if (!smartctl_def_options_str.empty()) {
-		try {
-			smartctl_options = Glib::shell_parse_argv(smartctl_def_options_str);
-		}
-		catch(Glib::ShellError& e)
-		{
-			return hz::Unexpected(SmartctlExecutorError::InvalidCommandLine, _("Invalid command line specified."));
-		}
+	auto smartctl_def_options = app_get_smartctl_default_options();
+	if (!smartctl_def_options.has_value()) {
+		return hz::Unexpected(SmartctlExecutorError::InvalidCommandLine, _("Invalid command line specified."));
 	}
+	std::vector<std::string> smartctl_options = std::move(smartctl_def_options.value());
 	smartctl_options.insert(smartctl_options.end(), device_opts.begin(), device_opts.end());
 	smartctl_options.insert(smartctl_options.end(), command_options.begin(), command_options.end());
 	smartctl_options.push_back(device);
 
 	smartctl_ex->set_command(hz::fs_path_to_string(smartctl_binary), smartctl_options);
 
+	// Account the execution per device and per option set (without the device and the default options)
+	std::vector<std::string> statistics_options = device_opts;
+	statistics_options.insert(statistics_options.end(), command_options.begin(), command_options.end());
+	const std::string device_key = (remote_host ? remote_host->get_destination() + ":" + device : device);
+	smartctl_ex->set_statistics_keys(device_key, hz::string_join(statistics_options, " "));
+
+	// Limit the concurrent passthrough commands on the same controller
+	smartctl_ex->set_serialization_domain(cmdex_get_serialization_domain(device_key, get_smartctl_type_argument(device_opts)));
+
 	if (!smartctl_ex->execute() || !smartctl_ex->get_error_msg().empty()) {
 		debug_out_warn("app", DBG_FUNC_MSG << "Smartctl binary did not execute cleanly.\n");
 
-		smartctl_output = hz::string_trim_copy(hz::string_any_to_unix_copy(smartctl_ex->get_stdout_str()));
+		smartctl_output = normalize_smartctl_output(smartctl_ex->get_stdout_buffer());
 
 		// check if it's a device permission error.
 		// Smartctl open device: /dev/sdb failed: Permission denied
-		if (app_regex_partial_match("/Smartctl open device.+Permission denied/mi", smartctl_output)) {
+		if (app_regex_partial_match("/Smartctl open device.+Permission denied/mi", *smartctl_output)) {
 			return hz::Unexpected(SmartctlExecutorError::PermissionDenied, _("Permission denied while opening device."));
 		}
 
 		// smartctl_output = smartctl_ex->get_stdout_str();
+		if (remote_host) {
+			// SSH reports the connection and authentication errors on stderr
+			if (const std::string ssh_error = hz::string_trim_copy(smartctl_ex->get_stderr_str()); !ssh_error.empty()) {
+				return hz::Unexpected(SmartctlExecutorError::ExecutionError,
+						Glib::ustring::compose(_("Error executing smartctl on %1: %2"), remote_host->get_destination(), ssh_error));
+			}
+		}
 		return hz::Unexpected(SmartctlExecutorError::ExecutionError, smartctl_ex->get_error_msg());
 	}
 
-	// any_to_unix is needed for windows
-	smartctl_output = hz::string_trim_copy(hz::string_any_to_unix_copy(smartctl_ex->get_stdout_str()));
-	if (smartctl_output.empty()) {
+	// The output is shared with the executor (and its log), not copied.
+	smartctl_output = normalize_smartctl_output(smartctl_ex->get_stdout_buffer());
+	if (hz::string_trim_view(*smartctl_output).empty()) {
 		debug_out_error("app", DBG_FUNC_MSG << "Smartctl returned an empty output.\n");
 		return hz::Unexpected(SmartctlExecutorError::EmptyOutput, _("Smartctl returned an empty output."));
 	}
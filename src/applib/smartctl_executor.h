@@ -54,6 +54,8 @@ class SmartctlExecutorGeneric : public ExecutorSync {
 		void construct()
 		{
 			ExecutorSync::get_async_executor().set_exit_status_translator(&SmartctlExecutorGeneric::translate_exit_status);
+			// Large outputs (e.g. -x with extended logs) shouldn't be limited by the channel buffers.
+			ExecutorSync::get_async_executor().set_streaming(true);
 			this->set_error_header(std::string(_("An error occurred while executing smartctl:")) + "\n\n");
 		}
 
@@ -106,12 +108,12 @@ class SmartctlExecutorGeneric : public ExecutorSync {
 
 			AsyncCommandExecutor::error_list_t errors = cmdex.get_errors();  // these are not clones
 
-			hz::ErrorBase* e = nullptr;
+			std::shared_ptr<hz::ErrorBase> e;  // shared with the list, no need to clone
 			// find the last relevant error.
 			for (const auto& error : std::ranges::reverse_view(errors)) {
 				// ignore iochannel errors, they may mask the real errors
 				if (error->get_type() != "giochannel" && error->get_type() != "custom") {
-					e = error->clone();
+					e = error;
 					break;
 				}
 			}
@@ -119,7 +121,7 @@ class SmartctlExecutorGeneric : public ExecutorSync {
 			cmdex.clear_errors();  // and clear them
 
 			if (e) {  // if error is present, alert the user
-				on_error_warn(e);
+				on_error_warn(e.get());
 			}
 		}
 
@@ -181,11 +183,14 @@ enum class SmartctlExecutorError {
 };
 
 
-/// Execute smartctl on device \c device.
+/// Execute smartctl on device \c device. \c smartctl_output is set to the output, with unix
+/// newlines and without leading whitespace. It's shared with the executor, not copied.
+/// \c operation selects the execution policy (see CommandExecutor::set_operation()).
 /// \return error message on error, empty string on success.
 [[nodiscard]] hz::ExpectedVoid<SmartctlExecutorError> execute_smartctl(const std::string& device, const std::vector<std::string>& device_opts,
 		const std::vector<std::string>& command_options,
-		std::shared_ptr<CommandExecutor> smartctl_ex, std::string& smartctl_output);
+		std::shared_ptr<CommandExecutor> smartctl_ex, CommandOutputPtr& smartctl_output,
+		CommandOperation operation = CommandOperation::Other);
 
 
 
@@ -11,11 +11,14 @@ Copyright:
 
 #include "smartctl_json_ata_parser.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <utility>
 #include <vector>
 #include <chrono>
 
@@ -30,7 +33,9 @@ Copyright:
 #include "hz/error_container.h"
 #include "hz/string_num.h"
 #include "smartctl_json_parser_helpers.h"
+#include "app_trace.h"
 #include "smartctl_parser_types.h"
+#include "storage_error_log_journal.h"
 
 
 /*
@@ -78,18 +83,17 @@ Information not printed in JSON yet:
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse(std::string_view smartctl_output)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse", "parser");
 	if (hz::string_trim_copy(smartctl_output).empty()) {
 		debug_out_warn("app", DBG_FUNC_MSG << "Empty string passed as an argument. Returning.\n");
 		return hz::Unexpected(SmartctlParserError::EmptyInput, "Smartctl data is empty.");
 	}
 
-	nlohmann::json json_root_node;
-	try {
-		json_root_node = nlohmann::json::parse(smartctl_output);
-	} catch (const nlohmann::json::parse_error& e) {
-		debug_out_warn("app", DBG_FUNC_MSG << "Error parsing smartctl output as JSON: " << e.what() << "\n");
-		return hz::Unexpected(SmartctlParserError::SyntaxError, std::string("Invalid JSON data: ") + e.what());
+	auto parsed_json = SmartctlJsonParserHelpers::parse_json_document(smartctl_output, get_keep_text_output());
+	if (!parsed_json) {
+		return hz::Unexpected(SmartctlParserError::SyntaxError, parsed_json.error().message());
 	}
+	const nlohmann::json& json_root_node = parsed_json.value();
 
 	StorageProperty merged_property, full_property;
 	auto version_parse_status = SmartctlJsonParserHelpers::parse_version(json_root_node, merged_property, full_property);
@@ -105,83 +109,39 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse(std::string_v
 		return info_parse_status;
 	}
 
-	// Add properties for each parsed section so that the UI knows which tabs to show or hide
-	{
-		auto section_parse_status = parse_section_health(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::Health;
-//		p.set_name("_parser/health_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_capabilities(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::Capabilities;
-//		p.set_name("_parser/capabilities_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_attributes(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::Attributes;
-//		p.set_name("_parser/attributes_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_directory_log(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::DirectoryLog;
-//		p.set_name("_parser/directory_log_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_error_log(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::ErrorLog;
-//		p.set_name("_parser/error_log_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_selftest_log(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::SelftestLog;
-//		p.set_name("_parser/selftest_log_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_selective_selftest_log(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::SelectiveSelftestLog;
-//		p.set_name("_parser/selective_selftest_log_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_scttemp_log(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::TemperatureLog;
-//		p.set_name("_parser/temperature_log_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_scterc_log(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::ErcLog;
-//		p.set_name("_parser/erc_log_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
-	}
-	{
-		auto section_parse_status = parse_section_devstat(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::Devstat;
-//		p.set_name("_parser/devstat_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
+	// Add properties for each parsed section so that the UI knows which tabs to show or hide.
+	// The sections read disjoint parts of the document, so the huge ones (large error logs,
+	// device statistics) may be parsed concurrently.
+	using section_method_t = hz::ExpectedVoid<SmartctlParserError> (SmartctlJsonAtaParser::*)(const nlohmann::json&);
+	static const std::vector<std::pair<StoragePropertySection, section_method_t>> section_methods = {
+		{StoragePropertySection::OverallHealth, &SmartctlJsonAtaParser::parse_section_health},
+		{StoragePropertySection::Capabilities, &SmartctlJsonAtaParser::parse_section_capabilities},
+		{StoragePropertySection::AtaAttributes, &SmartctlJsonAtaParser::parse_section_attributes},
+		{StoragePropertySection::DirectoryLog, &SmartctlJsonAtaParser::parse_section_directory_log},
+		{StoragePropertySection::AtaErrorLog, &SmartctlJsonAtaParser::parse_section_error_log},
+		{StoragePropertySection::SelftestLog, &SmartctlJsonAtaParser::parse_section_selftest_log},
+		{StoragePropertySection::SelectiveSelftestLog, &SmartctlJsonAtaParser::parse_section_selective_selftest_log},
+		{StoragePropertySection::TemperatureLog, &SmartctlJsonAtaParser::parse_section_scttemp_log},
+		{StoragePropertySection::ErcLog, &SmartctlJsonAtaParser::parse_section_scterc_log},
+		{StoragePropertySection::Statistics, &SmartctlJsonAtaParser::parse_section_devstat},
+		{StoragePropertySection::PhyLog, &SmartctlJsonAtaParser::parse_section_sataphy},
+	};
+
+	std::vector<section_parse_func_t> section_funcs;
+	for (const auto& [section, method] : section_methods) {
+		if (get_section_requested(section)) {
+			section_funcs.emplace_back([&json_root_node, method = method](SmartctlParser& parser) {
+				return (static_cast<SmartctlJsonAtaParser&>(parser).*method)(json_root_node).has_value();
+			});
+		}
 	}
-	{
-		auto section_parse_status = parse_section_sataphy(json_root_node);
-//		StorageProperty p;
-//		p.section = StoragePropertySection::PhyLog;
-//		p.set_name("_parser/phy_log_section_available");
-//		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
+
+	if (get_parallel_parse_enabled(smartctl_output.size())) {
+		static_cast<void>(parse_sections_concurrently(section_funcs));
+	} else {
+		for (const auto& func : section_funcs) {
+			func(*this);
+		}
 	}
 
 	return {};
@@ -189,8 +149,72 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse(std::string_v
 
 
 
+std::unique_ptr<SmartctlParser> SmartctlJsonAtaParser::create_section_parser() const
+{
+	return std::make_unique<SmartctlJsonAtaParser>();
+}
+
+
+
+std::optional<AtaStorageSelftestEntry> SmartctlJsonAtaParser::parse_selftest_status(const nlohmann::json& json_root_node)
+{
+	using namespace SmartctlJsonParserHelpers;
+
+	// Testing:
+	// "status": {
+	//   "value": 249,
+	//   "string": "in progress, 90% remaining",
+	//   "remaining_percent": 90
+	// },
+
+	// Not testing:
+	// "status": {
+	//   "value": 0,
+	//   "string": "completed without error",
+	//   "passed": true
+	// },
+
+	auto value_val = get_node_data_optional<uint8_t>(json_root_node, "ata_smart_data/self_test/status/value");
+	if (!value_val.has_value()) {
+		return std::nullopt;
+	}
+
+	AtaStorageSelftestEntry::Status status = AtaStorageSelftestEntry::Status::Unknown;
+	switch (value_val.value() >> 4) {
+		// Data from smartmontools/ataprint.cpp
+		case 0x0: status = AtaStorageSelftestEntry::Status::CompletedNoError; break;
+		case 0x1: status = AtaStorageSelftestEntry::Status::AbortedByHost; break;
+		case 0x2: status = AtaStorageSelftestEntry::Status::Interrupted; break;
+		case 0x3: status = AtaStorageSelftestEntry::Status::FatalOrUnknown; break;
+		case 0x4: status = AtaStorageSelftestEntry::Status::ComplUnknownFailure; break;
+		case 0x5: status = AtaStorageSelftestEntry::Status::ComplElectricalFailure; break;
+		case 0x6: status = AtaStorageSelftestEntry::Status::ComplServoFailure; break;
+		case 0x7: status = AtaStorageSelftestEntry::Status::ComplReadFailure; break;
+		case 0x8: status = AtaStorageSelftestEntry::Status::ComplHandlingDamage; break;
+		// Special case
+		case 0xf: status = AtaStorageSelftestEntry::Status::InProgress; break;
+		default: status = AtaStorageSelftestEntry::Status::Reserved; break;
+	}
+
+	AtaStorageSelftestEntry sse;
+	sse.test_num = 0;  // capability uses 0
+	sse.status_str = AtaStorageSelftestEntry::get_readable_status_name(status);
+	sse.status = status;
+
+	sse.remaining_percent = -1;  // unknown or n/a
+	// Present only when extended self-test log is supported
+	if (auto remaining_percent_val = get_node_data_optional<int8_t>(json_root_node, "ata_smart_data/self_test/status/remaining_percent"); remaining_percent_val.has_value()) {
+		sse.remaining_percent = remaining_percent_val.value();
+	}
+
+	return sse;
+}
+
+
+
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_info", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	// This is very similar to Basic Parser, but the Basic Parser supports different drive types, while this
@@ -203,9 +227,9 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
 					auto table_node = get_node(root_node, "smartctl/output");
-					if (table_node.has_value() && table_node->is_array() && !table_node.value().empty()) {
+					if (table_node.has_value() && table_node.value()->is_array() && !table_node.value()->empty()) {
 						std::vector<std::string> lines;
-						for (const auto& entry : table_node.value()) {
+						for (const auto& entry : *table_node.value()) {
 							lines.emplace_back(entry.get<std::string>());
 						}
 						StorageProperty p;
@@ -222,7 +246,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto jval = get_node_data<std::string>(root_node, "device/type"); jval.has_value()) {
+					if (auto jval = get_node_data_optional<std::string>(root_node, "device/type"); jval.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.value = jval.value();
@@ -237,7 +261,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto jval = get_node_data<std::string>(root_node, "device/protocol"); jval.has_value()) {
+					if (auto jval = get_node_data_optional<std::string>(root_node, "device/protocol"); jval.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.value = jval.value();
@@ -256,9 +280,9 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					auto jval1 = get_node_data<int64_t>(root_node, "wwn/naa");
-					auto jval2 = get_node_data<int64_t>(root_node, "wwn/oui");
-					auto jval3 = get_node_data<int64_t>(root_node, "wwn/id");
+					auto jval1 = get_node_data_optional<int64_t>(root_node, "wwn/naa");
+					auto jval2 = get_node_data_optional<int64_t>(root_node, "wwn/oui");
+					auto jval3 = get_node_data_optional<int64_t>(root_node, "wwn/id");
 
 					if (jval1 && jval2 && jval3) {
 						StorageProperty p;
@@ -288,7 +312,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto jval = get_node_data<int64_t>(root_node, "user_capacity/bytes"); jval) {
+					if (auto jval = get_node_data_optional<int64_t>(root_node, "user_capacity/bytes"); jval) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.readable_value = hz::format_size(static_cast<uint64_t>(jval.value()), true);
@@ -305,10 +329,10 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
 					std::vector<std::string> values;
-					if (auto jval1 = get_node_data<int64_t>(root_node, "logical_block_size"); jval1) {
+					if (auto jval1 = get_node_data_optional<int64_t>(root_node, "logical_block_size"); jval1) {
 						values.emplace_back(fmt::format("{} bytes logical", jval1.value()));
 					}
-					if (auto jval2 = get_node_data<int64_t>(root_node, "physical_block_size"); jval2) {
+					if (auto jval2 = get_node_data_optional<int64_t>(root_node, "physical_block_size"); jval2) {
 						values.emplace_back(fmt::format("{} bytes physical", jval2.value()));
 					}
 					if (!values.empty()) {
@@ -337,10 +361,10 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
 					std::vector<std::string> values;
-					if (auto jval1 = get_node_data<std::string>(root_node, "interface_speed/max/string"); jval1) {
+					if (auto jval1 = get_node_data_optional<std::string>(root_node, "interface_speed/max/string"); jval1) {
 						values.emplace_back(fmt::format("Max: {}", jval1.value()));
 					}
-					if (auto jval2 = get_node_data<std::string>(root_node, "interface_speed/current/string"); jval2) {
+					if (auto jval2 = get_node_data_optional<std::string>(root_node, "interface_speed/current/string"); jval2) {
 						values.emplace_back(fmt::format("Current: {}", jval2.value()));
 					}
 					if (!values.empty()) {
@@ -364,8 +388,8 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto level_result = get_node_data<int64_t>(root_node, "ata_aam/level"); level_result.has_value()) {
-						std::string level_string = get_node_data<std::string>(root_node, "ata_aam/string").value_or("");
+					if (auto level_result = get_node_data_optional<int64_t>(root_node, "ata_aam/level"); level_result.has_value()) {
+						std::string level_string = get_node_data_optional<std::string>(root_node, "ata_aam/string").value_or("");
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.readable_value = fmt::format("{} ({})", level_string, level_result.value());
@@ -382,8 +406,8 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto level_result = get_node_data<int64_t>(root_node, "ata_apm/level"); level_result.has_value()) {
-						std::string level_string = get_node_data<std::string>(root_node, "ata_apm/string").value_or("");
+					if (auto level_result = get_node_data_optional<int64_t>(root_node, "ata_apm/level"); level_result.has_value()) {
+						std::string level_string = get_node_data_optional<std::string>(root_node, "ata_apm/string").value_or("");
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.readable_value = fmt::format("{} ({})", level_string, level_result.value());
@@ -427,6 +451,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_info(
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_health(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_health", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	const std::vector<std::tuple<std::string, std::string, PropertyRetrievalFunc>> health_keys = {
@@ -450,6 +475,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_healt
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capabilities(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_capabilities", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	static const std::vector<std::tuple<std::string, std::string, PropertyRetrievalFunc>> json_keys = {
@@ -468,7 +494,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 					[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 							-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					auto value_val = get_node_data<int64_t>(root_node, "ata_smart_data/offline_data_collection/status/value");
+					auto value_val = get_node_data_optional<int64_t>(root_node, "ata_smart_data/offline_data_collection/status/value");
 					if (value_val.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
@@ -486,7 +512,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					auto value_val = get_node_data<uint8_t>(root_node, "ata_smart_data/offline_data_collection/status/value");
+					auto value_val = get_node_data_optional<uint8_t>(root_node, "ata_smart_data/offline_data_collection/status/value");
 					if (value_val.has_value()) {
 						std::string status_str;
 						switch (value_val.value() & 0x7f) {
@@ -513,7 +539,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 					[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 							-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					auto value_val = get_node_data<int64_t>(root_node, key);
+					auto value_val = get_node_data_optional<int64_t>(root_node, key);
 					if (value_val.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
@@ -528,54 +554,10 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					// Testing:
-					// "status": {
-					//   "value": 249,
-					//   "string": "in progress, 90% remaining",
-					//   "remaining_percent": 90
-					// },
-
-					// Not testing:
-					// "status": {
-					//   "value": 0,
-					//   "string": "completed without error",
-					//   "passed": true
-					// },
-
-					AtaStorageSelftestEntry::Status status = AtaStorageSelftestEntry::Status::Unknown;
-
-					auto value_val = get_node_data<uint8_t>(root_node, "ata_smart_data/self_test/status/value");
-					if (value_val.has_value()) {
-						switch (value_val.value() >> 4) {
-							// Data from smartmontools/ataprint.cpp
-							case 0x0: status = AtaStorageSelftestEntry::Status::CompletedNoError; break;
-							case 0x1: status = AtaStorageSelftestEntry::Status::AbortedByHost; break;
-							case 0x2: status = AtaStorageSelftestEntry::Status::Interrupted; break;
-							case 0x3: status = AtaStorageSelftestEntry::Status::FatalOrUnknown; break;
-							case 0x4: status = AtaStorageSelftestEntry::Status::ComplUnknownFailure; break;
-							case 0x5: status = AtaStorageSelftestEntry::Status::ComplElectricalFailure; break;
-							case 0x6: status = AtaStorageSelftestEntry::Status::ComplServoFailure; break;
-							case 0x7: status = AtaStorageSelftestEntry::Status::ComplReadFailure; break;
-							case 0x8: status = AtaStorageSelftestEntry::Status::ComplHandlingDamage; break;
-							// Special case
-							case 0xf: status = AtaStorageSelftestEntry::Status::InProgress; break;
-							default: status = AtaStorageSelftestEntry::Status::Reserved; break;
-						}
-
-						AtaStorageSelftestEntry sse;
-						sse.test_num = 0;  // capability uses 0
-						sse.status_str = AtaStorageSelftestEntry::get_readable_status_name(status);
-						sse.status = status;
-
-						sse.remaining_percent = -1;  // unknown or n/a
-						// Present only when extended self-test log is supported
-						if (auto remaining_percent_val = get_node_data<int8_t>(root_node, "ata_smart_data/self_test/status/remaining_percent"); remaining_percent_val.has_value()) {
-							sse.remaining_percent = remaining_percent_val.value();
-						}
-
+					if (auto sse = parse_selftest_status(root_node); sse.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
-						p.value = sse;
+						p.value = sse.value();
 						return p;
 					}
 
@@ -599,7 +581,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 					[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 							-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					auto value_val = get_node_data<int64_t>(root_node, key);
+					auto value_val = get_node_data_optional<int64_t>(root_node, key);
 					if (value_val.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
@@ -614,7 +596,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 					[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 							-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					auto value_val = get_node_data<int64_t>(root_node, key);
+					auto value_val = get_node_data_optional<int64_t>(root_node, key);
 					if (value_val.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
@@ -629,7 +611,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 					[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 							-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					auto value_val = get_node_data<int64_t>(root_node, key);
+					auto value_val = get_node_data_optional<int64_t>(root_node, key);
 					if (value_val.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
@@ -650,13 +632,10 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 							-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto value_val = get_node_exists(root_node, "ata_sct_capabilities"); value_val.has_value()) {
-						StorageProperty p;
-						p.set_name(key, displayable_name);
-						p.value = value_val.value();
-						return p;
-					}
-					return hz::Unexpected(SmartctlParserError::KeyNotFound, fmt::format("Error getting key {} from JSON data.", key));
+					StorageProperty p;
+					p.set_name(key, displayable_name);
+					p.value = (find_node(root_node, "ata_sct_capabilities") != nullptr);
+					return p;
 				}
 			},
 			{"ata_sct_capabilities/error_recovery_control_supported", _("SCT error recovery control supported"), bool_formatter(_("Yes"), _("No"))},
@@ -689,37 +668,35 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_capab
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_attributes(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_attributes", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
 
 	// Revision
-	if (get_node_exists(json_root_node, "ata_smart_attributes/revision").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_smart_attributes/revision", _("Data structure revision number"));
-		p.section = StoragePropertySection::AtaAttributes;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_smart_attributes/revision").value_or(0);
-		add_property(p);
-		section_properties_found = true;
-	}
+	const JsonFieldMapping fields[] = {
+		{"revision", _("Data structure revision number"), JsonFieldType::Integer, ""},
+	};
+	section_properties_found = parse_json_fields(json_root_node, "ata_smart_attributes", fields, StoragePropertySection::AtaAttributes, nullptr,
+			[this](StorageProperty p) { add_property(std::move(p)); });
 
 	const std::string table_key = "ata_smart_attributes/table";
 	auto table_node = get_node(json_root_node, table_key);
 
 	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
-		for (const auto& table_entry : table_node.value()) {
+	if (table_node.has_value() && table_node.value()->is_array()) {
+		for (const auto& table_entry : *table_node.value()) {
 			AtaStorageAttribute a;
 
-			a.id = get_node_data<int32_t>(table_entry, "id").value_or(0);
-			a.flag = get_node_data<std::string>(table_entry, "flags/string").value_or("");
-			a.value = (get_node_exists(table_entry, "value").value_or(false) ? std::optional<uint8_t>(get_node_data<uint8_t>(table_entry, "value").value_or(0)) : std::nullopt);
-			a.worst = (get_node_exists(table_entry, "worst").value_or(false) ? std::optional<uint8_t>(get_node_data<uint8_t>(table_entry, "worst").value_or(0)) : std::nullopt);
-			a.threshold = (get_node_exists(table_entry, "thresh").value_or(false) ? std::optional<uint8_t>(get_node_data<uint8_t>(table_entry, "thresh").value_or(0)) : std::nullopt);
-			a.attr_type = get_node_data<bool>(table_entry, "flags/prefailure").value_or(false) ? AtaStorageAttribute::AttributeType::Prefail : AtaStorageAttribute::AttributeType::OldAge;
-			a.update_type = get_node_data<bool>(table_entry, "flags/updated_online").value_or(false) ? AtaStorageAttribute::UpdateType::Always : AtaStorageAttribute::UpdateType::Offline;
+			a.id = get_node_data_optional<int32_t>(table_entry, "id").value_or(0);
+			a.flag = get_node_data_optional<std::string>(table_entry, "flags/string").value_or("");
+			a.value = ((find_node(table_entry, "value") != nullptr) ? std::optional<uint8_t>(get_node_data_optional<uint8_t>(table_entry, "value").value_or(0)) : std::nullopt);
+			a.worst = ((find_node(table_entry, "worst") != nullptr) ? std::optional<uint8_t>(get_node_data_optional<uint8_t>(table_entry, "worst").value_or(0)) : std::nullopt);
+			a.threshold = ((find_node(table_entry, "thresh") != nullptr) ? std::optional<uint8_t>(get_node_data_optional<uint8_t>(table_entry, "thresh").value_or(0)) : std::nullopt);
+			a.attr_type = get_node_data_optional<bool>(table_entry, "flags/prefailure").value_or(false) ? AtaStorageAttribute::AttributeType::Prefail : AtaStorageAttribute::AttributeType::OldAge;
+			a.update_type = get_node_data_optional<bool>(table_entry, "flags/updated_online").value_or(false) ? AtaStorageAttribute::UpdateType::Always : AtaStorageAttribute::UpdateType::Offline;
 
-			const std::string when_failed = get_node_data<std::string>(table_entry, "when_failed").value_or(std::string());
+			const std::string when_failed = get_node_data_optional<std::string>(table_entry, "when_failed").value_or(std::string());
 			if (when_failed == "now") {
 				a.when_failed = AtaStorageAttribute::FailTime::Now;
 			} else if (when_failed == "past") {
@@ -728,10 +705,10 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_attri
 				a.when_failed = AtaStorageAttribute::FailTime::None;
 			}
 
-			a.raw_value = get_node_data<std::string>(table_entry, "raw/string").value_or(std::string());
-			a.raw_value_int = get_node_data<int64_t>(table_entry, "raw/value").value_or(0);
+			a.raw_value = get_node_data_optional<std::string>(table_entry, "raw/string").value_or(std::string());
+			a.raw_value_int = get_node_data_optional<int64_t>(table_entry, "raw/value").value_or(0);
 
-			std::string reported_name = get_node_data<std::string>(table_entry, "name").value_or(std::string());
+			std::string reported_name = get_node_data_optional<std::string>(table_entry, "name").value_or(std::string());
 
 			StorageProperty p;
 			p.set_name(reported_name, reported_name, reported_name);  // The description database will correct this.
@@ -755,6 +732,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_attri
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_directory_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_directory_log", "parser");
 	using namespace SmartctlJsonParserHelpers;
 	using namespace std::string_literals;
 
@@ -762,52 +740,29 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_direc
 
 	std::vector<std::string> lines;
 
-	if (get_node_exists(json_root_node, "ata_log_directory/gp_dir_version").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_log_directory/gp_dir_version", _("General purpose log directory version"));
-		p.section = StoragePropertySection::DirectoryLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_log_directory/gp_dir_version").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("General Purpose Log Directory Version: {}", p.get_value<int64_t>()));
-		section_properties_found = true;
-	}
-	if (get_node_exists(json_root_node, "ata_log_directory/smart_dir_version").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_log_directory/smart_dir_version", _("SMART log directory version"));
-		p.section = StoragePropertySection::DirectoryLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_log_directory/smart_dir_version").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("SMART Log Directory Version: {}", p.get_value<int64_t>()));
-		section_properties_found = true;
-	}
-	if (get_node_exists(json_root_node, "ata_log_directory/smart_dir_multi_sector").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_log_directory/smart_dir_multi_sector", _("Multi-sector log support"));
-		p.section = StoragePropertySection::DirectoryLog;
-		p.value = get_node_data<bool>(json_root_node, "ata_log_directory/smart_dir_multi_sector").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Multi-sector log support: {}", p.get_value<bool>() ? "Yes" : "No"));
-		section_properties_found = true;
-	}
+	const JsonFieldMapping fields[] = {
+		{"gp_dir_version", _("General purpose log directory version"), JsonFieldType::Integer, "General Purpose Log Directory Version: {}"},
+		{"smart_dir_version", _("SMART log directory version"), JsonFieldType::Integer, "SMART Log Directory Version: {}"},
+		{"smart_dir_multi_sector", _("Multi-sector log support"), JsonFieldType::Bool, "Multi-sector log support: {}"},
+	};
+	section_properties_found = parse_json_fields(json_root_node, "ata_log_directory", fields, StoragePropertySection::DirectoryLog, &lines,
+			[this](StorageProperty p) { add_property(std::move(p)); });
 
 	// Table
 	const std::string table_key = "ata_log_directory/table";
 	auto table_node = get_node(json_root_node, table_key);
 
 	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
+	if (table_node.has_value() && table_node.value()->is_array()) {
 		lines.emplace_back();
 
-		for (const auto& table_entry : table_node.value()) {
-			const uint64_t address = get_node_data<uint64_t>(table_entry, "address").value_or(0);
-			const std::string name = get_node_data<std::string>(table_entry, "name").value_or(std::string());
-			const bool read = get_node_data<bool>(table_entry, "read").value_or(false);
-			const bool write = get_node_data<bool>(table_entry, "write").value_or(false);
-			const uint64_t gp_sectors = get_node_data<uint64_t>(table_entry, "gp_sectors").value_or(0);
-			const uint64_t smart_sectors = get_node_data<uint64_t>(table_entry, "smart_sectors").value_or(0);
+		for (const auto& table_entry : *table_node.value()) {
+			const uint64_t address = get_node_data_optional<uint64_t>(table_entry, "address").value_or(0);
+			const std::string name = get_node_data_optional<std::string>(table_entry, "name").value_or(std::string());
+			const bool read = get_node_data_optional<bool>(table_entry, "read").value_or(false);
+			const bool write = get_node_data_optional<bool>(table_entry, "write").value_or(false);
+			const uint64_t gp_sectors = get_node_data_optional<uint64_t>(table_entry, "gp_sectors").value_or(0);
+			const uint64_t smart_sectors = get_node_data_optional<uint64_t>(table_entry, "smart_sectors").value_or(0);
 
 			// Address, GPL/SL, RO/RW, Num Sectors (GPL, Smart) , Name
 			// 0x00       GPL,SL  R/O      1  Log Directory
@@ -847,42 +802,46 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_direc
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_error_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_error_log", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
 
-	// Revision
-	if (get_node_exists(json_root_node, "ata_smart_error_log/extended/revision").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_smart_error_log/extended/revision", _("SMART extended comprehensive error log version"));
-		p.section = StoragePropertySection::AtaErrorLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_smart_error_log/extended/revision").value_or(0);
-		add_property(p);
-		section_properties_found = true;
-	}
-	// Count
-	if (get_node_exists(json_root_node, "ata_smart_error_log/extended/count").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_smart_error_log/extended/count", _("ATA error count"));
-		p.section = StoragePropertySection::AtaErrorLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_smart_error_log/extended/count").value_or(0);
-		add_property(p);
-		section_properties_found = true;
-	}
+	// Revision and count
+	const JsonFieldMapping fields[] = {
+		{"revision", _("SMART extended comprehensive error log version"), JsonFieldType::Integer, ""},
+		{"count", _("ATA error count"), JsonFieldType::Integer, ""},
+	};
+	section_properties_found = parse_json_fields(json_root_node, "ata_smart_error_log/extended", fields, StoragePropertySection::AtaErrorLog, nullptr,
+			[this](StorageProperty p) { add_property(std::move(p)); });
 
 	const std::string table_key = "ata_smart_error_log/extended/table";
 	auto table_node = get_node(json_root_node, table_key);
 
-	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
-		for (const auto& table_entry : table_node.value()) {
+	// Entries. The ones ingested before are taken from the journal, described already.
+	const auto& journal = get_error_log_journal();
+	if (table_node.has_value() && table_node.value()->is_array()) {
+		std::size_t num_entries = 0;
+		for (const auto& table_entry : *table_node.value()) {
+			if (get_max_log_entries() != 0 && num_entries++ >= get_max_log_entries()) {
+				break;  // only the most recent ones
+			}
 			AtaStorageErrorBlock block;
-			block.error_num = get_node_data<uint32_t>(table_entry, "error_number").value_or(0);
-			block.log_index = get_node_data<uint64_t>(table_entry, "log_index").value_or(0);
-			block.lifetime_hours = get_node_data<uint32_t>(table_entry, "lifetime_hours").value_or(0);
-			block.device_state = get_node_data<std::string>(table_entry, "device_state/string").value_or(std::string());
-			block.lba = get_node_data<uint64_t>(table_entry, "completion_registers/lba").value_or(0);
-			block.type_more_info = get_node_data<std::string>(table_entry, "error_description").value_or(std::string());
+			block.error_num = get_node_data_optional<uint32_t>(table_entry, "error_number").value_or(0);
+			block.log_index = get_node_data_optional<uint64_t>(table_entry, "log_index").value_or(0);
+			block.lifetime_hours = get_node_data_optional<uint32_t>(table_entry, "lifetime_hours").value_or(0);
+
+			const std::uint64_t fingerprint = (static_cast<std::uint64_t>(block.lifetime_hours) << 32) ^ block.log_index;
+			if (journal) {
+				if (const auto* reused = journal->reuse(StoragePropertySection::AtaErrorLog, block.error_num, fingerprint)) {
+					add_property(*reused);
+					continue;
+				}
+			}
+
+			block.device_state = get_node_data_optional<std::string>(table_entry, "device_state/string").value_or(std::string());
+			block.lba = get_node_data_optional<uint64_t>(table_entry, "completion_registers/lba").value_or(0);
+			block.type_more_info = get_node_data_optional<std::string>(table_entry, "error_description").value_or(std::string());
 
 			StorageProperty p;
 			std::string gen_name = fmt::format("{}/{}", table_key, block.error_num);
@@ -890,6 +849,9 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_error
 			p.set_name(gen_name, disp_name, gen_name);
 			p.section = StoragePropertySection::AtaErrorLog;
 			p.value = block;
+			if (journal) {
+				journal->store(StoragePropertySection::AtaErrorLog, block.error_num, fingerprint, p);
+			}
 			add_property(p);
 		}
 
@@ -908,55 +870,24 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_error
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_selftest_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_selftest_log", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
 
-	const bool extended = get_node_exists(json_root_node, "ata_smart_self_test_log/extended/revision").value_or(false);
+	const bool extended = (find_node(json_root_node, "ata_smart_self_test_log/extended/revision") != nullptr);
 	const std::string log_key = extended ? "ata_smart_self_test_log/extended" : "ata_smart_self_test_log/standard";
 
-	// Revision
-	if (get_node_exists(json_root_node, log_key + "/revision").value_or(false)) {
-		StorageProperty p;
-		p.set_name(log_key + "/revision", extended ? _("SMART extended self-test log version") : _("SMART standard self-test log version"));
-		p.section = StoragePropertySection::SelftestLog;
-		p.value = get_node_data<int64_t>(json_root_node, log_key + "/revision").value_or(0);
-		add_property(p);
-		section_properties_found = true;
-	}
-
+	// Revision, and the counts (always added)
+	const JsonFieldMapping fields[] = {
+		{"revision", (extended ? _("SMART extended self-test log version") : _("SMART standard self-test log version")), JsonFieldType::Integer, ""},
+		{"count", _("Self-test count"), JsonFieldType::Integer, "Self-test entries: {}", true, false},
+		{"error_count_total", _("Total error count"), JsonFieldType::Integer, "Total error count: {}", true, false},
+		{"error_count_outdated", _("Outdated error count"), JsonFieldType::Integer, "Outdated error count: {}", true, false},
+	};
 	std::vector<std::string> counts;
-
-	// Count
-	{
-		StorageProperty p;
-		p.set_name(log_key + "/count", _("Self-test count"));
-		p.section = StoragePropertySection::SelftestLog;
-		p.value = get_node_data<int64_t>(json_root_node, log_key + "/count").value_or(0);
-		p.show_in_ui = false;
-		add_property(p);
-		counts.emplace_back(fmt::format("Self-test entries: {}", p.get_value<int64_t>()));
-	}
-	// Error Count
-	{
-		StorageProperty p;
-		p.set_name(log_key + "/error_count_total", _("Total error count"));
-		p.section = StoragePropertySection::SelftestLog;
-		p.value = get_node_data<int64_t>(json_root_node, log_key + "/error_count_total").value_or(0);
-		p.show_in_ui = false;
-		add_property(p);
-		counts.emplace_back(fmt::format("Total error count: {}", p.get_value<int64_t>()));
-	}
-	// Outdated Error Count
-	{
-		StorageProperty p;
-		p.set_name(log_key + "/error_count_outdated", _("Outdated error count"));
-		p.section = StoragePropertySection::SelftestLog;
-		p.value = get_node_data<int64_t>(json_root_node, log_key + "/error_count_outdated").value_or(0);
-		p.show_in_ui = false;
-		add_property(p);
-		counts.emplace_back(fmt::format("Outdated error count: {}", p.get_value<int64_t>()));
-	}
+	section_properties_found = parse_json_fields(json_root_node, log_key, fields, StoragePropertySection::SelftestLog, &counts,
+			[this](StorageProperty p) { add_property(std::move(p)); });
 
 	// Displayed Counts
 	if (!counts.empty()) {
@@ -973,25 +904,28 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_selft
 	auto table_node = get_node(json_root_node, table_key);
 
 	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
+	if (table_node.has_value() && table_node.value()->is_array()) {
 		uint32_t entry_num = 1;
-		for (const auto& table_entry : table_node.value()) {
+		for (const auto& table_entry : *table_node.value()) {
+			if (get_max_log_entries() != 0 && entry_num > get_max_log_entries()) {
+				break;  // only the most recent ones
+			}
 			AtaStorageSelftestEntry entry;
 			entry.test_num = entry_num;
-			entry.type = get_node_data<std::string>(table_entry, "type/string").value_or(std::string());  // FIXME use type/value for i18n
-			entry.status_str = get_node_data<std::string>(table_entry, "status/string").value_or(std::string());
-			entry.remaining_percent = get_node_data<int8_t>(table_entry, "status/remaining_percent").value_or(-1);  // extended only
-			entry.lifetime_hours = get_node_data<uint32_t>(table_entry, "lifetime_hours").value_or(0);
-			entry.passed = get_node_data<bool>(table_entry, "status/passed").value_or(false);
-
-			if (get_node_exists(table_entry, "lba").value_or(false)) {
-				entry.lba_of_first_error = hz::number_to_string_locale(get_node_data<uint64_t>(table_entry, "lba").value_or(0));
+			entry.type = get_node_data_optional<std::string>(table_entry, "type/string").value_or(std::string());  // FIXME use type/value for i18n
+			entry.status_str = get_node_data_optional<std::string>(table_entry, "status/string").value_or(std::string());
+			entry.remaining_percent = get_node_data_optional<int8_t>(table_entry, "status/remaining_percent").value_or(-1);  // extended only
+			entry.lifetime_hours = get_node_data_optional<uint32_t>(table_entry, "lifetime_hours").value_or(0);
+			entry.passed = get_node_data_optional<bool>(table_entry, "status/passed").value_or(false);
+
+			if ((find_node(table_entry, "lba") != nullptr)) {
+				entry.lba_of_first_error = hz::number_to_string_locale(get_node_data_optional<uint64_t>(table_entry, "lba").value_or(0));
 			} else {
 				entry.lba_of_first_error = "-";
 			}
 
-			if (get_node_exists(table_entry, "status/value").value_or(false)) {
-				const uint8_t status_value = get_node_data<uint8_t>(table_entry, "status/value").value_or(0);
+			if ((find_node(table_entry, "status/value") != nullptr)) {
+				const uint8_t status_value = get_node_data_optional<uint8_t>(table_entry, "status/value").value_or(0);
 				entry.status = static_cast<AtaStorageSelftestEntry::Status>(status_value >> 4);
 			} else {
 				entry.status = AtaStorageSelftestEntry::Status::Unknown;
@@ -1023,6 +957,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_selft
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_selective_selftest_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_selective_selftest_log", "parser");
 	using namespace SmartctlJsonParserHelpers;
 	using namespace std::string_literals;
 
@@ -1030,52 +965,30 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_selec
 
 	std::vector<std::string> lines;
 
-	if (get_node_exists(json_root_node, "ata_smart_selective_self_test_log/revision").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_smart_selective_self_test_log/revision", _("SMART Selective self-test log data structure revision number"));
-		p.section = StoragePropertySection::SelectiveSelftestLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_smart_selective_self_test_log/revision").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("SMART Selective self-test log data structure revision number: {}", p.get_value<int64_t>()));
-		section_properties_found = true;
-	}
-	if (get_node_exists(json_root_node, "ata_smart_selective_self_test_log/power_up_scan_resume_minutes").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_smart_selective_self_test_log/power_up_scan_resume_minutes",
-				_("If Selective self-test is pending on power-up, resume delay (minutes)"));
-		p.section = StoragePropertySection::SelectiveSelftestLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_smart_selective_self_test_log/power_up_scan_resume_minutes").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("If Selective self-test is pending on power-up, resume delay: {} minutes", p.get_value<int64_t>()));
-		section_properties_found = true;
-	}
-	if (get_node_exists(json_root_node, "ata_smart_selective_self_test_log/flags/remainder_scan_enabled").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_smart_selective_self_test_log/flags/remainder_scan_enabled",
-				_("After scanning selected spans, scan remainder of the drive"));
-		p.section = StoragePropertySection::SelectiveSelftestLog;
-		p.value = get_node_data<bool>(json_root_node, "ata_smart_selective_self_test_log/flags/remainder_scan_enabled").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("After scanning selected spans, scan remainder of the drive: {}", p.get_value<bool>() ? "Yes" : "No"));
-		section_properties_found = true;
-	}
+	const JsonFieldMapping fields[] = {
+		{"revision", _("SMART Selective self-test log data structure revision number"), JsonFieldType::Integer,
+				"SMART Selective self-test log data structure revision number: {}"},
+		{"power_up_scan_resume_minutes", _("If Selective self-test is pending on power-up, resume delay (minutes)"), JsonFieldType::Integer,
+				"If Selective self-test is pending on power-up, resume delay: {} minutes"},
+		{"flags/remainder_scan_enabled", _("After scanning selected spans, scan remainder of the drive"), JsonFieldType::Bool,
+				"After scanning selected spans, scan remainder of the drive: {}"},
+	};
+	section_properties_found = parse_json_fields(json_root_node, "ata_smart_selective_self_test_log", fields,
+			StoragePropertySection::SelectiveSelftestLog, &lines, [this](StorageProperty p) { add_property(std::move(p)); });
 
 	// Table
 	const std::string table_key = "ata_smart_selective_self_test_log/table";
 	auto table_node = get_node(json_root_node, table_key);
 
 	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
+	if (table_node.has_value() && table_node.value()->is_array()) {
 		lines.emplace_back();
 
 		int entry_num = 1;
-		for (const auto& table_entry : table_node.value()) {
-			const uint64_t lba_min = get_node_data<uint64_t>(table_entry, "lba_min").value_or(0);
-			const uint64_t lba_max = get_node_data<uint64_t>(table_entry, "lba_max").value_or(0);
-			const std::string status_str = get_node_data<std::string>(table_entry, "status/string").value_or(std::string());
+		for (const auto& table_entry : *table_node.value()) {
+			const uint64_t lba_min = get_node_data_optional<uint64_t>(table_entry, "lba_min").value_or(0);
+			const uint64_t lba_max = get_node_data_optional<uint64_t>(table_entry, "lba_max").value_or(0);
+			const std::string status_str = get_node_data_optional<std::string>(table_entry, "status/string").value_or(std::string());
 
 			lines.emplace_back(fmt::format(
 					"Span: {:2}    Min LBA: {:020}    Max LBA: {:020}    Status: {}",
@@ -1112,6 +1025,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_selec
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_scttemp_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_scttemp_log", "parser");
 	using namespace SmartctlJsonParserHelpers;
 	using namespace std::string_literals;
 
@@ -1119,165 +1033,82 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_sctte
 
 	std::vector<std::string> lines;
 
-	if (get_node_exists(json_root_node, "ata_sct_status/format_version").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/format_version", _("SCT status version"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/format_version").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("SCT status version: {}", get_node_data<int64_t>(json_root_node, "ata_sct_status/format_version").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/sct_version").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/sct_version", _("SCT format version"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/sct_version").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("SCT format version: {}", get_node_data<int64_t>(json_root_node, "ata_sct_status/sct_version").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/device_state/string").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/device_state/string", _("Device state"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<std::string>(json_root_node, "ata_sct_status/device_state/string").value_or(std::string());
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Device state: {}", get_node_data<std::string>(json_root_node, "ata_sct_status/device_state/string").value_or(std::string())));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/temperature/current").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/temperature/current", _("Current temperature (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/current").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Current temperature: {}° Celsius", get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/current").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/temperature/power_cycle_min").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/temperature/power_cycle_min", _("Power cycle min. temperature (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/power_cycle_min").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Power cycle min. temperature: {}° Celsius", get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/power_cycle_min").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/temperature/power_cycle_max").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/temperature/power_cycle_max", _("Power cycle max. temperature (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/power_cycle_max").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Power cycle max. temperature: {}° Celsius", get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/power_cycle_max").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/temperature/lifetime_min").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/temperature/lifetime_min", _("Lifetime min. temperature (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/lifetime_min").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Lifetime min. temperature: {}° Celsius", get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/lifetime_min").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/temperature/lifetime_max").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/temperature/lifetime_max", _("Lifetime max. temperature (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/lifetime_max").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Lifetime max. temperature: {}° Celsius", get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/lifetime_max").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/temperature/under_limit_count").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/temperature/under_limit_count", _("Under limit count"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/under_limit_count").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Under limit count: {}", get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/under_limit_count").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_status/temperature/over_limit_count").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_status/temperature/over_limit_count", _("Over limit count"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/over_limit_count").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Over limit count: {}", get_node_data<int64_t>(json_root_node, "ata_sct_status/temperature/over_limit_count").value_or(0)));
-	}
+	const JsonFieldMapping status_fields[] = {
+		{"format_version", _("SCT status version"), JsonFieldType::Integer, "SCT status version: {}"},
+		{"sct_version", _("SCT format version"), JsonFieldType::Integer, "SCT format version: {}"},
+		{"device_state/string", _("Device state"), JsonFieldType::String, "Device state: {}"},
+		{"temperature/current", _("Current temperature (C)"), JsonFieldType::Integer, "Current temperature: {}° Celsius"},
+		{"temperature/power_cycle_min", _("Power cycle min. temperature (C)"), JsonFieldType::Integer, "Power cycle min. temperature: {}° Celsius"},
+		{"temperature/power_cycle_max", _("Power cycle max. temperature (C)"), JsonFieldType::Integer, "Power cycle max. temperature: {}° Celsius"},
+		{"temperature/lifetime_min", _("Lifetime min. temperature (C)"), JsonFieldType::Integer, "Lifetime min. temperature: {}° Celsius"},
+		{"temperature/lifetime_max", _("Lifetime max. temperature (C)"), JsonFieldType::Integer, "Lifetime max. temperature: {}° Celsius"},
+		{"temperature/under_limit_count", _("Under limit count"), JsonFieldType::Integer, "Under limit count: {}"},
+		{"temperature/over_limit_count", _("Over limit count"), JsonFieldType::Integer, "Over limit count: {}"},
+	};
+	parse_json_fields(json_root_node, "ata_sct_status", status_fields, StoragePropertySection::TemperatureLog, &lines,
+			[this](StorageProperty p) { add_property(std::move(p)); });
 
 	lines.emplace_back();
 
-	if (get_node_exists(json_root_node, "ata_sct_temperature_history/version").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_temperature_history/version", _("SCT temperature history version"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/version").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("SCT temperature history version: {}", get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/version").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_temperature_history/sampling_period_minutes").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_temperature_history/sampling_period_minutes", _("Temperature sampling period (min)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/sampling_period_minutes").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Temperature sampling period: {} min.", get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/sampling_period_minutes").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_temperature_history/logging_interval_minutes").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_temperature_history/logging_interval_minutes", _("Temperature logging interval (min)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/logging_interval_minutes").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Temperature logging interval: {} min.", get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/logging_interval_minutes").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_temperature_history/temperature/op_limit_min").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_temperature_history/temperature/op_limit_min", _("Recommended operating temperature (minimum) (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/op_limit_min").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Recommended operating temperature (minimum): {}° Celsius",
-				get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/op_limit_min").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_temperature_history/temperature/op_limit_max").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_temperature_history/temperature/op_limit_max", _("Recommended operating temperature (maximum) (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/op_limit_max").value_or(0);
-		add_property(p);
+	const JsonFieldMapping history_fields[] = {
+		{"version", _("SCT temperature history version"), JsonFieldType::Integer, "SCT temperature history version: {}"},
+		{"sampling_period_minutes", _("Temperature sampling period (min)"), JsonFieldType::Integer, "Temperature sampling period: {} min."},
+		{"logging_interval_minutes", _("Temperature logging interval (min)"), JsonFieldType::Integer, "Temperature logging interval: {} min."},
+		{"temperature/op_limit_min", _("Recommended operating temperature (minimum) (C)"), JsonFieldType::Integer,
+				"Recommended operating temperature (minimum): {}° Celsius"},
+		{"temperature/op_limit_max", _("Recommended operating temperature (maximum) (C)"), JsonFieldType::Integer,
+				"Recommended operating temperature (maximum): {}° Celsius"},
+		{"temperature/limit_min", _("Allowed operating temperature (minimum) (C)"), JsonFieldType::Integer,
+				"Allowed operating temperature (minimum): {}° Celsius"},
+		{"temperature/limit_max", _("Allowed operating temperature (maximum) (C)"), JsonFieldType::Integer,
+				"Allowed operating temperature (maximum): {}° Celsius"},
+	};
+	parse_json_fields(json_root_node, "ata_sct_temperature_history", history_fields, StoragePropertySection::TemperatureLog, &lines,
+			[this](StorageProperty p) { add_property(std::move(p)); });
+
+	// The history table, oldest entry first. Format it like the text output, so that the history graph
+	// can use it as well. The newest entry was logged at smartctl runtime.
+	const nlohmann::json* history_node = find_node(json_root_node, "ata_sct_temperature_history");
+	const nlohmann::json* history_table_node = (history_node ? find_node(*history_node, "table") : nullptr);
+	const auto scan_time = get_node_data_optional<int64_t>(json_root_node, "local_time/time_t");
+	if (history_table_node != nullptr && history_table_node->is_array()
+			&& !history_table_node->empty() && scan_time.has_value()) {
+		const auto& table = *history_table_node;
+		const int64_t interval = std::max<int64_t>(1,
+				get_node_data_optional<int64_t>(*history_node, "logging_interval_minutes").value_or(1));
+		const int64_t size = get_node_data_optional<int64_t>(*history_node, "size").value_or(int64_t(table.size()));
+		const int64_t newest_index = get_node_data_optional<int64_t>(*history_node, "index").value_or(size - 1);
+		const auto count = static_cast<int64_t>(table.size());
+
+		// The typed history, for the graph and the exporters
+		AtaStorageTemperatureHistory history;
+		history.logging_interval_minutes = interval;
+		history.newest_time = scan_time.value();
+		history.write_index = static_cast<uint32_t>(count - 1);
+		history.samples.reserve(table.size());
 
-		lines.emplace_back(fmt::format("Recommended operating temperature (maximum): {}° Celsius",
-				get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/op_limit_max").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_temperature_history/temperature/limit_min").value_or(false)) {
-		StorageProperty p;
-		p.set_name("ata_sct_temperature_history/temperature/limit_min", _("Allowed operating temperature (minimum) (C)"));
-		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/limit_min").value_or(0);
-		add_property(p);
+		lines.emplace_back();
+		lines.emplace_back("Index    Estimated Time   Temperature Celsius");
+		for (int64_t i = 0; i < count; ++i) {
+			const auto& entry = table[static_cast<std::size_t>(i)];
+			const int64_t entry_index = (size > 0 ? ((newest_index - (count - 1 - i)) % size + size) % size : i);
+			const int64_t entry_time = scan_time.value() - (count - 1 - i) * interval * 60;
+			lines.emplace_back(fmt::format("{:4}    {}    {}", entry_index,
+					hz::format_date("%Y-%m-%d %H:%M", static_cast<std::time_t>(entry_time), true),
+					(entry.is_number_integer() ? hz::number_to_string_nolocale(entry.get<int64_t>()) : std::string("?"))));
+
+			const bool known = entry.is_number_integer()
+					&& entry.get<int64_t>() > AtaStorageTemperatureHistory::unknown_temperature
+					&& entry.get<int64_t>() <= std::numeric_limits<int8_t>::max();
+			history.samples.push_back(known ? static_cast<int8_t>(entry.get<int64_t>()) : AtaStorageTemperatureHistory::unknown_temperature);
+		}
 
-		lines.emplace_back(fmt::format("Allowed operating temperature (minimum): {}° Celsius",
-				get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/limit_min").value_or(0)));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_temperature_history/temperature/limit_max").value_or(false)) {
 		StorageProperty p;
-		p.set_name("ata_sct_temperature_history/temperature/limit_max", _("Allowed operating temperature (maximum) (C)"));
+		p.set_name("ata_sct_temperature_history/table", _("Temperature history"));
 		p.section = StoragePropertySection::TemperatureLog;
-		p.value = get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/limit_max").value_or(0);
-		add_property(p);
-
-		lines.emplace_back(fmt::format("Allowed operating temperature (maximum): {}° Celsius",
-				get_node_data<int64_t>(json_root_node, "ata_sct_temperature_history/temperature/limit_max").value_or(0)));
+		p.value = std::move(history);
+		p.show_in_ui = false;  // shown as a graph
+		add_property(std::move(p));
 	}
 
 	// The whole section
@@ -1306,6 +1137,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_sctte
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_scterc_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_scterc_log", "parser");
 	using namespace SmartctlJsonParserHelpers;
 	using namespace std::string_literals;
 
@@ -1313,15 +1145,14 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_scter
 
 	std::vector<std::string> lines;
 
-	if (get_node_exists(json_root_node, "ata_sct_erc/read/enabled").value_or(false)) {
-		lines.emplace_back(fmt::format("SCT error recovery control (read): {}, {:.2f} seconds",
-				(get_node_data<bool>(json_root_node, "ata_sct_erc/read/enabled").value_or(false) ? "enabled" : "disabled"),
-				get_node_data<double>(json_root_node, "ata_sct_erc/read/deciseconds").value_or(0.) / 10.));
-	}
-	if (get_node_exists(json_root_node, "ata_sct_erc/write/enabled").value_or(false)) {
-		lines.emplace_back(fmt::format("SCT error recovery control (write): {}, {:.2f} seconds",
-				(get_node_data<bool>(json_root_node, "ata_sct_erc/write/enabled").value_or(false) ? "enabled" : "disabled"),
-				get_node_data<double>(json_root_node, "ata_sct_erc/write/deciseconds").value_or(0.) / 10.));
+	const nlohmann::json* erc_node = find_node(json_root_node, "ata_sct_erc");
+	for (const auto* direction : {"read", "write"}) {
+		const nlohmann::json* direction_node = (erc_node ? find_node(*erc_node, direction) : nullptr);
+		if (direction_node != nullptr && find_node(*direction_node, "enabled") != nullptr) {
+			lines.emplace_back(fmt::format("SCT error recovery control ({}): {}, {:.2f} seconds", direction,
+					(get_node_data_optional<bool>(*direction_node, "enabled").value_or(false) ? "enabled" : "disabled"),
+					get_node_data_optional<double>(*direction_node, "deciseconds").value_or(0.) / 10.));
+		}
 	}
 
 	// The whole section
@@ -1348,6 +1179,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_scter
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_devstat(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_devstat", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
@@ -1356,15 +1188,15 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_devst
 	auto page_node = get_node(json_root_node, pages_key);
 
 	// Entries
-	if (page_node.has_value() && page_node->is_array()) {
-		for (const auto& page_entry : page_node.value()) {
+	if (page_node.has_value() && page_node.value()->is_array()) {
+		for (const auto& page_entry : *page_node.value()) {
 			AtaStorageStatistic page_stat;
 			page_stat.is_header = true;
-			page_stat.page = get_node_data<int64_t>(page_entry, "number").value_or(0);
+			page_stat.page = get_node_data_optional<int64_t>(page_entry, "number").value_or(0);
 
 			StorageProperty page_prop;
 			{
-				const std::string gen_name = get_node_data<std::string>(page_entry, "name").value_or(std::string());
+				const std::string gen_name = get_node_data_optional<std::string>(page_entry, "name").value_or(std::string());
 				const std::string disp_name = gen_name;  // TODO: Translate
 				page_prop.set_name(gen_name, disp_name);
 				page_prop.section = StoragePropertySection::Statistics;
@@ -1375,17 +1207,17 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_devst
 			const std::string table_key = "table";
 			auto table_node = get_node(page_entry, table_key);
 
-			if (table_node.has_value() && table_node->is_array()) {
-				for (const auto& table_entry : table_node.value()) {
+			if (table_node.has_value() && table_node.value()->is_array()) {
+				for (const auto& table_entry : *table_node.value()) {
 					AtaStorageStatistic s;
 					s.page = page_stat.page;
-					s.flags = get_node_data<std::string>(table_entry, "flags/string").value_or(std::string());
-					s.value_int = get_node_data<int64_t>(table_entry, "value").value_or(0);
-					s.value = std::to_string(get_node_data<int64_t>(table_entry, "value").value_or(0));
-					s.offset = get_node_data<int64_t>(table_entry, "offset").value_or(0);
+					s.flags = get_node_data_optional<std::string>(table_entry, "flags/string").value_or(std::string());
+					s.value_int = get_node_data_optional<int64_t>(table_entry, "value").value_or(0);
+					s.value = std::to_string(get_node_data_optional<int64_t>(table_entry, "value").value_or(0));
+					s.offset = get_node_data_optional<int64_t>(table_entry, "offset").value_or(0);
 
 					StorageProperty p;
-					const std::string gen_name = get_node_data<std::string>(table_entry, "name").value_or(std::string());
+					const std::string gen_name = get_node_data_optional<std::string>(table_entry, "name").value_or(std::string());
 					p.set_name(gen_name, gen_name, gen_name);  // The description database will correct this.
 					p.section = StoragePropertySection::Statistics;
 					p.value = s;
@@ -1409,6 +1241,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_devst
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_sataphy(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonAtaParser::parse_section_sataphy", "parser");
 	using namespace SmartctlJsonParserHelpers;
 	using namespace std::string_literals;
 
@@ -1421,13 +1254,13 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonAtaParser::parse_section_satap
 	auto table_node = get_node(json_root_node, table_key);
 
 	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
-		for (const auto& table_entry : table_node.value()) {
-			const uint64_t id = get_node_data<uint64_t>(table_entry, "id").value_or(0);
-			const std::string name = get_node_data<std::string>(table_entry, "name").value_or(std::string());
-			const uint64_t size = get_node_data<uint64_t>(table_entry, "size").value_or(0);
-			const int64_t value = get_node_data<int64_t>(table_entry, "value").value_or(0);
-//			const bool overflow = get_node_data<bool>(table_entry, "overflow").value_or(false);
+	if (table_node.has_value() && table_node.value()->is_array()) {
+		for (const auto& table_entry : *table_node.value()) {
+			const uint64_t id = get_node_data_optional<uint64_t>(table_entry, "id").value_or(0);
+			const std::string name = get_node_data_optional<std::string>(table_entry, "name").value_or(std::string());
+			const uint64_t size = get_node_data_optional<uint64_t>(table_entry, "size").value_or(0);
+			const int64_t value = get_node_data_optional<int64_t>(table_entry, "value").value_or(0);
+//			const bool overflow = get_node_data_optional<bool>(table_entry, "overflow").value_or(false);
 
 			lines.emplace_back(fmt::format(
 					"ID: 0x{:04X}    Size: {:8}    Value: {:20}    Description: {}",
@@ -14,6 +14,7 @@ Copyright:
 
 #include "smartctl_parser.h"
 
+#include <optional>
 #include <string_view>
 
 #include "nlohmann/json.hpp"
@@ -33,6 +34,16 @@ class SmartctlJsonAtaParser : public SmartctlParser {
 		// Overridden
 		[[nodiscard]] hz::ExpectedVoid<SmartctlParserError> parse(std::string_view smartctl_output) override;
 
+		/// Get the self-test execution status (reported by --capabilities) from json data.
+		/// This doesn't need the rest of the output to be parsed, so it's used for quick test progress polls.
+		/// \return std::nullopt if not present.
+		[[nodiscard]] static std::optional<AtaStorageSelftestEntry> parse_selftest_status(const nlohmann::json& json_root_node);
+
+	protected:
+
+		// Overridden
+		[[nodiscard]] std::unique_ptr<SmartctlParser> create_section_parser() const override;
+
 	private:
 
 		/// Parse the info section (root node), filling in the properties
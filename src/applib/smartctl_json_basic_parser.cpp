@@ -31,6 +31,7 @@ Copyright:
 //#include "ata_storage_property_descr.h"
 #include "storage_property.h"
 #include "smartctl_json_parser_helpers.h"
+#include "app_trace.h"
 #include "smartctl_parser_types.h"
 //#include "smartctl_version_parser.h"
 
@@ -38,6 +39,7 @@ Copyright:
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonBasicParser::parse(std::string_view smartctl_output)
 {
+	const AppTraceSpan trace_span("SmartctlJsonBasicParser::parse", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	if (hz::string_trim_copy(smartctl_output).empty()) {
@@ -45,13 +47,11 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonBasicParser::parse(std::string
 		return hz::Unexpected(SmartctlParserError::EmptyInput, "Smartctl data is empty.");
 	}
 
-	nlohmann::json json_root_node;
-	try {
-		json_root_node = nlohmann::json::parse(smartctl_output);
-	} catch (const nlohmann::json::parse_error& e) {
-		debug_out_warn("app", DBG_FUNC_MSG << "Error parsing smartctl output as JSON: " << e.what() << "\n");
-		return hz::Unexpected(SmartctlParserError::SyntaxError, std::string("Invalid JSON data: ") + e.what());
+	auto parsed_json = SmartctlJsonParserHelpers::parse_json_document(smartctl_output, get_keep_text_output());
+	if (!parsed_json) {
+		return hz::Unexpected(SmartctlParserError::SyntaxError, parsed_json.error().message());
 	}
+	const nlohmann::json& json_root_node = parsed_json.value();
 
 	StorageProperty merged_property, full_property;
 	auto version_parse_status = SmartctlJsonParserHelpers::parse_version(json_root_node, merged_property, full_property);
@@ -68,6 +68,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonBasicParser::parse(std::string
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonBasicParser::parse_section_basic_info(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonBasicParser::parse_section_basic_info", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	// Here we list the properties that are:
@@ -80,9 +81,9 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonBasicParser::parse_section_bas
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
 					auto table_node = get_node(root_node, "smartctl/output");
-					if (table_node.has_value() && table_node->is_array() && !table_node.value().empty()) {
+					if (table_node.has_value() && table_node.value()->is_array() && !table_node.value()->empty()) {
 						std::vector<std::string> lines;
-						for (const auto& entry : table_node.value()) {
+						for (const auto& entry : *table_node.value()) {
 							lines.emplace_back(entry.get<std::string>());
 						}
 						StorageProperty p;
@@ -12,6 +12,7 @@ Copyright:
 #include "smartctl_json_nvme_parser.h"
 
 #include <cstdint>
+#include <functional>  // std::hash
 #include <optional>
 #include <string>
 #include <string_view>
@@ -30,24 +31,25 @@ Copyright:
 #include "hz/error_container.h"
 #include "hz/string_num.h"
 #include "smartctl_json_parser_helpers.h"
+#include "app_trace.h"
 #include "smartctl_parser_types.h"
+#include "storage_error_log_journal.h"
 
 
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse(std::string_view smartctl_output)
 {
+	const AppTraceSpan trace_span("SmartctlJsonNvmeParser::parse", "parser");
 	if (hz::string_trim_copy(smartctl_output).empty()) {
 		debug_out_warn("app", DBG_FUNC_MSG << "Empty string passed as an argument. Returning.\n");
 		return hz::Unexpected(SmartctlParserError::EmptyInput, "Smartctl data is empty.");
 	}
 
-	nlohmann::json json_root_node;
-	try {
-		json_root_node = nlohmann::json::parse(smartctl_output);
-	} catch (const nlohmann::json::parse_error& e) {
-		debug_out_warn("app", DBG_FUNC_MSG << "Error parsing smartctl output as JSON: " << e.what() << "\n");
-		return hz::Unexpected(SmartctlParserError::SyntaxError, std::string("Invalid JSON data: ") + e.what());
+	auto parsed_json = SmartctlJsonParserHelpers::parse_json_document(smartctl_output, get_keep_text_output());
+	if (!parsed_json) {
+		return hz::Unexpected(SmartctlParserError::SyntaxError, parsed_json.error().message());
 	}
+	const nlohmann::json& json_root_node = parsed_json.value();
 
 	StorageProperty merged_property, full_property;
 	auto version_parse_status = SmartctlJsonParserHelpers::parse_version(json_root_node, merged_property, full_property);
@@ -64,35 +66,35 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse(std::string_
 	}
 
 	// Add properties for each parsed section so that the UI knows which tabs to show or hide
-	{
+	if (get_section_requested(StoragePropertySection::OverallHealth)) {
 		auto section_parse_status = parse_section_overall_health(json_root_node);
 //		StorageProperty p;
 //		p.section = StoragePropertySection::Health;
 //		p.set_name("_parser/health_section_available");
 //		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
 	}
-	{
+	if (get_section_requested(StoragePropertySection::NvmeHealth)) {
 		auto section_parse_status = parse_section_nvme_health(json_root_node);
 //		StorageProperty p;
 //		p.section = StoragePropertySection::Health;
 //		p.set_name("_parser/health_section_available");
 //		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
 	}
-	{
+	if (get_section_requested(StoragePropertySection::NvmeErrorLog)) {
 		auto section_parse_status = parse_section_nvme_error_log(json_root_node);
 //		StorageProperty p;
 //		p.section = StoragePropertySection::ErrorLog;
 //		p.set_name("_parser/error_log_section_available");
 //		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
 	}
-	{
+	if (get_section_requested(StoragePropertySection::SelftestLog)) {
 		auto section_parse_status = parse_section_selftest_log(json_root_node);
 //		StorageProperty p;
 //		p.section = StoragePropertySection::SelftestLog;
 //		p.set_name("_parser/selftest_log_section_available");
 //		p.value = section_parse_status.has_value() || section_parse_status.error().data() != SmartctlParserError::NoSection;
 	}
-	{
+	if (get_section_requested(StoragePropertySection::NvmeAttributes)) {
 		auto section_parse_status = parse_section_nvme_attributes(json_root_node);
 //		StorageProperty p;
 //		p.section = StoragePropertySection::Devstat;
@@ -105,8 +107,44 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse(std::string_
 
 
 
+NvmeSelfTestCurrentOperationType SmartctlJsonNvmeParser::decode_self_test_operation(uint8_t value)
+{
+	switch (value) {
+		// Data from smartmontools/nvmeprint.cpp
+		case 0x0: return NvmeSelfTestCurrentOperationType::None;
+		case 0x1: return NvmeSelfTestCurrentOperationType::ShortInProgress;
+		case 0x2: return NvmeSelfTestCurrentOperationType::ExtendedInProgress;
+		case 0xe: return NvmeSelfTestCurrentOperationType::VendorSpecificInProgress;
+		default: break;
+	}
+	return NvmeSelfTestCurrentOperationType::Unknown;
+}
+
+
+
+NvmeSelfTestResultType SmartctlJsonNvmeParser::decode_self_test_result(int32_t value)
+{
+	switch (value) {
+		case 0x0: return NvmeSelfTestResultType::CompletedNoError;
+		case 0x1: return NvmeSelfTestResultType::AbortedSelfTestCommand;
+		case 0x2: return NvmeSelfTestResultType::AbortedControllerReset;
+		case 0x3: return NvmeSelfTestResultType::AbortedNamespaceRemoved;
+		case 0x4: return NvmeSelfTestResultType::AbortedFormatNvmCommand;
+		case 0x5: return NvmeSelfTestResultType::FatalOrUnknownTestError;
+		case 0x6: return NvmeSelfTestResultType::CompletedUnknownFailedSegment;
+		case 0x7: return NvmeSelfTestResultType::CompletedFailedSegments;
+		case 0x8: return NvmeSelfTestResultType::AbortedUnknownReason;
+		case 0x9: return NvmeSelfTestResultType::AbortedSanitizeOperation;
+		default: break;
+	}
+	return NvmeSelfTestResultType::Unknown;
+}
+
+
+
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_info(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonNvmeParser::parse_section_info", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	// This is very similar to Basic Parser, but the Basic Parser supports different drive types, while this
@@ -119,9 +157,9 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_info
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
 					auto table_node = get_node(root_node, "smartctl/output");
-					if (table_node.has_value() && table_node->is_array() && !table_node.value().empty()) {
+					if (table_node.has_value() && table_node.value()->is_array() && !table_node.value()->empty()) {
 						std::vector<std::string> lines;
-						for (const auto& entry : table_node.value()) {
+						for (const auto& entry : *table_node.value()) {
 							lines.emplace_back(entry.get<std::string>());
 						}
 						StorageProperty p;
@@ -138,7 +176,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_info
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto jval = get_node_data<std::string>(root_node, "device/type"); jval.has_value()) {
+					if (auto jval = get_node_data_optional<std::string>(root_node, "device/type"); jval.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.value = jval.value();
@@ -153,7 +191,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_info
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto jval = get_node_data<std::string>(root_node, "device/protocol"); jval.has_value()) {
+					if (auto jval = get_node_data_optional<std::string>(root_node, "device/protocol"); jval.has_value()) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.value = jval.value();
@@ -202,7 +240,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_info
 				[](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 						-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 				{
-					if (auto jval = get_node_data<int64_t>(root_node, "user_capacity/bytes"); jval) {
+					if (auto jval = get_node_data_optional<int64_t>(root_node, "user_capacity/bytes"); jval) {
 						StorageProperty p;
 						p.set_name(key, displayable_name);
 						p.readable_value = hz::format_size(static_cast<uint64_t>(jval.value()), true);
@@ -248,6 +286,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_info
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_overall_health(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonNvmeParser::parse_section_overall_health", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
@@ -280,6 +319,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_over
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme_health(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonNvmeParser::parse_section_nvme_health", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
@@ -319,6 +359,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme_error_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonNvmeParser::parse_section_nvme_error_log", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
@@ -327,22 +368,22 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme
 
 	std::vector<std::string> lines;
 
-	if (get_node_exists(json_root_node, "nvme_error_information_log/size").value_or(false)) {
+	if ((find_node(json_root_node, "nvme_error_information_log/size") != nullptr)) {
 		StorageProperty p;
 		p.set_name("nvme_error_information_log/size", _("Non-Persistent Error Log Size"));
 		p.section = StoragePropertySection::NvmeErrorLog;
-		p.value = get_node_data<int64_t>(json_root_node, "nvme_error_information_log/size").value_or(0);
+		p.value = get_node_data_optional<int64_t>(json_root_node, "nvme_error_information_log/size").value_or(0);
 		add_property(p);
 
 		lines.emplace_back(fmt::format("Non-Persistent Error Log Size: {}", p.get_value<int64_t>()));
 		section_properties_found = true;
 	}
-	if (get_node_exists(json_root_node, "nvme_error_information_log/read").value_or(false)) {
+	if ((find_node(json_root_node, "nvme_error_information_log/read") != nullptr)) {
 		StorageProperty p;
 		// Note: This number can be controlled using smartctl option.
 		p.set_name("nvme_error_information_log/read", _("Number of Error Log Entries Read"));
 		p.section = StoragePropertySection::NvmeErrorLog;
-		p.value = get_node_data<int64_t>(json_root_node, "nvme_error_information_log/size").value_or(0);
+		p.value = get_node_data_optional<int64_t>(json_root_node, "nvme_error_information_log/size").value_or(0);
 		add_property(p);
 
 		lines.emplace_back(fmt::format("Number of Error Log Entries Read: {}", p.get_value<int64_t>()));
@@ -353,15 +394,25 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme
 	const std::string table_key = "nvme_error_information_log/table";
 	auto table_node = get_node(json_root_node, table_key);
 
-	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
+	// Entries. The lines of the ones ingested before are taken from the journal.
+	// The log is cleared on power cycle, the journal notices it by the lower error_count.
+	const auto& journal = get_error_log_journal();
+	if (table_node.has_value() && table_node.value()->is_array()) {
 		lines.emplace_back();
 
-		for (const auto& table_entry : table_node.value()) {
-			const uint64_t error_count = get_node_data<uint64_t>(table_entry, "error_count").value_or(0);
-			const uint64_t command_id = get_node_data<uint64_t>(table_entry, "command_id").value_or(0);
-			const std::string status_str = get_node_data<std::string>(table_entry, "status_field/string").value_or(std::string());
-			const uint64_t lba = get_node_data<uint64_t>(table_entry, "lba/value").value_or(0);
+		for (const auto& table_entry : *table_node.value()) {
+			const uint64_t error_count = get_node_data_optional<uint64_t>(table_entry, "error_count").value_or(0);
+			const uint64_t command_id = get_node_data_optional<uint64_t>(table_entry, "command_id").value_or(0);
+			const std::string status_str = get_node_data_optional<std::string>(table_entry, "status_field/string").value_or(std::string());
+			const uint64_t lba = get_node_data_optional<uint64_t>(table_entry, "lba/value").value_or(0);
+
+			const std::uint64_t fingerprint = (command_id << 48) ^ lba ^ std::hash<std::string>()(status_str);
+			if (journal) {
+				if (const auto* reused = journal->reuse(StoragePropertySection::NvmeErrorLog, error_count, fingerprint)) {
+					lines.push_back(reused->get_value<std::string>());
+					continue;
+				}
+			}
 
 			// Error #, Command ID, LBA, Status
 			lines.emplace_back(fmt::format(
@@ -370,6 +421,16 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme
 					command_id,
 					lba,
 					status_str));
+
+			// Only a part of the merged property, so it's not processed
+			if (journal) {
+				StorageProperty p;
+				const std::string gen_name = fmt::format("{}/{}", table_key, error_count);
+				p.set_name(gen_name, gen_name);
+				p.section = StoragePropertySection::NvmeErrorLog;
+				p.value = lines.back();
+				journal->store(StoragePropertySection::NvmeErrorLog, error_count, fingerprint, std::move(p));
+			}
 		}
 
 		section_properties_found = true;
@@ -398,6 +459,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_selftest_log(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonNvmeParser::parse_section_selftest_log", "parser");
 	// nvme_self_test_log
 
 	using namespace SmartctlJsonParserHelpers;
@@ -406,7 +468,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_self
 
 	// If nvme_self_test_log is present, the drive supports tests.
 	// Create this property only if supported, so that the UI can hide the tab if not needed.
-	if (get_node_exists(json_root_node, "nvme_self_test_log").value_or(false)) {
+	if ((find_node(json_root_node, "nvme_self_test_log") != nullptr)) {
 		StorageProperty p;
 		p.set_name("nvme_self_test_log/_exists", _("Self-tests supported"));
 		p.section = StoragePropertySection::SelftestLog;
@@ -419,17 +481,9 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_self
 		p.set_name("nvme_self_test_log/current_self_test_operation/value/_decoded", _("Current Self-Test Operation"));
 		p.section = StoragePropertySection::SelftestLog;
 
-		auto value_val = get_node_data<uint8_t>(json_root_node, "nvme_self_test_log/current_self_test_operation/value");
-		NvmeSelfTestCurrentOperationType operation = NvmeSelfTestCurrentOperationType::Unknown;
+		auto value_val = get_node_data_optional<uint8_t>(json_root_node, "nvme_self_test_log/current_self_test_operation/value");
 		if (value_val.has_value()) {
-			switch (value_val.value()) {
-				// Data from smartmontools/nvmeprint.cpp
-				case 0x0: operation = NvmeSelfTestCurrentOperationType::None; break;
-				case 0x1: operation = NvmeSelfTestCurrentOperationType::ShortInProgress; break;
-				case 0x2: operation = NvmeSelfTestCurrentOperationType::ExtendedInProgress; break;
-				case 0xe: operation = NvmeSelfTestCurrentOperationType::VendorSpecificInProgress; break;
-				default: break;  // Unknown
-			}
+			const NvmeSelfTestCurrentOperationType operation = decode_self_test_operation(value_val.value());
 			p.value = NvmeSelfTestCurrentOperationTypeExt::get_storable_name(operation);
 			p.readable_value = NvmeSelfTestCurrentOperationTypeExt::get_displayable_name(operation);
 			add_property(p);
@@ -443,7 +497,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_self
 		p.set_name("nvme_self_test_log/current_self_test_completion_percent", _("Current Self-Test Completion Percentage"));
 		p.section = StoragePropertySection::SelftestLog;
 
-		auto value_val = get_node_data<uint8_t>(json_root_node, "nvme_self_test_log/current_self_test_completion_percent");
+		auto value_val = get_node_data_optional<uint8_t>(json_root_node, "nvme_self_test_log/current_self_test_completion_percent");
 		if (value_val.has_value()) {
 			p.value = value_val.value();
 			p.readable_value = fmt::format("{} %", value_val.value());
@@ -455,15 +509,15 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_self
 	auto table_node = get_node(json_root_node, table_key);
 
 	// Entries
-	if (table_node.has_value() && table_node->is_array()) {
+	if (table_node.has_value() && table_node.value()->is_array()) {
 		uint32_t entry_num = 1;
-		for (const auto& table_entry : table_node.value()) {
+		for (const auto& table_entry : *table_node.value()) {
 			NvmeStorageSelftestEntry entry;
 			entry.test_num = entry_num;
 
 			NvmeSelfTestType test_type = NvmeSelfTestType::Unknown;
-			if (get_node_exists(table_entry, "self_test_code/value").value_or(false)) {
-				const int32_t type_value = get_node_data<int32_t>(table_entry, "self_test_code/value").value_or(int(NvmeSelfTestType::Unknown));
+			if ((find_node(table_entry, "self_test_code/value") != nullptr)) {
+				const int32_t type_value = get_node_data_optional<int32_t>(table_entry, "self_test_code/value").value_or(int(NvmeSelfTestType::Unknown));
 				switch(type_value) {
 					case 0x1: test_type = NvmeSelfTestType::Short; break;
 					case 0x2: test_type = NvmeSelfTestType::Extended; break;
@@ -473,28 +527,16 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_self
 			}
 
 			NvmeSelfTestResultType test_result = NvmeSelfTestResultType::Unknown;
-			if (get_node_exists(table_entry, "self_test_result/value").value_or(false)) {
-				const int32_t type_value = get_node_data<int32_t>(table_entry, "self_test_result/value").value_or(int(NvmeSelfTestType::Unknown));
-				switch(type_value) {
-					case 0x0: test_result = NvmeSelfTestResultType::CompletedNoError; break;
-					case 0x1: test_result = NvmeSelfTestResultType::AbortedSelfTestCommand; break;
-					case 0x2: test_result = NvmeSelfTestResultType::AbortedControllerReset; break;
-					case 0x3: test_result = NvmeSelfTestResultType::AbortedNamespaceRemoved; break;
-					case 0x4: test_result = NvmeSelfTestResultType::AbortedFormatNvmCommand; break;
-					case 0x5: test_result = NvmeSelfTestResultType::FatalOrUnknownTestError; break;
-					case 0x6: test_result = NvmeSelfTestResultType::CompletedUnknownFailedSegment; break;
-					case 0x7: test_result = NvmeSelfTestResultType::CompletedFailedSegments; break;
-					case 0x8: test_result = NvmeSelfTestResultType::AbortedUnknownReason; break;
-					case 0x9: test_result = NvmeSelfTestResultType::AbortedSanitizeOperation; break;
-					default: break;  // Unknown
-				}
+			if ((find_node(table_entry, "self_test_result/value") != nullptr)) {
+				test_result = decode_self_test_result(
+						get_node_data_optional<int32_t>(table_entry, "self_test_result/value").value_or(int(NvmeSelfTestType::Unknown)));
 			}
 
 			entry.type = test_type;
 			entry.result = test_result;
-			entry.power_on_hours = get_node_data<uint32_t>(table_entry, "power_on_hours").value_or(0);
-			if (get_node_exists(table_entry, "lba").value_or(false)) {  // optional
-				entry.lba = get_node_data<uint64_t>(table_entry, "lba").value();
+			entry.power_on_hours = get_node_data_optional<uint32_t>(table_entry, "power_on_hours").value_or(0);
+			if ((find_node(table_entry, "lba") != nullptr)) {  // optional
+				entry.lba = get_node_data_optional<uint64_t>(table_entry, "lba").value();
 			}
 
 			StorageProperty p;
@@ -523,6 +565,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_self
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlJsonNvmeParser::parse_section_nvme_attributes(const nlohmann::json& json_root_node)
 {
+	const AppTraceSpan trace_span("SmartctlJsonNvmeParser::parse_section_nvme_attributes", "parser");
 	using namespace SmartctlJsonParserHelpers;
 
 	bool section_properties_found = false;
@@ -33,6 +33,12 @@ class SmartctlJsonNvmeParser : public SmartctlParser {
 		// Overridden
 		[[nodiscard]] hz::ExpectedVoid<SmartctlParserError> parse(std::string_view smartctl_output) override;
 
+		/// Decode "nvme_self_test_log/current_self_test_operation/value"
+		[[nodiscard]] static NvmeSelfTestCurrentOperationType decode_self_test_operation(uint8_t value);
+
+		/// Decode "self_test_result/value" of a self-test log entry
+		[[nodiscard]] static NvmeSelfTestResultType decode_self_test_result(int32_t value);
+
 	private:
 
 		/// Parse the info section (root node), filling in the properties
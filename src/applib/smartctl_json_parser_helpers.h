@@ -12,9 +12,14 @@ Copyright:
 #ifndef SMARTCTL_JSON_PARSER_HELPERS_H
 #define SMARTCTL_JSON_PARSER_HELPERS_H
 
+#include <array>
 #include <cstddef>
 #include <functional>
+#include <optional>
+#include <span>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <string_view>
 #include <vector>
 
@@ -43,114 +48,401 @@ enum class SmartctlJsonParserError {
 namespace SmartctlJsonParserHelpers {
 
 
-/// Get node from json data. The path is slash-separated string.
-[[nodiscard]] inline hz::ExpectedValue<nlohmann::json, SmartctlJsonParserError>
-get_node(const nlohmann::json& root, std::string_view path)
+/// A slash-separated JSON path, split into components once (at compile time, if
+/// constructed in constant expressions), without allocating memory.
+/// Note: The components refer to the path string, which must outlive this object.
+class JsonPath {
+	public:
+
+		/// Maximum number of path components
+		static constexpr std::size_t max_components = 16;
+
+
+		/// Constructor. Empty components are skipped.
+		constexpr JsonPath(std::string_view path)  // NOLINT(google-explicit-constructor)
+				: path_(path)
+		{
+			std::size_t pos = 0;
+			while (pos < path.size()) {
+				std::size_t end = path.find('/', pos);
+				if (end == std::string_view::npos) {
+					end = path.size();
+				}
+				if (end > pos) {
+					if (size_ == max_components) {
+						too_long_ = true;
+						break;
+					}
+					components_[size_++] = path.substr(pos, end - pos);
+				}
+				pos = end + 1;
+			}
+		}
+
+		/// Constructor
+		constexpr JsonPath(const char* path)  // NOLINT(google-explicit-constructor)
+				: JsonPath(std::string_view(path))
+		{ }
+
+		/// Constructor
+		JsonPath(const std::string& path)  // NOLINT(google-explicit-constructor)
+				: JsonPath(std::string_view(path))
+		{ }
+
+
+		/// Get the original path
+		[[nodiscard]] constexpr std::string_view str() const
+		{
+			return path_;
+		}
+
+		/// Number of components
+		[[nodiscard]] constexpr std::size_t size() const
+		{
+			return size_;
+		}
+
+		/// Get a component
+		[[nodiscard]] constexpr std::string_view operator[](std::size_t index) const
+		{
+			return components_[index];
+		}
+
+		/// Check if the path has more than max_components components
+		[[nodiscard]] constexpr bool too_long() const
+		{
+			return too_long_;
+		}
+
+
+	private:
+
+		std::string_view path_;  ///< Full path
+		std::array<std::string_view, max_components> components_ = {};  ///< Path components
+		std::size_t size_ = 0;  ///< Number of used components
+		bool too_long_ = false;  ///< True if there were more components than max_components
+
+};
+
+
+
+/// Parse smartctl JSON output into a DOM.
+/// If \c keep_text_output is false, the "smartctl/output" array (the text output
+/// embedded with --json=o) is dropped by the SAX parser callback, so it's never
+/// stored in the DOM. This is a large part of the data.
+[[nodiscard]] inline hz::ExpectedValue<nlohmann::json, SmartctlParserError>
+parse_json_document(std::string_view smartctl_output, bool keep_text_output)
 {
-	using namespace std::literals;
+	nlohmann::json json_root_node;
+	try {
+		if (keep_text_output) {
+			json_root_node = nlohmann::json::parse(smartctl_output);
+
+		} else {
+			bool in_smartctl_node = false;  // whether we're inside the root "smartctl" object
+			json_root_node = nlohmann::json::parse(smartctl_output,
+					[&in_smartctl_node](int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed)
+			{
+				if (event != nlohmann::json::parse_event_t::key) {
+					return true;
+				}
+				if (depth == 1) {
+					in_smartctl_node = (parsed == "smartctl");
+					return true;
+				}
+				// Returning false for a key discards the key together with its value.
+				return !(depth == 2 && in_smartctl_node && parsed == "output");
+			});
+		}
+	} catch (const nlohmann::json::parse_error& e) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Error parsing smartctl output as JSON: " << e.what() << "\n");
+		return hz::Unexpected(SmartctlParserError::SyntaxError, std::string("Invalid JSON data: ") + e.what());
+	}
+	return json_root_node;
+}
+
+
+
+/// Result of lookup_node()
+struct JsonNodeLookup {
+	const nlohmann::json* node = nullptr;  ///< Found node (a pointer into the root), nullptr on error
+	SmartctlJsonParserError error = SmartctlJsonParserError::InternalError;  ///< Error, if node is nullptr
+	std::size_t component_index = 0;  ///< Index of the path component which caused the error
+};
 
-	std::vector<std::string> components;
-	hz::string_split(path, '/', components, true);
 
-	if (components.empty()) {
-		return hz::Unexpected(SmartctlJsonParserError::EmptyPath, "Cannot get node data: Empty path.");
+
+/// Find a node in json data. This doesn't allocate memory or throw; the error messages
+/// are made by lookup_error() only when the error is reported.
+[[nodiscard]] inline JsonNodeLookup lookup_node(const nlohmann::json& root, const JsonPath& path) noexcept
+{
+	JsonNodeLookup lookup;
+	if (path.size() == 0) {
+		lookup.error = SmartctlJsonParserError::EmptyPath;
+		return lookup;
+	}
+	if (path.too_long()) {
+		lookup.error = SmartctlJsonParserError::InternalError;
+		return lookup;
 	}
 
 	const auto* curr = &root;
-	for (std::size_t comp_index = 0; comp_index < components.size(); ++comp_index) {
-		const std::string& comp_name = components[comp_index];
+	for (std::size_t comp_index = 0; comp_index < path.size(); ++comp_index) {
+		lookup.component_index = comp_index;
 
 		if (!curr->is_object()) {  // we can't have non-object values in the middle of a path
-			return hz::Unexpected(SmartctlJsonParserError::UnexpectedObjectInPath,
-					fmt::format("Cannot get node data \"{}\", component \"{}\" is not an object.", path, comp_name));
+			lookup.error = SmartctlJsonParserError::UnexpectedObjectInPath;
+			return lookup;
 		}
-		if (auto iter = curr->find(comp_name); iter != curr->end()) {  // path component exists
-			const auto& jval = iter.value();
-			if (comp_index + 1 == components.size()) {  // it's the "value" component
-				return jval;
-			}
-			// continue to the next component
-			curr = &jval;
-
-		} else {  // path component doesn't exist
-			return hz::Unexpected(SmartctlJsonParserError::PathNotFound,
-					fmt::format("Cannot get node data \"{}\", component \"{}\" does not exist.", path, comp_name));
+		// Note: The transparent object comparator allows looking up string_view without conversion.
+		auto iter = curr->find(path[comp_index]);
+		if (iter == curr->end()) {  // path component doesn't exist
+			lookup.error = SmartctlJsonParserError::PathNotFound;
+			return lookup;
 		}
+		curr = &iter.value();  // continue to the next component
 	}
 
+	lookup.node = curr;
+	return lookup;
+}
+
+
+
+/// Make an error with a message from a failed lookup_node() result
+[[nodiscard]] inline auto lookup_error(const JsonNodeLookup& lookup, const JsonPath& path)
+{
+	const std::string_view comp_name = (lookup.component_index < path.size() ? path[lookup.component_index] : std::string_view());
+	switch (lookup.error) {
+		case SmartctlJsonParserError::EmptyPath:
+			return hz::Unexpected(SmartctlJsonParserError::EmptyPath, "Cannot get node data: Empty path.");
+		case SmartctlJsonParserError::UnexpectedObjectInPath:
+			return hz::Unexpected(SmartctlJsonParserError::UnexpectedObjectInPath,
+					fmt::format("Cannot get node data \"{}\", component \"{}\" is not an object.", path.str(), comp_name));
+		case SmartctlJsonParserError::PathNotFound:
+			return hz::Unexpected(SmartctlJsonParserError::PathNotFound,
+					fmt::format("Cannot get node data \"{}\", component \"{}\" does not exist.", path.str(), comp_name));
+		case SmartctlJsonParserError::InternalError:
+			if (path.too_long()) {
+				return hz::Unexpected(SmartctlJsonParserError::InternalError, fmt::format("Cannot get node data \"{}\": Path is too long.", path.str()));
+			}
+			break;
+		case SmartctlJsonParserError::TypeError:
+			break;
+	}
 	return hz::Unexpected(SmartctlJsonParserError::InternalError, "Internal error.");
 }
 
 
 
+/// Get node from json data.
+/// \return A pointer into \c root (valid while \c root is alive and unmodified).
+[[nodiscard]] inline hz::ExpectedValue<const nlohmann::json*, SmartctlJsonParserError>
+get_node(const nlohmann::json& root, const JsonPath& path)
+{
+	const JsonNodeLookup lookup = lookup_node(root, path);
+	if (!lookup.node) {
+		return lookup_error(lookup, path);
+	}
+	return lookup.node;
+}
+
+
+
+/// Find a node which may be absent. Unlike get_node(), this doesn't allocate memory.
+/// \return nullptr if the node doesn't exist (or the path goes through a non-object node).
+[[nodiscard]] inline const nlohmann::json* find_node(const nlohmann::json& root, const JsonPath& path) noexcept
+{
+	return lookup_node(root, path).node;
+}
+
+
 
-/// Get json node data. The path is slash-separated string.
+/// Convert a node value to T. Mismatches of the common (arithmetic and string) types are
+/// detected without throwing json::type_error.
+/// \return std::nullopt if the node has a different type.
+template<typename T>
+[[nodiscard]] std::optional<T> get_node_value_nothrow(const nlohmann::json& node)
+{
+	if constexpr (std::is_same_v<T, bool>) {
+		if (!node.is_boolean()) {
+			return std::nullopt;
+		}
+	} else if constexpr (std::is_arithmetic_v<T>) {
+		if (node.is_number()) {
+			return node.get<T>();
+		}
+		if (!node.is_boolean()) {  // some arithmetic types accept booleans, let json decide below
+			return std::nullopt;
+		}
+	} else if constexpr (std::is_same_v<T, std::string>) {
+		if (!node.is_string()) {
+			return std::nullopt;
+		}
+	}
+
+	try {
+		return node.get<T>();  // may throw json::type_error
+	}
+	catch (nlohmann::json::type_error&) {
+		return std::nullopt;
+	}
+}
+
+
+
+/// Get json node data.
 /// \return SmartctlJsonParserError on error.
 template<typename T>
-[[nodiscard]] hz::ExpectedValue<T, SmartctlJsonParserError> get_node_data(const nlohmann::json& root, std::string_view path)
+[[nodiscard]] hz::ExpectedValue<T, SmartctlJsonParserError> get_node_data(const nlohmann::json& root, const JsonPath& path)
 {
-	auto node_result = get_node(root, path);
-	if (!node_result) {
-		return hz::UnexpectedFrom(node_result);
+	const JsonNodeLookup lookup = lookup_node(root, path);
+	if (!lookup.node) {
+		return lookup_error(lookup, path);
 	}
 
+	if (auto value = get_node_value_nothrow<T>(*lookup.node)) {
+		return std::move(value.value());
+	}
+
+	// Get the message of the type error
 	try {
-		return node_result.value().get<T>();  // may throw json::type_error
+		return lookup.node->get<T>();  // throws json::type_error
 	}
 	catch (nlohmann::json::type_error& ex) {
 		return hz::Unexpected(SmartctlJsonParserError::TypeError,
-				fmt::format("Cannot get node data \"{}\", component has wrong type: {}.", path, ex.what()));
+				fmt::format("Cannot get node data \"{}\", component has wrong type: {}.", path.str(), ex.what()));
 	}
 }
 
 
 
-/// Get json node data. The path is slash-separated string.
+/// Get json node data.
 /// If the data is not is found, the default value is returned.
 template<typename T>
-[[nodiscard]] hz::ExpectedValue<T, SmartctlJsonParserError> get_node_data(const nlohmann::json& root, std::string_view path, const T& default_value)
+[[nodiscard]] hz::ExpectedValue<T, SmartctlJsonParserError> get_node_data(const nlohmann::json& root, const JsonPath& path, const T& default_value)
 {
-	auto expected_data = get_node_data<T>(root, path);
+	const JsonNodeLookup lookup = lookup_node(root, path);
+	if (!lookup.node && lookup.error == SmartctlJsonParserError::PathNotFound) {
+		return default_value;  // no error message needed
+	}
+	return get_node_data<T>(root, path);
+}
 
-	if (!expected_data.has_value()) {
-		switch(expected_data.error().data()) {
-			case SmartctlJsonParserError::PathNotFound:
-				return default_value;
 
-			case SmartctlJsonParserError::TypeError:
-			case SmartctlJsonParserError::UnexpectedObjectInPath:
-			case SmartctlJsonParserError::EmptyPath:
-			case SmartctlJsonParserError::InternalError:
-				break;
-		}
-	}
 
-	return expected_data;
+/// Get json node data which is expected to be absent on some drives. This doesn't allocate
+/// memory (except for the value itself) or throw when the data is absent or has a wrong type.
+/// \return std::nullopt on any error.
+template<typename T>
+[[nodiscard]] std::optional<T> get_node_data_optional(const nlohmann::json& root, const JsonPath& path)
+{
+	if (const auto* node = find_node(root, path)) {
+		return get_node_value_nothrow<T>(*node);
+	}
+	return std::nullopt;
 }
 
 
 
-/// Check if json node exists. The path is slash-separated string.
+/// Check if json node exists.
 [[nodiscard]] inline hz::ExpectedValue<bool, SmartctlJsonParserError>
-get_node_exists(const nlohmann::json& root, std::string_view path)
+get_node_exists(const nlohmann::json& root, const JsonPath& path)
 {
-	auto node_result = get_node(root, path);
-	if (node_result.has_value()) {
+	const JsonNodeLookup lookup = lookup_node(root, path);
+	if (lookup.node) {
 		return true;
 	}
+	if (lookup.error == SmartctlJsonParserError::PathNotFound) {
+		return false;
+	}
+	return lookup_error(lookup, path);
+}
 
-	switch (node_result.error().data()) {
-		case SmartctlJsonParserError::PathNotFound:
-			return false;
 
-		case SmartctlJsonParserError::UnexpectedObjectInPath:
-		case SmartctlJsonParserError::EmptyPath:
-		case SmartctlJsonParserError::InternalError:
-		case SmartctlJsonParserError::TypeError:
-			break;
+
+/// Value type of a JsonFieldMapping field
+enum class JsonFieldType {
+	Integer,  ///< int64_t value
+	Bool,  ///< bool value
+	String,  ///< std::string value
+};
+
+
+
+/// A field of a declarative section mapping, see parse_json_fields()
+struct JsonFieldMapping {
+	std::string_view path;  ///< Path relative to the subtree the fields are parsed from
+	const char* displayable_name = "";  ///< Property displayable name (translated)
+	JsonFieldType type = JsonFieldType::Integer;  ///< Value type
+	std::string_view text_format;  ///< Text line with "{}" for the value ("Yes" / "No" for Bool). Empty for no line.
+	bool add_if_absent = false;  ///< Add the property (with a zero / empty value) even if the field is absent
+	bool show_in_ui = true;  ///< StorageProperty::show_in_ui of the property
+};
+
+
+
+/// Parse the fields of a JSON subtree (e.g. "ata_sct_status") according to a declarative mapping.
+/// The subtree is looked up once, and each field once in it (with its value converted once).
+/// For each field present, a property named "<subtree_path>/<field path>" is created in \c section
+/// and passed to \c add_property, and if the field has a text format, a text line is appended to \c lines.
+/// The fields with a value of a wrong type get a zero / empty value.
+/// \return true if any field was present.
+template<typename AddPropertyFunc>
+bool parse_json_fields(const nlohmann::json& root, std::string_view subtree_path, std::span<const JsonFieldMapping> fields,
+		StoragePropertySection section, std::vector<std::string>* lines, AddPropertyFunc&& add_property)
+{
+	const nlohmann::json* subtree = find_node(root, subtree_path);
+	bool any_found = false;
+
+	for (const auto& field : fields) {
+		const nlohmann::json* node = (subtree ? find_node(*subtree, field.path) : nullptr);
+		if (!node && !field.add_if_absent) {
+			continue;
+		}
+		any_found = any_found || (node != nullptr);
+
+		StorageProperty p;
+		p.set_name(fmt::format("{}/{}", subtree_path, field.path), field.displayable_name);
+		p.section = section;
+		p.show_in_ui = field.show_in_ui;
+
+		std::string text_value;
+		switch (field.type) {
+			case JsonFieldType::Integer:
+			{
+				const auto value = (node ? get_node_value_nothrow<int64_t>(*node) : std::nullopt).value_or(0);
+				p.value = value;
+				if (!field.text_format.empty()) {
+					text_value = std::to_string(value);
+				}
+				break;
+			}
+			case JsonFieldType::Bool:
+			{
+				const auto value = (node ? get_node_value_nothrow<bool>(*node) : std::nullopt).value_or(false);
+				p.value = value;
+				text_value = (value ? "Yes" : "No");
+				break;
+			}
+			case JsonFieldType::String:
+			{
+				auto value = (node ? get_node_value_nothrow<std::string>(*node) : std::nullopt).value_or(std::string());
+				if (!field.text_format.empty()) {
+					text_value = value;
+				}
+				p.value = std::move(value);
+				break;
+			}
+		}
+
+		if (lines && !field.text_format.empty()) {
+			lines->emplace_back(fmt::format(fmt::runtime(field.text_format), text_value));
+		}
+		add_property(std::move(p));
 	}
 
-	return hz::UnexpectedFrom(node_result);
+	return any_found;
 }
 
 
@@ -168,7 +460,7 @@ inline auto string_formatter()
 	return [](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 			-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 	{
-		if (auto jval = get_node_data<std::string>(root_node, key); jval) {
+		if (auto jval = get_node_data_optional<std::string>(root_node, key); jval) {
 			StorageProperty p;
 			p.set_name(key, displayable_name);
 			// p.reported_value = jval.value();
@@ -212,7 +504,7 @@ inline auto bool_formatter(const std::string_view& true_str, const std::string_v
 	return [true_str, false_str](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 		-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 	{
-		if (auto jval = get_node_data<bool>(root_node, key); jval) {
+		if (auto jval = get_node_data_optional<bool>(root_node, key); jval) {
 			StorageProperty p;
 			p.set_name(key, displayable_name);
 			// p.reported_value = (jval.value() ? true_str : false_str);
@@ -234,7 +526,7 @@ auto integer_formatter(const std::string& format_string = "{}")
 	return [format_string](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 		-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 	{
-		if (auto jval = get_node_data<IntegerType>(root_node, key); jval) {
+		if (auto jval = get_node_data_optional<IntegerType>(root_node, key); jval) {
 			StorageProperty p;
 			p.set_name(key, displayable_name);
 			// p.reported_value = (jval.value() ? true_str : false_str);
@@ -256,7 +548,7 @@ auto custom_string_formatter(std::function<std::string(Type value)> formatter)
 	return [formatter](const nlohmann::json& root_node, const std::string& key, const std::string& displayable_name)
 			-> hz::ExpectedValue<StorageProperty, SmartctlParserError>
 	{
-		if (auto jval = get_node_data<Type>(root_node, key); jval) {
+		if (auto jval = get_node_data_optional<Type>(root_node, key); jval) {
 			StorageProperty p;
 			p.set_name(key, displayable_name);
 			// p.reported_value = formatter(jval.value());
@@ -304,9 +596,9 @@ auto custom_string_formatter(std::function<std::string(Type value)> formatter)
 	{
 		full_property.set_name("smartctl/version/_merged_full", _("Smartctl Version"));
 		full_property.readable_value = fmt::format("{}.{} r{} {} {}", json_ver->at(0), json_ver->at(1),
-				get_node_data<std::string>(json_root_node, "smartctl/svn_revision", {}).value_or(std::string()),
-				get_node_data<std::string>(json_root_node, "smartctl/platform_info", {}).value_or(std::string()),
-				get_node_data<std::string>(json_root_node, "smartctl/build_info", {}).value_or(std::string())
+				get_node_data_optional<std::string>(json_root_node, "smartctl/svn_revision").value_or(std::string()),
+				get_node_data_optional<std::string>(json_root_node, "smartctl/platform_info").value_or(std::string()),
+				get_node_data_optional<std::string>(json_root_node, "smartctl/build_info").value_or(std::string())
 		);
 		full_property.value = full_property.readable_value;  // string-type value
 		full_property.section = StoragePropertySection::Info;  // add to info section
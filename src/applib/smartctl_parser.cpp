@@ -9,6 +9,9 @@ Copyright:
 /// \weakgroup applib
 /// @{
 
+#include <algorithm>  // std::find, std::any_of
+#include <array>
+#include <cstdint>
 #include <locale>
 #include <cctype>  // isspace
 #include <utility>
@@ -23,10 +26,69 @@ Copyright:
 #include "smartctl_text_basic_parser.h"
 #include "storage_property_repository.h"
 #include "smartctl_json_nvme_parser.h"
+#include "storage_error_log_journal.h"
+#include "worker_threads.h"
 //#include "ata_storage_property_descr.h"
 
 
 
+namespace {
+
+	/// Number of bytes at the beginning of text output searched for the drive type markers.
+	/// The information section is well within it.
+	constexpr std::size_t signature_text_prefix_size = 8 * 1024;
+
+
+	/// Check whether \c text has a "<field> <value>" line (with any amount of whitespace in between),
+	/// where the value starts with \c value_prefix.
+	bool text_field_starts_with(std::string_view text, std::string_view field, std::string_view value_prefix)
+	{
+		std::size_t pos = 0;
+		while ((pos = text.find(field, pos)) != std::string_view::npos) {
+			pos += field.size();
+			const std::size_t value_pos = text.find_first_not_of(" \t", pos);
+			if (value_pos != std::string_view::npos && text.substr(value_pos).starts_with(value_prefix)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+	/// Find the string value of \c quoted_key (e.g. "\"protocol\"") in JSON data without parsing it.
+	/// \return An empty string if not found.
+	std::string_view json_find_string_value(std::string_view json, std::string_view quoted_key)
+	{
+		constexpr std::string_view whitespace = " \t\r\n";
+		std::size_t pos = 0;
+		while ((pos = json.find(quoted_key, pos)) != std::string_view::npos) {
+			// Quotes inside JSON strings (e.g. the embedded text output) are escaped
+			const bool escaped = (pos > 0 && json[pos - 1] == '\\');
+			pos += quoted_key.size();
+			if (escaped) {
+				continue;
+			}
+			std::size_t value_pos = json.find_first_not_of(whitespace, pos);
+			if (value_pos == std::string_view::npos || json[value_pos] != ':') {
+				continue;
+			}
+			value_pos = json.find_first_not_of(whitespace, value_pos + 1);
+			if (value_pos == std::string_view::npos || json[value_pos] != '"') {
+				continue;
+			}
+			const std::size_t value_end = json.find('"', value_pos + 1);
+			if (value_end == std::string_view::npos) {
+				break;
+			}
+			return json.substr(value_pos + 1, value_end - value_pos - 1);
+		}
+		return {};
+	}
+
+}
+
+
+
 std::unique_ptr<SmartctlParser> SmartctlParser::create(SmartctlParserType type, SmartctlOutputFormat format)
 {
 	switch(type) {
@@ -83,6 +145,78 @@ hz::ExpectedValue<SmartctlOutputFormat, SmartctlParserError> SmartctlParser::det
 
 
 
+hz::ExpectedValue<SmartctlOutputSignature, SmartctlParserError> SmartctlParser::detect_output_signature(std::string_view smartctl_output)
+{
+	auto format = detect_output_format(smartctl_output);
+	if (!format) {
+		return hz::UnexpectedFrom(format);
+	}
+
+	SmartctlOutputSignature signature;
+	signature.format = format.value();
+
+	if (signature.format == SmartctlOutputFormat::Json) {
+		// "ATA", "NVMe" or "SCSI". This is the same check as in StorageDevice::detect_drive_type_from_properties().
+		const std::string_view protocol = json_find_string_value(smartctl_output, "\"protocol\"");
+		if (protocol == "ATA") {
+			signature.parser_type = SmartctlParserType::Ata;
+		} else if (protocol == "NVMe") {
+			signature.parser_type = SmartctlParserType::Nvme;
+		}
+		return signature;
+	}
+
+	// Text. These are the markers SmartctlTextBasicParser uses to detect the drive type.
+	const std::string_view prefix = smartctl_output.substr(0, signature_text_prefix_size);
+	const bool basic_only = (prefix.find("this device: CD/DVD") != std::string_view::npos
+			|| text_field_starts_with(prefix, "Device type:", "CD/DVD")
+			|| text_field_starts_with(prefix, "Product:", "Raid"));
+	if (!basic_only) {
+		if (prefix.find("ATA Version is:") != std::string_view::npos) {
+			signature.parser_type = SmartctlParserType::Ata;
+		} else if (prefix.find("NVMe Version:") != std::string_view::npos) {
+			signature.parser_type = SmartctlParserType::Nvme;
+		}
+	}
+	return signature;
+}
+
+
+
+std::uint64_t SmartctlParser::get_output_content_hash(std::string_view smartctl_output)
+{
+	// The lines containing these change on every run without any other change in drive data.
+	// The json ones are the members of "local_time", which also appear in the embedded text output.
+	static constexpr std::array<std::string_view, 3> volatile_markers = {
+		"Local Time is:",
+		"\"time_t\":",
+		"\"asctime\":",
+	};
+
+	// FNV-1a
+	std::uint64_t hash = 0xcbf29ce484222325ULL;
+	std::size_t pos = 0;
+	while (pos < smartctl_output.size()) {
+		std::size_t end = smartctl_output.find('\n', pos);
+		end = (end == std::string_view::npos) ? smartctl_output.size() : end + 1;
+		const std::string_view line = smartctl_output.substr(pos, end - pos);
+		pos = end;
+
+		const bool is_volatile = std::any_of(volatile_markers.begin(), volatile_markers.end(),
+				[&line](std::string_view marker) { return line.find(marker) != std::string_view::npos; });
+		if (is_volatile) {
+			continue;
+		}
+		for (const char c : line) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 0x100000001b3ULL;
+		}
+	}
+	return hash;
+}
+
+
+
 const StoragePropertyRepository& SmartctlParser::get_property_repository() const
 {
 	return properties_;
@@ -90,6 +224,91 @@ const StoragePropertyRepository& SmartctlParser::get_property_repository() const
 
 
 
+StoragePropertyRepository SmartctlParser::take_property_repository()
+{
+	return std::exchange(properties_, StoragePropertyRepository());
+}
+
+
+
+void SmartctlParser::set_keep_text_output(bool keep)
+{
+	keep_text_output_ = keep;
+}
+
+
+
+bool SmartctlParser::get_keep_text_output() const
+{
+	return keep_text_output_;
+}
+
+
+
+void SmartctlParser::set_requested_sections(std::vector<StoragePropertySection> sections)
+{
+	requested_sections_ = std::move(sections);
+}
+
+
+
+bool SmartctlParser::get_section_requested(StoragePropertySection section) const
+{
+	return requested_sections_.empty() || section == StoragePropertySection::Info
+			|| std::find(requested_sections_.begin(), requested_sections_.end(), section) != requested_sections_.end();
+}
+
+
+
+const std::vector<StoragePropertySection>& SmartctlParser::get_requested_sections() const
+{
+	return requested_sections_;
+}
+
+
+
+void SmartctlParser::set_max_log_entries(std::size_t max_entries)
+{
+	max_log_entries_ = max_entries;
+}
+
+
+
+std::size_t SmartctlParser::get_max_log_entries() const
+{
+	return max_log_entries_;
+}
+
+
+
+void SmartctlParser::set_error_log_journal(std::shared_ptr<StorageErrorLogJournal> journal)
+{
+	error_log_journal_ = std::move(journal);
+}
+
+
+
+const std::shared_ptr<StorageErrorLogJournal>& SmartctlParser::get_error_log_journal() const
+{
+	return error_log_journal_;
+}
+
+
+
+void SmartctlParser::set_parallel_parse_min_size(std::size_t min_size)
+{
+	parallel_parse_min_size_ = min_size;
+}
+
+
+
+bool SmartctlParser::get_parallel_parse_enabled(std::size_t output_size) const
+{
+	return parallel_parse_min_size_ != 0 && output_size >= parallel_parse_min_size_;
+}
+
+
+
 // adds a property into property list, looks up and sets its description.
 // Yes, there's no place for this in the Parser, but whatever...
 void SmartctlParser::add_property(StorageProperty p)
@@ -99,6 +318,58 @@ void SmartctlParser::add_property(StorageProperty p)
 
 
 
+std::unique_ptr<SmartctlParser> SmartctlParser::create_section_parser() const
+{
+	return nullptr;
+}
+
+
+
+std::vector<SmartctlSectionParseResult> SmartctlParser::parse_sections_concurrently(
+		const std::vector<section_parse_func_t>& section_funcs)
+{
+	std::vector<SmartctlSectionParseResult> results(section_funcs.size());
+
+	std::vector<std::unique_ptr<SmartctlParser>> section_parsers;
+	section_parsers.reserve(section_funcs.size());
+	for (std::size_t i = 0; i < section_funcs.size(); ++i) {
+		std::unique_ptr<SmartctlParser> section_parser = create_section_parser();
+		if (!section_parser) {  // not supported, parse one by one
+			for (std::size_t j = 0; j < section_funcs.size(); ++j) {
+				results[j].parsed = section_funcs[j](*this);
+			}
+			return results;
+		}
+		section_parser->set_keep_text_output(get_keep_text_output());
+		section_parser->set_requested_sections(get_requested_sections());
+		section_parser->set_max_log_entries(get_max_log_entries());
+		section_parser->set_error_log_journal(get_error_log_journal());
+		section_parsers.push_back(std::move(section_parser));
+	}
+
+	{
+		AppTaskGroup group;
+		for (std::size_t i = 0; i < section_funcs.size(); ++i) {
+			group.run([&section_funcs, &section_parsers, &results, i]() {
+				results[i].parsed = section_funcs[i](*section_parsers[i]);
+				results[i].properties = std::move(section_parsers[i]->properties_.get_properties_ref());
+			});
+		}
+		group.wait(false);  // CPU-only, don't iterate the caller's main context
+	}
+
+	// The repository keeps the properties grouped by section in the order they were added,
+	// so adding them section parser by section parser gives the same result as parsing one by one.
+	for (const auto& result : results) {
+		for (const auto& p : result.properties) {
+			properties_.add_property(p);
+		}
+	}
+	return results;
+}
+
+
+
 
 
 /// @}
@@ -12,8 +12,12 @@ Copyright:
 #ifndef SMARTCTL_PARSER_H
 #define SMARTCTL_PARSER_H
 
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <functional>
 #include <string_view>
 #include <memory>
+#include <vector>
 
 #include "storage_property.h"
 #include "smartctl_parser_types.h"
@@ -21,6 +25,24 @@ Copyright:
 #include "storage_property_repository.h"
 
 
+class StorageErrorLogJournal;
+
+
+
+/// Output format and drive type, determined by SmartctlParser::detect_output_signature()
+struct SmartctlOutputSignature {
+	SmartctlOutputFormat format = SmartctlOutputFormat::Text;  ///< Output format
+	SmartctlParserType parser_type = SmartctlParserType::Basic;  ///< Parser for the drive type. Basic if the type is unknown.
+};
+
+
+
+/// Result of one section parser run by SmartctlParser::parse_sections_concurrently()
+struct SmartctlSectionParseResult {
+	bool parsed = false;  ///< Value returned by the section parser
+	std::vector<StorageProperty> properties;  ///< Properties added by the section parser, in the order they were added
+};
+
 
 
 /// Smartctl output parser.
@@ -63,19 +85,111 @@ class SmartctlParser {
 		[[nodiscard]] static hz::ExpectedValue<SmartctlOutputFormat, SmartctlParserError> detect_output_format(std::string_view smartctl_output);
 
 
+		/// Detect smartctl output format and the parser for its drive type without parsing the output.
+		/// For JSON this looks at the "device/protocol" key, for text at the information
+		/// section markers near the beginning of the output.
+		[[nodiscard]] static hz::ExpectedValue<SmartctlOutputSignature, SmartctlParserError> detect_output_signature(std::string_view smartctl_output);
+
+
+		/// Get a hash of smartctl output (text or json) with the volatile lines ("Local Time is:",
+		/// json "local_time" members) left out. Two outputs with the same hash parse to the same properties.
+		[[nodiscard]] static std::uint64_t get_output_content_hash(std::string_view smartctl_output);
+
+
 		/// Get parsed properties.
 		[[nodiscard]] const StoragePropertyRepository& get_property_repository() const;
 
 
+		/// Move the parsed properties out of the parser, leaving it without properties.
+		[[nodiscard]] StoragePropertyRepository take_property_repository();
+
+
+		/// Set whether JSON parsers should keep the text output embedded with --json=o
+		/// (as "smartctl/output" property). It is only needed for saving the data as text.
+		/// Call before parse(). The default is true.
+		void set_keep_text_output(bool keep);
+
+
+		/// Get whether JSON parsers should keep the embedded text output.
+		[[nodiscard]] bool get_keep_text_output() const;
+
+
+		/// Set which sections to parse. The other sections are skipped even if they are present
+		/// in the output. The Info section is always parsed. Call before parse().
+		/// An empty vector (the default) means all sections.
+		void set_requested_sections(std::vector<StoragePropertySection> sections);
+
+
+		/// Check whether a section should be parsed
+		[[nodiscard]] bool get_section_requested(StoragePropertySection section) const;
+
+
+		/// Get the sections set by set_requested_sections()
+		[[nodiscard]] const std::vector<StoragePropertySection>& get_requested_sections() const;
+
+
+		/// Set the maximum number of error log and self-test log entries to store as properties.
+		/// The logs are kept in the order of smartctl output, so the most recent entries are stored.
+		/// Call before parse(). 0 (the default) means all entries.
+		void set_max_log_entries(std::size_t max_entries);
+
+
+		/// Get the maximum number of stored log entries, 0 if unlimited.
+		[[nodiscard]] std::size_t get_max_log_entries() const;
+
+
+		/// Set the error log journal of the drive. The error log entries ingested before
+		/// (see StorageErrorLogJournal) are taken from it instead of being parsed again, and the new
+		/// ones are stored in it. The caller calls its begin() before parse(). Call before parse().
+		void set_error_log_journal(std::shared_ptr<StorageErrorLogJournal> journal);
+
+
+		/// Get the journal set by set_error_log_journal(), may be nullptr.
+		[[nodiscard]] const std::shared_ptr<StorageErrorLogJournal>& get_error_log_journal() const;
+
+
+		/// Set the output size from which the independent sections (e.g. large error logs
+		/// and device statistics) are parsed concurrently on the worker pool. The resulting
+		/// properties are the same. 0 means never. Call before parse(). The default is 256 KiB.
+		void set_parallel_parse_min_size(std::size_t min_size);
+
+
+		/// Check whether the sections of an output of \c output_size bytes should be parsed concurrently
+		[[nodiscard]] bool get_parallel_parse_enabled(std::size_t output_size) const;
+
+
 	protected:
 
 		/// Add a property into property list, look up and set its description
 		void add_property(StorageProperty p);
 
 
+		/// A section parser for parse_sections_concurrently(). It parses one section into \c parser
+		/// (which is of the same type as this one), returning whether the section was parsed.
+		using section_parse_func_t = std::function<bool(SmartctlParser& parser)>;
+
+
+		/// Create an empty parser of the same type for parse_sections_concurrently().
+		/// \return nullptr if the parser cannot parse its sections concurrently (the default).
+		[[nodiscard]] virtual std::unique_ptr<SmartctlParser> create_section_parser() const;
+
+
+		/// Run \c section_funcs concurrently on the worker pool, each with its own new parser with the same
+		/// settings (see create_section_parser()), and add their properties to this parser in the order of
+		/// \c section_funcs, as if they had been run one by one on this parser. The section parsers
+		/// must not depend on the properties added by each other.
+		/// \return Parse status and properties of each section, in the order of \c section_funcs.
+		std::vector<SmartctlSectionParseResult> parse_sections_concurrently(const std::vector<section_parse_func_t>& section_funcs);
+
+
 	private:
 
 		StoragePropertyRepository properties_;  ///< Parsed data properties
+		bool keep_text_output_ = true;  ///< Keep the embedded text output or not (JSON only)
+		std::vector<StoragePropertySection> requested_sections_;  ///< Sections to parse. Empty means all.
+		std::size_t max_log_entries_ = 0;  ///< Maximum number of stored log entries. 0 means all.
+		std::shared_ptr<StorageErrorLogJournal> error_log_journal_;  ///< Error log journal, may be nullptr
+		std::size_t parallel_parse_min_size_ = 256 * 1024;  ///< Output size from which the sections are parsed concurrently. 0 means never.
 
 };
 
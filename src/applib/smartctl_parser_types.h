@@ -12,8 +12,9 @@ Copyright:
 #ifndef SMARTCTL_PARSER_TYPES_H
 #define SMARTCTL_PARSER_TYPES_H
 
-#include <glibmm.h>
 #include <glibmm/i18n.h>
+#include <array>
+#include <string>
 
 #include "hz/enum_helper.h"
 
@@ -60,21 +61,17 @@ enum class SmartctlParserPreferenceType {
 
 /// Helper structure for enum-related functions
 struct SmartctlParserPreferenceTypeExt
-		: public hz::EnumHelper<
+		: public hz::EnumTableHelper<
 				SmartctlParserPreferenceType,
-				SmartctlParserPreferenceTypeExt,
-				Glib::ustring>
+				SmartctlParserPreferenceTypeExt>
 {
 	static constexpr SmartctlParserPreferenceType default_value = SmartctlParserPreferenceType::Auto;
 
-	static std::unordered_map<EnumType, std::pair<std::string, Glib::ustring>> build_enum_map()
-	{
-		return {
-			{SmartctlParserPreferenceType::Auto, {"auto", _("Automatic")}},
-			{SmartctlParserPreferenceType::Json, {"json", _("JSON")}},
-			{SmartctlParserPreferenceType::Text, {"text", _("Text")}},
-		};
-	}
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{SmartctlParserPreferenceType::Auto, "auto", N_("Automatic")},
+		{SmartctlParserPreferenceType::Json, "json", N_("JSON")},
+		{SmartctlParserPreferenceType::Text, "text", N_("Text")},
+	});
 
 };
 
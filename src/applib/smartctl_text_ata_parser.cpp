@@ -12,12 +12,18 @@ Copyright:
 #include "smartctl_text_ata_parser.h"
 
 // #include <glibmm.h>
+#include <algorithm>
 #include <chrono>
 #include <clocale>  // localeconv
 #include <cstddef>
 #include <cstdint>
+#include <ctime>  // std::mktime
+#include <functional>  // std::hash
+#include <limits>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,9 +37,11 @@ Copyright:
 #include "app_regex.h"
 //#include "ata_storage_property_descr.h"
 // #include "warning_colors.h"
+#include "app_trace.h"
 #include "smartctl_parser_types.h"
 #include "smartctl_version_parser.h"
 #include "smartctl_text_parser_helper.h"
+#include "storage_error_log_journal.h"
 
 
 
@@ -71,131 +79,381 @@ namespace {
 	}
 
 
-}
 
+	/// An entry of the text error log
+	struct TextAtaErrorLogEntry {
+		std::string_view block;  ///< Entry text, from its header line to its last line
+		std::string name;  ///< "Error 6"
+		std::string error_num;  ///< "6"
+		std::string lifetime_hours;  ///< Lifetime in hours, from the header line
+	};
 
 
-// Parse full "smartctl -x" output
-hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse(std::string_view smartctl_output)
-{
-	// -------------------- Fix the output, so it doesn't interfere with proper parsing
+	/// Find the entries of the text error log in a single pass over its lines.
+	/// An entry is its header line and the indented lines after it, possibly separated by single empty lines.
+	/// At most \c max_entries first (most recent) entries are returned, 0 means all.
+	inline std::vector<TextAtaErrorLogEntry> text_ata_find_error_log_entries(std::string_view sub, std::size_t max_entries)
+	{
+		// "Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)"
+		// "Error 25 occurred at disk power-on lifetime: 14799 hours"
+		const auto re_header = app_regex_re(
+				R"(/^(Error[ \t]*([0-9]+))[ \t]*(?:\[[0-9]+\][ \t])?occurred at disk power-on lifetime:[ \t]*([0-9]+) hours/i)");
 
-	// perform any2unix
-	std::string s = hz::string_trim_copy(hz::string_any_to_unix_copy(smartctl_output));
+		std::vector<std::string_view> lines;
+		hz::string_split(sub, '\n', lines, false);
 
-	if (s.empty()) {
-		debug_out_warn("app", DBG_FUNC_MSG << "Empty string passed as an argument. Returning.\n");
-		return hz::Unexpected(SmartctlParserError::EmptyInput, "Smartctl data is empty.");
+		auto is_indented = [&lines](std::size_t index) {
+			return index < lines.size() && lines[index].starts_with("  ");
+		};
+
+		std::vector<TextAtaErrorLogEntry> entries;
+		for (std::size_t i = 0; i < lines.size() && (max_entries == 0 || entries.size() < max_entries); ++i) {
+			// Don't run the regexp on the lines which can't be headers
+			if (lines[i].size() < 5 || !hz::string_iequals(lines[i].substr(0, 5), "error")) {
+				continue;
+			}
+			TextAtaErrorLogEntry entry;
+			if (!app_regex_partial_match(re_header, std::string(lines[i]), {&entry.name, &entry.error_num, &entry.lifetime_hours})) {
+				continue;
+			}
+			std::size_t last = i;
+			while (true) {
+				if (is_indented(last + 1)) {
+					last += 1;
+				} else if (last + 1 < lines.size() && lines[last + 1].empty() && is_indented(last + 2)) {
+					last += 2;
+				} else {
+					break;
+				}
+			}
+			const auto begin_pos = static_cast<std::size_t>(lines[i].data() - sub.data());
+			const auto end_pos = static_cast<std::size_t>(lines[last].data() + lines[last].size() - sub.data());
+			entry.block = sub.substr(begin_pos, end_pos - begin_pos);
+			entries.push_back(std::move(entry));
+			i = last;
+		}
+		return entries;
 	}
 
 
-	// The first line may be a command, filter it out. e.g.
-	// # smartctl -a /dev/sda
-	// NO NEED: We ignore everything non-section (except version info).
-	// Note: We ignore non-section lines, so we don't need any filtering here.
-// 	{
-// 		app_regex_replace_once("/^# .*$/", "", s);  // replace first only, on the first line only.
-// 	}
 
+	/// How the value of a known Info section property is parsed
+	enum class TextInfoValueKind {
+		String,  ///< The reported value as is
+		ByteSize,  ///< Byte size with a human-readable value
+		Integer,  ///< Integer at the beginning of the reported value
+		InDatabase,  ///< "In smartctl database" / "Not in smartctl database"
+		SmartSupport,  ///< "SMART support is" lines, named by their free-form value
+	};
 
-	// Checksum warnings are kind of randomly distributed, so
-	// extract and remove them.
+
+	/// Handler of a known Info section property
+	struct TextInfoPropertyHandler {
+		const char* generic_name = nullptr;  ///< Generic name to set, unused for SmartSupport
+		const char* displayable_name = nullptr;  ///< Displayable name to set, unused for SmartSupport
+		TextInfoValueKind kind = TextInfoValueKind::String;  ///< Value parsing
+	};
+
+
+	/// Get the handler of an Info section property by its lowercase reported name
+	/// (the text before the colon), nullptr if it's not known.
+	inline const TextInfoPropertyHandler* text_info_find_property_handler(const std::string& lower_name)
 	{
-		const auto re = app_regex_re("/\\nWarning! SMART (.+) Structure error: invalid SMART checksum\\.$/mi");
-		for (auto it = std::sregex_iterator(s.begin(), s.end(), re), end = std::sregex_iterator(); it != end; ++it) {
-			const std::string structure_name = hz::string_trim_copy(it->str(1));
-			add_property(app_get_checksum_error_property(structure_name));
+		using enum TextInfoValueKind;
+		static const std::unordered_map<std::string, TextInfoPropertyHandler> m {
+			{"model family", {"model_family", "Model Family", String}},
+			{"device model", {"model_name", "Device Model", String}},
+			{"device", {"model_name", "Device Model", String}},  // scsi/usb
+			{"product", {"model_name", "Device Model", String}},  // scsi/usb
+			{"vendor", {"vendor", "Vendor", String}},  // scsi/usb
+			{"revision", {"revision", "Revision", String}},  // scsi/usb
+			{"device type", {"device_type/name", "Device Type", String}},  // scsi/usb
+			{"compliance", {"scsi_version", "Compliance", String}},  // scsi/usb
+			{"serial number", {"serial_number", "Serial Number", String}},
+			{"lu wwn device id", {"wwn/_merged", "World Wide Name", String}},
+			{"add. product id", {"ata_additional_product_id", "Additional Product ID", String}},
+			{"firmware version", {"firmware_version", "Firmware Version", String}},
+			{"user capacity", {"user_capacity/bytes", "Capacity", ByteSize}},
+			// This contains 2 values (phys/logical, if they're different)
+			{"sector sizes", {"physical_block_size/_and/logical_block_size", "Sector Sizes", String}},
+			// This contains a single value (if it's not 512)
+			{"sector size", {"physical_block_size/_and/logical_block_size", "Sector Size", String}},
+			{"logical block size", {"logical_block_size", "Logical Block Size", String}},  // scsi/usb, "512 bytes"
+			{"rotation rate", {"rotation_rate", "Rotation Rate", Integer}},
+			{"form factor", {"form_factor/name", "Form Factor", String}},
+			{"device is", {"in_smartctl_database", "In Smartctl Database", InDatabase}},
+			{"ata version is", {"ata_version/string", "ATA Version", String}},
+			{"ata standard is", {"ata_version/string", "ATA Standard", String}},  // old, not present in smartctl 7.2
+			{"sata version is", {"sata_version/string", "SATA Version", String}},
+			{"local time is", {"local_time/asctime", "Scanned on", String}},
+			{"smart support is", {nullptr, nullptr, SmartSupport}},
+			// "-g all" stuff
+			{"aam feature is", {"ata_aam/enabled", "AAM Feature", String}},
+			{"aam level is", {"ata_aam/level", "AAM Level", String}},
+			{"apm feature is", {"ata_apm/enabled", "APM Feature", String}},
+			{"apm level is", {"ata_apm/level", "APM Level", String}},
+			{"rd look-ahead is", {"read_lookahead/enabled", "Read Look-Ahead", String}},
+			{"write cache is", {"write_cache/enabled", "Write Cache", String}},
+			{"wt cache reorder", {"_text_only/write_cache_reorder", "Write Cache Reorder", String}},
+			{"dsn feature is", {"ata_dsn/enabled", "DSN Feature", String}},
+			{"power mode was", {"_text_only/power_mode", "Power Mode", String}},
+			{"power mode is", {"_text_only/power_mode", "Power Mode", String}},
+			{"ata security is", {"ata_security/string", "ATA Security", String}},
+		};
+		auto iter = m.find(lower_name);
+		return (iter != m.end() ? &iter->second : nullptr);
+	}
+
+
+
+	/// Known names of the Capabilities section blocks
+	enum class TextCapabilityName {
+		OfflineStatusGroup,  ///< "Offline data collection status"
+		OfflineCapGroup,  ///< "Offline data collection capabilities"
+		SmartCapGroup,  ///< "SMART capabilities"
+		ErrorLogCapGroup,  ///< "Error logging capability"
+		SctCapGroup,  ///< "SCT capabilities"
+		SelftestStatus,  ///< "Self-test execution status"
+		OfflineTime,  ///< "Total time to complete Offline data collection"
+		SelftestShortTime,  ///< "Short self-test routine recommended polling time"
+		SelftestLongTime,  ///< "Extended self-test routine recommended polling time"
+		ConvSelftestTime,  ///< "Conveyance self-test routine recommended polling time"
+	};
+
+
+	/// Find a Capabilities section block name. The name is matched caselessly, and
+	/// "Off-line" is the same as "Offline" (smartctl gradually changed the spelling).
+	inline std::optional<TextCapabilityName> text_capability_find_name(const std::string& reported_name)
+	{
+		using enum TextCapabilityName;
+		static const std::unordered_map<std::string, TextCapabilityName> m {
+			{"offline data collection status", OfflineStatusGroup},
+			{"offline data collection capabilities", OfflineCapGroup},
+			{"smart capabilities", SmartCapGroup},
+			{"error logging capability", ErrorLogCapGroup},
+			{"sct capabilities", SctCapGroup},
+			{"self-test execution status", SelftestStatus},
+			{"total time to complete offline data collection", OfflineTime},
+			{"short self-test routine recommended polling time", SelftestShortTime},
+			{"extended self-test routine recommended polling time", SelftestLongTime},
+			{"conveyance self-test routine recommended polling time", ConvSelftestTime},
+		};
+		std::string key = hz::string_to_lower_copy(reported_name);
+		hz::string_replace(key, "off-line", "offline");
+		auto iter = m.find(key);
+		if (iter != m.end()) {
+			return iter->second;
 		}
-		app_regex_replace(re, "", s);  // remove them from s.
+		return std::nullopt;
 	}
 
-	// Remove some additional stuff which doesn't fit
-	// Display this warning somewhere? (info section?)
-	// Or not, these options don't do anything crucial - just some translation stuff.
+
+
+	/// Parse "YYYY-MM-DD" and "HH:MM" of the SCT temperature history table as local time
+	inline std::optional<int64_t> text_parse_sct_temperature_time(std::string_view date, std::string_view time)
 	{
-		app_regex_replace("/\\n.*May need -F samsung or -F samsung2 enabled; see manual for details\\.$/mi",
-				"", s);  // remove from s
+		int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+		if (date.size() != 10 || date[4] != '-' || date[7] != '-' || time.size() != 5 || time[2] != ':'
+				|| !hz::string_is_numeric_nolocale(std::string(date.substr(0, 4)), year, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(date.substr(5, 2)), month, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(date.substr(8, 2)), day, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(time.substr(0, 2)), hour, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(time.substr(3, 2)), minute, false, 10)) {
+			return std::nullopt;
+		}
+		std::tm tm = {};
+		tm.tm_year = year - 1900;
+		tm.tm_mon = month - 1;
+		tm.tm_mday = day;
+		tm.tm_hour = hour;
+		tm.tm_min = minute;
+		tm.tm_isdst = -1;  // let mktime() decide
+		const std::time_t t = std::mktime(&tm);
+		if (t == std::time_t(-1)) {
+			return std::nullopt;
+		}
+		return static_cast<int64_t>(t);
 	}
 
 
-	// The Warning: parts also screw up newlines sometimes (making double-newlines,
-	// confusing for section separation).
+
+	/// Parse the SCT temperature history table of the scttemp subsection into a circular buffer.
+	/// The rows skipped in the table ("...") have the temperature of the row before them.
+	/// \return std::nullopt if there is no table.
+	inline std::optional<AtaStorageTemperatureHistory> text_parse_sct_temperature_history(const std::string& sub)
 	{
-		const auto re = app_regex_re("/^(Warning: ATA error count.*\\n)\\n/mi");
+		// The drive keeps at most 478 one-byte samples (a 512-byte log sector).
+		constexpr std::size_t max_size = 0xffff;
+
+		std::string size_str, index_str;
+		if (!app_regex_partial_match("/^Temperature History Size \\(Index\\):[ \\t]+([0-9]+) \\(([0-9]+)\\)/mi", sub, {&size_str, &index_str})) {
+			return std::nullopt;
+		}
+		const auto size = hz::string_to_number_nolocale<std::size_t>(size_str, false);
+		if (size == 0 || size > max_size) {
+			return std::nullopt;
+		}
+
+		AtaStorageTemperatureHistory history;
+		history.samples.assign(size, AtaStorageTemperatureHistory::unknown_temperature);
+		history.write_index = static_cast<uint32_t>(hz::string_to_number_nolocale<std::size_t>(index_str, false) % size);
+
+		if (std::string interval; app_regex_partial_match("/^Temperature Logging Interval:[ \\t]+([0-9]+) minute/mi", sub, &interval)) {
+			history.logging_interval_minutes = std::max<int64_t>(1, hz::string_to_number_nolocale<int64_t>(interval, false));
+		}
+
+		// Rows look like " 362    2017-08-29 08:43    38  *******************"
+		std::optional<std::size_t> prev_index;
+		int8_t prev_temperature = AtaStorageTemperatureHistory::unknown_temperature;
+		bool skipped = false;
+		std::optional<int64_t> newest_time;
+		for (const std::string_view line : hz::string_split_view(sub, '\n', true)) {
+			std::vector<std::string_view> tokens;
+			for (const std::string_view token : hz::string_split_view_by_chars(line, " \t\r", true)) {
+				tokens.push_back(token);
+				if (tokens.size() == 4) {
+					break;
+				}
+			}
+			if (!tokens.empty() && tokens.front() == "...") {
+				skipped = true;
+				continue;
+			}
+			std::size_t index = 0;
+			if (tokens.size() < 4 || !hz::string_is_numeric_nolocale(std::string(tokens[0]), index, false, 10) || index >= size) {
+				continue;
+			}
+			const auto time = text_parse_sct_temperature_time(tokens[1], tokens[2]);
+			if (!time.has_value()) {
+				continue;  // not a table row
+			}
+
+			int64_t value = 0;
+			int8_t temperature = AtaStorageTemperatureHistory::unknown_temperature;
+			if (hz::string_is_numeric_nolocale(std::string(tokens[3]), value, false, 10)
+					&& value > AtaStorageTemperatureHistory::unknown_temperature && value <= std::numeric_limits<int8_t>::max()) {
+				temperature = static_cast<int8_t>(value);
+			}
+			if (skipped && prev_index.has_value()) {
+				for (std::size_t i = (prev_index.value() + 1) % size; i != index; i = (i + 1) % size) {
+					history.samples[i] = prev_temperature;
+				}
+			}
+			history.samples[index] = temperature;
+			prev_index = index;
+			prev_temperature = temperature;
+			skipped = false;
+			newest_time = time;  // the rows are oldest first
+		}
 
-		std::string match;
-		if (app_regex_partial_match(re, s, &match)) {
-			app_regex_replace(re, match, s);  // make one newline less
+		if (!newest_time.has_value()) {
+			return std::nullopt;
 		}
+		history.newest_time = newest_time.value();
+		return history;
 	}
 
 
-	// If the device doesn't support many things, the warnings aren't separated (for sections).
-	// Fix that. This affects old smartctl only (at least 6.5 fixed the warnings).
-	{
-		const auto re1 = app_regex_re("/^(Warning: device does not support Error Logging)$/mi");
-		const auto re2 = app_regex_re("/^(Warning: device does not support Self Test Logging)$/mi");
-		const auto re3 = app_regex_re("/^(Device does not support Selective Self Tests\\/Logging)$/mi");
-		const auto re4 = app_regex_re("/^(Warning: device does not support SCT Commands)$/mi");
-		std::string match;
+}
+
+
 
-		if (app_regex_partial_match(re1, s, &match))
-			app_regex_replace(re1, "\n" + match + "\n", s);  // add extra newlines
+void SmartctlTextAtaSubsectionCache::begin(const std::vector<StoragePropertySection>& requested_sections, std::size_t max_log_entries)
+{
+	if (requested_sections != requested_sections_ || max_log_entries != max_log_entries_) {
+		entries_.clear();
+		requested_sections_ = requested_sections;
+		max_log_entries_ = max_log_entries;
+	}
+	next_entries_.clear();
+	reused_count_ = 0;
+}
 
-		if (app_regex_partial_match(re2, s, &match))
-			app_regex_replace(re2, "\n" + match + "\n", s);  // add extra newlines
 
-		if (app_regex_partial_match(re3, s, &match))
-			app_regex_replace(re3, "\n" + match + "\n", s);  // add extra newlines
 
-		if (app_regex_partial_match(re4, s, &match))
-			app_regex_replace(re4, "\n" + match + "\n", s);  // add extra newlines
+const SmartctlTextAtaSubsectionCache::Entry* SmartctlTextAtaSubsectionCache::reuse(std::size_t text_hash)
+{
+	auto node = entries_.extract(text_hash);
+	if (node.empty()) {
+		return nullptr;
 	}
+	++reused_count_;
+	auto result = next_entries_.insert(std::move(node));
+	return &result.position->second;
+}
 
-	// Some errors get in the way of subsection detection and have little value, remove them.
+
+
+void SmartctlTextAtaSubsectionCache::store(std::size_t text_hash, Entry entry)
+{
+	next_entries_.insert_or_assign(text_hash, std::move(entry));
+}
+
+
+
+void SmartctlTextAtaSubsectionCache::finish()
+{
+	entries_ = std::move(next_entries_);
+	next_entries_.clear();
+}
+
+
+
+std::size_t SmartctlTextAtaSubsectionCache::get_reused_count() const
+{
+	return reused_count_;
+}
+
+
+
+void SmartctlTextAtaParser::set_subsection_cache(std::shared_ptr<SmartctlTextAtaSubsectionCache> cache)
+{
+	subsection_cache_ = std::move(cache);
+}
+
+
+
+std::unique_ptr<SmartctlParser> SmartctlTextAtaParser::create_section_parser() const
+{
+	return std::make_unique<SmartctlTextAtaParser>();
+}
+
+
+
+// Parse full "smartctl -x" output
+hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse(std::string_view smartctl_output)
+{
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse", "parser");
+	// -------------------- Fix the output, so it doesn't interfere with proper parsing
+
+	// The output is trimmed and converted to unix newlines by cleanup_ata_output() below,
+	// so no intermediate copies are made.
+	const std::string_view trimmed_output = hz::string_trim_view(smartctl_output);
+
+	if (trimmed_output.empty()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Empty string passed as an argument. Returning.\n");
+		return hz::Unexpected(SmartctlParserError::EmptyInput, "Smartctl data is empty.");
+	}
+
+
+	// The first line may be a command, filter it out. e.g.
+	// # smartctl -a /dev/sda
+	// NO NEED: We ignore everything non-section (except version info).
+	// Note: We ignore non-section lines, so we don't need any filtering here.
+// 	{
+// 		app_regex_replace_once("/^# .*$/", "", s);  // replace first only, on the first line only.
+// 	}
+
+
+	// Remove the checksum warnings and the stuff that gets in the way of section
+	// and subsection detection (single pass, see cleanup_ata_output()).
+	std::string s;
 	{
-		// "ATA_READ_LOG_EXT (addr=0x00:0x00, page=0, n=1) failed: 48-bit ATA commands not implemented"
-		// or "ATA_READ_LOG_EXT (addr=0x11:0x00, page=0, n=1) failed: scsi error aborted command"
-		// in front of "Read GP Log Directory failed" and "Read SATA Phy Event Counters failed".
-		const auto re1 = app_regex_re("/^(ATA_READ_LOG_EXT \\([^)]+\\) failed: .*)$/mi");
-		// "SMART WRITE LOG does not return COUNT and LBA_LOW register"
-		// in front of "SCT (Get) Error Recovery Control command failed" (scterc section)
-		const auto re2= app_regex_re("/^((?:Error )?SMART WRITE LOG does not return COUNT and LBA_LOW register)$/mi");
-		// "Read SCT Status failed: scsi error aborted command"
-		// in front of "Read SCT Temperature History failed" and "SCT (Get) Error Recovery Control command failed"
-		const auto re3= app_regex_re("/^(Read SCT Status failed: .*)$/mi");
-		// "Unknown SCT Status format version 0, should be 2 or 3."
-		const auto re4= app_regex_re("/^(Unknown SCT Status format version .*)$/mi");
-		// "Read SCT Data Table failed: scsi error aborted command"
-		const auto re5= app_regex_re("/^(Read SCT Data Table failed: .*)$/mi");
-		// "Write SCT Data Table failed: Undefined error: 0"
-		// in front of "Read SCT Temperature History failed"
-		const auto re6= app_regex_re("/^(Write SCT Data Table failed: .*)$/mi");
-		// "Unexpected SCT status 0x0000 (action_code=0, function_code=0)"
-		// in front of "Read SCT Temperature History failed"
-		const auto re7= app_regex_re("/^(Unexpected SCT status .*\\))$/mi");
-		std::string match;
-
-		if (app_regex_partial_match(re1, s, &match))
-			app_regex_replace(re1, "", s);  // add extra newlines
-
-		if (app_regex_partial_match(re2, s, &match))
-			app_regex_replace(re2, "", s);  // add extra newlines
-
-		if (app_regex_partial_match(re3, s, &match))
-			app_regex_replace(re3, "", s);  // add extra newlines
-
-		if (app_regex_partial_match(re4, s, &match))
-			app_regex_replace(re4, "", s);  // add extra newlines
-
-		if (app_regex_partial_match(re5, s, &match))
-			app_regex_replace(re5, "", s);  // add extra newlines
-
-		if (app_regex_partial_match(re6, s, &match))
-			app_regex_replace(re6, "", s);  // add extra newlines
-
-		if (app_regex_partial_match(re7, s, &match))
-			app_regex_replace(re7, "", s);  // add extra newlines
+		std::vector<std::string> checksum_error_structures;
+		s = SmartctlTextParserHelper::cleanup_ata_output(trimmed_output, checksum_error_structures);
+		for (const auto& structure_name : checksum_error_structures) {
+			add_property(app_get_checksum_error_property(structure_name));
+		}
 	}
 
 
@@ -235,8 +493,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse(std::string_v
 	{
 		StorageProperty p;
 		p.set_name("smartctl/output", "Smartctl Text Output");
-		p.reported_value = smartctl_output;
-		p.value = p.reported_value;  // string-type value
+		p.value = std::string(smartctl_output);  // string-type value. Not in reported_value, to avoid another copy.
 		p.show_in_ui = false;
 		add_property(p);
 	}
@@ -258,13 +515,14 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse(std::string_v
 		const std::string section_header = hz::string_trim_copy(s.substr(section_start_pos,
 				(tmp_pos == std::string::npos ? tmp_pos : (tmp_pos - section_start_pos)) ));
 
-		std::string section_body_str;
+		// The body is a view into s, it's copied only where it has to be stored.
+		std::string_view section_body;
 		if (tmp_pos != std::string::npos) {
 			section_end_pos = s.find("=== START", tmp_pos);  // start of the next section
-			section_body_str = hz::string_trim_copy(s.substr(tmp_pos,
+			section_body = hz::string_trim_view(std::string_view(s).substr(tmp_pos,
 					(section_end_pos == std::string::npos ? section_end_pos : section_end_pos - tmp_pos)));
 		}
-		status = parse_section(section_header, section_body_str).has_value() || status;
+		status = parse_section(section_header, section_body).has_value() || status;
 		section_start_pos = (tmp_pos == std::string::npos ? std::string::npos : section_end_pos);
 	}
 
@@ -279,7 +537,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse(std::string_v
 
 
 // Parse the section part (with "=== .... ===" header) - info or data sections.
-hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section(const std::string& header, const std::string& body)
+hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section(const std::string& header, std::string_view body)
 {
 	if (app_regex_partial_match("/START OF INFORMATION SECTION/mi", header)) {
 		return parse_section_info(body);
@@ -321,9 +579,10 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section(const
 // ------------------------------------------------ INFO SECTION
 
 
-hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_info(const std::string& body)
+hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_info(std::string_view body)
 {
-	this->set_data_section_info(body);
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_info", "parser");
+	this->set_data_section_info(std::string(body));
 
 	const StoragePropertySection section = StoragePropertySection::Info;
 
@@ -337,7 +596,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_info(
 	bool expecting_warning_lines = false;
 
 // 	while (re.FindAndConsume(&input, &name, &value)) {
-	for (auto line : lines) {
+	for (auto& line : lines) {
 		hz::string_trim(line);
 
 		if (expecting_warning_lines) {
@@ -441,167 +700,66 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_info_
 	}
 
 
-	if (app_regex_partial_match("/^Model Family$/mi", p.reported_name)) {
-		p.set_name("model_family", "Model Family", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^(?:Device Model|Device|Product)$/mi", p.reported_name)) {  // "Device" and "Product" are from scsi/usb
-		p.set_name("model_name", "Device Model", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Vendor$/mi", p.reported_name)) {  // From scsi/usb
-		p.set_name("vendor", "Vendor", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Revision$/mi", p.reported_name)) {  // From scsi/usb
-		p.set_name("revision", "Revision", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Device type$/mi", p.reported_name)) {  // From scsi/usb
-		p.set_name("device_type/name", "Device Type", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Compliance$/mi", p.reported_name)) {  // From scsi/usb
-		p.set_name("scsi_version", "Compliance", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Serial Number$/mi", p.reported_name)) {
-		p.set_name("serial_number", "Serial Number", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^LU WWN Device Id$/mi", p.reported_name)) {
-		p.set_name("wwn/_merged", "World Wide Name", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Add. Product Id$/mi", p.reported_name)) {
-		p.set_name("ata_additional_product_id", "Additional Product ID", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Firmware Version$/mi", p.reported_name)) {
-		p.set_name("firmware_version", "Firmware Version", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^User Capacity$/mi", p.reported_name)) {
-		p.set_name("user_capacity/bytes", "Capacity", p.reported_name);
-		int64_t v = 0;
-		p.readable_value = SmartctlTextParserHelper::parse_byte_size(p.reported_value, v, true);
-		if (p.readable_value.empty()) {
-			p.readable_value = "[unknown]";
-		} else {
-			p.value = v;  // integer-type value
+	// One lookup instead of trying each name in turn. The regexes are only for the free-form values.
+	if (const auto* handler = text_info_find_property_handler(hz::string_to_lower_copy(p.reported_name))) {
+		if (handler->kind != TextInfoValueKind::SmartSupport) {
+			p.set_name(handler->generic_name, handler->displayable_name, p.reported_name);
 		}
 
-	} else if (app_regex_partial_match("/^Sector Sizes$/mi", p.reported_name)) {
-		p.set_name("physical_block_size/_and/logical_block_size", "Sector Sizes", p.reported_name);
-		// This contains 2 values (phys/logical, if they're different)
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Sector Size$/mi", p.reported_name)) {
-		p.set_name("physical_block_size/_and/logical_block_size", "Sector Size", p.reported_name);
-		// This contains a single value (if it's not 512)
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Logical block size$/mi", p.reported_name)) {  // from scsi/usb
-		p.set_name("logical_block_size", "Logical Block Size", p.reported_name);
-		// "512 bytes"
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Rotation Rate$/mi", p.reported_name)) {
-		p.set_name("rotation_rate", "Rotation Rate", p.reported_name);
-		p.value = hz::string_to_number_nolocale<int64_t>(p.reported_value, false);
-
-	} else if (app_regex_partial_match("/^Form Factor$/mi", p.reported_name)) {
-		p.set_name("form_factor/name", "Form Factor", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Device is$/mi", p.reported_name)) {
-		p.set_name("in_smartctl_database", "In Smartctl Database", p.reported_name);
-		p.value = (!app_regex_partial_match("/Not in /mi", p.reported_value));  // bool-type value
-
-	} else if (app_regex_partial_match("/^ATA Version is$/mi", p.reported_name)) {
-		p.set_name("ata_version/string", "ATA Version", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^ATA Standard is$/mi", p.reported_name)) {  // old, not present in smartctl 7.2
-		p.set_name("ata_version/string", "ATA Standard", p.reported_name);
-		p.value = p.reported_value;  // string-type value
+		switch (handler->kind) {
+			case TextInfoValueKind::String:
+				p.value = p.reported_value;  // string-type value
+				break;
+
+			case TextInfoValueKind::ByteSize:
+			{
+				int64_t v = 0;
+				p.readable_value = SmartctlTextParserHelper::parse_byte_size(p.reported_value, v, true);
+				if (p.readable_value.empty()) {
+					p.readable_value = "[unknown]";
+				} else {
+					p.value = v;  // integer-type value
+				}
+				break;
+			}
 
-	} else if (app_regex_partial_match("/^SATA Version is$/mi", p.reported_name)) {
-		p.set_name("sata_version/string", "SATA Version", p.reported_name);
-		p.value = p.reported_value;  // string-type value
+			case TextInfoValueKind::Integer:
+				p.value = hz::string_to_number_nolocale<int64_t>(p.reported_value, false);
+				break;
 
-	} else if (app_regex_partial_match("/^Local Time is$/mi", p.reported_name)) {
-		p.set_name("local_time/asctime", "Scanned on", p.reported_name);
-		p.value = p.reported_value;  // string-type value
+			case TextInfoValueKind::InDatabase:
+				p.value = (!app_regex_partial_match("/Not in /mi", p.reported_value));  // bool-type value
+				break;
 
-	} else if (app_regex_partial_match("/^SMART support is$/mi", p.reported_name)) {
-		// There are two different properties with this name - supported and enabled.
-		// Don't put complete messages here - they change across smartctl versions.
+			case TextInfoValueKind::SmartSupport:
+				// There are two different properties with this name - supported and enabled.
+				// Don't put complete messages here - they change across smartctl versions.
 
-		if (app_regex_partial_match("/Available - device has/mi", p.reported_value)) {
-			p.set_name("smart_support/available", "SMART Supported", p.reported_name);
-			p.value = true;
+				if (app_regex_partial_match("/Available - device has/mi", p.reported_value)) {
+					p.set_name("smart_support/available", "SMART Supported", p.reported_name);
+					p.value = true;
 
-		} else if (app_regex_partial_match("/Enabled/mi", p.reported_value)) {
-			p.set_name("smart_support/enabled", "SMART Enabled", p.reported_name);
-			p.value = true;
+				} else if (app_regex_partial_match("/Enabled/mi", p.reported_value)) {
+					p.set_name("smart_support/enabled", "SMART Enabled", p.reported_name);
+					p.value = true;
 
-		} else if (app_regex_partial_match("/Disabled/mi", p.reported_value)) {
-			p.set_name("smart_support/enabled", "SMART Enabled", p.reported_name);
-			p.value = false;
+				} else if (app_regex_partial_match("/Disabled/mi", p.reported_value)) {
+					p.set_name("smart_support/enabled", "SMART Enabled", p.reported_name);
+					p.value = false;
 
-		} else if (app_regex_partial_match("/Unavailable/mi", p.reported_value)) {
-			p.set_name("smart_support/available", "SMART Supported", p.reported_name);
-			p.value = false;
+				} else if (app_regex_partial_match("/Unavailable/mi", p.reported_value)) {
+					p.set_name("smart_support/available", "SMART Supported", p.reported_name);
+					p.value = false;
 
-		// this should be the last - when ambiguous state is detected, usually smartctl
-		// retries with other methods and prints one of the above.
-		} else if (app_regex_partial_match("/Ambiguous/mi", p.reported_value)) {
-			p.set_name("smart_support/available", "SMART Supported", p.reported_name);
-			p.value = true;  // let's be optimistic - just hope that it doesn't hurt.
+				// this should be the last - when ambiguous state is detected, usually smartctl
+				// retries with other methods and prints one of the above.
+				} else if (app_regex_partial_match("/Ambiguous/mi", p.reported_value)) {
+					p.set_name("smart_support/available", "SMART Supported", p.reported_name);
+					p.value = true;  // let's be optimistic - just hope that it doesn't hurt.
+				}
+				break;
 		}
 
-	// "-g all" stuff
-	} else if (app_regex_partial_match("/^AAM feature is$/mi", p.reported_name)) {
-		p.set_name("ata_aam/enabled", "AAM Feature", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^AAM level is$/mi", p.reported_name)) {
-		p.set_name("ata_aam/level", "AAM Level", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^APM feature is$/mi", p.reported_name)) {
-		p.set_name("ata_apm/enabled", "APM Feature", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^APM level is$/mi", p.reported_name)) {
-		p.set_name("ata_apm/level", "APM Level", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Rd look-ahead is$/mi", p.reported_name)) {
-		p.set_name("read_lookahead/enabled", "Read Look-Ahead", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Write cache is$/mi", p.reported_name)) {
-		p.set_name("write_cache/enabled", "Write Cache", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Wt Cache Reorder$/mi", p.reported_name)) {
-		p.set_name("_text_only/write_cache_reorder", "Write Cache Reorder", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^DSN feature is$/mi", p.reported_name)) {
-		p.set_name("ata_dsn/enabled", "DSN Feature", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^Power mode (?:was|is)$/mi", p.reported_name)) {
-		p.set_name("_text_only/power_mode", "Power Mode", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
-	} else if (app_regex_partial_match("/^ATA Security is$/mi", p.reported_name)) {
-		p.set_name("ata_security/string", "ATA Security", p.reported_name);
-		p.value = p.reported_value;  // string-type value
-
 	// These are some debug warnings from smartctl on usb flash drives
 	} else if (app_regex_partial_match("/^scsiMode/mi", p.reported_name)) {
 		p.show_in_ui = false;
@@ -623,18 +781,18 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_info_
 
 
 // Parse the Data section (without "===" header)
-hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data(const std::string& body)
+hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data(std::string_view body)
 {
-	this->set_data_section_data(body);
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data", "parser");
+	this->set_data_section_data(std::string(body));
 
 	// perform any2unix
 // 	std::string s = hz::string_any_to_unix_copy(body);
 
-	std::vector<std::string> split_subsections;
 	// subsections are separated by double newlines, except:
 	// - "error log" subsection, which contains double-newline-separated blocks.
 	// - "scttemp" subsection, which has 3 blocks.
-	hz::string_split(body, "\n\n", split_subsections, true);
+	const auto split_subsections = hz::string_split_view(body, "\n\n", true);  // views into body
 
 	bool status = false;  // at least one subsection was parsed
 
@@ -646,8 +804,8 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data(
 	// "SCT Temperature History Version" or
 	// "Index    " or
 	// "Read SCT Temperature History failed".
-	for (auto sub : split_subsections) {
-		hz::string_trim(sub, "\t\n\r");  // don't trim space
+	for (const std::string_view sub_view : split_subsections) {
+		std::string sub(hz::string_trim_view(sub_view, "\t\n\r"));  // don't trim space
 		if (app_regex_partial_match("^  ", sub)
 				|| app_regex_partial_match("^Error [0-9]+", sub)
 				|| app_regex_partial_match("^SCT Temperature History Version", sub)
@@ -659,112 +817,92 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data(
 				debug_out_warn("app", DBG_FUNC_MSG << "Error Log's Error block, or SCT Temperature History, or SCT Index found without any data subsections present.\n");
 			}
 		} else {  // not an Error block, process as usual
-			subsections.push_back(sub);
+			subsections.push_back(std::move(sub));
 		}
 	}
 
 
-	// parse each subsection
-	for (auto sub : subsections) {
+	if (subsection_cache_) {
+		subsection_cache_->begin(get_requested_sections(), get_max_log_entries());
+	}
+
+	// Drop the empty ones, and take the unchanged ones from the previous parse
+	// (the same text gives the same properties).
+	for (auto& sub : subsections) {
 		hz::string_trim(sub);
-		if (sub.empty())
-			continue;
+	}
+	subsections.erase(std::remove_if(subsections.begin(), subsections.end(),
+			[](const std::string& sub) { return sub.empty(); }), subsections.end());
+
+	std::vector<std::size_t> sub_hashes;
+	std::vector<const SmartctlTextAtaSubsectionCache::Entry*> cached_entries;  // nullptr if not cached
+	std::vector<std::size_t> parse_indices;  // subsections to parse
+	for (std::size_t i = 0; i < subsections.size(); ++i) {
+		sub_hashes.push_back(subsection_cache_ ? std::hash<std::string>()(subsections[i]) : 0);
+		cached_entries.push_back(subsection_cache_ ? subsection_cache_->reuse(sub_hashes.back()) : nullptr);
+		if (!cached_entries.back()) {
+			parse_indices.push_back(i);
+		}
+	}
 
-		if (app_regex_partial_match("/^SMART overall-health self-assessment/mi", sub)) {
-			status = parse_section_data_subsection_health(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^General SMART Values/mi", sub)) {
-			status = parse_section_data_subsection_capabilities(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^SMART Attributes Data Structure/mi", sub)) {
-			status = parse_section_data_subsection_attributes(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^General Purpose Log Directory Version/mi", sub)  // -l directory
-				|| app_regex_partial_match("/^General Purpose Log Directory not supported/mi", sub)
-				|| app_regex_partial_match("/^General Purpose Logging \\(GPL\\) feature set supported/mi", sub)
-				|| app_regex_partial_match("/^Read GP Log Directory failed/mi", sub)
-				|| app_regex_partial_match("/^Log Directories not read due to '-F nologdir' option/mi", sub)
-				|| app_regex_partial_match("/^Read SMART Log Directory failed/mi", sub)
-				|| app_regex_partial_match("/^SMART Log Directory Version/mi", sub) ) {  // old smartctl
-			status = parse_section_data_subsection_directory_log(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^SMART Error Log Version/mi", sub)  // -l error
-				|| app_regex_partial_match("/^SMART Extended Comprehensive Error Log Version/mi", sub)  // -l xerror
-				|| app_regex_partial_match("/^Warning: device does not support Error Logging/mi", sub)  // -l error
-				|| app_regex_partial_match("/^SMART Error Log not supported/mi", sub)  // -l error
-				|| app_regex_partial_match("/^Read SMART Error Log failed/mi", sub) ) {  // -l error
-			status = parse_section_data_subsection_error_log(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^SMART Extended Comprehensive Error Log \\(GP Log 0x03\\) not supported/mi", sub)  // -l xerror
-				|| app_regex_partial_match("/^SMART Extended Comprehensive Error Log size (.*) not supported/mi", sub)
-				|| app_regex_partial_match("/^Read SMART Extended Comprehensive Error Log failed/mi", sub) ) {  // -l xerror
-			// These are printed with "-l xerror,error" if falling back to "error". They're in their own sections, ignore them.
-			// We don't support showing these messages.
-			status = false;
-
-		} else if (app_regex_partial_match("/^SMART Self-test log/mi", sub)  // -l selftest
-				|| app_regex_partial_match("/^SMART Extended Self-test Log Version/mi", sub)  // -l xselftest
-				|| app_regex_partial_match("/^Warning: device does not support Self Test Logging/mi", sub)  // -l selftest
-				|| app_regex_partial_match("/^Read SMART Self-test Log failed/mi", sub)  // -l selftest
-				|| app_regex_partial_match("/^SMART Self-test Log not supported/mi", sub)) {  // -l selftest
-			status = parse_section_data_subsection_selftest_log(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^SMART Extended Self-test Log \\(GP Log 0x07\\) not supported/mi", sub)  // -l xselftest
-				|| app_regex_partial_match("/^SMART Extended Self-test Log size [0-9-]+ not supported/mi", sub)  // -l xselftest
-				|| app_regex_partial_match("/^Read SMART Extended Self-test Log failed/mi", sub) ) {  // -l xselftest
-			// These are printed with "-l xselftest,selftest" if falling back to "selftest". They're in their own sections, ignore them.
-			// We don't support showing these messages.
-			status = false;
-
-		} else if (app_regex_partial_match("/^SMART Selective self-test log data structure/mi", sub)
-				|| app_regex_partial_match("/^Device does not support Selective Self Tests\\/Logging/mi", sub)
-				|| app_regex_partial_match("/^Selective Self-tests\\/Logging not supported/mi", sub)
-				|| app_regex_partial_match("/^Read SMART Selective Self-test Log failed/mi", sub) ) {
-			status = parse_section_data_subsection_selective_selftest_log(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^SCT Status Version/mi", sub)
-				// "SCT Commands not supported"
-				// "SCT Commands not supported if ATA Security is LOCKED"
-				// "Error unknown SCT Temperature History Format Version (3), should be 2."
-				// "Another SCT command is executing, abort Read Data Table"
-				|| app_regex_partial_match("/^SCT Commands not supported/mi", sub)
-				|| app_regex_partial_match("/^SCT Data Table command not supported/mi", sub)
-				|| app_regex_partial_match("/^Error unknown SCT Temperature History Format Version/mi", sub)
-				|| app_regex_partial_match("/^Another SCT command is executing, abort Read Data Table/mi", sub)
-				|| app_regex_partial_match("/^Warning: device does not support SCT Commands/mi", sub) ) {  // old smartctl
-			status = parse_section_data_subsection_scttemp_log(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^SCT Error Recovery Control/mi", sub)
-				// Can be the same "SCT Commands not supported" as scttemp.
-				// "Another SCT command is executing, abort Error Recovery Control"
-				|| app_regex_partial_match("/^SCT Error Recovery Control command not supported/mi", sub)
-				|| app_regex_partial_match("/^SCT \\(Get\\) Error Recovery Control command failed/mi", sub)
-				|| app_regex_partial_match("/^Another SCT command is executing, abort Error Recovery Control/mi", sub)
-				|| app_regex_partial_match("/^Warning: device does not support SCT \\(Get\\) Error Recovery Control/mi", sub) ) {  // old smartctl
-			status = parse_section_data_subsection_scterc_log(sub).has_value() || status;
-
-		} else if (app_regex_partial_match("/^Device Statistics \\([^)]+\\)$/mi", sub)  // -l devstat
-				|| app_regex_partial_match("/^Device Statistics \\([^)]+\\) not supported/mi", sub)
-				|| app_regex_partial_match("/^Read Device Statistics page (?:.+) failed/mi", sub) ) {
-			status = parse_section_data_subsection_devstat(sub).has_value() || status;
-
-		// "Device Statistics (GP Log 0x04) supported pages"
-		} else if (app_regex_partial_match("/^Device Statistics \\([^)]+\\) supported pages/mi", sub) ) {  // not sure where it came from
-			// We don't support this section.
-			status = false;
-
-		} else if (app_regex_partial_match("/^SATA Phy Event Counters/mi", sub)  // -l sataphy
-				|| app_regex_partial_match("/^SATA Phy Event Counters \\(GP Log 0x11\\) not supported/mi", sub)
-				|| app_regex_partial_match("/^SATA Phy Event Counters with [0-9-]+ sectors not supported/mi", sub)
-				|| app_regex_partial_match("/^Read SATA Phy Event Counters failed/mi", sub) ) {
-			status = parse_section_data_subsection_sataphy(sub).has_value() || status;
+	// The subsections are independent, so the huge ones (large error logs, device statistics and
+	// directory logs) are parsed concurrently, and the properties are added in the output order.
+	std::vector<SmartctlSectionParseResult> parallel_results;
+	if (parse_indices.size() > 1 && get_parallel_parse_enabled(body.size())) {
+		std::vector<section_parse_func_t> section_funcs;
+		for (const std::size_t i : parse_indices) {
+			section_funcs.emplace_back([&sub = std::as_const(subsections[i])](SmartctlParser& parser) {
+				return static_cast<SmartctlTextAtaParser&>(parser).parse_section_data_subsection(sub);
+			});
+		}
+		parallel_results = parse_sections_concurrently(section_funcs);
+	}
+
+	std::size_t parse_pos = 0;  // in parse_indices
+	const auto& journal = get_error_log_journal();
+	for (std::size_t i = 0; i < subsections.size(); ++i) {
+		if (const auto* entry = cached_entries[i]) {
+			for (const auto& p : entry->properties) {
+				// Keep the error log entries in the journal, they are processed already there
+				if (journal && p.section == StoragePropertySection::AtaErrorLog && p.is_value_type<AtaStorageErrorBlock>()) {
+					const uint32_t error_num = p.get_value<AtaStorageErrorBlock>().error_num;
+					const std::uint64_t fingerprint = std::hash<std::string>()(p.reported_value);
+					if (const auto* reused = journal->reuse(StoragePropertySection::AtaErrorLog, error_num, fingerprint)) {
+						add_property(*reused);
+						continue;
+					}
+					journal->store(StoragePropertySection::AtaErrorLog, error_num, fingerprint, p);
+				}
+				add_property(p);
+			}
+			status = entry->parsed || status;
+			continue;
+		}
 
+		bool sub_status = false;
+		SmartctlTextAtaSubsectionCache::Entry entry;
+		if (!parallel_results.empty()) {  // already added
+			sub_status = parallel_results[parse_pos].parsed;
+			entry.properties = std::move(parallel_results[parse_pos].properties);
 		} else {
-			debug_out_warn("app", DBG_FUNC_MSG << "Unknown Data subsection encountered.\n");
-			debug_out_dump("app", "---------------- Begin unknown section dump ----------------\n");
-			debug_out_dump("app", sub << "\n");
-			debug_out_dump("app", "----------------- End unknown section dump -----------------\n");
+			const std::size_t num_properties_before = get_property_repository().get_properties().size();
+			sub_status = parse_section_data_subsection(subsections[i]);
+			if (subsection_cache_) {
+				const auto& properties = get_property_repository().get_properties();
+				entry.properties.assign(properties.begin() + static_cast<std::ptrdiff_t>(num_properties_before), properties.end());
+			}
 		}
+		++parse_pos;
+		status = sub_status || status;
+
+		if (subsection_cache_) {
+			entry.parsed = sub_status;
+			subsection_cache_->store(sub_hashes[i], std::move(entry));
+		}
+	}
+
+	if (subsection_cache_) {
+		subsection_cache_->finish();
 	}
 
 	return hz::Unexpected(SmartctlParserError::NoSubsectionsParsed, "No subsections could be parsed.");
@@ -772,11 +910,115 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data(
 
 
 
+// Parse one subsection of the Data section, selecting the parser by its first line
+bool SmartctlTextAtaParser::parse_section_data_subsection(const std::string& sub)
+{
+	if (app_regex_partial_match("/^SMART overall-health self-assessment/mi", sub)) {
+		return parse_section_data_subsection_health(sub).has_value();
+
+	} else if (app_regex_partial_match("/^General SMART Values/mi", sub)) {
+		return parse_section_data_subsection_capabilities(sub).has_value();
+
+	} else if (app_regex_partial_match("/^SMART Attributes Data Structure/mi", sub)) {
+		return parse_section_data_subsection_attributes(sub).has_value();
+
+	} else if (app_regex_partial_match("/^General Purpose Log Directory Version/mi", sub)  // -l directory
+			|| app_regex_partial_match("/^General Purpose Log Directory not supported/mi", sub)
+			|| app_regex_partial_match("/^General Purpose Logging \\(GPL\\) feature set supported/mi", sub)
+			|| app_regex_partial_match("/^Read GP Log Directory failed/mi", sub)
+			|| app_regex_partial_match("/^Log Directories not read due to '-F nologdir' option/mi", sub)
+			|| app_regex_partial_match("/^Read SMART Log Directory failed/mi", sub)
+			|| app_regex_partial_match("/^SMART Log Directory Version/mi", sub) ) {  // old smartctl
+		return parse_section_data_subsection_directory_log(sub).has_value();
+
+	} else if (app_regex_partial_match("/^SMART Error Log Version/mi", sub)  // -l error
+			|| app_regex_partial_match("/^SMART Extended Comprehensive Error Log Version/mi", sub)  // -l xerror
+			|| app_regex_partial_match("/^Warning: device does not support Error Logging/mi", sub)  // -l error
+			|| app_regex_partial_match("/^SMART Error Log not supported/mi", sub)  // -l error
+			|| app_regex_partial_match("/^Read SMART Error Log failed/mi", sub) ) {  // -l error
+		return parse_section_data_subsection_error_log(sub).has_value();
+
+	} else if (app_regex_partial_match("/^SMART Extended Comprehensive Error Log \\(GP Log 0x03\\) not supported/mi", sub)  // -l xerror
+			|| app_regex_partial_match("/^SMART Extended Comprehensive Error Log size (.*) not supported/mi", sub)
+			|| app_regex_partial_match("/^Read SMART Extended Comprehensive Error Log failed/mi", sub) ) {  // -l xerror
+		// These are printed with "-l xerror,error" if falling back to "error". They're in their own sections, ignore them.
+		// We don't support showing these messages.
+		return false;
+
+	} else if (app_regex_partial_match("/^SMART Self-test log/mi", sub)  // -l selftest
+			|| app_regex_partial_match("/^SMART Extended Self-test Log Version/mi", sub)  // -l xselftest
+			|| app_regex_partial_match("/^Warning: device does not support Self Test Logging/mi", sub)  // -l selftest
+			|| app_regex_partial_match("/^Read SMART Self-test Log failed/mi", sub)  // -l selftest
+			|| app_regex_partial_match("/^SMART Self-test Log not supported/mi", sub)) {  // -l selftest
+		return parse_section_data_subsection_selftest_log(sub).has_value();
+
+	} else if (app_regex_partial_match("/^SMART Extended Self-test Log \\(GP Log 0x07\\) not supported/mi", sub)  // -l xselftest
+			|| app_regex_partial_match("/^SMART Extended Self-test Log size [0-9-]+ not supported/mi", sub)  // -l xselftest
+			|| app_regex_partial_match("/^Read SMART Extended Self-test Log failed/mi", sub) ) {  // -l xselftest
+		// These are printed with "-l xselftest,selftest" if falling back to "selftest". They're in their own sections, ignore them.
+		// We don't support showing these messages.
+		return false;
+
+	} else if (app_regex_partial_match("/^SMART Selective self-test log data structure/mi", sub)
+			|| app_regex_partial_match("/^Device does not support Selective Self Tests\\/Logging/mi", sub)
+			|| app_regex_partial_match("/^Selective Self-tests\\/Logging not supported/mi", sub)
+			|| app_regex_partial_match("/^Read SMART Selective Self-test Log failed/mi", sub) ) {
+		return parse_section_data_subsection_selective_selftest_log(sub).has_value();
+
+	} else if (app_regex_partial_match("/^SCT Status Version/mi", sub)
+			// "SCT Commands not supported"
+			// "SCT Commands not supported if ATA Security is LOCKED"
+			// "Error unknown SCT Temperature History Format Version (3), should be 2."
+			// "Another SCT command is executing, abort Read Data Table"
+			|| app_regex_partial_match("/^SCT Commands not supported/mi", sub)
+			|| app_regex_partial_match("/^SCT Data Table command not supported/mi", sub)
+			|| app_regex_partial_match("/^Error unknown SCT Temperature History Format Version/mi", sub)
+			|| app_regex_partial_match("/^Another SCT command is executing, abort Read Data Table/mi", sub)
+			|| app_regex_partial_match("/^Warning: device does not support SCT Commands/mi", sub) ) {  // old smartctl
+		return parse_section_data_subsection_scttemp_log(sub).has_value();
+
+	} else if (app_regex_partial_match("/^SCT Error Recovery Control/mi", sub)
+			// Can be the same "SCT Commands not supported" as scttemp.
+			// "Another SCT command is executing, abort Error Recovery Control"
+			|| app_regex_partial_match("/^SCT Error Recovery Control command not supported/mi", sub)
+			|| app_regex_partial_match("/^SCT \\(Get\\) Error Recovery Control command failed/mi", sub)
+			|| app_regex_partial_match("/^Another SCT command is executing, abort Error Recovery Control/mi", sub)
+			|| app_regex_partial_match("/^Warning: device does not support SCT \\(Get\\) Error Recovery Control/mi", sub) ) {  // old smartctl
+		return parse_section_data_subsection_scterc_log(sub).has_value();
+
+	} else if (app_regex_partial_match("/^Device Statistics \\([^)]+\\)$/mi", sub)  // -l devstat
+			|| app_regex_partial_match("/^Device Statistics \\([^)]+\\) not supported/mi", sub)
+			|| app_regex_partial_match("/^Read Device Statistics page (?:.+) failed/mi", sub) ) {
+		return parse_section_data_subsection_devstat(sub).has_value();
+
+	// "Device Statistics (GP Log 0x04) supported pages"
+	} else if (app_regex_partial_match("/^Device Statistics \\([^)]+\\) supported pages/mi", sub) ) {  // not sure where it came from
+		// We don't support this section.
+		return false;
+
+	} else if (app_regex_partial_match("/^SATA Phy Event Counters/mi", sub)  // -l sataphy
+			|| app_regex_partial_match("/^SATA Phy Event Counters \\(GP Log 0x11\\) not supported/mi", sub)
+			|| app_regex_partial_match("/^SATA Phy Event Counters with [0-9-]+ sectors not supported/mi", sub)
+			|| app_regex_partial_match("/^Read SATA Phy Event Counters failed/mi", sub) ) {
+		return parse_section_data_subsection_sataphy(sub).has_value();
+
+	} else {
+		debug_out_warn("app", DBG_FUNC_MSG << "Unknown Data subsection encountered.\n");
+		debug_out_dump("app", "---------------- Begin unknown section dump ----------------\n");
+		debug_out_dump("app", sub << "\n");
+		debug_out_dump("app", "----------------- End unknown section dump -----------------\n");
+	}
+	return false;
+}
+
+
+
 
 // -------------------- Health
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_health(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_health", "parser");
 	// Health section data (--info and --get=all):
 /*
 Model Family:     Hitachi/HGST Travelstar 5K750
@@ -820,6 +1062,7 @@ Device is:        In smartctl database [for details use: -P show]
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_capabilities(const std::string& sub_initial)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_capabilities", "parser");
 	// Capabilities section data:
 /*
 General SMART Values:
@@ -869,11 +1112,11 @@ SCT capabilities: 	       (0x003d)	SCT Status supported.
 
 
 	// split to lines and merge them into blocks
-	std::vector<std::string> lines, blocks;
-	hz::string_split(sub, '\n', lines, true);
+	std::vector<std::string> blocks;
 	bool partial = false;
 
-	for(auto line : lines) {
+	for (const std::string_view line_view : hz::string_split_view(sub, '\n', true)) {
+		std::string line(line_view);
 		if (line.empty() || app_regex_partial_match("/General SMART Values/mi", line))  // skip the non-informative lines
 			continue;
 		line += "\n";  // avoid joining lines without separator. this will get stripped anyway.
@@ -1000,78 +1243,53 @@ SCT capabilities: 	       (0x003d)	SCT Status supported.
 // Check the capabilities for internal properties we can use.
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_internal_capabilities(StorageProperty& cap_prop)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_internal_capabilities", "parser");
 	// Some special capabilities we're interested in.
 
 	// Note: Smartctl gradually changed spelling Off-line to Offline in some messages.
 	// Also, some capitalization was changed (so the regexps are caseless).
 
-	// "Offline data collection not supported." (at all) - we don't need to check this,
-	// because we look for immediate/automatic anyway.
-
-	// "was never started", "was completed without error", "is in progress",
-	// "was suspended by an interrupting command from host", etc.
-	const auto re_offline_status = app_regex_re("/^(Off-?line data collection) activity (?:is|was) (.*)$/mi");
-	// "Enabled", "Disabled". May not show up on older smartctl (< 5.1.10), so no way of knowing there.
-	const auto re_offline_enabled = app_regex_re("/^(Auto Off-?line Data Collection):[ \\t]*(.*)$/mi");
-	const auto re_offline_immediate = app_regex_re("/^(SMART execute Off-?line immediate)$/mi");
-	// "No Auto Offline data collection support.", "Auto Offline data collection on/off support.".
-	const auto re_offline_auto = app_regex_re("/^(No |)(Auto Off-?line data collection (?:on\\/off )?support)$/mi");
-	// Same as above (smartctl <= 5.1-18). "No Automatic timer ON/OFF support."
-	const auto re_offline_auto2 = app_regex_re("/^(No |)(Automatic timer ON\\/OFF support)$/mi");
-	const auto re_offline_suspend = app_regex_re("/^(?:Suspend|Abort) (Off-?line collection upon new command)$/mi");
-	const auto re_offline_surface = app_regex_re("/^(No |)(Off-?line surface scan supported)$/mi");
-
-	const auto re_selftest_support = app_regex_re("/^(No |)(Self-test supported)$/mi");
-	const auto re_conv_selftest_support = app_regex_re("/^(No |)(Conveyance Self-test supported)$/mi");
-	const auto re_selective_selftest_support = app_regex_re("/^(No |)(Selective Self-test supported)$/mi");
-
-	const auto re_sct_status = app_regex_re("/^(SCT Status supported)$/mi");
-	const auto re_sct_control = app_regex_re("/^(SCT Feature Control supported)$/mi");  // means can change logging interval
-	const auto re_sct_data = app_regex_re("/^(SCT Data Table supported)$/mi");
-
-	// these are matched on name
-	const auto re_offline_status_group = app_regex_re("/^(Off-?line data collection status)/mi");
-	const auto re_offline_time = app_regex_re("/^(Total time to complete Off-?line data collection)/mi");
-	const auto re_offline_cap_group = app_regex_re("/^(Off-?line data collection capabilities)/mi");
-	const auto re_smart_cap_group = app_regex_re("/^(SMART capabilities)/mi");
-	const auto re_error_log_cap_group = app_regex_re("/^(Error logging capability)/mi");
-	const auto re_sct_cap_group = app_regex_re("/^(SCT capabilities)/mi");
-	const auto re_selftest_status = app_regex_re("/^Self-test execution status/mi");
-	const auto re_selftest_short_time = app_regex_re("/^(Short self-test routine recommended polling time)/mi");
-	const auto re_selftest_long_time = app_regex_re("/^(Extended self-test routine recommended polling time)/mi");
-	const auto re_conv_selftest_time = app_regex_re("/^(Conveyance self-test routine recommended polling time)/mi");
-
 	if (cap_prop.section != StoragePropertySection::Capabilities) {
 		debug_out_error("app", DBG_FUNC_MSG << "Non-capability property passed.\n");
 		return hz::Unexpected(SmartctlParserError::DataError, "Non-capability property passed.");
 	}
 
 
-	// Name the capability groups for easy matching when setting descriptions
-	if (cap_prop.is_value_type<AtaStorageTextCapability>()) {
-		if (app_regex_partial_match(re_offline_status_group, cap_prop.reported_name)) {
-			cap_prop.generic_name = "ata_smart_data/offline_data_collection/status/_group";
-
-		} else if (app_regex_partial_match(re_offline_cap_group, cap_prop.reported_name)) {
-			cap_prop.generic_name = "ata_smart_data/offline_data_collection/_group";
-
-		} else if (app_regex_partial_match(re_smart_cap_group, cap_prop.reported_name)) {
-			cap_prop.generic_name = "ata_smart_data/capabilities/_group";
-
-		} else if (app_regex_partial_match(re_error_log_cap_group, cap_prop.reported_name)) {
-			cap_prop.generic_name = "ata_smart_data/capabilities/error_logging_supported/_group";
-
-		} else if (app_regex_partial_match(re_sct_cap_group, cap_prop.reported_name)) {
-			cap_prop.generic_name = "ata_sct_capabilities/_group";
+	// The names are fixed, so they're looked up instead of matched.
+	const std::optional<TextCapabilityName> cap_name = text_capability_find_name(cap_prop.reported_name);
 
-		} else if (app_regex_partial_match(re_selftest_status, cap_prop.reported_name)) {
-			cap_prop.generic_name = "ata_smart_data/self_test/status/_group";
+	// Name the capability groups for easy matching when setting descriptions
+	if (cap_prop.is_value_type<AtaStorageTextCapability>() && cap_name.has_value()) {
+		switch (cap_name.value()) {
+			case TextCapabilityName::OfflineStatusGroup:
+				cap_prop.generic_name = "ata_smart_data/offline_data_collection/status/_group";
+				break;
+			case TextCapabilityName::OfflineCapGroup:
+				cap_prop.generic_name = "ata_smart_data/offline_data_collection/_group";
+				break;
+			case TextCapabilityName::SmartCapGroup:
+				cap_prop.generic_name = "ata_smart_data/capabilities/_group";
+				break;
+			case TextCapabilityName::ErrorLogCapGroup:
+				cap_prop.generic_name = "ata_smart_data/capabilities/error_logging_supported/_group";
+				break;
+			case TextCapabilityName::SctCapGroup:
+				cap_prop.generic_name = "ata_sct_capabilities/_group";
+				break;
+			case TextCapabilityName::SelftestStatus:
+				cap_prop.generic_name = "ata_smart_data/self_test/status/_group";
+				break;
+			case TextCapabilityName::OfflineTime:
+			case TextCapabilityName::SelftestShortTime:
+			case TextCapabilityName::SelftestLongTime:
+			case TextCapabilityName::ConvSelftestTime:
+				break;
 		}
 	}
 
 
 	// Last self-test status
-	if (app_regex_partial_match(re_selftest_status, cap_prop.reported_name)) {
+	if (cap_name == TextCapabilityName::SelftestStatus) {
 		// The last self-test status. break up into pieces.
 
 		StorageProperty p;
@@ -1156,16 +1374,16 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_
 	// Section is unmodified.
 	if (cap_prop.is_value_type<std::chrono::seconds>()) {
 
-		if (app_regex_partial_match(re_offline_time, cap_prop.reported_name)) {
+		if (cap_name == TextCapabilityName::OfflineTime) {
 			cap_prop.generic_name = "ata_smart_data/offline_data_collection/completion_seconds";
 
-		} else if (app_regex_partial_match(re_selftest_short_time, cap_prop.reported_name)) {
+		} else if (cap_name == TextCapabilityName::SelftestShortTime) {
 			cap_prop.generic_name = "ata_smart_data/self_test/polling_minutes/short";
 
-		} else if (app_regex_partial_match(re_selftest_long_time, cap_prop.reported_name)) {
+		} else if (cap_name == TextCapabilityName::SelftestLongTime) {
 			cap_prop.generic_name = "ata_smart_data/self_test/polling_minutes/extended";
 
-		} else if (app_regex_partial_match(re_conv_selftest_time, cap_prop.reported_name)) {
+		} else if (cap_name == TextCapabilityName::ConvSelftestTime) {
 			cap_prop.generic_name = "ata_smart_data/self_test/polling_minutes/conveyance";
 		}
 
@@ -1175,6 +1393,30 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_
 
 	// Extract subcapabilities from capability vectors and assign to "internal" section.
 	if (cap_prop.is_value_type<AtaStorageTextCapability>()) {
+		// "Offline data collection not supported." (at all) - we don't need to check this,
+		// because we look for immediate/automatic anyway.
+
+		// "was never started", "was completed without error", "is in progress",
+		// "was suspended by an interrupting command from host", etc.
+		const auto re_offline_status = app_regex_re("/^(Off-?line data collection) activity (?:is|was) (.*)$/mi");
+		// "Enabled", "Disabled". May not show up on older smartctl (< 5.1.10), so no way of knowing there.
+		const auto re_offline_enabled = app_regex_re("/^(Auto Off-?line Data Collection):[ \\t]*(.*)$/mi");
+		const auto re_offline_immediate = app_regex_re("/^(SMART execute Off-?line immediate)$/mi");
+		// "No Auto Offline data collection support.", "Auto Offline data collection on/off support.".
+		const auto re_offline_auto = app_regex_re("/^(No |)(Auto Off-?line data collection (?:on\\/off )?support)$/mi");
+		// Same as above (smartctl <= 5.1-18). "No Automatic timer ON/OFF support."
+		const auto re_offline_auto2 = app_regex_re("/^(No |)(Automatic timer ON\\/OFF support)$/mi");
+		const auto re_offline_suspend = app_regex_re("/^(?:Suspend|Abort) (Off-?line collection upon new command)$/mi");
+		const auto re_offline_surface = app_regex_re("/^(No |)(Off-?line surface scan supported)$/mi");
+
+		const auto re_selftest_support = app_regex_re("/^(No |)(Self-test supported)$/mi");
+		const auto re_conv_selftest_support = app_regex_re("/^(No |)(Conveyance Self-test supported)$/mi");
+		const auto re_selective_selftest_support = app_regex_re("/^(No |)(Selective Self-test supported)$/mi");
+
+		const auto re_sct_status = app_regex_re("/^(SCT Status supported)$/mi");
+		const auto re_sct_control = app_regex_re("/^(SCT Feature Control supported)$/mi");  // means can change logging interval
+		const auto re_sct_data = app_regex_re("/^(SCT Data Table supported)$/mi");
+
 
 		// check for lines in capability vector
 		for (const auto& sv : cap_prop.get_value<AtaStorageTextCapability>().strvalues) {
@@ -1260,13 +1502,10 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_attributes(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_attributes", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::AtaAttributes;
 
-	// split to lines
-	std::vector<std::string> lines;
-	hz::string_split(sub, '\n', lines, true);
-
 	// Format notes:
 	// * Before 5.1-14, no UPDATED column was present in "old" format.
 
@@ -1300,173 +1539,128 @@ ID# ATTRIBUTE_NAME          FLAGS    VALUE WORST THRESH FAIL RAW_VALUE
                             ||_____ O updated online
                             |______ P prefailure warning
 */
-	enum {
-		FormatStyleOld,
-		FormatStyleNoUpdated,  // old format without UPDATED column
-		FormatStyleBrief
-	};
-
 	bool attr_found = false;  // at least one attribute was found
-	int attr_format_style = FormatStyleOld;
-
-	const std::string space_re = "[ \\t]+";
-
-	const std::string old_flag_re = "(0x[a-fA-F0-9]+)";
-	const std::string brief_flag_re = "([A-Z+-]{2,})";
-	// We allow name with spaces only in the old format, not in brief.
-	// This has to do with the name end detection - it's either 0x (flag's start) in the old format,
-	// or a space in the brief format.
-	const std::string old_base_re = R"([ \t]*([0-9]+) ([^ \t\n]+(?:[^0-9\t\n]+)*))" + space_re + old_flag_re + space_re;  // ID / name / flag
-	const std::string brief_base_re = R"([ \t]*([0-9]+) ([^ \t\n]+))" + space_re + brief_flag_re + space_re;  // ID / name / flag
-	const std::string vals_re = "([0-9-]+)" + space_re + "([0-9-]+)" + space_re + "([0-9-]+)" + space_re;  // value / worst / threshold
-	const std::string type_re = "([^ \\t\\n]+)" + space_re;
-	const std::string updated_re = "([^ \\t\\n]+)" + space_re;
-	const std::string failed_re = "([^ \\t\\n]+)" + space_re;
-	const std::string raw_re = "(.+)[ \\t]*";
-
-	const auto re_old_up = app_regex_re("/" + old_base_re + vals_re + type_re + updated_re + failed_re + raw_re + "/mi");
-	const auto re_old_noup = app_regex_re("/" + old_base_re + vals_re + type_re + failed_re + raw_re + "/mi");
-	const auto re_brief = app_regex_re("/" + brief_base_re + vals_re + failed_re + raw_re + "/mi");
+	auto attr_format = SmartctlTextAtaAttributeFormat::Old;
 
 	const auto re_flag_descr = app_regex_re("/^[\\t ]+\\|/mi");
 
 
-	for (const auto& line : lines) {
-		// skip the non-informative lines
-		if (line.empty() || app_regex_partial_match("/SMART Attributes with Thresholds/mi", line))
-			continue;
+	for (const std::string_view line : hz::string_split_view(sub, '\n', true)) {
+		// Attribute lines start with the ID, don't run the regexps below on them.
+		const auto first_char = line.find_first_not_of(" \t");
+		const bool attribute_line = (first_char != std::string_view::npos && line[first_char] >= '0' && line[first_char] <= '9');
 
-		if (app_regex_partial_match("/ATTRIBUTE_NAME/mi", line)) {
-			// detect format type
-			if (!app_regex_partial_match("/WHEN_FAILED/mi", line)) {
-				attr_format_style = FormatStyleBrief;
-			} else if (!app_regex_partial_match("/UPDATED/mi", line)) {
-				attr_format_style = FormatStyleNoUpdated;
-			}
-			continue;  // we don't need this line
-		}
-
-		if (app_regex_partial_match(re_flag_descr, line)) {
-			continue;  // skip flag description lines
-		}
+		if (!attribute_line) {
+			const std::string line_str(line);
 
-		if (app_regex_partial_match("/Data Structure revision number/mi", line)) {
-			const auto re = app_regex_re("/^([^:\\n]+):[ \\t]*(.*)$/mi");
-			std::string name, value;
-			if (app_regex_partial_match(re, line, {&name, &value})) {
-				hz::string_trim(name);
-				hz::string_trim(value);
-				int64_t value_num = 0;
-				hz::string_is_numeric_nolocale(value, value_num, false);
+			// skip the non-informative lines
+			if (line.empty() || app_regex_partial_match("/SMART Attributes with Thresholds/mi", line_str))
+				continue;
 
-				StorageProperty p(pt);
-				p.set_name("ata_smart_attributes/revision", name, name);
-				p.reported_value = value;
-				p.value = value_num;  // integer-type value
-
-				add_property(p);
-				attr_found = true;
-			}
-
-
-		} else {  // A line in attribute table
-
-			std::string id, name, flag, value, worst, threshold, attr_type,
-					update_type, when_failed, raw_value;
-
-			bool matched = true;
-
-			if (attr_format_style == FormatStyleOld) {
-				if (!app_regex_full_match(re_old_up, line,
-						{&id, &name, &flag, &value, &worst, &threshold, &attr_type, &update_type, &when_failed, &raw_value})) {
-					matched = false;
-					debug_out_warn("app", DBG_FUNC_MSG << "Cannot parse attribute line.\n");
-				}
-
-			} else if (attr_format_style == FormatStyleNoUpdated) {
-				if (!app_regex_full_match(re_old_noup, line,
-						{&id, &name, &flag, &value, &worst, &threshold, &attr_type, &when_failed, &raw_value})) {
-					matched = false;
-					debug_out_warn("app", DBG_FUNC_MSG << "Cannot parse attribute line.\n");
+			if (app_regex_partial_match("/ATTRIBUTE_NAME/mi", line_str)) {
+				// detect format type
+				if (!app_regex_partial_match("/WHEN_FAILED/mi", line_str)) {
+					attr_format = SmartctlTextAtaAttributeFormat::Brief;
+				} else if (!app_regex_partial_match("/UPDATED/mi", line_str)) {
+					attr_format = SmartctlTextAtaAttributeFormat::NoUpdated;
 				}
+				continue;  // we don't need this line
+			}
 
-			} else if (attr_format_style == FormatStyleBrief) {
-				if (!app_regex_full_match(re_brief, line,
-						{&id, &name, &flag, &value, &worst, &threshold, &when_failed, &raw_value})) {
-					matched = false;
-					debug_out_warn("app", DBG_FUNC_MSG << "Cannot parse attribute line.\n");
-				}
+			if (app_regex_partial_match(re_flag_descr, line_str)) {
+				continue;  // skip flag description lines
 			}
 
-			if (!matched) {
-				debug_out_dump("app", "------------ Begin unparsable attribute line dump ------------\n");
-				debug_out_dump("app", line << "\n");
-				debug_out_dump("app", "------------- End unparsable attribute line dump -------------\n");
-				continue;  // continue to the next line
+			if (app_regex_partial_match("/Data Structure revision number/mi", line_str)) {
+				const auto re = app_regex_re("/^([^:\\n]+):[ \\t]*(.*)$/mi");
+				std::string name, value;
+				if (app_regex_partial_match(re, line_str, {&name, &value})) {
+					hz::string_trim(name);
+					hz::string_trim(value);
+					int64_t value_num = 0;
+					hz::string_is_numeric_nolocale(value, value_num, false);
+
+					StorageProperty p(pt);
+					p.set_name("ata_smart_attributes/revision", name, name);
+					p.reported_value = value;
+					p.value = value_num;  // integer-type value
+
+					add_property(p);
+					attr_found = true;
+				}
+				continue;
 			}
+		}
 
+		// A line in attribute table
+		SmartctlTextAtaAttributeFields fields;
+		if (!SmartctlTextParserHelper::tokenize_ata_attribute_line(line, attr_format, fields)) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot parse attribute line.\n");
+			debug_out_dump("app", "------------ Begin unparsable attribute line dump ------------\n");
+			debug_out_dump("app", line << "\n");
+			debug_out_dump("app", "------------- End unparsable attribute line dump -------------\n");
+			continue;  // continue to the next line
+		}
 
-			AtaStorageAttribute attr;
-			hz::string_is_numeric_nolocale(hz::string_trim_copy(id), attr.id, true, 10);
-			attr.flag = hz::string_trim_copy(flag);
-			uint8_t norm_value = 0, worst_value = 0, threshold_value = 0;
+		AtaStorageAttribute attr;
+		hz::string_is_numeric_nolocale(std::string(fields.id), attr.id, true, 10);
+		attr.flag = fields.flag;
+		uint8_t norm_value = 0, worst_value = 0, threshold_value = 0;
 
-			if (hz::string_is_numeric_nolocale(hz::string_trim_copy(value), norm_value, true, 10)) {
-				attr.value = norm_value;
-			}
-			if (hz::string_is_numeric_nolocale(hz::string_trim_copy(worst), worst_value, true, 10)) {
-				attr.worst = worst_value;
-			}
-			if (hz::string_is_numeric_nolocale(hz::string_trim_copy(threshold), threshold_value, true, 10)) {
-				attr.threshold = threshold_value;
-			}
+		if (hz::string_is_numeric_nolocale(std::string(fields.value), norm_value, true, 10)) {
+			attr.value = norm_value;
+		}
+		if (hz::string_is_numeric_nolocale(std::string(fields.worst), worst_value, true, 10)) {
+			attr.worst = worst_value;
+		}
+		if (hz::string_is_numeric_nolocale(std::string(fields.threshold), threshold_value, true, 10)) {
+			attr.threshold = threshold_value;
+		}
 
-			if (attr_format_style == FormatStyleBrief) {
-				attr.attr_type = app_regex_partial_match("/P/", attr.flag) ? AtaStorageAttribute::AttributeType::Prefail : AtaStorageAttribute::AttributeType::OldAge;
+		if (attr_format == SmartctlTextAtaAttributeFormat::Brief) {
+			attr.attr_type = (fields.flag.find('P') != std::string_view::npos) ? AtaStorageAttribute::AttributeType::Prefail : AtaStorageAttribute::AttributeType::OldAge;
+		} else {
+			if (fields.attr_type == "Pre-fail") {
+				attr.attr_type = AtaStorageAttribute::AttributeType::Prefail;
+			} else if (fields.attr_type == "Old_age") {
+				attr.attr_type = AtaStorageAttribute::AttributeType::OldAge;
 			} else {
-				if (attr_type == "Pre-fail") {
-					attr.attr_type = AtaStorageAttribute::AttributeType::Prefail;
-				} else if (attr_type == "Old_age") {
-					attr.attr_type = AtaStorageAttribute::AttributeType::OldAge;
-				} else {
-					attr.attr_type = AtaStorageAttribute::AttributeType::Unknown;
-				}
+				attr.attr_type = AtaStorageAttribute::AttributeType::Unknown;
 			}
+		}
 
-			if (attr_format_style == FormatStyleBrief) {
-				attr.update_type = app_regex_partial_match("/O/", attr.flag) ? AtaStorageAttribute::UpdateType::Always : AtaStorageAttribute::UpdateType::Offline;
+		if (attr_format == SmartctlTextAtaAttributeFormat::Brief) {
+			attr.update_type = (fields.flag.find('O') != std::string_view::npos) ? AtaStorageAttribute::UpdateType::Always : AtaStorageAttribute::UpdateType::Offline;
+		} else {
+			if (fields.update_type == "Always") {
+				attr.update_type = AtaStorageAttribute::UpdateType::Always;
+			} else if (fields.update_type == "Offline") {
+				attr.update_type = AtaStorageAttribute::UpdateType::Offline;
 			} else {
-				if (update_type == "Always") {
-					attr.update_type = AtaStorageAttribute::UpdateType::Always;
-				} else if (update_type == "Offline") {
-					attr.update_type = AtaStorageAttribute::UpdateType::Offline;
-				} else {
-					attr.update_type = AtaStorageAttribute::UpdateType::Unknown;
-				}
-			}
-
-			attr.when_failed = AtaStorageAttribute::FailTime::Unknown;
-			hz::string_trim(when_failed);
-			if (when_failed == "-") {
-				attr.when_failed = AtaStorageAttribute::FailTime::None;
-			} else if (when_failed == "In_the_past" || when_failed == "Past") {  // the second one if from brief format
-				attr.when_failed = AtaStorageAttribute::FailTime::Past;
-			} else if (when_failed == "FAILING_NOW" || when_failed == "NOW") {  // the second one if from brief format
-				attr.when_failed = AtaStorageAttribute::FailTime::Now;
+				attr.update_type = AtaStorageAttribute::UpdateType::Unknown;
 			}
+		}
 
-			attr.raw_value = hz::string_trim_copy(raw_value);
-			hz::string_is_numeric_nolocale(hz::string_trim_copy(raw_value), attr.raw_value_int, false);  // same as raw_value, but parsed as int.
+		attr.when_failed = AtaStorageAttribute::FailTime::Unknown;
+		if (fields.when_failed == "-") {
+			attr.when_failed = AtaStorageAttribute::FailTime::None;
+		} else if (fields.when_failed == "In_the_past" || fields.when_failed == "Past") {  // the second one if from brief format
+			attr.when_failed = AtaStorageAttribute::FailTime::Past;
+		} else if (fields.when_failed == "FAILING_NOW" || fields.when_failed == "NOW") {  // the second one if from brief format
+			attr.when_failed = AtaStorageAttribute::FailTime::Now;
+		}
 
-			StorageProperty p(pt);
-			p.set_name(hz::string_trim_copy(name), hz::string_trim_copy(name), hz::string_trim_copy(name));
-			p.reported_value = line;  // use the whole line here
-			p.value = attr;  // attribute-type value;
+		attr.raw_value = hz::string_trim_copy(fields.raw_value);
+		hz::string_is_numeric_nolocale(attr.raw_value, attr.raw_value_int, false);  // same as raw_value, but parsed as int.
 
-			add_property(p);
-			attr_found = true;
-		}
+		StorageProperty p(pt);
+		const std::string name(fields.name);
+		p.set_name(name, name, name);
+		p.reported_value = line;  // use the whole line here
+		p.value = attr;  // attribute-type value;
 
+		add_property(p);
+		attr_found = true;
 	}
 
 	if (!attr_found) {
@@ -1480,6 +1674,7 @@ ID# ATTRIBUTE_NAME          FLAGS    VALUE WORST THRESH FAIL RAW_VALUE
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_directory_log(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_directory_log", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::DirectoryLog;
 
@@ -1531,6 +1726,7 @@ Address    Access  R/W   Size  Description
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_error_log(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_error_log", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::AtaErrorLog;
 
@@ -1577,6 +1773,12 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 */
 	bool data_found = false;
 
+	// The extended log may have hundreds of entries. Find them in a single pass over the lines,
+	// and look for the rest of the data in the part before them.
+	const std::vector<TextAtaErrorLogEntry> entries = text_ata_find_error_log_entries(sub, get_max_log_entries());
+	const std::string log_header = entries.empty() ? sub
+			: sub.substr(0, static_cast<std::size_t>(entries.front().block.data() - sub.data()));
+
 	// Error log version
 	{
 		// "SMART Error Log Version: 1"
@@ -1584,7 +1786,7 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 		const auto re = app_regex_re("/^(SMART (Extended Comprehensive )?Error Log Version): ([0-9]+).*?$/mi");
 
 		std::string name, value;
-		if (app_regex_partial_match(re, sub, {&name, &value})) {
+		if (app_regex_partial_match(re, log_header, {&name, &value})) {
 			hz::string_trim(name);
 			hz::string_trim(value);
 
@@ -1607,7 +1809,7 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 	{
 		const auto re = app_regex_re("/^(Warning: device does not support Error Logging)|(SMART Error Log not supported)$/mi");
 
-		if (app_regex_partial_match(re, sub)) {
+		if (app_regex_partial_match(re, log_header)) {
 			StorageProperty p(pt);
 			p.set_name("_text_only/ata_smart_error_log/_not_present", "Error Log not supported");
 			p.displayable_name = "Warning";
@@ -1623,7 +1825,7 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 		const auto re2 = app_regex_re("/^No Errors Logged$/mi");
 
 		std::string value;
-		if (app_regex_partial_match(re1, sub, &value) || app_regex_partial_match(re2, sub)) {
+		if (app_regex_partial_match(re1, log_header, &value) || app_regex_partial_match(re2, log_header)) {
 			hz::string_trim(value);
 
 			StorageProperty p(pt);
@@ -1633,7 +1835,7 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 			p.reported_value = value;
 
 			int64_t value_num = 0;
-			if (!app_regex_partial_match(re2, sub)) {  // if no errors, when value should be zero. otherwise, this:
+			if (!app_regex_partial_match(re2, log_header)) {  // if no errors, when value should be zero. otherwise, this:
 				hz::string_is_numeric_nolocale(value, value_num, false);
 			}
 			p.value = value_num;  // integer
@@ -1645,12 +1847,6 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 
 	// Individual errors
 	{
-		// Split by blocks:
-		// "Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)"
-		// "Error 25 occurred at disk power-on lifetime: 14799 hours"
-		const auto re_block = app_regex_re(
-				R"(/^((Error[ \t]*([0-9]+))[ \t]*(?:\[[0-9]+\][ \t])?occurred at disk power-on lifetime:[ \t]*([0-9]+) hours(?:[^\n]*)?.*(?:\n(?:  |\n  ).*)*)/mi)");
-
 		// "  When the command that caused the error occurred, the device was active or idle."
 		// Note: For "in an unknown state" - remove first two words.
 		const auto re_state = app_regex_re(R"(/occurred, the device was[ \t]*(?: in)?(?: an?)?[ \t]+([^.\n]*)\.?/mi)");
@@ -1659,11 +1855,27 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 		// "  02 -- 51 00 00 00 00 00 00 00 00 00 00  Error: TK0NF"
 		const auto re_type = app_regex_re(R"(/[ \t]+Error:[ \t]*([ ,a-z0-9]+)(?:[ \t]+((?:[0-9]+|at )[ \t]*.*))?$/mi)");
 
-		for (auto it = std::sregex_iterator(sub.begin(), sub.end(), re_block), end = std::sregex_iterator(); it != end; ++it) {
-			const std::string block = hz::string_trim_copy(it->str(1));
-			const std::string name = hz::string_trim_copy(it->str(2));
-			const std::string value_num = hz::string_trim_copy(it->str(3));
-			const std::string value_time = hz::string_trim_copy(it->str(4));
+		// The entries ingested before are taken from the journal, described already
+		const auto& journal = get_error_log_journal();
+
+		for (const auto& entry : entries) {
+			const std::string block = hz::string_trim_copy(entry.block);
+			const std::string name = hz::string_trim_copy(entry.name);
+			const std::string value_num = hz::string_trim_copy(entry.error_num);
+			const std::string value_time = hz::string_trim_copy(entry.lifetime_hours);
+
+			AtaStorageErrorBlock eb;
+			hz::string_is_numeric_nolocale(value_num, eb.error_num, false);
+			hz::string_is_numeric_nolocale(value_time, eb.lifetime_hours, false);
+
+			const std::uint64_t fingerprint = std::hash<std::string>()(block);
+			if (journal) {
+				if (const auto* reused = journal->reuse(StoragePropertySection::AtaErrorLog, eb.error_num, fingerprint)) {
+					add_property(*reused);
+					data_found = true;
+					continue;
+				}
+			}
 
 			// debug_out_dump("app", "\nBLOCK -------------------------------\n" << block);
 
@@ -1676,10 +1888,6 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 			p.set_name(gen_name, gen_name, gen_name);  // "Error 6"
 			p.reported_value = block;
 
-			AtaStorageErrorBlock eb;
-			hz::string_is_numeric_nolocale(value_num, eb.error_num, false);
-			hz::string_is_numeric_nolocale(value_time, eb.lifetime_hours, false);
-
 			std::vector<std::string> etypes;
 			hz::string_split(etypes_str, ",", etypes, true);
 			for (auto&& v : etypes) {
@@ -1692,6 +1900,9 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 
 			p.value = eb;  // Error block value
 
+			if (journal) {
+				journal->store(StoragePropertySection::AtaErrorLog, eb.error_num, fingerprint, p);
+			}
 			add_property(p);
 			data_found = true;
 		}
@@ -1727,6 +1938,7 @@ Error 1 [0] occurred at disk power-on lifetime: 1 hours (0 days + 1 hours)
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_selftest_log(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_selftest_log", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::SelftestLog;
 
@@ -1813,16 +2025,28 @@ Num  Test_Description    Status                  Remaining  LifeTime(hours)  LBA
 		// split by columns.
 		// num, type, status, remaining, hours, lba (optional).
 		const auto re = app_regex_re(
-				R"(/^(#[ \t]*([0-9]+)[ \t]+(\S+(?: \S+)*)  [ \t]*(\S.*) [ \t]*([0-9]+%)  [ \t]*([0-9]+)[ \t]*((?:  [ \t]*\S.*)?))$/mi)");
-
-		for (auto it = std::sregex_iterator(sub.begin(), sub.end(), re), end = std::sregex_iterator(); it != end; ++it) {
-			const std::string line = hz::string_trim_copy(it->str(1));
-			const std::string num = hz::string_trim_copy(it->str(2));
-			const std::string type = hz::string_trim_copy(it->str(3));
-			const std::string status_str = hz::string_trim_copy(it->str(4));
-			const std::string remaining = hz::string_trim_copy(it->str(5));
-			const std::string hours = hz::string_trim_copy(it->str(6));
-			const std::string lba = hz::string_trim_copy(it->str(7));
+				R"(/^(#[ \t]*([0-9]+)[ \t]+(\S+(?: \S+)*)  [ \t]*(\S.*) [ \t]*([0-9]+%)  [ \t]*([0-9]+)[ \t]*((?:  [ \t]*\S.*)?))$/i)");
+
+		// The entries are single lines, match them one by one in a single pass.
+		// Only the first (most recent) get_max_log_entries() entries are stored, but all are counted.
+		const std::size_t max_entries = get_max_log_entries();
+		for (const std::string_view sub_line : hz::string_split_view(sub, '\n', true)) {
+			std::string matched_line, num, type, status_str, remaining, hours, lba;
+			if (!sub_line.starts_with('#')
+					|| !app_regex_full_match(re, std::string(sub_line), {&matched_line, &num, &type, &status_str, &remaining, &hours, &lba})) {
+				continue;
+			}
+			++test_count;
+			if (max_entries != 0 && static_cast<std::size_t>(test_count) > max_entries) {
+				continue;
+			}
+			const std::string line = hz::string_trim_copy(matched_line);
+			hz::string_trim(num);
+			hz::string_trim(type);
+			hz::string_trim(status_str);
+			hz::string_trim(remaining);
+			hz::string_trim(hours);
+			hz::string_trim(lba);
 
 			StorageProperty p(pt);
 			p.set_name(fmt::format("ata_smart_self_test_log/entry/{}", num), "Self-test entry " + num);
@@ -1874,8 +2098,6 @@ Num  Test_Description    Status                  Remaining  LifeTime(hours)  LBA
 
 			add_property(p);
 			data_found = true;
-
-			++test_count;
 		}
 	}
 
@@ -1909,6 +2131,7 @@ Num  Test_Description    Status                  Remaining  LifeTime(hours)  LBA
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_selective_selftest_log(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_selective_selftest_log", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::SelectiveSelftestLog;
 
@@ -1965,6 +2188,7 @@ If Selective self-test is pending on power-up, resume after 0 minute delay.
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_scttemp_log(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_scttemp_log", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::TemperatureLog;
 
@@ -2012,6 +2236,15 @@ Index    Estimated Time   Temperature Celsius
 //		data_found = true;
 	}
 
+	// The history table, typed. Used by the graph and the exporters.
+	if (auto history = text_parse_sct_temperature_history(sub)) {
+		StorageProperty p(pt);
+		p.set_name("ata_sct_temperature_history/table", "Temperature history");
+		p.value = std::move(history.value());
+		p.show_in_ui = false;  // shown as a graph
+		add_property(std::move(p));
+	}
+
 	// supported / unsupported
 	{
 		StorageProperty p(pt);
@@ -2053,6 +2286,7 @@ Index    Estimated Time   Temperature Celsius
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_scterc_log(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_scterc_log", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::ErcLog;
 
@@ -2101,6 +2335,7 @@ SCT Error Recovery Control:
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_devstat(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_devstat", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::Statistics;
 
@@ -2272,6 +2507,7 @@ Page Offset Size         Value  Description
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextAtaParser::parse_section_data_subsection_sataphy(const std::string& sub)
 {
+	const AppTraceSpan trace_span("SmartctlTextAtaParser::parse_section_data_subsection_sataphy", "parser");
 	StorageProperty pt;  // template for easy copying
 	pt.section = StoragePropertySection::PhyLog;
 
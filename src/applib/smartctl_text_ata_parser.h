@@ -12,13 +12,61 @@ Copyright:
 #ifndef SMARTCTL_TEXT_ATA_PARSER_H
 #define SMARTCTL_TEXT_ATA_PARSER_H
 
+#include <cstddef>  // std::size_t
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "smartctl_parser.h"
 
 
 
+/// Results of parsing the Data section subsections of the previous "smartctl -x" text output
+/// of a drive, keyed by the subsection text hash. When the same cache is given to the parser of
+/// the next output, the subsections with unchanged text (e.g. a 1000-line error log) are not
+/// parsed again, only the changed ones (e.g. attributes and temperature) are.
+class SmartctlTextAtaSubsectionCache {
+	public:
+
+		/// Parse result of a subsection
+		struct Entry {
+			bool parsed = false;  ///< Whether the subsection was parsed successfully
+			std::vector<StorageProperty> properties;  ///< Properties added by the subsection parser
+		};
+
+
+		/// Start a new parse. If the requested sections or the maximum number of log entries
+		/// differ from the previous parse, the cache is cleared.
+		void begin(const std::vector<StoragePropertySection>& requested_sections, std::size_t max_log_entries);
+
+		/// Find the result of a subsection from the previous parse and keep it for the next one.
+		/// \return nullptr if not found.
+		[[nodiscard]] const Entry* reuse(std::size_t text_hash);
+
+		/// Store the result of a subsection parsed in this parse
+		void store(std::size_t text_hash, Entry entry);
+
+		/// Finish the parse, dropping the results of subsections which were not present in it
+		void finish();
+
+		/// Get the number of subsections whose results were reused in the last parse
+		[[nodiscard]] std::size_t get_reused_count() const;
+
+
+	private:
+
+		std::vector<StoragePropertySection> requested_sections_;  ///< Requested sections of the previous parse
+		std::size_t max_log_entries_ = 0;  ///< Maximum number of log entries of the previous parse
+		std::unordered_map<std::size_t, Entry> entries_;  ///< Results of the previous parse
+		std::unordered_map<std::size_t, Entry> next_entries_;  ///< Results of the current parse
+		std::size_t reused_count_ = 0;  ///< Number of reused results in the current / last parse
+
+};
+
+
+
 /// Smartctl (S)ATA text output parser.
 /// Note: ALL parse_* functions (except parse())
 /// expect data in unix-newline format!
@@ -32,22 +80,35 @@ class SmartctlTextAtaParser : public SmartctlParser {
 		[[nodiscard]] hz::ExpectedVoid<SmartctlParserError> parse(std::string_view smartctl_output) override;
 
 
+		/// Set the Data section subsection cache, shared between the parsers of the same drive's outputs.
+		/// Call before parse().
+		void set_subsection_cache(std::shared_ptr<SmartctlTextAtaSubsectionCache> cache);
+
+
 	protected:
 
 		/// Parse the section part (with "=== .... ===" header) - info or data sections.
-		hz::ExpectedVoid<SmartctlParserError> parse_section(const std::string& header, const std::string& body);
+		hz::ExpectedVoid<SmartctlParserError> parse_section(const std::string& header, std::string_view body);
 
 
 		/// Parse the info section (without "===" header).
 		/// This includes --info and --get=all.
-		hz::ExpectedVoid<SmartctlParserError> parse_section_info(const std::string& body);
+		hz::ExpectedVoid<SmartctlParserError> parse_section_info(std::string_view body);
 
 		/// Parse a component (one line) of the info section
 		hz::ExpectedVoid<SmartctlParserError> parse_section_info_property(StorageProperty& p);
 
 
+		// Overridden
+		[[nodiscard]] std::unique_ptr<SmartctlParser> create_section_parser() const override;
+
+
 		/// Parse the Data section (without "===" header)
-		hz::ExpectedVoid<SmartctlParserError> parse_section_data(const std::string& body);
+		hz::ExpectedVoid<SmartctlParserError> parse_section_data(std::string_view body);
+
+		/// Parse a subsection of the Data section with the parser selected by its first line.
+		/// \return false if it was not parsed.
+		bool parse_section_data_subsection(const std::string& sub);
 
 		/// Parse subsections of Data section
 		hz::ExpectedVoid<SmartctlParserError> parse_section_data_subsection_health(const std::string& sub);
@@ -78,6 +139,8 @@ class SmartctlTextAtaParser : public SmartctlParser {
 		std::string data_section_info_;  ///< "info" section data, filled by parse_section_info()
 		std::string data_section_data_;  ///< "data" section data, filled by parse_section_data()
 
+		std::shared_ptr<SmartctlTextAtaSubsectionCache> subsection_cache_;  ///< Subsection cache, may be nullptr
+
 };
 
 
@@ -28,6 +28,7 @@ Copyright:
 #include "app_regex.h"
 //#include "ata_storage_property_descr.h"
 // #include "warning_colors.h"
+#include "app_trace.h"
 #include "smartctl_parser_types.h"
 #include "smartctl_version_parser.h"
 #include "smartctl_text_parser_helper.h"
@@ -36,8 +37,9 @@ Copyright:
 
 hz::ExpectedVoid<SmartctlParserError> SmartctlTextBasicParser::parse(std::string_view smartctl_output)
 {
+	const AppTraceSpan trace_span("SmartctlTextBasicParser::parse", "parser");
 	// perform any2unix
-	const std::string output = hz::string_trim_copy(hz::string_any_to_unix_copy(smartctl_output));
+	const std::string output = hz::string_any_to_unix_copy(hz::string_trim_view(smartctl_output));
 
 	if (output.empty()) {
 		debug_out_warn("app", DBG_FUNC_MSG << "Empty string passed as an argument. Returning.\n");
@@ -71,8 +73,7 @@ hz::ExpectedVoid<SmartctlParserError> SmartctlTextBasicParser::parse(std::string
 	{
 		StorageProperty p;
 		p.set_name("smartctl/output", "Smartctl Text Output");
-		p.reported_value = output;
-		p.value = p.reported_value;  // string-type value
+		p.value = output;  // string-type value. Not in reported_value, to avoid another copy.
 		p.show_in_ui = false;
 		add_property(p);
 	}
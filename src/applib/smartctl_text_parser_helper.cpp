@@ -17,6 +17,146 @@ Copyright:
 #include "hz/string_algo.h"  // string_*
 #include "hz/debug.h"
 
+#include <algorithm>
+#include <cctype>
+
+
+
+namespace {
+
+	/// ASCII case-insensitive character comparison
+	inline bool chars_equal_nocase(char a, char b)
+	{
+		return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+	}
+
+
+	/// ASCII case-insensitive string comparison
+	inline bool equals_nocase(std::string_view str, std::string_view other)
+	{
+		return str.size() == other.size() && std::equal(str.begin(), str.end(), other.begin(), &chars_equal_nocase);
+	}
+
+
+	/// ASCII case-insensitive prefix check
+	inline bool starts_with_nocase(std::string_view str, std::string_view prefix)
+	{
+		return str.size() >= prefix.size() && equals_nocase(str.substr(0, prefix.size()), prefix);
+	}
+
+
+	/// ASCII case-insensitive suffix check
+	inline bool ends_with_nocase(std::string_view str, std::string_view suffix)
+	{
+		return str.size() >= suffix.size() && equals_nocase(str.substr(str.size() - suffix.size()), suffix);
+	}
+
+
+	/// Match "Warning! SMART <name> Structure error: invalid SMART checksum." and return the name.
+	inline bool match_checksum_warning(std::string_view line, std::string_view& structure_name)
+	{
+		constexpr std::string_view prefix = "Warning! SMART ";
+		constexpr std::string_view suffix = " Structure error: invalid SMART checksum.";
+		if (line.size() > prefix.size() + suffix.size()
+				&& starts_with_nocase(line, prefix) && ends_with_nocase(line, suffix)) {
+			structure_name = line.substr(prefix.size(), line.size() - prefix.size() - suffix.size());
+			return true;
+		}
+		return false;
+	}
+
+
+	/// Check for warnings which old smartctl versions don't separate from the next section.
+	/// These need newlines around them.
+	inline bool is_unseparated_warning(std::string_view line)
+	{
+		return equals_nocase(line, "Warning: device does not support Error Logging")
+				|| equals_nocase(line, "Warning: device does not support Self Test Logging")
+				|| equals_nocase(line, "Device does not support Selective Self Tests/Logging")
+				|| equals_nocase(line, "Warning: device does not support SCT Commands");
+	}
+
+
+	/// Check for errors which get in the way of subsection detection and have little value.
+	inline bool is_subsection_noise(std::string_view line)
+	{
+		// "ATA_READ_LOG_EXT (addr=0x00:0x00, page=0, n=1) failed: 48-bit ATA commands not implemented"
+		// or "ATA_READ_LOG_EXT (addr=0x11:0x00, page=0, n=1) failed: scsi error aborted command"
+		// in front of "Read GP Log Directory failed" and "Read SATA Phy Event Counters failed".
+		if (constexpr std::string_view prefix = "ATA_READ_LOG_EXT ("; starts_with_nocase(line, prefix)) {
+			const std::string_view rest = line.substr(prefix.size());
+			const auto paren_pos = rest.find(')');
+			if (paren_pos != 0 && paren_pos != std::string_view::npos && starts_with_nocase(rest.substr(paren_pos), ") failed: ")) {
+				return true;
+			}
+		}
+		// "SMART WRITE LOG does not return COUNT and LBA_LOW register"
+		// in front of "SCT (Get) Error Recovery Control command failed" (scterc section)
+		if (equals_nocase(line, "SMART WRITE LOG does not return COUNT and LBA_LOW register")
+				|| equals_nocase(line, "Error SMART WRITE LOG does not return COUNT and LBA_LOW register")) {
+			return true;
+		}
+		// "Read SCT Status failed: scsi error aborted command"
+		// in front of "Read SCT Temperature History failed" and "SCT (Get) Error Recovery Control command failed"
+		// "Unknown SCT Status format version 0, should be 2 or 3."
+		// "Read SCT Data Table failed: scsi error aborted command"
+		// "Write SCT Data Table failed: Undefined error: 0"
+		// in front of "Read SCT Temperature History failed"
+		if (starts_with_nocase(line, "Read SCT Status failed: ")
+				|| starts_with_nocase(line, "Unknown SCT Status format version ")
+				|| starts_with_nocase(line, "Read SCT Data Table failed: ")
+				|| starts_with_nocase(line, "Write SCT Data Table failed: ")) {
+			return true;
+		}
+		// "Unexpected SCT status 0x0000 (action_code=0, function_code=0)"
+		// in front of "Read SCT Temperature History failed"
+		if (constexpr std::string_view prefix = "Unexpected SCT status ";
+				line.size() > prefix.size() && starts_with_nocase(line, prefix) && line.back() == ')') {
+			return true;
+		}
+		return false;
+	}
+
+
+	/// Check for the column separators of the attribute table
+	inline bool is_attribute_blank(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+
+	/// Check for an ASCII digit
+	inline bool is_attribute_digit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+
+	/// Match 0x[a-fA-F0-9]+ (old format flag)
+	inline bool is_attribute_old_flag(std::string_view word)
+	{
+		return word.size() > 2 && word[0] == '0' && (word[1] == 'x' || word[1] == 'X')
+				&& std::all_of(word.begin() + 2, word.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; });
+	}
+
+
+	/// Match [A-Z+-]{2,} case-insensitively (brief format flags)
+	inline bool is_attribute_brief_flag(std::string_view word)
+	{
+		return word.size() >= 2 && std::all_of(word.begin(), word.end(), [](char c) {
+			return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '+' || c == '-';
+		});
+	}
+
+
+	/// Match [0-9-]+ (value / worst / threshold)
+	inline bool is_attribute_value(std::string_view word)
+	{
+		return !word.empty() && std::all_of(word.begin(), word.end(), [](char c) { return is_attribute_digit(c) || c == '-'; });
+	}
+
+}
+
 
 
 std::string SmartctlTextParserHelper::parse_byte_size(std::string str, int64_t& bytes, bool extended)
@@ -71,9 +211,193 @@ std::string SmartctlTextParserHelper::parse_byte_size(std::string str, int64_t&
 
 
 
+std::string SmartctlTextParserHelper::cleanup_ata_output(std::string_view output, std::vector<std::string>& checksum_error_structures)
+{
+	std::string result;
+	result.reserve(output.size() + 16);
+
+	bool first_result_line = true;
+	auto add_line = [&](std::string_view line) {
+		if (!first_result_line) {
+			result += '\n';
+		}
+		result.append(line);
+		first_result_line = false;
+	};
+
+	bool after_error_count_warning = false;  // the previous kept line is "Warning: ATA error count..."
+	bool pending_empty_line = false;  // an empty line after it, removed only if some other line follows
+
+	std::size_t line_start = 0;
+	for (std::size_t line_index = 0; line_start <= output.size(); ++line_index) {
+		// Lines may end with "\n", "\r\n" (dos) or "\r" (mac). The result has unix newlines.
+		std::size_t line_end = output.find_first_of("\r\n", line_start);
+		if (line_end == std::string_view::npos) {
+			line_end = output.size();
+		}
+		const std::string_view line = output.substr(line_start, line_end - line_start);
+		line_start = line_end + 1;
+		if (line_end < output.size() && output[line_end] == '\r' && line_start < output.size() && output[line_start] == '\n') {
+			++line_start;
+		}
+
+		// Checksum warnings are kind of randomly distributed, so extract and remove them.
+		// Remove "May need -F samsung..." lines too, they don't do anything crucial.
+		// The first line is never removed.
+		if (line_index > 0) {
+			if (std::string_view structure_name; match_checksum_warning(line, structure_name)) {
+				checksum_error_structures.push_back(hz::string_trim_copy(structure_name));
+				continue;
+			}
+			if (ends_with_nocase(line, "May need -F samsung or -F samsung2 enabled; see manual for details.")) {
+				continue;
+			}
+		}
+
+		// The "Warning: ATA error count" line may be followed by an extra empty line, making
+		// it confusing for section separation. Remove one.
+		pending_empty_line = false;
+		if (line.empty() && after_error_count_warning) {
+			after_error_count_warning = false;
+			pending_empty_line = true;
+			continue;
+		}
+		after_error_count_warning = starts_with_nocase(line, "Warning: ATA error count");
+
+		if (is_unseparated_warning(line)) {
+			// If the device doesn't support many things, the warnings aren't separated (for sections).
+			// Fix that. This affects old smartctl only (at least 6.5 fixed the warnings).
+			add_line({});
+			add_line(line);
+			add_line({});
+
+		} else if (is_subsection_noise(line)) {
+			add_line({});  // keep the newline
+
+		} else {
+			add_line(line);
+		}
+	}
+
+	if (pending_empty_line) {
+		add_line({});
+	}
+
+	return result;
+}
+
+
+
+bool SmartctlTextParserHelper::tokenize_ata_attribute_line(std::string_view line, SmartctlTextAtaAttributeFormat format,
+		SmartctlTextAtaAttributeFields& fields)
+{
+	// This replaces the following regexps (matched case-insensitively against the whole line),
+	// which were the bulk of the text attribute parsing time:
+	// Old:       [ \t]*([0-9]+) ([^ \t\n]+(?:[^0-9\t\n]+)*)[ \t]+(0x[a-fA-F0-9]+)[ \t]+
+	//            ([0-9-]+)[ \t]+([0-9-]+)[ \t]+([0-9-]+)[ \t]+([^ \t\n]+)[ \t]+([^ \t\n]+)[ \t]+([^ \t\n]+)[ \t]+(.+)[ \t]*
+	// NoUpdated: the same without the UPDATED column.
+	// Brief:     [ \t]*([0-9]+) ([^ \t\n]+)[ \t]+([A-Z+-]{2,})[ \t]+
+	//            ([0-9-]+)[ \t]+([0-9-]+)[ \t]+([0-9-]+)[ \t]+([^ \t\n]+)[ \t]+(.+)[ \t]*
+	// All the columns except the name (in the old formats) and the raw value are single words.
 
-/// @}
+	fields = SmartctlTextAtaAttributeFields();
+	std::size_t pos = 0;
 
+	auto skip_blanks = [&]() {
+		while (pos < line.size() && is_attribute_blank(line[pos])) {
+			++pos;
+		}
+	};
+	// A word, preceded by (already skipped) blanks. Empty at the end of line.
+	auto take_word = [&]() {
+		const std::size_t start = pos;
+		while (pos < line.size() && !is_attribute_blank(line[pos])) {
+			++pos;
+		}
+		return line.substr(start, pos - start);
+	};
+	auto take_column = [&]() {
+		skip_blanks();
+		return take_word();
+	};
+
+	// ID, followed by exactly one space
+	skip_blanks();
+	const std::size_t id_start = pos;
+	while (pos < line.size() && is_attribute_digit(line[pos])) {
+		++pos;
+	}
+	fields.id = line.substr(id_start, pos - id_start);
+	if (fields.id.empty() || pos + 1 >= line.size() || line[pos] != ' ' || is_attribute_blank(line[pos + 1])) {
+		return false;
+	}
+	++pos;
 
+	// Name
+	const std::size_t name_start = pos;
+	take_word();
+	std::size_t name_end = pos;
 
+	if (format == SmartctlTextAtaAttributeFormat::Brief) {
+		fields.flag = take_column();
+		if (!is_attribute_brief_flag(fields.flag)) {
+			return false;
+		}
+	} else {
+		// The words after the first one may be a part of the name, as long as they have
+		// no digits and are separated by spaces. The flag is the first word with digits.
+		while (true) {
+			const std::size_t blanks_start = pos;
+			skip_blanks();
+			const std::size_t word_start = pos;
+			const std::string_view word = take_word();
+			if (word.empty()) {
+				return false;
+			}
+			if (std::any_of(word.begin(), word.end(), &is_attribute_digit)) {
+				fields.flag = word;
+				break;
+			}
+			if (line.substr(blanks_start, word_start - blanks_start).find('\t') != std::string_view::npos) {
+				return false;
+			}
+			name_end = pos;
+		}
+		if (!is_attribute_old_flag(fields.flag)) {
+			return false;
+		}
+	}
+	fields.name = line.substr(name_start, name_end - name_start);
+
+	fields.value = take_column();
+	fields.worst = take_column();
+	fields.threshold = take_column();
+	if (!is_attribute_value(fields.value) || !is_attribute_value(fields.worst) || !is_attribute_value(fields.threshold)) {
+		return false;
+	}
 
+	if (format != SmartctlTextAtaAttributeFormat::Brief) {
+		fields.attr_type = take_column();
+		if (format == SmartctlTextAtaAttributeFormat::Old) {
+			fields.update_type = take_column();
+		}
+	}
+	fields.when_failed = take_column();
+
+	// Raw value, until the end of line. A missing column before it leaves nothing for it.
+	skip_blanks();
+	if (pos >= line.size()) {
+		return false;
+	}
+	std::size_t raw_end = line.size();
+	while (raw_end > pos && is_attribute_blank(line[raw_end - 1])) {
+		--raw_end;
+	}
+	fields.raw_value = line.substr(pos, raw_end - pos);
+
+	return true;
+}
+
+
+
+/// @}
@@ -13,10 +13,37 @@ Copyright:
 #define SMARTCTL_TEXT_PARSER_HELPER_H
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <cstdint>
 
 
 
+/// Column layouts of the "smartctl -A" text attribute table
+enum class SmartctlTextAtaAttributeFormat {
+	Old,  ///< ID# ATTRIBUTE_NAME FLAG VALUE WORST THRESH TYPE UPDATED WHEN_FAILED RAW_VALUE (used in -a)
+	NoUpdated,  ///< Old format without the UPDATED column (smartctl before 5.1-14)
+	Brief,  ///< ID# ATTRIBUTE_NAME FLAGS VALUE WORST THRESH FAIL RAW_VALUE (used in -x)
+};
+
+
+
+/// Fields of an attribute table line. The views point into the tokenized line.
+struct SmartctlTextAtaAttributeFields {
+	std::string_view id;  ///< Attribute ID
+	std::string_view name;  ///< Attribute name, may contain spaces in the Old / NoUpdated formats
+	std::string_view flag;  ///< "0x0032" or "PO-R--"
+	std::string_view value;  ///< Normalized value, may be "---"
+	std::string_view worst;  ///< Worst value, may be "---"
+	std::string_view threshold;  ///< Threshold, may be "---"
+	std::string_view attr_type;  ///< "Pre-fail" / "Old_age", empty in the Brief format
+	std::string_view update_type;  ///< "Always" / "Offline", empty in the Brief and NoUpdated formats
+	std::string_view when_failed;  ///< "-", "In_the_past", "FAILING_NOW" (or "Past" / "NOW" in the Brief format)
+	std::string_view raw_value;  ///< Raw value until the end of line, may contain spaces (e.g. "27 (Min/Max 12/48)")
+};
+
+
+
 /// Helpers for smartctl text output parser
 class SmartctlTextParserHelper {
 	public:
@@ -28,6 +55,22 @@ class SmartctlTextParserHelper {
 		/// \return Size as a displayable string
 		static std::string parse_byte_size(std::string str, int64_t& bytes, bool extended);
 
+
+		/// Clean up (trimmed) ATA smartctl text output so that it doesn't
+		/// interfere with section parsing. This removes the checksum warnings (returning
+		/// their structure names through \c checksum_error_structures) and some errors that
+		/// get in the way of subsection detection, and fixes the newlines around some warnings.
+		/// Mac and dos newlines are converted to unix ones. Done in a single pass over the lines.
+		static std::string cleanup_ata_output(std::string_view output, std::vector<std::string>& checksum_error_structures);
+
+
+		/// Split an attribute table line of "smartctl -A" text output into its columns.
+		/// This accepts the same lines as the column regexps used before (see the implementation),
+		/// including the -v variants with custom names and raw value formats.
+		/// \return false if the line is not an attribute line of this format.
+		static bool tokenize_ata_attribute_line(std::string_view line, SmartctlTextAtaAttributeFormat format,
+				SmartctlTextAtaAttributeFields& fields);
+
 };
 
 
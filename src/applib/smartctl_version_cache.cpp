@@ -0,0 +1,96 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>
+
+#include "rconfig/rconfig.h"
+
+#include "smartctl_version_cache.h"
+
+
+
+std::optional<SmartctlBinaryStamp> smartctl_version_cache_get_stamp(const hz::fs::path& binary)
+{
+	hz::fs::path file = binary;
+	if (!binary.has_parent_path()) {  // just a name, look it up the same way spawning does
+		const std::string found = Glib::find_program_in_path(hz::fs_path_to_string(binary));
+		if (found.empty()) {
+			return std::nullopt;
+		}
+		file = hz::fs_path_from_string(found);
+	}
+
+	std::error_code ec;
+	file = hz::fs::absolute(file, ec);
+	if (ec) {
+		return std::nullopt;
+	}
+	SmartctlBinaryStamp stamp;
+	stamp.path = hz::fs_path_to_string(file);
+	stamp.size = hz::fs::file_size(file, ec);
+	if (ec) {
+		return std::nullopt;
+	}
+	const auto mtime = hz::fs::last_write_time(file, ec);
+	if (ec) {
+		return std::nullopt;
+	}
+	stamp.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+	return stamp;
+}
+
+
+
+std::optional<SmartctlVersionInfo> smartctl_version_cache_lookup(const SmartctlBinaryStamp& stamp)
+{
+	const auto cached = rconfig::get_data<rconfig::json>("system/smartctl_version_cache");
+	try {
+		if (!cached.is_object() || cached.empty()) {
+			return std::nullopt;
+		}
+		SmartctlBinaryStamp cached_stamp;
+		cached_stamp.path = cached.at("path").get<std::string>();
+		cached_stamp.mtime = cached.at("mtime").get<std::int64_t>();
+		cached_stamp.size = cached.at("size").get<std::uintmax_t>();
+		if (cached_stamp != stamp) {
+			return std::nullopt;
+		}
+		SmartctlVersionInfo info;
+		info.version = cached.at("version").get<std::string>();
+		info.version_full = cached.at("version_full").get<std::string>();
+		if (info.version.empty()) {
+			return std::nullopt;
+		}
+		return info;
+	}
+	catch (rconfig::json::exception& e) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Invalid smartctl version cache: " << e.what() << "\n");
+	}
+	return std::nullopt;
+}
+
+
+
+void smartctl_version_cache_store(const SmartctlBinaryStamp& stamp, const SmartctlVersionInfo& info)
+{
+	rconfig::set_data("system/smartctl_version_cache", rconfig::json {
+		{"path", stamp.path},
+		{"mtime", stamp.mtime},
+		{"size", stamp.size},
+		{"version", info.version},
+		{"version_full", info.version_full},
+	});
+}
+
+
+
+
+/// @}
@@ -0,0 +1,60 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef SMARTCTL_VERSION_CACHE_H
+#define SMARTCTL_VERSION_CACHE_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "hz/fs.h"
+
+
+
+/// Parsed "smartctl -V" output of a smartctl binary
+struct SmartctlVersionInfo {
+	std::string version;  ///< A string similar to "7.2"
+	std::string version_full;  ///< A string similar to "smartctl 7.2 2020-12-30 r5155"
+};
+
+
+
+/// Identity of a smartctl binary file, to detect when it's replaced or upgraded
+struct SmartctlBinaryStamp {
+	std::string path;  ///< Absolute path of the binary
+	std::int64_t mtime = 0;  ///< Modification time, in file clock ticks
+	std::uintmax_t size = 0;  ///< File size
+
+	bool operator==(const SmartctlBinaryStamp& other) const = default;
+};
+
+
+
+/// Get the stamp of a smartctl binary. The binary is looked up in PATH if \c binary is not a path.
+/// \return std::nullopt if the binary doesn't exist.
+[[nodiscard]] std::optional<SmartctlBinaryStamp> smartctl_version_cache_get_stamp(const hz::fs::path& binary);
+
+
+/// Get the cached version of the binary (stored in "system/smartctl_version_cache" config key).
+/// \return std::nullopt if nothing is cached for this binary, or the binary has changed since.
+[[nodiscard]] std::optional<SmartctlVersionInfo> smartctl_version_cache_lookup(const SmartctlBinaryStamp& stamp);
+
+
+/// Store the version of the binary, replacing any previously cached one.
+void smartctl_version_cache_store(const SmartctlBinaryStamp& stamp, const SmartctlVersionInfo& info);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,133 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm/i18n.h>
+#include <memory>
+#include <utility>
+
+#include "hz/debug.h"
+
+#include "smartctl_executor.h"
+#include "smartctl_version_parser.h"
+#include "smartctl_version_probe.h"
+#include "worker_threads.h"
+
+
+
+namespace {
+
+	/// A background probe, owned by the main thread
+	struct SmartctlVersionProbe {
+		std::unique_ptr<AppTaskGroup> task_group;  ///< Runs the smartctl command, if not cached
+		SmartctlVersionProbeResult result;  ///< Written by the task, read after the task group is waited for
+	};
+
+
+	/// The probe started by smartctl_version_probe_start(), if not taken yet
+	std::unique_ptr<SmartctlVersionProbe>& get_pending_probe()
+	{
+		static std::unique_ptr<SmartctlVersionProbe> probe;
+		return probe;
+	}
+
+
+	/// Run "smartctl -V". Runs in a worker thread, so it must not touch the config.
+	void run_version_command(SmartctlVersionProbeResult& result)
+	{
+		SmartctlExecutor ex;
+		ex.set_command(result.binary, {"-V"});  // --version
+
+		if (!ex.execute() || !ex.get_error_msg().empty()) {
+			result.error_msg = ex.get_error_msg();
+			return;
+		}
+
+		const std::string output = ex.get_stdout_str();
+		if (output.empty()) {
+			result.error_msg = _("Smartctl returned an empty output.");
+			return;
+		}
+
+		SmartctlVersionInfo info;
+		if (!SmartctlVersionParser::parse_version_text(output, info.version, info.version_full)) {
+			result.error_msg = _("Smartctl returned invalid output.");
+			return;
+		}
+		result.info = std::move(info);
+	}
+
+}
+
+
+
+void smartctl_version_probe_start(const hz::fs::path& binary)
+{
+	const auto start_time = std::chrono::steady_clock::now();
+
+	auto probe = std::make_unique<SmartctlVersionProbe>();
+	probe->result.binary = hz::fs_path_to_string(binary);
+	if (probe->result.binary.empty()) {
+		get_pending_probe().reset();  // nothing to probe, the caller reports it
+		return;
+	}
+
+	probe->result.stamp = smartctl_version_cache_get_stamp(binary);
+	if (probe->result.stamp.has_value()) {
+		probe->result.info = smartctl_version_cache_lookup(probe->result.stamp.value());
+		probe->result.from_cache = probe->result.info.has_value();
+	}
+
+	if (!probe->result.from_cache) {
+		probe->task_group = std::make_unique<AppTaskGroup>(1);
+		probe->task_group->run([&result = probe->result, start_time]() {
+			run_version_command(result);
+			result.duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+		});
+	} else {
+		probe->result.duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+	}
+
+	get_pending_probe() = std::move(probe);
+}
+
+
+
+std::optional<SmartctlVersionProbeResult> smartctl_version_probe_take(const hz::fs::path& binary)
+{
+	auto probe = std::move(get_pending_probe());
+	if (!probe) {
+		return std::nullopt;
+	}
+
+	if (probe->task_group) {
+		const auto wait_start = std::chrono::steady_clock::now();
+		probe->task_group->wait();  // keeps the GUI responsive
+		probe->task_group.reset();
+		debug_out_info("app", "Smartctl version probe took " << probe->result.duration.count() << " usec in background, waited "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wait_start).count()
+				<< " usec for it.\n");
+	}
+
+	// The binary was changed in the meantime
+	if (probe->result.binary != hz::fs_path_to_string(binary)) {
+		return std::nullopt;
+	}
+
+	if (!probe->result.from_cache && probe->result.info.has_value() && probe->result.stamp.has_value()) {
+		smartctl_version_cache_store(probe->result.stamp.value(), probe->result.info.value());
+	}
+	return std::move(probe->result);
+}
+
+
+
+
+/// @}
@@ -0,0 +1,54 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef SMARTCTL_VERSION_PROBE_H
+#define SMARTCTL_VERSION_PROBE_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include "hz/fs.h"
+#include "smartctl_version_cache.h"
+
+
+
+/// Result of running "smartctl -V"
+struct SmartctlVersionProbeResult {
+	std::string binary;  ///< The binary, as given to smartctl_version_probe_start()
+	std::optional<SmartctlBinaryStamp> stamp;  ///< Binary stamp, std::nullopt if the binary wasn't found
+	std::optional<SmartctlVersionInfo> info;  ///< The version, std::nullopt on error
+	std::string error_msg;  ///< Error message if \c info is empty
+	bool from_cache = false;  ///< True if the version was taken from the version cache, without running smartctl
+	std::chrono::microseconds duration {0};  ///< Time spent probing
+};
+
+
+
+/// Start finding the smartctl binary version in the background (on the worker pool), so that
+/// the startup work which doesn't depend on it (building the windows, loading the icons) runs meanwhile.
+/// The version cache is consulted right away; the binary is run only if nothing is cached for it.
+/// Must be called from the main thread. A previous unclaimed probe is discarded.
+void smartctl_version_probe_start(const hz::fs::path& binary);
+
+
+/// Get the result of the background probe started for \c binary, waiting for it if needed
+/// (the main context keeps being iterated meanwhile). The probed version is stored in the version cache.
+/// The result can be taken only once; the later calls (or the calls for a different binary)
+/// return std::nullopt, and the caller should run smartctl itself. Must be called from the main thread.
+[[nodiscard]] std::optional<SmartctlVersionProbeResult> smartctl_version_probe_take(const hz::fs::path& binary);
+
+
+
+
+#endif
+
+/// @}
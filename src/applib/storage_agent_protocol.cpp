@@ -0,0 +1,524 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>  // compose()
+#include <glibmm/i18n.h>
+#include <algorithm>  // std::find
+#include <optional>
+#include <utility>
+
+#include "storage_agent_protocol.h"
+#include "storage_lifetime_metrics.h"
+#include "storage_property_diff.h"
+#include "storage_property_snapshot.h"
+#include "storage_risk_ranking.h"
+
+
+
+namespace {
+
+	/// Stream header, followed by the protocol version
+	constexpr std::string_view agent_stream_header = "GSCAGNT";
+
+	/// Maximum frame size. Larger frames are considered stream corruption.
+	constexpr std::uint64_t agent_max_frame_size = 64 * 1024 * 1024;
+
+	/// Maximum size of an encoded varint
+	constexpr std::size_t agent_max_uint_size = 10;
+
+
+
+	/// Append an unsigned LEB128 varint
+	void agent_put_uint(std::string& out, std::uint64_t value)
+	{
+		while (value >= 0x80) {
+			out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+
+	/// Append a zigzag-encoded signed varint
+	void agent_put_int(std::string& out, std::int64_t value)
+	{
+		agent_put_uint(out, (static_cast<std::uint64_t>(value) << 1) ^ (value < 0 ? ~std::uint64_t(0) : 0));
+	}
+
+
+	/// Append a length-prefixed string
+	void agent_put_string(std::string& out, std::string_view str)
+	{
+		agent_put_uint(out, str.size());
+		out.append(str);
+	}
+
+
+	/// Read an unsigned varint at \c pos, advancing it.
+	/// \return std::nullopt if the data ends in the middle of it (\c pos is not changed then).
+	/// \c invalid is set if the value is too long.
+	std::optional<std::uint64_t> agent_get_uint(std::string_view data, std::size_t& pos, bool& invalid)
+	{
+		std::uint64_t value = 0;
+		for (std::size_t i = 0; i < agent_max_uint_size && pos + i < data.size(); ++i) {
+			const auto byte = static_cast<unsigned char>(data[pos + i]);
+			value |= static_cast<std::uint64_t>(byte & 0x7f) << (7 * i);
+			if ((byte & 0x80) == 0) {
+				pos += i + 1;
+				return value;
+			}
+		}
+		invalid = (data.size() - pos >= agent_max_uint_size);
+		return std::nullopt;
+	}
+
+
+	/// Read a zigzag-encoded signed varint at \c pos, advancing it. \return std::nullopt on error.
+	std::optional<std::int64_t> agent_get_int(std::string_view data, std::size_t& pos)
+	{
+		bool invalid = false;
+		const auto value = agent_get_uint(data, pos, invalid);
+		if (!value.has_value()) {
+			return std::nullopt;
+		}
+		return static_cast<std::int64_t>((value.value() >> 1) ^ ((value.value() & 1) != 0 ? ~std::uint64_t(0) : 0));
+	}
+
+
+	/// Read a length-prefixed string at \c pos, advancing it. \return std::nullopt on error.
+	std::optional<std::string_view> agent_get_string(std::string_view data, std::size_t& pos)
+	{
+		bool invalid = false;
+		const auto size = agent_get_uint(data, pos, invalid);
+		if (!size.has_value() || size.value() > data.size() - pos) {
+			return std::nullopt;
+		}
+		auto str = data.substr(pos, static_cast<std::size_t>(size.value()));
+		pos += str.size();
+		return str;
+	}
+
+
+	/// Encode a frame (with its size prefix)
+	std::string agent_encode_frame(StorageAgentFrameType type, std::uint64_t drive_id, std::uint64_t sequence,
+			std::string_view text, std::string_view type_argument, std::string_view data)
+	{
+		std::string payload;
+		agent_put_uint(payload, static_cast<std::uint64_t>(type));
+		agent_put_uint(payload, drive_id);
+		agent_put_uint(payload, sequence);
+		agent_put_string(payload, text);
+		agent_put_string(payload, type_argument);
+		agent_put_string(payload, data);
+
+		std::string frame;
+		frame.reserve(payload.size() + agent_max_uint_size);
+		agent_put_uint(frame, payload.size());
+		frame += payload;
+		return frame;
+	}
+
+
+	/// Bits of the optional summary fields present in the encoded summary
+	enum AgentSummaryFields : std::uint64_t {
+		agent_summary_temperature = 1U << 0,
+		agent_summary_power_on_hours = 1U << 1,
+		agent_summary_percentage_used = 1U << 2,
+	};
+
+}
+
+
+
+StorageAgentDriveSummary StorageAgentDriveSummary::get_from_properties(const StoragePropertyRepository& properties)
+{
+	StorageAgentDriveSummary summary;
+
+	const auto get_string = [&properties](const std::string& name) -> std::string {
+		if (const auto* p = properties.find_property(name); p && p->is_value_type<std::string>()) {
+			return p->get_value<std::string>();
+		}
+		return {};
+	};
+	summary.model = get_string("model_name");
+	if (summary.model.empty()) {
+		summary.model = get_string("scsi_model_name");  // USB flash
+	}
+	summary.serial = get_string("serial_number");
+
+	if (const auto* p = properties.find_property("smart_status/passed"); p && p->is_value_type<bool>()) {
+		summary.health = p->get_value<bool>() ? StorageAgentDriveHealth::Passed : StorageAgentDriveHealth::Failed;
+	}
+	for (const auto* name : {"temperature/current", "ata_sct_status/temperature/current"}) {
+		if (const auto* p = properties.find_property(name); p && p->is_value_type<std::int64_t>()) {
+			summary.temperature = p->get_value<std::int64_t>();
+			break;
+		}
+	}
+
+	const auto counters = StorageLifetimeCounters::get_from_properties(properties);
+	summary.power_on_hours = counters.power_on_hours;
+	summary.percentage_used = counters.percentage_used;
+
+	for (const auto& p : properties.get_properties()) {
+		summary.worst_warning = std::max(summary.worst_warning, p.warning_level);
+		summary.risk_score += storage_risk_property_score(p);
+	}
+	return summary;
+}
+
+
+
+std::string storage_agent_summary_save(const StorageAgentDriveSummary& summary)
+{
+	std::uint64_t fields = 0;
+	fields |= (summary.temperature.has_value() ? agent_summary_temperature : 0);
+	fields |= (summary.power_on_hours.has_value() ? agent_summary_power_on_hours : 0);
+	fields |= (summary.percentage_used.has_value() ? agent_summary_percentage_used : 0);
+
+	std::string out;
+	agent_put_string(out, summary.model);
+	agent_put_string(out, summary.serial);
+	agent_put_uint(out, static_cast<std::uint64_t>(summary.worst_warning));
+	agent_put_uint(out, static_cast<std::uint64_t>(summary.health));
+	agent_put_int(out, summary.risk_score);
+	agent_put_uint(out, fields);
+	for (const auto& value : {summary.temperature, summary.power_on_hours, summary.percentage_used}) {
+		if (value.has_value()) {
+			agent_put_int(out, value.value());
+		}
+	}
+	return out;
+}
+
+
+
+hz::ExpectedValue<StorageAgentDriveSummary, StorageAgentStreamError> storage_agent_summary_load(std::string_view data)
+{
+	std::size_t pos = 0;
+	bool invalid = false;
+	const auto model = agent_get_string(data, pos);
+	const auto serial = agent_get_string(data, pos);
+	const auto worst_warning = agent_get_uint(data, pos, invalid);
+	const auto health = agent_get_uint(data, pos, invalid);
+	const auto risk_score = agent_get_int(data, pos);
+	const auto fields = agent_get_uint(data, pos, invalid);
+	if (!model || !serial || !worst_warning || !health || !risk_score || !fields
+			|| worst_warning.value() > static_cast<std::uint64_t>(WarningLevel::Alert)
+			|| health.value() > static_cast<std::uint64_t>(StorageAgentDriveHealth::Failed)) {
+		return hz::Unexpected(StorageAgentStreamError::InvalidFormat, _("Invalid drive summary in agent stream."));
+	}
+
+	StorageAgentDriveSummary summary;
+	summary.model = model.value();
+	summary.serial = serial.value();
+	summary.worst_warning = static_cast<WarningLevel>(worst_warning.value());
+	summary.health = static_cast<StorageAgentDriveHealth>(health.value());
+	summary.risk_score = risk_score.value();
+	for (const auto& [bit, value] : {std::pair(agent_summary_temperature, &summary.temperature),
+			std::pair(agent_summary_power_on_hours, &summary.power_on_hours),
+			std::pair(agent_summary_percentage_used, &summary.percentage_used)}) {
+		if ((fields.value() & bit) != 0) {
+			*value = agent_get_int(data, pos);
+			if (!value->has_value()) {
+				return hz::Unexpected(StorageAgentStreamError::InvalidFormat, _("Invalid drive summary in agent stream."));
+			}
+		}
+	}
+	// Any data after the known fields is for future protocol revisions.
+	return summary;
+}
+
+
+
+StorageAgentStreamEncoder::StorageAgentStreamEncoder(std::size_t snapshot_interval)
+		: snapshot_interval_(snapshot_interval)
+{ }
+
+
+
+std::string StorageAgentStreamEncoder::encode_start(const std::string& host_name)
+{
+	std::string out(agent_stream_header);
+	agent_put_uint(out, storage_agent_protocol_version);
+	out += agent_encode_frame(StorageAgentFrameType::Hello, 0, 0, host_name, {}, {});
+	stats_.bytes += out.size();
+	return out;
+}
+
+
+
+std::string StorageAgentStreamEncoder::encode_drive(std::uint64_t drive_id, const std::string& device, const std::string& type_argument)
+{
+	drives_[drive_id] = DriveState();
+	std::string out = agent_encode_frame(StorageAgentFrameType::Drive, drive_id, 0, device, type_argument, {});
+	stats_.bytes += out.size();
+	return out;
+}
+
+
+
+std::string StorageAgentStreamEncoder::encode_update(std::uint64_t drive_id, const StoragePropertyRepository& repository)
+{
+	DriveState& state = drives_[drive_id];
+
+	if (state.sequence != 0 && storage_property_repository_diff(state.repository, repository).empty()) {
+		++stats_.unchanged;
+		return {};
+	}
+
+	const std::string snapshot = storage_property_snapshot_save(repository);
+	stats_.snapshot_bytes += snapshot.size();
+
+	// The summary goes first, so that a summary-only receiver may skip the repository
+	std::string out;
+	auto summary = StorageAgentDriveSummary::get_from_properties(repository);
+	if (!state.summary.has_value() || state.summary.value() != summary) {
+		out = agent_encode_frame(StorageAgentFrameType::Summary, drive_id, state.sequence + 1, {}, {},
+				storage_agent_summary_save(summary));
+		state.summary = std::move(summary);
+		++stats_.summaries;
+	}
+
+	const bool send_snapshot = (state.sequence == 0
+			|| (snapshot_interval_ != 0 && state.deltas_since_snapshot >= snapshot_interval_));
+	if (send_snapshot) {
+		out += agent_encode_frame(StorageAgentFrameType::Snapshot, drive_id, state.sequence + 1, {}, {}, snapshot);
+		state.deltas_since_snapshot = 0;
+		++stats_.snapshots;
+	} else {
+		out += agent_encode_frame(StorageAgentFrameType::Delta, drive_id, state.sequence + 1, {}, {},
+				storage_property_delta_save(state.repository, repository));
+		++state.deltas_since_snapshot;
+		++stats_.deltas;
+	}
+
+	++state.sequence;
+	state.repository = repository;
+	stats_.bytes += out.size();
+	return out;
+}
+
+
+
+std::string StorageAgentStreamEncoder::encode_error(std::uint64_t drive_id, const std::string& message)
+{
+	std::string out = agent_encode_frame(StorageAgentFrameType::Error, drive_id, 0, message, {}, {});
+	stats_.bytes += out.size();
+	return out;
+}
+
+
+
+const StorageAgentStreamStats& StorageAgentStreamEncoder::get_stats() const
+{
+	return stats_;
+}
+
+
+
+StorageAgentStreamDecoder::StorageAgentStreamDecoder(StorageAgentDecoderMode mode)
+		: mode_(mode)
+{ }
+
+
+
+hz::ExpectedVoid<StorageAgentStreamError> StorageAgentStreamDecoder::feed(std::string_view data)
+{
+	if (failed_) {
+		return hz::Unexpected(StorageAgentStreamError::InvalidFormat, _("The agent stream is broken."));
+	}
+	buffer_.append(data);
+
+	std::size_t pos = 0;
+	auto result = [&]() -> hz::ExpectedVoid<StorageAgentStreamError> {
+		if (!header_read_) {
+			if (buffer_.size() < agent_stream_header.size()) {
+				return {};
+			}
+			if (std::string_view(buffer_).substr(0, agent_stream_header.size()) != agent_stream_header) {
+				return hz::Unexpected(StorageAgentStreamError::InvalidFormat, _("Invalid agent stream header."));
+			}
+			pos = agent_stream_header.size();
+			bool invalid = false;
+			const auto version = agent_get_uint(buffer_, pos, invalid);
+			if (!version.has_value()) {
+				pos = 0;
+				if (invalid) {
+					return hz::Unexpected(StorageAgentStreamError::InvalidFormat, _("Invalid agent stream header."));
+				}
+				return {};
+			}
+			if (version.value() != storage_agent_protocol_version) {
+				return hz::Unexpected(StorageAgentStreamError::UnsupportedVersion, _("Unsupported agent stream protocol version."));
+			}
+			header_read_ = true;
+		}
+
+		while (pos < buffer_.size()) {
+			std::size_t frame_pos = pos;
+			bool invalid = false;
+			const auto size = agent_get_uint(buffer_, frame_pos, invalid);
+			if (!size.has_value() || size.value() > agent_max_frame_size) {
+				if (invalid || size.has_value()) {
+					return hz::Unexpected(StorageAgentStreamError::InvalidFormat, _("Invalid agent stream frame size."));
+				}
+				break;  // incomplete size
+			}
+			if (size.value() > buffer_.size() - frame_pos) {
+				break;  // incomplete frame
+			}
+			auto status = apply_frame(std::string_view(buffer_).substr(frame_pos, static_cast<std::size_t>(size.value())));
+			if (!status) {
+				return status;
+			}
+			pos = frame_pos + static_cast<std::size_t>(size.value());
+		}
+		return {};
+	}();
+
+	buffer_.erase(0, pos);
+	if (!result) {
+		failed_ = true;
+		buffer_.clear();
+	}
+	return result;
+}
+
+
+
+const std::string& StorageAgentStreamDecoder::get_host_name() const
+{
+	return host_name_;
+}
+
+
+
+const std::map<std::uint64_t, StorageAgentDrive>& StorageAgentStreamDecoder::get_drives() const
+{
+	return drives_;
+}
+
+
+
+std::vector<std::uint64_t> StorageAgentStreamDecoder::take_changed_drives()
+{
+	return std::exchange(changed_drives_, {});
+}
+
+
+
+hz::ExpectedVoid<StorageAgentStreamError> StorageAgentStreamDecoder::apply_frame(std::string_view payload)
+{
+	std::size_t pos = 0;
+	bool invalid = false;
+	const auto type = agent_get_uint(payload, pos, invalid);
+	const auto drive_id = agent_get_uint(payload, pos, invalid);
+	const auto sequence = agent_get_uint(payload, pos, invalid);
+	const auto text = agent_get_string(payload, pos);
+	const auto type_argument = agent_get_string(payload, pos);
+	const auto data = agent_get_string(payload, pos);
+	if (!type || !drive_id || !sequence || !text || !type_argument || !data) {
+		return hz::Unexpected(StorageAgentStreamError::InvalidFormat, _("Truncated agent stream frame."));
+	}
+	// Any data after the known fields is for future protocol revisions.
+
+	if (type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Hello)) {
+		host_name_ = text.value();
+		return {};
+	}
+	if (type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Drive)) {
+		StorageAgentDrive& drive = drives_[drive_id.value()];
+		drive = StorageAgentDrive();
+		drive.device = text.value();
+		drive.type_argument = type_argument.value();
+		mark_changed(drive_id.value());
+		return {};
+	}
+
+	const auto known = (type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Snapshot)
+			|| type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Delta)
+			|| type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Error)
+			|| type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Summary));
+	if (!known) {
+		return {};  // skip unknown frames
+	}
+
+	auto drive_iter = drives_.find(drive_id.value());
+	if (drive_iter == drives_.end()) {
+		return hz::Unexpected(StorageAgentStreamError::UnknownDrive,
+				Glib::ustring::compose(_("Agent stream data for unknown drive %1."), drive_id.value()));
+	}
+	StorageAgentDrive& drive = drive_iter->second;
+
+	if (type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Error)) {
+		drive.error = text.value();
+		mark_changed(drive_id.value());
+		return {};
+	}
+
+	if (type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Summary)) {
+		auto summary = storage_agent_summary_load(data.value());
+		if (!summary) {
+			return hz::Unexpected(StorageAgentStreamError::InvalidFormat, summary.error().message());
+		}
+		drive.summary = std::move(summary.value());
+		summaries_received_ = true;
+		mark_changed(drive_id.value());
+		return {};
+	}
+
+	const bool is_delta = (type.value() == static_cast<std::uint64_t>(StorageAgentFrameType::Delta));
+
+	// The summaries come before the repositories they describe, the repositories are not needed.
+	if (mode_ == StorageAgentDecoderMode::Summary && (summaries_received_ || is_delta)) {
+		drive.sequence = sequence.value();
+		drive.error.clear();
+		mark_changed(drive_id.value());
+		return {};
+	}
+
+	if (is_delta && sequence.value() != drive.sequence + 1) {
+		return hz::Unexpected(StorageAgentStreamError::SequenceMismatch,
+				Glib::ustring::compose(_("Agent stream delta for drive %1 doesn't follow the previous data."), drive_id.value()));
+	}
+
+	auto repository = is_delta ? storage_property_delta_apply(drive.repository, data.value())
+			: storage_property_snapshot_load(data.value());
+	if (!repository) {
+		return hz::Unexpected(repository.error().data() == StoragePropertySnapshotError::BaseMismatch
+				? StorageAgentStreamError::SequenceMismatch : StorageAgentStreamError::InvalidFormat, repository.error().message());
+	}
+
+	if (mode_ == StorageAgentDecoderMode::Summary) {
+		drive.summary = StorageAgentDriveSummary::get_from_properties(repository.value());
+	} else {
+		drive.repository = std::move(repository.value());
+	}
+	drive.sequence = sequence.value();
+	drive.error.clear();
+	mark_changed(drive_id.value());
+	return {};
+}
+
+
+
+void StorageAgentStreamDecoder::mark_changed(std::uint64_t drive_id)
+{
+	if (std::find(changed_drives_.begin(), changed_drives_.end(), drive_id) == changed_drives_.end()) {
+		changed_drives_.push_back(drive_id);
+	}
+}
+
+
+
+
+/// @}
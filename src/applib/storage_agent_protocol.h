@@ -0,0 +1,245 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_AGENT_PROTOCOL_H
+#define STORAGE_AGENT_PROTOCOL_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hz/error_container.h"
+
+#include "storage_property_repository.h"
+#include "warning_level.h"
+
+
+/**
+\file
+Binary stream protocol of gsmartcontrol-agent. The agent keeps the processed property
+repositories of its drives in memory and sends a full snapshot of each drive once,
+then only the deltas (see storage_property_delta_save()) when something changes.
+
+The stream starts with a header ("GSCAGNT" and the protocol version), followed by frames.
+Each frame is prefixed by its size, so that frames of unknown types can be skipped.
+The stream is ordered (a pipe, e.g. over ssh), the deltas are applied to the previous
+repository of the drive.
+
+Each update whose summary (identity, worst warning, key counters) changed is preceded by
+a Summary frame, so a receiver which only needs the summaries (see StorageAgentDecoderMode)
+doesn't have to decode or keep the repositories.
+*/
+
+
+
+/// Agent stream errors
+enum class StorageAgentStreamError {
+	InvalidFormat,  ///< Not an agent stream, or corrupted data
+	UnsupportedVersion,  ///< Stream written by a different protocol version
+	UnknownDrive,  ///< Data for a drive which wasn't announced
+	SequenceMismatch,  ///< A delta for a different repository than the one we have
+};
+
+
+
+/// Version of the agent stream protocol
+constexpr std::uint32_t storage_agent_protocol_version = 1;
+
+
+
+/// Agent stream frame types
+enum class StorageAgentFrameType {
+	Hello = 1,  ///< Stream start. text: host name of the agent.
+	Drive,  ///< A drive is reported. text: device, type_argument: smartctl -d argument.
+	Snapshot,  ///< Full property repository of a drive. data: storage_property_snapshot_save() result.
+	Delta,  ///< Changes of a drive's repository since sequence - 1. data: storage_property_delta_save() result.
+	Error,  ///< The drive's data couldn't be fetched. text: error message.
+	Summary,  ///< Summary of the next repository of a drive. data: storage_agent_summary_save() result.
+};
+
+
+
+/// SMART health of a drive, as reported in its summary
+enum class StorageAgentDriveHealth {
+	Unknown,  ///< Not reported by the drive
+	Passed,  ///< The overall health self-assessment passed
+	Failed,  ///< The overall health self-assessment failed
+};
+
+
+
+/// Summary of a drive repository: identity, the worst warning and the key counters
+struct StorageAgentDriveSummary {
+
+	/// Get the summary of the properties
+	[[nodiscard]] static StorageAgentDriveSummary get_from_properties(const StoragePropertyRepository& properties);
+
+	/// Compare all the fields
+	[[nodiscard]] bool operator==(const StorageAgentDriveSummary& other) const = default;
+
+
+	std::string model;  ///< Model name
+	std::string serial;  ///< Serial number
+	WarningLevel worst_warning = WarningLevel::None;  ///< The highest warning level of the properties
+	StorageAgentDriveHealth health = StorageAgentDriveHealth::Unknown;  ///< SMART health
+	std::optional<std::int64_t> temperature;  ///< Current temperature, Celsius
+	std::optional<std::int64_t> power_on_hours;  ///< Power-on hours
+	std::optional<std::int64_t> percentage_used;  ///< Percentage of the rated endurance used
+	std::int64_t risk_score = 0;  ///< Risk score (see storage_risk_score())
+
+};
+
+
+
+/// Serialize a drive summary (the data of a Summary frame)
+[[nodiscard]] std::string storage_agent_summary_save(const StorageAgentDriveSummary& summary);
+
+
+/// Load a drive summary serialized by storage_agent_summary_save()
+[[nodiscard]] hz::ExpectedValue<StorageAgentDriveSummary, StorageAgentStreamError> storage_agent_summary_load(std::string_view data);
+
+
+
+/// Agent stream encoder statistics
+struct StorageAgentStreamStats {
+	std::uint64_t snapshots = 0;  ///< Number of full snapshots sent
+	std::uint64_t deltas = 0;  ///< Number of deltas sent
+	std::uint64_t unchanged = 0;  ///< Number of updates which didn't change anything (nothing is sent)
+	std::uint64_t summaries = 0;  ///< Number of summaries sent
+	std::uint64_t bytes = 0;  ///< Number of bytes encoded, in total
+	std::uint64_t snapshot_bytes = 0;  ///< Number of bytes the updates would take as full snapshots
+};
+
+
+
+/// Agent side of the stream. Produces the frames to be written to the stream.
+/// Not thread-safe.
+class StorageAgentStreamEncoder {
+	public:
+
+		/// Constructor. A full snapshot of a drive is re-sent after every \c snapshot_interval
+		/// deltas (0 means only the first time).
+		explicit StorageAgentStreamEncoder(std::size_t snapshot_interval = 0);
+
+
+		/// Encode the stream header and the Hello frame
+		[[nodiscard]] std::string encode_start(const std::string& host_name);
+
+		/// Encode a Drive frame. This (re)starts the drive's data, the next update is a full snapshot.
+		[[nodiscard]] std::string encode_drive(std::uint64_t drive_id, const std::string& device, const std::string& type_argument);
+
+		/// Encode a new repository of a drive as a snapshot or a delta, preceded by its summary
+		/// if the summary changed. \return An empty string if the repository didn't change since the last update.
+		[[nodiscard]] std::string encode_update(std::uint64_t drive_id, const StoragePropertyRepository& repository);
+
+		/// Encode an Error frame
+		[[nodiscard]] std::string encode_error(std::uint64_t drive_id, const std::string& message);
+
+
+		/// Get statistics
+		[[nodiscard]] const StorageAgentStreamStats& get_stats() const;
+
+
+	private:
+
+		/// Per-drive state
+		struct DriveState {
+			std::uint64_t sequence = 0;  ///< Sequence number of the last sent repository, 0 if none
+			StoragePropertyRepository repository;  ///< Last sent repository
+			std::optional<StorageAgentDriveSummary> summary;  ///< Last sent summary
+			std::size_t deltas_since_snapshot = 0;  ///< Number of deltas since the last snapshot
+		};
+
+		std::size_t snapshot_interval_ = 0;  ///< Full snapshot interval, in deltas
+		std::unordered_map<std::uint64_t, DriveState> drives_;  ///< Drive states by drive ID
+		StorageAgentStreamStats stats_;  ///< Statistics
+
+};
+
+
+
+/// A drive, as known to the receiving side of the stream
+struct StorageAgentDrive {
+	std::string device;  ///< Device on the agent's host
+	std::string type_argument;  ///< smartctl -d argument
+	std::uint64_t sequence = 0;  ///< Sequence number of the repository, 0 if no data was received yet
+	StoragePropertyRepository repository;  ///< Properties, empty in StorageAgentDecoderMode::Summary
+	StorageAgentDriveSummary summary;  ///< Summary of the repository
+	std::string error;  ///< Error of the last update, empty if it succeeded
+};
+
+
+
+/// What StorageAgentStreamDecoder keeps of the drives
+enum class StorageAgentDecoderMode {
+	Full,  ///< Repositories and summaries
+	Summary,  ///< Summaries only. The snapshots and deltas are not decoded (unless the agent
+			///< doesn't send summaries, then the snapshots are decoded to get them).
+};
+
+
+
+/// Receiving side of the stream (a collector or the GUI).
+/// Not thread-safe.
+class StorageAgentStreamDecoder {
+	public:
+
+		/// Constructor
+		explicit StorageAgentStreamDecoder(StorageAgentDecoderMode mode = StorageAgentDecoderMode::Full);
+
+
+		/// Decode and apply the complete frames in \c data (together with the incomplete data
+		/// of the previous calls). The frames of unknown types are skipped.
+		/// After an error the decoder stays failed, and the stream should be restarted.
+		[[nodiscard]] hz::ExpectedVoid<StorageAgentStreamError> feed(std::string_view data);
+
+
+		/// Get the host name of the agent (empty before the Hello frame)
+		[[nodiscard]] const std::string& get_host_name() const;
+
+		/// Get the drives by drive ID
+		[[nodiscard]] const std::map<std::uint64_t, StorageAgentDrive>& get_drives() const;
+
+		/// Get the IDs of the drives changed since the last call (in the order of the frames, without duplicates)
+		[[nodiscard]] std::vector<std::uint64_t> take_changed_drives();
+
+
+	private:
+
+		/// Apply a frame payload
+		[[nodiscard]] hz::ExpectedVoid<StorageAgentStreamError> apply_frame(std::string_view payload);
+
+		/// Remember \c drive_id as changed
+		void mark_changed(std::uint64_t drive_id);
+
+
+		StorageAgentDecoderMode mode_ = StorageAgentDecoderMode::Full;  ///< What is kept of the drives
+		bool summaries_received_ = false;  ///< Whether the agent sends Summary frames
+		std::string buffer_;  ///< Received data not decoded yet
+		bool header_read_ = false;  ///< Whether the stream header has been read
+		bool failed_ = false;  ///< Whether an error occurred
+		std::string host_name_;  ///< Agent host name
+		std::map<std::uint64_t, StorageAgentDrive> drives_;  ///< Drives by drive ID
+		std::vector<std::uint64_t> changed_drives_;  ///< Drives changed since take_changed_drives()
+
+};
+
+
+
+
+#endif
+
+/// @}
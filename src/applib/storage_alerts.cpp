@@ -0,0 +1,337 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <optional>
+
+#ifndef _WIN32
+	#include <syslog.h>
+#endif
+
+#include "nlohmann/json.hpp"
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"  // string_split
+#include "hz/string_num.h"
+#include "rconfig/rconfig.h"
+#include "command_executor.h"
+#include "storage_property.h"
+#include "storage_alerts.h"
+
+
+
+namespace {
+
+	/// Check if an ATA self-test status is a failure
+	bool is_ata_selftest_failure(AtaStorageSelftestEntry::Status status)
+	{
+		switch (status) {
+			case AtaStorageSelftestEntry::Status::FatalOrUnknown:
+			case AtaStorageSelftestEntry::Status::ComplUnknownFailure:
+			case AtaStorageSelftestEntry::Status::ComplElectricalFailure:
+			case AtaStorageSelftestEntry::Status::ComplServoFailure:
+			case AtaStorageSelftestEntry::Status::ComplReadFailure:
+			case AtaStorageSelftestEntry::Status::ComplHandlingDamage:
+				return true;
+			case AtaStorageSelftestEntry::Status::Unknown:
+			case AtaStorageSelftestEntry::Status::Reserved:
+			case AtaStorageSelftestEntry::Status::CompletedNoError:
+			case AtaStorageSelftestEntry::Status::AbortedByHost:
+			case AtaStorageSelftestEntry::Status::Interrupted:
+			case AtaStorageSelftestEntry::Status::InProgress:
+				break;
+		}
+		return false;
+	}
+
+
+	/// Check if an NVMe self-test result is a failure
+	bool is_nvme_selftest_failure(NvmeSelfTestResultType result)
+	{
+		switch (result) {
+			case NvmeSelfTestResultType::FatalOrUnknownTestError:
+			case NvmeSelfTestResultType::CompletedUnknownFailedSegment:
+			case NvmeSelfTestResultType::CompletedFailedSegments:
+				return true;
+			case NvmeSelfTestResultType::Unknown:
+			case NvmeSelfTestResultType::CompletedNoError:
+			case NvmeSelfTestResultType::AbortedSelfTestCommand:
+			case NvmeSelfTestResultType::AbortedControllerReset:
+			case NvmeSelfTestResultType::AbortedNamespaceRemoved:
+			case NvmeSelfTestResultType::AbortedFormatNvmCommand:
+			case NvmeSelfTestResultType::AbortedUnknownReason:
+			case NvmeSelfTestResultType::AbortedSanitizeOperation:
+				break;
+		}
+		return false;
+	}
+
+
+	/// Check if a property is a failed latest self-test
+	bool is_selftest_failure(const StorageProperty& p)
+	{
+		if (p.generic_name == "ata_smart_data/self_test/status/_merged" && p.is_value_type<AtaStorageSelftestEntry>()) {
+			return is_ata_selftest_failure(p.get_value<AtaStorageSelftestEntry>().status);
+		}
+		if (p.is_value_type<NvmeStorageSelftestEntry>()) {
+			const auto& entry = p.get_value<NvmeStorageSelftestEntry>();
+			return entry.test_num == 1 && is_nvme_selftest_failure(entry.result);
+		}
+		return false;
+	}
+
+
+	/// Get the reallocated sector count, if \c p is that attribute
+	std::optional<std::int64_t> get_reallocated_count(const StorageProperty& p)
+	{
+		if (p.section == StoragePropertySection::AtaAttributes && p.generic_name == "attr_reallocated_sector_count"
+				&& p.is_value_type<AtaStorageAttribute>()) {
+			return p.get_value<AtaStorageAttribute>().raw_value_int;
+		}
+		return std::nullopt;
+	}
+
+
+	/// Run an alert delivery command. \return false on error.
+	bool alert_run_command(const std::string& command, const std::vector<std::string>& args)
+	{
+		CommandExecutor ex(command, args);
+		if (!ex.execute() || !ex.get_error_msg().empty()) {
+			debug_out_error("app", DBG_FUNC_MSG << "Alert delivery command \"" << command << "\" failed: " << ex.get_error_msg() << "\n");
+			return false;
+		}
+		return true;
+	}
+
+}
+
+
+
+std::vector<StorageAlertEvent> storage_alert_evaluate(const StoragePropertyDiff& diff,
+		const std::set<StorageAlertRule>& enabled_rules, const std::string& drive, std::int64_t time)
+{
+	std::vector<StorageAlertEvent> events;
+	auto add_event = [&](StorageAlertRule rule, std::string message) {
+		if (enabled_rules.count(rule) != 0) {
+			events.push_back({rule, drive, std::move(message), time});
+		}
+	};
+
+	for (const auto& change : diff.changes) {
+		if (!change.new_property.has_value()) {
+			continue;  // removed
+		}
+		const StorageProperty& p = change.new_property.value();
+
+		if (change.get_new_warning_level() == WarningLevel::Alert && change.get_old_warning_level() != WarningLevel::Alert) {
+			add_event(StorageAlertRule::WarningAlert, p.displayable_name + ": " + p.format_value()
+					+ (p.warning_reason.empty() ? std::string() : " (" + p.warning_reason + ")"));
+		}
+
+		if (change.old_property.has_value()) {
+			const auto old_count = get_reallocated_count(change.old_property.value());
+			const auto new_count = get_reallocated_count(p);
+			if (old_count.has_value() && new_count.has_value() && new_count.value() > old_count.value()) {
+				add_event(StorageAlertRule::ReallocatedIncrease, p.displayable_name + ": "
+						+ hz::number_to_string_nolocale(old_count.value()) + " -> " + hz::number_to_string_nolocale(new_count.value()));
+			}
+		}
+
+		// Any change to a failed state is a new failure (the old entry may have been a failure too).
+		if (is_selftest_failure(p)) {
+			add_event(StorageAlertRule::SelfTestFailure, p.displayable_name + ": " + p.format_value());
+		}
+	}
+
+	return events;
+}
+
+
+
+void StorageAlertDispatcher::set_rule_debounce(StorageAlertRule rule, std::int64_t seconds)
+{
+	const std::scoped_lock lock(mutex_);
+	rule_debounce_[rule] = seconds;
+}
+
+
+
+void StorageAlertDispatcher::set_drive_debounce(std::int64_t seconds)
+{
+	const std::scoped_lock lock(mutex_);
+	drive_debounce_ = seconds;
+}
+
+
+
+void StorageAlertDispatcher::set_batch_interval(std::int64_t seconds)
+{
+	const std::scoped_lock lock(mutex_);
+	batch_interval_ = seconds;
+}
+
+
+
+void StorageAlertDispatcher::set_max_batch_size(std::size_t size)
+{
+	const std::scoped_lock lock(mutex_);
+	max_batch_size_ = size;
+}
+
+
+
+bool StorageAlertDispatcher::add(StorageAlertEvent event)
+{
+	const std::scoped_lock lock(mutex_);
+
+	const auto rule_key = std::pair(event.drive, event.rule);
+	if (auto iter = last_rule_alert_.find(rule_key); iter != last_rule_alert_.end()) {
+		const auto debounce_iter = rule_debounce_.find(event.rule);
+		if (debounce_iter != rule_debounce_.end() && event.time - iter->second < debounce_iter->second) {
+			++dropped_count_;
+			return false;
+		}
+	}
+	if (auto iter = last_drive_alert_.find(event.drive); iter != last_drive_alert_.end()) {
+		// The alerts raised together (by the same refresh) are kept
+		if (event.time != iter->second && event.time - iter->second < drive_debounce_) {
+			++dropped_count_;
+			return false;
+		}
+	}
+
+	last_rule_alert_[rule_key] = event.time;
+	last_drive_alert_[event.drive] = event.time;
+	if (queue_.empty()) {
+		queue_start_time_ = event.time;
+	}
+	queue_.push_back(std::move(event));
+	return true;
+}
+
+
+
+std::vector<StorageAlertEvent> StorageAlertDispatcher::take_batch(std::int64_t now, bool force)
+{
+	const std::scoped_lock lock(mutex_);
+	const bool due = force || now - queue_start_time_ >= batch_interval_
+			|| (max_batch_size_ != 0 && queue_.size() >= max_batch_size_);
+	if (queue_.empty() || !due) {
+		return {};
+	}
+	return std::exchange(queue_, {});
+}
+
+
+
+std::size_t StorageAlertDispatcher::take_dropped_count()
+{
+	const std::scoped_lock lock(mutex_);
+	return std::exchange(dropped_count_, 0);
+}
+
+
+
+StorageAlertDelivery StorageAlertDelivery::get_from_config()
+{
+	StorageAlertDelivery delivery;
+	delivery.exec_hook = rconfig::get_data<std::string>("system/alert_exec_hook");
+	delivery.webhook_url = rconfig::get_data<std::string>("system/alert_webhook_url");
+	delivery.curl_binary = rconfig::get_data<std::string>("system/curl_binary");
+	delivery.syslog = rconfig::get_data<bool>("system/alert_syslog");
+	return delivery;
+}
+
+
+
+std::set<StorageAlertRule> storage_alert_configure(StorageAlertDispatcher& dispatcher)
+{
+	std::set<StorageAlertRule> rules;
+	std::vector<std::string> rule_names;
+	hz::string_split(rconfig::get_data<std::string>("system/alert_rules"), ';', rule_names, true);
+	for (const auto& name : rule_names) {
+		const auto rule = StorageAlertRuleExt::get_by_storable_name(name, StorageAlertRuleExt::default_value);
+		if (StorageAlertRuleExt::get_storable_name(rule) == name) {
+			rules.insert(rule);
+		} else {
+			debug_out_warn("app", DBG_FUNC_MSG << "Unknown alert rule \"" << name << "\", ignoring.\n");
+		}
+	}
+
+	const auto rule_debounce = static_cast<std::int64_t>(std::max(0, rconfig::get_data<int>("system/alert_rule_debounce_sec")));
+	for (const auto rule : rules) {
+		dispatcher.set_rule_debounce(rule, rule_debounce);
+	}
+	dispatcher.set_drive_debounce(std::max(0, rconfig::get_data<int>("system/alert_drive_debounce_sec")));
+	dispatcher.set_batch_interval(std::max(0, rconfig::get_data<int>("system/alert_batch_interval_sec")));
+	dispatcher.set_max_batch_size(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/alert_max_batch_size"))));
+	return rules;
+}
+
+
+
+std::string storage_alert_batch_to_json(const std::vector<StorageAlertEvent>& batch, std::size_t dropped_count)
+{
+	nlohmann::json alerts = nlohmann::json::array();
+	for (const auto& event : batch) {
+		alerts.push_back({
+			{"rule", StorageAlertRuleExt::get_storable_name(event.rule)},
+			{"drive", event.drive},
+			{"message", event.message},
+			{"time", event.time},
+		});
+	}
+	const nlohmann::json root = {
+		{"dropped", dropped_count},
+		{"alerts", std::move(alerts)},
+	};
+	return root.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+
+
+bool storage_alert_deliver(const StorageAlertDelivery& delivery, const std::vector<StorageAlertEvent>& batch, std::size_t dropped_count)
+{
+	if (batch.empty()) {
+		return true;
+	}
+	bool ok = true;
+
+	if (delivery.syslog) {
+		for (const auto& event : batch) {
+#ifndef _WIN32
+			::syslog(LOG_WARNING, "%s: %s", event.drive.c_str(), event.message.c_str());
+#else
+			debug_out_warn("app", "Alert: " << event.drive << ": " << event.message << "\n");
+#endif
+		}
+	}
+
+	if (!delivery.exec_hook.empty() || !delivery.webhook_url.empty()) {
+		const std::string json = storage_alert_batch_to_json(batch, dropped_count);
+		if (!delivery.exec_hook.empty()) {
+			ok = alert_run_command(delivery.exec_hook, {json}) && ok;
+		}
+		if (!delivery.webhook_url.empty()) {
+			ok = alert_run_command(delivery.curl_binary, {"--silent", "--show-error", "--fail", "--max-time", "30",
+					"--header", "Content-Type: application/json", "--data-binary", json, delivery.webhook_url}) && ok;
+		}
+	}
+
+	return ok;
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,160 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_ALERTS_H
+#define STORAGE_ALERTS_H
+
+#include <glibmm/i18n.h>
+#include <array>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hz/enum_helper.h"
+#include "storage_property_diff.h"
+
+
+
+/// Alert rule. The rules look at property changes only, so a drive which stays
+/// in a bad state doesn't raise the alert again.
+enum class StorageAlertRule {
+	WarningAlert,  ///< A property warning level became Alert (see StorageProperty::warning_level)
+	ReallocatedIncrease,  ///< The reallocated sector count increased
+	SelfTestFailure,  ///< A self-test failed
+};
+
+
+
+/// Helper structure for enum-related functions
+struct StorageAlertRuleExt
+		: public hz::EnumTableHelper<
+				StorageAlertRule,
+				StorageAlertRuleExt>
+{
+	static constexpr StorageAlertRule default_value = StorageAlertRule::WarningAlert;
+
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{StorageAlertRule::WarningAlert, "warning_alert", N_("Warning Level Raised to Alert")},
+		{StorageAlertRule::ReallocatedIncrease, "reallocated_increase", N_("Reallocated Sector Count Increased")},
+		{StorageAlertRule::SelfTestFailure, "selftest_failure", N_("Self-Test Failed")},
+	});
+
+};
+
+
+
+/// An alert raised for a drive
+struct StorageAlertEvent {
+	StorageAlertRule rule = StorageAlertRule::WarningAlert;  ///< Rule which raised the alert
+	std::string drive;  ///< Drive identification (e.g. serial number or device name)
+	std::string message;  ///< Displayable description
+	std::int64_t time = 0;  ///< When the alert was raised, seconds since epoch
+};
+
+
+
+/// Evaluate the alert rules of \c enabled_rules on the property changes of a drive.
+/// The diff must be relative to previously known properties; a diff from an empty
+/// repository (e.g. the first fetch) reports the existing problems as new.
+[[nodiscard]] std::vector<StorageAlertEvent> storage_alert_evaluate(const StoragePropertyDiff& diff,
+		const std::set<StorageAlertRule>& enabled_rules, const std::string& drive, std::int64_t time);
+
+
+
+/// Debounces the alerts and groups them into batches, so that a flapping value on many
+/// drives results in a few notifications rather than one per drive and refresh.
+/// All the functions are thread-safe.
+class StorageAlertDispatcher {
+	public:
+
+		/// Set the minimum interval between the alerts of the same rule on the same drive.
+		/// The alerts raised sooner are dropped. 0 (default) disables.
+		void set_rule_debounce(StorageAlertRule rule, std::int64_t seconds);
+
+		/// Set the minimum interval between the alerts of any rule on the same drive. The alerts
+		/// raised at the same time as the previous one are not affected. 0 (default) disables.
+		void set_drive_debounce(std::int64_t seconds);
+
+		/// Set how long the alerts are held so that they are delivered together. 0 (default) delivers them right away.
+		void set_batch_interval(std::int64_t seconds);
+
+		/// Set the number of alerts after which a batch is delivered without waiting. 0 (default) means unlimited.
+		void set_max_batch_size(std::size_t size);
+
+
+		/// Queue an alert unless it's debounced.
+		/// \return false if the alert was dropped.
+		bool add(StorageAlertEvent event);
+
+		/// Take the queued alerts if they are due for delivery at \c now (or \c force is true).
+		/// \return an empty vector if nothing is due.
+		[[nodiscard]] std::vector<StorageAlertEvent> take_batch(std::int64_t now, bool force = false);
+
+		/// Get the number of alerts dropped by debouncing, since the last call to this function.
+		[[nodiscard]] std::size_t take_dropped_count();
+
+
+	private:
+
+		mutable std::mutex mutex_;  ///< Protects the members below
+		std::map<StorageAlertRule, std::int64_t> rule_debounce_;  ///< Rule -> debounce interval
+		std::int64_t drive_debounce_ = 0;  ///< Debounce interval of each drive
+		std::int64_t batch_interval_ = 0;  ///< Batch interval
+		std::size_t max_batch_size_ = 0;  ///< Maximum batch size
+
+		std::map<std::pair<std::string, StorageAlertRule>, std::int64_t> last_rule_alert_;  ///< (drive, rule) -> time of the last alert
+		std::map<std::string, std::int64_t> last_drive_alert_;  ///< Drive -> time of the last alert
+		std::vector<StorageAlertEvent> queue_;  ///< Queued alerts
+		std::int64_t queue_start_time_ = 0;  ///< Time of the first queued alert
+		std::size_t dropped_count_ = 0;  ///< Number of dropped alerts
+
+};
+
+
+
+/// Alert delivery settings
+struct StorageAlertDelivery {
+	std::string exec_hook;  ///< Command to run with the JSON batch as its last argument. Empty to disable.
+	std::string webhook_url;  ///< URL to POST the JSON batch to (using curl). Empty to disable.
+	std::string curl_binary = "curl";  ///< curl binary for webhooks
+	bool syslog = false;  ///< Whether to log each alert to syslog (the debug output in Windows)
+
+	/// Load the settings from the config ("system/alert_*")
+	[[nodiscard]] static StorageAlertDelivery get_from_config();
+};
+
+
+
+/// Load the dispatcher settings and the enabled rules from the config ("system/alert_*").
+[[nodiscard]] std::set<StorageAlertRule> storage_alert_configure(StorageAlertDispatcher& dispatcher);
+
+
+/// Format a batch of alerts as JSON: {"dropped": N, "alerts": [{"rule", "drive", "message", "time"}, ...]}
+[[nodiscard]] std::string storage_alert_batch_to_json(const std::vector<StorageAlertEvent>& batch, std::size_t dropped_count);
+
+
+/// Deliver a batch of alerts with each enabled method. Each external command is run
+/// once per batch. This blocks until the commands exit.
+/// \return false if any of the methods failed (the errors are logged).
+bool storage_alert_deliver(const StorageAlertDelivery& delivery, const std::vector<StorageAlertEvent>& batch, std::size_t dropped_count);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,246 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+
+#include "storage_attribute_matrix.h"
+
+
+
+std::optional<std::int64_t> StorageAttributeMatrixColumn::get(std::size_t row, StorageAttributeMatrixField field) const
+{
+	switch (field) {
+		case StorageAttributeMatrixField::Raw:
+			return (flags[row] & HasRaw) ? std::optional(raw[row]) : std::nullopt;
+		case StorageAttributeMatrixField::Value:
+			return (flags[row] & HasValue) ? std::optional(value[row]) : std::nullopt;
+		case StorageAttributeMatrixField::Worst:
+			return (flags[row] & HasWorst) ? std::optional(worst[row]) : std::nullopt;
+	}
+	return std::nullopt;
+}
+
+
+
+std::vector<StorageAttributeMatrixCell> storage_attribute_matrix_make_cells(const StoragePropertyRepository& properties)
+{
+	std::vector<StorageAttributeMatrixCell> cells;
+	for (const auto& p : properties.get_properties()) {
+		if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()) {
+			const auto& attr = p.get_value<AtaStorageAttribute>();
+			StorageAttributeMatrixCell cell;
+			cell.column_key = "ata/" + std::to_string(attr.id);
+			cell.name = std::to_string(attr.id) + " " + p.displayable_name;
+			cell.raw = attr.raw_value_int;
+			if (attr.value.has_value()) {
+				cell.value = attr.value.value();
+			}
+			if (attr.worst.has_value()) {
+				cell.worst = attr.worst.value();
+			}
+			cells.push_back(std::move(cell));
+
+		} else if (p.section == StoragePropertySection::NvmeAttributes && p.is_value_type<std::int64_t>()) {
+			StorageAttributeMatrixCell cell;
+			cell.column_key = p.generic_name;
+			cell.name = p.displayable_name;
+			cell.raw = p.get_value<std::int64_t>();
+			cells.push_back(std::move(cell));
+		}
+	}
+	return cells;
+}
+
+
+
+bool StorageAttributeMatrix::update(const StorageDevice& drive)
+{
+	return update(&drive, storage_attribute_matrix_make_cells(drive.get_snapshot()->property_repository));
+}
+
+
+
+bool StorageAttributeMatrix::update(const StorageDevice* drive, const std::vector<StorageAttributeMatrixCell>& cells)
+{
+	auto [row_iter, inserted] = rows_.try_emplace(drive, row_drives_.size());
+	const std::size_t row = row_iter->second;
+	if (inserted) {
+		row_drives_.push_back(drive);
+		for (auto& column : columns_) {
+			column.raw.push_back(0);
+			column.value.push_back(0);
+			column.worst.push_back(0);
+			column.flags.push_back(0);
+		}
+	}
+
+	// Columns of the attributes which the drive doesn't have (anymore) are cleared
+	std::vector<std::uint8_t> seen(columns_.size(), 0);
+	bool changed = inserted;
+
+	for (const auto& cell : cells) {
+		auto [column_iter, column_inserted] = column_indices_.try_emplace(cell.column_key, columns_.size());
+		if (column_inserted) {
+			StorageAttributeMatrixColumn column;
+			column.key = cell.column_key;
+			column.name = cell.name;
+			column.raw.resize(row_drives_.size(), 0);
+			column.value.resize(row_drives_.size(), 0);
+			column.worst.resize(row_drives_.size(), 0);
+			column.flags.resize(row_drives_.size(), 0);
+			columns_.push_back(std::move(column));
+			seen.push_back(0);
+		}
+		const std::size_t column_index = column_iter->second;
+		seen[column_index] = 1;
+
+		auto& column = columns_[column_index];
+		const auto flags = static_cast<std::uint8_t>(StorageAttributeMatrixColumn::HasRaw
+				| (cell.value.has_value() ? StorageAttributeMatrixColumn::HasValue : 0)
+				| (cell.worst.has_value() ? StorageAttributeMatrixColumn::HasWorst : 0));
+		const std::int64_t value = cell.value.value_or(0), worst = cell.worst.value_or(0);
+		if (column.flags[row] != flags || column.raw[row] != cell.raw || column.value[row] != value || column.worst[row] != worst) {
+			column.flags[row] = flags;
+			column.raw[row] = cell.raw;
+			column.value[row] = value;
+			column.worst[row] = worst;
+			changed = true;
+		}
+	}
+
+	for (std::size_t i = 0; i < columns_.size(); ++i) {
+		if (!seen[i] && columns_[i].flags[row] != 0) {
+			columns_[i].flags[row] = 0;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+
+
+void StorageAttributeMatrix::remove(const StorageDevice* drive)
+{
+	auto row_iter = rows_.find(drive);
+	if (row_iter == rows_.end()) {
+		return;
+	}
+	const std::size_t row = row_iter->second;
+	const std::size_t last = row_drives_.size() - 1;
+	rows_.erase(row_iter);
+
+	if (row != last) {
+		row_drives_[row] = row_drives_[last];
+		rows_[row_drives_[row]] = row;
+		for (auto& column : columns_) {
+			column.raw[row] = column.raw[last];
+			column.value[row] = column.value[last];
+			column.worst[row] = column.worst[last];
+			column.flags[row] = column.flags[last];
+		}
+	}
+	row_drives_.pop_back();
+	for (auto& column : columns_) {
+		column.raw.pop_back();
+		column.value.pop_back();
+		column.worst.pop_back();
+		column.flags.pop_back();
+	}
+}
+
+
+
+void StorageAttributeMatrix::clear()
+{
+	row_drives_.clear();
+	rows_.clear();
+	columns_.clear();
+	column_indices_.clear();
+}
+
+
+
+std::size_t StorageAttributeMatrix::get_row_count() const
+{
+	return row_drives_.size();
+}
+
+
+
+const StorageDevice* StorageAttributeMatrix::get_row_drive(std::size_t row) const
+{
+	return row_drives_.at(row);
+}
+
+
+
+std::optional<std::size_t> StorageAttributeMatrix::find_row(const StorageDevice* drive) const
+{
+	if (auto iter = rows_.find(drive); iter != rows_.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+const std::vector<StorageAttributeMatrixColumn>& StorageAttributeMatrix::get_columns() const
+{
+	return columns_;
+}
+
+
+
+std::optional<std::size_t> StorageAttributeMatrix::find_column(const std::string& key) const
+{
+	if (auto iter = column_indices_.find(key); iter != column_indices_.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+std::vector<std::size_t> StorageAttributeMatrix::filter_rows(std::size_t column, StorageAttributeMatrixField field,
+		std::int64_t min_value, std::int64_t max_value) const
+{
+	const auto& col = columns_.at(column);
+	std::vector<std::size_t> rows;
+	for (std::size_t row = 0; row < row_drives_.size(); ++row) {
+		const auto value = col.get(row, field);
+		if (value.has_value() && value.value() >= min_value && value.value() <= max_value) {
+			rows.push_back(row);
+		}
+	}
+	return rows;
+}
+
+
+
+void StorageAttributeMatrix::sort_rows(std::vector<std::size_t>& rows, std::size_t column,
+		StorageAttributeMatrixField field, bool descending) const
+{
+	const auto& col = columns_.at(column);
+	std::stable_sort(rows.begin(), rows.end(), [&col, field, descending](std::size_t a, std::size_t b) {
+		const auto value_a = col.get(a, field), value_b = col.get(b, field);
+		if (!value_a.has_value() || !value_b.has_value()) {
+			return value_a.has_value() && !value_b.has_value();
+		}
+		return descending ? (value_a.value() > value_b.value()) : (value_a.value() < value_b.value());
+	});
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,138 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_ATTRIBUTE_MATRIX_H
+#define STORAGE_ATTRIBUTE_MATRIX_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "storage_device.h"
+#include "storage_property_repository.h"
+
+
+
+/// Value of an attribute matrix cell
+enum class StorageAttributeMatrixField {
+	Raw,  ///< Raw value (ATA attributes), or the counter value (NVMe health counters)
+	Value,  ///< Normalized value (ATA attributes only)
+	Worst,  ///< Worst normalized value (ATA attributes only)
+};
+
+
+
+/// Attribute of a drive, as stored in an attribute matrix cell
+struct StorageAttributeMatrixCell {
+	std::string column_key;  ///< Column key, see storage_attribute_matrix_make_cells()
+	std::string name;  ///< Displayable attribute name
+	std::int64_t raw = 0;  ///< Raw value
+	std::optional<std::int64_t> value;  ///< Normalized value
+	std::optional<std::int64_t> worst;  ///< Worst normalized value
+
+	/// Comparison
+	bool operator==(const StorageAttributeMatrixCell& other) const = default;
+};
+
+
+
+/// A column of the attribute matrix. The values of all the drives (rows) are kept
+/// in contiguous arrays, so that sorting and filtering by a column only touches its arrays.
+struct StorageAttributeMatrixColumn {
+	/// Cell flags
+	enum Flags : std::uint8_t {
+		HasRaw = 1 << 0,  ///< The drive has this attribute
+		HasValue = 1 << 1,  ///< The normalized value is known
+		HasWorst = 1 << 2,  ///< The worst value is known
+	};
+
+	std::string key;  ///< Column key
+	std::string name;  ///< Displayable attribute name
+	std::vector<std::int64_t> raw;  ///< Raw values, by row
+	std::vector<std::int64_t> value;  ///< Normalized values, by row
+	std::vector<std::int64_t> worst;  ///< Worst values, by row
+	std::vector<std::uint8_t> flags;  ///< Flags, by row
+
+	/// Get the cell value of a row. \return std::nullopt if the row doesn't have it.
+	[[nodiscard]] std::optional<std::int64_t> get(std::size_t row, StorageAttributeMatrixField field) const;
+};
+
+
+
+/// Get the attribute cells of a drive from its properties: ATA attributes
+/// (column keys "ata/<id>") and NVMe health counters (column key is the property generic name).
+[[nodiscard]] std::vector<StorageAttributeMatrixCell> storage_attribute_matrix_make_cells(const StoragePropertyRepository& properties);
+
+
+
+/// Attributes of many drives for side-by-side comparison: rows are drives, columns are
+/// attributes. Updated one drive at a time (when it changes).
+class StorageAttributeMatrix {
+	public:
+
+		/// Add or update the row of a drive. \return true if the row changed.
+		bool update(const StorageDevice& drive);
+
+		/// Add or update the row of a drive. \return true if the row changed.
+		bool update(const StorageDevice* drive, const std::vector<StorageAttributeMatrixCell>& cells);
+
+		/// Remove the row of a drive. The last row takes its place.
+		void remove(const StorageDevice* drive);
+
+		/// Remove all rows and columns
+		void clear();
+
+
+		/// Get the number of rows
+		[[nodiscard]] std::size_t get_row_count() const;
+
+		/// Get the drive of a row
+		[[nodiscard]] const StorageDevice* get_row_drive(std::size_t row) const;
+
+		/// Find the row of a drive
+		[[nodiscard]] std::optional<std::size_t> find_row(const StorageDevice* drive) const;
+
+
+		/// Get the columns, in the order of their appearance
+		[[nodiscard]] const std::vector<StorageAttributeMatrixColumn>& get_columns() const;
+
+		/// Find a column by its key
+		[[nodiscard]] std::optional<std::size_t> find_column(const std::string& key) const;
+
+
+		/// Get the rows which have the field of a column in [min_value, max_value], in row order
+		[[nodiscard]] std::vector<std::size_t> filter_rows(std::size_t column, StorageAttributeMatrixField field,
+				std::int64_t min_value, std::int64_t max_value) const;
+
+		/// Sort \c rows by the field of a column. The rows without a value go last, the order of equal ones is kept.
+		void sort_rows(std::vector<std::size_t>& rows, std::size_t column, StorageAttributeMatrixField field, bool descending) const;
+
+
+	private:
+
+		std::vector<const StorageDevice*> row_drives_;  ///< Drives of the rows
+		std::unordered_map<const StorageDevice*, std::size_t> rows_;  ///< Row of each drive
+		std::vector<StorageAttributeMatrixColumn> columns_;  ///< Columns
+		std::unordered_map<std::string, std::size_t> column_indices_;  ///< Column of each key
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,211 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glib.h>
+#include <glibmm/i18n.h>
+#include <memory>
+#include <mutex>
+
+#include "hz/debug.h"
+
+#include "worker_threads.h"
+#include "storage_bulk_operation.h"
+#include "storage_output_compression.h"
+
+
+
+namespace {
+
+	/// Finished drives of a bulk operation, reported to the calling thread
+	struct StorageBulkProgress {
+		std::mutex mutex;  ///< Protects finished
+		std::vector<std::size_t> finished;  ///< Drive indices
+		std::function<void(std::size_t drive_index)> report;  ///< Calling thread only, reset when the operation is over
+	};
+
+
+	/// Report the finished drives. Called in the calling thread of storage_bulk_run().
+	void storage_bulk_report_progress(StorageBulkProgress& progress)
+	{
+		std::vector<std::size_t> finished;
+		{
+			const std::scoped_lock lock(progress.mutex);
+			finished.swap(progress.finished);
+		}
+		if (progress.report) {
+			for (const std::size_t drive_index : finished) {
+				progress.report(drive_index);
+			}
+		}
+	}
+
+
+	/// Run the operation on a drive. Called from a worker thread.
+	/// \return An error message, empty on success.
+	std::string storage_bulk_run_on_drive(StorageBulkOperation operation, StorageDevice& drive,
+			const CommandExecutorFactoryPtr& worker_factory, const hz::fs::path& output_dir)
+	{
+		std::shared_ptr<CommandExecutor> smartctl_ex;
+		if (!drive.get_is_virtual()) {
+			smartctl_ex = worker_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+			smartctl_ex->set_priority(CommandPriority::Bulk);
+		}
+
+		switch (operation) {
+			case StorageBulkOperation::EnableSmart:
+				if (auto status = drive.set_smart_enabled(true, smartctl_ex); !status) {
+					return status.error().message();
+				}
+				if (auto status = drive.fetch_basic_data_and_parse(smartctl_ex); !status) {
+					return status.error().message();
+				}
+				break;
+
+			case StorageBulkOperation::Refresh:
+				if (auto status = drive.fetch_basic_data_and_parse(smartctl_ex); !status) {
+					return status.error().message();
+				}
+				break;
+
+			case StorageBulkOperation::SaveOutput:
+			{
+				if (drive.get_full_output().empty() && !drive.get_is_virtual()) {
+					if (auto status = drive.fetch_full_data_and_parse(smartctl_ex); !status) {
+						return status.error().message();
+					}
+				}
+				const std::string& output = drive.get_full_output().empty() ? drive.get_basic_output() : drive.get_full_output();
+				// Compressed if the filename format ends with ".gz"
+				if (auto status = storage_output_save(output_dir / hz::fs_path_from_string(drive.get_save_filename()), output); !status) {
+					return status.error().message();
+				}
+				break;
+			}
+		}
+		return {};
+	}
+
+}
+
+
+
+std::string storage_bulk_get_displayable_name(StorageBulkOperation operation)
+{
+	switch (operation) {
+		case StorageBulkOperation::EnableSmart: return _("Enable SMART");
+		case StorageBulkOperation::Refresh: return _("Re-read Data");
+		case StorageBulkOperation::SaveOutput: return _("Save Smartctl Output");
+	}
+	return {};
+}
+
+
+
+bool storage_bulk_get_is_applicable(StorageBulkOperation operation, const StorageDevice& drive)
+{
+	if (drive.get_test_is_active() || drive.get_fetch_in_progress()) {
+		return false;
+	}
+	switch (operation) {
+		case StorageBulkOperation::EnableSmart:
+			return !drive.get_is_virtual() && drive.get_smart_switch_supported()
+					&& drive.get_smart_status() == StorageDevice::SmartStatus::Disabled;
+		case StorageBulkOperation::Refresh:
+			return !drive.get_is_virtual();
+		case StorageBulkOperation::SaveOutput:
+			return !drive.get_basic_output().empty() || !drive.get_is_virtual();
+	}
+	return false;
+}
+
+
+
+std::vector<StorageBulkResult> storage_bulk_run(StorageBulkOperation operation,
+		const std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory,
+		std::size_t max_parallel, const hz::fs::path& output_dir, const StorageBulkProgressSlot& progress_slot)
+{
+	std::vector<StorageBulkResult> results(drives.size());
+	std::vector<std::size_t> applicable;
+	for (std::size_t i = 0; i < drives.size(); ++i) {
+		results[i].drive = drives[i];
+		results[i].skipped = !drives[i] || !storage_bulk_get_is_applicable(operation, *drives[i]);
+		if (!results[i].skipped) {
+			applicable.push_back(i);
+		}
+	}
+
+	debug_out_info("app", DBG_FUNC_MSG << storage_bulk_get_displayable_name(operation) << ": " << applicable.size()
+			<< " of " << drives.size() << " drives, using up to " << max_parallel << " threads...\n");
+
+	// GUI executors show dialogs, so they can't be used outside the main thread.
+	const CommandExecutorFactoryPtr worker_factory = command_executor_factory_for_worker_threads(ex_factory);
+
+	// Each drive is handed back to the calling thread as soon as its worker is done with it.
+	// Until then, its signal_changed() is suppressed (see StorageDevice::begin_worker_fetch()).
+	GMainContext* context = g_main_context_get_thread_default();
+	if (!context) {
+		context = g_main_context_default();
+	}
+	std::size_t num_finished = 0;
+	auto progress = std::make_shared<StorageBulkProgress>();
+	progress->report = [&](std::size_t drive_index) {
+		drives[drive_index]->end_worker_fetch();
+		++num_finished;
+		if (progress_slot) {
+			progress_slot(num_finished, applicable.size());
+		}
+	};
+	for (const std::size_t i : applicable) {
+		drives[i]->begin_worker_fetch();
+	}
+
+	app_run_worker_tasks(applicable.size(), max_parallel, [&](std::size_t task_index) {
+		const std::size_t i = applicable[task_index];
+		results[i].error = storage_bulk_run_on_drive(operation, *drives[i], worker_factory, output_dir);
+
+		{
+			const std::scoped_lock lock(progress->mutex);
+			progress->finished.push_back(i);
+		}
+		g_main_context_invoke_full(context, G_PRIORITY_DEFAULT, [](gpointer data) -> gboolean {
+			storage_bulk_report_progress(*static_cast<std::shared_ptr<StorageBulkProgress>*>(data)->get());
+			return FALSE;
+		}, new std::shared_ptr<StorageBulkProgress>(progress), [](gpointer data) {
+			delete static_cast<std::shared_ptr<StorageBulkProgress>*>(data);
+		});
+	});
+
+	// The workers are done, report the drives whose callbacks weren't dispatched yet.
+	storage_bulk_report_progress(*progress);
+	progress->report = nullptr;
+
+	return results;
+}
+
+
+
+std::string storage_bulk_format_errors(const std::vector<StorageBulkResult>& results)
+{
+	std::string errors;
+	for (const auto& result : results) {
+		if (result.error.empty()) {
+			continue;
+		}
+		const std::string device = result.drive ? result.drive->get_device_with_type() : std::string();
+		errors += device + ": " + result.error + "\n";
+	}
+	return errors;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,79 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_BULK_OPERATION_H
+#define STORAGE_BULK_OPERATION_H
+
+#include <cstddef>  // std::size_t
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "hz/fs.h"
+
+#include "command_executor_factory.h"
+#include "storage_device.h"
+
+
+
+/// An operation run on many drives by storage_bulk_run()
+enum class StorageBulkOperation {
+	EnableSmart,  ///< Enable SMART and re-read the basic data
+	Refresh,  ///< Re-read the basic data
+	SaveOutput,  ///< Save the full smartctl output (fetching it if needed) to a directory
+};
+
+
+
+/// Result of a bulk operation on one drive
+struct StorageBulkResult {
+	StorageDevicePtr drive;  ///< The drive
+	bool skipped = false;  ///< The operation was not applicable to the drive (see storage_bulk_get_is_applicable())
+	std::string error;  ///< Error message, empty on success
+};
+
+
+
+/// Progress callback of storage_bulk_run(): the number of finished drives and the total number of drives
+using StorageBulkProgressSlot = std::function<void(std::size_t finished, std::size_t total)>;
+
+
+
+/// Get the displayable name of an operation (e.g. "Enable SMART")
+[[nodiscard]] std::string storage_bulk_get_displayable_name(StorageBulkOperation operation);
+
+
+/// Check whether an operation can be run on a drive. The drives being tested are never applicable,
+/// the virtual ones only for SaveOutput.
+[[nodiscard]] bool storage_bulk_get_is_applicable(StorageBulkOperation operation, const StorageDevice& drive);
+
+
+/// Run an operation on the drives concurrently, with up to \c max_parallel drives at the same time.
+/// The drives are processed in worker threads with non-GUI executors (see app_run_worker_tasks()),
+/// while the calling thread's main context keeps being iterated. Each drive's signal_changed()
+/// and \c progress_slot are called from the calling thread as soon as the drive is done.
+/// \c output_dir is used by SaveOutput only.
+/// \return The results, in the order of \c drives.
+[[nodiscard]] std::vector<StorageBulkResult> storage_bulk_run(StorageBulkOperation operation,
+		const std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory,
+		std::size_t max_parallel, const hz::fs::path& output_dir, const StorageBulkProgressSlot& progress_slot);
+
+
+/// Format the errors of the results (one line per failed drive), for a single error dialog.
+/// \return An empty string if there are no errors.
+[[nodiscard]] std::string storage_bulk_format_errors(const std::vector<StorageBulkResult>& results);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,113 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "storage_columnar_export.h"
+#include "storage_device.h"
+
+
+
+StorageColumnarExport::StorageColumnarExport(std::ostream& values, std::ostream& drives, std::ostream& models)
+		: values_(values), drives_(drives), models_(models)
+{
+	values_ << "drive_id,model_id,time,attribute,value\n";
+	drives_ << "drive_id,serial,model_id\n";
+	models_ << "model_id,model\n";
+}
+
+
+
+void StorageColumnarExport::add_values(const std::string& serial, const std::string& model, std::int64_t time,
+		const StorageHistoryValues& values)
+{
+	const auto [drive_id, model_id] = get_drive_ids(serial, model);
+	const std::string prefix = std::to_string(drive_id) + "," + std::to_string(model_id) + "," + std::to_string(time) + ",";
+	for (const auto& [key, value] : values) {
+		values_ << prefix << quote(key) << ',' << value << '\n';
+	}
+	row_count_ += values.size();
+}
+
+
+
+void StorageColumnarExport::add_drive(const StorageDevice& drive, std::int64_t time)
+{
+	const std::string serial = drive.get_serial_number();
+	if (!serial.empty()) {
+		add_values(serial, drive.get_model_name(), time, StorageHistory::get_values_from_properties(drive.get_property_repository()));
+	}
+}
+
+
+
+void StorageColumnarExport::add_history(const StorageHistory& history)
+{
+	// The points come grouped by drive, don't look it up for each one
+	const std::string* last_serial = nullptr;
+	std::string prefix;
+	history.for_each_point([&](const std::string& serial, const std::string& key, const StorageHistoryPoint& point) {
+		if (last_serial != &serial) {
+			const auto [drive_id, model_id] = get_drive_ids(serial, std::string());
+			prefix = std::to_string(drive_id) + "," + std::to_string(model_id) + ",";
+			last_serial = &serial;
+		}
+		values_ << prefix << point.time << ',' << quote(key) << ',' << point.value << '\n';
+		++row_count_;
+	});
+}
+
+
+
+std::size_t StorageColumnarExport::get_row_count() const
+{
+	return row_count_;
+}
+
+
+
+std::string StorageColumnarExport::quote(const std::string& field)
+{
+	if (field.find_first_of(",\"\r\n") == std::string::npos) {
+		return field;
+	}
+	std::string quoted = "\"";
+	for (const char c : field) {
+		if (c == '"') {
+			quoted += '"';
+		}
+		quoted += c;
+	}
+	return quoted + '"';
+}
+
+
+
+std::pair<std::size_t, std::size_t> StorageColumnarExport::get_drive_ids(const std::string& serial, const std::string& model)
+{
+	if (auto iter = drive_ids_.find(serial); iter != drive_ids_.end()) {
+		return iter->second;
+	}
+
+	auto [model_iter, model_inserted] = model_ids_.try_emplace(model, model_ids_.size());
+	if (model_inserted) {
+		models_ << model_iter->second << ',' << quote(model) << '\n';
+	}
+	const auto ids = std::pair(drive_ids_.size(), model_iter->second);
+	drive_ids_.emplace(serial, ids);
+	drives_ << ids.first << ',' << quote(serial) << ',' << ids.second << '\n';
+	return ids;
+}
+
+
+
+
+
+
+/// @}
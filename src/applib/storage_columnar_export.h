@@ -0,0 +1,89 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_COLUMNAR_EXPORT_H
+#define STORAGE_COLUMNAR_EXPORT_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "storage_history.h"
+
+
+class StorageDevice;
+
+
+
+/// Writes the attribute values of many drives as CSV tables for bulk analytics:
+///
+/// values: drive_id,model_id,time,attribute,value (one row per drive, time and attribute);
+/// drives: drive_id,serial,model_id;
+/// models: model_id,model.
+///
+/// The drive and model columns of the values table are dictionary-encoded: they contain
+/// the IDs from the drives and models tables. The rows are written to the streams as they
+/// are added, so only the dictionaries are kept in memory.
+class StorageColumnarExport {
+	public:
+
+		/// Constructor. The headers are written right away.
+		StorageColumnarExport(std::ostream& values, std::ostream& drives, std::ostream& models);
+
+
+		/// Add the values of a drive at \c time (seconds since epoch).
+		/// The model of a drive is taken from its first row.
+		void add_values(const std::string& serial, const std::string& model, std::int64_t time, const StorageHistoryValues& values);
+
+
+		/// Add the current values of a drive (see StorageHistory::get_values_from_properties()).
+		/// The drives without a serial number are ignored.
+		void add_drive(const StorageDevice& drive, std::int64_t time);
+
+
+		/// Add all the samples of a history store. The history contains only the changes,
+		/// so a row means the value was in effect from that time on. The models of
+		/// the drives which weren't added before are empty.
+		void add_history(const StorageHistory& history);
+
+
+		/// Get the number of rows written to the values table
+		[[nodiscard]] std::size_t get_row_count() const;
+
+
+		/// Quote a CSV field if needed (RFC 4180)
+		[[nodiscard]] static std::string quote(const std::string& field);
+
+
+	private:
+
+		/// Get the ID of a drive, adding it to the dictionaries if needed
+		std::pair<std::size_t, std::size_t> get_drive_ids(const std::string& serial, const std::string& model);
+
+
+		std::ostream& values_;  ///< Values table
+		std::ostream& drives_;  ///< Drives table
+		std::ostream& models_;  ///< Models table
+
+		std::unordered_map<std::string, std::pair<std::size_t, std::size_t>> drive_ids_;  ///< Serial -> (drive ID, model ID)
+		std::unordered_map<std::string, std::size_t> model_ids_;  ///< Model -> model ID
+		std::size_t row_count_ = 0;  ///< Number of values rows
+
+};
+
+
+
+
+#endif
+
+/// @}
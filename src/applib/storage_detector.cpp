@@ -9,18 +9,32 @@ Copyright:
 /// \weakgroup applib
 /// @{
 
-#include <glibmm.h>
-#include <gtkmm.h>  // compose()
+#include <glibmm.h>  // compose()
+#include <glibmm/i18n.h>
 #include <algorithm>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
 
 #include "build_config.h"
 
 #include "hz/debug.h"
+#include "rconfig/rconfig.h"
 
 #include "app_regex.h"
+#include "app_trace.h"
+#include "command_executor_remote.h"
 #include "smartctl_executor.h"
 #include "storage_detector.h"
+#include "storage_detector_dedup.h"
+#include "storage_detector_scan_open.h"
+#include "storage_device_type_cache.h"
+#include "storage_drive_identity.h"
+#include "storage_fetch_order.h"
+#include "storage_io_load.h"
+#include "storage_privileged_helper.h"
+#include "worker_threads.h"
 
 #include "storage_detector_linux.h"
 #include "storage_detector_win32.h"
@@ -28,17 +42,142 @@ Copyright:
 
 
 
+namespace {
+
+	/// Detect the drives of the remote hosts (see remote_hosts_get_configured()) with
+	/// "smartctl --scan-open". Each host has its own SSH connection, so several hosts are
+	/// queried at once. The hosts which fail are skipped (with a warning).
+	void detect_drives_remote(const std::vector<RemoteHostPtr>& hosts, std::vector<StorageDevicePtr>& drives,
+			const CommandExecutorFactoryPtr& ex_factory)
+	{
+		const auto max_parallel = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/remote_max_parallel_hosts")));
+		std::vector<std::vector<StorageDevicePtr>> host_drives(hosts.size());
+
+		app_run_worker_tasks(hosts.size(), max_parallel, [&](std::size_t i) {
+			// Non-GUI executors, these may run in worker threads
+			auto host_factory = std::make_shared<CommandExecutorFactory>();
+			host_factory->set_pooled(ex_factory->get_pooled());
+			host_factory->set_remote_host(hosts[i]);
+			host_factory->set_cancellation(ex_factory->get_cancellation());
+
+			if (auto status = detect_drives_scan_open(host_drives[i], host_factory); !status) {
+				debug_out_warn("app", DBG_FUNC_MSG << "Cannot detect drives on " << hosts[i]->get_destination()
+						<< ": " << status.error().message() << "\n");
+			}
+			for (const auto& drive : host_drives[i]) {
+				drive->set_remote_host(hosts[i]);
+			}
+		});
+
+		for (auto& list : host_drives) {
+			drives.insert(drives.end(), list.begin(), list.end());
+		}
+	}
+
+
+	/// How long to wait for a busy drive before querying it anyway (see StorageIoLoadGuard)
+	std::chrono::seconds get_io_load_max_wait()
+	{
+		return std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/io_load_scan_max_wait_sec")));
+	}
+
+
+	/// Fetch the data of a drive during the scan: the basic data, all of it with a single
+	/// smartctl run if \c fetch_full is set ("system/scan_fetch_full_data"), or the identity
+	/// only if \c identity_only is set ("system/scan_identity_probe").
+	/// The drive is registered in the drive identity registry, since it may have moved since the last scan.
+	hz::ExpectedVoid<StorageDeviceError> fetch_drive_scan_data(StorageDevice& drive,
+			const std::shared_ptr<CommandExecutor>& smartctl_ex, bool fetch_full, bool identity_only)
+	{
+		hz::ExpectedVoid<StorageDeviceError> status;
+		if (fetch_full) {
+			status = drive.fetch_all_data_and_parse(smartctl_ex);
+		} else if (identity_only) {
+			status = drive.fetch_identity_and_parse(smartctl_ex);
+		} else {
+			status = drive.fetch_basic_data_and_parse(smartctl_ex);
+		}
+		if (status) {
+			storage_drive_identity_update(drive);
+		}
+		return status;
+	}
+
+
+	/// Get the fetch latency key of a drive: its ID if it was registered by this or
+	/// a previous scan (so that the latency follows the drive), or its device.
+	std::string get_fetch_latency_key(const StorageDevice& drive)
+	{
+		return storage_drive_identity_find_at(storage_drive_identity_get_location(drive)).value_or(drive.get_device_with_type());
+	}
+
+
+	/// Error returned by the detector functions when the scan is cancelled
+	hz::ExpectedVoid<StorageDetectorError> get_cancelled_error(const AppCancellationPtr& cancellation)
+	{
+		if (cancellation && cancellation->get_deadline_passed()) {
+			return hz::Unexpected(StorageDetectorError::Cancelled, _("The scan did not finish in time, the results may be incomplete."));
+		}
+		return hz::Unexpected(StorageDetectorError::Cancelled, _("The scan was cancelled."));
+	}
+
+
+	/// Drives finished by the worker threads of a parallel fetch, which are yet to be reported
+	/// in the calling thread.
+	struct StorageDetectorFetchProgress {
+		std::mutex mutex;  ///< Protects finished
+		std::vector<std::size_t> finished;  ///< Drive indices
+		std::function<void(std::size_t drive_index)> report;  ///< Calling thread only, reset when the fetch is over
+	};
+
+
+	/// Report the finished drives. Called in the calling thread of the parallel fetch.
+	void storage_detector_report_fetch_progress(StorageDetectorFetchProgress& progress)
+	{
+		std::vector<std::size_t> finished;
+		{
+			const std::scoped_lock lock(progress.mutex);
+			finished.swap(progress.finished);
+		}
+		if (progress.report) {
+			for (const std::size_t drive_index : finished) {
+				progress.report(drive_index);
+			}
+		}
+	}
+
+}
+
+
 
 hz::ExpectedVoid<StorageDetectorError> StorageDetector::detect(std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
 {
+	const AppTraceSpan trace_span("StorageDetector::detect", "detector");
 	debug_out_info("app", DBG_FUNC_MSG << "Starting drive detection.\n");
 
 	std::vector<StorageDevicePtr> all_detected;
 	hz::ExpectedVoid<StorageDetectorError> detect_status;
 
+	// The privileged helper has detected the local drives already, and has their data cached.
+	bool detected_by_helper = false;
+	if (const auto helper = storage_privileged_helper_get_global()) {
+		auto helper_drives = storage_privileged_helper_load_drives(*helper);
+		if (helper_drives) {
+			debug_out_info("app", DBG_FUNC_MSG << "Got " << helper_drives->size() << " drives from the privileged helper.\n");
+			all_detected = std::move(helper_drives.value());
+			detected_by_helper = true;
+		} else {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot get the drives from the privileged helper, detecting them directly: "
+					<< helper_drives.error().message() << "\n");
+		}
+	}
+
 	// Try each one and move to next if it fails.
 
-	if constexpr(BuildEnv::is_kernel_linux()) {
+	if (detected_by_helper) {
+		// Nothing to do
+
+	} else if constexpr(BuildEnv::is_kernel_linux()) {
 		detect_status = detect_drives_linux(all_detected, ex_factory);  // linux /proc/partitions as fallback.
 
 	} else if constexpr(BuildEnv::is_kernel_family_windows()) {
@@ -48,7 +187,16 @@ hz::ExpectedVoid<StorageDetectorError> StorageDetector::detect(std::vector<Stora
 		detect_status = detect_drives_other(all_detected, ex_factory);  // bsd, etc. . scans /dev.
 	}
 
+	const AppCancellationPtr cancellation = ex_factory->get_cancellation();
+
+	if (const auto remote_hosts = remote_hosts_get_configured(); !remote_hosts.empty() && !app_is_cancelled(cancellation)) {
+		detect_drives_remote(remote_hosts, all_detected, ex_factory);
+	}
+
 	if (all_detected.empty()) {
+		if (app_is_cancelled(cancellation)) {
+			return get_cancelled_error(cancellation);
+		}
 		debug_out_warn("app", DBG_FUNC_MSG << "Cannot detect drives: None of the drive detection methods returned any drives.\n");
 		return detect_status;
 	}
@@ -61,13 +209,7 @@ hz::ExpectedVoid<StorageDetectorError> StorageDetector::detect(std::vector<Stora
 // 				continue;
 
 			// matched, check the blacklist
-			bool blacked = false;
-			for (const auto& blacklist_pattern : blacklist_patterns_) {
-				if (app_regex_partial_match(blacklist_pattern, drive->get_device())) {  // matched the blacklist too
-					blacked = true;
-					break;
-				}
-			}
+			const bool blacked = is_blacklisted(drive->get_device());
 
 			debug_out_info("app", "Found device: " << drive->get_device_with_type() << ".\n");
 
@@ -77,30 +219,114 @@ hz::ExpectedVoid<StorageDetectorError> StorageDetector::detect(std::vector<Stora
 
 			} else {  // blacklisted
 				debug_out_info("app", "Device " << drive->get_device_with_type() << " is blacklisted, ignoring.\n");
+				blacklisted_drives_.push_back(drive);
 // 				break;  // go to next device
 			}
 // 		}
 	}
 
+	// Drop the aliases before sorting, so that the drives found by the preferred detectors are kept.
+	storage_detector_remove_aliases(drives);
+
 	// Sort the drives, because their order is not quite defined.
 	// TODO Sort using natural sort
 	std::sort(drives.begin(), drives.end());
 
+	if (drive_callback_) {
+		for (const auto& drive : drives) {
+			drive_callback_(drive, DriveStage::Detected);
+		}
+	}
+
+	if (app_is_cancelled(cancellation)) {
+		debug_out_info("app", DBG_FUNC_MSG << "Drive detection cancelled, " << drives.size() << " drives found so far.\n");
+		return get_cancelled_error(cancellation);
+	}
+
 	debug_out_info("app", DBG_FUNC_MSG << "Drive detection finished.\n");
 	return {};
 }
 
 
 
+void StorageDetector::add_blacklist_patterns(const std::vector<std::string>& patterns)
+{
+	for (const auto& pattern : patterns) {
+		try {
+			blacklist_res_.push_back(app_regex_re(pattern));
+		}
+		catch (std::regex_error& e) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Invalid blacklist pattern \"" << pattern << "\": " << e.what() << "\n");
+		}
+	}
+}
+
+
+
+bool StorageDetector::is_blacklisted(const std::string& device) const
+{
+	return std::any_of(blacklist_res_.cbegin(), blacklist_res_.cend(),
+			[&device](const std::regex& re) { return app_regex_partial_match(re, device); });
+}
+
+
+
 hz::ExpectedVoid<StorageDetectorError> StorageDetector::fetch_basic_data(std::vector<StorageDevicePtr>& drives,
 		const CommandExecutorFactoryPtr& ex_factory, bool return_first_error)
 {
 	fetch_data_errors_.clear();
 	fetch_data_error_outputs_.clear();
 
+	if (rconfig::get_data<bool>("system/scan_fetch_full_data")) {
+		return fetch_stage(drives, ex_factory, return_first_error, FetchStage::Full);
+	}
+	if (!rconfig::get_data<bool>("system/scan_identity_probe")) {
+		return fetch_stage(drives, ex_factory, return_first_error, FetchStage::Basic);
+	}
+
+	// The drives can be shown as soon as their identity is known, the rest takes longer
+	if (auto identity_status = fetch_stage(drives, ex_factory, return_first_error, FetchStage::Identity);
+			!identity_status && return_first_error) {
+		return identity_status;
+	}
+	return fetch_stage(drives, ex_factory, return_first_error, FetchStage::Rest);
+}
+
+
+
+bool StorageDetector::get_drive_needs_stage(const StorageDevice& drive, FetchStage stage)
+{
+	if (stage == FetchStage::Rest) {
+		return drive.get_basic_data_identity_only();
+	}
+	return drive.get_basic_output().empty();
+}
+
+
+
+hz::ExpectedVoid<StorageDetectorError> StorageDetector::fetch_stage(std::vector<StorageDevicePtr>& drives,
+		const CommandExecutorFactoryPtr& ex_factory, bool return_first_error, FetchStage stage)
+{
+	if (max_parallel_fetches_ > 1 && drives.size() > 1) {
+		return fetch_stage_parallel(drives, ex_factory, return_first_error, stage);
+	}
+
 	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+	if (stage == FetchStage::Rest) {  // don't hold up the user's commands
+		smartctl_ex->set_priority(CommandPriority::BackgroundRefresh);
+	}
+	const AppCancellationPtr cancellation = ex_factory->get_cancellation();
+
+	const auto io_load_guard = storage_io_load_guard_get_global();
+	const auto io_load_max_wait = get_io_load_max_wait();
+	const bool fetch_full = (stage == FetchStage::Full);
+	const bool identity_only = (stage == FetchStage::Identity);
+	const DriveStage reported_stage = identity_only ? DriveStage::Identified : DriveStage::Fetched;
 
-	for (auto& drive : drives) {
+	StorageFetchLatencies measured_latencies;
+
+	for (const std::size_t drive_index : get_fetch_order(drives)) {
+		const auto& drive = drives[drive_index];
 		debug_out_info("app", "Retrieving basic information about the device...\n");
 
 		smartctl_ex->set_running_msg(Glib::ustring::compose(_("Running {command} on %1..."), drive->get_device_with_type()));
@@ -109,12 +335,27 @@ hz::ExpectedVoid<StorageDetectorError> StorageDetector::fetch_basic_data(std::ve
 		// no need for gui-based executors here, we already show the message in
 		// iconview background (if called from main window)
 		hz::ExpectedVoid<StorageDeviceError> fetch_status;
-		if (drive->get_basic_output().empty()) {  // if not fetched during detection
-			fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
+		if (get_drive_needs_stage(*drive, stage) && !app_is_cancelled(cancellation)) {
+			if (io_load_guard) {  // don't compete with a latency-sensitive workload
+				io_load_guard->wait_until_idle(*drive, io_load_max_wait);
+			}
+			const auto start_time = std::chrono::steady_clock::now();
+			fetch_status = fetch_drive_scan_data(*drive, smartctl_ex, fetch_full, identity_only);
+			if (!identity_only) {  // the identity probe is not comparable with the others
+				measured_latencies[get_fetch_latency_key(*drive)] = std::chrono::duration_cast<std::chrono::milliseconds>(
+						std::chrono::steady_clock::now() - start_time);
+			}
+		}
+
+		if (drive_callback_) {
+			drive_callback_(drive, reported_stage);
 		}
 
 		// normally we skip drives with errors - possibly scsi, etc.
 		if (return_first_error && !fetch_status) {
+			storage_fetch_latencies_store(measured_latencies);
+			storage_device_type_cache_save();
+			storage_drive_identity_save();
 			return hz::Unexpected(StorageDetectorError::StorageDeviceError, fetch_status.error().message());
 		}
 
@@ -136,19 +377,179 @@ hz::ExpectedVoid<StorageDetectorError> StorageDetector::fetch_basic_data(std::ve
 
 	}
 
+	storage_fetch_latencies_store(measured_latencies);
+	storage_device_type_cache_save();
+	storage_drive_identity_save();
+
+	if (app_is_cancelled(cancellation)) {
+		return get_cancelled_error(cancellation);
+	}
 	return {};
 }
 
 
 
+hz::ExpectedVoid<StorageDetectorError> StorageDetector::fetch_stage_parallel(std::vector<StorageDevicePtr>& drives,
+		const CommandExecutorFactoryPtr& ex_factory, bool return_first_error, FetchStage stage)
+{
+	/// Per-drive fetch result, filled by the worker threads.
+	struct FetchResult {
+		hz::ExpectedVoid<StorageDeviceError> status;  ///< Fetch status
+		std::string output;  ///< Command output, set on error
+		std::optional<std::chrono::milliseconds> latency;  ///< Fetch duration, set if the data was fetched
+	};
+	std::vector<FetchResult> results(drives.size());
+
+	// GUI executors show dialogs, so they can't be used outside the main thread.
+	// The caller already shows the progress (e.g. in the iconview background).
+	const CommandExecutorFactoryPtr worker_factory = command_executor_factory_for_worker_threads(ex_factory);
+
+	debug_out_info("app", DBG_FUNC_MSG << "Retrieving basic information about " << drives.size()
+			<< " devices using up to " << max_parallel_fetches_ << " threads...\n");
+
+	// The workers take the drives in this order
+	const std::vector<std::size_t> fetch_order = get_fetch_order(drives);
+
+	const auto io_load_guard = storage_io_load_guard_get_global();
+	const auto io_load_max_wait = get_io_load_max_wait();
+	const bool fetch_full = (stage == FetchStage::Full);
+	const bool identity_only = (stage == FetchStage::Identity);
+	const DriveStage reported_stage = identity_only ? DriveStage::Identified : DriveStage::Fetched;
+	const AppCancellationPtr cancellation = ex_factory->get_cancellation();
+
+	// Each drive is handed back to the calling thread as soon as its worker is done with it.
+	// Until then, its signal_changed() is suppressed (see StorageDevice::begin_worker_fetch()).
+	GMainContext* context = g_main_context_get_thread_default();
+	if (!context) {
+		context = g_main_context_default();
+	}
+	auto progress = std::make_shared<StorageDetectorFetchProgress>();
+	progress->report = [&](std::size_t drive_index) {
+		drives[drive_index]->end_worker_fetch();
+		if (drive_callback_) {
+			drive_callback_(drives[drive_index], reported_stage);
+		}
+	};
+	for (const auto& drive : drives) {
+		drive->begin_worker_fetch();
+	}
+
+	app_run_worker_tasks(drives.size(), max_parallel_fetches_, [&](std::size_t task_index) {
+		const std::size_t i = fetch_order[task_index];
+		if (get_drive_needs_stage(*drives[i], stage) && !app_is_cancelled(cancellation)) {
+			// One executor per in-flight drive
+			std::shared_ptr<CommandExecutor> smartctl_ex = worker_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+			if (stage == FetchStage::Rest) {  // don't hold up the user's commands
+				smartctl_ex->set_priority(CommandPriority::BackgroundRefresh);
+			}
+			if (io_load_guard) {  // this only delays this worker
+				io_load_guard->wait_until_idle(*drives[i], io_load_max_wait);
+			}
+			const auto start_time = std::chrono::steady_clock::now();
+			results[i].status = fetch_drive_scan_data(*drives[i], smartctl_ex, fetch_full, identity_only);
+			if (!identity_only) {  // the identity probe is not comparable with the others
+				results[i].latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+			}
+			if (!results[i].status) {
+				results[i].output = smartctl_ex->get_stdout_str();
+			}
+		}
+
+		{
+			const std::scoped_lock lock(progress->mutex);
+			progress->finished.push_back(i);
+		}
+		g_main_context_invoke_full(context, G_PRIORITY_DEFAULT, [](gpointer data) -> gboolean {
+			storage_detector_report_fetch_progress(*static_cast<std::shared_ptr<StorageDetectorFetchProgress>*>(data)->get());
+			return FALSE;
+		}, new std::shared_ptr<StorageDetectorFetchProgress>(progress), [](gpointer data) {
+			delete static_cast<std::shared_ptr<StorageDetectorFetchProgress>*>(data);
+		});
+	});
+
+	// The workers are done, report the drives whose callbacks weren't dispatched yet.
+	storage_detector_report_fetch_progress(*progress);
+	progress->report = nullptr;
+
+	StorageFetchLatencies measured_latencies;
+	for (std::size_t i = 0; i < drives.size(); ++i) {
+		if (results[i].latency.has_value()) {
+			measured_latencies[get_fetch_latency_key(*drives[i])] = results[i].latency.value();
+		}
+	}
+	storage_fetch_latencies_store(measured_latencies);
+	storage_device_type_cache_save();
+	storage_drive_identity_save();
+
+	// Report the results in drive order.
+	for (std::size_t i = 0; i < drives.size(); ++i) {
+		const auto& drive = drives[i];
+		const auto& fetch_status = results[i].status;
+
+		// normally we skip drives with errors - possibly scsi, etc.
+		if (return_first_error && !fetch_status) {
+			return hz::Unexpected(StorageDetectorError::StorageDeviceError, fetch_status.error().message());
+		}
+
+		if (!fetch_status) {
+			fetch_data_errors_.push_back(fetch_status.error().message());
+			fetch_data_error_outputs_.push_back(results[i].output);
+		}
+
+		debug_out_dump("app", "Device information for " << drive->get_device()
+				<< " (type: \"" << drive->get_type_argument() << "\"):\n"
+				<< "\tModel: " << drive->get_model_name() << "\n"
+				<< "\tDetected type: " << StorageDeviceDetectedTypeExt::get_displayable_name(drive->get_detected_type()) << "\n"
+				<< "\tSMART status: " << StorageDevice::get_status_displayable_name(drive->get_smart_status()) << "\n"
+				);
+	}
+
+	if (app_is_cancelled(cancellation)) {
+		return get_cancelled_error(cancellation);
+	}
+	return {};
+}
+
+
+
+std::vector<std::size_t> StorageDetector::get_fetch_order(const std::vector<StorageDevicePtr>& drives) const
+{
+	const StorageFetchLatencies stored_latencies = storage_fetch_latencies_load();
+	std::vector<std::optional<std::chrono::milliseconds>> latencies(drives.size());
+	for (std::size_t i = 0; i < drives.size(); ++i) {
+		if (auto iter = stored_latencies.find(get_fetch_latency_key(*drives[i])); iter != stored_latencies.end()) {
+			latencies[i] = iter->second;
+		}
+	}
+	const auto slow_threshold = std::chrono::milliseconds(std::max(0, rconfig::get_data<int>("system/fetch_slow_threshold_msec")));
+	return storage_fetch_get_order(latencies, max_parallel_fetches_, slow_threshold);
+}
+
+
+
 hz::ExpectedVoid<StorageDetectorError> StorageDetector::detect_and_fetch_basic_data(std::vector<StorageDevicePtr>& put_drives_here,
 		const CommandExecutorFactoryPtr& ex_factory)
 {
 	auto detect_status = detect(put_drives_here, ex_factory);
 
-	if (!detect_status) {
-		// ignore its errors, there may be plenty of them.
-		[[maybe_unused]] auto fetch_status = fetch_basic_data(put_drives_here, ex_factory, false);
+	const bool cancelled = (!detect_status && detect_status.error().data() == StorageDetectorError::Cancelled);
+	if (detect_status || cancelled) {
+		// The drives from the privileged helper's cache have their data already.
+		std::vector<StorageDevicePtr> fetch_drives;
+		for (const auto& drive : put_drives_here) {
+			if (drive->get_parse_status() == StorageDevice::ParseStatus::None) {
+				fetch_drives.push_back(drive);
+			} else if (drive_callback_) {
+				drive_callback_(drive, DriveStage::Fetched);
+			}
+		}
+
+		// ignore its errors, there may be plenty of them. A cancelled fetch is reported though.
+		auto fetch_status = fetch_basic_data(fetch_drives, ex_factory, false);
+		storage_detector_remove_duplicate_serials(put_drives_here);
+		if (!fetch_status && fetch_status.error().data() == StorageDetectorError::Cancelled) {
+			return fetch_status;
+		}
 	}
 
 	return detect_status;
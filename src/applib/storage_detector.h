@@ -14,6 +14,11 @@ Copyright:
 
 #include <vector>
 #include <string>
+#include <cstddef>  // std::size_t
+#include <algorithm>  // std::max
+#include <functional>
+#include <regex>
+#include <utility>
 
 #include "storage_device.h"
 #include "command_executor.h"
@@ -33,6 +38,7 @@ enum class StorageDetectorError {
 	ConfigError,
 	DevOpenError,
 	InvalidCommandLine,
+	Cancelled,
 };
 
 
@@ -41,19 +47,65 @@ enum class StorageDetectorError {
 class StorageDetector {
 	public:
 
+		/// Progress of a drive, reported to the drive callback (see set_drive_callback())
+		enum class DriveStage {
+			Detected,  ///< The drive was found by detect(), its basic data may not be fetched yet
+			Identified,  ///< The identity probe of fetch_basic_data() is done with the drive (successfully or not)
+			Fetched,  ///< fetch_basic_data() is done with the drive (successfully or not)
+		};
+
+		/// Drive callback type
+		using DriveCallback = std::function<void(const StorageDevicePtr& drive, DriveStage stage)>;
+
+
+		/// Set a callback which is called for each drive as soon as it's detected, and then again
+		/// as soon as its identity and its basic data are fetched, so that the results can be shown progressively.
+		/// It's always called from the calling thread (with parallel fetches too), but the drives
+		/// may still be removed afterwards (see detect_and_fetch_basic_data()).
+		void set_drive_callback(DriveCallback callback)
+		{
+			drive_callback_ = std::move(callback);
+		}
+
+
 		/// Detects a list of drives. Returns detection error message if error occurs.
+		/// Blacklisted drives and aliases of the same device (see storage_detector_remove_aliases())
+		/// are not included.
+		/// If the cancellation token of \c ex_factory (see CommandExecutorFactory::set_cancellation())
+		/// is cancelled meanwhile, the drives found so far are returned with a Cancelled error.
 		[[nodiscard]] hz::ExpectedVoid<StorageDetectorError> detect(std::vector<StorageDevicePtr>& drives,
 				const CommandExecutorFactoryPtr& ex_factory);
 
 
 		/// For each drive, fetch basic data and parse it.
+		/// The drives are queried in the order of their previous fetch latencies
+		/// (see storage_fetch_get_order()), so that the slow ones don't hold up the rest.
+		/// If "system/scan_fetch_full_data" config key is set, the full data is fetched instead,
+		/// with a single smartctl run per drive (see StorageDevice::fetch_all_data_and_parse()).
+		/// Otherwise, if "system/scan_identity_probe" is set, the identity of all the drives is fetched
+		/// first (see StorageDevice::fetch_identity_and_parse()), and their health and capabilities
+		/// follow at a lower priority. The drive callback is called with Identified in between.
 		/// If \c return_first_error is true, the function returns on the first error.
+		/// If the cancellation token of \c ex_factory is cancelled, the remaining drives are not
+		/// queried (they're still reported to the drive callback) and a Cancelled error is returned.
 		/// \return An empty string. Or, if return_first_error is true, the first error that occurs.
 		[[nodiscard]] hz::ExpectedVoid<StorageDetectorError> fetch_basic_data(std::vector<StorageDevicePtr>& drives,
 				const CommandExecutorFactoryPtr& ex_factory, bool return_first_error = false);
 
 
-		/// Run detect() and fetch_basic_data().
+		/// Set the maximum number of drives fetch_basic_data() queries simultaneously.
+		/// With values larger than 1, the drives are queried from worker threads (using
+		/// non-GUI executors) while the caller's main context keeps being iterated.
+		/// The default is 1 (query the drives one by one).
+		void set_max_parallel_fetches(std::size_t count)
+		{
+			max_parallel_fetches_ = std::max(count, std::size_t(1));
+		}
+
+
+		/// Run detect() and fetch_basic_data(). The drives which turn out to have the same
+		/// serial number as another drive are removed after fetching.
+		/// If the scan is cancelled (see detect()), the partial results are kept.
 		/// \return An error if such occurs.
 		[[nodiscard]] hz::ExpectedVoid<StorageDetectorError> detect_and_fetch_basic_data(std::vector<StorageDevicePtr>& put_drives_here,
 				const CommandExecutorFactoryPtr& ex_factory);
@@ -65,10 +117,20 @@ class StorageDetector {
 // 		}
 
 
-		/// Add device patterns to drive detection blacklist
-		void add_blacklist_patterns(const std::vector<std::string>& patterns)
+		/// Add device patterns to drive detection blacklist. The patterns are compiled here,
+		/// invalid ones are ignored (with a warning).
+		void add_blacklist_patterns(const std::vector<std::string>& patterns);
+
+
+		/// Check whether a device file matches any of the blacklist patterns
+		[[nodiscard]] bool is_blacklisted(const std::string& device) const;
+
+
+		/// Get the drives which detect() found, but left out because they're blacklisted.
+		/// Their basic data is not fetched.
+		[[nodiscard]] const std::vector<StorageDevicePtr>& get_blacklisted_drives() const
 		{
-			blacklist_patterns_.insert(blacklist_patterns_.end(), patterns.begin(), patterns.end());
+			return blacklisted_drives_;
 		}
 
 
@@ -88,12 +150,46 @@ class StorageDetector {
 
 	private:
 
+		/// Get the order to query the drives in, based on their stored fetch latencies.
+		/// \return Indices into \c drives.
+		[[nodiscard]] std::vector<std::size_t> get_fetch_order(const std::vector<StorageDevicePtr>& drives) const;
+
+
+		/// What one pass of fetch_basic_data() over the drives retrieves
+		enum class FetchStage {
+			Basic,  ///< The basic data (StorageDevice::fetch_basic_data_and_parse())
+			Identity,  ///< The identity only (StorageDevice::fetch_identity_and_parse())
+			Rest,  ///< The basic data of the drives which have the identity only, at a lower priority
+			Full,  ///< All the data (StorageDevice::fetch_all_data_and_parse())
+		};
+
+
+		/// Check whether a drive is to be fetched in a stage: if it has no basic data yet (it may
+		/// have been fetched during detection), or for the Rest stage, if it has the identity only.
+		[[nodiscard]] static bool get_drive_needs_stage(const StorageDevice& drive, FetchStage stage);
+
+
+		/// One pass of fetch_basic_data() over the drives, one by one
+		[[nodiscard]] hz::ExpectedVoid<StorageDetectorError> fetch_stage(std::vector<StorageDevicePtr>& drives,
+				const CommandExecutorFactoryPtr& ex_factory, bool return_first_error, FetchStage stage);
+
+
+		/// fetch_stage() implementation for max_parallel_fetches_ > 1.
+		[[nodiscard]] hz::ExpectedVoid<StorageDetectorError> fetch_stage_parallel(std::vector<StorageDevicePtr>& drives,
+				const CommandExecutorFactoryPtr& ex_factory, bool return_first_error, FetchStage stage);
+
+
 // 		std::vector<std::string> match_patterns_;  ///< First each file is matched against these
-		std::vector<std::string> blacklist_patterns_;  ///< If a device matches these, it's ignored.
+		std::vector<std::regex> blacklist_res_;  ///< If a device matches these, it's ignored.
+		std::vector<StorageDevicePtr> blacklisted_drives_;  ///< Drives left out by detect() because of blacklist_res_
 
 		std::vector<std::string> fetch_data_errors_;  ///< Errors that have occurred
 		std::vector<std::string> fetch_data_error_outputs_;  ///< Corresponding command outputs to fetch_data_errors_
 
+		std::size_t max_parallel_fetches_ = 1;  ///< Maximum number of drives to query simultaneously
+
+		DriveCallback drive_callback_;  ///< Progress callback, may be empty
+
 };
 
 
@@ -0,0 +1,98 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <unordered_set>
+
+#include "build_config.h"
+
+#include "hz/debug.h"
+#include "hz/fs.h"
+#include "rconfig/rconfig.h"
+
+#include "storage_detector_dedup.h"
+#include "storage_nvme_controller.h"
+
+
+
+std::string storage_detector_get_device_identity([[maybe_unused]] const StorageDevice& drive)
+{
+	if constexpr(BuildEnv::is_kernel_linux()) {
+		if (drive.get_is_virtual() || drive.get_type_argument().find(',') != std::string::npos) {
+			return {};  // behind a RAID controller, the device is the controller
+		}
+		if (drive.get_remote_host()) {
+			return {};  // the device file is not on this machine
+		}
+		std::error_code ec;
+		// Resolve /dev/disk/by-id/... links
+		const hz::fs::path dev = hz::fs::canonical(hz::fs_path_from_string(drive.get_device()), ec);
+		if (ec) {
+			return {};
+		}
+		static const rconfig::Key<std::string> sysfs_path("system/linux_sysfs_path");
+		const auto sysfs_dir = hz::fs_path_from_string(sysfs_path.get());
+		// NVMe namespaces are handled by the detectors, so only SCSI (sd*, sg*) devices are here.
+		for (const auto* class_dir : {"block", "class/scsi_generic"}) {
+			const hz::fs::path path = hz::fs::canonical(sysfs_dir / class_dir / dev.filename() / "device", ec);
+			if (!ec) {
+				const std::string identity = hz::fs_path_to_string(path);
+				if (identity.find("/nvme") == std::string::npos) {
+					return identity;
+				}
+			}
+		}
+	}
+	return {};
+}
+
+
+
+std::size_t storage_detector_remove_aliases(std::vector<StorageDevicePtr>& drives,
+		const std::function<std::string(const StorageDevice&)>& get_identity)
+{
+	std::unordered_set<std::string> identities;
+	const auto removed = std::erase_if(drives, [&](const StorageDevicePtr& drive) {
+		const std::string identity = get_identity(*drive);
+		if (identity.empty() || identities.insert(identity).second) {
+			return false;
+		}
+		debug_out_info("app", "Device " << drive->get_device_with_type() << " is an alias of another detected device ("
+				<< identity << "), ignoring.\n");
+		return true;
+	});
+	return static_cast<std::size_t>(removed);
+}
+
+
+
+std::size_t storage_detector_remove_duplicate_serials(std::vector<StorageDevicePtr>& drives)
+{
+	std::unordered_set<std::string> serials;
+	const auto removed = std::erase_if(drives, [&](const StorageDevicePtr& drive) {
+		std::string serial = drive->get_serial_number();
+		// The namespaces of an NVMe controller report the controller's serial number, but they are different drives.
+		if (auto nvme_name = storage_nvme_parse_device_name(drive->get_device()); nvme_name && nvme_name->namespace_id) {
+			serial += "/n" + std::to_string(nvme_name->namespace_id.value());
+		}
+		if (drive->get_is_virtual() || drive->get_serial_number().empty() || serials.insert(serial).second) {
+			return false;
+		}
+		debug_out_info("app", "Device " << drive->get_device_with_type() << " has the same serial number as another detected device ("
+				<< serial << "), ignoring.\n");
+		return true;
+	});
+	return static_cast<std::size_t>(removed);
+}
+
+
+
+
+/// @}
@@ -0,0 +1,50 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DETECTOR_DEDUP_H
+#define STORAGE_DETECTOR_DEDUP_H
+
+#include <cstddef>  // std::size_t
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "storage_device.h"
+
+
+
+/// Get an identity of the physical device behind the drive's device file, which is the same for
+/// all its aliases (e.g. /dev/sda, /dev/sg0 and /dev/disk/by-id/... links). On Linux this is the
+/// SCSI device directory in sysfs. Empty if unknown, if the drive is on a remote host, or if the drive
+/// is behind a RAID controller (the device file is the controller then).
+[[nodiscard]] std::string storage_detector_get_device_identity(const StorageDevice& drive);
+
+
+/// Remove the drives whose identity (as returned by \c get_identity) is the same as of a previous
+/// drive, e.g. the same drive detected as /dev/sda and /dev/sg0, or with "-d sat" and "-d scsi".
+/// The drives with empty identities are kept.
+/// \return Number of removed drives.
+std::size_t storage_detector_remove_aliases(std::vector<StorageDevicePtr>& drives,
+		const std::function<std::string(const StorageDevice&)>& get_identity = &storage_detector_get_device_identity);
+
+
+/// Remove the drives whose serial number is the same as of a previous drive. Call this after
+/// fetching the basic data, so that the same drive is not fully fetched more than once.
+/// The drives without serial numbers are kept, and so are the different namespaces of an NVMe controller.
+/// \return Number of removed drives.
+std::size_t storage_detector_remove_duplicate_serials(std::vector<StorageDevicePtr>& drives);
+
+
+
+
+#endif
+
+/// @}
@@ -13,18 +13,28 @@ Copyright:
 #define STORAGE_DETECTOR_HELPERS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <map>
 
 #include <glibmm.h>  // Glib::compose
 
 #include "build_config.h"
 #include "command_executor_factory.h"
+#include "command_executor_remote.h"
 #include "storage_device.h"
 #include "rconfig/rconfig.h"
 #include "app_regex.h"
 #include "hz/string_num.h"
 #include "storage_detector.h"
 #include "hz/string_algo.h"
+#include "worker_threads.h"
+#include "storage_raid_cli_inventory.h"
+#include "storage_raid_port_map.h"
 
 
 
@@ -75,41 +85,53 @@ inline hz::ExpectedVoid<StorageDetectorError> execute_tw_cli(const CommandExecut
 
 
 
+/// Get the host key of the RAID CLI inventory cache (see raid_cli_inventory_get()):
+/// the remote host destination, or an empty string if local.
+inline std::string raid_cli_inventory_get_host(const CommandExecutorFactoryPtr& ex_factory)
+{
+	const auto remote_host = ex_factory->get_remote_host();
+	return remote_host ? remote_host->get_destination() : std::string();
+}
+
+
+
 /// Get the drives on a 3ware controller using tw_cli.
+/// The populated ports are cached in the RAID CLI inventory (see raid_cli_inventory_get()).
 /// Note that the drives are inserted in the order they are detected.
 inline hz::ExpectedVoid<StorageDetectorError> tw_cli_get_drives(const std::string& dev, int controller,
 		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory, bool use_tw_cli_dev)
 {
-	debug_out_info("app", "Getting available 3ware drives (ports) for controller " << controller << " through tw_cli...\n");
+	const std::string host = raid_cli_inventory_get_host(ex_factory);
 
-	std::string output;
-	auto exec_status = execute_tw_cli(ex_factory, {hz::string_sprintf("/c%d", controller), "show", "all"}, output);
-	if (!exec_status) {
-		return exec_status;
-	}
+	std::vector<int> ports;
+	const auto inventory = raid_cli_inventory_get(host);
+	if (auto iter = inventory.tw_cli_ports.find(controller); iter != inventory.tw_cli_ports.end()) {
+		debug_out_info("app", "Using cached 3ware drives (ports) for controller " << controller << ".\n");
+		ports = iter->second;
 
-	// split to lines
-	std::vector<std::string> lines;
-	hz::string_split(output, '\n', lines, true);
+	} else {
+		debug_out_info("app", "Getting available 3ware drives (ports) for controller " << controller << " through tw_cli...\n");
+
+		std::string output;
+		auto exec_status = execute_tw_cli(ex_factory, {hz::string_sprintf("/c%d", controller), "show", "all"}, output);
+		if (!exec_status) {
+			return exec_status;
+		}
+		ports = tw_cli_parse_ports(output);
+		raid_cli_inventory_update(host, [&](RaidCliInventory& updated) {
+			updated.tw_cli_ports[controller] = ports;
+		});
+	}
 
 	// Note that the ports may be printed in any order. We sort the drives themselves in the end.
-	auto port_re = app_regex_re(R"(/^p([0-9]+)[ \t]+([^\t\n]+)/mi)");
-	for (const auto& line : lines) {
-		std::string port_str, status;
-		if (app_regex_partial_match(port_re, hz::string_trim_copy(line), {&port_str, &status})) {
-			if (status != "NOT-PRESENT") {
-				int port = -1;
-				if (hz::string_is_numeric_nolocale(port_str, port)) {
-					if (use_tw_cli_dev) {  // use "tw_cli/cx/py" device
-						drives.emplace_back(std::make_shared<StorageDevice>("tw_cli/c"
-								+ hz::number_to_string_nolocale(controller) + "/p" + hz::number_to_string_nolocale(port)));
-					} else {
-						drives.emplace_back(std::make_shared<StorageDevice>(dev, "3ware," + hz::number_to_string_nolocale(port)));
-					}
-					debug_out_info("app", "Added 3ware drive " << drives.back()->get_device_with_type() << ".\n");
-				}
-			}
+	for (const int port : ports) {
+		if (use_tw_cli_dev) {  // use "tw_cli/cx/py" device
+			drives.emplace_back(std::make_shared<StorageDevice>("tw_cli/c"
+					+ hz::number_to_string_nolocale(controller) + "/p" + hz::number_to_string_nolocale(port)));
+		} else {
+			drives.emplace_back(std::make_shared<StorageDevice>(dev, "3ware," + hz::number_to_string_nolocale(port)));
 		}
+		debug_out_info("app", "Added 3ware drive " << drives.back()->get_device_with_type() << ".\n");
 	}
 
 	return {};
@@ -118,10 +140,19 @@ inline hz::ExpectedVoid<StorageDetectorError> tw_cli_get_drives(const std::strin
 
 
 /// Return 3ware SCSI host numbers (same as /c switch to tw_cli).
+/// The result is cached in the RAID CLI inventory (see raid_cli_inventory_get()).
 /// \return error string on error
 inline hz::ExpectedVoid<StorageDetectorError> tw_cli_get_controllers(
 		const CommandExecutorFactoryPtr& ex_factory, std::vector<int>& controllers)
 {
+	const std::string host = raid_cli_inventory_get_host(ex_factory);
+
+	if (const auto inventory = raid_cli_inventory_get(host); inventory.tw_cli_controllers.has_value()) {
+		debug_out_info("app", "Using cached 3ware controllers.\n");
+		controllers = inventory.tw_cli_controllers.value();
+		return {};
+	}
+
 	debug_out_info("app", "Getting available 3ware controllers through tw_cli...\n");
 
 	std::string output;
@@ -130,73 +161,206 @@ inline hz::ExpectedVoid<StorageDetectorError> tw_cli_get_controllers(
 		return exec_status;
 	}
 
-	// split to lines
-	std::vector<std::string> lines;
-	hz::string_split(output, '\n', lines, true);
-
-	auto controller_re = app_regex_re("/^c([0-9]+)[ \\t]+/mi");
-	for (const auto& line : lines) {
-		std::string controller_str;
-		if (app_regex_partial_match(controller_re, hz::string_trim_copy(line), &controller_str)) {
-			int controller = -1;
-			if (hz::string_is_numeric_nolocale(controller_str, controller)) {
-				debug_out_info("app", "Found 3ware controller " << controller << ".\n");
-				controllers.push_back(controller);
+	controllers = tw_cli_parse_controllers(output);
+	for (const int controller : controllers) {
+		debug_out_info("app", "Found 3ware controller " << controller << ".\n");
+	}
+	raid_cli_inventory_update(host, [&](RaidCliInventory& updated) {
+		updated.tw_cli_controllers = controllers;
+	});
+
+	return {};
+}
+
+
+
+/// Verdict for a single probed port, see smartctl_probe_ports().
+enum class SmartctlPortProbeStatus {
+	Populated,  ///< There is a drive on the port
+	Empty,  ///< The port is empty (or the drive cannot be used)
+	StopScan,  ///< Controller or smartctl port limit reached, ignore this and later ports
+};
+
+
+/// Port classifier for smartctl_probe_ports(). Called in the calling thread, in port order.
+using SmartctlPortProbeClassifier = std::function<SmartctlPortProbeStatus(int port,
+		const StorageDevicePtr& drive, const hz::ExpectedVoid<StorageDeviceError>& fetch_status)>;
+
+
+/// Probe ports [from, to] by running smartctl on each one, adding the populated ones to \c drives.
+/// \c type contains a printf-formatted string with %d.
+/// Up to "system/raid_scan_max_parallel_probes" ports of the same controller are probed
+/// concurrently (some controller firmware can't handle concurrent passthrough, so the default is 1).
+/// The scan stops when \c classify returns StopScan, or after "system/raid_scan_max_empty_ports"
+/// consecutive empty ports (if non-zero). The results are processed in port order, so the
+/// detected drives are the same as with a sequential scan.
+/// The populated ports are remembered (see StorageRaidPortMapEntry). If a controller was swept
+/// less than "system/raid_port_map_sweep_interval_sec" ago, only its remembered ports are probed,
+/// and the full sweep is done only if one of them turns out to be empty.
+/// \c last_output receives the output of the last processed port.
+inline void smartctl_probe_ports(const std::string& dev, const std::string& type, int from, int to,
+		const SmartctlPortProbeClassifier& classify, std::vector<StorageDevicePtr>& drives,
+		const CommandExecutorFactoryPtr& ex_factory, std::string& last_output)
+{
+	const auto max_parallel = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/raid_scan_max_parallel_probes")));
+	const int max_empty_ports = std::max(0, rconfig::get_data<int>("system/raid_scan_max_empty_ports"));
+	const auto sweep_interval = std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/raid_port_map_sweep_interval_sec")));
+
+	const CommandExecutorFactoryPtr probe_factory = (max_parallel > 1)
+			? command_executor_factory_for_worker_threads(ex_factory) : ex_factory;
+
+	// One executor per in-flight port
+	std::vector<std::shared_ptr<CommandExecutor>> executors;
+	for (std::size_t i = 0; i < max_parallel; ++i) {
+		executors.push_back(probe_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl));
+	}
+
+	// Verdicts of the ports probed so far. The populated ones are already in drives.
+	std::map<int, SmartctlPortProbeStatus> probed;
+	bool cancelled = false;
+
+	// Probe the ports in order, skipping the already probed ones (but taking their verdicts into account).
+	// Returns false if the scan should stop.
+	auto probe = [&](const std::vector<int>& ports, bool count_empty_ports) -> bool
+	{
+		int empty_run = 0;
+		for (std::size_t batch_start = 0; batch_start < ports.size(); batch_start += max_parallel) {
+			if (app_is_cancelled(ex_factory->get_cancellation())) {
+				debug_out_dump("app", "Scan cancelled at port " << ports[batch_start] << ", stopping port scan.\n");
+				cancelled = true;
+				return false;
+			}
+			const auto batch_size = std::min(max_parallel, ports.size() - batch_start);
+
+			std::vector<StorageDevicePtr> batch_drives(batch_size);
+			std::vector<hz::ExpectedVoid<StorageDeviceError>> batch_statuses(batch_size);
+
+			app_run_worker_tasks(batch_size, max_parallel, [&](std::size_t i) {
+				const int port = ports[batch_start + i];
+				if (probed.find(port) == probed.end()) {
+					batch_drives[i] = std::make_shared<StorageDevice>(dev, hz::string_sprintf(type.c_str(), port));
+					batch_statuses[i] = batch_drives[i]->fetch_basic_data_and_parse(executors[i]);
+				}
+			});
+
+			for (std::size_t i = 0; i < batch_size; ++i) {
+				const int port = ports[batch_start + i];
+				auto status = SmartctlPortProbeStatus::Empty;
+				if (auto iter = probed.find(port); iter != probed.end()) {
+					status = iter->second;
+				} else {
+					const auto& drive = batch_drives[i];
+					last_output = drive->get_basic_output();
+					status = classify(port, drive, batch_statuses[i]);
+					probed.emplace(port, status);
+					if (status == SmartctlPortProbeStatus::Populated) {
+						drives.push_back(drive);
+						debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
+					} else if (status == SmartctlPortProbeStatus::Empty) {
+						debug_out_dump("app", "Skipping drive " << drive->get_device_with_type() << " due to smartctl error.\n");
+					}
+				}
+
+				switch (status) {
+					case SmartctlPortProbeStatus::Populated:
+						empty_run = 0;
+						break;
+					case SmartctlPortProbeStatus::Empty:
+						++empty_run;
+						break;
+					case SmartctlPortProbeStatus::StopScan:
+						return false;
+				}
+
+				if (count_empty_ports && max_empty_ports > 0 && empty_run >= max_empty_ports) {
+					debug_out_dump("app", "Found " << empty_run << " empty ports in a row at port " << port << ", stopping port scan.\n");
+					return false;
+				}
 			}
 		}
+		return true;
+	};
+
+	const auto remote_host = ex_factory->get_remote_host();
+	const std::string map_key = storage_raid_port_map_get_key(remote_host ? remote_host->get_destination() : std::string(), dev, type);
+	const auto now = std::chrono::system_clock::now();
+
+	if (const auto entry = storage_raid_port_map_lookup(map_key); entry.has_value() && sweep_interval.count() > 0) {
+		std::vector<int> known_ports;
+		std::copy_if(entry->ports.begin(), entry->ports.end(), std::back_inserter(known_ports),
+				[&](int port) { return port >= from && port <= to; });
+
+		debug_out_dump("app", "Probing " << known_ports.size() << " previously populated ports of \"" << dev << "\" (" << type << ") first.\n");
+		const bool completed = probe(known_ports, false);
+		if (cancelled) {
+			return;
+		}
+		const bool unchanged = completed && std::all_of(known_ports.begin(), known_ports.end(),
+				[&](int port) { return probed.at(port) == SmartctlPortProbeStatus::Populated; });
+		if (unchanged && !storage_raid_port_map_get_sweep_due(entry.value(), now, sweep_interval)) {
+			debug_out_dump("app", "All previously populated ports are still populated, skipping the full port sweep.\n");
+			return;
+		}
 	}
 
-	// Sort them. This affects only the further detection order, since the drives
-	// are sorted in the end anyway.
-	std::sort(controllers.begin(), controllers.end());
+	std::vector<int> all_ports;
+	for (int port = from; port <= to; ++port) {
+		all_ports.push_back(port);
+	}
+	probe(all_ports, true);
+	if (cancelled) {
+		return;
+	}
 
-	return {};
+	StorageRaidPortMapEntry entry;
+	for (const auto& [port, status] : probed) {
+		if (status == SmartctlPortProbeStatus::Populated) {
+			entry.ports.push_back(port);
+		}
+	}
+	entry.full_sweep_time = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+	storage_raid_port_map_store(map_key, entry);
 }
 
 
 
-/// Get number of ports by sequentially running smartctl on each port, until
-/// one of the gives an error. \c type contains a printf-formatted string with %d.
+/// Get the drives by running smartctl on each port, until the controller or smartctl
+/// port limit is reached. \c type contains a printf-formatted string with %d.
 /// \return an error message on error.
-inline hz::ExpectedVoid<StorageDetectorError> smartctl_scan_drives_sequentially(const std::string& dev, const std::string& type,
+inline hz::ExpectedVoid<StorageDetectorError> smartctl_scan_drives(const std::string& dev, const std::string& type,
 	  int from, int to, std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory, std::string& last_output)
 {
-	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
-
-	for (int i = from; i <= to; ++i) {
-		std::string type_arg = hz::string_sprintf(type.c_str(), i);
-		auto drive = std::make_shared<StorageDevice>(dev, type_arg);
-
+	auto classify = [](int port, const StorageDevicePtr& drive, const hz::ExpectedVoid<StorageDeviceError>& fetch_status)
+	{
 		// This will generate an error if smartctl doesn't return 0, which is what happens
 		// with non-populated ports.
 		// Sometimes the output contains:
 		// "Read Device Identity failed: Input/output error"
 		// or
 		// "Read Device Identity failed: empty IDENTIFY data"
-		auto fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
-		last_output = drive->get_basic_output();
+		const std::string output = drive->get_basic_output();
 
 		// If we've reached smartctl port limit (older versions may have smaller limits), abort.
-		if (app_regex_partial_match("/VALID ARGUMENTS ARE/mi", last_output)) {
-			break;
+		if (app_regex_partial_match("/VALID ARGUMENTS ARE/mi", output)) {
+			debug_out_dump("app", "Reached smartctl port limit with port " << port << ", stopping port scan.\n");
+			return SmartctlPortProbeStatus::StopScan;
 		}
 
 		// If we couldn't open the device, it means there is no such controller at specified device
 		// and scanning the ports is useless.
-		if (app_regex_partial_match("/No .* controller found/mi", last_output)
-				|| app_regex_partial_match("/Smartctl open device: .* failed: No such device/mi", last_output) ) {
-			break;
+		if (app_regex_partial_match("/No .* controller found/mi", output)
+				|| app_regex_partial_match("/Smartctl open device: .* failed: No such device/mi", output) ) {
+			return SmartctlPortProbeStatus::StopScan;
 		}
 
 		if (!fetch_status) {
 			debug_out_info("app", "Smartctl returned with an error: " << fetch_status.error().message() << "\n");
-			debug_out_dump("app", "Skipping drive " << drive->get_device_with_type() << " due to smartctl error.\n");
-		} else {
-			drives.push_back(drive);
-			debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
+			return SmartctlPortProbeStatus::Empty;
 		}
-	}
+		return SmartctlPortProbeStatus::Populated;
+	};
 
+	smartctl_probe_ports(dev, type, from, to, classify, drives, ex_factory, last_output);
 	return {};
 }
 
@@ -22,6 +22,9 @@ Copyright:
 #include <regex>
 #include <set>
 #include <map>
+#include <mutex>
+#include <optional>
+#include <tuple>  // std::tie
 #include <system_error>
 #include <vector>
 #include <utility>  // std::pair
@@ -29,6 +32,7 @@ Copyright:
 
 #include "build_config.h"
 #include "command_executor_factory.h"
+#include "command_executor_policy.h"
 #include "hz/error_container.h"
 #include "hz/string_algo.h"
 #include "hz/debug.h"
@@ -36,9 +40,12 @@ Copyright:
 #include "hz/string_num.h"
 #include "rconfig/rconfig.h"
 #include "app_regex.h"
+#include "app_trace.h"
 #include "storage_detector.h"
 #include "storage_detector_helpers.h"
+#include "storage_detector_scan_open.h"
 #include "storage_device.h"
+#include "worker_threads.h"
 
 
 
@@ -138,10 +145,11 @@ inline std::map<hz::fs::path, std::string>& get_read_file_cache_ref()
 
 
 
-/// Clear the read file cache.
-inline void clear_read_file_cache()
+/// Mutex for get_read_file_cache_ref(), the detectors may run in parallel.
+inline std::mutex& get_read_file_cache_mutex()
 {
-	get_read_file_cache_ref().clear();
+	static std::mutex mutex;
+	return mutex;
 }
 
 
@@ -149,6 +157,9 @@ inline void clear_read_file_cache()
 /// Read procfs file without using seeking.
 inline std::error_code read_proc_file(const hz::fs::path& file, std::string& contents)
 {
+	// Hold the lock while reading, so that each file is read only once.
+	const std::scoped_lock lock(get_read_file_cache_mutex());
+
 	auto& cache = get_read_file_cache_ref();
 	if (auto iter = cache.find(file); iter != cache.end()) {
 		contents = iter->second;
@@ -332,6 +343,257 @@ inline std::string read_proc_scsi_sg_devices_file(std::vector<std::vector<int>>&
 
 
 
+/// SCSI device as seen in sysfs (/sys/bus/scsi/devices/H:C:I:L)
+struct LinuxSysfsScsiDevice {
+	int host = -1;  ///< SCSI host (controller) number
+	int channel = -1;  ///< Channel
+	int id = -1;  ///< Target ID
+	int lun = -1;  ///< LUN
+	int type = -1;  ///< SCSI peripheral device type (0 - disk, 3 - processor, 12 - RAID controller)
+	std::string vendor;  ///< Vendor, trimmed
+	std::string model;  ///< Model, trimmed
+	int sg_num = -1;  ///< N in /dev/sgN, -1 if there is no SCSI generic device
+};
+
+
+
+/// Storage-related information read from sysfs
+struct LinuxSysfsInfo {
+	bool available = false;  ///< Whether sysfs could be read at all
+	std::vector<std::string> block_disks;  ///< Whole-disk block device names relative to /dev (e.g. "sda", "cciss/c0d0")
+	std::map<int, std::string> host_drivers;  ///< SCSI host number -> driver name (e.g. "3w-9xxx", "aacraid", "arcmsr", "hpsa")
+	std::vector<LinuxSysfsScsiDevice> scsi_devices;  ///< SCSI devices, sorted by host, channel, id, lun
+};
+
+
+
+/// Read a single-value sysfs attribute file, trimmed.
+/// These are not cached, since the whole LinuxSysfsInfo is.
+inline std::optional<std::string> read_sysfs_attribute(const hz::fs::path& file)
+{
+	std::string contents;
+	if (hz::fs_file_get_contents_unseekable(file, contents)) {
+		return std::nullopt;
+	}
+	return hz::string_trim_copy(contents);
+}
+
+
+
+/// Parse "H:C:I:L" SCSI address
+inline bool parse_scsi_address(const std::string& str, LinuxSysfsScsiDevice& dev)
+{
+	std::vector<std::string> parts;
+	hz::string_split(str, ':', parts, false);
+	return parts.size() == 4
+			&& hz::string_is_numeric_nolocale(parts[0], dev.host)
+			&& hz::string_is_numeric_nolocale(parts[1], dev.channel)
+			&& hz::string_is_numeric_nolocale(parts[2], dev.id)
+			&& hz::string_is_numeric_nolocale(parts[3], dev.lun);
+}
+
+
+
+/// Parse the number in "sgN" (optionally prefixed with "scsi_generic:" in old kernels)
+inline int parse_sg_name(std::string name)
+{
+	if (name.starts_with("scsi_generic:")) {
+		name.erase(0, std::string("scsi_generic:").size());
+	}
+	int num = -1;
+	if (!name.starts_with("sg") || !hz::string_is_numeric_nolocale(name.substr(2), num)) {
+		return -1;
+	}
+	return num;
+}
+
+
+
+/// Read the storage information from sysfs ("system/linux_sysfs_path" config key, /sys by default):
+/// whole disks from /sys/block, SCSI host drivers from /sys/class/scsi_host and
+/// SCSI devices from /sys/bus/scsi/devices.
+inline LinuxSysfsInfo read_sysfs_info()
+{
+	LinuxSysfsInfo info;
+
+	const auto sysfs_dir = hz::fs_path_from_string(rconfig::get_data<std::string>("system/linux_sysfs_path"));
+	std::error_code ec;
+	if (sysfs_dir.empty() || !hz::fs::is_directory(sysfs_dir / "block", ec)) {
+		debug_out_info("app", DBG_FUNC_MSG << "Block device directory not found in sysfs.\n");
+		return info;
+	}
+	info.available = true;
+
+	// Whole disks. Partitions are subdirectories of their disks, not /sys/block entries.
+	// Virtual devices (loop, ram, md, dm, ...) have no "device" link.
+	for (const auto& entry : hz::fs::directory_iterator(sysfs_dir / "block", ec)) {
+		std::error_code dummy_ec;
+		if (!hz::fs::exists(entry.path() / "device", dummy_ec)) {
+			continue;
+		}
+		std::string name = hz::fs_path_to_string(entry.path().filename());
+		std::replace(name.begin(), name.end(), '!', '/');  // "cciss!c0d0" is /dev/cciss/c0d0
+		info.block_disks.push_back(name);
+	}
+	std::sort(info.block_disks.begin(), info.block_disks.end());
+
+	// SCSI hosts. The directory doesn't exist if there is no SCSI support.
+	for (const auto& entry : hz::fs::directory_iterator(sysfs_dir / "class" / "scsi_host", ec)) {
+		const std::string name = hz::fs_path_to_string(entry.path().filename());
+		int host_num = -1;
+		if (name.starts_with("host") && hz::string_is_numeric_nolocale(name.substr(4), host_num)) {
+			info.host_drivers[host_num] = read_sysfs_attribute(entry.path() / "proc_name").value_or(std::string());
+		}
+	}
+
+	// SCSI devices
+	for (const auto& entry : hz::fs::directory_iterator(sysfs_dir / "bus" / "scsi" / "devices", ec)) {
+		LinuxSysfsScsiDevice dev;
+		if (!parse_scsi_address(hz::fs_path_to_string(entry.path().filename()), dev)) {
+			continue;  // hostN, targetH:C:I
+		}
+		hz::string_is_numeric_nolocale(read_sysfs_attribute(entry.path() / "type").value_or(std::string()), dev.type);
+		dev.vendor = read_sysfs_attribute(entry.path() / "vendor").value_or(std::string());
+		dev.model = read_sysfs_attribute(entry.path() / "model").value_or(std::string());
+
+		std::error_code sg_ec;
+		if (hz::fs::is_directory(entry.path() / "scsi_generic", sg_ec)) {
+			for (const auto& sg_entry : hz::fs::directory_iterator(entry.path() / "scsi_generic", sg_ec)) {
+				dev.sg_num = parse_sg_name(hz::fs_path_to_string(sg_entry.path().filename()));
+			}
+		} else {
+			for (const auto& sg_entry : hz::fs::directory_iterator(entry.path(), sg_ec)) {
+				if (int sg_num = parse_sg_name(hz::fs_path_to_string(sg_entry.path().filename())); sg_num >= 0) {
+					dev.sg_num = sg_num;
+				}
+			}
+		}
+		info.scsi_devices.push_back(dev);
+	}
+	std::sort(info.scsi_devices.begin(), info.scsi_devices.end(), [](const auto& a, const auto& b) {
+		return std::tie(a.host, a.channel, a.id, a.lun) < std::tie(b.host, b.channel, b.id, b.lun);
+	});
+
+	debug_out_dump("app", DBG_FUNC_MSG << "Found " << info.block_disks.size() << " disks, "
+			<< info.host_drivers.size() << " SCSI hosts and " << info.scsi_devices.size() << " SCSI devices in sysfs.\n");
+
+	return info;
+}
+
+
+
+/// Cached result of read_sysfs_info(), cleared by clear_read_file_cache().
+inline std::optional<LinuxSysfsInfo>& get_sysfs_info_cache_ref()
+{
+	static std::optional<LinuxSysfsInfo> cache;
+	return cache;
+}
+
+
+
+/// Get the sysfs information, reading it on first call after clear_read_file_cache().
+inline LinuxSysfsInfo get_sysfs_info()
+{
+	const std::scoped_lock lock(get_read_file_cache_mutex());
+	auto& cache = get_sysfs_info_cache_ref();
+	if (!cache.has_value()) {
+		cache = read_sysfs_info();
+	}
+	return cache.value();
+}
+
+
+
+/// Clear the read file cache and the sysfs information cache.
+inline void clear_read_file_cache()
+{
+	const std::scoped_lock lock(get_read_file_cache_mutex());
+	get_read_file_cache_ref().clear();
+	get_sysfs_info_cache_ref().reset();
+}
+
+
+
+/// Check whether the detection should use sysfs instead of /proc files
+/// ("system/linux_detection_backend" config key: "auto", "sysfs" or "proc").
+inline bool get_use_sysfs_detection()
+{
+	const auto backend = rconfig::get_data<std::string>("system/linux_detection_backend");
+	if (backend == "proc") {
+		return false;
+	}
+	const bool available = get_sysfs_info().available;
+	if (backend == "sysfs" && !available) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Sysfs detection requested, but sysfs is not available. Using /proc files.\n");
+	}
+	return available;
+}
+
+
+
+
+/// Convert block device names (as in /proc/partitions or /sys/block, e.g. "sda" or "nvme0n1")
+/// to device files, query them and add them to \c drives.
+inline void fetch_linux_block_drives(const std::vector<std::string>& proc_devices,
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	// In case if nvme, smartctl < 7.5 doesn't support self-tests for nvme devices with namespaces.
+	// Remove the namespace portion from the device name, unless there are multiple namespaces.
+	std::vector<std::string> clean_devices;
+	for (const auto& dev : proc_devices) {
+		std::string no_ns_dev;
+		if (app_regex_partial_match("/(nvme[0-9]+)n[0-9]+$/", dev, &no_ns_dev)) {
+			auto num_nvmes = std::count_if(proc_devices.begin(), proc_devices.end(), [&no_ns_dev](const std::string& d) {
+				return d.starts_with(no_ns_dev);
+			});
+			if (num_nvmes == 1) {
+				// Only one namespace, remove the namespace portion.
+				clean_devices.push_back(no_ns_dev);
+			} else {
+				clean_devices.push_back(dev);
+			}
+		} else {
+			clean_devices.push_back(dev);
+		}
+	}
+
+	std::vector<std::string> devices;
+	for (auto& dev : clean_devices) {
+		dev = "/dev/" + dev;  // let's just hope it's really /dev.
+
+		if (std::find(devices.begin(), devices.end(), dev) == devices.end()) {  // there may be duplicates
+			devices.push_back(dev);
+		}
+	}
+
+
+	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+
+	for (const auto& device : devices) {
+		if (app_is_cancelled(ex_factory->get_cancellation())) {
+			debug_out_dump("app", "Scan cancelled, not querying " << device << " and the following devices.\n");
+			break;
+		}
+		auto drive = std::make_shared<StorageDevice>(device);
+		auto fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
+		if (!fetch_status) {
+			continue;
+		}
+
+		// 3ware controllers also export themselves as sd*. Smartctl detects that,
+		// so we can avoid adding them. Older smartctl (5.38) prints "AMCC", newer one
+		// prints "AMCC/3ware controller". It's better to search it this way.
+		if (app_regex_partial_match("/try adding '-d 3ware,N'/im", drive->get_basic_output())) {
+			debug_out_dump("app", "Drive " << drive->get_device_with_type() << " seems to be a 3ware controller, ignoring.\n");
+		} else {
+			drives.push_back(drive);
+			debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
+		}
+	}
+}
+
+
+
 /**
 <pre>
 Linux (tested with 2.4 and 2.6) /proc/partitions. Parses the file, appends /dev to each entry.
@@ -389,16 +651,6 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_proc_partition
 		return hz::Unexpected(StorageDetectorError::ProcReadError, error_msg);
 	}
 
-	static const std::vector<std::string> blacklist = {
-		"/d[a-z][0-9]+$/",  // sda1, hdb2 - partitions. twa0 and twe1 are drives, not partitions.
-		"/ram[0-9]+$/",  // ramdisks?
-		"/loop[0-9]*$/",  // not sure if loop devices go there, but anyway...
-		"/part[0-9]+$/",  // devfs had them
-		"/p[0-9]+$/",  // partitions are usually marked this way
-		"/md[0-9]*$/",  // linux software raid
-		"/dm-[0-9]*$/",  // linux device mapper
-	};
-
 	std::vector<std::string> proc_devices;
 
 	for (auto line : lines) {
@@ -413,70 +665,38 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_proc_partition
 		}
 
 		// platform blacklist
-		bool blacked = false;
-		for (const auto& bl_pattern : blacklist) {
-			if (app_regex_partial_match(bl_pattern, dev)) {
-				blacked = true;
-				break;
-			}
-		}
-		if (blacked)
+		if (is_ignored_device_linux(dev))
 			continue;
 
 		proc_devices.push_back(dev);
 	}
 
-	// In case if nvme, smartctl < 7.5 doesn't support self-tests for nvme devices with namespaces.
-	// Remove the namespace portion from the device name, unless there are multiple namespaces.
-	std::vector<std::string> clean_devices;
-	for (const auto& dev : proc_devices) {
-		std::string no_ns_dev;
-		if (app_regex_partial_match("/(nvme[0-9]+)n[0-9]+$/", dev, &no_ns_dev)) {
-			auto num_nvmes = std::count_if(proc_devices.begin(), proc_devices.end(), [&no_ns_dev](const std::string& d) {
-				return d.starts_with(no_ns_dev);
-			});
-			if (num_nvmes == 1) {
-				// Only one namespace, remove the namespace portion.
-				clean_devices.push_back(no_ns_dev);
-			} else {
-				clean_devices.push_back(dev);
-			}
-		} else {
-			clean_devices.push_back(dev);
-		}
-	}
-
-	std::vector<std::string> devices;
-	for (auto& dev : clean_devices) {
-		dev = "/dev/" + dev;  // let's just hope it's really /dev.
+	fetch_linux_block_drives(proc_devices, drives, ex_factory);
 
-		if (std::find(devices.begin(), devices.end(), dev) == devices.end()) {  // there may be duplicates
-			devices.push_back(dev);
-		}
-	}
+	return {};
+}
 
 
-	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
 
-	for (const auto& device : devices) {
-		auto drive = std::make_shared<StorageDevice>(device);
-		auto fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
-		if (!fetch_status) {
-			continue;
-		}
-
-		// 3ware controllers also export themselves as sd*. Smartctl detects that,
-		// so we can avoid adding them. Older smartctl (5.38) prints "AMCC", newer one
-		// prints "AMCC/3ware controller". It's better to search it this way.
-		if (app_regex_partial_match("/try adding '-d 3ware,N'/im", drive->get_basic_output())) {
-			debug_out_dump("app", "Drive " << drive->get_device_with_type() << " seems to be a 3ware controller, ignoring.\n");
-		} else {
-			drives.push_back(drive);
-			debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
-		}
+/// Find the drives on the ports of 3ware controller \c dev (e.g. /dev/twa0) having SCSI host \c host_num.
+/// tw_cli is used if available, otherwise the ports are scanned one by one.
+inline void scan_3ware_controller(const std::string& dev, int host_num,
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	auto exec_status = tw_cli_get_drives(dev, host_num, drives, ex_factory, false);
+	if (!exec_status) {  // no tw_cli
+		int max_ports = rconfig::get_data<int>("system/linux_3ware_max_scan_port");
+		max_ports = std::max(0, std::min(max_ports, 127));  // Sanity check
+		debug_out_dump("app", "Starting brute-force port scan on 0-" << max_ports << " ports, device \"" << dev
+				<< "\". Change the maximum by setting \"system/linux_3ware_max_scan_port\" config key.\n");
+		std::string last_output;
+		exec_status = smartctl_scan_drives(dev, "3ware,%d", 0, max_ports, drives, ex_factory, last_output);
+		debug_out_dump("app", "Brute-force port scan finished.\n");
 	}
 
-	return {};
+	if (!exec_status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Couldn't get the drives on ports of LSI/AMCC/3ware controller: " << exec_status.error().message() << "\n");
+	}
 }
 
 
@@ -587,11 +807,11 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_3ware(
 		// If there are several different tw* devices present (like 1 twa and 1 twe), we
 		// use the vendor name to differentiate them.
 		if (int(twa_found) + int(twe_found) + int(twl_found) > 1) {
-			if (twa_found && hz::string_to_lower_copy(vendor) == "amcc") {
+			if (twa_found && hz::string_iequals(vendor, "amcc")) {
 				dev_base = "twa";
-			} else if (twe_found && hz::string_to_lower_copy(vendor) == "3ware") {
+			} else if (twe_found && hz::string_iequals(vendor, "3ware")) {
 				dev_base = "twe";
-			} else if (twl_found && hz::string_to_lower_copy(vendor) == "lsi") {
+			} else if (twl_found && hz::string_iequals(vendor, "lsi")) {
 				dev_base = "twl";
 			}
 			// else we default to twl, twa, twe (in this order)
@@ -601,20 +821,7 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_3ware(
 		std::string dev = std::string("/dev/") + dev_base + hz::number_to_string_nolocale(device_numbers[dev_base]);
 		++device_numbers[dev_base];
 
-		auto exec_status = tw_cli_get_drives(dev, vendor_model.first, drives, ex_factory, false);
-		if (!exec_status) {  // no tw_cli
-			int max_ports = rconfig::get_data<int>("system/linux_3ware_max_scan_port");
-			max_ports = std::max(0, std::min(max_ports, 127));  // Sanity check
-			debug_out_dump("app", "Starting brute-force port scan on 0-" << max_ports << " ports, device \"" << dev
-					<< "\". Change the maximum by setting \"system/linux_3ware_max_scan_port\" config key.\n");
-			std::string last_output;
-			exec_status = smartctl_scan_drives_sequentially(dev, "3ware,%d", 0, max_ports, drives, ex_factory, last_output);
-			debug_out_dump("app", "Brute-force port scan finished.\n");
-		}
-
-		if (!exec_status) {
-			debug_out_warn("app", DBG_FUNC_MSG << "Couldn't get the drives on ports of LSI/AMCC/3ware controller: " << exec_status.error().message() << "\n");
-		}
+		scan_3ware_controller(dev, host_num, drives, ex_factory);
 	}
 
 	if (controller_hosts.empty()) {
@@ -626,6 +833,40 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_3ware(
 
 
 
+/// Query the drive behind Adaptec controller with SCSI host \c host_num, accessible as /dev/sg<sg_num>,
+/// and add it to \c drives.
+/// "-d sat" is tried first, then the default SCSI type.
+inline void probe_adaptec_drive(int host_num, int sg_num, const std::shared_ptr<CommandExecutor>& smartctl_ex, std::vector<StorageDevicePtr>& drives)
+{
+	const std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
+
+	// Each drive has its own node, but the passthrough commands go through the controller.
+	cmdex_set_device_domain(dev, "aacraid:host" + hz::number_to_string_nolocale(host_num));
+	auto drive = std::make_shared<StorageDevice>(dev, std::string("sat"));
+
+	auto fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
+	const std::string output = drive->get_basic_output();
+
+	// Note: Not sure about this, have to check with real SAS drives
+	if (app_regex_partial_match("/Device Read Identity Failed/mi", output)) {
+		// "-d sat" didn't work, default back to smartctl's "-d scsi"
+		drive->clear_parse_results();
+		drive->clear_outputs();
+		drive->set_type_argument("");
+		fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
+	}
+
+	if (!fetch_status) {
+		debug_out_info("app", "Smartctl returned with an error: " << fetch_status.error().message() << "\n");
+		debug_out_dump("app", "Skipping drive " << drive->get_device_with_type() << ".\n");
+	} else {
+		drives.push_back(drive);
+		debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
+	}
+}
+
+
+
 /** <pre>
 Detect drives behind Adaptec RAID controller (aacraid driver).
 Tested using Adaptec RAID 5805 (SAS / SATA controller).
@@ -713,28 +954,7 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_adaptec(
 				continue;
 			}
 
-			const std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
-			auto drive = std::make_shared<StorageDevice>(dev, std::string("sat"));
-
-			auto fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
-			const std::string output = drive->get_basic_output();
-
-			// Note: Not sure about this, have to check with real SAS drives
-			if (app_regex_partial_match("/Device Read Identity Failed/mi", output)) {
-				// "-d sat" didn't work, default back to smartctl's "-d scsi"
-				drive->clear_parse_results();
-				drive->clear_outputs();
-				drive->set_type_argument("");
-				fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
-			}
-
-			if (!fetch_status) {
-				debug_out_info("app", "Smartctl returned with an error: " << fetch_status.error().message() << "\n");
-				debug_out_dump("app", "Skipping drive " << drive->get_device_with_type() << ".\n");
-			} else {
-				drives.push_back(drive);
-				debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
-			}
+			probe_adaptec_drive(host_num, static_cast<int>(sg_num), smartctl_ex, drives);
 		}
 	}
 
@@ -747,6 +967,68 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_adaptec(
 
 
 
+/// Find the drives on the ports of Areca controller having SCSI host \c host_num,
+/// accessible as /dev/sg<sg_num>. The ports (and enclosures) are scanned one by one.
+inline void scan_areca_controller(int host_num, int sg_num, bool has_enclosure,
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	hz::ExpectedVoid<StorageDetectorError> exec_status;
+
+	if (has_enclosure) {
+		// TODO We have no information on what "/sys/bus/scsi/devices/host%d/scsi_host/host%d/host_fw_hd_channels"
+		// contains in case of enclosure-having cards.
+
+		int max_enclosures = rconfig::get_data<int>("system/linux_areca_enc_max_enclosure");
+		max_enclosures = std::max(1, std::min(8, max_enclosures));  // 1-8
+
+		int max_ports = rconfig::get_data<int>("system/linux_areca_enc_max_scan_port");
+		max_ports = std::max(1, std::min(128, max_ports));  // 1-128 sanity check
+
+		std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
+
+		debug_out_dump("app", "Starting brute-force port/enclosure scan on 1-" << max_ports << " ports, 1-" << max_enclosures << " enclosures, device \"" << dev
+				<< "\". Change the maximums by setting \"system/linux_areca_enc_max_scan_port\" and \"system/linux_areca_enc_max_enclosure\" config keys.\n");
+		std::string last_output;
+		for (int enclosure_no = 1; enclosure_no < max_enclosures; ++enclosure_no) {
+			exec_status = smartctl_scan_drives(dev, "areca,%d/" + hz::number_to_string_nolocale(enclosure_no), 1, max_ports, drives, ex_factory, last_output);
+		}
+		debug_out_dump("app", "Brute-force port/enclosure scan finished.\n");
+
+	} else {
+		int max_ports = 0;
+
+		// Read the number of ports.
+		auto ports_file = hz::fs_path_from_string(rconfig::get_data<std::string>("system/linux_sysfs_path"))
+				/ hz::string_sprintf("bus/scsi/devices/host%d/scsi_host/host%d/host_fw_hd_channels", host_num, host_num);
+		std::string ports_file_contents;
+		auto ec = read_proc_file(ports_file, ports_file_contents);
+		if (ec) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Couldn't read the number of ports on Areca controller (\"" << ports_file.string() << "\"): "
+					<< ec.message() << ", trying manually.\n");
+		} else {
+			hz::string_is_numeric_nolocale(hz::string_trim_copy(ports_file_contents), max_ports);
+			debug_out_dump("app", DBG_FUNC_MSG << "Detected " << max_ports << " ports, through \"" << ports_file.string() << "\".\n");
+		}
+		if (max_ports == 0) {
+			max_ports = rconfig::get_data<int>("system/linux_areca_noenc_max_scan_port");
+		}
+		max_ports = std::max(1, std::min(24, max_ports));  // 1-24 sanity check
+
+		std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
+		debug_out_dump("app", "Starting brute-force port scan on 1-" << max_ports << " ports, device \"" << dev
+				<< "\". Change the maximum by setting \"system/linux_areca_noenc_max_scan_port\" config key.\n");
+		std::string last_output;
+		exec_status = smartctl_scan_drives(dev, "areca,%d", 1, max_ports, drives, ex_factory, last_output);
+		debug_out_dump("app", "Brute-force port scan finished.\n");
+	}
+
+	if (!exec_status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Couldn't get the drives on ports of Areca controller: " << exec_status.error().message() << "\n");
+	}
+}
+
+
+
 /** <pre>
 Areca Linux (arcmsr driver):
 Call as:
@@ -839,62 +1121,50 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_areca(
 				continue;
 			}
 
-			hz::ExpectedVoid<StorageDetectorError> exec_status;
+			scan_areca_controller(host_num, static_cast<int>(sg_num), has_enclosure, drives, ex_factory);
+		}
+	}
+
+	return {};
+}
 
-			if (has_enclosure) {
-				// TODO We have no information on what "/sys/bus/scsi/devices/host%d/scsi_host/host%d/host_fw_hd_channels"
-				// contains in case of enclosure-having cards.
 
-				int max_enclosures = rconfig::get_data<int>("system/linux_areca_enc_max_enclosure");
-				max_enclosures = std::max(1, std::min(8, max_enclosures));  // 1-8
 
-				int max_ports = rconfig::get_data<int>("system/linux_areca_enc_max_scan_port");
-				max_ports = std::max(1, std::min(128, max_ports));  // 1-128 sanity check
+/// Find the drives on the ports of HP RAID (CCISS) controller number \c controller_no
+/// by scanning the ports one by one.
+inline void scan_cciss_controller(int controller_no, std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	std::string dev = std::string("/dev/cciss/c") + hz::number_to_string_nolocale(controller_no) + "d0";
 
-				std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
+	const int max_port = 127;
+	debug_out_dump("app", "Starting brute-force port scan on 1-" << max_port << " ports, device \"" << dev << "\".\n");
 
-				debug_out_dump("app", "Starting brute-force port/enclosure scan on 1-" << max_ports << " ports, 1-" << max_enclosures << " enclosures, device \"" << dev
-						<< "\". Change the maximums by setting \"system/linux_areca_enc_max_scan_port\" and \"system/linux_areca_enc_max_enclosure\" config keys.\n");
-				std::string last_output;
-				for (int enclosure_no = 1; enclosure_no < max_enclosures; ++enclosure_no) {
-					exec_status = smartctl_scan_drives_sequentially(dev, "areca,%d/" + hz::number_to_string_nolocale(enclosure_no), 1, max_ports, drives, ex_factory, last_output);
-				}
-				debug_out_dump("app", "Brute-force port/enclosure scan finished.\n");
+	auto classify = [](int port, const StorageDevicePtr& drive, const hz::ExpectedVoid<StorageDeviceError>& fetch_status)
+	{
+		const std::string& output = drive->get_basic_output();
 
-			} else {
-				int max_ports = 0;
-
-				// Read the number of ports.
-				auto ports_file = hz::fs_path_from_string(hz::string_sprintf("/sys/bus/scsi/devices/host%d/scsi_host/host%d/host_fw_hd_channels", host_num, host_num));
-				std::string ports_file_contents;
-				auto ec = read_proc_file(ports_file, ports_file_contents);
-				if (ec) {
-					debug_out_warn("app", DBG_FUNC_MSG << "Couldn't read the number of ports on Areca controller (\"" << ports_file.string() << "\"): "
-							<< ec.message() << ", trying manually.\n");
-				} else {
-					hz::string_is_numeric_nolocale(hz::string_trim_copy(ports_file_contents), max_ports);
-					debug_out_dump("app", DBG_FUNC_MSG << "Detected " << max_ports << " ports, through \"" << ports_file.string() << "\".\n");
-				}
-				if (max_ports == 0) {
-					max_ports = rconfig::get_data<int>("system/linux_areca_noenc_max_scan_port");
-				}
-				max_ports = std::max(1, std::min(24, max_ports));  // 1-24 sanity check
-
-				std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
-				debug_out_dump("app", "Starting brute-force port scan on 1-" << max_ports << " ports, device \"" << dev
-						<< "\". Change the maximum by setting \"system/linux_areca_noenc_max_scan_port\" config key.\n");
-				std::string last_output;
-				exec_status = smartctl_scan_drives_sequentially(dev, "areca,%d", 1, max_ports, drives, ex_factory, last_output);
-				debug_out_dump("app", "Brute-force port scan finished.\n");
-			}
+		if (!fetch_status) {
+			debug_out_info("app", "Smartctl returned with an error: " << fetch_status.error().message() << "\n");
+		}
 
-			if (!exec_status) {
-				debug_out_warn("app", DBG_FUNC_MSG << "Couldn't get the drives on ports of Areca controller: " << exec_status.error().message() << "\n");
-			}
+		if (app_regex_partial_match("/VALID ARGUMENTS ARE/mi", output)) {
+			// smartctl doesn't support this many ports, return.
+			debug_out_dump("app", "Reached smartctl port limit with port " << port << ", stopping port scan.\n");
+			return SmartctlPortProbeStatus::StopScan;
+		}
+		if (app_regex_partial_match("/No such device or address/mi", output) && port > 15) {
+			// we've reached the controller port limit
+			debug_out_dump("app", "Reached controller port limit with port " << port << ", stopping port scan.\n");
+			return SmartctlPortProbeStatus::StopScan;
 		}
-	}
 
-	return {};
+		return fetch_status ? SmartctlPortProbeStatus::Populated : SmartctlPortProbeStatus::Empty;
+	};
+
+	std::string last_output;
+	smartctl_probe_ports(dev, "cciss,%d", 0, max_port, classify, drives, ex_factory, last_output);
+
+	debug_out_dump("app", "Brute-force port scan finished.\n");
 }
 
 
@@ -955,47 +1225,45 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_cciss(
 		return {};  // no controllers
 	}
 
-	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
-
 	for (int controller_no : controllers) {
-		std::string dev = std::string("/dev/cciss/c") + hz::number_to_string_nolocale(controller_no) + "d0";
+		scan_cciss_controller(controller_no, drives, ex_factory);
+	}
 
-		const int max_port = 127;
-		debug_out_dump("app", "Starting brute-force port scan on 1-" << max_port << " ports, device \"" << dev << "\".\n");
+	return {};
+}
 
-		for (int port = 0; port <= max_port; ++port) {
-			auto drive = std::make_shared<StorageDevice>(dev, std::string("cciss,") + hz::number_to_string_nolocale(port));
 
-			auto fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
-			std::string output = drive->get_basic_output();
 
-			if (!fetch_status) {
-				debug_out_info("app", "Smartctl returned with an error: " << fetch_status.error().message() << "\n");
-			}
+/// Find the drives on the ports of HP RAID (hpsa / hpahcisr) controller accessible
+/// as /dev/sg<sg_num> by scanning the ports one by one.
+inline void scan_hpsa_controller(int sg_num, std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
 
-			if (app_regex_partial_match("/VALID ARGUMENTS ARE/mi", output)) {
-				// smartctl doesn't support this many ports, return.
-				debug_out_dump("app", "Reached smartctl port limit with port " << port << ", stopping port scan.\n");
-				break;
-			}
-			if (app_regex_partial_match("/No such device or address/mi", output) && port > 15) {
-				// we've reached the controller port limit
-				debug_out_dump("app", "Reached controller port limit with port " << port << ", stopping port scan.\n");
-				break;
-			}
+	const int max_port = 127;
+	debug_out_dump("app", "Starting brute-force port scan on 0-" << max_port << " ports, device \"" << dev << "\".\n");
 
-			if (fetch_status) {
-				drives.push_back(drive);
-				debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
-			} else {
-				debug_out_dump("app", "Skipping drive " << drive->get_device_with_type() << " due to smartctl error.\n");
-			}
+	auto classify = [](int port, const StorageDevicePtr& drive, const hz::ExpectedVoid<StorageDeviceError>& fetch_status)
+	{
+		const std::string& output = drive->get_basic_output();
+
+		if (app_regex_partial_match("/No such device or address/mi", output)
+				|| app_regex_partial_match("/VALID ARGUMENTS ARE/mi", output)) {
+			// We reached the controller port limit, or smartctl-supported port limit.
+			debug_out_dump("app", "Reached controller or smartctl port limit with port " << port << ", stopping port scan.\n");
+			return SmartctlPortProbeStatus::StopScan;
+		}
+		if (!fetch_status) {
+			debug_out_info("app", "Smartctl returned with an error: " << fetch_status.error().message() << "\n");
+			return SmartctlPortProbeStatus::Empty;
 		}
+		return SmartctlPortProbeStatus::Populated;
+	};
 
-		debug_out_dump("app", "Brute-force port scan finished.\n");
-	}
+	std::string last_output;
+	smartctl_probe_ports(dev, "cciss,%d", 0, max_port, classify, drives, ex_factory, last_output);
 
-	return {};
+	debug_out_dump("app", "Brute-force port scan finished.\n");
 }
 
 
@@ -1035,8 +1303,6 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_hpsa(
 		return hz::Unexpected(StorageDetectorError::ProcReadError, error_msg);
 	}
 
-	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
-
 	std::set<int> controller_hosts;
 
 	for (auto& vendor_model : vendors_models) {
@@ -1065,38 +1331,130 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_hpsa(
 				continue;
 			}
 
-			std::string dev = std::string("/dev/sg") + hz::number_to_string_nolocale(sg_num);
+			scan_hpsa_controller(static_cast<int>(sg_num), drives, ex_factory);
+		}
+	}
 
-			const int max_port = 127;
-			debug_out_dump("app", "Starting brute-force port scan on 0-" << max_port << " ports, device \"" << dev << "\".\n");
+	if (controller_hosts.empty()) {
+		debug_out_info("app", DBG_FUNC_MSG << "No hpsa/hpahcisr-specific entries found in Sg devices file.\n");
+	}
 
-			for (int port = 0; port <= max_port; ++port) {
-				auto drive = std::make_shared<StorageDevice>(dev, std::string("cciss,") + hz::number_to_string_nolocale(port));
+	return {};
+}
 
-				auto fetch_status = drive->fetch_basic_data_and_parse(smartctl_ex);
-				std::string output = drive->get_basic_output();
 
-				if (app_regex_partial_match("/No such device or address/mi", output)
-						|| app_regex_partial_match("/VALID ARGUMENTS ARE/mi", output)) {
-					// We reached the controller port limit, or smartctl-supported port limit.
-					debug_out_dump("app", "Reached controller or smartctl port limit with port " << port << ", stopping port scan.\n");
-					break;
-				}
-				if (!fetch_status) {
-					debug_out_info("app", "Smartctl returned with an error: " << fetch_status.error().message() << "\n");
-					debug_out_dump("app", "Skipping drive " << drive->get_device_with_type() << " due to smartctl error.\n");
-				} else {
-					drives.push_back(drive);
-					debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
-				}
-			}
 
-			debug_out_dump("app", "Brute-force port scan finished.\n");
+/// Detect drives using /sys/block. Partitions and virtual devices are not listed there
+/// as whole disks with a "device" link, so no name-based filtering is needed for them.
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_sysfs_block(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives through sysfs block devices (/sys by default; set \"system/linux_sysfs_path\" config key to override).\n");
+
+	const LinuxSysfsInfo info = get_sysfs_info();
+
+	std::vector<std::string> devices;
+	for (const auto& dev : info.block_disks) {
+		if (!is_ignored_device_linux(dev)) {
+			devices.push_back(dev);
 		}
 	}
 
-	if (controller_hosts.empty()) {
-		debug_out_info("app", DBG_FUNC_MSG << "No hpsa/hpahcisr-specific entries found in Sg devices file.\n");
+	fetch_linux_block_drives(devices, drives, ex_factory);
+
+	return {};
+}
+
+
+
+/// Detect drives behind 3ware RAID controllers using sysfs. The controllers are found by
+/// the driver name of their SCSI hosts, so there is no need to guess twa / twe / twl
+/// from the vendor names. See detect_drives_linux_3ware() for details.
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_sysfs_3ware(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives behind 3ware controller(s) using sysfs...\n");
+
+	static const std::map<std::string, std::string> driver_devices = {
+		{"3w-9xxx", "twa"},
+		{"3w-xxxx", "twe"},
+		{"3w-sas", "twl"},
+	};
+
+	const LinuxSysfsInfo info = get_sysfs_info();
+	std::map<std::string, int> device_numbers;  // device base (e.g. twa) -> number of times found
+
+	// Hosts are sorted by number. Assume twaX have the same relative order.
+	for (const auto& [host_num, driver] : info.host_drivers) {
+		auto iter = driver_devices.find(driver);
+		if (iter == driver_devices.end()) {
+			continue;
+		}
+		const std::string& dev_base = iter->second;
+		const std::string dev = std::string("/dev/") + dev_base + hz::number_to_string_nolocale(device_numbers[dev_base]);
+		++device_numbers[dev_base];
+
+		debug_out_dump("app", "Found " << driver << " controller, SCSI host " << host_num << ", device " << dev << ".\n");
+		scan_3ware_controller(dev, host_num, drives, ex_factory);
+	}
+
+	return {};
+}
+
+
+
+/// Detect drives behind Adaptec RAID controllers (aacraid driver) using sysfs.
+/// See detect_drives_linux_adaptec() for details.
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_sysfs_adaptec(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives behind Adaptec controller(s) using sysfs...\n");
+
+	const LinuxSysfsInfo info = get_sysfs_info();
+	std::shared_ptr<CommandExecutor> smartctl_ex;
+
+	for (const auto& dev : info.scsi_devices) {
+		auto driver_iter = info.host_drivers.find(dev.host);
+		if (driver_iter == info.host_drivers.end() || driver_iter->second != "aacraid") {
+			continue;
+		}
+		if (dev.id <= 0 || dev.sg_num < 0) {
+			continue;  // scsi id 0 is the controller, probably
+		}
+		if (!smartctl_ex) {
+			smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+		}
+		probe_adaptec_drive(dev.host, dev.sg_num, smartctl_ex, drives);
+	}
+
+	return {};
+}
+
+
+
+/// Detect drives behind Areca RAID controllers (arcmsr driver) using sysfs.
+/// See detect_drives_linux_areca() for details.
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_sysfs_areca(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives behind Areca controller(s) using sysfs...\n");
+
+	const LinuxSysfsInfo info = get_sysfs_info();
+
+	for (const auto& dev : info.scsi_devices) {
+		auto driver_iter = info.host_drivers.find(dev.host);
+		if (driver_iter == info.host_drivers.end() || driver_iter->second != "arcmsr") {
+			continue;
+		}
+		// The controller itself has type 3 and id 16 (as per smartmontools), the rest are volumes.
+		if (dev.id != 16 || dev.type != 3 || dev.sg_num < 0) {
+			continue;
+		}
+		const bool has_enclosure = app_regex_partial_match("/ix/i", dev.model);
+		debug_out_dump("app", "Found Areca controller, SCSI host " << dev.host << ", model \"" << dev.model << "\", "
+				<< (has_enclosure ? "with enclosure(s)" : "without enclosures") << ".\n");
+
+		scan_areca_controller(dev.host, dev.sg_num, has_enclosure, drives, ex_factory);
 	}
 
 	return {};
@@ -1104,10 +1462,125 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_hpsa(
 
 
 
+/// Detect drives behind HP RAID controllers (cciss driver) using sysfs.
+/// The controllers are taken from /sys/block "cciss!cNdM" entries.
+/// See detect_drives_linux_cciss() for details.
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_sysfs_cciss(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives behind HP RAID (CCISS) controller(s) using sysfs...\n");
+
+	const LinuxSysfsInfo info = get_sysfs_info();
+
+	std::set<int> controllers;
+	for (const auto& dev : info.block_disks) {
+		const std::string prefix = "cciss/c";
+		int controller_no = -1;
+		if (dev.starts_with(prefix) && hz::string_is_numeric_nolocale(dev.substr(prefix.size()), controller_no, false)) {
+			controllers.insert(controller_no);
+		}
+	}
+
+	for (int controller_no : controllers) {
+		scan_cciss_controller(controller_no, drives, ex_factory);
+	}
+
+	return {};
+}
+
+
+
+/// Detect drives behind HP RAID controllers (hpsa / hpahcisr drivers) using sysfs.
+/// See detect_drives_linux_hpsa() for details.
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_sysfs_hpsa(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives behind HP RAID (hpsa/hpahcisr) controller(s) using sysfs...\n");
+
+	const LinuxSysfsInfo info = get_sysfs_info();
+
+	for (const auto& dev : info.scsi_devices) {
+		auto driver_iter = info.host_drivers.find(dev.host);
+		if (driver_iter == info.host_drivers.end() || (driver_iter->second != "hpsa" && driver_iter->second != "hpahcisr")) {
+			continue;
+		}
+		// Use the nodes of the controllers, not of the logical drives.
+		if (dev.sg_num < 0 || app_regex_partial_match("/LOGICAL VOLUME/i", dev.model)) {
+			continue;
+		}
+		debug_out_dump("app", "Found HP controller, SCSI host " << dev.host << ", /dev/sg" << dev.sg_num << ".\n");
+		scan_hpsa_controller(dev.sg_num, drives, ex_factory);
+	}
+
+	return {};
+}
+
+
+
+/// Detect the drives with a single "smartctl --scan-open" instead of probing each block device,
+/// falling back to \c block_detector if it fails or finds nothing.
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_scan_open(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory,
+		hz::ExpectedVoid<StorageDetectorError> (*block_detector)(std::vector<StorageDevicePtr>&, const CommandExecutorFactoryPtr&))
+{
+	// The 3ware controllers, which export themselves as sd* too, are filtered out by
+	// detect_drives_scan_open() the same way as by the block detectors.
+	std::vector<StorageDevicePtr> scanned;
+	if (auto status = detect_drives_scan_open(scanned, ex_factory); !status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Smartctl --scan-open failed, probing each device instead: "
+				<< status.error().message() << "\n");
+		return block_detector(drives, ex_factory);
+	}
+	if (scanned.empty()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Smartctl --scan-open found no drives, probing each device instead.\n");
+		return block_detector(drives, ex_factory);
+	}
+	drives.insert(drives.end(), scanned.begin(), scanned.end());
+	return {};
+}
+
+
+
+/// Block device detection through smartctl --scan-open, with sysfs as fallback
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_scan_open_or_sysfs(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	return detect_drives_linux_scan_open(drives, ex_factory, &detect_drives_linux_sysfs_block);
+}
+
+
+
+/// Block device detection through smartctl --scan-open, with /proc/partitions as fallback
+inline hz::ExpectedVoid<StorageDetectorError> detect_drives_linux_scan_open_or_proc(
+		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	return detect_drives_linux_scan_open(drives, ex_factory, &detect_drives_linux_proc_partitions);
+}
+
+
+
 }  // anon ns
 
 
 
+bool is_ignored_device_linux(const std::string& dev)
+{
+	static const std::vector<std::string> blacklist = {
+		"/d[a-z][0-9]+$/",  // sda1, hdb2 - partitions. twa0 and twe1 are drives, not partitions.
+		"/ram[0-9]+$/",  // ramdisks?
+		"/loop[0-9]*$/",  // not sure if loop devices go there, but anyway...
+		"/part[0-9]+$/",  // devfs had them
+		"/p[0-9]+$/",  // partitions are usually marked this way
+		"/md[0-9]*$/",  // linux software raid
+		"/dm-[0-9]*$/",  // linux device mapper
+	};
+
+	return std::any_of(blacklist.cbegin(), blacklist.cend(),
+			[&dev](const std::string& pattern) { return app_regex_partial_match(pattern, dev); });
+}
+
+
+
 
 hz::ExpectedVoid<StorageDetectorError> detect_drives_linux(
 		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
@@ -1115,7 +1588,6 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_linux(
 	clear_read_file_cache();
 
 	std::vector<std::string> error_msgs;
-	hz::ExpectedVoid<StorageDetectorError> status;
 
 	// Disable by-id detection - it's unreliable on broken systems.
 	// For example, on Ubuntu 8.04, /dev/disk/by-id contains two device
@@ -1123,34 +1595,77 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_linux(
 	// sda and sdb). Plus, there are no "*-partN" files (not that we need them).
 // 	error_message = detect_drives_linux_udev_byid(devices);  // linux udev
 
-	status = detect_drives_linux_proc_partitions(drives, ex_factory);
-	if (!status) {
-		error_msgs.push_back(status.error().message());
-	}
+	/// A detection backend
+	using detector_func_t = hz::ExpectedVoid<StorageDetectorError> (*)(std::vector<StorageDevicePtr>&, const CommandExecutorFactoryPtr&);
 
-	status = detect_drives_linux_3ware(drives, ex_factory);
-	if (!status) {
-		error_msgs.push_back(status.error().message());
-	}
+	/// A detection backend and its name (for tracing)
+	struct Detector {
+		const char* name = nullptr;  ///< Function name
+		detector_func_t func = nullptr;  ///< Backend
+	};
 
-	status = detect_drives_linux_areca(drives, ex_factory);
-	if (!status) {
-		error_msgs.push_back(status.error().message());
+	// The backends look at different controllers, so they can run in parallel.
+	// They are listed in the order their results are merged.
+	// The sysfs ones read structured per-device attributes instead of parsing /proc files,
+	// which may be missing altogether (/proc/scsi) on newer kernels.
+	std::vector<Detector> detectors = get_use_sysfs_detection()
+		? std::vector<Detector> {
+			{"detect_drives_linux_sysfs_block", &detect_drives_linux_sysfs_block},
+			{"detect_drives_linux_sysfs_3ware", &detect_drives_linux_sysfs_3ware},
+			{"detect_drives_linux_sysfs_areca", &detect_drives_linux_sysfs_areca},
+			{"detect_drives_linux_sysfs_adaptec", &detect_drives_linux_sysfs_adaptec},
+			{"detect_drives_linux_sysfs_cciss", &detect_drives_linux_sysfs_cciss},
+			{"detect_drives_linux_sysfs_hpsa", &detect_drives_linux_sysfs_hpsa},
+		}
+		: std::vector<Detector> {
+			{"detect_drives_linux_proc_partitions", &detect_drives_linux_proc_partitions},
+			{"detect_drives_linux_3ware", &detect_drives_linux_3ware},
+			{"detect_drives_linux_areca", &detect_drives_linux_areca},
+			{"detect_drives_linux_adaptec", &detect_drives_linux_adaptec},
+			{"detect_drives_linux_cciss", &detect_drives_linux_cciss},
+			{"detect_drives_linux_hpsa", &detect_drives_linux_hpsa},
+		};
+
+	// A single smartctl --scan-open replaces probing each block device. Smartctl doesn't
+	// know about the other controllers, so their detectors are kept.
+	if (get_use_scan_open_detection()) {
+		if (detectors.front().func == &detect_drives_linux_sysfs_block) {
+			detectors.front() = {"detect_drives_linux_scan_open_or_sysfs", &detect_drives_linux_scan_open_or_sysfs};
+		} else {
+			detectors.front() = {"detect_drives_linux_scan_open_or_proc", &detect_drives_linux_scan_open_or_proc};
+		}
 	}
 
-	status = detect_drives_linux_adaptec(drives, ex_factory);
-	if (!status) {
-		error_msgs.push_back(status.error().message());
-	}
+	const auto max_parallel = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/linux_max_parallel_detectors")));
+	const CommandExecutorFactoryPtr detector_factory = (max_parallel > 1)
+			? command_executor_factory_for_worker_threads(ex_factory) : ex_factory;
 
-	status = detect_drives_linux_cciss(drives, ex_factory);
-	if (!status) {
-		error_msgs.push_back(status.error().message());
-	}
+	std::vector<std::vector<StorageDevicePtr>> detected_drives(detectors.size());
+	std::vector<hz::ExpectedVoid<StorageDetectorError>> statuses(detectors.size());
 
-	status = detect_drives_linux_hpsa(drives, ex_factory);
-	if (!status) {
-		error_msgs.push_back(status.error().message());
+	app_run_worker_tasks(detectors.size(), max_parallel, [&](std::size_t i) {
+		if (app_is_cancelled(detector_factory->get_cancellation())) {
+			return;  // the remaining backends are skipped, the partial results are kept
+		}
+		const AppTraceSpan trace_span(detectors[i].name, "detector");
+		statuses[i] = detectors[i].func(detected_drives[i], detector_factory);
+	});
+
+	// Merge the results in backend order, skipping the drives already found by previous backends.
+	for (std::size_t i = 0; i < detectors.size(); ++i) {
+		for (const auto& drive : detected_drives[i]) {
+			const bool duplicate = std::any_of(drives.begin(), drives.end(), [&drive](const StorageDevicePtr& existing) {
+				return existing->get_device_with_type() == drive->get_device_with_type();
+			});
+			if (duplicate) {
+				debug_out_dump("app", "Drive " << drive->get_device_with_type() << " detected more than once, ignoring.\n");
+				continue;
+			}
+			drives.push_back(drive);
+		}
+		if (!statuses[i]) {
+			error_msgs.push_back(statuses[i].error().message());
+		}
 	}
 
 	if (!error_msgs.empty()) {
@@ -29,6 +29,11 @@ Copyright:
 		const CommandExecutorFactoryPtr& ex_factory);
 
 
+/// Check whether a block device name (e.g. "sda", "loop0", "dm-1") is one of the
+/// kinds that the Linux drive detection ignores (partitions, ramdisks, loop devices, etc.).
+[[nodiscard]] bool is_ignored_device_linux(const std::string& dev);
+
+
 
 
 #endif
@@ -14,24 +14,92 @@ Copyright:
 #include <glibmm.h>
 #include <algorithm>  // std::sort
 #include <cerrno>
+#include <optional>
+#include <regex>
 
 #if defined CONFIG_KERNEL_OPENBSD || defined CONFIG_KERNEL_NETBSD
 	#include <util.h>  // getrawpartition()
 #endif
 
+#if defined CONFIG_KERNEL_FREEBSD
+	#include <sys/types.h>
+	#include <sys/sysctl.h>  // sysctlbyname()
+#endif
+
 #include "fmt/format.h"
 #include "hz/debug.h"
 #include "hz/fs.h"
 #include "rconfig/rconfig.h"
 #include "app_regex.h"
 #include "storage_detector_other.h"
+#include "storage_detector_scan_open.h"
+
+
+
+namespace {
+
+	/// Get the names of the disks known to the kernel (relative to /dev), without
+	/// listing /dev. \return std::nullopt if not supported on this OS, or on error.
+	std::optional<std::vector<std::string>> detect_drives_other_get_native_disk_names()
+	{
+	#if defined CONFIG_KERNEL_FREEBSD
+		// kern.disks is a space-separated list of the disk devices, e.g. "ada1 ada0 da0".
+		// Unlike /dev, it contains no dummy devices.
+		std::size_t size = 0;
+		if (sysctlbyname("kern.disks", nullptr, &size, nullptr, 0) != 0) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot get the size of kern.disks, errno " << errno << ".\n");
+			return std::nullopt;
+		}
+		std::string value(size, '\0');
+		if (size != 0 && sysctlbyname("kern.disks", value.data(), &size, nullptr, 0) != 0) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot read kern.disks, errno " << errno << ".\n");
+			return std::nullopt;
+		}
+		value.resize(std::min(size, value.size()));
+		return storage_detector_other_parse_disk_list(value);
+	#else
+		return std::nullopt;
+	#endif
+	}
+
+}
+
+
 
+std::vector<std::string> storage_detector_other_parse_disk_list(std::string_view list)
+{
+	using namespace std::literals;
+	std::vector<std::string> names;
+	std::size_t pos = 0;
+	while (pos < list.size()) {
+		const std::size_t start = list.find_first_not_of(" \t\n\0"sv, pos);
+		if (start == std::string_view::npos) {
+			break;
+		}
+		const std::size_t end = std::min(list.find_first_of(" \t\n\0"sv, start), list.size());
+		names.emplace_back(list.substr(start, end - start));
+		pos = end;
+	}
+	std::sort(names.begin(), names.end());
+	return names;
+}
 
 
 
 hz::ExpectedVoid<StorageDetectorError> detect_drives_other(std::vector<StorageDevicePtr>& drives,
-		[[maybe_unused]] const CommandExecutorFactoryPtr& ex_factory)
+		const CommandExecutorFactoryPtr& ex_factory)
 {
+	// A single smartctl --scan-open is much faster than checking each /dev entry.
+	if (get_use_scan_open_detection()) {
+		std::vector<StorageDevicePtr> scanned;
+		auto scan_status = detect_drives_scan_open(scanned, ex_factory);
+		if (scan_status && !scanned.empty()) {
+			drives.insert(drives.end(), scanned.begin(), scanned.end());
+			return {};
+		}
+		debug_out_warn("app", DBG_FUNC_MSG << "Smartctl --scan-open found no drives, checking /dev instead.\n");
+	}
+
 	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives through /dev...\n");
 
 	std::vector<std::string> devices;
@@ -178,27 +246,51 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_other(std::vector<StorageDe
 	}  // unix platforms
 
 
+	// Compile the patterns once, /dev may have thousands of entries.
+	std::vector<std::regex> matchers;
+	matchers.reserve(whitelist.size());
+	for (const auto& wl_pattern : whitelist) {
+		matchers.push_back(app_regex_re(wl_pattern));
+	}
+	auto name_matches = [&matchers](const std::string& name) {
+		return std::any_of(matchers.begin(), matchers.end(),
+				[&name](const std::regex& re) { return app_regex_partial_match(re, name); });
+	};
+
 	std::vector<hz::fs::path> matched_devices;
-	std::error_code ec;
-	for(const auto& entry : hz::fs::directory_iterator(dir, ec)) {
-		const auto& path = entry.path();
-
-		bool matched = false;
-		for (const auto& wl_pattern : whitelist) {
-			if (app_regex_partial_match(wl_pattern, path.filename().string())) {
-				matched = true;
-				break;
+	bool native_inventory_used = false;
+
+	// The kernel's disk list, if available, avoids listing (and matching) the whole /dev.
+	// It's relative to /dev, so it's only used if the device directory is the default one.
+	if (auto native_names = detect_drives_other_get_native_disk_names();
+			native_names.has_value() && !native_names->empty() && dir == hz::fs::path("/dev")) {
+		for (const auto& name : native_names.value()) {
+			if (name_matches(name)) {
+				matched_devices.push_back(dir / hz::fs_path_from_string(name));
 			}
 		}
-		if (!matched)
-			continue;
+		native_inventory_used = !matched_devices.empty();
+		if (native_inventory_used) {
+			debug_out_info("app", DBG_FUNC_MSG << "Using the kernel disk list instead of listing /dev.\n");
+		}
+	}
 
-		// In case these are links, check if the originals exists (solaris has dangling links, filter them out).
-		// We don't replace /dev files with real devices - it leads to really bad paths (pci ids for solaris, etc.).
-		if (!hz::fs::exists(path)) {
-			continue;
+	std::error_code ec;
+	if (!native_inventory_used) {
+		for (const auto& entry : hz::fs::directory_iterator(dir, ec)) {
+			const auto& path = entry.path();
+			if (!name_matches(path.filename().string()))
+				continue;
+
+			// In case these are links, check if the originals exists (solaris has dangling links, filter them out).
+			// We don't replace /dev files with real devices - it leads to really bad paths (pci ids for solaris, etc.).
+			// The entry type usually comes from the directory listing itself, so only the links need a stat().
+			std::error_code entry_ec;
+			if (entry.is_symlink(entry_ec) && !hz::fs::exists(path, entry_ec)) {
+				continue;
+			}
+			matched_devices.push_back(path);
 		}
-		matched_devices.push_back(path);
 	}
 	if (ec) {
 		debug_out_error("app", DBG_FUNC_MSG << "Cannot list device directory entries.\n");
@@ -221,7 +313,8 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_other(std::vector<StorageDe
 		// Don't do this on solaris - we can't distinguish between cdroms and hds there.
 
 		// If there are less than 4 devices, they are probably not dummy (newer freebsd).
-		bool open_needed = (matched_devices.size() >= 4);
+		// The kernel disk list has no dummy devices.
+		bool open_needed = (!native_inventory_used && matched_devices.size() >= 4);
 		if (open_needed) {
 			debug_out_info("app", DBG_FUNC_MSG << "Number of matched devices is "
 					<< matched_devices.size() << ", will try to filter non-existent ones out.\n");
@@ -15,6 +15,7 @@ Copyright:
 #include "build_config.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "command_executor_factory.h"
@@ -27,6 +28,11 @@ Copyright:
 		const CommandExecutorFactoryPtr& ex_factory);
 
 
+/// Parse a whitespace-separated disk name list (e.g. FreeBSD's kern.disks sysctl value,
+/// "ada1 ada0 da0"). \return sorted names.
+[[nodiscard]] std::vector<std::string> storage_detector_other_parse_disk_list(std::string_view list);
+
+
 
 #endif
 
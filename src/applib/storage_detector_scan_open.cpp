@@ -0,0 +1,177 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>  // std::max
+#include <string>
+
+#include "nlohmann/json.hpp"
+#include "hz/debug.h"
+#include "hz/fs.h"
+#include "hz/string_algo.h"
+#include "rconfig/rconfig.h"
+
+#include "app_regex.h"
+#include "smartctl_executor.h"  // get_smartctl_binary
+#include "storage_detector_scan_open.h"
+#include "storage_settings.h"
+#include "worker_threads.h"
+
+
+
+namespace {
+
+	/// Fetch the basic data of the drives found by smartctl --scan-open and add the ones which
+	/// answered to \c drives, like the block device detectors do, so that the detected drives have
+	/// their type. Up to "system/smartctl_max_parallel_fetches" drives are queried at once.
+	void fetch_scan_open_drives(const std::vector<StorageDevicePtr>& scanned, std::vector<StorageDevicePtr>& drives,
+			const CommandExecutorFactoryPtr& ex_factory)
+	{
+		const auto max_parallel = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/smartctl_max_parallel_fetches")));
+		const CommandExecutorFactoryPtr fetch_factory = (max_parallel > 1)
+				? command_executor_factory_for_worker_threads(ex_factory) : ex_factory;
+		const RemoteHostPtr remote_host = ex_factory->get_remote_host();
+
+		std::vector<char> fetched(scanned.size(), 0);  // not vector<bool>, it's written from several threads
+
+		app_run_worker_tasks(scanned.size(), max_parallel, [&](std::size_t i) {
+			if (app_is_cancelled(fetch_factory->get_cancellation())) {
+				return;
+			}
+			if (remote_host) {  // the drive's host is where its commands run
+				scanned[i]->set_remote_host(remote_host);
+			}
+			const auto smartctl_ex = fetch_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+			fetched[i] = scanned[i]->fetch_basic_data_and_parse(smartctl_ex) ? 1 : 0;
+		});
+
+		for (std::size_t i = 0; i < scanned.size(); ++i) {
+			const auto& drive = scanned[i];
+			if (!fetched[i]) {
+				debug_out_dump("app", "Skipping drive " << drive->get_device_with_type() << " due to smartctl error.\n");
+				continue;
+			}
+			// 3ware controllers also export themselves as sd*, see fetch_linux_block_drives().
+			if (app_regex_partial_match("/try adding '-d 3ware,N'/im", drive->get_basic_output())) {
+				debug_out_dump("app", "Drive " << drive->get_device_with_type() << " seems to be a 3ware controller, ignoring.\n");
+				continue;
+			}
+			drives.push_back(drive);
+			debug_out_info("app", "Added drive " << drive->get_device_with_type() << ".\n");
+		}
+	}
+
+}
+
+
+
+hz::ExpectedVoid<StorageDetectorError> parse_scan_open_json(std::string_view json_output,
+		std::vector<StorageDevicePtr>& drives)
+{
+	nlohmann::json root;
+	try {
+		root = nlohmann::json::parse(json_output);
+	}
+	catch (nlohmann::json::parse_error& e) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot parse smartctl --scan-open output: " << e.what() << "\n");
+		return hz::Unexpected(StorageDetectorError::ParseError, _("Cannot parse smartctl output."));
+	}
+
+	const auto devices_iter = root.find("devices");
+	if (devices_iter == root.end() || !devices_iter->is_array()) {
+		// No "devices" means no devices (or a very old smartctl which doesn't support --json).
+		if (root.contains("json_format_version")) {
+			return {};
+		}
+		return hz::Unexpected(StorageDetectorError::UnsupportedCommandVersion,
+				"Unsupported smartctl version: Smartctl doesn't support --scan-open with --json.");
+	}
+
+	for (const auto& entry : *devices_iter) {
+		if (!entry.is_object() || !entry.contains("name") || !entry.at("name").is_string()) {
+			continue;
+		}
+		const auto name = entry.at("name").get<std::string>();
+		const auto type = entry.value("type", std::string());
+		if (entry.contains("open_error")) {
+			debug_out_dump("app", "Skipping " << name << " (-d " << type << "), it could not be opened: "
+					<< entry.at("open_error").dump() << "\n");
+			continue;
+		}
+		// Types like "sat" or "nvme" are autodetected by smartctl anyway. Keep them empty,
+		// so that the drives (and their cached data, history, etc.) are the same as with the other detectors.
+		const bool type_needed = type.find(',') != std::string::npos;
+		drives.push_back(std::make_shared<StorageDevice>(name, type_needed ? type : std::string()));
+		debug_out_dump("app", "Found drive " << drives.back()->get_device_with_type() << ".\n");
+	}
+
+	return {};
+}
+
+
+
+bool get_use_scan_open_detection()
+{
+	return rconfig::get_data<bool>("system/use_scan_open_detection");
+}
+
+
+
+hz::ExpectedVoid<StorageDetectorError> detect_drives_scan_open(std::vector<StorageDevicePtr>& drives,
+		const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", DBG_FUNC_MSG << "Detecting drives through smartctl --scan-open...\n");
+
+	const RemoteHostPtr remote_host = ex_factory->get_remote_host();
+	auto smartctl_binary = remote_host ? hz::fs_path_from_string(remote_host->get_smartctl_binary()) : get_smartctl_binary();
+	if (smartctl_binary.empty()) {
+		debug_out_error("app", DBG_FUNC_MSG << "Smartctl binary is not set in config.\n");
+		return hz::Unexpected(StorageDetectorError::NoSmartctlBinary, _("Smartctl binary is not specified in configuration."));
+	}
+
+	auto smartctl_options = app_get_smartctl_default_options();
+	if (!smartctl_options.has_value()) {
+		return hz::Unexpected(StorageDetectorError::InvalidCommandLine, _("Invalid command line specified."));
+	}
+	smartctl_options->emplace_back("--scan-open");
+	smartctl_options->emplace_back("--json");
+
+	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+	smartctl_ex->set_command(hz::fs_path_to_string(smartctl_binary), smartctl_options.value());
+
+	if (const bool execute_status = smartctl_ex->execute(); !execute_status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Smartctl binary did not execute cleanly.\n");
+		return hz::Unexpected(StorageDetectorError::SmartctlExecutionError, smartctl_ex->get_error_msg());
+	}
+
+	const std::string output = hz::string_trim_copy(smartctl_ex->get_stdout_str());
+	if (output.empty()) {
+		debug_out_error("app", DBG_FUNC_MSG << "Smartctl returned an empty output.\n");
+		return hz::Unexpected(StorageDetectorError::EmptyCommandOutput, _("Smartctl returned an empty output."));
+	}
+	if (app_regex_partial_match("/UNRECOGNIZED OPTION/mi", output)) {
+		return hz::Unexpected(StorageDetectorError::UnsupportedCommandVersion,
+				"Unsupported smartctl version: Smartctl doesn't support --scan-open with --json.");
+	}
+
+	std::vector<StorageDevicePtr> scanned;
+	if (auto parse_status = parse_scan_open_json(output, scanned); !parse_status) {
+		return parse_status;
+	}
+	fetch_scan_open_drives(scanned, drives, ex_factory);
+	return {};
+}
+
+
+
+
+/// @}
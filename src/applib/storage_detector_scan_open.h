@@ -0,0 +1,51 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DETECTOR_SCAN_OPEN_H
+#define STORAGE_DETECTOR_SCAN_OPEN_H
+
+#include <string_view>
+#include <vector>
+
+#include "command_executor_factory.h"
+#include "storage_device.h"
+#include "storage_detector.h"
+
+
+
+/// Parse the output of "smartctl --scan-open --json" into drives. The devices which
+/// could not be opened are skipped. The type is kept only for the types smartctl
+/// cannot autodetect by itself (the ones with parameters, e.g. "megaraid,0"), so that the
+/// drives are identical to the ones found by the other detectors.
+[[nodiscard]] hz::ExpectedVoid<StorageDetectorError> parse_scan_open_json(std::string_view json_output,
+		std::vector<StorageDevicePtr>& drives);
+
+
+/// Check whether drive detection through "smartctl --scan-open" is enabled
+/// ("system/use_scan_open_detection" config key).
+[[nodiscard]] bool get_use_scan_open_detection();
+
+
+/// Detect drives by running "smartctl --scan-open --json" once. This is much faster than
+/// probing each device, but smartctl doesn't know about all the controllers (e.g. 3ware,
+/// Areca or cciss), so the callers still run their specific detectors for those.
+/// The basic data of the found drives is fetched (in parallel, up to "system/smartctl_max_parallel_fetches"
+/// drives at once), and the ones which don't answer are left out, as with the block device detectors.
+/// If \c ex_factory has a remote host, the drives of that host are detected.
+[[nodiscard]] hz::ExpectedVoid<StorageDetectorError> detect_drives_scan_open(std::vector<StorageDevicePtr>& drives,
+		const CommandExecutorFactoryPtr& ex_factory);
+
+
+
+
+#endif
+
+/// @}
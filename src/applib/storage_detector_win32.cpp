@@ -12,8 +12,10 @@ Copyright:
 #include "build_config.h"
 
 #include <glibmm.h>
+#include <array>
+#include <atomic>
+#include <cwchar>  // std::wcslen
 #include <set>
-#include <bitset>
 #include <map>
 #include <vector>
 #include <memory>
@@ -28,9 +30,11 @@ Copyright:
 #include "hz/string_num.h"
 #include "rconfig/rconfig.h"
 #include "app_regex.h"
+#include "app_trace.h"
 #include "storage_detector_win32.h"
 #include "storage_detector_helpers.h"
 #include "smartctl_executor.h"  // get_smartctl_binary
+#include "worker_threads.h"
 
 
 
@@ -102,81 +106,103 @@ namespace {
 
 
 /// Check which physical drives each drive letter (C, D, ...) spans across.
+/// The volumes are enumerated once (FindFirstVolumeW()), so a volume having several
+/// drive letters is opened only once, and the volumes mounted only as folders are never opened.
 std::map<char, DriveLetterInfo> win32_get_drive_letter_map()
 {
 	std::map<char, DriveLetterInfo> drive_letter_map;
 
 #ifdef _WIN32
-	std::bitset<32> drives(GetLogicalDrives());
-
-	// Check which drives are fixed
-	std::vector<char> good_drives;
-	for (char c = 'A'; c <= 'Z'; ++c) {
-		if (drives[static_cast<unsigned char>(c) - 'A']) {  // drive is present
-			debug_out_dump("app", "Windows drive found: " << c << ".\n");
-			switch (auto drive_type = GetDriveType((c + std::string(":\\")).c_str())) {
-				case DRIVE_FIXED:
-					debug_out_dump("app", "Windows reports the drive " << c << " as fixed.\n");
-					good_drives.push_back(c);
-					break;
-				case DRIVE_REMOVABLE:
-					debug_out_dump("app", "Windows reports the drive " << c << " as removable.\n");
-					good_drives.push_back(c);
-					break;
-				case DRIVE_CDROM:
-					debug_out_dump("app", "Windows reports the drive " << c << " as cdrom.\n");
-					good_drives.push_back(c);
-					break;
-				default:
-					debug_out_dump("app", "Windows reports the drive " << c << " as type " << drive_type << ".\n");
-					// don't add
-					break;
+	std::array<wchar_t, MAX_PATH+1> volume_w = {};
+	HANDLE find_handle = FindFirstVolumeW(volume_w.data(), DWORD(volume_w.size()));
+	if (find_handle == INVALID_HANDLE_VALUE) {
+		debug_out_warn("app", "Cannot enumerate Windows volumes.\n");
+		return drive_letter_map;
+	}
+
+	do {
+		const std::wstring volume = volume_w.data();  // "\\?\Volume{GUID}\"
+		const std::string volume_str = hz::win32_utf16_to_utf8(volume);
+
+		// Drive letters and mount points of the volume, as a list of null-terminated strings
+		std::vector<wchar_t> path_names(MAX_PATH+1);
+		DWORD path_names_size = 0;
+		if (GetVolumePathNamesForVolumeNameW(volume.c_str(), path_names.data(), DWORD(path_names.size()), &path_names_size) == FALSE) {
+			if (GetLastError() != ERROR_MORE_DATA) {
+				continue;
+			}
+			path_names.resize(path_names_size);
+			if (GetVolumePathNamesForVolumeNameW(volume.c_str(), path_names.data(), DWORD(path_names.size()), &path_names_size) == FALSE) {
+				continue;
 			}
 		}
-	}
+		std::vector<char> letters;
+		for (const wchar_t* path = path_names.data(); *path != L'\0'; path += std::wcslen(path) + 1) {
+			// "C:\"
+			if (std::wcslen(path) == 3 && path[1] == L':' && path[2] == L'\\' && path[0] >= L'A' && path[0] <= L'Z') {
+				letters.push_back(static_cast<char>(path[0]));
+			}
+		}
+		if (letters.empty()) {
+			debug_out_dump("app", "Windows volume " << volume_str << " has no drive letters, skipping.\n");
+			continue;
+		}
+
+		switch (auto drive_type = GetDriveTypeW(volume.c_str())) {
+			case DRIVE_FIXED:
+			case DRIVE_REMOVABLE:
+			case DRIVE_CDROM:
+				break;
+			default:
+				debug_out_dump("app", "Windows reports the volume " << volume_str << " as type " << drive_type << ", skipping.\n");
+				continue;
+		}
 
-	// Try to open each drive, check its disk extents
-	for (const char drive : good_drives) {
-		const std::string drive_str = std::string("\\\\.\\") + drive + ":";
-		HANDLE h = CreateFileA(
-				drive_str.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+		// Open the volume (without the trailing backslash), check its disk extents
+		const std::wstring volume_device = volume.substr(0, volume.size() - 1);
+		HANDLE h = CreateFileW(
+				volume_device.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
 				OPEN_EXISTING, FILE_FLAG_NO_BUFFERING | FILE_FLAG_RANDOM_ACCESS, nullptr);
 		if (h == INVALID_HANDLE_VALUE) {
-			debug_out_warn("app", "Windows drive " << drive << " cannot be opened.\n");
+			debug_out_warn("app", "Windows volume " << volume_str << " cannot be opened.\n");
 			continue;
 		}
-		DWORD bytesReturned = 0;
-		VOLUME_DISK_EXTENTS vde;
-		if (DeviceIoControl(
+		// Room for the spanned volumes too
+		constexpr std::size_t max_extents = 32;
+		std::vector<unsigned char> vde_buffer(sizeof(VOLUME_DISK_EXTENTS) + (max_extents - 1) * sizeof(DISK_EXTENT));
+		DWORD bytes_returned = 0;
+		const BOOL extents_status = DeviceIoControl(
 				h, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS,
-				nullptr, 0, &vde, sizeof(vde), &bytesReturned, nullptr) == FALSE) {
-			debug_out_warn("app", "Windows drive " << drive << " is not mapped to any physical drives.\n");
+				nullptr, 0, vde_buffer.data(), DWORD(vde_buffer.size()), &bytes_returned, nullptr);
+		CloseHandle(h);
+		if (extents_status == FALSE) {
+			debug_out_warn("app", "Windows volume " << volume_str << " is not mapped to any physical drives.\n");
 			continue;
 		}
+		const auto* vde = reinterpret_cast<const VOLUME_DISK_EXTENTS*>(vde_buffer.data());
 
-		std::set<int> physical_drives;
-		for (std::size_t i = 0; i < vde.NumberOfDiskExtents; ++i) {
-			physical_drives.insert(int(vde.Extents[i].DiskNumber));
-			debug_out_dump("app", "Windows drive " << drive << " corresponds to physical drive " << vde.Extents[i].DiskNumber << ".\n");
+		DriveLetterInfo dli;
+		for (std::size_t i = 0; i < vde->NumberOfDiskExtents; ++i) {
+			dli.physical_drives.insert(int(vde->Extents[i].DiskNumber));
 		}
 
-		std::string volume_name;
 		std::array<wchar_t, MAX_PATH+1> volume_name_w = {};
 		DWORD dummy = 0;
-		const std::wstring drive_name = hz::win32_utf8_to_utf16(drive + std::string(":\\"));
-		if (!drive_name.empty()
-				&& GetVolumeInformationW(drive_name.c_str(),
+		if (GetVolumeInformationW(volume.c_str(),
 					volume_name_w.data(), MAX_PATH+1,
 					nullptr, &dummy, &dummy, nullptr, 0) == TRUE) {
-			volume_name = hz::win32_utf16_to_utf8(volume_name_w);
+			dli.volume_name = hz::win32_utf16_to_utf8(volume_name_w);
 		}
 
-		DriveLetterInfo dli;
-		dli.physical_drives = physical_drives;
-		dli.volume_name = volume_name;
+		for (const char letter : letters) {
+			for (const int physical_drive : dli.physical_drives) {
+				debug_out_dump("app", "Windows drive " << letter << " corresponds to physical drive " << physical_drive << ".\n");
+			}
+			drive_letter_map[letter] = dli;
+		}
+	} while (FindNextVolumeW(find_handle, volume_w.data(), DWORD(volume_w.size())) == TRUE);
 
-		drive_letter_map[drive] = dli;
-	}
+	FindVolumeClose(find_handle);
 #endif
 	return drive_letter_map;
 }
@@ -307,175 +333,53 @@ inline hz::ExpectedVoid<StorageDetectorError> execute_areca_cli(const CommandExe
 
 
 
-/** <pre>
-Get the drives on Areca controller using Areca cli tool.
-Note that the drives are inserted in the order they are detected.
-
-There are 3 formats of "disk info" output:
-
-1. No expanders:
-------------------------------------------------------------
-  # Ch# ModelName                       Capacity  Usage
-===============================================================================
-  1  1  INTEL SSDSA2M160G2GC             160.0GB  System
-  2  2  INTEL SSDSA2M160G2GC             160.0GB  System
-  3  3  INTEL SSDSA2M160G2GC             160.0GB  System
-  4  4  INTEL SSDSA2M160G2GC             160.0GB  System
-  5  5  Hitachi HDS724040ALE640         4000.8GB  Storage
-  6  6  Hitachi HDS724040ALE640         4000.8GB  Storage
-  7  7  Hitachi HDS724040ALE640         4000.8GB  Storage
-  8  8  Hitachi HDS724040ALE640         4000.8GB  Storage
-  9  9  Hitachi HDS724040ALE640         4000.8GB  Storage
- 10 10  Hitachi HDS724040ALE640         4000.8GB  Storage
- 11 11  Hitachi HDS724040ALE640         4000.8GB  Backup
- 12 12  Hitachi HDS724040ALE640         4000.8GB  Backup
-===============================================================================
-GuiErrMsg<0x00>: Success.
-------------------------------------------------------------
-
-2. No expanders (this output comes from CLI documentation, possibly an old format):
-------------------------------------------------------------
- #   ModelName        Serial#          FirmRev     Capacity  State
-===============================================================================
- 1   ST3250620NS      5QE1CP8S         3.AEE        250.1GB  RaidSet Member(1)
- 2   ST3250620NS      5QE1CP8S         3.AEE        250.1GB  RaidSet Member(1)
-....(snip)....
-12   ST3250620NS      5QE1CP8S         3.AEE        250.1GB  RaidSet Member(1)
-===============================================================================
-GuiErrMsg<0x00>: Success.
-------------------------------------------------------------
-
-3. Expanders:
-------------------------------------------------------------
-  # Enc# Slot#   ModelName                        Capacity  Usage
-===============================================================================
-  1  01  Slot#1  N.A.                                0.0GB  N.A.
-  2  01  Slot#2  N.A.                                0.0GB  N.A.
-  3  01  Slot#3  N.A.                                0.0GB  N.A.
-  4  01  Slot#4  N.A.                                0.0GB  N.A.
-  5  01  Slot#5  N.A.                                0.0GB  N.A.
-  6  01  Slot#6  N.A.                                0.0GB  N.A.
-  7  01  Slot#7  N.A.                                0.0GB  N.A.
-  8  01  Slot#8  N.A.                                0.0GB  N.A.
-  9  02  SLOT 01 N.A.                                0.0GB  N.A.
- 10  02  SLOT 02 N.A.                                0.0GB  N.A.
- 11  02  SLOT 03 N.A.                                0.0GB  N.A.
- 12  02  SLOT 04 N.A.                                0.0GB  N.A.
- 13  02  SLOT 05 N.A.                                0.0GB  N.A.
- 14  02  SLOT 06 N.A.                                0.0GB  N.A.
- 15  02  SLOT 07 N.A.                                0.0GB  N.A.
- 16  02  SLOT 08 N.A.                                0.0GB  N.A.
- 17  02  SLOT 09 N.A.                                0.0GB  N.A.
- 18  02  SLOT 10 N.A.                                0.0GB  N.A.
- 19  02  SLOT 11 N.A.                                0.0GB  N.A.
- 20  02  SLOT 12 N.A.                                0.0GB  N.A.
- 21  02  SLOT 13 N.A.                                0.0GB  N.A.
- 22  02  SLOT 14 ST910021AS                        100.0GB  Free
- 23  02  SLOT 15 WDC WD3200BEVT-75A23T0            320.1GB  HotSpare[Global]
- 24  02  SLOT 16 N.A.                                0.0GB  N.A.
- 25  02  SLOT 17 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
- 26  02  SLOT 18 ST31500341AS                     1500.3GB  Raid Set # 000
- 27  02  SLOT 19 ST3320620AS                       320.1GB  Raid Set # 000
- 28  02  SLOT 20 ST31500341AS                     1500.3GB  Raid Set # 000
- 29  02  SLOT 21 ST3500320AS                       500.1GB  Raid Set # 000
- 30  02  SLOT 22 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
- 31  02  SLOT 23 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
- 32  02  SLOT 24 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
- 33  02  EXTP 01 N.A.                                0.0GB  N.A.
- 34  02  EXTP 02 N.A.                                0.0GB  N.A.
- 35  02  EXTP 03 N.A.                                0.0GB  N.A.
- 36  02  EXTP 04 N.A.                                0.0GB  N.A.
-===============================================================================
-GuiErrMsg<0x00>: Success.
-------------------------------------------------------------
-</pre> */
+/// Get the drives on Areca controller using Areca cli tool (see areca_cli_parse_disk_info()).
+/// The result is cached in the RAID CLI inventory (see raid_cli_inventory_get()).
+/// Note that the drives are inserted in the order they are detected.
 [[nodiscard]] inline hz::ExpectedVoid<StorageDetectorError> areca_cli_get_drives(
 		const std::string& cli_binary, const std::string& dev, int controller,
 		std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
 {
-	debug_out_info("app", "Getting available Areca drives (ports) for controller " << controller << " through Areca CLI...\n");
-
 	// TODO Support controller number.
 	// So far it seems the only way to pass the controller number to CLI is to use
 	// the interactive mode.
 
-	std::string output;
-	auto execute_status = execute_areca_cli(ex_factory, cli_binary, {"disk", "info"}, output);
-	if (!execute_status) {
-		return execute_status;
-	}
-
-	// split to lines
-	std::vector<std::string> lines;
-	hz::string_split(output, '\n', lines, true);
-
-	enum class FormatType {
-		Unknown,
-		NoEnc1,
-		NoEnc2,
-		Enc
-	};
+	const std::string host = raid_cli_inventory_get_host(ex_factory);
+	auto inventory = raid_cli_inventory_get(host).areca;
+	if (inventory.has_value()) {
+		debug_out_info("app", "Using cached Areca drives (ports) for controller " << controller << ".\n");
 
-	const auto noenc1_header_re = app_regex_re("/^\\s*#\\s+Ch#/mi");
-	const auto noenc2_header_re = app_regex_re("/^\\s*#\\s+ModelName/mi");
-	const auto exp_header_re = app_regex_re("/^\\s*#\\s+Enc#/mi");
+	} else {
+		debug_out_info("app", "Getting available Areca drives (ports) for controller " << controller << " through Areca CLI...\n");
 
-	FormatType format_type = FormatType::Unknown;
-	for (const auto& line : lines) {
-		if (app_regex_partial_match(noenc1_header_re, line)) {
-			format_type = FormatType::NoEnc1;
-			break;
+		std::string output;
+		auto execute_status = execute_areca_cli(ex_factory, cli_binary, {"disk", "info"}, output);
+		if (!execute_status) {
+			return execute_status;
 		}
-		if (app_regex_partial_match(noenc2_header_re, line)) {
-			format_type = FormatType::NoEnc2;
-			break;
+		auto parse_status = areca_cli_parse_disk_info(output);
+		if (!parse_status) {
+			return hz::Unexpected(StorageDetectorError(parse_status.error().data()), parse_status.error().message());
 		}
-		if (app_regex_partial_match(exp_header_re, line)) {
-			format_type = FormatType::Enc;
-			break;
-		}
-	}
-	if (format_type == FormatType::Unknown) {
-		debug_out_warn("app", "Could not read Areca CLI output: No valid header found.\n");
-		return hz::Unexpected(StorageDetectorError::ParseError,
-				_("Could not read Areca CLI output: No valid header found."));
+		inventory = parse_status.value();
+		raid_cli_inventory_update(host, [&](RaidCliInventory& updated) {
+			updated.areca = inventory;
+		});
 	}
 
-	// Note: These may not match the full model, but just the first part is sufficient for comparison with "N.A.".
-	const auto noexp1_port_re = app_regex_re("/^\\s*[0-9]+\\s+([0-9]+)\\s+([^\\s]+)/mi");  // matches port, model.
-	const auto noexp2_port_re = app_regex_re("/^\\s*([0-9]+)\\s+([^\\s]+)/mi");  // matches port, model.
-	const auto exp_port_re = app_regex_re("/^\\s*[0-9]+\\s+([0-9]+)\\s+(?:Slot#|SLOT\\s+)([0-9]+)\\s+([^\\s]+)/mi");  // matches enclosure, port, model.
-
-	const bool has_enclosure = (format_type == FormatType::Enc);
-	if (has_enclosure) {
+	if (inventory->has_enclosure) {
 		debug_out_dump("app", "Areca controller seems to have enclosures.\n");
 	} else {
 		debug_out_dump("app", "Areca controller doesn't have any enclosures.\n");
 	}
 
-	for (const auto& line : lines) {
-		std::string port_str, model_str;
-		if (has_enclosure) {
-			std::string enclosure_str;
-			if (app_regex_partial_match(exp_port_re, hz::string_trim_copy(line), {&enclosure_str, &port_str, &model_str})) {
-				if (model_str != "N.A.") {
-					const int port = hz::string_to_number_nolocale<int>(port_str);
-					const int enclosure = hz::string_to_number_nolocale<int>(enclosure_str);
-					drives.emplace_back(std::make_shared<StorageDevice>(dev,
-							"areca," + hz::number_to_string_nolocale(port) + "/" + hz::number_to_string_nolocale(enclosure)));
-					debug_out_info("app", "Added Areca drive " << drives.back()->get_device_with_type() << ".\n");
-				}
-			}
-		} else {  // no enclosures
-			const auto port_re = (format_type == FormatType::NoEnc1 ? noexp1_port_re : noexp2_port_re);
-			if (app_regex_partial_match(port_re, hz::string_trim_copy(line), {&port_str, &model_str})) {
-				if (model_str != "N.A.") {
-					const int port = hz::string_to_number_nolocale<int>(port_str);
-					drives.emplace_back(std::make_shared<StorageDevice>(dev, "areca," + hz::number_to_string_nolocale(port)));
-					debug_out_info("app", "Added Areca drive " << drives.back()->get_device_with_type() << ".\n");
-				}
-			}
+	for (const auto& disk : inventory->disks) {
+		std::string type = "areca," + hz::number_to_string_nolocale(disk.port);
+		if (inventory->has_enclosure) {
+			type += "/" + hz::number_to_string_nolocale(disk.enclosure);
 		}
+		drives.emplace_back(std::make_shared<StorageDevice>(dev, type));
+		debug_out_info("app", "Added Areca drive " << drives.back()->get_device_with_type() << ".\n");
 	}
 
 	return {};
@@ -595,7 +499,7 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_win32_areca(std::vec
 
 		auto drive = std::make_shared<StorageDevice>("/dev/arcmsr0", "areca,1");
 		[[maybe_unused]] auto drive_status = drive->fetch_basic_data_and_parse(smartctl_ex);
-		const std::string output = drive->get_basic_output();
+		const std::string& output = drive->get_basic_output();
 		if (app_regex_partial_match("/No Areca controller found/mi", output)
 				|| app_regex_partial_match("/Smartctl open device: .* failed: No such device/mi", output) ) {
 			use_cli = 0;
@@ -642,7 +546,7 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_win32_areca(std::vec
 
 			const std::size_t old_drive_count = drives.size();
 			std::string last_output;
-			auto scan_status = smartctl_scan_drives_sequentially(dev, "areca,%d", 1, max_noenc_ports, drives, ex_factory, last_output);
+			auto scan_status = smartctl_scan_drives(dev, "areca,%d", 1, max_noenc_ports, drives, ex_factory, last_output);
 			// If the scan stopped because of no controller, stop it all.
 			if (!scan_status && (app_regex_partial_match("/No Areca controller found/mi", last_output)
 					|| app_regex_partial_match("/Smartctl open device: .* failed: No such device/mi", last_output)) ) {
@@ -657,7 +561,7 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_win32_areca(std::vec
 					debug_out_dump("app", "Starting brute-force port scan (enclosure #" << enclosure_no << ") on 1-" << max_enc_ports << " ports, device \"" << dev
 							<< "\". Change the maximums by setting \"system/win32_areca_onc_max_scan_port\" and \"system/win32_areca_enc_max_enclosure\" config keys.\n");
 					// FIXME Not sure whether we should ignore this error message
-					[[maybe_unused]] auto encl_status = smartctl_scan_drives_sequentially(dev, "areca,%d/" + hz::number_to_string_nolocale(enclosure_no), 1, max_enc_ports, drives, ex_factory, last_output);
+					[[maybe_unused]] auto encl_status = smartctl_scan_drives(dev, "areca,%d/" + hz::number_to_string_nolocale(enclosure_no), 1, max_enc_ports, drives, ex_factory, last_output);
 				}
 			}
 
@@ -672,25 +576,13 @@ inline hz::ExpectedVoid<StorageDetectorError> detect_drives_win32_areca(std::vec
 
 
 
-}
-
-
-
-
-// smartctl accepts various variants, the most straight being pdN,
-// (or /dev/pdN, /dev/ being optional) where N comes from
-// "\\.\PhysicalDriveN" (winnt only).
-// http://msdn.microsoft.com/en-us/library/aa365247(VS.85).aspx
-hz::ExpectedVoid<StorageDetectorError> detect_drives_win32(std::vector<StorageDevicePtr>& drives,
-		const CommandExecutorFactoryPtr& ex_factory)
+/// Detect the drives reported by "smartctl --scan-open", and the \\.\PhysicalDriveN ones
+/// which are not duplicates of them. \c multiport_found and \c areca_open_found are set, as soon as
+/// they are known, to whether --scan-open returned any drives and any Areca ones, respectively.
+hz::ExpectedVoid<StorageDetectorError> detect_drives_win32_scan_open_and_pd(std::vector<StorageDevicePtr>& drives,
+		const CommandExecutorFactoryPtr& ex_factory, const std::map<char, DriveLetterInfo>& drive_letter_map,
+		std::atomic<bool>& multiport_found, std::atomic<bool>& areca_open_found)
 {
-	std::vector<std::string> error_msgs;
-
-	// Construct drive letter map
-	debug_out_info("app", "Checking which drive corresponds to which \\\\.\\PhysicalDriveN device...\n");
-	const std::map<char, DriveLetterInfo> drive_letter_map = win32_get_drive_letter_map();
-
-
 	std::shared_ptr<CommandExecutor> smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
 
 	// Fetch multiport devices using --scan-open.
@@ -698,12 +590,7 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_win32(std::vector<StorageDe
 
 	std::set<int> used_pds;
 	auto multiport_status = get_scan_open_multiport_devices(drives, ex_factory, drive_letter_map, used_pds);
-	if (!multiport_status) {
-		error_msgs.push_back(multiport_status.error().message());
-	}
-
-	const bool multiport_found = !drives.empty();
-	bool areca_open_found = false;  // whether areca devices were found at --scan-open time.
+	multiport_found = !drives.empty();
 
 	// Find out their serial numbers and whether there are Arecas there.
 	std::map<std::string, StorageDevicePtr> serials;
@@ -725,6 +612,9 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_win32(std::vector<StorageDe
 		if (type_arg.find("areca") != std::string::npos) {
 			areca_open_found = true;
 		}
+		if (app_is_cancelled(ex_factory->get_cancellation())) {
+			return multiport_status;  // the partial results are kept
+		}
 	}
 
 
@@ -735,6 +625,9 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_win32(std::vector<StorageDe
 	[[maybe_unused]] int num_failed = 0;
 	const int max_drives = 255;  // arbitrary
 	for (int drive_num = 0; drive_num < max_drives; ++drive_num) {
+		if (app_is_cancelled(ex_factory->get_cancellation())) {
+			break;  // the partial results are kept
+		}
 
 		// If the drive was already encountered in --scan-open (with a port number), skip it.
 		if (used_pds.contains(drive_num)) {
@@ -805,6 +698,102 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_win32(std::vector<StorageDe
 		drives.push_back(drive);
 	}
 
+	return multiport_status;
+}
+
+
+
+/// Detect the drives behind 3ware controllers using tw_cli, if 3DM2 is installed.
+/// This is needed only if --scan-open doesn't return any drives, see detect_drives_win32().
+void detect_drives_win32_tw_cli(std::vector<StorageDevicePtr>& drives, const CommandExecutorFactoryPtr& ex_factory)
+{
+	debug_out_info("app", "Checking for additional 3ware devices...\n");
+	std::string inst_path;
+#ifdef _WIN32
+	hz::win32_get_registry_value_string(HKEY_USERS, ".DEFAULT\\Software\\3ware\\3DM2", "InstallPath", inst_path);
+#endif
+	if (!inst_path.empty()) {
+		debug_out_dump("app", "3ware 3DM2 found at\"" << inst_path << "\".\n");
+		std::vector<int> controllers;
+		auto tw_status = tw_cli_get_controllers(ex_factory, controllers);
+		// ignore the error message above, it's of no use.
+		for (const int controller : controllers) {
+			// don't specify device, it's ignored in tw_cli mode
+			[[maybe_unused]] auto tw_drive_status = tw_cli_get_drives("", controller, drives, ex_factory, true);
+		}
+	} else {
+		debug_out_info("app", "3ware 3DM2 not installed.\n");
+	}
+}
+
+
+
+}
+
+
+
+
+// smartctl accepts various variants, the most straight being pdN,
+// (or /dev/pdN, /dev/ being optional) where N comes from
+// "\\.\PhysicalDriveN" (winnt only).
+// http://msdn.microsoft.com/en-us/library/aa365247(VS.85).aspx
+hz::ExpectedVoid<StorageDetectorError> detect_drives_win32(std::vector<StorageDevicePtr>& drives,
+		const CommandExecutorFactoryPtr& ex_factory)
+{
+	std::vector<std::string> error_msgs;
+
+	// Construct drive letter map
+	debug_out_info("app", "Checking which drive corresponds to which \\\\.\\PhysicalDriveN device...\n");
+	const std::map<char, DriveLetterInfo> drive_letter_map = win32_get_drive_letter_map();
+
+	// The backends look at different buses, so they can run in parallel. 3ware and Areca
+	// detection is needed only if --scan-open doesn't find the drives behind them; if it's
+	// known by the time they start, they are skipped, otherwise their results are discarded.
+	const auto max_parallel = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/win32_max_parallel_detectors")));
+	const CommandExecutorFactoryPtr detector_factory = (max_parallel > 1)
+			? command_executor_factory_for_worker_threads(ex_factory) : ex_factory;
+
+	std::atomic<bool> scan_open_finished = false;
+	std::atomic<bool> multiport_found = false;  // whether --scan-open returned any drives
+	std::atomic<bool> areca_open_found = false;  // whether areca devices were found at --scan-open time.
+
+	enum { ScanOpen, TwCli, Areca, BackendCount };
+	std::vector<std::vector<StorageDevicePtr>> detected_drives(BackendCount);
+	std::vector<hz::ExpectedVoid<StorageDetectorError>> statuses(BackendCount);
+
+	app_run_worker_tasks(BackendCount, max_parallel, [&](std::size_t i) {
+		if (app_is_cancelled(detector_factory->get_cancellation())) {
+			return;  // the remaining backends are skipped, the partial results are kept
+		}
+		switch (i) {
+			case ScanOpen: {
+				const AppTraceSpan trace_span("detect_drives_win32_scan_open_and_pd", "detector");
+				statuses[i] = detect_drives_win32_scan_open_and_pd(detected_drives[i], detector_factory,
+						drive_letter_map, multiport_found, areca_open_found);
+				scan_open_finished = true;
+				break;
+			}
+			case TwCli:
+				if (!(scan_open_finished && multiport_found)) {
+					const AppTraceSpan trace_span("detect_drives_win32_tw_cli", "detector");
+					detect_drives_win32_tw_cli(detected_drives[i], detector_factory);
+				}
+				break;
+			case Areca:
+				if (!(scan_open_finished && areca_open_found)) {
+					const AppTraceSpan trace_span("detect_drives_win32_areca", "detector");
+					statuses[i] = detect_drives_win32_areca(detected_drives[i], detector_factory);
+				}
+				break;
+			default:
+				break;
+		}
+	});
+
+	if (!statuses[ScanOpen]) {
+		error_msgs.push_back(statuses[ScanOpen].error().message());
+	}
+	drives.insert(drives.end(), detected_drives[ScanOpen].begin(), detected_drives[ScanOpen].end());
 
 	// If smartctl --scan-open returns no "sd*,port"-style devices,
 	// check if 3dm2 is installed and execute "tw_cli show" to get
@@ -812,30 +801,13 @@ hz::ExpectedVoid<StorageDetectorError> detect_drives_win32(std::vector<StorageDe
 	// happen with older smartctl which doesn't support --scan-open, or with
 	// drivers that don't allow proper SMART commands.
 	if (!multiport_found) {
-		debug_out_info("app", "Checking for additional 3ware devices...\n");
-		std::string inst_path;
-#ifdef _WIN32
-		hz::win32_get_registry_value_string(HKEY_USERS, ".DEFAULT\\Software\\3ware\\3DM2", "InstallPath", inst_path);
-#endif
-		if (!inst_path.empty()) {
-			debug_out_dump("app", "3ware 3DM2 found at\"" << inst_path << "\".\n");
-			std::vector<int> controllers;
-			auto tw_status = tw_cli_get_controllers(ex_factory, controllers);
-			// ignore the error message above, it's of no use.
-			for (const int controller : controllers) {
-				// don't specify device, it's ignored in tw_cli mode
-				[[maybe_unused]] auto tw_drive_status = tw_cli_get_drives("", controller, drives, ex_factory, true);
-			}
-		} else {
-			debug_out_info("app", "3ware 3DM2 not installed.\n");
-		}
+		drives.insert(drives.end(), detected_drives[TwCli].begin(), detected_drives[TwCli].end());
 	}
 
-
 	if (!areca_open_found) {
-		auto areca_status = detect_drives_win32_areca(drives, ex_factory);
-		if (!areca_status) {
-			error_msgs.push_back(areca_status.error().message());
+		drives.insert(drives.end(), detected_drives[Areca].begin(), detected_drives[Areca].end());
+		if (!statuses[Areca]) {
+			error_msgs.push_back(statuses[Areca].error().message());
 		}
 	}
 
@@ -12,9 +12,15 @@ Copyright:
 #include "storage_device.h"
 
 #include <glibmm.h>
+#include <glib.h>
+#include <algorithm>  // std::max
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <string>
@@ -30,16 +36,59 @@ Copyright:
 #include "app_regex.h"
 #include "smartctl_parser_types.h"
 #include "storage_device_detected_type.h"
+#include "storage_device_type_cache.h"
+#include "storage_drive_identity.h"
+#include "storage_error_log_journal.h"
 #include "storage_settings.h"
 #include "smartctl_executor.h"
 #include "smartctl_version_parser.h"
+#include "storage_history.h"
+#include "storage_trend.h"
+#include "storage_ioctl_poll.h"
+#include "storage_nvme_controller.h"
+#include "storage_output_compression.h"
+#include "storage_privileged_helper.h"
 #include "storage_property_descr.h"
+#include "storage_property_snapshot.h"
+#include "worker_threads.h"
 #include "build_config.h"
 //#include "smartctl_text_parser_helper.h"
 //#include "ata_storage_property_descr.h"
 
 
 
+namespace {
+
+	/// Unchanged-output statistics, see StorageDevice::get_parse_skip_stats()
+	std::atomic<std::uint64_t> parse_skip_hits = 0;
+	std::atomic<std::uint64_t> parse_skip_misses = 0;
+
+
+	/// Get the ATA drive type (SSD or HDD) from the rotation rate property
+	StorageDeviceDetectedType get_ata_type_from_rotation_rate(const StoragePropertyRepository& property_repo)
+	{
+		const auto* rpm_prop = property_repo.find_property("rotation_rate");
+		if (!rpm_prop || rpm_prop->get_value<std::int64_t>() == 0) {
+			return StorageDeviceDetectedType::AtaSsd;
+		}
+		return StorageDeviceDetectedType::AtaHdd;
+	}
+
+
+	/// Get the smartctl option selecting JSON output. The text output is embedded (--json=o)
+	/// only if enabled in the config, since it doubles the output size. Monitoring fetches never embed it.
+	std::string storage_device_get_json_option(bool monitoring)
+	{
+		if (!monitoring && rconfig::get_data<bool>("system/smartctl_json_embed_text_output")) {
+			return "--json=o";
+		}
+		return "--json";
+	}
+
+}
+
+
+
 std::string StorageDevice::get_status_displayable_name(SmartStatus status)
 {
 	static const std::unordered_map<SmartStatus, std::string> m {
@@ -55,6 +104,13 @@ std::string StorageDevice::get_status_displayable_name(SmartStatus status)
 
 
 
+StorageDeviceParseSkipStats StorageDevice::get_parse_skip_stats()
+{
+	return {parse_skip_hits.load(), parse_skip_misses.load()};
+}
+
+
+
 StorageDevice::StorageDevice(std::string dev_or_vfile, bool is_virtual)
 		: is_virtual_(is_virtual)
 {
@@ -63,20 +119,25 @@ StorageDevice::StorageDevice(std::string dev_or_vfile, bool is_virtual)
 	} else {
 		device_ = std::move(dev_or_vfile);
 	}
+	update_sort_key();
 }
 
 
 
 StorageDevice::StorageDevice(std::string dev, std::string type_arg)
 		: device_(std::move(dev)), type_arg_(std::move(type_arg))
-{ }
+{
+	update_sort_key();
+}
 
 
 
 void StorageDevice::clear_outputs()
 {
-	basic_output_.clear();
-	full_output_.clear();
+	basic_output_ = std::make_shared<const std::string>();
+	full_output_ = std::make_shared<const std::string>();
+	text_output_.clear();
+	basic_data_identity_only_ = false;
 }
 
 
@@ -87,52 +148,114 @@ void StorageDevice::clear_parse_results()
 //	test_is_active_ = false;  // not sure
 
 	property_repository_.clear();
+	full_output_hash_.reset();
+	full_data_time_.reset();
+	compacted_full_output_.reset();
 
 	smart_supported_.reset();
 	smart_enabled_.reset();
 	model_name_.reset();
 	family_name_.reset();
 	size_.reset();
-	health_property_.reset();
+	health_property_ = StorageProperty();
+	invalidate_derived_facts();
 }
 
 
 
 hz::ExpectedVoid<StorageDeviceError> StorageDevice::fetch_basic_data_and_parse(
 		const std::shared_ptr<CommandExecutor>& smartctl_ex)
+{
+	return do_fetch_basic_data_and_parse(smartctl_ex, false);
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::fetch_identity_and_parse(
+		const std::shared_ptr<CommandExecutor>& smartctl_ex)
+{
+	return do_fetch_basic_data_and_parse(smartctl_ex, true);
+}
+
+
+
+bool StorageDevice::get_basic_data_identity_only() const
+{
+	return basic_data_identity_only_;
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::do_fetch_basic_data_and_parse(
+		const std::shared_ptr<CommandExecutor>& smartctl_ex, bool identity_only)
 {
 	if (this->test_is_active_) {
 		return hz::Unexpected(StorageDeviceError::TestRunning, _("A test is currently being performed on this drive."));
 	}
+	if (this->fetch_in_progress_) {
+		return hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved."));
+	}
 
 	// Clear everything fetched before, including outputs
 	this->clear_parse_results();
 	this->clear_outputs();
 
+	// If the drive needed an explicit type last time, try it first instead of failing without one.
+	std::string type_cache_key;
+	if (get_type_argument().empty() && get_detected_type() == StorageDeviceDetectedType::Unknown && !is_virtual_) {
+		type_cache_key = storage_device_type_cache_get_key(*this);
+		if (auto cached_type = storage_device_type_cache_get(type_cache_key)) {
+			debug_out_info("app", "Trying the previously working type \"" << cached_type.value() << "\" for " << get_device() << ".\n");
+			this->set_type_argument(cached_type.value());
+			auto cached_type_status = this->do_fetch_basic_data_and_parse(smartctl_ex, identity_only);
+			if (cached_type_status || cached_type_status.error().data() != StorageDeviceError::ExecutionError) {
+				return cached_type_status;
+			}
+			// A different drive, or it's attached differently now.
+			debug_out_info("app", "The previously working type doesn't work anymore, forgetting it.\n");
+			storage_device_type_cache_forget(type_cache_key);
+			this->set_type_argument("");
+			this->set_detected_type(StorageDeviceDetectedType::Unknown);
+			this->clear_parse_results();
+			this->clear_outputs();
+		}
+	}
+
 	// We don't use "--all" - it may cause really screwed up the output (tests, etc.).
 	// This looks just like "--info" only on non-smart devices.
+	// The identity probe has the info section only, which is small enough that there's
+	// nothing to skip when parsing it. The embedded text output is not needed either.
 	const auto default_parser_type = SmartctlVersionParser::get_default_format(SmartctlParserType::Basic);
-	std::vector<std::string> command_options = {"--info", "--health", "--capabilities"};
+	std::vector<std::string> command_options = {"--info"};
+	if (!identity_only) {
+		command_options.insert(command_options.end(), {"--health", "--capabilities"});
+	}
 	if (default_parser_type == SmartctlOutputFormat::Json) {
-		// --json flags: o means include original output (just in case).
-		command_options.push_back("--json=o");
+		command_options.push_back(identity_only ? std::string("--json=c") : storage_device_get_json_option(false));
 	}
 
-	auto execute_status = execute_device_smartctl(command_options, smartctl_ex, this->basic_output_, true);  // set type to invalid if needed
+	auto execute_status = execute_device_smartctl(command_options, smartctl_ex, this->basic_output_, true,  // set type to invalid if needed
+			CommandOperation::Scan);
 
 	// Smartctl 5.39 cvs/svn version defaults to usb type on at least linux and windows.
 	// This means that the old SCSI identify command isn't executed by default,
 	// and there is no information about the device manufacturer/etc. in the output.
 	// We detect this and set the device type to scsi to at least have _some_ info.
 
-	// Note: This match works even with JSON (the text output is included in --json=o).
+	// Note: This match works with JSON too (the message is in "smartctl/messages").
 	if ((execute_status || execute_status.error().data() == StorageDeviceError::ExecutionError)
 			&& get_detected_type() == StorageDeviceDetectedType::NeedsExplicitType
 			&& get_type_argument().empty() ) {
 		debug_out_info("app", "The device seems to be of different type than auto-detected, trying again with scsi.\n");
 		this->set_type_argument("scsi");
 		this->set_detected_type(StorageDeviceDetectedType::BasicScsi);
-		return this->fetch_basic_data_and_parse(smartctl_ex);  // try again with scsi
+		auto scsi_status = this->do_fetch_basic_data_and_parse(smartctl_ex, identity_only);  // try again with scsi
+		if (scsi_status && !type_cache_key.empty()) {
+			// Register the drive first, so that the type is remembered by its drive ID
+			storage_drive_identity_update(*this);
+			storage_device_type_cache_remember(storage_device_type_cache_get_key(*this), get_type_argument());
+		}
+		return scsi_status;
 	}
 
 	// Since the type error leads to "command line didn't parse" error here,
@@ -144,6 +267,8 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::fetch_basic_data_and_parse(
 //		return execute_status;
 //	}
 
+	basic_data_identity_only_ = identity_only;
+
 	// Set some properties too - they are needed for e.g. SMART on/off support, etc.
 	return this->parse_basic_data();
 }
@@ -167,6 +292,7 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_basic_data()
 	// Parse using Basic parser. This supports all drive types.
 	auto basic_parser = SmartctlParser::create(SmartctlParserType::Basic, output_format);
 	DBG_ASSERT_RETURN(basic_parser, hz::Unexpected(StorageDeviceError::ParseError, _("Cannot create parser")));
+	basic_parser->set_keep_text_output(keep_text_output_);
 
 	// This also fills the drive type properties.
 	auto parse_status = basic_parser->parse(this->get_basic_output());
@@ -178,13 +304,13 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_basic_data()
 
 	// See if we can narrow down the drive type from what was detected
 	// by StorageDetector and properties set by Basic parser.
-	auto basic_property_repo = basic_parser->get_property_repository();
+	auto basic_property_repo = basic_parser->take_property_repository();
 
 	// Make detected type more exact.
 	detect_drive_type_from_properties(basic_property_repo);
 
 	// Add property descriptions and set to the drive.
-	this->set_property_repository(StoragePropertyProcessor::process_properties(basic_property_repo, get_detected_type()));
+	this->set_property_repository(StoragePropertyProcessor::process_properties(std::move(basic_property_repo), get_detected_type()));
 
 	debug_out_dump("app", "Drive " << get_device_with_type() << " set to be "
 			<< StorageDeviceDetectedTypeExt::get_displayable_name(get_detected_type()) << " device.\n");
@@ -207,7 +333,29 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_basic_data()
 //		}
 //	}
 
-	signal_changed().emit(this);  // notify listeners
+	emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
+
+	return {};
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::load_basic_data_snapshot(std::string_view snapshot)
+{
+	auto repository = storage_property_snapshot_load(snapshot);
+	if (!repository) {
+		return hz::Unexpected(StorageDeviceError::ParseError,
+				fmt::format(fmt::runtime(_("Cannot load property snapshot: {}")), repository.error().message()));
+	}
+
+	this->clear_parse_results();
+	this->set_property_repository(std::move(repository.value()));
+
+	read_common_properties();  // sets model_name_, etc.
+
+	set_parse_status(model_name_.has_value() ? ParseStatus::Basic : ParseStatus::None);
+
+	emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
 
 	return {};
 }
@@ -216,73 +364,202 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_basic_data()
 
 hz::ExpectedVoid<StorageDeviceError> StorageDevice::fetch_full_data_and_parse(
 		const std::shared_ptr<CommandExecutor>& smartctl_ex)
+{
+	if (this->fetch_in_progress_) {
+		return hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved."));
+	}
+	return do_fetch_full_data_and_parse(smartctl_ex);
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::fetch_all_data_and_parse(
+		const std::shared_ptr<CommandExecutor>& smartctl_ex)
 {
 	if (this->test_is_active_) {
 		return hz::Unexpected(StorageDeviceError::TestRunning, _("A test is currently being performed on this drive."));
 	}
+	if (this->fetch_in_progress_) {
+		return hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved."));
+	}
 
-	// Drive type must be already set at this point, using fetch_basic_data_and_parse().
-	DBG_ASSERT(this->get_detected_type() != StorageDeviceDetectedType::Unknown);
+	const StorageDeviceDetectedType type = get_detected_type();
+	if (type != StorageDeviceDetectedType::Unknown && type != StorageDeviceDetectedType::NeedsExplicitType) {
+		return do_fetch_full_data_and_parse(smartctl_ex);
+	}
 
 	// Clear everything fetched before, including outputs
 	this->clear_parse_results();
 	this->clear_outputs();
 
+	// See fetch_basic_data_and_parse()
+	const std::string type_argument = get_type_argument();
+	if (type_argument.empty() && type == StorageDeviceDetectedType::Unknown && !is_virtual_) {
+		if (auto cached_type = storage_device_type_cache_get(storage_device_type_cache_get_key(*this))) {
+			this->set_type_argument(cached_type.value());
+		}
+	}
+
+	// The options can't be chosen by drive type here, but -x works with all of them.
+	std::vector<std::string> command_options = {"--xall"};
+	if (SmartctlVersionParser::get_default_format(SmartctlParserType::Basic) == SmartctlOutputFormat::Json) {
+		command_options.push_back(storage_device_get_json_option(false));
+	}
+
+	CommandOutputPtr output;
+	auto execute_status = execute_device_smartctl(command_options, smartctl_ex, output, true, CommandOperation::Scan);
+
+	if (execute_status && output) {
+		// The same output serves as both, it's not copied.
+		this->basic_output_ = output;
+		this->full_output_ = output;
+		// This detects the drive type from the output and parses it with the matching parser.
+		auto parse_status = this->parse_any_data_for_virtual();
+		if (parse_status && get_parse_status() == ParseStatus::Full) {
+			full_data_time_ = std::chrono::steady_clock::now();
+			if (append_to_history()) {
+				emit_signal_changed(StorageDeviceChange::Properties);  // the warnings changed after parsing
+			}
+		}
+		return parse_status;
+	}
+
+	// Let the usual detection deal with it (explicit types, etc.).
+	debug_out_info("app", "Cannot retrieve all data from " << get_device_with_type() << " at once, retrieving the basic data first.\n");
+	this->set_type_argument(type_argument);
+	this->set_detected_type(StorageDeviceDetectedType::Unknown);
+	auto basic_status = this->fetch_basic_data_and_parse(smartctl_ex);
+	if (!basic_status || get_parse_status() == ParseStatus::None) {
+		return basic_status;
+	}
+	return do_fetch_full_data_and_parse(smartctl_ex);
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::poll_ioctl_data_and_parse()
+{
+	if (this->fetch_in_progress_) {
+		return hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved."));
+	}
+	if (this->test_is_active_) {
+		return hz::Unexpected(StorageDeviceError::TestRunning, _("A test is currently being performed on this drive."));
+	}
+	if (this->get_is_virtual()) {
+		return hz::Unexpected(StorageDeviceError::CannotExecuteOnVirtual, _("Cannot retrieve SMART data from a virtual file."));
+	}
+	const StorageDeviceDetectedType type = this->get_detected_type();
+	if (this->get_remote_host() || this->get_parse_status() != ParseStatus::Full
+			|| (standby_aware_ && type != StorageDeviceDetectedType::Nvme)
+			|| !storage_ioctl_poll_get_supported(this->get_device(), this->get_type_argument(), type)) {
+		return hz::Unexpected(StorageDeviceError::IoctlPollUnavailable, _("The drive cannot be polled directly."));
+	}
+
+	auto json_output = storage_ioctl_poll(this->get_device(), type, property_repository_);
+	if (!json_output) {
+		return hz::Unexpected(StorageDeviceError::IoctlPollUnavailable, json_output.error().message());
+	}
+
+	// Parse it like smartctl output, so that the properties are the same
+	const auto parser_type = (type == StorageDeviceDetectedType::Nvme) ? SmartctlParserType::Nvme : SmartctlParserType::Ata;
+	auto parser = SmartctlParser::create(parser_type, SmartctlOutputFormat::Json);
+	DBG_ASSERT_RETURN(parser, hz::Unexpected(StorageDeviceError::ParseError, _("Cannot create parser")));
+	parser->set_requested_sections({StoragePropertySection::OverallHealth,
+			parser_type == SmartctlParserType::Nvme ? StoragePropertySection::NvmeAttributes : StoragePropertySection::AtaAttributes});
+	const auto parse_status = parser->parse(json_output.value());
+	if (!parse_status) {
+		return hz::Unexpected(StorageDeviceError::ParseError,
+				fmt::format(fmt::runtime(_("Cannot parse smartctl output: {}")), parse_status.error().message()));
+	}
+
+	auto polled = StoragePropertyProcessor::process_properties(parser->take_property_repository(), type);
+	set_property_repository(storage_ioctl_merge_properties(property_repository_, polled));
+	in_standby_ = false;
+
+	emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
+
+	return {};
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::do_fetch_full_data_and_parse(
+		const std::shared_ptr<CommandExecutor>& smartctl_ex)
+{
+	if (this->test_is_active_) {
+		return hz::Unexpected(StorageDeviceError::TestRunning, _("A test is currently being performed on this drive."));
+	}
+
+	// Drive type must be already set at this point, using fetch_basic_data_and_parse().
+	DBG_ASSERT(this->get_detected_type() != StorageDeviceDetectedType::Unknown);
+
+	// The devices of an NVMe controller share its health information and logs. If another one
+	// fetched them recently, fetch only the namespace information and reuse the rest.
+	const std::string nvme_controller_key = get_nvme_controller_key();
+	std::optional<StorageNvmeControllerData> nvme_controller_data;
+	if (!nvme_controller_key.empty()) {
+		nvme_controller_data = storage_nvme_controller_cache_get(nvme_controller_key, get_device_with_type());
+	}
+
 	// Execute smartctl.
+	std::vector<std::string> command_options = nvme_controller_data.has_value()
+			? std::vector<std::string>{"--info"}
+			: storage_fetch_profile_get_smartctl_options(fetch_profile_, this->get_detected_type());
 
-	// Instead of -x, we use all the individual options -x encompasses, so that
-	// an addition to default -x output won't affect us.
-	std::vector<std::string> command_options;
-
-	// Type was detected by Basic parser
-	switch (this->get_detected_type()) {
-		case StorageDeviceDetectedType::Unknown:
-		case StorageDeviceDetectedType::NeedsExplicitType:
-			DBG_ASSERT(0);
-			break;
-		case StorageDeviceDetectedType::AtaAny:
-		case StorageDeviceDetectedType::AtaHdd:
-		case StorageDeviceDetectedType::AtaSsd:
-			command_options = {
-					"--health",
-					"--info",
-					"--get=all",
-					"--capabilities",
-					"--attributes",
-					"--format=brief",
-					"--log=xerror,50,error",
-					"--log=xselftest,50,selftest",
-					"--log=selective",
-					"--log=directory",
-					"--log=scttemp",
-					"--log=scterc",
-					"--log=devstat",
-					"--log=sataphy",
-			};
-			break;
-		case StorageDeviceDetectedType::Nvme:
-			// We don't care if something is added to json output.
-			// Same as: --health --info --capabilities --attributes --log=error --log=selftest
-			command_options = {"--xall"};
-			break;
-		case StorageDeviceDetectedType::BasicScsi:
-		case StorageDeviceDetectedType::CdDvd:
-		case StorageDeviceDetectedType::UnsupportedRaid:
-			// SCSI equivalent of -x:
-			// command_options = "--health --info --attributes --log=error --log=selftest --log=background --log=sasphy";
-			command_options = {"--xall"};
-			break;
+	// Smartctl doesn't support checking the power mode of NVMe devices.
+	if (standby_aware_ && this->get_detected_type() != StorageDeviceDetectedType::Nvme) {
+		command_options.insert(command_options.begin(), "--nocheck=standby");
 	}
 
 	auto parser_type = SmartctlVersionParser::get_default_parser_type(this->get_detected_type());
 	auto parser_format = SmartctlVersionParser::get_default_format(parser_type);
 	if (parser_format == SmartctlOutputFormat::Json) {
-		// --json flags: o means include original output (just in case).
-		command_options.push_back("--json=o");
+		command_options.push_back(storage_device_get_json_option(fetch_profile_ == StorageFetchProfile::Monitoring));
 	}
 
-	std::string output;
-	auto execute_status = execute_device_smartctl(command_options, smartctl_ex, output);
+	CommandOutputPtr output;
+	auto execute_status = execute_device_smartctl(command_options, smartctl_ex, output, false, CommandOperation::Refresh);
+
+	// The drive is asleep, and smartctl didn't wake it up. Keep the data we have.
+	// "Device is in STANDBY mode, exit(2)" (also embedded in JSON). Exit code 2 is not treated as an error.
+	in_standby_ = (standby_aware_ && execute_status && output
+			&& app_regex_partial_match("/Device is in [A-Z_ ()]+ mode, exit\\(/m", *output));
+	if (in_standby_) {
+		debug_out_info("app", DBG_FUNC_MSG << "Drive " << get_device_with_type() << " is in standby mode, keeping its old data.\n");
+		emit_signal_changed(StorageDeviceChange::Standby);  // notify listeners about get_in_standby()
+		return {};
+	}
+
+	// With frequent refreshes of idle drives the output is often the same except for the
+	// current time. Keep the properties parsed from the previous output in that case.
+	std::optional<std::uint64_t> output_hash;
+	if (execute_status && output) {
+		output_hash = SmartctlParser::get_output_content_hash(*output)
+				^ (static_cast<std::uint64_t>(parser_type) << 56) ^ (static_cast<std::uint64_t>(fetch_profile_) << 48)
+				^ (static_cast<std::uint64_t>(keep_text_output_) << 40)
+				^ (rconfig::get_generation() * 0x9e3779b97f4a7c15ULL)  // settings may affect the warnings
+				^ (nvme_controller_data.has_value() ? nvme_controller_data->output_hash : 0);
+		if (parse_status_ == ParseStatus::Full && full_output_hash_ == output_hash) {
+			++parse_skip_hits;
+			debug_out_dump("app", DBG_FUNC_MSG << "Output of " << get_device_with_type() << " is unchanged, not parsing it.\n");
+			this->full_output_ = output;
+			this->text_output_.clear();
+			full_data_time_ = std::chrono::steady_clock::now();
+			append_to_history();
+			emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
+			return {};
+		}
+		++parse_skip_misses;
+	}
+
+	// An abandoned fetch (e.g. a cancelled prefetch) leaves the data of the previous one alone
+	if (!execute_status && app_is_cancelled(smartctl_ex->get_cancellation())) {
+		return execute_status;
+	}
+
+	// Clear everything fetched before, including outputs
+	this->clear_parse_results();
+	this->clear_outputs();
 
 //	if (this->get_type_argument() == "scsi") {  // not sure about correctness... FIXME probably fails with RAID/scsi
 //		const auto default_parser_type = SmartctlVersionParser::get_default_format(SmartctlParserType::Basic);
@@ -323,7 +600,39 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::fetch_full_data_and_parse(
 		return execute_status;
 
 	this->full_output_ = output;
-	return this->parse_full_data(parser_type, parser_format);
+	this->nvme_controller_properties_ = (nvme_controller_data.has_value() ? nvme_controller_data->properties : nullptr);
+	auto parse_status = this->parse_full_data(parser_type, parser_format);
+
+	if (parse_status) {
+		full_output_hash_ = output_hash;
+		full_data_time_ = std::chrono::steady_clock::now();
+		if (!nvme_controller_key.empty() && !nvme_controller_data.has_value()) {
+			storage_nvme_controller_cache_store(nvme_controller_key, get_device_with_type(), StorageNvmeControllerData{
+					std::make_shared<const std::vector<StorageProperty>>(storage_nvme_get_controller_properties(property_repository_)),
+					output_hash.value_or(0)});
+		}
+		if (append_to_history()) {
+			emit_signal_changed(StorageDeviceChange::Properties);  // the warnings changed after parsing
+		}
+	}
+	return parse_status;
+}
+
+
+
+bool StorageDevice::append_to_history()
+{
+	// Record the values for the trends
+	auto history = storage_history_get_global();
+	if (!history) {
+		return false;
+	}
+	if (auto ec = history->append(*this)) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot write SMART history: " << ec.message() << "\n");
+	}
+	// The trends are a warning source on top of the static thresholds
+	const std::string serial = get_serial_number();
+	return !serial.empty() && storage_trend_apply_warnings(property_repository_, history->get_trends(serial));
 }
 
 
@@ -332,7 +641,7 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::try_parse_data()
 {
 	this->clear_fetched(false);  // clear everything fetched before, except outputs and disk type
 
-	auto parser_format = SmartctlParser::detect_output_format(this->full_output_);
+	auto parser_format = SmartctlParser::detect_output_format(*this->full_output_);
 	if (!parser_format.has_value()) {
 		return hz::Unexpected(StorageDeviceError::ParseError, parser_format.error().message());
 	}
@@ -347,9 +656,10 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::try_parse_data()
 
 	auto parser = SmartctlParser::create(parser_type, parser_format.value());
 	DBG_ASSERT_RETURN(parser, hz::Unexpected(StorageDeviceError::ParseError, _("Cannot create parser")));
+	parser->set_keep_text_output(keep_text_output_);
 
 	// Try to parse it (parse only, set the properties after basic parsing).
-	const auto parse_status = parser->parse(this->full_output_);
+	const auto parse_status = parser->parse(*this->full_output_);
 	if (parse_status.has_value()) {
 
 		// refresh basic info too
@@ -367,7 +677,7 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::try_parse_data()
 		// copy to our drive, overwriting old data.
 		this->set_property_repository(StoragePropertyProcessor::process_properties(parser->get_property_repository(), disk_type));
 
-		signal_changed().emit(this);  // notify listeners
+		emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
 
 		return {};
 	}
@@ -400,8 +710,30 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_full_data(SmartctlPars
 
 	auto parser = SmartctlParser::create(parser_type, format);
 	DBG_ASSERT_RETURN(parser, hz::Unexpected(StorageDeviceError::ParseError, _("Cannot create parser")));
+	parser->set_keep_text_output(keep_text_output_);
+	if (parser_type != SmartctlParserType::Basic) {
+		parser->set_requested_sections(storage_fetch_profile_get_sections(fetch_profile_));
+		parser->set_max_log_entries(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/smartctl_max_log_entries"))));
+	}
+
+	// Refreshes usually change only a few subsections of the text output, reuse the rest
+	if (auto* text_ata_parser = dynamic_cast<SmartctlTextAtaParser*>(parser.get())) {
+		if (!text_subsection_cache_) {
+			text_subsection_cache_ = std::make_shared<SmartctlTextAtaSubsectionCache>();
+		}
+		text_ata_parser->set_subsection_cache(text_subsection_cache_);
+	}
+
+	// Only the error log entries newer than the ones seen before are parsed and described
+	if (parser_type != SmartctlParserType::Basic) {
+		if (!error_log_journal_) {
+			error_log_journal_ = std::make_shared<StorageErrorLogJournal>();
+		}
+		error_log_journal_->begin(parser->get_requested_sections(), parser->get_max_log_entries());
+		parser->set_error_log_journal(error_log_journal_);
+	}
 
-	const auto parse_status = parser->parse(this->full_output_);
+	const auto parse_status = parser->parse(*this->full_output_);
 	if (parse_status.has_value()) {
 		set_parse_status(parser_type == SmartctlParserType::Basic ? ParseStatus::Basic : ParseStatus::Full);
 
@@ -409,12 +741,33 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_full_data(SmartctlPars
 		detect_drive_type_from_properties(parser->get_property_repository());
 
 		// Set the full properties, overwriting old data.
-		set_property_repository(StoragePropertyProcessor::process_properties(parser->get_property_repository(), get_detected_type()));
+		std::function<bool(const StorageProperty& p)> is_processed;
+		if (parser->get_error_log_journal()) {
+			error_log_journal_->set_processing_key(static_cast<std::uint64_t>(get_detected_type())
+					^ (rconfig::get_generation() * 0x9e3779b97f4a7c15ULL));  // settings may affect the warnings
+			is_processed = [journal = error_log_journal_.get()](const StorageProperty& p) {
+				return journal->get_processed(p);
+			};
+		}
+		auto repository = StoragePropertyProcessor::process_properties(parser->take_property_repository(),
+				get_detected_type(), is_processed);
+		if (parser->get_error_log_journal()) {
+			error_log_journal_->finish(repository);
+		}
+		if (nvme_controller_properties_ && parser_type != SmartctlParserType::Basic) {
+			storage_nvme_merge_controller_properties(repository, *nvme_controller_properties_);
+		}
+		if (parser_type != SmartctlParserType::Basic) {
+			// The rates are derived from the previous refresh
+			lifetime_metrics_.update(repository, std::chrono::duration_cast<std::chrono::seconds>(
+					std::chrono::system_clock::now().time_since_epoch()).count());
+		}
+		set_property_repository(std::move(repository));
 
 		// Read common properties from the repository.
 		read_common_properties();
 
-		signal_changed().emit(this);  // notify listeners
+		emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
 
 		return {};
 	}
@@ -431,31 +784,57 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_any_data_for_virtual()
 	// Clear everything fetched before, except outputs and disk type
 	this->clear_parse_results();
 
-	auto parser_format = SmartctlParser::detect_output_format(this->full_output_);
-	if (!parser_format.has_value()) {
-		return hz::Unexpected(StorageDeviceError::ParseError, parser_format.error().message());
+	// This is cheap compared to parsing, and usually tells the drive type as well.
+	auto signature = SmartctlParser::detect_output_signature(*this->full_output_);
+	if (!signature.has_value()) {
+		return hz::Unexpected(StorageDeviceError::ParseError, signature.error().message());
+	}
+	const SmartctlOutputFormat parser_format = signature->format;
+
+	// If the drive type is known, parse the output once, with the specialized parser.
+	bool signature_parser_failed = false;
+	if (signature->parser_type != SmartctlParserType::Basic) {
+		if (auto parser = SmartctlParser::create(signature->parser_type, parser_format)) {
+			parser->set_keep_text_output(keep_text_output_);
+			if (parser->parse(*this->full_output_).has_value()) {
+				if (parser_format == SmartctlOutputFormat::Text) {
+					// The text parsers of specific drive types don't report the drive type, the signature does.
+					set_detected_type(signature->parser_type == SmartctlParserType::Nvme
+							? StorageDeviceDetectedType::Nvme : get_ata_type_from_rotation_rate(parser->get_property_repository()));
+				} else {
+					detect_drive_type_from_properties(parser->get_property_repository());
+				}
+				set_property_repository(StoragePropertyProcessor::process_properties(parser->take_property_repository(), get_detected_type()));
+				read_common_properties();
+				set_parse_status(ParseStatus::Full);
+				emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
+				return {};
+			}
+			signature_parser_failed = true;  // fall back to the basic parser, don't try it again
+		}
 	}
 
-	auto basic_parser = SmartctlParser::create(SmartctlParserType::Basic, parser_format.value());
+	auto basic_parser = SmartctlParser::create(SmartctlParserType::Basic, parser_format);
 	if (!basic_parser) {
 		return hz::Unexpected(StorageDeviceError::ParseError, _("Cannot create parser"));
 	}
+	basic_parser->set_keep_text_output(keep_text_output_);
 
 	// This will add some properties and emit signal_changed().
-	auto basic_parse_status = basic_parser->parse(this->full_output_);
+	auto basic_parse_status = basic_parser->parse(*this->full_output_);
 	if (!basic_parse_status) {
 		std::string message = basic_parse_status.error().message();
 		return hz::Unexpected(StorageDeviceError::ParseError,
 				fmt::format(fmt::runtime(_("Cannot parse smartctl output: {}")), message));
 	}
 
-	auto basic_property_repo = basic_parser->get_property_repository();
+	auto basic_property_repo = basic_parser->take_property_repository();
 
 	// Make detected type more exact.
 	detect_drive_type_from_properties(basic_property_repo);
 
 	// Set properties from the basic parser.
-	set_property_repository(StoragePropertyProcessor::process_properties(basic_property_repo, get_detected_type()));
+	set_property_repository(StoragePropertyProcessor::process_properties(std::move(basic_property_repo), get_detected_type()));
 
 	// Read common properties from the repository.
 	read_common_properties();
@@ -464,29 +843,28 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_any_data_for_virtual()
 	// Try to parse with a specialized parser based on drive type
 	auto parser_type = SmartctlVersionParser::get_default_parser_type(this->get_detected_type());
 
-	if (parser_type != SmartctlParserType::Basic) {
+	if (parser_type != SmartctlParserType::Basic && !(signature_parser_failed && parser_type == signature->parser_type)) {
 		// Try specialized parser
-		auto parser = SmartctlParser::create(parser_type, parser_format.value());
+		auto parser = SmartctlParser::create(parser_type, parser_format);
 		DBG_ASSERT_RETURN(parser, hz::Unexpected(StorageDeviceError::ParseError, _("Cannot create parser.")));
+		parser->set_keep_text_output(keep_text_output_);
 
-		const auto parse_status = parser->parse(this->full_output_);
+		const auto parse_status = parser->parse(*this->full_output_);
 		if (parse_status.has_value()) {
 			// Call this after parse_basic_data(), since it sets parse status to "info".
 			set_parse_status(StorageDevice::ParseStatus::Full);
 
-			// set the full properties.
-			// copy to our drive, overwriting old data.
-			set_property_repository(StoragePropertyProcessor::process_properties(parser->get_property_repository(), get_detected_type()));
+			// set the full properties, overwriting old data.
+			set_property_repository(StoragePropertyProcessor::process_properties(parser->take_property_repository(), get_detected_type()));
 		}
 	}
 
 	if (get_parse_status() != ParseStatus::Full) {
-		// Only basic data available
+		// Only basic data available. The basic properties are already set.
 		set_parse_status(ParseStatus::Basic);
-		set_property_repository(StoragePropertyProcessor::process_properties(basic_parser->get_property_repository(), get_detected_type()));
 	}
 
-	signal_changed().emit(this);  // notify listeners
+	emit_signal_changed(StorageDeviceChange::Properties);  // notify listeners
 
 	// Don't show any GUI warnings on parse failure - it may just be an unsupported
 	// drive (e.g. usb flash disk). Plus, it may flood the string. The data will be
@@ -501,6 +879,55 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::parse_any_data_for_virtual()
 
 
 
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::load_cached_outputs(std::string basic_output,
+		std::string full_output, std::optional<std::chrono::seconds> full_output_age)
+{
+	if (full_output.empty()) {
+		set_info_output(std::move(basic_output));
+		return parse_basic_data();
+	}
+
+	// The full output includes the basic information, so it can be parsed alone (and shared).
+	if (basic_output.empty() || basic_output == full_output) {
+		set_virtual_output(std::move(full_output));
+	} else {
+		set_info_output(std::move(basic_output));
+		set_full_output(std::move(full_output));
+	}
+
+	// The other process may use a different output format, detect it.
+	auto parse_status = parse_any_data_for_virtual();
+	if (parse_status && get_parse_status() == ParseStatus::Full && full_output_age.has_value()) {
+		full_data_time_ = std::chrono::steady_clock::now() - full_output_age.value();
+	}
+	return parse_status;
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::reparse_outputs()
+{
+	if (this->fetch_in_progress_) {
+		return hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved."));
+	}
+	if (this->get_is_virtual()) {
+		return this->parse_any_data_for_virtual();
+	}
+	if (this->get_parse_status() == ParseStatus::Full && !this->get_full_output().empty()) {
+		auto signature = SmartctlParser::detect_output_signature(this->get_full_output());
+		if (!signature.has_value()) {
+			return hz::Unexpected(StorageDeviceError::ParseError, signature.error().message());
+		}
+		return this->parse_full_data(signature->parser_type, signature->format);
+	}
+	if (!this->get_basic_output().empty()) {
+		return this->parse_basic_data();
+	}
+	return {};  // nothing fetched yet
+}
+
+
+
 StorageDevice::ParseStatus StorageDevice::get_parse_status() const
 {
 	return parse_status_;
@@ -514,6 +941,9 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::set_smart_enabled(bool b,
 	if (this->test_is_active_) {
 		return hz::Unexpected(StorageDeviceError::TestRunning, _("A test is currently being performed on this drive."));
 	}
+	if (this->fetch_in_progress_) {
+		return hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved."));
+	}
 
 	// execute smartctl --smart=on|off /dev/...
 	// --saveauto=on is also executed when enabling smart.
@@ -555,29 +985,30 @@ A mandatory SMART command failed: exiting. To continue, add one or more '-T perm
 
 void StorageDevice::read_common_properties()
 {
-	if (auto prop = property_repository_.lookup_property("smart_support/available"); !prop.empty()) {
-		smart_supported_ = prop.get_value<bool>();
+	invalidate_derived_facts();  // smart_supported_, etc. change
+	if (const auto* prop = property_repository_.find_property("smart_support/available")) {
+		smart_supported_ = prop->get_value<bool>();
 	}
-	if (auto prop = property_repository_.lookup_property("smart_support/enabled"); !prop.empty()) {
-		smart_enabled_ = prop.get_value<bool>();
+	if (const auto* prop = property_repository_.find_property("smart_support/enabled")) {
+		smart_enabled_ = prop->get_value<bool>();
 	}
-	if (auto prop = property_repository_.lookup_property("model_name"); !prop.empty()) {
-		model_name_ = prop.get_value<std::string>();
-	} else if (prop = property_repository_.lookup_property("scsi_model_name"); !prop.empty()) {  // USB flash
-		model_name_ = prop.get_value<std::string>();
+	if (const auto* prop = property_repository_.find_property("model_name")) {
+		model_name_ = prop->get_value<std::string>();
+	} else if (prop = property_repository_.find_property("scsi_model_name"); prop) {  // USB flash
+		model_name_ = prop->get_value<std::string>();
 	}
-	if (auto prop = property_repository_.lookup_property("model_family"); !prop.empty()) {
-		family_name_ = prop.get_value<std::string>();
-	} else if (prop = property_repository_.lookup_property("scsi_vendor"); !prop.empty()) {  // USB flash
-		family_name_ = prop.get_value<std::string>();
+	if (const auto* prop = property_repository_.find_property("model_family")) {
+		family_name_ = prop->get_value<std::string>();
+	} else if (prop = property_repository_.find_property("scsi_vendor"); prop) {  // USB flash
+		family_name_ = prop->get_value<std::string>();
 	}
-	if (auto prop = property_repository_.lookup_property("serial_number"); !prop.empty()) {
-		serial_number_ = prop.get_value<std::string>();
+	if (const auto* prop = property_repository_.find_property("serial_number")) {
+		serial_number_ = prop->get_value<std::string>();
 	}
-	if (auto prop = property_repository_.lookup_property("user_capacity/bytes/_short"); !prop.empty()) {
-		size_ = prop.readable_value;
-	} else if (auto prop2 = property_repository_.lookup_property("user_capacity/bytes"); !prop.empty()) {
-		size_ = prop2.readable_value;
+	if (const auto* prop = property_repository_.find_property("user_capacity/bytes/_short")) {
+		size_ = prop->readable_value;
+	} else if (prop = property_repository_.find_property("user_capacity/bytes"); prop) {
+		size_ = prop->readable_value;
 	}
 }
 
@@ -586,29 +1017,24 @@ void StorageDevice::read_common_properties()
 void StorageDevice::detect_drive_type_from_properties(const StoragePropertyRepository& property_repo)
 {
 	// This is set by Text parser
-	if (auto drive_type_prop = property_repo.lookup_property("_text_only/custom/parser_detected_drive_type"); !drive_type_prop.empty()) {
-		const auto& drive_type_storable_str = drive_type_prop.get_value<std::string>();
+	if (const auto* drive_type_prop = property_repo.find_property("_text_only/custom/parser_detected_drive_type")) {
+		const auto& drive_type_storable_str = drive_type_prop->get_value<std::string>();
 		set_detected_type(StorageDeviceDetectedTypeExt::get_by_storable_name(drive_type_storable_str, StorageDeviceDetectedType::BasicScsi));
 
 		// Find out if it's SSD or HDD
 		if (get_detected_type() == StorageDeviceDetectedType::AtaAny) {
-			auto rpm_prop = property_repo.lookup_property("rotation_rate");
-			if (rpm_prop.empty() || rpm_prop.get_value<std::int64_t>() == 0) {
-				set_detected_type(StorageDeviceDetectedType::AtaSsd);
-			} else {
-				set_detected_type(StorageDeviceDetectedType::AtaHdd);
-			}
+			set_detected_type(get_ata_type_from_rotation_rate(property_repo));
 		}
 	}
 
 	// This is set by JSON parser
-	if (auto device_type_prop = property_repo.lookup_property("device/type"); !device_type_prop.empty()) {
+	if (const auto* device_type_prop = property_repo.find_property("device/type")) {
 		// Note: USB flash drives in non-scsi mode do not have this property.
-		const auto& smartctl_type = device_type_prop.get_value<std::string>();
+		const auto& smartctl_type = device_type_prop->get_value<std::string>();
 
 		std::string lowercase_protocol;
-		if (auto device_protocol_prop = property_repo.lookup_property("device/protocol"); !device_protocol_prop.empty()) {
-			lowercase_protocol = hz::string_to_lower_copy(device_protocol_prop.get_value<std::string>());
+		if (const auto* device_protocol_prop = property_repo.find_property("device/protocol")) {
+			lowercase_protocol = hz::string_to_lower_copy(device_protocol_prop->get_value<std::string>());
 		}
 
 		// USB flash in scsi mode, optical, scsi, etc.
@@ -623,12 +1049,7 @@ void StorageDevice::detect_drive_type_from_properties(const StoragePropertyRepos
 		// (S)ATA, including behind supported RAID controllers
 		} else if (smartctl_type == "sat" || lowercase_protocol == "ata") {
 			// Find out if it's SSD or HDD
-			auto rpm_prop = property_repo.lookup_property("rotation_rate");
-			if (rpm_prop.empty() || rpm_prop.get_value<std::int64_t>() == 0) {
-				set_detected_type(StorageDeviceDetectedType::AtaSsd);
-			} else {
-				set_detected_type(StorageDeviceDetectedType::AtaHdd);
-			}
+			set_detected_type(get_ata_type_from_rotation_rate(property_repo));
 
 		// NVMe SSD.
 		// Note: NVMe behind USB bridge may have type "sntrealtek" or similar, with protocol "nvme".
@@ -653,6 +1074,10 @@ void StorageDevice::detect_drive_type_from_properties(const StoragePropertyRepos
 
 StorageDevice::SmartStatus StorageDevice::get_smart_status() const
 {
+	if (derived_facts_.smart_status.has_value()) {
+		return derived_facts_.smart_status.value();
+	}
+
 	SmartStatus status = SmartStatus::Unsupported;
 	if (smart_enabled_.has_value()) {
 		if (smart_enabled_.value()) {  // enabled, supported
@@ -679,6 +1104,7 @@ StorageDevice::SmartStatus StorageDevice::get_smart_status() const
 			status = SmartStatus::Unsupported;
 		}
 	}
+	derived_facts_.smart_status = status;
 	return status;
 }
 
@@ -686,53 +1112,50 @@ StorageDevice::SmartStatus StorageDevice::get_smart_status() const
 
 bool StorageDevice::get_smart_switch_supported() const
 {
-	const bool supported = get_smart_status() != SmartStatus::Unsupported;
-	// NVMe does not support on/off
-	const bool is_nvme = get_detected_type() == StorageDeviceDetectedType::Nvme;
+	if (!derived_facts_.smart_switch_supported.has_value()) {
+		const bool supported = get_smart_status() != SmartStatus::Unsupported;
+		// NVMe does not support on/off
+		const bool is_nvme = get_detected_type() == StorageDeviceDetectedType::Nvme;
 
-	return !get_is_virtual() && supported && !is_nvme;
+		derived_facts_.smart_switch_supported = !get_is_virtual() && supported && !is_nvme;
+	}
+	return derived_facts_.smart_switch_supported.value();
 }
 
 
 
-std::string StorageDevice::get_device_size_str() const
+const std::string& StorageDevice::get_device_size_str() const
 {
-	return (size_.has_value() ? size_.value() : "");
+	static const std::string empty;
+	return (size_.has_value() ? size_.value() : empty);
 }
 
 
 
-StorageProperty StorageDevice::get_health_property() const
+const StorageProperty& StorageDevice::get_health_property() const
 {
-	if (health_property_.has_value())  // cached return value
-		return health_property_.value();
-
-	StorageProperty p = property_repository_.lookup_property("smart_status/passed",
-			StoragePropertySection::OverallHealth);
-	if (!p.empty())
-		health_property_ = p;  // store to cache
-
-	return p;
+	return health_property_;
 }
 
 
 
-std::string StorageDevice::get_device() const
+const std::string& StorageDevice::get_device() const
 {
 	return device_;
 }
 
 
 
-std::string StorageDevice::get_device_base() const
+std::string_view StorageDevice::get_device_base() const
 {
 	if (is_virtual_)
-		return "";
+		return {};
 
-	const std::string::size_type pos = device_.rfind('/');  // find basename
-	if (pos == std::string::npos)
-		return device_;  // fall back
-	return device_.substr(pos+1, std::string::npos);
+	const std::string_view device = device_;
+	const std::string_view::size_type pos = device.rfind('/');  // find basename
+	if (pos == std::string_view::npos)
+		return device;  // fall back
+	return device.substr(pos+1);
 }
 
 
@@ -749,6 +1172,9 @@ std::string StorageDevice::get_device_with_type() const
 	if (!get_type_argument().empty()) {
 		device = Glib::ustring::compose(_("%1 (%2)"), device, get_type_argument());
 	}
+	if (remote_host_) {
+		device = remote_host_->get_destination() + ":" + device;
+	}
 	return device;
 }
 
@@ -757,6 +1183,7 @@ std::string StorageDevice::get_device_with_type() const
 void StorageDevice::set_detected_type(StorageDeviceDetectedType t)
 {
 	detected_type_ = t;
+	invalidate_derived_facts();
 }
 
 
@@ -771,11 +1198,12 @@ StorageDeviceDetectedType StorageDevice::get_detected_type() const
 void StorageDevice::set_type_argument(std::string arg)
 {
 	type_arg_ = std::move(arg);
+	update_sort_key();
 }
 
 
 
-std::string StorageDevice::get_type_argument() const
+const std::string& StorageDevice::get_type_argument() const
 {
 	return type_arg_;
 }
@@ -789,13 +1217,49 @@ void StorageDevice::set_extra_arguments(std::vector<std::string> args)
 
 
 
-std::vector<std::string> StorageDevice::get_extra_arguments() const
+const std::vector<std::string>& StorageDevice::get_extra_arguments() const
 {
 	return extra_args_;
 }
 
 
 
+void StorageDevice::set_remote_host(RemoteHostPtr host)
+{
+	remote_host_ = std::move(host);
+	update_sort_key();
+}
+
+
+
+RemoteHostPtr StorageDevice::get_remote_host() const
+{
+	return remote_host_;
+}
+
+
+
+std::string StorageDevice::get_remote_host_name() const
+{
+	return remote_host_ ? remote_host_->get_destination() : std::string();
+}
+
+
+
+std::string StorageDevice::get_nvme_controller_key() const
+{
+	if (get_is_virtual() || get_detected_type() != StorageDeviceDetectedType::Nvme) {
+		return {};
+	}
+	const auto name = storage_nvme_parse_device_name(get_device());
+	if (!name.has_value()) {
+		return {};  // e.g. NVMe behind a USB bridge
+	}
+	return storage_nvme_controller_get_key(get_remote_host_name(), name->controller, fetch_profile_);
+}
+
+
+
 void StorageDevice::set_drive_letters(std::map<char, std::string> letters)
 {
 	drive_letters_ = std::move(letters);
@@ -846,6 +1310,49 @@ std::string StorageDevice::get_virtual_filename() const
 
 
 
+StorageDevice::SnapshotPtr StorageDevice::get_snapshot() const
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+	return snapshot_.load(std::memory_order_acquire);
+#else
+	return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+#endif
+}
+
+
+
+bool StorageDevice::SortKey::operator< (const SortKey& other) const
+{
+	return std::tie(is_virtual, remote_host, virtual_file, device_base, type_arg)
+			< std::tie(other.is_virtual, other.remote_host, other.virtual_file, other.device_base, other.type_arg);
+}
+
+
+
+const StorageDevice::SortKey& StorageDevice::get_sort_key() const
+{
+	return sort_key_;
+}
+
+
+
+void StorageDevice::update_sort_key()
+{
+	sort_key_.is_virtual = is_virtual_;
+	sort_key_.remote_host = get_remote_host_name();
+	if (is_virtual_) {
+		sort_key_.virtual_file = virtual_file_;
+		sort_key_.device_base.clear();
+		sort_key_.type_arg.clear();
+	} else {
+		sort_key_.virtual_file.clear();
+		sort_key_.device_base = get_device_base();
+		sort_key_.type_arg = type_arg_;
+	}
+}
+
+
+
 const StoragePropertyRepository& StorageDevice::get_property_repository() const
 {
 	return property_repository_;
@@ -853,9 +1360,10 @@ const StoragePropertyRepository& StorageDevice::get_property_repository() const
 
 
 
-std::string StorageDevice::get_model_name() const
+const std::string& StorageDevice::get_model_name() const
 {
-	return (model_name_.has_value() ? model_name_.value() : "");
+	static const std::string empty;
+	return (model_name_.has_value() ? model_name_.value() : empty);
 }
 
 
@@ -867,37 +1375,212 @@ std::string StorageDevice::get_family_name() const
 
 
 
-std::string StorageDevice::get_serial_number() const
+const std::string& StorageDevice::get_serial_number() const
 {
-	return (serial_number_.has_value() ? serial_number_.value() : "");
+	static const std::string empty;
+	return (serial_number_.has_value() ? serial_number_.value() : empty);
 }
 
 
 
 void StorageDevice::set_info_output(std::string s)
 {
-	basic_output_ = std::move(s);
+	basic_output_ = std::make_shared<const std::string>(std::move(s));
 }
 
 
 
-std::string StorageDevice::get_basic_output() const
+const std::string& StorageDevice::get_basic_output() const
 {
-	return basic_output_;
+	return *basic_output_;
 }
 
 
 
 void StorageDevice::set_full_output(std::string s)
 {
-	full_output_ = std::move(s);
+	full_output_ = std::make_shared<const std::string>(std::move(s));
+}
+
+
+
+const std::string& StorageDevice::get_full_output() const
+{
+	return *full_output_;
 }
 
 
 
-std::string StorageDevice::get_full_output() const
+void StorageDevice::set_virtual_output(std::string s)
 {
-	return full_output_;
+	full_output_ = std::make_shared<const std::string>(std::move(s));
+	basic_output_ = full_output_;
+}
+
+
+
+hz::ExpectedValue<std::string, StorageDeviceError> StorageDevice::get_text_output(
+		const std::shared_ptr<CommandExecutor>& smartctl_ex)
+{
+	if (!text_output_.empty()) {
+		return text_output_;
+	}
+	const bool full = !get_full_output().empty();
+	const std::string& output = (full ? get_full_output() : get_basic_output());
+
+	auto format = SmartctlParser::detect_output_format(output);
+	if (!output.empty() && (!format || format.value() == SmartctlOutputFormat::Text)) {
+		return output;
+	}
+	// Embedded with --json=o (and kept by the parser)
+	if (auto p = property_repository_.lookup_property("smartctl/output"); !p.empty()) {
+		if (auto text = p.get_value<std::string>(); !text.empty()) {
+			return text;
+		}
+	}
+	if (this->get_is_virtual()) {
+		return hz::Unexpected(StorageDeviceError::CannotExecuteOnVirtual, _("The text output is not available in this data file."));
+	}
+	if (this->test_is_active_) {
+		return hz::Unexpected(StorageDeviceError::TestRunning, _("A test is currently being performed on this drive."));
+	}
+
+	// Run the same command as the last fetch, in text format
+	std::vector<std::string> command_options = {"--info", "--health", "--capabilities"};
+	if (full) {
+		command_options = storage_fetch_profile_get_smartctl_options(fetch_profile_, this->get_detected_type());
+	}
+	std::string text;
+	if (auto execute_status = execute_device_smartctl(command_options, smartctl_ex, text); !execute_status) {
+		return hz::Unexpected(StorageDeviceError(execute_status.error().data()), execute_status.error().message());
+	}
+	text_output_ = text;
+	return text;
+}
+
+
+
+StorageDeviceMemoryUsage StorageDevice::get_memory_usage() const
+{
+	StorageDeviceMemoryUsage usage;
+
+	usage.outputs = basic_output_->size() + text_output_.size();
+	if (full_output_ != basic_output_) {
+		usage.outputs += full_output_->size();
+	}
+	if (compacted_full_output_) {
+		usage.outputs += compacted_full_output_->size();
+	}
+
+	usage.properties = property_repository_.get_memory_usage();
+	usage.property_count = property_repository_.get_properties().size();
+
+	// health_property_ is a part of the object, count its strings only
+	usage.other = sizeof(StorageDevice) + device_.size() + type_arg_.size() + virtual_file_.native().size()
+			+ health_property_.get_memory_usage() - sizeof(StorageProperty);
+	for (const auto& arg : extra_args_) {
+		usage.other += sizeof(std::string) + arg.size();
+	}
+	for (const auto& [letter, volume] : drive_letters_) {
+		usage.other += sizeof(char) + sizeof(std::string) + 3 * sizeof(void*) + volume.size();  // map node
+	}
+	for (const auto* str : {&model_name_, &family_name_, &serial_number_, &size_}) {
+		usage.other += str->has_value() ? str->value().size() : 0;
+	}
+
+	return usage;
+}
+
+
+
+bool StorageDevice::compact_data()
+{
+	if (compacted_full_output_ || parse_status_ != ParseStatus::Full || full_output_->empty()
+			|| test_is_active_ || fetch_in_progress_ || worker_fetch_in_progress_) {
+		return false;
+	}
+
+	// Keep the output as is if it can't be compressed, the properties are the bigger part anyway
+	auto compressed = storage_output_compress(*full_output_, StorageOutputCompression::Gzip);
+	compacted_full_output_ = (compressed ? std::make_shared<const std::string>(std::move(compressed.value())) : full_output_);
+	compacted_full_output_size_ = full_output_->size();
+	compacted_shared_output_ = (basic_output_ == full_output_);
+
+	full_output_ = std::make_shared<const std::string>();
+	if (compacted_shared_output_) {
+		basic_output_ = full_output_;
+	}
+	text_output_.clear();
+	text_subsection_cache_.reset();
+	error_log_journal_.reset();
+	full_output_hash_.reset();  // the next fetch must parse the output even if it's the same
+
+	// The summary: whatever makes the drive stand out, plus what the icon shows
+	StoragePropertyRepository summary;
+	for (const auto& p : property_repository_.get_properties()) {
+		if (p.warning_level != WarningLevel::None || p.generic_name == "local_time/asctime") {
+			summary.add_property(p);
+		}
+	}
+	property_repository_ = std::move(summary);
+	invalidate_derived_facts();
+
+	// The listeners have seen the full properties. If they get the differences relative to
+	// the summary after the next fetch, they see the unchanged properties as added, which is harmless.
+	notified_property_repository_ = property_repository_;
+
+	publish_snapshot();  // nothing has changed for the listeners, don't notify them
+
+	debug_out_dump("app", DBG_FUNC_MSG << "Compacted the data of " << get_device_with_type() << " ("
+			<< compacted_full_output_size_ << " bytes of output to " << compacted_full_output_->size() << ").\n");
+	return true;
+}
+
+
+
+bool StorageDevice::get_data_compacted() const
+{
+	return compacted_full_output_ != nullptr;
+}
+
+
+
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::restore_compacted_data()
+{
+	if (!compacted_full_output_) {
+		return {};
+	}
+	if (fetch_in_progress_ || worker_fetch_in_progress_) {
+		return hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved."));
+	}
+
+	auto output = storage_output_decompress(*compacted_full_output_, compacted_full_output_size_);
+	if (!output) {
+		full_data_time_.reset();
+		return hz::Unexpected(StorageDeviceError::ParseError,
+				fmt::format(fmt::runtime(_("Cannot restore the compacted drive data: {}")), output.error().message()));
+	}
+
+	const bool shared_output = compacted_shared_output_;
+	const auto full_data_time = full_data_time_;
+	full_output_ = std::make_shared<const std::string>(std::move(output.value()));
+	if (shared_output) {
+		basic_output_ = full_output_;
+	}
+	debug_out_dump("app", DBG_FUNC_MSG << "Restoring the compacted data of " << get_device_with_type() << ".\n");
+
+	// The parsers clear the compacted state. The output was parsed the same way before.
+	hz::ExpectedVoid<StorageDeviceError> parse_status;
+	if (shared_output || is_virtual_) {
+		parse_status = parse_any_data_for_virtual();
+	} else {
+		const auto parser_type = SmartctlVersionParser::get_default_parser_type(get_detected_type());
+		parse_status = parse_full_data(parser_type, SmartctlVersionParser::get_default_format(parser_type));
+	}
+	if (parse_status) {
+		full_data_time_ = full_data_time;  // still the time of the fetch
+	}
+	return parse_status;
 }
 
 
@@ -916,12 +1599,69 @@ bool StorageDevice::get_is_manually_added() const
 
 
 
+void StorageDevice::set_keep_text_output(bool b)
+{
+	keep_text_output_ = b;
+}
+
+
+
+bool StorageDevice::get_keep_text_output() const
+{
+	return keep_text_output_;
+}
+
+
+
+void StorageDevice::set_fetch_profile(StorageFetchProfile profile)
+{
+	fetch_profile_ = profile;
+	invalidate_derived_facts();
+}
+
+
+
+StorageFetchProfile StorageDevice::get_fetch_profile() const
+{
+	return fetch_profile_;
+}
+
+
+
+void StorageDevice::set_standby_aware(bool b)
+{
+	standby_aware_ = b;
+}
+
+
+
+bool StorageDevice::get_standby_aware() const
+{
+	return standby_aware_;
+}
+
+
+
+bool StorageDevice::get_in_standby() const
+{
+	return in_standby_;
+}
+
+
+
+std::optional<std::chrono::steady_clock::time_point> StorageDevice::get_full_data_time() const
+{
+	return full_data_time_;
+}
+
+
+
 void StorageDevice::set_test_is_active(bool b)
 {
 	const bool changed = (test_is_active_ != b);
 	test_is_active_ = b;
 	if (changed) {
-		signal_changed().emit(this);  // so that everybody stops any test-aborting operations.
+		emit_signal_changed(StorageDeviceChange::Activity);  // so that everybody stops any test-aborting operations.
 	}
 }
 
@@ -936,14 +1676,20 @@ bool StorageDevice::get_test_is_active() const
 
 StorageDevice::SelfTestSupportStatus StorageDevice::get_self_test_support_status() const
 {
-	if (get_parse_status() == ParseStatus::Full) {
-		return property_repository_.has_properties_for_section(StoragePropertySection::SelftestLog) ?
-				SelfTestSupportStatus::Supported : SelfTestSupportStatus::Unsupported;
+	if (derived_facts_.self_test_support_status.has_value()) {
+		return derived_facts_.self_test_support_status.value();
 	}
-	if (get_parse_status() == ParseStatus::Basic) {
-		return get_smart_status() == SmartStatus::Enabled ? SelfTestSupportStatus::Unknown : SelfTestSupportStatus::Unsupported;
+
+	SelfTestSupportStatus status = SelfTestSupportStatus::Unknown;
+	// The monitoring profile doesn't fetch the self-test log
+	if (get_parse_status() == ParseStatus::Full && fetch_profile_ == StorageFetchProfile::Full) {
+		status = property_repository_.has_properties_for_section(StoragePropertySection::SelftestLog) ?
+				SelfTestSupportStatus::Supported : SelfTestSupportStatus::Unsupported;
+	} else if (get_parse_status() != ParseStatus::None) {
+		status = get_smart_status() == SmartStatus::Enabled ? SelfTestSupportStatus::Unknown : SelfTestSupportStatus::Unsupported;
 	}
-	return StorageDevice::SelfTestSupportStatus::Unknown;
+	derived_facts_.self_test_support_status = status;
+	return status;
 }
 
 
@@ -981,7 +1727,7 @@ std::vector<std::string> StorageDevice::get_device_options() const
 		args.push_back(get_type_argument());
 	}
 	// extra args, as specified manually in CLI or when adding the drive
-	auto extra_args = get_extra_arguments();
+	const auto& extra_args = get_extra_arguments();
 	args.insert(args.end(), extra_args.begin(), extra_args.end());
 
 	// config options, as specified in preferences.
@@ -994,7 +1740,7 @@ std::vector<std::string> StorageDevice::get_device_options() const
 
 
 hz::ExpectedVoid<StorageDeviceError> StorageDevice::execute_device_smartctl(const std::vector<std::string>& command_options,
-		const std::shared_ptr<CommandExecutor>& smartctl_ex, std::string& smartctl_output, bool check_type)
+		const std::shared_ptr<CommandExecutor>& smartctl_ex, CommandOutputPtr& smartctl_output, bool check_type, CommandOperation operation)
 {
 	// don't forbid running on currently tested drive - we need to call this from the test code.
 
@@ -1005,8 +1751,39 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::execute_device_smartctl(cons
 
 	const std::string device = get_device();
 
-	auto smartctl_status = execute_smartctl(device, this->get_device_options(),
-			command_options, smartctl_ex, smartctl_output);
+	hz::ExpectedVoid<SmartctlExecutorError> smartctl_status;
+
+	bool executed_by_helper = false;
+	if (const auto helper = storage_privileged_helper_get_global(); helper && !remote_host_) {
+		// The local drives are opened by the privileged helper, we may not have the permissions.
+		std::vector<std::string> options = this->get_device_options();
+		options.insert(options.end(), command_options.begin(), command_options.end());
+		auto helper_status = helper->execute_smartctl(device, options, smartctl_output,
+				smartctl_ex ? smartctl_ex->get_cancellation() : nullptr);
+		if (helper_status || helper_status.error().data() != StoragePrivilegedHelperError::Unavailable) {
+			executed_by_helper = true;
+			if (!helper_status) {
+				smartctl_status = hz::Unexpected(SmartctlExecutorError::ExecutionError, helper_status.error().message());
+			}
+		} else {
+			debug_out_warn("app", DBG_FUNC_MSG << "The privileged helper is unavailable, running smartctl directly: "
+					<< helper_status.error().message() << "\n");
+		}
+	}
+
+	if (!executed_by_helper) {
+		// The executor may come from a local factory, make sure it runs on the drive's host.
+		std::shared_ptr<CommandExecutor> ex = smartctl_ex;
+		if (!ex && remote_host_) {
+			ex = std::make_shared<SmartctlExecutor>();
+		}
+		if (ex) {
+			ex->set_remote_host(remote_host_);
+		}
+
+		smartctl_status = execute_smartctl(device, this->get_device_options(),
+				command_options, ex, smartctl_output, operation);
+	}
 
 	if (!smartctl_status) {
 		debug_out_warn("app", DBG_FUNC_MSG << "Smartctl binary did not execute cleanly.\n");
@@ -1016,9 +1793,9 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::execute_device_smartctl(cons
 		// and there is no information about the device manufacturer/etc. in the output.
 		// We detect this and set the device type to scsi to at least have _some_ info.
 
-		// Note: This match works even with JSON (the text output is included in --json=o).
-		if (check_type && this->get_detected_type() == StorageDeviceDetectedType::Unknown
-				&& app_regex_partial_match("/specify device type with the -d option/mi", smartctl_output)) {
+		// Note: This match works with JSON too (the message is in "smartctl/messages").
+		if (check_type && this->get_detected_type() == StorageDeviceDetectedType::Unknown && smartctl_output
+				&& app_regex_partial_match("/specify device type with the -d option/mi", *smartctl_output)) {
 			this->set_detected_type(StorageDeviceDetectedType::NeedsExplicitType);
 		}
 
@@ -1030,6 +1807,115 @@ hz::ExpectedVoid<StorageDeviceError> StorageDevice::execute_device_smartctl(cons
 
 
 
+hz::ExpectedVoid<StorageDeviceError> StorageDevice::execute_device_smartctl(const std::vector<std::string>& command_options,
+		const std::shared_ptr<CommandExecutor>& smartctl_ex, std::string& smartctl_output, bool check_type, CommandOperation operation)
+{
+	CommandOutputPtr output;
+	auto status = execute_device_smartctl(command_options, smartctl_ex, output, check_type, operation);
+	smartctl_output = (output ? *output : std::string());
+	return status;
+}
+
+
+
+namespace {
+
+	/// State of StorageDevice::fetch_full_data_and_parse_async(). Created and destroyed
+	/// in the calling thread, so the sigc slot is never touched by the worker thread.
+	struct StorageDeviceAsyncFetch {
+		StorageDevicePtr drive;  ///< Drive, kept alive until the fetch is finished
+		std::shared_ptr<CommandExecutor> smartctl_ex;  ///< Executor
+		StorageDevice::fetch_finished_slot_t finished_slot;  ///< Called when finished
+		hz::ExpectedVoid<StorageDeviceError> status;  ///< Fetch status, written by the worker thread
+		GMainContext* context = nullptr;  ///< Main context of the calling thread
+	};
+
+}
+
+
+
+void StorageDevice::fetch_full_data_and_parse_async(std::shared_ptr<CommandExecutor> smartctl_ex,
+		const fetch_finished_slot_t& finished_slot)
+{
+	auto* fetch = new StorageDeviceAsyncFetch();
+	fetch->drive = shared_from_this();
+	fetch->smartctl_ex = std::move(smartctl_ex);
+	fetch->finished_slot = finished_slot;
+	fetch->context = g_main_context_get_thread_default();
+	if (!fetch->context) {
+		fetch->context = g_main_context_default();
+	}
+	g_main_context_ref(fetch->context);
+
+	// Called in the calling thread's main context when the worker is done
+	static const auto finish_func = [](gpointer data) -> gboolean {
+		auto* f = static_cast<StorageDeviceAsyncFetch*>(data);
+		f->drive->fetch_in_progress_ = false;
+		f->drive->emit_signal_changed(StorageDeviceChange::Activity);  // parsing emitted nothing while in the worker thread
+		if (f->finished_slot) {  // empty if its object was destroyed
+			f->finished_slot(f->drive.get(), f->status);
+		}
+		return FALSE;
+	};
+	static const auto destroy_func = [](gpointer data) {
+		auto* f = static_cast<StorageDeviceAsyncFetch*>(data);
+		g_main_context_unref(f->context);
+		delete f;
+	};
+
+	if (this->test_is_active_ || this->fetch_in_progress_) {
+		fetch->status = (this->test_is_active_
+				? hz::Unexpected(StorageDeviceError::TestRunning, _("A test is currently being performed on this drive."))
+				: hz::Unexpected(StorageDeviceError::FetchInProgress, _("The drive data is currently being retrieved.")));
+		// Report it asynchronously too, so that the callers have one code path.
+		// Don't use finish_func, it would reset the flag of the running fetch.
+		g_main_context_invoke_full(fetch->context, G_PRIORITY_DEFAULT, [](gpointer data) -> gboolean {
+			auto* f = static_cast<StorageDeviceAsyncFetch*>(data);
+			if (f->finished_slot) {
+				f->finished_slot(f->drive.get(), f->status);
+			}
+			return FALSE;
+		}, fetch, destroy_func);
+		return;
+	}
+
+	this->fetch_in_progress_ = true;
+
+	// The executor attaches its event sources to the task's own context
+	app_post_worker_task([fetch]() {
+		fetch->status = fetch->drive->do_fetch_full_data_and_parse(fetch->smartctl_ex);
+		fetch->smartctl_ex.reset();
+
+		// Don't touch fetch after this, it's owned by the calling thread's context.
+		GMainContext* context = fetch->context;
+		g_main_context_invoke_full(context, G_PRIORITY_DEFAULT, finish_func, fetch, destroy_func);
+	});
+}
+
+
+
+bool StorageDevice::get_fetch_in_progress() const
+{
+	return fetch_in_progress_ || worker_fetch_in_progress_;
+}
+
+
+
+void StorageDevice::begin_worker_fetch()
+{
+	worker_fetch_in_progress_ = true;
+}
+
+
+
+void StorageDevice::end_worker_fetch()
+{
+	worker_fetch_in_progress_ = false;
+	emit_signal_changed(StorageDeviceChange::Activity);  // parsing emitted nothing while in the worker thread
+}
+
+
+
 sigc::signal<void, StorageDevice*>& StorageDevice::signal_changed()
 {
 	return signal_changed_;
@@ -1037,15 +1923,138 @@ sigc::signal<void, StorageDevice*>& StorageDevice::signal_changed()
 
 
 
+sigc::signal<void, StorageDevice*, StorageDeviceChange>& StorageDevice::signal_changed_coalesced()
+{
+	return signal_changed_coalesced_;
+}
+
+
+
+sigc::signal<void, StorageDevice*, const StoragePropertyDiff&>& StorageDevice::signal_properties_changed()
+{
+	return signal_properties_changed_;
+}
+
+
+
+void StorageDevice::publish_snapshot()
+{
+	auto snapshot = std::make_shared<Snapshot>();
+	snapshot->basic_output = basic_output_;
+	snapshot->full_output = full_output_;
+	snapshot->property_repository = property_repository_;
+	snapshot->detected_type = detected_type_;
+	snapshot->parse_status = parse_status_;
+	snapshot->smart_status = get_smart_status();
+	snapshot->model_name = get_model_name();
+	snapshot->family_name = get_family_name();
+	snapshot->serial_number = get_serial_number();
+	snapshot->size = get_device_size_str();
+	snapshot->health_property = health_property_;
+	snapshot->test_is_active = test_is_active_;
+	snapshot->in_standby = in_standby_;
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+	snapshot_.store(std::move(snapshot), std::memory_order_release);
+#else
+	std::atomic_store_explicit(&snapshot_, SnapshotPtr(std::move(snapshot)), std::memory_order_release);
+#endif
+}
+
+
+
+void StorageDevice::emit_signal_changed(StorageDeviceChange changes)
+{
+	// Readers of other threads see the new state right away
+	publish_snapshot();
+
+	pending_changes_.fetch_or(static_cast<std::uint32_t>(changes), std::memory_order_relaxed);
+
+	// The listeners are usually GUI objects, don't call them from the worker thread.
+	if (fetch_in_progress_ || worker_fetch_in_progress_) {
+		return;
+	}
+
+	// Don't keep a copy of the properties if nobody needs the differences
+	if (signal_properties_changed_.empty()) {
+		notified_property_repository_.clear();
+	} else {
+		const StoragePropertyDiff diff = storage_property_repository_diff(notified_property_repository_, property_repository_);
+		notified_property_repository_ = property_repository_;
+		if (!diff.empty()) {
+			signal_properties_changed_.emit(this, diff);
+		}
+	}
+
+	signal_changed_.emit(this);
+
+	if (signal_changed_coalesced_.empty()) {
+		pending_changes_.store(0, std::memory_order_relaxed);
+		return;
+	}
+	if (coalesced_emission_scheduled_) {
+		return;
+	}
+	// Without an owner, there's nothing to keep the drive alive until the emission
+	std::weak_ptr<StorageDevice> weak_self = weak_from_this();
+	if (weak_self.expired()) {
+		emit_signal_changed_coalesced();
+		return;
+	}
+	coalesced_emission_scheduled_ = true;
+	auto emit_func = [weak_self]() {
+		if (auto self = weak_self.lock()) {
+			self->emit_signal_changed_coalesced();
+		}
+	};
+	static const rconfig::Key<int> interval_msec("gui/change_notification_interval_msec");
+	if (const int interval = interval_msec.get(); interval > 0) {
+		Glib::signal_timeout().connect_once(emit_func, static_cast<unsigned int>(interval), Glib::PRIORITY_HIGH_IDLE);
+	} else {
+		// Before the redraw, which is at a lower priority
+		Glib::signal_idle().connect_once(emit_func, Glib::PRIORITY_HIGH_IDLE);
+	}
+}
+
+
+
+void StorageDevice::emit_signal_changed_coalesced()
+{
+	coalesced_emission_scheduled_ = false;
+	// The changes made by a worker fetch meanwhile are delivered after the fetch
+	if (fetch_in_progress_ || worker_fetch_in_progress_) {
+		return;
+	}
+	const auto changes = static_cast<StorageDeviceChange>(pending_changes_.exchange(0, std::memory_order_relaxed));
+	if (changes != StorageDeviceChange::None) {
+		signal_changed_coalesced_.emit(this, changes);
+	}
+}
+
+
+
 void StorageDevice::set_parse_status(ParseStatus value)
 {
 	parse_status_ = value;
+	if (value == ParseStatus::Full) {  // has the health and capabilities too
+		basic_data_identity_only_ = false;
+	}
+	invalidate_derived_facts();
 }
 
 
 void StorageDevice::set_property_repository(StoragePropertyRepository repository)
 {
 	property_repository_ = std::move(repository);
+	health_property_ = property_repository_.lookup_property("smart_status/passed", StoragePropertySection::OverallHealth);
+	invalidate_derived_facts();
+}
+
+
+
+void StorageDevice::invalidate_derived_facts()
+{
+	derived_facts_ = DerivedFacts();
 }
 
 
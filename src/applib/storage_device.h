@@ -12,18 +12,28 @@ Copyright:
 #ifndef STORAGE_DEVICE_H
 #define STORAGE_DEVICE_H
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
 #include <optional>
 #include <memory>
 #include <sigc++/sigc++.h>
 
+#include "hz/error_container.h"
+
 #include "hz/fs_ns.h"
 #include "storage_property.h"
 #include "smartctl_text_ata_parser.h"  // prop_list_t
 #include "smartctl_executor.h"
 #include "storage_property_repository.h"
+#include "storage_property_diff.h"
 #include "storage_device_detected_type.h"
+#include "storage_fetch_profile.h"
+#include "storage_lifetime_metrics.h"
 
 
 
@@ -44,13 +54,72 @@ enum class StorageDeviceError {
 	CommandFailed,  ///< SMART command (e.g. enable/disable SMART) failed.
 	CommandUnknownError,  ///< Unknown error from the command.
 	ParseError,  ///< Error parsing the output.
+	FetchInProgress,  ///< An asynchronous fetch is in progress on this device.
+	IoctlPollUnavailable,  ///< The data cannot be polled with ioctls, a full fetch is needed.
+};
+
+
+
+/// What changed in a drive, see StorageDevice::signal_changed_coalesced(). The values are bit flags.
+enum class StorageDeviceChange : std::uint32_t {
+	None = 0,  ///< Nothing
+	Properties = 1U << 0,  ///< Outputs, properties, parse status and the data read from them (model, SMART status, ...)
+	Standby = 1U << 1,  ///< get_in_standby()
+	Activity = 1U << 2,  ///< get_test_is_active(), or the end of get_fetch_in_progress()
+};
+
+
+/// Combine the change flags
+[[nodiscard]] constexpr StorageDeviceChange operator|(StorageDeviceChange a, StorageDeviceChange b)
+{
+	return static_cast<StorageDeviceChange>(static_cast<std::uint32_t>(a) | static_cast<std::uint32_t>(b));
+}
+
+
+/// Intersect the change flags
+[[nodiscard]] constexpr StorageDeviceChange operator&(StorageDeviceChange a, StorageDeviceChange b)
+{
+	return static_cast<StorageDeviceChange>(static_cast<std::uint32_t>(a) & static_cast<std::uint32_t>(b));
+}
+
+
+/// Check whether \c changes has any of the \c flags
+[[nodiscard]] constexpr bool storage_device_change_has(StorageDeviceChange changes, StorageDeviceChange flags)
+{
+	return (changes & flags) != StorageDeviceChange::None;
+}
+
+
+
+/// How often StorageDevice::fetch_full_data_and_parse() found the output unchanged and skipped the parsing
+struct StorageDeviceParseSkipStats {
+	std::uint64_t hits = 0;  ///< Fetches with unchanged output, not parsed
+	std::uint64_t misses = 0;  ///< Fetches which had to be parsed
+};
+
+
+/// Approximate memory usage of a drive, see StorageDevice::get_memory_usage()
+struct StorageDeviceMemoryUsage {
+	std::size_t outputs = 0;  ///< Raw smartctl outputs (basic, full and text). An output shared by both is counted once.
+	std::size_t properties = 0;  ///< Parsed properties, with their strings
+	std::size_t property_count = 0;  ///< Number of parsed properties
+	std::size_t other = 0;  ///< The object itself and its other members
+
+	/// Get the total memory usage
+	[[nodiscard]] std::size_t get_total() const
+	{
+		return outputs + properties + other;
+	}
 };
 
 
 /// This class represents a single drive
-class StorageDevice {
+class StorageDevice : public std::enable_shared_from_this<StorageDevice> {
 	public:
 
+		/// Callback for fetch_full_data_and_parse_async()
+		using fetch_finished_slot_t = sigc::slot<void, StorageDevice*, hz::ExpectedVoid<StorageDeviceError>>;
+
 		/// Statuses of various states
 		enum class SmartStatus {
 			Enabled,
@@ -62,6 +131,10 @@ class StorageDevice {
 		[[nodiscard]] static std::string get_status_displayable_name(SmartStatus status);
 
 
+		/// Get the unchanged-output statistics of all the drives since program start. Thread-safe.
+		[[nodiscard]] static StorageDeviceParseSkipStats get_parse_skip_stats();
+
+
 		/// Statuses of various parse states
 		enum class ParseStatus {
 			Full,  ///< Parsed with specialized parser
@@ -78,6 +151,28 @@ class StorageDevice {
 		};
 
 
+		/// An immutable view of the drive state, published by the drive each time
+		/// it has new information (see get_snapshot()).
+		struct Snapshot {
+			CommandOutputPtr basic_output = std::make_shared<const std::string>();  ///< "smartctl --info" output, never nullptr
+			CommandOutputPtr full_output = std::make_shared<const std::string>();  ///< "smartctl --all" or "-x" output, never nullptr
+			StoragePropertyRepository property_repository;  ///< Parsed data properties
+			StorageDeviceDetectedType detected_type = StorageDeviceDetectedType::Unknown;  ///< Detected type
+			ParseStatus parse_status = ParseStatus::None;  ///< "Fully parsed" flag
+			SmartStatus smart_status = SmartStatus::Unsupported;  ///< See get_smart_status()
+			std::string model_name;  ///< Model name, empty if not known
+			std::string family_name;  ///< Family name, empty if not known
+			std::string serial_number;  ///< Serial number, empty if not known
+			std::string size;  ///< Formatted size, empty if not known
+			StorageProperty health_property;  ///< Overall health property, empty if not known
+			bool test_is_active = false;  ///< "Test is active" flag
+			bool in_standby = false;  ///< See get_in_standby()
+		};
+
+		/// A reference-counting pointer to an immutable snapshot
+		using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+
 		/// Constructor
 		explicit StorageDevice(std::string dev_or_vfile, bool is_virtual = false);
 
@@ -98,14 +193,68 @@ class StorageDevice {
 		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> fetch_basic_data_and_parse(
 				const std::shared_ptr<CommandExecutor>& smartctl_ex = nullptr);
 
+		/// Calls "smartctl -i" (info section only, compact JSON), then parse_basic_data().
+		/// This is the first stage of the drive detection: the identity (model, serial number,
+		/// protocol, SMART support) is enough to show the drive, and it's much faster to get than
+		/// the basic data. get_basic_data_identity_only() returns true until the health and
+		/// capabilities are fetched with fetch_basic_data_and_parse() (or the full data is).
+		/// Note: this will clear all previous properties!
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> fetch_identity_and_parse(
+				const std::shared_ptr<CommandExecutor>& smartctl_ex = nullptr);
+
+		/// Check whether the basic data has the identity only, see fetch_identity_and_parse()
+		[[nodiscard]] bool get_basic_data_identity_only() const;
+
 		/// Detects type, smart support, smart status (on / off).
 		/// Note: this will clear all previous properties!
 		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> parse_basic_data();
 
+		/// Same as parse_basic_data(), but takes the processed properties from a snapshot
+		/// written by storage_property_snapshot_save() instead of parsing the basic output.
+		/// The detected type is not part of the snapshot and is kept as is.
+		/// Note: this will clear all previous properties!
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> load_basic_data_snapshot(std::string_view snapshot);
+
 
-		/// Execute smartctl --all / -x (all sections), get output, parse it (basic data too), fill properties.
+		/// Execute smartctl -x (or the sections of the fetch profile), get output, parse it (basic data too), fill properties.
 		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> fetch_full_data_and_parse(const std::shared_ptr<CommandExecutor>& smartctl_ex);
 
+		/// Used instead of fetch_basic_data_and_parse() during drive detection when the full data is
+		/// needed anyway: calls "smartctl -x" once, detects the type and parses the full data from
+		/// the same output, which also becomes the basic output. If the drive type is already known,
+		/// this is fetch_full_data_and_parse(). If "-x" fails (e.g. the drive needs an explicit type),
+		/// falls back to fetch_basic_data_and_parse() followed by fetch_full_data_and_parse().
+		/// Note: this will clear all previous properties!
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> fetch_all_data_and_parse(const std::shared_ptr<CommandExecutor>& smartctl_ex);
+
+		/// Run fetch_full_data_and_parse() in a worker thread and return immediately.
+		/// \c smartctl_ex must be a non-GUI executor (see command_executor_factory_for_worker_threads()).
+		/// When the fetch is finished, signal_changed() is emitted and \c finished_slot is called
+		/// in the thread-default main context of the calling thread. The device is kept alive
+		/// until then. If \c finished_slot is bound to a destroyed sigc::trackable, it's not called.
+		/// The device data must not be accessed while get_fetch_in_progress() returns true.
+		void fetch_full_data_and_parse_async(std::shared_ptr<CommandExecutor> smartctl_ex,
+				const fetch_finished_slot_t& finished_slot);
+
+		/// Check whether an asynchronous fetch (or a worker fetch, see begin_worker_fetch()) is in progress
+		[[nodiscard]] bool get_fetch_in_progress() const;
+
+		/// Mark the start of a fetch which the caller runs in a worker thread (e.g. a parallel basic
+		/// data fetch of StorageDetector). Until end_worker_fetch(), get_fetch_in_progress() returns true
+		/// and signal_changed() is not emitted, so the listeners are not called from the worker thread.
+		/// Must be called from the main thread.
+		void begin_worker_fetch();
+
+		/// Undo begin_worker_fetch() and emit signal_changed(). Must be called from the main thread.
+		void end_worker_fetch();
+
+		/// Refresh the health status, attributes and temperature using ioctls instead of smartctl
+		/// (see storage_ioctl_poll.h), keeping the other properties of the previous full fetch.
+		/// It's much cheaper than fetch_full_data_and_parse(), which should be used instead
+		/// if this returns IoctlPollUnavailable. A previous full fetch is required.
+		/// In standby-aware mode, ATA drives are not polled (the SMART commands would wake them up).
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> poll_ioctl_data_and_parse();
+
 		/// Parse full info. If failed, try to parse it as basic info.
 //		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> try_parse_data();
 
@@ -115,6 +264,19 @@ class StorageDevice {
 		/// Try to detect the data type and parse it. This is used when loading virtual drives.
 		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> parse_any_data_for_virtual();
 
+		/// Load the outputs which another process fetched from this drive (e.g. the cache of
+		/// the privileged helper, see storage_privileged_helper_load_drives()) and parse them.
+		/// The format and the drive type are detected from the output. If the full output is
+		/// parsed, get_full_data_time() is set to \c full_output_age ago.
+		/// Note: this will clear all previous properties!
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> load_cached_outputs(std::string basic_output,
+				std::string full_output, std::optional<std::chrono::seconds> full_output_age);
+
+		/// Parse the outputs of the last fetch again, without running smartctl, so that the
+		/// property descriptions and warnings are recomputed (e.g. after the warning rules or
+		/// the drive database change). The full output is used if it was parsed, the basic one otherwise.
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> reparse_outputs();
+
 		/// Get the "fully parsed" flag
 		[[nodiscard]] ParseStatus get_parse_status() const;
 
@@ -130,27 +292,29 @@ class StorageDevice {
 		void detect_drive_type_from_properties(const StoragePropertyRepository& property_repo);
 
 
-		/// Get SMART status
+		/// Get SMART status. Memoized, see DerivedFacts.
 		[[nodiscard]] SmartStatus get_smart_status() const;
 
-		/// Get if SMART on/off is supported
+		/// Get if SMART on/off is supported. Memoized, see DerivedFacts.
 		[[nodiscard]] bool get_smart_switch_supported() const;
 
 
 		/// Get format size string, or an empty string on error.
-		[[nodiscard]] std::string get_device_size_str() const;
+		[[nodiscard]] const std::string& get_device_size_str() const;
 
 		/// Get the overall health property
-		[[nodiscard]] StorageProperty get_health_property() const;
+		[[nodiscard]] const StorageProperty& get_health_property() const;
 
 
 		/// Get device name (e.g. /dev/sda)
-		[[nodiscard]] std::string get_device() const;
+		[[nodiscard]] const std::string& get_device() const;
 
 		/// Get device name without path. For example, "sda".
-		[[nodiscard]] std::string get_device_base() const;
+		/// The view is valid for as long as the device object.
+		[[nodiscard]] std::string_view get_device_base() const;
 
-		/// Get device name for display purposes (with a type argument in parentheses)
+		/// Get device name for display purposes (with a type argument in parentheses,
+		/// prefixed by the remote host, if any)
 		[[nodiscard]] std::string get_device_with_type() const;
 
 
@@ -164,15 +328,27 @@ class StorageDevice {
 		/// Set argument for "-d" smartctl parameter
 		void set_type_argument(std::string arg);
 
-		/// Get argument for "-d" smartctl parameter
-		[[nodiscard]] std::string get_type_argument() const;
+		/// Get argument for "-d" smartctl parameter.
+		/// The reference is valid until the argument is changed.
+		[[nodiscard]] const std::string& get_type_argument() const;
 
 
 		/// Set extra arguments smartctl
 		void set_extra_arguments(std::vector<std::string> args);
 
-		/// Get extra arguments smartctl
-		[[nodiscard]] std::vector<std::string> get_extra_arguments() const;
+		/// Get extra arguments smartctl.
+		/// The reference is valid until the arguments are changed.
+		[[nodiscard]] const std::vector<std::string>& get_extra_arguments() const;
+
+
+		/// Set the remote host the drive is on (see RemoteHost). nullptr (default) means a local drive.
+		void set_remote_host(RemoteHostPtr host);
+
+		/// Get the remote host the drive is on. nullptr if it's a local drive.
+		[[nodiscard]] RemoteHostPtr get_remote_host() const;
+
+		/// Get the SSH destination of the remote host the drive is on. Empty if it's a local drive.
+		[[nodiscard]] std::string get_remote_host_name() const;
 
 
 		/// Set windows drive letters for this drive
@@ -195,35 +371,98 @@ class StorageDevice {
 		[[nodiscard]] std::string get_virtual_filename() const;
 
 
+		/// Sort key: hard drives first (local ones first, then by remote host), then device name
+		/// base and type argument. Virtual drives are ordered by their file.
+		struct SortKey {
+			bool is_virtual = false;  ///< get_is_virtual()
+			std::string remote_host;  ///< get_remote_host_name()
+			hz::fs::path virtual_file;  ///< get_virtual_file(), virtual drives only
+			std::string device_base;  ///< get_device_base(), real drives only
+			std::string type_arg;  ///< get_type_argument(), real drives only
+
+			/// Comparison operator
+			bool operator< (const SortKey& other) const;
+		};
+
+		/// Get the sort key, kept up to date when the identity of the drive changes.
+		/// The reference is valid for as long as the device object.
+		[[nodiscard]] const SortKey& get_sort_key() const;
+
+
 		/// Get properties
 		[[nodiscard]] const StoragePropertyRepository& get_property_repository() const;
 
 
-		/// Get model name.
+		/// Get the last published snapshot of the drive state. It's published whenever
+		/// signal_changed() is due, including by an asynchronous fetch in its worker thread
+		/// (so the data of a fetch in progress is the previous snapshot).
+		/// This is thread-safe and lock-free, and the snapshot stays valid and unchanged for
+		/// as long as it's held. Prefer it over the individual getters when reading
+		/// several values which must be consistent, or from other threads.
+		[[nodiscard]] SnapshotPtr get_snapshot() const;
+
+
+		/// Get model name. The reference is valid until the drive data is changed.
 		/// \return empty string if not found
-		[[nodiscard]] std::string get_model_name() const;
+		[[nodiscard]] const std::string& get_model_name() const;
 
 		/// Get family name.
 		/// \return empty string if not found
 		[[nodiscard]] std::string get_family_name() const;
 
-		/// Get serial number.
+		/// Get serial number. The reference is valid until the drive data is changed.
 		/// \return empty string if not found
-		[[nodiscard]] std::string get_serial_number() const;
+		[[nodiscard]] const std::string& get_serial_number() const;
 
 
 		/// Set "info" output to parse
 		void set_info_output(std::string s);
 
-		/// Get "info" output to parse
-		[[nodiscard]] std::string get_basic_output() const;
+		/// Get "info" output to parse. The reference is valid until the output is changed.
+		[[nodiscard]] const std::string& get_basic_output() const;
 
 
 		/// Set "full" output to parse
 		void set_full_output(std::string s);
 
-		/// Get "full" output to parse
-		[[nodiscard]] std::string get_full_output() const;
+		/// Get "full" output to parse. The reference is valid until the output is changed.
+		[[nodiscard]] const std::string& get_full_output() const;
+
+		/// Set both "full" and "info" outputs of a virtual drive to \c s, without copying it twice
+		/// (the info can be parsed from the full output too).
+		void set_virtual_output(std::string s);
+
+
+		/// Get the human-readable smartctl output of the last fetch. JSON outputs don't embed it
+		/// by default (see "system/smartctl_json_embed_text_output"), so it's fetched on the first
+		/// call (the same command in text format) and kept until the outputs change.
+		/// Virtual drives return it only if it's in the data file.
+		[[nodiscard]] hz::ExpectedValue<std::string, StorageDeviceError> get_text_output(
+				const std::shared_ptr<CommandExecutor>& smartctl_ex);
+
+
+		/// Get the approximate memory usage of the drive data. The outputs may be shared with
+		/// their other users (e.g. the execution log), they're counted here nevertheless.
+		[[nodiscard]] StorageDeviceMemoryUsage get_memory_usage() const;
+
+
+		/// Reduce the memory use of a drive nobody has looked at for a while (see StorageMemoryBudget):
+		/// the full output is compressed, the text output is dropped, and only a summary of the
+		/// properties (the ones with warnings) is kept. The identity, health and SMART status
+		/// getters are unaffected, as is the basic output unless it's the full output too.
+		/// The published snapshot has the summary only. The users needing the full data call
+		/// restore_compacted_data() first. A fetch replaces the compacted data as well.
+		/// Only the fully parsed drives without a running fetch or test are compacted.
+		/// \return false if the drive was not compacted.
+		bool compact_data();
+
+		/// Check whether the drive data is compacted (see compact_data())
+		[[nodiscard]] bool get_data_compacted() const;
+
+		/// Undo compact_data() by parsing the decompressed full output again. Does nothing
+		/// if the data is not compacted. On error get_full_data_time() is unset, so that
+		/// the users fetch the drive data again.
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> restore_compacted_data();
 
 
 		/// Set "manually added" flag
@@ -233,6 +472,42 @@ class StorageDevice {
 		[[nodiscard]] bool get_is_manually_added() const;
 
 
+		/// Set whether to keep the text output embedded in JSON output when parsing
+		/// (the "smartctl/output" property, see get_text_output()). Default: true.
+		/// Non-GUI users may disable this to reduce memory use.
+		void set_keep_text_output(bool b);
+
+		/// Get whether to keep the text output embedded in JSON output when parsing
+		[[nodiscard]] bool get_keep_text_output() const;
+
+
+		/// Set what fetch_full_data_and_parse() retrieves and parses. Default: Full.
+		/// Non-GUI pollers may use Monitoring to avoid reading the logs each time.
+		void set_fetch_profile(StorageFetchProfile profile);
+
+		/// Get what fetch_full_data_and_parse() retrieves and parses
+		[[nodiscard]] StorageFetchProfile get_fetch_profile() const;
+
+
+		/// Set whether fetch_full_data_and_parse() leaves the drive alone if it's in standby
+		/// or sleep mode (smartctl --nocheck=standby), so that it's not spun up. The previously
+		/// fetched data is kept in that case (see get_in_standby()). Default: false.
+		/// Periodic pollers may enable this for drives which are spun down when idle.
+		void set_standby_aware(bool b);
+
+		/// Get whether fetch_full_data_and_parse() leaves the drives in standby mode alone
+		[[nodiscard]] bool get_standby_aware() const;
+
+		/// Get whether the last fetch_full_data_and_parse() found the drive in standby or sleep
+		/// mode (standby-aware mode only). The data, if any, is from an earlier fetch then.
+		[[nodiscard]] bool get_in_standby() const;
+
+		/// Get when the full data was last fetched and parsed successfully (fetch_full_data_and_parse()
+		/// or fetch_all_data_and_parse()). std::nullopt if the properties don't come from such a fetch.
+		/// A drive in standby (see get_in_standby()) keeps the time of the fetch its data comes from.
+		[[nodiscard]] std::optional<std::chrono::steady_clock::time_point> get_full_data_time() const;
+
+
 		/// Set "test is active" flag, emit the "changed" signal if needed.
 		void set_test_is_active(bool b);
 
@@ -240,7 +515,7 @@ class StorageDevice {
 		[[nodiscard]] bool get_test_is_active() const;
 
 
-		/// Get whether the tests are supported, based on parsed properties
+		/// Get whether the tests are supported, based on parsed properties. Memoized, see DerivedFacts.
 		[[nodiscard]] SelfTestSupportStatus get_self_test_support_status() const;
 
 
@@ -253,14 +528,36 @@ class StorageDevice {
 
 
 		/// Execute smartctl on this device. Nothing is modified in this class.
+		/// The output is shared with the executor, not copied. \c operation selects the execution policy.
+		/// Local drives run it in the privileged helper if there is one (see storage_privileged_helper_set_global()).
 		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> execute_device_smartctl(const std::vector<std::string>& command_options,
-				const std::shared_ptr<CommandExecutor>& smartctl_ex, std::string& output, bool check_type = false);
+				const std::shared_ptr<CommandExecutor>& smartctl_ex, CommandOutputPtr& output, bool check_type = false,
+				CommandOperation operation = CommandOperation::Other);
+
+		/// Execute smartctl on this device, copying the output. Used for short outputs (test commands, etc.).
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> execute_device_smartctl(const std::vector<std::string>& command_options,
+				const std::shared_ptr<CommandExecutor>& smartctl_ex, std::string& output, bool check_type = false,
+				CommandOperation operation = CommandOperation::Other);
 
 
 		/// Emitted whenever new information is available
 		[[nodiscard]] sigc::signal<void, StorageDevice*>& signal_changed();
 
 
+		/// Emitted after signal_changed(), at most once per main loop iteration (or once per
+		/// "gui/change_notification_interval_msec"), with all the changes since the previous emission.
+		/// The redrawing listeners use this, so that a burst of changes (bulk operations, parallel
+		/// refreshes) redraws them once. The emission is scheduled in the default main context
+		/// if the drive is owned by a StorageDevicePtr, otherwise it's immediate.
+		[[nodiscard]] sigc::signal<void, StorageDevice*, StorageDeviceChange>& signal_changed_coalesced();
+
+
+		/// Emitted before signal_changed() if the properties changed since the previous emission.
+		/// The baseline is only kept while there are listeners, so the first emission after
+		/// connecting reports all the properties as added.
+		[[nodiscard]] sigc::signal<void, StorageDevice*, const StoragePropertyDiff&>& signal_properties_changed();
+
+
 	protected:
 
 		/// Set the "fully parsed" flag
@@ -269,26 +566,76 @@ class StorageDevice {
 		/// Set properties
 		void set_property_repository(StoragePropertyRepository repository);
 
+		/// fetch_basic_data_and_parse() and fetch_identity_and_parse() implementation
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> do_fetch_basic_data_and_parse(
+				const std::shared_ptr<CommandExecutor>& smartctl_ex, bool identity_only);
+
+		/// fetch_full_data_and_parse() implementation, without the fetch_in_progress_ check
+		[[nodiscard]] hz::ExpectedVoid<StorageDeviceError> do_fetch_full_data_and_parse(const std::shared_ptr<CommandExecutor>& smartctl_ex);
+
+		/// Get the key of the NVMe controller data cache (see storage_nvme_controller.h) for this device.
+		/// Empty if the device is not a local or remote NVMe device file.
+		[[nodiscard]] std::string get_nvme_controller_key() const;
+
+		/// Append the full data values to the global history store (if any), and raise
+		/// the warnings of the properties whose trends signal a coming failure.
+		/// \return true if any warning was raised.
+		bool append_to_history();
+
+		/// Replace the snapshot returned by get_snapshot() with the current state
+		void publish_snapshot();
+
+		/// Publish the snapshot and emit signal_changed(), unless it's called from an
+		/// asynchronous fetch. In that case, the signal is emitted in the main context after the fetch.
+		/// \c changes are accumulated for signal_changed_coalesced(), which is scheduled here.
+		void emit_signal_changed(StorageDeviceChange changes);
+
+		/// Emit signal_changed_coalesced() with the accumulated changes
+		void emit_signal_changed_coalesced();
+
 
 	private:
 
+		/// Rebuild sort_key_ after the device, type argument or remote host change
+		void update_sort_key();
+
+		/// Forget the memoized derived facts. Called whenever the properties, or anything else
+		/// the facts are derived from, change.
+		void invalidate_derived_facts();
+
+
 		std::string device_;  ///< e.g. /dev/sda or pd0. empty if virtual.
 		std::string type_arg_;  ///< Device type (for -d smartctl parameter), as specified when adding the device.
 		std::vector<std::string> extra_args_;  ///< Extra parameters for smartctl, as specified when adding the device.
+		RemoteHostPtr remote_host_;  ///< Remote host the drive is on. nullptr if local.
+		SortKey sort_key_;  ///< Sort key, see update_sort_key()
 
 		std::map<char, std::string> drive_letters_;  ///< Windows drive letters (if detected), with volume names
 
 		bool is_virtual_ = false;  ///< If true, then this is not a real device - merely a loaded description of it.
 		hz::fs::path virtual_file_;  ///< A file (smartctl data) the virtual device was loaded from
 		bool is_manually_added_ = false;  ///< StorageDevice doesn't use it, but it's useful for its users.
+		bool keep_text_output_ = true;  ///< Whether the parsers keep the embedded text output of JSON data
+		bool basic_data_identity_only_ = false;  ///< Whether basic_output_ has the identity only, see fetch_identity_and_parse()
+		StorageFetchProfile fetch_profile_ = StorageFetchProfile::Full;  ///< What the full fetch retrieves
+		bool standby_aware_ = false;  ///< Whether the full fetch leaves the drives in standby mode alone
+		bool in_standby_ = false;  ///< Whether the drive was in standby mode during the last full fetch
 
 		/// Sort of a "lock". If true, the device is not allowed to perform any commands
 		/// except "-l selftest" and maybe "--capabilities" and "--info" (not sure).
 		bool test_is_active_ = false;
 
-		// Outputs
-		std::string basic_output_;  ///< "smartctl --info" output
-		std::string full_output_;  ///< "smartctl --all" or "-x" output
+		/// Set while fetch_full_data_and_parse_async() is running. Written by the calling thread only.
+		bool fetch_in_progress_ = false;
+
+		/// Set between begin_worker_fetch() and end_worker_fetch(). Written by the main thread only.
+		bool worker_fetch_in_progress_ = false;
+
+		// Outputs. These are shared with the executor that produced them (and with each other
+		// if the full output is used as basic output too), never nullptr.
+		CommandOutputPtr basic_output_ = std::make_shared<const std::string>();  ///< "smartctl --info" output
+		CommandOutputPtr full_output_ = std::make_shared<const std::string>();  ///< "smartctl --all" or "-x" output
+		std::string text_output_;  ///< Text output fetched by get_text_output() for a JSON full (or basic) output
 
 		StorageDeviceDetectedType detected_type_ = StorageDeviceDetectedType::Unknown;  ///< Detected by basic parser
 
@@ -296,6 +643,34 @@ class StorageDevice {
 
 		StoragePropertyRepository property_repository_;  ///< Parsed data properties
 
+		/// Content hash (see SmartctlParser::get_output_content_hash()) of the full output
+		/// property_repository_ was parsed from, combined with the parse settings.
+		/// Unset if the properties come from anywhere else.
+		std::optional<std::uint64_t> full_output_hash_;
+
+		/// See get_full_data_time(). Set by the (possibly asynchronous) fetch, cleared with the properties.
+		std::optional<std::chrono::steady_clock::time_point> full_data_time_;
+
+		/// Compressed full output of compact_data() (or the output itself if it can't be
+		/// compressed), nullptr if the data is not compacted. Cleared with the properties.
+		std::shared_ptr<const std::string> compacted_full_output_;
+		std::size_t compacted_full_output_size_ = 0;  ///< Uncompressed size of compacted_full_output_
+		bool compacted_shared_output_ = false;  ///< The compacted full output was the basic output too
+
+		/// Controller-scoped properties fetched through another device of the same NVMe controller,
+		/// merged into the properties parsed from full_output_ (which has the namespace information only then).
+		/// nullptr if the full output has everything.
+		std::shared_ptr<const std::vector<StorageProperty>> nvme_controller_properties_;
+
+		/// Subsection parse results of the last full text output, see SmartctlTextAtaParser::set_subsection_cache()
+		std::shared_ptr<SmartctlTextAtaSubsectionCache> text_subsection_cache_;
+
+		/// Error log entries ingested from the previous full outputs, see SmartctlParser::set_error_log_journal()
+		std::shared_ptr<StorageErrorLogJournal> error_log_journal_;
+
+		/// Metrics derived from the lifetime counters of the previous full outputs
+		StorageLifetimeMetrics lifetime_metrics_;
+
 		// Common properties
 		std::optional<bool> smart_supported_;  ///< SMART support status
 		std::optional<bool> smart_enabled_;  ///< SMART enabled status
@@ -303,34 +678,59 @@ class StorageDevice {
 		std::optional<std::string> family_name_;  ///< Family name
 		std::optional<std::string> serial_number_;  ///< Serial number
 		std::optional<std::string> size_;  ///< Formatted size
-		mutable std::optional<StorageProperty> health_property_;  ///< Cached health property.
+		StorageProperty health_property_;  ///< Health property, looked up when the properties are set
+
+
+		/// Facts derived from the properties and the state of the drive. The icon view and the
+		/// menu state updates ask for them repeatedly, so they're computed on first use and
+		/// kept until invalidate_derived_facts().
+		struct DerivedFacts {
+			std::optional<SmartStatus> smart_status;  ///< See get_smart_status()
+			std::optional<bool> smart_switch_supported;  ///< See get_smart_switch_supported()
+			std::optional<SelfTestSupportStatus> self_test_support_status;  ///< See get_self_test_support_status()
+		};
+
+		mutable DerivedFacts derived_facts_;  ///< Memoized derived facts
 
 
 		/// Emitted whenever new information is available
 		sigc::signal<void, StorageDevice*> signal_changed_;
 
+		/// Emitted with the accumulated changes, see signal_changed_coalesced()
+		sigc::signal<void, StorageDevice*, StorageDeviceChange> signal_changed_coalesced_;
+
+		/// Changes not yet delivered through signal_changed_coalesced_. A worker fetch adds to them
+		/// from its thread, hence atomic.
+		std::atomic<std::uint32_t> pending_changes_ = 0;
+
+		/// signal_changed_coalesced_ emission is scheduled
+		bool coalesced_emission_scheduled_ = false;
+
+		/// Emitted when the properties change
+		sigc::signal<void, StorageDevice*, const StoragePropertyDiff&> signal_properties_changed_;
+
+		/// Properties as of the last signal_properties_changed_ emission
+		StoragePropertyRepository notified_property_repository_;
+
+		/// The last published snapshot, never nullptr. Written by the thread modifying
+		/// the drive, read by any thread.
+#if defined(__cpp_lib_atomic_shared_ptr)
+		std::atomic<SnapshotPtr> snapshot_ = std::make_shared<const Snapshot>();
+#else
+		SnapshotPtr snapshot_ = std::make_shared<const Snapshot>();  ///< Accessed with std::atomic_load() / std::atomic_store() only
+#endif
+
 
 };
 
 
 
 
-/// Operator for sorting, hard drives first, then device name base
+/// Operator for sorting, hard drives first (local ones first, then by remote host), then device name base.
+/// See StorageDevice::SortKey.
 inline bool operator< (const StorageDevicePtr& a, const StorageDevicePtr& b)
 {
-// 	if (a->get_detected_type() != a->get_detected_type()) {
-// 		return (a->get_detected_type() == StorageDevice::DetectedType::unknown);  // hard drives first
-// 	}
-	if (a->get_is_virtual() != b->get_is_virtual()) {
-		return int(a->get_is_virtual()) < int(b->get_is_virtual());
-	}
-	if (a->get_is_virtual()) {
-		return a->get_virtual_file() < b->get_virtual_file();
-	}
-	if (a->get_device_base() != b->get_device_base()) {
-		return a->get_device_base() < b->get_device_base();
-	}
-	return a->get_type_argument() < b->get_type_argument();
+	return a->get_sort_key() < b->get_sort_key();
 }
 
 
@@ -0,0 +1,182 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>  // Glib::Base64
+#include <algorithm>  // std::find_if
+#include <map>
+#include <memory>
+
+#include "nlohmann/json.hpp"
+
+#include "hz/debug.h"
+
+#include "command_executor_remote.h"
+#include "storage_device_cache.h"
+#include "storage_device_detected_type.h"
+#include "storage_property_snapshot.h"
+
+
+
+namespace {
+
+	/// Version of the cache file format. Files with a different version are ignored.
+	constexpr int cache_format_version = 1;
+
+	/// Maximum cache file size to load
+	constexpr int cache_max_size = 10*1024*1024;  // 10M
+
+}
+
+
+
+hz::fs::path storage_device_cache_get_default_file()
+{
+	return hz::fs_get_user_config_dir() / "gsmartcontrol" / "drive_cache.json";
+}
+
+
+
+std::error_code storage_device_cache_save(const hz::fs::path& file, const std::vector<StorageDevicePtr>& drives)
+{
+	nlohmann::json doc;
+	doc["format_version"] = cache_format_version;
+	nlohmann::json& drives_json = doc["drives"];
+	drives_json = nlohmann::json::array();
+
+	for (const auto& drive : drives) {
+		if (!drive || drive->get_is_virtual() || drive->get_is_manually_added()
+				|| drive->get_basic_output().empty() || drive->get_serial_number().empty()) {
+			continue;
+		}
+		nlohmann::json j;
+		j["device"] = drive->get_device();
+		j["type_argument"] = drive->get_type_argument();
+		j["extra_arguments"] = drive->get_extra_arguments();
+		j["remote_host"] = drive->get_remote_host_name();
+		j["serial_number"] = drive->get_serial_number();
+		j["basic_output"] = drive->get_basic_output();
+
+		// Processed basic properties, so that loading doesn't have to parse the output.
+		// Drives with full data have full properties, their basic ones are not available anymore.
+		if (drive->get_parse_status() == StorageDevice::ParseStatus::Basic) {
+			j["detected_type"] = StorageDeviceDetectedTypeExt::get_storable_name(drive->get_detected_type());
+			j["basic_snapshot"] = Glib::Base64::encode(storage_property_snapshot_save(drive->get_property_repository()));
+		}
+
+		nlohmann::json letters = nlohmann::json::object();
+		for (const auto& [letter, volname] : drive->get_drive_letters()) {
+			letters[std::string(1, letter)] = volname;
+		}
+		j["drive_letters"] = std::move(letters);
+
+		drives_json.push_back(std::move(j));
+	}
+
+	std::error_code ec;
+	hz::fs::create_directories(file.parent_path(), ec);  // ignore errors, the write will report them
+	return hz::fs_file_put_contents_atomic(file, doc.dump());
+}
+
+
+
+std::vector<StorageDevicePtr> storage_device_cache_load(const hz::fs::path& file)
+{
+	std::vector<StorageDevicePtr> drives;
+
+	std::error_code ec;
+	if (!hz::fs::exists(file, ec)) {
+		return drives;
+	}
+
+	std::string contents;
+	if (auto read_ec = hz::fs_file_get_contents(file, contents, cache_max_size)) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot read drive cache file \""
+				<< hz::fs_path_to_string(file) << "\": " << read_ec.message() << "\n");
+		return drives;
+	}
+
+	const nlohmann::json doc = nlohmann::json::parse(contents, nullptr, false);
+	if (!doc.is_object() || doc.value("format_version", 0) != cache_format_version
+			|| !doc.contains("drives") || !doc["drives"].is_array()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Drive cache file \"" << hz::fs_path_to_string(file)
+				<< "\" has invalid format, ignoring.\n");
+		return drives;
+	}
+
+	const std::vector<RemoteHostPtr> remote_hosts = remote_hosts_get_configured();
+
+	for (const auto& j : doc["drives"]) {
+		try {
+			auto drive = std::make_shared<StorageDevice>(j.at("device").get<std::string>(), j.value("type_argument", std::string()));
+			drive->set_extra_arguments(j.value("extra_arguments", std::vector<std::string>()));
+
+			// The drives of the hosts which are not configured anymore are dropped
+			if (const auto host_name = j.value("remote_host", std::string()); !host_name.empty()) {
+				auto host_iter = std::find_if(remote_hosts.begin(), remote_hosts.end(),
+						[&host_name](const RemoteHostPtr& host) { return host->get_destination() == host_name; });
+				if (host_iter == remote_hosts.end()) {
+					continue;
+				}
+				drive->set_remote_host(*host_iter);
+			}
+
+			std::map<char, std::string> letters;
+			const nlohmann::json letters_json = j.value("drive_letters", nlohmann::json::object());
+			for (const auto& [letter, volname] : letters_json.items()) {
+				if (!letter.empty()) {
+					letters[letter.front()] = volname.get<std::string>();
+				}
+			}
+			drive->set_drive_letters(std::move(letters));
+
+			drive->set_info_output(j.at("basic_output").get<std::string>());
+
+			// Use the snapshot if it's from the same format version, parse the output otherwise.
+			bool snapshot_loaded = false;
+			if (j.contains("basic_snapshot") && j.contains("detected_type")) {
+				drive->set_detected_type(StorageDeviceDetectedTypeExt::get_by_storable_name(
+						j.at("detected_type").get<std::string>(), StorageDeviceDetectedType::Unknown));
+				auto snapshot_status = drive->load_basic_data_snapshot(Glib::Base64::decode(j.at("basic_snapshot").get<std::string>()));
+				snapshot_loaded = snapshot_status.has_value() && drive->get_parse_status() == StorageDevice::ParseStatus::Basic;
+				if (!snapshot_loaded) {
+					debug_out_dump("app", DBG_FUNC_MSG << "Cannot use cached property snapshot of " << drive->get_device_with_type() << ", parsing.\n");
+				}
+			}
+
+			if (!snapshot_loaded && !drive->parse_basic_data()) {
+				debug_out_info("app", DBG_FUNC_MSG << "Cannot parse cached data of " << drive->get_device_with_type() << ", skipping.\n");
+				continue;
+			}
+			if (drive->get_serial_number() != j.at("serial_number").get<std::string>()) {
+				debug_out_info("app", DBG_FUNC_MSG << "Serial number mismatch in cached data of " << drive->get_device_with_type() << ", skipping.\n");
+				continue;
+			}
+			drives.push_back(drive);
+		}
+		catch (const nlohmann::json::exception& e) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Invalid drive cache entry: " << e.what() << "\n");
+		}
+	}
+
+	return drives;
+}
+
+
+
+std::string storage_device_cache_get_key(const StorageDevice& drive)
+{
+	return drive.get_remote_host_name() + "\n" + drive.get_device() + "\n" + drive.get_type_argument() + "\n" + drive.get_serial_number();
+}
+
+
+
+
+/// @}
@@ -0,0 +1,50 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DEVICE_CACHE_H
+#define STORAGE_DEVICE_CACHE_H
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "hz/fs.h"
+
+#include "storage_device.h"
+
+
+
+/// Get the default drive snapshot cache file ("$HOME/.config/gsmartcontrol/drive_cache.json" in UNIX).
+[[nodiscard]] hz::fs::path storage_device_cache_get_default_file();
+
+
+/// Save the basic ("smartctl -i -H -c") outputs of detected drives to a cache file,
+/// so that the next program start can display them before the detection finishes.
+/// Virtual and manually added drives, as well as drives without a serial number, are skipped.
+[[nodiscard]] std::error_code storage_device_cache_save(const hz::fs::path& file, const std::vector<StorageDevicePtr>& drives);
+
+
+/// Load the drives from a cache file written by storage_device_cache_save() and parse
+/// their basic data. Entries which can't be parsed, or whose serial number doesn't
+/// match the output anymore, are skipped. A missing or broken file results in no drives.
+[[nodiscard]] std::vector<StorageDevicePtr> storage_device_cache_load(const hz::fs::path& file);
+
+
+/// Get the cache key of a drive: remote host, device, type argument and serial number.
+/// A drive is considered unchanged between runs if the key is the same.
+[[nodiscard]] std::string storage_device_cache_get_key(const StorageDevice& drive);
+
+
+
+
+#endif
+
+/// @}
@@ -11,8 +11,9 @@ Copyright:
 #ifndef STORAGE_DEVICE_DETECTED_TYPE_H
 #define STORAGE_DEVICE_DETECTED_TYPE_H
 
-#include <glibmm.h>
 #include <glibmm/i18n.h>
+#include <array>
+#include <string>
 #include <unordered_map>
 
 #include "hz/enum_helper.h"
@@ -36,27 +37,23 @@ enum class StorageDeviceDetectedType {
 
 /// Helper structure for enum-related functions
 struct StorageDeviceDetectedTypeExt
-		: public hz::EnumHelper<
+		: public hz::EnumTableHelper<
 				StorageDeviceDetectedType,
-				StorageDeviceDetectedTypeExt,
-				Glib::ustring>
+				StorageDeviceDetectedTypeExt>
 {
 	static constexpr StorageDeviceDetectedType default_value = StorageDeviceDetectedType::Unknown;
 
-	static std::unordered_map<EnumType, std::pair<std::string, Glib::ustring>> build_enum_map()
-	{
-		return {
-			{StorageDeviceDetectedType::Unknown, {"unknown", _("Unknown")}},
-			{StorageDeviceDetectedType::NeedsExplicitType, {"needs_explicit_type", _("Needs Explicit Type")}},
-			{StorageDeviceDetectedType::AtaAny, {"ata_any", _("ATA Device (HDD or SSD)")}},
-			{StorageDeviceDetectedType::AtaHdd, {"ata_hdd", _("ATA HDD")}},
-			{StorageDeviceDetectedType::AtaSsd, {"ata_ssd", _("ATA SSD")}},
-			{StorageDeviceDetectedType::Nvme, {"nvme", _("NVMe Device")}},
-			{StorageDeviceDetectedType::BasicScsi, {"basic_scsi", _("Basic SCSI Device")}},
-			{StorageDeviceDetectedType::CdDvd, {"cd_dvd", _("CD/DVD/Blu-Ray")}},
-			{StorageDeviceDetectedType::UnsupportedRaid, {"unsupported_raid", _("Unsupported RAID Controller or Volume")}},
-		};
-	}
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{StorageDeviceDetectedType::Unknown, "unknown", N_("Unknown")},
+		{StorageDeviceDetectedType::NeedsExplicitType, "needs_explicit_type", N_("Needs Explicit Type")},
+		{StorageDeviceDetectedType::AtaAny, "ata_any", N_("ATA Device (HDD or SSD)")},
+		{StorageDeviceDetectedType::AtaHdd, "ata_hdd", N_("ATA HDD")},
+		{StorageDeviceDetectedType::AtaSsd, "ata_ssd", N_("ATA SSD")},
+		{StorageDeviceDetectedType::Nvme, "nvme", N_("NVMe Device")},
+		{StorageDeviceDetectedType::BasicScsi, "basic_scsi", N_("Basic SCSI Device")},
+		{StorageDeviceDetectedType::CdDvd, "cd_dvd", N_("CD/DVD/Blu-Ray")},
+		{StorageDeviceDetectedType::UnsupportedRaid, "unsupported_raid", N_("Unsupported RAID Controller or Volume")},
+	});
 
 };
 
@@ -0,0 +1,166 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+
+#include "hz/string_algo.h"
+
+#include "storage_device_index.h"
+
+
+
+StorageDeviceFilter StorageDeviceFilter::create(std::string_view text, WarningLevel min_warning)
+{
+	StorageDeviceFilter filter;
+	for (const auto word : hz::string_split_view_by_chars(text, " \t\r\n", true)) {
+		filter.words.push_back(hz::string_to_lower_copy(word));
+	}
+	filter.min_warning = min_warning;
+	return filter;
+}
+
+
+
+bool StorageDeviceFilter::is_empty() const
+{
+	return words.empty() && min_warning == WarningLevel::None;
+}
+
+
+
+std::string storage_device_index_get_controller(const std::string& remote_host,
+		const std::string& device_base, const std::string& type_argument)
+{
+	// Types with ports look like "megaraid,5", "areca,3/1", "3ware,2", "cciss,1".
+	const auto comma_pos = type_argument.find(',');
+	if (comma_pos == std::string::npos) {
+		return {};
+	}
+	return (remote_host.empty() ? std::string() : (remote_host + ":")) + device_base + " " + type_argument.substr(0, comma_pos);
+}
+
+
+
+StorageDeviceIndexRecord storage_device_index_make_record(const StorageDevice& drive)
+{
+	const StorageDevice::SnapshotPtr snapshot = drive.get_snapshot();
+
+	StorageDeviceIndexRecord record;
+	record.host = drive.get_remote_host_name();
+	record.search_text = hz::string_to_lower_copy(snapshot->model_name + "\n" + snapshot->serial_number + "\n"
+			+ drive.get_device_with_type() + "\n" + record.host + "\n" + drive.get_virtual_filename());
+
+	for (const auto& p : snapshot->property_repository.get_properties()) {
+		record.warning = std::max(record.warning, p.warning_level);
+	}
+	record.warning = std::max(record.warning, snapshot->health_property.warning_level);
+
+	if (!drive.get_is_virtual()) {
+		record.controller = storage_device_index_get_controller(record.host, std::string(drive.get_device_base()), drive.get_type_argument());
+	}
+	return record;
+}
+
+
+
+bool storage_device_index_record_matches(const StorageDeviceIndexRecord& record, const StorageDeviceFilter& filter)
+{
+	if (record.warning < filter.min_warning) {
+		return false;
+	}
+	return std::all_of(filter.words.begin(), filter.words.end(), [&record](const std::string& word) {
+		return record.search_text.find(word) != std::string::npos;
+	});
+}
+
+
+
+bool StorageDeviceIndex::update(const StorageDevice& drive)
+{
+	return update(&drive, storage_device_index_make_record(drive));
+}
+
+
+
+bool StorageDeviceIndex::update(const StorageDevice* drive, StorageDeviceIndexRecord record)
+{
+	auto [iter, inserted] = records_.try_emplace(drive);
+	if (!inserted && iter->second == record) {
+		return false;
+	}
+	iter->second = std::move(record);
+	return true;
+}
+
+
+
+void StorageDeviceIndex::remove(const StorageDevice* drive)
+{
+	records_.erase(drive);
+}
+
+
+
+void StorageDeviceIndex::clear()
+{
+	records_.clear();
+}
+
+
+
+const StorageDeviceIndexRecord* StorageDeviceIndex::find(const StorageDevice* drive) const
+{
+	if (auto iter = records_.find(drive); iter != records_.end()) {
+		return &iter->second;
+	}
+	return nullptr;
+}
+
+
+
+bool StorageDeviceIndex::matches(const StorageDevice* drive, const StorageDeviceFilter& filter) const
+{
+	const auto* record = find(drive);
+	return record && storage_device_index_record_matches(*record, filter);
+}
+
+
+
+std::string StorageDeviceIndex::get_group(const StorageDevice* drive, StorageDeviceGrouping grouping) const
+{
+	const auto* record = find(drive);
+	if (!record) {
+		return {};
+	}
+	switch (grouping) {
+		case StorageDeviceGrouping::None:
+			break;
+		case StorageDeviceGrouping::Controller:
+			return record->controller;
+		case StorageDeviceGrouping::Host:
+			return record->host;
+	}
+	return {};
+}
+
+
+
+std::size_t StorageDeviceIndex::size() const
+{
+	return records_.size();
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,125 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DEVICE_INDEX_H
+#define STORAGE_DEVICE_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "storage_device.h"
+#include "warning_level.h"
+
+
+
+/// How the drive list is grouped
+enum class StorageDeviceGrouping {
+	None,  ///< No groups
+	Controller,  ///< By RAID controller (see storage_device_index_get_controller())
+	Host,  ///< By remote host
+};
+
+
+
+/// A drive list filter
+struct StorageDeviceFilter {
+	/// Create a filter from a search text (space-separated words, each of which must
+	/// be found in the model, serial number, device or host of a drive, case-insensitively)
+	/// and the minimum warning level of the drive.
+	[[nodiscard]] static StorageDeviceFilter create(std::string_view text, WarningLevel min_warning = WarningLevel::None);
+
+	/// Check whether the filter lets all the drives through
+	[[nodiscard]] bool is_empty() const;
+
+	/// Comparison
+	bool operator==(const StorageDeviceFilter& other) const = default;
+
+	std::vector<std::string> words;  ///< Lowercase search words
+	WarningLevel min_warning = WarningLevel::None;  ///< Minimum warning level of a drive
+};
+
+
+
+/// Searchable data of a drive
+struct StorageDeviceIndexRecord {
+	std::string search_text;  ///< Lowercase model, serial number, device and host, separated by newlines
+	WarningLevel warning = WarningLevel::None;  ///< The highest warning level of the drive properties
+	std::string controller;  ///< Controller group, empty for drives not behind a RAID controller
+	std::string host;  ///< Host group, empty for local drives
+
+	/// Comparison
+	bool operator==(const StorageDeviceIndexRecord& other) const = default;
+};
+
+
+
+/// Get the group name of the RAID controller a drive is behind: remote host (if any),
+/// device and the smartctl type without the port (e.g. "/dev/sda megaraid").
+/// \return an empty string if the drive type has no port (e.g. local SATA / NVMe drives).
+[[nodiscard]] std::string storage_device_index_get_controller(const std::string& remote_host,
+		const std::string& device_base, const std::string& type_argument);
+
+
+/// Create the searchable record of a drive from its current snapshot
+[[nodiscard]] StorageDeviceIndexRecord storage_device_index_make_record(const StorageDevice& drive);
+
+
+/// Check whether a record passes a filter
+[[nodiscard]] bool storage_device_index_record_matches(const StorageDeviceIndexRecord& record, const StorageDeviceFilter& filter);
+
+
+
+/// Searchable records of the displayed drives, updated one drive at a time (when it
+/// changes), so that filtering a large drive list doesn't re-read all the drive data.
+class StorageDeviceIndex {
+	public:
+
+		/// Add or update the record of a drive. \return true if the record changed.
+		bool update(const StorageDevice& drive);
+
+		/// Add or update the record of a drive. \return true if the record changed.
+		bool update(const StorageDevice* drive, StorageDeviceIndexRecord record);
+
+		/// Remove the record of a drive
+		void remove(const StorageDevice* drive);
+
+		/// Remove all records
+		void clear();
+
+		/// Find the record of a drive. \return nullptr if not indexed.
+		[[nodiscard]] const StorageDeviceIndexRecord* find(const StorageDevice* drive) const;
+
+		/// Check whether an indexed drive passes a filter. Drives which are not indexed never do.
+		[[nodiscard]] bool matches(const StorageDevice* drive, const StorageDeviceFilter& filter) const;
+
+		/// Get the group of an indexed drive (empty for the default group, e.g. local drives).
+		[[nodiscard]] std::string get_group(const StorageDevice* drive, StorageDeviceGrouping grouping) const;
+
+		/// Get the number of indexed drives
+		[[nodiscard]] std::size_t size() const;
+
+
+	private:
+
+		std::unordered_map<const StorageDevice*, StorageDeviceIndexRecord> records_;  ///< Records of the drives
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
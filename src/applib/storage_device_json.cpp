@@ -0,0 +1,188 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <variant>
+
+#include "storage_device_json.h"
+#include "storage_device_detected_type.h"
+
+
+
+std::string warning_level_get_storable_name(WarningLevel level)
+{
+	switch (level) {
+		case WarningLevel::None: return "none";
+		case WarningLevel::Notice: return "notice";
+		case WarningLevel::Warning: return "warning";
+		case WarningLevel::Alert: return "alert";
+	}
+	return "none";
+}
+
+
+
+namespace {
+
+	/// Set \c key to an optional value if it's set
+	template<typename T>
+	void json_set_optional(nlohmann::json& j, const char* key, const std::optional<T>& value)
+	{
+		if (value.has_value()) {
+			j[key] = value.value();
+		}
+	}
+
+}
+
+
+
+nlohmann::json storage_property_to_json(const StorageProperty& p)
+{
+	nlohmann::json j;
+	j["section"] = StoragePropertySectionExt::get_storable_name(p.section);
+	j["name"] = p.generic_name;
+	j["value"] = p.format_value();
+
+	if (p.warning_level != WarningLevel::None) {
+		j["warning"] = warning_level_get_storable_name(p.warning_level);
+		j["warning_reason"] = p.warning_reason;
+	}
+
+	// Store the typed data for the types where it makes sense.
+	std::visit([&j](const auto& value)
+	{
+		using T = std::decay_t<decltype(value)>;
+		if constexpr(std::is_same_v<T, std::int64_t> || std::is_same_v<T, bool>) {
+			j["data"] = value;
+
+		} else if constexpr(std::is_same_v<T, std::chrono::seconds>) {
+			j["data"] = value.count();
+
+		} else if constexpr(std::is_same_v<T, AtaStorageAttribute>) {
+			nlohmann::json& d = j["data"];
+			d["id"] = value.id;
+			json_set_optional(d, "value", value.value);
+			json_set_optional(d, "worst", value.worst);
+			json_set_optional(d, "threshold", value.threshold);
+			d["raw"] = value.raw_value_int;
+			d["prefail"] = (value.attr_type == AtaStorageAttribute::AttributeType::Prefail);
+			d["failing_now"] = (value.when_failed == AtaStorageAttribute::FailTime::Now);
+
+		} else if constexpr(std::is_same_v<T, AtaStorageStatistic>) {
+			if (!value.is_header) {
+				nlohmann::json& d = j["data"];
+				d["page"] = value.page;
+				d["offset"] = value.offset;
+				d["value"] = value.value_int;
+			}
+
+		} else if constexpr(std::is_same_v<T, AtaStorageSelftestEntry>) {
+			nlohmann::json& d = j["data"];
+			d["test_num"] = value.test_num;
+			d["lifetime_hours"] = value.lifetime_hours;
+			d["passed"] = value.passed;
+
+		} else if constexpr(std::is_same_v<T, NvmeStorageSelftestEntry>) {
+			nlohmann::json& d = j["data"];
+			d["test_num"] = value.test_num;
+			d["power_on_hours"] = value.power_on_hours;
+			json_set_optional(d, "lba", value.lba);
+
+		} else if constexpr(std::is_same_v<T, AtaStorageTemperatureHistory>) {
+			nlohmann::json& d = j["data"];
+			d["logging_interval_minutes"] = value.logging_interval_minutes;
+			d["newest_time"] = value.newest_time;
+			// Oldest first, null for the unknown temperatures
+			nlohmann::json& samples = d["samples"];
+			samples = nlohmann::json::array();
+			for (std::size_t i = 0; i < value.samples.size(); ++i) {
+				const std::int8_t temperature = value.samples[(value.get_oldest_index() + i) % value.samples.size()];
+				if (temperature == AtaStorageTemperatureHistory::unknown_temperature) {
+					samples.push_back(nullptr);
+				} else {
+					samples.push_back(temperature);
+				}
+			}
+		}
+	}, p.value);
+
+	return j;
+}
+
+
+
+nlohmann::json storage_device_to_json(const StorageDevice& drive)
+{
+	// A consistent view, even if the drive is being refreshed
+	return storage_device_to_json(drive, drive.get_snapshot());
+}
+
+
+
+nlohmann::json storage_device_to_json(const StorageDevice& drive, const StorageDevice::SnapshotPtr& snapshot)
+{
+	nlohmann::json j;
+	j["device"] = drive.get_device();
+	if (!drive.get_type_argument().empty()) {
+		j["type_argument"] = drive.get_type_argument();
+	}
+
+	j["detected_type"] = StorageDeviceDetectedTypeExt::get_storable_name(snapshot->detected_type);
+	j["model"] = snapshot->model_name;
+	j["family"] = snapshot->family_name;
+	j["serial"] = snapshot->serial_number;
+
+	const StorageProperty& health = snapshot->health_property;
+	if (!health.empty()) {
+		j["health"] = health.format_value();
+		j["health_warning"] = warning_level_get_storable_name(health.warning_level);
+	}
+
+	nlohmann::json& properties = j["properties"];
+	properties = nlohmann::json::array();
+	for (const auto& p : snapshot->property_repository.get_properties()) {
+		properties.push_back(storage_property_to_json(p));
+	}
+
+	return j;
+}
+
+
+
+nlohmann::json storage_property_diff_to_json(const StoragePropertyDiff& diff)
+{
+	nlohmann::json j = nlohmann::json::array();
+	for (const auto& change : diff.changes) {
+		nlohmann::json& c = j.emplace_back();
+		switch (change.type) {
+			case StoragePropertyChange::Type::Added: c["change"] = "added"; break;
+			case StoragePropertyChange::Type::Removed: c["change"] = "removed"; break;
+			case StoragePropertyChange::Type::Changed: c["change"] = "changed"; break;
+		}
+		if (change.old_property.has_value()) {
+			c["old"] = storage_property_to_json(change.old_property.value());
+		}
+		if (change.new_property.has_value()) {
+			c["new"] = storage_property_to_json(change.new_property.value());
+		}
+	}
+	return j;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,53 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DEVICE_JSON_H
+#define STORAGE_DEVICE_JSON_H
+
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+#include "storage_property.h"
+#include "warning_level.h"
+#include "storage_device.h"
+#include "storage_property_diff.h"
+
+
+
+/// Get a storable (non-translatable) name of warning level, for machine-readable output.
+[[nodiscard]] std::string warning_level_get_storable_name(WarningLevel level);
+
+
+/// Convert a processed property to compact JSON. Only the machine-relevant
+/// parts are stored (no descriptions or translatable names).
+[[nodiscard]] nlohmann::json storage_property_to_json(const StorageProperty& p);
+
+
+/// Convert a drive (basic information and all its properties) to compact JSON.
+[[nodiscard]] nlohmann::json storage_device_to_json(const StorageDevice& drive);
+
+
+/// Same as above, but with the data of a previously taken snapshot of the drive
+/// instead of the current one. \c snapshot must not be nullptr.
+[[nodiscard]] nlohmann::json storage_device_to_json(const StorageDevice& drive, const StorageDevice::SnapshotPtr& snapshot);
+
+
+/// Convert the property changes to compact JSON, an array of
+/// {"change": "added" / "removed" / "changed", "old": property, "new": property}.
+[[nodiscard]] nlohmann::json storage_property_diff_to_json(const StoragePropertyDiff& diff);
+
+
+
+
+#endif
+
+/// @}
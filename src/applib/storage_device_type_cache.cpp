@@ -0,0 +1,178 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <map>
+#include <mutex>
+
+#include "hz/fs.h"
+#include "hz/string_algo.h"
+#include "rconfig/rconfig.h"
+
+#include "storage_detector_dedup.h"
+#include "storage_device_type_cache.h"
+#include "storage_drive_identity.h"
+
+
+
+namespace {
+
+	/// Don't let the config grow forever with drives which are long gone
+	constexpr std::size_t max_stored_types = 512;
+
+
+	/// Remembered types with their mutex
+	struct DeviceTypeCache {
+		std::mutex mutex;  ///< Protects the members below
+		bool loaded = false;  ///< Whether types were read from config
+		bool changed = false;  ///< Whether types differ from config
+		std::map<std::string, std::string> types;  ///< Key -> type argument
+	};
+
+
+	/// Get the cache
+	DeviceTypeCache& get_device_type_cache()
+	{
+		static DeviceTypeCache cache;
+		return cache;
+	}
+
+
+	/// Read the types from config if not done yet. The mutex must be locked.
+	void device_type_cache_load(DeviceTypeCache& cache)
+	{
+		if (cache.loaded) {
+			return;
+		}
+		cache.loaded = true;
+		const auto stored = rconfig::get_data<rconfig::json>("system/device_type_cache");
+		if (!stored.is_object()) {
+			return;
+		}
+		for (const auto& [key, value] : stored.items()) {
+			if (value.is_string() && !value.get<std::string>().empty()) {
+				cache.types.emplace(key, value.get<std::string>());
+			}
+		}
+	}
+
+}
+
+
+
+std::string storage_device_type_cache_get_key(const std::string& remote_host,
+		const std::string& device, const std::string& identity)
+{
+	std::string key = remote_host.empty() ? device : (remote_host + ":" + device);
+	if (!identity.empty()) {
+		key += "#" + identity;
+	}
+	return key;
+}
+
+
+
+std::string storage_device_type_cache_get_key(const StorageDevice& drive)
+{
+	// A registered drive is known by its ID wherever it's attached
+	if (const std::string system_wwn = storage_drive_identity_get_system_wwn(drive); !system_wwn.empty()) {
+		if (auto id = storage_drive_identity_find({"wwn:" + system_wwn})) {
+			return id.value();
+		}
+	}
+
+	std::string identity = storage_detector_get_device_identity(drive);  // sysfs device directory
+	if (!identity.empty()) {
+		// The WWN follows the drive if it's attached to another port
+		std::string wwid;
+		if (!hz::fs_file_get_contents_unseekable(hz::fs_path_from_string(identity) / "wwid", wwid)) {
+			wwid = hz::string_trim_copy(wwid);
+			if (!wwid.empty()) {
+				identity = wwid;
+			}
+		}
+	}
+	return storage_device_type_cache_get_key(drive.get_remote_host_name(), drive.get_device(), identity);
+}
+
+
+
+std::optional<std::string> storage_device_type_cache_get(const std::string& key)
+{
+	auto& cache = get_device_type_cache();
+	const std::scoped_lock lock(cache.mutex);
+	device_type_cache_load(cache);
+	if (auto iter = cache.types.find(key); iter != cache.types.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+void storage_device_type_cache_remember(const std::string& key, const std::string& type_argument)
+{
+	auto& cache = get_device_type_cache();
+	const std::scoped_lock lock(cache.mutex);
+	device_type_cache_load(cache);
+	auto& type = cache.types[key];
+	if (type != type_argument) {
+		type = type_argument;
+		cache.changed = true;
+	}
+}
+
+
+
+void storage_device_type_cache_forget(const std::string& key)
+{
+	auto& cache = get_device_type_cache();
+	const std::scoped_lock lock(cache.mutex);
+	device_type_cache_load(cache);
+	if (cache.types.erase(key) > 0) {
+		cache.changed = true;
+	}
+}
+
+
+
+void storage_device_type_cache_save()
+{
+	auto& cache = get_device_type_cache();
+	const std::scoped_lock lock(cache.mutex);
+	if (!cache.changed) {
+		return;
+	}
+	cache.changed = false;
+	if (cache.types.size() > max_stored_types) {
+		cache.types.clear();  // forget the old drives, the ones in use will be re-learned
+	}
+	rconfig::json stored = rconfig::json::object();
+	for (const auto& [key, type] : cache.types) {
+		stored[key] = type;
+	}
+	rconfig::set_data("system/device_type_cache", stored);
+}
+
+
+
+void storage_device_type_cache_reset()
+{
+	auto& cache = get_device_type_cache();
+	const std::scoped_lock lock(cache.mutex);
+	cache.loaded = false;
+	cache.changed = false;
+	cache.types.clear();
+}
+
+
+
+
+/// @}
@@ -0,0 +1,71 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DEVICE_TYPE_CACHE_H
+#define STORAGE_DEVICE_TYPE_CACHE_H
+
+#include <optional>
+#include <string>
+
+#include "storage_device.h"
+
+
+
+/*
+Drives which smartctl cannot open without "-d" (e.g. USB bridges) go through a failed smartctl
+run and a retry with an explicit type on each scan. The type which worked is remembered per drive
+(its ID in the drive identity registry, or the device file plus a stable identity of the physical drive
+behind it) in "system/device_type_cache" config key, and it is tried first on the next scans. If it doesn't work anymore, it is forgotten.
+
+The remembered types are kept in memory, so they can be looked up and remembered from
+the worker threads. storage_device_type_cache_save() writes them to config.
+*/
+
+
+
+/// Get the type cache key for a device file on a host (empty for local), with an identity
+/// of the drive behind it (empty if unknown).
+[[nodiscard]] std::string storage_device_type_cache_get_key(const std::string& remote_host,
+		const std::string& device, const std::string& identity);
+
+
+/// Get the type cache key of a drive. If the drive's WWN (on Linux, sysfs "wwid" file) is in the drive
+/// identity registry, this is its drive ID (see storage_drive_identity_update()), so that the type follows
+/// the drive to another port. Otherwise, the identity is the WWN, or the sysfs device directory if it has none.
+[[nodiscard]] std::string storage_device_type_cache_get_key(const StorageDevice& drive);
+
+
+/// Get the type argument which worked for a drive last time. Thread-safe.
+[[nodiscard]] std::optional<std::string> storage_device_type_cache_get(const std::string& key);
+
+
+/// Remember the type argument which worked for a drive. Thread-safe.
+void storage_device_type_cache_remember(const std::string& key, const std::string& type_argument);
+
+
+/// Forget the type argument of a drive (it didn't work). Thread-safe.
+void storage_device_type_cache_forget(const std::string& key);
+
+
+/// Store the remembered types in "system/device_type_cache" config key, if they changed.
+/// Call this from the thread which owns the config.
+void storage_device_type_cache_save();
+
+
+/// Drop the in-memory types, so that they are read from config again when needed. Thread-safe.
+void storage_device_type_cache_reset();
+
+
+
+
+#endif
+
+/// @}
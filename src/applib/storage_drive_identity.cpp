@@ -0,0 +1,357 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <cctype>  // std::isxdigit
+#include <charconv>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+#include "fmt/format.h"
+#include "hz/fs.h"
+#include "hz/string_algo.h"
+#include "rconfig/rconfig.h"
+
+#include "storage_detector_dedup.h"
+#include "storage_drive_identity.h"
+
+
+
+namespace {
+
+	/// Don't let the config grow forever with drives which are long gone
+	constexpr std::size_t max_stored_drives = 1024;
+
+
+	/// The registry with its mutex
+	struct DriveIdentityRegistry {
+		std::mutex mutex;  ///< Protects the members below
+		bool loaded = false;  ///< Whether the registry was read from config
+		bool changed = false;  ///< Whether the registry differs from config
+		std::uint64_t next_id = 1;  ///< Number of the next new drive ID
+		std::map<std::string, std::string, std::less<>> ids;  ///< Identity key -> drive ID
+		std::map<std::string, std::string, std::less<>> ids_by_location;  ///< Location -> drive ID
+		std::map<std::string, std::string, std::less<>> locations;  ///< Drive ID -> location
+	};
+
+
+	/// Get the registry
+	DriveIdentityRegistry& get_drive_identity_registry()
+	{
+		static DriveIdentityRegistry registry;
+		return registry;
+	}
+
+
+	/// Read the registry from config if not done yet. The mutex must be locked.
+	void drive_identity_load(DriveIdentityRegistry& registry)
+	{
+		if (registry.loaded) {
+			return;
+		}
+		registry.loaded = true;
+		const auto stored = rconfig::get_data<rconfig::json>("system/drive_identities");
+		if (!stored.is_object()) {
+			return;
+		}
+		if (auto iter = stored.find("next_id"); iter != stored.end() && iter->is_number_unsigned()) {
+			registry.next_id = std::max<std::uint64_t>(1, iter->get<std::uint64_t>());
+		}
+		auto drives_iter = stored.find("drives");
+		if (drives_iter == stored.end() || !drives_iter->is_object()) {
+			return;
+		}
+		for (const auto& [id, drive] : drives_iter->items()) {
+			if (!drive.is_object()) {
+				continue;
+			}
+			if (auto keys_iter = drive.find("keys"); keys_iter != drive.end() && keys_iter->is_array()) {
+				for (const auto& key : *keys_iter) {
+					if (key.is_string() && !key.get<std::string>().empty()) {
+						registry.ids.emplace(key.get<std::string>(), id);
+					}
+				}
+			}
+			if (auto location_iter = drive.find("location"); location_iter != drive.end() && location_iter->is_string()
+					&& registry.ids_by_location.emplace(location_iter->get<std::string>(), id).second) {
+				registry.locations.emplace(id, location_iter->get<std::string>());
+			}
+		}
+	}
+
+
+	/// Forget the drive at a location. The mutex must be locked.
+	void drive_identity_forget_location(DriveIdentityRegistry& registry, const std::string& location)
+	{
+		if (auto iter = registry.ids_by_location.find(location); iter != registry.ids_by_location.end()) {
+			registry.locations.erase(iter->second);
+			registry.ids_by_location.erase(iter);
+			registry.changed = true;
+		}
+	}
+
+
+	/// Parse a hex number of at most \c max_digits digits
+	std::optional<std::uint64_t> drive_identity_parse_hex(std::string_view str, std::size_t max_digits)
+	{
+		std::uint64_t value = 0;
+		if (str.empty() || str.size() > max_digits) {
+			return std::nullopt;
+		}
+		auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value, 16);
+		if (ec != std::errc() || ptr != str.data() + str.size()) {
+			return std::nullopt;
+		}
+		return value;
+	}
+
+}
+
+
+
+std::string storage_drive_identity_normalize_wwn(std::string_view wwn)
+{
+	std::string str = hz::string_to_lower_copy(hz::string_trim_copy(wwn));
+	for (const std::string_view prefix : {"naa.", "eui.", "0x"}) {
+		if (str.starts_with(prefix)) {
+			str.erase(0, prefix.size());
+			break;
+		}
+	}
+
+	std::vector<std::string_view> parts;
+	hz::string_split_by_chars(str, " -", parts, true);
+
+	if (parts.size() == 3) {
+		// smartctl: 4-bit NAA, 24-bit OUI and 36-bit ID, the ID possibly without its leading zeroes
+		const auto naa = drive_identity_parse_hex(parts[0], 1);
+		const auto oui = drive_identity_parse_hex(parts[1], 6);
+		const auto id = drive_identity_parse_hex(parts[2], 9);
+		if (!naa || !oui || !id) {
+			return {};
+		}
+		return fmt::format("{:016x}", (naa.value() << 60) | (oui.value() << 36) | id.value());
+	}
+
+	// A 64-bit or a 128-bit (NAA 6) identifier
+	if (parts.size() == 1 && (parts[0].size() == 16 || parts[0].size() == 32)
+			&& std::all_of(parts[0].begin(), parts[0].end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); })) {
+		return std::string(parts[0]);
+	}
+	return {};
+}
+
+
+
+std::vector<std::string> storage_drive_identity_get_keys(const std::string& wwn,
+		const std::string& model, const std::string& serial)
+{
+	std::vector<std::string> keys;
+	if (const std::string normalized = storage_drive_identity_normalize_wwn(wwn); !normalized.empty()) {
+		keys.push_back("wwn:" + normalized);
+	}
+	// The serial numbers are unique per vendor only
+	if (!hz::string_trim_copy(serial).empty()) {
+		keys.push_back("sn:" + hz::string_trim_copy(model) + "/" + hz::string_trim_copy(serial));
+	}
+	return keys;
+}
+
+
+
+std::string storage_drive_identity_get_system_wwn(const StorageDevice& drive)
+{
+	const std::string identity = storage_detector_get_device_identity(drive);  // sysfs device directory
+	if (identity.empty()) {
+		return {};
+	}
+	std::string wwid;
+	if (hz::fs_file_get_contents_unseekable(hz::fs_path_from_string(identity) / "wwid", wwid)) {
+		return {};
+	}
+	return storage_drive_identity_normalize_wwn(wwid);
+}
+
+
+
+std::vector<std::string> storage_drive_identity_get_keys(const StorageDevice& drive)
+{
+	if (drive.get_is_virtual()) {
+		return {};
+	}
+	// The WWN property is present after a full fetch only
+	std::string wwn;
+	if (const auto* prop = drive.get_property_repository().find_property("wwn/_merged")) {
+		wwn = prop->readable_value;
+	}
+	std::vector<std::string> keys = storage_drive_identity_get_keys(wwn, drive.get_model_name(), drive.get_serial_number());
+
+	// Register the system WWN too, it's used before the drive is queried (e.g. for its "-d" type)
+	if (const std::string system_wwn = storage_drive_identity_get_system_wwn(drive); !system_wwn.empty()
+			&& std::find(keys.begin(), keys.end(), "wwn:" + system_wwn) == keys.end()) {
+		keys.push_back("wwn:" + system_wwn);
+	}
+	return keys;
+}
+
+
+
+std::string storage_drive_identity_get_location(const StorageDevice& drive)
+{
+	const std::string remote_host = drive.get_remote_host_name();
+	std::string location = remote_host.empty() ? drive.get_device() : (remote_host + ":" + drive.get_device());
+	// The other type arguments may change between the scans, while the drive stays
+	if (const std::string type_argument = drive.get_type_argument(); type_argument.find(',') != std::string::npos) {
+		location += "#" + type_argument;
+	}
+	return location;
+}
+
+
+
+std::string storage_drive_identity_update(const std::string& location, const std::vector<std::string>& keys)
+{
+	auto& registry = get_drive_identity_registry();
+	const std::scoped_lock lock(registry.mutex);
+	drive_identity_load(registry);
+
+	if (keys.empty()) {
+		drive_identity_forget_location(registry, location);
+		return {};
+	}
+
+	std::string id;
+	for (const auto& key : keys) {
+		if (auto iter = registry.ids.find(key); iter != registry.ids.end()) {
+			id = iter->second;
+			break;
+		}
+	}
+	if (id.empty()) {
+		id = "drive-" + std::to_string(registry.next_id++);
+		registry.changed = true;
+	}
+
+	for (const auto& key : keys) {
+		auto [iter, inserted] = registry.ids.try_emplace(key, id);
+		if (inserted || iter->second != id) {
+			iter->second = id;  // the key was registered to another drive, e.g. by the system WWN only
+			registry.changed = true;
+		}
+	}
+
+	// The drive may have moved, and another drive may have taken its place
+	if (auto iter = registry.locations.find(id); iter == registry.locations.end() || iter->second != location) {
+		if (iter != registry.locations.end()) {
+			registry.ids_by_location.erase(iter->second);
+			registry.locations.erase(iter);
+		}
+		drive_identity_forget_location(registry, location);
+		registry.ids_by_location.emplace(location, id);
+		registry.locations.emplace(id, location);
+		registry.changed = true;
+	}
+	return id;
+}
+
+
+
+std::string storage_drive_identity_update(const StorageDevice& drive)
+{
+	if (drive.get_is_virtual()) {
+		return {};
+	}
+	return storage_drive_identity_update(storage_drive_identity_get_location(drive), storage_drive_identity_get_keys(drive));
+}
+
+
+
+std::optional<std::string> storage_drive_identity_find(const std::vector<std::string>& keys)
+{
+	auto& registry = get_drive_identity_registry();
+	const std::scoped_lock lock(registry.mutex);
+	drive_identity_load(registry);
+	for (const auto& key : keys) {
+		if (auto iter = registry.ids.find(key); iter != registry.ids.end()) {
+			return iter->second;
+		}
+	}
+	return std::nullopt;
+}
+
+
+
+std::optional<std::string> storage_drive_identity_find_at(const std::string& location)
+{
+	auto& registry = get_drive_identity_registry();
+	const std::scoped_lock lock(registry.mutex);
+	drive_identity_load(registry);
+	if (auto iter = registry.ids_by_location.find(location); iter != registry.ids_by_location.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+void storage_drive_identity_save()
+{
+	auto& registry = get_drive_identity_registry();
+	const std::scoped_lock lock(registry.mutex);
+	if (!registry.changed) {
+		return;
+	}
+	registry.changed = false;
+
+	std::map<std::string, std::vector<std::string>> keys_by_id;
+	for (const auto& [key, id] : registry.ids) {
+		keys_by_id[id].push_back(key);
+	}
+	if (keys_by_id.size() > max_stored_drives) {
+		// Forget the drives which are not at their last location anymore. The IDs are not
+		// reused, so the cache entries of the forgotten drives are never applied to other ones.
+		std::erase_if(registry.ids, [&registry](const auto& entry) { return !registry.locations.contains(entry.second); });
+		std::erase_if(keys_by_id, [&registry](const auto& entry) { return !registry.locations.contains(entry.first); });
+	}
+
+	rconfig::json drives = rconfig::json::object();
+	for (const auto& [id, keys] : keys_by_id) {
+		rconfig::json& drive = drives[id];
+		drive["keys"] = keys;
+		if (auto iter = registry.locations.find(id); iter != registry.locations.end()) {
+			drive["location"] = iter->second;
+		}
+	}
+	rconfig::json stored = rconfig::json::object();
+	stored["next_id"] = registry.next_id;
+	stored["drives"] = std::move(drives);
+	rconfig::set_data("system/drive_identities", stored);
+}
+
+
+
+void storage_drive_identity_reset()
+{
+	auto& registry = get_drive_identity_registry();
+	const std::scoped_lock lock(registry.mutex);
+	registry.loaded = false;
+	registry.changed = false;
+	registry.next_id = 1;
+	registry.ids.clear();
+	registry.ids_by_location.clear();
+	registry.locations.clear();
+}
+
+
+
+
+/// @}
@@ -0,0 +1,99 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DRIVE_IDENTITY_H
+#define STORAGE_DRIVE_IDENTITY_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "storage_device.h"
+
+
+
+/*
+Device files (and RAID ports) are not stable names of the drives: a drive may be attached
+to another port, controller or host, and the device file may then point to another drive.
+The drive identity registry gives each physical drive a stable ID ("drive-N"), found by any of
+its identity keys (its WWN, or its model and serial number), and remembers the location
+(host and device file) the drive was last seen at. The per-drive caches (e.g. the learned
+"-d" types and the fetch latencies) use the ID, so that they follow the drive.
+
+The registry is updated after each successful fetch of the drive identity during the scans,
+which takes a few map lookups, and it is kept in memory, so that it can be used from
+the worker threads. storage_drive_identity_save() writes it to "system/drive_identities"
+config key. The IDs are never reused.
+*/
+
+
+
+/// Normalize a World Wide Name (or an EUI-64) to lowercase hex digits without separators.
+/// The smartctl forms ("5 000c50 0a1b2c3d4" and "5-000C50-A1B2C3D4", NAA, OUI and ID parts)
+/// and the Linux sysfs forms ("naa.5000c500a1b2c3d4", "eui.0025388b91b2c3d4") are accepted.
+/// \return an empty string if \c wwn is not a WWN (e.g. a sysfs "t10." identifier).
+[[nodiscard]] std::string storage_drive_identity_normalize_wwn(std::string_view wwn);
+
+
+/// Get the identity keys of a drive: "wwn:<normalized WWN>" if the WWN is valid, and
+/// "sn:<model>/<serial>" if the serial number is not empty.
+[[nodiscard]] std::vector<std::string> storage_drive_identity_get_keys(const std::string& wwn,
+		const std::string& model, const std::string& serial);
+
+
+/// Get the WWN of a local drive as known to the OS without running smartctl, normalized.
+/// On Linux, this is the sysfs "wwid" file of the drive. Empty if unknown.
+[[nodiscard]] std::string storage_drive_identity_get_system_wwn(const StorageDevice& drive);
+
+
+/// Get the identity keys of a drive from its system WWN and its parsed properties.
+/// Virtual drives have no keys.
+[[nodiscard]] std::vector<std::string> storage_drive_identity_get_keys(const StorageDevice& drive);
+
+
+/// Get the location of a drive: the remote host (if any), the device file, and the
+/// type argument if it selects a RAID port (e.g. "megaraid,3").
+[[nodiscard]] std::string storage_drive_identity_get_location(const StorageDevice& drive);
+
+
+/// Register a drive seen at \c location, with its identity keys. A known drive gets
+/// any new keys and the new location; a new one gets a new ID. Thread-safe.
+/// \return the drive ID, or an empty string if \c keys is empty (the location is forgotten then).
+std::string storage_drive_identity_update(const std::string& location, const std::vector<std::string>& keys);
+
+
+/// Register a drive with its current location and identity keys, see above. Thread-safe.
+std::string storage_drive_identity_update(const StorageDevice& drive);
+
+
+/// Find the ID of a drive by any of its identity keys. Thread-safe.
+[[nodiscard]] std::optional<std::string> storage_drive_identity_find(const std::vector<std::string>& keys);
+
+
+/// Find the ID of the drive last seen at \c location. Thread-safe.
+[[nodiscard]] std::optional<std::string> storage_drive_identity_find_at(const std::string& location);
+
+
+/// Store the registry in "system/drive_identities" config key, if it changed.
+/// Call this from the thread which owns the config.
+void storage_drive_identity_save();
+
+
+/// Drop the in-memory registry, so that it is read from config again when needed. Thread-safe.
+void storage_drive_identity_reset();
+
+
+
+
+#endif
+
+/// @}
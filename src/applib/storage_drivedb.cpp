@@ -0,0 +1,219 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <cstdint>  // std::uintmax_t
+#include <iterator>
+#include <regex>
+#include <tuple>
+
+#include "hz/debug.h"
+
+#include "storage_drivedb.h"
+
+
+
+namespace {
+
+	/// Maximum size of a drivedb.h file (the real ones are about 300KB)
+	constexpr std::uintmax_t drivedb_max_file_size = 16 * 1024 * 1024;
+
+
+	/// Parse a C string literal at \c pos (pointing to the opening quote), advancing \c pos past it
+	std::string drivedb_parse_string_literal(std::string_view contents, std::size_t& pos)
+	{
+		std::string value;
+		++pos;  // opening quote
+		while (pos < contents.size() && contents[pos] != '"') {
+			if (contents[pos] == '\\' && pos + 1 < contents.size()) {
+				++pos;
+				switch (contents[pos]) {
+					case 'n': value += '\n'; break;
+					case 't': value += '\t'; break;
+					default: value += contents[pos]; break;  // \" \\ and the regex escapes (\\. is written as "\\.")
+				}
+			} else {
+				value += contents[pos];
+			}
+			++pos;
+		}
+		++pos;  // closing quote
+		return value;
+	}
+
+
+	/// Ordering of the entries, for set operations
+	bool drivedb_entry_less(const StorageDriveDbEntry& a, const StorageDriveDbEntry& b)
+	{
+		return std::tie(a.family, a.model_regex, a.firmware_regex, a.warning, a.presets)
+				< std::tie(b.family, b.model_regex, b.firmware_regex, b.warning, b.presets);
+	}
+
+
+	/// Get all the entries of a snapshot, sorted
+	std::vector<StorageDriveDbEntry> drivedb_get_sorted_entries(const StorageDriveDbSnapshot& snapshot)
+	{
+		std::vector<StorageDriveDbEntry> entries;
+		for (const auto& [file, file_entries] : snapshot) {
+			entries.insert(entries.end(), file_entries.begin(), file_entries.end());
+		}
+		std::sort(entries.begin(), entries.end(), &drivedb_entry_less);
+		return entries;
+	}
+
+
+	/// Match a whole string against a drivedb regex. Invalid patterns don't match.
+	bool drivedb_regex_match(const std::string& pattern, const std::string& str)
+	{
+		try {
+			return std::regex_match(str, std::regex(pattern, std::regex::extended));
+		}
+		catch (const std::regex_error& e) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Invalid drive database regex \"" << pattern << "\": " << e.what() << "\n");
+		}
+		return false;
+	}
+
+}
+
+
+
+std::vector<StorageDriveDbEntry> storage_drivedb_parse(std::string_view contents)
+{
+	std::vector<StorageDriveDbEntry> entries;
+
+	// The entries are the innermost brace blocks: { "family", "model" "continued", "firmware", "warning", "presets" },
+	// The array around them is commented out in the smartmontools file (it's included inside the array).
+	bool in_entry = false;  // inside an innermost block
+	std::vector<std::string> fields;
+	bool field_started = false;
+	std::size_t pos = 0;
+	while (pos < contents.size()) {
+		const char c = contents[pos];
+		if (c == '/' && pos + 1 < contents.size() && contents[pos + 1] == '/') {
+			pos = contents.find('\n', pos);
+			pos = (pos == std::string_view::npos ? contents.size() : pos + 1);
+
+		} else if (c == '/' && pos + 1 < contents.size() && contents[pos + 1] == '*') {
+			pos = contents.find("*/", pos + 2);
+			pos = (pos == std::string_view::npos ? contents.size() : pos + 2);
+
+		} else if (c == '"') {
+			std::string value = drivedb_parse_string_literal(contents, pos);
+			if (in_entry) {
+				if (!field_started) {
+					fields.emplace_back();
+					field_started = true;
+				}
+				fields.back() += value;  // adjacent literals are concatenated
+			}
+
+		} else if (c == '\'') {  // skip character literals, they may contain quotes
+			pos = contents.find('\'', pos + (pos + 2 < contents.size() && contents[pos + 1] == '\\' ? 3 : 2));
+			pos = (pos == std::string_view::npos ? contents.size() : pos + 1);
+
+		} else {
+			if (c == '{') {
+				in_entry = true;
+				fields.clear();
+				field_started = false;
+			} else if (c == '}') {
+				if (in_entry && fields.size() >= 2) {
+					fields.resize(5);
+					entries.push_back({std::move(fields[0]), std::move(fields[1]), std::move(fields[2]),
+							std::move(fields[3]), std::move(fields[4])});
+				}
+				in_entry = false;
+			} else if (c == ',' && in_entry) {
+				if (!field_started) {  // a field without literals (e.g. nullptr)
+					fields.emplace_back();
+				}
+				field_started = false;
+			}
+			++pos;
+		}
+	}
+	return entries;
+}
+
+
+
+std::vector<hz::fs::path> storage_drivedb_get_default_files(const hz::fs::path& smartctl_binary)
+{
+	std::vector<hz::fs::path> files;
+	if (smartctl_binary.is_absolute()) {
+		files.push_back(smartctl_binary.parent_path() / "drivedb.h");
+		files.push_back(smartctl_binary.parent_path().parent_path() / "share" / "smartmontools" / "drivedb.h");
+	}
+	for (const char* file : {"/var/lib/smartmontools/drivedb/drivedb.h", "/var/lib/smartmontools/drivedb.h",
+			"/usr/share/smartmontools/drivedb.h", "/usr/local/share/smartmontools/drivedb.h"}) {
+		const hz::fs::path path = hz::fs_path_from_string(file);
+		if (std::find(files.begin(), files.end(), path) == files.end()) {
+			files.push_back(path);
+		}
+	}
+	return files;
+}
+
+
+
+StorageDriveDbSnapshot storage_drivedb_take_snapshot(const std::vector<hz::fs::path>& files)
+{
+	StorageDriveDbSnapshot snapshot;
+	for (const auto& file : files) {
+		std::error_code ec;
+		if (!hz::fs::is_regular_file(file, ec)) {
+			continue;
+		}
+		std::string contents;
+		if (ec = hz::fs_file_get_contents(file, contents, drivedb_max_file_size); ec) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot read " << hz::fs_path_to_string(file) << ": " << ec.message() << "\n");
+			continue;
+		}
+		snapshot[file] = storage_drivedb_parse(contents);
+	}
+	return snapshot;
+}
+
+
+
+std::vector<StorageDriveDbEntry> storage_drivedb_get_changed_entries(
+		const StorageDriveDbSnapshot& before, const StorageDriveDbSnapshot& after)
+{
+	const auto before_entries = drivedb_get_sorted_entries(before);
+	const auto after_entries = drivedb_get_sorted_entries(after);
+
+	std::vector<StorageDriveDbEntry> changed;
+	std::set_symmetric_difference(before_entries.begin(), before_entries.end(),
+			after_entries.begin(), after_entries.end(), std::back_inserter(changed), &drivedb_entry_less);
+	return changed;
+}
+
+
+
+bool storage_drivedb_entry_matches(const StorageDriveDbEntry& entry, const std::string& model, const std::string& firmware)
+{
+	if (entry.family == "DEFAULT") {
+		return true;
+	}
+	if (entry.family.starts_with("VERSION") || entry.family.starts_with("USB:") || entry.model_regex == "-") {
+		return false;
+	}
+	if (model.empty() || !drivedb_regex_match(entry.model_regex, model)) {
+		return false;
+	}
+	return entry.firmware_regex.empty() || drivedb_regex_match(entry.firmware_regex, firmware);
+}
+
+
+
+
+/// @}
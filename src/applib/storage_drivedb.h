@@ -0,0 +1,74 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_DRIVEDB_H
+#define STORAGE_DRIVEDB_H
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hz/fs.h"
+
+
+
+/// An entry of the smartctl drive database (drivedb.h)
+struct StorageDriveDbEntry {
+	std::string family;  ///< Model family, "DEFAULT" for the settings of all the drives
+	std::string model_regex;  ///< Model name regex (POSIX extended). The "USB: ..." family entries have a USB id here.
+	std::string firmware_regex;  ///< Firmware version regex, empty matches any
+	std::string warning;  ///< Warning message
+	std::string presets;  ///< smartctl options (e.g. "-v 9,minutes")
+
+	/// Comparison
+	bool operator==(const StorageDriveDbEntry& other) const = default;
+};
+
+
+
+/// Entries of the drive database files, per file
+using StorageDriveDbSnapshot = std::map<hz::fs::path, std::vector<StorageDriveDbEntry>>;
+
+
+
+/// Parse the contents of a drivedb.h file. The C syntax is not validated,
+/// anything which doesn't look like an entry is skipped.
+[[nodiscard]] std::vector<StorageDriveDbEntry> storage_drivedb_parse(std::string_view contents);
+
+
+/// Get the drivedb.h files update-smart-drivedb may write to: the one next to the smartctl binary
+/// (Windows), and the standard smartmontools locations (UNIX).
+[[nodiscard]] std::vector<hz::fs::path> storage_drivedb_get_default_files(const hz::fs::path& smartctl_binary);
+
+
+/// Read and parse the existing files among \c files. The missing ones are left out.
+[[nodiscard]] StorageDriveDbSnapshot storage_drivedb_take_snapshot(const std::vector<hz::fs::path>& files);
+
+
+/// Get the entries which were added, removed or modified between two snapshots
+/// (both the old and the new versions of a modified entry are returned).
+[[nodiscard]] std::vector<StorageDriveDbEntry> storage_drivedb_get_changed_entries(
+		const StorageDriveDbSnapshot& before, const StorageDriveDbSnapshot& after);
+
+
+/// Check whether a drive with \c model and \c firmware is affected by an entry, the way smartctl
+/// matches them (whole-string regex match). A "DEFAULT" entry affects all the drives,
+/// the USB bridge entries none.
+[[nodiscard]] bool storage_drivedb_entry_matches(const StorageDriveDbEntry& entry,
+		const std::string& model, const std::string& firmware);
+
+
+
+
+#endif
+
+/// @}
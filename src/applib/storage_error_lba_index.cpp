@@ -0,0 +1,186 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+#include "hz/string_algo.h"  // string_split
+#include "hz/string_num.h"
+#include "app_regex.h"
+#include "selftest_selective.h"  // selftest_parse_lba
+#include "storage_property.h"
+#include "storage_error_lba_index.h"
+
+
+
+bool StorageErrorLbaIndex::add(std::uint64_t lba, std::uint8_t sources, std::int64_t time)
+{
+	auto [iter, inserted] = by_lba_.try_emplace(lba, StorageErrorLba{lba, sources, time});
+	if (inserted) {
+		by_time_.emplace(time, lba);
+		return true;
+	}
+
+	StorageErrorLba& entry = iter->second;
+	bool changed = false;
+	if ((entry.sources | sources) != entry.sources) {
+		entry.sources = static_cast<std::uint8_t>(entry.sources | sources);
+		changed = true;
+	}
+	if (time < entry.first_seen) {  // loaded out of order
+		by_time_.erase({entry.first_seen, lba});
+		entry.first_seen = time;
+		by_time_.emplace(time, lba);
+		changed = true;
+	}
+	return changed;
+}
+
+
+
+std::size_t StorageErrorLbaIndex::size() const
+{
+	return by_lba_.size();
+}
+
+
+
+bool StorageErrorLbaIndex::empty() const
+{
+	return by_lba_.empty();
+}
+
+
+
+std::optional<StorageErrorLba> StorageErrorLbaIndex::find(std::uint64_t lba) const
+{
+	if (auto iter = by_lba_.find(lba); iter != by_lba_.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+std::vector<StorageErrorLba> StorageErrorLbaIndex::get_range(std::uint64_t from_lba, std::uint64_t to_lba) const
+{
+	std::vector<StorageErrorLba> result;
+	for (auto iter = by_lba_.lower_bound(from_lba); iter != by_lba_.end() && iter->first <= to_lba; ++iter) {
+		result.push_back(iter->second);
+	}
+	return result;
+}
+
+
+
+std::vector<StorageErrorLba> StorageErrorLbaIndex::get_since(std::int64_t time) const
+{
+	std::vector<StorageErrorLba> result;
+	for (auto iter = by_time_.lower_bound({time, 0}); iter != by_time_.end(); ++iter) {
+		result.push_back(by_lba_.at(iter->second));
+	}
+	return result;
+}
+
+
+
+std::size_t StorageErrorLbaIndex::count_near(std::uint64_t lba, std::uint64_t distance) const
+{
+	const std::uint64_t from = (lba > distance ? lba - distance : 0);
+	const std::uint64_t to = (std::numeric_limits<std::uint64_t>::max() - lba > distance ? lba + distance : std::numeric_limits<std::uint64_t>::max());
+	auto begin = by_lba_.lower_bound(from);
+	auto end = by_lba_.upper_bound(to);
+	return static_cast<std::size_t>(std::distance(begin, end));
+}
+
+
+
+std::vector<StorageErrorLbaCluster> StorageErrorLbaIndex::get_clusters(std::uint64_t max_gap, std::size_t min_count) const
+{
+	std::vector<StorageErrorLbaCluster> clusters;
+	std::optional<StorageErrorLbaCluster> current;
+	for (const auto& [lba, entry] : by_lba_) {
+		if (current.has_value() && lba - current->last_lba <= max_gap) {
+			current->last_lba = lba;
+			++current->count;
+			continue;
+		}
+		if (current.has_value() && current->count >= min_count) {
+			clusters.push_back(current.value());
+		}
+		current = StorageErrorLbaCluster{lba, lba, 1};
+	}
+	if (current.has_value() && current->count >= min_count) {
+		clusters.push_back(current.value());
+	}
+	return clusters;
+}
+
+
+
+std::vector<std::uint64_t> StorageErrorLbaIndex::get_lbas() const
+{
+	std::vector<std::uint64_t> lbas;
+	lbas.reserve(by_lba_.size());
+	for (const auto& [lba, entry] : by_lba_) {
+		lbas.push_back(lba);
+	}
+	return lbas;
+}
+
+
+
+StorageErrorLbaList StorageErrorLbaIndex::get_lbas_from_properties(const StoragePropertyRepository& properties)
+{
+	std::map<std::uint64_t, std::uint8_t> lbas;
+
+	for (const auto& p : properties.get_properties()) {
+		if (p.is_value_type<AtaStorageErrorBlock>()) {
+			// 0 means the LBA is not reported
+			if (const auto lba = p.get_value<AtaStorageErrorBlock>().lba; lba != 0) {
+				lbas[lba] |= StorageErrorLbaSourceAtaErrorLog;
+			}
+
+		} else if (p.is_value_type<AtaStorageSelftestEntry>()) {
+			if (auto lba = selftest_parse_lba(p.get_value<AtaStorageSelftestEntry>().lba_of_first_error); lba.has_value()) {
+				lbas[lba.value()] |= StorageErrorLbaSourceSelfTestLog;
+			}
+
+		} else if (p.is_value_type<NvmeStorageSelftestEntry>()) {
+			if (const auto& lba = p.get_value<NvmeStorageSelftestEntry>().lba; lba.has_value()) {
+				lbas[lba.value()] |= StorageErrorLbaSourceSelfTestLog;
+			}
+
+		} else if (p.generic_name == "nvme_error_information_log/_merged" && p.is_value_type<std::string>()) {
+			// The entries are available only in the formatted log, one per line
+			std::vector<std::string> lines;
+			hz::string_split(p.get_value<std::string>(), '\n', lines, true);
+			for (const auto& line : lines) {
+				std::string lba_str;
+				std::uint64_t lba = 0;
+				if (app_regex_partial_match("/LBA: ([0-9]+)/", line, &lba_str)
+						&& hz::string_is_numeric_nolocale(lba_str, lba, false) && lba != 0) {
+					lbas[lba] |= StorageErrorLbaSourceNvmeErrorLog;
+				}
+			}
+		}
+	}
+
+	return {lbas.begin(), lbas.end()};
+}
+
+
+
+
+
+
+/// @}
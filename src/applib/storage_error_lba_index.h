@@ -0,0 +1,128 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_ERROR_LBA_INDEX_H
+#define STORAGE_ERROR_LBA_INDEX_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "storage_property_repository.h"
+
+
+
+/// Where an error LBA was seen (flags)
+enum StorageErrorLbaSource : std::uint8_t {
+	StorageErrorLbaSourceAtaErrorLog = 1 << 0,  ///< ATA error log
+	StorageErrorLbaSourceNvmeErrorLog = 1 << 1,  ///< NVMe error information log
+	StorageErrorLbaSourceSelfTestLog = 1 << 2,  ///< Self-test log (LBA of first error)
+};
+
+
+/// (LBA, StorageErrorLbaSource flags) pairs
+using StorageErrorLbaList = std::vector<std::pair<std::uint64_t, std::uint8_t>>;
+
+
+
+/// An error LBA of a drive
+struct StorageErrorLba {
+	std::uint64_t lba = 0;  ///< LBA
+	std::uint8_t sources = 0;  ///< StorageErrorLbaSource flags
+	std::int64_t first_seen = 0;  ///< When the LBA was first seen, seconds since epoch
+
+	/// Comparison
+	bool operator==(const StorageErrorLba& other) const = default;
+};
+
+
+
+/// A group of error LBAs close to each other
+struct StorageErrorLbaCluster {
+	std::uint64_t first_lba = 0;  ///< First LBA
+	std::uint64_t last_lba = 0;  ///< Last LBA
+	std::size_t count = 0;  ///< Number of error LBAs
+
+	/// Comparison
+	bool operator==(const StorageErrorLbaCluster& other) const = default;
+};
+
+
+
+/// Error LBAs of a drive, seen in the error and self-test logs over time. Each LBA is
+/// stored once, no matter how many refreshes (and logs) reported it. The LBAs are kept
+/// in balanced trees ordered by LBA and by the time they were first seen, so the range
+/// queries take O(log n + k) time.
+class StorageErrorLbaIndex {
+	public:
+
+		/// Add an LBA seen at \c time.
+		/// \return true if the LBA is new, or was not seen in these sources before.
+		bool add(std::uint64_t lba, std::uint8_t sources, std::int64_t time);
+
+
+		/// Get the number of LBAs
+		[[nodiscard]] std::size_t size() const;
+
+
+		/// Check if there are no LBAs
+		[[nodiscard]] bool empty() const;
+
+
+		/// Find an LBA
+		[[nodiscard]] std::optional<StorageErrorLba> find(std::uint64_t lba) const;
+
+
+		/// Get the LBAs in [from_lba, to_lba], sorted by LBA
+		[[nodiscard]] std::vector<StorageErrorLba> get_range(std::uint64_t from_lba, std::uint64_t to_lba) const;
+
+
+		/// Get the LBAs first seen at or after \c time, sorted by that time
+		[[nodiscard]] std::vector<StorageErrorLba> get_since(std::int64_t time) const;
+
+
+		/// Get the number of LBAs within \c distance sectors of \c lba (including itself)
+		[[nodiscard]] std::size_t count_near(std::uint64_t lba, std::uint64_t distance) const;
+
+
+		/// Group the LBAs which are at most \c max_gap sectors from their neighbours.
+		/// Only the clusters of at least \c min_count LBAs are returned, sorted by LBA.
+		[[nodiscard]] std::vector<StorageErrorLbaCluster> get_clusters(std::uint64_t max_gap, std::size_t min_count = 2) const;
+
+
+		/// Get all the LBAs, sorted
+		[[nodiscard]] std::vector<std::uint64_t> get_lbas() const;
+
+
+		/// Get the error LBAs from parsed properties: ATA error log entries, NVMe error
+		/// information log entries, and the LBAs of first error of ATA and NVMe self-tests.
+		/// The list is sorted by LBA, each LBA is listed once.
+		[[nodiscard]] static StorageErrorLbaList get_lbas_from_properties(const StoragePropertyRepository& properties);
+
+
+	private:
+
+		std::map<std::uint64_t, StorageErrorLba> by_lba_;  ///< LBA -> entry
+		std::set<std::pair<std::int64_t, std::uint64_t>> by_time_;  ///< (first seen, LBA)
+
+};
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,159 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <unordered_map>
+
+#include "storage_error_log_journal.h"
+
+
+
+void StorageErrorLogJournal::begin(const std::vector<StoragePropertySection>& requested_sections, std::size_t max_log_entries)
+{
+	const std::scoped_lock lock(mutex_);
+	if (requested_sections != requested_sections_ || max_log_entries != max_log_entries_) {
+		entries_.clear();
+		newest_numbers_.clear();
+		requested_sections_ = requested_sections;
+		max_log_entries_ = max_log_entries;
+	}
+	next_entries_.clear();
+	next_newest_numbers_.clear();
+	reused_names_.clear();
+	reused_count_ = 0;
+	reset_count_ = 0;
+}
+
+
+
+const StorageProperty* StorageErrorLogJournal::reuse(StoragePropertySection section, std::uint64_t number, std::uint64_t fingerprint)
+{
+	const std::scoped_lock lock(mutex_);
+
+	// The newest entry comes first. If it's older than the newest one of the previous parse,
+	// the counter started over.
+	auto [newest_iter, first_in_log] = next_newest_numbers_.try_emplace(section, number);
+	if (first_in_log) {
+		auto prev_newest_iter = newest_numbers_.find(section);
+		if (prev_newest_iter != newest_numbers_.end() && number < prev_newest_iter->second) {
+			reset_log(section);
+		}
+	} else {
+		newest_iter->second = std::max(newest_iter->second, number);
+	}
+
+	auto iter = entries_.find(EntryKey(section, number));
+	if (iter == entries_.end()) {
+		return nullptr;
+	}
+	// The same number with different contents, the log was reset and filled up again
+	if (iter->second.fingerprint != fingerprint) {
+		reset_log(section);
+		return nullptr;
+	}
+
+	auto result = next_entries_.insert(entries_.extract(iter));
+	const StorageProperty& property = result.position->second.property;
+	reused_names_.insert(property.generic_name);
+	++reused_count_;
+	return &property;
+}
+
+
+
+void StorageErrorLogJournal::store(StoragePropertySection section, std::uint64_t number, std::uint64_t fingerprint, StorageProperty property)
+{
+	const std::scoped_lock lock(mutex_);
+	auto& newest = next_newest_numbers_.try_emplace(section, number).first->second;
+	newest = std::max(newest, number);
+	next_entries_.insert_or_assign(EntryKey(section, number), Entry{fingerprint, std::move(property)});
+}
+
+
+
+void StorageErrorLogJournal::set_processing_key(std::uint64_t key)
+{
+	const std::scoped_lock lock(mutex_);
+	if (key != processing_key_) {
+		reused_names_.clear();
+		processing_key_ = key;
+	}
+}
+
+
+
+bool StorageErrorLogJournal::get_processed(const StorageProperty& p) const
+{
+	// Called from the processing threads, nothing changes it then
+	return !reused_names_.empty() && reused_names_.contains(p.generic_name);
+}
+
+
+
+void StorageErrorLogJournal::finish(const StoragePropertyRepository& repository)
+{
+	const std::scoped_lock lock(mutex_);
+
+	std::set<StoragePropertySection> sections;
+	std::unordered_map<std::string, Entry*> entries_by_name;
+	for (auto& [key, entry] : next_entries_) {
+		sections.insert(key.first);
+		entries_by_name.emplace(entry.property.generic_name, &entry);
+	}
+	for (const auto section : sections) {
+		for (const auto& p : repository.get_properties_for_section(section)) {
+			auto iter = entries_by_name.find(p.generic_name);
+			if (iter != entries_by_name.end()) {
+				iter->second->property = p;
+			}
+		}
+	}
+
+	entries_ = std::move(next_entries_);
+	next_entries_.clear();
+	newest_numbers_ = std::move(next_newest_numbers_);
+	next_newest_numbers_.clear();
+}
+
+
+
+std::size_t StorageErrorLogJournal::get_reused_count() const
+{
+	const std::scoped_lock lock(mutex_);
+	return reused_count_;
+}
+
+
+
+std::size_t StorageErrorLogJournal::get_reset_count() const
+{
+	const std::scoped_lock lock(mutex_);
+	return reset_count_;
+}
+
+
+
+void StorageErrorLogJournal::reset_log(StoragePropertySection section)
+{
+	entries_.erase(entries_.lower_bound(EntryKey(section, 0)),
+			entries_.upper_bound(EntryKey(section, std::numeric_limits<std::uint64_t>::max())));
+	newest_numbers_.erase(section);
+	++reset_count_;
+}
+
+
+
+
+
+
+/// @}
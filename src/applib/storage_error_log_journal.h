@@ -0,0 +1,111 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_ERROR_LOG_JOURNAL_H
+#define STORAGE_ERROR_LOG_JOURNAL_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "storage_property.h"
+#include "storage_property_repository.h"
+
+
+
+/// Error log entries of a drive ingested from its previous full outputs. The entries are
+/// numbered by the drive with a counter which only grows (ATA error number, NVMe error_count),
+/// so when the same journal is given to the parser of the next output, only the entries
+/// newer than the ones seen before are parsed and described, the rest are taken from the journal.
+/// Each entry has a fingerprint (a hash of its fields which never change, e.g. its lifetime
+/// hours), which must match for the entry to be reused. If it doesn't, or the newest entry is
+/// older than the newest one seen before, the log was reset (e.g. by a secure erase, a power cycle
+/// for the non-persistent NVMe log, or a counter wrap), and the journal of that log starts over.
+/// The entries which rolled off the drive's log are dropped from the journal, so the result
+/// is always the same as that of a full parse.
+/// The parsers call reuse() and store() (possibly from the section parsing threads),
+/// the drive calls the rest.
+class StorageErrorLogJournal {
+	public:
+
+		/// Start a new parse. If the requested sections or the maximum number of log entries
+		/// differ from the previous parse, the journal is cleared.
+		void begin(const std::vector<StoragePropertySection>& requested_sections, std::size_t max_log_entries);
+
+		/// Find the entry \c number of the \c section log ingested before, and keep it for the next parse.
+		/// \return its processed property, or nullptr if the entry is new or the log was reset.
+		[[nodiscard]] const StorageProperty* reuse(StoragePropertySection section, std::uint64_t number, std::uint64_t fingerprint);
+
+		/// Store a new entry parsed in this parse. If \c property is added to the repository
+		/// (as opposed to being a part of another property), its processed version is taken by finish().
+		void store(StoragePropertySection section, std::uint64_t number, std::uint64_t fingerprint, StorageProperty property);
+
+		/// Set the key of everything the processing of the properties depends on (drive type, settings).
+		/// Call after the parse. If it differs from the previous one, the reused entries are processed again.
+		void set_processing_key(std::uint64_t key);
+
+		/// Check whether \c p was taken from the journal in this parse and is already processed.
+		/// Call after set_processing_key().
+		[[nodiscard]] bool get_processed(const StorageProperty& p) const;
+
+		/// Finish the parse, taking the processed entries from \c repository and dropping the
+		/// entries which were not present in this parse.
+		void finish(const StoragePropertyRepository& repository);
+
+		/// Get the number of entries reused in the last parse
+		[[nodiscard]] std::size_t get_reused_count() const;
+
+		/// Get the number of log resets detected in the last parse
+		[[nodiscard]] std::size_t get_reset_count() const;
+
+
+	private:
+
+		/// An ingested entry
+		struct Entry {
+			std::uint64_t fingerprint = 0;  ///< Fingerprint of the entry
+			StorageProperty property;  ///< Property of the entry, processed if it's in the repository
+		};
+
+		/// Entry key: log section and entry number
+		using EntryKey = std::pair<StoragePropertySection, std::uint64_t>;
+
+		/// Drop the entries of the previous parse of \c section log. Called with mutex_ locked.
+		void reset_log(StoragePropertySection section);
+
+
+		mutable std::mutex mutex_;  ///< Protects the members between begin() and set_processing_key()
+		std::vector<StoragePropertySection> requested_sections_;  ///< Requested sections of the previous parse
+		std::size_t max_log_entries_ = 0;  ///< Maximum number of log entries of the previous parse
+		std::uint64_t processing_key_ = 0;  ///< Processing key of the stored properties
+		std::map<EntryKey, Entry> entries_;  ///< Entries of the previous parse
+		std::map<EntryKey, Entry> next_entries_;  ///< Entries of the current parse
+		std::map<StoragePropertySection, std::uint64_t> newest_numbers_;  ///< Newest entry number of each log in the previous parse
+		std::map<StoragePropertySection, std::uint64_t> next_newest_numbers_;  ///< Newest entry number of each log in the current parse
+		std::unordered_set<std::string> reused_names_;  ///< Generic names of the processed entries reused in the current parse
+		std::size_t reused_count_ = 0;  ///< Number of reused entries in the current / last parse
+		std::size_t reset_count_ = 0;  ///< Number of log resets in the current / last parse
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,108 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+
+#include "rconfig/rconfig.h"
+
+#include "storage_fetch_order.h"
+
+
+
+namespace {
+
+	/// Don't let the config grow forever with devices which are long gone
+	constexpr std::size_t max_stored_latencies = 512;
+
+}
+
+
+
+StorageFetchLatencies storage_fetch_latencies_load()
+{
+	StorageFetchLatencies latencies;
+	const auto stored = rconfig::get_data<rconfig::json>("system/fetch_latencies");
+	if (!stored.is_object()) {
+		return latencies;
+	}
+	for (const auto& [device, value] : stored.items()) {
+		if (value.is_number_integer() && value.get<std::chrono::milliseconds::rep>() >= 0) {
+			latencies.emplace(device, std::chrono::milliseconds(value.get<std::chrono::milliseconds::rep>()));
+		}
+	}
+	return latencies;
+}
+
+
+
+void storage_fetch_latencies_store(const StorageFetchLatencies& measured)
+{
+	if (measured.empty()) {
+		return;
+	}
+	StorageFetchLatencies latencies = storage_fetch_latencies_load();
+	if (latencies.size() + measured.size() > max_stored_latencies) {
+		latencies.clear();  // forget the old devices, the ones in use will be re-learned
+	}
+	for (const auto& [device, latency] : measured) {
+		auto iter = latencies.find(device);
+		if (iter == latencies.end()) {
+			latencies.emplace(device, latency);
+		} else {
+			// A single slow fetch (e.g. a drive spinning up) shouldn't reorder everything.
+			iter->second = (iter->second + latency) / 2;
+		}
+	}
+
+	rconfig::json stored = rconfig::json::object();
+	for (const auto& [device, latency] : latencies) {
+		stored[device] = latency.count();
+	}
+	rconfig::set_data("system/fetch_latencies", stored);
+}
+
+
+
+std::vector<std::size_t> storage_fetch_get_order(const std::vector<std::optional<std::chrono::milliseconds>>& latencies,
+		std::size_t max_parallel, std::chrono::milliseconds slow_threshold)
+{
+	std::vector<std::size_t> slow, fast, unknown;
+	for (std::size_t i = 0; i < latencies.size(); ++i) {
+		if (!latencies[i].has_value()) {
+			unknown.push_back(i);
+		} else if (latencies[i].value() >= slow_threshold) {
+			slow.push_back(i);
+		} else {
+			fast.push_back(i);
+		}
+	}
+
+	std::stable_sort(slow.begin(), slow.end(), [&latencies](std::size_t a, std::size_t b) {
+		return latencies[a].value() > latencies[b].value();
+	});
+	std::stable_sort(fast.begin(), fast.end(), [&latencies](std::size_t a, std::size_t b) {
+		return latencies[a].value() < latencies[b].value();
+	});
+
+	const std::size_t early_slow_count = std::min(slow.size(), max_parallel > 1 ? max_parallel - 1 : std::size_t(0));
+
+	std::vector<std::size_t> order;
+	order.reserve(latencies.size());
+	order.insert(order.end(), slow.begin(), slow.begin() + static_cast<std::ptrdiff_t>(early_slow_count));
+	order.insert(order.end(), fast.begin(), fast.end());
+	order.insert(order.end(), unknown.begin(), unknown.end());
+	order.insert(order.end(), slow.begin() + static_cast<std::ptrdiff_t>(early_slow_count), slow.end());
+	return order;
+}
+
+
+
+/// @}
@@ -0,0 +1,52 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_FETCH_ORDER_H
+#define STORAGE_FETCH_ORDER_H
+
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+
+/// Drive ID (see storage_drive_identity_update()), or device with type if it has none
+/// (see StorageDevice::get_device_with_type()) -> basic data fetch latency
+using StorageFetchLatencies = std::unordered_map<std::string, std::chrono::milliseconds>;
+
+
+/// Load the recent basic data fetch latencies, stored in "system/fetch_latencies" config key.
+[[nodiscard]] StorageFetchLatencies storage_fetch_latencies_load();
+
+
+/// Merge the new measurements with the stored ones (smoothing the values of known devices)
+/// and store the result in "system/fetch_latencies" config key.
+void storage_fetch_latencies_store(const StorageFetchLatencies& measured);
+
+
+/// Get the order to fetch the drives in, given their previous latencies (unset if unknown)
+/// and the number of drives fetched simultaneously.
+/// Drives slower than \c slow_threshold are started first (slowest first), but only on up to
+/// max_parallel - 1 workers, so that the remaining workers go through the fast drives
+/// (fastest first), then the ones with unknown latency. The slow drives which didn't
+/// get a worker come last.
+/// \return Indices into \c latencies.
+[[nodiscard]] std::vector<std::size_t> storage_fetch_get_order(const std::vector<std::optional<std::chrono::milliseconds>>& latencies,
+		std::size_t max_parallel, std::chrono::milliseconds slow_threshold);
+
+
+
+#endif
+
+/// @}
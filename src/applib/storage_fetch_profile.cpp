@@ -0,0 +1,106 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "storage_fetch_profile.h"
+
+#include "hz/debug.h"
+
+
+
+std::vector<StoragePropertySection> storage_fetch_profile_get_sections(StorageFetchProfile profile)
+{
+	switch (profile) {
+		case StorageFetchProfile::Full:
+			break;
+		case StorageFetchProfile::Monitoring:
+			return {
+					StoragePropertySection::Info,
+					StoragePropertySection::OverallHealth,
+					StoragePropertySection::AtaAttributes,
+					StoragePropertySection::Statistics,
+					StoragePropertySection::NvmeHealth,
+					StoragePropertySection::NvmeAttributes,
+			};
+	}
+	return {};
+}
+
+
+
+std::vector<std::string> storage_fetch_profile_get_smartctl_options(StorageFetchProfile profile,
+		StorageDeviceDetectedType type)
+{
+	switch (type) {
+		case StorageDeviceDetectedType::Unknown:
+		case StorageDeviceDetectedType::NeedsExplicitType:
+			DBG_ASSERT(0);
+			break;
+
+		case StorageDeviceDetectedType::AtaAny:
+		case StorageDeviceDetectedType::AtaHdd:
+		case StorageDeviceDetectedType::AtaSsd:
+			if (profile == StorageFetchProfile::Monitoring) {
+				// The temperature is a part of --attributes. SCT temperature history and the
+				// logs need additional (slow, on some drives) reads, so skip them.
+				return {
+						"--health",
+						"--info",
+						"--attributes",
+						"--format=brief",
+						"--log=devstat",
+				};
+			}
+			// Instead of -x, we use all the individual options -x encompasses, so that
+			// an addition to default -x output won't affect us.
+			return {
+					"--health",
+					"--info",
+					"--get=all",
+					"--capabilities",
+					"--attributes",
+					"--format=brief",
+					"--log=xerror,50,error",
+					"--log=xselftest,50,selftest",
+					"--log=selective",
+					"--log=directory",
+					"--log=scttemp",
+					"--log=scterc",
+					"--log=devstat",
+					"--log=sataphy",
+			};
+
+		case StorageDeviceDetectedType::Nvme:
+			if (profile == StorageFetchProfile::Monitoring) {
+				// --attributes is the SMART / Health Information log
+				return {"--health", "--info", "--attributes"};
+			}
+			// We don't care if something is added to json output.
+			// Same as: --health --info --capabilities --attributes --log=error --log=selftest
+			return {"--xall"};
+
+		case StorageDeviceDetectedType::BasicScsi:
+		case StorageDeviceDetectedType::CdDvd:
+		case StorageDeviceDetectedType::UnsupportedRaid:
+			if (profile == StorageFetchProfile::Monitoring) {
+				return {"--health", "--info", "--attributes"};
+			}
+			// SCSI equivalent of -x:
+			// command_options = "--health --info --attributes --log=error --log=selftest --log=background --log=sasphy";
+			return {"--xall"};
+	}
+	return {};
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,65 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_FETCH_PROFILE_H
+#define STORAGE_FETCH_PROFILE_H
+
+#include <glibmm/i18n.h>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hz/enum_helper.h"
+#include "storage_device_detected_type.h"
+#include "storage_property.h"
+
+
+
+/// What to retrieve from a drive when fetching its full data.
+enum class StorageFetchProfile {
+	Full,  ///< Everything smartctl -x gives. Needed by the Information window.
+	Monitoring,  ///< Health, attributes, statistics and temperature only. Less drive I/O, used for periodic polling.
+};
+
+
+
+/// Helper structure for enum-related functions
+struct StorageFetchProfileExt
+		: public hz::EnumTableHelper<
+				StorageFetchProfile,
+				StorageFetchProfileExt>
+{
+	static constexpr StorageFetchProfile default_value = StorageFetchProfile::Full;
+
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{StorageFetchProfile::Full, "full", N_("Full")},
+		{StorageFetchProfile::Monitoring, "monitoring", N_("Monitoring")},
+	});
+
+};
+
+
+
+/// Get the sections retrieved with a profile. An empty vector means all sections.
+[[nodiscard]] std::vector<StoragePropertySection> storage_fetch_profile_get_sections(StorageFetchProfile profile);
+
+
+/// Get smartctl options (without --json) which retrieve the profile's sections from a drive of type \c type.
+[[nodiscard]] std::vector<std::string> storage_fetch_profile_get_smartctl_options(StorageFetchProfile profile,
+		StorageDeviceDetectedType type);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,229 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+
+#include "hz/string_algo.h"
+
+#include "storage_fleet.h"
+
+
+
+namespace {
+
+	/// Get the heap memory of a string (nothing if it fits into the string object)
+	std::size_t fleet_get_string_memory(const std::string& str)
+	{
+		static const std::size_t inline_capacity = std::string().capacity();
+		return (str.capacity() > inline_capacity) ? str.capacity() + 1 : 0;
+	}
+
+}
+
+
+
+std::size_t StorageFleetTable::add_host(const std::string& destination)
+{
+	if (auto iter = host_by_destination_.find(destination); iter != host_by_destination_.end()) {
+		return iter->second;
+	}
+	hosts_.push_back({destination, {}});
+	host_by_destination_.emplace(destination, hosts_.size() - 1);
+	return hosts_.size() - 1;
+}
+
+
+
+bool StorageFleetTable::update(std::size_t host, StorageAgentStreamDecoder& decoder)
+{
+	bool changed = false;
+	const auto& drives = decoder.get_drives();
+	for (const auto drive_id : decoder.take_changed_drives()) {
+		auto drive_iter = drives.find(drive_id);
+		if (drive_iter == drives.end()) {
+			continue;
+		}
+		const StorageAgentDrive& drive = drive_iter->second;
+
+		auto [row_iter, inserted] = row_by_drive_.try_emplace({host, drive_id}, rows_.size());
+		if (inserted) {
+			rows_.emplace_back();
+			rows_.back().host = host;
+			rows_.back().drive_id = drive_id;
+			order_.push_back(rows_.size() - 1);
+		}
+		StorageFleetRow& row = rows_[row_iter->second];
+		if (!inserted && row.device == drive.device && row.type_argument == drive.type_argument
+				&& row.summary == drive.summary && row.error == drive.error) {
+			continue;
+		}
+		row.device = drive.device;
+		row.type_argument = drive.type_argument;
+		row.summary = drive.summary;
+		row.error = drive.error;
+		changed = true;
+	}
+	order_dirty_ = order_dirty_ || changed;
+	return changed;
+}
+
+
+
+void StorageFleetTable::set_host_error(std::size_t host, std::string error)
+{
+	hosts_.at(host).error = std::move(error);
+}
+
+
+
+void StorageFleetTable::clear_host(std::size_t host)
+{
+	const auto old_size = rows_.size();
+	rows_.erase(std::remove_if(rows_.begin(), rows_.end(),
+			[host](const StorageFleetRow& row) { return row.host == host; }), rows_.end());
+	if (rows_.size() == old_size) {
+		return;
+	}
+	row_by_drive_.clear();
+	order_.clear();
+	for (std::size_t i = 0; i < rows_.size(); ++i) {
+		row_by_drive_.emplace(std::pair(rows_[i].host, rows_[i].drive_id), i);
+		order_.push_back(i);
+	}
+	order_dirty_ = true;
+}
+
+
+
+const std::vector<StorageFleetHost>& StorageFleetTable::get_hosts() const
+{
+	return hosts_;
+}
+
+
+
+std::size_t StorageFleetTable::size() const
+{
+	return rows_.size();
+}
+
+
+
+std::vector<std::size_t> StorageFleetTable::get_warning_counts() const
+{
+	std::vector<std::size_t> counts(static_cast<std::size_t>(WarningLevel::Alert) + 1, 0);
+	for (const auto& row : rows_) {
+		++counts.at(static_cast<std::size_t>(row.summary.worst_warning));
+	}
+	return counts;
+}
+
+
+
+StorageFleetPage StorageFleetTable::get_page(const StorageDeviceFilter& filter, std::size_t offset, std::size_t count) const
+{
+	sort_rows();
+
+	StorageFleetPage page;
+	const bool filtered = !filter.is_empty();
+	for (const auto index : order_) {
+		const StorageFleetRow& row = rows_[index];
+		if (filtered && !storage_device_index_record_matches(make_record(row), filter)) {
+			continue;
+		}
+		if (page.total >= offset && page.rows.size() < count) {
+			page.rows.push_back(row);
+		}
+		++page.total;
+	}
+	return page;
+}
+
+
+
+const StorageFleetRow* StorageFleetTable::find(std::size_t host, std::uint64_t drive_id) const
+{
+	if (auto iter = row_by_drive_.find({host, drive_id}); iter != row_by_drive_.end()) {
+		return &rows_[iter->second];
+	}
+	return nullptr;
+}
+
+
+
+std::size_t StorageFleetTable::get_memory_usage() const
+{
+	std::size_t size = rows_.capacity() * sizeof(StorageFleetRow) + order_.capacity() * sizeof(std::size_t);
+	for (const auto& row : rows_) {
+		size += fleet_get_string_memory(row.device) + fleet_get_string_memory(row.type_argument)
+				+ fleet_get_string_memory(row.summary.model) + fleet_get_string_memory(row.summary.serial)
+				+ fleet_get_string_memory(row.error);
+	}
+	// Node of each map entry
+	size += row_by_drive_.size() * (sizeof(std::pair<std::size_t, std::uint64_t>) + sizeof(std::size_t) + 4 * sizeof(void*));
+	for (const auto& host : hosts_) {
+		size += sizeof(StorageFleetHost) + 2 * fleet_get_string_memory(host.destination) + fleet_get_string_memory(host.error)
+				+ sizeof(std::string) + sizeof(std::size_t) + 4 * sizeof(void*);
+	}
+	return size;
+}
+
+
+
+StorageDevicePtr StorageFleetTable::make_drive(const StorageFleetRow& row, const std::vector<RemoteHostPtr>& remote_hosts) const
+{
+	const std::string& destination = hosts_.at(row.host).destination;
+	auto host_iter = std::find_if(remote_hosts.begin(), remote_hosts.end(),
+			[&destination](const RemoteHostPtr& host) { return host && host->get_destination() == destination; });
+	if (host_iter == remote_hosts.end()) {
+		return nullptr;
+	}
+	auto drive = std::make_shared<StorageDevice>(row.device, row.type_argument);
+	drive->set_remote_host(*host_iter);
+	return drive;
+}
+
+
+
+StorageDeviceIndexRecord StorageFleetTable::make_record(const StorageFleetRow& row) const
+{
+	StorageDeviceIndexRecord record;
+	record.host = hosts_.at(row.host).destination;
+	record.search_text = hz::string_to_lower_copy(row.summary.model + "\n" + row.summary.serial + "\n"
+			+ row.device + (row.type_argument.empty() ? std::string() : (" (" + row.type_argument + ")")) + "\n" + record.host);
+	record.warning = row.summary.worst_warning;
+	record.controller = storage_device_index_get_controller(record.host, row.device, row.type_argument);
+	return record;
+}
+
+
+
+void StorageFleetTable::sort_rows() const
+{
+	if (!order_dirty_) {
+		return;
+	}
+	std::sort(order_.begin(), order_.end(), [this](std::size_t a, std::size_t b) {
+		const StorageFleetRow& ra = rows_[a];
+		const StorageFleetRow& rb = rows_[b];
+		// Descending warnings and scores, ascending names
+		return std::tie(rb.summary.worst_warning, rb.summary.risk_score, hosts_[ra.host].destination, ra.device, ra.drive_id)
+				< std::tie(ra.summary.worst_warning, ra.summary.risk_score, hosts_[rb.host].destination, rb.device, rb.drive_id);
+	});
+	order_dirty_ = false;
+}
+
+
+
+
+/// @}
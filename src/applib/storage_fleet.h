@@ -0,0 +1,129 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_FLEET_H
+#define STORAGE_FLEET_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "command_executor_remote.h"
+#include "storage_agent_protocol.h"
+#include "storage_device_index.h"
+
+
+
+/// A drive of the fleet
+struct StorageFleetRow {
+	std::size_t host = 0;  ///< Index of the host (see StorageFleetTable::get_hosts())
+	std::uint64_t drive_id = 0;  ///< Drive ID in the agent stream of the host
+	std::string device;  ///< Device on the host
+	std::string type_argument;  ///< smartctl -d argument
+	StorageAgentDriveSummary summary;  ///< Summary of the drive data
+	std::string error;  ///< Error of the last update of the drive, empty if it succeeded
+};
+
+
+
+/// A host of the fleet
+struct StorageFleetHost {
+	std::string destination;  ///< SSH destination the agent runs on
+	std::string error;  ///< Agent stream error, empty if there is none
+};
+
+
+
+/// A page of the fleet rows
+struct StorageFleetPage {
+	std::vector<StorageFleetRow> rows;  ///< Rows of the page
+	std::size_t total = 0;  ///< Number of rows matching the filter
+};
+
+
+
+/// Summaries of the drives of many hosts, as received from their agent streams
+/// (decoded in StorageAgentDecoderMode::Summary). Only the summaries are kept, so the
+/// memory used is proportional to the number of drives, not to the size of their data.
+/// The full data of a drive is fetched from its host when needed (see StorageFleetTable::make_drive()).
+/// The rows are read a page at a time, ordered by the worst warning and the risk score.
+/// This class is not thread-safe.
+class StorageFleetTable {
+	public:
+
+		/// Add a host if it's not known yet. \return its index.
+		std::size_t add_host(const std::string& destination);
+
+		/// Update the rows of the drives changed in the stream of a host since the last call
+		/// (see StorageAgentStreamDecoder::take_changed_drives()). \return true if anything changed.
+		bool update(std::size_t host, StorageAgentStreamDecoder& decoder);
+
+		/// Set the agent stream error of a host (empty to clear it)
+		void set_host_error(std::size_t host, std::string error);
+
+		/// Remove the drives of a host, e.g. when its agent is restarted with a new stream
+		void clear_host(std::size_t host);
+
+
+		/// Get the hosts
+		[[nodiscard]] const std::vector<StorageFleetHost>& get_hosts() const;
+
+		/// Get the number of drives
+		[[nodiscard]] std::size_t size() const;
+
+		/// Get the number of drives with each warning level (indexed by WarningLevel)
+		[[nodiscard]] std::vector<std::size_t> get_warning_counts() const;
+
+		/// Get \c count rows matching \c filter, starting at \c offset. The rows are ordered by
+		/// the worst warning and the risk score (the most troubled first), then by host and device.
+		[[nodiscard]] StorageFleetPage get_page(const StorageDeviceFilter& filter, std::size_t offset, std::size_t count) const;
+
+		/// Find the row of a drive. \return nullptr if not found.
+		[[nodiscard]] const StorageFleetRow* find(std::size_t host, std::uint64_t drive_id) const;
+
+		/// Get the approximate memory used by the table, in bytes
+		[[nodiscard]] std::size_t get_memory_usage() const;
+
+
+		/// Create a drive for fetching the full data of a row from its host
+		/// (one of \c remote_hosts, matched by destination). \return nullptr if the host is not in \c remote_hosts.
+		[[nodiscard]] StorageDevicePtr make_drive(const StorageFleetRow& row, const std::vector<RemoteHostPtr>& remote_hosts) const;
+
+		/// Get the searchable record of a row (see StorageDeviceIndex)
+		[[nodiscard]] StorageDeviceIndexRecord make_record(const StorageFleetRow& row) const;
+
+
+	private:
+
+		/// Sort order_ if the rows changed since the last sort
+		void sort_rows() const;
+
+
+		std::vector<StorageFleetHost> hosts_;  ///< Hosts
+		std::map<std::string, std::size_t, std::less<>> host_by_destination_;  ///< Destination -> index in hosts_
+		std::vector<StorageFleetRow> rows_;  ///< Rows
+		std::map<std::pair<std::size_t, std::uint64_t>, std::size_t> row_by_drive_;  ///< (host, drive ID) -> index in rows_
+
+		mutable std::vector<std::size_t> order_;  ///< Indices of rows_, in the page order
+		mutable bool order_dirty_ = false;  ///< Whether order_ has to be sorted again
+
+};
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,674 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <optional>
+#include <string_view>
+
+#include "hz/debug.h"
+#include "hz/string_num.h"
+
+#include "storage_history.h"
+#include "storage_device.h"
+
+
+
+namespace {
+
+	/// File header, including the format version
+	constexpr std::string_view history_file_header = "GSCHIST\x01";
+
+	/// Maximum history file size to load
+	constexpr std::uintmax_t history_max_file_size = 1024UL * 1024UL * 1024UL;  // 1G
+
+
+	/// Block types
+	enum class HistoryBlockType : unsigned char {
+		Drive = 1,  ///< drive ID, serial number
+		Series = 2,  ///< drive ID, series index, key
+		Sample = 3,  ///< drive ID, time delta, number of changed values, (series index delta, value delta) pairs
+		ErrorLba = 4,  ///< drive ID, time delta, number of LBAs, (LBA delta, source flags) pairs
+	};
+
+
+	/// Append an unsigned LEB128 varint
+	void history_put_varint(std::string& out, std::uint64_t value)
+	{
+		while (value >= 0x80) {
+			out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+
+	/// Append a zigzag-encoded signed delta between two values (wrapping)
+	void history_put_delta(std::string& out, std::int64_t value, std::int64_t base)
+	{
+		const std::uint64_t delta = static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(base);
+		const std::uint64_t sign = (delta >> 63) != 0 ? ~std::uint64_t(0) : 0;
+		history_put_varint(out, (delta << 1) ^ sign);
+	}
+
+
+	/// Append a length-prefixed string
+	void history_put_string(std::string& out, std::string_view str)
+	{
+		history_put_varint(out, str.size());
+		out.append(str);
+	}
+
+
+	/// Append a block
+	void history_put_block(std::string& out, HistoryBlockType type, const std::string& payload)
+	{
+		out.push_back(static_cast<char>(type));
+		history_put_varint(out, payload.size());
+		out.append(payload);
+	}
+
+
+	/// Bounds-checked reader of the encoded data
+	class HistoryReader {
+		public:
+
+			/// Constructor
+			explicit HistoryReader(std::string_view data) : data_(data)
+			{ }
+
+			/// Read a varint
+			std::optional<std::uint64_t> get_varint()
+			{
+				std::uint64_t value = 0;
+				for (int shift = 0; shift < 64 && pos_ < data_.size(); shift += 7) {
+					const auto byte = static_cast<unsigned char>(data_[pos_++]);
+					value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+					if ((byte & 0x80) == 0) {
+						return value;
+					}
+				}
+				return std::nullopt;
+			}
+
+			/// Read a delta and apply it to \c base
+			std::optional<std::int64_t> get_delta(std::int64_t base)
+			{
+				const auto zigzag = get_varint();
+				if (!zigzag) {
+					return std::nullopt;
+				}
+				const std::uint64_t delta = (*zigzag >> 1) ^ ((*zigzag & 1) != 0 ? ~std::uint64_t(0) : 0);
+				return static_cast<std::int64_t>(static_cast<std::uint64_t>(base) + delta);
+			}
+
+			/// Read a string
+			std::optional<std::string_view> get_string()
+			{
+				const auto size = get_varint();
+				if (!size || *size > data_.size() - pos_) {
+					return std::nullopt;
+				}
+				auto str = data_.substr(pos_, static_cast<std::size_t>(*size));
+				pos_ += str.size();
+				return str;
+			}
+
+			/// Read a single byte
+			std::optional<unsigned char> get_byte()
+			{
+				if (pos_ >= data_.size()) {
+					return std::nullopt;
+				}
+				return static_cast<unsigned char>(data_[pos_++]);
+			}
+
+			/// Check if all the data has been read
+			[[nodiscard]] bool at_end() const
+			{
+				return pos_ == data_.size();
+			}
+
+			/// Current position
+			[[nodiscard]] std::size_t get_pos() const
+			{
+				return pos_;
+			}
+
+		private:
+			std::string_view data_;  ///< Data
+			std::size_t pos_ = 0;  ///< Current position
+	};
+
+
+
+	/// Global history store
+	struct HistoryGlobal {
+		std::mutex mutex;  ///< Protects history
+		std::shared_ptr<StorageHistory> history;  ///< History store
+	};
+
+
+	/// Get the global history store
+	HistoryGlobal& history_get_global_ref()
+	{
+		static HistoryGlobal global;
+		return global;
+	}
+
+}
+
+
+
+StorageHistory::StorageHistory(hz::fs::path file)
+		: file_(std::move(file))
+{ }
+
+
+
+std::error_code StorageHistory::open()
+{
+	const std::scoped_lock lock(mutex_);
+	drives_.clear();
+	drives_by_serial_.clear();
+	valid_file_size_ = 0;
+
+	std::error_code ec;
+	if (!hz::fs::exists(file_, ec)) {
+		return {};
+	}
+
+	std::string data;
+	ec = hz::fs_file_get_contents(file_, data, history_max_file_size);
+	if (ec) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot read history file \"" << hz::fs_path_to_string(file_) << "\": " << ec.message() << "\n");
+		return ec;
+	}
+	if (data.substr(0, history_file_header.size()) != history_file_header) {
+		debug_out_warn("app", DBG_FUNC_MSG << "History file \"" << hz::fs_path_to_string(file_) << "\" has unsupported format, it will be overwritten.\n");
+		return {};
+	}
+
+	valid_file_size_ = history_file_header.size() + decode(data.substr(history_file_header.size()));
+	if (valid_file_size_ != data.size()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "History file \"" << hz::fs_path_to_string(file_) << "\" has "
+				<< (data.size() - valid_file_size_) << " bytes of broken data at the end, discarding them.\n");
+	}
+	debug_out_info("app", DBG_FUNC_MSG << "Loaded history of " << drives_.size() << " drives.\n");
+	return {};
+}
+
+
+
+std::error_code StorageHistory::append(const std::string& serial, std::int64_t time, const StorageHistoryValues& values,
+		const StorageErrorLbaList& error_lbas)
+{
+	const std::scoped_lock lock(mutex_);
+
+	std::string blocks;
+	std::string payload;
+
+	std::size_t drive_id = drives_.size();
+	if (auto iter = drives_by_serial_.find(serial); iter != drives_by_serial_.end()) {
+		drive_id = iter->second;
+	} else {
+		history_put_varint(payload, drive_id);
+		history_put_string(payload, serial);
+		history_put_block(blocks, HistoryBlockType::Drive, payload);
+	}
+	const Drive* drive = (drive_id < drives_.size() ? &drives_[drive_id] : nullptr);
+
+	// (series index, value) of the changed values
+	std::vector<std::pair<std::size_t, std::int64_t>> changed;
+	std::size_t num_series = (drive ? drive->series.size() : 0);
+	std::map<std::string, std::size_t, std::less<>> new_series;
+	for (const auto& [key, value] : values) {
+		std::optional<std::size_t> known_index;
+		if (drive) {
+			if (auto iter = drive->series_by_key.find(key); iter != drive->series_by_key.end()) {
+				known_index = iter->second;
+			}
+		}
+		if (known_index.has_value()) {
+			if (value != drive->series[*known_index].last_value) {
+				changed.emplace_back(*known_index, value);
+			}
+			continue;
+		}
+		if (new_series.find(key) != new_series.end()) {
+			continue;  // duplicate key, first one wins
+		}
+		const std::size_t index = num_series++;
+		new_series.emplace(key, index);
+		payload.clear();
+		history_put_varint(payload, drive_id);
+		history_put_varint(payload, index);
+		history_put_string(payload, key);
+		history_put_block(blocks, HistoryBlockType::Series, payload);
+		changed.emplace_back(index, value);  // the first value is always written
+	}
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end(),  // duplicate keys in values
+			[](const auto& a, const auto& b) { return a.first == b.first; }), changed.end());
+
+	payload.clear();
+	history_put_varint(payload, drive_id);
+	history_put_delta(payload, time, drive ? drive->last_time : 0);
+	history_put_varint(payload, changed.size());
+	std::size_t last_index = 0;
+	for (const auto& [index, value] : changed) {
+		history_put_varint(payload, index - last_index);
+		history_put_delta(payload, value, drive ? (index < drive->series.size() ? drive->series[index].last_value : 0) : 0);
+		last_index = index;
+	}
+	history_put_block(blocks, HistoryBlockType::Sample, payload);
+
+	// Only the LBAs which are new (or seen in new logs) are written
+	StorageErrorLbaList new_lbas;
+	for (const auto& [lba, sources] : error_lbas) {
+		const auto known = (drive && drive->error_lbas) ? drive->error_lbas->find(lba) : std::nullopt;
+		if (!known.has_value() || (known->sources | sources) != known->sources) {
+			new_lbas.emplace_back(lba, sources);
+		}
+	}
+	std::sort(new_lbas.begin(), new_lbas.end());
+	if (!new_lbas.empty()) {
+		payload.clear();
+		history_put_varint(payload, drive_id);
+		history_put_delta(payload, time, time);  // follows the sample block, which sets the base time
+		history_put_varint(payload, new_lbas.size());
+		std::uint64_t last_lba = 0;
+		for (const auto& [lba, sources] : new_lbas) {
+			history_put_varint(payload, lba - last_lba);
+			history_put_varint(payload, sources);
+			last_lba = lba;
+		}
+		history_put_block(blocks, HistoryBlockType::ErrorLba, payload);
+	}
+
+	if (auto ec = write_blocks(blocks); ec) {
+		return ec;
+	}
+
+	// Apply the same blocks to memory, so that it's always in sync with the file.
+	[[maybe_unused]] const std::size_t decoded = decode(blocks);
+	DBG_ASSERT(decoded == blocks.size());
+	return {};
+}
+
+
+
+std::error_code StorageHistory::append(const StorageDevice& drive)
+{
+	const std::string serial = drive.get_serial_number();
+	if (serial.empty()) {
+		return {};
+	}
+	const auto now = std::chrono::system_clock::now();
+	const auto time = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+	const auto& properties = drive.get_property_repository();
+	return append(serial, time, get_values_from_properties(properties),
+			StorageErrorLbaIndex::get_lbas_from_properties(properties));
+}
+
+
+
+std::optional<std::int64_t> StorageHistory::get_last_time(const std::string& serial) const
+{
+	const std::scoped_lock lock(mutex_);
+	if (auto iter = drives_by_serial_.find(serial); iter != drives_by_serial_.end()) {
+		return drives_[iter->second].last_time;
+	}
+	return std::nullopt;
+}
+
+
+
+std::vector<std::string> StorageHistory::get_series_keys(const std::string& serial) const
+{
+	const std::scoped_lock lock(mutex_);
+	std::vector<std::string> keys;
+	if (auto iter = drives_by_serial_.find(serial); iter != drives_by_serial_.end()) {
+		for (const auto& [key, index] : drives_[iter->second].series_by_key) {
+			keys.push_back(key);
+		}
+	}
+	return keys;  // sorted by std::map
+}
+
+
+
+std::vector<StorageHistoryPoint> StorageHistory::get_series(const std::string& serial, const std::string& key,
+		std::int64_t from, std::int64_t to) const
+{
+	const std::scoped_lock lock(mutex_);
+	std::vector<StorageHistoryPoint> result;
+
+	auto drive_iter = drives_by_serial_.find(serial);
+	if (drive_iter == drives_by_serial_.end()) {
+		return result;
+	}
+	const Drive& drive = drives_[drive_iter->second];
+	auto series_iter = drive.series_by_key.find(key);
+	if (series_iter == drive.series_by_key.end()) {
+		return result;
+	}
+	const auto& points = drive.series[series_iter->second].points;
+
+	auto begin = std::upper_bound(points.begin(), points.end(), from,
+			[](std::int64_t time, const StorageHistoryPoint& point) { return time < point.time; });
+	auto end = std::upper_bound(begin, points.end(), to,
+			[](std::int64_t time, const StorageHistoryPoint& point) { return time < point.time; });
+
+	if (begin != points.begin()) {
+		result.push_back({from, std::prev(begin)->value});  // the value in effect at "from"
+	}
+	result.insert(result.end(), begin, end);
+	if (!result.empty() && drive.last_time <= to && drive.last_time > result.back().time) {
+		result.push_back({drive.last_time, result.back().value});
+	}
+	return result;
+}
+
+
+
+void StorageHistory::for_each_point(const std::function<void(const std::string& serial, const std::string& key,
+		const StorageHistoryPoint& point)>& func) const
+{
+	const std::scoped_lock lock(mutex_);
+	for (const auto& drive : drives_) {
+		for (const auto& series : drive.series) {
+			for (const auto& point : series.points) {
+				func(drive.serial, series.key, point);
+			}
+		}
+	}
+}
+
+
+
+void StorageHistory::for_each_new_point(StorageHistoryCursor& cursor, const std::function<void(const std::string& serial,
+		const std::string& key, const StorageHistoryPoint& point)>& func) const
+{
+	const std::scoped_lock lock(mutex_);
+	for (const auto& drive : drives_) {
+		auto& drive_cursor = cursor[drive.serial];
+		for (const auto& series : drive.series) {
+			std::size_t& read_count = drive_cursor[series.key];
+			for (std::size_t i = read_count; i < series.points.size(); ++i) {
+				func(drive.serial, series.key, series.points[i]);
+			}
+			read_count = std::max(read_count, series.points.size());
+		}
+	}
+}
+
+
+
+std::vector<std::pair<std::string, StorageTrend>> StorageHistory::get_trends(const std::string& serial) const
+{
+	const std::scoped_lock lock(mutex_);
+	std::vector<std::pair<std::string, StorageTrend>> trends;
+	if (auto iter = drives_by_serial_.find(serial); iter != drives_by_serial_.end()) {
+		const Drive& drive = drives_[iter->second];
+		for (const std::size_t index : drive.tracked_series) {
+			trends.emplace_back(drive.series[index].key, drive.series[index].trend.value());
+		}
+	}
+	return trends;
+}
+
+
+
+std::shared_ptr<const StorageErrorLbaIndex> StorageHistory::get_error_lbas(const std::string& serial) const
+{
+	const std::scoped_lock lock(mutex_);
+	if (auto iter = drives_by_serial_.find(serial); iter != drives_by_serial_.end()) {
+		return drives_[iter->second].error_lbas;
+	}
+	return nullptr;
+}
+
+
+
+StorageHistoryValues StorageHistory::get_values_from_properties(const StoragePropertyRepository& properties)
+{
+	StorageHistoryValues values;
+	for (const auto& p : properties.get_properties()) {
+		if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()) {
+			const auto& attr = p.get_value<AtaStorageAttribute>();
+			const std::string prefix = "ata_attr/" + hz::number_to_string_nolocale(attr.id);
+			values.emplace_back(prefix + "/raw", attr.raw_value_int);
+			if (attr.value.has_value()) {
+				values.emplace_back(prefix + "/value", attr.value.value());
+			}
+
+		} else if (p.section == StoragePropertySection::Statistics && p.is_value_type<AtaStorageStatistic>()) {
+			const auto& stat = p.get_value<AtaStorageStatistic>();
+			if (!stat.is_header) {
+				values.emplace_back("ata_stat/" + hz::number_to_string_nolocale(stat.page)
+						+ "/" + hz::number_to_string_nolocale(stat.offset), stat.value_int);
+			}
+
+		} else if (p.section == StoragePropertySection::NvmeAttributes && p.is_value_type<std::int64_t>()) {
+			values.emplace_back("nvme/" + p.generic_name, p.get_value<std::int64_t>());
+		}
+	}
+	return values;
+}
+
+
+
+hz::fs::path StorageHistory::get_default_file()
+{
+	return hz::fs_get_user_config_dir() / "gsmartcontrol" / "history.dat";
+}
+
+
+
+std::size_t StorageHistory::decode(const std::string& data)
+{
+	HistoryReader reader(data);
+	std::size_t valid_size = 0;
+
+	while (!reader.at_end()) {
+		const auto type = reader.get_byte();
+		const auto payload = reader.get_string();
+		if (!type || !payload) {
+			break;  // truncated
+		}
+		HistoryReader block(*payload);
+		bool ok = false;
+
+		switch (static_cast<HistoryBlockType>(*type)) {
+			case HistoryBlockType::Drive:
+			{
+				const auto drive_id = block.get_varint();
+				const auto serial = block.get_string();
+				if (drive_id && serial && *drive_id == drives_.size() && drives_by_serial_.find(*serial) == drives_by_serial_.end()) {
+					Drive& drive = drives_.emplace_back();
+					drive.serial = std::string(*serial);
+					drives_by_serial_.emplace(drive.serial, drives_.size() - 1);
+					ok = true;
+				}
+				break;
+			}
+			case HistoryBlockType::Series:
+			{
+				const auto drive_id = block.get_varint();
+				const auto index = block.get_varint();
+				const auto key = block.get_string();
+				if (drive_id && index && key && *drive_id < drives_.size()) {
+					Drive& drive = drives_[static_cast<std::size_t>(*drive_id)];
+					if (*index == drive.series.size() && drive.series_by_key.find(*key) == drive.series_by_key.end()) {
+						Series& series = drive.series.emplace_back();
+						series.key = std::string(*key);
+						drive.series_by_key.emplace(series.key, drive.series.size() - 1);
+						if (storage_trend_is_tracked(series.key)) {
+							series.trend.emplace();
+							drive.tracked_series.push_back(drive.series.size() - 1);
+						}
+						ok = true;
+					}
+				}
+				break;
+			}
+			case HistoryBlockType::Sample:
+			{
+				const auto drive_id = block.get_varint();
+				if (!drive_id || *drive_id >= drives_.size()) {
+					break;
+				}
+				Drive& drive = drives_[static_cast<std::size_t>(*drive_id)];
+				const auto time = block.get_delta(drive.last_time);
+				const auto count = block.get_varint();
+				if (!time || !count) {
+					break;
+				}
+				ok = true;
+				std::size_t index = 0;
+				for (std::uint64_t i = 0; i < *count; ++i) {
+					const auto index_delta = block.get_varint();
+					if (!index_delta || *index_delta > drive.series.size() - index) {
+						ok = false;
+						break;
+					}
+					index += static_cast<std::size_t>(*index_delta);
+					if (index >= drive.series.size()) {
+						ok = false;
+						break;
+					}
+					Series& series = drive.series[index];
+					const auto value = block.get_delta(series.last_value);
+					if (!value) {
+						ok = false;
+						break;
+					}
+					series.last_value = *value;
+					series.points.push_back({*time, *value});
+				}
+				// The unchanged values count too, they flatten the trends.
+				if (ok) {
+					for (const std::size_t tracked_index : drive.tracked_series) {
+						Series& series = drive.series[tracked_index];
+						if (!series.points.empty()) {  // has a value
+							series.trend->add(*time, series.last_value);
+						}
+					}
+				}
+				drive.last_time = *time;
+				break;
+			}
+			case HistoryBlockType::ErrorLba:
+			{
+				const auto drive_id = block.get_varint();
+				if (!drive_id || *drive_id >= drives_.size()) {
+					break;
+				}
+				Drive& drive = drives_[static_cast<std::size_t>(*drive_id)];
+				const auto time = block.get_delta(drive.last_time);
+				const auto count = block.get_varint();
+				if (!time || !count) {
+					break;
+				}
+				if (!drive.error_lbas) {
+					drive.error_lbas = std::make_shared<StorageErrorLbaIndex>();
+				} else if (drive.error_lbas.use_count() > 1) {
+					// Don't modify the index returned by get_error_lbas()
+					drive.error_lbas = std::make_shared<StorageErrorLbaIndex>(*drive.error_lbas);
+				}
+				ok = true;
+				std::uint64_t lba = 0;
+				for (std::uint64_t i = 0; i < *count; ++i) {
+					const auto lba_delta = block.get_varint();
+					const auto sources = block.get_varint();
+					if (!lba_delta || !sources || *sources > 0xff) {
+						ok = false;
+						break;
+					}
+					lba += *lba_delta;
+					drive.error_lbas->add(lba, static_cast<std::uint8_t>(*sources), *time);
+				}
+				break;
+			}
+		}
+
+		if (!ok || !block.at_end()) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Invalid history block at offset " << valid_size << ".\n");
+			break;
+		}
+		valid_size = reader.get_pos();
+	}
+
+	return valid_size;
+}
+
+
+
+std::error_code StorageHistory::write_blocks(const std::string& blocks)
+{
+	std::error_code ec;
+	hz::fs::create_directories(file_.parent_path(), ec);  // the error is reported by fopen below
+
+	// Discard the broken tail (or the whole file if its format is unsupported).
+	const bool file_exists = hz::fs::exists(file_, ec);
+	if (file_exists && valid_file_size_ == 0) {
+		hz::fs::resize_file(file_, 0, ec);
+	} else if (file_exists && hz::fs::file_size(file_, ec) != valid_file_size_ && !ec) {
+		hz::fs::resize_file(file_, valid_file_size_, ec);
+	}
+	if (ec) {
+		return ec;
+	}
+
+	std::FILE* f = hz::fs_platform_fopen(file_, "ab");
+	if (!f) {
+		return {errno, std::system_category()};
+	}
+	std::string data;
+	if (valid_file_size_ == 0) {
+		data = history_file_header;
+	}
+	data += blocks;
+	const bool write_ok = (std::fwrite(data.data(), data.size(), 1, f) == 1);
+	const int error = errno;
+	if (std::fclose(f) != 0 || !write_ok) {
+		return {write_ok ? errno : error, std::system_category()};
+	}
+	valid_file_size_ += data.size();
+	return {};
+}
+
+
+
+void storage_history_set_global(std::shared_ptr<StorageHistory> history)
+{
+	auto& global = history_get_global_ref();
+	const std::scoped_lock lock(global.mutex);
+	global.history = std::move(history);
+}
+
+
+
+std::shared_ptr<StorageHistory> storage_history_get_global()
+{
+	auto& global = history_get_global_ref();
+	const std::scoped_lock lock(global.mutex);
+	return global.history;
+}
+
+
+
+
+
+/// @}
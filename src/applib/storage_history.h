@@ -0,0 +1,193 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_HISTORY_H
+#define STORAGE_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "hz/fs.h"
+
+#include "storage_property_repository.h"
+#include "storage_error_lba_index.h"
+#include "storage_trend.h"
+
+
+class StorageDevice;
+
+
+
+/// A single history sample of a series
+struct StorageHistoryPoint {
+	std::int64_t time = 0;  ///< Sample time, seconds since epoch
+	std::int64_t value = 0;  ///< Value
+};
+
+
+
+/// Values of one drive at one point in time: (series key, value) pairs.
+using StorageHistoryValues = std::vector<std::pair<std::string, std::int64_t>>;
+
+
+
+/// Read position in the history (see StorageHistory::for_each_new_point()):
+/// serial -> series key -> number of change points already read.
+using StorageHistoryCursor = std::map<std::string, std::map<std::string, std::size_t, std::less<>>, std::less<>>;
+
+
+
+/// Append-only time-series store of raw SMART values (ATA attributes and statistics,
+/// NVMe health counters) per drive (serial number).
+///
+/// The file consists of the header and a sequence of blocks, each being a type byte,
+/// a varint payload size and the payload. Drives and their series are defined once,
+/// and each sample block stores only the values which changed since the previous
+/// sample of that drive, as zigzag varint deltas along with the time delta.
+/// The error LBAs of a drive are written once, when first seen (or seen in a new log),
+/// and are kept in a StorageErrorLbaIndex. The trends of some series (see storage_trend_is_tracked())
+/// are estimated as the samples are decoded, in O(1) time per sample.
+/// A truncated trailing block (e.g. after a crash) is discarded on open().
+///
+/// The whole file is decoded into memory on open(), so the range queries don't touch the disk.
+/// All the functions are thread-safe.
+class StorageHistory {
+	public:
+
+		/// Constructor. Call open() afterwards.
+		explicit StorageHistory(hz::fs::path file);
+
+
+		/// Load the existing data from file. A missing file is not an error.
+		[[nodiscard]] std::error_code open();
+
+
+		/// Append the values and error LBAs of a drive sampled at \c time. Only the changed values
+		/// and the new error LBAs are written.
+		[[nodiscard]] std::error_code append(const std::string& serial, std::int64_t time, const StorageHistoryValues& values,
+				const StorageErrorLbaList& error_lbas = {});
+
+
+		/// Append the current values and error LBAs of a drive, see get_values_from_properties()
+		/// and StorageErrorLbaIndex::get_lbas_from_properties().
+		/// Drives without a serial number are ignored.
+		[[nodiscard]] std::error_code append(const StorageDevice& drive);
+
+
+		/// Get the time of the last sample of a drive. \return std::nullopt if the drive has no samples.
+		[[nodiscard]] std::optional<std::int64_t> get_last_time(const std::string& serial) const;
+
+
+		/// Get the series keys of a drive, sorted.
+		[[nodiscard]] std::vector<std::string> get_series_keys(const std::string& serial) const;
+
+
+		/// Get the series values in [from, to] time range. The values change only at the
+		/// returned points. If the series has a value at \c from, the first point is
+		/// that value at time \c from. The last point is the last sample time (if in range),
+		/// so that the returned graph extends to it.
+		[[nodiscard]] std::vector<StorageHistoryPoint> get_series(const std::string& serial, const std::string& key,
+				std::int64_t from, std::int64_t to) const;
+
+
+		/// Call \c func for each change point of each series of each drive, in the order of
+		/// drives and series. The store is locked during the calls, \c func must not call its functions.
+		void for_each_point(const std::function<void(const std::string& serial, const std::string& key,
+				const StorageHistoryPoint& point)>& func) const;
+
+
+		/// Same as for_each_point(), but only for the change points added after \c cursor,
+		/// which is then advanced past them. The points are only appended, so the ones
+		/// read before are skipped without being visited.
+		void for_each_new_point(StorageHistoryCursor& cursor, const std::function<void(const std::string& serial,
+				const std::string& key, const StorageHistoryPoint& point)>& func) const;
+
+
+		/// Get the trends of the tracked series of a drive (see storage_trend_is_tracked()), as (key, trend) pairs.
+		[[nodiscard]] std::vector<std::pair<std::string, StorageTrend>> get_trends(const std::string& serial) const;
+
+
+		/// Get the error LBAs of a drive. \return nullptr if none were recorded.
+		[[nodiscard]] std::shared_ptr<const StorageErrorLbaIndex> get_error_lbas(const std::string& serial) const;
+
+
+		/// Get the history series values from parsed properties. The keys are:
+		/// "ata_attr/<id>/raw" and "ata_attr/<id>/value" for ATA attributes,
+		/// "ata_stat/<page>/<offset>" for ATA statistics, "nvme/<generic_name>" for NVMe health counters.
+		[[nodiscard]] static StorageHistoryValues get_values_from_properties(const StoragePropertyRepository& properties);
+
+
+		/// Get the default history file ("$HOME/.config/gsmartcontrol/history.dat" in UNIX).
+		[[nodiscard]] static hz::fs::path get_default_file();
+
+
+	private:
+
+		/// A series of a drive
+		struct Series {
+			std::string key;  ///< Series key
+			std::int64_t last_value = 0;  ///< Last value, the base of the next delta
+			std::vector<StorageHistoryPoint> points;  ///< Change points, by time
+			std::optional<StorageTrend> trend;  ///< Trend, if tracked
+		};
+
+		/// A drive
+		struct Drive {
+			std::string serial;  ///< Serial number
+			std::int64_t last_time = 0;  ///< Last sample time, the base of the next delta
+			std::vector<Series> series;  ///< Series, by local index
+			std::map<std::string, std::size_t, std::less<>> series_by_key;  ///< Key -> index in series
+			std::vector<std::size_t> tracked_series;  ///< Indices of the series with trends
+			std::shared_ptr<StorageErrorLbaIndex> error_lbas;  ///< Error LBAs (copied on write if shared with get_error_lbas() callers)
+		};
+
+
+		/// Decode the blocks in \c data. \return the size of the valid part.
+		std::size_t decode(const std::string& data);
+
+		/// Write the data to the end of the file
+		std::error_code write_blocks(const std::string& blocks);
+
+
+		hz::fs::path file_;  ///< History file
+		std::uintmax_t valid_file_size_ = 0;  ///< Size of the valid part of the file (the rest is truncated before writing)
+
+		mutable std::mutex mutex_;  ///< Protects all the members
+		std::vector<Drive> drives_;  ///< Drives, by ID
+		std::map<std::string, std::size_t, std::less<>> drives_by_serial_;  ///< Serial -> index in drives_
+
+};
+
+
+
+/// Set the history store which StorageDevice::fetch_full_data_and_parse() feeds (nullptr to disable).
+void storage_history_set_global(std::shared_ptr<StorageHistory> history);
+
+
+/// Get the history store set by storage_history_set_global(), may be nullptr.
+[[nodiscard]] std::shared_ptr<StorageHistory> storage_history_get_global();
+
+
+
+
+
+#endif
+
+/// @}
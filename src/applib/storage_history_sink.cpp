@@ -0,0 +1,441 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "fmt/format.h"
+#include "hz/debug.h"
+#include "hz/string_num.h"
+#include "nlohmann/json.hpp"
+#include "rconfig/rconfig.h"
+
+#include "command_executor.h"
+#include "storage_output_compression.h"
+#include "storage_history_sink.h"
+
+
+
+namespace {
+
+	/// Version of the chunk and state file formats
+	constexpr int history_sink_format_version = 1;
+
+
+	/// Maximum decompressed chunk size we accept
+	constexpr std::uintmax_t history_chunk_max_size = 256UL * 1024UL * 1024UL;
+
+
+	/// Chunk file name suffix
+	constexpr std::string_view history_chunk_suffix = ".chunk.json.gz";
+
+
+	/// Failure backoff limits, seconds
+	constexpr std::int64_t history_min_retry_delay = 30;
+	constexpr std::int64_t history_max_retry_delay = 3600;
+
+
+	/// Get the current time, seconds since epoch
+	std::int64_t history_sink_get_time()
+	{
+		return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+}
+
+
+
+hz::ExpectedValue<std::string, StorageHistorySinkError> storage_history_chunk_encode(
+		const std::string& host, const std::vector<StorageHistoryChunkRow>& rows)
+{
+	nlohmann::json series = nlohmann::json::array();
+	nlohmann::json series_index = nlohmann::json::array();
+	nlohmann::json time_delta = nlohmann::json::array();
+	nlohmann::json value = nlohmann::json::array();
+
+	// Rows of the same series usually follow each other, so the lookup is rarely needed.
+	std::map<std::pair<std::string_view, std::string_view>, std::size_t> series_indices;
+	std::size_t last_index = 0;
+	std::int64_t last_time = 0;
+	for (const auto& row : rows) {
+		std::size_t index = last_index;
+		if (series.empty() || series[last_index][0] != row.serial || series[last_index][1] != row.key) {
+			auto [iter, inserted] = series_indices.try_emplace({row.serial, row.key}, series.size());
+			if (inserted) {
+				series.push_back({row.serial, row.key});
+			}
+			index = iter->second;
+		}
+		series_index.push_back(index);
+		time_delta.push_back(row.point.time - last_time);
+		value.push_back(row.point.value);
+		last_index = index;
+		last_time = row.point.time;
+	}
+
+	nlohmann::json doc;
+	doc["format_version"] = history_sink_format_version;
+	doc["host"] = host;
+	doc["series"] = std::move(series);
+	doc["series_index"] = std::move(series_index);
+	doc["time_delta"] = std::move(time_delta);
+	doc["value"] = std::move(value);
+
+	auto compressed = storage_output_compress(doc.dump(), StorageOutputCompression::Gzip);
+	if (!compressed) {
+		return hz::Unexpected(StorageHistorySinkError::InvalidChunk, compressed.error().message());
+	}
+	return std::move(compressed.value());
+}
+
+
+
+hz::ExpectedValue<std::vector<StorageHistoryChunkRow>, StorageHistorySinkError> storage_history_chunk_decode(
+		std::string_view data)
+{
+	auto json_str = storage_output_decompress(data, history_chunk_max_size);
+	if (!json_str) {
+		return hz::Unexpected(StorageHistorySinkError::InvalidChunk, json_str.error().message());
+	}
+	const nlohmann::json doc = nlohmann::json::parse(json_str.value(), nullptr, false);
+	if (!doc.is_object() || doc.value("format_version", 0) != history_sink_format_version) {
+		return hz::Unexpected(StorageHistorySinkError::InvalidChunk, _("Unsupported history chunk format."));
+	}
+
+	std::vector<StorageHistoryChunkRow> rows;
+	try {
+		const auto& series = doc.at("series");
+		const auto& series_index = doc.at("series_index");
+		const auto& time_delta = doc.at("time_delta");
+		const auto& value = doc.at("value");
+		if (series_index.size() != time_delta.size() || series_index.size() != value.size()) {
+			return hz::Unexpected(StorageHistorySinkError::InvalidChunk, _("History chunk columns have different sizes."));
+		}
+		std::int64_t time = 0;
+		rows.reserve(series_index.size());
+		for (std::size_t i = 0; i < series_index.size(); ++i) {
+			const auto& s = series.at(series_index[i].get<std::size_t>());
+			time += time_delta[i].get<std::int64_t>();
+			rows.push_back({s.at(0).get<std::string>(), s.at(1).get<std::string>(), {time, value[i].get<std::int64_t>()}});
+		}
+	}
+	catch (const nlohmann::json::exception& e) {
+		return hz::Unexpected(StorageHistorySinkError::InvalidChunk,
+				fmt::format(fmt::runtime(_("Invalid history chunk: {}")), e.what()));
+	}
+	return rows;
+}
+
+
+
+StorageHistorySinkSettings StorageHistorySinkSettings::get_from_config()
+{
+	StorageHistorySinkSettings settings;
+	settings.url = rconfig::get_data<std::string>("system/history_sink_url");
+	settings.curl_binary = rconfig::get_data<std::string>("system/curl_binary");
+	settings.host = Glib::get_host_name();
+	const auto spool_dir = rconfig::get_data<std::string>("system/history_sink_spool_dir");
+	settings.spool_dir = spool_dir.empty() ? get_default_spool_dir() : hz::fs_path_from_string(spool_dir);
+	settings.max_chunk_points = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/history_sink_max_chunk_points")));
+	settings.max_chunk_interval = std::max(0, rconfig::get_data<int>("system/history_sink_max_chunk_interval_sec"));
+	settings.max_upload_rate = static_cast<std::uintmax_t>(std::max(0, rconfig::get_data<int>("system/history_sink_max_upload_rate")));
+	settings.max_spool_size = static_cast<std::uintmax_t>(std::max(0, rconfig::get_data<int>("system/history_sink_max_spool_size_mb")))
+			* 1024UL * 1024UL;
+	return settings;
+}
+
+
+
+hz::fs::path StorageHistorySinkSettings::get_default_spool_dir()
+{
+	return hz::fs_get_user_config_dir() / "gsmartcontrol" / "history_spool";
+}
+
+
+
+StorageHistorySink::StorageHistorySink(std::shared_ptr<const StorageHistory> history, StorageHistorySinkSettings settings)
+		: history_(std::move(history)), settings_(std::move(settings))
+{ }
+
+
+
+StorageHistorySink::~StorageHistorySink()
+{
+	stop();
+}
+
+
+
+hz::ExpectedVoid<StorageHistorySinkError> StorageHistorySink::open()
+{
+	const std::scoped_lock lock(mutex_);
+
+	std::error_code ec;
+	hz::fs::create_directories(settings_.spool_dir, ec);
+	if (ec) {
+		return hz::Unexpected(StorageHistorySinkError::SpoolError,
+				fmt::format(fmt::runtime(_("Cannot create directory \"{}\": {}")), hz::fs_path_to_string(settings_.spool_dir), ec.message()));
+	}
+
+	std::string json_str;
+	if (!hz::fs_file_get_contents(get_state_file(), json_str, history_chunk_max_size)) {
+		const nlohmann::json doc = nlohmann::json::parse(json_str, nullptr, false);
+		if (!doc.is_object() || doc.value("format_version", 0) != history_sink_format_version) {
+			return hz::Unexpected(StorageHistorySinkError::SpoolError,
+					fmt::format(fmt::runtime(_("Unsupported history sink state in \"{}\".")), hz::fs_path_to_string(get_state_file())));
+		}
+		try {
+			next_chunk_number_ = doc.at("next_chunk").get<std::uint64_t>();
+			for (const auto& [serial, keys] : doc.at("cursor").items()) {
+				auto& drive_cursor = cursor_[serial];
+				for (const auto& [key, count] : keys.items()) {
+					drive_cursor[key] = count.get<std::size_t>();
+				}
+			}
+		}
+		catch (const nlohmann::json::exception& e) {
+			return hz::Unexpected(StorageHistorySinkError::SpoolError,
+					fmt::format(fmt::runtime(_("Invalid history sink state in \"{}\": {}")), hz::fs_path_to_string(get_state_file()), e.what()));
+		}
+	}
+
+	// Never overwrite a chunk waiting for upload (e.g. if the state file was removed)
+	if (const auto chunks = get_spooled_chunks(); !chunks.empty()) {
+		std::string name = hz::fs_path_to_string(chunks.back().filename());
+		name.resize(name.size() - history_chunk_suffix.size());
+		std::uint64_t number = 0;
+		if (hz::string_is_numeric_nolocale(name, number, true, 10)) {
+			next_chunk_number_ = std::max(next_chunk_number_, number + 1);
+		}
+	}
+	return {};
+}
+
+
+
+void StorageHistorySink::start(std::chrono::seconds poll_interval)
+{
+	const std::scoped_lock lock(thread_mutex_);
+	if (thread_.joinable()) {
+		return;
+	}
+	stop_requested_ = false;
+	thread_ = std::thread([this, poll_interval]() {
+		// The upload command attaches to this, not to the main loop.
+		GMainContext* context = g_main_context_new();
+		g_main_context_push_thread_default(context);
+
+		std::unique_lock thread_lock(thread_mutex_);
+		while (!stop_requested_) {
+			thread_lock.unlock();
+			const std::int64_t now = history_sink_get_time();
+			if (auto status = collect(now); !status) {
+				debug_out_warn("app", DBG_FUNC_MSG << "Cannot spool the history: " << status.error().message() << "\n");
+			}
+			if (auto status = upload(now); !status) {
+				debug_out_warn("app", DBG_FUNC_MSG << status.error().message() << "\n");
+			}
+			thread_lock.lock();
+			thread_cond_.wait_for(thread_lock, poll_interval, [this]() { return stop_requested_; });
+		}
+		thread_lock.unlock();
+
+		g_main_context_pop_thread_default(context);
+		g_main_context_unref(context);
+	});
+}
+
+
+
+void StorageHistorySink::stop()
+{
+	{
+		std::unique_lock lock(thread_mutex_);
+		if (!thread_.joinable()) {
+			return;
+		}
+		stop_requested_ = true;
+		thread_cond_.notify_all();
+		lock.unlock();
+		thread_.join();
+	}
+	// Spool what was read, it's uploaded on the next start.
+	if (auto status = collect(history_sink_get_time(), true); !status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot spool the history: " << status.error().message() << "\n");
+	}
+}
+
+
+
+hz::ExpectedVoid<StorageHistorySinkError> StorageHistorySink::collect(std::int64_t now, bool force)
+{
+	const std::scoped_lock lock(mutex_);
+
+	const std::size_t old_size = pending_.size();
+	history_->for_each_new_point(cursor_, [this](const std::string& serial, const std::string& key, const StorageHistoryPoint& point) {
+		pending_.push_back({serial, key, point});
+	});
+	if (old_size == 0 && !pending_.empty()) {
+		pending_since_ = now;
+	}
+
+	if (!pending_.empty() && (force || pending_.size() >= settings_.max_chunk_points
+			|| now - pending_since_ >= settings_.max_chunk_interval)) {
+		return write_chunk();
+	}
+	return {};
+}
+
+
+
+hz::ExpectedVoid<StorageHistorySinkError> StorageHistorySink::upload(std::int64_t now)
+{
+	if (settings_.url.empty()) {
+		return {};
+	}
+	const std::scoped_lock upload_lock(upload_mutex_);
+
+	for (const auto& file : get_spooled_chunks()) {
+		{
+			const std::scoped_lock lock(mutex_);
+			if (now < next_upload_time_) {
+				break;
+			}
+		}
+
+		std::error_code ec;
+		const std::uintmax_t size = hz::fs::file_size(file, ec);
+
+		std::vector<std::string> args = {"--silent", "--show-error", "--fail", "--max-time", "300",
+				"--header", "Content-Type: application/json", "--header", "Content-Encoding: gzip",
+				"--data-binary", "@" + hz::fs_path_to_string(file)};
+		if (settings_.max_upload_rate > 0) {
+			// Smooths the bursts; the pause after each chunk keeps the average rate.
+			args.insert(args.end(), {"--limit-rate", hz::number_to_string_nolocale(settings_.max_upload_rate)});
+		}
+		args.push_back(settings_.url);
+
+		CommandExecutor ex(settings_.curl_binary, args);
+		if (!ex.execute() || !ex.get_error_msg().empty()) {
+			const std::scoped_lock lock(mutex_);
+			retry_delay_ = std::clamp(retry_delay_ * 2, history_min_retry_delay, history_max_retry_delay);
+			next_upload_time_ = now + retry_delay_;
+			return hz::Unexpected(StorageHistorySinkError::UploadError,
+					fmt::format(fmt::runtime(_("Cannot upload \"{}\", retrying in {} seconds: {}")),
+					hz::fs_path_to_string(file), retry_delay_, ex.get_error_msg()));
+		}
+
+		hz::fs::remove(file, ec);
+		debug_out_dump("app", DBG_FUNC_MSG << "Uploaded history chunk " << file << ", " << size << " bytes.\n");
+
+		const std::scoped_lock lock(mutex_);
+		retry_delay_ = 0;
+		if (settings_.max_upload_rate > 0) {
+			next_upload_time_ = now + static_cast<std::int64_t>((size + settings_.max_upload_rate - 1) / settings_.max_upload_rate);
+		}
+	}
+	return {};
+}
+
+
+
+std::vector<hz::fs::path> StorageHistorySink::get_spooled_chunks() const
+{
+	std::vector<hz::fs::path> files;
+	std::error_code ec;
+	for (const auto& entry : hz::fs::directory_iterator(settings_.spool_dir, ec)) {
+		if (hz::fs_path_to_string(entry.path().filename()).ends_with(history_chunk_suffix)) {
+			files.push_back(entry.path());
+		}
+	}
+	std::sort(files.begin(), files.end());  // the numbers are zero-padded
+	return files;
+}
+
+
+
+hz::ExpectedVoid<StorageHistorySinkError> StorageHistorySink::write_chunk()
+{
+	auto chunk = storage_history_chunk_encode(settings_.host, pending_);
+	if (!chunk) {
+		return hz::Unexpected(chunk.error().data(), chunk.error().message());
+	}
+
+	const hz::fs::path file = settings_.spool_dir
+			/ hz::fs_path_from_string(fmt::format("{:012}{}", next_chunk_number_, history_chunk_suffix));
+	if (auto ec = hz::fs_file_put_contents_atomic(file, chunk.value())) {
+		return hz::Unexpected(StorageHistorySinkError::SpoolError,
+				fmt::format(fmt::runtime(_("Cannot write \"{}\": {}")), hz::fs_path_to_string(file), ec.message()));
+	}
+	++next_chunk_number_;
+
+	// Written after the chunk, so a crash in between resends the rows rather than losing them.
+	nlohmann::json doc;
+	doc["format_version"] = history_sink_format_version;
+	doc["next_chunk"] = next_chunk_number_;
+	nlohmann::json& cursor = doc["cursor"] = nlohmann::json::object();
+	for (const auto& [serial, keys] : cursor_) {
+		nlohmann::json& drive_cursor = cursor[serial] = nlohmann::json::object();
+		for (const auto& [key, count] : keys) {
+			drive_cursor[key] = count;
+		}
+	}
+	if (auto ec = hz::fs_file_put_contents_atomic(get_state_file(), doc.dump())) {
+		return hz::Unexpected(StorageHistorySinkError::SpoolError,
+				fmt::format(fmt::runtime(_("Cannot write \"{}\": {}")), hz::fs_path_to_string(get_state_file()), ec.message()));
+	}
+
+	debug_out_info("app", DBG_FUNC_MSG << "Spooled " << pending_.size() << " history points to " << file << ".\n");
+	pending_.clear();
+	trim_spool();
+	return {};
+}
+
+
+
+void StorageHistorySink::trim_spool()
+{
+	if (settings_.max_spool_size == 0) {
+		return;
+	}
+	const auto files = get_spooled_chunks();
+	std::vector<std::uintmax_t> sizes;
+	std::uintmax_t total_size = 0;
+	for (const auto& file : files) {
+		std::error_code ec;
+		sizes.push_back(hz::fs::file_size(file, ec));
+		total_size += sizes.back();
+	}
+	// Keep the newest one even if it's too large by itself
+	for (std::size_t i = 0; i + 1 < files.size() && total_size > settings_.max_spool_size; ++i) {
+		debug_out_warn("app", DBG_FUNC_MSG << "History spool is full, dropping " << files[i] << ".\n");
+		std::error_code ec;
+		hz::fs::remove(files[i], ec);
+		total_size -= sizes[i];
+	}
+}
+
+
+
+hz::fs::path StorageHistorySink::get_state_file() const
+{
+	return settings_.spool_dir / "state.json";
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,181 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_HISTORY_SINK_H
+#define STORAGE_HISTORY_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "hz/error_container.h"
+#include "hz/fs.h"
+
+#include "storage_history.h"
+
+
+
+/// Errors of the history sink
+enum class StorageHistorySinkError {
+	SpoolError,  ///< Cannot read or write the spool directory
+	UploadError,  ///< The upload command failed
+	InvalidChunk,  ///< Not a chunk, or written by a different format version
+};
+
+
+
+/// A change point of a history series, as stored in a chunk
+struct StorageHistoryChunkRow {
+	std::string serial;  ///< Drive serial number
+	std::string key;  ///< Series key
+	StorageHistoryPoint point;  ///< Change point
+};
+
+
+
+/// Encode the rows as a gzip-compressed columnar JSON chunk:
+/// {"format_version": 1, "host": host, "series": [[serial, key], ...],
+/// "series_index": [...], "time_delta": [...], "value": [...]}.
+/// Each row is an index into "series", its time as a delta from the previous row's
+/// time (the first one from 0), and its value.
+[[nodiscard]] hz::ExpectedValue<std::string, StorageHistorySinkError> storage_history_chunk_encode(
+		const std::string& host, const std::vector<StorageHistoryChunkRow>& rows);
+
+
+/// Decode a chunk written by storage_history_chunk_encode()
+[[nodiscard]] hz::ExpectedValue<std::vector<StorageHistoryChunkRow>, StorageHistorySinkError> storage_history_chunk_decode(
+		std::string_view data);
+
+
+
+/// History sink settings
+struct StorageHistorySinkSettings {
+	std::string url;  ///< URL to POST the chunks to (using curl). Empty to only spool them.
+	std::string curl_binary = "curl";  ///< curl binary
+	std::string host;  ///< Host name written to the chunks
+	hz::fs::path spool_dir;  ///< Directory of the chunks waiting for upload, and of the read position
+	std::size_t max_chunk_points = 10000;  ///< A chunk is written when it has this many points...
+	std::int64_t max_chunk_interval = 3600;  ///< ...or its first point was read this many seconds ago
+	std::uintmax_t max_upload_rate = 16384;  ///< Average upload rate limit, bytes per second. 0 means unlimited.
+	std::uintmax_t max_spool_size = 64UL * 1024UL * 1024UL;  ///< The oldest chunks are dropped above this size. 0 means unlimited.
+
+	/// Load the settings from the config ("system/history_sink_*")
+	[[nodiscard]] static StorageHistorySinkSettings get_from_config();
+
+	/// Get the default spool directory ("$HOME/.config/gsmartcontrol/history_spool" in UNIX).
+	[[nodiscard]] static hz::fs::path get_default_spool_dir();
+};
+
+
+
+/// Replicates a history store to a central collector. The new change points are read from
+/// the store (see StorageHistory::for_each_new_point(), only the points added since the previous
+/// read are visited), and batched into compressed columnar chunks (see storage_history_chunk_encode()).
+/// A chunk is written to the spool directory once it's large or old enough, together with the read
+/// position, so after a restart the reading resumes where the last chunk ended. The spooled chunks
+/// are uploaded oldest first, each with a single curl POST. The uploads are spaced so that the average
+/// rate stays under the limit, and back off exponentially on failure; a failed chunk stays in the spool.
+/// Delivery is at-least-once: a chunk may be re-sent after a crash, the collector should deduplicate
+/// the rows by (serial, key, time).
+/// All the functions are thread-safe.
+class StorageHistorySink {
+	public:
+
+		/// Constructor. Call open() afterwards.
+		StorageHistorySink(std::shared_ptr<const StorageHistory> history, StorageHistorySinkSettings settings);
+
+		/// Deleted
+		StorageHistorySink(const StorageHistorySink& other) = delete;
+
+		/// Deleted
+		StorageHistorySink(StorageHistorySink&& other) = delete;
+
+		/// Deleted
+		StorageHistorySink& operator=(const StorageHistorySink& other) = delete;
+
+		/// Deleted
+		StorageHistorySink& operator=(StorageHistorySink&& other) = delete;
+
+		/// Destructor, calls stop()
+		~StorageHistorySink();
+
+
+		/// Create the spool directory and load the read position from it
+		[[nodiscard]] hz::ExpectedVoid<StorageHistorySinkError> open();
+
+
+		/// Start a thread which calls collect() and upload() every \c poll_interval
+		void start(std::chrono::seconds poll_interval);
+
+		/// Stop the thread (waiting for the running upload) and spool the points read so far
+		void stop();
+
+
+		/// Read the new points from the store, and write them to a chunk if it's due at \c now
+		/// (seconds since epoch) or \c force is true.
+		hz::ExpectedVoid<StorageHistorySinkError> collect(std::int64_t now, bool force = false);
+
+
+		/// Upload the spooled chunks which the rate limit and failure backoff allow at \c now.
+		/// Does nothing if no URL is set.
+		hz::ExpectedVoid<StorageHistorySinkError> upload(std::int64_t now);
+
+
+		/// Get the spooled chunk files, oldest first
+		[[nodiscard]] std::vector<hz::fs::path> get_spooled_chunks() const;
+
+
+	private:
+
+		/// Write the pending rows to a new chunk and save the read position
+		hz::ExpectedVoid<StorageHistorySinkError> write_chunk();
+
+		/// Drop the oldest chunks if the spool is too large
+		void trim_spool();
+
+		/// Get the read position file
+		[[nodiscard]] hz::fs::path get_state_file() const;
+
+
+		std::shared_ptr<const StorageHistory> history_;  ///< History store
+		StorageHistorySinkSettings settings_;  ///< Settings
+
+		mutable std::mutex mutex_;  ///< Protects the members below
+		StorageHistoryCursor cursor_;  ///< Read position after the pending rows (saved with each chunk)
+		std::vector<StorageHistoryChunkRow> pending_;  ///< Rows read, but not spooled yet
+		std::int64_t pending_since_ = 0;  ///< When the first pending row was read
+		std::uint64_t next_chunk_number_ = 1;  ///< Number of the next chunk file
+		std::int64_t next_upload_time_ = 0;  ///< Uploads wait until this time (rate limit / backoff)
+		std::int64_t retry_delay_ = 0;  ///< Current failure backoff, seconds
+
+		std::mutex upload_mutex_;  ///< Serializes upload() calls, so that a chunk isn't sent twice at the same time
+
+		std::mutex thread_mutex_;  ///< Protects the members below
+		std::condition_variable thread_cond_;  ///< Wakes up the thread on stop
+		bool stop_requested_ = false;  ///< Stop request for the thread
+		std::thread thread_;  ///< Collection / upload thread
+
+};
+
+
+
+
+
+#endif
+
+/// @}
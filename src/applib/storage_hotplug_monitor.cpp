@@ -0,0 +1,199 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "build_config.h"
+
+#include <array>
+#include <map>
+
+#ifdef CONFIG_KERNEL_LINUX
+	#include <sys/socket.h>
+	#include <linux/netlink.h>
+	#include <unistd.h>  // close()
+	#include <cerrno>
+	#include <cstring>  // std::strerror
+#endif
+
+#include "hz/debug.h"
+
+#include "storage_hotplug_monitor.h"
+
+
+
+StorageHotplugMonitor::~StorageHotplugMonitor()
+{
+	stop();
+}
+
+
+
+bool StorageHotplugMonitor::start()
+{
+#ifdef CONFIG_KERNEL_LINUX
+	if (is_running()) {
+		return true;
+	}
+
+	fd_ = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+	if (fd_ < 0) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot create netlink socket: " << std::strerror(errno) << "\n");
+		return false;
+	}
+
+	sockaddr_nl addr = {};
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = 1;  // kernel uevents (udev rebroadcasts use group 2 and a different format)
+	if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot bind netlink socket: " << std::strerror(errno) << "\n");
+		::close(fd_);
+		fd_ = -1;
+		return false;
+	}
+
+	channel_ = g_io_channel_unix_new(fd_);
+	g_io_channel_set_encoding(channel_, nullptr, nullptr);  // binary IO
+
+	main_context_ = g_main_context_ref_thread_default();
+	GSource* source = g_io_create_watch(channel_, GIOCondition(G_IO_IN | G_IO_ERR | G_IO_HUP));
+	g_source_set_callback(source, reinterpret_cast<GSourceFunc>(reinterpret_cast<void (*)()>(&on_channel_io)), this, nullptr);
+	watch_id_ = g_source_attach(source, main_context_);
+	g_source_unref(source);
+
+	debug_out_info("app", DBG_FUNC_MSG << "Listening to block device hotplug events.\n");
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+void StorageHotplugMonitor::stop()
+{
+	if (watch_id_ != 0) {
+		GSource* source = g_main_context_find_source_by_id(main_context_, watch_id_);
+		if (source)
+			g_source_destroy(source);
+		watch_id_ = 0;
+	}
+	if (main_context_) {
+		g_main_context_unref(main_context_);
+		main_context_ = nullptr;
+	}
+	if (channel_) {
+		g_io_channel_unref(channel_);
+		channel_ = nullptr;
+	}
+#ifdef CONFIG_KERNEL_LINUX
+	if (fd_ >= 0) {
+		::close(fd_);
+	}
+#endif
+	fd_ = -1;
+}
+
+
+
+bool StorageHotplugMonitor::is_running() const
+{
+	return fd_ >= 0;
+}
+
+
+
+std::optional<StorageHotplugEvent> StorageHotplugMonitor::parse_uevent(std::string_view message)
+{
+	// The message is "action@devpath\0KEY=value\0KEY=value\0...".
+	std::map<std::string_view, std::string_view> values;
+	while (!message.empty()) {
+		const std::string_view::size_type end = message.find('\0');
+		const std::string_view entry = message.substr(0, end);
+		const std::string_view::size_type eq_pos = entry.find('=');
+		if (eq_pos != std::string_view::npos) {
+			values.emplace(entry.substr(0, eq_pos), entry.substr(eq_pos + 1));
+		}
+		if (end == std::string_view::npos) {
+			break;
+		}
+		message.remove_prefix(end + 1);
+	}
+
+	auto get_value = [&values](std::string_view key)
+	{
+		auto iter = values.find(key);
+		return iter != values.end() ? iter->second : std::string_view();
+	};
+
+	if (get_value("SUBSYSTEM") != "block" || get_value("DEVTYPE") != "disk" || get_value("DEVNAME").empty()) {
+		return std::nullopt;
+	}
+
+	StorageHotplugEvent event;
+	const std::string_view action = get_value("ACTION");
+	if (action == "add") {
+		event.action = StorageHotplugEvent::Action::Add;
+	} else if (action == "remove") {
+		event.action = StorageHotplugEvent::Action::Remove;
+	} else {
+		return std::nullopt;
+	}
+
+	// DEVNAME is relative to /dev, unless udev rewrote it.
+	const std::string_view name = get_value("DEVNAME");
+	event.device = (name.front() == '/' ? std::string(name) : "/dev/" + std::string(name));
+	return event;
+}
+
+
+
+sigc::signal<void, const StorageHotplugEvent&>& StorageHotplugMonitor::signal_event()
+{
+	return signal_event_;
+}
+
+
+
+void StorageHotplugMonitor::on_socket_readable()
+{
+#ifdef CONFIG_KERNEL_LINUX
+	std::array<char, 8192> buffer = {};
+	while (fd_ >= 0) {
+		const ssize_t len = ::recv(fd_, buffer.data(), buffer.size(), 0);
+		if (len <= 0) {
+			break;  // EAGAIN (no more messages) or error
+		}
+		if (auto event = parse_uevent(std::string_view(buffer.data(), static_cast<std::size_t>(len)))) {
+			debug_out_dump("app", DBG_FUNC_MSG << "Hotplug event: "
+					<< (event->action == StorageHotplugEvent::Action::Add ? "add " : "remove ") << event->device << "\n");
+			signal_event_.emit(event.value());
+		}
+	}
+#endif
+}
+
+
+
+gboolean StorageHotplugMonitor::on_channel_io([[maybe_unused]] GIOChannel* source, GIOCondition cond, gpointer data)
+{
+	auto* self = static_cast<StorageHotplugMonitor*>(data);
+	if (cond & (G_IO_ERR | G_IO_HUP)) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Netlink socket error, no more hotplug events will be received.\n");
+		self->watch_id_ = 0;  // removed by returning false
+		return FALSE;
+	}
+	self->on_socket_readable();
+	return TRUE;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,106 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_HOTPLUG_MONITOR_H
+#define STORAGE_HOTPLUG_MONITOR_H
+
+#include <glib.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sigc++/sigc++.h>
+
+
+
+/// Disk-level hotplug event
+struct StorageHotplugEvent {
+
+	/// Event type
+	enum class Action {
+		Add,  ///< A disk has appeared
+		Remove,  ///< A disk has disappeared
+	};
+
+	Action action = Action::Add;  ///< Event type
+	std::string device;  ///< Device file, e.g. "/dev/sdb"
+};
+
+
+
+/// Listens to kernel uevents of the "block" subsystem (Linux only) and reports
+/// whole-disk add / remove events. Partition and "change" events are ignored.
+/// The socket is watched by the thread-default main context of the thread calling start().
+class StorageHotplugMonitor {
+	public:
+
+		/// Constructor
+		StorageHotplugMonitor() = default;
+
+		/// Deleted
+		StorageHotplugMonitor(const StorageHotplugMonitor& other) = delete;
+
+		/// Deleted
+		StorageHotplugMonitor(StorageHotplugMonitor&& other) = delete;
+
+		/// Deleted
+		StorageHotplugMonitor& operator=(const StorageHotplugMonitor&) = delete;
+
+		/// Deleted
+		StorageHotplugMonitor& operator=(StorageHotplugMonitor&&) = delete;
+
+		/// Destructor, calls stop().
+		~StorageHotplugMonitor();
+
+
+		/// Start listening.
+		/// \return false if not supported on this platform or the netlink socket cannot be opened.
+		bool start();
+
+		/// Stop listening
+		void stop();
+
+		/// Check if start() was successful and stop() wasn't called yet
+		[[nodiscard]] bool is_running() const;
+
+
+		/// Parse a kernel uevent message ("key=value" strings separated by NUL characters).
+		/// \return nullopt if it's not a whole-disk add / remove event.
+		[[nodiscard]] static std::optional<StorageHotplugEvent> parse_uevent(std::string_view message);
+
+
+		/// Emitted in the main context for each whole-disk add / remove event
+		[[nodiscard]] sigc::signal<void, const StorageHotplugEvent&>& signal_event();
+
+
+	private:
+
+		/// Read and dispatch all pending messages. Called when the socket is readable.
+		void on_socket_readable();
+
+		/// Socket watch callback
+		static gboolean on_channel_io(GIOChannel* source, GIOCondition cond, gpointer data);
+
+
+		int fd_ = -1;  ///< Netlink socket
+		GIOChannel* channel_ = nullptr;  ///< Channel of fd_
+		guint watch_id_ = 0;  ///< Watch source of channel_
+		GMainContext* main_context_ = nullptr;  ///< Context the watch is attached to
+
+		sigc::signal<void, const StorageHotplugEvent&> signal_event_;  ///< Event signal
+
+};
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,271 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <utility>
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+
+#include "storage_hwmon_temperature.h"
+
+
+
+namespace {
+
+	/// Maximum time between the samples written to the history store, seconds.
+	/// This way the graph extends to the current time even if the temperature doesn't change.
+	constexpr std::int64_t hwmon_history_max_interval = 10 * 60;
+
+
+	/// Find the "hwmonN" directory with a matching "name" in \c dir, or in its "hwmon" subdirectory.
+	/// \return its temp1_input file.
+	std::optional<hz::fs::path> hwmon_find_input_in(const hz::fs::path& dir, std::string_view driver_name)
+	{
+		for (const auto& parent : {dir, dir / "hwmon"}) {
+			std::error_code ec;
+			for (const auto& entry : hz::fs::directory_iterator(parent, ec)) {
+				if (!hz::fs_path_to_string(entry.path().filename()).starts_with("hwmon")) {
+					continue;
+				}
+				std::string name;
+				if (hz::fs_file_get_contents_unseekable(entry.path() / "name", name)
+						|| hz::string_trim_copy(name) != driver_name) {
+					continue;
+				}
+				std::error_code input_ec;
+				if (hz::fs::exists(entry.path() / "temp1_input", input_ec)) {
+					return entry.path() / "temp1_input";
+				}
+			}
+		}
+		return std::nullopt;
+	}
+
+
+	/// Current time, seconds since epoch
+	std::int64_t hwmon_get_current_time()
+	{
+		const auto now = std::chrono::system_clock::now();
+		return std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+	}
+
+
+	/// Global monitor. Main thread only.
+	std::shared_ptr<StorageHwmonTemperatureMonitor>& hwmon_get_global_ref()
+	{
+		static std::shared_ptr<StorageHwmonTemperatureMonitor> monitor;
+		return monitor;
+	}
+
+}
+
+
+
+std::optional<hz::fs::path> storage_hwmon_find_temperature_input(const hz::fs::path& sysfs_dir, const std::string& device)
+{
+	const std::string name = hz::fs_path_to_string(hz::fs_path_from_string(device).filename());
+	if (sysfs_dir.empty() || !device.starts_with("/dev/") || name.empty()) {
+		return std::nullopt;
+	}
+
+	// The drivetemp hwmon device is a child of the SCSI device of the disk
+	if (name.starts_with("sd")) {
+		return hwmon_find_input_in(sysfs_dir / "block" / name / "device", "drivetemp");
+	}
+
+	// The nvme hwmon device is a child of the controller (older kernels: of its PCI device).
+	// Drop the namespace part of "nvme0n1".
+	if (name.starts_with("nvme")) {
+		std::string controller = name;
+		if (const auto ns_pos = controller.find('n', std::string_view("nvme").size()); ns_pos != std::string::npos) {
+			controller.erase(ns_pos);
+		}
+		const hz::fs::path controller_dir = sysfs_dir / "class" / "nvme" / controller;
+		if (auto input = hwmon_find_input_in(controller_dir, "nvme")) {
+			return input;
+		}
+		return hwmon_find_input_in(controller_dir / "device", "nvme");
+	}
+
+	return std::nullopt;
+}
+
+
+
+std::optional<std::int64_t> storage_hwmon_read_temperature(const hz::fs::path& input_file)
+{
+	std::string contents;
+	if (hz::fs_file_get_contents_unseekable(input_file, contents)) {
+		return std::nullopt;  // e.g. ENODATA if the drive cannot report it now
+	}
+	std::int64_t millidegrees = 0;
+	if (!hz::string_is_numeric_nolocale(hz::string_trim_copy(contents), millidegrees, true)) {
+		return std::nullopt;
+	}
+	const std::int64_t celsius = (millidegrees >= 0 ? millidegrees + 500 : millidegrees - 500) / 1000;
+	if (celsius < -100 || celsius > 200) {
+		return std::nullopt;  // garbage
+	}
+	return celsius;
+}
+
+
+
+StorageHwmonTemperatureMonitor::StorageHwmonTemperatureMonitor(hz::fs::path sysfs_dir)
+		: sysfs_dir_(std::move(sysfs_dir))
+{ }
+
+
+
+StorageHwmonTemperatureMonitor::~StorageHwmonTemperatureMonitor()
+{
+	stop();
+}
+
+
+
+bool StorageHwmonTemperatureMonitor::start(std::chrono::seconds interval, drives_slot_t drives_slot)
+{
+	stop();
+	if (interval.count() <= 0) {
+		return false;
+	}
+	drives_slot_ = std::move(drives_slot);
+	timeout_id_ = g_timeout_add_seconds(static_cast<guint>(interval.count()), &StorageHwmonTemperatureMonitor::on_timeout, this);
+	return true;
+}
+
+
+
+void StorageHwmonTemperatureMonitor::stop()
+{
+	if (timeout_id_ != 0) {
+		g_source_remove(timeout_id_);
+		timeout_id_ = 0;
+	}
+	drives_slot_ = {};
+}
+
+
+
+void StorageHwmonTemperatureMonitor::sample(const std::vector<StorageDevicePtr>& drives)
+{
+	const std::int64_t now = hwmon_get_current_time();
+	const auto history = storage_history_get_global();
+
+	for (const auto& drive : drives) {
+		if (!drive || !get_drive_supported(*drive) || drive->get_in_standby()) {
+			continue;
+		}
+		auto [iter, inserted] = entries_.try_emplace(drive->get_device());
+		Entry& entry = iter->second;
+		if (inserted) {
+			entry.input_file = storage_hwmon_find_temperature_input(sysfs_dir_, drive->get_device());
+			debug_out_dump("app", DBG_FUNC_MSG << "Hwmon temperature input of " << drive->get_device() << ": "
+					<< (entry.input_file ? hz::fs_path_to_string(*entry.input_file) : std::string("none")) << "\n");
+		}
+		if (!entry.input_file) {
+			continue;
+		}
+		const auto temperature = storage_hwmon_read_temperature(*entry.input_file);
+		if (!temperature) {
+			continue;
+		}
+		entry.last_sample = StorageHistoryPoint{now, temperature.value()};
+
+		const std::string serial = drive->get_serial_number();
+		if (history && !serial.empty() && (!entry.last_recorded || entry.last_recorded->value != temperature.value()
+				|| now - entry.last_recorded->time >= hwmon_history_max_interval)) {
+			if (auto ec = history->append(serial, now, {{storage_hwmon_history_key, temperature.value()}})) {
+				debug_out_warn("app", DBG_FUNC_MSG << "Cannot write SMART history: " << ec.message() << "\n");
+			}
+			entry.last_recorded = entry.last_sample;
+		}
+
+		signal_sampled_.emit(drive.get());
+	}
+}
+
+
+
+std::optional<StorageHistoryPoint> StorageHwmonTemperatureMonitor::get_last_sample(const StorageDevice& drive) const
+{
+	if (auto iter = entries_.find(drive.get_device()); iter != entries_.end()) {
+		return iter->second.last_sample;
+	}
+	return std::nullopt;
+}
+
+
+
+void StorageHwmonTemperatureMonitor::clear_cache()
+{
+	entries_.clear();
+}
+
+
+
+sigc::signal<void, StorageDevice*>& StorageHwmonTemperatureMonitor::signal_sampled()
+{
+	return signal_sampled_;
+}
+
+
+
+bool StorageHwmonTemperatureMonitor::get_drive_supported(const StorageDevice& drive)
+{
+	if (drive.get_is_virtual() || !drive.get_remote_host_name().empty()) {
+		return false;
+	}
+	const std::string device = drive.get_device();
+	if (!device.starts_with("/dev/sd") && !device.starts_with("/dev/nvme")) {
+		return false;
+	}
+	// Drives behind RAID controllers (-d megaraid,N, etc.) share the device file of the controller
+	static const std::array<std::string_view, 5> direct_types = {"", "auto", "sat", "ata", "nvme"};
+	const std::string type_argument = drive.get_type_argument();
+	return std::find(direct_types.begin(), direct_types.end(), type_argument) != direct_types.end();
+}
+
+
+
+gboolean StorageHwmonTemperatureMonitor::on_timeout(gpointer data)
+{
+	auto* self = static_cast<StorageHwmonTemperatureMonitor*>(data);
+	if (self->drives_slot_) {
+		self->sample(self->drives_slot_());
+	}
+	return TRUE;
+}
+
+
+
+void storage_hwmon_temperature_set_global(std::shared_ptr<StorageHwmonTemperatureMonitor> monitor)
+{
+	hwmon_get_global_ref() = std::move(monitor);
+}
+
+
+
+std::shared_ptr<StorageHwmonTemperatureMonitor> storage_hwmon_temperature_get_global()
+{
+	return hwmon_get_global_ref();
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,148 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_HWMON_TEMPERATURE_H
+#define STORAGE_HWMON_TEMPERATURE_H
+
+#include <glib.h>
+#include <sigc++/sigc++.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "hz/fs.h"
+
+#include "storage_device.h"
+#include "storage_history.h"
+
+
+
+/// History series key of the hwmon temperature samples (see StorageHistory)
+inline constexpr const char* storage_hwmon_history_key = "hwmon/temperature";
+
+
+/// Find the hwmon temperature input file of a local drive in sysfs (Linux only):
+/// "<sysfs>/block/sdX/device/hwmon/hwmonN/temp1_input" of the "drivetemp" driver for
+/// /dev/sdX, or the "nvme" hwmon node of the controller for /dev/nvmeX and /dev/nvmeXnY.
+/// \return std::nullopt if there is none (e.g. the drivetemp module is not loaded).
+[[nodiscard]] std::optional<hz::fs::path> storage_hwmon_find_temperature_input(const hz::fs::path& sysfs_dir,
+		const std::string& device);
+
+
+/// Read a hwmon temperature input file (millidegrees Celsius). \return the temperature in Celsius.
+[[nodiscard]] std::optional<std::int64_t> storage_hwmon_read_temperature(const hz::fs::path& input_file);
+
+
+
+/// Samples the temperatures of the drives through the kernel hwmon interface (drivetemp and nvme
+/// drivers), without running smartctl. That's a single sysfs file read per drive, so it can be done
+/// much more often than the smartctl refresh. The samples are recorded in the history store
+/// (storage_history_get_global()) when they change, and at least every 10 minutes otherwise.
+/// The hwmon nodes of the drives are looked up on the first sample and then cached until clear_cache().
+/// Drives in standby mode (see StorageDevice::get_in_standby()) are not sampled.
+/// This class must be used from the main thread.
+class StorageHwmonTemperatureMonitor : public sigc::trackable {
+	public:
+
+		/// Slot providing the drives to sample
+		using drives_slot_t = sigc::slot<std::vector<StorageDevicePtr>>;
+
+		/// Constructor
+		explicit StorageHwmonTemperatureMonitor(hz::fs::path sysfs_dir);
+
+		/// Deleted
+		StorageHwmonTemperatureMonitor(const StorageHwmonTemperatureMonitor& other) = delete;
+
+		/// Deleted
+		StorageHwmonTemperatureMonitor(StorageHwmonTemperatureMonitor&& other) = delete;
+
+		/// Deleted
+		StorageHwmonTemperatureMonitor& operator=(const StorageHwmonTemperatureMonitor& other) = delete;
+
+		/// Deleted
+		StorageHwmonTemperatureMonitor& operator=(StorageHwmonTemperatureMonitor&& other) = delete;
+
+		/// Destructor, calls stop().
+		~StorageHwmonTemperatureMonitor();
+
+
+		/// Sample the drives provided by \c drives_slot every \c interval in the thread-default main context.
+		/// \return false if the interval is zero.
+		bool start(std::chrono::seconds interval, drives_slot_t drives_slot);
+
+		/// Stop the periodic sampling
+		void stop();
+
+
+		/// Sample the temperatures of \c drives now. signal_sampled() is emitted for the sampled drives.
+		void sample(const std::vector<StorageDevicePtr>& drives);
+
+
+		/// Get the last temperature sample of a drive (time and Celsius).
+		/// \return std::nullopt if the drive was not sampled or has no hwmon node.
+		[[nodiscard]] std::optional<StorageHistoryPoint> get_last_sample(const StorageDevice& drive) const;
+
+
+		/// Forget the hwmon nodes of the drives (e.g. after the drives were re-scanned)
+		void clear_cache();
+
+
+		/// Emitted after a drive has been sampled
+		sigc::signal<void, StorageDevice*>& signal_sampled();
+
+
+		/// Check whether a drive may have a hwmon node: local, non-virtual /dev/sd* or /dev/nvme*
+		/// drive without a RAID controller type argument.
+		[[nodiscard]] static bool get_drive_supported(const StorageDevice& drive);
+
+
+	private:
+
+		/// Sampled data of a drive
+		struct Entry {
+			std::optional<hz::fs::path> input_file;  ///< Temperature input file, std::nullopt if none
+			std::optional<StorageHistoryPoint> last_sample;  ///< Last sample
+			std::optional<StorageHistoryPoint> last_recorded;  ///< Last sample written to the history store
+		};
+
+		/// Timeout callback
+		static gboolean on_timeout(gpointer data);
+
+
+		hz::fs::path sysfs_dir_;  ///< Sysfs mount point
+		drives_slot_t drives_slot_;  ///< See start()
+		guint timeout_id_ = 0;  ///< on_timeout() source
+		std::map<std::string, Entry> entries_;  ///< Device file -> its data
+
+		sigc::signal<void, StorageDevice*> signal_sampled_;  ///< Signal
+
+};
+
+
+
+/// Set the monitor which the GUI uses for the temperatures (nullptr to disable)
+void storage_hwmon_temperature_set_global(std::shared_ptr<StorageHwmonTemperatureMonitor> monitor);
+
+
+/// Get the monitor set by storage_hwmon_temperature_set_global(), may be nullptr.
+[[nodiscard]] std::shared_ptr<StorageHwmonTemperatureMonitor> storage_hwmon_temperature_get_global();
+
+
+
+
+
+#endif
+
+/// @}
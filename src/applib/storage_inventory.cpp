@@ -0,0 +1,204 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm/i18n.h>
+#include <algorithm>  // std::find_if, std::any_of
+#include <set>
+#include <tuple>
+
+#include "nlohmann/json.hpp"
+
+#include "hz/debug.h"
+
+#include "command_executor_remote.h"
+#include "storage_inventory.h"
+
+
+
+namespace {
+
+	/// Version of the inventory file format
+	constexpr int inventory_format_version = 1;
+
+	/// Maximum inventory file size to load
+	constexpr int inventory_max_size = 10*1024*1024;  // 10M
+
+
+	/// Get the key to match the inventory entries and the drives by
+	std::tuple<std::string, std::string, std::string> get_entry_key(const StorageInventoryEntry& entry)
+	{
+		return {entry.remote_host, entry.device, entry.type_argument};
+	}
+
+}
+
+
+
+hz::ExpectedValue<std::vector<StorageInventoryEntry>, StorageInventoryError> storage_inventory_parse(std::string_view json_str)
+{
+	const nlohmann::json doc = nlohmann::json::parse(json_str, nullptr, false);
+	if (!doc.is_object() || doc.value("format_version", 0) != inventory_format_version
+			|| !doc.contains("drives") || !doc["drives"].is_array()) {
+		return hz::Unexpected(StorageInventoryError::InvalidFormat, _("The file is not a drive inventory, or has an unsupported format version."));
+	}
+
+	std::vector<StorageInventoryEntry> entries;
+	try {
+		for (const auto& j : doc["drives"]) {
+			StorageInventoryEntry entry;
+			entry.device = j.value("device", std::string());
+			entry.type_argument = j.value("type_argument", std::string());
+			entry.extra_arguments = j.value("extra_arguments", std::vector<std::string>());
+			entry.remote_host = j.value("remote_host", std::string());
+			if (entry.device.empty()) {
+				debug_out_warn("app", DBG_FUNC_MSG << "Drive inventory entry without a device, skipping.\n");
+				continue;
+			}
+			entries.push_back(std::move(entry));
+		}
+	}
+	catch (const nlohmann::json::exception& e) {
+		return hz::Unexpected(StorageInventoryError::InvalidFormat, e.what());
+	}
+	return entries;
+}
+
+
+
+std::string storage_inventory_dump(const std::vector<StorageInventoryEntry>& entries)
+{
+	nlohmann::json doc;
+	doc["format_version"] = inventory_format_version;
+	nlohmann::json& drives_json = doc["drives"];
+	drives_json = nlohmann::json::array();
+
+	// Only the non-default values, the file is meant to be edited by hand as well
+	for (const auto& entry : entries) {
+		nlohmann::json j;
+		j["device"] = entry.device;
+		if (!entry.type_argument.empty()) {
+			j["type_argument"] = entry.type_argument;
+		}
+		if (!entry.extra_arguments.empty()) {
+			j["extra_arguments"] = entry.extra_arguments;
+		}
+		if (!entry.remote_host.empty()) {
+			j["remote_host"] = entry.remote_host;
+		}
+		drives_json.push_back(std::move(j));
+	}
+	return doc.dump(1, '\t');
+}
+
+
+
+hz::ExpectedValue<std::vector<StorageInventoryEntry>, StorageInventoryError> storage_inventory_load(const hz::fs::path& file)
+{
+	std::string contents;
+	if (auto ec = hz::fs_file_get_contents(file, contents, inventory_max_size)) {
+		return hz::Unexpected(StorageInventoryError::ReadError, ec.message());
+	}
+	return storage_inventory_parse(contents);
+}
+
+
+
+hz::ExpectedVoid<StorageInventoryError> storage_inventory_save(const hz::fs::path& file,
+		const std::vector<StorageInventoryEntry>& entries)
+{
+	if (auto ec = hz::fs_file_put_contents_atomic(file, storage_inventory_dump(entries))) {
+		return hz::Unexpected(StorageInventoryError::WriteError, ec.message());
+	}
+	return {};
+}
+
+
+
+std::vector<StorageInventoryEntry> storage_inventory_get_entries(const std::vector<StorageDevicePtr>& drives)
+{
+	std::vector<StorageInventoryEntry> entries;
+	for (const auto& drive : drives) {
+		if (!drive || drive->get_is_virtual()) {
+			continue;
+		}
+		StorageInventoryEntry entry;
+		entry.device = drive->get_device();
+		entry.type_argument = drive->get_type_argument();
+		entry.extra_arguments = drive->get_extra_arguments();
+		entry.remote_host = drive->get_remote_host_name();
+		entries.push_back(std::move(entry));
+	}
+	return entries;
+}
+
+
+
+std::vector<StorageDevicePtr> storage_inventory_create_drives(const std::vector<StorageInventoryEntry>& entries)
+{
+	// Only read the remote host configuration if needed
+	const bool has_remote = std::any_of(entries.begin(), entries.end(),
+			[](const StorageInventoryEntry& entry) { return !entry.remote_host.empty(); });
+	const std::vector<RemoteHostPtr> remote_hosts = has_remote ? remote_hosts_get_configured() : std::vector<RemoteHostPtr>();
+
+	std::vector<StorageDevicePtr> drives;
+	for (const auto& entry : entries) {
+		auto drive = std::make_shared<StorageDevice>(entry.device, entry.type_argument);
+		drive->set_extra_arguments(entry.extra_arguments);
+
+		if (!entry.remote_host.empty()) {
+			auto host_iter = std::find_if(remote_hosts.begin(), remote_hosts.end(),
+					[&entry](const RemoteHostPtr& host) { return host->get_destination() == entry.remote_host; });
+			if (host_iter == remote_hosts.end()) {
+				debug_out_warn("app", DBG_FUNC_MSG << "Remote host \"" << entry.remote_host << "\" of inventory drive "
+						<< entry.device << " is not configured, skipping.\n");
+				continue;
+			}
+			drive->set_remote_host(*host_iter);
+		}
+		drives.push_back(drive);
+	}
+	return drives;
+}
+
+
+
+StorageInventoryReconciliation storage_inventory_reconcile(const std::vector<StorageInventoryEntry>& entries,
+		const std::vector<StorageDevicePtr>& detected_drives)
+{
+	const auto detected_entries = storage_inventory_get_entries(detected_drives);  // non-virtual ones
+
+	std::set<std::tuple<std::string, std::string, std::string>> inventory_keys, detected_keys;
+	for (const auto& entry : entries) {
+		inventory_keys.insert(get_entry_key(entry));
+	}
+	for (const auto& entry : detected_entries) {
+		detected_keys.insert(get_entry_key(entry));
+	}
+
+	StorageInventoryReconciliation result;
+	for (const auto& entry : entries) {
+		if (!detected_keys.contains(get_entry_key(entry))) {
+			result.missing.push_back(entry);
+		}
+	}
+	for (const auto& drive : detected_drives) {
+		if (drive && !drive->get_is_virtual() && !inventory_keys.contains(
+				std::make_tuple(drive->get_remote_host_name(), drive->get_device(), drive->get_type_argument()))) {
+			result.unlisted.push_back(drive);
+		}
+	}
+	return result;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,107 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_INVENTORY_H
+#define STORAGE_INVENTORY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hz/error_container.h"
+#include "hz/fs.h"
+
+#include "storage_device.h"
+
+
+
+/*
+A drive inventory lists the drives of a machine with a fixed topology (device, type argument,
+extra arguments, remote host), so that they can be queried directly on startup, without the
+detection pass (and its RAID port sweeps). It's a JSON file:
+
+{
+	"format_version": 1,
+	"drives": [
+		{"device": "/dev/sda"},
+		{"device": "/dev/twa0", "type_argument": "3ware,2"},
+		{"device": "/dev/sdb", "extra_arguments": ["-T", "permissive"]}
+	]
+}
+*/
+
+
+
+/// Errors of reading and writing the drive inventory
+enum class StorageInventoryError {
+	ReadError,  ///< Cannot read the file
+	WriteError,  ///< Cannot write the file
+	InvalidFormat,  ///< Not an inventory, or an unsupported format version
+};
+
+
+
+/// A drive in the inventory
+struct StorageInventoryEntry {
+	std::string device;  ///< Device file, e.g. "/dev/sda"
+	std::string type_argument;  ///< Smartctl -d argument, may be empty
+	std::vector<std::string> extra_arguments;  ///< Additional smartctl arguments
+	std::string remote_host;  ///< Remote host destination (see RemoteHost), empty for local drives
+
+	bool operator==(const StorageInventoryEntry& other) const = default;
+};
+
+
+
+/// Result of storage_inventory_reconcile()
+struct StorageInventoryReconciliation {
+	std::vector<StorageInventoryEntry> missing;  ///< Inventory entries which were not detected
+	std::vector<StorageDevicePtr> unlisted;  ///< Detected drives which are not in the inventory
+};
+
+
+
+/// Parse the inventory JSON. The entries without a device are skipped.
+[[nodiscard]] hz::ExpectedValue<std::vector<StorageInventoryEntry>, StorageInventoryError> storage_inventory_parse(std::string_view json_str);
+
+
+/// Serialize the inventory to JSON
+[[nodiscard]] std::string storage_inventory_dump(const std::vector<StorageInventoryEntry>& entries);
+
+
+/// Load the inventory from a file
+[[nodiscard]] hz::ExpectedValue<std::vector<StorageInventoryEntry>, StorageInventoryError> storage_inventory_load(const hz::fs::path& file);
+
+
+/// Save the inventory to a file (atomically)
+[[nodiscard]] hz::ExpectedVoid<StorageInventoryError> storage_inventory_save(const hz::fs::path& file,
+		const std::vector<StorageInventoryEntry>& entries);
+
+
+/// Get the inventory entries of the drives. Virtual drives are skipped.
+[[nodiscard]] std::vector<StorageInventoryEntry> storage_inventory_get_entries(const std::vector<StorageDevicePtr>& drives);
+
+
+/// Create the (not yet fetched) drives of the inventory entries. The entries of the remote hosts
+/// which are not configured (see remote_hosts_get_configured()) are skipped.
+[[nodiscard]] std::vector<StorageDevicePtr> storage_inventory_create_drives(const std::vector<StorageInventoryEntry>& entries);
+
+
+/// Compare the inventory with the detected drives (by remote host, device and type argument)
+[[nodiscard]] StorageInventoryReconciliation storage_inventory_reconcile(const std::vector<StorageInventoryEntry>& entries,
+		const std::vector<StorageDevicePtr>& detected_drives);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,490 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glib.h>
+#include <algorithm>
+#include <utility>
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+#include "rconfig/rconfig.h"
+#include "build_config.h"
+
+#include "storage_io_load.h"
+
+
+
+namespace {
+
+	/// Minimum time between the /proc/diskstats samples
+	constexpr std::chrono::milliseconds io_load_min_sample_interval(500);
+
+
+	/// Interval of the load checks in StorageIoLoadGuard::wait_until_idle()
+	constexpr std::chrono::milliseconds io_load_wait_check_interval(500);
+
+
+	/// Timeout callback of StorageIoLoadGuard::wait_until_idle(). It only needs to wake up the loop.
+	gboolean io_load_on_wait_timeout([[maybe_unused]] gpointer data)
+	{
+		return TRUE;  // continue
+	}
+
+
+	/// Size of a /proc/diskstats sector, bytes (regardless of the device's sector size)
+	constexpr double io_diskstats_sector_size = 512.;
+
+
+	/// Global performance monitor. Main thread only.
+	std::shared_ptr<StorageIoPerformanceMonitor>& io_performance_get_global_ref()
+	{
+		static std::shared_ptr<StorageIoPerformanceMonitor> monitor;
+		return monitor;
+	}
+
+
+	/// Global guard
+	std::shared_ptr<StorageIoLoadGuard>& io_load_get_global_ref()
+	{
+		static std::shared_ptr<StorageIoLoadGuard> guard;
+		return guard;
+	}
+
+
+	/// Mutex for io_load_get_global_ref()
+	std::mutex& io_load_get_global_mutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+}
+
+
+
+StorageIoStatsMap storage_io_parse_diskstats(std::string_view contents)
+{
+	// Field indices of a line: major, minor, name, then the counters (at least 11 of them).
+	constexpr std::size_t name_index = 2, reads_index = 3, sectors_read_index = 5, read_msec_index = 6,
+			writes_index = 7, sectors_written_index = 9, write_msec_index = 10, in_flight_index = 11,
+			busy_msec_index = 12, weighted_msec_index = 13;
+
+	StorageIoStatsMap result;
+	std::vector<std::string> fields;
+	for (std::string_view line : hz::string_split_view(contents, '\n', true)) {
+		fields.clear();
+		for (std::string_view field : hz::string_split_view_by_chars(line, " \t", true)) {
+			fields.emplace_back(field);
+		}
+		if (fields.size() <= weighted_msec_index) {
+			continue;
+		}
+		std::vector<std::uint64_t> values(fields.size(), 0);
+		bool valid = true;
+		for (std::size_t i = reads_index; i < fields.size() && valid; ++i) {
+			valid = hz::string_is_numeric_nolocale(fields[i], values[i]);
+		}
+		if (!valid) {
+			continue;
+		}
+		StorageIoStats stats;
+		stats.reads_completed = values[reads_index];
+		stats.writes_completed = values[writes_index];
+		stats.sectors_read = values[sectors_read_index];
+		stats.sectors_written = values[sectors_written_index];
+		stats.io_time_msec = values[read_msec_index] + values[write_msec_index];
+		stats.in_flight = values[in_flight_index];
+		stats.busy_time_msec = values[busy_msec_index];
+		stats.weighted_io_time_msec = values[weighted_msec_index];
+		result[fields[name_index]] = stats;
+	}
+	return result;
+}
+
+
+
+std::string storage_io_get_diskstats_name(const std::string& device, bool& prefix)
+{
+	prefix = false;
+	if (!device.starts_with("/dev/")) {
+		return {};
+	}
+	std::string name = device.substr(std::string_view("/dev/").size());
+	if (name.starts_with("sd") && name.size() > 2 && name.find('/') == std::string::npos) {
+		return name;
+	}
+	if (name.starts_with("nvme") && name.find('/') == std::string::npos) {
+		// "nvme0" is the controller, "nvme0n1" a namespace
+		prefix = (name.find('n', std::string_view("nvme").size()) == std::string::npos);
+		if (prefix) {
+			name += "n";
+		}
+		return name;
+	}
+	return {};
+}
+
+
+
+std::optional<StorageIoStats> storage_io_find_stats(const StorageIoStatsMap& stats, const std::string& device)
+{
+	bool prefix = false;
+	const std::string name = storage_io_get_diskstats_name(device, prefix);
+	if (name.empty()) {
+		return std::nullopt;
+	}
+	if (!prefix) {
+		if (auto iter = stats.find(name); iter != stats.end()) {
+			return iter->second;
+		}
+		return std::nullopt;
+	}
+
+	// Sum the namespaces of the controller
+	std::optional<StorageIoStats> result;
+	for (auto iter = stats.lower_bound(name); iter != stats.end() && iter->first.starts_with(name); ++iter) {
+		if (iter->first.find('p', name.size()) != std::string::npos) {
+			continue;  // partition, e.g. "nvme0n1p1"
+		}
+		if (!result) {
+			result = StorageIoStats();
+		}
+		result->reads_completed += iter->second.reads_completed;
+		result->writes_completed += iter->second.writes_completed;
+		result->sectors_read += iter->second.sectors_read;
+		result->sectors_written += iter->second.sectors_written;
+		result->io_time_msec += iter->second.io_time_msec;
+		result->in_flight += iter->second.in_flight;
+		result->busy_time_msec = std::max(result->busy_time_msec, iter->second.busy_time_msec);  // they overlap
+		result->weighted_io_time_msec += iter->second.weighted_io_time_msec;
+	}
+	return result;
+}
+
+
+
+StorageIoLoad storage_io_compute_load(const StorageIoStats& previous, const StorageIoStats& current,
+		std::chrono::steady_clock::duration elapsed)
+{
+	StorageIoLoad load;
+	load.in_flight = current.in_flight;
+
+	// The counters may wrap or be reset (e.g. the device was re-plugged)
+	const double elapsed_msec = std::chrono::duration<double, std::milli>(elapsed).count();
+	if (elapsed_msec > 0. && current.weighted_io_time_msec >= previous.weighted_io_time_msec) {
+		load.queue_depth = double(current.weighted_io_time_msec - previous.weighted_io_time_msec) / elapsed_msec;
+	}
+	const std::uint64_t previous_ios = previous.reads_completed + previous.writes_completed;
+	const std::uint64_t current_ios = current.reads_completed + current.writes_completed;
+	if (current_ios > previous_ios && current.io_time_msec >= previous.io_time_msec) {
+		load.latency_msec = double(current.io_time_msec - previous.io_time_msec) / double(current_ios - previous_ios);
+	}
+	return load;
+}
+
+
+
+StorageIoPerformance storage_io_compute_performance(const StorageIoStats& previous, const StorageIoStats& current,
+		std::chrono::steady_clock::duration elapsed)
+{
+	StorageIoPerformance perf;
+	const double elapsed_sec = std::chrono::duration<double>(elapsed).count();
+	if (elapsed_sec <= 0.) {
+		return perf;
+	}
+
+	// The counters may wrap or be reset (e.g. the device was re-plugged), ignore the decreasing ones.
+	auto delta = [](std::uint64_t prev, std::uint64_t cur) {
+		return cur >= prev ? double(cur - prev) : 0.;
+	};
+	perf.read_iops = delta(previous.reads_completed, current.reads_completed) / elapsed_sec;
+	perf.write_iops = delta(previous.writes_completed, current.writes_completed) / elapsed_sec;
+	perf.read_bytes_per_sec = delta(previous.sectors_read, current.sectors_read) * io_diskstats_sector_size / elapsed_sec;
+	perf.write_bytes_per_sec = delta(previous.sectors_written, current.sectors_written) * io_diskstats_sector_size / elapsed_sec;
+
+	const StorageIoLoad load = storage_io_compute_load(previous, current, elapsed);
+	perf.service_time_msec = load.latency_msec;
+	perf.queue_depth = load.queue_depth;
+	perf.utilization = std::clamp(delta(previous.busy_time_msec, current.busy_time_msec) / (elapsed_sec * 1000.), 0., 1.);
+	return perf;
+}
+
+
+
+bool StorageIoLoadThresholds::get_exceeded(const StorageIoLoad& load) const
+{
+	if (max_queue_depth > 0. && std::max(double(load.in_flight), load.queue_depth) > max_queue_depth) {
+		return true;
+	}
+	return max_latency_msec > 0. && load.latency_msec.has_value() && load.latency_msec.value() > max_latency_msec;
+}
+
+
+
+StorageIoLoadGuard::StorageIoLoadGuard(hz::fs::path diskstats_file, StorageIoLoadThresholds thresholds)
+		: diskstats_file_(std::move(diskstats_file)), thresholds_(thresholds)
+{ }
+
+
+
+std::optional<StorageIoLoad> StorageIoLoadGuard::get_load(const std::string& device)
+{
+	bool prefix = false;
+	if (storage_io_get_diskstats_name(device, prefix).empty()) {
+		return std::nullopt;
+	}
+
+	const std::scoped_lock lock(mutex_);
+	update_samples();
+	if (!current_) {
+		return std::nullopt;
+	}
+
+	const auto current_stats = storage_io_find_stats(current_->stats, device);
+	if (!current_stats) {
+		return std::nullopt;
+	}
+	const auto previous_stats = (previous_ ? storage_io_find_stats(previous_->stats, device) : std::nullopt);
+	if (!previous_stats) {
+		StorageIoLoad load;
+		load.in_flight = current_stats->in_flight;
+		return load;
+	}
+	return storage_io_compute_load(*previous_stats, *current_stats, current_->time - previous_->time);
+}
+
+
+
+bool StorageIoLoadGuard::get_busy(const StorageDevice& drive)
+{
+	if (drive.get_is_virtual() || !drive.get_remote_host_name().empty()) {
+		return false;
+	}
+	const auto load = get_load(drive.get_device());
+	if (!load || !thresholds_.get_exceeded(load.value())) {
+		return false;
+	}
+	debug_out_dump("app", DBG_FUNC_MSG << drive.get_device() << " is busy: " << load->in_flight << " I/Os in flight, queue depth "
+			<< load->queue_depth << ", latency " << load->latency_msec.value_or(0.) << " ms.\n");
+	return true;
+}
+
+
+
+bool StorageIoLoadGuard::wait_until_idle(const StorageDevice& drive, std::chrono::steady_clock::duration max_wait)
+{
+	if (!get_busy(drive)) {
+		return true;
+	}
+	debug_out_info("app", DBG_FUNC_MSG << "Waiting for the I/O load of " << drive.get_device() << " to decrease...\n");
+
+	GMainContext* context = g_main_context_get_thread_default();
+	GSource* source = g_timeout_source_new(guint(io_load_wait_check_interval.count()));
+	g_source_set_callback(source, &io_load_on_wait_timeout, nullptr, nullptr);
+	g_source_attach(source, context);
+
+	const auto deadline = std::chrono::steady_clock::now() + max_wait;
+	auto next_check = std::chrono::steady_clock::now() + io_load_wait_check_interval;
+	bool idle = false;
+	while (std::chrono::steady_clock::now() < deadline) {
+		g_main_context_iteration(context, TRUE);
+		if (std::chrono::steady_clock::now() >= next_check) {
+			next_check = std::chrono::steady_clock::now() + io_load_wait_check_interval;
+			if (!get_busy(drive)) {
+				idle = true;
+				break;
+			}
+		}
+	}
+
+	g_source_destroy(source);
+	g_source_unref(source);
+
+	if (!idle) {
+		debug_out_info("app", DBG_FUNC_MSG << drive.get_device() << " is still busy, not waiting any longer.\n");
+	}
+	return idle;
+}
+
+
+
+void StorageIoLoadGuard::update_samples()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (current_ && now - current_->time < io_load_min_sample_interval) {
+		return;
+	}
+	std::string contents;
+	if (auto ec = hz::fs_file_get_contents_unseekable(diskstats_file_, contents)) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot read \"" << hz::fs_path_to_string(diskstats_file_) << "\": " << ec.message() << "\n");
+		return;
+	}
+	previous_ = std::move(current_);
+	current_ = Sample{now, storage_io_parse_diskstats(contents)};
+}
+
+
+
+StorageIoPerformanceMonitor::StorageIoPerformanceMonitor(hz::fs::path diskstats_file, std::chrono::milliseconds interval)
+		: diskstats_file_(std::move(diskstats_file)), interval_(interval)
+{ }
+
+
+
+StorageIoPerformanceMonitor::~StorageIoPerformanceMonitor()
+{
+	if (timeout_id_ != 0) {
+		g_source_remove(timeout_id_);
+	}
+}
+
+
+
+void StorageIoPerformanceMonitor::add_user()
+{
+	if (users_++ == 0 && interval_.count() > 0) {
+		sample();  // the first sample, so that the data is there after one interval
+		timeout_id_ = g_timeout_add(static_cast<guint>(interval_.count()), &StorageIoPerformanceMonitor::on_timeout, this);
+	}
+}
+
+
+
+void StorageIoPerformanceMonitor::remove_user()
+{
+	DBG_ASSERT_RETURN_NONE(users_ > 0);
+	if (--users_ == 0) {
+		if (timeout_id_ != 0) {
+			g_source_remove(timeout_id_);
+			timeout_id_ = 0;
+		}
+		// Stale samples would give averages over the idle time
+		previous_.reset();
+		current_.reset();
+	}
+}
+
+
+
+void StorageIoPerformanceMonitor::sample()
+{
+	std::string contents;
+	if (auto ec = hz::fs_file_get_contents_unseekable(diskstats_file_, contents)) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot read \"" << hz::fs_path_to_string(diskstats_file_) << "\": " << ec.message() << "\n");
+		return;
+	}
+	previous_ = std::move(current_);
+	previous_time_ = current_time_;
+	current_ = storage_io_parse_diskstats(contents);
+	current_time_ = std::chrono::steady_clock::now();
+	signal_sampled_.emit();
+}
+
+
+
+std::optional<StorageIoPerformance> StorageIoPerformanceMonitor::get_performance(const StorageDevice& drive) const
+{
+	if (!previous_ || !current_ || drive.get_is_virtual() || !drive.get_remote_host_name().empty()) {
+		return std::nullopt;
+	}
+	const auto previous_stats = storage_io_find_stats(*previous_, drive.get_device());
+	const auto current_stats = storage_io_find_stats(*current_, drive.get_device());
+	if (!previous_stats || !current_stats) {
+		return std::nullopt;
+	}
+	return storage_io_compute_performance(*previous_stats, *current_stats, current_time_ - previous_time_);
+}
+
+
+
+sigc::signal<void>& StorageIoPerformanceMonitor::signal_sampled()
+{
+	return signal_sampled_;
+}
+
+
+
+gboolean StorageIoPerformanceMonitor::on_timeout(gpointer data)
+{
+	static_cast<StorageIoPerformanceMonitor*>(data)->sample();
+	return TRUE;
+}
+
+
+
+std::shared_ptr<StorageIoPerformanceMonitor> storage_io_performance_create_from_settings()
+{
+	if constexpr(!BuildEnv::is_kernel_linux()) {
+		return nullptr;
+	}
+	const int interval_msec = rconfig::get_data<int>("gui/io_performance_interval_msec");
+	if (interval_msec <= 0) {
+		return nullptr;
+	}
+	return std::make_shared<StorageIoPerformanceMonitor>(
+			hz::fs_path_from_string(rconfig::get_data<std::string>("system/linux_proc_diskstats_path")),
+			std::chrono::milliseconds(std::max(interval_msec, 250)));
+}
+
+
+
+void storage_io_performance_set_global(std::shared_ptr<StorageIoPerformanceMonitor> monitor)
+{
+	io_performance_get_global_ref() = std::move(monitor);
+}
+
+
+
+std::shared_ptr<StorageIoPerformanceMonitor> storage_io_performance_get_global()
+{
+	return io_performance_get_global_ref();
+}
+
+
+
+std::shared_ptr<StorageIoLoadGuard> storage_io_load_guard_create_from_settings()
+{
+	if constexpr(!BuildEnv::is_kernel_linux()) {
+		return nullptr;
+	}
+	if (!rconfig::get_data<bool>("system/io_load_guard_enabled")) {
+		return nullptr;
+	}
+	StorageIoLoadThresholds thresholds;
+	thresholds.max_queue_depth = std::max(0., rconfig::get_data<double>("system/io_load_max_queue_depth"));
+	thresholds.max_latency_msec = std::max(0., rconfig::get_data<double>("system/io_load_max_latency_msec"));
+	return std::make_shared<StorageIoLoadGuard>(
+			hz::fs_path_from_string(rconfig::get_data<std::string>("system/linux_proc_diskstats_path")), thresholds);
+}
+
+
+
+void storage_io_load_guard_set_global(std::shared_ptr<StorageIoLoadGuard> guard)
+{
+	const std::scoped_lock lock(io_load_get_global_mutex());
+	io_load_get_global_ref() = std::move(guard);
+}
+
+
+
+std::shared_ptr<StorageIoLoadGuard> storage_io_load_guard_get_global()
+{
+	const std::scoped_lock lock(io_load_get_global_mutex());
+	return io_load_get_global_ref();
+}
+
+
+
+
+
+
+/// @}
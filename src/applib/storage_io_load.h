@@ -0,0 +1,264 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_IO_LOAD_H
+#define STORAGE_IO_LOAD_H
+
+#include <glib.h>
+#include <sigc++/sigc++.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hz/fs.h"
+
+#include "storage_device.h"
+
+
+
+/// I/O counters of a block device, as in /proc/diskstats (see the kernel's Documentation/admin-guide/iostats.rst)
+struct StorageIoStats {
+	std::uint64_t reads_completed = 0;  ///< Reads completed (field 1)
+	std::uint64_t writes_completed = 0;  ///< Writes completed (field 5)
+	std::uint64_t sectors_read = 0;  ///< 512-byte sectors read (field 3)
+	std::uint64_t sectors_written = 0;  ///< 512-byte sectors written (field 7)
+	std::uint64_t io_time_msec = 0;  ///< Time spent by the reads and writes, milliseconds (fields 4 and 8)
+	std::uint64_t in_flight = 0;  ///< I/Os currently in progress (field 9)
+	std::uint64_t busy_time_msec = 0;  ///< Time the device had I/Os in progress, milliseconds (field 10)
+	std::uint64_t weighted_io_time_msec = 0;  ///< Weighted time spent doing I/Os, milliseconds (field 11)
+};
+
+
+/// Parsed /proc/diskstats: block device name (e.g. "sda") -> its counters
+using StorageIoStatsMap = std::map<std::string, StorageIoStats, std::less<>>;
+
+
+/// Parse /proc/diskstats
+[[nodiscard]] StorageIoStatsMap storage_io_parse_diskstats(std::string_view contents);
+
+
+/// Get the /proc/diskstats names of the block devices behind a device file: "sdX" for /dev/sdX,
+/// "nvmeXnY" for /dev/nvmeXnY. For an NVMe controller (/dev/nvmeX), that's an "nvmeX" prefix,
+/// matching all its namespaces (\c prefix is set to true). \return empty string if unknown.
+[[nodiscard]] std::string storage_io_get_diskstats_name(const std::string& device, bool& prefix);
+
+
+/// Get the counters of the block devices behind a device file (see storage_io_get_diskstats_name()),
+/// summed for the namespaces of an NVMe controller. \return std::nullopt if there are none.
+[[nodiscard]] std::optional<StorageIoStats> storage_io_find_stats(const StorageIoStatsMap& stats, const std::string& device);
+
+
+
+/// I/O load of a block device between two samples
+struct StorageIoLoad {
+	std::uint64_t in_flight = 0;  ///< I/Os in progress at the second sample
+	double queue_depth = 0.;  ///< Average number of I/Os in progress between the samples
+	std::optional<double> latency_msec;  ///< Average I/O latency between the samples, std::nullopt if nothing completed
+};
+
+
+/// Compute the load from two samples which are \c elapsed apart
+[[nodiscard]] StorageIoLoad storage_io_compute_load(const StorageIoStats& previous, const StorageIoStats& current,
+		std::chrono::steady_clock::duration elapsed);
+
+
+
+/// I/O performance of a block device between two samples
+struct StorageIoPerformance {
+	double read_iops = 0.;  ///< Reads per second
+	double write_iops = 0.;  ///< Writes per second
+	double read_bytes_per_sec = 0.;  ///< Read throughput
+	double write_bytes_per_sec = 0.;  ///< Write throughput
+	std::optional<double> service_time_msec;  ///< Average time per completed I/O, std::nullopt if nothing completed
+	double queue_depth = 0.;  ///< Average number of I/Os in progress
+	double utilization = 0.;  ///< Fraction of the time the device had I/Os in progress, 0 - 1
+
+	/// Comparison
+	bool operator==(const StorageIoPerformance& other) const = default;
+};
+
+
+/// Compute the performance from two samples which are \c elapsed apart
+[[nodiscard]] StorageIoPerformance storage_io_compute_performance(const StorageIoStats& previous, const StorageIoStats& current,
+		std::chrono::steady_clock::duration elapsed);
+
+
+
+/// Thresholds above which a device is considered busy. 0 disables a threshold.
+struct StorageIoLoadThresholds {
+	double max_queue_depth = 0.;  ///< Maximum in-flight I/Os (the instantaneous and the average ones)
+	double max_latency_msec = 0.;  ///< Maximum average I/O latency
+
+	/// Check whether \c load exceeds the thresholds
+	[[nodiscard]] bool get_exceeded(const StorageIoLoad& load) const;
+};
+
+
+
+/// Monitors the I/O load of the local drives through /proc/diskstats, so that smartctl
+/// commands to the drives busy with a latency-sensitive workload can be deferred or delayed.
+/// /proc/diskstats is sampled at most twice a second; the load is the difference between
+/// the last two samples (or just the in-flight I/O count if there's only one).
+/// Drives which are virtual, remote or not backed by a block device (e.g. /dev/twa0) are never busy.
+/// This class is thread-safe.
+class StorageIoLoadGuard {
+	public:
+
+		/// Constructor
+		StorageIoLoadGuard(hz::fs::path diskstats_file, StorageIoLoadThresholds thresholds);
+
+
+		/// Get the load of a device, sampling /proc/diskstats if the last sample is old enough.
+		/// \return std::nullopt if the device is not in /proc/diskstats.
+		[[nodiscard]] std::optional<StorageIoLoad> get_load(const std::string& device);
+
+
+		/// Check whether the drive is too busy for smartctl commands now
+		[[nodiscard]] bool get_busy(const StorageDevice& drive);
+
+
+		/// Wait until the drive is not busy, for at most \c max_wait, iterating the thread-default
+		/// main context meanwhile. \return false if it was still busy after \c max_wait.
+		bool wait_until_idle(const StorageDevice& drive, std::chrono::steady_clock::duration max_wait);
+
+
+	private:
+
+		/// /proc/diskstats contents at a point in time
+		struct Sample {
+			std::chrono::steady_clock::time_point time;  ///< Sampling time
+			StorageIoStatsMap stats;  ///< Parsed file
+		};
+
+		/// Take a new sample if the last one is old enough. Must be called with mutex_ locked.
+		void update_samples();
+
+
+		const hz::fs::path diskstats_file_;  ///< /proc/diskstats
+		const StorageIoLoadThresholds thresholds_;  ///< Thresholds
+
+		std::mutex mutex_;  ///< Protects the samples
+		std::optional<Sample> previous_;  ///< The sample before current_
+		std::optional<Sample> current_;  ///< The last sample
+
+};
+
+
+
+/// Samples /proc/diskstats periodically for the live I/O performance display (info window tab,
+/// icons). A single file read per interval serves all the drives and all the windows, and the
+/// timer only runs while somebody uses the data (see add_user()).
+/// This class must be used from the main thread.
+class StorageIoPerformanceMonitor : public sigc::trackable {
+	public:
+
+		/// Constructor
+		StorageIoPerformanceMonitor(hz::fs::path diskstats_file, std::chrono::milliseconds interval);
+
+		/// Deleted
+		StorageIoPerformanceMonitor(const StorageIoPerformanceMonitor& other) = delete;
+
+		/// Deleted
+		StorageIoPerformanceMonitor(StorageIoPerformanceMonitor&& other) = delete;
+
+		/// Deleted
+		StorageIoPerformanceMonitor& operator=(const StorageIoPerformanceMonitor& other) = delete;
+
+		/// Deleted
+		StorageIoPerformanceMonitor& operator=(StorageIoPerformanceMonitor&& other) = delete;
+
+		/// Destructor
+		~StorageIoPerformanceMonitor();
+
+
+		/// Start sampling (in the default main context) if this is the first user.
+		/// Each add_user() must be paired with remove_user().
+		void add_user();
+
+		/// Undo add_user(). The sampling is stopped when there are no users left.
+		void remove_user();
+
+
+		/// Read /proc/diskstats now and compute the performance since the previous sample.
+		/// signal_sampled() is emitted.
+		void sample();
+
+
+		/// Get the performance of a drive between the last two samples.
+		/// \return std::nullopt if there aren't two samples yet, or the drive is not local or not a block device.
+		[[nodiscard]] std::optional<StorageIoPerformance> get_performance(const StorageDevice& drive) const;
+
+
+		/// Emitted after each sample
+		sigc::signal<void>& signal_sampled();
+
+
+	private:
+
+		/// Timeout callback
+		static gboolean on_timeout(gpointer data);
+
+
+		const hz::fs::path diskstats_file_;  ///< /proc/diskstats
+		const std::chrono::milliseconds interval_;  ///< Sampling interval
+		int users_ = 0;  ///< Number of add_user() calls
+		guint timeout_id_ = 0;  ///< on_timeout() source
+
+		std::chrono::steady_clock::time_point previous_time_;  ///< Time of previous_
+		std::optional<StorageIoStatsMap> previous_;  ///< The sample before current_
+		std::chrono::steady_clock::time_point current_time_;  ///< Time of current_
+		std::optional<StorageIoStatsMap> current_;  ///< The last sample
+
+		sigc::signal<void> signal_sampled_;  ///< Signal
+
+};
+
+
+
+/// Create a performance monitor from the settings ("gui/io_performance_interval_msec").
+/// \return nullptr if it's disabled or not supported (non-Linux).
+[[nodiscard]] std::shared_ptr<StorageIoPerformanceMonitor> storage_io_performance_create_from_settings();
+
+
+/// Set the monitor which the GUI uses (nullptr to disable). Main thread only.
+void storage_io_performance_set_global(std::shared_ptr<StorageIoPerformanceMonitor> monitor);
+
+
+/// Get the monitor set by storage_io_performance_set_global(), may be nullptr. Main thread only.
+[[nodiscard]] std::shared_ptr<StorageIoPerformanceMonitor> storage_io_performance_get_global();
+
+
+
+/// Create a load guard from the "system/io_load_*" settings.
+/// \return nullptr if it's disabled or not supported (non-Linux).
+[[nodiscard]] std::shared_ptr<StorageIoLoadGuard> storage_io_load_guard_create_from_settings();
+
+
+/// Set the guard used by scans and scheduled refreshes (nullptr to disable). Thread-safe.
+void storage_io_load_guard_set_global(std::shared_ptr<StorageIoLoadGuard> guard);
+
+
+/// Get the guard set by storage_io_load_guard_set_global(), may be nullptr. Thread-safe.
+[[nodiscard]] std::shared_ptr<StorageIoLoadGuard> storage_io_load_guard_get_global();
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,611 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "storage_ioctl_poll.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <limits>
+#include <set>
+#include <string_view>
+#include <utility>
+
+#ifdef __linux__
+	#include <cerrno>
+	#include <cstring>  // std::strerror
+	#include <fcntl.h>  // open()
+	#include <linux/nvme_ioctl.h>  // NVME_IOCTL_ADMIN_CMD
+	#include <scsi/sg.h>  // SG_IO
+	#include <sys/ioctl.h>
+	#include <unistd.h>  // close()
+#endif
+
+#include "fmt/format.h"
+#include "nlohmann/json.hpp"
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+
+
+
+namespace {
+
+
+	/// Size of the ATA SMART data pages and of the NVMe health log
+	constexpr std::size_t storage_ioctl_page_size = 512;
+
+	/// Number of attribute slots in the ATA SMART READ DATA page
+	constexpr std::size_t storage_ioctl_ata_attribute_slots = 30;
+
+	/// Attributes which report the temperature in the lowest raw byte, in the order smartctl prefers them
+	constexpr std::array<std::int32_t, 2> storage_ioctl_ata_temperature_attributes = {194, 190};
+
+
+	/// Read a little-endian unsigned integer of \c size bytes (at most 8)
+	inline std::uint64_t read_le(std::span<const std::uint8_t> page, std::size_t offset, std::size_t size)
+	{
+		std::uint64_t value = 0;
+		for (std::size_t i = size; i > 0; --i) {
+			value = (value << 8) | page[offset + i - 1];
+		}
+		return value;
+	}
+
+
+	/// Read a little-endian 128-bit NVMe counter, saturating at INT64_MAX
+	inline std::int64_t read_le_128_saturated(std::span<const std::uint8_t> page, std::size_t offset)
+	{
+		constexpr auto max_value = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+		const std::uint64_t low = read_le(page, offset, 8);
+		const std::uint64_t high = read_le(page, offset + 8, 8);
+		return static_cast<std::int64_t>((high != 0 || low > max_value) ? max_value : low);
+	}
+
+
+	/// Get "major.minor" smartctl version of the previous fetch as a JSON array
+	inline std::optional<std::vector<int>> get_previous_smartctl_version(const StoragePropertyRepository& previous)
+	{
+		const StorageProperty* p = previous.find_property("smartctl/version/_merged", StoragePropertySection::Info);
+		if (!p || !p->is_value_type<std::string>()) {
+			return std::nullopt;
+		}
+		std::vector<std::string> components;
+		hz::string_split(p->get_value<std::string>(), '.', components, true);
+		int major = 0, minor = 0;
+		if (components.size() < 2 || !hz::string_is_numeric_nolocale(components[0], major)
+				|| !hz::string_is_numeric_nolocale(components[1], minor)) {
+			return std::nullopt;
+		}
+		return std::vector<int>{major, minor};
+	}
+
+
+	/// Create the common part of the smartctl JSON output
+	inline nlohmann::json create_json_root(const std::vector<int>& smartctl_version)
+	{
+		nlohmann::json root;
+		root["json_format_version"] = {1, 0};
+		root["smartctl"]["version"] = smartctl_version;
+		root["smartctl"]["exit_status"] = 0;
+		return root;
+	}
+
+
+	/// Check whether a property is taken from the polled data by storage_ioctl_merge_properties()
+	inline bool get_property_polled(const StorageProperty& p)
+	{
+		switch (p.section) {
+			case StoragePropertySection::OverallHealth:
+			case StoragePropertySection::AtaAttributes:
+			case StoragePropertySection::NvmeAttributes:
+				return true;
+			case StoragePropertySection::Info:
+				return p.generic_name == "temperature/current";
+			default:
+				break;
+		}
+		return false;
+	}
+
+
+	/// Check whether two properties are the same (the polled version of one another)
+	inline bool get_same_property(const StorageProperty& a, const StorageProperty& b)
+	{
+		if (a.section != b.section) {
+			return false;
+		}
+		if (a.is_value_type<AtaStorageAttribute>() && b.is_value_type<AtaStorageAttribute>()) {
+			return a.get_value<AtaStorageAttribute>().id == b.get_value<AtaStorageAttribute>().id;
+		}
+		return a.generic_name == b.generic_name;
+	}
+
+
+
+#ifdef __linux__
+
+	/// Device file descriptor, closed on destruction
+	class StorageIoctlDeviceFd {
+		public:
+
+			/// Constructor, opens the device. O_NONBLOCK is what smartctl uses (it doesn't wait for the media).
+			explicit StorageIoctlDeviceFd(const std::string& device)
+					: fd_(open(device.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC))
+			{ }
+
+			/// Deleted
+			StorageIoctlDeviceFd(const StorageIoctlDeviceFd& other) = delete;
+
+			/// Deleted
+			StorageIoctlDeviceFd(StorageIoctlDeviceFd&& other) = delete;
+
+			/// Deleted
+			StorageIoctlDeviceFd& operator=(const StorageIoctlDeviceFd& other) = delete;
+
+			/// Deleted
+			StorageIoctlDeviceFd& operator=(StorageIoctlDeviceFd&& other) = delete;
+
+			/// Destructor
+			~StorageIoctlDeviceFd()
+			{
+				if (fd_ >= 0) {
+					close(fd_);
+				}
+			}
+
+			/// Get the file descriptor, -1 if the device couldn't be opened
+			[[nodiscard]] int get() const
+			{
+				return fd_;
+			}
+
+		private:
+
+			int fd_ = -1;  ///< File descriptor
+	};
+
+
+	/// ATA registers returned by a passthrough command with CK_COND set
+	struct StorageIoctlAtaReturnRegisters {
+		std::uint8_t lba_mid = 0;  ///< LBA Mid (7:0)
+		std::uint8_t lba_high = 0;  ///< LBA High (7:0)
+	};
+
+
+	/// Execute a SMART command (ATA command 0xB0) using ATA PASS-THROUGH (16) of SAT.
+	/// If \c data is not empty, it's a PIO Data-In command reading one sector into it.
+	/// Otherwise, it's a non-data command with its result registers returned in \c registers.
+	hz::ExpectedVoid<StorageIoctlPollError> storage_ioctl_ata_smart_command(int fd, std::uint8_t feature,
+			std::span<std::uint8_t> data, StorageIoctlAtaReturnRegisters* registers)
+	{
+		std::array<unsigned char, 16> cdb = {};
+		cdb[0] = 0x85;  // ATA PASS-THROUGH (16)
+		if (data.empty()) {
+			cdb[1] = 3 << 1;  // protocol: non-data
+			cdb[2] = 0x20;  // CK_COND: return the registers
+		} else {
+			cdb[1] = 4 << 1;  // protocol: PIO Data-In
+			cdb[2] = 0x0e;  // T_DIR from device, BYT_BLOK, T_LENGTH in sector count
+			cdb[6] = 1;  // sector count
+		}
+		cdb[4] = feature;
+		cdb[10] = 0x4f;  // LBA Mid, SMART signature
+		cdb[12] = 0xc2;  // LBA High, SMART signature
+		cdb[14] = 0xb0;  // SMART
+
+		std::array<unsigned char, 32> sense = {};
+		sg_io_hdr_t io_hdr = {};
+		io_hdr.interface_id = 'S';
+		io_hdr.cmd_len = static_cast<unsigned char>(cdb.size());
+		io_hdr.cmdp = cdb.data();
+		io_hdr.mx_sb_len = static_cast<unsigned char>(sense.size());
+		io_hdr.sbp = sense.data();
+		io_hdr.dxfer_direction = data.empty() ? SG_DXFER_NONE : SG_DXFER_FROM_DEV;
+		io_hdr.dxfer_len = static_cast<unsigned int>(data.size());
+		io_hdr.dxferp = data.empty() ? nullptr : data.data();
+		io_hdr.timeout = 10000;  // ms
+
+		if (ioctl(fd, SG_IO, &io_hdr) != 0) {
+			return hz::Unexpected(StorageIoctlPollError::IoctlFailed, fmt::format("SG_IO ioctl failed: {}", std::strerror(errno)));
+		}
+		if (io_hdr.host_status != 0 || (io_hdr.driver_status & 0x0f) != 0) {
+			return hz::Unexpected(StorageIoctlPollError::IoctlFailed,
+					fmt::format("SG_IO command failed: host status {}, driver status {}.", io_hdr.host_status, io_hdr.driver_status));
+		}
+
+		if (data.empty()) {
+			// The registers are in the ATA Status Return sense data descriptor (descriptor format),
+			// or in the information fields (fixed format).
+			const std::size_t sense_size = io_hdr.sb_len_wr;
+			if (sense_size >= 8 && (sense[0] & 0x7f) == 0x72) {
+				for (std::size_t pos = 8; pos + 14 <= sense_size; pos += 2 + std::size_t(sense[pos + 1])) {
+					if (sense[pos] == 0x09) {
+						registers->lba_mid = sense[pos + 9];
+						registers->lba_high = sense[pos + 11];
+						return {};
+					}
+				}
+			} else if (sense_size >= 12 && (sense[0] & 0x7f) == 0x70) {
+				registers->lba_mid = sense[10];
+				registers->lba_high = sense[11];
+				return {};
+			}
+			return hz::Unexpected(StorageIoctlPollError::IoctlFailed, "No ATA registers returned by SMART RETURN STATUS.");
+		}
+
+		if (io_hdr.status != 0) {
+			return hz::Unexpected(StorageIoctlPollError::IoctlFailed, fmt::format("SMART command failed: SCSI status {}.", io_hdr.status));
+		}
+		return {};
+	}
+
+
+	/// Poll an ATA drive
+	hz::ExpectedValue<std::string, StorageIoctlPollError> storage_ioctl_poll_ata(int fd, const StoragePropertyRepository& previous)
+	{
+		std::array<std::uint8_t, storage_ioctl_page_size> page = {};
+		auto read_status = storage_ioctl_ata_smart_command(fd, 0xd0, page, nullptr);  // SMART READ DATA
+		if (!read_status) {
+			return hz::Unexpected(StorageIoctlPollError(read_status.error().data()), read_status.error().message());
+		}
+		auto attributes = storage_ioctl_decode_ata_smart_data(page);
+		if (!attributes) {
+			return hz::Unexpected(StorageIoctlPollError(attributes.error().data()), attributes.error().message());
+		}
+
+		std::optional<bool> health_passed;
+		StorageIoctlAtaReturnRegisters registers;
+		if (storage_ioctl_ata_smart_command(fd, 0xda, {}, &registers)) {  // SMART RETURN STATUS
+			if (registers.lba_mid == 0x4f && registers.lba_high == 0xc2) {
+				health_passed = true;
+			} else if (registers.lba_mid == 0xf4 && registers.lba_high == 0x2c) {
+				health_passed = false;
+			}
+		}
+		if (!health_passed.has_value() && previous.find_property("smart_status/passed", StoragePropertySection::OverallHealth)) {
+			return hz::Unexpected(StorageIoctlPollError::NeedsFullFetch, "Cannot get the SMART health status.");
+		}
+
+		return storage_ioctl_create_ata_json(previous, attributes.value(), health_passed);
+	}
+
+
+	/// Poll an NVMe drive
+	hz::ExpectedValue<std::string, StorageIoctlPollError> storage_ioctl_poll_nvme(int fd)
+	{
+		std::array<std::uint8_t, storage_ioctl_page_size> page = {};
+		nvme_admin_cmd cmd = {};
+		cmd.opcode = 0x02;  // Get Log Page
+		cmd.nsid = 0xffffffff;  // controller, all namespaces
+		cmd.addr = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(page.data()));
+		cmd.data_len = static_cast<std::uint32_t>(page.size());
+		cmd.cdw10 = 0x02 | ((static_cast<std::uint32_t>(page.size() / 4) - 1) << 16);  // SMART / Health Information, number of dwords - 1
+
+		const int result = ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd);
+		if (result < 0) {
+			return hz::Unexpected(StorageIoctlPollError::IoctlFailed, fmt::format("NVMe admin ioctl failed: {}", std::strerror(errno)));
+		}
+		if (result > 0) {
+			return hz::Unexpected(StorageIoctlPollError::IoctlFailed, fmt::format("NVMe Get Log Page failed: status 0x{:x}.", result));
+		}
+
+		auto health_log = storage_ioctl_decode_nvme_health_log(page);
+		if (!health_log) {
+			return hz::Unexpected(StorageIoctlPollError(health_log.error().data()), health_log.error().message());
+		}
+		return storage_ioctl_create_nvme_json(health_log.value());
+	}
+
+#endif
+
+}
+
+
+
+bool storage_ioctl_poll_get_supported([[maybe_unused]] const std::string& device, [[maybe_unused]] const std::string& type_argument,
+		[[maybe_unused]] StorageDeviceDetectedType detected_type)
+{
+#ifdef __linux__
+	switch (detected_type) {
+		case StorageDeviceDetectedType::AtaAny:
+		case StorageDeviceDetectedType::AtaHdd:
+		case StorageDeviceDetectedType::AtaSsd:
+			// Other types (-d megaraid,N, etc.) need the passthrough of their controllers
+			return hz::string_begins_with(device, "/dev/sd")
+					&& (type_argument.empty() || type_argument == "auto" || type_argument == "sat");
+		case StorageDeviceDetectedType::Nvme:
+			return hz::string_begins_with(device, "/dev/nvme")
+					&& (type_argument.empty() || type_argument == "auto" || type_argument == "nvme");
+		default:
+			break;
+	}
+#endif
+	return false;
+}
+
+
+
+hz::ExpectedValue<std::vector<StorageIoctlAtaAttribute>, StorageIoctlPollError>
+		storage_ioctl_decode_ata_smart_data(std::span<const std::uint8_t> page)
+{
+	if (page.size() != storage_ioctl_page_size) {
+		return hz::Unexpected(StorageIoctlPollError::InvalidData, "Invalid SMART data page size.");
+	}
+	std::uint8_t checksum = 0;
+	for (const std::uint8_t byte : page) {
+		checksum = static_cast<std::uint8_t>(checksum + byte);
+	}
+	if (checksum != 0) {
+		return hz::Unexpected(StorageIoctlPollError::InvalidData, "Invalid SMART data checksum.");
+	}
+
+	// Bytes 0-1 are the revision, then 30 entries of 12 bytes:
+	// ID, flags (2), value, worst, raw value (6), reserved.
+	std::vector<StorageIoctlAtaAttribute> attributes;
+	for (std::size_t slot = 0; slot < storage_ioctl_ata_attribute_slots; ++slot) {
+		const std::size_t offset = 2 + slot * 12;
+		if (page[offset] == 0) {
+			continue;  // unused
+		}
+		StorageIoctlAtaAttribute& a = attributes.emplace_back();
+		a.id = page[offset];
+		a.flags = static_cast<std::uint16_t>(read_le(page, offset + 1, 2));
+		a.value = page[offset + 3];
+		a.worst = page[offset + 4];
+		a.raw_value = read_le(page, offset + 5, 6);
+	}
+	return attributes;
+}
+
+
+
+hz::ExpectedValue<StorageIoctlNvmeHealthLog, StorageIoctlPollError>
+		storage_ioctl_decode_nvme_health_log(std::span<const std::uint8_t> page)
+{
+	if (page.size() != storage_ioctl_page_size) {
+		return hz::Unexpected(StorageIoctlPollError::InvalidData, "Invalid NVMe health log size.");
+	}
+	StorageIoctlNvmeHealthLog log;
+	log.critical_warning = page[0];
+	log.temperature = static_cast<std::int64_t>(read_le(page, 1, 2)) - 273;  // Kelvin
+	log.available_spare = page[3];
+	log.available_spare_threshold = page[4];
+	log.percentage_used = page[5];
+	log.data_units_read = read_le_128_saturated(page, 32);
+	log.data_units_written = read_le_128_saturated(page, 48);
+	log.host_reads = read_le_128_saturated(page, 64);
+	log.host_writes = read_le_128_saturated(page, 80);
+	log.controller_busy_time = read_le_128_saturated(page, 96);
+	log.power_cycles = read_le_128_saturated(page, 112);
+	log.power_on_hours = read_le_128_saturated(page, 128);
+	log.unsafe_shutdowns = read_le_128_saturated(page, 144);
+	log.media_errors = read_le_128_saturated(page, 160);
+	log.num_err_log_entries = read_le_128_saturated(page, 176);
+	log.warning_temp_time = static_cast<std::int64_t>(read_le(page, 192, 4));
+	log.critical_comp_time = static_cast<std::int64_t>(read_le(page, 196, 4));
+	return log;
+}
+
+
+
+std::optional<std::string> storage_ioctl_format_ata_raw_value(const AtaStorageAttribute& previous, std::uint64_t raw_value)
+{
+	const auto previous_raw = static_cast<std::uint64_t>(previous.raw_value_int);
+	if (raw_value == previous_raw) {
+		return previous.raw_value;
+	}
+	if (previous.raw_value == std::to_string(previous_raw)) {
+		return std::to_string(raw_value);
+	}
+
+	// A number followed by something else, e.g. "29 (Min/Max 23/41)" or "1720h+30m".
+	// It's the lowest byte(s) of the raw value; the rest of the string is made of the other bytes.
+	const std::string_view str = previous.raw_value;
+	std::uint64_t leading_number = 0;
+	const auto [number_end, ec] = std::from_chars(str.data(), str.data() + str.size(), leading_number);
+	if (ec != std::errc() || number_end == str.data()) {
+		return std::nullopt;
+	}
+	for (const std::uint64_t mask : {std::uint64_t(0xff), std::uint64_t(0xffff), std::uint64_t(0xffffffff)}) {
+		if ((previous_raw & mask) == leading_number && (previous_raw & ~mask) == (raw_value & ~mask)) {
+			return std::to_string(raw_value & mask) + std::string(number_end, str.data() + str.size());
+		}
+	}
+	return std::nullopt;
+}
+
+
+
+hz::ExpectedValue<std::string, StorageIoctlPollError> storage_ioctl_create_ata_json(
+		const StoragePropertyRepository& previous, const std::vector<StorageIoctlAtaAttribute>& attributes,
+		std::optional<bool> health_passed)
+{
+	const auto smartctl_version = get_previous_smartctl_version(previous);
+	if (!smartctl_version.has_value()) {
+		return hz::Unexpected(StorageIoctlPollError::NeedsFullFetch, "No smartctl version in the previous data.");
+	}
+
+	// The attributes of the previous fetch, by ID
+	std::vector<const StorageProperty*> previous_attributes;
+	std::set<std::int32_t> previous_ids;
+	for (const auto& p : previous.get_properties()) {
+		if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()) {
+			previous_attributes.push_back(&p);
+			previous_ids.insert(p.get_value<AtaStorageAttribute>().id);
+		}
+	}
+	std::set<std::int32_t> ids;
+	for (const auto& a : attributes) {
+		ids.insert(a.id);
+	}
+	if (ids.empty() || ids != previous_ids) {
+		return hz::Unexpected(StorageIoctlPollError::NeedsFullFetch, "The attributes differ from the previous data.");
+	}
+
+	nlohmann::json root = create_json_root(smartctl_version.value());
+	nlohmann::json& table = root["ata_smart_attributes"]["table"];
+	table = nlohmann::json::array();
+
+	for (const auto& a : attributes) {
+		const auto found = std::find_if(previous_attributes.begin(), previous_attributes.end(), [&a](const StorageProperty* p) {
+			return p->get_value<AtaStorageAttribute>().id == a.id;
+		});
+		if (found == previous_attributes.end()) {  // same IDs, can't happen
+			return hz::Unexpected(StorageIoctlPollError::NeedsFullFetch, "The attributes differ from the previous data.");
+		}
+		const StorageProperty& previous_property = **found;
+		const auto& previous_attr = previous_property.get_value<AtaStorageAttribute>();
+
+		const auto raw_string = storage_ioctl_format_ata_raw_value(previous_attr, a.raw_value);
+		if (!raw_string.has_value()) {
+			return hz::Unexpected(StorageIoctlPollError::NeedsFullFetch,
+					fmt::format("Cannot format the raw value of attribute {}.", a.id));
+		}
+
+		nlohmann::json entry;
+		entry["id"] = a.id;
+		entry["name"] = previous_property.reported_name;
+		// Normalized values marked as invalid in the drive database ("---") stay that way
+		if (previous_attr.value.has_value()) {
+			entry["value"] = a.value;
+			entry["worst"] = a.worst;
+		}
+		// The thresholds change only with firmware updates, they are kept
+		if (previous_attr.threshold.has_value()) {
+			entry["thresh"] = previous_attr.threshold.value();
+		}
+		entry["flags"]["value"] = a.flags;
+		entry["flags"]["string"] = previous_attr.flag;
+		entry["flags"]["prefailure"] = bool(a.flags & 0x01);
+		entry["flags"]["updated_online"] = bool(a.flags & 0x02);
+
+		// Same as smartctl: failing now if the value is at or below the threshold, in the past if the worst one is.
+		std::string when_failed;
+		if (previous_attr.value.has_value() && previous_attr.threshold.value_or(0) != 0) {
+			if (a.value <= previous_attr.threshold.value()) {
+				when_failed = "now";
+			} else if (a.worst <= previous_attr.threshold.value()) {
+				when_failed = "past";
+			}
+		}
+		entry["when_failed"] = when_failed;
+		entry["raw"]["value"] = a.raw_value;
+		entry["raw"]["string"] = raw_string.value();
+		table.push_back(std::move(entry));
+	}
+
+	// The temperature of the previous fetch may have come from other sources (e.g. SCT status),
+	// but most drives report the same in these attributes. The JSON parser also needs it
+	// (at least one Info key), so the drives without such attributes are not supported.
+	std::optional<std::int64_t> temperature;
+	for (const std::int32_t id : storage_ioctl_ata_temperature_attributes) {
+		const auto found = std::find_if(attributes.begin(), attributes.end(), [id](const StorageIoctlAtaAttribute& a) {
+			return a.id == id;
+		});
+		if (found != attributes.end()) {
+			temperature = static_cast<std::int64_t>(found->raw_value & 0xff);
+			break;
+		}
+	}
+	if (!temperature.has_value()) {
+		return hz::Unexpected(StorageIoctlPollError::NeedsFullFetch, "No temperature attribute.");
+	}
+	root["temperature"]["current"] = temperature.value();
+
+	if (health_passed.has_value()) {
+		root["smart_status"]["passed"] = health_passed.value();
+	}
+
+	return root.dump();
+}
+
+
+
+std::string storage_ioctl_create_nvme_json(const StorageIoctlNvmeHealthLog& health_log)
+{
+	// There is no drive-specific formatting here, so the minimum version accepted by the JSON parser will do
+	nlohmann::json root = create_json_root({7, 3});
+
+	// Same as smartctl: any critical warning bit means failure
+	root["smart_status"]["passed"] = (health_log.critical_warning == 0);
+	root["temperature"]["current"] = health_log.temperature;
+
+	nlohmann::json& log = root["nvme_smart_health_information_log"];
+	log["critical_warning"] = health_log.critical_warning;
+	log["temperature"] = health_log.temperature;
+	log["available_spare"] = health_log.available_spare;
+	log["available_spare_threshold"] = health_log.available_spare_threshold;
+	log["percentage_used"] = health_log.percentage_used;
+	log["data_units_read"] = health_log.data_units_read;
+	log["data_units_written"] = health_log.data_units_written;
+	log["host_reads"] = health_log.host_reads;
+	log["host_writes"] = health_log.host_writes;
+	log["controller_busy_time"] = health_log.controller_busy_time;
+	log["power_cycles"] = health_log.power_cycles;
+	log["power_on_hours"] = health_log.power_on_hours;
+	log["unsafe_shutdowns"] = health_log.unsafe_shutdowns;
+	log["media_errors"] = health_log.media_errors;
+	log["num_err_log_entries"] = health_log.num_err_log_entries;
+	log["warning_temp_time"] = health_log.warning_temp_time;
+	log["critical_comp_time"] = health_log.critical_comp_time;
+
+	return root.dump();
+}
+
+
+
+hz::ExpectedValue<std::string, StorageIoctlPollError> storage_ioctl_poll([[maybe_unused]] const std::string& device,
+		[[maybe_unused]] StorageDeviceDetectedType detected_type, [[maybe_unused]] const StoragePropertyRepository& previous)
+{
+#ifdef __linux__
+	if (!storage_ioctl_poll_get_supported(device, std::string(), detected_type)) {
+		return hz::Unexpected(StorageIoctlPollError::Unsupported, "The drive is not supported.");
+	}
+	const StorageIoctlDeviceFd fd(device);
+	if (fd.get() < 0) {
+		return hz::Unexpected(StorageIoctlPollError::OpenFailed,
+				fmt::format("Cannot open device {}: {}", device, std::strerror(errno)));
+	}
+	if (detected_type == StorageDeviceDetectedType::Nvme) {
+		return storage_ioctl_poll_nvme(fd.get());
+	}
+	return storage_ioctl_poll_ata(fd.get(), previous);
+#else
+	return hz::Unexpected(StorageIoctlPollError::Unsupported, "Polling with ioctls is not supported on this platform.");
+#endif
+}
+
+
+
+StoragePropertyRepository storage_ioctl_merge_properties(StoragePropertyRepository repository,
+		const StoragePropertyRepository& polled)
+{
+	auto& properties = repository.get_properties_ref();
+	for (const auto& polled_property : polled.get_properties()) {
+		if (!get_property_polled(polled_property)) {
+			continue;
+		}
+		const auto found = std::find_if(properties.begin(), properties.end(), [&polled_property](const StorageProperty& p) {
+			return get_same_property(p, polled_property);
+		});
+		if (found != properties.end()) {
+			*found = polled_property;
+		}
+	}
+	return repository;
+}
+
+
+
+/// @}
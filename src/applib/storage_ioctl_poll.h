@@ -0,0 +1,145 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_IOCTL_POLL_H
+#define STORAGE_IOCTL_POLL_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "hz/error_container.h"
+
+#include "storage_device_detected_type.h"
+#include "storage_property.h"
+#include "storage_property_repository.h"
+
+
+/*
+In-process polling of the frequently changing SMART data: the ATA attributes and
+health status (SMART READ DATA / RETURN STATUS through SAT passthrough with SG_IO),
+and the NVMe SMART / Health Information log (NVMe admin Get Log Page ioctl).
+It costs a single ioctl per page instead of a smartctl process.
+
+The data read this way is converted to smartctl JSON (the subset smartctl would
+output for these pages) and parsed by the usual JSON parsers, so the properties
+are exactly the same as those of a smartctl fetch. The attribute names and raw
+value formats come from the drive database of smartctl, so a poll can only refresh
+the properties of a previous full smartctl fetch; anything it can't reproduce
+(a new attribute, an unknown raw value format, etc.) is reported as
+StorageIoctlPollError::NeedsFullFetch and the caller should use smartctl instead.
+
+Only Linux is supported; the other platforms always return Unsupported.
+*/
+
+
+
+/// Errors of the ioctl-based polling
+enum class StorageIoctlPollError {
+	Unsupported,  ///< The drive (or the platform) is not supported, use smartctl
+	OpenFailed,  ///< Cannot open the device (usually insufficient permissions)
+	IoctlFailed,  ///< The ioctl or the passthrough command failed
+	InvalidData,  ///< The returned data page is invalid (e.g. wrong checksum)
+	NeedsFullFetch,  ///< The data cannot be converted without smartctl, use smartctl
+};
+
+
+
+/// An attribute of the ATA SMART READ DATA page
+struct StorageIoctlAtaAttribute {
+	std::int32_t id = 0;  ///< Attribute ID
+	std::uint16_t flags = 0;  ///< Flags (bit 0: pre-failure, bit 1: updated online)
+	std::uint8_t value = 0;  ///< Normalized value
+	std::uint8_t worst = 0;  ///< Worst normalized value
+	std::uint64_t raw_value = 0;  ///< 48-bit raw value, in the default byte order
+
+	/// Compare all the fields
+	[[nodiscard]] bool operator==(const StorageIoctlAtaAttribute& other) const = default;
+};
+
+
+
+/// Fields of the NVMe SMART / Health Information log page. The 128-bit counters saturate at INT64_MAX.
+struct StorageIoctlNvmeHealthLog {
+	std::int64_t critical_warning = 0;  ///< Critical warning bits
+	std::int64_t temperature = 0;  ///< Composite temperature, Celsius
+	std::int64_t available_spare = 0;  ///< Available spare, percent
+	std::int64_t available_spare_threshold = 0;  ///< Available spare threshold, percent
+	std::int64_t percentage_used = 0;  ///< Percentage used
+	std::int64_t data_units_read = 0;  ///< Data units (1000 * 512 bytes) read
+	std::int64_t data_units_written = 0;  ///< Data units (1000 * 512 bytes) written
+	std::int64_t host_reads = 0;  ///< Host read commands
+	std::int64_t host_writes = 0;  ///< Host write commands
+	std::int64_t controller_busy_time = 0;  ///< Controller busy time, minutes
+	std::int64_t power_cycles = 0;  ///< Power cycles
+	std::int64_t power_on_hours = 0;  ///< Power on hours
+	std::int64_t unsafe_shutdowns = 0;  ///< Unsafe shutdowns
+	std::int64_t media_errors = 0;  ///< Media and data integrity errors
+	std::int64_t num_err_log_entries = 0;  ///< Number of error information log entries
+	std::int64_t warning_temp_time = 0;  ///< Warning composite temperature time, minutes
+	std::int64_t critical_comp_time = 0;  ///< Critical composite temperature time, minutes
+};
+
+
+
+/// Check whether a drive may be polled with ioctls: a local /dev/sd* ATA drive
+/// (no type argument, or "sat" / "auto") or a /dev/nvme* NVMe drive, in Linux.
+[[nodiscard]] bool storage_ioctl_poll_get_supported(const std::string& device, const std::string& type_argument,
+		StorageDeviceDetectedType detected_type);
+
+
+/// Decode the 512-byte ATA SMART READ DATA page. The checksum is verified.
+[[nodiscard]] hz::ExpectedValue<std::vector<StorageIoctlAtaAttribute>, StorageIoctlPollError>
+		storage_ioctl_decode_ata_smart_data(std::span<const std::uint8_t> page);
+
+
+/// Decode the 512-byte NVMe SMART / Health Information log page
+[[nodiscard]] hz::ExpectedValue<StorageIoctlNvmeHealthLog, StorageIoctlPollError>
+		storage_ioctl_decode_nvme_health_log(std::span<const std::uint8_t> page);
+
+
+/// Format the raw value of an attribute the way smartctl formatted its previous raw value.
+/// The plain decimal format is always supported. For the others (e.g. "29 (Min/Max 23/41)"),
+/// only the leading number may change. \return std::nullopt if it can't be done.
+[[nodiscard]] std::optional<std::string> storage_ioctl_format_ata_raw_value(const AtaStorageAttribute& previous,
+		std::uint64_t raw_value);
+
+
+/// Create smartctl JSON output for the ATA attributes and health status (if known),
+/// using the names and the raw value formats of the attribute properties in \c previous.
+[[nodiscard]] hz::ExpectedValue<std::string, StorageIoctlPollError> storage_ioctl_create_ata_json(
+		const StoragePropertyRepository& previous, const std::vector<StorageIoctlAtaAttribute>& attributes,
+		std::optional<bool> health_passed);
+
+
+/// Create smartctl JSON output for the NVMe health log
+[[nodiscard]] std::string storage_ioctl_create_nvme_json(const StorageIoctlNvmeHealthLog& health_log);
+
+
+/// Read the pages from the drive and create the smartctl JSON output for them
+/// (see storage_ioctl_create_ata_json() and storage_ioctl_create_nvme_json()).
+/// This blocks for the duration of the ioctls.
+[[nodiscard]] hz::ExpectedValue<std::string, StorageIoctlPollError> storage_ioctl_poll(const std::string& device,
+		StorageDeviceDetectedType detected_type, const StoragePropertyRepository& previous);
+
+
+/// Replace the properties of \c repository with their polled versions from \c polled
+/// (matched by section and generic name; ATA attributes by ID). The properties which were not polled are kept.
+[[nodiscard]] StoragePropertyRepository storage_ioctl_merge_properties(StoragePropertyRepository repository,
+		const StoragePropertyRepository& polled);
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,272 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm/i18n.h>
+#include <algorithm>  // std::max
+#include <cmath>
+#include <string>
+
+#include "fmt/format.h"
+#include "hz/format_unit.h"
+#include "hz/string_num.h"
+
+#include "storage_lifetime_metrics.h"
+
+
+
+namespace {
+
+	/// NVMe data units are thousands of 512-byte units
+	constexpr std::int64_t nvme_data_unit_bytes = 512 * 1000;
+
+
+	/// Get the logical sector size from the "Sector Size" property, 512 if unknown
+	std::int64_t get_logical_sector_size(const StoragePropertyRepository& properties)
+	{
+		// "512 bytes logical, 4096 bytes physical", or "512 bytes" for the logical block size alone
+		for (const auto* name : {"physical_block_size/_and/logical_block_size", "logical_block_size"}) {
+			if (const auto* p = properties.find_property(name); p && p->is_value_type<std::string>()) {
+				const auto size = hz::string_to_number_nolocale<std::int64_t>(p->get_value<std::string>(), false);
+				if (size > 0) {
+					return size;
+				}
+			}
+		}
+		return 512;
+	}
+
+
+	/// Get the lifetime average write rate (bytes per second of the power-on time)
+	std::optional<double> get_lifetime_write_rate(const StorageLifetimeCounters& counters)
+	{
+		if (!counters.bytes_written.has_value() || !counters.power_on_hours.has_value() || counters.power_on_hours.value() <= 0) {
+			return std::nullopt;
+		}
+		return static_cast<double>(counters.bytes_written.value()) / static_cast<double>(counters.power_on_hours.value() * 3600);
+	}
+
+
+	/// Check if a counter went back
+	bool counter_went_back(const std::optional<std::int64_t>& previous, const std::optional<std::int64_t>& current)
+	{
+		return previous.has_value() && current.has_value() && current.value() < previous.value();
+	}
+
+
+	/// Create a metric property
+	StorageProperty create_metric_property(const std::string& generic_name, const std::string& displayable_name,
+			std::int64_t value, std::string readable_value, std::string_view description)
+	{
+		StorageProperty p;
+		p.set_name(generic_name, displayable_name);
+		p.section = StoragePropertySection::Info;
+		p.value = value;
+		p.readable_value = std::move(readable_value);
+		p.set_static_description(description, StorageProperty::DescriptionTitle::Name);
+		return p;
+	}
+
+}
+
+
+
+StorageLifetimeCounters StorageLifetimeCounters::get_from_properties(const StoragePropertyRepository& properties)
+{
+	StorageLifetimeCounters counters;
+
+	// NVMe
+	const auto get_nvme_value = [&properties](const std::string& name) -> std::optional<std::int64_t> {
+		if (const auto* p = properties.find_property("nvme_smart_health_information_log/" + name, StoragePropertySection::NvmeAttributes);
+				p && p->is_value_type<std::int64_t>()) {
+			return p->get_value<std::int64_t>();
+		}
+		return std::nullopt;
+	};
+	if (auto units = get_nvme_value("data_units_written"); units.has_value()) {
+		counters.bytes_written = units.value() * nvme_data_unit_bytes;
+	}
+	counters.power_on_hours = get_nvme_value("power_on_hours");
+	counters.percentage_used = get_nvme_value("percentage_used");
+
+	// ATA device statistics
+	for (const auto& p : properties.get_properties_for_section(StoragePropertySection::Statistics)) {
+		if (!p.is_value_type<AtaStorageStatistic>()) {
+			continue;
+		}
+		const auto& stat = p.get_value<AtaStorageStatistic>();
+		if (stat.is_header) {
+			continue;
+		}
+		if (stat.page == 0x01 && stat.offset == 0x010) {  // Power-on Hours
+			counters.power_on_hours = stat.value_int;
+		} else if (stat.page == 0x01 && stat.offset == 0x018) {  // Logical Sectors Written
+			counters.bytes_written = stat.value_int * get_logical_sector_size(properties);
+		} else if (stat.page == 0x07 && stat.offset == 0x008) {  // Percentage Used Endurance Indicator
+			counters.percentage_used = stat.value_int;
+		}
+	}
+
+	// ATA attributes, if there are no statistics
+	if (!counters.power_on_hours.has_value()) {
+		for (const auto& p : properties.get_properties_for_section(StoragePropertySection::AtaAttributes)) {
+			if (p.is_value_type<AtaStorageAttribute>() && p.get_value<AtaStorageAttribute>().id == 9) {  // Power_On_Hours
+				counters.power_on_hours = p.get_value<AtaStorageAttribute>().raw_value_int;
+				break;
+			}
+		}
+	}
+
+	return counters;
+}
+
+
+
+void StorageLifetimeMetrics::update(const StorageLifetimeCounters& counters, std::int64_t time)
+{
+	// Nothing new, the time until the next change is accounted for then
+	if (time_.has_value() && counters == counters_) {
+		return;
+	}
+
+	if (counter_went_back(counters_.bytes_written, counters.bytes_written)
+			|| counter_went_back(counters_.power_on_hours, counters.power_on_hours)) {
+		reset();
+	}
+
+	if (time_.has_value() && time > time_.value()
+			&& counters_.bytes_written.has_value() && counters.bytes_written.has_value()) {
+		const auto dt = static_cast<double>(time - time_.value());
+		const double rate = static_cast<double>(counters.bytes_written.value() - counters_.bytes_written.value()) / dt;
+		if (write_rate_.has_value()) {
+			const double decay = std::exp(-dt / static_cast<double>(storage_lifetime_write_rate_time_constant_sec));
+			write_rate_ = decay * write_rate_.value() + (1. - decay) * rate;
+		} else {
+			write_rate_ = rate;
+		}
+	} else if (!write_rate_.has_value()) {
+		// The first refresh starts with the lifetime average
+		write_rate_ = get_lifetime_write_rate(counters);
+	}
+
+	counters_ = counters;
+	time_ = time;
+}
+
+
+
+void StorageLifetimeMetrics::update(StoragePropertyRepository& properties, std::int64_t time)
+{
+	update(StorageLifetimeCounters::get_from_properties(properties), time);
+	add_properties(properties);
+}
+
+
+
+void StorageLifetimeMetrics::add_properties(StoragePropertyRepository& properties) const
+{
+	if (auto rate = get_write_rate(); rate.has_value()) {
+		const auto bytes = static_cast<std::int64_t>(std::llround(std::max(0., rate.value())));
+		properties.add_property(create_metric_property("lifetime/write_rate", _("Recent Write Rate"), bytes,
+				fmt::format("{}/s", hz::format_size(static_cast<std::uint64_t>(bytes), true)),
+				_("Amount of data written by the host per second, averaged over the recent refreshes (bytes per second).")));
+	}
+	if (auto per_day = get_bytes_per_day(); per_day.has_value()) {
+		const auto bytes = static_cast<std::int64_t>(std::llround(per_day.value()));
+		properties.add_property(create_metric_property("lifetime/bytes_written_per_day", _("Average Writes per Day"), bytes,
+				fmt::format("{}/day", hz::format_size(static_cast<std::uint64_t>(bytes), true)),
+				_("Amount of data written by the host per power-on day, averaged over the drive lifetime (bytes per day).")));
+	}
+	if (auto days = get_remaining_endurance_days(); days.has_value()) {
+		const auto whole_days = static_cast<std::int64_t>(days.value());
+		properties.add_property(create_metric_property("lifetime/remaining_endurance_days", _("Estimated Remaining Endurance"), whole_days,
+				fmt::format(fmt::runtime(_("{} days")), whole_days),
+				_("Estimated number of days until the rated endurance of the drive is used up at the recent write rate. "
+				"The drive may work well beyond that.")));
+	}
+	if (auto intensity = get_workload_intensity(); intensity.has_value()) {
+		const auto percent = static_cast<std::int64_t>(std::llround(intensity.value() * 100.));
+		properties.add_property(create_metric_property("lifetime/workload_intensity", _("Workload Intensity"), percent,
+				fmt::format("{}%", percent),
+				_("Recent write rate relative to the lifetime average. Over 100% means the drive is written more than usual.")));
+	}
+}
+
+
+
+void StorageLifetimeMetrics::reset()
+{
+	counters_ = {};
+	time_.reset();
+	write_rate_.reset();
+}
+
+
+
+std::optional<double> StorageLifetimeMetrics::get_write_rate() const
+{
+	return write_rate_;
+}
+
+
+
+std::optional<double> StorageLifetimeMetrics::get_bytes_per_day() const
+{
+	if (auto rate = get_lifetime_write_rate(counters_); rate.has_value()) {
+		return rate.value() * 86400.;
+	}
+	return std::nullopt;
+}
+
+
+
+std::optional<double> StorageLifetimeMetrics::get_remaining_endurance_days() const
+{
+	if (!counters_.percentage_used.has_value()) {
+		return std::nullopt;
+	}
+	const auto used = counters_.percentage_used.value();
+	if (used >= 100) {
+		return 0.;
+	}
+	if (used <= 0) {
+		return std::nullopt;  // nothing to extrapolate from
+	}
+
+	// The rated endurance, extrapolated from the data written so far
+	if (counters_.bytes_written.has_value() && write_rate_.has_value() && write_rate_.value() > 0) {
+		const auto written = static_cast<double>(counters_.bytes_written.value());
+		const double remaining = written * 100. / static_cast<double>(used) - written;
+		return remaining / (write_rate_.value() * 86400.);
+	}
+	// No writes recently, use the power-on time
+	if (counters_.power_on_hours.has_value() && counters_.power_on_hours.value() > 0) {
+		return static_cast<double>(counters_.power_on_hours.value()) * static_cast<double>(100 - used) / static_cast<double>(used) / 24.;
+	}
+	return std::nullopt;
+}
+
+
+
+std::optional<double> StorageLifetimeMetrics::get_workload_intensity() const
+{
+	const auto lifetime_rate = get_lifetime_write_rate(counters_);
+	if (!write_rate_.has_value() || !lifetime_rate.has_value() || lifetime_rate.value() <= 0) {
+		return std::nullopt;
+	}
+	return std::max(0., write_rate_.value()) / lifetime_rate.value();
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,98 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_LIFETIME_METRICS_H
+#define STORAGE_LIFETIME_METRICS_H
+
+#include <cstdint>
+#include <optional>
+
+#include "storage_property_repository.h"
+
+
+
+/// Time constant of the recent write rate: the older refreshes weigh exp(-age / tau) as much.
+constexpr std::int64_t storage_lifetime_write_rate_time_constant_sec = 24 * 3600;  // 1 day
+
+
+
+/// Lifetime counters of a drive, taken from its processed properties
+/// (ATA device statistics and attributes, NVMe health information).
+struct StorageLifetimeCounters {
+
+	/// Get the counters from the properties
+	[[nodiscard]] static StorageLifetimeCounters get_from_properties(const StoragePropertyRepository& properties);
+
+	/// Compare all the fields
+	[[nodiscard]] bool operator==(const StorageLifetimeCounters& other) const = default;
+
+
+	std::optional<std::int64_t> bytes_written;  ///< Bytes written by the host
+	std::optional<std::int64_t> power_on_hours;  ///< Power-on hours
+	std::optional<std::int64_t> percentage_used;  ///< Percentage of the rated endurance used, may exceed 100
+
+};
+
+
+
+/// Metrics derived from the lifetime counters of a drive: the recent write rate,
+/// the average writes per day, the estimated remaining endurance and the workload
+/// intensity (the recent write rate relative to the lifetime average).
+/// Each refresh updates them in O(1) time from the counters of the previous refresh and the
+/// time between them, without looking at the older refreshes.
+/// The refreshes with unchanged counters (e.g. a reparse of the same output) are not sampled,
+/// their time is folded into the next refresh with changed counters.
+class StorageLifetimeMetrics {
+	public:
+
+		/// Update the metrics with the counters of a refresh made at \c time (seconds since epoch).
+		/// If the counters went back (e.g. another drive was attached), the previous refreshes are forgotten.
+		void update(const StorageLifetimeCounters& counters, std::int64_t time);
+
+		/// Same as update(get_from_properties()), and add the metrics to \c properties
+		/// as Info section properties.
+		void update(StoragePropertyRepository& properties, std::int64_t time);
+
+		/// Add the metrics to \c properties as Info section properties
+		void add_properties(StoragePropertyRepository& properties) const;
+
+		/// Forget the previous refreshes
+		void reset();
+
+
+		/// Get the recent write rate (bytes per second), exponentially weighted
+		/// (see storage_lifetime_write_rate_time_constant_sec)
+		[[nodiscard]] std::optional<double> get_write_rate() const;
+
+		/// Get the average bytes written per power-on day over the drive lifetime
+		[[nodiscard]] std::optional<double> get_bytes_per_day() const;
+
+		/// Get the estimated number of days until the rated endurance is used up at the recent write rate
+		[[nodiscard]] std::optional<double> get_remaining_endurance_days() const;
+
+		/// Get the recent write rate relative to the lifetime average (1 is the usual workload)
+		[[nodiscard]] std::optional<double> get_workload_intensity() const;
+
+
+	private:
+
+		StorageLifetimeCounters counters_;  ///< Counters of the last sampled refresh
+		std::optional<std::int64_t> time_;  ///< Time of the last sampled refresh
+		std::optional<double> write_rate_;  ///< Recent write rate, bytes per second
+
+};
+
+
+
+
+#endif
+
+/// @}
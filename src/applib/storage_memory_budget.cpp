@@ -0,0 +1,109 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <numeric>
+
+#include "rconfig/rconfig.h"
+
+#include "storage_memory_budget.h"
+
+
+
+StorageMemoryBudget::StorageMemoryBudget(std::size_t budget)
+		: budget_(budget)
+{ }
+
+
+
+void StorageMemoryBudget::set_budget(std::size_t budget)
+{
+	budget_ = budget;
+}
+
+
+
+std::size_t StorageMemoryBudget::get_budget() const
+{
+	return budget_;
+}
+
+
+
+void StorageMemoryBudget::touch(const StorageDevice* drive)
+{
+	last_use_[drive] = ++use_counter_;
+}
+
+
+
+void StorageMemoryBudget::forget(const StorageDevice* drive)
+{
+	last_use_.erase(drive);
+}
+
+
+
+std::size_t StorageMemoryBudget::enforce(const std::vector<StorageDevicePtr>& drives,
+		const std::function<bool(const StorageDevice& drive)>& keep)
+{
+	if (budget_ == 0) {
+		return 0;
+	}
+
+	std::size_t total = std::accumulate(drives.begin(), drives.end(), std::size_t(0),
+			[](std::size_t sum, const StorageDevicePtr& drive) {
+				return sum + (drive ? drive->get_memory_usage().get_total() : 0);
+			});
+	if (total <= budget_) {
+		return 0;
+	}
+
+	// Coldest first. The drives never touched have no entry, and keep their list order.
+	std::vector<StorageDevice*> candidates;
+	for (const auto& drive : drives) {
+		if (drive && !drive->get_data_compacted() && !(keep && keep(*drive))) {
+			candidates.push_back(drive.get());
+		}
+	}
+	auto get_last_use = [this](const StorageDevice* drive) -> std::uint64_t {
+		auto iter = last_use_.find(drive);
+		return iter == last_use_.end() ? 0 : iter->second;
+	};
+	std::stable_sort(candidates.begin(), candidates.end(), [&get_last_use](const StorageDevice* a, const StorageDevice* b) {
+		return get_last_use(a) < get_last_use(b);
+	});
+
+	std::size_t compacted = 0;
+	for (StorageDevice* drive : candidates) {
+		if (total <= budget_) {
+			break;
+		}
+		const std::size_t before = drive->get_memory_usage().get_total();
+		if (drive->compact_data()) {
+			total -= std::min(total, before - std::min(before, drive->get_memory_usage().get_total()));
+			++compacted;
+		}
+	}
+	return compacted;
+}
+
+
+
+StorageMemoryBudget storage_memory_budget_create_from_settings()
+{
+	const auto budget_mib = static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("gui/drive_data_memory_budget_mib")));
+	return StorageMemoryBudget(budget_mib * 1024 * 1024);
+}
+
+
+
+/// @}
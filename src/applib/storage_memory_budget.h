@@ -0,0 +1,76 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_MEMORY_BUDGET_H
+#define STORAGE_MEMORY_BUDGET_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "storage_device.h"
+
+
+
+/// Keeps the memory used by the drive data (see StorageDevice::get_memory_usage()) within
+/// a budget: when it's exceeded, the least recently used drives are compacted
+/// (see StorageDevice::compact_data()) until it's not. The drives are used when touch()
+/// is called for them; the ones never touched are the coldest, in their list order.
+/// This class is not thread-safe, use it in the thread owning the drives.
+class StorageMemoryBudget {
+	public:
+
+		/// Constructor. \c budget is in bytes, 0 means unlimited.
+		explicit StorageMemoryBudget(std::size_t budget = 0);
+
+
+		/// Set the budget in bytes, 0 means unlimited
+		void set_budget(std::size_t budget);
+
+		/// Get the budget in bytes, 0 means unlimited
+		[[nodiscard]] std::size_t get_budget() const;
+
+
+		/// Mark a drive as used now
+		void touch(const StorageDevice* drive);
+
+		/// Forget a drive which is gone
+		void forget(const StorageDevice* drive);
+
+
+		/// Compact the least recently used drives of \c drives until their memory usage fits
+		/// the budget. The drives for which \c keep returns true (e.g. the ones shown in
+		/// a window) are left alone. \return the number of compacted drives.
+		std::size_t enforce(const std::vector<StorageDevicePtr>& drives,
+				const std::function<bool(const StorageDevice& drive)>& keep = {});
+
+
+	private:
+
+		std::size_t budget_ = 0;  ///< Budget in bytes, 0 means unlimited
+		std::uint64_t use_counter_ = 0;  ///< Incremented by each touch()
+		std::unordered_map<const StorageDevice*, std::uint64_t> last_use_;  ///< Value of use_counter_ at the last touch() of each drive
+
+};
+
+
+
+/// Create a budget from the "gui/drive_data_memory_budget_mib" setting
+[[nodiscard]] StorageMemoryBudget storage_memory_budget_create_from_settings();
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,374 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "fmt/format.h"
+#include "hz/debug.h"
+
+#include "storage_metrics.h"
+#include "storage_device_detected_type.h"
+
+
+
+namespace {
+
+	/// Metric family description
+	struct MetricFamily {
+		std::string_view name;  ///< Family name
+		std::string_view help;  ///< Help text
+	};
+
+
+	/// Known metric families. All of them are gauges.
+	constexpr std::array metric_families = {
+		MetricFamily{"gsmartcontrol_device_info", "Drive information, always 1"},
+		MetricFamily{"gsmartcontrol_up", "Whether the last refresh of the drive data succeeded"},
+		MetricFamily{"gsmartcontrol_data_stale", "Whether the drive data is older than the staleness limit (and is not exported)"},
+		MetricFamily{"gsmartcontrol_in_standby", "Whether the drive was in standby mode during the last refresh (and was not spun up)"},
+		MetricFamily{"gsmartcontrol_last_refresh_success_timestamp_seconds", "Time of the last successful refresh of the drive data"},
+		MetricFamily{"gsmartcontrol_refresh_duration_seconds", "Duration of the last refresh of the drive data"},
+		MetricFamily{"gsmartcontrol_smart_health_passed", "Whether the SMART overall-health self-assessment test passed"},
+		MetricFamily{"gsmartcontrol_temperature_celsius", "Current drive temperature"},
+		MetricFamily{"gsmartcontrol_warning_level", "Highest warning level of the drive properties (0 none, 1 notice, 2 warning, 3 alert)"},
+		MetricFamily{"gsmartcontrol_ata_attribute_value", "ATA SMART attribute normalized value"},
+		MetricFamily{"gsmartcontrol_ata_attribute_worst", "ATA SMART attribute worst normalized value"},
+		MetricFamily{"gsmartcontrol_ata_attribute_threshold", "ATA SMART attribute threshold"},
+		MetricFamily{"gsmartcontrol_ata_attribute_raw", "ATA SMART attribute raw value"},
+		MetricFamily{"gsmartcontrol_ata_statistic", "ATA device statistic value"},
+		MetricFamily{"gsmartcontrol_nvme_health", "NVMe health information log value"},
+		MetricFamily{"gsmartcontrol_selftest_in_progress", "Whether a self-test is running"},
+		MetricFamily{"gsmartcontrol_selftest_last_failed", "Whether the last completed self-test failed"},
+		MetricFamily{"gsmartcontrol_risk_score", "Risk score of the drive (bad sectors, media errors, wear and failed self-tests)"},
+		MetricFamily{"gsmartcontrol_risk_rank", "Rank of the drive among the most at-risk drives, 1 for the highest risk score"},
+	};
+
+
+	/// Find a metric family
+	const MetricFamily* find_metric_family(std::string_view name)
+	{
+		for (const auto& family : metric_families) {
+			if (family.name == name) {
+				return &family;
+			}
+		}
+		return nullptr;
+	}
+
+
+	/// Check if an ATA self-test status is a failure
+	bool is_ata_selftest_failure(AtaStorageSelftestEntry::Status status)
+	{
+		switch (status) {
+			case AtaStorageSelftestEntry::Status::FatalOrUnknown:
+			case AtaStorageSelftestEntry::Status::ComplUnknownFailure:
+			case AtaStorageSelftestEntry::Status::ComplElectricalFailure:
+			case AtaStorageSelftestEntry::Status::ComplServoFailure:
+			case AtaStorageSelftestEntry::Status::ComplReadFailure:
+			case AtaStorageSelftestEntry::Status::ComplHandlingDamage:
+				return true;
+			case AtaStorageSelftestEntry::Status::Unknown:
+			case AtaStorageSelftestEntry::Status::Reserved:
+			case AtaStorageSelftestEntry::Status::CompletedNoError:
+			case AtaStorageSelftestEntry::Status::AbortedByHost:
+			case AtaStorageSelftestEntry::Status::Interrupted:
+			case AtaStorageSelftestEntry::Status::InProgress:
+				break;
+		}
+		return false;
+	}
+
+
+	/// Check if an NVMe self-test result is a failure
+	bool is_nvme_selftest_failure(NvmeSelfTestResultType result)
+	{
+		switch (result) {
+			case NvmeSelfTestResultType::FatalOrUnknownTestError:
+			case NvmeSelfTestResultType::CompletedUnknownFailedSegment:
+			case NvmeSelfTestResultType::CompletedFailedSegments:
+				return true;
+			case NvmeSelfTestResultType::Unknown:
+			case NvmeSelfTestResultType::CompletedNoError:
+			case NvmeSelfTestResultType::AbortedSelfTestCommand:
+			case NvmeSelfTestResultType::AbortedControllerReset:
+			case NvmeSelfTestResultType::AbortedNamespaceRemoved:
+			case NvmeSelfTestResultType::AbortedFormatNvmCommand:
+			case NvmeSelfTestResultType::AbortedUnknownReason:
+			case NvmeSelfTestResultType::AbortedSanitizeOperation:
+				break;
+		}
+		return false;
+	}
+
+
+	/// Append labels to a copy of \c labels
+	StorageMetricsLabels with_labels(StorageMetricsLabels labels, std::initializer_list<std::pair<std::string, std::string>> extra)
+	{
+		labels.insert(labels.end(), extra.begin(), extra.end());
+		return labels;
+	}
+
+}
+
+
+
+void StorageMetricsWriter::add_sample(std::string_view family, const StorageMetricsLabels& labels, double value)
+{
+	std::string str;
+	if (std::isnan(value)) {
+		str = "NaN";
+	} else if (std::isinf(value)) {
+		str = (value > 0 ? "+Inf" : "-Inf");
+	} else {
+		str = fmt::format("{}", value);
+	}
+	add_sample_line(family, labels, str);
+}
+
+
+
+void StorageMetricsWriter::add_sample(std::string_view family, const StorageMetricsLabels& labels, std::int64_t value)
+{
+	add_sample_line(family, labels, fmt::format("{}", value));
+}
+
+
+
+void StorageMetricsWriter::add_drive(const StorageDevice& drive)
+{
+	const StorageMetricsLabels labels = get_drive_labels(drive);
+
+	// A consistent view, even if the drive is being refreshed
+	const StorageDevice::SnapshotPtr snapshot = drive.get_snapshot();
+
+	add_sample("gsmartcontrol_device_info", with_labels(labels, {
+			{"model", snapshot->model_name},
+			{"type", StorageDeviceDetectedTypeExt::get_storable_name(snapshot->detected_type)}}), std::int64_t(1));
+
+	const auto& properties = snapshot->property_repository;
+
+	if (const auto* p = properties.find_property("smart_status/passed"); p && p->is_value_type<bool>()) {
+		add_sample("gsmartcontrol_smart_health_passed", labels, std::int64_t(p->get_value<bool>() ? 1 : 0));
+	}
+
+	for (const auto* name : {"temperature/current", "ata_sct_status/temperature/current"}) {
+		if (const auto* p = properties.find_property(name); p && p->is_value_type<std::int64_t>()) {
+			add_sample("gsmartcontrol_temperature_celsius", labels, p->get_value<std::int64_t>());
+			break;
+		}
+	}
+
+	WarningLevel max_warning = WarningLevel::None;
+	bool nvme_selftest_checked = false;
+
+	for (const auto& p : properties.get_properties()) {
+		max_warning = std::max(max_warning, p.warning_level);
+
+		if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()) {
+			const auto& attr = p.get_value<AtaStorageAttribute>();
+			const auto attr_labels = with_labels(labels, {
+					{"id", fmt::format("{}", attr.id)}, {"name", p.reported_name}});
+			if (attr.value.has_value()) {
+				add_sample("gsmartcontrol_ata_attribute_value", attr_labels, std::int64_t(attr.value.value()));
+			}
+			if (attr.worst.has_value()) {
+				add_sample("gsmartcontrol_ata_attribute_worst", attr_labels, std::int64_t(attr.worst.value()));
+			}
+			if (attr.threshold.has_value()) {
+				add_sample("gsmartcontrol_ata_attribute_threshold", attr_labels, std::int64_t(attr.threshold.value()));
+			}
+			add_sample("gsmartcontrol_ata_attribute_raw", attr_labels, attr.raw_value_int);
+
+		} else if (p.section == StoragePropertySection::Statistics && p.is_value_type<AtaStorageStatistic>()) {
+			const auto& stat = p.get_value<AtaStorageStatistic>();
+			if (!stat.is_header) {
+				add_sample("gsmartcontrol_ata_statistic", with_labels(labels, {
+						{"page", fmt::format("{}", stat.page)}, {"offset", fmt::format("{}", stat.offset)},
+						{"name", p.reported_name}}), stat.value_int);
+			}
+
+		} else if (p.section == StoragePropertySection::NvmeAttributes && p.is_value_type<std::int64_t>()) {
+			std::string name = p.generic_name;
+			constexpr std::string_view prefix = "nvme_smart_health_information_log/";
+			if (name.substr(0, prefix.size()) == prefix) {
+				name.erase(0, prefix.size());
+			}
+			add_sample("gsmartcontrol_nvme_health", with_labels(labels, {{"name", name}}), p.get_value<std::int64_t>());
+
+		} else if (p.generic_name == "ata_smart_data/self_test/status/_merged" && p.is_value_type<AtaStorageSelftestEntry>()) {
+			const auto status = p.get_value<AtaStorageSelftestEntry>().status;
+			add_sample("gsmartcontrol_selftest_in_progress", labels,
+					std::int64_t(status == AtaStorageSelftestEntry::Status::InProgress ? 1 : 0));
+			add_sample("gsmartcontrol_selftest_last_failed", labels, std::int64_t(is_ata_selftest_failure(status) ? 1 : 0));
+
+		} else if (!nvme_selftest_checked && p.is_value_type<NvmeStorageSelftestEntry>()
+				&& p.get_value<NvmeStorageSelftestEntry>().test_num == 1) {  // the latest one
+			nvme_selftest_checked = true;
+			add_sample("gsmartcontrol_selftest_last_failed", labels,
+					std::int64_t(is_nvme_selftest_failure(p.get_value<NvmeStorageSelftestEntry>().result) ? 1 : 0));
+		}
+	}
+
+	if (const auto* p = properties.find_property("nvme_self_test_log/current_self_test_operation/value/_decoded");
+			p && p->is_value_type<std::string>()) {
+		const bool running = p->get_value<std::string>() != NvmeSelfTestCurrentOperationTypeExt::get_storable_name(NvmeSelfTestCurrentOperationType::None);
+		add_sample("gsmartcontrol_selftest_in_progress", labels, std::int64_t(running ? 1 : 0));
+	}
+
+	add_sample("gsmartcontrol_warning_level", labels, static_cast<std::int64_t>(max_warning));
+}
+
+
+
+void StorageMetricsWriter::merge(const StorageMetricsWriter& other)
+{
+	for (const auto& [family, lines] : other.samples_) {
+		auto& dest = samples_[family];
+		dest.insert(dest.end(), lines.begin(), lines.end());
+	}
+}
+
+
+
+std::string StorageMetricsWriter::get_text() const
+{
+	std::string text;
+	// Keep the order of metric_families, so that the output is stable.
+	for (const auto& family : metric_families) {
+		auto iter = samples_.find(family.name);
+		if (iter == samples_.end() || iter->second.empty()) {
+			continue;
+		}
+		text += fmt::format("# HELP {} {}\n# TYPE {} gauge\n", family.name, family.help, family.name);
+		for (const auto& line : iter->second) {
+			text += line;
+		}
+	}
+	text += "# EOF\n";
+	return text;
+}
+
+
+
+StorageMetricsFamilyTexts StorageMetricsWriter::get_family_texts() const
+{
+	StorageMetricsFamilyTexts texts(metric_families.size());
+	for (std::size_t i = 0; i < metric_families.size(); ++i) {
+		auto iter = samples_.find(metric_families[i].name);
+		if (iter == samples_.end()) {
+			continue;
+		}
+		std::size_t size = 0;
+		for (const auto& line : iter->second) {
+			size += line.size();
+		}
+		texts[i].reserve(size);
+		for (const auto& line : iter->second) {
+			texts[i] += line;
+		}
+	}
+	return texts;
+}
+
+
+
+std::string StorageMetricsWriter::join_family_texts(const std::vector<const StorageMetricsFamilyTexts*>& parts)
+{
+	// Allocate once, this is called for each scrape
+	std::size_t size = 0;
+	for (const auto* part : parts) {
+		if (part) {
+			for (const auto& text : *part) {
+				size += text.size();
+			}
+		}
+	}
+
+	std::string text;
+	text.reserve(size + metric_families.size() * 128);
+	for (std::size_t i = 0; i < metric_families.size(); ++i) {
+		const bool empty = std::all_of(parts.begin(), parts.end(), [i](const StorageMetricsFamilyTexts* part) {
+			return !part || i >= part->size() || (*part)[i].empty();
+		});
+		if (empty) {
+			continue;
+		}
+		const auto& family = metric_families[i];
+		text += fmt::format("# HELP {} {}\n# TYPE {} gauge\n", family.name, family.help, family.name);
+		for (const auto* part : parts) {
+			if (part && i < part->size()) {
+				text += (*part)[i];
+			}
+		}
+	}
+	text += "# EOF\n";
+	return text;
+}
+
+
+
+StorageMetricsLabels StorageMetricsWriter::get_drive_labels(const StorageDevice& drive)
+{
+	return {{"device", drive.get_device_with_type()}, {"serial", drive.get_serial_number()}};
+}
+
+
+
+std::string StorageMetricsWriter::escape_label_value(std::string_view value)
+{
+	std::string escaped;
+	escaped.reserve(value.size());
+	for (const char c : value) {
+		switch (c) {
+			case '\\': escaped += "\\\\"; break;
+			case '"': escaped += "\\\""; break;
+			case '\n': escaped += "\\n"; break;
+			default: escaped += c; break;
+		}
+	}
+	return escaped;
+}
+
+
+
+void StorageMetricsWriter::add_sample_line(std::string_view family, const StorageMetricsLabels& labels, const std::string& value)
+{
+	if (!find_metric_family(family)) {
+		debug_out_error("app", DBG_FUNC_MSG << "Unknown metric family \"" << family << "\".\n");
+		return;
+	}
+
+	std::string line(family);
+	if (!labels.empty()) {
+		line += '{';
+		for (std::size_t i = 0; i < labels.size(); ++i) {
+			if (i != 0) {
+				line += ',';
+			}
+			line += labels[i].first + "=\"" + escape_label_value(labels[i].second) + "\"";
+		}
+		line += '}';
+	}
+	line += ' ';
+	line += value;
+	line += '\n';
+
+	samples_[std::string(family)].push_back(std::move(line));
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,98 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_METRICS_H
+#define STORAGE_METRICS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "storage_device.h"
+
+
+
+/// Metric labels: (name, value) pairs
+using StorageMetricsLabels = std::vector<std::pair<std::string, std::string>>;
+
+
+
+/// Pre-serialized sample lines of a StorageMetricsWriter, one buffer per metric family
+/// (in the StorageMetricsWriter::get_text() order). These can be cached (e.g. per drive) and
+/// joined with StorageMetricsWriter::join_family_texts() without formatting the samples again.
+using StorageMetricsFamilyTexts = std::vector<std::string>;
+
+
+
+/// Collects metric samples and formats them in OpenMetrics / Prometheus text format.
+/// The samples are grouped by metric family, as the format requires, so the
+/// samples of multiple drives may be added (or merged) in any order.
+/// All the metric families are gauges (the raw SMART values are not guaranteed to be monotonic).
+class StorageMetricsWriter {
+	public:
+
+		/// Add a sample. \c family must be one of the families known to this class
+		/// (see storage_metrics.cpp); unknown families are ignored.
+		void add_sample(std::string_view family, const StorageMetricsLabels& labels, double value);
+
+		/// Add an integer sample. Integers are stored exactly (raw values may exceed double precision).
+		void add_sample(std::string_view family, const StorageMetricsLabels& labels, std::int64_t value);
+
+
+		/// Add all the metrics of a drive with fetched full data: health, temperature,
+		/// ATA attributes and statistics, NVMe health counters, self-test status and warning level.
+		void add_drive(const StorageDevice& drive);
+
+
+		/// Add the samples of another writer
+		void merge(const StorageMetricsWriter& other);
+
+
+		/// Get the formatted text, terminated by "# EOF".
+		[[nodiscard]] std::string get_text() const;
+
+
+		/// Get the sample lines of each metric family, for caching
+		[[nodiscard]] StorageMetricsFamilyTexts get_family_texts() const;
+
+		/// Get the same text as get_text() of a writer with all of \c parts merged, by concatenating
+		/// the buffers of each family. nullptr parts are skipped.
+		[[nodiscard]] static std::string join_family_texts(const std::vector<const StorageMetricsFamilyTexts*>& parts);
+
+
+		/// Get the labels identifying a drive
+		[[nodiscard]] static StorageMetricsLabels get_drive_labels(const StorageDevice& drive);
+
+
+		/// Escape a label value
+		[[nodiscard]] static std::string escape_label_value(std::string_view value);
+
+
+	private:
+
+		/// Add a formatted sample
+		void add_sample_line(std::string_view family, const StorageMetricsLabels& labels, const std::string& value);
+
+
+		std::map<std::string, std::vector<std::string>, std::less<>> samples_;  ///< Family name -> sample lines
+
+};
+
+
+
+
+
+#endif
+
+/// @}
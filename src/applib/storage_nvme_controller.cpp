@@ -0,0 +1,182 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+
+#include "hz/string_num.h"
+#include "rconfig/rconfig.h"
+#include "app_regex.h"
+
+#include "storage_nvme_controller.h"
+
+
+
+namespace {
+
+	/// Cached controller data
+	struct CachedNvmeControllerData {
+		std::chrono::steady_clock::time_point fetch_time;  ///< When the data was stored
+		std::string source_device;  ///< Device the data was fetched through
+		StorageNvmeControllerData data;  ///< Controller data
+	};
+
+
+	/// Controller data cache with its mutex
+	struct NvmeControllerCache {
+		std::mutex mutex;  ///< Protects controllers
+		std::map<std::string, CachedNvmeControllerData> controllers;  ///< Key -> data
+	};
+
+
+	/// Get the cache
+	NvmeControllerCache& get_nvme_controller_cache()
+	{
+		static NvmeControllerCache cache;
+		return cache;
+	}
+
+
+	/// Get "system/nvme_controller_data_ttl_sec"
+	std::chrono::seconds get_nvme_controller_data_ttl()
+	{
+		return std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/nvme_controller_data_ttl_sec")));
+	}
+
+}
+
+
+
+std::optional<StorageNvmeDeviceName> storage_nvme_parse_device_name(const std::string& device)
+{
+	std::string controller, namespace_id_str;
+	if (!app_regex_full_match("/^(.*nvme[0-9]+)(?:ns?([0-9]+))?$/", device, {&controller, &namespace_id_str})) {
+		return std::nullopt;
+	}
+	StorageNvmeDeviceName name;
+	name.controller = controller;
+	if (!namespace_id_str.empty()) {
+		int namespace_id = 0;
+		if (!hz::string_is_numeric_nolocale(namespace_id_str, namespace_id, false)) {
+			return std::nullopt;
+		}
+		name.namespace_id = namespace_id;
+	}
+	return name;
+}
+
+
+
+bool storage_nvme_get_property_is_controller_scoped(const StorageProperty& p)
+{
+	if (p.section != StoragePropertySection::Info) {
+		return true;
+	}
+	// These are reported in the info section, but come from the SMART / Health Information log.
+	return p.generic_name == "temperature/current"
+			|| p.generic_name == "power_cycle_count"
+			|| p.generic_name == "power_on_time/hours";
+}
+
+
+
+std::vector<StorageProperty> storage_nvme_get_controller_properties(const StoragePropertyRepository& repository)
+{
+	std::vector<StorageProperty> properties;
+	for (const auto& p : repository.get_properties()) {
+		if (storage_nvme_get_property_is_controller_scoped(p)) {
+			properties.push_back(p);
+		}
+	}
+	return properties;
+}
+
+
+
+void storage_nvme_merge_controller_properties(StoragePropertyRepository& repository,
+		const std::vector<StorageProperty>& controller_properties)
+{
+	// Section is a part of the key, so that the same names in different sections are kept
+	auto get_key = [](const StorageProperty& p) {
+		return std::to_string(static_cast<int>(p.section)) + "/" + p.generic_name;
+	};
+
+	std::unordered_set<std::string> existing;
+	for (const auto& p : repository.get_properties()) {
+		existing.insert(get_key(p));
+	}
+
+	std::vector<StorageProperty> properties = repository.get_properties();
+	for (const auto& p : controller_properties) {
+		if (!existing.contains(get_key(p))) {
+			properties.push_back(p);
+		}
+	}
+	repository.set_properties(std::move(properties));  // groups them by section
+}
+
+
+
+std::string storage_nvme_controller_get_key(const std::string& remote_host,
+		const std::string& controller_device, StorageFetchProfile profile)
+{
+	return remote_host + "\n" + controller_device + "\n" + StorageFetchProfileExt::get_storable_name(profile);
+}
+
+
+
+std::optional<StorageNvmeControllerData> storage_nvme_controller_cache_get(const std::string& key,
+		const std::string& requesting_device)
+{
+	const auto ttl = get_nvme_controller_data_ttl();
+	auto& cache = get_nvme_controller_cache();
+	const std::scoped_lock lock(cache.mutex);
+	if (auto iter = cache.controllers.find(key); iter != cache.controllers.end()) {
+		if (std::chrono::steady_clock::now() - iter->second.fetch_time >= ttl) {
+			cache.controllers.erase(iter);
+			return std::nullopt;
+		}
+		if (iter->second.source_device != requesting_device) {
+			return iter->second.data;
+		}
+	}
+	return std::nullopt;
+}
+
+
+
+void storage_nvme_controller_cache_store(const std::string& key, const std::string& source_device,
+		StorageNvmeControllerData data)
+{
+	auto& cache = get_nvme_controller_cache();
+	const std::scoped_lock lock(cache.mutex);
+	auto& cached = cache.controllers[key];
+	cached.fetch_time = std::chrono::steady_clock::now();
+	cached.source_device = source_device;
+	cached.data = std::move(data);
+}
+
+
+
+void storage_nvme_controller_cache_clear()
+{
+	auto& cache = get_nvme_controller_cache();
+	const std::scoped_lock lock(cache.mutex);
+	cache.controllers.clear();
+}
+
+
+
+
+/// @}
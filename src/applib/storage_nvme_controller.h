@@ -0,0 +1,96 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_NVME_CONTROLLER_H
+#define STORAGE_NVME_CONTROLLER_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "storage_fetch_profile.h"
+#include "storage_property.h"
+#include "storage_property_repository.h"
+
+
+
+/*
+The namespaces of an NVMe controller (e.g. /dev/nvme0n1 and /dev/nvme0n2, and the controller
+itself, /dev/nvme0) share the controller's health information, error log and self-test log.
+When one of them is fully fetched, its controller-scoped properties are cached for a short time
+("system/nvme_controller_data_ttl_sec"), so that the full fetches of the other namespaces
+run "smartctl --info" only (the namespace-specific part) and merge the cached properties in.
+*/
+
+
+
+/// Device file of an NVMe namespace or controller, split into parts
+struct StorageNvmeDeviceName {
+	std::string controller;  ///< Controller device file, e.g. "/dev/nvme0"
+	std::optional<int> namespace_id;  ///< Namespace ID, e.g. 1 for "/dev/nvme0n1". Unset for the controller itself.
+};
+
+
+/// Parse an NVMe device file name: "/dev/nvme0n1" (Linux), "/dev/nvme0ns1" (FreeBSD) or "/dev/nvme0".
+/// \return std::nullopt if it's not an NVMe device file.
+[[nodiscard]] std::optional<StorageNvmeDeviceName> storage_nvme_parse_device_name(const std::string& device);
+
+
+/// Check whether a property of an NVMe device describes the controller (health, attributes, logs)
+/// rather than the namespace (capacity, block size, etc.).
+[[nodiscard]] bool storage_nvme_get_property_is_controller_scoped(const StorageProperty& p);
+
+
+/// Get the controller-scoped properties of a (parsed) NVMe device
+[[nodiscard]] std::vector<StorageProperty> storage_nvme_get_controller_properties(const StoragePropertyRepository& repository);
+
+
+/// Add the controller properties to the namespace properties, unless the repository already has
+/// a property with the same name in the same section.
+void storage_nvme_merge_controller_properties(StoragePropertyRepository& repository,
+		const std::vector<StorageProperty>& controller_properties);
+
+
+
+/// Controller-scoped properties of an NVMe controller, as fetched through one of its devices
+struct StorageNvmeControllerData {
+	std::shared_ptr<const std::vector<StorageProperty>> properties;  ///< Processed controller-scoped properties, never nullptr
+	std::uint64_t output_hash = 0;  ///< Content hash of the output they were parsed from
+};
+
+
+/// Get the cache key of a controller. The data fetched with different profiles is not shared.
+[[nodiscard]] std::string storage_nvme_controller_get_key(const std::string& remote_host,
+		const std::string& controller_device, StorageFetchProfile profile);
+
+
+/// Get the cached controller data, unless it expired, or it was fetched through \c requesting_device
+/// (that device is refreshed, so the data must be fetched again). Thread-safe.
+[[nodiscard]] std::optional<StorageNvmeControllerData> storage_nvme_controller_cache_get(const std::string& key,
+		const std::string& requesting_device);
+
+
+/// Store the controller data fetched through \c source_device, replacing any previous one. Thread-safe.
+void storage_nvme_controller_cache_store(const std::string& key, const std::string& source_device,
+		StorageNvmeControllerData data);
+
+
+/// Forget the cached controller data. Thread-safe.
+void storage_nvme_controller_cache_clear();
+
+
+
+
+#endif
+
+/// @}
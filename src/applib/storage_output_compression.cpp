@@ -0,0 +1,186 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <gio/gio.h>  // GZlibCompressor
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <array>
+#include <memory>
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"  // string_to_lower_copy
+
+#include "storage_output_compression.h"
+
+
+
+namespace {
+
+	/// Size of the chunks the data is (de)compressed in
+	constexpr std::size_t output_conversion_chunk_size = 64UL * 1024UL;
+
+
+	/// Run the data through a zlib (de)compressor, chunk by chunk. Stop if the output exceeds \c max_size.
+	hz::ExpectedValue<std::string, StorageOutputFileError> storage_output_convert(GConverter* converter,
+			std::string_view input, std::uintmax_t max_size)
+	{
+		std::string output;
+		std::array<char, output_conversion_chunk_size> buf = {0};
+		while (true) {
+			gsize bytes_read = 0, bytes_written = 0;
+			GError* error = nullptr;
+			const GConverterResult result = g_converter_convert(converter, input.data(), input.size(),
+					buf.data(), buf.size(), G_CONVERTER_INPUT_AT_END, &bytes_read, &bytes_written, &error);
+			if (result == G_CONVERTER_ERROR) {
+				const std::string message = (error ? error->message : "unknown error");
+				if (error) {
+					g_error_free(error);
+				}
+				return hz::Unexpected(StorageOutputFileError::ConversionError,
+						Glib::ustring::compose(_("Cannot decompress the data: %1"), message));
+			}
+			input.remove_prefix(bytes_read);
+			if (output.size() + bytes_written > max_size) {
+				return hz::Unexpected(StorageOutputFileError::TooLarge, _("The decompressed data is too large."));
+			}
+			output.append(buf.data(), bytes_written);
+			if (result == G_CONVERTER_FINISHED) {
+				break;
+			}
+		}
+		return output;
+	}
+
+}
+
+
+
+StorageOutputCompression storage_output_detect_compression(std::string_view data)
+{
+	if (data.starts_with("\x1f\x8b")) {
+		return StorageOutputCompression::Gzip;
+	}
+	if (data.starts_with("\x28\xb5\x2f\xfd")) {
+		return StorageOutputCompression::Zstd;
+	}
+	return StorageOutputCompression::None;
+}
+
+
+
+StorageOutputCompression storage_output_get_file_compression(const hz::fs::path& file)
+{
+	const std::string ext = hz::string_to_lower_copy(hz::fs_path_to_string(file.extension()));
+	if (ext == ".gz" || ext == ".tgz") {
+		return StorageOutputCompression::Gzip;
+	}
+	if (ext == ".zst") {
+		return StorageOutputCompression::Zstd;
+	}
+	return StorageOutputCompression::None;
+}
+
+
+
+hz::fs::path storage_output_strip_compression_extension(const hz::fs::path& file)
+{
+	if (hz::string_to_lower_copy(hz::fs_path_to_string(file.extension())) == ".tgz") {
+		return hz::fs::path(file).replace_extension(".tar");
+	}
+	if (storage_output_get_file_compression(file) != StorageOutputCompression::None) {
+		return hz::fs::path(file).replace_extension();
+	}
+	return file;
+}
+
+
+
+hz::ExpectedValue<std::string, StorageOutputFileError> storage_output_compress(
+		std::string_view data, StorageOutputCompression compression)
+{
+	switch (compression) {
+		case StorageOutputCompression::None:
+			return std::string(data);
+		case StorageOutputCompression::Gzip:
+		{
+			std::unique_ptr<GZlibCompressor, decltype(&g_object_unref)> compressor(
+					g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1), &g_object_unref);
+			return storage_output_convert(G_CONVERTER(compressor.get()), data, static_cast<std::uintmax_t>(-1));
+		}
+		case StorageOutputCompression::Zstd:
+			break;
+	}
+	return hz::Unexpected(StorageOutputFileError::UnsupportedCompression, _("Zstandard compression is not supported."));
+}
+
+
+
+hz::ExpectedValue<std::string, StorageOutputFileError> storage_output_decompress(
+		std::string_view data, std::uintmax_t max_size)
+{
+	switch (storage_output_detect_compression(data)) {
+		case StorageOutputCompression::None:
+			if (data.size() > max_size) {
+				return hz::Unexpected(StorageOutputFileError::TooLarge, _("The data is too large."));
+			}
+			return std::string(data);
+		case StorageOutputCompression::Gzip:
+		{
+			std::unique_ptr<GZlibDecompressor, decltype(&g_object_unref)> decompressor(
+					g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP), &g_object_unref);
+			return storage_output_convert(G_CONVERTER(decompressor.get()), data, max_size);
+		}
+		case StorageOutputCompression::Zstd:
+			break;
+	}
+	return hz::Unexpected(StorageOutputFileError::UnsupportedCompression, _("Zstandard-compressed files are not supported."));
+}
+
+
+
+hz::ExpectedVoid<StorageOutputFileError> storage_output_save(const hz::fs::path& file, std::string_view data)
+{
+	const StorageOutputCompression compression = storage_output_get_file_compression(file);
+	std::string compressed;
+	if (compression != StorageOutputCompression::None) {
+		auto compress_status = storage_output_compress(data, compression);
+		if (!compress_status) {
+			return hz::Unexpected(StorageOutputFileError(compress_status.error().data()), compress_status.error().message());
+		}
+		compressed = std::move(compress_status.value());
+		data = compressed;
+	}
+	if (auto ec = hz::fs_file_put_contents(file, data)) {
+		return hz::Unexpected(StorageOutputFileError::WriteError, ec.message());
+	}
+	return {};
+}
+
+
+
+hz::ExpectedValue<std::string, StorageOutputFileError> storage_output_load(
+		const hz::fs::path& file, std::uintmax_t max_size)
+{
+	std::string contents;
+	if (auto ec = hz::fs_file_get_contents(file, contents, max_size)) {
+		return hz::Unexpected(StorageOutputFileError::ReadError, ec.message());
+	}
+	if (storage_output_detect_compression(contents) == StorageOutputCompression::None) {
+		return contents;
+	}
+	debug_out_dump("app", DBG_FUNC_MSG << "Decompressing " << hz::fs_path_to_string(file) << ".\n");
+	return storage_output_decompress(contents, max_size);
+}
+
+
+
+
+/// @}
@@ -0,0 +1,82 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_OUTPUT_COMPRESSION_H
+#define STORAGE_OUTPUT_COMPRESSION_H
+
+#include <cstdint>  // std::uintmax_t
+#include <string>
+#include <string_view>
+
+#include "hz/error_container.h"
+#include "hz/fs.h"
+
+
+
+/// Compression of a saved smartctl output
+enum class StorageOutputCompression {
+	None,  ///< Not compressed
+	Gzip,  ///< gzip (".gz")
+	Zstd,  ///< Zstandard (".zst"). Recognized, but not supported.
+};
+
+
+
+/// Errors of reading and writing (compressed) smartctl outputs
+enum class StorageOutputFileError {
+	ReadError,  ///< Cannot read the file
+	WriteError,  ///< Cannot write the file
+	UnsupportedCompression,  ///< The compression format is not supported
+	ConversionError,  ///< The data cannot be compressed or decompressed (e.g. it's corrupted)
+	TooLarge,  ///< The decompressed data exceeds the size limit
+};
+
+
+
+/// Detect the compression of the data by its magic bytes
+[[nodiscard]] StorageOutputCompression storage_output_detect_compression(std::string_view data);
+
+
+/// Get the compression to use for a file, judging by its extension (".gz", ".zst")
+[[nodiscard]] StorageOutputCompression storage_output_get_file_compression(const hz::fs::path& file);
+
+
+/// Remove the compression extension, if any (e.g. "a.json.gz" -> "a.json")
+[[nodiscard]] hz::fs::path storage_output_strip_compression_extension(const hz::fs::path& file);
+
+
+/// Compress the data
+[[nodiscard]] hz::ExpectedValue<std::string, StorageOutputFileError> storage_output_compress(
+		std::string_view data, StorageOutputCompression compression);
+
+
+/// Decompress the data if it's compressed (detected by storage_output_detect_compression()),
+/// otherwise return it as is. The decompression is streamed in chunks and stops as soon as
+/// the output exceeds \c max_size, so a small corrupted or malicious file can't exhaust the memory.
+[[nodiscard]] hz::ExpectedValue<std::string, StorageOutputFileError> storage_output_decompress(
+		std::string_view data, std::uintmax_t max_size);
+
+
+/// Write the data to a file, compressed according to the file extension
+/// (see storage_output_get_file_compression()).
+[[nodiscard]] hz::ExpectedVoid<StorageOutputFileError> storage_output_save(const hz::fs::path& file, std::string_view data);
+
+
+/// Read a file, decompressing it if needed. \c max_size limits both the file size and the decompressed size.
+[[nodiscard]] hz::ExpectedValue<std::string, StorageOutputFileError> storage_output_load(
+		const hz::fs::path& file, std::uintmax_t max_size);
+
+
+
+
+#endif
+
+/// @}
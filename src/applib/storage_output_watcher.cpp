@@ -0,0 +1,224 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "build_config.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>  // std::memcpy
+#include <string>
+#include <utility>
+
+#ifdef CONFIG_KERNEL_LINUX
+	#include <sys/inotify.h>
+	#include <unistd.h>  // close(), read()
+	#include <cerrno>
+#endif
+
+#include "hz/debug.h"
+
+#include "storage_output_watcher.h"
+
+
+
+StorageOutputWatcher::~StorageOutputWatcher()
+{
+	stop();
+}
+
+
+
+bool StorageOutputWatcher::start(const hz::fs::path& dir)
+{
+#ifdef CONFIG_KERNEL_LINUX
+	stop();
+
+	fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd_ < 0) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot initialize inotify: " << std::strerror(errno) << "\n");
+		return false;
+	}
+
+	// The outputs are usually rewritten in place (shell redirection), so wait for them to be closed.
+	// Atomic writes (to a temporary file, then renamed) are seen as moves.
+	const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+	if (::inotify_add_watch(fd_, hz::fs_path_to_string(dir).c_str(), mask) < 0) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot watch directory " << dir << ": " << std::strerror(errno) << "\n");
+		::close(fd_);
+		fd_ = -1;
+		return false;
+	}
+	dir_ = dir;
+
+	channel_ = g_io_channel_unix_new(fd_);
+	g_io_channel_set_encoding(channel_, nullptr, nullptr);  // binary IO
+
+	main_context_ = g_main_context_ref_thread_default();
+	GSource* source = g_io_create_watch(channel_, GIOCondition(G_IO_IN | G_IO_ERR | G_IO_HUP));
+	g_source_set_callback(source, reinterpret_cast<GSourceFunc>(reinterpret_cast<void (*)()>(&on_channel_io)), this, nullptr);
+	watch_id_ = g_source_attach(source, main_context_);
+	g_source_unref(source);
+
+	debug_out_info("app", DBG_FUNC_MSG << "Watching directory " << dir << " for smartctl outputs.\n");
+	return true;
+#else
+	static_cast<void>(dir);
+	return false;
+#endif
+}
+
+
+
+void StorageOutputWatcher::stop()
+{
+	if (watch_id_ != 0) {
+		GSource* source = g_main_context_find_source_by_id(main_context_, watch_id_);
+		if (source)
+			g_source_destroy(source);
+		watch_id_ = 0;
+	}
+	if (main_context_) {
+		g_main_context_unref(main_context_);
+		main_context_ = nullptr;
+	}
+	if (channel_) {
+		g_io_channel_unref(channel_);
+		channel_ = nullptr;
+	}
+#ifdef CONFIG_KERNEL_LINUX
+	if (fd_ >= 0) {
+		::close(fd_);  // removes the watch
+	}
+#endif
+	fd_ = -1;
+}
+
+
+
+bool StorageOutputWatcher::is_running() const
+{
+	return fd_ >= 0;
+}
+
+
+
+const hz::fs::path& StorageOutputWatcher::get_directory() const
+{
+	return dir_;
+}
+
+
+
+std::vector<hz::fs::path> StorageOutputWatcher::get_files() const
+{
+	std::vector<hz::fs::path> files;
+	std::error_code ec;
+	for (const auto& entry : hz::fs::directory_iterator(dir_, ec)) {
+		if (entry.is_regular_file(ec) && is_output_file_name(hz::fs_path_to_string(entry.path().filename()))) {
+			files.push_back(entry.path());
+		}
+	}
+	if (ec) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot read directory " << dir_ << ": " << ec.message() << "\n");
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+
+
+bool StorageOutputWatcher::is_output_file_name(std::string_view name)
+{
+	return !name.empty() && name.front() != '.' && name.back() != '~';
+}
+
+
+
+sigc::signal<void, const StorageOutputFileEvent&>& StorageOutputWatcher::signal_event()
+{
+	return signal_event_;
+}
+
+
+
+void StorageOutputWatcher::on_fd_readable()
+{
+#ifdef CONFIG_KERNEL_LINUX
+	// The file name -> the last event, in the order of the first events
+	std::vector<std::pair<std::string, StorageOutputFileEvent::Action>> events;
+	bool dir_gone = false;
+
+	alignas(inotify_event) std::array<char, 16384> buffer = {};
+	while (fd_ >= 0) {
+		const ssize_t len = ::read(fd_, buffer.data(), buffer.size());
+		if (len <= 0) {
+			break;  // EAGAIN (no more events) or error
+		}
+		std::size_t pos = 0;
+		while (pos + sizeof(inotify_event) <= static_cast<std::size_t>(len)) {
+			inotify_event header = {};
+			std::memcpy(&header, buffer.data() + pos, sizeof(header));
+			const char* name_ptr = buffer.data() + pos + sizeof(inotify_event);
+			pos += sizeof(inotify_event) + header.len;
+
+			if ((header.mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) != 0) {
+				dir_gone = true;
+				continue;
+			}
+			const std::string name = (header.len > 0 ? std::string(name_ptr) : std::string());  // NUL-padded
+			if ((header.mask & IN_ISDIR) != 0 || !is_output_file_name(name)) {
+				continue;
+			}
+			const auto action = ((header.mask & (IN_DELETE | IN_MOVED_FROM)) != 0)
+					? StorageOutputFileEvent::Action::Removed : StorageOutputFileEvent::Action::Changed;
+			auto iter = std::find_if(events.begin(), events.end(), [&name](const auto& e) { return e.first == name; });
+			if (iter != events.end()) {
+				iter->second = action;
+			} else {
+				events.emplace_back(name, action);
+			}
+		}
+	}
+
+	for (const auto& [name, action] : events) {
+		StorageOutputFileEvent event;
+		event.action = action;
+		event.file = dir_ / hz::fs_path_from_string(name);
+		debug_out_dump("app", DBG_FUNC_MSG << "Output file "
+				<< (action == StorageOutputFileEvent::Action::Changed ? "changed: " : "removed: ") << event.file << "\n");
+		signal_event_.emit(event);
+	}
+
+	if (dir_gone) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Watched directory " << dir_ << " is gone, no more output changes will be received.\n");
+		stop();
+	}
+#endif
+}
+
+
+
+gboolean StorageOutputWatcher::on_channel_io([[maybe_unused]] GIOChannel* source, GIOCondition cond, gpointer data)
+{
+	auto* self = static_cast<StorageOutputWatcher*>(data);
+	if (cond & (G_IO_ERR | G_IO_HUP)) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Inotify error, no more output changes will be received.\n");
+		self->watch_id_ = 0;  // removed by returning false
+		return FALSE;
+	}
+	self->on_fd_readable();
+	return self->is_running() ? TRUE : FALSE;
+}
+
+
+
+
+/// @}
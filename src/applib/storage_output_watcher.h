@@ -0,0 +1,118 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_OUTPUT_WATCHER_H
+#define STORAGE_OUTPUT_WATCHER_H
+
+#include <glib.h>
+#include <string_view>
+#include <vector>
+#include <sigc++/sigc++.h>
+
+#include "hz/fs.h"
+
+
+
+/// Change of a smartctl output file in a watched directory
+struct StorageOutputFileEvent {
+
+	/// Event type
+	enum class Action {
+		Changed,  ///< The file was written (or moved into the directory)
+		Removed,  ///< The file was deleted (or moved out of the directory)
+	};
+
+	Action action = Action::Changed;  ///< Event type
+	hz::fs::path file;  ///< The file
+};
+
+
+
+/// Watches a directory of smartctl outputs written by other programs (e.g. the cron job in
+/// contrib/cron-based_noadmin) with inotify (Linux only), so that each output file can be shown
+/// as a (virtual) drive and re-parsed only when it's rewritten, without running any processes.
+/// Only the files which are completely written (closed) are reported.
+/// The inotify descriptor is watched by the thread-default main context of the thread calling start().
+class StorageOutputWatcher {
+	public:
+
+		/// Constructor
+		StorageOutputWatcher() = default;
+
+		/// Deleted
+		StorageOutputWatcher(const StorageOutputWatcher& other) = delete;
+
+		/// Deleted
+		StorageOutputWatcher(StorageOutputWatcher&& other) = delete;
+
+		/// Deleted
+		StorageOutputWatcher& operator=(const StorageOutputWatcher&) = delete;
+
+		/// Deleted
+		StorageOutputWatcher& operator=(StorageOutputWatcher&&) = delete;
+
+		/// Destructor, calls stop().
+		~StorageOutputWatcher();
+
+
+		/// Start watching \c dir (not recursively).
+		/// \return false if not supported on this platform or the directory cannot be watched.
+		bool start(const hz::fs::path& dir);
+
+		/// Stop watching
+		void stop();
+
+		/// Check if start() was successful and stop() wasn't called yet
+		[[nodiscard]] bool is_running() const;
+
+		/// Get the watched directory
+		[[nodiscard]] const hz::fs::path& get_directory() const;
+
+
+		/// Get the output files currently in the watched directory, sorted by name
+		[[nodiscard]] std::vector<hz::fs::path> get_files() const;
+
+
+		/// Check if a file in the watched directory should be treated as a smartctl output.
+		/// Hidden files (e.g. temporary files of atomic writes) and backup files are skipped.
+		[[nodiscard]] static bool is_output_file_name(std::string_view name);
+
+
+		/// Emitted in the main context for each changed or removed output file.
+		/// The events of one inotify read are coalesced, a file is reported once.
+		[[nodiscard]] sigc::signal<void, const StorageOutputFileEvent&>& signal_event();
+
+
+	private:
+
+		/// Read and dispatch all pending events. Called when the descriptor is readable.
+		void on_fd_readable();
+
+		/// Descriptor watch callback
+		static gboolean on_channel_io(GIOChannel* source, GIOCondition cond, gpointer data);
+
+
+		hz::fs::path dir_;  ///< Watched directory
+		int fd_ = -1;  ///< Inotify descriptor
+		GIOChannel* channel_ = nullptr;  ///< Channel of fd_
+		guint watch_id_ = 0;  ///< Watch source of channel_
+		GMainContext* main_context_ = nullptr;  ///< Context the watch is attached to
+
+		sigc::signal<void, const StorageOutputFileEvent&> signal_event_;  ///< Event signal
+
+};
+
+
+
+
+#endif
+
+/// @}
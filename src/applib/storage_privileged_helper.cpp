@@ -0,0 +1,197 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>  // compose()
+#include <glibmm/i18n.h>
+#include <algorithm>  // std::find
+#include <array>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+
+#include "app_regex.h"
+#include "storage_privileged_helper.h"
+
+
+
+namespace {
+
+	/// Global helper and its mutex
+	struct StoragePrivilegedHelperGlobal {
+		std::mutex mutex;  ///< Protects helper
+		StoragePrivilegedHelperPtr helper;  ///< Helper, may be nullptr
+	};
+
+
+	/// Get the global helper holder
+	StoragePrivilegedHelperGlobal& privileged_helper_get_global_ref()
+	{
+		static StoragePrivilegedHelperGlobal global;
+		return global;
+	}
+
+
+	/// The smartctl options the clients send which take no argument (the fetch profiles,
+	/// the self-test abort). Each must be a separate argument, exactly as listed.
+	constexpr auto privileged_helper_plain_options = std::to_array<std::string_view>({
+		"--info", "-i",
+		"--health", "-H",
+		"--capabilities", "-c",
+		"--attributes", "-A",
+		"--xall", "-x",
+		"--all", "-a",
+		"--abort", "-X",
+	});
+
+
+	/// An allowed smartctl option which takes an argument
+	struct PrivilegedHelperArgOption {
+		std::string_view long_name;  ///< Long option, its argument follows "="
+		std::string_view short_name;  ///< Short option, its argument is the next command-line argument
+		std::string_view value_pattern;  ///< Allowed values, a perl-style regex for app_regex_full_match()
+	};
+
+
+	/// The smartctl options the clients send which take an argument, and their allowed values.
+	/// None of the values can name a file.
+	constexpr auto privileged_helper_arg_options = std::to_array<PrivilegedHelperArgOption>({
+		{"--device", "-d", "/^[a-z0-9_]+(?:[,+/][a-z0-9_]+)*$/"},  // "sat", "megaraid,3", "areca,3/1", "sat+megaraid,0"
+		{"--log", "-l", "/^[a-z0-9]+(?:,[a-z0-9]+)*$/"},  // "xerror,50,error", "devstat"
+		{"--test", "-t", "/^(?:short|long|conveyance|offline|select,[0-9]+-[0-9]+)$/"},
+		{"--smart", "-s", "/^(?:on|off)$/"},
+		{"--offlineauto", "-o", "/^(?:on|off)$/"},
+		{"--saveauto", "-S", "/^(?:on|off)$/"},
+		{"--nocheck", "-n", "/^(?:never|sleep|standby|idle)(?:,[qp]|,[0-9]+)*$/"},
+		{"--tolerance", "-T", "/^(?:normal|conservative|permissive|verypermissive)$/"},
+		{"--format", "-f", "/^(?:old|brief|hex|hex,id|hex,val)$/"},
+		{"--get", "-g", "/^(?:all|aam|apm|dsn|lookahead|security|wcache|rcache|wcreorder|wcache-sct)$/"},
+	});
+
+
+	/// Check the options of a client's smartctl request against the lists above.
+	/// getopt() accepts clustered short options ("-iB/etc/shadow") and abbreviated long ones
+	/// ("--dr=/etc/shadow"), so anything not listed exactly is rejected.
+	/// \return The first rejected option, or std::nullopt if all of them are allowed.
+	std::optional<std::string> privileged_helper_find_disallowed_option(const std::vector<std::string>& options)
+	{
+		for (std::size_t i = 0; i < options.size(); ++i) {
+			const std::string& option = options[i];
+			if (std::find(privileged_helper_plain_options.begin(), privileged_helper_plain_options.end(), option)
+					!= privileged_helper_plain_options.end()) {
+				continue;
+			}
+			// JSON output, with its modifiers ("--json=c", "--json=o")
+			if (app_regex_full_match("/^--json(?:=[cgiosuvy]+)?$/", option)) {
+				continue;
+			}
+
+			bool allowed = false;
+			for (const auto& arg_option : privileged_helper_arg_options) {
+				std::string value;
+				if (option == arg_option.short_name) {
+					if (i + 1 >= options.size()) {
+						break;
+					}
+					value = options[++i];
+				} else if (option.starts_with(std::string(arg_option.long_name) + "=")) {
+					value = option.substr(arg_option.long_name.size() + 1);
+				} else {
+					continue;
+				}
+				allowed = app_regex_full_match(std::string(arg_option.value_pattern), value);
+				break;
+			}
+			if (!allowed) {
+				return option;
+			}
+		}
+		return std::nullopt;
+	}
+
+}
+
+
+
+void storage_privileged_helper_set_global(StoragePrivilegedHelperPtr helper)
+{
+	auto& global = privileged_helper_get_global_ref();
+	const std::scoped_lock lock(global.mutex);
+	global.helper = std::move(helper);
+}
+
+
+
+StoragePrivilegedHelperPtr storage_privileged_helper_get_global()
+{
+	auto& global = privileged_helper_get_global_ref();
+	const std::scoped_lock lock(global.mutex);
+	return global.helper;
+}
+
+
+
+hz::ExpectedValue<std::vector<StorageDevicePtr>, StoragePrivilegedHelperError>
+		storage_privileged_helper_load_drives(StoragePrivilegedHelper& helper)
+{
+	auto cached_drives = helper.get_drives();
+	if (!cached_drives) {
+		return hz::Unexpected(StoragePrivilegedHelperError(cached_drives.error().data()), cached_drives.error().message());
+	}
+
+	std::vector<StorageDevicePtr> drives;
+	for (auto& cached : cached_drives.value()) {
+		auto drive = std::make_shared<StorageDevice>(cached.device, cached.type_argument);
+		if (!cached.basic_output.empty() || !cached.full_output.empty()) {
+			auto load_status = drive->load_cached_outputs(std::move(cached.basic_output), std::move(cached.full_output),
+					cached.full_output_age);
+			if (!load_status) {
+				// The drive will be fetched as usual
+				debug_out_warn("app", DBG_FUNC_MSG << "Cannot load the cached data of " << drive->get_device_with_type()
+						<< ": " << load_status.error().message() << "\n");
+				drive->clear_outputs();
+				drive->clear_parse_results();
+			}
+		}
+		drives.push_back(drive);
+	}
+	return drives;
+}
+
+
+
+hz::ExpectedVoid<StoragePrivilegedHelperError> storage_privileged_helper_check_request(
+		const std::string& device, const std::vector<std::string>& options)
+{
+	// No relative components, so that the path stays in /dev
+	if (!hz::string_begins_with(device, "/dev/") || device.find("/../") != std::string::npos
+			|| hz::string_ends_with(device, "/..")) {
+		return hz::Unexpected(StoragePrivilegedHelperError::InvalidRequest, _("Invalid device name specified."));
+	}
+
+	// Smartctl runs as root there, so only the options the clients need are allowed.
+	// Some of the others take file names (e.g. the drive database).
+	if (auto disallowed = privileged_helper_find_disallowed_option(options)) {
+		return hz::Unexpected(StoragePrivilegedHelperError::InvalidRequest,
+				Glib::ustring::compose(_("Option %1 is not allowed."), disallowed.value()));
+	}
+	return {};
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,139 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_PRIVILEGED_HELPER_H
+#define STORAGE_PRIVILEGED_HELPER_H
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "hz/error_container.h"
+
+#include "app_cancellation.h"
+#include "command_executor.h"  // CommandOutputPtr
+#include "storage_device.h"
+
+
+
+/// Well-known D-Bus name of the privileged helper ("gsmartcontrol-agent --dbus")
+inline constexpr const char* storage_helper_dbus_name = "org.gsmartcontrol.Agent";
+
+/// D-Bus object path of the privileged helper
+inline constexpr const char* storage_helper_dbus_object_path = "/org/gsmartcontrol/Agent";
+
+/// D-Bus interface of the privileged helper
+inline constexpr const char* storage_helper_dbus_interface = "org.gsmartcontrol.Agent1";
+
+
+
+/// Privileged helper errors
+enum class StoragePrivilegedHelperError {
+	Unavailable,  ///< The helper is not running and cannot be started, or denied the request
+	InvalidRequest,  ///< The helper refuses to run such a command
+	ExecutionError,  ///< smartctl failed in the helper
+	InvalidReply,  ///< The helper replied with something unexpected
+};
+
+
+
+/// A privileged process (normally "gsmartcontrol-agent --dbus", running as root) which
+/// detects the local drives, keeps their data cached between the GUI launches, and runs
+/// smartctl on behalf of an unprivileged GUI. This way the GUI doesn't have to run as root,
+/// and shows the drives without running smartctl at startup.
+/// This is the transport-neutral interface, see GscPrivilegedHelper for the D-Bus client.
+class StoragePrivilegedHelper {
+	public:
+
+		/// A drive detected by the helper, with the data it has cached
+		struct CachedDrive {
+			std::string device;  ///< Device file
+			std::string type_argument;  ///< smartctl -d argument, may be empty
+			std::string basic_output;  ///< Cached "smartctl --info" output, may be empty
+			std::string full_output;  ///< Cached full output, empty if not fetched yet
+			std::optional<std::chrono::seconds> full_output_age;  ///< Age of full_output, unset if not fetched yet
+		};
+
+
+		/// Defaulted
+		StoragePrivilegedHelper() = default;
+
+		/// Deleted
+		StoragePrivilegedHelper(const StoragePrivilegedHelper& other) = delete;
+
+		/// Deleted
+		StoragePrivilegedHelper(StoragePrivilegedHelper&& other) = delete;
+
+		/// Deleted
+		StoragePrivilegedHelper& operator=(const StoragePrivilegedHelper& other) = delete;
+
+		/// Deleted
+		StoragePrivilegedHelper& operator=(StoragePrivilegedHelper&& other) = delete;
+
+		/// Virtual destructor
+		virtual ~StoragePrivilegedHelper() = default;
+
+
+		/// Get the local drives detected by the helper, with their cached data
+		[[nodiscard]] virtual hz::ExpectedValue<std::vector<CachedDrive>, StoragePrivilegedHelperError> get_drives() = 0;
+
+		/// Run smartctl on \c device in the helper, with \c options (the device options and the
+		/// command options, without the default ones, which the helper adds itself).
+		/// The output is normalized, like execute_smartctl() does, and is set on ExecutionError
+		/// too (smartctl may explain the error there). While waiting, the thread-default
+		/// main context is iterated, and the command is abandoned if \c cancellation is cancelled.
+		/// On Unavailable, the caller runs smartctl itself (e.g. the helper is not installed).
+		/// May be called from any thread.
+		[[nodiscard]] virtual hz::ExpectedVoid<StoragePrivilegedHelperError> execute_smartctl(const std::string& device,
+				const std::vector<std::string>& options, CommandOutputPtr& smartctl_output,
+				const AppCancellationPtr& cancellation) = 0;
+
+};
+
+
+/// A reference-counting pointer to StoragePrivilegedHelper
+using StoragePrivilegedHelperPtr = std::shared_ptr<StoragePrivilegedHelper>;
+
+
+
+/// Set the helper which runs smartctl for the local drives (see StorageDevice::execute_device_smartctl())
+/// and detects them (see StorageDetector::detect()). nullptr (default) runs smartctl directly.
+void storage_privileged_helper_set_global(StoragePrivilegedHelperPtr helper);
+
+
+/// Get the helper set by storage_privileged_helper_set_global(), may be nullptr
+[[nodiscard]] StoragePrivilegedHelperPtr storage_privileged_helper_get_global();
+
+
+
+/// Get the drives of the helper, loading their cached data (see StorageDevice::load_cached_outputs()).
+/// The drives without cached data are returned without any data.
+[[nodiscard]] hz::ExpectedValue<std::vector<StorageDevicePtr>, StoragePrivilegedHelperError>
+		storage_privileged_helper_load_drives(StoragePrivilegedHelper& helper);
+
+
+/// Check a smartctl request of an unprivileged client on the helper side. The device must be
+/// a device file, and the options must be the ones the clients send (the fetch profiles,
+/// "-d <type>", self-test start and abort, SMART and automatic offline / autosave on/off,
+/// the JSON and standby options), each one as a separate argument, with its value checked.
+/// Anything else is rejected, so that smartctl can't be made to read other files (e.g. as the drive database).
+[[nodiscard]] hz::ExpectedVoid<StoragePrivilegedHelperError> storage_privileged_helper_check_request(
+		const std::string& device, const std::vector<std::string>& options);
+
+
+
+
+
+#endif
+
+/// @}
@@ -10,37 +10,86 @@ Copyright:
 /// @{
 
 #include <glibmm.h>
+#include <algorithm>  // std::count
 #include <cstddef>
 #include <chrono>
-#include <ios>
+#include <iterator>  // std::back_inserter
 #include <map>
 #include <ostream>  // not iosfwd - it doesn't work
-#include <sstream>
 #include <locale>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <variant>
 
+#include "fmt/format.h"
+#include "fmt/ranges.h"  // fmt::join
 
 #include "hz/string_num.h"  // number_to_string
-#include "hz/stream_cast.h"  // stream_cast<>
 #include "hz/format_unit.h"  // format_time_length
-#include "hz/string_algo.h"  // string_join
+#include "hz/string_algo.h"  // string_join, string_replace_copy
 
 #include "storage_property.h"
+#include "warning_colors.h"  // storage_property_get_warning_reason
 
 
 
-std::ostream& operator<< (std::ostream& os, const AtaStorageTextCapability& p)
+namespace {
+
+	/// Write the contents of a buffer to a stream
+	std::ostream& write_buffer(std::ostream& os, const fmt::memory_buffer& buf)
+	{
+		return os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+	}
+
+
+	/// Format a value to a buffer and write it to a stream
+	template<typename T>
+	std::ostream& write_formatted(std::ostream& os, const T& value)
+	{
+		fmt::memory_buffer buf;
+		fmt::format_to(std::back_inserter(buf), "{}", value);
+		return write_buffer(os, buf);
+	}
+
+
+	/// Get the system locale, used for the thousands separators. It's expensive to
+	/// construct, so it's created once.
+	const std::locale& get_system_locale()
+	{
+		static const std::locale system_locale = []() {
+			try {
+				return std::locale("");
+			}
+			catch (const std::runtime_error& e) {
+				// something is wrong with system locale, can't do anything here.
+				return std::locale::classic();
+			}
+		}();
+		return system_locale;
+	}
+
+}
+
+
+
+fmt::format_context::iterator fmt::formatter<AtaStorageTextCapability>::format(const AtaStorageTextCapability& p, fmt::format_context& ctx) const
 {
-	os
-			// << p.name << ": "
-			<< p.flag_value;
-	for (auto&& v : p.strvalues) {
-		os << "\n\t" << v;
+	fmt::memory_buffer buf;
+	auto out = std::back_inserter(buf);
+	fmt::format_to(out, "{}", p.flag_value);
+	for (const auto& v : p.strvalues) {
+		fmt::format_to(out, "\n\t{}", v);
 	}
-	return os;
+	return formatter<std::string_view>::format(std::string_view(buf.data(), buf.size()), ctx);
+}
+
+
+
+std::ostream& operator<< (std::ostream& os, const AtaStorageTextCapability& p)
+{
+	return write_formatted(os, p);
 }
 
 
@@ -95,31 +144,31 @@ std::string AtaStorageAttribute::format_raw_value() const
 {
 	// If it's fully a number, format it with commas
 	if (hz::number_to_string_nolocale(raw_value_int) == raw_value) {
-		std::stringstream ss;
-		try {
-			ss.imbue(std::locale(""));
-		}
-		catch (const std::runtime_error& e) {
-			// something is wrong with system locale, can't do anything here.
-		}
-		ss << std::fixed << raw_value_int;
-		return ss.str();
+		return fmt::format(get_system_locale(), "{:L}", raw_value_int);
 	}
 	return raw_value;
 }
 
 
 
-std::ostream& operator<< (std::ostream& os, const AtaStorageAttribute& p)
+fmt::format_context::iterator fmt::formatter<AtaStorageAttribute>::format(const AtaStorageAttribute& p, fmt::format_context& ctx) const
 {
-//	os << p.name << ": "
+	fmt::memory_buffer buf;
+	auto out = std::back_inserter(buf);
 	if (p.value.has_value()) {
-		os << static_cast<int>(p.value.value());
+		fmt::format_to(out, "{}", static_cast<int>(p.value.value()));
 	} else {
-		os << "-";
+		fmt::format_to(out, "-");
 	}
-	os << " (" << p.format_raw_value() << ")";
-	return os;
+	fmt::format_to(out, " ({})", p.format_raw_value());
+	return formatter<std::string_view>::format(std::string_view(buf.data(), buf.size()), ctx);
+}
+
+
+
+std::ostream& operator<< (std::ostream& os, const AtaStorageAttribute& p)
+{
+	return write_formatted(os, p);
 }
 
 
@@ -135,21 +184,20 @@ std::string AtaStorageStatistic::format_value() const
 {
 	// If it's fully a number, format it with commas
 	if (hz::number_to_string_nolocale(value_int) == value) {
-		std::stringstream ss;
-		try {
-			ss.imbue(std::locale(""));
-		}
-		catch (const std::runtime_error& e) {
-			// something is wrong with system locale, can't do anything here.
-		}
-		ss << std::fixed << value_int;
-		return ss.str();
+		return fmt::format(get_system_locale(), "{:L}", value_int);
 	}
 	return value;
 }
 
 
 
+fmt::format_context::iterator fmt::formatter<AtaStorageStatistic>::format(const AtaStorageStatistic& p, fmt::format_context& ctx) const
+{
+	return formatter<std::string_view>::format(p.value, ctx);
+}
+
+
+
 std::ostream& operator<<(std::ostream& os, const AtaStorageStatistic& p)
 {
 	os << p.value;
@@ -222,12 +270,50 @@ WarningLevel AtaStorageErrorBlock::get_warning_level_for_error_type(const std::s
 
 
 
+fmt::format_context::iterator fmt::formatter<AtaStorageErrorBlock>::format(const AtaStorageErrorBlock& b, fmt::format_context& ctx) const
+{
+	fmt::memory_buffer buf;
+	fmt::format_to(std::back_inserter(buf), "Error number {}: {} [{}]", b.error_num,
+			fmt::join(b.reported_types, ", "), AtaStorageErrorBlock::format_readable_error_types(b.reported_types));
+	return formatter<std::string_view>::format(std::string_view(buf.data(), buf.size()), ctx);
+}
+
+
+
 std::ostream& operator<< (std::ostream& os, const AtaStorageErrorBlock& b)
 {
-	os << "Error number " << b.error_num << ": "
-		<< hz::string_join(b.reported_types, ", ")
-		<< " [" << AtaStorageErrorBlock::format_readable_error_types(b.reported_types) << "]";
-	return os;
+	return write_formatted(os, b);
+}
+
+
+
+std::size_t AtaStorageTemperatureHistory::get_oldest_index() const
+{
+	return (samples.empty() ? 0 : (write_index + 1) % samples.size());
+}
+
+
+
+std::size_t AtaStorageTemperatureHistory::get_known_count() const
+{
+	return samples.size() - static_cast<std::size_t>(std::count(samples.begin(), samples.end(), unknown_temperature));
+}
+
+
+
+fmt::format_context::iterator fmt::formatter<AtaStorageTemperatureHistory>::format(const AtaStorageTemperatureHistory& h, fmt::format_context& ctx) const
+{
+	fmt::memory_buffer buf;
+	fmt::format_to(std::back_inserter(buf), "Temperature history: {} samples ({} known), interval: {} min., index: {}",
+			h.samples.size(), h.get_known_count(), h.logging_interval_minutes, h.write_index);
+	return formatter<std::string_view>::format(std::string_view(buf.data(), buf.size()), ctx);
+}
+
+
+
+std::ostream& operator<< (std::ostream& os, const AtaStorageTemperatureHistory& h)
+{
+	return write_formatted(os, h);
 }
 
 
@@ -263,22 +349,38 @@ std::string AtaStorageSelftestEntry::get_readable_status() const
 
 
 
+fmt::format_context::iterator fmt::formatter<AtaStorageSelftestEntry>::format(const AtaStorageSelftestEntry& b, fmt::format_context& ctx) const
+{
+	fmt::memory_buffer buf;
+	fmt::format_to(std::back_inserter(buf), "Test entry {}: {}, status: {}, remaining: {}",
+			b.test_num, b.type, b.get_readable_status(), int(b.remaining_percent));
+	return formatter<std::string_view>::format(std::string_view(buf.data(), buf.size()), ctx);
+}
+
+
+
 std::ostream& operator<< (std::ostream& os, const AtaStorageSelftestEntry& b)
 {
-	os << "Test entry " << b.test_num << ": "
-		<< b.type << ", status: " << b.get_readable_status() << ", remaining: " << int(b.remaining_percent);
-	return os;
+	return write_formatted(os, b);
+}
+
+
+
+fmt::format_context::iterator fmt::formatter<NvmeStorageSelftestEntry>::format(const NvmeStorageSelftestEntry& b, fmt::format_context& ctx) const
+{
+	fmt::memory_buffer buf;
+	fmt::format_to(std::back_inserter(buf), "Test entry {}: {}, result: {}, power on hours: {}, lba: {}",
+			b.test_num, NvmeSelfTestTypeExt::get_storable_name(b.type),
+			NvmeSelfTestResultTypeExt::get_storable_name(b.result),
+			int(b.power_on_hours), int(b.lba.value_or(0)));
+	return formatter<std::string_view>::format(std::string_view(buf.data(), buf.size()), ctx);
 }
 
 
 
 std::ostream& operator<<(std::ostream& os, const NvmeStorageSelftestEntry& b)
 {
-	return os << "Test entry " << b.test_num << ": "
-		<< NvmeSelfTestTypeExt::get_storable_name(b.type)
-		<< ", result: " << NvmeSelfTestResultTypeExt::get_storable_name(b.result)
-		<< ", power on hours: " << int(b.power_on_hours)
-		<< ", lba: " << int(b.lba.value_or(0));
+	return write_formatted(os, b);
 }
 
 
@@ -307,6 +409,8 @@ std::string StorageProperty::get_storable_value_type_name() const
 		return "ata_selftest_entry";
 	if (std::holds_alternative<NvmeStorageSelftestEntry>(value))
 		return "nvme_selftest_entry";
+	if (std::holds_alternative<AtaStorageTemperatureHistory>(value))
+		return "temperature_history";
 	return "[internal_error]";
 }
 
@@ -319,41 +423,71 @@ bool StorageProperty::empty() const
 
 
 
+std::size_t StorageProperty::get_memory_usage() const
+{
+	std::size_t size = sizeof(StorageProperty) + generic_name.size() + displayable_name.size() + reported_name.size()
+			+ reported_value.size() + readable_value.size() + warning_reason.size();
+
+	std::visit([&size](const auto& v) {
+		using T = std::decay_t<decltype(v)>;
+		if constexpr(std::is_same_v<T, std::string>) {
+			size += v.size();
+		} else if constexpr(std::is_same_v<T, AtaStorageTextCapability>) {
+			size += v.reported_flag_value.size() + v.reported_strvalue.size();
+			for (const auto& str : v.strvalues) {
+				size += sizeof(std::string) + str.size();
+			}
+		} else if constexpr(std::is_same_v<T, AtaStorageAttribute>) {
+			size += v.flag.size() + v.raw_value.size();
+		} else if constexpr(std::is_same_v<T, AtaStorageStatistic>) {
+			size += v.flags.size() + v.value.size();
+		} else if constexpr(std::is_same_v<T, AtaStorageErrorBlock>) {
+			size += v.device_state.size() + v.type_more_info.size();
+			for (const auto& type : v.reported_types) {
+				size += sizeof(std::string) + type.size();
+			}
+		} else if constexpr(std::is_same_v<T, AtaStorageSelftestEntry>) {
+			size += v.type.size() + v.status_str.size() + v.lba_of_first_error.size();
+		} else if constexpr(std::is_same_v<T, AtaStorageTemperatureHistory>) {
+			size += v.samples.capacity();
+		}
+	}, value);
+
+	return size;
+}
+
+
+
 void StorageProperty::dump(std::ostream& os, std::size_t internal_offset) const
 {
-	const std::string offset(internal_offset, ' ');
-
-	os << offset << "[" << StoragePropertySectionExt::get_storable_name(section) << "]"
-			<< " " << generic_name
-			// << (generic_name == reported_name ? "" : (" (" + reported_name + ")"))
-			<< ": [" << get_storable_value_type_name() << "] ";
-
-	// if (!readable_value.empty())
-	// 	os << readable_value;
-
-	if (std::holds_alternative<std::monostate>(value)) {
-		os << "[empty]";
-	} else if (std::holds_alternative<std::string>(value)) {
-		os << std::get<std::string>(value);
-	} else if (std::holds_alternative<std::int64_t>(value)) {
-		os << std::get<std::int64_t>(value) << " [" << reported_value << "]";
-	} else if (std::holds_alternative<bool>(value)) {
-		os << std::string(std::get<bool>(value) ? "Yes" : "No") << " [" << reported_value << "]";
-	} else if (std::holds_alternative<std::chrono::seconds>(value)) {
-		os << std::get<std::chrono::seconds>(value).count() << " sec [" << reported_value << "]";
-	} else if (std::holds_alternative<AtaStorageTextCapability>(value)) {
-		os << std::get<AtaStorageTextCapability>(value);
-	} else if (std::holds_alternative<AtaStorageAttribute>(value)) {
-		os << std::get<AtaStorageAttribute>(value);
-	} else if (std::holds_alternative<AtaStorageStatistic>(value)) {
-		os << std::get<AtaStorageStatistic>(value);
-	} else if (std::holds_alternative<AtaStorageErrorBlock>(value)) {
-		os << std::get<AtaStorageErrorBlock>(value);
-	} else if (std::holds_alternative<AtaStorageSelftestEntry>(value)) {
-		os << std::get<AtaStorageSelftestEntry>(value);
-	} else if (std::holds_alternative<NvmeStorageSelftestEntry>(value)) {
-		os << std::get<NvmeStorageSelftestEntry>(value);
-	}
+	fmt::memory_buffer buf;
+	dump(buf, internal_offset);
+	write_buffer(os, buf);
+}
+
+
+
+void StorageProperty::dump(fmt::memory_buffer& buf, std::size_t internal_offset) const
+{
+	auto out = std::back_inserter(buf);
+	fmt::format_to(out, "{:{}}[{}] {}: [{}] ", "", internal_offset,
+			StoragePropertySectionExt::get_storable_name(section), generic_name, get_storable_value_type_name());
+
+	std::visit([&out, this](const auto& v)
+	{
+		using T = std::decay_t<decltype(v)>;
+		if constexpr(std::is_same_v<T, std::monostate>) {
+			fmt::format_to(out, "[empty]");
+		} else if constexpr(std::is_same_v<T, std::int64_t>) {
+			fmt::format_to(out, "{} [{}]", v, reported_value);
+		} else if constexpr(std::is_same_v<T, bool>) {
+			fmt::format_to(out, "{} [{}]", (v ? "Yes" : "No"), reported_value);
+		} else if constexpr(std::is_same_v<T, std::chrono::seconds>) {
+			fmt::format_to(out, "{} sec [{}]", v.count(), reported_value);
+		} else {
+			fmt::format_to(out, "{}", v);
+		}
+	}, value);
 }
 
 
@@ -374,17 +508,19 @@ std::string StorageProperty::format_value(bool add_reported_too) const
 	if (std::holds_alternative<std::chrono::seconds>(value))
 		return hz::format_time_length(std::get<std::chrono::seconds>(value)) + (add_reported_too ? (" [" + reported_value + "]") : "");
 	if (std::holds_alternative<AtaStorageTextCapability>(value))
-		return hz::stream_cast<std::string>(std::get<AtaStorageTextCapability>(value));
+		return fmt::format("{}", std::get<AtaStorageTextCapability>(value));
 	if (std::holds_alternative<AtaStorageAttribute>(value))
-		return hz::stream_cast<std::string>(std::get<AtaStorageAttribute>(value));
+		return fmt::format("{}", std::get<AtaStorageAttribute>(value));
 	if (std::holds_alternative<AtaStorageStatistic>(value))
-		return hz::stream_cast<std::string>(std::get<AtaStorageStatistic>(value));
+		return std::get<AtaStorageStatistic>(value).value;
 	if (std::holds_alternative<AtaStorageErrorBlock>(value))
-		return hz::stream_cast<std::string>(std::get<AtaStorageErrorBlock>(value));
+		return fmt::format("{}", std::get<AtaStorageErrorBlock>(value));
 	if (std::holds_alternative<AtaStorageSelftestEntry>(value))
-		return hz::stream_cast<std::string>(std::get<AtaStorageSelftestEntry>(value));
+		return fmt::format("{}", std::get<AtaStorageSelftestEntry>(value));
 	if (std::holds_alternative<NvmeStorageSelftestEntry>(value))
-		return hz::stream_cast<std::string>(std::get<NvmeStorageSelftestEntry>(value));
+		return fmt::format("{}", std::get<NvmeStorageSelftestEntry>(value));
+	if (std::holds_alternative<AtaStorageTemperatureHistory>(value))
+		return fmt::format("{}", std::get<AtaStorageTemperatureHistory>(value));
 
 	return "[internal_error]";
 }
@@ -393,16 +529,70 @@ std::string StorageProperty::format_value(bool add_reported_too) const
 
 std::string StorageProperty::get_description(bool clean) const
 {
-	if (clean)
-		return this->description;
-	return (this->description.empty() ? "No description available" : this->description);
+	const std::string_view body = get_description_body();
+	const bool has_warning = (warning_level != WarningLevel::None);
+	if (body.empty() && description_title_ == DescriptionTitle::None && !has_warning)
+		return (clean ? std::string() : std::string("No description available"));
+
+	std::string descr;
+	switch (description_title_) {
+		case DescriptionTitle::None:
+			break;
+		case DescriptionTitle::Name:
+			descr = "<b>" + Glib::Markup::escape_text(displayable_name) + "</b>\n";
+			break;
+		case DescriptionTitle::NameAndReportedName:
+			descr = "<b>" + Glib::Markup::escape_text(displayable_name) + "</b>"
+					+ "\n<small>Reported by smartctl as <b>\""
+					+ Glib::Markup::escape_text(hz::string_replace_copy(reported_name, '_', ' '))
+					+ "\"</b></small>\n\n";
+			break;
+	}
+	descr += body;
+
+	if (has_warning) {
+		descr += "\n\n" + storage_property_get_warning_reason(*this);
+	}
+	return descr;
+}
+
+
+
+void StorageProperty::set_description(const std::string& descr, DescriptionTitle title)
+{
+	if (descr.empty()) {
+		description_.reset();
+	} else {
+		description_ = hz::StringPool::get_default().intern(descr);
+	}
+	static_description_ = {};
+	description_title_ = title;
+}
+
+
+
+void StorageProperty::set_static_description(std::string_view descr, DescriptionTitle title)
+{
+	description_.reset();
+	static_description_ = descr;
+	description_title_ = title;
 }
 
 
 
-void StorageProperty::set_description(const std::string& descr)
+std::string_view StorageProperty::get_description_body() const
 {
-	this->description = descr;
+	if (description_) {
+		return *description_;
+	}
+	return static_description_;
+}
+
+
+
+StorageProperty::DescriptionTitle StorageProperty::get_description_title() const
+{
+	return description_title_;
 }
 
 
@@ -418,6 +608,15 @@ void StorageProperty::set_name(const std::string& gen_name, const std::string& d
 
 
 
+fmt::format_context::iterator fmt::formatter<StorageProperty>::format(const StorageProperty& p, fmt::format_context& ctx) const
+{
+	fmt::memory_buffer buf;
+	p.dump(buf);
+	return formatter<std::string_view>::format(std::string_view(buf.data(), buf.size()), ctx);
+}
+
+
+
 std::ostream& operator<<(std::ostream& os, const StorageProperty& p)
 {
 	p.dump(os);
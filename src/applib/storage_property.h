@@ -12,9 +12,10 @@ Copyright:
 #ifndef STORAGE_PROPERTY_H
 #define STORAGE_PROPERTY_H
 
-#include <glibmm.h>
 #include <glibmm/i18n.h>
 
+#include <algorithm>
+#include <array>
 #include <cstddef>  // std::size_t
 #include <string>
 #include <unordered_map>
@@ -22,12 +23,17 @@ Copyright:
 #include <vector>
 #include <iosfwd>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <chrono>
 #include <variant>
+#include <string_view>
+
+#include "fmt/format.h"
 
 #include "warning_level.h"
 #include "hz/enum_helper.h"
+#include "hz/string_pool.h"
 
 
 
@@ -39,6 +45,9 @@ class AtaStorageTextCapability {
 		uint16_t flag_value = 0x0;  ///< Flag value. This is one or sometimes two bytes (maybe more?)
 		std::string reported_strvalue;  ///< Original flag descriptions
 		std::vector<std::string> strvalues;  ///< A list of capabilities in the block.
+
+		/// Compare all the fields
+		[[nodiscard]] bool operator==(const AtaStorageTextCapability& other) const = default;
 };
 
 
@@ -46,6 +55,13 @@ class AtaStorageTextCapability {
 std::ostream& operator<< (std::ostream& os, const AtaStorageTextCapability& p);
 
 
+/// Formatter for fmt::format() and friends. The string formatting specs (e.g. width) apply to the whole value.
+template<>
+struct fmt::formatter<AtaStorageTextCapability> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const AtaStorageTextCapability& p, fmt::format_context& ctx) const;
+};
+
+
 
 
 
@@ -110,6 +126,9 @@ class AtaStorageAttribute {
 		std::string raw_value;  ///< Raw value as a string, as presented by smartctl (formatted).
 		std::int64_t raw_value_int = 0;  ///< Same as raw_value, but parsed as int64. original value is 6 bytes I think.
 
+		/// Compare all the fields
+		[[nodiscard]] bool operator==(const AtaStorageAttribute& other) const = default;
+
 };
 
 
@@ -117,6 +136,13 @@ class AtaStorageAttribute {
 std::ostream& operator<< (std::ostream& os, const AtaStorageAttribute& p);
 
 
+/// Formatter for fmt::format() and friends
+template<>
+struct fmt::formatter<AtaStorageAttribute> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const AtaStorageAttribute& p, fmt::format_context& ctx) const;
+};
+
+
 
 
 /// Holds one line of "devstat" subsection.
@@ -136,6 +162,9 @@ class AtaStorageStatistic {
 		std::int64_t value_int = 0;  ///< Same as value, but parsed as int64.
 		std::int64_t page = 0;  ///< Page
 		std::int64_t offset = 0;  ///< Offset in page
+
+		/// Compare all the fields
+		[[nodiscard]] bool operator==(const AtaStorageStatistic& other) const = default;
 };
 
 
@@ -143,6 +172,13 @@ class AtaStorageStatistic {
 std::ostream& operator<< (std::ostream& os, const AtaStorageStatistic& p);
 
 
+/// Formatter for fmt::format() and friends
+template<>
+struct fmt::formatter<AtaStorageStatistic> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const AtaStorageStatistic& p, fmt::format_context& ctx) const;
+};
+
+
 
 /// Holds one error block of "error log" subsection.
 /// ATA only.
@@ -163,6 +199,9 @@ class AtaStorageErrorBlock {
 		std::vector<std::string> reported_types;  ///< Array of reported types (strings), e.g. "UNC".
 		std::string type_more_info;  ///< More info on error type (e.g. "at LBA = 0x0253eac0 = 39054016")
 		std::uint64_t lba = 0;  ///< LBA of the error
+
+		/// Compare all the fields
+		[[nodiscard]] bool operator==(const AtaStorageErrorBlock& other) const = default;
 };
 
 
@@ -170,6 +209,59 @@ class AtaStorageErrorBlock {
 std::ostream& operator<< (std::ostream& os, const AtaStorageErrorBlock& b);
 
 
+/// Formatter for fmt::format() and friends
+template<>
+struct fmt::formatter<AtaStorageErrorBlock> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const AtaStorageErrorBlock& b, fmt::format_context& ctx) const;
+};
+
+
+
+
+/// SCT temperature history (--log=scttemp), kept the way the drive keeps it: a circular
+/// buffer of one-byte temperatures. It's stored in one property of the drive, so that the
+/// graph and the exporters don't have to parse the formatted table.
+/// ATA only.
+class AtaStorageTemperatureHistory {
+	public:
+
+		/// Temperature of the samples which were not logged (e.g. the drive was powered off).
+		/// The drive reports them as 0x80.
+		static constexpr std::int8_t unknown_temperature = std::numeric_limits<std::int8_t>::min();
+
+		/// Get the index of the oldest sample in samples
+		[[nodiscard]] std::size_t get_oldest_index() const;
+
+		/// Get the number of samples with known temperature
+		[[nodiscard]] std::size_t get_known_count() const;
+
+		/// Call \c func(time, temperature) for each sample with known temperature, oldest first.
+		/// The times are estimated from newest_time and logging_interval_minutes.
+		template<typename Func>
+		void for_each_known_sample(Func&& func) const;
+
+
+		std::int64_t logging_interval_minutes = 1;  ///< Time between the samples
+		std::uint32_t write_index = 0;  ///< Index of the newest sample in samples
+		std::int64_t newest_time = 0;  ///< Time (time_t) of the newest sample, logged when smartctl was run
+		std::vector<std::int8_t> samples;  ///< Temperatures in Celsius, a circular buffer
+
+		/// Compare all the fields
+		[[nodiscard]] bool operator==(const AtaStorageTemperatureHistory& other) const = default;
+};
+
+
+/// Output operator for debug purposes
+std::ostream& operator<< (std::ostream& os, const AtaStorageTemperatureHistory& h);
+
+
+/// Formatter for fmt::format() and friends
+template<>
+struct fmt::formatter<AtaStorageTemperatureHistory> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const AtaStorageTemperatureHistory& h, fmt::format_context& ctx) const;
+};
+
+
 
 
 /// Holds one entry of selftest_log subsection.
@@ -210,6 +302,9 @@ class AtaStorageSelftestEntry {
 		std::uint32_t lifetime_hours = 0;  ///< When the test happened (in lifetime hours). capability: unused.
 		std::string lba_of_first_error;  ///< LBA of the first error. "-" or value (format? usually hex). capability: unused.
 		bool passed = false;  ///< Test passed or not. capability: unused.
+
+		/// Compare all the fields
+		[[nodiscard]] bool operator==(const AtaStorageSelftestEntry& other) const = default;
 };
 
 
@@ -217,6 +312,13 @@ class AtaStorageSelftestEntry {
 std::ostream& operator<< (std::ostream& os, const AtaStorageSelftestEntry& b);
 
 
+/// Formatter for fmt::format() and friends
+template<>
+struct fmt::formatter<AtaStorageSelftestEntry> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const AtaStorageSelftestEntry& b, fmt::format_context& ctx) const;
+};
+
+
 
 
 /// Decoded of nvme_self_test_log/current_self_test_operation/value
@@ -232,23 +334,19 @@ enum class NvmeSelfTestCurrentOperationType {
 
 /// Helper structure for enum-related functions
 struct NvmeSelfTestCurrentOperationTypeExt
-		: public hz::EnumHelper<
+		: public hz::EnumTableHelper<
 				NvmeSelfTestCurrentOperationType,
-				NvmeSelfTestCurrentOperationTypeExt,
-				Glib::ustring>
+				NvmeSelfTestCurrentOperationTypeExt>
 {
 	static constexpr NvmeSelfTestCurrentOperationType default_value = NvmeSelfTestCurrentOperationType::Unknown;
 
-	static std::unordered_map<EnumType, std::pair<std::string, Glib::ustring>> build_enum_map()
-	{
-		return {
-			{NvmeSelfTestCurrentOperationType::Unknown, {"unknown", _("Unknown")}},
-			{NvmeSelfTestCurrentOperationType::None, {"none", _("None")}},
-			{NvmeSelfTestCurrentOperationType::ShortInProgress, {"shortInProgress", _("Short Test in Progress")}},
-			{NvmeSelfTestCurrentOperationType::ExtendedInProgress, {"extendedInProgress", _("Extended Test in Progress")}},
-			{NvmeSelfTestCurrentOperationType::VendorSpecificInProgress, {"vendorSpecificInProgress", _("Vendor-Specific Test in Progress")}},
-		};
-	}
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{NvmeSelfTestCurrentOperationType::Unknown, "unknown", N_("Unknown")},
+		{NvmeSelfTestCurrentOperationType::None, "none", N_("None")},
+		{NvmeSelfTestCurrentOperationType::ShortInProgress, "shortInProgress", N_("Short Test in Progress")},
+		{NvmeSelfTestCurrentOperationType::ExtendedInProgress, "extendedInProgress", N_("Extended Test in Progress")},
+		{NvmeSelfTestCurrentOperationType::VendorSpecificInProgress, "vendorSpecificInProgress", N_("Vendor-Specific Test in Progress")},
+	});
 };
 
 
@@ -265,22 +363,18 @@ enum class NvmeSelfTestType {
 
 /// Helper structure for enum-related functions
 struct NvmeSelfTestTypeExt
-		: public hz::EnumHelper<
+		: public hz::EnumTableHelper<
 				NvmeSelfTestType,
-				NvmeSelfTestTypeExt,
-				Glib::ustring>
+				NvmeSelfTestTypeExt>
 {
 	static constexpr NvmeSelfTestType default_value = NvmeSelfTestType::Unknown;
 
-	static std::unordered_map<EnumType, std::pair<std::string, Glib::ustring>> build_enum_map()
-	{
-		return {
-			{NvmeSelfTestType::Unknown, {"unknown", _("Unknown")}},
-			{NvmeSelfTestType::Short, {"short", _("Short Test")}},
-			{NvmeSelfTestType::Extended, {"extended", _("Extended Test")}},
-			{NvmeSelfTestType::VendorSpecific, {"vendorSpecific", _("Vendor-Specific Test")}},
-		};
-	}
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{NvmeSelfTestType::Unknown, "unknown", N_("Unknown")},
+		{NvmeSelfTestType::Short, "short", N_("Short Test")},
+		{NvmeSelfTestType::Extended, "extended", N_("Extended Test")},
+		{NvmeSelfTestType::VendorSpecific, "vendorSpecific", N_("Vendor-Specific Test")},
+	});
 };
 
 
@@ -305,29 +399,25 @@ enum class NvmeSelfTestResultType {
 
 /// Helper structure for enum-related functions
 struct NvmeSelfTestResultTypeExt
-		: public hz::EnumHelper<
+		: public hz::EnumTableHelper<
 				NvmeSelfTestResultType,
-				NvmeSelfTestResultTypeExt,
-				Glib::ustring>
+				NvmeSelfTestResultTypeExt>
 {
 	static constexpr NvmeSelfTestResultType default_value = NvmeSelfTestResultType::Unknown;
 
-	static std::unordered_map<EnumType, std::pair<std::string, Glib::ustring>> build_enum_map()
-	{
-		return {
-			{NvmeSelfTestResultType::Unknown, {"unknown", _("Unknown")}},
-			{NvmeSelfTestResultType::CompletedNoError, {"completedNoError", _("Completed Without Errors")}},
-			{NvmeSelfTestResultType::AbortedSelfTestCommand, {"abortedSelfTestCommand", _("Aborted: Self-Test Command")}},
-			{NvmeSelfTestResultType::AbortedControllerReset, {"abortedControllerReset", _("Aborted: Controller Reset")}},
-			{NvmeSelfTestResultType::AbortedNamespaceRemoved, {"abortedNamespaceRemoved", _("Aborted: Namespace Removed")}},
-			{NvmeSelfTestResultType::AbortedFormatNvmCommand, {"abortedFormatNvmCommand", _("Aborted: Format NVM Command")}},
-			{NvmeSelfTestResultType::FatalOrUnknownTestError, {"fatalOrUnknownTestError", _("Fatal or Unknown Test Error")}},
-			{NvmeSelfTestResultType::CompletedUnknownFailedSegment, {"completedUnknownFailedSegment", _("Completed: Unknown Failed Segment")}},
-			{NvmeSelfTestResultType::CompletedFailedSegments, {"completedFailedSegments", _("Completed: Failed Segments")}},
-			{NvmeSelfTestResultType::AbortedUnknownReason, {"abortedUnknownReason", _("Aborted: Unknown Reason")}},
-			{NvmeSelfTestResultType::AbortedSanitizeOperation, {"abortedSanitizeOperation", _("Aborted: Sanitize Operation")}},
-		};
-	}
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{NvmeSelfTestResultType::Unknown, "unknown", N_("Unknown")},
+		{NvmeSelfTestResultType::CompletedNoError, "completedNoError", N_("Completed Without Errors")},
+		{NvmeSelfTestResultType::AbortedSelfTestCommand, "abortedSelfTestCommand", N_("Aborted: Self-Test Command")},
+		{NvmeSelfTestResultType::AbortedControllerReset, "abortedControllerReset", N_("Aborted: Controller Reset")},
+		{NvmeSelfTestResultType::AbortedNamespaceRemoved, "abortedNamespaceRemoved", N_("Aborted: Namespace Removed")},
+		{NvmeSelfTestResultType::AbortedFormatNvmCommand, "abortedFormatNvmCommand", N_("Aborted: Format NVM Command")},
+		{NvmeSelfTestResultType::FatalOrUnknownTestError, "fatalOrUnknownTestError", N_("Fatal or Unknown Test Error")},
+		{NvmeSelfTestResultType::CompletedUnknownFailedSegment, "completedUnknownFailedSegment", N_("Completed: Unknown Failed Segment")},
+		{NvmeSelfTestResultType::CompletedFailedSegments, "completedFailedSegments", N_("Completed: Failed Segments")},
+		{NvmeSelfTestResultType::AbortedUnknownReason, "abortedUnknownReason", N_("Aborted: Unknown Reason")},
+		{NvmeSelfTestResultType::AbortedSanitizeOperation, "abortedSanitizeOperation", N_("Aborted: Sanitize Operation")},
+	});
 };
 
 
@@ -349,6 +439,9 @@ class NvmeStorageSelftestEntry {
 		NvmeSelfTestResultType result = NvmeSelfTestResultType::Unknown;  ///< Test result
 		std::uint32_t power_on_hours = 0;  ///< When the test happened (in power-on hours).
 		std::optional<std::uint64_t> lba;  ///< LBA of the first error.
+
+		/// Compare all the fields
+		[[nodiscard]] bool operator==(const NvmeStorageSelftestEntry& other) const = default;
 };
 
 
@@ -356,6 +449,13 @@ class NvmeStorageSelftestEntry {
 std::ostream& operator<< (std::ostream& os, const NvmeStorageSelftestEntry& b);
 
 
+/// Formatter for fmt::format() and friends
+template<>
+struct fmt::formatter<NvmeStorageSelftestEntry> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const NvmeStorageSelftestEntry& b, fmt::format_context& ctx) const;
+};
+
+
 
 /// Sections in output
 enum class StoragePropertySection {
@@ -381,34 +481,30 @@ enum class StoragePropertySection {
 
 /// Helper structure for enum-related functions
 struct StoragePropertySectionExt
-		: public hz::EnumHelper<
+		: public hz::EnumTableHelper<
 				StoragePropertySection,
-				StoragePropertySectionExt,
-				std::string>
+				StoragePropertySectionExt>
 {
 	static constexpr StoragePropertySection default_value = StoragePropertySection::Unknown;
 
-	static std::unordered_map<EnumType, std::pair<std::string, std::string>> build_enum_map()
-	{
-		return {
-			{StoragePropertySection::Unknown,              {"unknown",              _("Unknown")}},
-			{StoragePropertySection::Info,                 {"info",                 _("Short Info")}},
-			{StoragePropertySection::OverallHealth,        {"overallHealth",        _("Overall Health")}},
-			{StoragePropertySection::Capabilities,         {"capabilities",         _("Capabilities")}},
-			{StoragePropertySection::AtaAttributes,        {"attributes",           _("Attributes")}},
-			{StoragePropertySection::Statistics,           {"statistics",           _("Statistics")}},
-			{StoragePropertySection::AtaErrorLog,          {"errorLog",             _("Error Log")}},
-			{StoragePropertySection::SelftestLog,          {"selftestLog",          _("Self-test Log")}},
-			{StoragePropertySection::SelectiveSelftestLog, {"selectiveSelftestLog", _("Selective Self-test Log")}},
-			{StoragePropertySection::TemperatureLog,       {"temperatureLog",       _("Temperature Log")}},
-			{StoragePropertySection::ErcLog,               {"ercLog",               _("Error Recovery Control Log")}},
-			{StoragePropertySection::PhyLog,               {"phyLog",               _("Phy Log")}},
-			{StoragePropertySection::DirectoryLog,         {"directoryLog",         _("Directory Log")}},
-			{StoragePropertySection::NvmeHealth,           {"nvmeHealth",           _("NVMe Health")}},
-			{StoragePropertySection::NvmeAttributes,       {"nvmeAttributes",       _("NVMe Attributes")}},
-			{StoragePropertySection::NvmeErrorLog,         {"nvmeErrorLog",         _("NVMe Error Log")}},
-		};
-	}
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{StoragePropertySection::Unknown,              "unknown",              N_("Unknown")},
+		{StoragePropertySection::Info,                 "info",                 N_("Short Info")},
+		{StoragePropertySection::OverallHealth,        "overallHealth",        N_("Overall Health")},
+		{StoragePropertySection::Capabilities,         "capabilities",         N_("Capabilities")},
+		{StoragePropertySection::AtaAttributes,        "attributes",           N_("Attributes")},
+		{StoragePropertySection::Statistics,           "statistics",           N_("Statistics")},
+		{StoragePropertySection::AtaErrorLog,          "errorLog",             N_("Error Log")},
+		{StoragePropertySection::SelftestLog,          "selftestLog",          N_("Self-test Log")},
+		{StoragePropertySection::SelectiveSelftestLog, "selectiveSelftestLog", N_("Selective Self-test Log")},
+		{StoragePropertySection::TemperatureLog,       "temperatureLog",       N_("Temperature Log")},
+		{StoragePropertySection::ErcLog,               "ercLog",               N_("Error Recovery Control Log")},
+		{StoragePropertySection::PhyLog,               "phyLog",               N_("Phy Log")},
+		{StoragePropertySection::DirectoryLog,         "directoryLog",         N_("Directory Log")},
+		{StoragePropertySection::NvmeHealth,           "nvmeHealth",           N_("NVMe Health")},
+		{StoragePropertySection::NvmeAttributes,       "nvmeAttributes",       N_("NVMe Attributes")},
+		{StoragePropertySection::NvmeErrorLog,         "nvmeErrorLog",         N_("NVMe Error Log")},
+	});
 };
 
 
@@ -430,10 +526,19 @@ class StorageProperty {
 			AtaStorageStatistic,  ///< Value (if it's a statistic from devstat)
 			AtaStorageErrorBlock,  ///< Value (if it's a error block)
 			AtaStorageSelftestEntry,  ///< Value (if it's ATA self-test log entry)
-			NvmeStorageSelftestEntry  ///< Value (if it's NVMe self-test log entry)
+			NvmeStorageSelftestEntry,  ///< Value (if it's NVMe self-test log entry)
+			AtaStorageTemperatureHistory  ///< Value (if it's SCT temperature history)
 		>;
 
 
+		/// Title prepended to the description by get_description()
+		enum class DescriptionTitle {
+			None,  ///< No title
+			Name,  ///< The displayable name, in bold
+			NameAndReportedName,  ///< Same, followed by a note with the smartctl-reported name
+		};
+
+
 		/// Constructor
 		StorageProperty() = default;
 
@@ -451,9 +556,18 @@ class StorageProperty {
 		[[nodiscard]] bool empty() const;
 
 
+		/// Get the approximate memory usage of the property, with its strings. The interned
+		/// and static descriptions are shared between the drives and are not included.
+		[[nodiscard]] std::size_t get_memory_usage() const;
+
+
 		/// Dump the property to a stream for debugging purposes
 		void dump(std::ostream& os, std::size_t internal_offset = 0) const;
 
+		/// Dump the property to a memory buffer for debugging purposes. This avoids the stream
+		/// overhead when dumping many properties (the buffer may be reused).
+		void dump(fmt::memory_buffer& buf, std::size_t internal_offset = 0) const;
+
 
 		/// Format this property for debugging purposes
 		[[nodiscard]] std::string format_value(bool add_reported_too = false) const;
@@ -469,12 +583,27 @@ class StorageProperty {
 		[[nodiscard]] bool is_value_type() const;
 
 
-		/// Get property description (used in tooltips)
+		/// Get property description markup (used in tooltips). It's composed on each call
+		/// from the title, the description body and the warning (if any), so it should
+		/// only be called when the description is actually displayed or exported.
 		[[nodiscard]] std::string get_description(bool clean = false) const;
 
 
-		/// Set property description (used in tooltips)
-		void set_description(const std::string& descr);
+		/// Set property description body (used in tooltips). The body is copied (interned).
+		void set_description(const std::string& descr, DescriptionTitle title = DescriptionTitle::None);
+
+
+		/// Set property description body without copying it. \c descr must outlive the property,
+		/// e.g. a string literal or a description database entry.
+		void set_static_description(std::string_view descr, DescriptionTitle title = DescriptionTitle::None);
+
+
+		/// Get the description body, as set by set_description() or set_static_description()
+		[[nodiscard]] std::string_view get_description_body() const;
+
+
+		/// Get the description title, as set by set_description() or set_static_description()
+		[[nodiscard]] DescriptionTitle get_description_title() const;
 
 
 		/// Set generic (internal) name, readable name, and smartctl-reported name (optional)
@@ -485,8 +614,6 @@ class StorageProperty {
 		std::string displayable_name;  ///< Readable property name. May be the same as reported_name, or something more user-readable. Possibly translatable.
 		std::string reported_name;  ///< Property name as reported by smartctl. Mainly used by Text parser.
 
-		std::string description;  ///< Property description (for tooltips, etc.). May contain markup.
-
 		StoragePropertySection section = StoragePropertySection::Unknown;  ///< Section this property belongs to
 
 		std::string reported_value;  ///< String representation of the value as reported
@@ -499,6 +626,20 @@ class StorageProperty {
 
 		bool show_in_ui = true;  ///< Whether to show this property in UI or not
 
+
+	private:
+
+		/// Property description body (for tooltips, etc.). May contain markup. nullptr if empty
+		/// or static. The composed descriptions are mostly the same for all the drives,
+		/// so they are interned to avoid storing a copy in each property.
+		hz::StringPool::StringPtr description_;
+
+		/// Static property description body, if description_ is not set
+		std::string_view static_description_;
+
+		/// Title of the description
+		DescriptionTitle description_title_ = DescriptionTitle::None;
+
 };
 
 
@@ -508,6 +649,13 @@ class StorageProperty {
 std::ostream& operator<< (std::ostream& os, const StorageProperty& p);
 
 
+/// Formatter for fmt::format() and friends
+template<>
+struct fmt::formatter<StorageProperty> : fmt::formatter<std::string_view> {
+	fmt::format_context::iterator format(const StorageProperty& p, fmt::format_context& ctx) const;
+};
+
+
 
 
 
@@ -515,6 +663,21 @@ std::ostream& operator<< (std::ostream& os, const StorageProperty& p);
 
 
 
+template<typename Func>
+void AtaStorageTemperatureHistory::for_each_known_sample(Func&& func) const
+{
+	const std::size_t oldest = get_oldest_index();
+	const std::int64_t interval = std::max<std::int64_t>(1, logging_interval_minutes) * 60;
+	for (std::size_t i = 0; i < samples.size(); ++i) {
+		const std::int8_t temperature = samples[(oldest + i) % samples.size()];
+		if (temperature != unknown_temperature) {
+			func(newest_time - static_cast<std::int64_t>(samples.size() - 1 - i) * interval, temperature);
+		}
+	}
+}
+
+
+
 template<typename T>
 const T& StorageProperty::get_value() const
 {
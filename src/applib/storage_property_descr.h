@@ -12,6 +12,8 @@ Copyright:
 #ifndef STORAGE_PROPERTY_DESCR_H
 #define STORAGE_PROPERTY_DESCR_H
 
+#include <functional>
+
 #include "storage_property_repository.h"
 #include "storage_device_detected_type.h"
 
@@ -23,8 +25,13 @@ class StoragePropertyProcessor {
 	public:
 
 		/// Set descriptions, warnings, etc. on properties, and return them.
+		/// Pass the repository as rvalue to avoid copying it. Large repositories are processed
+		/// in several threads. The properties for which \c is_processed returns true (e.g. the
+		/// error log entries taken from StorageErrorLogJournal) are left as they are.
+		/// The warning summaries of the returned repository are computed.
 		static StoragePropertyRepository process_properties(StoragePropertyRepository properties,
-				StorageDeviceDetectedType device_type);
+				StorageDeviceDetectedType device_type,
+				const std::function<bool(const StorageProperty& p)>& is_processed = nullptr);
 
 };
 
@@ -10,12 +10,15 @@ Copyright:
 /// @{
 
 #include <glibmm.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <string_view>
 #include <utility>
 #include <vector>
-#include <map>
-#include <unordered_map>
 
 #include "hz/string_algo.h"  // string_replace_copy
+#include "hz/string_replacer.h"
 #include "applib/app_regex.h"
 
 #include "storage_property_descr_ata_attribute.h"
@@ -1046,7 +1049,8 @@ namespace {
 			/// Add an attribute description to the attribute database
 			void add(AtaAttributeDescription descr)
 			{
-				id_db[descr.id].emplace_back(std::move(descr));
+				DBG_ASSERT_RETURN_NONE(descr.id >= 0 && static_cast<std::size_t>(descr.id) < id_db.size());
+				id_db[static_cast<std::size_t>(descr.id)].emplace_back(std::move(descr));
 			}
 
 
@@ -1083,55 +1087,48 @@ namespace {
 			/// different smartctl name (fill the other members from the previous attribute).
 			void add(int32_t id, std::optional<StorageDeviceDetectedType> type, std::string reported_name)
 			{
-				auto iter = id_db.find(id);
-				DBG_ASSERT(iter != id_db.end() && !iter->second.empty());
-				if (iter != id_db.end() && !iter->second.empty()) {
-					AtaAttributeDescription attr = iter->second.front();
+				const bool valid = id >= 0 && static_cast<std::size_t>(id) < id_db.size() && !id_db[static_cast<std::size_t>(id)].empty();
+				DBG_ASSERT(valid);
+				if (valid) {
+					AtaAttributeDescription attr = id_db[static_cast<std::size_t>(id)].front();
 					add(AtaAttributeDescription(id, type,
 							std::move(reported_name), std::move(attr.displayable_name), std::move(attr.generic_name), std::move(attr.description)));
 				}
 			}
 
 
-			/// Find the description by smartctl name or id, merging them if they're partial.
-			[[nodiscard]] AtaAttributeDescription find(const std::string& reported_name, int32_t id, std::optional<StorageDeviceDetectedType> type) const
+			/// Find the description by smartctl name or id.
+			/// If no description matches the name, the first one with this id (and a matching type) is returned.
+			/// \return nullptr if not found. This does not allocate.
+			[[nodiscard]] const AtaAttributeDescription* find(std::string_view reported_name, int32_t id, std::optional<StorageDeviceDetectedType> type) const
 			{
-				// search by ID first
-				auto id_iter = id_db.find(id);
-				if (id_iter == id_db.end()) {
-					return {};  // not found
-				}
-				DBG_ASSERT(!id_iter->second.empty());
-				if (id_iter->second.empty()) {
-					return {};  // invalid DB?
+				if (id < 0 || static_cast<std::size_t>(id) >= id_db.size()) {
+					return nullptr;  // not found
 				}
 
-				std::vector<AtaAttributeDescription> type_matched;
-				for (const auto& attr_iter : id_iter->second) {
-					if (!attr_iter.drive_type.has_value() || !type.has_value() || attr_iter.drive_type == type) {
-						type_matched.push_back(attr_iter);
+				const AtaAttributeDescription* first_type_matched = nullptr;
+				for (const auto& attr : id_db[static_cast<std::size_t>(id)]) {
+					if (attr.drive_type.has_value() && type.has_value() && attr.drive_type != type) {
+						continue;
 					}
-				}
-				if (type_matched.empty()) {
-					return {};  // not found
-				}
-
-				// search by smartctl name in ID-supplied vector
-				for (const auto& attr_iter : type_matched) {
 					// compare them case-insensitively, just in case
-					if ( hz::string_to_lower_copy(attr_iter.reported_name) == hz::string_to_lower_copy(reported_name)) {
-						return attr_iter;  // found it
+					if (hz::string_iequals(attr.reported_name, reported_name)) {
+						return &attr;  // found it
+					}
+					if (!first_type_matched) {
+						first_type_matched = &attr;
 					}
 				}
 
-				// nothing was found by name, return the first one by that ID.
-				return type_matched.front();
+				// nothing was found by name, return the first one by that ID (if any).
+				return first_type_matched;
 			}
 
 
 		private:
 
-			std::map< int32_t, std::vector<AtaAttributeDescription> > id_db;  ///< id => attribute descriptions
+			/// Attribute descriptions, indexed by attribute ID (0-255).
+			std::array<std::vector<AtaAttributeDescription>, 256> id_db;
 
 	};
 
@@ -1146,73 +1143,70 @@ namespace {
 	}
 
 
-
-	/// Check if a property is an attribute and matches a generic name
-	inline bool attr_match(StorageProperty& p, const std::string& generic_name)
-	{
-		return (p.is_value_type<AtaStorageAttribute>() && p.generic_name == generic_name);
-	}
-
-
 }
 
 
 
-void auto_set_ata_attribute_description(StorageProperty& p, StorageDeviceDetectedType drive_type)
+void auto_set_ata_attribute_description(StorageProperty& p, const AtaStorageAttribute& attr, StorageDeviceDetectedType drive_type)
 {
-	AtaAttributeDescription attr = get_ata_attribute_description_db().find(p.reported_name, p.get_value<AtaStorageAttribute>().id, drive_type);
+	const AtaAttributeDescription* attr_descr = get_ata_attribute_description_db().find(p.reported_name, attr.id, drive_type);
+	std::string displayable_name = (attr_descr ? attr_descr->displayable_name : std::string());
+	const std::string_view description = (attr_descr ? std::string_view(attr_descr->description) : std::string_view());
 
 	std::string humanized_reported_name;
 	std::string ssd_hdd_str;
 	const bool known_by_smartctl = !app_regex_partial_match("/Unknown_(HDD|SSD)_?Attr.*/i", p.reported_name, &ssd_hdd_str);
 	if (known_by_smartctl) {
-		humanized_reported_name = " " + p.reported_name + " ";  // spaces are for easy replacements
-
-		static const std::unordered_map<std::string, std::string> replacement_map = {
+		// Separate the words first, so that the abbreviations below are matched as words
+		static const hz::StringReplacer separator_replacer = {
 				{"_", " "},
 				{"/", " / "},
-				{" Ct ", " Count "},
-				{" Tot ", " Total "},
-				{" Blk ", " Block "},
-				{" Cel ", " Celsius "},
-				{" Uncorrect ", " Uncorrectable "},
-				{" Cnt ", " Count "},
-				{" Offl ", " Offline "},
-				{" UNC ", " Uncorrectable "},
-				{" Err ", " Error "},
-				{" Errs ", " Errors "},
-				{" Perc ", " Percent "},
-				{" Ct ", " Count "},
-				{" Avg ", " Average "},
-				{" Max ", " Maximum "},
-				{" Min ", " Minimum "}
 		};
-
-		hz::string_replace_array(humanized_reported_name, replacement_map);
+		static const hz::StringReplacer word_replacer({
+				{"Ct", "Count"},
+				{"Tot", "Total"},
+				{"Blk", "Block"},
+				{"Cel", "Celsius"},
+				{"Uncorrect", "Uncorrectable"},
+				{"Cnt", "Count"},
+				{"Offl", "Offline"},
+				{"UNC", "Uncorrectable"},
+				{"Err", "Error"},
+				{"Errs", "Errors"},
+				{"Perc", "Percent"},
+				{"Avg", "Average"},
+				{"Max", "Maximum"},
+				{"Min", "Minimum"},
+		}, hz::StringReplacer::Mode::Words);
+
+		humanized_reported_name = separator_replacer.replace_copy(p.reported_name);
+		word_replacer.replace(humanized_reported_name);
 		hz::string_trim(humanized_reported_name);
 		hz::string_remove_adjacent_duplicates(humanized_reported_name, ' ');  // may happen with slashes
 	}
 
-	if (attr.displayable_name.empty()) {
+	if (displayable_name.empty()) {
 		// try to display something sensible (use humanized form of smartctl name)
 		if (!humanized_reported_name.empty()) {
-			attr.displayable_name = humanized_reported_name;
+			displayable_name = humanized_reported_name;
 
 		} else {  // unknown to smartctl
 			if (hz::string_to_upper_copy(ssd_hdd_str) == "SSD") {
-				attr.displayable_name = "Unknown SSD Attribute";
+				displayable_name = "Unknown SSD Attribute";
 			} else if (hz::string_to_upper_copy(ssd_hdd_str) == "HDD") {
-				attr.displayable_name = "Unknown HDD Attribute";
+				displayable_name = "Unknown HDD Attribute";
 			} else {
-				attr.displayable_name = "Unknown Attribute";
+				displayable_name = "Unknown Attribute";
 			}
 		}
 	}
 
 
 
-	if (attr.description.empty()) {
-		attr.description = "No description is available for this attribute.";
+	p.displayable_name = displayable_name;
+
+	if (description.empty()) {
+		p.set_static_description("No description is available for this attribute.");
 
 	} else {
 		bool same_names = true;
@@ -1220,139 +1214,55 @@ void auto_set_ata_attribute_description(StorageProperty& p, StorageDeviceDetecte
 			// See if humanized smartctl-reported name looks like our found name.
 			// If not, show it in description.
 			std::string match = " " + humanized_reported_name + " ";
-			std::string against = " " + attr.displayable_name + " ";
+			std::string against = " " + displayable_name + " ";
 
-			static const std::unordered_map<std::string, std::string> replacement_map = {
-					{" Percent ", " % "},
+			// All the spaces are removed, including the ones around "%"
+			static const hz::StringReplacer replacer = {
+					{" Percent ", "%"},
 					{"-", 	""},
 					{"(", 	""},
 					{")", 	""},
 					{" ", 	""},
 			};
-			hz::string_replace_array(match, replacement_map);
-			hz::string_replace_array(against, replacement_map);
+			replacer.replace(match);
+			replacer.replace(against);
 
 			same_names = app_regex_partial_match("/^" + app_regex_escape(match) + "$/i", against);
 		}
 
-		std::string descr =  std::string("<b>") + Glib::Markup::escape_text(attr.displayable_name) + "</b>";
-		if (!same_names) {
-			const std::string reported_name_for_descr = Glib::Markup::escape_text(hz::string_replace_copy(p.reported_name, '_', ' '));
-			descr += "\n<small>Reported by smartctl as <b>\"" + reported_name_for_descr + "\"</b></small>\n";
-		}
-		descr += "\n";
-		descr += attr.description;
-
-		attr.description = descr;
+		// The database outlives the properties. The title is composed when the description is displayed.
+		p.set_static_description(attr_descr->description, same_names ? StorageProperty::DescriptionTitle::Name
+				: StorageProperty::DescriptionTitle::NameAndReportedName);
 	}
 
-	p.displayable_name = attr.displayable_name;
-	p.set_description(attr.description);
-	p.generic_name = attr.generic_name;
+	p.generic_name = (attr_descr ? attr_descr->generic_name : std::string());
 }
 
 
 
-void storage_property_ata_attribute_autoset_warning(StorageProperty& p)
+void storage_property_ata_attribute_autoset_warning(StorageProperty& p, const AtaStorageAttribute& attr)
 {
 	std::optional<WarningLevel> w;
 	std::string reason;
 
-	if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()) {
-		const auto& attr = p.get_value<AtaStorageAttribute>();
-
-		// Set notices for known pre-fail attributes. These are notices only, since the warnings
-		// and alerts are shown only in case of attribute failure.
-
-		// Reallocated Sector Count
-		if (attr_match(p, "attr_reallocated_sector_count") && attr.raw_value_int > 0) {
-			w = WarningLevel::Notice;
-			reason = "The drive has a non-zero Raw value, but there is no SMART warning yet. "
-					"This could be an indication of future failures and/or potential data loss in bad sectors.";
-
-		// Spin-up Retry Count
-		} else if (attr_match(p, "attr_spin_up_retry_count") && attr.raw_value_int > 0) {
-			w = WarningLevel::Notice;
-			reason = "The drive has a non-zero Raw value, but there is no SMART warning yet. "
-					"Your drive may have problems spinning up, which could lead to a complete mechanical failure. Please back up.";
-
-		// Soft Read Error Rate
-		} else if (attr_match(p, "attr_soft_read_error_rate") && attr.raw_value_int > 0) {
-			w = WarningLevel::Notice;
-			reason = "The drive has a non-zero Raw value, but there is no SMART warning yet. "
-					"This could be an indication of future failures and/or potential data loss in bad sectors.";
-
-		// Temperature (for some it may be 10xTemp, so limit the upper bound.)
-		} else if (attr_match(p, "attr_temperature_celsius")) {
-			// Raw value may be 27, or 253403791387 (which encodes min/max values as well).
-			// Use string instead.
-			std::int64_t temp_int = 0;
-			if (hz::string_is_numeric_nolocale(attr.raw_value, temp_int, false)
-					&& temp_int > 50 && temp_int <= 120) {  // 50C
-				w = WarningLevel::Notice;
-				reason = "The temperature of the drive is higher than 50 degrees Celsius. "
-							"This may shorten its lifespan and cause damage under severe load. Please install a cooling solution.";
-			}
-		// Temperature (for some it may be 10xTemp, so limit the upper bound.)
-		} else if (attr_match(p, "attr_temperature_celsius_x10") && attr.raw_value_int > 500) {  // 50C
-			w = WarningLevel::Notice;
-			reason = "The temperature of the drive is higher than 50 degrees Celsius. "
-					"This may shorten its lifespan and cause damage under severe load. Please install a cooling solution.";
-
-		// Reallocation Event Count
-		} else if (attr_match(p, "attr_reallocation_event_count") && attr.raw_value_int > 0) {
-			w = WarningLevel::Notice;
-			reason = "The drive has a non-zero Raw value, but there is no SMART warning yet. "
-					"This could be an indication of future failures and/or potential data loss in bad sectors.";
-
-		// Current Pending Sector Count
-		} else if ((attr_match(p, "attr_current_pending_sector_count") || attr_match(p, "attr_total_pending_sectors"))
-					&& attr.raw_value_int > 0) {
-			w = WarningLevel::Notice;
-			reason = "The drive has a non-zero Raw value, but there is no SMART warning yet. "
-					"This could be an indication of future failures and/or potential data loss in bad sectors.";
-
-		// Uncorrectable Sector Count
-		} else if ((attr_match(p, "attr_offline_uncorrectable") || attr_match(p, "attr_total_attr_offline_uncorrectable"))
-					&& attr.raw_value_int > 0) {
-			w = WarningLevel::Notice;
-			reason = "The drive has a non-zero Raw value, but there is no SMART warning yet. "
-					"This could be an indication of future failures and/or potential data loss in bad sectors.";
-
-		// SSD Life Left (%)
-		} else if ((attr_match(p, "attr_ssd_life_left"))
-					&& attr.value.value() < 50) {
-			w = WarningLevel::Notice;
-			reason = "The drive has less than half of its estimated life left.";
-
-		// SSD Life Used (%)
-		} else if ((attr_match(p, "attr_ssd_life_used"))
-					&& attr.raw_value_int >= 50) {
-			w = WarningLevel::Notice;
-			reason = "The drive has less than half of its estimated life left.";
-		}
+	if (attr.when_failed == AtaStorageAttribute::FailTime::Now) {  // NOW
 
-		// Now override this with reported SMART attribute failure warnings / errors
-
-		if (attr.when_failed == AtaStorageAttribute::FailTime::Now) {  // NOW
-
-			if (attr.attr_type == AtaStorageAttribute::AttributeType::OldAge) {  // old-age
-				w = WarningLevel::Warning;
-				reason = "The drive has a failing old-age attribute. Usually this indicates a wear-out. You should consider replacing the drive.";
-			} else {  // pre-fail
-				w = WarningLevel::Alert;
-				reason = "The drive has a failing pre-fail attribute. Usually this indicates a that the drive will FAIL soon. Please back up immediately!";
-			}
+		if (attr.attr_type == AtaStorageAttribute::AttributeType::OldAge) {  // old-age
+			w = WarningLevel::Warning;
+			reason = "The drive has a failing old-age attribute. Usually this indicates a wear-out. You should consider replacing the drive.";
+		} else {  // pre-fail
+			w = WarningLevel::Alert;
+			reason = "The drive has a failing pre-fail attribute. Usually this indicates a that the drive will FAIL soon. Please back up immediately!";
+		}
 
-		} else if (attr.when_failed == AtaStorageAttribute::FailTime::Past) {  // PAST
+	} else if (attr.when_failed == AtaStorageAttribute::FailTime::Past) {  // PAST
 
-			if (attr.attr_type == AtaStorageAttribute::AttributeType::OldAge) {  // old-age
-				// nothing. we don't warn about e.g. temperature increase in the past
-			} else {  // pre-fail
-				w = WarningLevel::Warning;  // there was a problem, it got corrected (hopefully)
-				reason = "The drive had a failing pre-fail attribute, but it has been restored to a normal value. "
-						"This may be a serious problem, you should consider replacing the drive.";
-			}
+		if (attr.attr_type == AtaStorageAttribute::AttributeType::OldAge) {  // old-age
+			// nothing. we don't warn about e.g. temperature increase in the past
+		} else {  // pre-fail
+			w = WarningLevel::Warning;  // there was a problem, it got corrected (hopefully)
+			reason = "The drive had a failing pre-fail attribute, but it has been restored to a normal value. "
+					"This may be a serious problem, you should consider replacing the drive.";
 		}
 	}
 
@@ -18,12 +18,13 @@ Copyright:
 
 
 /// Find a property's attribute in the attribute database and fill the property
-/// with all the readable information we can gather.
-void auto_set_ata_attribute_description(StorageProperty& p, StorageDeviceDetectedType drive_type);
+/// with all the readable information we can gather. \c attr is the value of \c p.
+void auto_set_ata_attribute_description(StorageProperty& p, const AtaStorageAttribute& attr, StorageDeviceDetectedType drive_type);
 
 
-/// If p is of appropriate type, set the warning on it if needed.
-void storage_property_ata_attribute_autoset_warning(StorageProperty& p);
+/// If \c attr (the value of \c p) failed now or in the past, set the warning on \c p.
+/// This overrides the warnings set by the warning rules.
+void storage_property_ata_attribute_autoset_warning(StorageProperty& p, const AtaStorageAttribute& attr);
 
 
 #endif
@@ -18,12 +18,8 @@ Copyright:
 
 
 /// Find a property's statistic in the statistic database and fill the property
-/// with all the readable information we can gather.
-bool auto_set_ata_statistic_description(StorageProperty& p);
-
-
-/// If p is of appropriate type, set the warning on it if needed.
-void storage_property_ata_statistic_autoset_warning(StorageProperty& p);
+/// with all the readable information we can gather. \c statistic is the value of \c p.
+bool auto_set_ata_statistic_description(StorageProperty& p, const AtaStorageStatistic& statistic);
 
 
 #endif
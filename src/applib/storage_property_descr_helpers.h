@@ -14,7 +14,11 @@ Copyright:
 
 #include <glibmm.h>
 #include <glibmm/i18n.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>  // std::size_t
 #include <string>
+#include <string_view>
 
 
 /// Get text related to "uncorrectable sectors"
@@ -32,6 +36,43 @@ inline const std::string& get_suffix_for_uncorrectable_property_description()
 
 
 
+/// Sort a description table by its \c KeyMember (a std::string_view member) at compile time,
+/// so that the table may be written in any (e.g. the specification) order and still be
+/// searched with storage_descr_table_find().
+template<auto KeyMember, typename Entry, std::size_t N>
+constexpr std::array<Entry, N> storage_descr_table_sort(std::array<Entry, N> table)
+{
+	std::sort(table.begin(), table.end(), [](const Entry& a, const Entry& b) { return a.*KeyMember < b.*KeyMember; });
+	return table;
+}
+
+
+
+/// Check that the keys of a table sorted by storage_descr_table_sort() are unique
+template<auto KeyMember, typename Entry, std::size_t N>
+constexpr bool storage_descr_table_keys_unique(const std::array<Entry, N>& table)
+{
+	return std::adjacent_find(table.begin(), table.end(),
+			[](const Entry& a, const Entry& b) { return a.*KeyMember == b.*KeyMember; }) == table.end();
+}
+
+
+
+/// Find an entry in a table sorted by storage_descr_table_sort(). This doesn't allocate.
+/// \return nullptr if not found.
+template<auto KeyMember, typename Entry, std::size_t N>
+const Entry* storage_descr_table_find(const std::array<Entry, N>& table, std::string_view key)
+{
+	auto iter = std::lower_bound(table.begin(), table.end(), key,
+			[](const Entry& entry, std::string_view k) { return entry.*KeyMember < k; });
+	if (iter == table.end() || (*iter).*KeyMember != key) {
+		return nullptr;
+	}
+	return &(*iter);
+}
+
+
+
 #endif
 
 /// @}
@@ -10,163 +10,100 @@ Copyright:
 /// @{
 
 #include <glibmm.h>
-#include <utility>
-#include <map>
-#include <optional>
+#include <glibmm/i18n.h>
+#include <array>
 #include <string>
+#include <string_view>
 
 #include "hz/string_algo.h"  // string_replace_copy
 //#include "applib/app_regex.h"
 
 #include "storage_property_descr_nvme_attribute.h"
 //#include "warning_colors.h"
-//#include "storage_property_descr_helpers.h"
+#include "storage_property_descr_helpers.h"
 
 
 namespace {
 
 
-	/// Attribute description for attribute database
+	/// NVMe attribute description.
+	/// Note: Displayable names for known attributes have already been added while parsing.
+	/// For unknown attributes, the displayable name is derived from generic name.
 	struct NvmeAttributeDescription {
-		/// Constructor
-		NvmeAttributeDescription() = default;
-
-		/// Constructor
-		NvmeAttributeDescription(std::string generic_name_, std::string description_)
-				: generic_name(std::move(generic_name_)), description(std::move(description_))
-		{ }
-
-//		std::string reported_name;  ///< e.g. Highest Temperature
-//		std::string displayable_name;  ///< e.g. Highest Temperature (C)
-		std::string generic_name;  ///< Generic name to be set on the property.
-		std::string description;  ///< Attribute description, can be "".
+		std::string_view generic_name;  ///< Generic name of the property
+		const char* description = nullptr;  ///< Attribute description (untranslated, see N_())
 	};
 
 
 
-	/// Devstat entry description database
-	class NvmeAttributeDescriptionDatabase {
-		public:
+	/// NVMe attribute description database, sorted by generic name at compile time.
+	/// The entries are string literals, so neither the database nor the lookups allocate.
+	constexpr auto nvme_attribute_description_db = storage_descr_table_sort<&NvmeAttributeDescription::generic_name>(
+			std::to_array<NvmeAttributeDescription>({
+			{"nvme_smart_health_information_log/temperature",
+					N_("Drive temperature (Celsius)")},
 
-			/// Constructor
-			NvmeAttributeDescriptionDatabase()
-			{
-				add("nvme_smart_health_information_log/temperature",
-						_("Drive temperature (Celsius)"));
+			{"nvme_smart_health_information_log/available_spare",
+					N_("Normalized percentage (0% to 100%) of the remaining space capacity. "
+					  "If Available Spare is lower than Available Space Threshold, the drive is considered to be in a critical state.")},
 
-				add("nvme_smart_health_information_log/available_spare",
-						_("Normalized percentage (0% to 100%) of the remaining space capacity. "
-						  "If Available Spare is lower than Available Space Threshold, the drive is considered to be in a critical state."));
+			{"nvme_smart_health_information_log/available_spare_threshold",
+					N_("Normalized percentage (0% to 100%). If the Available Spare is lower than this threshold, the drive is considered to be in a critical state.")},
 
-				add("nvme_smart_health_information_log/available_spare_threshold",
-						_("Normalized percentage (0% to 100%). If the Available Spare is lower than this threshold, the drive is considered to be in a critical state."));
+			{"nvme_smart_health_information_log/percentage_used",
+					N_("Vendor-specific estimate of the percentage of device life based on the actual device usage and the manufacturer's prediction of the device life. "
+					  "A value of 100 indicates that the estimated endurance of the device has been consumed, but may not indicate a device failure. "
+					  "This value is allowed to exceed 100. Percentage values greater than 254 are be represented as 255. This value is updated once "
+					  "per power-on hour (when the controller is not in a sleep state).")},
 
-				add("nvme_smart_health_information_log/percentage_used",
-						_("Vendor-specific estimate of the percentage of device life based on the actual device usage and the manufacturer's prediction of the device life. "
-						  "A value of 100 indicates that the estimated endurance of the device has been consumed, but may not indicate a device failure. "
-						  "This value is allowed to exceed 100. Percentage values greater than 254 are be represented as 255. This value is updated once "
-						  "per power-on hour (when the controller is not in a sleep state)."));
+			{"nvme_smart_health_information_log/data_units_read",
+					N_("The number of 512-byte data units the host has read from the controller. "
+					  "This value does not include metadata. "
+					  "The value is reported in thousands (i.e. a value of 1 corresponds to 1000 units of 512 bytes read) and is rounded up. "
+					  "When the LBA size is a value other than 512 bytes, the controller converts the amount of data read to 512-byte units.")},
 
-				add("nvme_smart_health_information_log/data_units_read",
-						_("The number of 512-byte data units the host has read from the controller. "
-						  "This value does not include metadata. "
-						  "The value is reported in thousands (i.e. a value of 1 corresponds to 1000 units of 512 bytes read) and is rounded up. "
-						  "When the LBA size is a value other than 512 bytes, the controller converts the amount of data read to 512-byte units."));
+			{"nvme_smart_health_information_log/data_units_written",
+					N_("The number of 512-byte data units the host has written to the controller. "
+					  "This value does not include metadata. "
+					  "The value is reported in thousands (i.e. a value of 1 corresponds to 1000 units of 512 bytes read) and is rounded up.")},
 
-				add("nvme_smart_health_information_log/data_units_written",
-						_("The number of 512-byte data units the host has written to the controller. "
-						  "This value does not include metadata. "
-						  "The value is reported in thousands (i.e. a value of 1 corresponds to 1000 units of 512 bytes read) and is rounded up."));
+			{"nvme_smart_health_information_log/host_reads",
+					N_("Number of read commands completed by the controller")},
 
-				add("nvme_smart_health_information_log/host_reads",
-						_("Number of read commands completed by the controller"));
+			{"nvme_smart_health_information_log/host_writes",
+					N_("Number of write commands completed by the controller")},
 
-				add("nvme_smart_health_information_log/host_writes",
-						_("Number of write commands completed by the controller"));
+			{"nvme_smart_health_information_log/controller_busy_time",
+					N_("The amount of time the controller is busy with I/O commands.")},
 
-				add("nvme_smart_health_information_log/controller_busy_time",
-						_("The amount of time the controller is busy with I/O commands."));
+			{"nvme_smart_health_information_log/power_cycles",
+					N_("Number of power cycles experienced by the drive")},
 
-				add("nvme_smart_health_information_log/power_cycles",
-						_("Number of power cycles experienced by the drive"));
+			{"nvme_smart_health_information_log/power_on_hours",
+					N_("Number of hours in power-on state. This does not include the time that the controller was powered in a low power state condition.")},
 
-				add("nvme_smart_health_information_log/power_on_hours",
-						_("Number of hours in power-on state. This does not include the time that the controller was powered in a low power state condition."));
+			{"nvme_smart_health_information_log/unsafe_shutdowns",
+					N_("Number of unsafe shutdowns. This value is incremented when a shutdown notification is not received prior to loss of power.")},
 
-				add("nvme_smart_health_information_log/unsafe_shutdowns",
-						_("Number of unsafe shutdowns. This value is incremented when a shutdown notification is not received prior to loss of power."));
+			{"nvme_smart_health_information_log/media_errors",
+					N_("Number of occurrences where the controller detected an unrecovered data integrity error. Errors such as uncorrectable ECC, "
+					  "CRC checksum failure or LBA tag mismatch are included in this field.")},
 
-				add("nvme_smart_health_information_log/media_errors",
-						_("Number of occurrences where the controller detected an unrecovered data integrity error. Errors such as uncorrectable ECC, "
-						  "CRC checksum failure or LBA tag mismatch are included in this field."));
+			{"nvme_smart_health_information_log/num_err_log_entries",
+					N_("Maximum number of possible Error Information Log entries preserved over the life of the controller")},
 
-				add("nvme_smart_health_information_log/num_err_log_entries",
-						_("Maximum number of possible Error Information Log entries preserved over the life of the controller"));
+			/// FIXME unit?
+			{"nvme_smart_health_information_log/warning_temp_time",
+					N_("The minimum Composite Temperature field value indicates an overheating condition during which the controller operation continues. "
+					  "Immediate remediation is recommended (e.g. additional cooling or workload reduction).")},
 
-				/// FIXME unit?
-				add("nvme_smart_health_information_log/warning_temp_time",
-						_("The minimum Composite Temperature field value indicates an overheating condition during which the controller operation continues. "
-						  "Immediate remediation is recommended (e.g. additional cooling or workload reduction)."));
+			{"nvme_smart_health_information_log/critical_comp_time",
+					N_("The amount of time in minutes that the controller is operational and the Composite Temperature is >= Critical Composite Temperature Threshold (CCTEMP).")},
+			}));
 
-				add("nvme_smart_health_information_log/critical_comp_time",
-						_("The amount of time in minutes that the controller is operational and the Composite Temperature is >= Critical Composite Temperature Threshold (CCTEMP)."));
-			}
+	static_assert(storage_descr_table_keys_unique<&NvmeAttributeDescription::generic_name>(nvme_attribute_description_db));
 
 
-			/// Add an attribute description to the attribute database.
-			/// Note: Displayable names for known attributes have already been added while parsing.
-			/// For unknown attributes, the displayable name is derived from generic name.
-			void add(const std::string& generic_name, const std::string& description)
-			{
-				add(NvmeAttributeDescription(generic_name, description));
-			}
-
-
-			/// Add an devstat entry description to the devstat database
-			void add(const NvmeAttributeDescription& descr)
-			{
-				nvme_attr_db[descr.generic_name] = descr;
-			}
-
-
-			/// Find the description by smartctl generic name.
-			[[nodiscard]] NvmeAttributeDescription find(const std::string& reported_name) const
-			{
-				// search by ID first
-				auto iter = nvme_attr_db.find(reported_name);
-				if (iter == nvme_attr_db.end()) {
-					return {};  // not found
-				}
-				return iter->second;
-			}
-
-
-		private:
-
-			std::map<std::string, NvmeAttributeDescription> nvme_attr_db;  ///< generic_name => description
-
-	};
-
-
-
-	/// Get program-wide devstat description database
-	[[nodiscard]] inline const NvmeAttributeDescriptionDatabase& get_nvme_attribute_description_db()
-	{
-		static const NvmeAttributeDescriptionDatabase nvme_attr_db;
-		return nvme_attr_db;
-	}
-
-
-
-	/// Check if a property matches a name (generic or reported)
-	inline bool name_match(StorageProperty& p, const std::string& name)
-	{
-		if (p.generic_name.empty()) {
-			return hz::string_to_lower_copy(p.reported_name) == hz::string_to_lower_copy(name);
-		}
-		return hz::string_to_lower_copy(p.generic_name) == hz::string_to_lower_copy(name);
-	}
-
 
 }
 
@@ -175,25 +112,21 @@ namespace {
 /// with all the readable information we can gather.
 bool auto_set_nvme_attribute_description(StorageProperty& p)
 {
-	NvmeAttributeDescription attr_descr = get_nvme_attribute_description_db().find(p.generic_name);
-
-//		const std::string displayable_name = (attr_descr.displayable_name.empty() ? attr_descr.reported_name : attr_descr.displayable_name);
+	const NvmeAttributeDescription* attr_descr = storage_descr_table_find<&NvmeAttributeDescription::generic_name>(
+			nvme_attribute_description_db, p.generic_name);
 
-	const bool found = !attr_descr.description.empty();
+	const bool found = (attr_descr != nullptr);
 	if (!found) {
 		// Derive displayable name from generic name
 //			p.displayable_name = hz::string_replace_copy(p.generic_name, "_", " ");
 
-		attr_descr.description = "No description is available for this attribute.";
+		p.set_static_description("No description is available for this attribute.");
 
 	} else {
-		std::string descr =  std::string("<b>") + Glib::Markup::escape_text(p.displayable_name) + "</b>\n";
-		descr += attr_descr.description;
-
-		attr_descr.description = descr;
+		// The translations are static too
+		p.set_static_description(_(attr_descr->description), StorageProperty::DescriptionTitle::Name);
 	}
 
-	p.set_description(attr_descr.description);
 //		p.generic_name = attr_descr.generic_name;
 
 	return found;
@@ -203,61 +136,4 @@ bool auto_set_nvme_attribute_description(StorageProperty& p)
 
 
 
-void storage_property_nvme_attribute_autoset_warning(StorageProperty& p)
-{
-	std::optional<WarningLevel> w = WarningLevel::None;
-	std::string reason;
-
-	if (p.section != StoragePropertySection::NvmeAttributes) {
-		return;
-	}
-
-	if (name_match(p, "nvme_smart_health_information_log/temperature") && p.is_value_type<int64_t >() && p.get_value<int64_t>() > 50) {  // 50C
-		w = WarningLevel::Notice;
-		reason = "The temperature of the drive is higher than 50 degrees Celsius. "
-				"This may shorten its lifespan and cause damage under severe load. Please install a cooling solution.";
-
-	} else if (name_match(p, "nvme_smart_health_information_log/available_spare") && p.is_value_type<int64_t >()
-			&& p.get_value<int64_t>() <= 10) {  // 10% (arbitrary value)
-		w = WarningLevel::Warning;
-		reason = "The drive has less than 10% available spare lifetime left.";
-
-	} else if (name_match(p, "nvme_smart_health_information_log/percentage_used") && p.is_value_type<int64_t >()
-			&& p.get_value<int64_t>() >= 90) {  // 90% (arbitrary value)
-		w = WarningLevel::Warning;
-		reason = "The estimate drive lifetime is nearing its limit.";
-
-	} else if (name_match(p, "nvme_smart_health_information_log/media_errors") && p.is_value_type<int64_t >()
-			&& p.get_value<int64_t>() > 0) {
-		w = WarningLevel::Notice;
-		reason = "There are media errors present on this drive.";
-
-//	} else if (name_match(p, "nvme_smart_health_information_log/num_err_log_entries") && p.is_value_type<int64_t >()
-//			&& p.get_value<int64_t>() > 0) {
-//		w = WarningLevel::Warning;
-//		reason = "The drive has errors in its persistent error log.";
-
-	} else if (name_match(p, "nvme_smart_health_information_log/warning_temp_time") && p.is_value_type<int64_t >()
-			&& p.get_value<int64_t>() > 0) {
-		w = WarningLevel::Notice;
-		reason = "The drive detected is or was overheating. "
-				 "This may have shortened its lifespan and caused damage. Please install a cooling solution.";
-
-	} else if (name_match(p, "nvme_smart_health_information_log/critical_comp_time") && p.is_value_type<int64_t >()
-			&& p.get_value<int64_t>() > 0) {
-		w = WarningLevel::Notice;
-		reason = "The drive detected is or was overheating. "
-				 "This may have shortened its lifespan and caused damage. Please install a cooling solution.";
-	}
-
-	if (w.has_value()) {
-		p.warning_level = w.value();
-		p.warning_reason = reason;
-	}
-}
-
-
-
-
-
 /// @}
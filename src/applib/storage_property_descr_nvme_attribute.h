@@ -22,10 +22,6 @@ Copyright:
 bool auto_set_nvme_attribute_description(StorageProperty& p);
 
 
-/// If p is of appropriate type, set the warning on it if needed.
-void storage_property_nvme_attribute_autoset_warning(StorageProperty& p);
-
-
 #endif
 
 /// @}
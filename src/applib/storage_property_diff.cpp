@@ -0,0 +1,124 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>  // std::any_of
+#include <cstddef>  // std::size_t
+#include <string_view>
+#include <unordered_map>
+
+#include "storage_property_diff.h"
+
+
+
+WarningLevel StoragePropertyChange::get_old_warning_level() const
+{
+	return old_property.has_value() ? old_property->warning_level : WarningLevel::None;
+}
+
+
+
+WarningLevel StoragePropertyChange::get_new_warning_level() const
+{
+	return new_property.has_value() ? new_property->warning_level : WarningLevel::None;
+}
+
+
+
+bool StoragePropertyChange::get_warning_level_changed() const
+{
+	return get_old_warning_level() != get_new_warning_level();
+}
+
+
+
+bool StoragePropertyDiff::empty() const
+{
+	return changes.empty();
+}
+
+
+
+bool StoragePropertyDiff::has_warning_level_changes() const
+{
+	return std::any_of(changes.begin(), changes.end(),
+			[](const StoragePropertyChange& change) { return change.get_warning_level_changed(); });
+}
+
+
+
+bool storage_property_values_equal(const StorageProperty& a, const StorageProperty& b)
+{
+	return a.value == b.value
+			&& a.reported_value == b.reported_value
+			&& a.readable_value == b.readable_value
+			&& a.displayable_name == b.displayable_name
+			&& a.warning_level == b.warning_level
+			&& a.warning_reason == b.warning_reason
+			&& a.show_in_ui == b.show_in_ui;
+}
+
+
+
+StoragePropertyDiff storage_property_repository_diff(
+		const StoragePropertyRepository& old_repo, const StoragePropertyRepository& new_repo)
+{
+	// An unmodified copy, e.g. the drive wasn't refreshed since
+	if (old_repo.shares_data_with(new_repo)) {
+		return {};
+	}
+
+	const auto& old_props = old_repo.get_properties();
+	const auto& new_props = new_repo.get_properties();
+
+	// generic_name -> indices in old_props. Usually there's only one property per name.
+	std::unordered_map<std::string_view, std::vector<std::size_t>> old_indices;
+	old_indices.reserve(old_props.size());
+	for (std::size_t i = 0; i < old_props.size(); ++i) {
+		old_indices[old_props[i].generic_name].push_back(i);
+	}
+	std::vector<bool> old_matched(old_props.size(), false);
+
+	StoragePropertyDiff diff;
+
+	for (const auto& p : new_props) {
+		std::optional<std::size_t> old_index;
+		if (auto iter = old_indices.find(p.generic_name); iter != old_indices.end()) {
+			for (const std::size_t i : iter->second) {
+				if (!old_matched[i] && old_props[i].section == p.section) {
+					old_index = i;
+					break;
+				}
+			}
+		}
+
+		if (!old_index.has_value()) {
+			diff.changes.push_back({StoragePropertyChange::Type::Added, std::nullopt, p});
+			continue;
+		}
+		old_matched[old_index.value()] = true;
+		if (!storage_property_values_equal(old_props[old_index.value()], p)) {
+			diff.changes.push_back({StoragePropertyChange::Type::Changed, old_props[old_index.value()], p});
+		}
+	}
+
+	for (std::size_t i = 0; i < old_props.size(); ++i) {
+		if (!old_matched[i]) {
+			diff.changes.push_back({StoragePropertyChange::Type::Removed, old_props[i], std::nullopt});
+		}
+	}
+
+	return diff;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,83 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_PROPERTY_DIFF_H
+#define STORAGE_PROPERTY_DIFF_H
+
+#include <optional>
+#include <vector>
+
+#include "storage_property_repository.h"
+#include "warning_level.h"
+
+
+
+/// A single difference between two property repositories
+struct StoragePropertyChange {
+
+	/// Change type
+	enum class Type {
+		Added,  ///< Only in the new repository
+		Removed,  ///< Only in the old repository
+		Changed,  ///< In both, with a different value or warning
+	};
+
+
+	/// Get the warning level before the change (None if added)
+	[[nodiscard]] WarningLevel get_old_warning_level() const;
+
+	/// Get the warning level after the change (None if removed)
+	[[nodiscard]] WarningLevel get_new_warning_level() const;
+
+	/// Check if the warning level is different before and after the change
+	[[nodiscard]] bool get_warning_level_changed() const;
+
+
+	Type type = Type::Changed;  ///< Change type
+	std::optional<StorageProperty> old_property;  ///< Property in the old repository, unset if added
+	std::optional<StorageProperty> new_property;  ///< Property in the new repository, unset if removed
+
+};
+
+
+
+/// Differences between two property repositories
+struct StoragePropertyDiff {
+
+	/// Check if there are no changes
+	[[nodiscard]] bool empty() const;
+
+	/// Check if any warning level changed (including added / removed properties with warnings)
+	[[nodiscard]] bool has_warning_level_changes() const;
+
+
+	std::vector<StoragePropertyChange> changes;  ///< Changes, in the new repository order, then the removed ones
+
+};
+
+
+
+/// Check if two properties have the same value, displayed strings and warning.
+/// The descriptions come from the description databases and are not compared.
+[[nodiscard]] bool storage_property_values_equal(const StorageProperty& a, const StorageProperty& b);
+
+
+/// Compute the differences between two repositories. The properties are matched by
+/// (section, generic_name); properties with the same key are matched in the order of appearance.
+[[nodiscard]] StoragePropertyDiff storage_property_repository_diff(
+		const StoragePropertyRepository& old_repo, const StoragePropertyRepository& new_repo);
+
+
+
+
+#endif
+
+/// @}
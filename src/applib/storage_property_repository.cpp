@@ -13,16 +13,125 @@ Copyright:
 
 
 
+void StoragePropertyWarningSummary::add(const StorageProperty& p)
+{
+	++level_counts[static_cast<std::size_t>(p.warning_level)];
+	if (p.warning_level == WarningLevel::None) {
+		return;
+	}
+	if (p.warning_level > max_level) {
+		max_level = p.warning_level;
+		top_reasons.clear();
+	}
+	if (p.warning_level == max_level && top_reasons.size() < max_top_reasons) {
+		top_reasons.push_back(p.warning_reason);
+	}
+}
+
+
+
+void StoragePropertyWarningSummary::merge(const StoragePropertyWarningSummary& other)
+{
+	for (std::size_t i = 0; i < level_counts.size(); ++i) {
+		level_counts[i] += other.level_counts[i];
+	}
+	if (other.max_level == WarningLevel::None || other.max_level < max_level) {
+		return;
+	}
+	if (other.max_level > max_level) {
+		max_level = other.max_level;
+		top_reasons.clear();
+	}
+	for (const auto& reason : other.top_reasons) {
+		if (top_reasons.size() >= max_top_reasons) {
+			break;
+		}
+		top_reasons.push_back(reason);
+	}
+}
+
+
+
+std::size_t StoragePropertyWarningSummary::get_warning_count() const
+{
+	return get_count(WarningLevel::Notice) + get_count(WarningLevel::Warning) + get_count(WarningLevel::Alert);
+}
+
+
+
+std::size_t StoragePropertyWarningSummary::get_count(WarningLevel level) const
+{
+	return level_counts[static_cast<std::size_t>(level)];
+}
+
+
+
+StoragePropertyRepository::StoragePropertyRepository()
+		: data_(get_empty_data())
+{ }
+
+
+
+StoragePropertyRepository::StoragePropertyRepository(const StoragePropertyRepository& other)
+{
+	// Shared data is never modified, finish it before sharing
+	other.build_lookup_index();
+	other.build_warning_summaries();
+	data_ = other.data_;
+}
+
+
+
+StoragePropertyRepository::StoragePropertyRepository(StoragePropertyRepository&& other) noexcept
+		: data_(std::exchange(other.data_, get_empty_data()))
+{ }
+
+
+
+StoragePropertyRepository& StoragePropertyRepository::operator=(const StoragePropertyRepository& other)
+{
+	if (this != &other) {
+		other.build_lookup_index();
+		other.build_warning_summaries();
+		data_ = other.data_;
+	}
+	return *this;
+}
+
+
+
+StoragePropertyRepository& StoragePropertyRepository::operator=(StoragePropertyRepository&& other) noexcept
+{
+	if (this != &other) {
+		data_ = std::exchange(other.data_, get_empty_data());
+	}
+	return *this;
+}
+
+
+
 const std::vector<StorageProperty>& StoragePropertyRepository::get_properties() const
 {
-	return properties_;
+	return data_->properties;
 }
 
 
 
 std::vector<StorageProperty>& StoragePropertyRepository::get_properties_ref()
 {
-	return properties_;
+	return get_mutable_data().properties;  // the caller may modify the properties
+}
+
+
+
+std::span<const StorageProperty> StoragePropertyRepository::get_properties_for_section(StoragePropertySection section) const
+{
+	const auto index = static_cast<std::size_t>(section);
+	if (index >= section_count) {
+		return {};
+	}
+	return std::span<const StorageProperty>(data_->properties).subspan(
+			data_->section_offsets[index], data_->section_offsets[index + 1] - data_->section_offsets[index]);
 }
 
 
@@ -30,42 +139,195 @@ std::vector<StorageProperty>& StoragePropertyRepository::get_properties_ref()
 StorageProperty StoragePropertyRepository::lookup_property(
 		const std::string& generic_name, StoragePropertySection section) const
 {
-	for (const auto& p : properties_) {
-		if (section != StoragePropertySection::Unknown && p.section != section)
-			continue;
-
-		if (p.generic_name == generic_name)
-			return p;
+	if (const auto* p = find_property(generic_name, section)) {
+		return *p;
 	}
 	return {};  // check with .empty()
 }
 
 
 
+const StorageProperty* StoragePropertyRepository::find_property(
+		const std::string& generic_name, StoragePropertySection section) const
+{
+	build_lookup_index();
+	if (auto iter = data_->lookup_index.find(IndexKey{section, generic_name});
+			iter != data_->lookup_index.end() && iter->second < data_->properties.size()) {
+		return &data_->properties[iter->second];
+	}
+	return nullptr;
+}
+
+
+
 void StoragePropertyRepository::set_properties(std::vector<StorageProperty> properties)
 {
-	properties_ = std::move(properties);
+	auto data = std::make_shared<Data>();
+	data->properties = std::move(properties);
+	const auto section_less = [](const StorageProperty& a, const StorageProperty& b) {
+		return a.section < b.section;
+	};
+	if (!std::is_sorted(data->properties.begin(), data->properties.end(), section_less)) {
+		std::stable_sort(data->properties.begin(), data->properties.end(), section_less);
+	}
+	data_ = std::move(data);
+	update_section_offsets();
 }
 
 
 
 void StoragePropertyRepository::add_property(StorageProperty property)
 {
-	properties_.push_back(std::move(property));
+	Data& data = get_mutable_data();
+	const auto index = static_cast<std::size_t>(property.section);
+	if (data.section_offsets[index + 1] == data.properties.size()) {
+		data.properties.push_back(std::move(property));  // last section, no need to move anything
+	} else {
+		data.properties.insert(data.properties.begin() + static_cast<std::ptrdiff_t>(data.section_offsets[index + 1]), std::move(property));
+	}
+	for (std::size_t i = index + 1; i < data.section_offsets.size(); ++i) {
+		++data.section_offsets[i];
+	}
 }
 
 
 
 void StoragePropertyRepository::clear()
 {
-	properties_.clear();
+	data_ = get_empty_data();
+}
+
+
+
+std::size_t StoragePropertyRepository::get_memory_usage() const
+{
+	const auto& properties = data_->properties;
+	std::size_t size = (properties.capacity() - properties.size()) * sizeof(StorageProperty);
+	for (const auto& p : properties) {
+		size += p.get_memory_usage();
+	}
+	// Node, key string and bucket of each index entry
+	for (const auto& entry : data_->lookup_index) {
+		size += sizeof(IndexKey) + sizeof(std::size_t) + 2 * sizeof(void*) + entry.first.generic_name.size();
+	}
+	return size + data_->lookup_index.bucket_count() * sizeof(void*);
 }
 
 
 
 bool StoragePropertyRepository::has_properties_for_section(StoragePropertySection section) const
 {
-	return std::any_of(properties_.begin(), properties_.end(),
-			[section](const StorageProperty& p) { return p.section == section; });
+	return !get_properties_for_section(section).empty();
+}
+
+
+
+const StoragePropertyWarningSummary& StoragePropertyRepository::get_warning_summary(StoragePropertySection section) const
+{
+	build_warning_summaries();
+	const auto index = static_cast<std::size_t>(section);
+	if (section == StoragePropertySection::Unknown || index >= section_count) {
+		return data_->warning_summary;
+	}
+	return data_->section_warning_summaries[index];
+}
+
+
+
+void StoragePropertyRepository::update_warning_summaries()
+{
+	build_warning_summaries();
+}
+
+
+
+bool StoragePropertyRepository::shares_data_with(const StoragePropertyRepository& other) const
+{
+	return data_ == other.data_;
 }
 
+
+
+const std::shared_ptr<StoragePropertyRepository::Data>& StoragePropertyRepository::get_empty_data()
+{
+	static const std::shared_ptr<Data> empty_data = []() {
+		auto data = std::make_shared<Data>();
+		data->lookup_index_valid = true;  // shared from the start
+		data->warning_summaries_valid = true;
+		return data;
+	}();
+	return empty_data;
+}
+
+
+
+StoragePropertyRepository::Data& StoragePropertyRepository::get_mutable_data()
+{
+	if (data_.use_count() > 1) {
+		// The caches are invalidated anyway, don't copy them
+		auto data = std::make_shared<Data>();
+		data->properties = data_->properties;
+		data->section_offsets = data_->section_offsets;
+		data_ = std::move(data);
+	}
+	data_->lookup_index_valid = false;
+	data_->warning_summaries_valid = false;
+	return *data_;
+}
+
+
+
+void StoragePropertyRepository::update_section_offsets()
+{
+	const auto& properties = data_->properties;
+	auto& section_offsets = data_->section_offsets;
+	std::size_t pos = 0;
+	for (std::size_t i = 0; i < section_count; ++i) {
+		section_offsets[i] = pos;
+		while (pos < properties.size() && static_cast<std::size_t>(properties[pos].section) == i) {
+			++pos;
+		}
+	}
+	section_offsets[section_count] = properties.size();
+}
+
+
+
+void StoragePropertyRepository::build_lookup_index() const
+{
+	if (data_->lookup_index_valid)
+		return;
+
+	const auto& properties = data_->properties;
+	auto& lookup_index = data_->lookup_index;
+	lookup_index.clear();
+	lookup_index.reserve(properties.size() * 2);
+	for (std::size_t i = 0; i < properties.size(); ++i) {
+		const auto& p = properties[i];
+		// emplace() keeps the existing entry, so the first matching property wins.
+		lookup_index.emplace(IndexKey{p.section, p.generic_name}, i);
+		lookup_index.emplace(IndexKey{StoragePropertySection::Unknown, p.generic_name}, i);
+	}
+	data_->lookup_index_valid = true;
+}
+
+
+
+void StoragePropertyRepository::build_warning_summaries() const
+{
+	if (data_->warning_summaries_valid)
+		return;
+
+	data_->warning_summary = StoragePropertyWarningSummary();
+	for (std::size_t i = 0; i < section_count; ++i) {
+		auto& summary = data_->section_warning_summaries[i];
+		summary = StoragePropertyWarningSummary();
+		for (const auto& p : get_properties_for_section(static_cast<StoragePropertySection>(i))) {
+			if (p.show_in_ui) {
+				summary.add(p);
+			}
+		}
+		data_->warning_summary.merge(summary);
+	}
+	data_->warning_summaries_valid = true;
+}
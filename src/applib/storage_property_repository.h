@@ -6,21 +6,84 @@ Copyright:
 #ifndef STORAGE_PROPERTY_REPOSITORY_H
 #define STORAGE_PROPERTY_REPOSITORY_H
 
+#include <array>
+#include <memory>
 #include <string>
 #include <vector>
+#include <span>
+#include <unordered_map>
+#include <cstddef>  // std::size_t
 #include "storage_property.h"
+#include "warning_level.h"
+
+
+
+/// Summary of the warnings of a group of properties (a section or a whole repository)
+struct StoragePropertyWarningSummary {
+
+	/// Maximum number of reasons kept in top_reasons
+	static constexpr std::size_t max_top_reasons = 3;
+
+	/// Add a property to the summary
+	void add(const StorageProperty& p);
+
+	/// Add another summary to this one. The reasons of this one come first.
+	void merge(const StoragePropertyWarningSummary& other);
+
+	/// Get the number of properties with a warning of any level
+	[[nodiscard]] std::size_t get_warning_count() const;
+
+	/// Get the number of properties with a warning of \c level
+	[[nodiscard]] std::size_t get_count(WarningLevel level) const;
+
+
+	WarningLevel max_level = WarningLevel::None;  ///< Worst warning level
+	std::array<std::size_t, static_cast<std::size_t>(WarningLevel::Alert) + 1> level_counts = {};  ///< Number of properties of each warning level
+	std::vector<std::string> top_reasons;  ///< Warning reasons of the first properties with the worst level, at most max_top_reasons
+
+};
+
 
 
 /// A repository of properties. Used to store and look up drive properties.
+/// The properties are kept grouped by section (in StoragePropertySection order),
+/// in the order they were added within each section.
+/// The data is reference-counted and copied on write, so the copies (snapshots of the drive,
+/// the previous state for diffing, etc.) don't copy the properties until one of them is modified.
 class StoragePropertyRepository {
 	public:
 
-		/// Get all properties
+		/// Constructor. Creates an empty repository without allocating.
+		StoragePropertyRepository();
+
+		/// Copy constructor. The data is shared, not copied.
+		StoragePropertyRepository(const StoragePropertyRepository& other);
+
+		/// Move constructor. \c other is left empty.
+		StoragePropertyRepository(StoragePropertyRepository&& other) noexcept;
+
+		/// Copy assignment. The data is shared, not copied.
+		StoragePropertyRepository& operator=(const StoragePropertyRepository& other);
+
+		/// Move assignment. \c other is left empty.
+		StoragePropertyRepository& operator=(StoragePropertyRepository&& other) noexcept;
+
+		/// Destructor
+		~StoragePropertyRepository() = default;
+
+
+		/// Get all properties, grouped by section
 		[[nodiscard]] const std::vector<StorageProperty>& get_properties() const;
 
-		/// Get all properties
+		/// Get all properties, for modifying them in place. The data is copied first if it's shared.
+		/// Don't add or remove the properties or change their sections through this
+		/// (use set_properties() and add_property()), it would break the section grouping.
+		/// This invalidates the lookup index; don't keep the reference across lookups or copies.
 		[[nodiscard]] std::vector<StorageProperty>& get_properties_ref();
 
+		/// Get the properties of a section. The span is valid until the repository is modified.
+		[[nodiscard]] std::span<const StorageProperty> get_properties_for_section(StoragePropertySection section) const;
+
 
 		/// Find a property.
 		/// If section is Section::Unknown, search in all sections.
@@ -28,23 +91,110 @@ class StoragePropertyRepository {
 				StoragePropertySection section = StoragePropertySection::Unknown) const;
 
 
-		/// Set properties
+		/// Same as lookup_property(), but returns a pointer to the stored property
+		/// (nullptr if not found) instead of a copy. The pointer is valid until the
+		/// repository is modified.
+		[[nodiscard]] const StorageProperty* find_property(const std::string& generic_name,
+				StoragePropertySection section = StoragePropertySection::Unknown) const;
+
+
+		/// Set properties. They are (stably) grouped by section.
 		void set_properties(std::vector<StorageProperty> properties);
 
-		/// Add a property
+		/// Add a property at the end of its section
 		void add_property(StorageProperty property);
 
 		/// Clear all properties
 		void clear();
 
 
+		/// Get the approximate memory usage of the properties (see StorageProperty::get_memory_usage())
+		/// and the lookup index
+		[[nodiscard]] std::size_t get_memory_usage() const;
+
+
 		/// Check if there are any properties for a given section
 		[[nodiscard]] bool has_properties_for_section(StoragePropertySection section) const;
 
 
+		/// Get the warning summary of the properties shown in UI in a section.
+		/// If section is Section::Unknown, get the summary of all sections.
+		/// The summaries are computed by update_warning_summaries() (called by
+		/// StoragePropertyProcessor::process_properties()), or on first use after a modification.
+		[[nodiscard]] const StoragePropertyWarningSummary& get_warning_summary(
+				StoragePropertySection section = StoragePropertySection::Unknown) const;
+
+		/// Compute the warning summaries now, so that the readers don't have to
+		void update_warning_summaries();
+
+
+		/// Check if this repository shares its data with \c other, i.e. one is an unmodified
+		/// copy of the other. Such repositories have the same properties.
+		[[nodiscard]] bool shares_data_with(const StoragePropertyRepository& other) const;
+
+
 	private:
 
-		std::vector<StorageProperty> properties_;  ///< Parsed data properties
+		/// Number of sections
+		static constexpr std::size_t section_count = static_cast<std::size_t>(StoragePropertySection::NvmeErrorLog) + 1;
+
+
+		/// Lookup index key
+		struct IndexKey {
+			StoragePropertySection section = StoragePropertySection::Unknown;
+			std::string generic_name;
+
+			bool operator==(const IndexKey& other) const = default;
+		};
+
+		/// Hash for IndexKey
+		struct IndexKeyHash {
+			std::size_t operator()(const IndexKey& key) const
+			{
+				return std::hash<std::string>()(key.generic_name) ^ (static_cast<std::size_t>(key.section) << 1);
+			}
+		};
+
+
+		/// The repository data, shared between the copies. Once shared, it's immutable
+		/// (the lookup index and the warning summaries are built before sharing).
+		struct Data {
+			std::vector<StorageProperty> properties;  ///< Parsed data properties, grouped by section
+
+			/// Section i occupies [section_offsets[i], section_offsets[i+1]) in properties
+			std::array<std::size_t, section_count + 1> section_offsets = {};
+
+			/// (section, generic_name) -> index of the first such property in properties.
+			/// Section::Unknown keys refer to the first property with that name in any section.
+			/// Built lazily by lookups, invalidated on modification.
+			mutable std::unordered_map<IndexKey, std::size_t, IndexKeyHash> lookup_index;
+			mutable bool lookup_index_valid = false;  ///< Whether lookup_index is up to date
+
+			/// Warning summary of each section. Built lazily, invalidated on modification.
+			mutable std::array<StoragePropertyWarningSummary, section_count> section_warning_summaries;
+			mutable StoragePropertyWarningSummary warning_summary;  ///< Warning summary of all sections
+			mutable bool warning_summaries_valid = false;  ///< Whether the warning summaries are up to date
+		};
+
+
+		/// Get the data of the empty repositories, shared by all of them
+		[[nodiscard]] static const std::shared_ptr<Data>& get_empty_data();
+
+		/// Get the data for modifying it, copying it first if it's shared.
+		/// The lookup index and the warning summaries are invalidated.
+		[[nodiscard]] Data& get_mutable_data();
+
+		/// Recompute section_offsets from properties
+		void update_section_offsets();
+
+		/// Rebuild the lookup index if needed
+		void build_lookup_index() const;
+
+		/// Rebuild the warning summaries if needed
+		void build_warning_summaries() const;
+
+
+		std::shared_ptr<Data> data_;  ///< Data, never nullptr
 
 };
 
@@ -0,0 +1,722 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm/i18n.h>
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "storage_property_diff.h"  // storage_property_values_equal
+#include "storage_property_snapshot.h"
+
+
+
+namespace {
+
+	/// Snapshot header, followed by the format version
+	constexpr std::string_view snapshot_header = "GSCPROP";
+
+	/// Delta header, followed by the format version
+	constexpr std::string_view delta_header = "GSCPDLT";
+
+
+	/// Delta operations
+	enum class DeltaOp {
+		Copy,  ///< Copy a run of properties from the base repository (start index, count)
+		Insert,  ///< A new or changed property (the property follows)
+	};
+
+
+	// Adding, removing or reordering ValueVariantType alternatives changes the variant indices
+	// stored in snapshots. Update the (de)serialization below and storage_property_snapshot_version
+	// when this fails.
+	static_assert(std::variant_size_v<StorageProperty::ValueVariantType> == 12);
+
+
+	/// Encoder of the snapshot data. Integers are stored as LEB128 varints (signed ones zigzag-encoded),
+	/// strings are length-prefixed.
+	class SnapshotWriter {
+		public:
+
+			/// Append an unsigned integer
+			void put_uint(std::uint64_t value)
+			{
+				while (value >= 0x80) {
+					out_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+					value >>= 7;
+				}
+				out_.push_back(static_cast<char>(value));
+			}
+
+			/// Append a signed integer
+			void put_int(std::int64_t value)
+			{
+				const auto uvalue = static_cast<std::uint64_t>(value);
+				put_uint((uvalue << 1) ^ (value < 0 ? ~std::uint64_t(0) : 0));
+			}
+
+			/// Append a bool
+			void put_bool(bool value)
+			{
+				out_.push_back(value ? '\1' : '\0');
+			}
+
+			/// Append a string
+			void put_string(std::string_view str)
+			{
+				put_uint(str.size());
+				out_.append(str);
+			}
+
+			/// Append raw data (no length prefix)
+			void put_raw(std::string_view str)
+			{
+				out_.append(str);
+			}
+
+			/// Append an optional integer
+			template<typename T>
+			void put_optional_uint(const std::optional<T>& value)
+			{
+				put_bool(value.has_value());
+				if (value.has_value()) {
+					put_uint(value.value());
+				}
+			}
+
+			/// Append an enum value
+			template<typename Enum>
+			void put_enum(Enum value)
+			{
+				put_int(static_cast<std::int64_t>(value));
+			}
+
+			/// Take the encoded data
+			std::string take()
+			{
+				return std::move(out_);
+			}
+
+		private:
+
+			std::string out_;  ///< Encoded data
+	};
+
+
+
+	/// Bounds-checked decoder of the snapshot data. Reading past the end or a malformed value
+	/// puts the reader into failed state, in which all the reads return empty values.
+	class SnapshotReader {
+		public:
+
+			/// Constructor
+			explicit SnapshotReader(std::string_view data) : data_(data)
+			{ }
+
+			/// Read an unsigned integer
+			std::uint64_t get_uint()
+			{
+				std::uint64_t value = 0;
+				for (int shift = 0; shift < 64 && pos_ < data_.size(); shift += 7) {
+					const auto byte = static_cast<unsigned char>(data_[pos_++]);
+					value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+					if ((byte & 0x80) == 0) {
+						return value;
+					}
+				}
+				failed_ = true;
+				return 0;
+			}
+
+			/// Read an unsigned integer of type T, failing if it doesn't fit
+			template<typename T>
+			T get_uint_as()
+			{
+				const std::uint64_t value = get_uint();
+				if (value > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+					failed_ = true;
+					return T();
+				}
+				return static_cast<T>(value);
+			}
+
+			/// Read a signed integer
+			std::int64_t get_int()
+			{
+				const std::uint64_t zigzag = get_uint();
+				return static_cast<std::int64_t>((zigzag >> 1) ^ ((zigzag & 1) != 0 ? ~std::uint64_t(0) : 0));
+			}
+
+			/// Read a bool
+			bool get_bool()
+			{
+				if (failed_ || pos_ >= data_.size()) {
+					failed_ = true;
+					return false;
+				}
+				return data_[pos_++] != '\0';
+			}
+
+			/// Read a string. The returned view points into the snapshot data.
+			std::string_view get_string()
+			{
+				const std::uint64_t size = get_uint();
+				if (failed_ || size > data_.size() - pos_) {
+					failed_ = true;
+					return {};
+				}
+				auto str = data_.substr(pos_, static_cast<std::size_t>(size));
+				pos_ += str.size();
+				return str;
+			}
+
+			/// Read raw data of a known size
+			std::string_view get_raw(std::size_t size)
+			{
+				if (failed_ || size > data_.size() - pos_) {
+					failed_ = true;
+					return {};
+				}
+				auto str = data_.substr(pos_, size);
+				pos_ += size;
+				return str;
+			}
+
+			/// Read an optional integer
+			template<typename T>
+			std::optional<T> get_optional_uint()
+			{
+				if (!get_bool()) {
+					return std::nullopt;
+				}
+				return get_uint_as<T>();
+			}
+
+			/// Read an enum value, failing if it is greater than \c max_value (if given).
+			template<typename Enum>
+			Enum get_enum(std::optional<Enum> max_value = std::nullopt)
+			{
+				const std::int64_t value = get_int();
+				if (max_value.has_value() && (value < 0 || value > static_cast<std::int64_t>(max_value.value()))) {
+					failed_ = true;
+					return Enum();
+				}
+				return static_cast<Enum>(value);
+			}
+
+			/// Read a container size. Each element takes at least one byte, so a size larger than
+			/// the remaining data is invalid. This prevents huge allocations on corrupted data.
+			std::size_t get_size()
+			{
+				const std::uint64_t size = get_uint();
+				if (failed_ || size > data_.size() - pos_) {
+					failed_ = true;
+					return 0;
+				}
+				return static_cast<std::size_t>(size);
+			}
+
+			/// Check if there was a read error
+			[[nodiscard]] bool failed() const
+			{
+				return failed_;
+			}
+
+			/// Check if all the data has been read
+			[[nodiscard]] bool at_end() const
+			{
+				return pos_ == data_.size();
+			}
+
+		private:
+
+			std::string_view data_;  ///< Data
+			std::size_t pos_ = 0;  ///< Current position
+			bool failed_ = false;  ///< Read error flag
+	};
+
+
+
+	/// Append a string vector
+	void snapshot_put_strings(SnapshotWriter& w, const std::vector<std::string>& strings)
+	{
+		w.put_uint(strings.size());
+		for (const auto& str : strings) {
+			w.put_string(str);
+		}
+	}
+
+
+	/// Read a string vector
+	std::vector<std::string> snapshot_get_strings(SnapshotReader& r)
+	{
+		std::vector<std::string> strings(r.get_size());
+		for (auto& str : strings) {
+			str = r.get_string();
+		}
+		return strings;
+	}
+
+
+
+	/// Append a property value. There is one overload per ValueVariantType alternative.
+	void snapshot_put_value([[maybe_unused]] SnapshotWriter& w, [[maybe_unused]] const std::monostate& value)
+	{ }
+
+
+	void snapshot_put_value(SnapshotWriter& w, const std::string& value)
+	{
+		w.put_string(value);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, std::int64_t value)
+	{
+		w.put_int(value);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, bool value)
+	{
+		w.put_bool(value);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, std::chrono::seconds value)
+	{
+		w.put_int(value.count());
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, const AtaStorageTextCapability& value)
+	{
+		w.put_string(value.reported_flag_value);
+		w.put_uint(value.flag_value);
+		w.put_string(value.reported_strvalue);
+		snapshot_put_strings(w, value.strvalues);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, const AtaStorageAttribute& value)
+	{
+		w.put_int(value.id);
+		w.put_string(value.flag);
+		w.put_optional_uint(value.value);
+		w.put_optional_uint(value.worst);
+		w.put_optional_uint(value.threshold);
+		w.put_enum(value.attr_type);
+		w.put_enum(value.update_type);
+		w.put_enum(value.when_failed);
+		w.put_string(value.raw_value);
+		w.put_int(value.raw_value_int);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, const AtaStorageStatistic& value)
+	{
+		w.put_bool(value.is_header);
+		w.put_string(value.flags);
+		w.put_string(value.value);
+		w.put_int(value.value_int);
+		w.put_int(value.page);
+		w.put_int(value.offset);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, const AtaStorageErrorBlock& value)
+	{
+		w.put_uint(value.error_num);
+		w.put_uint(value.log_index);
+		w.put_uint(value.lifetime_hours);
+		w.put_string(value.device_state);
+		snapshot_put_strings(w, value.reported_types);
+		w.put_string(value.type_more_info);
+		w.put_uint(value.lba);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, const AtaStorageSelftestEntry& value)
+	{
+		w.put_uint(value.test_num);
+		w.put_string(value.type);
+		w.put_string(value.status_str);
+		w.put_enum(value.status);
+		w.put_int(value.remaining_percent);
+		w.put_uint(value.lifetime_hours);
+		w.put_string(value.lba_of_first_error);
+		w.put_bool(value.passed);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, const NvmeStorageSelftestEntry& value)
+	{
+		w.put_uint(value.test_num);
+		w.put_enum(value.type);
+		w.put_enum(value.result);
+		w.put_uint(value.power_on_hours);
+		w.put_optional_uint(value.lba);
+	}
+
+
+	void snapshot_put_value(SnapshotWriter& w, const AtaStorageTemperatureHistory& value)
+	{
+		w.put_int(value.logging_interval_minutes);
+		w.put_uint(value.write_index);
+		w.put_int(value.newest_time);
+		// One byte per sample
+		w.put_string(std::string_view(reinterpret_cast<const char*>(value.samples.data()), value.samples.size()));
+	}
+
+
+
+	/// Read a value of the variant alternative \c index
+	StorageProperty::ValueVariantType snapshot_get_value(SnapshotReader& r, std::size_t index)
+	{
+		switch (index) {
+			case 0:
+				return std::monostate();
+			case 1:
+				return std::string(r.get_string());
+			case 2:
+				return r.get_int();
+			case 3:
+				return r.get_bool();
+			case 4:
+				return std::chrono::seconds(r.get_int());
+			case 5:
+			{
+				AtaStorageTextCapability value;
+				value.reported_flag_value = r.get_string();
+				value.flag_value = r.get_uint_as<std::uint16_t>();
+				value.reported_strvalue = r.get_string();
+				value.strvalues = snapshot_get_strings(r);
+				return value;
+			}
+			case 6:
+			{
+				AtaStorageAttribute value;
+				value.id = static_cast<std::int32_t>(r.get_int());
+				value.flag = r.get_string();
+				value.value = r.get_optional_uint<std::uint8_t>();
+				value.worst = r.get_optional_uint<std::uint8_t>();
+				value.threshold = r.get_optional_uint<std::uint8_t>();
+				value.attr_type = r.get_enum<AtaStorageAttribute::AttributeType>();
+				value.update_type = r.get_enum<AtaStorageAttribute::UpdateType>();
+				value.when_failed = r.get_enum<AtaStorageAttribute::FailTime>();
+				value.raw_value = r.get_string();
+				value.raw_value_int = r.get_int();
+				return value;
+			}
+			case 7:
+			{
+				AtaStorageStatistic value;
+				value.is_header = r.get_bool();
+				value.flags = r.get_string();
+				value.value = r.get_string();
+				value.value_int = r.get_int();
+				value.page = r.get_int();
+				value.offset = r.get_int();
+				return value;
+			}
+			case 8:
+			{
+				AtaStorageErrorBlock value;
+				value.error_num = r.get_uint_as<std::uint32_t>();
+				value.log_index = r.get_uint();
+				value.lifetime_hours = r.get_uint_as<std::uint32_t>();
+				value.device_state = r.get_string();
+				value.reported_types = snapshot_get_strings(r);
+				value.type_more_info = r.get_string();
+				value.lba = r.get_uint();
+				return value;
+			}
+			case 9:
+			{
+				AtaStorageSelftestEntry value;
+				value.test_num = r.get_uint_as<std::uint32_t>();
+				value.type = r.get_string();
+				value.status_str = r.get_string();
+				value.status = r.get_enum<AtaStorageSelftestEntry::Status>();
+				value.remaining_percent = static_cast<std::int8_t>(r.get_int());
+				value.lifetime_hours = r.get_uint_as<std::uint32_t>();
+				value.lba_of_first_error = r.get_string();
+				value.passed = r.get_bool();
+				return value;
+			}
+			case 10:
+			{
+				NvmeStorageSelftestEntry value;
+				value.test_num = r.get_uint_as<std::uint32_t>();
+				value.type = r.get_enum<NvmeSelfTestType>();
+				value.result = r.get_enum<NvmeSelfTestResultType>();
+				value.power_on_hours = r.get_uint_as<std::uint32_t>();
+				value.lba = r.get_optional_uint<std::uint64_t>();
+				return value;
+			}
+			case 11:
+			{
+				AtaStorageTemperatureHistory value;
+				value.logging_interval_minutes = r.get_int();
+				value.write_index = r.get_uint_as<std::uint32_t>();
+				value.newest_time = r.get_int();
+				const std::string_view samples = r.get_string();
+				value.samples.assign(samples.begin(), samples.end());
+				return value;
+			}
+			default:
+				break;
+		}
+		return std::monostate();
+	}
+
+
+
+	/// Append a property
+	void snapshot_put_property(SnapshotWriter& w, const StorageProperty& p)
+	{
+		w.put_string(p.generic_name);
+		w.put_string(p.displayable_name);
+		w.put_string(p.reported_name);
+		w.put_enum(p.section);
+		w.put_string(p.reported_value);
+		w.put_string(p.readable_value);
+		w.put_string(p.get_description_body());
+		w.put_enum(p.get_description_title());
+		w.put_enum(p.warning_level);
+		w.put_string(p.warning_reason);
+		w.put_bool(p.show_in_ui);
+
+		w.put_uint(p.value.index());
+		std::visit([&w](const auto& value) { snapshot_put_value(w, value); }, p.value);
+	}
+
+
+
+	/// Read a property. \return false if the value type is invalid.
+	bool snapshot_get_property(SnapshotReader& r, StorageProperty& p)
+	{
+		p.generic_name = r.get_string();
+		p.displayable_name = r.get_string();
+		p.reported_name = r.get_string();
+		p.section = r.get_enum<StoragePropertySection>(StoragePropertySection::NvmeErrorLog);
+		p.reported_value = r.get_string();
+		p.readable_value = r.get_string();
+		{
+			const std::string description(r.get_string());
+			// interned, shared with the other drives
+			p.set_description(description, r.get_enum<StorageProperty::DescriptionTitle>(StorageProperty::DescriptionTitle::NameAndReportedName));
+		}
+		p.warning_level = r.get_enum<WarningLevel>(WarningLevel::Alert);
+		p.warning_reason = r.get_string();
+		p.show_in_ui = r.get_bool();
+
+		const auto index = r.get_uint_as<std::size_t>();
+		if (index >= std::variant_size_v<StorageProperty::ValueVariantType>) {
+			return false;
+		}
+		p.value = snapshot_get_value(r, index);
+		return true;
+	}
+
+
+
+	/// Check if the properties are the same in everything that's serialized
+	bool snapshot_properties_equal(const StorageProperty& a, const StorageProperty& b)
+	{
+		return a.section == b.section
+				&& a.generic_name == b.generic_name
+				&& a.reported_name == b.reported_name
+				&& storage_property_values_equal(a, b)
+				&& a.get_description_body() == b.get_description_body()
+				&& a.get_description_title() == b.get_description_title();
+	}
+
+}
+
+
+
+std::string storage_property_snapshot_save(const StoragePropertyRepository& repository)
+{
+	const auto& properties = repository.get_properties();
+
+	SnapshotWriter w;
+	w.put_raw(snapshot_header);
+	w.put_uint(storage_property_snapshot_version);
+	w.put_uint(properties.size());
+
+	for (const auto& p : properties) {
+		snapshot_put_property(w, p);
+	}
+
+	return w.take();
+}
+
+
+
+hz::ExpectedValue<StoragePropertyRepository, StoragePropertySnapshotError>
+		storage_property_snapshot_load(std::string_view data)
+{
+	SnapshotReader r(data);
+	if (r.get_raw(snapshot_header.size()) != snapshot_header) {
+		return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Invalid property snapshot header."));
+	}
+	if (r.get_uint() != storage_property_snapshot_version || r.failed()) {
+		return hz::Unexpected(StoragePropertySnapshotError::UnsupportedVersion, _("Unsupported property snapshot version."));
+	}
+
+	std::vector<StorageProperty> properties(r.get_size());
+	for (auto& p : properties) {
+		if (!snapshot_get_property(r, p)) {
+			return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Invalid property snapshot value type."));
+		}
+		if (r.failed()) {
+			break;
+		}
+	}
+
+	if (r.failed() || !r.at_end()) {
+		return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Truncated or corrupted property snapshot."));
+	}
+
+	StoragePropertyRepository repository;
+	repository.set_properties(std::move(properties));
+	return repository;
+}
+
+
+
+std::string storage_property_delta_save(const StoragePropertyRepository& base, const StoragePropertyRepository& repository)
+{
+	const auto& base_props = base.get_properties();
+	const auto& props = repository.get_properties();
+
+	// generic_name -> indices in base_props
+	std::unordered_map<std::string_view, std::vector<std::size_t>> base_indices;
+	base_indices.reserve(base_props.size());
+	for (std::size_t i = 0; i < base_props.size(); ++i) {
+		base_indices[base_props[i].generic_name].push_back(i);
+	}
+	std::vector<bool> base_used(base_props.size(), false);
+
+	SnapshotWriter w;
+	w.put_raw(delta_header);
+	w.put_uint(storage_property_snapshot_version);
+	w.put_uint(base_props.size());
+	w.put_uint(props.size());
+
+	std::size_t run_start = 0, run_size = 0;  // pending run of copied base properties
+	auto flush_run = [&]() {
+		if (run_size > 0) {
+			w.put_enum(DeltaOp::Copy);
+			w.put_uint(run_start);
+			w.put_uint(run_size);
+			run_size = 0;
+		}
+	};
+
+	for (const auto& p : props) {
+		// Usually the property follows the previous one in base too
+		std::optional<std::size_t> base_index;
+		if (const std::size_t next = run_start + run_size; run_size > 0 && next < base_props.size()
+				&& !base_used[next] && snapshot_properties_equal(base_props[next], p)) {
+			base_index = next;
+		} else if (auto iter = base_indices.find(p.generic_name); iter != base_indices.end()) {
+			for (const std::size_t i : iter->second) {
+				if (!base_used[i] && snapshot_properties_equal(base_props[i], p)) {
+					base_index = i;
+					break;
+				}
+			}
+		}
+
+		if (!base_index.has_value()) {
+			flush_run();
+			w.put_enum(DeltaOp::Insert);
+			snapshot_put_property(w, p);
+			continue;
+		}
+
+		base_used[base_index.value()] = true;
+		if (run_size == 0 || base_index.value() != run_start + run_size) {
+			flush_run();
+			run_start = base_index.value();
+		}
+		++run_size;
+	}
+	flush_run();
+
+	return w.take();
+}
+
+
+
+hz::ExpectedValue<StoragePropertyRepository, StoragePropertySnapshotError>
+		storage_property_delta_apply(const StoragePropertyRepository& base, std::string_view delta)
+{
+	const auto& base_props = base.get_properties();
+
+	SnapshotReader r(delta);
+	if (r.get_raw(delta_header.size()) != delta_header) {
+		return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Invalid property delta header."));
+	}
+	if (r.get_uint() != storage_property_snapshot_version || r.failed()) {
+		return hz::Unexpected(StoragePropertySnapshotError::UnsupportedVersion, _("Unsupported property delta version."));
+	}
+	if (r.get_uint() != base_props.size() || r.failed()) {
+		return hz::Unexpected(StoragePropertySnapshotError::BaseMismatch, _("Property delta was made for a different base repository."));
+	}
+
+	// Each property takes at least one byte (an operation or a part of a run), except the copied ones.
+	const std::uint64_t size = r.get_uint();
+	if (r.failed() || size > base_props.size() + delta.size()) {
+		return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Truncated or corrupted property delta."));
+	}
+
+	std::vector<StorageProperty> properties;
+	properties.reserve(static_cast<std::size_t>(size));
+	while (!r.failed() && !r.at_end() && properties.size() < size) {
+		const auto op = r.get_enum<DeltaOp>(DeltaOp::Insert);
+		if (op == DeltaOp::Copy) {
+			const std::uint64_t start = r.get_uint();
+			const std::uint64_t count = r.get_uint();
+			if (r.failed() || count == 0 || start > base_props.size() || count > base_props.size() - start
+					|| count > size - properties.size()) {
+				return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Truncated or corrupted property delta."));
+			}
+			properties.insert(properties.end(), base_props.begin() + static_cast<std::ptrdiff_t>(start),
+					base_props.begin() + static_cast<std::ptrdiff_t>(start + count));
+		} else {
+			StorageProperty p;
+			if (!snapshot_get_property(r, p)) {
+				return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Invalid property delta value type."));
+			}
+			properties.push_back(std::move(p));
+		}
+	}
+
+	if (r.failed() || !r.at_end() || properties.size() != size) {
+		return hz::Unexpected(StoragePropertySnapshotError::InvalidFormat, _("Truncated or corrupted property delta."));
+	}
+
+	StoragePropertyRepository repository;
+	repository.set_properties(std::move(properties));
+	return repository;
+}
+
+
+
+
+/// @}
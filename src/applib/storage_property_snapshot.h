@@ -0,0 +1,69 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_PROPERTY_SNAPSHOT_H
+#define STORAGE_PROPERTY_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "hz/error_container.h"
+
+#include "storage_property_repository.h"
+
+
+
+/// Snapshot loading errors
+enum class StoragePropertySnapshotError {
+	InvalidFormat,  ///< Not a snapshot, or truncated / corrupted data
+	UnsupportedVersion,  ///< Snapshot written by a different format version
+	BaseMismatch,  ///< Delta made for a different base repository
+};
+
+
+
+/// Version of the snapshot format. It must be increased whenever any of the serialized
+/// types (StorageProperty, its ValueVariantType alternatives) changes.
+/// Snapshots with a different version are rejected, and the callers re-parse the original output instead.
+constexpr std::uint32_t storage_property_snapshot_version = 3;
+
+
+
+/// Serialize a processed property repository (values, descriptions and warnings) to a
+/// compact binary string. This allows reloading a drive without parsing and processing
+/// the smartctl output again.
+[[nodiscard]] std::string storage_property_snapshot_save(const StoragePropertyRepository& repository);
+
+
+/// Load a property repository serialized by storage_property_snapshot_save()
+[[nodiscard]] hz::ExpectedValue<StoragePropertyRepository, StoragePropertySnapshotError>
+		storage_property_snapshot_load(std::string_view data);
+
+
+/// Serialize the differences between two processed property repositories. The unchanged
+/// properties are referenced by their positions in \c base (in runs), the changed and new
+/// ones are stored as in a snapshot. A delta between equal repositories takes a few bytes.
+[[nodiscard]] std::string storage_property_delta_save(const StoragePropertyRepository& base,
+		const StoragePropertyRepository& repository);
+
+
+/// Reconstruct a repository from \c base and a delta made by storage_property_delta_save().
+/// BaseMismatch is returned if the delta is obviously not made for \c base.
+[[nodiscard]] hz::ExpectedValue<StoragePropertyRepository, StoragePropertySnapshotError>
+		storage_property_delta_apply(const StoragePropertyRepository& base, std::string_view delta);
+
+
+
+
+#endif
+
+/// @}
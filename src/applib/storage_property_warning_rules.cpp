@@ -0,0 +1,461 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include "storage_property_warning_rules.h"
+
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "nlohmann/json.hpp"
+#include "hz/debug.h"
+#include "hz/string_algo.h"  // string_iequals
+#include "hz/string_num.h"  // string_is_numeric_nolocale
+
+
+
+namespace {
+
+
+	/// Maximum size of a rules file
+	constexpr std::uintmax_t rules_file_max_size = 1024UL * 1024UL;
+
+
+	// Reasons shared by several rules
+	constexpr const char* reason_nonzero_raw_bad_sectors = "The drive has a non-zero Raw value, but there is no SMART warning yet. "
+			"This could be an indication of future failures and/or potential data loss in bad sectors.";
+	constexpr const char* reason_surface_errors = "The drive is reporting surface errors. "
+			"This could be an indication of future failures and/or potential data loss in bad sectors.";
+	constexpr const char* reason_temperature = "The temperature of the drive is higher than 50 degrees Celsius. "
+			"This may shorten its lifespan and cause damage under severe load. Please install a cooling solution.";
+	constexpr const char* reason_overheated = "The drive detected is or was overheating. "
+			"This may have shortened its lifespan and caused damage. Please install a cooling solution.";
+	constexpr const char* reason_half_life = "The drive has less than half of its estimated life left.";
+	constexpr const char* reason_past_life = "The drive is past its estimated lifespan.";
+
+
+	/// Build the built-in rules
+	StorageWarningRules build_builtin_rules()
+	{
+		using S = StoragePropertySection;
+		using V = StorageWarningRuleValue;
+		using W = WarningLevel;
+
+		static const std::vector<StorageWarningRule> rules = {
+			// Info
+			{S::Info, "smart_support/available", V::Value, std::nullopt, 0, W::Notice,
+					"SMART is not supported. You won't be able to read any SMART information from this drive."},
+			{S::Info, "smart_support/enabled", V::Value, std::nullopt, 0, W::Notice,
+					"SMART is disabled. You should enable it to read any SMART information from this drive. "
+					"Additionally, some drives do not log useful data with SMART disabled, so it's advisable to keep it always enabled."},
+			{S::Info, "_text_only/info_warning", V::Present, std::nullopt, std::nullopt, W::Notice,
+					"Your drive may be affected by the warning, please see the details."},
+
+			// Overall health
+			{S::OverallHealth, "smart_status/passed", V::Value, std::nullopt, 0, W::Alert,
+					"The drive is reporting that it will FAIL very soon. Please back up as soon as possible!"},
+
+			// ATA attributes. These are notices only, since the warnings and alerts are
+			// shown only in case of attribute failure (see storage_property_ata_attribute_autoset_warning()).
+			{S::AtaAttributes, "attr_reallocated_sector_count", V::Raw, 1, std::nullopt, W::Notice, reason_nonzero_raw_bad_sectors},
+			{S::AtaAttributes, "attr_spin_up_retry_count", V::Raw, 1, std::nullopt, W::Notice,
+					"The drive has a non-zero Raw value, but there is no SMART warning yet. "
+					"Your drive may have problems spinning up, which could lead to a complete mechanical failure. Please back up."},
+			{S::AtaAttributes, "attr_soft_read_error_rate", V::Raw, 1, std::nullopt, W::Notice, reason_nonzero_raw_bad_sectors},
+			// Raw value may be 27, or 253403791387 (which encodes min/max values as well), so use the string.
+			// For some it may be 10xTemp, so limit the upper bound.
+			{S::AtaAttributes, "attr_temperature_celsius", V::RawString, 51, 120, W::Notice, reason_temperature},
+			{S::AtaAttributes, "attr_temperature_celsius_x10", V::Raw, 501, std::nullopt, W::Notice, reason_temperature},
+			{S::AtaAttributes, "attr_reallocation_event_count", V::Raw, 1, std::nullopt, W::Notice, reason_nonzero_raw_bad_sectors},
+			{S::AtaAttributes, "attr_current_pending_sector_count", V::Raw, 1, std::nullopt, W::Notice, reason_nonzero_raw_bad_sectors},
+			{S::AtaAttributes, "attr_total_pending_sectors", V::Raw, 1, std::nullopt, W::Notice, reason_nonzero_raw_bad_sectors},
+			{S::AtaAttributes, "attr_offline_uncorrectable", V::Raw, 1, std::nullopt, W::Notice, reason_nonzero_raw_bad_sectors},
+			{S::AtaAttributes, "attr_total_attr_offline_uncorrectable", V::Raw, 1, std::nullopt, W::Notice, reason_nonzero_raw_bad_sectors},
+			{S::AtaAttributes, "attr_ssd_life_left", V::Normalized, std::nullopt, 49, W::Notice, reason_half_life},
+			{S::AtaAttributes, "attr_ssd_life_used", V::Raw, 50, std::nullopt, W::Notice, reason_half_life},
+
+			// ATA statistics.
+			// "Workload Utilization" is either normalized, or encodes several values, so we can't use it.
+			{S::Statistics, "Pending Error Count", V::Value, 1, std::nullopt, W::Notice, reason_surface_errors},
+			{S::Statistics, "Utilization Usage Rate", V::Value, 50, std::nullopt, W::Notice, reason_half_life},
+			{S::Statistics, "Utilization Usage Rate", V::Value, 100, std::nullopt, W::Warning, reason_past_life},
+			{S::Statistics, "Number of Reallocated Logical Sectors", V::Raw, 1, std::nullopt, W::Notice, reason_surface_errors},
+			{S::Statistics, "Number of Reallocated Logical Sectors", V::Normalized, std::nullopt, 0, W::Warning, reason_surface_errors},
+			{S::Statistics, "Number of Mechanical Start Failures", V::Value, 1, std::nullopt, W::Notice,
+					"The drive is reporting mechanical errors."},
+			{S::Statistics, "Number of Realloc. Candidate Logical Sectors", V::Value, 1, std::nullopt, W::Notice, reason_surface_errors},
+			{S::Statistics, "Number of Reported Uncorrectable Errors", V::Value, 1, std::nullopt, W::Notice, reason_surface_errors},
+			{S::Statistics, "Current Temperature", V::Value, 51, std::nullopt, W::Notice, reason_temperature},
+			{S::Statistics, "Time in Over-Temperature", V::Value, 1, std::nullopt, W::Notice,
+					"The temperature of the drive is or was over the manufacturer-specified maximum. "
+					"This may have shortened its lifespan and caused damage. Please install a cooling solution."},
+			{S::Statistics, "Time in Under-Temperature", V::Value, 1, std::nullopt, W::Notice,
+					"The temperature of the drive is or was under the manufacturer-specified minimum. "
+					"This may have shortened its lifespan and caused damage. Please operate the drive within manufacturer-specified temperature range."},
+			{S::Statistics, "Percentage Used Endurance Indicator", V::Value, 50, std::nullopt, W::Notice, reason_half_life},
+			{S::Statistics, "Percentage Used Endurance Indicator", V::Value, 100, std::nullopt, W::Warning, reason_past_life},
+
+			// ATA error log. The individual error entries are rated in storage_property_autoset_warning().
+			{S::AtaErrorLog, "ata_smart_error_log/extended/count", V::Value, 1, std::nullopt, W::Notice,
+					"The drive is reporting internal errors. Usually this means uncorrectable data loss and similar severe errors. "
+					"Check the actual errors for details."},
+			{S::AtaErrorLog, "_text_only/ata_smart_error_log/_not_present", V::Present, std::nullopt, std::nullopt, W::Notice,
+					"The drive does not support error logging. This means that SMART error history is unavailable."},
+
+			// Self-test log.
+			// Don't include selftest warnings - they may be old or something.
+			// Self-tests are carried manually anyway, so the user is expected to check their status anyway.
+			{S::SelftestLog, "ata_smart_self_test_log/_present", V::Present, std::nullopt, std::nullopt, W::Notice,
+					"The drive does not support self-test logging. This means that SMART test results won't be logged."},
+
+			// Temperature log. Don't highlight SCT Unsupported as warning, it's harmless.
+			{S::TemperatureLog, "ata_sct_status/temperature/current", V::Value, 51, std::nullopt, W::Notice, reason_temperature},
+
+			// NVMe attributes
+			{S::NvmeAttributes, "nvme_smart_health_information_log/temperature", V::Value, 51, std::nullopt, W::Notice, reason_temperature},
+			{S::NvmeAttributes, "nvme_smart_health_information_log/available_spare", V::Value, std::nullopt, 10, W::Warning,  // 10% (arbitrary value)
+					"The drive has less than 10% available spare lifetime left."},
+			{S::NvmeAttributes, "nvme_smart_health_information_log/percentage_used", V::Value, 90, std::nullopt, W::Warning,  // 90% (arbitrary value)
+					"The estimate drive lifetime is nearing its limit."},
+			{S::NvmeAttributes, "nvme_smart_health_information_log/media_errors", V::Value, 1, std::nullopt, W::Notice,
+					"There are media errors present on this drive."},
+			{S::NvmeAttributes, "nvme_smart_health_information_log/warning_temp_time", V::Value, 1, std::nullopt, W::Notice, reason_overheated},
+			{S::NvmeAttributes, "nvme_smart_health_information_log/critical_comp_time", V::Value, 1, std::nullopt, W::Notice, reason_overheated},
+		};
+
+		StorageWarningRules builtin;
+		for (const auto& rule : rules) {
+			builtin.add_rule(rule);
+		}
+		return builtin;
+	}
+
+
+
+	/// Get the value of a property checked by a rule. std::nullopt if the property doesn't have it.
+	/// The value type is dispatched once, the handler for each type is selected at compile time.
+	std::optional<std::int64_t> get_rule_value(const StorageProperty& p, StorageWarningRuleValue value)
+	{
+		return std::visit([value](const auto& v) -> std::optional<std::int64_t> {
+			using T = std::decay_t<decltype(v)>;
+
+			if constexpr(std::is_same_v<T, AtaStorageAttribute>) {
+				switch (value) {
+					case StorageWarningRuleValue::Present:
+						return 0;
+					case StorageWarningRuleValue::Value:
+					case StorageWarningRuleValue::Raw:
+						return v.raw_value_int;
+					case StorageWarningRuleValue::Normalized:
+						if (v.value.has_value()) {
+							return v.value.value();
+						}
+						return std::nullopt;
+					case StorageWarningRuleValue::RawString:
+					{
+						std::int64_t raw_int = 0;
+						if (hz::string_is_numeric_nolocale(v.raw_value, raw_int, false)) {
+							return raw_int;
+						}
+						return std::nullopt;
+					}
+				}
+				return std::nullopt;
+
+			} else if constexpr(std::is_same_v<T, AtaStorageStatistic>) {
+				switch (value) {
+					case StorageWarningRuleValue::Present:
+					case StorageWarningRuleValue::Value:
+						return v.value_int;
+					case StorageWarningRuleValue::Normalized:
+						if (v.is_normalized()) {
+							return v.value_int;
+						}
+						return std::nullopt;
+					case StorageWarningRuleValue::Raw:
+						if (!v.is_normalized()) {
+							return v.value_int;
+						}
+						return std::nullopt;
+					case StorageWarningRuleValue::RawString:
+						return std::nullopt;
+				}
+				return std::nullopt;
+
+			} else if constexpr(std::is_same_v<T, bool>) {
+				if (value == StorageWarningRuleValue::Present) {
+					return 0;
+				}
+				if (value == StorageWarningRuleValue::Value) {
+					return v ? 1 : 0;
+				}
+				return std::nullopt;
+
+			} else if constexpr(std::is_same_v<T, std::int64_t>) {
+				if (value == StorageWarningRuleValue::Present) {
+					return 0;
+				}
+				if (value == StorageWarningRuleValue::Value) {
+					return v;
+				}
+				return std::nullopt;
+
+			} else {
+				if (value == StorageWarningRuleValue::Present) {
+					return 0;
+				}
+				return std::nullopt;
+			}
+		}, p.value);
+	}
+
+
+
+	/// Check whether a rule triggers for a property
+	bool get_rule_triggered(const StorageWarningRule& rule, const StorageProperty& p)
+	{
+		if (rule.value == StorageWarningRuleValue::Present) {
+			return true;
+		}
+		auto value = get_rule_value(p, rule.value);
+		return value.has_value()
+				&& (!rule.min.has_value() || value.value() >= rule.min.value())
+				&& (!rule.max.has_value() || value.value() <= rule.max.value());
+	}
+
+
+
+	/// Parse warning level name
+	std::optional<WarningLevel> parse_warning_level(const std::string& name)
+	{
+		if (name == "notice") {
+			return WarningLevel::Notice;
+		}
+		if (name == "warning") {
+			return WarningLevel::Warning;
+		}
+		if (name == "alert") {
+			return WarningLevel::Alert;
+		}
+		return std::nullopt;
+	}
+
+
+
+	/// Global rules
+	struct RulesGlobal {
+		std::mutex mutex;  ///< Protects rules
+		std::shared_ptr<const StorageWarningRules> rules;  ///< Rules, nullptr if built-in
+	};
+
+
+	/// Get the global rules
+	RulesGlobal& rules_get_global_ref()
+	{
+		static RulesGlobal global;
+		return global;
+	}
+
+}
+
+
+
+const StorageWarningRules& StorageWarningRules::get_builtin()
+{
+	static const StorageWarningRules builtin = build_builtin_rules();
+	return builtin;
+}
+
+
+
+void StorageWarningRules::add_rule(StorageWarningRule rule)
+{
+	auto& name_rules = rules_[rule.section];
+	auto iter = name_rules.find(std::string_view(rule.name));
+	if (iter == name_rules.end()) {
+		iter = name_rules.emplace(rule.name, std::vector<StorageWarningRule>()).first;
+	}
+	iter->second.push_back(std::move(rule));
+	++size_;
+}
+
+
+
+hz::ExpectedVoid<StorageWarningRulesError> StorageWarningRules::add_rules_from_json(std::string_view json_data)
+{
+	const nlohmann::json doc = nlohmann::json::parse(json_data, nullptr, false);
+	if (doc.is_discarded() || !doc.is_array()) {
+		return hz::Unexpected(StorageWarningRulesError::SyntaxError, "Warning rules must be a JSON array of objects.");
+	}
+
+	std::vector<StorageWarningRule> rules;
+	for (const auto& j : doc) {
+		try {
+			StorageWarningRule rule;
+
+			const auto section_name = j.at("section").get<std::string>();
+			rule.section = StoragePropertySectionExt::get_by_storable_name(section_name);
+			if (rule.section == StoragePropertySection::Unknown) {
+				return hz::Unexpected(StorageWarningRulesError::InvalidRule, "Unknown section \"" + section_name + "\" in warning rule.");
+			}
+
+			rule.name = j.at("name").get<std::string>();
+
+			const auto value_name = j.value("value", std::string("value"));
+			rule.value = StorageWarningRuleValueExt::get_by_storable_name(value_name, StorageWarningRuleValue::Present);
+			if (rule.value == StorageWarningRuleValue::Present && value_name != "present") {
+				return hz::Unexpected(StorageWarningRulesError::InvalidRule, "Unknown value \"" + value_name + "\" in warning rule.");
+			}
+
+			if (j.contains("min")) {
+				rule.min = j["min"].get<std::int64_t>();
+			}
+			if (j.contains("max")) {
+				rule.max = j["max"].get<std::int64_t>();
+			}
+
+			const auto level_name = j.value("level", std::string("notice"));
+			auto level = parse_warning_level(level_name);
+			if (!level.has_value()) {
+				return hz::Unexpected(StorageWarningRulesError::InvalidRule, "Unknown level \"" + level_name + "\" in warning rule.");
+			}
+			rule.level = level.value();
+
+			rule.reason = j.value("reason", std::string());
+			rules.push_back(std::move(rule));
+		}
+		catch (const nlohmann::json::exception& e) {
+			return hz::Unexpected(StorageWarningRulesError::InvalidRule, std::string("Invalid warning rule: ") + e.what());
+		}
+	}
+
+	for (auto& rule : rules) {
+		add_rule(std::move(rule));
+	}
+	return {};
+}
+
+
+
+hz::ExpectedVoid<StorageWarningRulesError> StorageWarningRules::add_rules_from_file(const hz::fs::path& file)
+{
+	std::string contents;
+	if (auto ec = hz::fs_file_get_contents(file, contents, rules_file_max_size)) {
+		return hz::Unexpected(StorageWarningRulesError::ReadError,
+				"Cannot read warning rules file \"" + hz::fs_path_to_string(file) + "\": " + ec.message());
+	}
+	return add_rules_from_json(contents);
+}
+
+
+
+bool StorageWarningRules::apply(StorageProperty& p) const
+{
+	// No allocations here, this is called for each property
+	auto section_iter = rules_.find(p.section);
+	if (section_iter == rules_.end()) {
+		return false;
+	}
+	const std::string_view name = (p.generic_name.empty() ? p.reported_name : p.generic_name);
+	auto iter = section_iter->second.find(name);
+	if (iter == section_iter->second.end()) {
+		return false;
+	}
+
+	const StorageWarningRule* triggered = nullptr;
+	for (const auto& rule : iter->second) {
+		if ((triggered == nullptr || rule.level > triggered->level) && get_rule_triggered(rule, p)) {
+			triggered = &rule;
+		}
+	}
+	if (triggered == nullptr) {
+		return false;
+	}
+	p.warning_level = triggered->level;
+	p.warning_reason = triggered->reason;
+	return true;
+}
+
+
+
+std::size_t StorageWarningRules::size() const
+{
+	return size_;
+}
+
+
+
+std::size_t StorageWarningRules::NameHash::operator()(std::string_view name) const
+{
+	// FNV-1a of the lowercase name
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (const char c : name) {
+		hash ^= static_cast<unsigned char>((c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c);
+		hash *= 1099511628211ULL;
+	}
+	return static_cast<std::size_t>(hash);
+}
+
+
+
+bool StorageWarningRules::NameEqual::operator()(std::string_view a, std::string_view b) const
+{
+	return hz::string_iequals(a, b);
+}
+
+
+
+void storage_warning_rules_set_global(std::shared_ptr<const StorageWarningRules> rules)
+{
+	auto& global = rules_get_global_ref();
+	const std::scoped_lock lock(global.mutex);
+	global.rules = std::move(rules);
+}
+
+
+
+std::shared_ptr<const StorageWarningRules> storage_warning_rules_get_global()
+{
+	auto& global = rules_get_global_ref();
+	{
+		const std::scoped_lock lock(global.mutex);
+		if (global.rules) {
+			return global.rules;
+		}
+	}
+	// Non-owning pointer to the built-in rules, which are never destroyed before the users.
+	return {std::shared_ptr<const StorageWarningRules>{}, &StorageWarningRules::get_builtin()};
+}
+
+
+
+void storage_warning_rules_init_global(const hz::fs::path& file)
+{
+	if (file.empty()) {
+		storage_warning_rules_set_global(nullptr);
+		return;
+	}
+	auto rules = std::make_shared<StorageWarningRules>(StorageWarningRules::get_builtin());
+	if (auto status = rules->add_rules_from_file(file); !status) {
+		debug_out_warn("app", DBG_FUNC_MSG << status.error().message() << " Using the built-in warning rules only.\n");
+		storage_warning_rules_set_global(nullptr);
+		return;
+	}
+	debug_out_info("app", DBG_FUNC_MSG << "Loaded warning rules from \"" << hz::fs_path_to_string(file) << "\".\n");
+	storage_warning_rules_set_global(rules);
+}
+
+
+
+
+/// @}
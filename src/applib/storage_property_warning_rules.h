@@ -0,0 +1,169 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_PROPERTY_WARNING_RULES_H
+#define STORAGE_PROPERTY_WARNING_RULES_H
+
+#include <array>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hz/enum_helper.h"
+#include "hz/error_container.h"
+#include "hz/fs.h"
+
+#include "storage_property.h"
+#include "warning_level.h"
+
+
+
+/// Errors of loading warning rules
+enum class StorageWarningRulesError {
+	ReadError,  ///< Cannot read the file
+	SyntaxError,  ///< Invalid JSON
+	InvalidRule,  ///< Invalid or unknown rule member
+};
+
+
+
+/// The value of a property which a warning rule checks
+enum class StorageWarningRuleValue {
+	Present,  ///< Nothing is checked, the property just has to exist
+	Value,  ///< Boolean (0 / 1) or integer value, ATA attribute raw value or ATA statistic value
+	Normalized,  ///< Normalized value of ATA attribute, or value of normalized ATA statistic
+	Raw,  ///< Raw value of ATA attribute, or value of non-normalized ATA statistic
+	RawString,  ///< Raw value string of ATA attribute, if it's a plain number (e.g. temperature with min / max not encoded)
+};
+
+
+
+/// Helper structure for enum-related functions
+struct StorageWarningRuleValueExt
+		: public hz::EnumTableHelper<
+				StorageWarningRuleValue,
+				StorageWarningRuleValueExt>
+{
+	static constexpr StorageWarningRuleValue default_value = StorageWarningRuleValue::Value;
+
+	static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+		{StorageWarningRuleValue::Present, "present", "Present"},
+		{StorageWarningRuleValue::Value, "value", "Value"},
+		{StorageWarningRuleValue::Normalized, "normalized", "Normalized Value"},
+		{StorageWarningRuleValue::Raw, "raw", "Raw Value"},
+		{StorageWarningRuleValue::RawString, "raw_string", "Raw Value String"},
+	});
+
+};
+
+
+
+/// A warning rule. It triggers if the property's value is in [min, max] range.
+struct StorageWarningRule {
+	StoragePropertySection section = StoragePropertySection::Unknown;  ///< Section of the property
+	std::string name;  ///< Generic name of the property (reported name if it has no generic name), case-insensitive
+	StorageWarningRuleValue value = StorageWarningRuleValue::Value;  ///< Which value to check
+	std::optional<std::int64_t> min;  ///< Minimum value (inclusive), unset if unlimited
+	std::optional<std::int64_t> max;  ///< Maximum value (inclusive), unset if unlimited
+	WarningLevel level = WarningLevel::Notice;  ///< Warning level to set
+	std::string reason;  ///< Warning reason to set
+};
+
+
+
+/// A set of warning rules, indexed by (section, name). Applying the rules costs one
+/// lookup per property, plus the checks of the rules for that property.
+///
+/// The rules may be loaded from a JSON file, which contains an array of objects:
+/// [{"section": "attributes", "name": "attr_reallocated_sector_count", "value": "raw",
+/// "min": 100, "level": "warning", "reason": "Too many reallocated sectors."}, ...].
+/// "section" is a storable name of StoragePropertySection, "value" - of StorageWarningRuleValue
+/// ("value" by default), "level" is "notice", "warning" or "alert".
+class StorageWarningRules {
+	public:
+
+		/// Get the built-in rules
+		[[nodiscard]] static const StorageWarningRules& get_builtin();
+
+
+		/// Add a rule. Multiple rules may be added for the same property, the highest triggered level wins
+		/// (the rule added first wins if the levels are equal).
+		void add_rule(StorageWarningRule rule);
+
+
+		/// Add rules from JSON data (see the class description).
+		/// No rules are added on error.
+		hz::ExpectedVoid<StorageWarningRulesError> add_rules_from_json(std::string_view json_data);
+
+
+		/// Add rules from a JSON file (see the class description).
+		/// No rules are added on error.
+		hz::ExpectedVoid<StorageWarningRulesError> add_rules_from_file(const hz::fs::path& file);
+
+
+		/// Set the warning of the property if any rule triggers for it.
+		/// \return true if a rule triggered.
+		bool apply(StorageProperty& p) const;
+
+
+		/// Get the number of rules
+		[[nodiscard]] std::size_t size() const;
+
+
+	private:
+
+		/// Case-insensitive hash of rule names. Being transparent, it lets the properties
+		/// be looked up by their names as they are, without building a key.
+		struct NameHash {
+			using is_transparent = void;  ///< Allow lookup by std::string_view
+			std::size_t operator()(std::string_view name) const;
+		};
+
+		/// Case-insensitive comparison of rule names
+		struct NameEqual {
+			using is_transparent = void;  ///< Allow lookup by std::string_view
+			bool operator()(std::string_view a, std::string_view b) const;
+		};
+
+		/// Rule name -> rules
+		using NameRuleMap = std::unordered_map<std::string, std::vector<StorageWarningRule>, NameHash, NameEqual>;
+
+
+		std::unordered_map<StoragePropertySection, NameRuleMap> rules_;  ///< Section -> name -> rules
+		std::size_t size_ = 0;  ///< Number of rules
+
+};
+
+
+
+/// Set the rules used by StoragePropertyProcessor (nullptr to use the built-in rules).
+void storage_warning_rules_set_global(std::shared_ptr<const StorageWarningRules> rules);
+
+
+/// Get the rules set by storage_warning_rules_set_global(), or the built-in ones. Never nullptr.
+[[nodiscard]] std::shared_ptr<const StorageWarningRules> storage_warning_rules_get_global();
+
+
+/// Use the built-in rules plus the rules from \c file (if not empty) as global rules.
+/// The errors are logged, and only the built-in rules are used in that case.
+void storage_warning_rules_init_global(const hz::fs::path& file);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,299 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <mutex>
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+#include "rconfig/rconfig.h"
+#include "app_regex.h"
+
+#include "storage_raid_cli_inventory.h"
+
+
+
+namespace {
+
+	/// Cached inventory of a host
+	struct CachedRaidCliInventory {
+		std::chrono::steady_clock::time_point start_time;  ///< When the first query result was added
+		RaidCliInventory inventory;  ///< Query results
+	};
+
+
+	/// Inventory cache with its mutex
+	struct RaidCliInventoryCache {
+		std::mutex mutex;  ///< Protects inventories
+		std::map<std::string, CachedRaidCliInventory> inventories;  ///< Host -> inventory
+	};
+
+
+	/// Get the cache
+	RaidCliInventoryCache& get_raid_cli_inventory_cache()
+	{
+		static RaidCliInventoryCache cache;
+		return cache;
+	}
+
+
+	/// Get "system/raid_cli_inventory_ttl_sec"
+	std::chrono::seconds get_raid_cli_inventory_ttl()
+	{
+		return std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/raid_cli_inventory_ttl_sec")));
+	}
+
+}
+
+
+
+std::vector<int> tw_cli_parse_controllers(std::string_view output)
+{
+	std::vector<int> controllers;
+	const auto controller_re = app_regex_re("/^c([0-9]+)[ \\t]+/mi");
+	for (const std::string_view line : hz::string_split_view(output, '\n', true)) {
+		std::string controller_str;
+		if (app_regex_partial_match(controller_re, hz::string_trim_copy(line), &controller_str)) {
+			int controller = -1;
+			if (hz::string_is_numeric_nolocale(controller_str, controller)) {
+				controllers.push_back(controller);
+			}
+		}
+	}
+
+	// Sort them. This affects only the further detection order, since the drives
+	// are sorted in the end anyway.
+	std::sort(controllers.begin(), controllers.end());
+	return controllers;
+}
+
+
+
+std::vector<int> tw_cli_parse_ports(std::string_view output)
+{
+	std::vector<int> ports;
+	// The columns are separated by spaces or tabs, the status is the first one after the port.
+	const auto port_re = app_regex_re(R"(/^p([0-9]+)[ \t]+([^ \t\n]+)/mi)");
+	for (const std::string_view line : hz::string_split_view(output, '\n', true)) {
+		std::string port_str, status;
+		if (app_regex_partial_match(port_re, hz::string_trim_copy(line), {&port_str, &status})) {
+			int port = -1;
+			if (status != "NOT-PRESENT" && hz::string_is_numeric_nolocale(port_str, port)) {
+				ports.push_back(port);
+			}
+		}
+	}
+	return ports;
+}
+
+
+
+/** <pre>
+Parse "cli disk info" output of Areca CLI.
+
+There are 3 formats of "disk info" output:
+
+1. No expanders:
+------------------------------------------------------------
+  # Ch# ModelName                       Capacity  Usage
+===============================================================================
+  1  1  INTEL SSDSA2M160G2GC             160.0GB  System
+  2  2  INTEL SSDSA2M160G2GC             160.0GB  System
+  3  3  INTEL SSDSA2M160G2GC             160.0GB  System
+  4  4  INTEL SSDSA2M160G2GC             160.0GB  System
+  5  5  Hitachi HDS724040ALE640         4000.8GB  Storage
+  6  6  Hitachi HDS724040ALE640         4000.8GB  Storage
+  7  7  Hitachi HDS724040ALE640         4000.8GB  Storage
+  8  8  Hitachi HDS724040ALE640         4000.8GB  Storage
+  9  9  Hitachi HDS724040ALE640         4000.8GB  Storage
+ 10 10  Hitachi HDS724040ALE640         4000.8GB  Storage
+ 11 11  Hitachi HDS724040ALE640         4000.8GB  Backup
+ 12 12  Hitachi HDS724040ALE640         4000.8GB  Backup
+===============================================================================
+GuiErrMsg<0x00>: Success.
+------------------------------------------------------------
+
+2. No expanders (this output comes from CLI documentation, possibly an old format):
+------------------------------------------------------------
+ #   ModelName        Serial#          FirmRev     Capacity  State
+===============================================================================
+ 1   ST3250620NS      5QE1CP8S         3.AEE        250.1GB  RaidSet Member(1)
+ 2   ST3250620NS      5QE1CP8S         3.AEE        250.1GB  RaidSet Member(1)
+....(snip)....
+12   ST3250620NS      5QE1CP8S         3.AEE        250.1GB  RaidSet Member(1)
+===============================================================================
+GuiErrMsg<0x00>: Success.
+------------------------------------------------------------
+
+3. Expanders:
+------------------------------------------------------------
+  # Enc# Slot#   ModelName                        Capacity  Usage
+===============================================================================
+  1  01  Slot#1  N.A.                                0.0GB  N.A.
+  2  01  Slot#2  N.A.                                0.0GB  N.A.
+  3  01  Slot#3  N.A.                                0.0GB  N.A.
+  4  01  Slot#4  N.A.                                0.0GB  N.A.
+  5  01  Slot#5  N.A.                                0.0GB  N.A.
+  6  01  Slot#6  N.A.                                0.0GB  N.A.
+  7  01  Slot#7  N.A.                                0.0GB  N.A.
+  8  01  Slot#8  N.A.                                0.0GB  N.A.
+  9  02  SLOT 01 N.A.                                0.0GB  N.A.
+ 10  02  SLOT 02 N.A.                                0.0GB  N.A.
+ 11  02  SLOT 03 N.A.                                0.0GB  N.A.
+ 12  02  SLOT 04 N.A.                                0.0GB  N.A.
+ 13  02  SLOT 05 N.A.                                0.0GB  N.A.
+ 14  02  SLOT 06 N.A.                                0.0GB  N.A.
+ 15  02  SLOT 07 N.A.                                0.0GB  N.A.
+ 16  02  SLOT 08 N.A.                                0.0GB  N.A.
+ 17  02  SLOT 09 N.A.                                0.0GB  N.A.
+ 18  02  SLOT 10 N.A.                                0.0GB  N.A.
+ 19  02  SLOT 11 N.A.                                0.0GB  N.A.
+ 20  02  SLOT 12 N.A.                                0.0GB  N.A.
+ 21  02  SLOT 13 N.A.                                0.0GB  N.A.
+ 22  02  SLOT 14 ST910021AS                        100.0GB  Free
+ 23  02  SLOT 15 WDC WD3200BEVT-75A23T0            320.1GB  HotSpare[Global]
+ 24  02  SLOT 16 N.A.                                0.0GB  N.A.
+ 25  02  SLOT 17 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
+ 26  02  SLOT 18 ST31500341AS                     1500.3GB  Raid Set # 000
+ 27  02  SLOT 19 ST3320620AS                       320.1GB  Raid Set # 000
+ 28  02  SLOT 20 ST31500341AS                     1500.3GB  Raid Set # 000
+ 29  02  SLOT 21 ST3500320AS                       500.1GB  Raid Set # 000
+ 30  02  SLOT 22 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
+ 31  02  SLOT 23 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
+ 32  02  SLOT 24 Hitachi HDS724040ALE640          4000.8GB  Raid Set # 000
+ 33  02  EXTP 01 N.A.                                0.0GB  N.A.
+ 34  02  EXTP 02 N.A.                                0.0GB  N.A.
+ 35  02  EXTP 03 N.A.                                0.0GB  N.A.
+ 36  02  EXTP 04 N.A.                                0.0GB  N.A.
+===============================================================================
+GuiErrMsg<0x00>: Success.
+------------------------------------------------------------
+</pre> */
+hz::ExpectedValue<ArecaCliInventory, StorageDetectorError> areca_cli_parse_disk_info(std::string_view output)
+{
+	// split to lines
+	std::vector<std::string> lines;
+	hz::string_split(std::string(output), '\n', lines, true);
+
+	enum class FormatType {
+		Unknown,
+		NoEnc1,
+		NoEnc2,
+		Enc
+	};
+
+	const auto noenc1_header_re = app_regex_re("/^\\s*#\\s+Ch#/mi");
+	const auto noenc2_header_re = app_regex_re("/^\\s*#\\s+ModelName/mi");
+	const auto exp_header_re = app_regex_re("/^\\s*#\\s+Enc#/mi");
+
+	FormatType format_type = FormatType::Unknown;
+	for (const auto& line : lines) {
+		if (app_regex_partial_match(noenc1_header_re, line)) {
+			format_type = FormatType::NoEnc1;
+			break;
+		}
+		if (app_regex_partial_match(noenc2_header_re, line)) {
+			format_type = FormatType::NoEnc2;
+			break;
+		}
+		if (app_regex_partial_match(exp_header_re, line)) {
+			format_type = FormatType::Enc;
+			break;
+		}
+	}
+	if (format_type == FormatType::Unknown) {
+		debug_out_warn("app", "Could not read Areca CLI output: No valid header found.\n");
+		return hz::Unexpected(StorageDetectorError::ParseError,
+				_("Could not read Areca CLI output: No valid header found."));
+	}
+
+	// Note: These may not match the full model, but just the first part is sufficient for comparison with "N.A.".
+	const auto noexp1_port_re = app_regex_re("/^\\s*[0-9]+\\s+([0-9]+)\\s+([^\\s]+)/mi");  // matches port, model.
+	const auto noexp2_port_re = app_regex_re("/^\\s*([0-9]+)\\s+([^\\s]+)/mi");  // matches port, model.
+	const auto exp_port_re = app_regex_re("/^\\s*[0-9]+\\s+([0-9]+)\\s+(?:Slot#|SLOT\\s+)([0-9]+)\\s+([^\\s]+)/mi");  // matches enclosure, port, model.
+
+	ArecaCliInventory inventory;
+	inventory.has_enclosure = (format_type == FormatType::Enc);
+
+	for (const auto& line : lines) {
+		std::string port_str, model_str;
+		if (inventory.has_enclosure) {
+			std::string enclosure_str;
+			if (app_regex_partial_match(exp_port_re, hz::string_trim_copy(line), {&enclosure_str, &port_str, &model_str})) {
+				if (model_str != "N.A.") {
+					ArecaCliDisk disk;
+					disk.port = hz::string_to_number_nolocale<int>(port_str);
+					disk.enclosure = hz::string_to_number_nolocale<int>(enclosure_str);
+					inventory.disks.push_back(disk);
+				}
+			}
+		} else {  // no enclosures
+			const auto port_re = (format_type == FormatType::NoEnc1 ? noexp1_port_re : noexp2_port_re);
+			if (app_regex_partial_match(port_re, hz::string_trim_copy(line), {&port_str, &model_str})) {
+				if (model_str != "N.A.") {
+					ArecaCliDisk disk;
+					disk.port = hz::string_to_number_nolocale<int>(port_str);
+					inventory.disks.push_back(disk);
+				}
+			}
+		}
+	}
+
+	return inventory;
+}
+
+
+
+RaidCliInventory raid_cli_inventory_get(const std::string& host)
+{
+	const auto ttl = get_raid_cli_inventory_ttl();
+	auto& cache = get_raid_cli_inventory_cache();
+	const std::scoped_lock lock(cache.mutex);
+	if (auto iter = cache.inventories.find(host); iter != cache.inventories.end()) {
+		if (std::chrono::steady_clock::now() - iter->second.start_time < ttl) {
+			return iter->second.inventory;
+		}
+		cache.inventories.erase(iter);
+	}
+	return {};
+}
+
+
+
+void raid_cli_inventory_update(const std::string& host, const std::function<void(RaidCliInventory& inventory)>& update)
+{
+	const auto ttl = get_raid_cli_inventory_ttl();
+	const auto now = std::chrono::steady_clock::now();
+	auto& cache = get_raid_cli_inventory_cache();
+	const std::scoped_lock lock(cache.mutex);
+	auto& cached = cache.inventories[host];
+	if (cached.start_time == std::chrono::steady_clock::time_point() || now - cached.start_time >= ttl) {
+		cached = CachedRaidCliInventory();
+		cached.start_time = now;
+	}
+	update(cached.inventory);
+}
+
+
+
+void raid_cli_inventory_clear()
+{
+	auto& cache = get_raid_cli_inventory_cache();
+	const std::scoped_lock lock(cache.mutex);
+	cache.inventories.clear();
+}
+
+
+
+
+/// @}
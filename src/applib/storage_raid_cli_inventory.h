@@ -0,0 +1,87 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_RAID_CLI_INVENTORY_H
+#define STORAGE_RAID_CLI_INVENTORY_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hz/error_container.h"
+
+#include "storage_detector.h"
+
+
+
+/// A populated port reported by Areca CLI
+struct ArecaCliDisk {
+	int port = 0;  ///< Port (slot) number
+	int enclosure = 0;  ///< Enclosure number, 0 if the controller has no enclosures
+
+	bool operator==(const ArecaCliDisk& other) const = default;
+};
+
+
+/// Parsed "cli disk info" output of Areca CLI
+struct ArecaCliInventory {
+	bool has_enclosure = false;  ///< The controller has enclosures (the drives need "areca,N/E")
+	std::vector<ArecaCliDisk> disks;  ///< Populated ports, in the output order
+};
+
+
+
+/// Populated ports of the RAID controllers, as reported by the vendor CLI tools of one host.
+/// Each part is filled when the corresponding query is first run.
+struct RaidCliInventory {
+	std::optional<std::vector<int>> tw_cli_controllers;  ///< 3ware controllers ("tw_cli show"), sorted
+	std::map<int, std::vector<int>> tw_cli_ports;  ///< 3ware controller -> populated ports ("tw_cli /cN show all")
+	std::optional<ArecaCliInventory> areca;  ///< Areca drives ("cli disk info")
+};
+
+
+
+/// Parse "tw_cli show" output. \return controller numbers, sorted.
+[[nodiscard]] std::vector<int> tw_cli_parse_controllers(std::string_view output);
+
+
+/// Parse "tw_cli /cN show all" output. \return populated port numbers, in the output order.
+[[nodiscard]] std::vector<int> tw_cli_parse_ports(std::string_view output);
+
+
+/// Parse "cli disk info" output of Areca CLI.
+[[nodiscard]] hz::ExpectedValue<ArecaCliInventory, StorageDetectorError> areca_cli_parse_disk_info(std::string_view output);
+
+
+
+/// Get the cached inventory of a host (empty string for the local one).
+/// The inventory expires "system/raid_cli_inventory_ttl_sec" after it was started, so that
+/// the lookups during one scan (and shortly after it) run each CLI query once. Thread-safe.
+[[nodiscard]] RaidCliInventory raid_cli_inventory_get(const std::string& host);
+
+
+/// Add query results to the cached inventory of a host, starting a new one if it expired. Thread-safe.
+void raid_cli_inventory_update(const std::string& host, const std::function<void(RaidCliInventory& inventory)>& update);
+
+
+/// Forget the cached inventories. Thread-safe.
+void raid_cli_inventory_clear();
+
+
+
+
+#endif
+
+/// @}
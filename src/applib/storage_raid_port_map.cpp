@@ -0,0 +1,80 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+
+#include "rconfig/rconfig.h"
+#include "hz/debug.h"
+
+#include "storage_raid_port_map.h"
+
+
+
+std::string storage_raid_port_map_get_key(const std::string& remote_host, const std::string& dev, const std::string& type)
+{
+	return (remote_host.empty() ? std::string() : (remote_host + ":")) + dev + " " + type;
+}
+
+
+
+std::optional<StorageRaidPortMapEntry> storage_raid_port_map_lookup(const std::string& key)
+{
+	const auto map = rconfig::get_data<rconfig::json>("system/raid_port_map");
+	try {
+		if (!map.is_object() || !map.contains(key)) {
+			return std::nullopt;
+		}
+		const auto& cached = map.at(key);
+		StorageRaidPortMapEntry entry;
+		entry.ports = cached.at("ports").get<std::vector<int>>();
+		entry.full_sweep_time = cached.at("full_sweep_time").get<std::int64_t>();
+		std::sort(entry.ports.begin(), entry.ports.end());
+		entry.ports.erase(std::unique(entry.ports.begin(), entry.ports.end()), entry.ports.end());
+		return entry;
+	}
+	catch (rconfig::json::exception& e) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Invalid RAID port map entry for \"" << key << "\": " << e.what() << "\n");
+	}
+	return std::nullopt;
+}
+
+
+
+void storage_raid_port_map_store(const std::string& key, const StorageRaidPortMapEntry& entry)
+{
+	auto map = rconfig::get_data<rconfig::json>("system/raid_port_map");
+	if (!map.is_object()) {
+		map = rconfig::json::object();
+	}
+	map[key] = rconfig::json {
+		{"ports", entry.ports},
+		{"full_sweep_time", entry.full_sweep_time},
+	};
+	rconfig::set_data("system/raid_port_map", map);
+}
+
+
+
+bool storage_raid_port_map_get_sweep_due(const StorageRaidPortMapEntry& entry,
+		std::chrono::system_clock::time_point now, std::chrono::seconds interval)
+{
+	if (interval <= std::chrono::seconds::zero() || entry.full_sweep_time <= 0) {
+		return true;
+	}
+	const auto last_sweep = std::chrono::system_clock::time_point(std::chrono::seconds(entry.full_sweep_time));
+	// A clock which went backwards doesn't postpone the sweep forever
+	return now < last_sweep || now - last_sweep >= interval;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,59 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_RAID_PORT_MAP_H
+#define STORAGE_RAID_PORT_MAP_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+
+/// Ports of a RAID controller (or enclosure) which held drives in the previous scans,
+/// so that a rescan can probe them first and skip the full port sweep while nothing changed.
+struct StorageRaidPortMapEntry {
+	std::vector<int> ports;  ///< Populated ports, ascending
+	std::int64_t full_sweep_time = 0;  ///< Time of the last full sweep, seconds since the epoch. 0 if never.
+
+	bool operator==(const StorageRaidPortMapEntry& other) const = default;
+};
+
+
+
+/// Get the map key of a controller: remote host destination (empty if local), device
+/// and the smartctl type format (e.g. "areca,%d/1").
+[[nodiscard]] std::string storage_raid_port_map_get_key(const std::string& remote_host,
+		const std::string& dev, const std::string& type);
+
+
+/// Get the learned ports of a controller (stored in "system/raid_port_map" config key).
+/// \return std::nullopt if the controller was never fully swept.
+[[nodiscard]] std::optional<StorageRaidPortMapEntry> storage_raid_port_map_lookup(const std::string& key);
+
+
+/// Store the learned ports of a controller, replacing the previous entry.
+void storage_raid_port_map_store(const std::string& key, const StorageRaidPortMapEntry& entry);
+
+
+/// Check whether the full port sweep of a controller is due: true if the last one was
+/// \c interval or more ago (or never), or if \c interval is zero (learning is disabled).
+[[nodiscard]] bool storage_raid_port_map_get_sweep_due(const StorageRaidPortMapEntry& entry,
+		std::chrono::system_clock::time_point now, std::chrono::seconds interval);
+
+
+
+
+#endif
+
+/// @}
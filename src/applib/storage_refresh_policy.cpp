@@ -0,0 +1,135 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "hz/string_num.h"
+
+#include "storage_refresh_policy.h"
+
+
+
+namespace {
+
+	/// ATA attributes which grow when the drive is failing
+	constexpr std::int32_t activity_ata_attribute_ids[] = {
+		5,  // Reallocated Sector Count
+		196,  // Reallocation Event Count
+		197,  // Current Pending Sector Count
+		198,  // Offline Uncorrectable
+	};
+
+	/// NVMe health counters which grow when the drive is failing
+	constexpr const char* activity_nvme_names[] = {
+		"critical_warning",
+		"media_errors",
+		"num_err_log_entries",
+	};
+
+	/// Temperature changes smaller than this are ignored
+	constexpr std::int64_t temperature_threshold = 2;
+
+}
+
+
+
+StorageRefreshPolicy::StorageRefreshPolicy(std::chrono::seconds min_interval, std::chrono::seconds max_interval)
+		: min_interval_(std::max(min_interval, std::chrono::seconds(1))),
+		max_interval_(std::max(max_interval, min_interval_)),
+		interval_(min_interval_)
+{ }
+
+
+
+std::chrono::seconds StorageRefreshPolicy::update(const StoragePropertyRepository& properties)
+{
+	auto values = get_activity_values(properties);
+	if (last_values_.has_value() && !get_activity_changed(last_values_.value(), values)) {
+		// Keep the old values as a base, so that a slow temperature drift is noticed too.
+		interval_ = std::min(interval_ * 2, max_interval_);
+	} else {
+		interval_ = min_interval_;
+		last_values_ = std::move(values);
+	}
+	return interval_;
+}
+
+
+
+std::chrono::seconds StorageRefreshPolicy::get_interval() const
+{
+	return interval_;
+}
+
+
+
+StorageActivityValues StorageRefreshPolicy::get_activity_values(const StoragePropertyRepository& properties)
+{
+	StorageActivityValues values;
+
+	for (const auto* name : {"temperature/current", "ata_sct_status/temperature/current"}) {
+		if (const auto* p = properties.find_property(name); p && p->is_value_type<std::int64_t>()) {
+			values.emplace_back("temperature", p->get_value<std::int64_t>());
+			break;
+		}
+	}
+
+	for (const auto& p : properties.get_properties()) {
+		if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()) {
+			const auto& attr = p.get_value<AtaStorageAttribute>();
+			if (std::find(std::begin(activity_ata_attribute_ids), std::end(activity_ata_attribute_ids), attr.id)
+					!= std::end(activity_ata_attribute_ids)) {
+				values.emplace_back("ata_attr/" + hz::number_to_string_nolocale(attr.id), attr.raw_value_int);
+			}
+		}
+	}
+
+	for (const auto* name : activity_nvme_names) {
+		const std::string generic_name = std::string("nvme_smart_health_information_log/") + name;
+		if (const auto* p = properties.find_property(generic_name); p && p->is_value_type<std::int64_t>()) {
+			values.emplace_back(std::string("nvme/") + name, p->get_value<std::int64_t>());
+		}
+	}
+
+	return values;
+}
+
+
+
+bool StorageRefreshPolicy::get_activity_changed(const StorageActivityValues& old_values, const StorageActivityValues& new_values)
+{
+	if (old_values.size() != new_values.size()) {
+		return true;
+	}
+	for (std::size_t i = 0; i < old_values.size(); ++i) {
+		const auto& [old_key, old_value] = old_values[i];
+		const auto& [new_key, new_value] = new_values[i];
+		if (old_key != new_key) {
+			return true;
+		}
+		if (new_key == "temperature") {
+			if (std::abs(new_value - old_value) >= temperature_threshold) {
+				return true;
+			}
+		} else if (new_value != old_value) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
+
+/// @}
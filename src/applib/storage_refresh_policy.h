@@ -0,0 +1,77 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_REFRESH_POLICY_H
+#define STORAGE_REFRESH_POLICY_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage_property_repository.h"
+
+
+
+/// Values of a drive which indicate that it's changing: (key, value) pairs.
+using StorageActivityValues = std::vector<std::pair<std::string, std::int64_t>>;
+
+
+
+/// Adaptive refresh interval of a drive. The interval is reset to the minimum
+/// when the temperature or the reallocated / pending / uncorrectable counts change,
+/// and it's doubled (up to the maximum) each time they stay the same.
+class StorageRefreshPolicy {
+	public:
+
+		/// Constructor. The first interval is \c min_interval.
+		StorageRefreshPolicy(std::chrono::seconds min_interval, std::chrono::seconds max_interval);
+
+
+		/// Update the interval using freshly fetched properties.
+		/// \return the interval until the next refresh.
+		std::chrono::seconds update(const StoragePropertyRepository& properties);
+
+
+		/// Get the current interval
+		[[nodiscard]] std::chrono::seconds get_interval() const;
+
+
+		/// Get the activity values from parsed properties. The keys are "temperature",
+		/// "ata_attr/<id>" for the reallocation-related ATA attributes and "nvme/<name>"
+		/// for the NVMe error counters.
+		[[nodiscard]] static StorageActivityValues get_activity_values(const StoragePropertyRepository& properties);
+
+
+		/// Check whether the drive is changing. Temperature changes smaller than 2 degrees are ignored.
+		[[nodiscard]] static bool get_activity_changed(const StorageActivityValues& old_values, const StorageActivityValues& new_values);
+
+
+	private:
+
+		std::chrono::seconds min_interval_;  ///< Minimum interval
+		std::chrono::seconds max_interval_;  ///< Maximum interval
+		std::chrono::seconds interval_;  ///< Current interval
+
+		std::optional<StorageActivityValues> last_values_;  ///< Values at the last detected change
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
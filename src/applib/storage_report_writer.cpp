@@ -0,0 +1,242 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <atomic>
+
+#include "nlohmann/json.hpp"
+
+#include "hz/string_algo.h"  // string_to_lower_copy, string_ends_with
+#include "build_config.h"
+#include "storage_device_json.h"
+#include "worker_threads.h"
+#include "storage_report_writer.h"
+
+
+
+namespace {
+
+	/// Version of the JSON report format
+	constexpr int report_format_version = 1;
+
+
+	/// Dump JSON without failing on invalid UTF-8 in the smartctl output
+	std::string report_json_dump(const nlohmann::json& j)
+	{
+		return j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+	}
+
+}
+
+
+
+StorageReportWriter::StorageReportWriter(std::ostream& out, StorageReportFormat format)
+		: out_(out), format_(format)
+{ }
+
+
+
+bool StorageReportWriter::get_format_for_file(const std::string& filename, StorageReportFormat& format)
+{
+	const std::string lower = hz::string_to_lower_copy(filename);
+	if (hz::string_ends_with(lower, ".json")) {
+		format = StorageReportFormat::Json;
+		return true;
+	}
+	if (hz::string_ends_with(lower, ".html") || hz::string_ends_with(lower, ".htm")) {
+		format = StorageReportFormat::Html;
+		return true;
+	}
+	return false;
+}
+
+
+
+void StorageReportWriter::begin(const std::string& host, std::int64_t time)
+{
+	const std::scoped_lock lock(mutex_);
+	switch (format_) {
+		case StorageReportFormat::Json:
+			// The drives are written one by one, so the document is assembled by hand.
+			out_ << "{\"format_version\":" << report_format_version
+					<< ",\"program_version\":" << report_json_dump(BuildEnv::package_version())
+					<< ",\"host\":" << report_json_dump(host)
+					<< ",\"time\":" << time
+					<< ",\"drives\":[";
+			break;
+		case StorageReportFormat::Html:
+			out_ << "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n"
+					<< "<title>SMART Report - " << html_escape(host) << "</title>\n"
+					<< "<style>\n"
+					<< "body { font-family: sans-serif; }\n"
+					<< "table { border-collapse: collapse; margin-bottom: 2em; }\n"
+					<< "th, td { border: 1px solid #ccc; padding: 2px 6px; text-align: left; vertical-align: top; }\n"
+					<< "tr.notice { background: #ffffcc; }\n"
+					<< "tr.warning { background: #ffddaa; }\n"
+					<< "tr.alert { background: #ffaaaa; }\n"
+					<< ".error { color: #c00000; }\n"
+					<< "</style>\n</head>\n<body>\n"
+					<< "<h1>SMART Report - " << html_escape(host) << "</h1>\n"
+					<< "<p>Generated by GSmartControl " << html_escape(BuildEnv::package_version())
+					<< " at " << time << " (seconds since epoch).</p>\n";
+			break;
+	}
+}
+
+
+
+void StorageReportWriter::add_drive(const StorageDevice& drive, const std::string& error)
+{
+	if (format_ == StorageReportFormat::Html) {
+		write_html_drive(drive, error);
+		return;
+	}
+
+	// Serialize outside the lock, so that the other workers aren't held up.
+	nlohmann::json drive_json = storage_device_to_json(drive);
+	if (!error.empty()) {
+		drive_json["error"] = error;
+	}
+	const std::string str = report_json_dump(drive_json);
+	drive_json = nlohmann::json();
+
+	const std::scoped_lock lock(mutex_);
+	out_ << (drive_count_ == 0 ? "\n" : ",\n") << str;
+	out_.flush();
+	++drive_count_;
+}
+
+
+
+void StorageReportWriter::end(std::int64_t duration_ms)
+{
+	const std::scoped_lock lock(mutex_);
+	switch (format_) {
+		case StorageReportFormat::Json:
+			out_ << "\n],\"duration_ms\":" << duration_ms << "}\n";
+			break;
+		case StorageReportFormat::Html:
+			out_ << "<p>" << drive_count_ << " drive(s), collected in " << duration_ms << " ms.</p>\n"
+					<< "</body>\n</html>\n";
+			break;
+	}
+	out_.flush();
+}
+
+
+
+std::size_t StorageReportWriter::get_drive_count() const
+{
+	const std::scoped_lock lock(mutex_);
+	return drive_count_;
+}
+
+
+
+bool StorageReportWriter::get_ok() const
+{
+	const std::scoped_lock lock(mutex_);
+	return out_.good();
+}
+
+
+
+std::string StorageReportWriter::html_escape(const std::string& str)
+{
+	std::string escaped;
+	escaped.reserve(str.size());
+	for (const char c : str) {
+		switch (c) {
+			case '&': escaped += "&amp;"; break;
+			case '<': escaped += "&lt;"; break;
+			case '>': escaped += "&gt;"; break;
+			case '"': escaped += "&quot;"; break;
+			case '\'': escaped += "&#39;"; break;
+			default: escaped += c; break;
+		}
+	}
+	return escaped;
+}
+
+
+
+void StorageReportWriter::write_html_drive(const StorageDevice& drive, const std::string& error)
+{
+	const StorageDevice::SnapshotPtr snapshot = drive.get_snapshot();
+
+	std::string str = "<h2>" + html_escape(drive.get_device_with_type());
+	if (!snapshot->model_name.empty()) {
+		str += " - " + html_escape(snapshot->model_name);
+	}
+	str += "</h2>\n";
+	if (!snapshot->serial_number.empty()) {
+		str += "<p>Serial number: " + html_escape(snapshot->serial_number) + "</p>\n";
+	}
+	if (!snapshot->health_property.empty()) {
+		str += "<p>Health: " + html_escape(snapshot->health_property.format_value()) + "</p>\n";
+	}
+	if (!error.empty()) {
+		str += "<p class=\"error\">Error: " + html_escape(error) + "</p>\n";
+	}
+
+	const auto& properties = snapshot->property_repository.get_properties();
+	if (!properties.empty()) {
+		str += "<table>\n<tr><th>Section</th><th>Name</th><th>Value</th><th>Warning</th></tr>\n";
+		for (const auto& p : properties) {
+			const bool has_warning = (p.warning_level != WarningLevel::None);
+			str += (has_warning ? "<tr class=\"" + warning_level_get_storable_name(p.warning_level) + "\">" : std::string("<tr>"));
+			str += "<td>" + html_escape(StoragePropertySectionExt::get_displayable_name(p.section)) + "</td>";
+			str += "<td>" + html_escape(p.displayable_name.empty() ? p.generic_name : p.displayable_name) + "</td>";
+			str += "<td>" + html_escape(p.format_value()) + "</td>";
+			str += "<td>" + (has_warning ? html_escape(p.warning_reason) : std::string()) + "</td></tr>\n";
+		}
+		str += "</table>\n";
+	}
+
+	const std::scoped_lock lock(mutex_);
+	out_ << str;
+	out_.flush();
+	++drive_count_;
+}
+
+
+
+bool storage_report_fetch_and_write(StorageReportWriter& writer, std::vector<StorageDevicePtr> drives,
+		const CommandExecutorFactoryPtr& ex_factory, std::size_t max_parallel)
+{
+	std::atomic<bool> all_ok = true;
+	app_run_worker_tasks(drives.size(), max_parallel, [&](std::size_t i) {
+		// Take the only reference we hold, so the drive is freed when the task ends.
+		const StorageDevicePtr drive = std::move(drives[i]);
+
+		std::string error;
+		if (!drive->get_is_virtual() || drive->get_full_output().empty()) {
+			std::shared_ptr<CommandExecutor> smartctl_ex;
+			if (!drive->get_is_virtual()) {
+				smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+				smartctl_ex->set_priority(CommandPriority::Bulk);
+			}
+			// The type of the real drives may not be known yet (e.g. manually added ones)
+			auto status = drive->get_is_virtual() ? drive->fetch_full_data_and_parse(smartctl_ex)
+					: drive->fetch_all_data_and_parse(smartctl_ex);
+			if (!status) {
+				error = status.error().message();
+				all_ok = false;
+			}
+		}
+		writer.add_drive(*drive, error);
+	});
+	return all_ok;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,101 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_REPORT_WRITER_H
+#define STORAGE_REPORT_WRITER_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "command_executor_factory.h"
+#include "storage_device.h"
+
+
+
+/// Format of a multi-drive report
+enum class StorageReportFormat {
+	Json,  ///< JSON document, with each drive as in storage_device_to_json()
+	Html,  ///< HTML page with a table of properties per drive
+};
+
+
+
+/// Writes a report of many drives to a stream, one drive at a time. Each drive is
+/// serialized and written as soon as it's added, so the report is never held in memory.
+/// add_drive() is thread-safe, so the drives may be added from the worker threads
+/// fetching them, in any order.
+class StorageReportWriter {
+	public:
+
+		/// Constructor. Nothing is written until begin().
+		StorageReportWriter(std::ostream& out, StorageReportFormat format);
+
+
+		/// Get the report format by the file extension (".html" / ".htm" or ".json", case-insensitive).
+		/// \return false if the extension is not recognized.
+		static bool get_format_for_file(const std::string& filename, StorageReportFormat& format);
+
+
+		/// Write the report header. \c time is in seconds since epoch.
+		void begin(const std::string& host, std::int64_t time);
+
+		/// Write a drive. \c error is the fetch error message, if any.
+		void add_drive(const StorageDevice& drive, const std::string& error = std::string());
+
+		/// Write the report footer. \c duration_ms is the time it took to collect the data.
+		void end(std::int64_t duration_ms);
+
+
+		/// Get the number of drives written
+		[[nodiscard]] std::size_t get_drive_count() const;
+
+		/// Check whether the stream is still good
+		[[nodiscard]] bool get_ok() const;
+
+
+		/// Escape the HTML special characters in a string
+		[[nodiscard]] static std::string html_escape(const std::string& str);
+
+
+	private:
+
+		/// Write a drive as HTML
+		void write_html_drive(const StorageDevice& drive, const std::string& error);
+
+
+		std::ostream& out_;  ///< Output stream
+		StorageReportFormat format_ = StorageReportFormat::Json;  ///< Report format
+
+		mutable std::mutex mutex_;  ///< Serializes the writes to out_
+		std::size_t drive_count_ = 0;  ///< Number of drives written
+
+};
+
+
+
+/// Fetch the full data of the drives in parallel (up to \c max_parallel at the same time),
+/// writing each drive to \c writer as soon as its fetch finishes. The drives are moved in,
+/// and each one is released right after it's written, so (unless the caller holds other
+/// references) only the drives being fetched are in memory.
+/// \return false if any of the fetches failed (the errors are written to the report).
+bool storage_report_fetch_and_write(StorageReportWriter& writer, std::vector<StorageDevicePtr> drives,
+		const CommandExecutorFactoryPtr& ex_factory, std::size_t max_parallel);
+
+
+
+
+#endif
+
+/// @}
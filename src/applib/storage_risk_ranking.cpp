@@ -0,0 +1,251 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+#include "storage_risk_ranking.h"
+
+
+
+namespace {
+
+	/// A counter property adding to the risk score
+	struct RiskCounter {
+		StoragePropertySection section;  ///< Property section
+		std::string_view generic_name;  ///< Property generic name
+		std::int64_t weight;  ///< Points per unit
+	};
+
+
+	/// Counters adding to the risk score. The pending and uncorrectable sectors are weighted
+	/// higher than the reallocated ones, since they are unreadable data.
+	constexpr std::array risk_counters = {
+		RiskCounter{StoragePropertySection::AtaAttributes, "attr_current_pending_sector_count", 10},
+		RiskCounter{StoragePropertySection::AtaAttributes, "attr_total_pending_sectors", 10},
+		RiskCounter{StoragePropertySection::AtaAttributes, "attr_offline_uncorrectable", 10},
+		RiskCounter{StoragePropertySection::AtaAttributes, "attr_total_attr_offline_uncorrectable", 10},
+		RiskCounter{StoragePropertySection::AtaAttributes, "attr_reallocated_sector_count", 1},
+		RiskCounter{StoragePropertySection::NvmeAttributes, "nvme_smart_health_information_log/media_errors", 10},
+		RiskCounter{StoragePropertySection::NvmeAttributes, "nvme_smart_health_information_log/percentage_used", 1},
+	};
+
+
+	/// Score of a failed last self-test
+	constexpr std::int64_t failed_selftest_score = 1000;
+
+	/// Counter values are limited to this, so that vendor-encoded raw values don't overflow the sums
+	constexpr std::int64_t max_counter_value = 1'000'000'000;
+
+
+	/// Check if an ATA self-test status is a failure
+	bool is_ata_selftest_failure(AtaStorageSelftestEntry::Status status)
+	{
+		switch (status) {
+			case AtaStorageSelftestEntry::Status::FatalOrUnknown:
+			case AtaStorageSelftestEntry::Status::ComplUnknownFailure:
+			case AtaStorageSelftestEntry::Status::ComplElectricalFailure:
+			case AtaStorageSelftestEntry::Status::ComplServoFailure:
+			case AtaStorageSelftestEntry::Status::ComplReadFailure:
+			case AtaStorageSelftestEntry::Status::ComplHandlingDamage:
+				return true;
+			case AtaStorageSelftestEntry::Status::Unknown:
+			case AtaStorageSelftestEntry::Status::Reserved:
+			case AtaStorageSelftestEntry::Status::CompletedNoError:
+			case AtaStorageSelftestEntry::Status::AbortedByHost:
+			case AtaStorageSelftestEntry::Status::Interrupted:
+			case AtaStorageSelftestEntry::Status::InProgress:
+				break;
+		}
+		return false;
+	}
+
+
+	/// Check if an NVMe self-test result is a failure
+	bool is_nvme_selftest_failure(NvmeSelfTestResultType result)
+	{
+		switch (result) {
+			case NvmeSelfTestResultType::FatalOrUnknownTestError:
+			case NvmeSelfTestResultType::CompletedUnknownFailedSegment:
+			case NvmeSelfTestResultType::CompletedFailedSegments:
+				return true;
+			case NvmeSelfTestResultType::Unknown:
+			case NvmeSelfTestResultType::CompletedNoError:
+			case NvmeSelfTestResultType::AbortedSelfTestCommand:
+			case NvmeSelfTestResultType::AbortedControllerReset:
+			case NvmeSelfTestResultType::AbortedNamespaceRemoved:
+			case NvmeSelfTestResultType::AbortedFormatNvmCommand:
+			case NvmeSelfTestResultType::AbortedUnknownReason:
+			case NvmeSelfTestResultType::AbortedSanitizeOperation:
+				break;
+		}
+		return false;
+	}
+
+}
+
+
+
+std::int64_t storage_risk_property_score(const StorageProperty& p)
+{
+	if (p.section == StoragePropertySection::AtaAttributes || p.section == StoragePropertySection::NvmeAttributes) {
+		for (const auto& counter : risk_counters) {
+			if (p.section != counter.section || p.generic_name != counter.generic_name) {
+				continue;
+			}
+			std::int64_t value = 0;
+			if (p.is_value_type<AtaStorageAttribute>()) {
+				value = p.get_value<AtaStorageAttribute>().raw_value_int;
+			} else if (p.is_value_type<std::int64_t>()) {
+				value = p.get_value<std::int64_t>();
+			}
+			return std::clamp<std::int64_t>(value, 0, max_counter_value) * counter.weight;
+		}
+		return 0;
+	}
+
+	if (p.generic_name == "ata_smart_data/self_test/status/_merged" && p.is_value_type<AtaStorageSelftestEntry>()) {
+		return is_ata_selftest_failure(p.get_value<AtaStorageSelftestEntry>().status) ? failed_selftest_score : 0;
+	}
+
+	if (p.is_value_type<NvmeStorageSelftestEntry>()) {
+		const auto& entry = p.get_value<NvmeStorageSelftestEntry>();
+		// Only the latest one, the older failures may have been fixed since
+		return (entry.test_num == 1 && is_nvme_selftest_failure(entry.result)) ? failed_selftest_score : 0;
+	}
+
+	return 0;
+}
+
+
+
+std::int64_t storage_risk_score(const StoragePropertyRepository& properties)
+{
+	std::int64_t score = 0;
+	for (const auto& p : properties.get_properties()) {
+		score += storage_risk_property_score(p);
+	}
+	return score;
+}
+
+
+
+bool StorageRiskRanking::update(const StorageDevice* drive, const StoragePropertyRepository& properties)
+{
+	return set_score(drive, storage_risk_score(properties));
+}
+
+
+
+bool StorageRiskRanking::set_score(const StorageDevice* drive, std::int64_t score)
+{
+	auto [iter, inserted] = scores_.try_emplace(drive, score);
+	if (!inserted) {
+		if (iter->second == score) {
+			return false;
+		}
+		order_.erase(StorageRiskEntry{drive, iter->second});
+		iter->second = score;
+	}
+	order_.insert(StorageRiskEntry{drive, score});
+	return true;
+}
+
+
+
+bool StorageRiskRanking::apply_diff(const StorageDevice* drive, const StoragePropertyDiff& diff)
+{
+	auto iter = scores_.find(drive);
+	if (iter == scores_.end()) {
+		return false;
+	}
+	std::int64_t score = iter->second;
+	for (const auto& change : diff.changes) {
+		if (change.old_property.has_value()) {
+			score -= storage_risk_property_score(change.old_property.value());
+		}
+		if (change.new_property.has_value()) {
+			score += storage_risk_property_score(change.new_property.value());
+		}
+	}
+	return set_score(drive, score);
+}
+
+
+
+void StorageRiskRanking::remove(const StorageDevice* drive)
+{
+	auto iter = scores_.find(drive);
+	if (iter != scores_.end()) {
+		order_.erase(StorageRiskEntry{drive, iter->second});
+		scores_.erase(iter);
+	}
+}
+
+
+
+void StorageRiskRanking::clear()
+{
+	scores_.clear();
+	order_.clear();
+}
+
+
+
+std::size_t StorageRiskRanking::size() const
+{
+	return scores_.size();
+}
+
+
+
+std::optional<std::int64_t> StorageRiskRanking::get_score(const StorageDevice* drive) const
+{
+	if (auto iter = scores_.find(drive); iter != scores_.end()) {
+		return iter->second;
+	}
+	return std::nullopt;
+}
+
+
+
+std::vector<StorageRiskEntry> StorageRiskRanking::get_top(std::size_t k, std::int64_t min_score,
+		const std::function<bool(const StorageDevice*)>& filter) const
+{
+	std::vector<StorageRiskEntry> top;
+	for (const auto& entry : order_) {
+		if (top.size() >= k || entry.score < min_score) {
+			break;
+		}
+		if (!filter || filter(entry.drive)) {
+			top.push_back(entry);
+		}
+	}
+	return top;
+}
+
+
+
+bool StorageRiskRanking::EntryOrder::operator()(const StorageRiskEntry& a, const StorageRiskEntry& b) const
+{
+	if (a.score != b.score) {
+		return a.score > b.score;
+	}
+	return std::less<const StorageDevice*>()(a.drive, b.drive);
+}
+
+
+
+
+
+
+/// @}
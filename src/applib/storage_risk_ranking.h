@@ -0,0 +1,114 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_RISK_RANKING_H
+#define STORAGE_RISK_RANKING_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "storage_device.h"
+#include "storage_property.h"
+#include "storage_property_diff.h"
+#include "storage_property_repository.h"
+
+
+
+/// Get the risk score contribution of a property: 10 points for each pending or offline
+/// uncorrectable sector and NVMe media error, 1 point for each reallocated sector and NVMe
+/// "percentage used" percent, 1000 points for a failed last self-test. 0 for the other properties.
+[[nodiscard]] std::int64_t storage_risk_property_score(const StorageProperty& p);
+
+
+/// Get the risk score of a drive: the sum of storage_risk_property_score() of its properties.
+[[nodiscard]] std::int64_t storage_risk_score(const StoragePropertyRepository& properties);
+
+
+
+/// A drive with its risk score
+struct StorageRiskEntry {
+	const StorageDevice* drive = nullptr;  ///< Drive
+	std::int64_t score = 0;  ///< Risk score
+
+	/// Comparison
+	bool operator==(const StorageRiskEntry& other) const = default;
+};
+
+
+
+/// Risk scores of many drives, kept ordered so that the most at-risk drives can be
+/// retrieved without looking at the others. The scores are updated one drive at a time,
+/// either from all of its properties or from the differences of its properties only.
+class StorageRiskRanking {
+	public:
+
+		/// Set the score of a drive from all of its properties.
+		/// \return true if the score changed or the drive is new.
+		bool update(const StorageDevice* drive, const StoragePropertyRepository& properties);
+
+
+		/// Set the score of a drive.
+		/// \return true if the score changed or the drive is new.
+		bool set_score(const StorageDevice* drive, std::int64_t score);
+
+
+		/// Adjust the score of a drive by the contributions of the changed properties only.
+		/// The drive must have been added with update() or set_score(), unknown drives are ignored.
+		/// \return true if the score changed.
+		bool apply_diff(const StorageDevice* drive, const StoragePropertyDiff& diff);
+
+
+		/// Remove a drive
+		void remove(const StorageDevice* drive);
+
+
+		/// Remove all the drives
+		void clear();
+
+
+		/// Get the number of drives
+		[[nodiscard]] std::size_t size() const;
+
+
+		/// Get the score of a drive. \return std::nullopt if the drive is unknown.
+		[[nodiscard]] std::optional<std::int64_t> get_score(const StorageDevice* drive) const;
+
+
+		/// Get up to \c k drives with the highest scores (not less than \c min_score), highest first.
+		/// If \c filter is set, only the drives it accepts are returned.
+		[[nodiscard]] std::vector<StorageRiskEntry> get_top(std::size_t k, std::int64_t min_score = 1,
+				const std::function<bool(const StorageDevice*)>& filter = nullptr) const;
+
+
+	private:
+
+		/// Order of order_: highest score first, then by drive
+		struct EntryOrder {
+			bool operator()(const StorageRiskEntry& a, const StorageRiskEntry& b) const;
+		};
+
+		std::unordered_map<const StorageDevice*, std::int64_t> scores_;  ///< Drive -> score
+		std::set<StorageRiskEntry, EntryOrder> order_;  ///< Drives ordered by score
+
+};
+
+
+
+
+
+#endif
+
+/// @}
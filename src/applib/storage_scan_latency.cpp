@@ -0,0 +1,337 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include "fmt/format.h"
+#include "nlohmann/json.hpp"
+
+#include "hz/debug.h"
+
+#include "app_trace.h"
+#include "command_executor_stats.h"
+#include "storage_detector.h"
+#include "storage_scan_latency.h"
+
+
+
+namespace {
+
+	/// Version of the report file format
+	constexpr int scan_latency_format_version = 1;
+
+	/// Maximum report file size to load
+	constexpr int scan_latency_max_size = 10*1024*1024;  // 10M
+
+	/// Capacity of the trace ring buffer during a measurement. Only the detector spans are used.
+	constexpr std::size_t scan_latency_trace_capacity = 65536;
+
+
+	/// Get the duration since a time point
+	std::chrono::microseconds get_elapsed(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	}
+
+
+	/// Get the total runtime of the commands executed for a device since the statistics were cleared
+	std::chrono::microseconds get_device_command_time(const std::string& device)
+	{
+		const auto stats = cmdex_stats_get();
+		auto iter = stats.by_device.find(device);
+		return iter == stats.by_device.end() ? std::chrono::microseconds(0) : iter->second.runtime.get_total();
+	}
+
+
+	/// Format a duration in milliseconds
+	std::string format_ms(std::chrono::microseconds duration)
+	{
+		return fmt::format("{:.1f}", static_cast<double>(duration.count()) / 1000.);
+	}
+
+
+	/// Format a key as a table cell
+	std::string format_key(const StorageScanLatencyKey& key)
+	{
+		return fmt::format("{:<12} {:<24} {:<36}", key.backend, (key.device.empty() ? std::string("-") : key.device), key.phase);
+	}
+
+
+	/// One repetition of the scan-and-fetch. The durations are added to the recorder if it's not nullptr.
+	hz::ExpectedVoid<StorageScanLatencyError> measure_repetition(StorageScanLatencyRecorder* recorder,
+			const StorageScanLatencySettings& settings, const CommandExecutorFactoryPtr& ex_factory)
+	{
+		const auto add = [&](const std::string& device, std::string phase, std::chrono::microseconds duration) {
+			if (recorder) {
+				recorder->add({settings.backend, device, std::move(phase)}, duration);
+			}
+		};
+		const auto total_start = std::chrono::steady_clock::now();
+
+		std::vector<StorageDevicePtr> drives;
+		if (settings.detect) {
+			app_trace_set_enabled(true, scan_latency_trace_capacity);  // clears the previous spans
+
+			StorageDetector sd;
+			sd.add_blacklist_patterns(settings.blacklist_patterns);
+			const auto detect_start = std::chrono::steady_clock::now();
+			auto detect_status = sd.detect(drives, ex_factory);
+			add({}, "detect", get_elapsed(detect_start));
+			if (!detect_status) {
+				return hz::Unexpected(StorageScanLatencyError::DetectionError, detect_status.error().message());
+			}
+
+			for (const auto& span : app_trace_get_spans()) {
+				if (std::string_view(span.category) == "detector" && std::string_view(span.name) != "StorageDetector::detect") {
+					add({}, std::string("detect/") + span.name, std::chrono::microseconds(span.duration_ns / 1000));
+				}
+			}
+		}
+		for (auto&& drive : storage_inventory_create_drives(settings.drives)) {
+			drives.push_back(std::move(drive));
+		}
+
+		for (const auto& drive : drives) {
+			drive->set_keep_text_output(false);
+			const std::string device = drive->get_device_with_type();
+			auto smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+
+			cmdex_stats_clear();
+			const auto basic_start = std::chrono::steady_clock::now();
+			auto basic_status = drive->fetch_basic_data_and_parse(smartctl_ex);
+			add(device, "fetch_basic", get_elapsed(basic_start));
+			add(device, "fetch_basic/commands", get_device_command_time(drive->get_device()));
+			if (!basic_status) {
+				return hz::Unexpected(StorageScanLatencyError::FetchError,
+						fmt::format("{}: {}", device, basic_status.error().message()));
+			}
+
+			cmdex_stats_clear();
+			const auto full_start = std::chrono::steady_clock::now();
+			auto full_status = drive->fetch_full_data_and_parse(smartctl_ex);
+			add(device, "fetch_full", get_elapsed(full_start));
+			add(device, "fetch_full/commands", get_device_command_time(drive->get_device()));
+			if (!full_status) {
+				return hz::Unexpected(StorageScanLatencyError::FetchError,
+						fmt::format("{}: {}", device, full_status.error().message()));
+			}
+		}
+
+		add({}, "total", get_elapsed(total_start));
+		return {};
+	}
+
+}
+
+
+
+std::chrono::microseconds storage_scan_latency_percentile(const std::vector<std::chrono::microseconds>& sorted, double fraction)
+{
+	if (sorted.empty()) {
+		return std::chrono::microseconds(0);
+	}
+	const auto rank = static_cast<std::size_t>(std::ceil(std::clamp(fraction, 0., 1.) * static_cast<double>(sorted.size())));
+	return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+
+
+void StorageScanLatencyRecorder::add(const StorageScanLatencyKey& key, std::chrono::microseconds duration)
+{
+	samples_[key].push_back(duration);
+}
+
+
+
+StorageScanLatencySummaries StorageScanLatencyRecorder::get_summaries() const
+{
+	StorageScanLatencySummaries summaries;
+	for (const auto& [key, samples] : samples_) {
+		auto sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+		StorageScanLatencySummary& summary = summaries[key];
+		summary.count = sorted.size();
+		summary.p50 = storage_scan_latency_percentile(sorted, 0.50);
+		summary.p95 = storage_scan_latency_percentile(sorted, 0.95);
+		summary.p99 = storage_scan_latency_percentile(sorted, 0.99);
+		summary.max = sorted.empty() ? std::chrono::microseconds(0) : sorted.back();
+	}
+	return summaries;
+}
+
+
+
+hz::ExpectedVoid<StorageScanLatencyError> storage_scan_latency_measure(StorageScanLatencyRecorder& recorder,
+		const StorageScanLatencySettings& settings, const CommandExecutorFactoryPtr& ex_factory)
+{
+	hz::ExpectedVoid<StorageScanLatencyError> status;
+	for (int i = 0; i < settings.warmup + settings.repetitions && status; ++i) {
+		status = measure_repetition((i < settings.warmup ? nullptr : &recorder), settings, ex_factory);
+	}
+	app_trace_set_enabled(false);
+	cmdex_stats_clear();
+	return status;
+}
+
+
+
+std::string storage_scan_latency_dump(const StorageScanLatencySummaries& summaries, const std::string& host)
+{
+	nlohmann::json doc;
+	doc["format_version"] = scan_latency_format_version;
+	doc["host"] = host;
+	nlohmann::json& entries_json = doc["entries"];
+	entries_json = nlohmann::json::array();
+	for (const auto& [key, summary] : summaries) {
+		entries_json.push_back({
+			{"backend", key.backend},
+			{"device", key.device},
+			{"phase", key.phase},
+			{"count", summary.count},
+			{"p50_us", summary.p50.count()},
+			{"p95_us", summary.p95.count()},
+			{"p99_us", summary.p99.count()},
+			{"max_us", summary.max.count()},
+		});
+	}
+	return doc.dump(1, '\t');
+}
+
+
+
+hz::ExpectedValue<StorageScanLatencySummaries, StorageScanLatencyError> storage_scan_latency_parse(std::string_view json_str)
+{
+	const nlohmann::json doc = nlohmann::json::parse(json_str, nullptr, false);
+	if (!doc.is_object() || doc.value("format_version", 0) != scan_latency_format_version
+			|| !doc.contains("entries") || !doc["entries"].is_array()) {
+		return hz::Unexpected(StorageScanLatencyError::InvalidFormat, _("The file is not a scan latency report, or has an unsupported format version."));
+	}
+
+	StorageScanLatencySummaries summaries;
+	try {
+		for (const auto& j : doc["entries"]) {
+			StorageScanLatencyKey key;
+			key.backend = j.at("backend").get<std::string>();
+			key.device = j.value("device", std::string());
+			key.phase = j.at("phase").get<std::string>();
+
+			StorageScanLatencySummary summary;
+			summary.count = j.value("count", std::size_t(0));
+			summary.p50 = std::chrono::microseconds(j.at("p50_us").get<std::int64_t>());
+			summary.p95 = std::chrono::microseconds(j.at("p95_us").get<std::int64_t>());
+			summary.p99 = std::chrono::microseconds(j.at("p99_us").get<std::int64_t>());
+			summary.max = std::chrono::microseconds(j.value("max_us", summary.p99.count()));
+			summaries[std::move(key)] = summary;
+		}
+	}
+	catch (const nlohmann::json::exception& e) {
+		return hz::Unexpected(StorageScanLatencyError::InvalidFormat, e.what());
+	}
+	return summaries;
+}
+
+
+
+hz::ExpectedVoid<StorageScanLatencyError> storage_scan_latency_save(const hz::fs::path& file,
+		const StorageScanLatencySummaries& summaries, const std::string& host)
+{
+	if (auto ec = hz::fs_file_put_contents_atomic(file, storage_scan_latency_dump(summaries, host))) {
+		return hz::Unexpected(StorageScanLatencyError::WriteError, ec.message());
+	}
+	return {};
+}
+
+
+
+hz::ExpectedValue<StorageScanLatencySummaries, StorageScanLatencyError> storage_scan_latency_load(const hz::fs::path& file)
+{
+	std::string contents;
+	if (auto ec = hz::fs_file_get_contents(file, contents, scan_latency_max_size)) {
+		return hz::Unexpected(StorageScanLatencyError::ReadError, ec.message());
+	}
+	return storage_scan_latency_parse(contents);
+}
+
+
+
+std::vector<StorageScanLatencyComparison> storage_scan_latency_compare(const StorageScanLatencySummaries& current,
+		const StorageScanLatencySummaries& baseline, double tolerance, std::chrono::microseconds min_delta)
+{
+	std::vector<StorageScanLatencyComparison> comparison;
+	for (const auto& [key, summary] : current) {
+		StorageScanLatencyComparison entry;
+		entry.key = key;
+		entry.current = summary;
+		if (auto iter = baseline.find(key); iter != baseline.end()) {
+			entry.baseline = iter->second;
+			const auto allowed = static_cast<double>(iter->second.p95.count()) * (1. + tolerance);
+			entry.regressed = static_cast<double>(summary.p95.count()) > allowed
+					&& summary.p95 - iter->second.p95 > min_delta;
+		}
+		comparison.push_back(std::move(entry));
+	}
+	for (const auto& [key, summary] : baseline) {
+		if (!current.contains(key)) {
+			StorageScanLatencyComparison entry;
+			entry.key = key;
+			entry.baseline = summary;
+			comparison.push_back(std::move(entry));
+		}
+	}
+	std::sort(comparison.begin(), comparison.end(), [](const auto& a, const auto& b) { return a.key < b.key; });
+	return comparison;
+}
+
+
+
+std::string storage_scan_latency_format(const StorageScanLatencySummaries& summaries)
+{
+	std::string text = fmt::format("{:<12} {:<24} {:<36} {:>6} {:>10} {:>10} {:>10} {:>10}\n",
+			"backend", "device", "phase", "count", "p50 ms", "p95 ms", "p99 ms", "max ms");
+	for (const auto& [key, summary] : summaries) {
+		text += fmt::format("{} {:>6} {:>10} {:>10} {:>10} {:>10}\n", format_key(key), summary.count,
+				format_ms(summary.p50), format_ms(summary.p95), format_ms(summary.p99), format_ms(summary.max));
+	}
+	return text;
+}
+
+
+
+std::string storage_scan_latency_format_comparison(const std::vector<StorageScanLatencyComparison>& comparison)
+{
+	std::string text = fmt::format("{:<12} {:<24} {:<36} {:>14} {:>14} {:>8}\n",
+			"backend", "device", "phase", "base p95 ms", "p95 ms", "change");
+	for (const auto& entry : comparison) {
+		std::string change;
+		if (!entry.baseline.has_value()) {
+			change = "new";
+		} else if (!entry.current.has_value()) {
+			change = "gone";
+		} else if (entry.baseline->p95.count() > 0) {
+			change = fmt::format("{:+.0f}%", (static_cast<double>(entry.current->p95.count())
+					/ static_cast<double>(entry.baseline->p95.count()) - 1.) * 100.);
+		}
+		text += fmt::format("{} {:>14} {:>14} {:>8}{}\n", format_key(entry.key),
+				(entry.baseline.has_value() ? format_ms(entry.baseline->p95) : std::string("-")),
+				(entry.current.has_value() ? format_ms(entry.current->p95) : std::string("-")),
+				change, (entry.regressed ? "  REGRESSION" : ""));
+	}
+	return text;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,190 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_SCAN_LATENCY_H
+#define STORAGE_SCAN_LATENCY_H
+
+#include <chrono>
+#include <compare>
+#include <cstddef>  // std::size_t
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hz/error_container.h"
+#include "hz/fs.h"
+
+#include "command_executor_factory.h"
+#include "storage_inventory.h"
+
+
+
+/*
+A scan latency report gives the percentiles of the durations of a standard scan-and-fetch
+(drive detection, then the basic and the full data of each drive), repeated a number of times.
+The durations are broken down by detection backend, device and phase:
+
+- "total" (no device): the whole scan-and-fetch.
+- "detect" (no device): StorageDetector::detect().
+- "detect/<backend span>" (no device): each detection backend, from the "detector" trace spans.
+- "fetch_basic", "fetch_full" (per device): StorageDevice::fetch_basic_data_and_parse() and
+  StorageDevice::fetch_full_data_and_parse().
+- "fetch_basic/commands", "fetch_full/commands" (per device): the time spent in the smartctl
+  commands of the above, from the execution statistics. The rest is parsing and processing.
+
+The report (without the samples) is saved as JSON, to be compared with later runs:
+
+{
+	"format_version": 1,
+	"host": "server1",
+	"entries": [
+		{"backend": "scan_open", "device": "/dev/sda", "phase": "fetch_full",
+			"count": 10, "p50_us": 150000, "p95_us": 190000, "p99_us": 195000, "max_us": 195000},
+		...
+	]
+}
+*/
+
+
+
+/// Errors of the scan latency measurement and reports
+enum class StorageScanLatencyError {
+	ReadError,  ///< Cannot read the report file
+	WriteError,  ///< Cannot write the report file
+	InvalidFormat,  ///< Not a report, or an unsupported format version
+	DetectionError,  ///< Drive detection failed
+	FetchError,  ///< A drive could not be fetched
+};
+
+
+
+/// What a duration was measured for
+struct StorageScanLatencyKey {
+	std::string backend;  ///< Detection backend (a name chosen by the caller)
+	std::string device;  ///< Device, empty for the phases of the whole scan
+	std::string phase;  ///< Phase (see the description above)
+
+	auto operator<=>(const StorageScanLatencyKey& other) const = default;
+};
+
+
+
+/// Percentiles of the durations of one key
+struct StorageScanLatencySummary {
+	std::size_t count = 0;  ///< Number of samples
+	std::chrono::microseconds p50{0};  ///< Median
+	std::chrono::microseconds p95{0};  ///< 95th percentile
+	std::chrono::microseconds p99{0};  ///< 99th percentile
+	std::chrono::microseconds max{0};  ///< Longest duration
+};
+
+
+/// Summaries by key
+using StorageScanLatencySummaries = std::map<StorageScanLatencyKey, StorageScanLatencySummary>;
+
+
+
+/// Get the nearest-rank percentile (\c fraction 0 - 1) of sorted durations.
+/// The samples are few (one per repetition), so they're kept, and the percentiles are exact.
+[[nodiscard]] std::chrono::microseconds storage_scan_latency_percentile(
+		const std::vector<std::chrono::microseconds>& sorted, double fraction);
+
+
+
+/// Collects the duration samples
+class StorageScanLatencyRecorder {
+	public:
+
+		/// Add a sample
+		void add(const StorageScanLatencyKey& key, std::chrono::microseconds duration);
+
+		/// Compute the summaries of all the keys
+		[[nodiscard]] StorageScanLatencySummaries get_summaries() const;
+
+	private:
+
+		std::map<StorageScanLatencyKey, std::vector<std::chrono::microseconds>> samples_;  ///< Samples by key
+
+};
+
+
+
+/// Settings of storage_scan_latency_measure()
+struct StorageScanLatencySettings {
+	std::string backend;  ///< Name the samples are recorded under, describing the detection configuration
+	bool detect = true;  ///< Whether to detect the drives. If false, only \c drives are fetched.
+	std::vector<std::string> blacklist_patterns;  ///< Detection blacklist (see StorageDetector::add_blacklist_patterns())
+	std::vector<StorageInventoryEntry> drives;  ///< Drives fetched in addition to the detected ones
+	int repetitions = 10;  ///< Number of recorded repetitions
+	int warmup = 1;  ///< Number of repetitions before these, which are not recorded
+};
+
+
+
+/// Repeat the scan-and-fetch and record the durations. The drives are created anew in each
+/// repetition and fetched one by one, so that their times don't include waiting for each other.
+/// Tracing is enabled meanwhile (and disabled afterwards), and the execution statistics are cleared.
+/// A fetch error stops the measurement, since it would make the durations meaningless.
+[[nodiscard]] hz::ExpectedVoid<StorageScanLatencyError> storage_scan_latency_measure(StorageScanLatencyRecorder& recorder,
+		const StorageScanLatencySettings& settings, const CommandExecutorFactoryPtr& ex_factory);
+
+
+
+/// Serialize the summaries to JSON
+[[nodiscard]] std::string storage_scan_latency_dump(const StorageScanLatencySummaries& summaries, const std::string& host);
+
+
+/// Parse the summaries written by storage_scan_latency_dump()
+[[nodiscard]] hz::ExpectedValue<StorageScanLatencySummaries, StorageScanLatencyError> storage_scan_latency_parse(std::string_view json_str);
+
+
+/// Save the summaries to a file (atomically)
+[[nodiscard]] hz::ExpectedVoid<StorageScanLatencyError> storage_scan_latency_save(const hz::fs::path& file,
+		const StorageScanLatencySummaries& summaries, const std::string& host);
+
+
+/// Load the summaries from a file
+[[nodiscard]] hz::ExpectedValue<StorageScanLatencySummaries, StorageScanLatencyError> storage_scan_latency_load(const hz::fs::path& file);
+
+
+
+/// A key compared with the baseline
+struct StorageScanLatencyComparison {
+	StorageScanLatencyKey key;  ///< Key
+	std::optional<StorageScanLatencySummary> baseline;  ///< Baseline summary, unset if the key is new
+	std::optional<StorageScanLatencySummary> current;  ///< Current summary, unset if the key is gone
+	bool regressed = false;  ///< Whether the current p95 is above the allowed one
+};
+
+
+/// Compare the summaries with a baseline. A key regressed if its p95 is more than \c tolerance
+/// (a fraction, e.g. 0.2) and more than \c min_delta above the baseline p95. The absolute
+/// threshold keeps the very short phases from failing the comparison because of noise.
+[[nodiscard]] std::vector<StorageScanLatencyComparison> storage_scan_latency_compare(const StorageScanLatencySummaries& current,
+		const StorageScanLatencySummaries& baseline, double tolerance, std::chrono::microseconds min_delta);
+
+
+
+/// Format the summaries as a human-readable table, one line per key
+[[nodiscard]] std::string storage_scan_latency_format(const StorageScanLatencySummaries& summaries);
+
+
+/// Format the comparison as a human-readable table, one line per key, regressions marked
+[[nodiscard]] std::string storage_scan_latency_format_comparison(const std::vector<StorageScanLatencyComparison>& comparison);
+
+
+
+
+#endif
+
+/// @}
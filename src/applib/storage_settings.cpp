@@ -0,0 +1,170 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>
+#include <cstdint>
+#include <mutex>
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+
+#include "storage_settings.h"
+
+
+
+namespace {
+
+	/// Options decoded from config, valid for one config generation
+	struct DecodedOptions {
+		std::uint64_t generation = 0;  ///< rconfig generation the options were decoded at
+		bool valid = false;  ///< Whether the options were decoded at all
+		std::map<AppDeviceWithType, std::vector<std::string>> device_options;  ///< Parsed per-device options
+		std::optional<std::vector<std::string>> default_options;  ///< Parsed "system/smartctl_options", nullopt if invalid
+	};
+
+	/// Decoded options cache. The options are read by the worker threads too.
+	DecodedOptions decoded_options;
+
+	/// Mutex for decoded_options
+	std::mutex decoded_options_mutex;
+
+
+	/// Parse a command line, returning std::nullopt if it's invalid
+	inline std::optional<std::vector<std::string>> parse_options(const std::string& options_str)
+	{
+		const std::string trimmed = hz::string_trim_copy(options_str);
+		if (trimmed.empty()) {
+			return std::vector<std::string>();
+		}
+		try {
+			return Glib::shell_parse_argv(trimmed);
+		}
+		catch(Glib::ShellError& e) {
+			return std::nullopt;
+		}
+	}
+
+
+	/// Make sure the cache corresponds to the current config. Must be called with the mutex locked.
+	inline void update_decoded_options()
+	{
+		const std::uint64_t generation = rconfig::get_generation();
+		if (decoded_options.valid && decoded_options.generation == generation) {
+			return;
+		}
+
+		decoded_options.device_options.clear();
+		for (const auto& [dev_with_type, options_str] : app_config_get_device_option_map().value) {
+			if (auto options = parse_options(options_str); options.has_value()) {
+				if (!options->empty()) {
+					decoded_options.device_options.emplace(dev_with_type, std::move(options.value()));
+				}
+			} else {
+				debug_out_warn("app", DBG_FUNC_MSG << "Cannot parse the options for device \""
+						<< dev_with_type.first << "\": " << options_str << "\n");
+			}
+		}
+		decoded_options.default_options = parse_options(rconfig::get_data<std::string>("system/smartctl_options"));
+		decoded_options.generation = generation;
+		decoded_options.valid = true;
+	}
+
+}
+
+
+
+std::vector<std::string> app_get_device_options(const std::string& dev, const std::string& type_arg)
+{
+	if (dev.empty())
+		return {};
+
+	const std::scoped_lock lock(decoded_options_mutex);
+	update_decoded_options();
+	if (auto iter = decoded_options.device_options.find(std::pair(dev, type_arg)); iter != decoded_options.device_options.end()) {
+		return iter->second;
+	}
+	return {};
+}
+
+
+
+std::optional<std::vector<std::string>> app_get_smartctl_default_options()
+{
+	const std::scoped_lock lock(decoded_options_mutex);
+	update_decoded_options();
+	return decoded_options.default_options;
+}
+
+
+
+
+AppDriveSettings AppDriveSettings::get_current()
+{
+	AppDriveSettings settings;
+	settings.smartctl_binary = rconfig::get_data<std::string>("system/smartctl_binary");
+	settings.smartctl_options = rconfig::get_data<std::string>("system/smartctl_options");
+	settings.win32_search_smartctl_in_smartmontools = rconfig::get_data<bool>("system/win32_search_smartctl_in_smartmontools");
+	settings.blacklist_patterns = rconfig::get_data<std::string>("system/device_blacklist_patterns");
+	settings.device_options = app_config_get_device_option_map();
+	settings.show_smart_capable_only = rconfig::get_data<bool>("gui/show_smart_capable_only");
+	settings.icons_show_device_name = rconfig::get_data<bool>("gui/icons_show_device_name");
+	settings.icons_show_serial_number = rconfig::get_data<bool>("gui/icons_show_serial_number");
+	return settings;
+}
+
+
+
+AppDriveSettingsDelta app_drive_settings_compare(const AppDriveSettings& old_settings,
+		const AppDriveSettings& new_settings)
+{
+	AppDriveSettingsDelta delta;
+	delta.rescan = old_settings.smartctl_binary != new_settings.smartctl_binary
+			|| old_settings.smartctl_options != new_settings.smartctl_options
+			|| old_settings.win32_search_smartctl_in_smartmontools != new_settings.win32_search_smartctl_in_smartmontools;
+	delta.blacklist = old_settings.blacklist_patterns != new_settings.blacklist_patterns;
+	delta.visibility = old_settings.show_smart_capable_only != new_settings.show_smart_capable_only;
+	delta.icon_text = old_settings.icons_show_device_name != new_settings.icons_show_device_name
+			|| old_settings.icons_show_serial_number != new_settings.icons_show_serial_number;
+
+	// Both maps are sorted by key
+	const auto& old_map = old_settings.device_options.value;
+	const auto& new_map = new_settings.device_options.value;
+	auto old_iter = old_map.cbegin();
+	auto new_iter = new_map.cbegin();
+	while (old_iter != old_map.cend() || new_iter != new_map.cend()) {
+		if (new_iter == new_map.cend() || (old_iter != old_map.cend() && old_iter->first < new_iter->first)) {
+			delta.device_options.push_back(old_iter->first);  // removed
+			++old_iter;
+		} else if (old_iter == old_map.cend() || new_iter->first < old_iter->first) {
+			delta.device_options.push_back(new_iter->first);  // added
+			++new_iter;
+		} else {
+			if (old_iter->second != new_iter->second) {
+				delta.device_options.push_back(new_iter->first);  // changed
+			}
+			++old_iter;
+			++new_iter;
+		}
+	}
+	return delta;
+}
+
+
+
+bool app_device_options_key_matches(const AppDeviceWithType& key, const std::string& dev, const std::string& type_arg)
+{
+	return !dev.empty() && key.first == dev && key.second == type_arg;
+}
+
+
+
+
+/// @}
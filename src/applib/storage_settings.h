@@ -14,7 +14,9 @@ Copyright:
 
 #include <string>
 #include <map>
+#include <optional>
 #include <utility>
+#include <vector>
 
 #include "rconfig/rconfig.h"
 
@@ -83,28 +85,65 @@ inline AppDeviceOptionMap app_config_get_device_option_map()
 
 
 
-/// Read device option map from config and get the options for (dev, type_arg) pair.
-inline std::vector<std::string> app_get_device_options(const std::string& dev, const std::string& type_arg)
-{
-	if (dev.empty())
-		return {};
+/// Get the options for (dev, type_arg) pair from the device option map in config.
+/// The map is decoded (and the options parsed) once per config change,
+/// so this is a single lookup in the common case. Unparsable options are ignored.
+[[nodiscard]] std::vector<std::string> app_get_device_options(const std::string& dev, const std::string& type_arg);
 
-	auto devmap = app_config_get_device_option_map().value;
-	if (auto iter = devmap.find(std::pair(dev, type_arg)); iter != devmap.end()) {
-		if (iter->second.empty()) {
-			return {};
-		}
-		try {
-			return Glib::shell_parse_argv(iter->second);
-		}
-		catch(Glib::ShellError& e)
-		{
-			// TODO report error
-			return {};
-		}
+
+
+/// Get the parsed default smartctl options ("system/smartctl_options"), cached the same
+/// way as app_get_device_options(). \return std::nullopt if the options cannot be parsed.
+[[nodiscard]] std::optional<std::vector<std::string>> app_get_smartctl_default_options();
+
+
+
+
+/// The settings which affect the detected drives and their icons.
+/// Taken before and after the preferences are changed, see app_drive_settings_compare().
+struct AppDriveSettings {
+	std::string smartctl_binary;  ///< "system/smartctl_binary"
+	std::string smartctl_options;  ///< "system/smartctl_options"
+	bool win32_search_smartctl_in_smartmontools = false;  ///< "system/win32_search_smartctl_in_smartmontools"
+	std::string blacklist_patterns;  ///< "system/device_blacklist_patterns"
+	AppDeviceOptionMap device_options;  ///< "system/smartctl_device_options"
+	bool show_smart_capable_only = false;  ///< "gui/show_smart_capable_only"
+	bool icons_show_device_name = false;  ///< "gui/icons_show_device_name"
+	bool icons_show_serial_number = false;  ///< "gui/icons_show_serial_number"
+
+	/// Read the settings from config
+	[[nodiscard]] static AppDriveSettings get_current();
+};
+
+
+
+/// What has to be done to apply a change of AppDriveSettings to the detected drives
+struct AppDriveSettingsDelta {
+	bool rescan = false;  ///< All the drives have to be detected again (the smartctl binary or its default options changed)
+	bool blacklist = false;  ///< The blacklist patterns have to be re-applied to the detected drives
+	bool visibility = false;  ///< The set of shown drives changed ("SMART-capable only")
+	bool icon_text = false;  ///< The text under the icons changed
+	std::vector<AppDeviceWithType> device_options;  ///< Per-device option keys which were added, changed or removed
+
+	/// Check whether nothing has to be done
+	[[nodiscard]] bool is_empty() const
+	{
+		return !rescan && !blacklist && !visibility && !icon_text && device_options.empty();
 	}
-	return {};
-}
+};
+
+
+
+/// Compute what has to be done to apply the new settings
+[[nodiscard]] AppDriveSettingsDelta app_drive_settings_compare(const AppDriveSettings& old_settings,
+		const AppDriveSettings& new_settings);
+
+
+
+/// Check whether the per-device options of \c key (see AppDeviceOptionMap) apply to
+/// a drive, the same way app_get_device_options() looks them up.
+[[nodiscard]] bool app_device_options_key_matches(const AppDeviceWithType& key,
+		const std::string& dev, const std::string& type_arg);
 
 
 
@@ -0,0 +1,307 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>  // std::get_time
+#include <limits>
+#include <locale>
+#include <sstream>
+
+#include "nlohmann/json.hpp"
+
+#include "hz/debug.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+
+#include "storage_smartd_attrlog.h"
+
+
+
+namespace {
+
+	/// Version of the state file format. Files with a different version are ignored.
+	constexpr int attrlog_state_format_version = 1;
+
+	/// Maximum state file size to load
+	constexpr int attrlog_state_max_size = 1024*1024;  // 1M
+
+	/// Size of the blocks the logs are read in
+	constexpr std::size_t attrlog_read_block_size = 256*1024;
+
+
+	/// Parse the local time written by smartd ("2024-01-15 10:30:00")
+	std::optional<std::int64_t> attrlog_parse_time(std::string_view str)
+	{
+		// std::get_time() doesn't fail on a truncated string, check the size of the zero-padded fields instead.
+		if (str.size() != std::string_view("YYYY-MM-DD HH:MM:SS").size()) {
+			return std::nullopt;
+		}
+		std::tm tm = {};
+		std::istringstream iss {std::string(str)};
+		iss.imbue(std::locale::classic());
+		iss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+		if (iss.fail()) {
+			return std::nullopt;
+		}
+		tm.tm_isdst = -1;  // let mktime() figure it out
+		const std::time_t time = std::mktime(&tm);
+		if (time == static_cast<std::time_t>(-1)) {
+			return std::nullopt;
+		}
+		return static_cast<std::int64_t>(time);
+	}
+
+}
+
+
+
+std::optional<StorageSmartdAttrlogSample> storage_smartd_attrlog_parse_line(std::string_view line)
+{
+	line = hz::string_trim_view(line);
+	const auto time_end = line.find(';');
+	if (time_end == std::string_view::npos) {
+		return std::nullopt;
+	}
+	const auto time = attrlog_parse_time(line.substr(0, time_end));
+	if (!time.has_value()) {
+		return std::nullopt;
+	}
+
+	StorageSmartdAttrlogSample sample;
+	sample.time = time.value();
+
+	// Each attribute is "\t<id>;<normalized>;<raw>;"
+	for (std::string_view field : hz::string_split_view(line.substr(time_end + 1), '\t', true)) {
+		std::vector<std::string> parts;
+		hz::string_split(hz::string_trim_view(field), ';', parts, true);
+		std::int32_t id = 0, value = 0;
+		std::uint64_t raw = 0;
+		if (parts.size() != 3 || !hz::string_is_numeric_nolocale(parts[0], id, true, 10)
+				|| !hz::string_is_numeric_nolocale(parts[1], value, true, 10)
+				|| !hz::string_is_numeric_nolocale(parts[2], raw, true, 10)) {
+			continue;  // SCSI counters
+		}
+		const std::string prefix = "ata_attr/" + hz::number_to_string_nolocale(id);
+		sample.values.emplace_back(prefix + "/raw", static_cast<std::int64_t>(raw));  // 48 bits
+		sample.values.emplace_back(prefix + "/value", value);
+	}
+
+	if (sample.values.empty()) {
+		return std::nullopt;
+	}
+	return sample;
+}
+
+
+
+std::string storage_smartd_attrlog_get_drive_id(std::string_view model, std::string_view serial)
+{
+	auto sanitize = [](std::string_view str) {
+		std::string result(str);
+		for (char& c : result) {
+			if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) {
+				c = '_';
+			}
+		}
+		return result;
+	};
+	return sanitize(model) + "-" + sanitize(serial);
+}
+
+
+
+StorageSmartdAttrlogImporter::StorageSmartdAttrlogImporter(std::shared_ptr<StorageHistory> history,
+		std::string log_prefix, hz::fs::path state_file)
+		: history_(std::move(history)), log_prefix_(std::move(log_prefix)), state_file_(std::move(state_file))
+{ }
+
+
+
+std::error_code StorageSmartdAttrlogImporter::load()
+{
+	offsets_.clear();
+
+	std::error_code ec;
+	if (!hz::fs::exists(state_file_, ec)) {
+		return {};
+	}
+	std::string contents;
+	if (auto read_ec = hz::fs_file_get_contents(state_file_, contents, attrlog_state_max_size)) {
+		return read_ec;
+	}
+
+	const nlohmann::json doc = nlohmann::json::parse(contents, nullptr, false);
+	if (!doc.is_object() || doc.value("format_version", 0) != attrlog_state_format_version
+			|| !doc.contains("files") || !doc["files"].is_object()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "smartd attribute log import state file \"" << hz::fs_path_to_string(state_file_)
+				<< "\" has invalid format, ignoring.\n");
+		return {};
+	}
+	for (const auto& [file, offset] : doc["files"].items()) {
+		if (offset.is_number_unsigned()) {
+			offsets_[file] = offset.get<std::uintmax_t>();
+		}
+	}
+	return {};
+}
+
+
+
+std::error_code StorageSmartdAttrlogImporter::import(const std::vector<StorageDevicePtr>& drives)
+{
+	std::vector<std::pair<std::string, std::string>> model_serials;
+	for (const auto& drive : drives) {
+		if (drive && !drive->get_is_virtual() && !drive->get_serial_number().empty()) {
+			model_serials.emplace_back(drive->get_model_name(), drive->get_serial_number());
+		}
+	}
+	return import(model_serials);
+}
+
+
+
+std::error_code StorageSmartdAttrlogImporter::import(const std::vector<std::pair<std::string, std::string>>& model_serials)
+{
+	imported_count_ = 0;
+	if (!history_ || log_prefix_.empty()) {
+		return {};
+	}
+
+	std::error_code import_ec;
+	bool changed = false;
+	for (const auto& [model, serial] : model_serials) {
+		const std::string file_str = log_prefix_ + storage_smartd_attrlog_get_drive_id(model, serial) + ".ata.csv";
+		const hz::fs::path file = hz::fs_path_from_string(file_str);
+		std::error_code ec;
+		if (serial.empty() || !hz::fs::exists(file, ec)) {
+			continue;
+		}
+		std::uintmax_t& offset = offsets_[file_str];
+		const std::uintmax_t old_offset = offset;
+		import_ec = import_file(file, serial, offset);
+		changed = changed || (offset != old_offset);
+		if (import_ec) {
+			break;
+		}
+	}
+
+	if (changed) {
+		if (auto save_ec = save(); save_ec && !import_ec) {
+			return save_ec;
+		}
+	}
+	return import_ec;
+}
+
+
+
+std::size_t StorageSmartdAttrlogImporter::get_imported_count() const
+{
+	return imported_count_;
+}
+
+
+
+hz::fs::path StorageSmartdAttrlogImporter::get_default_state_file()
+{
+	return hz::fs_get_user_config_dir() / "gsmartcontrol" / "smartd_attrlog_import.json";
+}
+
+
+
+std::error_code StorageSmartdAttrlogImporter::import_file(const hz::fs::path& file, const std::string& serial, std::uintmax_t& offset)
+{
+	std::error_code ec;
+	const std::uintmax_t size = hz::fs::file_size(file, ec);
+	if (ec) {
+		return ec;
+	}
+	if (size < offset) {  // replaced or truncated, the old lines are skipped by time below
+		offset = 0;
+	}
+	if (size == offset) {
+		return {};
+	}
+
+	std::FILE* f = hz::fs_platform_fopen(file, "rb");
+	if (!f) {
+		return {errno, std::system_category()};
+	}
+	if (hz::fs_platform_fseek(f, offset, SEEK_SET) != 0) {
+		const int error = errno;
+		std::fclose(f);
+		return {error, std::system_category()};
+	}
+
+	std::int64_t last_time = history_->get_last_time(serial).value_or(std::numeric_limits<std::int64_t>::min());
+
+	// Only the complete lines are consumed, a partially written one is read on the next import.
+	std::string pending;
+	std::string block(attrlog_read_block_size, '\0');
+	std::error_code result_ec;
+	while (!result_ec) {
+		const std::size_t read_size = std::fread(block.data(), 1, block.size(), f);
+		if (read_size == 0) {
+			if (std::ferror(f)) {
+				result_ec = {errno, std::system_category()};
+			}
+			break;
+		}
+		pending.append(block.data(), read_size);
+
+		std::size_t line_start = 0;
+		for (std::size_t line_end = pending.find('\n'); line_end != std::string::npos;
+				line_start = line_end + 1, line_end = pending.find('\n', line_start)) {
+			const auto sample = storage_smartd_attrlog_parse_line(std::string_view(pending).substr(line_start, line_end - line_start));
+			if (sample.has_value() && sample->time > last_time) {
+				if (auto append_ec = history_->append(serial, sample->time, sample->values)) {
+					result_ec = append_ec;
+					break;
+				}
+				last_time = sample->time;
+				++imported_count_;
+			}
+			offset += line_end + 1 - line_start;
+		}
+		pending.erase(0, line_start);
+	}
+
+	std::fclose(f);
+	if (!result_ec && imported_count_ > 0) {
+		debug_out_dump("app", DBG_FUNC_MSG << "Imported smartd attribute log \"" << hz::fs_path_to_string(file)
+				<< "\" up to offset " << offset << ".\n");
+	}
+	return result_ec;
+}
+
+
+
+std::error_code StorageSmartdAttrlogImporter::save() const
+{
+	nlohmann::json doc;
+	doc["format_version"] = attrlog_state_format_version;
+	nlohmann::json& files = doc["files"];
+	files = nlohmann::json::object();
+	for (const auto& [file, offset] : offsets_) {
+		files[file] = offset;
+	}
+
+	std::error_code ec;
+	hz::fs::create_directories(state_file_.parent_path(), ec);  // ignore errors, the write will report them
+	return hz::fs_file_put_contents_atomic(state_file_, doc.dump());
+}
+
+
+
+
+/// @}
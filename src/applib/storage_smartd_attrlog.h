@@ -0,0 +1,124 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_SMARTD_ATTRLOG_H
+#define STORAGE_SMARTD_ATTRLOG_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "hz/fs.h"
+
+#include "storage_device.h"
+#include "storage_history.h"
+
+
+
+/*
+smartd started with "-A PREFIX" appends a line to "PREFIX<model>-<serial>.ata.csv" after each
+check of an ATA drive (every 30 minutes by default). In the file name, all the characters of
+the model and the serial number except the ASCII letters and digits are replaced by "_".
+Each line is the local time, followed by a tab-separated triplet per attribute:
+
+2024-01-15 10:30:00;	1;200;0;	5;200;0;	9;97;2513;	194;117;33;
+
+SCSI drives have "<name>;<value>;" pairs instead of the triplets. They are ignored.
+*/
+
+
+
+/// A line of a smartd attribute log
+struct StorageSmartdAttrlogSample {
+	std::int64_t time = 0;  ///< Sample time, seconds since epoch
+	StorageHistoryValues values;  ///< "ata_attr/<id>/value" and "ata_attr/<id>/raw" values, as in StorageHistory
+};
+
+
+
+/// Parse a line of a smartd attribute log. \return std::nullopt if it's not a valid line
+/// or has no ATA attributes.
+[[nodiscard]] std::optional<StorageSmartdAttrlogSample> storage_smartd_attrlog_parse_line(std::string_view line);
+
+
+/// Get the part of the attribute log file name which identifies the drive ("<model>-<serial>"),
+/// with the characters replaced the way smartd does it.
+[[nodiscard]] std::string storage_smartd_attrlog_get_drive_id(std::string_view model, std::string_view serial);
+
+
+
+/// Imports the smartd attribute logs into the history store incrementally. The read offset
+/// of each file is kept in a state file, so that each line is read once. The files are matched
+/// to the drives by model and serial number. The files of the drives which are not known yet
+/// are not read, so that they can be imported when the drives appear.
+/// The lines which are not newer than the last history sample of the drive are skipped,
+/// since the history only accepts appended samples.
+class StorageSmartdAttrlogImporter {
+	public:
+
+		/// Constructor. \c log_prefix is the "-A" argument of smartd.
+		/// Call load() afterwards.
+		StorageSmartdAttrlogImporter(std::shared_ptr<StorageHistory> history, std::string log_prefix, hz::fs::path state_file);
+
+
+		/// Load the read offsets from the state file. A missing or broken file is not an error,
+		/// the files are then read from the beginning.
+		[[nodiscard]] std::error_code load();
+
+
+		/// Import the new lines of the logs of the drives, then save the read offsets.
+		/// Virtual drives and drives without a serial number are skipped.
+		[[nodiscard]] std::error_code import(const std::vector<StorageDevicePtr>& drives);
+
+
+		/// Same as above, but with (model, serial) pairs.
+		[[nodiscard]] std::error_code import(const std::vector<std::pair<std::string, std::string>>& model_serials);
+
+
+		/// Get the number of samples appended to the history by the last import() call.
+		[[nodiscard]] std::size_t get_imported_count() const;
+
+
+		/// Get the default state file ("$HOME/.config/gsmartcontrol/smartd_attrlog_import.json" in UNIX).
+		[[nodiscard]] static hz::fs::path get_default_state_file();
+
+
+	private:
+
+		/// Read the new complete lines of a file and append them to the history
+		std::error_code import_file(const hz::fs::path& file, const std::string& serial, std::uintmax_t& offset);
+
+		/// Write the offsets to the state file
+		std::error_code save() const;
+
+
+		std::shared_ptr<StorageHistory> history_;  ///< History store to append to
+		std::string log_prefix_;  ///< smartd attribute log prefix
+		hz::fs::path state_file_;  ///< State file with the read offsets
+		std::map<std::string, std::uintmax_t> offsets_;  ///< File name -> read offset
+		std::size_t imported_count_ = 0;  ///< Samples appended by the last import()
+
+};
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,265 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <tuple>
+
+#include "fmt/format.h"
+#include "hz/debug.h"
+#include "nlohmann/json.hpp"
+
+#include "storage_property_snapshot.h"
+#include "storage_snapshot_index.h"
+
+
+
+namespace {
+
+	/// Version of the index file format
+	constexpr int snapshot_index_format_version = 1;
+
+
+	/// Maximum snapshot size we read
+	constexpr std::uintmax_t snapshot_max_size = 64UL * 1024UL * 1024UL;
+
+
+	/// Get a string property value, empty if there is none
+	std::string snapshot_get_string_property(const StoragePropertyRepository& repository, const std::string& generic_name)
+	{
+		if (const auto* p = repository.find_property(generic_name); p && p->is_value_type<std::string>()) {
+			return p->get_value<std::string>();
+		}
+		return {};
+	}
+
+
+	/// Read and load a snapshot file
+	hz::ExpectedValue<StoragePropertyRepository, StorageSnapshotIndexError> snapshot_read_file(const hz::fs::path& file)
+	{
+		std::string data;
+		if (auto ec = hz::fs_file_get_contents(file, data, snapshot_max_size)) {
+			return hz::Unexpected(StorageSnapshotIndexError::ReadError,
+					fmt::format(fmt::runtime(_("Cannot read \"{}\": {}")), hz::fs_path_to_string(file), ec.message()));
+		}
+		auto repository = storage_property_snapshot_load(data);
+		if (!repository) {
+			return hz::Unexpected(StorageSnapshotIndexError::InvalidSnapshot,
+					fmt::format(fmt::runtime(_("Cannot load \"{}\": {}")), hz::fs_path_to_string(file), repository.error().message()));
+		}
+		return std::move(repository.value());
+	}
+
+}
+
+
+
+StorageSnapshotIndex::StorageSnapshotIndex(std::size_t max_loaded)
+		: max_loaded_(std::max<std::size_t>(max_loaded, 2))  // at least the two compared ones
+{ }
+
+
+
+hz::ExpectedVoid<StorageSnapshotIndexError> StorageSnapshotIndex::scan(const hz::fs::path& dir, std::vector<std::string>& errors)
+{
+	dir_ = dir;
+	entries_.clear();
+	loaded_.clear();
+
+	std::map<hz::fs::path, StorageSnapshotIndexEntry> indexed;
+	for (auto& entry : read_index_file()) {
+		auto file = entry.file;
+		indexed.emplace(std::move(file), std::move(entry));
+	}
+
+	std::error_code ec;
+	bool changed = false;
+	for (const auto& dir_entry : hz::fs::directory_iterator(dir_, ec)) {
+		std::error_code entry_ec;
+		if (!dir_entry.is_regular_file(entry_ec) || dir_entry.path().extension() != ".snapshot") {
+			continue;
+		}
+		StorageSnapshotIndexEntry entry;
+		entry.file = dir_entry.path().filename();
+		entry.file_size = dir_entry.file_size(entry_ec);
+		const auto mtime = dir_entry.last_write_time(entry_ec);
+		if (entry_ec) {
+			errors.push_back(fmt::format(fmt::runtime(_("Cannot read \"{}\": {}")),
+					hz::fs_path_to_string(dir_entry.path()), entry_ec.message()));
+			continue;
+		}
+		entry.file_mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+		entry.time = std::chrono::duration_cast<std::chrono::seconds>(
+				std::chrono::file_clock::to_sys(mtime).time_since_epoch()).count();
+
+		// Unchanged since the last scan, no need to read it
+		if (auto iter = indexed.find(entry.file); iter != indexed.end()
+				&& iter->second.file_size == entry.file_size && iter->second.file_mtime == entry.file_mtime) {
+			entries_.push_back(std::move(iter->second));
+			continue;
+		}
+
+		auto repository = snapshot_read_file(dir_entry.path());
+		if (!repository) {
+			errors.push_back(repository.error().message());
+			continue;
+		}
+		entry.serial = snapshot_get_string_property(repository.value(), "serial_number");
+		entry.model = snapshot_get_string_property(repository.value(), "model_name");
+		if (entry.model.empty()) {
+			entry.model = snapshot_get_string_property(repository.value(), "scsi_model_name");
+		}
+		entries_.push_back(std::move(entry));
+		changed = true;
+	}
+	if (ec) {
+		return hz::Unexpected(StorageSnapshotIndexError::ReadError,
+				fmt::format(fmt::runtime(_("Cannot read directory \"{}\": {}")), hz::fs_path_to_string(dir_), ec.message()));
+	}
+
+	std::sort(entries_.begin(), entries_.end(), [](const StorageSnapshotIndexEntry& a, const StorageSnapshotIndexEntry& b) {
+		return std::tie(a.serial, a.time, a.file) < std::tie(b.serial, b.time, b.file);
+	});
+
+	// Removed files change the index too
+	if (changed || entries_.size() != indexed.size()) {
+		write_index_file();
+	}
+	debug_out_info("app", DBG_FUNC_MSG << "Indexed " << entries_.size() << " snapshots in " << dir_ << ".\n");
+
+	return {};
+}
+
+
+
+const hz::fs::path& StorageSnapshotIndex::get_directory() const
+{
+	return dir_;
+}
+
+
+
+std::vector<std::string> StorageSnapshotIndex::get_serials() const
+{
+	std::vector<std::string> serials;
+	for (const auto& entry : entries_) {
+		if (serials.empty() || serials.back() != entry.serial) {
+			serials.push_back(entry.serial);
+		}
+	}
+	return serials;
+}
+
+
+
+std::span<const StorageSnapshotIndexEntry> StorageSnapshotIndex::get_entries(const std::string& serial) const
+{
+	const auto begin = std::lower_bound(entries_.begin(), entries_.end(), serial,
+			[](const StorageSnapshotIndexEntry& entry, const std::string& value) { return entry.serial < value; });
+	const auto end = std::upper_bound(begin, entries_.end(), serial,
+			[](const std::string& value, const StorageSnapshotIndexEntry& entry) { return value < entry.serial; });
+	return {begin, end};
+}
+
+
+
+hz::ExpectedValue<std::shared_ptr<const StoragePropertyRepository>, StorageSnapshotIndexError>
+		StorageSnapshotIndex::load(const StorageSnapshotIndexEntry& entry)
+{
+	const hz::fs::path file = dir_ / entry.file;
+
+	auto iter = std::find_if(loaded_.begin(), loaded_.end(), [&file](const auto& loaded) { return loaded.first == file; });
+	if (iter != loaded_.end()) {
+		std::rotate(iter, iter + 1, loaded_.end());  // most recently used
+		return loaded_.back().second;
+	}
+
+	auto repository = snapshot_read_file(file);
+	if (!repository) {
+		return hz::Unexpected(repository.error().data(), repository.error().message());
+	}
+	auto shared_repository = std::make_shared<const StoragePropertyRepository>(std::move(repository.value()));
+	if (loaded_.size() >= max_loaded_) {
+		loaded_.erase(loaded_.begin());
+	}
+	loaded_.emplace_back(file, shared_repository);
+	return shared_repository;
+}
+
+
+
+std::string StorageSnapshotIndex::get_index_file_name()
+{
+	return "snapshot_index.json";
+}
+
+
+
+std::vector<StorageSnapshotIndexEntry> StorageSnapshotIndex::read_index_file() const
+{
+	std::vector<StorageSnapshotIndexEntry> entries;
+	std::string json_str;
+	if (hz::fs_file_get_contents(dir_ / hz::fs_path_from_string(get_index_file_name()), json_str, snapshot_max_size)) {
+		return entries;  // no index yet
+	}
+	const nlohmann::json doc = nlohmann::json::parse(json_str, nullptr, false);
+	if (!doc.is_object() || doc.value("format_version", 0) != snapshot_index_format_version) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Ignoring invalid snapshot index in " << dir_ << ".\n");
+		return entries;
+	}
+	try {
+		for (const auto& j : doc.at("snapshots")) {
+			StorageSnapshotIndexEntry& entry = entries.emplace_back();
+			entry.file = hz::fs_path_from_string(j.at("file").get<std::string>());
+			entry.file_size = j.at("file_size").get<std::uintmax_t>();
+			entry.file_mtime = j.at("file_mtime").get<std::int64_t>();
+			entry.time = j.at("time").get<std::int64_t>();
+			entry.serial = j.value("serial", std::string());
+			entry.model = j.value("model", std::string());
+		}
+	}
+	catch (const nlohmann::json::exception& e) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Ignoring invalid snapshot index in " << dir_ << ": " << e.what() << "\n");
+		entries.clear();
+	}
+	return entries;
+}
+
+
+
+void StorageSnapshotIndex::write_index_file() const
+{
+	nlohmann::json doc;
+	doc["format_version"] = snapshot_index_format_version;
+	nlohmann::json& snapshots = doc["snapshots"] = nlohmann::json::array();
+	for (const auto& entry : entries_) {
+		snapshots.push_back({
+			{"file", hz::fs_path_to_string(entry.file)},
+			{"file_size", entry.file_size},
+			{"file_mtime", entry.file_mtime},
+			{"time", entry.time},
+			{"serial", entry.serial},
+			{"model", entry.model},
+		});
+	}
+	// The directory may be read-only (e.g. an archive), the index is rebuilt each time then.
+	if (auto ec = hz::fs_file_put_contents(dir_ / hz::fs_path_from_string(get_index_file_name()), doc.dump(1, '\t'))) {
+		debug_out_info("app", DBG_FUNC_MSG << "Cannot write snapshot index in " << dir_ << ": " << ec.message() << "\n");
+	}
+}
+
+
+
+
+
+/// @}
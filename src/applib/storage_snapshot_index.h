@@ -0,0 +1,112 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_SNAPSHOT_INDEX_H
+#define STORAGE_SNAPSHOT_INDEX_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hz/error_container.h"
+#include "hz/fs.h"
+
+#include "storage_property_repository.h"
+
+
+
+/// Errors of indexing and loading the property snapshots
+enum class StorageSnapshotIndexError {
+	ReadError,  ///< Cannot read the directory or a file
+	InvalidSnapshot,  ///< Not a snapshot, or written by a different format version
+};
+
+
+
+/// A property snapshot file (see storage_property_snapshot_save()) in the index
+struct StorageSnapshotIndexEntry {
+	hz::fs::path file;  ///< Snapshot file
+	std::uintmax_t file_size = 0;  ///< File size when indexed
+	std::int64_t file_mtime = 0;  ///< File modification time when indexed (file clock ticks)
+	std::int64_t time = 0;  ///< File modification time, seconds since epoch
+	std::string serial;  ///< Drive serial number, may be empty
+	std::string model;  ///< Drive model, may be empty
+};
+
+
+
+/// Index of a directory of property snapshots (e.g. written by gsmartcontrol-reprocess --snapshot-dir),
+/// by drive serial number and time, so that any two snapshots of a drive can be compared
+/// without loading (let alone re-parsing) all of them.
+/// The index is kept in the directory (see get_index_file_name()), so only the new and
+/// changed snapshots are read on the next scan(). The loaded repositories are cached,
+/// the least recently used ones are dropped.
+class StorageSnapshotIndex {
+	public:
+
+		/// Constructor
+		explicit StorageSnapshotIndex(std::size_t max_loaded = 16);
+
+
+		/// Index the "*.snapshot" files in \c dir, replacing the previous index.
+		/// The unreadable snapshots are skipped, with their errors added to \c errors.
+		/// The index file is updated if anything changed (and the directory is writable).
+		hz::ExpectedVoid<StorageSnapshotIndexError> scan(const hz::fs::path& dir, std::vector<std::string>& errors);
+
+		/// Get the indexed directory
+		[[nodiscard]] const hz::fs::path& get_directory() const;
+
+
+		/// Get the serial numbers of the indexed drives, sorted
+		[[nodiscard]] std::vector<std::string> get_serials() const;
+
+		/// Get the snapshots of a drive, oldest first
+		[[nodiscard]] std::span<const StorageSnapshotIndexEntry> get_entries(const std::string& serial) const;
+
+
+		/// Load the properties of a snapshot (or take them from the cache)
+		[[nodiscard]] hz::ExpectedValue<std::shared_ptr<const StoragePropertyRepository>, StorageSnapshotIndexError>
+				load(const StorageSnapshotIndexEntry& entry);
+
+
+		/// Get the name of the index file kept in the snapshot directory
+		[[nodiscard]] static std::string get_index_file_name();
+
+
+	private:
+
+		/// Read the index file of the current directory, returns the entries by file name
+		[[nodiscard]] std::vector<StorageSnapshotIndexEntry> read_index_file() const;
+
+		/// Write the index file of the current directory
+		void write_index_file() const;
+
+
+		std::size_t max_loaded_ = 16;  ///< Maximum number of cached repositories
+		hz::fs::path dir_;  ///< Indexed directory
+		std::vector<StorageSnapshotIndexEntry> entries_;  ///< Entries, sorted by serial and time
+
+		/// Cached repositories, the most recently used last
+		std::vector<std::pair<hz::fs::path, std::shared_ptr<const StoragePropertyRepository>>> loaded_;
+
+};
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,280 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <array>
+#include <cstdint>  // UINT64_MAX
+#include <ctime>
+#include <iterator>  // std::back_inserter
+
+#include "hz/string_num.h"
+
+#include "storage_temperature_history.h"
+#include "storage_hwmon_temperature.h"
+
+
+
+namespace {
+
+	/// Split a line into whitespace-separated tokens
+	std::vector<std::string_view> temperature_split_tokens(std::string_view line)
+	{
+		std::vector<std::string_view> tokens;
+		std::size_t pos = 0;
+		while (pos < line.size()) {
+			const std::size_t begin = line.find_first_not_of(" \t\r", pos);
+			if (begin == std::string_view::npos) {
+				break;
+			}
+			std::size_t end = line.find_first_of(" \t\r", begin);
+			if (end == std::string_view::npos) {
+				end = line.size();
+			}
+			tokens.push_back(line.substr(begin, end - begin));
+			pos = end;
+		}
+		return tokens;
+	}
+
+
+	/// Parse "YYYY-MM-DD" and "HH:MM" as local time
+	std::optional<std::int64_t> temperature_parse_local_time(std::string_view date, std::string_view time)
+	{
+		int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+		if (date.size() != 10 || date[4] != '-' || date[7] != '-' || time.size() != 5 || time[2] != ':'
+				|| !hz::string_is_numeric_nolocale(std::string(date.substr(0, 4)), year, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(date.substr(5, 2)), month, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(date.substr(8, 2)), day, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(time.substr(0, 2)), hour, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(time.substr(3, 2)), minute, false, 10)) {
+			return std::nullopt;
+		}
+		std::tm tm = {};
+		tm.tm_year = year - 1900;
+		tm.tm_mon = month - 1;
+		tm.tm_mday = day;
+		tm.tm_hour = hour;
+		tm.tm_min = minute;
+		tm.tm_isdst = -1;  // let mktime() decide
+		const std::time_t t = std::mktime(&tm);
+		if (t == std::time_t(-1)) {
+			return std::nullopt;
+		}
+		return static_cast<std::int64_t>(t);
+	}
+
+
+	/// Compare points by time
+	inline bool temperature_point_time_less(const StorageHistoryPoint& a, const StorageHistoryPoint& b)
+	{
+		return a.time < b.time;
+	}
+
+}
+
+
+
+std::vector<StorageHistoryPoint> storage_temperature_history_parse_sct_table(std::string_view text)
+{
+	std::vector<StorageHistoryPoint> points;
+
+	// Rows look like " 362    2017-08-29 08:43    38  *******************".
+	// "..." rows (skipped entries with the same temperature) and "?" temperatures are ignored.
+	std::size_t pos = 0;
+	while (pos < text.size()) {
+		std::size_t end = text.find('\n', pos);
+		if (end == std::string_view::npos) {
+			end = text.size();
+		}
+		const std::string_view line = text.substr(pos, end - pos);
+		pos = end + 1;
+
+		const auto tokens = temperature_split_tokens(line);
+		if (tokens.size() < 4) {
+			continue;
+		}
+		std::uint32_t index = 0;
+		std::int64_t value = 0;
+		if (!hz::string_is_numeric_nolocale(std::string(tokens[0]), index, false, 10)
+				|| !hz::string_is_numeric_nolocale(std::string(tokens[3]), value, false, 10)) {
+			continue;
+		}
+		if (auto time = temperature_parse_local_time(tokens[1], tokens[2])) {
+			points.push_back({time.value(), value});
+		}
+	}
+
+	std::stable_sort(points.begin(), points.end(), &temperature_point_time_less);
+	return points;
+}
+
+
+
+std::vector<StorageHistoryPoint> storage_temperature_history_get_sct_samples(const StoragePropertyRepository& properties)
+{
+	const StorageProperty* p = properties.find_property("ata_sct_temperature_history/table", StoragePropertySection::TemperatureLog);
+	if (!p || !p->is_value_type<AtaStorageTemperatureHistory>()) {
+		return {};
+	}
+	const auto& history = p->get_value<AtaStorageTemperatureHistory>();
+	std::vector<StorageHistoryPoint> points;
+	points.reserve(history.get_known_count());
+	history.for_each_known_sample([&points](std::int64_t time, std::int8_t temperature) {
+		points.push_back({time, temperature});
+	});
+	return points;
+}
+
+
+
+std::vector<StorageHistoryPoint> storage_temperature_history_get_stored_samples(
+		const StorageHistory& history, const std::string& serial, std::int64_t from, std::int64_t to)
+{
+	// Most accurate first. The attribute raw values may contain min / max temperatures in the upper bytes.
+	static const std::array<std::pair<std::string_view, bool>, 4> keys = {{
+			{"ata_stat/5/8", false},  // Current Temperature statistic
+			{"nvme/nvme_smart_health_information_log/temperature", false},
+			{"ata_attr/194/raw", true},
+			{"ata_attr/190/raw", true},
+	}};
+
+	// The hwmon samples are taken much more often than smartctl runs, between them
+	const std::vector<StorageHistoryPoint> hwmon_points = history.get_series(serial, storage_hwmon_history_key, from, to);
+
+	for (const auto& [key, is_attribute_raw] : keys) {
+		auto points = history.get_series(serial, std::string(key), from, to);
+		if (points.empty()) {
+			continue;
+		}
+		if (is_attribute_raw) {
+			for (auto& point : points) {
+				point.value &= 0xffff;
+			}
+			std::erase_if(points, [](const StorageHistoryPoint& point) { return point.value > 200; });
+		}
+		return storage_temperature_history_merge(points, hwmon_points);
+	}
+	return hwmon_points;
+}
+
+
+
+std::vector<StorageHistoryPoint> storage_temperature_history_merge(
+		const std::vector<StorageHistoryPoint>& a, const std::vector<StorageHistoryPoint>& b)
+{
+	std::vector<StorageHistoryPoint> result;
+	result.reserve(a.size() + b.size());
+	std::merge(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result), &temperature_point_time_less);
+	return result;
+}
+
+
+
+void StorageTemperatureBuckets::reset(std::int64_t from, std::int64_t to, std::size_t count)
+{
+	from_ = from;
+	to_ = std::max(from, to);
+	buckets_.assign(count, StorageTemperatureBucket());
+}
+
+
+
+std::optional<std::size_t> StorageTemperatureBuckets::add(const StorageHistoryPoint& point)
+{
+	const auto index = get_bucket_index(point.time);
+	if (!index.has_value()) {
+		return std::nullopt;
+	}
+	auto& bucket = buckets_[index.value()];
+	if (!bucket.has_data) {
+		bucket.min = point.value;
+		bucket.max = point.value;
+		bucket.has_data = true;
+	} else {
+		bucket.min = std::min(bucket.min, point.value);
+		bucket.max = std::max(bucket.max, point.value);
+	}
+	return index;
+}
+
+
+
+void StorageTemperatureBuckets::add(const std::vector<StorageHistoryPoint>& points)
+{
+	for (const auto& point : points) {
+		add(point);
+	}
+}
+
+
+
+std::optional<std::size_t> StorageTemperatureBuckets::get_bucket_index(std::int64_t time) const
+{
+	if (buckets_.empty() || time < from_ || time > to_) {
+		return std::nullopt;
+	}
+	// The range is inclusive, so it spans (to - from + 1) seconds.
+	const auto span = static_cast<std::uint64_t>(to_ - from_) + 1;
+	const auto offset = static_cast<std::uint64_t>(time - from_);
+	// Multiplication may overflow for very large ranges, divide first in that case.
+	std::uint64_t index = 0;
+	if (offset <= UINT64_MAX / buckets_.size()) {
+		index = offset * buckets_.size() / span;
+	} else {
+		index = offset / (span / buckets_.size() + 1);
+	}
+	return std::min(static_cast<std::size_t>(index), buckets_.size() - 1);
+}
+
+
+
+const std::vector<StorageTemperatureBucket>& StorageTemperatureBuckets::get_buckets() const
+{
+	return buckets_;
+}
+
+
+
+std::int64_t StorageTemperatureBuckets::get_from() const
+{
+	return from_;
+}
+
+
+
+std::int64_t StorageTemperatureBuckets::get_to() const
+{
+	return to_;
+}
+
+
+
+std::optional<std::pair<std::int64_t, std::int64_t>> StorageTemperatureBuckets::get_value_range() const
+{
+	std::optional<std::pair<std::int64_t, std::int64_t>> range;
+	for (const auto& bucket : buckets_) {
+		if (!bucket.has_data) {
+			continue;
+		}
+		if (!range.has_value()) {
+			range = std::pair(bucket.min, bucket.max);
+		} else {
+			range->first = std::min(range->first, bucket.min);
+			range->second = std::max(range->second, bucket.max);
+		}
+	}
+	return range;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,115 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_TEMPERATURE_HISTORY_H
+#define STORAGE_TEMPERATURE_HISTORY_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "storage_history.h"
+#include "storage_property_repository.h"
+
+
+
+/// Parse the SCT temperature history table ("Index  Estimated Time  Temperature Celsius")
+/// of smartctl text output. The estimated times are in local time. The unknown ("?")
+/// temperatures and the skipped-rows markers are ignored. The points are sorted by time.
+[[nodiscard]] std::vector<StorageHistoryPoint> storage_temperature_history_parse_sct_table(std::string_view text);
+
+
+/// Get the SCT temperature history samples from the parsed properties of a drive
+/// (the AtaStorageTemperatureHistory property), sorted by time
+[[nodiscard]] std::vector<StorageHistoryPoint> storage_temperature_history_get_sct_samples(
+		const StoragePropertyRepository& properties);
+
+
+/// Get the temperature samples of a drive recorded in the history store, in [from, to] time range.
+/// The first available series of ATA statistics, NVMe health log and ATA attributes 194 / 190 is used,
+/// merged with the hwmon samples (see StorageHwmonTemperatureMonitor).
+[[nodiscard]] std::vector<StorageHistoryPoint> storage_temperature_history_get_stored_samples(
+		const StorageHistory& history, const std::string& serial, std::int64_t from, std::int64_t to);
+
+
+/// Merge sorted sample lists, keeping the result sorted by time
+[[nodiscard]] std::vector<StorageHistoryPoint> storage_temperature_history_merge(
+		const std::vector<StorageHistoryPoint>& a, const std::vector<StorageHistoryPoint>& b);
+
+
+
+/// A bucket of StorageTemperatureBuckets (a pixel column of a graph)
+struct StorageTemperatureBucket {
+	std::int64_t min = 0;  ///< Minimum value in the bucket
+	std::int64_t max = 0;  ///< Maximum value in the bucket
+	bool has_data = false;  ///< Whether the bucket has any samples
+};
+
+
+
+/// Min/max-per-bucket downsampling of a time series. With one bucket per pixel column,
+/// drawing a graph of months of 1-minute samples is O(width). Adding a sample which
+/// falls into the range updates a single bucket, so the graph can be redrawn incrementally.
+class StorageTemperatureBuckets {
+	public:
+
+		/// Set the time range [from, to] and the number of buckets. This clears the buckets.
+		void reset(std::int64_t from, std::int64_t to, std::size_t count);
+
+
+		/// Add a sample. \return the index of the updated bucket, or std::nullopt if the sample is outside the range.
+		std::optional<std::size_t> add(const StorageHistoryPoint& point);
+
+
+		/// Add samples
+		void add(const std::vector<StorageHistoryPoint>& points);
+
+
+		/// Get the bucket index of a time point, std::nullopt if outside the range.
+		[[nodiscard]] std::optional<std::size_t> get_bucket_index(std::int64_t time) const;
+
+
+		/// Get the buckets
+		[[nodiscard]] const std::vector<StorageTemperatureBucket>& get_buckets() const;
+
+
+		/// Get the start of the time range
+		[[nodiscard]] std::int64_t get_from() const;
+
+
+		/// Get the end of the time range
+		[[nodiscard]] std::int64_t get_to() const;
+
+
+		/// Get the minimum and maximum values of all the buckets, std::nullopt if there is no data.
+		[[nodiscard]] std::optional<std::pair<std::int64_t, std::int64_t>> get_value_range() const;
+
+
+	private:
+
+		std::int64_t from_ = 0;  ///< Start of the time range
+		std::int64_t to_ = 0;  ///< End of the time range
+		std::vector<StorageTemperatureBucket> buckets_;  ///< Buckets
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
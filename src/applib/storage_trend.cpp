@@ -0,0 +1,201 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <array>
+#include <cmath>
+#include <map>
+
+#include "fmt/format.h"
+#include "hz/string_num.h"
+#include "storage_property.h"
+#include "storage_trend.h"
+
+
+
+namespace {
+
+	/// Kind of a tracked series
+	enum class TrendKind {
+		ErrorCounter,  ///< Error counter, repeated increases mean a failing drive
+		CableErrorCounter,  ///< Interface error counter, repeated increases mean a bad cable or connector
+		WearPercentage,  ///< Wear percentage, the failure is expected at 100
+	};
+
+
+	/// A tracked series
+	struct TrendSeries {
+		std::string_view key;  ///< Series key
+		TrendKind kind;  ///< Kind
+	};
+
+
+	/// Tracked series
+	constexpr std::array trend_series = {
+		TrendSeries{"ata_attr/5/raw", TrendKind::ErrorCounter},  // Reallocated Sector Count
+		TrendSeries{"ata_attr/197/raw", TrendKind::ErrorCounter},  // Current Pending Sector Count
+		TrendSeries{"ata_attr/198/raw", TrendKind::ErrorCounter},  // Offline Uncorrectable
+		TrendSeries{"ata_attr/199/raw", TrendKind::CableErrorCounter},  // UDMA CRC Error Count
+		TrendSeries{"nvme/nvme_smart_health_information_log/media_errors", TrendKind::ErrorCounter},
+		TrendSeries{"nvme/nvme_smart_health_information_log/percentage_used", TrendKind::WearPercentage},
+	};
+
+
+	/// An error counter whose decayed number of increases reaches this is a trend
+	/// (e.g. two increases within about three weeks).
+	constexpr double trend_min_recent_increases = 1.5;
+
+	/// Warn if the projected wear reaches 100% in this many days...
+	constexpr double trend_wear_warning_days = 90.;
+
+	/// ...or a notice in this many days
+	constexpr double trend_wear_notice_days = 365.;
+
+
+	/// Get the kind of a tracked series
+	std::optional<TrendKind> get_trend_kind(std::string_view key)
+	{
+		for (const auto& series : trend_series) {
+			if (series.key == key) {
+				return series.kind;
+			}
+		}
+		return std::nullopt;
+	}
+
+
+	/// Get the history series key of a property, if it may be tracked
+	std::optional<std::string> get_property_series_key(const StorageProperty& p)
+	{
+		if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()) {
+			return "ata_attr/" + hz::number_to_string_nolocale(p.get_value<AtaStorageAttribute>().id) + "/raw";
+		}
+		if (p.section == StoragePropertySection::NvmeAttributes && p.is_value_type<std::int64_t>()) {
+			return "nvme/" + p.generic_name;
+		}
+		return std::nullopt;
+	}
+
+}
+
+
+
+void StorageTrend::add(std::int64_t time, std::int64_t value)
+{
+	if (samples == 0) {
+		last_time = time;
+		last_value = value;
+		samples = 1;
+		return;
+	}
+
+	const auto dt = static_cast<double>(time - last_time);
+	const double decay = (dt > 0 ? std::exp(-dt / static_cast<double>(storage_trend_time_constant_sec)) : 1.);
+	recent_increases *= decay;
+	if (value > last_value) {
+		++increases;
+		recent_increases += 1.;
+	}
+	// The samples taken at the same time have no rate
+	if (dt > 0) {
+		const double rate = static_cast<double>(value - last_value) / dt * 86400.;
+		slope_per_day = decay * slope_per_day + (1. - decay) * rate;
+	}
+
+	last_time = time;
+	last_value = value;
+	++samples;
+}
+
+
+
+bool storage_trend_is_tracked(std::string_view key)
+{
+	return get_trend_kind(key).has_value();
+}
+
+
+
+std::pair<WarningLevel, std::string> storage_trend_get_warning(std::string_view key, const StorageTrend& trend)
+{
+	const auto kind = get_trend_kind(key);
+	if (!kind.has_value() || trend.samples < 2) {
+		return {WarningLevel::None, {}};
+	}
+
+	switch (kind.value()) {
+		case TrendKind::ErrorCounter:
+			if (trend.recent_increases >= trend_min_recent_increases) {
+				return {WarningLevel::Warning, fmt::format("The value has been increasing recently ({} times, about {:.1f} per day). The drive may be failing.",
+						static_cast<std::uint64_t>(std::lround(trend.recent_increases)), trend.slope_per_day)};
+			}
+			break;
+		case TrendKind::CableErrorCounter:
+			if (trend.recent_increases >= trend_min_recent_increases) {
+				return {WarningLevel::Notice, fmt::format("The value has been increasing recently ({} times). Check the cable and the connectors.",
+						static_cast<std::uint64_t>(std::lround(trend.recent_increases)))};
+			}
+			break;
+		case TrendKind::WearPercentage:
+			if (trend.slope_per_day > 0 && trend.last_value < 100) {
+				const double days_left = static_cast<double>(100 - trend.last_value) / trend.slope_per_day;
+				if (days_left < trend_wear_notice_days) {
+					return {days_left < trend_wear_warning_days ? WarningLevel::Warning : WarningLevel::Notice,
+							fmt::format("At the current rate, the drive will reach its rated endurance in about {} days.",
+							static_cast<std::int64_t>(days_left))};
+				}
+			}
+			break;
+	}
+	return {WarningLevel::None, {}};
+}
+
+
+
+bool storage_trend_apply_warnings(StoragePropertyRepository& properties,
+		const std::vector<std::pair<std::string, StorageTrend>>& trends)
+{
+	if (trends.empty()) {
+		return false;
+	}
+	const std::map<std::string_view, const StorageTrend*> trends_by_key = [&trends]() {
+		std::map<std::string_view, const StorageTrend*> m;
+		for (const auto& [key, trend] : trends) {
+			m.emplace(key, &trend);
+		}
+		return m;
+	}();
+
+	bool raised = false;
+	for (auto& p : properties.get_properties_ref()) {
+		const auto key = get_property_series_key(p);
+		if (!key.has_value()) {
+			continue;
+		}
+		auto iter = trends_by_key.find(key.value());
+		if (iter == trends_by_key.end()) {
+			continue;
+		}
+		auto [level, reason] = storage_trend_get_warning(key.value(), *iter->second);
+		if (level > p.warning_level) {
+			p.warning_level = level;
+			p.warning_reason = std::move(reason);  // shown in the description by get_description()
+			raised = true;
+		}
+	}
+	return raised;
+}
+
+
+
+
+
+
+/// @}
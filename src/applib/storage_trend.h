@@ -0,0 +1,73 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_TREND_H
+#define STORAGE_TREND_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "storage_property_repository.h"
+#include "warning_level.h"
+
+
+
+/// Time constant of the trend estimators: the older samples weigh exp(-age / tau) as much.
+constexpr std::int64_t storage_trend_time_constant_sec = 30 * 24 * 3600;  // 30 days
+
+
+
+/// Online trend estimate of a history series. Each sample updates it in O(1) time
+/// without looking at the previous samples.
+struct StorageTrend {
+
+	/// Add a sample. The samples must be added in time order.
+	void add(std::int64_t time, std::int64_t value);
+
+
+	std::int64_t last_time = 0;  ///< Time of the last sample
+	std::int64_t last_value = 0;  ///< Value of the last sample
+	std::uint64_t samples = 0;  ///< Number of samples
+	double slope_per_day = 0;  ///< Exponentially weighted moving average of the rate of change, per day
+	std::uint64_t increases = 0;  ///< Number of samples where the value increased (change points)
+	double recent_increases = 0;  ///< Same, with the older increases decayed (see storage_trend_time_constant_sec)
+
+};
+
+
+
+/// Check if the trend of a history series (see StorageHistory::get_values_from_properties())
+/// is estimated: reallocated, pending and offline uncorrectable sectors, CRC errors,
+/// NVMe media errors and percentage used.
+[[nodiscard]] bool storage_trend_is_tracked(std::string_view key);
+
+
+/// Get the warning of a trend of a tracked series, if it signals a coming failure.
+/// \return (level, reason), level is None if there's nothing to warn about.
+[[nodiscard]] std::pair<WarningLevel, std::string> storage_trend_get_warning(std::string_view key, const StorageTrend& trend);
+
+
+/// Raise the warnings of the properties whose trends (by series key) signal a coming failure.
+/// The warnings are never lowered, so the static thresholds still apply.
+/// \return true if any warning was raised.
+bool storage_trend_apply_warnings(StoragePropertyRepository& properties,
+		const std::vector<std::pair<std::string, StorageTrend>>& trends);
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,348 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+
+#include "hz/debug.h"
+#include "hz/fs_mapped_file.h"
+#include "hz/string_algo.h"
+
+#include "app_trace.h"
+#include "storage_output_compression.h"
+#include "storage_virtual_import.h"
+#include "worker_threads.h"
+
+
+
+namespace {
+
+	/// Maximum size of a smartctl output file, same as for GscMainWindow::add_virtual_drive()
+	constexpr std::uintmax_t max_source_size = 10*1024*1024;
+
+	/// Maximum size of a tar archive
+	constexpr std::uintmax_t max_archive_size = std::uintmax_t(2)*1024*1024*1024;
+
+	/// Tar block size
+	constexpr std::size_t tar_block_size = 512;
+
+
+	/// Get a NUL-terminated (or full-length) field of a tar header
+	inline std::string_view tar_get_string_field(std::string_view header, std::size_t offset, std::size_t size)
+	{
+		std::string_view field = header.substr(offset, size);
+		if (const auto pos = field.find('\0'); pos != std::string_view::npos) {
+			field = field.substr(0, pos);
+		}
+		return field;
+	}
+
+
+	/// Parse an octal number field of a tar header
+	inline std::optional<std::uint64_t> tar_get_octal_field(std::string_view header, std::size_t offset, std::size_t size)
+	{
+		const std::string_view field = hz::string_trim_view(tar_get_string_field(header, offset, size), " ");
+		if (field.empty()) {
+			return std::uint64_t(0);
+		}
+		std::uint64_t value = 0;
+		for (const char c : field) {
+			if (c < '0' || c > '7') {
+				return std::nullopt;  // base-256 sizes are for files larger than 8 GiB, we don't need them
+			}
+			value = value * 8 + static_cast<std::uint64_t>(c - '0');
+		}
+		return value;
+	}
+
+
+	/// Check whether the file is a (possibly compressed) tar archive, judging by its name
+	inline bool is_tar_file_name(const hz::fs::path& file)
+	{
+		return hz::string_to_lower_copy(hz::fs_path_to_string(
+				storage_output_strip_compression_extension(file).extension())) == ".tar";
+	}
+
+}
+
+
+
+void VirtualDriveIndex::add(StorageDevicePtr drive, const std::string& source)
+{
+	Entry entry;
+	entry.entry.model = drive->get_model_name();
+	entry.entry.serial = drive->get_serial_number();
+	entry.entry.warning_level = drive->get_property_repository().get_warning_summary().max_level;
+	entry.entry.drive = std::move(drive);
+	entry.model_lower = hz::string_to_lower_copy(entry.entry.model);
+	entry.serial_lower = hz::string_to_lower_copy(entry.entry.serial);
+
+	// Drives without a serial number (e.g. unsupported USB bridges) can't be deduplicated.
+	if (!entry.entry.serial.empty()) {
+		if (auto iter = by_serial_.find(entry.entry.serial); iter != by_serial_.end()) {
+			Entry& existing = entries_[iter->second];
+			entry.entry.replaced_sources = std::move(existing.entry.replaced_sources);
+			entry.entry.replaced_sources.push_back(hz::fs_path_to_string(existing.entry.drive->get_virtual_file()));
+			existing = std::move(entry);
+			++duplicate_count_;
+			debug_out_dump("app", DBG_FUNC_MSG << "Source \"" << source << "\" replaces an older output of the same drive.\n");
+			return;
+		}
+		by_serial_.emplace(entry.entry.serial, entries_.size());
+	}
+	entries_.push_back(std::move(entry));
+}
+
+
+
+std::vector<const VirtualDriveIndexEntry*> VirtualDriveIndex::find(std::string_view text,
+		WarningLevel min_level, std::size_t max_results) const
+{
+	const std::string text_lower = hz::string_to_lower_copy(hz::string_trim_view(text));
+
+	std::vector<const Entry*> found;
+	for (const auto& entry : entries_) {
+		if (entry.entry.warning_level < min_level) {
+			continue;
+		}
+		if (text_lower.empty() || entry.model_lower.find(text_lower) != std::string::npos
+				|| entry.serial_lower.find(text_lower) != std::string::npos) {
+			found.push_back(&entry);
+		}
+	}
+
+	auto compare = [](const Entry* a, const Entry* b) {
+		if (a->entry.warning_level != b->entry.warning_level) {
+			return a->entry.warning_level > b->entry.warning_level;  // highest warning first
+		}
+		return std::tie(a->model_lower, a->serial_lower) < std::tie(b->model_lower, b->serial_lower);
+	};
+	if (max_results > 0 && max_results < found.size()) {
+		std::partial_sort(found.begin(), found.begin() + static_cast<std::ptrdiff_t>(max_results), found.end(), compare);
+		found.resize(max_results);
+	} else {
+		std::sort(found.begin(), found.end(), compare);
+	}
+
+	std::vector<const VirtualDriveIndexEntry*> results;
+	results.reserve(found.size());
+	for (const Entry* e : found) {
+		results.push_back(&e->entry);
+	}
+	return results;
+}
+
+
+
+std::size_t VirtualDriveIndex::size() const
+{
+	return entries_.size();
+}
+
+
+
+std::size_t VirtualDriveIndex::get_duplicate_count() const
+{
+	return duplicate_count_;
+}
+
+
+
+hz::ExpectedVoid<VirtualDriveImportError> storage_virtual_import_read_tar(std::string_view tar_data,
+		const std::string& archive_name, std::vector<VirtualDriveSource>& sources,
+		const std::shared_ptr<const void>& storage)
+{
+	std::string long_name;  // set by GNU "L" entries, applies to the next entry
+	std::size_t pos = 0;
+	while (pos < tar_data.size()) {
+		const std::string_view header = tar_data.substr(pos, tar_block_size);
+		if (header.find_first_not_of('\0') == std::string_view::npos) {
+			break;  // end-of-archive marker
+		}
+		pos += tar_block_size;
+
+		const auto size = (header.size() == tar_block_size ? tar_get_octal_field(header, 124, 12) : std::nullopt);
+		if (!size.has_value() || size.value() > tar_data.size() - pos) {
+			return hz::Unexpected(VirtualDriveImportError::InvalidArchive,
+					Glib::ustring::compose(_("Archive \"%1\" is broken."), archive_name));
+		}
+		const std::string_view data = tar_data.substr(pos, static_cast<std::size_t>(size.value()));
+		pos += (static_cast<std::size_t>(size.value()) + tar_block_size - 1) / tar_block_size * tar_block_size;
+
+		const char type = header[156];
+		if (type == 'L') {
+			long_name = std::string(tar_get_string_field(data, 0, data.size()));
+			continue;
+		}
+
+		std::string name;
+		if (!long_name.empty()) {
+			name = std::move(long_name);
+			long_name.clear();
+		} else {
+			name = std::string(tar_get_string_field(header, 0, 100));
+			if (header.substr(257, 5) == "ustar") {  // ustar splits long names into prefix and name
+				const std::string_view prefix = tar_get_string_field(header, 345, 155);
+				if (!prefix.empty()) {
+					name = std::string(prefix) + "/" + name;
+				}
+			}
+		}
+
+		// Regular files only. pax headers ('x', 'g'), directories, links, etc. are skipped.
+		if ((type == '0' || type == '\0') && !name.empty() && data.size() <= max_source_size) {
+			sources.push_back({archive_name + "/" + name, data, storage});
+		}
+	}
+	return {};
+}
+
+
+
+hz::ExpectedValue<std::vector<VirtualDriveSource>, VirtualDriveImportError>
+		storage_virtual_import_read_sources(const hz::fs::path& path, std::vector<std::string>& errors)
+{
+	const AppTraceSpan trace_span("storage_virtual_import_read_sources", "import");
+	std::vector<VirtualDriveSource> sources;
+
+	auto read_archive = [&sources](const hz::fs::path& file) -> hz::ExpectedVoid<VirtualDriveImportError> {
+		auto archive = std::make_shared<hz::FsMappedFile>();
+		if (auto ec = archive->open(file, max_archive_size)) {
+			return hz::Unexpected(VirtualDriveImportError::ReadError,
+					Glib::ustring::compose(_("Cannot read \"%1\": %2"), hz::fs_path_to_string(file), ec.message()));
+		}
+		// A compressed archive has to be decompressed as a whole. The members of an uncompressed
+		// one may be compressed individually, they're decompressed when parsed.
+		if (storage_output_detect_compression(archive->get_view()) != StorageOutputCompression::None) {
+			auto tar_data = storage_output_decompress(archive->get_view(), max_archive_size);
+			if (!tar_data) {
+				return hz::Unexpected(VirtualDriveImportError::ReadError,
+						Glib::ustring::compose(_("Cannot read \"%1\": %2"), hz::fs_path_to_string(file), tar_data.error().message()));
+			}
+			auto decompressed = std::make_shared<const std::string>(std::move(tar_data.value()));
+			return storage_virtual_import_read_tar(*decompressed, hz::fs_path_to_string(file), sources, decompressed);
+		}
+		return storage_virtual_import_read_tar(archive->get_view(), hz::fs_path_to_string(file), sources, archive);
+	};
+
+	std::error_code ec;
+	if (!hz::fs::is_directory(path, ec)) {
+		if (auto status = read_archive(path); !status) {
+			return hz::Unexpected(VirtualDriveImportError(status.error().data()), status.error().message());
+		}
+
+	} else {
+		hz::fs::recursive_directory_iterator iter(path, hz::fs::directory_options::skip_permission_denied, ec);
+		if (ec) {
+			return hz::Unexpected(VirtualDriveImportError::ReadError,
+					Glib::ustring::compose(_("Cannot read \"%1\": %2"), hz::fs_path_to_string(path), ec.message()));
+		}
+		for (; iter != hz::fs::recursive_directory_iterator(); iter.increment(ec)) {
+			if (ec) {
+				errors.push_back(Glib::ustring::compose(_("Cannot read \"%1\": %2"), hz::fs_path_to_string(path), ec.message()));
+				break;
+			}
+			const hz::fs::path file = iter->path();
+			std::error_code file_ec;
+			if (!iter->is_regular_file(file_ec)) {
+				continue;
+			}
+			if (is_tar_file_name(file)) {
+				if (auto status = read_archive(file); !status) {
+					errors.push_back(status.error().message());
+				}
+				continue;
+			}
+			auto mapped_file = std::make_shared<hz::FsMappedFile>();
+			if (auto map_ec = mapped_file->open(file, max_source_size)) {
+				errors.push_back(Glib::ustring::compose(_("Cannot read \"%1\": %2"), hz::fs_path_to_string(file), map_ec.message()));
+				continue;
+			}
+			const std::string_view data = mapped_file->get_view();
+			sources.push_back({hz::fs_path_to_string(file), data, std::move(mapped_file)});
+		}
+	}
+
+	std::sort(sources.begin(), sources.end(),
+			[](const VirtualDriveSource& a, const VirtualDriveSource& b) { return a.name < b.name; });
+	return sources;
+}
+
+
+
+VirtualDriveIndex storage_virtual_import_parse(std::vector<VirtualDriveSource> sources, std::vector<std::string>& errors)
+{
+	const AppTraceSpan trace_span("storage_virtual_import_parse", "import");
+
+	/// Parse result of a source
+	struct ParseResult {
+		StorageDevicePtr drive;  ///< Parsed drive, nullptr on error
+		std::string error;  ///< Error message
+	};
+	std::vector<ParseResult> results(sources.size());
+
+	// Parsing is CPU-only, and each drive is used by one thread only.
+	app_run_parallel_ranges(sources.size(), 4, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			auto drive = std::make_shared<StorageDevice>(sources[i].name, true);
+			auto output = storage_output_decompress(sources[i].data, max_source_size);  // copied if not compressed
+			sources[i].data = {};
+			sources[i].storage.reset();  // unmap the file as soon as possible
+			if (!output) {
+				results[i].error = output.error().message();
+				continue;
+			}
+			drive->set_virtual_output(std::move(output.value()));  // the only copy of the data
+			if (auto parse_status = drive->parse_any_data_for_virtual(); parse_status) {
+				results[i].drive = std::move(drive);
+			} else {
+				results[i].error = parse_status.error().message();
+			}
+		}
+	});
+
+	VirtualDriveIndex index;
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		if (results[i].drive) {
+			index.add(std::move(results[i].drive), sources[i].name);
+		} else {
+			errors.push_back(sources[i].name + ": " + results[i].error);
+		}
+	}
+	return index;
+}
+
+
+
+hz::ExpectedValue<VirtualDriveImportResult, VirtualDriveImportError> storage_virtual_import(const hz::fs::path& path)
+{
+	VirtualDriveImportResult result;
+	auto sources = storage_virtual_import_read_sources(path, result.errors);
+	if (!sources) {
+		return hz::Unexpected(VirtualDriveImportError(sources.error().data()), sources.error().message());
+	}
+	result.source_count = sources->size();
+	result.index = storage_virtual_import_parse(std::move(sources.value()), result.errors);
+
+	debug_out_info("app", DBG_FUNC_MSG << "Loaded " << result.index.size() << " drives from " << result.source_count
+			<< " files in \"" << hz::fs_path_to_string(path) << "\" (" << result.index.get_duplicate_count()
+			<< " older duplicates, " << result.errors.size() << " errors).\n");
+	return result;
+}
+
+
+
+
+/// @}
@@ -0,0 +1,145 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef STORAGE_VIRTUAL_IMPORT_H
+#define STORAGE_VIRTUAL_IMPORT_H
+
+#include <cstddef>  // std::size_t
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hz/error_container.h"
+#include "hz/fs.h"
+
+#include "storage_device.h"
+#include "warning_level.h"
+
+
+
+/// Errors of bulk-loading virtual drives
+enum class VirtualDriveImportError {
+	ReadError,  ///< Cannot read the directory or the archive
+	InvalidArchive,  ///< The tar archive is broken
+};
+
+
+
+/// A smartctl output to load as a virtual drive
+struct VirtualDriveSource {
+	std::string name;  ///< File name. Archive members are named "archive.tar/member".
+	std::string_view data;  ///< File contents, owned by \c storage
+	std::shared_ptr<const void> storage;  ///< Keeps \c data alive (usually a memory-mapped file or archive)
+};
+
+
+
+/// A virtual drive in VirtualDriveIndex
+struct VirtualDriveIndexEntry {
+	StorageDevicePtr drive;  ///< Parsed drive
+	std::string model;  ///< Model name, may be empty
+	std::string serial;  ///< Serial number, may be empty
+	WarningLevel warning_level = WarningLevel::None;  ///< Highest warning level of the drive properties
+	std::vector<std::string> replaced_sources;  ///< Sources of the older outputs of the same drive (by serial number)
+};
+
+
+
+/// Parsed virtual drives, deduplicated by serial number and searchable by model,
+/// serial number and warning level.
+class VirtualDriveIndex {
+	public:
+
+		/// Add a parsed drive. A drive with the same serial number as an existing one replaces it
+		/// (the sources are expected to be added in order, e.g. sorted by name, which includes
+		/// the date in the default save file names).
+		void add(StorageDevicePtr drive, const std::string& source);
+
+
+		/// Find the drives whose model or serial number contains \c text (case-insensitive,
+		/// everything matches an empty text), with a warning level of at least \c min_level.
+		/// The highest warning levels come first, then the drives are sorted by model and serial number.
+		/// At most \c max_results results are returned (0 means unlimited).
+		[[nodiscard]] std::vector<const VirtualDriveIndexEntry*> find(std::string_view text,
+				WarningLevel min_level = WarningLevel::None, std::size_t max_results = 0) const;
+
+
+		/// Get the number of (unique) drives
+		[[nodiscard]] std::size_t size() const;
+
+
+		/// Get the number of drives replaced by newer outputs of the same drive
+		[[nodiscard]] std::size_t get_duplicate_count() const;
+
+
+	private:
+
+		/// An entry, with lowercase search keys
+		struct Entry {
+			VirtualDriveIndexEntry entry;  ///< Entry
+			std::string model_lower;  ///< Lowercase model, for searching
+			std::string serial_lower;  ///< Lowercase serial number, for searching
+		};
+
+		std::vector<Entry> entries_;  ///< Drives, in the order of addition
+		std::unordered_map<std::string, std::size_t> by_serial_;  ///< Serial number -> index in entries_
+		std::size_t duplicate_count_ = 0;  ///< Number of replaced drives
+
+};
+
+
+
+/// Result of storage_virtual_import()
+struct VirtualDriveImportResult {
+	VirtualDriveIndex index;  ///< Loaded drives
+	std::size_t source_count = 0;  ///< Number of files found
+	std::vector<std::string> errors;  ///< Files which could not be loaded, with the reasons
+};
+
+
+
+/// Extract the regular files of an uncompressed (ustar or GNU) tar archive into \c sources.
+/// The members are named "<archive_name>/<member path>". The member data is not copied,
+/// it points into \c tar_data, which is kept alive by \c storage (if \c storage is nullptr,
+/// \c tar_data must outlive the sources).
+[[nodiscard]] hz::ExpectedVoid<VirtualDriveImportError> storage_virtual_import_read_tar(std::string_view tar_data,
+		const std::string& archive_name, std::vector<VirtualDriveSource>& sources,
+		const std::shared_ptr<const void>& storage = nullptr);
+
+
+/// Read the smartctl outputs in a directory (recursively) or a tar archive.
+/// Tar archives found in the directory are read as well. Files larger than 10 MiB are skipped.
+/// The files are memory-mapped, not read. The sources are sorted by name.
+/// The outputs and the archives may be gzip-compressed (see storage_output_compression.h).
+/// A whole compressed archive (".tar.gz") is decompressed into memory; in a multi-drive archive
+/// of individually compressed outputs (a ".tar" of ".json.gz" files), the tar headers index
+/// the drives and each one is decompressed separately by storage_virtual_import_parse().
+[[nodiscard]] hz::ExpectedValue<std::vector<VirtualDriveSource>, VirtualDriveImportError>
+		storage_virtual_import_read_sources(const hz::fs::path& path, std::vector<std::string>& errors);
+
+
+/// Decompress (if needed) and parse the sources in parallel into virtual drives, and index them.
+/// The sources which cannot be parsed are added to \c errors.
+[[nodiscard]] VirtualDriveIndex storage_virtual_import_parse(std::vector<VirtualDriveSource> sources,
+		std::vector<std::string>& errors);
+
+
+/// Read and parse the smartctl outputs in a directory or a tar archive.
+[[nodiscard]] hz::ExpectedValue<VirtualDriveImportResult, VirtualDriveImportError> storage_virtual_import(const hz::fs::path& path);
+
+
+
+
+#endif
+
+/// @}
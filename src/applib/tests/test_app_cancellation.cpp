@@ -0,0 +1,59 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/app_cancellation.h"
+
+using namespace std::chrono_literals;
+
+
+
+TEST_CASE("AppCancellation", "[app][cancellation]")
+{
+	REQUIRE(!app_is_cancelled(nullptr));
+
+	SECTION("Explicit") {
+		auto cancellation = std::make_shared<AppCancellation>();
+		REQUIRE(!app_is_cancelled(cancellation));
+		REQUIRE(!cancellation->get_time_left().has_value());
+
+		cancellation->cancel();
+		REQUIRE(app_is_cancelled(cancellation));
+		REQUIRE(!cancellation->get_deadline_passed());
+	}
+
+	SECTION("Deadline") {
+		auto cancellation = std::make_shared<AppCancellation>();
+		cancellation->set_timeout(1h);
+		REQUIRE(!cancellation->is_cancelled());
+		REQUIRE(cancellation->get_time_left().has_value());
+		REQUIRE(cancellation->get_time_left().value() > 59min);
+
+		cancellation->set_deadline(std::chrono::steady_clock::now() - 1s);
+		REQUIRE(cancellation->is_cancelled());
+		REQUIRE(cancellation->get_deadline_passed());
+		REQUIRE(cancellation->get_time_left().value() == std::chrono::steady_clock::duration::zero());
+
+		cancellation->set_timeout(0s);  // no deadline
+		REQUIRE(!cancellation->is_cancelled());
+		REQUIRE(!cancellation->get_time_left().has_value());
+	}
+}
+
+
+
+
+/// @}
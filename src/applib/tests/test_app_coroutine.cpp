@@ -0,0 +1,124 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/app_coroutine.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+	/// A task finishing without suspending
+	AppTask<int> add_task(int a, int b)
+	{
+		co_return a + b;
+	}
+
+
+	/// A task awaiting other tasks
+	AppTask<int> sum_task(std::vector<int>& trace)
+	{
+		trace.push_back(1);
+		const int a = co_await add_task(1, 2);
+		trace.push_back(2);
+		const int b = co_await add_task(a, 3);
+		co_return b;
+	}
+
+
+	/// A throwing task
+	AppTask<std::string> throwing_task()
+	{
+		throw std::runtime_error("error");
+		co_return std::string();
+	}
+
+
+	/// A task catching the exception of another one
+	AppTask<std::string> catching_task()
+	{
+		try {
+			co_return co_await throwing_task();
+		} catch (const std::runtime_error& e) {
+			co_return std::string("caught ") + e.what();
+		}
+	}
+
+
+	/// A task waiting in the main context
+	AppTask<> waiting_task(std::vector<int>& trace, int id, std::chrono::milliseconds delay)
+	{
+		trace.push_back(id);
+		co_await app_co_yield();
+		co_await app_co_sleep(delay);
+		trace.push_back(id + 100);
+	}
+
+}
+
+
+
+TEST_CASE("AppTask", "[app][coroutine]")
+{
+	std::vector<int> trace;
+	int result = 0;
+	app_task_start(sum_task(trace), [&result](int value) { result = value; });
+	REQUIRE(result == 6);
+	REQUIRE(trace == std::vector<int>{1, 2});
+
+	std::string message;
+	app_task_start(catching_task(), [&message](std::string value) { message = std::move(value); });
+	REQUIRE(message == "caught error");
+
+	{
+		auto task = sum_task(trace);  // lazily started, destroyed without running
+	}
+	REQUIRE(trace.size() == 2);
+}
+
+
+
+TEST_CASE("AppTaskMainContext", "[app][coroutine]")
+{
+	GMainContext* context = g_main_context_new();
+	g_main_context_push_thread_default(context);
+
+	// Both tasks wait in the same context at the same time
+	std::vector<int> trace;
+	int finished = 0;
+	app_task_start(waiting_task(trace, 1, std::chrono::milliseconds(30)), [&finished]() { ++finished; });
+	app_task_start(waiting_task(trace, 2, std::chrono::milliseconds(1)), [&finished]() { ++finished; });
+	REQUIRE(trace == std::vector<int>{1, 2});
+
+	while (finished < 2) {
+		g_main_context_iteration(context, TRUE);
+	}
+	REQUIRE(trace == std::vector<int>{1, 2, 102, 101});
+
+	g_main_context_pop_thread_default(context);
+	g_main_context_unref(context);
+}
+
+
+
+
+
+
+/// @}
@@ -105,6 +105,26 @@ Use smartctl -X to abort test.
 
 
 
+TEST_CASE("AppRegexCache", "[app][regex]")
+{
+	const auto stats_before = app_regex_get_cache_stats();
+
+	auto re1 = app_regex_re_cached("/test_cache_pattern_[0-9]+/i");
+	auto re2 = app_regex_re_cached("/test_cache_pattern_[0-9]+/i");
+	REQUIRE(re1 == re2);  // same compiled object
+	REQUIRE(app_regex_partial_match("/test_cache_pattern_[0-9]+/i", "a TEST_CACHE_PATTERN_5 b"));
+
+	const auto stats_after = app_regex_get_cache_stats();
+	REQUIRE(stats_after.misses == stats_before.misses + 1);
+	REQUIRE(stats_after.hits == stats_before.hits + 2);
+	REQUIRE(stats_after.size == stats_before.size + 1);
+
+	REQUIRE_THROWS_AS(app_regex_re_cached("/[/"), std::regex_error);
+}
+
+
+
+
 
 
 /// @}
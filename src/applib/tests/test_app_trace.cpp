@@ -0,0 +1,112 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <string>
+
+#include "applib/app_trace.h"
+#include "nlohmann/json.hpp"
+
+
+
+TEST_CASE("AppTraceSpans", "[app][trace]")
+{
+	app_trace_set_enabled(false);
+	{
+		const AppTraceSpan span("disabled_span");
+	}
+	REQUIRE(nlohmann::json::parse(app_trace_export_chrome_json())["traceEvents"].empty());
+
+	app_trace_set_enabled(true);
+	{
+		const AppTraceSpan outer("outer", "test");
+		const AppTraceSpan inner("inner", "test", "some detail");
+	}
+	app_trace_add_span("manual", "test", 1000, 3000);
+
+	const auto events = nlohmann::json::parse(app_trace_export_chrome_json())["traceEvents"];
+	REQUIRE(events.size() == 3);
+
+	// Spans are recorded when they finish
+	REQUIRE(events[0]["name"] == "inner");
+	REQUIRE(events[0]["args"]["detail"] == "some detail");
+	REQUIRE(events[1]["name"] == "outer");
+	REQUIRE(events[1]["cat"] == "test");
+	REQUIRE(events[1]["ph"] == "X");
+	REQUIRE(events[1].count("args") == 0);
+	REQUIRE(events[1]["dur"].get<double>() >= events[0]["dur"].get<double>());
+	REQUIRE(events[2]["ts"].get<double>() == 1.);
+	REQUIRE(events[2]["dur"].get<double>() == 2.);
+
+	const auto spans = app_trace_get_spans();
+	REQUIRE(spans.size() == 3);
+	REQUIRE(std::string(spans[2].name) == "manual");
+	REQUIRE(spans[2].start_ns == 1000);
+	REQUIRE(spans[2].duration_ns == 2000);
+
+	app_trace_set_enabled(false);
+	REQUIRE(app_trace_get_spans().empty());
+}
+
+
+
+TEST_CASE("AppTraceRingBuffer", "[app][trace]")
+{
+	app_trace_set_enabled(true, 2);
+	app_trace_add_span("first", "test", 0, 1);
+	app_trace_add_span("second", "test", 1, 2);
+	app_trace_add_span("third", "test", 2, 3);
+
+	// The oldest span is overwritten
+	const auto events = nlohmann::json::parse(app_trace_export_chrome_json())["traceEvents"];
+	REQUIRE(events.size() == 2);
+	REQUIRE(events[0]["name"] == "second");
+	REQUIRE(events[1]["name"] == "third");
+
+	app_trace_set_enabled(false);
+}
+
+
+
+
+TEST_CASE("AppTraceWatchedSpan", "[app][trace]")
+{
+	app_trace_set_enabled(false);
+
+	// Not the watched thread yet
+	{
+		const AppTraceSpan span("unwatched");
+		REQUIRE(app_trace_get_watched_span() == nullptr);
+	}
+
+	// Published even with tracing disabled
+	app_trace_set_watched_thread();
+	{
+		const AppTraceSpan outer("outer");
+		REQUIRE(std::string(app_trace_get_watched_span()) == "outer");
+		{
+			const AppTraceSpan inner("inner");
+			REQUIRE(std::string(app_trace_get_watched_span()) == "inner");
+		}
+		REQUIRE(std::string(app_trace_get_watched_span()) == "outer");
+	}
+	REQUIRE(app_trace_get_watched_span() == nullptr);
+}
+
+
+
+
+/// @}
@@ -0,0 +1,55 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/async_command_executor_win32.h"
+
+
+
+TEST_CASE("Win32MakeCommandLine", "[app][executor]")
+{
+	REQUIRE(win32_make_command_line({}).empty());
+	REQUIRE(win32_make_command_line({"smartctl.exe", "-x", "/dev/sda"}) == "smartctl.exe -x /dev/sda");
+
+	// Spaces and empty arguments are quoted
+	REQUIRE(win32_make_command_line({"C:\\Program Files\\smartctl.exe", ""}) == "\"C:\\Program Files\\smartctl.exe\" \"\"");
+
+	// Backslashes are literal unless they precede a quote
+	REQUIRE(win32_make_command_line({"a\\b"}) == "a\\b");
+	REQUIRE(win32_make_command_line({"a \\b"}) == "\"a \\b\"");
+	REQUIRE(win32_make_command_line({"a\"b"}) == "\"a\\\"b\"");
+	REQUIRE(win32_make_command_line({"a\\\"b"}) == "\"a\\\\\\\"b\"");
+	REQUIRE(win32_make_command_line({"dir \\"}) == "\"dir \\\\\"");
+}
+
+
+
+TEST_CASE("Win32ChildProcessStart", "[app][executor]")
+{
+#ifndef _WIN32
+	void* handle = nullptr;
+	std::string error_msg;
+	REQUIRE(win32_child_process_start({"smartctl"}, {}, nullptr, {}, handle, error_msg) == nullptr);
+	REQUIRE(!error_msg.empty());
+#endif
+}
+
+
+
+
+
+
+/// @}
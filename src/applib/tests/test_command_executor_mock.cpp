@@ -0,0 +1,66 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/command_executor_mock.h"
+
+
+
+TEST_CASE("CommandExecutorMock", "[app][executor]")
+{
+	auto corpus = std::make_shared<CommandExecutorMockCorpus>();
+	corpus->add({"-i", "/dev/sda"}, "info sda");
+	corpus->add({"-x", "/dev/sda"}, CommandExecutorMockResponse {
+		.std_output = std::make_shared<const std::string>("failed sda"),
+		.error_message = "Smartctl exited with status 4.",
+		.delay = {},
+	});
+
+	auto factory = std::make_shared<CommandExecutorFactoryMock>(corpus);
+	auto ex = factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+
+	SECTION("Canned output") {
+		ex->set_command("smartctl", {"-i", "/dev/sda"});
+		REQUIRE(ex->execute());
+		REQUIRE(ex->get_error_msg().empty());
+		REQUIRE(*ex->get_stdout_buffer() == "info sda");
+		REQUIRE(corpus->get_hit_count() == 1);
+		REQUIRE(corpus->get_misses().empty());
+	}
+
+	SECTION("Canned error") {
+		ex->set_command("/usr/sbin/smartctl", {"-x", "/dev/sda"});  // the command name is not a part of the key
+		REQUIRE(ex->execute());
+		REQUIRE(ex->get_error_msg() == "Smartctl exited with status 4.");
+		REQUIRE(*ex->get_stdout_buffer() == "failed sda");
+	}
+
+	SECTION("Missing response") {
+		ex->set_command("smartctl", {"-i", "/dev/sdb"});
+		REQUIRE_FALSE(ex->execute());
+		REQUIRE_FALSE(ex->get_error_msg().empty());
+		REQUIRE(ex->get_stdout_buffer()->empty());
+		REQUIRE(corpus->get_misses() == std::set<std::vector<std::string>>{{"-i", "/dev/sdb"}});
+
+		corpus->clear_misses();
+		REQUIRE(corpus->get_misses().empty());
+	}
+}
+
+
+
+
+/// @}
@@ -0,0 +1,148 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/command_executor_policy.h"
+
+using namespace std::chrono_literals;
+
+
+
+TEST_CASE("CommandRateLimiter", "[app][executor]")
+{
+	CommandRateLimiter limiter;
+	const auto start = std::chrono::steady_clock::now();
+
+	SECTION("Unlimited") {
+		for (int i = 0; i < 10; ++i) {
+			REQUIRE(limiter.reserve("/dev/sda", 0., 1, start) == 0s);
+		}
+	}
+
+	SECTION("Burst and rate") {
+		// 2 commands per second, 3 at once
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start) == 500ms);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start) == 1000ms);  // queued behind the previous one
+
+		// After 1.5 seconds, the 3 tokens accrued pay for the 2 reserved ones
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start + 1500ms) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start + 1500ms) == 500ms);
+
+		// The bucket never holds more than the burst
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start + 1h) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start + 1h) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start + 1h) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 2., 3, start + 1h) == 500ms);
+	}
+
+	SECTION("Per key") {
+		REQUIRE(limiter.reserve("/dev/sda", 1., 1, start) == 0s);
+		REQUIRE(limiter.reserve("/dev/sda", 1., 1, start) == 1s);
+		REQUIRE(limiter.reserve("/dev/sdb", 1., 1, start) == 0s);
+		REQUIRE(limiter.reserve("host:/dev/sda", 1., 1, start) == 0s);
+
+		limiter.clear();
+		REQUIRE(limiter.reserve("/dev/sda", 1., 1, start) == 0s);
+	}
+}
+
+
+
+TEST_CASE("CommandIoPriorityClass", "[app][executor]")
+{
+	REQUIRE(cmdex_parse_io_priority_class("") == CommandIoPriorityClass::Default);
+	REQUIRE(cmdex_parse_io_priority_class("default") == CommandIoPriorityClass::Default);
+	REQUIRE(cmdex_parse_io_priority_class("RealTime") == CommandIoPriorityClass::RealTime);
+	REQUIRE(cmdex_parse_io_priority_class("best-effort") == CommandIoPriorityClass::BestEffort);
+	REQUIRE(cmdex_parse_io_priority_class(" idle ") == CommandIoPriorityClass::Idle);
+	REQUIRE(!cmdex_parse_io_priority_class("background"));
+
+	REQUIRE(cmdex_get_operation_name(CommandOperation::Scan) == "scan");
+	REQUIRE(cmdex_get_operation_name(CommandOperation::SelfTest) == "selftest");
+	REQUIRE(CommandExecutionPolicy() == CommandExecutionPolicy());
+}
+
+
+
+TEST_CASE("CommandPriority", "[app][executor]")
+{
+	using namespace std::literals;
+
+	REQUIRE(cmdex_get_priority_name(CommandPriority::Interactive) == "interactive");
+	REQUIRE(cmdex_get_priority_name(CommandPriority::Bulk) == "bulk");
+
+	// Without waiting, the classes are ordered
+	REQUIRE(cmdex_get_priority_rank(CommandPriority::Interactive, 0s, 10s)
+			< cmdex_get_priority_rank(CommandPriority::SelfTestPoll, 0s, 10s));
+	REQUIRE(cmdex_get_priority_rank(CommandPriority::BackgroundRefresh, 0s, 10s)
+			< cmdex_get_priority_rank(CommandPriority::Bulk, 0s, 10s));
+
+	// A bulk command waiting long enough overtakes a fresh interactive one
+	REQUIRE(cmdex_get_priority_rank(CommandPriority::Bulk, 29s, 10s)
+			> cmdex_get_priority_rank(CommandPriority::Interactive, 0s, 10s));
+	REQUIRE(cmdex_get_priority_rank(CommandPriority::Bulk, 40s, 10s)
+			< cmdex_get_priority_rank(CommandPriority::Interactive, 0s, 10s));
+
+	// No aging
+	REQUIRE(cmdex_get_priority_rank(CommandPriority::Bulk, 1h, 0s) == cmdex_get_priority_rank(CommandPriority::Bulk, 0s, 10s));
+}
+
+
+
+
+TEST_CASE("CommandSerializationDomain", "[app][executor]")
+{
+	// Ports of a controller share its domain, the type family selects its limit
+	REQUIRE(cmdex_get_serialization_domain("/dev/twa0", "3ware,2") == "3ware:/dev/twa0");
+	REQUIRE(cmdex_get_serialization_domain("/dev/twa0", "3ware,5") == cmdex_get_serialization_domain("/dev/twa0", "3ware,2"));
+	REQUIRE(cmdex_get_serialization_domain("/dev/sg2", "areca,3/1") == "areca:/dev/sg2");
+	REQUIRE(cmdex_get_serialization_domain("/dev/cciss/c0d0", "CCISS,1") == "cciss:/dev/cciss/c0d0");
+	REQUIRE(cmdex_get_serialization_domain("host1:/dev/sda", "sat+megaraid,0") == "megaraid:host1:/dev/sda");
+	REQUIRE(cmdex_get_domain_family("megaraid:host1:/dev/sda") == "megaraid");
+
+	// Independent devices
+	REQUIRE(cmdex_get_serialization_domain("/dev/sda", "").empty());
+	REQUIRE(cmdex_get_serialization_domain("/dev/nvme0", "nvme").empty());
+
+	// Registered by detection
+	cmdex_set_device_domain("/dev/sg5", "aacraid:host2");
+	REQUIRE(cmdex_get_serialization_domain("/dev/sg5", "sat") == "aacraid:host2");
+	REQUIRE(cmdex_get_domain_family("aacraid:host2") == "aacraid");
+	cmdex_set_device_domain("/dev/sg5", "");
+	REQUIRE(cmdex_get_serialization_domain("/dev/sg5", "sat").empty());
+}
+
+
+
+TEST_CASE("CommandDomainLimits", "[app][executor]")
+{
+	REQUIRE(cmdex_parse_domain_limits("") == CommandDomainLimits());
+	REQUIRE(cmdex_parse_domain_limits("3ware:1;areca:1; CCISS : 2 ;")
+			== CommandDomainLimits{{"3ware", 1}, {"areca", 1}, {"cciss", 2}});
+	REQUIRE(cmdex_parse_domain_limits("megaraid:0") == CommandDomainLimits{{"megaraid", 0}});
+	REQUIRE(!cmdex_parse_domain_limits("3ware"));
+	REQUIRE(!cmdex_parse_domain_limits("3ware:one"));
+	REQUIRE(!cmdex_parse_domain_limits(":1"));
+	REQUIRE(!cmdex_parse_domain_limits("areca:-1"));
+}
+
+
+
+
+/// @}
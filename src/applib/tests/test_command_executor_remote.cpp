@@ -0,0 +1,81 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/command_executor_remote.h"
+#include <algorithm>  // std::find
+#include <string>
+#include <vector>
+
+
+
+TEST_CASE("RemoteHostShellQuote", "[app][executor]")
+{
+	REQUIRE(remote_host_shell_quote("/dev/sda") == "/dev/sda");
+	REQUIRE(remote_host_shell_quote("--json=o") == "--json=o");
+	REQUIRE(remote_host_shell_quote("") == "''");
+	REQUIRE(remote_host_shell_quote("a b") == "'a b'");
+	REQUIRE(remote_host_shell_quote("$(reboot)") == "'$(reboot)'");
+	REQUIRE(remote_host_shell_quote("it's") == "'it'\\''s'");
+}
+
+
+
+TEST_CASE("RemoteHostDestination", "[app][executor]")
+{
+	REQUIRE(remote_host_is_valid_destination("server1"));
+	REQUIRE(remote_host_is_valid_destination("root@server1.example.com"));
+	REQUIRE(!remote_host_is_valid_destination(""));
+	REQUIRE(!remote_host_is_valid_destination("-oProxyCommand=x"));
+	REQUIRE(!remote_host_is_valid_destination("server1 server2"));
+}
+
+
+
+TEST_CASE("RemoteHostWrapCommand", "[app][executor]")
+{
+	const RemoteHost host("root@server1", "ssh", "/run/user/1000", std::chrono::seconds(600), "smartctl");
+	const auto [command, args] = host.wrap_command("smartctl", {"-x", "-d", "sat,12", "/dev/sda"});
+
+	REQUIRE(command == "ssh");
+	REQUIRE(args.size() >= 3);
+	// The destination comes after the end of options, followed by the remote command line
+	REQUIRE(args[args.size() - 3] == "--");
+	REQUIRE(args[args.size() - 2] == "root@server1");
+	REQUIRE(args.back() == "smartctl -x -d sat,12 /dev/sda");
+
+	auto has_option = [&args](const std::string& option) {
+		for (std::size_t i = 0; i + 1 < args.size(); ++i) {
+			if (args[i] == "-o" && args[i + 1] == option) {
+				return true;
+			}
+		}
+		return false;
+	};
+	REQUIRE(has_option("BatchMode=yes"));
+	REQUIRE(has_option("ControlMaster=auto"));
+	REQUIRE(has_option("ControlPath=/run/user/1000/gsc-ssh-%C"));
+	REQUIRE(has_option("ControlPersist=600"));
+
+	const RemoteHost no_persist("server2", "ssh", "/tmp", std::chrono::seconds(0), "smartctl");
+	const auto no_persist_args = no_persist.wrap_command("smartctl", {}).second;
+	REQUIRE(std::find(no_persist_args.begin(), no_persist_args.end(), "ControlPersist=no") != no_persist_args.end());
+}
+
+
+
+
+/// @}
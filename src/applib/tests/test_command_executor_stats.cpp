@@ -0,0 +1,228 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/command_executor_stats.h"
+
+using namespace std::chrono_literals;
+
+
+
+TEST_CASE("CommandDurationHistogram", "[app][executor]")
+{
+	CommandDurationHistogram histogram;
+	REQUIRE(histogram.get_count() == 0);
+	REQUIRE(histogram.get_percentile(0.5) == 0us);
+
+	histogram.add(0us);
+	histogram.add(1us);
+	histogram.add(3us);  // [2, 4)
+	histogram.add(1000us);  // [512, 1024)
+	histogram.add(1h);  // last bucket
+
+	REQUIRE(histogram.get_count() == 5);
+	REQUIRE(histogram.get_bucket(0) == 2);
+	REQUIRE(histogram.get_bucket(1) == 1);
+	REQUIRE(histogram.get_bucket(9) == 1);
+	REQUIRE(histogram.get_bucket(CommandDurationHistogram::bucket_count - 1) == 1);
+	REQUIRE(histogram.get_max() == 1h);
+	REQUIRE(histogram.get_total() == 1h + 1004us);
+
+	// Upper bound of the percentile's bucket
+	REQUIRE(histogram.get_percentile(0.) == 2us);
+	REQUIRE(histogram.get_percentile(0.6) == 4us);
+	REQUIRE(histogram.get_percentile(0.8) == 1024us);
+	REQUIRE(histogram.get_percentile(1.) == 1h);
+}
+
+
+
+TEST_CASE("CommandExecutionStats", "[app][executor]")
+{
+	cmdex_stats_clear();
+
+	CommandExecutionSample sample;
+	sample.device = "/dev/sda";
+	sample.options = "-d sat --info";
+	sample.runtime = 200ms;
+	sample.time_to_first_byte = 50ms;
+	sample.bytes_out = 1000;
+	cmdex_stats_add_sample(sample);
+
+	sample.killed = true;
+	sample.timed_out = true;
+	sample.time_to_first_byte.reset();
+	cmdex_stats_add_sample(sample);
+
+	CommandExecutionSample failed;
+	failed.options = "tw_cli show";
+	failed.spawned = false;
+	cmdex_stats_add_sample(failed);
+
+	const auto stats = cmdex_stats_get();
+	REQUIRE(stats.by_device.size() == 1);
+	REQUIRE(stats.by_options.size() == 2);
+
+	const auto& sda = stats.by_device.at("/dev/sda");
+	REQUIRE(sda.executions == 2);
+	REQUIRE(sda.kills == 1);
+	REQUIRE(sda.timeouts == 1);
+	REQUIRE(sda.bytes_out == 2000);
+	REQUIRE(sda.runtime.get_count() == 2);
+	REQUIRE(sda.time_to_first_byte.get_count() == 1);
+
+	const auto& tw_cli = stats.by_options.at("tw_cli show");
+	REQUIRE(tw_cli.executions == 1);
+	REQUIRE(tw_cli.failures == 1);
+	REQUIRE(tw_cli.runtime.get_count() == 0);
+
+	const std::string text = cmdex_stats_format(stats);
+	REQUIRE(text.find("/dev/sda: 2 runs") != std::string::npos);
+	REQUIRE(text.find("tw_cli show: 1 runs (1 failed)") != std::string::npos);
+
+	cmdex_stats_clear();
+	REQUIRE(cmdex_stats_get().by_options.empty());
+}
+
+
+TEST_CASE("CommandExecutionStatsAdaptiveTimeouts", "[app][executor]")
+{
+	CommandAdaptiveTimeoutSettings settings;
+	settings.min_timeout = 1s;
+	settings.max_timeout = 300s;
+	settings.kill_delay = 3s;
+
+	SECTION("No data") {
+		const auto timeouts = cmdex_stats_compute_timeouts(nullptr, settings);
+		REQUIRE(timeouts.term_timeout == 300s);
+		REQUIRE(timeouts.kill_timeout == 303s);
+	}
+
+	CommandExecutionSample sample;
+	sample.runtime = 1s;
+
+	SECTION("Enough samples") {
+		CommandExecutionStats stats;
+		stats.add(sample);
+		stats.add(sample);
+		REQUIRE(cmdex_stats_compute_timeouts(&stats, settings).term_timeout == 300s);  // not enough yet
+		stats.add(sample);
+		const auto timeouts = cmdex_stats_compute_timeouts(&stats, settings);
+		REQUIRE(timeouts.term_timeout == 4000ms);
+		REQUIRE(timeouts.kill_timeout == 7000ms);
+
+		// Clamped
+		settings.max_timeout = 500ms;
+		REQUIRE(cmdex_stats_compute_timeouts(&stats, settings).term_timeout == 1s);
+		settings.min_timeout = 10ms;
+		REQUIRE(cmdex_stats_compute_timeouts(&stats, settings).term_timeout == 500ms);
+	}
+
+	SECTION("Dead port") {
+		CommandExecutionSample timed_out = sample;
+		timed_out.timed_out = true;
+		timed_out.killed = true;
+
+		CommandExecutionStats stats;
+		stats.add(timed_out);
+		REQUIRE(stats.consecutive_timeouts == 1);
+		REQUIRE(stats.completed_runtime.get_count() == 0);
+		REQUIRE(cmdex_stats_compute_timeouts(&stats, settings).term_timeout == 1s);
+
+		// A port which used to answer gets one more chance
+		for (int i = 0; i < 3; ++i) {
+			stats.add(sample);
+		}
+		REQUIRE(stats.consecutive_timeouts == 0);
+		stats.add(timed_out);
+		REQUIRE(cmdex_stats_compute_timeouts(&stats, settings).term_timeout == 4000ms);
+		stats.add(timed_out);
+		REQUIRE(stats.consecutive_timeouts == 2);
+		REQUIRE(cmdex_stats_compute_timeouts(&stats, settings).term_timeout == 1s);
+	}
+}
+
+
+
+TEST_CASE("CommandExecutionStatsDeviceOperation", "[app][executor]")
+{
+	cmdex_stats_clear();
+
+	CommandExecutionSample sample;
+	sample.device = "/dev/sda";
+	sample.operation = CommandOperation::Scan;
+	sample.runtime = 200ms;
+	cmdex_stats_add_sample(sample);
+	sample.operation = CommandOperation::Refresh;
+	cmdex_stats_add_sample(sample);
+	cmdex_stats_add_sample(sample);
+
+	REQUIRE(cmdex_stats_get().by_device_operation.size() == 2);
+	REQUIRE(!cmdex_stats_get_device_operation("/dev/sdb", CommandOperation::Scan).has_value());
+	REQUIRE(!cmdex_stats_get_device_operation("/dev/sda", CommandOperation::SelfTest).has_value());
+	REQUIRE(cmdex_stats_get_device_operation("/dev/sda", CommandOperation::Scan)->executions == 1);
+	REQUIRE(cmdex_stats_get_device_operation("/dev/sda", CommandOperation::Refresh)->executions == 2);
+
+	cmdex_stats_clear();
+	REQUIRE(!cmdex_stats_get_device_operation("/dev/sda", CommandOperation::Refresh).has_value());
+}
+
+
+
+TEST_CASE("CommandExecutionStatsOutputSizes", "[app][executor]")
+{
+	cmdex_stats_clear();
+
+	CommandExecutionSample sample;
+	sample.device = "/dev/sda";
+	sample.options = "-x";
+	sample.bytes_out = 160000;
+	sample.bytes_err = 100;
+	cmdex_stats_add_sample(sample);
+
+	// Incomplete outputs are not counted
+	CommandExecutionSample killed = sample;
+	killed.bytes_out = 10;
+	killed.killed = true;
+	cmdex_stats_add_sample(killed);
+
+	sample.bytes_out = 150000;
+	cmdex_stats_add_sample(sample);
+
+	REQUIRE(!cmdex_stats_get_output_sizes("/dev/sdb", "-x").has_value());
+	REQUIRE(!cmdex_stats_get_output_sizes("/dev/sda", "-i").has_value());
+	const auto sizes = cmdex_stats_get_output_sizes("/dev/sda", "-x");
+	REQUIRE(sizes.has_value());
+	REQUIRE(sizes->executions == 2);
+	REQUIRE(sizes->last_stdout == 150000);
+	REQUIRE(sizes->max_stdout == 160000);
+	REQUIRE(sizes->get_expected_stdout() == 160000);  // the last one with a margin is smaller
+	REQUIRE(sizes->get_expected_stderr() == 106);
+
+	// A growing output
+	sample.bytes_out = 320000;
+	cmdex_stats_add_sample(sample);
+	REQUIRE(cmdex_stats_get_output_sizes("/dev/sda", "-x")->get_expected_stdout() == 340000);
+
+	REQUIRE(CommandOutputSizes().get_expected_stdout() == 0);
+	cmdex_stats_clear();
+}
+
+
+
+
+
+/// @}
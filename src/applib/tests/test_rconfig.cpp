@@ -0,0 +1,72 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "rconfig/loadsave.h"
+
+
+
+TEST_CASE("RconfigKey", "[rconfig]")
+{
+	rconfig::set_default_data("test/key/int_value", 5);
+	const rconfig::Key<int> key("test/key/int_value");
+	REQUIRE(key.get_path() == "test/key/int_value");
+	REQUIRE(key.get() == 5);
+
+	// The cached value is refreshed when the config changes
+	REQUIRE(key.set(7));
+	REQUIRE(key.get() == 7);
+	rconfig::set_data("test/key/int_value", 8);
+	REQUIRE(key.get() == 8);
+	rconfig::unset_data("test/key/int_value");
+	REQUIRE(key.get() == 5);
+
+	const rconfig::Key<int> missing_key("test/key/missing");
+	REQUIRE_THROWS(missing_key.get());
+}
+
+
+
+TEST_CASE("RconfigSave", "[rconfig]")
+{
+	const hz::fs::path dir = hz::fs::temp_directory_path() / "gsc_test_rconfig_save";
+	std::error_code ec;
+	hz::fs::remove_all(dir, ec);
+	REQUIRE(hz::fs::create_directories(dir, ec));
+	const hz::fs::path file = dir / "config.json";
+
+	rconfig::set_data("test/save/value", 1);
+	REQUIRE(rconfig::has_unsaved_changes());
+	REQUIRE(rconfig::save_to_file(file));
+	REQUIRE_FALSE(rconfig::has_unsaved_changes());
+	REQUIRE_FALSE(hz::fs::exists(dir / "config.json.tmp", ec));
+
+	rconfig::set_data("test/save/value", 2);
+	REQUIRE(rconfig::has_unsaved_changes());
+	REQUIRE(rconfig::load_from_file(file));
+	REQUIRE_FALSE(rconfig::has_unsaved_changes());
+	REQUIRE(rconfig::get_data<int>("test/save/value") == 1);
+
+	rconfig::unset_data("test/save");
+	hz::fs::remove_all(dir, ec);
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,68 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/selftest_fleet.h"
+#include <string>
+
+
+
+TEST_CASE("SelfTestFleetControllerKey", "[app][selftest]")
+{
+	SECTION("RAID ports share the controller") {
+		const StorageDevice port1("/dev/sda", std::string("areca,1/2"));
+		const StorageDevice port2("/dev/sda", std::string("areca,7/2"));
+		const StorageDevice other("/dev/sdb", std::string("areca,1/2"));
+		REQUIRE(SelfTestFleet::get_controller_key(port1, {}) == "raid:/dev/sda:areca");
+		REQUIRE(SelfTestFleet::get_controller_key(port1, {}) == SelfTestFleet::get_controller_key(port2, {}));
+		REQUIRE(SelfTestFleet::get_controller_key(port1, {}) != SelfTestFleet::get_controller_key(other, {}));
+	}
+
+	SECTION("The host adapter is the last PCI function in sysfs path") {
+		const StorageDevice drive("/dev/sdc", std::string());
+		const std::string sysfs_path = "/sys/devices/pci0000:00/0000:00:01.0/0000:01:00.0/host0/port-0:0"
+				"/expander-0:0/port-0:0:3/end_device-0:0:3/target0:0:3/0:0:3:0/block/sdc";
+		REQUIRE(SelfTestFleet::get_controller_key(drive, sysfs_path) == "pci:0000:01:00.0");
+		REQUIRE(SelfTestFleet::get_enclosure_key(drive, sysfs_path) == "sas:expander-0:0");
+	}
+
+	SECTION("Standalone drive") {
+		const StorageDevice drive("/dev/sdd", std::string());
+		REQUIRE(SelfTestFleet::get_controller_key(drive, {}) != SelfTestFleet::get_controller_key(StorageDevice("/dev/sde", std::string()), {}));
+		REQUIRE(SelfTestFleet::get_enclosure_key(drive, {}).empty());
+	}
+}
+
+
+
+TEST_CASE("SelfTestFleetEnclosureKey", "[app][selftest]")
+{
+	const StorageDevice drive1("/dev/sg0", std::string("areca,3/1"));
+	const StorageDevice drive2("/dev/sg0", std::string("areca,4/1"));
+	const StorageDevice drive3("/dev/sg0", std::string("areca,3/2"));
+	const StorageDevice noenc("/dev/sg0", std::string("areca,3"));
+	REQUIRE(SelfTestFleet::get_enclosure_key(drive1, {}) == "raid:/dev/sg0:1");
+	REQUIRE(SelfTestFleet::get_enclosure_key(drive1, {}) == SelfTestFleet::get_enclosure_key(drive2, {}));
+	REQUIRE(SelfTestFleet::get_enclosure_key(drive1, {}) != SelfTestFleet::get_enclosure_key(drive3, {}));
+	REQUIRE(SelfTestFleet::get_enclosure_key(noenc, {}).empty());
+}
+
+
+
+
+
+
+/// @}
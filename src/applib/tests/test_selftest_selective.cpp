@@ -0,0 +1,94 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/selftest_selective.h"
+#include "applib/storage_property.h"
+
+
+
+TEST_CASE("SelfTestParseLba", "[app][selftest]")
+{
+	REQUIRE(selftest_parse_lba("39054016") == 39054016);
+	REQUIRE(selftest_parse_lba("39,054,016") == 39054016);
+	REQUIRE(selftest_parse_lba("0x0253eac0") == 39054016);
+	REQUIRE(!selftest_parse_lba("-").has_value());
+	REQUIRE(!selftest_parse_lba("").has_value());
+}
+
+
+
+TEST_CASE("SelfTestErrorLbas", "[app][selftest]")
+{
+	StoragePropertyRepository properties;
+
+	AtaStorageErrorBlock block;
+	block.lba = 5000;
+	properties.add_property(StorageProperty(StoragePropertySection::AtaErrorLog, block));
+	block.lba = 0;  // not reported
+	properties.add_property(StorageProperty(StoragePropertySection::AtaErrorLog, block));
+
+	AtaStorageSelftestEntry entry;
+	entry.lba_of_first_error = "1000";
+	properties.add_property(StorageProperty(StoragePropertySection::SelftestLog, entry));
+	entry.lba_of_first_error = "5000";
+	properties.add_property(StorageProperty(StoragePropertySection::SelftestLog, entry));
+	entry.lba_of_first_error = "-";
+	properties.add_property(StorageProperty(StoragePropertySection::SelftestLog, entry));
+
+	REQUIRE(selftest_get_error_lbas(properties) == std::vector<std::uint64_t>{1000, 5000});
+
+	REQUIRE(!selftest_get_max_lba(properties).has_value());
+	StorageProperty capacity(StoragePropertySection::Info, std::int64_t(4096 * 1000));
+	capacity.generic_name = "user_capacity/bytes";
+	properties.add_property(capacity);
+	REQUIRE(selftest_get_max_lba(properties) == 8000 - 1);
+
+	StorageProperty sector_size(StoragePropertySection::Info, std::string("4096 bytes logical/physical"));
+	sector_size.generic_name = "physical_block_size/_and/logical_block_size";
+	properties.add_property(sector_size);
+	REQUIRE(selftest_get_logical_sector_size(properties) == 4096);
+	REQUIRE(selftest_get_max_lba(properties) == 1000 - 1);
+}
+
+
+
+TEST_CASE("SelfTestPlanSelectiveSpans", "[app][selftest]")
+{
+	// Overlapping and adjacent spans are merged, the ends are clamped
+	REQUIRE(selftest_plan_selective_spans({500, 10, 150, 200}, 50, 520)
+			== std::vector<SelfTestLbaSpan>{{0, 60}, {100, 250}, {450, 520}});
+	REQUIRE(selftest_plan_selective_spans({100, 201}, 50, std::nullopt)
+			== std::vector<SelfTestLbaSpan>{{50, 251}});
+
+	// LBAs past the end are ignored
+	REQUIRE(selftest_plan_selective_spans({100, 2000}, 10, 1000)
+			== std::vector<SelfTestLbaSpan>{{90, 110}});
+
+	// The closest spans are merged to fit the limit
+	const auto spans = selftest_plan_selective_spans({1000, 2000, 2100, 5000, 9000}, 10, std::nullopt, 3);
+	REQUIRE(spans == std::vector<SelfTestLbaSpan>{{990, 2110}, {4990, 5010}, {8990, 9010}});
+	REQUIRE(selftest_get_spans_sector_count(spans) == 1121 + 21 + 21);
+
+	REQUIRE(selftest_plan_selective_spans({}, 10, std::nullopt).empty());
+}
+
+
+
+
+
+
+/// @}
@@ -15,7 +15,23 @@ Copyright:
 // Catch2 v2
 #include "catch2/catch.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include "applib/smartctl_parser.h"
+#include "applib/smartctl_json_parser_helpers.h"
+#include "applib/smartctl_json_ata_parser.h"
+#include "applib/smartctl_json_nvme_parser.h"
+#include "applib/storage_fetch_profile.h"
+#include "applib/smartctl_text_parser_helper.h"
+#include "applib/smartctl_text_ata_parser.h"
+#include "applib/app_regex.h"
+#include "hz/alloc_tracking.h"
+#include "hz/string_algo.h"
 
 
 
@@ -41,6 +57,755 @@ Copyright (C) 2002-20, Bruce Allen, Christian Franke, www.smartmontools.org
 
 
 
+TEST_CASE("SmartctlOutputSignature", "[app][parser]")
+{
+	auto detect_type = [](std::string_view output) {
+		return SmartctlParser::detect_output_signature(output).value().parser_type;
+	};
+
+	REQUIRE(SmartctlParser::detect_output_signature("smart").error().data() == SmartctlParserError::UnsupportedFormat);
+
+	// The embedded text output comes before the device object, its quotes are escaped
+	const auto json = SmartctlParser::detect_output_signature(
+			R"({"smartctl": {"output": ["\"protocol\": \"NVMe\""]}, "device": {"type": "sat", "protocol" : "ATA"}})");
+	REQUIRE(json.value().format == SmartctlOutputFormat::Json);
+	REQUIRE(json.value().parser_type == SmartctlParserType::Ata);
+	REQUIRE(detect_type(R"({"device": {"type": "nvme", "protocol": "NVMe"}})") == SmartctlParserType::Nvme);
+	REQUIRE(detect_type(R"({"device": {"type": "scsi", "protocol": "SCSI"}})") == SmartctlParserType::Basic);
+	REQUIRE(detect_type(R"({"json_format_version": [1, 0]})") == SmartctlParserType::Basic);
+
+	const std::string text_header = "smartctl 7.3 2022-02-28 r5338\n\n=== START OF INFORMATION SECTION ===\n";
+	const auto text = SmartctlParser::detect_output_signature(text_header + "ATA Version is:   ACS-3 T13/2161-D revision 5\n");
+	REQUIRE(text.value().format == SmartctlOutputFormat::Text);
+	REQUIRE(text.value().parser_type == SmartctlParserType::Ata);
+	REQUIRE(detect_type(text_header + "NVMe Version:                       1.3\n") == SmartctlParserType::Nvme);
+	REQUIRE(detect_type(text_header + "Device type:          CD/DVD\n") == SmartctlParserType::Basic);
+	REQUIRE(detect_type(text_header + "Product:              Raid 5 Volume\nATA Version is: 8\n") == SmartctlParserType::Basic);
+	REQUIRE(detect_type(text_header + std::string(10000, ' ') + "ATA Version is: 8\n") == SmartctlParserType::Basic);  // too far
+}
+
+
+
+TEST_CASE("SmartctlOutputContentHash", "[app][parser]")
+{
+	const auto text_hash = SmartctlParser::get_output_content_hash(
+			"Device Model:     ST1000\nLocal Time is:    Tue Aug 29 08:43:00 2017 MSK\nPower_On_Hours 100\n");
+	REQUIRE(text_hash == SmartctlParser::get_output_content_hash(
+			"Device Model:     ST1000\nLocal Time is:    Tue Aug 29 08:44:00 2017 MSK\nPower_On_Hours 100\n"));
+	REQUIRE(text_hash != SmartctlParser::get_output_content_hash(
+			"Device Model:     ST1000\nLocal Time is:    Tue Aug 29 08:44:00 2017 MSK\nPower_On_Hours 101\n"));
+
+	const std::string json = R"({
+  "local_time": {
+    "time_t": 1503985380,
+    "asctime": "Tue Aug 29 08:43:00 2017 MSK"
+  },
+  "temperature": {
+    "current": 35
+  }
+})";
+	std::string json_later = json;
+	hz::string_replace(json_later, "1503985380", "1503985440");
+	hz::string_replace(json_later, "08:43:00", "08:44:00");
+	REQUIRE(SmartctlParser::get_output_content_hash(json) == SmartctlParser::get_output_content_hash(json_later));
+	hz::string_replace(json_later, "35", "36");
+	REQUIRE(SmartctlParser::get_output_content_hash(json) != SmartctlParser::get_output_content_hash(json_later));
+}
+
+
+
+TEST_CASE("SmartctlJsonPath", "[app][parser]")
+{
+	using namespace SmartctlJsonParserHelpers;
+
+	constexpr JsonPath path("/ata_smart_data//self_test/status/");
+	static_assert(path.size() == 3);
+	static_assert(path[0] == "ata_smart_data");
+	static_assert(path[2] == "status");
+
+	const auto root = nlohmann::json::parse(R"({"a": {"b": {"c": 5}, "d": [1, 2]}})");
+
+	REQUIRE(get_node(root, "a/b").value() == &root["a"]["b"]);
+	REQUIRE(get_node_data<int>(root, "a/b/c").value() == 5);
+	REQUIRE(get_node_data<int>(root, "a/x", 7).value() == 7);
+	REQUIRE(get_node(root, "a/x").error().data() == SmartctlJsonParserError::PathNotFound);
+	REQUIRE(get_node(root, "a/b/c/e").error().data() == SmartctlJsonParserError::UnexpectedObjectInPath);
+	REQUIRE(get_node(root, "/").error().data() == SmartctlJsonParserError::EmptyPath);
+	REQUIRE(get_node_data<std::string>(root, "a/d").error().data() == SmartctlJsonParserError::TypeError);
+	REQUIRE(get_node_exists(root, std::string("a/d")).value() == true);
+
+	// Lookups of optional keys
+	REQUIRE(find_node(root, "a/d") == &root["a"]["d"]);
+	REQUIRE(find_node(root, "a/x") == nullptr);
+	REQUIRE(find_node(root, "a/b/c/e") == nullptr);
+	REQUIRE(get_node_data_optional<int>(root, "a/b/c").value() == 5);
+	REQUIRE(get_node_data_optional<double>(root, "a/b/c").value() == 5.);
+	REQUIRE(!get_node_data_optional<int>(root, "a/x").has_value());
+	REQUIRE(!get_node_data_optional<std::string>(root, "a/b/c").has_value());
+	REQUIRE(!get_node_data_optional<bool>(root, "a/b/c").has_value());
+}
+
+
+
+TEST_CASE("SmartctlJsonFieldMapping", "[app][parser]")
+{
+	using namespace SmartctlJsonParserHelpers;
+
+	const auto root = nlohmann::json::parse(R"({"log": {"version": 3, "state": {"string": "Active"}, "enabled": true, "count": "x"}})");
+
+	const JsonFieldMapping fields[] = {
+		{"version", "Version", JsonFieldType::Integer, "Version: {}"},
+		{"state/string", "State", JsonFieldType::String, "State: {}"},
+		{"enabled", "Enabled", JsonFieldType::Bool, "Enabled: {}"},
+		{"count", "Count", JsonFieldType::Integer, ""},  // wrong type
+		{"missing", "Missing", JsonFieldType::Integer, "Missing: {}"},
+		{"total", "Total", JsonFieldType::Integer, "Total: {}", true, false},  // added even if absent
+	};
+
+	std::vector<StorageProperty> properties;
+	std::vector<std::string> lines;
+	REQUIRE(parse_json_fields(root, "log", fields, StoragePropertySection::TemperatureLog, &lines,
+			[&properties](StorageProperty p) { properties.push_back(std::move(p)); }));
+
+	REQUIRE(properties.size() == 5);
+	REQUIRE(properties[0].generic_name == "log/version");
+	REQUIRE(properties[0].section == StoragePropertySection::TemperatureLog);
+	REQUIRE(properties[0].get_value<int64_t>() == 3);
+	REQUIRE(properties[1].get_value<std::string>() == "Active");
+	REQUIRE(properties[2].get_value<bool>());
+	REQUIRE(properties[3].get_value<int64_t>() == 0);
+	REQUIRE(properties[4].generic_name == "log/total");
+	REQUIRE_FALSE(properties[4].show_in_ui);
+	REQUIRE(lines == std::vector<std::string>{"Version: 3", "State: Active", "Enabled: Yes", "Total: 0"});
+
+	properties.clear();
+	REQUIRE_FALSE(parse_json_fields(root, "other", fields, StoragePropertySection::TemperatureLog, nullptr,
+			[&properties](StorageProperty p) { properties.push_back(std::move(p)); }));
+	REQUIRE(properties.size() == 1);  // "total"
+}
+
+
+
+TEST_CASE("SmartctlJsonSkipTextOutput", "[app][parser]")
+{
+	using namespace SmartctlJsonParserHelpers;
+
+	const std::string json = R"({"smartctl": {"version": [7, 3], "output": ["line 1", "line 2"]}, "output": [1]})";
+
+	auto full = parse_json_document(json, true);
+	REQUIRE(full.has_value());
+	REQUIRE(full.value()["smartctl"]["output"].size() == 2);
+
+	auto skipped = parse_json_document(json, false);
+	REQUIRE(skipped.has_value());
+	REQUIRE(!skipped.value()["smartctl"].contains("output"));
+	REQUIRE(skipped.value()["smartctl"]["version"][1] == 3);
+	REQUIRE(skipped.value()["output"].size() == 1);  // only smartctl/output is skipped
+
+	REQUIRE(parse_json_document("{", false).error().data() == SmartctlParserError::SyntaxError);
+}
+
+
+
+TEST_CASE("SmartctlJsonSelftestStatus", "[app][parser]")
+{
+	using namespace SmartctlJsonParserHelpers;
+
+	auto running = parse_json_document(
+			R"({"ata_smart_data": {"self_test": {"status": {"value": 249, "remaining_percent": 90}}}})", false);
+	REQUIRE(running.has_value());
+	auto sse = SmartctlJsonAtaParser::parse_selftest_status(running.value());
+	REQUIRE(sse.has_value());
+	REQUIRE(sse->status == AtaStorageSelftestEntry::Status::InProgress);
+	REQUIRE(sse->remaining_percent == 90);
+
+	auto finished = parse_json_document(R"({"ata_smart_data": {"self_test": {"status": {"value": 0}}}})", false);
+	REQUIRE(SmartctlJsonAtaParser::parse_selftest_status(finished.value())->status == AtaStorageSelftestEntry::Status::CompletedNoError);
+	REQUIRE(SmartctlJsonAtaParser::parse_selftest_status(finished.value())->remaining_percent == -1);
+
+	REQUIRE(!SmartctlJsonAtaParser::parse_selftest_status(parse_json_document("{}", false).value()).has_value());
+
+	REQUIRE(SmartctlJsonNvmeParser::decode_self_test_operation(0) == NvmeSelfTestCurrentOperationType::None);
+	REQUIRE(SmartctlJsonNvmeParser::decode_self_test_operation(2) == NvmeSelfTestCurrentOperationType::ExtendedInProgress);
+	REQUIRE(SmartctlJsonNvmeParser::decode_self_test_operation(5) == NvmeSelfTestCurrentOperationType::Unknown);
+	REQUIRE(SmartctlJsonNvmeParser::decode_self_test_result(7) == NvmeSelfTestResultType::CompletedFailedSegments);
+}
+
+
+
+TEST_CASE("SmartctlTextAtaCleanup", "[app][parser]")
+{
+	const std::string input =
+R"(smartctl 7.2
+Warning! SMART Attribute Data Structure error: invalid SMART checksum.
+=== START OF INFORMATION SECTION ===
+Model: X
+Firmware may need -F samsung or -F samsung2 enabled; see manual for details.
+Warning: ATA error count 10 inconsistent with error log pointer 5
+
+Warning: device does not support SCT Commands
+ATA_READ_LOG_EXT (addr=0x00:0x00, page=0, n=1) failed: 48-bit ATA commands not implemented
+Read SCT Status failed: scsi error aborted command
+Unexpected SCT status 0x0000 (action_code=0, function_code=0)
+Done)";
+
+	const std::string expected =
+R"(smartctl 7.2
+=== START OF INFORMATION SECTION ===
+Model: X
+Warning: ATA error count 10 inconsistent with error log pointer 5
+
+Warning: device does not support SCT Commands
+
+
+
+
+Done)";
+
+	std::vector<std::string> checksum_errors;
+	REQUIRE(SmartctlTextParserHelper::cleanup_ata_output(input, checksum_errors) == expected);
+	REQUIRE(checksum_errors == std::vector<std::string>{"Attribute Data"});
+
+	// dos and mac newlines
+	const std::string dos_input = hz::string_replace_copy(input, "\n", "\r\n");
+	const std::string mac_input = hz::string_replace_copy(input, '\n', '\r');
+	checksum_errors.clear();
+	REQUIRE(SmartctlTextParserHelper::cleanup_ata_output(dos_input, checksum_errors) == expected);
+	checksum_errors.clear();
+	REQUIRE(SmartctlTextParserHelper::cleanup_ata_output(mac_input, checksum_errors) == expected);
+}
+
+
+TEST_CASE("SmartctlTextAtaAttributeTokenizer", "[app][parser]")
+{
+	// The regexps the tokenizer replaced. It must accept the same lines and produce the same columns.
+	const std::string space_re = "[ \\t]+";
+	const std::string old_base_re = R"([ \t]*([0-9]+) ([^ \t\n]+(?:[^0-9\t\n]+)*))" + space_re + "(0x[a-fA-F0-9]+)" + space_re;
+	const std::string brief_base_re = R"([ \t]*([0-9]+) ([^ \t\n]+))" + space_re + "([A-Z+-]{2,})" + space_re;
+	const std::string vals_re = "([0-9-]+)" + space_re + "([0-9-]+)" + space_re + "([0-9-]+)" + space_re;
+	const std::string word_re = "([^ \\t\\n]+)" + space_re;
+	const std::string raw_re = "(.+)[ \\t]*";
+	const auto re_old_up = app_regex_re("/" + old_base_re + vals_re + word_re + word_re + word_re + raw_re + "/mi");
+	const auto re_old_noup = app_regex_re("/" + old_base_re + vals_re + word_re + word_re + raw_re + "/mi");
+	const auto re_brief = app_regex_re("/" + brief_base_re + vals_re + word_re + raw_re + "/mi");
+
+	auto check = [&](SmartctlTextAtaAttributeFormat format, const std::string& line) {
+		std::string id, name, flag, value, worst, threshold, attr_type, update_type, when_failed, raw_value;
+		bool matched = false;
+		switch (format) {
+			case SmartctlTextAtaAttributeFormat::Old:
+				matched = app_regex_full_match(re_old_up, line,
+						{&id, &name, &flag, &value, &worst, &threshold, &attr_type, &update_type, &when_failed, &raw_value});
+				break;
+			case SmartctlTextAtaAttributeFormat::NoUpdated:
+				matched = app_regex_full_match(re_old_noup, line,
+						{&id, &name, &flag, &value, &worst, &threshold, &attr_type, &when_failed, &raw_value});
+				break;
+			case SmartctlTextAtaAttributeFormat::Brief:
+				matched = app_regex_full_match(re_brief, line,
+						{&id, &name, &flag, &value, &worst, &threshold, &when_failed, &raw_value});
+				break;
+		}
+
+		SmartctlTextAtaAttributeFields fields;
+		const bool tokenized = SmartctlTextParserHelper::tokenize_ata_attribute_line(line, format, fields);
+		INFO(line);
+		REQUIRE(tokenized == matched);
+		if (matched) {
+			REQUIRE(fields.id == id);
+			REQUIRE(fields.name == hz::string_trim_copy(name));
+			REQUIRE(fields.flag == flag);
+			REQUIRE(fields.value == value);
+			REQUIRE(fields.worst == worst);
+			REQUIRE(fields.threshold == threshold);
+			REQUIRE(fields.attr_type == attr_type);
+			REQUIRE(fields.update_type == update_type);
+			REQUIRE(fields.when_failed == when_failed);
+			REQUIRE(fields.raw_value == hz::string_trim_copy(raw_value));
+		}
+		return tokenized;
+	};
+
+	using Format = SmartctlTextAtaAttributeFormat;
+
+	REQUIRE(check(Format::Old, "  5 Reallocated_Sector_Ct   0x0032   100   100   ---    Old_age   Always       -       0"));
+	REQUIRE(check(Format::Old, "  9 Power_On_Hours          0x0032   253   100   ---    Old_age   Always       -       1720"));
+	REQUIRE(check(Format::Old, "240 Head flying hours       0x0000   100   253   000    Old_age   Offline      -       3225 (3 105 0)"));
+	REQUIRE(check(Format::Old, "  9 Power_On_Minutes        0x0032   092   092   000    Old_age   Always   FAILING_NOW 1720h+30m  "));  // -v 9,minutes
+	REQUIRE(check(Format::Old, "190 Airflow_Temperature_Cel 0x0022   071   059   045    Old_age   Always   In_the_past 29 (Min/Max 23/41)"));
+	REQUIRE(check(Format::NoUpdated, "  1 Raw_Read_Error_Rate     0x000b   100   100   016    Pre-fail     -       0"));
+	REQUIRE(check(Format::Brief, "  1 Raw_Read_Error_Rate     PO-R--   100   100   062    -    0"));
+	REQUIRE(check(Format::Brief, "194 Temperature_Celsius     -O---K   222   222   000    NOW  27 (Min/Max 12/48)"));
+	REQUIRE(check(Format::Brief, "  5 Reallocated_Sector_Ct   PO--CK   ---   ---   ---    Past 0x0000000000"));
+
+	// Not attribute lines of these formats
+	REQUIRE(!check(Format::Old, "ID# ATTRIBUTE_NAME          FLAG     VALUE WORST THRESH TYPE      UPDATED  WHEN_FAILED RAW_VALUE"));
+	REQUIRE(!check(Format::Old, "  5 Reallocated_Sector_Ct   0x0032   100   100   ---    Old_age   Always       -"));  // no raw value
+	REQUIRE(!check(Format::Old, "  5  Reallocated_Sector_Ct  0x0032   100   100   ---    Old_age   Always       -       0"));  // two spaces after ID
+	REQUIRE(!check(Format::Old, "  5 Unknown Attribute 2     0x0032   100   100   ---    Old_age   Always       -       0"));  // digits in name
+	REQUIRE(!check(Format::Old, "  1 Raw_Read_Error_Rate     PO-R--   100   100   062    -    0"));
+	REQUIRE(!check(Format::Old, "                            ||||||_ K auto-keep"));
+	REQUIRE(!check(Format::NoUpdated, "  5 Reallocated_Sector_Ct   0x0032   100   1x0   ---    Old_age   -       0"));
+	REQUIRE(!check(Format::Brief, "  5 Head flying hours       PO--CK   100   100   000    -    0"));  // spaces in name
+	REQUIRE(!check(Format::Brief, "  5 Reallocated_Sector_Ct   P   100   100   000    -    0"));  // short flags
+	REQUIRE(!check(Format::Brief, ""));
+}
+
+
+
+TEST_CASE("SmartctlTextAtaLogEntries", "[app][parser]")
+{
+	std::string output =
+R"(smartctl 7.2 2020-12-30 r5155 [x86_64-linux-5.3.18] (local build)
+Copyright (C) 2002-20, Bruce Allen, Christian Franke, www.smartmontools.org
+
+=== START OF INFORMATION SECTION ===
+Device Model:     ST1000
+Serial Number:    S1
+
+=== START OF READ SMART DATA SECTION ===
+SMART overall-health self-assessment test result: PASSED
+
+SMART Extended Comprehensive Error Log Version: 1 (1 sectors)
+Device Error Count: 3
+	CR     = Command Register
+	ER     = Error register
+)";
+	for (int i = 3; i >= 1; --i) {
+		output += "\nError " + std::to_string(i) + " [" + std::to_string(i - 1) + "] occurred at disk power-on lifetime: "
+				+ std::to_string(100 * i) + " hours (4 days + 4 hours)\n"
+R"(  When the command that caused the error occurred, the device was active or idle.
+
+  After command completion occurred, registers were:
+  ER -- ST COUNT  LBA_48  LH LM LL DV DC
+  -- -- -- == -- == == == -- -- -- -- --
+  40 -- 51 00 08 00 00 00 6c 1d 80 40 00  Error: UNC at LBA = 0x006c1d80 = 7085440
+
+  Commands leading to the command that caused the error were:
+  CR FEATR COUNT  LBA_48  LH LM LL DV DC  Powered_Up_Time  Command/Feature_Name
+  -- == -- == -- == == == -- -- -- -- --  ---------------  --------------------
+  25 00 00 00 08 00 00 00 6c 1d 80 e0 08     00:10:17.305  READ DMA EXT
+)";
+	}
+	output += R"(
+SMART Extended Self-test Log Version: 1 (1 sectors)
+Num  Test_Description    Status                  Remaining  LifeTime(hours)  LBA_of_first_error
+# 1  Short offline       Completed: read failure       90%       300         7085440
+# 2  Short offline       Completed without error       00%       200         -
+# 3  Extended offline    Aborted by host               80%       100         -
+)";
+
+	auto parse = [&output](std::size_t max_log_entries) {
+		SmartctlTextAtaParser parser;
+		parser.set_max_log_entries(max_log_entries);
+		REQUIRE(parser.parse(output).has_value());
+		return parser.take_property_repository();
+	};
+
+	{
+		const StoragePropertyRepository repo = parse(0);
+		REQUIRE(repo.lookup_property("ata_smart_error_log/extended/count").get_value<int64_t>() == 3);
+		const auto error = repo.lookup_property("Error 2").get_value<AtaStorageErrorBlock>();
+		REQUIRE(error.error_num == 2);
+		REQUIRE(error.lifetime_hours == 200);
+		REQUIRE(error.device_state == "active or idle");
+		REQUIRE(error.reported_types == std::vector<std::string>{"UNC"});
+		REQUIRE(error.type_more_info == "at LBA = 0x006c1d80 = 7085440");
+		REQUIRE(hz::string_ends_with(repo.lookup_property("Error 1").reported_value, "READ DMA EXT"));
+
+		const auto entry = repo.lookup_property("ata_smart_self_test_log/entry/3").get_value<AtaStorageSelftestEntry>();
+		REQUIRE(entry.status == AtaStorageSelftestEntry::Status::AbortedByHost);
+		REQUIRE(entry.remaining_percent == 80);
+		REQUIRE(repo.lookup_property("ata_smart_self_test_log/entry/1").get_value<AtaStorageSelftestEntry>().lba_of_first_error == "7085440");
+		REQUIRE(repo.lookup_property("ata_smart_self_test_log/extended/table/count").get_value<int64_t>() == 3);
+	}
+
+	// Only the most recent entries are stored, the counts stay
+	{
+		const StoragePropertyRepository repo = parse(2);
+		REQUIRE(!repo.lookup_property("Error 3").empty());
+		REQUIRE(!repo.lookup_property("Error 2").empty());
+		REQUIRE(repo.lookup_property("Error 1").empty());
+		REQUIRE(repo.lookup_property("ata_smart_error_log/extended/count").get_value<int64_t>() == 3);
+		REQUIRE(!repo.lookup_property("ata_smart_self_test_log/entry/2").empty());
+		REQUIRE(repo.lookup_property("ata_smart_self_test_log/entry/3").empty());
+		REQUIRE(repo.lookup_property("ata_smart_self_test_log/extended/table/count").get_value<int64_t>() == 3);
+	}
+}
+
+
+
+TEST_CASE("SmartctlSctTemperatureHistory", "[app][parser]")
+{
+	const std::string text_output =
+R"(smartctl 7.2 2020-12-30 r5155 [x86_64-linux-5.3.18] (local build)
+Copyright (C) 2002-20, Bruce Allen, Christian Franke, www.smartmontools.org
+
+=== START OF INFORMATION SECTION ===
+Device Model:     ST1000
+Serial Number:    S1
+
+=== START OF READ SMART DATA SECTION ===
+SMART overall-health self-assessment test result: PASSED
+
+SCT Status Version:                  3
+SCT Version (vendor specific):       258 (0x0102)
+Device State:                        Active (0)
+Current Temperature:                    39 Celsius
+
+SCT Temperature History Version:     2
+Temperature Sampling Period:         1 minute
+Temperature Logging Interval:        2 minutes
+Temperature History Size (Index):    8 (2)
+
+Index    Estimated Time   Temperature Celsius
+   3    2017-08-29 12:00    30  ***
+ ...    ..(  3 skipped).    ..  ***
+   7    2017-08-29 12:08    31  ***
+   0    2017-08-29 12:10     ?  -
+   1    2017-08-29 12:12    33  ***
+   2    2017-08-29 12:14    34  ***
+)";
+
+	SmartctlTextAtaParser text_parser;
+	REQUIRE(text_parser.parse(text_output).has_value());
+	const auto* text_p = text_parser.get_property_repository().find_property("ata_sct_temperature_history/table");
+	REQUIRE(text_p != nullptr);
+	REQUIRE(!text_p->show_in_ui);
+	const auto& text_history = text_p->get_value<AtaStorageTemperatureHistory>();
+	REQUIRE(text_history.logging_interval_minutes == 2);
+	REQUIRE(text_history.write_index == 2);
+	REQUIRE(text_history.samples == std::vector<std::int8_t>{
+			AtaStorageTemperatureHistory::unknown_temperature, 33, 34, 30, 30, 30, 30, 31});
+	REQUIRE(text_history.get_oldest_index() == 3);
+	REQUIRE(text_history.get_known_count() == 7);
+
+	std::vector<std::pair<std::int64_t, std::int8_t>> text_samples;
+	text_history.for_each_known_sample([&text_samples](std::int64_t time, std::int8_t temperature) {
+		text_samples.emplace_back(time, temperature);
+	});
+	REQUIRE(text_samples.size() == 7);
+	REQUIRE(text_samples.front().second == 30);
+	REQUIRE(text_samples.back() == std::pair<std::int64_t, std::int8_t>(text_history.newest_time, 34));
+	REQUIRE(text_samples.back().first - text_samples.front().first == 7 * 2 * 60);
+
+	const std::string json_output = R"({
+		"json_format_version": [1, 0],
+		"smartctl": {"version": [7, 3], "exit_status": 0},
+		"device": {"name": "/dev/sda", "type": "sat", "protocol": "ATA"},
+		"model_name": "ST1000",
+		"local_time": {"time_t": 1000000},
+		"ata_sct_status": {"temperature": {"current": 34}},
+		"ata_sct_temperature_history": {"version": 2, "logging_interval_minutes": 2, "size": 4, "index": 1,
+				"table": [30, null, 33, 34]}
+	})";
+
+	SmartctlJsonAtaParser json_parser;
+	REQUIRE(json_parser.parse(json_output).has_value());
+	const auto* json_p = json_parser.get_property_repository().find_property("ata_sct_temperature_history/table");
+	REQUIRE(json_p != nullptr);
+	const auto& json_history = json_p->get_value<AtaStorageTemperatureHistory>();
+	REQUIRE(json_history.newest_time == 1000000);
+	REQUIRE(json_history.logging_interval_minutes == 2);
+	REQUIRE(json_history.get_known_count() == 3);
+
+	std::vector<std::pair<std::int64_t, std::int8_t>> json_samples;
+	json_history.for_each_known_sample([&json_samples](std::int64_t time, std::int8_t temperature) {
+		json_samples.emplace_back(time, temperature);
+	});
+	REQUIRE(json_samples == std::vector<std::pair<std::int64_t, std::int8_t>>{
+			{1000000 - 3 * 120, 30}, {1000000 - 120, 33}, {1000000, 34}});
+}
+
+
+
+TEST_CASE("SmartctlTextAtaSubsectionCache", "[app][parser]")
+{
+	const std::string output =
+R"(smartctl 7.2 2020-12-30 r5155 [x86_64-linux-5.3.18] (local build)
+Copyright (C) 2002-20, Bruce Allen, Christian Franke, www.smartmontools.org
+
+=== START OF INFORMATION SECTION ===
+Device Model:     ST1000
+Serial Number:    S1
+
+=== START OF READ SMART DATA SECTION ===
+SMART overall-health self-assessment test result: PASSED
+
+SMART Attributes Data Structure revision number: 10
+Vendor Specific SMART Attributes with Thresholds:
+ID# ATTRIBUTE_NAME          FLAGS    VALUE WORST THRESH FAIL RAW_VALUE
+194 Temperature_Celsius     -O---K   100   100   000    -    35
+
+SMART Error Log Version: 1
+No Errors Logged
+)";
+	const std::string changed_output = hz::string_replace_copy(output, "-    35", "-    36");
+
+	auto parse = [](const std::string& text, const std::shared_ptr<SmartctlTextAtaSubsectionCache>& cache) {
+		SmartctlTextAtaParser parser;
+		parser.set_subsection_cache(cache);
+		static_cast<void>(parser.parse(text));
+		std::vector<std::string> values;
+		for (const auto& p : parser.get_property_repository().get_properties()) {
+			values.push_back(p.generic_name + "=" + p.format_value());
+		}
+		return values;
+	};
+
+	auto cache = std::make_shared<SmartctlTextAtaSubsectionCache>();
+	const auto first = parse(output, cache);
+	REQUIRE(cache->get_reused_count() == 0);
+	REQUIRE(first == parse(output, nullptr));
+
+	// Same output: all the subsections are reused
+	REQUIRE(parse(output, cache) == first);
+	REQUIRE(cache->get_reused_count() == 3);
+
+	// Only the attributes are parsed again
+	const auto changed = parse(changed_output, cache);
+	REQUIRE(cache->get_reused_count() == 2);
+	REQUIRE(changed == parse(changed_output, nullptr));
+	REQUIRE(changed != first);
+}
+
+
+
+TEST_CASE("SmartctlTextAtaPropertyNames", "[app][parser]")
+{
+	const std::string output =
+R"(smartctl 7.2 2020-12-30 r5155 [x86_64-linux-5.3.18] (local build)
+Copyright (C) 2002-20, Bruce Allen, Christian Franke, www.smartmontools.org
+
+=== START OF INFORMATION SECTION ===
+Device Model:     ST1000
+SERIAL NUMBER:    S1
+User Capacity:    500,107,862,016 bytes [500 GB]
+Rotation Rate:    7200 rpm
+Device is:        Not in smartctl database 7.3/5319
+SMART support is: Available - device has SMART capability.
+SMART support is: Disabled
+Power mode was:   STANDBY
+Some Future Property: hello
+
+=== START OF READ SMART DATA SECTION ===
+SMART overall-health self-assessment test result: PASSED
+
+General SMART Values:
+Off-line data collection status:  (0x82)	Offline data collection activity
+					was completed without error.
+Total time to complete Offline 
+data collection: 		(  430) seconds.
+Extended self-test routine
+recommended polling time: 	 ( 163) minutes.
+)";
+
+	SmartctlTextAtaParser parser;
+	REQUIRE(parser.parse(output));
+	const auto& repository = parser.get_property_repository();
+
+	auto find = [&repository](const std::string& generic_name) {
+		const auto* p = repository.find_property(generic_name);
+		REQUIRE(p);
+		return p;
+	};
+
+	// The names are matched caselessly
+	REQUIRE(find("model_name")->get_value<std::string>() == "ST1000");
+	REQUIRE(find("serial_number")->get_value<std::string>() == "S1");
+	REQUIRE(find("user_capacity/bytes")->get_value<int64_t>() == 500'107'862'016);
+	REQUIRE(find("rotation_rate")->get_value<int64_t>() == 7200);
+	REQUIRE_FALSE(find("in_smartctl_database")->get_value<bool>());
+	REQUIRE(find("smart_support/available")->get_value<bool>());
+	REQUIRE_FALSE(find("smart_support/enabled")->get_value<bool>());
+	REQUIRE(find("_text_only/power_mode")->get_value<std::string>() == "STANDBY");
+
+	// Unknown properties are kept as strings under their own names
+	REQUIRE(find("Some Future Property")->get_value<std::string>() == "hello");
+
+	// "Off-line" is the old spelling of "Offline"
+	REQUIRE(find("ata_smart_data/offline_data_collection/status/_group"));
+	REQUIRE(find("ata_smart_data/offline_data_collection/completion_seconds")->get_value<std::chrono::seconds>()
+			== std::chrono::seconds(430));
+	REQUIRE(find("ata_smart_data/self_test/polling_minutes/extended")->get_value<std::chrono::seconds>()
+			== std::chrono::minutes(163));
+}
+
+
+
+TEST_CASE("SmartctlParallelSectionParsing", "[app][parser]")
+{
+	const std::string text_output =
+R"(smartctl 7.2 2020-12-30 r5155 [x86_64-linux-5.3.18] (local build)
+Copyright (C) 2002-20, Bruce Allen, Christian Franke, www.smartmontools.org
+
+=== START OF INFORMATION SECTION ===
+Device Model:     ST1000
+Serial Number:    S1
+
+=== START OF READ SMART DATA SECTION ===
+SMART overall-health self-assessment test result: PASSED
+
+SMART Attributes Data Structure revision number: 10
+Vendor Specific SMART Attributes with Thresholds:
+ID# ATTRIBUTE_NAME          FLAGS    VALUE WORST THRESH FAIL RAW_VALUE
+194 Temperature_Celsius     -O---K   100   100   000    -    35
+
+SMART Error Log Version: 1
+No Errors Logged
+
+SMART Self-test log structure revision number 1
+Num  Test_Description    Status                  Remaining  LifeTime(hours)  LBA_of_first_error
+# 1  Short offline       Completed without error       00%     12345         -
+)";
+
+	const std::string json_output = R"({
+		"smartctl": {"version": [7, 3]},
+		"model_name": "X",
+		"temperature": {"current": 35},
+		"smart_status": {"passed": true},
+		"ata_smart_attributes": {"revision": 10, "table": [{"id": 194, "name": "Temperature_Celsius", "value": 100,
+			"worst": 100, "thresh": 0, "flags": {"value": 34, "string": "-O---K ", "prefailure": false},
+			"raw": {"value": 35, "string": "35"}}]},
+		"ata_smart_self_test_log": {"standard": {"revision": 1}}
+	})";
+
+	auto parse = [](SmartctlOutputFormat format, const std::string& output, std::size_t parallel_min_size) {
+		auto parser = SmartctlParser::create(SmartctlParserType::Ata, format);
+		parser->set_parallel_parse_min_size(parallel_min_size);
+		static_cast<void>(parser->parse(output));
+		std::vector<std::string> values;
+		for (const auto& p : parser->get_property_repository().get_properties()) {
+			values.push_back(p.generic_name + "=" + p.format_value());
+		}
+		return values;
+	};
+
+	// The same properties in the same order
+	for (const auto format : {SmartctlOutputFormat::Text, SmartctlOutputFormat::Json}) {
+		const std::string& output = (format == SmartctlOutputFormat::Text ? text_output : json_output);
+		const auto sequential = parse(format, output, 0);
+		REQUIRE(sequential.size() > 5);
+		REQUIRE(parse(format, output, 1) == sequential);
+	}
+}
+
+
+
+TEST_CASE("SmartctlJsonRequestedSections", "[app][parser]")
+{
+	const std::string json = R"({
+		"smartctl": {"version": [7, 3]},
+		"model_name": "X",
+		"temperature": {"current": 35},
+		"smart_status": {"passed": true},
+		"ata_smart_self_test_log": {"standard": {"revision": 1}}
+	})";
+
+	auto full_parser = SmartctlParser::create(SmartctlParserType::Ata, SmartctlOutputFormat::Json);
+	REQUIRE(full_parser->parse(json).has_value());
+	REQUIRE(full_parser->get_property_repository().has_properties_for_section(StoragePropertySection::SelftestLog));
+
+	auto parser = SmartctlParser::create(SmartctlParserType::Ata, SmartctlOutputFormat::Json);
+	parser->set_requested_sections(storage_fetch_profile_get_sections(StorageFetchProfile::Monitoring));
+	REQUIRE(!parser->get_section_requested(StoragePropertySection::SelftestLog));
+	REQUIRE(parser->get_section_requested(StoragePropertySection::Info));
+	REQUIRE(parser->parse(json).has_value());
+	REQUIRE(!parser->get_property_repository().has_properties_for_section(StoragePropertySection::SelftestLog));
+	REQUIRE(parser->get_property_repository().has_properties_for_section(StoragePropertySection::OverallHealth));
+	REQUIRE(parser->get_property_repository().lookup_property("temperature/current").get_value<int64_t>() == 35);
+
+	REQUIRE(storage_fetch_profile_get_sections(StorageFetchProfile::Full).empty());
+	REQUIRE(storage_fetch_profile_get_smartctl_options(StorageFetchProfile::Monitoring, StorageDeviceDetectedType::Nvme)
+			== std::vector<std::string>{"--health", "--info", "--attributes"});
+}
+
+
+namespace {
+
+	/// Attributes of the allocation budget test outputs: id, name, raw value
+	const std::vector<std::tuple<int, std::string, std::int64_t>> budget_ssd_attributes = {
+		{1, "Raw_Read_Error_Rate", 0}, {5, "Reallocated_Sector_Ct", 0}, {9, "Power_On_Hours", 12345},
+		{12, "Power_Cycle_Count", 321}, {177, "Wear_Leveling_Count", 12}, {179, "Used_Rsvd_Blk_Cnt_Tot", 0},
+		{181, "Program_Fail_Cnt_Total", 0}, {182, "Erase_Fail_Count_Total", 0}, {183, "Runtime_Bad_Block", 0},
+		{187, "Uncorrectable_Error_Cnt", 0}, {190, "Airflow_Temperature_Cel", 35}, {195, "ECC_Error_Rate", 0},
+		{199, "CRC_Error_Count", 0}, {235, "POR_Recovery_Count", 20}, {241, "Total_LBAs_Written", 987654321},
+	};
+
+
+	/// Parse \c output with the ATA parser, returning the number of allocations (0 if not tracked)
+	std::uint64_t get_ata_parse_allocations(SmartctlOutputFormat format, const std::string& output)
+	{
+		auto parser = SmartctlParser::create(SmartctlParserType::Ata, format);
+		REQUIRE(parser);
+		const hz::AllocTrackingScope allocs;
+		REQUIRE(parser->parse(output).has_value());
+		const std::uint64_t count = allocs.get_stats().count;
+		REQUIRE(parser->get_property_repository().has_properties_for_section(StoragePropertySection::AtaAttributes));
+		return count;
+	}
+
+}
+
+
+
+// Allocation budgets of parsing typical SSD outputs. They're checked only if test_all
+// is built with APP_TEST_ALLOCATION_TRACKING. If a budget is exceeded, check whether the
+// new allocations are really needed before raising it.
+TEST_CASE("SmartctlParserAllocationBudget", "[app][parser][allocations]")
+{
+	std::string json = R"({"json_format_version": [1, 0], "smartctl": {"version": [7, 3], "exit_status": 0},
+		"device": {"name": "/dev/sda", "info_name": "/dev/sda [SAT]", "type": "sat", "protocol": "ATA"},
+		"model_name": "Budget SSD", "serial_number": "S1", "firmware_version": "1.0",
+		"user_capacity": {"blocks": 1953525168, "bytes": 1000204886016}, "logical_block_size": 512,
+		"physical_block_size": 512, "rotation_rate": 0, "smart_support": {"available": true, "enabled": true},
+		"smart_status": {"passed": true}, "temperature": {"current": 35},
+		"power_on_time": {"hours": 12345}, "power_cycle_count": 321,
+		"ata_smart_attributes": {"revision": 1, "table": [)";
+	std::string text = "smartctl 7.3 2022-02-28 r5338 [x86_64-linux-6.8.0] (local build)\n"
+			"Copyright (C) 2002-22, Bruce Allen, Christian Franke, www.smartmontools.org\n\n"
+			"=== START OF INFORMATION SECTION ===\n"
+			"Device Model:     Budget SSD\n"
+			"Serial Number:    S1\n"
+			"Firmware Version: 1.0\n"
+			"User Capacity:    1,000,204,886,016 bytes [1.00 TB]\n"
+			"Sector Size:      512 bytes logical/physical\n"
+			"Rotation Rate:    Solid State Device\n"
+			"SMART support is: Available - device has SMART capability.\n"
+			"SMART support is: Enabled\n\n"
+			"=== START OF READ SMART DATA SECTION ===\n"
+			"SMART overall-health self-assessment test result: PASSED\n\n"
+			"SMART Attributes Data Structure revision number: 1\n"
+			"Vendor Specific SMART Attributes with Thresholds:\n"
+			"ID# ATTRIBUTE_NAME          FLAGS    VALUE WORST THRESH FAIL RAW_VALUE\n";
+	for (std::size_t i = 0; i < budget_ssd_attributes.size(); ++i) {
+		const auto& [id, name, raw] = budget_ssd_attributes[i];
+		json += (i == 0 ? "" : ",") + std::string(R"({"id": )") + std::to_string(id) + R"(, "name": ")" + name
+				+ R"(", "value": 100, "worst": 99, "thresh": 10, "when_failed": "", "flags": {"value": 50, "string": "-O--CK ",)"
+				+ R"( "prefailure": false, "updated_online": true, "performance": false, "error_rate": false,)"
+				+ R"( "event_count": true, "auto_keep": true}, "raw": {"value": )" + std::to_string(raw)
+				+ R"(, "string": ")" + std::to_string(raw) + R"("}})";
+		std::string line = std::to_string(id);
+		line.insert(0, 3 - line.size(), ' ');
+		line += " " + name;
+		line.resize(28, ' ');
+		text += line + "-O--CK   100   099   010    -    " + std::to_string(raw) + "\n";
+	}
+	json += "]}}";
+
+	const std::uint64_t json_allocs = get_ata_parse_allocations(SmartctlOutputFormat::Json, json);
+	const std::uint64_t text_allocs = get_ata_parse_allocations(SmartctlOutputFormat::Text, text);
+
+	if (hz::alloc_tracking_get_installed()) {
+		INFO("JSON: " << json_allocs << " allocations, text: " << text_allocs << " allocations");
+		REQUIRE(json_allocs < 2000);
+		REQUIRE(text_allocs < 15000);
+	}
+}
+
+
+
+
 /// @}
 
 
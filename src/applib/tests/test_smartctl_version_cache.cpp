@@ -0,0 +1,61 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "applib/smartctl_version_cache.h"
+
+
+
+TEST_CASE("SmartctlVersionCache", "[app][parser]")
+{
+	rconfig::set_default_data("system/smartctl_version_cache", rconfig::json::object());
+
+	const hz::fs::path dir = hz::fs::temp_directory_path() / "gsc_test_smartctl_version_cache";
+	std::error_code ec;
+	hz::fs::remove_all(dir, ec);
+	REQUIRE(hz::fs::create_directories(dir, ec));
+	const hz::fs::path binary = dir / "smartctl";
+	REQUIRE(!hz::fs_file_put_contents(binary, "binary"));
+
+	REQUIRE_FALSE(smartctl_version_cache_get_stamp(dir / "missing").has_value());
+
+	const auto stamp = smartctl_version_cache_get_stamp(binary);
+	REQUIRE(stamp.has_value());
+	REQUIRE(stamp->size == 6);
+	REQUIRE_FALSE(smartctl_version_cache_lookup(stamp.value()).has_value());
+
+	smartctl_version_cache_store(stamp.value(), {"7.4", "smartctl 7.4 2023-08-01 r5530"});
+	const auto info = smartctl_version_cache_lookup(stamp.value());
+	REQUIRE(info.has_value());
+	REQUIRE(info->version == "7.4");
+	REQUIRE(info->version_full == "smartctl 7.4 2023-08-01 r5530");
+
+	// An upgraded binary is probed again
+	REQUIRE(!hz::fs_file_put_contents(binary, "new binary"));
+	const auto new_stamp = smartctl_version_cache_get_stamp(binary);
+	REQUIRE(new_stamp.has_value());
+	REQUIRE_FALSE(smartctl_version_cache_lookup(new_stamp.value()).has_value());
+
+	rconfig::unset_data("system/smartctl_version_cache");
+	hz::fs::remove_all(dir, ec);
+}
+
+
+
+
+
+/// @}
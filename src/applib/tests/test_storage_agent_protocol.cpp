@@ -0,0 +1,173 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_agent_protocol.h"
+#include "applib/storage_property_diff.h"
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+	/// Create a repository with a temperature property
+	StoragePropertyRepository make_repository(std::int64_t temperature)
+	{
+		StoragePropertyRepository repo;
+		for (int i = 0; i < 20; ++i) {
+			StorageProperty p(StoragePropertySection::Info, std::string("value ") + std::to_string(i));
+			p.set_name("info_" + std::to_string(i), "Info " + std::to_string(i));
+			repo.add_property(std::move(p));
+		}
+		StorageProperty temp(StoragePropertySection::TemperatureLog, temperature);
+		temp.set_name("temperature/current", "Current Temperature");
+		repo.add_property(std::move(temp));
+		return repo;
+	}
+
+}
+
+
+
+TEST_CASE("StorageAgentStream", "[app][agent]")
+{
+	StorageAgentStreamEncoder encoder;
+	std::string stream = encoder.encode_start("host1");
+	stream += encoder.encode_drive(1, "/dev/sda", "sat");
+	stream += encoder.encode_update(1, make_repository(30));
+	const std::size_t snapshot_end = stream.size();
+
+	REQUIRE(encoder.encode_update(1, make_repository(30)).empty());  // unchanged
+
+	const std::string delta = encoder.encode_update(1, make_repository(31));
+	REQUIRE(!delta.empty());
+	REQUIRE(delta.size() * 4 < snapshot_end);
+	stream += delta;
+	stream += encoder.encode_error(1, "Error");
+
+	REQUIRE(encoder.get_stats().snapshots == 1);
+	REQUIRE(encoder.get_stats().deltas == 1);
+	REQUIRE(encoder.get_stats().unchanged == 1);
+
+	// Feed byte by byte, as from a pipe
+	StorageAgentStreamDecoder decoder;
+	for (std::size_t i = 0; i < snapshot_end; ++i) {
+		REQUIRE(decoder.feed(std::string_view(stream).substr(i, 1)));
+	}
+	REQUIRE(decoder.get_host_name() == "host1");
+	REQUIRE(decoder.get_drives().size() == 1);
+	REQUIRE(decoder.get_drives().at(1).device == "/dev/sda");
+	REQUIRE(decoder.get_drives().at(1).type_argument == "sat");
+	REQUIRE(decoder.get_drives().at(1).sequence == 1);
+	REQUIRE(decoder.take_changed_drives() == std::vector<std::uint64_t>{1});
+
+	REQUIRE(decoder.feed(std::string_view(stream).substr(snapshot_end, delta.size())));
+	const StorageAgentDrive& drive = decoder.get_drives().at(1);
+	REQUIRE(drive.sequence == 2);
+	REQUIRE(storage_property_repository_diff(drive.repository, make_repository(31)).empty());
+	REQUIRE(decoder.take_changed_drives() == std::vector<std::uint64_t>{1});
+
+	REQUIRE(decoder.feed(std::string_view(stream).substr(snapshot_end + delta.size())));
+	REQUIRE(decoder.get_drives().at(1).error == "Error");
+	REQUIRE(decoder.get_drives().at(1).sequence == 2);  // the data is kept
+}
+
+
+
+TEST_CASE("StorageAgentStreamSummary", "[app][agent]")
+{
+	StoragePropertyRepository repo = make_repository(30);
+	StorageProperty model(StoragePropertySection::Info, std::string("ST1000"));
+	model.set_name("model_name", "Device Model");
+	repo.add_property(std::move(model));
+	StorageProperty health(StoragePropertySection::OverallHealth, false);
+	health.set_name("smart_status/passed", "Overall Health Self-Assessment Test");
+	health.warning_level = WarningLevel::Alert;
+	repo.add_property(std::move(health));
+
+	const auto summary = StorageAgentDriveSummary::get_from_properties(repo);
+	REQUIRE(summary.model == "ST1000");
+	REQUIRE(summary.health == StorageAgentDriveHealth::Failed);
+	REQUIRE(summary.worst_warning == WarningLevel::Alert);
+	REQUIRE(summary.temperature == 30);
+	REQUIRE(!summary.power_on_hours.has_value());
+
+	auto loaded = storage_agent_summary_load(storage_agent_summary_save(summary));
+	REQUIRE(loaded);
+	REQUIRE(loaded.value() == summary);
+	REQUIRE(!storage_agent_summary_load("\x05ab"));
+
+	StorageAgentStreamEncoder encoder;
+	std::string stream = encoder.encode_start("host1");
+	stream += encoder.encode_drive(1, "/dev/sda", "sat");
+	stream += encoder.encode_update(1, repo);
+	stream += encoder.encode_update(1, make_repository(31));
+	REQUIRE(encoder.get_stats().summaries == 2);
+
+	// The repositories are not kept, the summaries follow the deltas
+	StorageAgentStreamDecoder decoder(StorageAgentDecoderMode::Summary);
+	REQUIRE(decoder.feed(stream));
+	const StorageAgentDrive& drive = decoder.get_drives().at(1);
+	REQUIRE(drive.sequence == 2);
+	REQUIRE(drive.repository.get_properties().empty());
+	REQUIRE(drive.summary.temperature == 31);
+	REQUIRE(drive.summary.worst_warning == WarningLevel::None);
+
+	// Full decoders get them too
+	StorageAgentStreamDecoder full_decoder;
+	REQUIRE(full_decoder.feed(stream));
+	REQUIRE(full_decoder.get_drives().at(1).summary == drive.summary);
+	REQUIRE(!full_decoder.get_drives().at(1).repository.get_properties().empty());
+}
+
+
+
+TEST_CASE("StorageAgentStreamInvalid", "[app][agent]")
+{
+	{
+		StorageAgentStreamDecoder decoder;
+		REQUIRE(!decoder.feed("not an agent stream"));
+		REQUIRE(!decoder.feed(""));  // stays failed
+	}
+
+	StorageAgentStreamEncoder encoder;
+	const std::string start = encoder.encode_start("host1");
+	const std::string drive = encoder.encode_drive(1, "/dev/sda", "");
+	const std::string snapshot = encoder.encode_update(1, make_repository(30));
+	const std::string delta = encoder.encode_update(1, make_repository(31));
+
+	// Data for an unannounced drive
+	{
+		StorageAgentStreamDecoder decoder;
+		const auto status = decoder.feed(start + snapshot);
+		REQUIRE(!status);
+		REQUIRE(status.error().data() == StorageAgentStreamError::UnknownDrive);
+	}
+
+	// A missed snapshot
+	{
+		StorageAgentStreamDecoder decoder;
+		const auto status = decoder.feed(start + drive + delta);
+		REQUIRE(!status);
+		REQUIRE(status.error().data() == StorageAgentStreamError::SequenceMismatch);
+	}
+}
+
+
+
+
+/// @}
@@ -0,0 +1,135 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_alerts.h"
+#include "applib/storage_property.h"
+
+
+
+namespace {
+
+	/// Create a reallocated sector count attribute property
+	StorageProperty make_reallocated(std::int64_t raw_value, WarningLevel warning)
+	{
+		AtaStorageAttribute attr;
+		attr.id = 5;
+		attr.raw_value_int = raw_value;
+		StorageProperty p(StoragePropertySection::AtaAttributes, attr);
+		p.generic_name = "attr_reallocated_sector_count";
+		p.displayable_name = "Reallocated Sector Count";
+		p.warning_level = warning;
+		return p;
+	}
+
+	/// Create a change
+	StoragePropertyChange make_change(std::optional<StorageProperty> old_property, std::optional<StorageProperty> new_property)
+	{
+		StoragePropertyChange change;
+		change.type = (!old_property ? StoragePropertyChange::Type::Added
+				: (!new_property ? StoragePropertyChange::Type::Removed : StoragePropertyChange::Type::Changed));
+		change.old_property = std::move(old_property);
+		change.new_property = std::move(new_property);
+		return change;
+	}
+
+	/// All the rules
+	const std::set<StorageAlertRule> all_rules = {
+		StorageAlertRule::WarningAlert, StorageAlertRule::ReallocatedIncrease, StorageAlertRule::SelfTestFailure};
+
+}
+
+
+
+TEST_CASE("StorageAlertEvaluate", "[app][alerts]")
+{
+	StoragePropertyDiff diff;
+	diff.changes.push_back(make_change(make_reallocated(0, WarningLevel::None), make_reallocated(8, WarningLevel::Alert)));
+
+	auto events = storage_alert_evaluate(diff, all_rules, "S1", 1000);
+	REQUIRE(events.size() == 2);
+	REQUIRE(events[0].rule == StorageAlertRule::WarningAlert);
+	REQUIRE(events[1].rule == StorageAlertRule::ReallocatedIncrease);
+	REQUIRE(events[1].drive == "S1");
+	REQUIRE(events[1].time == 1000);
+
+	// Already in Alert: only the increase is reported
+	diff.changes = {make_change(make_reallocated(8, WarningLevel::Alert), make_reallocated(9, WarningLevel::Alert))};
+	events = storage_alert_evaluate(diff, all_rules, "S1", 2000);
+	REQUIRE(events.size() == 1);
+	REQUIRE(events[0].rule == StorageAlertRule::ReallocatedIncrease);
+
+	// Disabled rules and decreases are ignored
+	REQUIRE(storage_alert_evaluate(diff, {StorageAlertRule::SelfTestFailure}, "S1", 2000).empty());
+	diff.changes = {make_change(make_reallocated(9, WarningLevel::None), make_reallocated(1, WarningLevel::None))};
+	REQUIRE(storage_alert_evaluate(diff, all_rules, "S1", 2000).empty());
+
+	// The latest NVMe self-test failed
+	NvmeStorageSelftestEntry entry;
+	entry.test_num = 1;
+	entry.result = NvmeSelfTestResultType::CompletedFailedSegments;
+	diff.changes = {make_change(std::nullopt, StorageProperty(StoragePropertySection::SelftestLog, entry))};
+	events = storage_alert_evaluate(diff, all_rules, "S1", 3000);
+	REQUIRE(events.size() == 1);
+	REQUIRE(events[0].rule == StorageAlertRule::SelfTestFailure);
+}
+
+
+
+TEST_CASE("StorageAlertDispatcher", "[app][alerts]")
+{
+	StorageAlertDispatcher dispatcher;
+	dispatcher.set_rule_debounce(StorageAlertRule::ReallocatedIncrease, 3600);
+	dispatcher.set_drive_debounce(300);
+	dispatcher.set_batch_interval(60);
+	dispatcher.set_max_batch_size(3);
+
+	// Alerts raised together are kept, repeated ones are dropped
+	REQUIRE(dispatcher.add({StorageAlertRule::ReallocatedIncrease, "S1", "", 1000}));
+	REQUIRE(dispatcher.add({StorageAlertRule::WarningAlert, "S1", "", 1000}));
+	REQUIRE(!dispatcher.add({StorageAlertRule::SelfTestFailure, "S1", "", 1100}));  // drive debounce
+	REQUIRE(!dispatcher.add({StorageAlertRule::ReallocatedIncrease, "S1", "", 2000}));  // rule debounce
+	REQUIRE(dispatcher.add({StorageAlertRule::WarningAlert, "S1", "", 2000}));
+	REQUIRE(dispatcher.take_dropped_count() == 2);
+	REQUIRE(dispatcher.take_dropped_count() == 0);
+
+	// The batch is delivered when it's full
+	REQUIRE(dispatcher.take_batch(1000).size() == 3);
+	REQUIRE(dispatcher.take_batch(1000).empty());
+
+	// ... or when the batch interval passes
+	REQUIRE(dispatcher.add({StorageAlertRule::WarningAlert, "S2", "", 5000}));
+	REQUIRE(dispatcher.take_batch(5030).empty());
+	REQUIRE(dispatcher.take_batch(5060).size() == 1);
+
+	REQUIRE(dispatcher.add({StorageAlertRule::WarningAlert, "S3", "", 6000}));
+	REQUIRE(dispatcher.take_batch(6000, true).size() == 1);
+}
+
+
+
+TEST_CASE("StorageAlertBatchToJson", "[app][alerts]")
+{
+	const std::string json = storage_alert_batch_to_json({{StorageAlertRule::SelfTestFailure, "S1", "Failed", 1000}}, 2);
+	REQUIRE(json == R"({"alerts":[{"drive":"S1","message":"Failed","rule":"selftest_failure","time":1000}],"dropped":2})");
+}
+
+
+
+
+
+
+/// @}
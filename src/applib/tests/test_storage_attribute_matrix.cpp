@@ -0,0 +1,122 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <array>
+
+#include "applib/storage_attribute_matrix.h"
+
+
+
+namespace {
+
+	StorageAttributeMatrixCell make_cell(const std::string& key, std::int64_t raw, std::optional<std::int64_t> value = std::nullopt)
+	{
+		StorageAttributeMatrixCell cell;
+		cell.column_key = key;
+		cell.name = key;
+		cell.raw = raw;
+		cell.value = value;
+		cell.worst = value;
+		return cell;
+	}
+
+}
+
+
+
+TEST_CASE("StorageAttributeMatrixCells", "[app][attribute_matrix]")
+{
+	StoragePropertyRepository properties;
+
+	AtaStorageAttribute attr;
+	attr.id = 5;
+	attr.value = 100;
+	attr.raw_value_int = 8;
+	StorageProperty ata_property(StoragePropertySection::AtaAttributes, attr);
+	ata_property.displayable_name = "Reallocated Sector Count";
+	properties.add_property(ata_property);
+
+	StorageProperty nvme_property(StoragePropertySection::NvmeAttributes, std::int64_t(3));
+	nvme_property.generic_name = "nvme_smart_health_information_log/media_errors";
+	properties.add_property(nvme_property);
+
+	const auto cells = storage_attribute_matrix_make_cells(properties);
+	REQUIRE(cells.size() == 2);
+	REQUIRE(cells[0].column_key == "ata/5");
+	REQUIRE(cells[0].name == "5 Reallocated Sector Count");
+	REQUIRE(cells[0].raw == 8);
+	REQUIRE(cells[0].value == 100);
+	REQUIRE(!cells[0].worst.has_value());
+	REQUIRE(cells[1].column_key == "nvme_smart_health_information_log/media_errors");
+	REQUIRE(cells[1].raw == 3);
+}
+
+
+
+TEST_CASE("StorageAttributeMatrix", "[app][attribute_matrix]")
+{
+	// Only used as keys
+	std::array<int, 3> keys = {};
+	const auto* drive_a = reinterpret_cast<const StorageDevice*>(&keys[0]);
+	const auto* drive_b = reinterpret_cast<const StorageDevice*>(&keys[1]);
+	const auto* drive_c = reinterpret_cast<const StorageDevice*>(&keys[2]);
+
+	StorageAttributeMatrix matrix;
+	REQUIRE(matrix.update(drive_a, {make_cell("ata/5", 8, 100), make_cell("ata/197", 0, 100)}));
+	REQUIRE(!matrix.update(drive_a, {make_cell("ata/5", 8, 100), make_cell("ata/197", 0, 100)}));  // unchanged
+	REQUIRE(matrix.update(drive_b, {make_cell("ata/5", 0, 100)}));
+	REQUIRE(matrix.update(drive_c, {make_cell("nvme_smart_health_information_log/media_errors", 2)}));
+
+	REQUIRE(matrix.get_row_count() == 3);
+	REQUIRE(matrix.get_columns().size() == 3);
+	const auto col_5 = matrix.find_column("ata/5").value();
+	const auto& column = matrix.get_columns()[col_5];
+	REQUIRE(column.raw.size() == 3);
+	REQUIRE(column.get(matrix.find_row(drive_a).value(), StorageAttributeMatrixField::Raw) == 8);
+	REQUIRE(column.get(matrix.find_row(drive_b).value(), StorageAttributeMatrixField::Worst) == 100);
+	REQUIRE(!column.get(matrix.find_row(drive_c).value(), StorageAttributeMatrixField::Raw).has_value());
+
+	// Filtering and sorting
+	REQUIRE(matrix.filter_rows(col_5, StorageAttributeMatrixField::Raw, 1, 100)
+			== std::vector<std::size_t>{matrix.find_row(drive_a).value()});
+	std::vector<std::size_t> rows = {0, 1, 2};
+	matrix.sort_rows(rows, col_5, StorageAttributeMatrixField::Raw, true);
+	REQUIRE(rows == std::vector<std::size_t>{0, 1, 2});
+	matrix.sort_rows(rows, col_5, StorageAttributeMatrixField::Raw, false);
+	REQUIRE(rows == std::vector<std::size_t>{1, 0, 2});  // missing values go last
+
+	// Attributes which disappear are cleared
+	REQUIRE(matrix.update(drive_a, {make_cell("ata/5", 9, 99)}));
+	const auto col_197 = matrix.find_column("ata/197").value();
+	REQUIRE(!matrix.get_columns()[col_197].get(matrix.find_row(drive_a).value(), StorageAttributeMatrixField::Raw).has_value());
+
+	// The last row takes the place of the removed one
+	matrix.remove(drive_a);
+	REQUIRE(matrix.get_row_count() == 2);
+	REQUIRE(!matrix.find_row(drive_a).has_value());
+	REQUIRE(matrix.find_row(drive_c) == 0);
+	REQUIRE(matrix.get_row_drive(0) == drive_c);
+	REQUIRE(matrix.get_columns()[col_5].get(matrix.find_row(drive_b).value(), StorageAttributeMatrixField::Raw) == 0);
+	REQUIRE(matrix.get_columns()[col_5].raw.size() == 2);
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,58 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <memory>
+
+#include "applib/storage_bulk_operation.h"
+
+
+
+TEST_CASE("StorageBulkOperationApplicable", "[app][bulk]")
+{
+	const StorageDevice virtual_drive("/tmp/sda.txt", true);
+	REQUIRE(!storage_bulk_get_is_applicable(StorageBulkOperation::EnableSmart, virtual_drive));
+	REQUIRE(!storage_bulk_get_is_applicable(StorageBulkOperation::Refresh, virtual_drive));
+
+	const StorageDevice drive("/dev/sda", std::string());
+	REQUIRE(storage_bulk_get_is_applicable(StorageBulkOperation::Refresh, drive));
+	REQUIRE(storage_bulk_get_is_applicable(StorageBulkOperation::SaveOutput, drive));
+
+	REQUIRE(!storage_bulk_get_displayable_name(StorageBulkOperation::SaveOutput).empty());
+}
+
+
+
+TEST_CASE("StorageBulkOperationErrors", "[app][bulk]")
+{
+	std::vector<StorageBulkResult> results(3);
+	results[0].drive = std::make_shared<StorageDevice>("/dev/sda", std::string());
+	results[1].drive = std::make_shared<StorageDevice>("/dev/sdb", std::string("sat"));
+	results[1].error = "Permission denied";
+	results[2].drive = std::make_shared<StorageDevice>("/dev/sdc", std::string());
+	results[2].skipped = true;
+
+	REQUIRE(storage_bulk_format_errors({}).empty());
+	REQUIRE(storage_bulk_format_errors(results) == "/dev/sdb (sat): Permission denied\n");
+
+	results[0].error = "No such device";
+	REQUIRE(storage_bulk_format_errors(results) == "/dev/sda: No such device\n/dev/sdb (sat): Permission denied\n");
+}
+
+
+
+
+/// @}
@@ -0,0 +1,81 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_columnar_export.h"
+#include "hz/fs.h"
+#include <sstream>
+
+
+
+TEST_CASE("StorageColumnarExportValues", "[app][export]")
+{
+	std::ostringstream values, drives, models;
+	StorageColumnarExport csv(values, drives, models);
+
+	csv.add_values("S1", "Model, A", 1000, {{"ata_attr/5/raw", 0}, {"ata_attr/9/raw", 100}});
+	csv.add_values("S2", "Model, A", 1000, {{"ata_attr/5/raw", 8}});
+	csv.add_values("S1", "Other", 2000, {{"ata_attr/5/raw", 1}});  // the first model is kept
+	REQUIRE(csv.get_row_count() == 4);
+
+	REQUIRE(values.str() == "drive_id,model_id,time,attribute,value\n"
+			"0,0,1000,ata_attr/5/raw,0\n"
+			"0,0,1000,ata_attr/9/raw,100\n"
+			"1,0,1000,ata_attr/5/raw,8\n"
+			"0,0,2000,ata_attr/5/raw,1\n");
+	REQUIRE(drives.str() == "drive_id,serial,model_id\n0,S1,0\n1,S2,0\n");
+	REQUIRE(models.str() == "model_id,model\n0,\"Model, A\"\n");
+
+	REQUIRE(StorageColumnarExport::quote("a\"b") == "\"a\"\"b\"");
+}
+
+
+
+TEST_CASE("StorageColumnarExportHistory", "[app][export]")
+{
+	auto file = hz::fs::temp_directory_path() / "gsmartcontrol_test_export_history.dat";
+	std::error_code ec;
+	hz::fs::remove(file, ec);
+
+	StorageHistory history(file);
+	REQUIRE(!history.open());
+	REQUIRE(!history.append("S1", 1000, {{"a", 1}}));
+	REQUIRE(!history.append("S1", 2000, {{"a", 1}}));  // unchanged, not a row
+	REQUIRE(!history.append("S1", 3000, {{"a", 2}}));
+	REQUIRE(!history.append("S2", 3000, {{"b", -5}}));
+
+	std::ostringstream values, drives, models;
+	StorageColumnarExport csv(values, drives, models);
+	csv.add_values("S2", "M2", 4000, {{"b", -4}});
+	csv.add_history(history);
+
+	REQUIRE(values.str() == "drive_id,model_id,time,attribute,value\n"
+			"0,0,4000,b,-4\n"
+			"1,1,1000,a,1\n"
+			"1,1,3000,a,2\n"
+			"0,0,3000,b,-5\n");
+	REQUIRE(drives.str() == "drive_id,serial,model_id\n0,S2,0\n1,S1,1\n");
+	REQUIRE(models.str() == "model_id,model\n0,M2\n1,\n");
+
+	hz::fs::remove(file, ec);
+}
+
+
+
+
+
+
+/// @}
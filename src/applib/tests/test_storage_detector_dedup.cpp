@@ -0,0 +1,59 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <map>
+
+#include "applib/storage_detector_dedup.h"
+
+
+
+TEST_CASE("StorageDetectorRemoveAliases", "[app][detector]")
+{
+	const std::map<std::string, std::string> identities = {
+		{"/dev/sda", "host0/0:0:0:0"},
+		{"/dev/sg0", "host0/0:0:0:0"},
+		{"/dev/sdb", "host1/1:0:0:0"},
+	};
+	auto get_identity = [&identities](const StorageDevice& drive) -> std::string {
+		if (auto iter = identities.find(drive.get_device()); iter != identities.end()) {
+			return iter->second;
+		}
+		return {};
+	};
+
+	std::vector<StorageDevicePtr> drives = {
+		std::make_shared<StorageDevice>("/dev/sda"),
+		std::make_shared<StorageDevice>("/dev/sdb"),
+		std::make_shared<StorageDevice>("/dev/sg0"),  // alias of /dev/sda
+		std::make_shared<StorageDevice>("/dev/sda", std::string("scsi")),  // another type for /dev/sda
+		std::make_shared<StorageDevice>("/dev/bus/0", std::string("megaraid,0")),  // unknown identity
+		std::make_shared<StorageDevice>("/dev/bus/0", std::string("megaraid,1")),
+	};
+
+	REQUIRE(storage_detector_remove_aliases(drives, get_identity) == 2);
+	REQUIRE(drives.size() == 4);
+	REQUIRE(drives[0]->get_device_with_type() == "/dev/sda");
+	REQUIRE(drives[1]->get_device_with_type() == "/dev/sdb");
+	REQUIRE(drives[2]->get_type_argument() == "megaraid,0");
+	REQUIRE(drives[3]->get_type_argument() == "megaraid,1");
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,39 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_detector_other.h"
+
+
+
+TEST_CASE("StorageDetectorOtherParseDiskList", "[app][detector]")
+{
+	REQUIRE(storage_detector_other_parse_disk_list("").empty());
+	REQUIRE(storage_detector_other_parse_disk_list("  \n").empty());
+	REQUIRE(storage_detector_other_parse_disk_list("ada1 ada0 da0")
+			== std::vector<std::string>{"ada0", "ada1", "da0"});
+
+	// sysctl values may include the terminating null character
+	REQUIRE(storage_detector_other_parse_disk_list(std::string_view("nvd0 ada0\0", 10))
+			== std::vector<std::string>{"ada0", "nvd0"});
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,62 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_detector_scan_open.h"
+
+
+
+TEST_CASE("StorageDetectorScanOpen", "[app][detector]")
+{
+	SECTION("Devices") {
+		const std::string output = R"({
+			"json_format_version": [1, 0],
+			"devices": [
+				{"name": "/dev/sda", "info_name": "/dev/sda [SAT]", "type": "sat", "protocol": "ATA"},
+				{"name": "/dev/nvme0", "info_name": "/dev/nvme0", "type": "nvme", "protocol": "NVMe"},
+				{"name": "/dev/bus/0", "info_name": "/dev/bus/0 [megaraid_disk_00]", "type": "megaraid,0", "protocol": "SCSI"},
+				{"name": "/dev/sdb", "info_name": "/dev/sdb", "type": "scsi", "protocol": "SCSI", "open_error": "Permission denied"}
+			]
+		})";
+		std::vector<StorageDevicePtr> drives;
+		REQUIRE(parse_scan_open_json(output, drives));
+		REQUIRE(drives.size() == 3);
+		REQUIRE(drives[0]->get_device() == "/dev/sda");
+		REQUIRE(drives[0]->get_type_argument().empty());
+		REQUIRE(drives[1]->get_device() == "/dev/nvme0");
+		REQUIRE(drives[1]->get_type_argument().empty());
+		REQUIRE(drives[2]->get_device() == "/dev/bus/0");
+		REQUIRE(drives[2]->get_type_argument() == "megaraid,0");
+	}
+
+	SECTION("NoDevices") {
+		std::vector<StorageDevicePtr> drives;
+		REQUIRE(parse_scan_open_json(R"({"json_format_version": [1, 0]})", drives));
+		REQUIRE(drives.empty());
+	}
+
+	SECTION("Invalid") {
+		std::vector<StorageDevicePtr> drives;
+		REQUIRE_FALSE(parse_scan_open_json("/dev/sda -d sat # /dev/sda [SAT], ATA device", drives));
+		REQUIRE_FALSE(parse_scan_open_json("{}", drives));
+	}
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,78 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_device_index.h"
+
+
+
+TEST_CASE("StorageDeviceFilter", "[app][index]")
+{
+	REQUIRE(StorageDeviceFilter::create("").is_empty());
+	REQUIRE(StorageDeviceFilter::create("  ").is_empty());
+	REQUIRE(!StorageDeviceFilter::create("", WarningLevel::Warning).is_empty());
+
+	const auto filter = StorageDeviceFilter::create(" WDC  sda\t");
+	REQUIRE(filter.words == std::vector<std::string>{"wdc", "sda"});
+}
+
+
+
+TEST_CASE("StorageDeviceIndexController", "[app][index]")
+{
+	REQUIRE(storage_device_index_get_controller("", "/dev/sda", "").empty());
+	REQUIRE(storage_device_index_get_controller("", "/dev/sda", "sat").empty());
+	REQUIRE(storage_device_index_get_controller("", "/dev/bus/0", "megaraid,5") == "/dev/bus/0 megaraid");
+	REQUIRE(storage_device_index_get_controller("nas", "/dev/sg1", "areca,3/1") == "nas:/dev/sg1 areca");
+}
+
+
+
+TEST_CASE("StorageDeviceIndex", "[app][index]")
+{
+	StorageDeviceIndexRecord record;
+	record.search_text = "wdc wd40efrx\nwd-123\n/dev/sda\n\n";
+	record.warning = WarningLevel::Warning;
+	record.controller = "/dev/sda megaraid";
+
+	StorageDeviceIndex index;
+	const auto* drive = reinterpret_cast<const StorageDevice*>(&record);  // only used as a key
+	REQUIRE(!index.matches(drive, StorageDeviceFilter()));  // not indexed
+
+	REQUIRE(index.update(drive, record));
+	REQUIRE(!index.update(drive, record));  // unchanged
+	REQUIRE(index.size() == 1);
+
+	REQUIRE(index.matches(drive, StorageDeviceFilter()));
+	REQUIRE(index.matches(drive, StorageDeviceFilter::create("WD40 sda")));
+	REQUIRE(!index.matches(drive, StorageDeviceFilter::create("wd40 sdb")));
+	REQUIRE(index.matches(drive, StorageDeviceFilter::create("", WarningLevel::Warning)));
+	REQUIRE(!index.matches(drive, StorageDeviceFilter::create("", WarningLevel::Alert)));
+
+	REQUIRE(index.get_group(drive, StorageDeviceGrouping::Controller) == "/dev/sda megaraid");
+	REQUIRE(index.get_group(drive, StorageDeviceGrouping::Host).empty());
+	REQUIRE(index.get_group(drive, StorageDeviceGrouping::None).empty());
+
+	index.remove(drive);
+	REQUIRE(index.find(drive) == nullptr);
+}
+
+
+
+
+
+
+/// @}
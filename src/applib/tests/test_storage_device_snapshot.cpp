@@ -0,0 +1,185 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_device.h"
+#include "applib/storage_property_snapshot.h"
+#include "rconfig/rconfig.h"
+#include <glib.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+	/// Create a property snapshot of a drive with a model name and health status
+	std::string make_basic_snapshot(const std::string& model, bool passed)
+	{
+		StoragePropertyRepository repo;
+
+		StorageProperty model_prop(StoragePropertySection::Info, model);
+		model_prop.set_name("model_name", "Device Model");
+		repo.add_property(std::move(model_prop));
+
+		StorageProperty health_prop(StoragePropertySection::OverallHealth, passed);
+		health_prop.set_name("smart_status/passed", "Overall Health Self-Assessment Test");
+		repo.add_property(std::move(health_prop));
+
+		return storage_property_snapshot_save(repo);
+	}
+
+}
+
+
+
+TEST_CASE("StorageDeviceSnapshot", "[app][device]")
+{
+	StorageDevice drive("/dev/sda", std::string());
+
+	const StorageDevice::SnapshotPtr empty = drive.get_snapshot();
+	REQUIRE(empty != nullptr);
+	REQUIRE(empty->model_name.empty());
+	REQUIRE(empty->health_property.empty());
+	REQUIRE(empty->basic_output != nullptr);
+	REQUIRE(empty->parse_status == StorageDevice::ParseStatus::None);
+
+	REQUIRE(drive.load_basic_data_snapshot(make_basic_snapshot("Model 1", true)));
+	const StorageDevice::SnapshotPtr first = drive.get_snapshot();
+	REQUIRE(first != empty);
+	REQUIRE(first->model_name == "Model 1");
+	REQUIRE(first->parse_status == StorageDevice::ParseStatus::Basic);
+	REQUIRE(first->health_property.get_value<bool>());
+	REQUIRE(first->property_repository.get_properties().size() == 2);
+	REQUIRE(drive.get_health_property().get_value<bool>());
+
+	// The held snapshots don't change when the drive does
+	REQUIRE(drive.load_basic_data_snapshot(make_basic_snapshot("Model 2", false)));
+	REQUIRE(first->model_name == "Model 1");
+	REQUIRE(first->health_property.get_value<bool>());
+	REQUIRE(empty->model_name.empty());
+	REQUIRE(drive.get_snapshot()->model_name == "Model 2");
+	REQUIRE(!drive.get_snapshot()->health_property.get_value<bool>());
+	REQUIRE(!drive.get_health_property().get_value<bool>());
+}
+
+
+
+TEST_CASE("StorageDeviceDerivedFacts", "[app][device]")
+{
+	const auto make_smart_snapshot = [](bool enabled) {
+		StoragePropertyRepository repo;
+		StorageProperty model_prop(StoragePropertySection::Info, std::string("Model"));
+		model_prop.set_name("model_name", "Device Model");
+		repo.add_property(std::move(model_prop));
+		StorageProperty available(StoragePropertySection::Info, true);
+		available.set_name("smart_support/available", "SMART Supported");
+		repo.add_property(std::move(available));
+		StorageProperty enabled_prop(StoragePropertySection::Info, enabled);
+		enabled_prop.set_name("smart_support/enabled", "SMART Enabled");
+		repo.add_property(std::move(enabled_prop));
+		return storage_property_snapshot_save(repo);
+	};
+
+	StorageDevice drive("/dev/sda", std::string());
+	REQUIRE(drive.get_smart_status() == StorageDevice::SmartStatus::Unsupported);
+	REQUIRE(drive.get_self_test_support_status() == StorageDevice::SelfTestSupportStatus::Unknown);
+
+	// The memoized facts follow the properties
+	REQUIRE(drive.load_basic_data_snapshot(make_smart_snapshot(true)));
+	REQUIRE(drive.get_smart_status() == StorageDevice::SmartStatus::Enabled);
+	REQUIRE(drive.get_smart_switch_supported());
+	REQUIRE(drive.get_self_test_support_status() == StorageDevice::SelfTestSupportStatus::Unknown);
+
+	REQUIRE(drive.load_basic_data_snapshot(make_smart_snapshot(false)));
+	REQUIRE(drive.get_smart_status() == StorageDevice::SmartStatus::Disabled);
+	REQUIRE(drive.get_self_test_support_status() == StorageDevice::SelfTestSupportStatus::Unsupported);
+
+	drive.set_detected_type(StorageDeviceDetectedType::Nvme);
+	REQUIRE(!drive.get_smart_switch_supported());
+}
+
+
+
+TEST_CASE("StorageDeviceWorkerFetch", "[app][device]")
+{
+	StorageDevice drive("/dev/sda", std::string());
+	int changed = 0;
+	drive.signal_changed().connect([&changed](StorageDevice*) { ++changed; });
+
+	// While a worker thread fetches the drive, the snapshots are published but the signal is held back
+	drive.begin_worker_fetch();
+	REQUIRE(drive.get_fetch_in_progress());
+	REQUIRE(drive.load_basic_data_snapshot(make_basic_snapshot("Model 1", true)));
+	REQUIRE(drive.get_snapshot()->model_name == "Model 1");
+	REQUIRE(changed == 0);
+
+	drive.end_worker_fetch();
+	REQUIRE(!drive.get_fetch_in_progress());
+	REQUIRE(changed == 1);
+
+	REQUIRE(drive.load_basic_data_snapshot(make_basic_snapshot("Model 2", true)));
+	REQUIRE(changed == 2);
+}
+
+
+
+TEST_CASE("StorageDeviceCoalescedChanges", "[app][device]")
+{
+	rconfig::set_default_data("gui/change_notification_interval_msec", 0);
+
+	// A drive without an owner delivers the changes immediately
+	StorageDevice drive("/dev/sda", std::string());
+	std::vector<StorageDeviceChange> delivered;
+	drive.signal_changed_coalesced().connect([&delivered](StorageDevice*, StorageDeviceChange changes) {
+		delivered.push_back(changes);
+	});
+	REQUIRE(drive.load_basic_data_snapshot(make_basic_snapshot("Model 1", true)));
+	REQUIRE(delivered == std::vector{StorageDeviceChange::Properties});
+
+	// The changes of a worker fetch are delivered together after it
+	drive.begin_worker_fetch();
+	REQUIRE(drive.load_basic_data_snapshot(make_basic_snapshot("Model 2", true)));
+	REQUIRE(delivered.size() == 1);
+	drive.end_worker_fetch();
+	REQUIRE(delivered.size() == 2);
+	REQUIRE(delivered.back() == (StorageDeviceChange::Properties | StorageDeviceChange::Activity));
+	REQUIRE(!storage_device_change_has(delivered.back(), StorageDeviceChange::Standby));
+
+	// An owned drive delivers a burst of changes once, in the main loop
+	auto owned = std::make_shared<StorageDevice>("/dev/sdb", std::string());
+	int changed = 0;
+	std::vector<StorageDeviceChange> owned_delivered;
+	owned->signal_changed().connect([&changed](StorageDevice*) { ++changed; });
+	owned->signal_changed_coalesced().connect([&owned_delivered](StorageDevice*, StorageDeviceChange changes) {
+		owned_delivered.push_back(changes);
+	});
+	REQUIRE(owned->load_basic_data_snapshot(make_basic_snapshot("Model 1", true)));
+	owned->set_test_is_active(true);
+	REQUIRE(changed == 2);
+	REQUIRE(owned_delivered.empty());
+
+	while (g_main_context_iteration(nullptr, FALSE)) { }
+	REQUIRE(owned_delivered == std::vector{StorageDeviceChange::Properties | StorageDeviceChange::Activity});
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,64 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "applib/storage_device_type_cache.h"
+
+
+
+TEST_CASE("StorageDeviceTypeCacheKey", "[app][detector]")
+{
+	REQUIRE(storage_device_type_cache_get_key("", "/dev/sdb", "") == "/dev/sdb");
+	REQUIRE(storage_device_type_cache_get_key("", "/dev/sdb", "naa.5000c500a1b2c3d4") == "/dev/sdb#naa.5000c500a1b2c3d4");
+	REQUIRE(storage_device_type_cache_get_key("root@nas", "/dev/sdb", "") == "root@nas:/dev/sdb");
+}
+
+
+
+TEST_CASE("StorageDeviceTypeCache", "[app][detector]")
+{
+	rconfig::set_default_data("system/device_type_cache", rconfig::json::object());
+	rconfig::unset_data("system/device_type_cache");
+	storage_device_type_cache_reset();
+
+	REQUIRE_FALSE(storage_device_type_cache_get("/dev/sdb#wwn1").has_value());
+
+	storage_device_type_cache_remember("/dev/sdb#wwn1", "scsi");
+	storage_device_type_cache_remember("/dev/sdc#wwn2", "sat");
+	REQUIRE(storage_device_type_cache_get("/dev/sdb#wwn1") == "scsi");
+	REQUIRE_FALSE(storage_device_type_cache_get("/dev/sdb#wwn3").has_value());  // another drive on the same device file
+
+	// Stored in config and read back
+	storage_device_type_cache_save();
+	storage_device_type_cache_reset();
+	REQUIRE(storage_device_type_cache_get("/dev/sdc#wwn2") == "sat");
+
+	storage_device_type_cache_forget("/dev/sdc#wwn2");
+	storage_device_type_cache_save();
+	storage_device_type_cache_reset();
+	REQUIRE_FALSE(storage_device_type_cache_get("/dev/sdc#wwn2").has_value());
+	REQUIRE(storage_device_type_cache_get("/dev/sdb#wwn1") == "scsi");
+
+	rconfig::unset_data("system/device_type_cache");
+	storage_device_type_cache_reset();
+}
+
+
+
+
+
+/// @}
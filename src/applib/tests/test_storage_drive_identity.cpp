@@ -0,0 +1,93 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "applib/storage_drive_identity.h"
+
+
+
+TEST_CASE("StorageDriveIdentityKeys", "[app][detector]")
+{
+	// smartctl text, smartctl JSON (ID without leading zeroes) and sysfs forms of the same WWN
+	REQUIRE(storage_drive_identity_normalize_wwn("5 000c50 0a1b2c3d4") == "5000c500a1b2c3d4");
+	REQUIRE(storage_drive_identity_normalize_wwn("5-000C50-A1B2C3D4") == "5000c500a1b2c3d4");
+	REQUIRE(storage_drive_identity_normalize_wwn("naa.5000C500A1B2C3D4\n") == "5000c500a1b2c3d4");
+	REQUIRE(storage_drive_identity_normalize_wwn("eui.0025388b91b2c3d4") == "0025388b91b2c3d4");
+	REQUIRE(storage_drive_identity_normalize_wwn("t10.ATA     ST2000DM001-1CH164     Z1E6ABCD").empty());
+	REQUIRE(storage_drive_identity_normalize_wwn("5 000c50 0a1b2c3d4f").empty());  // ID too long
+	REQUIRE(storage_drive_identity_normalize_wwn("").empty());
+
+	REQUIRE(storage_drive_identity_get_keys("5 000c50 0a1b2c3d4", "ST2000DM001", "Z1E6ABCD")
+			== std::vector<std::string>{"wwn:5000c500a1b2c3d4", "sn:ST2000DM001/Z1E6ABCD"});
+	REQUIRE(storage_drive_identity_get_keys("", "ST2000DM001", " Z1E6ABCD ") == std::vector<std::string>{"sn:ST2000DM001/Z1E6ABCD"});
+	REQUIRE(storage_drive_identity_get_keys("", "ST2000DM001", "").empty());
+}
+
+
+
+TEST_CASE("StorageDriveIdentityRegistry", "[app][detector]")
+{
+	rconfig::set_default_data("system/drive_identities", rconfig::json::object());
+	rconfig::unset_data("system/drive_identities");
+	storage_drive_identity_reset();
+
+	const std::vector<std::string> drive1 = {"wwn:5000c500a1b2c3d4", "sn:ST2000DM001/Z1E6ABCD"};
+	const std::vector<std::string> drive2 = {"sn:Samsung SSD 870/S5Y1NX0R"};
+
+	const std::string id1 = storage_drive_identity_update("/dev/sdb", drive1);
+	const std::string id2 = storage_drive_identity_update("/dev/sdc", drive2);
+	REQUIRE(!id1.empty());
+	REQUIRE(!id2.empty());
+	REQUIRE(id1 != id2);
+	REQUIRE(storage_drive_identity_find({"wwn:5000c500a1b2c3d4"}) == id1);
+	REQUIRE(storage_drive_identity_find({"sn:other/1", "sn:Samsung SSD 870/S5Y1NX0R"}) == id2);
+	REQUIRE_FALSE(storage_drive_identity_find({"sn:other/1"}).has_value());
+	REQUIRE(storage_drive_identity_find_at("/dev/sdb") == id1);
+
+	// The drives swap places, on another host
+	REQUIRE(storage_drive_identity_update("root@nas:/dev/sdc", {"sn:ST2000DM001/Z1E6ABCD"}) == id1);
+	REQUIRE(storage_drive_identity_update("root@nas:/dev/sdb", drive2) == id2);
+	REQUIRE(storage_drive_identity_find_at("root@nas:/dev/sdc") == id1);
+	REQUIRE_FALSE(storage_drive_identity_find_at("/dev/sdb").has_value());
+
+	// A drive without identity forgets the location
+	REQUIRE(storage_drive_identity_update("root@nas:/dev/sdb", {}).empty());
+	REQUIRE_FALSE(storage_drive_identity_find_at("root@nas:/dev/sdb").has_value());
+
+	// A new key (e.g. the system WWN) is added to the drive found by the other keys
+	REQUIRE(storage_drive_identity_update("/dev/sdd", {"sn:Samsung SSD 870/S5Y1NX0R", "wwn:5002538e40a1b2c3"}) == id2);
+	REQUIRE(storage_drive_identity_find({"wwn:5002538e40a1b2c3"}) == id2);
+
+	// Stored in config and read back, the IDs are not reused
+	storage_drive_identity_save();
+	storage_drive_identity_reset();
+	REQUIRE(storage_drive_identity_find({"wwn:5000c500a1b2c3d4"}) == id1);
+	REQUIRE(storage_drive_identity_find({"wwn:5002538e40a1b2c3"}) == id2);
+	REQUIRE(storage_drive_identity_find_at("/dev/sdd") == id2);
+	const std::string id3 = storage_drive_identity_update("/dev/sde", {"sn:WDC WD40EFRX/WD-WCC4E1234567"});
+	REQUIRE(id3 != id1);
+	REQUIRE(id3 != id2);
+
+	rconfig::unset_data("system/drive_identities");
+	storage_drive_identity_reset();
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,112 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_drivedb.h"
+
+
+
+namespace {
+
+	/// A small drivedb.h in the format of the smartmontools one
+	constexpr std::string_view drivedb_contents = R"DB(/*
+ * drivedb.h - smartmontools drive database file
+ */
+
+/*
+const drive_settings builtin_knowndrives[] = {
+ */
+{ "VERSION: 7.3/5528 2023-08-01 15:58:03 $Id: drivedb.h 5528 2023-08-01 15:58:03Z chrfranke $",
+  "-", "-",
+  "Version information",
+  ""
+},
+{ "DEFAULT",
+  "-", "",
+  "Default settings",
+  "-v 1,raw48:54 " // "raw48:54" comment
+  "-v 9,raw24(raw8)"
+},
+{ "Western Digital Red", // tested with WDC WD40EFRX-68N32N0/82.00A82
+  "WDC WD(7500|[1-6]0)EF[RZ]X-.*",
+  "", "", ""
+},
+{ "Samsung based SSDs",
+  "SAMSUNG SSD 8[56]0 .*",
+  "EXM0[1-4]B6Q",
+  "A firmware update is available",
+  "-v 177,raw48,Wear_Leveling_Count"
+},
+{ "USB: Seagate FreeAgent; ",
+  "0x0bc2:0x5021",
+  "",
+  "",
+  "-d sat"
+},
+/*
+};
+ */
+)DB";
+
+}
+
+
+
+TEST_CASE("StorageDriveDbParse", "[app][drivedb]")
+{
+	const auto entries = storage_drivedb_parse(drivedb_contents);
+	REQUIRE(entries.size() == 5);
+	REQUIRE(entries[1].family == "DEFAULT");
+	REQUIRE(entries[1].presets == "-v 1,raw48:54 -v 9,raw24(raw8)");
+	REQUIRE(entries[2].model_regex == "WDC WD(7500|[1-6]0)EF[RZ]X-.*");
+	REQUIRE(entries[3].firmware_regex == "EXM0[1-4]B6Q");
+	REQUIRE(entries[3].warning == "A firmware update is available");
+	REQUIRE(entries[4].model_regex == "0x0bc2:0x5021");
+
+	REQUIRE(storage_drivedb_parse("").empty());
+	REQUIRE(storage_drivedb_parse("{ { \"unterminated").empty());
+}
+
+
+
+TEST_CASE("StorageDriveDbChanges", "[app][drivedb]")
+{
+	const auto entries = storage_drivedb_parse(drivedb_contents);
+	StorageDriveDbSnapshot before = {{"/usr/share/smartmontools/drivedb.h", entries}};
+	REQUIRE(storage_drivedb_get_changed_entries(before, before).empty());
+
+	StorageDriveDbSnapshot after = before;
+	auto& after_entries = after.begin()->second;
+	after_entries[3].presets += " -v 241,raw48,Total_LBAs_Written";
+	after_entries.push_back({"Seagate IronWolf", "ST[0-9]+VN00[0-9]-.*", "", "", ""});
+
+	const auto changed = storage_drivedb_get_changed_entries(before, after);
+	REQUIRE(changed.size() == 3);  // the old and new Samsung entries, the new Seagate one
+
+	REQUIRE(storage_drivedb_entry_matches(entries[2], "WDC WD40EFRX-68N32N0", "82.00A82"));
+	REQUIRE(!storage_drivedb_entry_matches(entries[2], "WDC WD40EFAX-68JH4N0", "82.00A82"));
+	REQUIRE(!storage_drivedb_entry_matches(entries[2], "XWDC WD40EFRX-68N32N0", ""));  // whole string
+	REQUIRE(storage_drivedb_entry_matches(entries[3], "SAMSUNG SSD 850 EVO 500GB", "EXM02B6Q"));
+	REQUIRE(!storage_drivedb_entry_matches(entries[3], "SAMSUNG SSD 850 EVO 500GB", "EMT02B6Q"));
+	REQUIRE(storage_drivedb_entry_matches(entries[1], "Any Model", ""));  // DEFAULT
+	REQUIRE(!storage_drivedb_entry_matches(entries[0], "Any Model", ""));  // VERSION
+	REQUIRE(!storage_drivedb_entry_matches(entries[4], "0x0bc2:0x5021", ""));  // USB bridge
+}
+
+
+
+
+/// @}
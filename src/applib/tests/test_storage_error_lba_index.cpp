@@ -0,0 +1,94 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_error_lba_index.h"
+#include "applib/storage_property.h"
+
+
+
+TEST_CASE("StorageErrorLbaIndexQueries", "[app][error_lba]")
+{
+	StorageErrorLbaIndex index;
+	REQUIRE(index.empty());
+
+	REQUIRE(index.add(1000, StorageErrorLbaSourceAtaErrorLog, 100));
+	REQUIRE(index.add(1010, StorageErrorLbaSourceAtaErrorLog, 200));
+	REQUIRE(index.add(1030, StorageErrorLbaSourceSelfTestLog, 300));
+	REQUIRE(index.add(90000, StorageErrorLbaSourceNvmeErrorLog, 400));
+
+	// Duplicates are ignored, new sources are merged
+	REQUIRE(!index.add(1000, StorageErrorLbaSourceAtaErrorLog, 500));
+	REQUIRE(index.add(1000, StorageErrorLbaSourceSelfTestLog, 500));
+	REQUIRE(index.size() == 4);
+	REQUIRE(index.find(1000) == StorageErrorLba{1000, StorageErrorLbaSourceAtaErrorLog | StorageErrorLbaSourceSelfTestLog, 100});
+	REQUIRE(!index.find(1001).has_value());
+
+	REQUIRE(index.get_range(1005, 1030).size() == 2);
+	REQUIRE(index.get_range(0, 999).empty());
+
+	const auto since = index.get_since(200);
+	REQUIRE(since.size() == 3);
+	REQUIRE(since.front().lba == 1010);
+	REQUIRE(since.back().lba == 90000);
+
+	REQUIRE(index.count_near(1010, 10) == 2);
+	REQUIRE(index.count_near(0, 1000) == 1);
+	REQUIRE(index.count_near(~std::uint64_t(0), 10) == 0);
+
+	REQUIRE(index.get_clusters(20) == std::vector<StorageErrorLbaCluster>{{1000, 1030, 3}});
+	REQUIRE(index.get_clusters(10) == std::vector<StorageErrorLbaCluster>{{1000, 1010, 2}});
+	REQUIRE(index.get_clusters(10, 1).size() == 3);
+}
+
+
+
+TEST_CASE("StorageErrorLbaIndexFromProperties", "[app][error_lba]")
+{
+	StoragePropertyRepository properties;
+
+	AtaStorageErrorBlock block;
+	block.lba = 5000;
+	properties.add_property(StorageProperty(StoragePropertySection::AtaErrorLog, block));
+	block.lba = 0;  // not reported
+	properties.add_property(StorageProperty(StoragePropertySection::AtaErrorLog, block));
+
+	AtaStorageSelftestEntry entry;
+	entry.lba_of_first_error = "5,000";
+	properties.add_property(StorageProperty(StoragePropertySection::SelftestLog, entry));
+
+	NvmeStorageSelftestEntry nvme_entry;
+	nvme_entry.lba = 7000;
+	properties.add_property(StorageProperty(StoragePropertySection::SelftestLog, nvme_entry));
+
+	StorageProperty nvme_log(StoragePropertySection::NvmeErrorLog, std::string(
+			"Error   1    Command ID: 0012    LBA: 00000000000000003000    Unrecovered read error\n"
+			"Error   2    Command ID: 0013    LBA: 00000000000000000000    Invalid field\n"));
+	nvme_log.generic_name = "nvme_error_information_log/_merged";
+	properties.add_property(nvme_log);
+
+	REQUIRE(StorageErrorLbaIndex::get_lbas_from_properties(properties) == StorageErrorLbaList{
+			{3000, StorageErrorLbaSourceNvmeErrorLog},
+			{5000, StorageErrorLbaSourceAtaErrorLog | StorageErrorLbaSourceSelfTestLog},
+			{7000, StorageErrorLbaSourceSelfTestLog}});
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,208 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "applib/smartctl_json_ata_parser.h"
+#include "applib/smartctl_json_nvme_parser.h"
+#include "applib/smartctl_text_ata_parser.h"
+#include "applib/storage_error_log_journal.h"
+#include "applib/storage_property_descr.h"
+
+
+
+namespace {
+
+	/// An error log entry: number, lifetime hours
+	struct TestErrorEntry {
+		std::uint64_t number = 0;
+		std::uint64_t hours = 0;
+	};
+
+
+	/// smartctl JSON output of an ATA drive with \c entries in its error log, newest first
+	std::string make_ata_json_output(const std::vector<TestErrorEntry>& entries)
+	{
+		std::string table;
+		for (const auto& entry : entries) {
+			table += fmt::format(R"({}{{"error_number": {}, "log_index": {}, "lifetime_hours": {},
+					"device_state": {{"string": "Active"}}, "completion_registers": {{"lba": {}}}, "error_description": "UNC"}})",
+					(table.empty() ? "" : ", "), entry.number, entry.number % 16, entry.hours, entry.number * 1000);
+		}
+		return fmt::format(R"({{
+			"json_format_version": [1, 0],
+			"smartctl": {{"version": [7, 3], "exit_status": 0}},
+			"device": {{"name": "/dev/sda", "type": "sat", "protocol": "ATA"}},
+			"model_name": "ST1000",
+			"ata_smart_error_log": {{"extended": {{"revision": 1, "count": {}, "table": [{}]}}}}
+		}})", entries.empty() ? 0 : entries.front().number, table);
+	}
+
+
+	/// smartctl JSON output of an NVMe drive with \c entries in its error log, newest first
+	std::string make_nvme_json_output(const std::vector<TestErrorEntry>& entries)
+	{
+		std::string table;
+		for (const auto& entry : entries) {
+			table += fmt::format(R"({}{{"error_count": {}, "command_id": {}, "lba": {{"value": {}}},
+					"status_field": {{"string": "Invalid Field in Command"}}}})",
+					(table.empty() ? "" : ", "), entry.number, entry.hours, entry.number * 1000);
+		}
+		return fmt::format(R"({{
+			"json_format_version": [1, 0],
+			"smartctl": {{"version": [7, 3], "exit_status": 0}},
+			"device": {{"name": "/dev/nvme0", "type": "nvme", "protocol": "NVMe"}},
+			"model_name": "NVMe1",
+			"nvme_error_information_log": {{"size": 64, "read": 16, "table": [{}]}}
+		}})", table);
+	}
+
+
+	/// Parse and process \c output the way StorageDevice does, with \c journal (may be nullptr).
+	/// \return the properties of \c section as "name=value|description".
+	template<typename Parser>
+	std::vector<std::string> parse_log(const std::string& output, StoragePropertySection section,
+			const std::shared_ptr<StorageErrorLogJournal>& journal)
+	{
+		Parser parser;
+		if (journal) {
+			journal->begin(parser.get_requested_sections(), parser.get_max_log_entries());
+			parser.set_error_log_journal(journal);
+		}
+		REQUIRE(parser.parse(output));
+
+		auto repository = StoragePropertyProcessor::process_properties(parser.take_property_repository(),
+				StorageDeviceDetectedType::AtaHdd, [&journal](const StorageProperty& p) {
+			return journal && journal->get_processed(p);
+		});
+		if (journal) {
+			journal->finish(repository);
+		}
+
+		std::vector<std::string> values;
+		for (const auto& p : repository.get_properties_for_section(section)) {
+			values.push_back(p.generic_name + "=" + p.format_value() + "|" + p.get_description());
+		}
+		return values;
+	}
+
+}
+
+
+
+TEST_CASE("StorageErrorLogJournalAta", "[app][parser]")
+{
+	auto journal = std::make_shared<StorageErrorLogJournal>();
+	auto parse = [&journal](const std::vector<TestErrorEntry>& entries) {
+		const std::string output = make_ata_json_output(entries);
+		const auto values = parse_log<SmartctlJsonAtaParser>(output, StoragePropertySection::AtaErrorLog, journal);
+		REQUIRE(values == parse_log<SmartctlJsonAtaParser>(output, StoragePropertySection::AtaErrorLog, nullptr));
+		return values;
+	};
+
+	static_cast<void>(parse({{3, 30}, {2, 20}, {1, 10}}));
+	REQUIRE(journal->get_reused_count() == 0);
+
+	// Only the new one is parsed, the oldest one rolled off the log
+	static_cast<void>(parse({{4, 40}, {3, 30}, {2, 20}}));
+	REQUIRE(journal->get_reused_count() == 2);
+	REQUIRE(journal->get_reset_count() == 0);
+
+	static_cast<void>(parse({{4, 40}, {3, 30}, {2, 20}}));
+	REQUIRE(journal->get_reused_count() == 3);
+
+	// Reset: the counter started over
+	static_cast<void>(parse({{2, 60}, {1, 50}}));
+	REQUIRE(journal->get_reused_count() == 0);
+	REQUIRE(journal->get_reset_count() == 1);
+
+	// Reset, and filled up to the same number with different entries
+	static_cast<void>(parse({{3, 90}, {2, 80}, {1, 70}}));
+	REQUIRE(journal->get_reused_count() == 0);
+	REQUIRE(journal->get_reset_count() == 1);
+}
+
+
+
+TEST_CASE("StorageErrorLogJournalNvme", "[app][parser]")
+{
+	auto journal = std::make_shared<StorageErrorLogJournal>();
+	auto parse = [&journal](const std::vector<TestErrorEntry>& entries) {
+		const std::string output = make_nvme_json_output(entries);
+		const auto values = parse_log<SmartctlJsonNvmeParser>(output, StoragePropertySection::NvmeErrorLog, journal);
+		REQUIRE(values == parse_log<SmartctlJsonNvmeParser>(output, StoragePropertySection::NvmeErrorLog, nullptr));
+		return values;
+	};
+
+	const auto first = parse({{8, 1}, {7, 2}});
+	REQUIRE(parse({{9, 3}, {8, 1}, {7, 2}}) != first);
+	REQUIRE(journal->get_reused_count() == 2);
+
+	// Power cycle, the log is not persistent
+	static_cast<void>(parse({{1, 4}}));
+	REQUIRE(journal->get_reused_count() == 0);
+	REQUIRE(journal->get_reset_count() == 1);
+}
+
+
+
+TEST_CASE("StorageErrorLogJournalText", "[app][parser]")
+{
+	auto make_output = [](const std::vector<TestErrorEntry>& entries) {
+		std::string output =
+R"(smartctl 7.2 2020-12-30 r5155 [x86_64-linux-5.3.18] (local build)
+Copyright (C) 2002-20, Bruce Allen, Christian Franke, www.smartmontools.org
+
+=== START OF INFORMATION SECTION ===
+Device Model:     ST1000
+Serial Number:    S1
+
+=== START OF READ SMART DATA SECTION ===
+SMART overall-health self-assessment test result: PASSED
+
+SMART Error Log Version: 1
+)";
+		output += fmt::format("ATA Error Count: {}\n", entries.empty() ? 0 : entries.front().number);
+		for (const auto& entry : entries) {
+			output += fmt::format("\nError {} occurred at disk power-on lifetime: {} hours\n"
+					"  When the command that caused the error occurred, the device was active or idle.\n\n"
+					"  40 51 00 f5 41 61 e0  Error: UNC at LBA = 0x006141f5 = 6373877\n", entry.number, entry.hours);
+		}
+		return output;
+	};
+
+	auto journal = std::make_shared<StorageErrorLogJournal>();
+	auto parse = [&journal, &make_output](const std::vector<TestErrorEntry>& entries) {
+		const std::string output = make_output(entries);
+		const auto values = parse_log<SmartctlTextAtaParser>(output, StoragePropertySection::AtaErrorLog, journal);
+		REQUIRE(values == parse_log<SmartctlTextAtaParser>(output, StoragePropertySection::AtaErrorLog, nullptr));
+		return values;
+	};
+
+	static_cast<void>(parse({{2, 20}, {1, 10}}));
+	static_cast<void>(parse({{3, 30}, {2, 20}, {1, 10}}));
+	REQUIRE(journal->get_reused_count() == 2);
+}
+
+
+
+/// @}
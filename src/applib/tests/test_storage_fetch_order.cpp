@@ -0,0 +1,74 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "applib/storage_fetch_order.h"
+
+using namespace std::chrono_literals;
+
+
+
+TEST_CASE("StorageFetchOrder", "[app][detector]")
+{
+	const std::vector<std::optional<std::chrono::milliseconds>> latencies = {
+		5000ms,  // 0, slow
+		100ms,  // 1
+		std::nullopt,  // 2
+		9000ms,  // 3, slowest
+		50ms,  // 4
+		3000ms,  // 5, slow
+	};
+
+	SECTION("Sequential") {
+		REQUIRE(storage_fetch_get_order(latencies, 1, 2000ms) == std::vector<std::size_t>{4, 1, 2, 3, 0, 5});
+	}
+
+	SECTION("Parallel") {
+		// Two slowest ones start first, the third worker goes through the fast ones.
+		REQUIRE(storage_fetch_get_order(latencies, 3, 2000ms) == std::vector<std::size_t>{3, 0, 4, 1, 2, 5});
+		REQUIRE(storage_fetch_get_order(latencies, 10, 2000ms) == std::vector<std::size_t>{3, 0, 5, 4, 1, 2});
+	}
+
+	SECTION("Nothing known") {
+		REQUIRE(storage_fetch_get_order({std::nullopt, std::nullopt}, 4, 2000ms) == std::vector<std::size_t>{0, 1});
+	}
+}
+
+
+
+TEST_CASE("StorageFetchLatencies", "[app][detector]")
+{
+	rconfig::set_default_data("system/fetch_latencies", rconfig::json::object());
+	rconfig::unset_data("system/fetch_latencies");
+
+	REQUIRE(storage_fetch_latencies_load().empty());
+
+	storage_fetch_latencies_store({{"/dev/sda", 100ms}, {"/dev/sdb::sat", 4000ms}});
+	storage_fetch_latencies_store({{"/dev/sda", 300ms}});
+
+	const auto latencies = storage_fetch_latencies_load();
+	REQUIRE(latencies.size() == 2);
+	REQUIRE(latencies.at("/dev/sda") == 200ms);  // smoothed
+	REQUIRE(latencies.at("/dev/sdb::sat") == 4000ms);
+
+	rconfig::unset_data("system/fetch_latencies");
+}
+
+
+
+
+/// @}
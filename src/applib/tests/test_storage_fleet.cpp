@@ -0,0 +1,115 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_fleet.h"
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+	/// Create a repository of a drive with a temperature property
+	StoragePropertyRepository make_repository(const std::string& serial, std::int64_t temperature,
+			WarningLevel warning = WarningLevel::None)
+	{
+		StoragePropertyRepository repo;
+		StorageProperty model(StoragePropertySection::Info, std::string("ST1000"));
+		model.set_name("model_name", "Device Model");
+		repo.add_property(std::move(model));
+		StorageProperty serial_p(StoragePropertySection::Info, serial);
+		serial_p.set_name("serial_number", "Serial Number");
+		repo.add_property(std::move(serial_p));
+		StorageProperty temp(StoragePropertySection::TemperatureLog, temperature);
+		temp.set_name("temperature/current", "Current Temperature");
+		temp.warning_level = warning;
+		repo.add_property(std::move(temp));
+		return repo;
+	}
+
+}
+
+
+
+TEST_CASE("StorageFleetTable", "[app][agent][fleet]")
+{
+	StorageFleetTable table;
+	const std::size_t host1 = table.add_host("root@host1");
+	const std::size_t host2 = table.add_host("root@host2");
+	REQUIRE(table.add_host("root@host1") == host1);
+
+	StorageAgentStreamEncoder encoder1;
+	std::string stream1 = encoder1.encode_start("host1");
+	stream1 += encoder1.encode_drive(1, "/dev/sda", "sat");
+	stream1 += encoder1.encode_update(1, make_repository("S1", 30));
+	stream1 += encoder1.encode_drive(2, "/dev/sdb", "");
+	stream1 += encoder1.encode_update(2, make_repository("S2", 60, WarningLevel::Warning));
+
+	StorageAgentStreamEncoder encoder2;
+	std::string stream2 = encoder2.encode_start("host2");
+	stream2 += encoder2.encode_drive(1, "/dev/sda", "");
+	stream2 += encoder2.encode_update(1, make_repository("S3", 35));
+
+	StorageAgentStreamDecoder decoder1(StorageAgentDecoderMode::Summary);
+	StorageAgentStreamDecoder decoder2(StorageAgentDecoderMode::Summary);
+	REQUIRE(decoder1.feed(stream1));
+	REQUIRE(decoder2.feed(stream2));
+	REQUIRE(table.update(host1, decoder1));
+	REQUIRE(table.update(host2, decoder2));
+	REQUIRE(!table.update(host1, decoder1));  // nothing changed
+	REQUIRE(table.size() == 3);
+	REQUIRE(table.get_warning_counts().at(static_cast<std::size_t>(WarningLevel::Warning)) == 1);
+
+	// The troubled drive first, then by host
+	StorageFleetPage page = table.get_page(StorageDeviceFilter(), 0, 2);
+	REQUIRE(page.total == 3);
+	REQUIRE(page.rows.size() == 2);
+	REQUIRE(page.rows[0].summary.serial == "S2");
+	REQUIRE(page.rows[1].summary.serial == "S1");
+	page = table.get_page(StorageDeviceFilter(), 2, 2);
+	REQUIRE(page.rows.size() == 1);
+	REQUIRE(page.rows[0].summary.serial == "S3");
+	REQUIRE(page.rows[0].host == host2);
+
+	page = table.get_page(StorageDeviceFilter::create("host2"), 0, 10);
+	REQUIRE(page.total == 1);
+	page = table.get_page(StorageDeviceFilter::create("", WarningLevel::Warning), 0, 10);
+	REQUIRE(page.total == 1);
+	REQUIRE(page.rows[0].device == "/dev/sdb");
+
+	// The warning is gone, so the drive moves down
+	REQUIRE(decoder1.feed(encoder1.encode_update(2, make_repository("S2", 40))));
+	REQUIRE(table.update(host1, decoder1));
+	page = table.get_page(StorageDeviceFilter(), 0, 10);
+	REQUIRE(page.rows[0].summary.serial == "S1");
+	REQUIRE(page.rows[1].summary.serial == "S2");
+	REQUIRE(page.rows[1].summary.temperature == 40);
+
+	const StorageFleetRow* row = table.find(host2, 1);
+	REQUIRE(row);
+	REQUIRE(row->summary.serial == "S3");
+	REQUIRE(table.get_memory_usage() > 3 * sizeof(StorageFleetRow));
+
+	table.clear_host(host1);
+	REQUIRE(table.size() == 1);
+	REQUIRE(!table.find(host1, 1));
+	REQUIRE(table.find(host2, 1));
+}
+
+
+
+/// @}
@@ -0,0 +1,190 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_history.h"
+#include "hz/fs.h"
+#include <string>
+
+
+
+namespace {
+
+	/// Get a fresh history file path in the temporary directory
+	hz::fs::path get_test_history_file()
+	{
+		auto file = hz::fs::temp_directory_path() / "gsmartcontrol_test_history.dat";
+		std::error_code ec;
+		hz::fs::remove(file, ec);
+		return file;
+	}
+
+}
+
+
+
+TEST_CASE("StorageHistoryAppendAndQuery", "[app][history]")
+{
+	const auto file = get_test_history_file();
+	{
+		StorageHistory history(file);
+		REQUIRE(!history.open());
+
+		REQUIRE(!history.append("S1", 1000, {{"ata_attr/9/raw", 100}, {"ata_attr/194/raw", 35}}));
+		REQUIRE(!history.append("S1", 2000, {{"ata_attr/9/raw", 101}, {"ata_attr/194/raw", 35}}));
+		REQUIRE(!history.append("S2", 2000, {{"nvme/temperature", -5}}));
+		REQUIRE(!history.append("S1", 3000, {{"ata_attr/9/raw", 102}, {"ata_attr/194/raw", 30}}));
+		REQUIRE(!history.append("S1", 4000, {{"ata_attr/9/raw", 102}, {"ata_attr/194/raw", 30}}));
+	}
+
+	// Reload from file
+	StorageHistory history(file);
+	REQUIRE(!history.open());
+
+	REQUIRE(history.get_series_keys("S1") == std::vector<std::string>{"ata_attr/194/raw", "ata_attr/9/raw"});
+	REQUIRE(history.get_series("missing", "ata_attr/9/raw", 0, 10000).empty());
+
+	const auto hours = history.get_series("S1", "ata_attr/9/raw", 0, 10000);
+	REQUIRE(hours.size() == 4);  // 3 changes + last sample time
+	REQUIRE(hours[0].time == 1000);
+	REQUIRE(hours[0].value == 100);
+	REQUIRE(hours[2].time == 3000);
+	REQUIRE(hours[2].value == 102);
+	REQUIRE(hours[3].time == 4000);
+	REQUIRE(hours[3].value == 102);
+
+	// The value in effect at the range start is included
+	const auto temp = history.get_series("S1", "ata_attr/194/raw", 2500, 3500);
+	REQUIRE(temp.size() == 2);
+	REQUIRE(temp[0].time == 2500);
+	REQUIRE(temp[0].value == 35);
+	REQUIRE(temp[1].time == 3000);
+	REQUIRE(temp[1].value == 30);
+
+	REQUIRE(history.get_series("S2", "nvme/temperature", 0, 10000).front().value == -5);
+
+	// Unchanged values are not written: the last sample takes only a few bytes.
+	std::error_code ec;
+	const auto size_before = hz::fs::file_size(file, ec);
+	REQUIRE(!history.append("S1", 5000, {{"ata_attr/9/raw", 102}, {"ata_attr/194/raw", 30}}));
+	REQUIRE(hz::fs::file_size(file, ec) - size_before < 8);
+
+	hz::fs::remove(file, ec);
+}
+
+
+
+TEST_CASE("StorageHistoryTruncatedFile", "[app][history]")
+{
+	const auto file = get_test_history_file();
+	{
+		StorageHistory history(file);
+		REQUIRE(!history.open());
+		REQUIRE(!history.append("S1", 1000, {{"a", 1}}));
+		REQUIRE(!history.append("S1", 2000, {{"a", 2}}));
+	}
+
+	// Cut the last block in half, as if the program crashed while writing
+	std::error_code ec;
+	hz::fs::resize_file(file, hz::fs::file_size(file, ec) - 2, ec);
+	REQUIRE(!ec);
+
+	StorageHistory history(file);
+	REQUIRE(!history.open());
+	REQUIRE(history.get_series("S1", "a", 0, 10000).size() == 1);
+
+	// The broken tail is discarded before appending
+	REQUIRE(!history.append("S1", 3000, {{"a", 3}}));
+	StorageHistory reloaded(file);
+	REQUIRE(!reloaded.open());
+	const auto points = reloaded.get_series("S1", "a", 0, 10000);
+	REQUIRE(points.size() == 2);
+	REQUIRE(points[1].value == 3);
+
+	hz::fs::remove(file, ec);
+}
+
+
+
+TEST_CASE("StorageHistoryTrends", "[app][history]")
+{
+	const auto file = get_test_history_file();
+	{
+		StorageHistory history(file);
+		REQUIRE(!history.open());
+		REQUIRE(!history.append("S1", 0, {{"ata_attr/197/raw", 0}, {"ata_attr/9/raw", 1}}));
+		REQUIRE(!history.append("S1", 86400, {{"ata_attr/197/raw", 2}, {"ata_attr/9/raw", 25}}));
+		REQUIRE(!history.append("S1", 2 * 86400, {{"ata_attr/197/raw", 2}, {"ata_attr/9/raw", 49}}));
+	}
+
+	// The trends are rebuilt on load, the unchanged samples count too
+	StorageHistory history(file);
+	REQUIRE(!history.open());
+	const auto trends = history.get_trends("S1");
+	REQUIRE(trends.size() == 1);
+	REQUIRE(trends[0].first == "ata_attr/197/raw");
+	REQUIRE(trends[0].second.samples == 3);
+	REQUIRE(trends[0].second.increases == 1);
+	REQUIRE(history.get_trends("S2").empty());
+
+	std::error_code ec;
+	hz::fs::remove(file, ec);
+}
+
+
+
+TEST_CASE("StorageHistoryErrorLbas", "[app][history]")
+{
+	const auto file = get_test_history_file();
+	{
+		StorageHistory history(file);
+		REQUIRE(!history.open());
+		REQUIRE(!history.append("S1", 1000, {{"a", 1}}, {{5000, StorageErrorLbaSourceAtaErrorLog}}));
+		REQUIRE(!history.append("S1", 2000, {{"a", 1}}, {{5000, StorageErrorLbaSourceAtaErrorLog}, {7000, StorageErrorLbaSourceSelfTestLog}}));
+	}
+
+	StorageHistory history(file);
+	REQUIRE(!history.open());
+	REQUIRE(history.get_error_lbas("S2") == nullptr);
+
+	const auto lbas = history.get_error_lbas("S1");
+	REQUIRE(lbas != nullptr);
+	REQUIRE(lbas->get_lbas() == std::vector<std::uint64_t>{5000, 7000});
+	REQUIRE(lbas->find(5000)->first_seen == 1000);
+	REQUIRE(lbas->get_since(1500).size() == 1);
+
+	// Known LBAs are not written again
+	std::error_code ec;
+	const auto size_before = hz::fs::file_size(file, ec);
+	REQUIRE(!history.append("S1", 3000, {{"a", 1}}, {{5000, StorageErrorLbaSourceAtaErrorLog}, {7000, StorageErrorLbaSourceSelfTestLog}}));
+	REQUIRE(hz::fs::file_size(file, ec) - size_before < 8);
+
+	// A known LBA seen in a new log is recorded; the previously returned index is unchanged.
+	REQUIRE(!history.append("S1", 4000, {{"a", 1}}, {{5000, StorageErrorLbaSourceSelfTestLog}}));
+	REQUIRE(lbas->find(5000)->sources == StorageErrorLbaSourceAtaErrorLog);
+	const auto updated = history.get_error_lbas("S1");
+	REQUIRE(updated->find(5000)->sources == (StorageErrorLbaSourceAtaErrorLog | StorageErrorLbaSourceSelfTestLog));
+	REQUIRE(updated->find(5000)->first_seen == 1000);
+
+	hz::fs::remove(file, ec);
+}
+
+
+
+
+
+
+/// @}
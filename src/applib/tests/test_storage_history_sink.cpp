@@ -0,0 +1,144 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "applib/storage_history_sink.h"
+#include "hz/fs.h"
+
+
+
+namespace {
+
+	/// Get a fresh directory in the temporary directory
+	hz::fs::path get_test_sink_dir()
+	{
+		auto dir = hz::fs::temp_directory_path() / "gsmartcontrol_test_history_sink";
+		std::error_code ec;
+		hz::fs::remove_all(dir, ec);
+		hz::fs::create_directories(dir, ec);
+		return dir;
+	}
+
+
+	/// Decode a spooled chunk
+	std::vector<StorageHistoryChunkRow> read_test_chunk(const hz::fs::path& file)
+	{
+		std::string data;
+		REQUIRE(!hz::fs_file_get_contents(file, data, 1024 * 1024));
+		auto rows = storage_history_chunk_decode(data);
+		REQUIRE(rows);
+		return rows.value();
+	}
+
+}
+
+
+
+TEST_CASE("StorageHistoryChunk", "[app][history_sink]")
+{
+	const std::vector<StorageHistoryChunkRow> rows = {
+		{"S1", "ata_attr/9/raw", {1000, 100}},
+		{"S1", "ata_attr/9/raw", {2000, 101}},
+		{"S2", "nvme/temperature", {1500, -5}},
+		{"S1", "ata_attr/9/raw", {3000, 102}},
+	};
+	auto chunk = storage_history_chunk_encode("host1", rows);
+	REQUIRE(chunk);
+
+	auto decoded = storage_history_chunk_decode(chunk.value());
+	REQUIRE(decoded);
+	REQUIRE(decoded.value().size() == rows.size());
+	for (std::size_t i = 0; i < rows.size(); ++i) {
+		REQUIRE(decoded.value()[i].serial == rows[i].serial);
+		REQUIRE(decoded.value()[i].key == rows[i].key);
+		REQUIRE(decoded.value()[i].point.time == rows[i].point.time);
+		REQUIRE(decoded.value()[i].point.value == rows[i].point.value);
+	}
+
+	REQUIRE(!storage_history_chunk_decode("garbage"));
+}
+
+
+
+TEST_CASE("StorageHistorySink", "[app][history_sink]")
+{
+	const auto dir = get_test_sink_dir();
+	auto history = std::make_shared<StorageHistory>(dir / "history.dat");
+	REQUIRE(!history->open());
+	REQUIRE(!history->append("S1", 1000, {{"ata_attr/9/raw", 100}, {"ata_attr/194/raw", 35}}));
+	REQUIRE(!history->append("S1", 2000, {{"ata_attr/9/raw", 101}, {"ata_attr/194/raw", 35}}));
+
+	StorageHistorySinkSettings settings;
+	settings.spool_dir = dir / "spool";
+	settings.max_chunk_points = 4;
+	settings.max_chunk_interval = 100;
+
+	{
+		StorageHistorySink sink(history, settings);
+		REQUIRE(sink.open());
+
+		// 3 points, not due yet
+		REQUIRE(sink.collect(10));
+		REQUIRE(sink.get_spooled_chunks().empty());
+
+		// Too many points
+		REQUIRE(!history->append("S2", 2000, {{"nvme/temperature", 40}}));
+		REQUIRE(sink.collect(20));
+		const auto chunks = sink.get_spooled_chunks();
+		REQUIRE(chunks.size() == 1);
+		REQUIRE(read_test_chunk(chunks[0]).size() == 4);
+
+		// Too old
+		REQUIRE(!history->append("S2", 3000, {{"nvme/temperature", 41}}));
+		REQUIRE(sink.collect(30));
+		REQUIRE(sink.get_spooled_chunks().size() == 1);
+		REQUIRE(sink.collect(130));
+		REQUIRE(sink.get_spooled_chunks().size() == 2);
+
+		// Read, but not spooled
+		REQUIRE(!history->append("S2", 4000, {{"nvme/temperature", 42}}));
+		REQUIRE(sink.collect(140));
+	}
+
+	// The reading resumes after the last spooled chunk, the unspooled point is read again.
+	StorageHistorySink sink(history, settings);
+	REQUIRE(sink.open());
+	REQUIRE(sink.collect(150, true));
+	const auto chunks = sink.get_spooled_chunks();
+	REQUIRE(chunks.size() == 3);
+	const auto rows = read_test_chunk(chunks[2]);
+	REQUIRE(rows.size() == 1);
+	REQUIRE(rows[0].serial == "S2");
+	REQUIRE(rows[0].point.value == 42);
+
+	// Nothing new
+	REQUIRE(sink.collect(160, true));
+	REQUIRE(sink.get_spooled_chunks().size() == 3);
+
+	std::error_code ec;
+	hz::fs::remove_all(dir, ec);
+}
+
+
+
+
+
+
+/// @}
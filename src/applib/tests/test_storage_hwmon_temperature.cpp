@@ -0,0 +1,80 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_hwmon_temperature.h"
+
+
+
+namespace {
+
+	/// Create a hwmon node with a driver name and a temperature input
+	void create_hwmon_node(const hz::fs::path& dir, const std::string& name, const std::string& input)
+	{
+		std::error_code ec;
+		REQUIRE(hz::fs::create_directories(dir, ec));
+		REQUIRE(!hz::fs_file_put_contents(dir / "name", name + "\n"));
+		REQUIRE(!hz::fs_file_put_contents(dir / "temp1_input", input + "\n"));
+	}
+
+}
+
+
+
+TEST_CASE("StorageHwmonTemperature", "[app][hwmon]")
+{
+	const hz::fs::path sysfs = hz::fs::temp_directory_path() / "gsmartcontrol_test_hwmon";
+	std::error_code ec;
+	hz::fs::remove_all(sysfs, ec);
+
+	create_hwmon_node(sysfs / "block" / "sda" / "device" / "hwmon" / "hwmon2", "drivetemp", "37000");
+	create_hwmon_node(sysfs / "block" / "sdb" / "device" / "hwmon" / "hwmon3", "other", "40000");
+	create_hwmon_node(sysfs / "class" / "nvme" / "nvme0" / "hwmon4", "nvme", "41850");  // newer kernels
+	create_hwmon_node(sysfs / "class" / "nvme" / "nvme1" / "device" / "hwmon" / "hwmon5", "nvme", "-1500");  // older kernels
+
+	SECTION("Find") {
+		REQUIRE(storage_hwmon_find_temperature_input(sysfs, "/dev/sda")
+				== sysfs / "block" / "sda" / "device" / "hwmon" / "hwmon2" / "temp1_input");
+		REQUIRE(!storage_hwmon_find_temperature_input(sysfs, "/dev/sdb"));  // not drivetemp
+		REQUIRE(!storage_hwmon_find_temperature_input(sysfs, "/dev/sdc"));
+		REQUIRE(storage_hwmon_find_temperature_input(sysfs, "/dev/nvme0")
+				== sysfs / "class" / "nvme" / "nvme0" / "hwmon4" / "temp1_input");
+		REQUIRE(storage_hwmon_find_temperature_input(sysfs, "/dev/nvme0n1")
+				== sysfs / "class" / "nvme" / "nvme0" / "hwmon4" / "temp1_input");
+		REQUIRE(storage_hwmon_find_temperature_input(sysfs, "/dev/nvme1n2")
+				== sysfs / "class" / "nvme" / "nvme1" / "device" / "hwmon" / "hwmon5" / "temp1_input");
+		REQUIRE(!storage_hwmon_find_temperature_input(sysfs, "/dev/hda"));
+		REQUIRE(!storage_hwmon_find_temperature_input(sysfs, "sda"));
+	}
+
+	SECTION("Read") {
+		REQUIRE(storage_hwmon_read_temperature(sysfs / "block" / "sda" / "device" / "hwmon" / "hwmon2" / "temp1_input") == 37);
+		REQUIRE(storage_hwmon_read_temperature(sysfs / "class" / "nvme" / "nvme0" / "hwmon4" / "temp1_input") == 42);
+		REQUIRE(storage_hwmon_read_temperature(sysfs / "class" / "nvme" / "nvme1" / "device" / "hwmon" / "hwmon5" / "temp1_input") == -2);
+		REQUIRE(!storage_hwmon_read_temperature(sysfs / "block" / "sda" / "device" / "hwmon" / "hwmon2" / "name"));
+		REQUIRE(!storage_hwmon_read_temperature(sysfs / "missing"));
+
+		REQUIRE(!hz::fs_file_put_contents(sysfs / "garbage", "1000000\n"));
+		REQUIRE(!storage_hwmon_read_temperature(sysfs / "garbage"));
+	}
+
+	hz::fs::remove_all(sysfs, ec);
+}
+
+
+
+
+/// @}
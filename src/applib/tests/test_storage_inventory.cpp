@@ -0,0 +1,92 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "applib/storage_inventory.h"
+
+
+
+TEST_CASE("StorageInventoryParse", "[app][inventory]")
+{
+	const std::string json = R"({
+		"format_version": 1,
+		"drives": [
+			{"device": "/dev/sda"},
+			{"device": "/dev/twa0", "type_argument": "3ware,2"},
+			{"device": "/dev/sdb", "extra_arguments": ["-T", "permissive"]},
+			{"type_argument": "sat"}
+		]
+	})";
+
+	auto entries = storage_inventory_parse(json);
+	REQUIRE(entries.has_value());
+	REQUIRE(entries->size() == 3);
+	REQUIRE(entries->at(0).device == "/dev/sda");
+	REQUIRE(entries->at(0).type_argument.empty());
+	REQUIRE(entries->at(1).type_argument == "3ware,2");
+	REQUIRE(entries->at(2).extra_arguments == std::vector<std::string>{"-T", "permissive"});
+
+	// Round trip
+	auto reparsed = storage_inventory_parse(storage_inventory_dump(entries.value()));
+	REQUIRE(reparsed.has_value());
+	REQUIRE(reparsed.value() == entries.value());
+
+	REQUIRE(!storage_inventory_parse("{}").has_value());
+	REQUIRE(!storage_inventory_parse(R"({"format_version": 2, "drives": []})").has_value());
+	REQUIRE(!storage_inventory_parse("not json").has_value());
+}
+
+
+
+TEST_CASE("StorageInventoryReconcile", "[app][inventory]")
+{
+	std::vector<StorageInventoryEntry> entries(2);
+	entries[0].device = "/dev/sda";
+	entries[1].device = "/dev/twa0";
+	entries[1].type_argument = "3ware,2";
+
+	const auto drives = storage_inventory_create_drives(entries);
+	REQUIRE(drives.size() == 2);
+	REQUIRE(drives.at(1)->get_type_argument() == "3ware,2");
+
+	std::vector<StorageDevicePtr> detected = {
+		std::make_shared<StorageDevice>("/dev/sda"),
+		std::make_shared<StorageDevice>("/dev/twa0", "3ware,3"),
+		std::make_shared<StorageDevice>("/tmp/virtual.json", true),
+	};
+	const auto result = storage_inventory_reconcile(entries, detected);
+	REQUIRE(result.missing.size() == 1);
+	REQUIRE(result.missing.at(0).type_argument == "3ware,2");
+	REQUIRE(result.unlisted.size() == 1);
+	REQUIRE(result.unlisted.at(0)->get_type_argument() == "3ware,3");
+
+	// The inventory of the detected drives matches them
+	REQUIRE(storage_inventory_get_entries(detected).size() == 2);
+	const auto same = storage_inventory_reconcile(storage_inventory_get_entries(detected), detected);
+	REQUIRE(same.missing.empty());
+	REQUIRE(same.unlisted.empty());
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,184 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_io_load.h"
+
+using namespace std::chrono_literals;
+
+
+
+namespace {
+
+	/// /proc/diskstats of a newer kernel (with the discard and flush fields)
+	constexpr std::string_view diskstats_contents =
+		"   8       0 sda 1000 10 80000 5000 500 20 40000 2500 3 4000 7600 0 0 0 0 0 0\n"
+		"   8       1 sda1 900 10 70000 4000 400 20 30000 2000 0 3000 6000 0 0 0 0 0 0\n"
+		" 259       0 nvme0n1 100 0 800 50 100 0 800 50 1 60 110 0 0 0 0 10 5\n"
+		" 259       1 nvme0n1p1 90 0 700 40 90 0 700 40 0 50 80 0 0 0 0 0 0\n"
+		" 259       2 nvme0n2 10 0 80 5 10 0 80 5 2 6 11 0 0 0 0 0 0\n"
+		" 259       3 nvme10n1 10 0 80 5 10 0 80 5 7 6 11\n"
+		"   7       0 loop0 broken line\n";
+
+}
+
+
+
+TEST_CASE("StorageIoLoadParse", "[app][io_load]")
+{
+	const auto stats = storage_io_parse_diskstats(diskstats_contents);
+	REQUIRE(stats.size() == 6);
+	REQUIRE(stats.at("sda").reads_completed == 1000);
+	REQUIRE(stats.at("sda").writes_completed == 500);
+	REQUIRE(stats.at("sda").sectors_read == 80000);
+	REQUIRE(stats.at("sda").sectors_written == 40000);
+	REQUIRE(stats.at("sda").io_time_msec == 7500);
+	REQUIRE(stats.at("sda").in_flight == 3);
+	REQUIRE(stats.at("sda").busy_time_msec == 4000);
+	REQUIRE(stats.at("sda").weighted_io_time_msec == 7600);
+	REQUIRE(stats.at("nvme10n1").in_flight == 7);  // older kernel, 11 fields
+	REQUIRE(!stats.contains("loop0"));
+
+	bool prefix = false;
+	REQUIRE(storage_io_get_diskstats_name("/dev/sda", prefix) == "sda");
+	REQUIRE(!prefix);
+	REQUIRE(storage_io_get_diskstats_name("/dev/nvme0n1", prefix) == "nvme0n1");
+	REQUIRE(!prefix);
+	REQUIRE(storage_io_get_diskstats_name("/dev/nvme0", prefix) == "nvme0n");
+	REQUIRE(prefix);
+	REQUIRE(storage_io_get_diskstats_name("/dev/twa0", prefix).empty());
+	REQUIRE(storage_io_get_diskstats_name("/dev/bus/0", prefix).empty());
+	REQUIRE(storage_io_get_diskstats_name("sda", prefix).empty());
+}
+
+
+
+TEST_CASE("StorageIoLoadCompute", "[app][io_load]")
+{
+	StorageIoStats previous {.reads_completed = 600, .writes_completed = 400, .io_time_msec = 5000, .weighted_io_time_msec = 7000};
+	StorageIoStats current {.reads_completed = 650, .writes_completed = 450, .io_time_msec = 7000, .in_flight = 6, .weighted_io_time_msec = 9000};
+
+	const StorageIoLoad load = storage_io_compute_load(previous, current, 1s);
+	REQUIRE(load.in_flight == 6);
+	REQUIRE(load.queue_depth == Approx(2.));
+	REQUIRE(load.latency_msec.has_value());
+	REQUIRE(load.latency_msec.value() == Approx(20.));
+
+	// Nothing completed, reset counters
+	const StorageIoLoad idle = storage_io_compute_load(current, previous, 1s);
+	REQUIRE(idle.queue_depth == 0.);
+	REQUIRE(!idle.latency_msec.has_value());
+
+	StorageIoLoadThresholds thresholds {4., 50.};
+	REQUIRE(thresholds.get_exceeded(load));  // 6 in flight
+	REQUIRE(!thresholds.get_exceeded(idle));
+
+	thresholds = {0., 10.};
+	REQUIRE(thresholds.get_exceeded(load));  // 20 ms
+	thresholds = {0., 0.};
+	REQUIRE(!thresholds.get_exceeded(load));
+}
+
+
+
+TEST_CASE("StorageIoPerformanceCompute", "[app][io_load]")
+{
+	StorageIoStats previous {600, 400, 8000, 4000, 5000, 0, 1000, 7000};
+	StorageIoStats current {800, 500, 12000, 6000, 6500, 2, 1500, 11000};
+
+	const StorageIoPerformance perf = storage_io_compute_performance(previous, current, 2s);
+	REQUIRE(perf.read_iops == Approx(100.));
+	REQUIRE(perf.write_iops == Approx(50.));
+	REQUIRE(perf.read_bytes_per_sec == Approx(4000. * 512 / 2));
+	REQUIRE(perf.write_bytes_per_sec == Approx(2000. * 512 / 2));
+	REQUIRE(perf.service_time_msec.has_value());
+	REQUIRE(perf.service_time_msec.value() == Approx(5.));  // 1500 ms / 300 I/Os
+	REQUIRE(perf.queue_depth == Approx(2.));
+	REQUIRE(perf.utilization == Approx(0.25));
+
+	// Nothing completed, reset counters
+	const StorageIoPerformance idle = storage_io_compute_performance(current, previous, 2s);
+	REQUIRE(idle.read_iops == 0.);
+	REQUIRE(!idle.service_time_msec.has_value());
+	REQUIRE(idle.utilization == 0.);
+
+	const auto stats = storage_io_parse_diskstats(diskstats_contents);
+	const auto nvme = storage_io_find_stats(stats, "/dev/nvme0");  // namespaces summed, no partitions
+	REQUIRE(nvme.has_value());
+	REQUIRE(nvme->reads_completed == 110);
+	REQUIRE(nvme->in_flight == 3);
+	REQUIRE(nvme->busy_time_msec == 60);  // the namespaces share the controller
+	REQUIRE(storage_io_find_stats(stats, "/dev/sda").value().reads_completed == 1000);
+	REQUIRE(!storage_io_find_stats(stats, "/dev/sdz").has_value());
+}
+
+
+
+TEST_CASE("StorageIoLoadGuard", "[app][io_load]")
+{
+	const hz::fs::path file = hz::fs::temp_directory_path() / "gsmartcontrol_test_diskstats";
+	REQUIRE(!hz::fs_file_put_contents(file, std::string(diskstats_contents)));
+
+	StorageIoLoadGuard guard(file, {4., 50.});
+
+	// A single sample only has the in-flight counts
+	const auto sda_load = guard.get_load("/dev/sda");
+	REQUIRE(sda_load.has_value());
+	REQUIRE(sda_load->in_flight == 3);
+	REQUIRE(!sda_load->latency_msec.has_value());
+
+	// The namespaces of a controller are summed, without the partitions
+	const auto nvme_load = guard.get_load("/dev/nvme0");
+	REQUIRE(nvme_load.has_value());
+	REQUIRE(nvme_load->in_flight == 3);
+
+	REQUIRE(!guard.get_load("/dev/sdz").has_value());
+	REQUIRE(!guard.get_load("/dev/twa0").has_value());
+
+	std::error_code ec;
+	hz::fs::remove(file, ec);
+}
+
+
+
+TEST_CASE("StorageIoPerformanceMonitor", "[app][io_load]")
+{
+	const hz::fs::path file = hz::fs::temp_directory_path() / "gsmartcontrol_test_diskstats_perf";
+	REQUIRE(!hz::fs_file_put_contents(file, std::string(diskstats_contents)));
+
+	StorageIoPerformanceMonitor monitor(file, 1s);
+	int emitted = 0;
+	monitor.signal_sampled().connect([&emitted]() { ++emitted; });
+
+	const StorageDevice sda("/dev/sda", std::string());
+	monitor.sample();
+	REQUIRE(emitted == 1);
+	REQUIRE(!monitor.get_performance(sda).has_value());  // a single sample
+
+	monitor.sample();
+	REQUIRE(emitted == 2);
+	const auto perf = monitor.get_performance(sda);
+	REQUIRE(perf.has_value());
+	REQUIRE(perf->read_iops == 0.);  // unchanged file
+	REQUIRE(!monitor.get_performance(StorageDevice("/dev/sdz", std::string())).has_value());
+
+	std::error_code ec;
+	hz::fs::remove(file, ec);
+}
+
+
+
+/// @}
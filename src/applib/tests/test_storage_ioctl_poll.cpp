@@ -0,0 +1,248 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_ioctl_poll.h"
+#include "applib/smartctl_parser.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+	/// Output of a smartctl fetch, as the previous data
+	const std::string s_previous_json = R"json({
+		"json_format_version": [1, 0],
+		"smartctl": {"version": [7, 4], "exit_status": 0},
+		"model_name": "ST1000",
+		"smart_status": {"passed": true},
+		"temperature": {"current": 29},
+		"ata_smart_attributes": {"revision": 10, "table": [
+			{"id": 5, "name": "Reallocated_Sector_Ct", "value": 100, "worst": 100, "thresh": 36, "when_failed": "",
+				"flags": {"value": 51, "string": "PO--CK ", "prefailure": true, "updated_online": true},
+				"raw": {"value": 0, "string": "0"}},
+			{"id": 194, "name": "Temperature_Celsius", "value": 71, "worst": 59, "thresh": 0, "when_failed": "",
+				"flags": {"value": 34, "string": "-O---K ", "prefailure": false, "updated_online": true},
+				"raw": {"value": 176095166493, "string": "29 (Min/Max 23/41)"}}
+		]}
+	})json";
+
+
+	/// Parse smartctl JSON output of an ATA or NVMe drive
+	StoragePropertyRepository parse_json(const std::string& json, SmartctlParserType type = SmartctlParserType::Ata)
+	{
+		auto parser = SmartctlParser::create(type, SmartctlOutputFormat::Json);
+		REQUIRE(parser);
+		REQUIRE(parser->parse(json));
+		return parser->get_property_repository();
+	}
+
+
+	/// Create a SMART READ DATA page with attributes (ID, flags, value, worst, raw value)
+	std::array<std::uint8_t, 512> make_ata_page(const std::vector<StorageIoctlAtaAttribute>& attributes)
+	{
+		std::array<std::uint8_t, 512> page = {};
+		page[0] = 10;  // revision
+		for (std::size_t i = 0; i < attributes.size(); ++i) {
+			const auto& a = attributes[i];
+			const std::size_t offset = 2 + i * 12;
+			page[offset] = static_cast<std::uint8_t>(a.id);
+			page[offset + 1] = static_cast<std::uint8_t>(a.flags & 0xff);
+			page[offset + 2] = static_cast<std::uint8_t>(a.flags >> 8);
+			page[offset + 3] = a.value;
+			page[offset + 4] = a.worst;
+			for (std::size_t b = 0; b < 6; ++b) {
+				page[offset + 5 + b] = static_cast<std::uint8_t>(a.raw_value >> (8 * b));
+			}
+		}
+		std::uint8_t sum = 0;
+		for (std::size_t i = 0; i < 511; ++i) {
+			sum = static_cast<std::uint8_t>(sum + page[i]);
+		}
+		page[511] = static_cast<std::uint8_t>(0x100 - sum);
+		return page;
+	}
+
+
+	/// Find an attribute by ID
+	const AtaStorageAttribute* find_attribute(const StoragePropertyRepository& repo, std::int32_t id)
+	{
+		for (const auto& p : repo.get_properties()) {
+			if (p.is_value_type<AtaStorageAttribute>() && p.get_value<AtaStorageAttribute>().id == id) {
+				return &p.get_value<AtaStorageAttribute>();
+			}
+		}
+		return nullptr;
+	}
+
+}
+
+
+
+TEST_CASE("StorageIoctlPollAtaDecode", "[app][ioctl_poll]")
+{
+	const std::vector<StorageIoctlAtaAttribute> attributes = {
+		{5, 0x33, 100, 100, 8},
+		{194, 0x22, 70, 59, 0x290017001eULL},
+	};
+	auto page = make_ata_page(attributes);
+	auto decoded = storage_ioctl_decode_ata_smart_data(page);
+	REQUIRE(decoded);
+	REQUIRE(decoded.value() == attributes);
+
+	page[100] ^= 0x01;
+	auto broken = storage_ioctl_decode_ata_smart_data(page);
+	REQUIRE(!broken);
+	REQUIRE(broken.error().data() == StorageIoctlPollError::InvalidData);
+
+	REQUIRE(!storage_ioctl_decode_ata_smart_data(std::span(page).first(100)));
+}
+
+
+
+TEST_CASE("StorageIoctlPollAtaRawValue", "[app][ioctl_poll]")
+{
+	AtaStorageAttribute decimal;
+	decimal.raw_value = "12";
+	decimal.raw_value_int = 12;
+	REQUIRE(storage_ioctl_format_ata_raw_value(decimal, 12) == "12");
+	REQUIRE(storage_ioctl_format_ata_raw_value(decimal, 13) == "13");
+
+	AtaStorageAttribute temperature;
+	temperature.raw_value = "29 (Min/Max 23/41)";
+	temperature.raw_value_int = 0x290017001d;
+	REQUIRE(storage_ioctl_format_ata_raw_value(temperature, 0x290017001e) == "30 (Min/Max 23/41)");
+	REQUIRE(!storage_ioctl_format_ata_raw_value(temperature, 0x2a0017001e));  // the maximum changed
+
+	AtaStorageAttribute text;
+	text.raw_value = "Unknown";
+	text.raw_value_int = 5;
+	REQUIRE(!storage_ioctl_format_ata_raw_value(text, 6));
+}
+
+
+
+TEST_CASE("StorageIoctlPollAtaJson", "[app][ioctl_poll]")
+{
+	const StoragePropertyRepository previous = parse_json(s_previous_json);
+	REQUIRE(find_attribute(previous, 194) != nullptr);
+
+	SECTION("Updated") {
+		const std::vector<StorageIoctlAtaAttribute> attributes = {
+			{5, 0x33, 30, 30, 8},
+			{194, 0x22, 70, 59, 0x290017001eULL},
+		};
+		auto json = storage_ioctl_create_ata_json(previous, attributes, false);
+		REQUIRE(json);
+		const StoragePropertyRepository merged = storage_ioctl_merge_properties(previous, parse_json(json.value()));
+		REQUIRE(merged.get_properties().size() == previous.get_properties().size());
+
+		const auto* reallocated = find_attribute(merged, 5);
+		REQUIRE(reallocated != nullptr);
+		REQUIRE(reallocated->value == 30);
+		REQUIRE(reallocated->threshold == 36);
+		REQUIRE(reallocated->flag == "PO--CK ");
+		REQUIRE(reallocated->when_failed == AtaStorageAttribute::FailTime::Now);
+		REQUIRE(reallocated->raw_value == "8");
+		REQUIRE(reallocated->raw_value_int == 8);
+
+		const auto* temperature_attr = find_attribute(merged, 194);
+		REQUIRE(temperature_attr != nullptr);
+		REQUIRE(temperature_attr->raw_value == "30 (Min/Max 23/41)");
+
+		REQUIRE(merged.find_property("temperature/current")->get_value<std::int64_t>() == 30);
+		REQUIRE(merged.find_property("smart_status/passed")->get_value<bool>() == false);
+		REQUIRE(merged.find_property("model_name")->get_value<std::string>() == "ST1000");  // kept
+	}
+
+	SECTION("Unchanged") {
+		const std::vector<StorageIoctlAtaAttribute> attributes = {
+			{5, 0x33, 100, 100, 0},
+			{194, 0x22, 71, 59, 176095166493ULL},
+		};
+		auto json = storage_ioctl_create_ata_json(previous, attributes, true);
+		REQUIRE(json);
+		const StoragePropertyRepository merged = storage_ioctl_merge_properties(previous, parse_json(json.value()));
+		for (const std::int32_t id : {5, 194}) {
+			REQUIRE(*find_attribute(merged, id) == *find_attribute(previous, id));
+		}
+	}
+
+	SECTION("Needs full fetch") {
+		// A new attribute
+		auto json = storage_ioctl_create_ata_json(previous, {{5, 0x33, 100, 100, 0}, {9, 0x32, 99, 99, 100},
+				{194, 0x22, 71, 59, 176095166493ULL}}, true);
+		REQUIRE(!json);
+		REQUIRE(json.error().data() == StorageIoctlPollError::NeedsFullFetch);
+
+		// A raw value which can't be formatted without the drive database
+		json = storage_ioctl_create_ata_json(previous, {{5, 0x33, 100, 100, 0}, {194, 0x22, 71, 59, 0x2a0017001eULL}}, true);
+		REQUIRE(!json);
+		REQUIRE(json.error().data() == StorageIoctlPollError::NeedsFullFetch);
+	}
+}
+
+
+
+TEST_CASE("StorageIoctlPollNvme", "[app][ioctl_poll]")
+{
+	std::array<std::uint8_t, 512> page = {};
+	page[0] = 0x04;  // critical warning: reliability degraded
+	page[1] = 300 & 0xff;  // 300 K
+	page[2] = 300 >> 8;
+	page[3] = 100;
+	page[4] = 10;
+	page[5] = 3;
+	page[32] = 0x10;  // data units read
+	page[33] = 0x27;
+	page[128] = 200;  // power on hours
+	page[48 + 8] = 1;  // data units written, above 64 bits
+
+	auto health_log = storage_ioctl_decode_nvme_health_log(page);
+	REQUIRE(health_log);
+	REQUIRE(health_log->temperature == 27);
+	REQUIRE(health_log->data_units_read == 10000);
+	REQUIRE(health_log->data_units_written == INT64_MAX);
+	REQUIRE(health_log->power_on_hours == 200);
+
+	const StoragePropertyRepository polled = parse_json(storage_ioctl_create_nvme_json(health_log.value()), SmartctlParserType::Nvme);
+	REQUIRE(polled.find_property("nvme_smart_health_information_log/temperature")->get_value<std::int64_t>() == 27);
+	REQUIRE(polled.find_property("nvme_smart_health_information_log/available_spare")->readable_value == "100%");
+	REQUIRE(polled.find_property("nvme_smart_health_information_log/power_on_hours")->get_value<std::int64_t>() == 200);
+	REQUIRE(polled.find_property("smart_status/passed")->get_value<bool>() == false);
+}
+
+
+
+TEST_CASE("StorageIoctlPollSupported", "[app][ioctl_poll]")
+{
+#ifdef __linux__
+	REQUIRE(storage_ioctl_poll_get_supported("/dev/sda", "", StorageDeviceDetectedType::AtaHdd));
+	REQUIRE(storage_ioctl_poll_get_supported("/dev/sda", "sat", StorageDeviceDetectedType::AtaSsd));
+	REQUIRE(storage_ioctl_poll_get_supported("/dev/nvme0", "", StorageDeviceDetectedType::Nvme));
+#endif
+	REQUIRE(!storage_ioctl_poll_get_supported("/dev/sda", "megaraid,0", StorageDeviceDetectedType::AtaHdd));
+	REQUIRE(!storage_ioctl_poll_get_supported("/dev/sda", "", StorageDeviceDetectedType::BasicScsi));
+	REQUIRE(!storage_ioctl_poll_get_supported("/dev/twa0", "", StorageDeviceDetectedType::AtaHdd));
+}
+
+
+
+
+/// @}
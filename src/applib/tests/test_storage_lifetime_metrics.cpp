@@ -0,0 +1,151 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include "applib/storage_lifetime_metrics.h"
+#include "applib/storage_property.h"
+
+
+
+namespace {
+
+	constexpr std::int64_t day = 86400;
+
+
+	/// Create an NVMe health property
+	StorageProperty create_nvme_property(const std::string& name, std::int64_t value)
+	{
+		StorageProperty p;
+		p.set_name("nvme_smart_health_information_log/" + name, name);
+		p.section = StoragePropertySection::NvmeAttributes;
+		p.value = value;
+		return p;
+	}
+
+
+	/// Create an ATA device statistic property
+	StorageProperty create_statistic_property(std::int64_t page, std::int64_t offset, std::int64_t value)
+	{
+		AtaStorageStatistic stat;
+		stat.page = page;
+		stat.offset = offset;
+		stat.value_int = value;
+		return StorageProperty(StoragePropertySection::Statistics, stat);
+	}
+
+}
+
+
+
+TEST_CASE("StorageLifetimeCounters", "[app][lifetime_metrics]")
+{
+	StoragePropertyRepository nvme;
+	nvme.add_property(create_nvme_property("data_units_written", 10));
+	nvme.add_property(create_nvme_property("power_on_hours", 100));
+	nvme.add_property(create_nvme_property("percentage_used", 3));
+	const auto nvme_counters = StorageLifetimeCounters::get_from_properties(nvme);
+	REQUIRE(nvme_counters.bytes_written == 10 * 512'000);
+	REQUIRE(nvme_counters.power_on_hours == 100);
+	REQUIRE(nvme_counters.percentage_used == 3);
+
+	StoragePropertyRepository ata;
+	StorageProperty sector_size(StoragePropertySection::Info, std::string("4096 bytes logical, 4096 bytes physical"));
+	sector_size.set_name("physical_block_size/_and/logical_block_size", "Sector Size");
+	ata.add_property(sector_size);
+	ata.add_property(create_statistic_property(0x01, 0x010, 200));
+	ata.add_property(create_statistic_property(0x01, 0x018, 1000));
+	const auto ata_counters = StorageLifetimeCounters::get_from_properties(ata);
+	REQUIRE(ata_counters.bytes_written == 1000 * 4096);
+	REQUIRE(ata_counters.power_on_hours == 200);
+	REQUIRE(!ata_counters.percentage_used.has_value());
+}
+
+
+
+TEST_CASE("StorageLifetimeMetricsUpdate", "[app][lifetime_metrics]")
+{
+	constexpr std::int64_t gb = 1'000'000'000;
+
+	// 10 days of power-on time, 100 GB written, 10% used
+	StorageLifetimeCounters counters;
+	counters.bytes_written = 100 * gb;
+	counters.power_on_hours = 240;
+	counters.percentage_used = 10;
+
+	StorageLifetimeMetrics metrics;
+	metrics.update(counters, 0);
+
+	// The first refresh has the lifetime averages only
+	REQUIRE(metrics.get_bytes_per_day().value() == Approx(10. * gb));
+	REQUIRE(metrics.get_write_rate().value() * day == Approx(10. * gb));
+	REQUIRE(metrics.get_workload_intensity().value() == Approx(1.));
+	REQUIRE(metrics.get_remaining_endurance_days().value() == Approx(90.));
+
+	// A steady 40 GB per day is approached
+	for (std::int64_t i = 1; i <= 20; ++i) {
+		counters.bytes_written = counters.bytes_written.value() + 40 * gb;
+		counters.power_on_hours = counters.power_on_hours.value() + 24;
+		metrics.update(counters, i * day);
+	}
+	REQUIRE(metrics.get_write_rate().value() * day == Approx(40. * gb).epsilon(0.01));
+	REQUIRE(metrics.get_workload_intensity().value() > 1.);
+
+	// An unchanged refresh (e.g. a reparse) changes nothing
+	const auto rate = metrics.get_write_rate();
+	metrics.update(counters, 30 * day);
+	REQUIRE(metrics.get_write_rate() == rate);
+
+	// Another drive, the counters went back
+	counters.bytes_written = 0;
+	counters.power_on_hours = 0;
+	counters.percentage_used = 0;
+	metrics.update(counters, 31 * day);
+	REQUIRE(!metrics.get_write_rate().has_value());
+	REQUIRE(!metrics.get_bytes_per_day().has_value());
+	REQUIRE(!metrics.get_remaining_endurance_days().has_value());
+}
+
+
+
+TEST_CASE("StorageLifetimeMetricsProperties", "[app][lifetime_metrics]")
+{
+	StoragePropertyRepository properties;
+	properties.add_property(create_nvme_property("data_units_written", 2'000'000));  // 1.024 TB
+	properties.add_property(create_nvme_property("power_on_hours", 1000));
+	properties.add_property(create_nvme_property("percentage_used", 1));
+
+	StorageLifetimeMetrics metrics;
+	metrics.update(properties, 1'700'000'000);
+
+	for (const auto* name : {"lifetime/write_rate", "lifetime/bytes_written_per_day",
+			"lifetime/remaining_endurance_days", "lifetime/workload_intensity"}) {
+		const auto* p = properties.find_property(name, StoragePropertySection::Info);
+		REQUIRE(p != nullptr);
+		REQUIRE(p->is_value_type<std::int64_t>());
+		REQUIRE(!p->readable_value.empty());
+	}
+	REQUIRE(properties.find_property("lifetime/workload_intensity")->get_value<std::int64_t>() == 100);
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,125 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "applib/storage_device.h"
+#include "applib/storage_memory_budget.h"
+
+
+
+namespace {
+
+	/// Create a virtual drive with fully parsed JSON ATA data
+	StorageDevicePtr make_parsed_drive(const std::string& serial)
+	{
+		auto drive = std::make_shared<StorageDevice>("/tmp/" + serial + ".json", true);
+		drive->set_virtual_output(R"({
+			"json_format_version": [1, 0],
+			"smartctl": {"version": [7, 3], "exit_status": 0},
+			"device": {"name": "/dev/sda", "type": "sat", "protocol": "ATA"},
+			"model_name": "ST1000",
+			"serial_number": ")" + serial + R"(",
+			"smart_support": {"available": true, "enabled": true},
+			"smart_status": {"passed": true},
+			"temperature": {"current": 35},
+			"power_on_time": {"hours": 12345},
+			"ata_smart_attributes": {"revision": 10, "table": [
+				{"id": 5, "name": "Reallocated_Sector_Ct", "value": 100, "worst": 100, "thresh": 10,
+					"flags": {"value": 51, "string": "PO--CK ", "prefailure": true},
+					"raw": {"value": 0, "string": "0"}},
+				{"id": 194, "name": "Temperature_Celsius", "value": 100, "worst": 100, "thresh": 0,
+					"flags": {"value": 34, "string": "-O---K ", "prefailure": false},
+					"raw": {"value": 35, "string": "35"}}
+			]}
+		})");
+		REQUIRE(drive->parse_any_data_for_virtual());
+		REQUIRE(drive->get_parse_status() == StorageDevice::ParseStatus::Full);
+		return drive;
+	}
+
+}
+
+
+
+TEST_CASE("StorageDeviceCompactData", "[app][device]")
+{
+	const auto drive = make_parsed_drive("S1");
+	const std::string output = drive->get_full_output();
+	const std::size_t property_count = drive->get_property_repository().get_properties().size();
+	const std::size_t memory_usage = drive->get_memory_usage().get_total();
+
+	REQUIRE(drive->compact_data());
+	REQUIRE(drive->get_data_compacted());
+	REQUIRE_FALSE(drive->compact_data());  // already compacted
+	REQUIRE(drive->get_full_output().empty());
+	REQUIRE(drive->get_property_repository().get_properties().size() < property_count);
+	REQUIRE(drive->get_memory_usage().get_total() < memory_usage);
+
+	// The summary stays
+	REQUIRE(drive->get_serial_number() == "S1");
+	REQUIRE(drive->get_parse_status() == StorageDevice::ParseStatus::Full);
+	REQUIRE(drive->get_health_property().get_value<bool>());
+	REQUIRE(drive->get_snapshot()->serial_number == "S1");
+
+	REQUIRE(drive->restore_compacted_data());
+	REQUIRE_FALSE(drive->get_data_compacted());
+	REQUIRE(drive->get_full_output() == output);
+	REQUIRE(drive->get_property_repository().get_properties().size() == property_count);
+	REQUIRE(drive->restore_compacted_data());  // nothing to do
+}
+
+
+
+TEST_CASE("StorageMemoryBudget", "[app][device]")
+{
+	const std::vector<StorageDevicePtr> drives = {make_parsed_drive("S1"), make_parsed_drive("S2"), make_parsed_drive("S3")};
+	const std::size_t drive_usage = drives.front()->get_memory_usage().get_total();
+
+	SECTION("Unlimited") {
+		StorageMemoryBudget budget;
+		REQUIRE(budget.enforce(drives) == 0);
+	}
+
+	SECTION("Least recently used first") {
+		StorageMemoryBudget budget(drive_usage * 3 - 1);
+		budget.touch(drives[0].get());
+		budget.touch(drives[2].get());
+		budget.touch(drives[0].get());
+		REQUIRE(budget.enforce(drives) == 1);
+		REQUIRE(drives[1]->get_data_compacted());  // never touched
+		REQUIRE_FALSE(drives[0]->get_data_compacted());
+		REQUIRE_FALSE(drives[2]->get_data_compacted());
+		REQUIRE(budget.enforce(drives) == 0);  // fits now
+	}
+
+	SECTION("Kept drives") {
+		StorageMemoryBudget budget(1);
+		const std::size_t compacted = budget.enforce(drives, [&drives](const StorageDevice& drive) {
+			return &drive == drives[1].get();
+		});
+		REQUIRE(compacted == 2);
+		REQUIRE_FALSE(drives[1]->get_data_compacted());
+	}
+}
+
+
+
+
+/// @}
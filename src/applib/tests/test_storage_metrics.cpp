@@ -0,0 +1,85 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_metrics.h"
+#include <string>
+
+
+
+TEST_CASE("StorageMetricsEscapeLabelValue", "[app][metrics]")
+{
+	REQUIRE(StorageMetricsWriter::escape_label_value("plain") == "plain");
+	REQUIRE(StorageMetricsWriter::escape_label_value("a\"b\\c\nd") == "a\\\"b\\\\c\\nd");
+}
+
+
+
+TEST_CASE("StorageMetricsGrouping", "[app][metrics]")
+{
+	StorageMetricsWriter drive1, drive2;
+	drive1.add_sample("gsmartcontrol_up", {{"device", "/dev/sda"}}, std::int64_t(1));
+	drive1.add_sample("gsmartcontrol_temperature_celsius", {{"device", "/dev/sda"}}, std::int64_t(35));
+	drive2.add_sample("gsmartcontrol_temperature_celsius", {{"device", "/dev/sdb"}}, 40.5);
+	drive2.add_sample("gsmartcontrol_up", {{"device", "/dev/sdb"}}, std::int64_t(0));
+	drive2.add_sample("gsmartcontrol_unknown_family", {}, std::int64_t(1));  // ignored
+
+	StorageMetricsWriter writer;
+	writer.merge(drive1);
+	writer.merge(drive2);
+
+	// Samples of the same family are together, in the family table order.
+	REQUIRE(writer.get_text() ==
+			"# HELP gsmartcontrol_up Whether the last refresh of the drive data succeeded\n"
+			"# TYPE gsmartcontrol_up gauge\n"
+			"gsmartcontrol_up{device=\"/dev/sda\"} 1\n"
+			"gsmartcontrol_up{device=\"/dev/sdb\"} 0\n"
+			"# HELP gsmartcontrol_temperature_celsius Current drive temperature\n"
+			"# TYPE gsmartcontrol_temperature_celsius gauge\n"
+			"gsmartcontrol_temperature_celsius{device=\"/dev/sda\"} 35\n"
+			"gsmartcontrol_temperature_celsius{device=\"/dev/sdb\"} 40.5\n"
+			"# EOF\n");
+
+	REQUIRE(StorageMetricsWriter().get_text() == "# EOF\n");
+}
+
+
+
+TEST_CASE("StorageMetricsFamilyTexts", "[app][metrics]")
+{
+	StorageMetricsWriter drive1, drive2;
+	drive1.add_sample("gsmartcontrol_up", {{"device", "/dev/sda"}}, std::int64_t(1));
+	drive1.add_sample("gsmartcontrol_temperature_celsius", {{"device", "/dev/sda"}}, std::int64_t(35));
+	drive2.add_sample("gsmartcontrol_up", {{"device", "/dev/sdb"}}, std::int64_t(0));
+
+	StorageMetricsWriter merged;
+	merged.merge(drive1);
+	merged.merge(drive2);
+
+	// Joining the cached buffers gives the same text as merging the writers
+	const StorageMetricsFamilyTexts texts1 = drive1.get_family_texts();
+	const StorageMetricsFamilyTexts texts2 = drive2.get_family_texts();
+	REQUIRE(StorageMetricsWriter::join_family_texts({&texts1, nullptr, &texts2}) == merged.get_text());
+
+	REQUIRE(StorageMetricsWriter::join_family_texts({}) == "# EOF\n");
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,123 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <string>
+
+#include "rconfig/rconfig.h"
+#include "applib/storage_nvme_controller.h"
+
+
+
+namespace {
+
+	StorageProperty make_property(StoragePropertySection section, const std::string& name, std::int64_t value)
+	{
+		StorageProperty p(section, value);
+		p.set_name(name, name);
+		return p;
+	}
+
+}
+
+
+
+TEST_CASE("StorageNvmeParseDeviceName", "[app][nvme]")
+{
+	auto name = storage_nvme_parse_device_name("/dev/nvme0n1");
+	REQUIRE(name.has_value());
+	REQUIRE(name->controller == "/dev/nvme0");
+	REQUIRE(name->namespace_id == 1);
+
+	name = storage_nvme_parse_device_name("/dev/nvme12ns3");  // FreeBSD
+	REQUIRE(name.has_value());
+	REQUIRE(name->controller == "/dev/nvme12");
+	REQUIRE(name->namespace_id == 3);
+
+	name = storage_nvme_parse_device_name("/dev/nvme1");
+	REQUIRE(name.has_value());
+	REQUIRE(name->controller == "/dev/nvme1");
+	REQUIRE_FALSE(name->namespace_id.has_value());
+
+	REQUIRE_FALSE(storage_nvme_parse_device_name("/dev/sda").has_value());
+	REQUIRE_FALSE(storage_nvme_parse_device_name("/dev/nvme0n1p2").has_value());  // partition
+}
+
+
+
+TEST_CASE("StorageNvmeMergeControllerProperties", "[app][nvme]")
+{
+	StoragePropertyRepository controller_repo;
+	controller_repo.add_property(make_property(StoragePropertySection::Info, "user_capacity/bytes", 1000));
+	controller_repo.add_property(make_property(StoragePropertySection::Info, "temperature/current", 40));
+	controller_repo.add_property(make_property(StoragePropertySection::OverallHealth, "smart_status/passed", 1));
+	controller_repo.add_property(make_property(StoragePropertySection::NvmeAttributes, "media_errors", 0));
+
+	const auto controller_properties = storage_nvme_get_controller_properties(controller_repo);
+	REQUIRE(controller_properties.size() == 3);  // not the capacity
+
+	StoragePropertyRepository namespace_repo;
+	namespace_repo.add_property(make_property(StoragePropertySection::Info, "user_capacity/bytes", 500));
+	namespace_repo.add_property(make_property(StoragePropertySection::NvmeAttributes, "media_errors", 2));  // has its own
+
+	storage_nvme_merge_controller_properties(namespace_repo, controller_properties);
+	REQUIRE(namespace_repo.get_properties().size() == 4);
+	REQUIRE(namespace_repo.lookup_property("user_capacity/bytes").get_value<std::int64_t>() == 500);
+	REQUIRE(namespace_repo.lookup_property("temperature/current").get_value<std::int64_t>() == 40);
+	REQUIRE(namespace_repo.lookup_property("media_errors").get_value<std::int64_t>() == 2);
+	REQUIRE(namespace_repo.has_properties_for_section(StoragePropertySection::OverallHealth));
+}
+
+
+
+TEST_CASE("StorageNvmeControllerCache", "[app][nvme]")
+{
+	rconfig::set_default_data("system/nvme_controller_data_ttl_sec", 30);
+	storage_nvme_controller_cache_clear();
+
+	const std::string key = storage_nvme_controller_get_key("", "/dev/nvme0", StorageFetchProfile::Full);
+	REQUIRE(key != storage_nvme_controller_get_key("", "/dev/nvme0", StorageFetchProfile::Monitoring));
+	REQUIRE(key != storage_nvme_controller_get_key("root@nas", "/dev/nvme0", StorageFetchProfile::Full));
+
+	REQUIRE_FALSE(storage_nvme_controller_cache_get(key, "/dev/nvme0n2").has_value());
+
+	StorageNvmeControllerData data;
+	data.properties = std::make_shared<const std::vector<StorageProperty>>(std::vector<StorageProperty>{
+			make_property(StoragePropertySection::NvmeAttributes, "media_errors", 0)});
+	data.output_hash = 42;
+	storage_nvme_controller_cache_store(key, "/dev/nvme0n1", data);
+
+	// The other namespaces reuse it, the one which fetched it doesn't
+	const auto cached = storage_nvme_controller_cache_get(key, "/dev/nvme0n2");
+	REQUIRE(cached.has_value());
+	REQUIRE(cached->output_hash == 42);
+	REQUIRE(cached->properties->size() == 1);
+	REQUIRE_FALSE(storage_nvme_controller_cache_get(key, "/dev/nvme0n1").has_value());
+
+	// Expired
+	rconfig::set_data("system/nvme_controller_data_ttl_sec", 0);
+	REQUIRE_FALSE(storage_nvme_controller_cache_get(key, "/dev/nvme0n2").has_value());
+
+	rconfig::unset_data("system/nvme_controller_data_ttl_sec");
+	storage_nvme_controller_cache_clear();
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,103 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <string>
+
+#include "hz/fs.h"
+#include "applib/storage_output_compression.h"
+
+
+
+TEST_CASE("OutputCompressionDetect", "[app][compression]")
+{
+	REQUIRE(storage_output_detect_compression("{\"json_format_version\": [1, 0]}") == StorageOutputCompression::None);
+	REQUIRE(storage_output_detect_compression(std::string("\x1f\x8b\x08\x00", 4)) == StorageOutputCompression::Gzip);
+	REQUIRE(storage_output_detect_compression(std::string("\x28\xb5\x2f\xfd", 4)) == StorageOutputCompression::Zstd);
+	REQUIRE(storage_output_detect_compression("\x1f") == StorageOutputCompression::None);
+
+	REQUIRE(storage_output_get_file_compression(hz::fs_path_from_string("a.json.gz")) == StorageOutputCompression::Gzip);
+	REQUIRE(storage_output_get_file_compression(hz::fs_path_from_string("a.TGZ")) == StorageOutputCompression::Gzip);
+	REQUIRE(storage_output_get_file_compression(hz::fs_path_from_string("a.json.zst")) == StorageOutputCompression::Zstd);
+	REQUIRE(storage_output_get_file_compression(hz::fs_path_from_string("a.json")) == StorageOutputCompression::None);
+
+	REQUIRE(storage_output_strip_compression_extension(hz::fs_path_from_string("a.json.gz")) == hz::fs_path_from_string("a.json"));
+	REQUIRE(storage_output_strip_compression_extension(hz::fs_path_from_string("a.tgz")) == hz::fs_path_from_string("a.tar"));
+	REQUIRE(storage_output_strip_compression_extension(hz::fs_path_from_string("a.txt")) == hz::fs_path_from_string("a.txt"));
+}
+
+
+
+TEST_CASE("OutputCompressionRoundTrip", "[app][compression]")
+{
+	std::string data;
+	for (int i = 0; i < 20000; ++i) {
+		data += "ID# ATTRIBUTE_NAME FLAG VALUE WORST THRESH " + std::to_string(i) + "\n";
+	}
+
+	auto compressed = storage_output_compress(data, StorageOutputCompression::Gzip);
+	REQUIRE(compressed);
+	REQUIRE(compressed.value().size() < data.size());
+	REQUIRE(storage_output_detect_compression(compressed.value()) == StorageOutputCompression::Gzip);
+
+	auto decompressed = storage_output_decompress(compressed.value(), data.size());
+	REQUIRE(decompressed);
+	REQUIRE(decompressed.value() == data);
+
+	// The uncompressed data is returned as is
+	auto plain = storage_output_decompress(data, data.size());
+	REQUIRE(plain);
+	REQUIRE(plain.value() == data);
+
+	// The limit applies to the decompressed size
+	auto too_large = storage_output_decompress(compressed.value(), data.size() / 2);
+	REQUIRE(!too_large);
+	REQUIRE(too_large.error().data() == StorageOutputFileError::TooLarge);
+
+	auto corrupted = storage_output_decompress(compressed.value().substr(0, 20) + std::string(100, 'x'), data.size());
+	REQUIRE(!corrupted);
+
+	auto zstd = storage_output_decompress(std::string("\x28\xb5\x2f\xfd", 4) + "data", data.size());
+	REQUIRE(!zstd);
+	REQUIRE(zstd.error().data() == StorageOutputFileError::UnsupportedCompression);
+}
+
+
+
+TEST_CASE("OutputCompressionFile", "[app][compression]")
+{
+	const hz::fs::path file = hz::fs::temp_directory_path() / hz::fs_path_from_string("gsc_test_output_compression.json.gz");
+	const std::string data = "{\"device\": {\"name\": \"/dev/sda\"}}";
+
+	REQUIRE(storage_output_save(file, data));
+	std::string raw;
+	REQUIRE(!hz::fs_file_get_contents(file, raw, 1024*1024));
+	REQUIRE(storage_output_detect_compression(raw) == StorageOutputCompression::Gzip);
+
+	auto loaded = storage_output_load(file, 1024*1024);
+	REQUIRE(loaded);
+	REQUIRE(loaded.value() == data);
+
+	std::error_code ec;
+	hz::fs::remove(file, ec);
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,153 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "applib/storage_privileged_helper.h"
+
+
+
+namespace {
+
+	/// Helper with fixed drives, which records the commands and fails them
+	class FakePrivilegedHelper : public StoragePrivilegedHelper {
+		public:
+
+			hz::ExpectedValue<std::vector<CachedDrive>, StoragePrivilegedHelperError> get_drives() override
+			{
+				return drives;
+			}
+
+			hz::ExpectedVoid<StoragePrivilegedHelperError> execute_smartctl(const std::string& device,
+					const std::vector<std::string>& options, CommandOutputPtr& smartctl_output,
+					[[maybe_unused]] const AppCancellationPtr& cancellation) override
+			{
+				executed_device = device;
+				executed_options = options;
+				smartctl_output = std::make_shared<const std::string>();
+				return hz::Unexpected(StoragePrivilegedHelperError::ExecutionError, "Denied by the fake helper");
+			}
+
+			std::vector<CachedDrive> drives;
+			std::string executed_device;
+			std::vector<std::string> executed_options;
+	};
+
+
+	/// smartctl JSON output of an ATA drive
+	const std::string ata_json_output = R"({
+		"json_format_version": [1, 0],
+		"smartctl": {"version": [7, 3], "exit_status": 0},
+		"device": {"name": "/dev/sda", "type": "sat", "protocol": "ATA"},
+		"model_name": "ST1000",
+		"serial_number": "S1",
+		"smart_support": {"available": true, "enabled": true},
+		"smart_status": {"passed": true},
+		"temperature": {"current": 35},
+		"power_on_time": {"hours": 12345}
+	})";
+
+}
+
+
+
+TEST_CASE("StoragePrivilegedHelperCheckRequest", "[app][helper]")
+{
+	REQUIRE(storage_privileged_helper_check_request("/dev/sda", {"-d", "sat", "-x"}));
+	REQUIRE(storage_privileged_helper_check_request("/dev/disk/by-id/ata-ST1000_S1", {"--info"}));
+
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/etc/shadow", {"-x"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/../etc/shadow", {"-x"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"-B", "/etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"--drivedb=/etc/shadow"}));
+
+	// The options the clients send
+	REQUIRE(storage_privileged_helper_check_request("/dev/sda", {"-d", "megaraid,3", "--nocheck=standby",
+			"--health", "--info", "--get=all", "--capabilities", "--attributes", "--format=brief",
+			"--log=xerror,50,error", "--log=xselftest,50,selftest", "--log=devstat", "--json=o"}));
+	REQUIRE(storage_privileged_helper_check_request("/dev/sdb", {"-d", "areca,3/1", "--info", "--json=c"}));
+	REQUIRE(storage_privileged_helper_check_request("/dev/sda", {"--test=select,0-1000", "--test=select,5000-6000"}));
+	REQUIRE(storage_privileged_helper_check_request("/dev/sda", {"--abort"}));
+	REQUIRE(storage_privileged_helper_check_request("/dev/sda", {"--smart=on", "--saveauto=on"}));
+	REQUIRE(storage_privileged_helper_check_request("/dev/sda", {"-T", "permissive", "--offlineauto=off"}));
+
+	// getopt() would accept these
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"-iB/etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"-iB", "/etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"--dr=/etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"--drive", "/etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"--inf"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"-d", "-B/etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"--device=../../etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"-d"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"--smart=on", "/etc/shadow"}));
+	REQUIRE_FALSE(storage_privileged_helper_check_request("/dev/sda", {"--test=short,/etc/shadow"}));
+}
+
+
+
+TEST_CASE("StoragePrivilegedHelperLoadDrives", "[app][helper]")
+{
+	FakePrivilegedHelper helper;
+	helper.drives.push_back({"/dev/sda", "sat", "", ata_json_output, std::chrono::seconds(30)});
+	helper.drives.push_back({"/dev/sdb", "", "", "", std::nullopt});  // not fetched by the helper yet
+
+	auto drives = storage_privileged_helper_load_drives(helper);
+	REQUIRE(drives);
+	REQUIRE(drives->size() == 2);
+
+	const auto& loaded = drives->at(0);
+	REQUIRE(loaded->get_device() == "/dev/sda");
+	REQUIRE(loaded->get_type_argument() == "sat");
+	REQUIRE(loaded->get_parse_status() == StorageDevice::ParseStatus::Full);
+	REQUIRE(loaded->get_serial_number() == "S1");
+	REQUIRE(loaded->get_full_data_time().has_value());
+	REQUIRE(std::chrono::steady_clock::now() - loaded->get_full_data_time().value() >= std::chrono::seconds(30));
+
+	REQUIRE(drives->at(1)->get_parse_status() == StorageDevice::ParseStatus::None);
+}
+
+
+
+TEST_CASE("StoragePrivilegedHelperExecute", "[app][helper]")
+{
+	auto helper = std::make_shared<FakePrivilegedHelper>();
+	storage_privileged_helper_set_global(helper);
+
+	auto drive = std::make_shared<StorageDevice>("/dev/sda", "sat");
+	std::string output;
+	auto status = drive->execute_device_smartctl({"--info"}, nullptr, output);
+
+	storage_privileged_helper_set_global(nullptr);
+
+	// The command went to the helper, with the device options
+	REQUIRE_FALSE(status);
+	REQUIRE(status.error().message() == "Denied by the fake helper");
+	REQUIRE(helper->executed_device == "/dev/sda");
+	const auto& options = helper->executed_options;
+	REQUIRE(std::find(options.begin(), options.end(), "sat") != options.end());
+	REQUIRE(options.back() == "--info");
+}
+
+
+
+
+/// @}
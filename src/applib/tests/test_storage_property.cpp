@@ -0,0 +1,103 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_property.h"
+#include <sstream>
+
+
+
+TEST_CASE("StoragePropertyFormat", "[app][property]")
+{
+	AtaStorageAttribute attr;
+	attr.value = 100;
+	attr.raw_value = "abc";
+	REQUIRE(fmt::format("{}", attr) == "100 (abc)");
+	REQUIRE(fmt::format("[{:>10}]", attr) == "[ 100 (abc)]");
+
+	attr.value.reset();
+	REQUIRE(fmt::format("{}", attr) == "- (abc)");
+
+	NvmeStorageSelftestEntry entry;
+	entry.test_num = 2;
+	entry.power_on_hours = 10;
+	entry.lba = 5;
+	REQUIRE(fmt::format("{}", entry).find("power on hours: 10, lba: 5") != std::string::npos);
+
+	// The stream operators give the same result
+	std::ostringstream ss;
+	ss << entry;
+	REQUIRE(ss.str() == fmt::format("{}", entry));
+}
+
+
+
+TEST_CASE("StoragePropertyDump", "[app][property]")
+{
+	StorageProperty p;
+	p.generic_name = "power_cycle_count";
+	p.section = StoragePropertySection::Info;
+	p.reported_value = "12";
+	p.value = std::int64_t(12);
+
+	fmt::memory_buffer buf;
+	p.dump(buf, 2);
+	REQUIRE(std::string(buf.data(), buf.size()) == "  [info] power_cycle_count: [integer] 12 [12]");
+
+	std::ostringstream ss;
+	ss << p;
+	REQUIRE(ss.str() == "[info] power_cycle_count: [integer] 12 [12]");
+	REQUIRE(fmt::format("{}", p) == ss.str());
+
+	REQUIRE(StorageProperty().format_value() == "[unknown]");
+}
+
+
+
+
+
+TEST_CASE("StoragePropertyDescription", "[app][property]")
+{
+	StorageProperty p;
+	p.displayable_name = "Name <1>";
+	p.reported_name = "Reported_Name";
+	REQUIRE(p.get_description(true).empty());
+	REQUIRE(p.get_description() == "No description available");
+
+	p.set_static_description("Body");
+	REQUIRE(p.get_description() == "Body");
+
+	p.set_static_description("Body", StorageProperty::DescriptionTitle::Name);
+	REQUIRE(p.get_description_body() == "Body");
+	REQUIRE(p.get_description() == "<b>Name &lt;1&gt;</b>\nBody");
+
+	p.set_description(std::string("Body"), StorageProperty::DescriptionTitle::NameAndReportedName);
+	REQUIRE(p.get_description() == "<b>Name &lt;1&gt;</b>\n<small>Reported by smartctl as <b>\"Reported Name\"</b></small>\n\nBody");
+
+	// The warning is composed on demand too
+	p.set_description(std::string("Body"));
+	p.warning_level = WarningLevel::Warning;
+	p.warning_reason = "Reason";
+	const std::string descr = p.get_description();
+	REQUIRE(descr.rfind("Body\n\n", 0) == 0);
+	REQUIRE(descr.find("Reason") != std::string::npos);
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,111 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_device_json.h"
+#include "applib/storage_property_diff.h"
+#include <string>
+
+
+
+namespace {
+
+	StorageProperty make_property(StoragePropertySection section, const std::string& name, std::int64_t value,
+			WarningLevel warning_level = WarningLevel::None)
+	{
+		StorageProperty p(section, value);
+		p.set_name(name, name);
+		p.warning_level = warning_level;
+		return p;
+	}
+
+}
+
+
+
+TEST_CASE("StoragePropertyRepositoryDiff", "[app][property]")
+{
+	StoragePropertyRepository old_repo;
+	old_repo.add_property(make_property(StoragePropertySection::Info, "same", 1));
+	old_repo.add_property(make_property(StoragePropertySection::Info, "changed", 2));
+	old_repo.add_property(make_property(StoragePropertySection::Info, "removed", 3));
+	old_repo.add_property(make_property(StoragePropertySection::SelftestLog, "entry", 10));
+	old_repo.add_property(make_property(StoragePropertySection::SelftestLog, "entry", 11));
+
+	REQUIRE(storage_property_repository_diff(old_repo, old_repo).empty());
+
+	StoragePropertyRepository new_repo;
+	new_repo.add_property(make_property(StoragePropertySection::Info, "same", 1));
+	new_repo.add_property(make_property(StoragePropertySection::Info, "changed", 2, WarningLevel::Warning));
+	new_repo.add_property(make_property(StoragePropertySection::Capabilities, "same", 1));  // different section
+	new_repo.add_property(make_property(StoragePropertySection::SelftestLog, "entry", 10));
+	new_repo.add_property(make_property(StoragePropertySection::SelftestLog, "entry", 12));
+
+	const auto diff = storage_property_repository_diff(old_repo, new_repo);
+	REQUIRE(diff.changes.size() == 4);
+
+	REQUIRE(diff.changes[0].type == StoragePropertyChange::Type::Changed);
+	REQUIRE(diff.changes[0].new_property->generic_name == "changed");
+	REQUIRE(diff.changes[0].get_old_warning_level() == WarningLevel::None);
+	REQUIRE(diff.changes[0].get_new_warning_level() == WarningLevel::Warning);
+
+	REQUIRE(diff.changes[1].type == StoragePropertyChange::Type::Added);
+	REQUIRE(diff.changes[1].new_property->section == StoragePropertySection::Capabilities);
+	REQUIRE(!diff.changes[1].old_property.has_value());
+
+	// Same-named properties are matched in order
+	REQUIRE(diff.changes[2].type == StoragePropertyChange::Type::Changed);
+	REQUIRE(diff.changes[2].old_property->get_value<std::int64_t>() == 11);
+	REQUIRE(diff.changes[2].new_property->get_value<std::int64_t>() == 12);
+
+	REQUIRE(diff.changes[3].type == StoragePropertyChange::Type::Removed);
+	REQUIRE(diff.changes[3].old_property->generic_name == "removed");
+
+	REQUIRE(diff.has_warning_level_changes());
+	REQUIRE(storage_property_repository_diff(StoragePropertyRepository(), old_repo).changes.size() == 5);
+}
+
+
+
+TEST_CASE("StoragePropertyDiffJson", "[app][property]")
+{
+	StoragePropertyRepository old_repo;
+	old_repo.add_property(make_property(StoragePropertySection::Info, "changed", 2));
+	old_repo.add_property(make_property(StoragePropertySection::Info, "removed", 3));
+
+	StoragePropertyRepository new_repo;
+	new_repo.add_property(make_property(StoragePropertySection::Info, "changed", 4, WarningLevel::Alert));
+
+	const nlohmann::json j = storage_property_diff_to_json(storage_property_repository_diff(old_repo, new_repo));
+	REQUIRE(j.is_array());
+	REQUIRE(j.size() == 2);
+
+	REQUIRE(j[0]["change"] == "changed");
+	REQUIRE(j[0]["old"]["data"] == 2);
+	REQUIRE(j[0]["new"]["data"] == 4);
+	REQUIRE(j[0]["new"]["warning"] == "alert");
+
+	REQUIRE(j[1]["change"] == "removed");
+	REQUIRE(j[1]["old"]["name"] == "removed");
+	REQUIRE_FALSE(j[1].contains("new"));
+
+	REQUIRE(storage_property_diff_to_json(StoragePropertyDiff()).empty());
+}
+
+
+
+
+/// @}
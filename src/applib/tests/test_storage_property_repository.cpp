@@ -0,0 +1,203 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_property_repository.h"
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+	StorageProperty make_property(StoragePropertySection section, const std::string& name, std::int64_t value)
+	{
+		StorageProperty p(section, value);
+		p.set_name(name, name);
+		return p;
+	}
+
+
+	StorageProperty make_warning_property(StoragePropertySection section, const std::string& name,
+			WarningLevel level, const std::string& reason)
+	{
+		StorageProperty p = make_property(section, name, 0);
+		p.warning_level = level;
+		p.warning_reason = reason;
+		return p;
+	}
+
+}
+
+
+
+TEST_CASE("StoragePropertyRepositoryLookup", "[app][property]")
+{
+	StoragePropertyRepository repo;
+	repo.add_property(make_property(StoragePropertySection::Info, "a", 1));
+	repo.add_property(make_property(StoragePropertySection::Capabilities, "b", 2));
+	repo.add_property(make_property(StoragePropertySection::AtaAttributes, "b", 3));
+
+	REQUIRE(repo.find_property("missing") == nullptr);
+	REQUIRE(repo.lookup_property("missing").empty());
+
+	// Any section: the first property with this name wins
+	REQUIRE(repo.find_property("b") != nullptr);
+	REQUIRE(repo.find_property("b")->get_value<std::int64_t>() == 2);
+	REQUIRE(repo.find_property("b", StoragePropertySection::AtaAttributes)->get_value<std::int64_t>() == 3);
+	REQUIRE(repo.find_property("a", StoragePropertySection::Capabilities) == nullptr);
+	REQUIRE(repo.lookup_property("a").get_value<std::int64_t>() == 1);
+
+	// Modifications invalidate the index
+	repo.add_property(make_property(StoragePropertySection::Statistics, "c", 4));
+	REQUIRE(repo.find_property("c") != nullptr);
+
+	repo.get_properties_ref().front().generic_name = "renamed";
+	REQUIRE(repo.find_property("a") == nullptr);
+	REQUIRE(repo.find_property("renamed", StoragePropertySection::Info) != nullptr);
+
+	repo.set_properties({make_property(StoragePropertySection::Info, "d", 5)});
+	REQUIRE(repo.find_property("b") == nullptr);
+	REQUIRE(repo.find_property("d")->get_value<std::int64_t>() == 5);
+
+	repo.clear();
+	REQUIRE(repo.find_property("d") == nullptr);
+}
+
+
+
+TEST_CASE("StoragePropertyRepositorySections", "[app][property]")
+{
+	StoragePropertyRepository repo;
+	repo.add_property(make_property(StoragePropertySection::AtaAttributes, "a1", 1));
+	repo.add_property(make_property(StoragePropertySection::Info, "i1", 2));
+	repo.add_property(make_property(StoragePropertySection::AtaAttributes, "a2", 3));
+	repo.add_property(make_property(StoragePropertySection::Info, "i2", 4));
+
+	// Grouped by section, in the order of addition within a section
+	const auto& all = repo.get_properties();
+	REQUIRE(all.size() == 4);
+	REQUIRE(all[0].generic_name == "i1");
+	REQUIRE(all[1].generic_name == "i2");
+	REQUIRE(all[2].generic_name == "a1");
+	REQUIRE(all[3].generic_name == "a2");
+
+	const auto attrs = repo.get_properties_for_section(StoragePropertySection::AtaAttributes);
+	REQUIRE(attrs.size() == 2);
+	REQUIRE(attrs[0].generic_name == "a1");
+	REQUIRE(attrs[1].generic_name == "a2");
+	REQUIRE(repo.has_properties_for_section(StoragePropertySection::Info));
+	REQUIRE(!repo.has_properties_for_section(StoragePropertySection::Statistics));
+	REQUIRE(repo.get_properties_for_section(StoragePropertySection::Unknown).empty());
+
+	repo.set_properties({
+		make_property(StoragePropertySection::NvmeErrorLog, "n1", 5),
+		make_property(StoragePropertySection::Capabilities, "c1", 6),
+		make_property(StoragePropertySection::NvmeErrorLog, "n2", 7),
+	});
+	REQUIRE(repo.get_properties().front().generic_name == "c1");
+	REQUIRE(repo.get_properties_for_section(StoragePropertySection::NvmeErrorLog).size() == 2);
+	REQUIRE(repo.get_properties_for_section(StoragePropertySection::NvmeErrorLog)[1].generic_name == "n2");
+	REQUIRE(!repo.has_properties_for_section(StoragePropertySection::Info));
+
+	repo.clear();
+	REQUIRE(!repo.has_properties_for_section(StoragePropertySection::Capabilities));
+}
+
+
+
+TEST_CASE("StoragePropertyRepositoryWarningSummary", "[app][property]")
+{
+	StoragePropertyRepository repo;
+	repo.add_property(make_warning_property(StoragePropertySection::AtaAttributes, "a1", WarningLevel::Notice, "n1"));
+	repo.add_property(make_warning_property(StoragePropertySection::AtaAttributes, "a2", WarningLevel::Warning, "w1"));
+	repo.add_property(make_warning_property(StoragePropertySection::AtaAttributes, "a3", WarningLevel::None, ""));
+	repo.add_property(make_warning_property(StoragePropertySection::AtaAttributes, "a4", WarningLevel::Warning, "w2"));
+	repo.add_property(make_warning_property(StoragePropertySection::Info, "i1", WarningLevel::Warning, "w0"));
+	repo.update_warning_summaries();
+
+	const auto& attrs = repo.get_warning_summary(StoragePropertySection::AtaAttributes);
+	REQUIRE(attrs.max_level == WarningLevel::Warning);
+	REQUIRE(attrs.get_warning_count() == 3);
+	REQUIRE(attrs.get_count(WarningLevel::Notice) == 1);
+	REQUIRE(attrs.get_count(WarningLevel::None) == 1);
+	REQUIRE(attrs.top_reasons == std::vector<std::string>{"w1", "w2"});
+
+	REQUIRE(repo.get_warning_summary(StoragePropertySection::Statistics).max_level == WarningLevel::None);
+	REQUIRE(repo.get_warning_summary(StoragePropertySection::Statistics).get_warning_count() == 0);
+
+	// All sections, in section order
+	REQUIRE(repo.get_warning_summary().get_warning_count() == 4);
+	REQUIRE(repo.get_warning_summary().top_reasons == std::vector<std::string>{"w0", "w1", "w2"});
+
+	// Modifications invalidate the summaries. Hidden properties are not counted.
+	repo.add_property(make_warning_property(StoragePropertySection::Statistics, "s1", WarningLevel::Alert, "a"));
+	auto hidden = make_warning_property(StoragePropertySection::Statistics, "s2", WarningLevel::Alert, "hidden");
+	hidden.show_in_ui = false;
+	repo.add_property(hidden);
+	REQUIRE(repo.get_warning_summary().max_level == WarningLevel::Alert);
+	REQUIRE(repo.get_warning_summary().top_reasons == std::vector<std::string>{"a"});
+	REQUIRE(repo.get_warning_summary(StoragePropertySection::Statistics).get_warning_count() == 1);
+
+	repo.get_properties_ref().front().warning_level = WarningLevel::None;
+	REQUIRE(repo.get_warning_summary(StoragePropertySection::Info).max_level == WarningLevel::None);
+
+	repo.clear();
+	REQUIRE(repo.get_warning_summary().max_level == WarningLevel::None);
+}
+
+
+
+TEST_CASE("StoragePropertyRepositorySharing", "[app][property]")
+{
+	StoragePropertyRepository repo;
+	repo.add_property(make_property(StoragePropertySection::Info, "a", 1));
+	repo.add_property(make_property(StoragePropertySection::AtaAttributes, "b", 2));
+
+	// Copies share the data until modified
+	StoragePropertyRepository copy = repo;
+	REQUIRE(copy.shares_data_with(repo));
+	REQUIRE(&copy.get_properties() == &repo.get_properties());
+	REQUIRE(copy.find_property("b") == repo.find_property("b"));
+
+	copy.add_property(make_property(StoragePropertySection::Statistics, "c", 3));
+	REQUIRE(!copy.shares_data_with(repo));
+	REQUIRE(repo.find_property("c") == nullptr);
+	REQUIRE(repo.get_properties().size() == 2);
+	REQUIRE(copy.find_property("c") != nullptr);
+
+	StoragePropertyRepository modified = repo;
+	modified.get_properties_ref().front().value = std::int64_t(10);
+	REQUIRE(repo.find_property("a")->get_value<std::int64_t>() == 1);
+	REQUIRE(modified.find_property("a")->get_value<std::int64_t>() == 10);
+
+	// Moving leaves the source empty
+	StoragePropertyRepository moved = std::move(copy);
+	REQUIRE(moved.get_properties().size() == 3);
+	REQUIRE(copy.get_properties().empty());
+	REQUIRE(copy.find_property("a") == nullptr);
+
+	// Clearing doesn't affect the copies
+	StoragePropertyRepository cleared = repo;
+	cleared.clear();
+	REQUIRE(cleared.get_properties().empty());
+	REQUIRE(repo.get_properties().size() == 2);
+	REQUIRE(StoragePropertyRepository().shares_data_with(cleared));
+}
+
+
+
+/// @}
@@ -0,0 +1,213 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_property_snapshot.h"
+#include <string>
+
+
+
+namespace {
+
+	/// Create a repository with a property of each value type
+	StoragePropertyRepository make_test_repository()
+	{
+		StoragePropertyRepository repo;
+
+		auto add = [&repo](StoragePropertySection section, const std::string& name, StorageProperty::ValueVariantType value) {
+			StorageProperty p(section, std::move(value));
+			p.set_name(name, "Readable " + name, "reported " + name);
+			p.reported_value = "rv";
+			repo.add_property(std::move(p));
+		};
+
+		add(StoragePropertySection::Info, "none", std::monostate());
+		add(StoragePropertySection::Info, "model_name", std::string("Model \xc3\xa9"));
+		add(StoragePropertySection::Info, "negative", std::int64_t(-1234567890123));
+		add(StoragePropertySection::OverallHealth, "passed", true);
+		add(StoragePropertySection::Capabilities, "duration", std::chrono::seconds(7200));
+
+		AtaStorageTextCapability cap;
+		cap.reported_flag_value = "0x7b";
+		cap.flag_value = 0x7b;
+		cap.strvalues = {"one", "two"};
+		add(StoragePropertySection::Capabilities, "cap", cap);
+
+		AtaStorageAttribute attr;
+		attr.id = 194;
+		attr.value = 100;
+		attr.threshold = 0;
+		attr.attr_type = AtaStorageAttribute::AttributeType::OldAge;
+		attr.when_failed = AtaStorageAttribute::FailTime::None;
+		attr.raw_value = "35 (Min/Max 20/45)";
+		attr.raw_value_int = 0x2d00140023;
+		add(StoragePropertySection::AtaAttributes, "attr", attr);
+
+		AtaStorageStatistic stat;
+		stat.flags = "---";
+		stat.value_int = 35;
+		stat.page = 5;
+		stat.offset = 8;
+		add(StoragePropertySection::Statistics, "stat", stat);
+
+		AtaStorageErrorBlock error_block;
+		error_block.error_num = 3;
+		error_block.reported_types = {"UNC", "IDNF"};
+		error_block.lba = 0x253eac0;
+		add(StoragePropertySection::AtaErrorLog, "error", error_block);
+
+		AtaStorageSelftestEntry ata_test;
+		ata_test.test_num = 1;
+		ata_test.status = AtaStorageSelftestEntry::Status::Unknown;
+		ata_test.remaining_percent = -1;
+		ata_test.passed = true;
+		add(StoragePropertySection::SelftestLog, "ata_test", ata_test);
+
+		NvmeStorageSelftestEntry nvme_test;
+		nvme_test.test_num = 2;
+		nvme_test.type = NvmeSelfTestType::Extended;
+		nvme_test.lba = 12345;
+		add(StoragePropertySection::SelftestLog, "nvme_test", nvme_test);
+
+		auto& props = repo.get_properties_ref();
+		props[2].warning_level = WarningLevel::Alert;
+		props[2].warning_reason = "Reason";
+		props[2].show_in_ui = false;
+		props[2].set_description("Description", StorageProperty::DescriptionTitle::Name);
+
+		return repo;
+	}
+
+}
+
+
+
+TEST_CASE("StoragePropertySnapshotRoundTrip", "[app][property]")
+{
+	const auto repo = make_test_repository();
+	const std::string snapshot = storage_property_snapshot_save(repo);
+
+	const auto loaded = storage_property_snapshot_load(snapshot);
+	REQUIRE(loaded.has_value());
+
+	const auto& orig_props = repo.get_properties();
+	const auto& props = loaded.value().get_properties();
+	REQUIRE(props.size() == orig_props.size());
+	for (std::size_t i = 0; i < props.size(); ++i) {
+		REQUIRE(props[i].generic_name == orig_props[i].generic_name);
+		REQUIRE(props[i].displayable_name == orig_props[i].displayable_name);
+		REQUIRE(props[i].reported_name == orig_props[i].reported_name);
+		REQUIRE(props[i].section == orig_props[i].section);
+		REQUIRE(props[i].reported_value == orig_props[i].reported_value);
+		REQUIRE(props[i].value.index() == orig_props[i].value.index());
+		REQUIRE(props[i].format_value() == orig_props[i].format_value());
+	}
+
+	REQUIRE(props[2].get_value<std::int64_t>() == -1234567890123);
+	REQUIRE(props[2].warning_level == WarningLevel::Alert);
+	REQUIRE(props[2].warning_reason == "Reason");
+	REQUIRE(!props[2].show_in_ui);
+	REQUIRE(props[2].get_description_body() == "Description");
+	REQUIRE(props[2].get_description_title() == StorageProperty::DescriptionTitle::Name);
+	REQUIRE(props[2].get_description() == orig_props[2].get_description());
+	REQUIRE(props[0].get_description(true).empty());
+
+	const auto& attr = props[6].get_value<AtaStorageAttribute>();
+	REQUIRE(attr.value == 100);
+	REQUIRE(!attr.worst.has_value());
+	REQUIRE(attr.threshold == 0);
+	REQUIRE(attr.raw_value_int == 0x2d00140023);
+	REQUIRE(props[8].get_value<AtaStorageErrorBlock>().reported_types == std::vector<std::string>{"UNC", "IDNF"});
+	REQUIRE(props[9].get_value<AtaStorageSelftestEntry>().status == AtaStorageSelftestEntry::Status::Unknown);
+	REQUIRE(props[10].get_value<NvmeStorageSelftestEntry>().lba == 12345);
+
+	// Lookups work on the loaded repository
+	REQUIRE(loaded.value().find_property("model_name") != nullptr);
+}
+
+
+
+TEST_CASE("StoragePropertySnapshotInvalid", "[app][property]")
+{
+	const std::string snapshot = storage_property_snapshot_save(make_test_repository());
+
+	REQUIRE(!storage_property_snapshot_load(""));
+	REQUIRE(!storage_property_snapshot_load("not a snapshot"));
+
+	// Any truncation is detected
+	for (std::size_t size = 0; size < snapshot.size(); ++size) {
+		REQUIRE(!storage_property_snapshot_load(std::string_view(snapshot).substr(0, size)));
+	}
+	REQUIRE(!storage_property_snapshot_load(snapshot + "x"));
+
+	// Different format version
+	std::string other_version = snapshot;
+	other_version[7] = static_cast<char>(storage_property_snapshot_version + 1);
+	const auto status = storage_property_snapshot_load(other_version);
+	REQUIRE(!status);
+	REQUIRE(status.error().data() == StoragePropertySnapshotError::UnsupportedVersion);
+
+	// An empty repository
+	REQUIRE(storage_property_snapshot_load(storage_property_snapshot_save(StoragePropertyRepository())).has_value());
+}
+
+
+
+
+TEST_CASE("StoragePropertyDelta", "[app][property]")
+{
+	const auto base = make_test_repository();
+	const std::string snapshot = storage_property_snapshot_save(base);
+
+	// Unchanged repository
+	const std::string same_delta = storage_property_delta_save(base, base);
+	REQUIRE(same_delta.size() < 20);
+	const auto same = storage_property_delta_apply(base, same_delta);
+	REQUIRE(same.has_value());
+	REQUIRE(storage_property_snapshot_save(same.value()) == snapshot);
+
+	// Changed, removed and added properties
+	auto changed_repo = base;
+	auto props = base.get_properties();
+	props[2].value = std::int64_t(5);
+	props[4].warning_level = WarningLevel::Warning;
+	props.erase(props.begin() + 7);
+	StorageProperty added(StoragePropertySection::Info, std::string("new"));
+	added.set_name("added", "Added");
+	props.push_back(added);
+	changed_repo.set_properties(props);
+
+	const std::string delta = storage_property_delta_save(base, changed_repo);
+	REQUIRE(delta.size() < snapshot.size());
+	const auto applied = storage_property_delta_apply(base, delta);
+	REQUIRE(applied.has_value());
+	REQUIRE(storage_property_snapshot_save(applied.value()) == storage_property_snapshot_save(changed_repo));
+
+	// Wrong base
+	const auto mismatch = storage_property_delta_apply(StoragePropertyRepository(), delta);
+	REQUIRE(!mismatch);
+	REQUIRE(mismatch.error().data() == StoragePropertySnapshotError::BaseMismatch);
+
+	// Any truncation is detected
+	for (std::size_t size = 0; size < delta.size(); ++size) {
+		REQUIRE(!storage_property_delta_apply(base, std::string_view(delta).substr(0, size)));
+	}
+}
+
+
+
+
+/// @}
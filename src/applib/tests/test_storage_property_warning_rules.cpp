@@ -0,0 +1,102 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_property_warning_rules.h"
+#include <string>
+
+
+
+namespace {
+
+	StorageProperty make_attribute(const std::string& generic_name, std::int64_t raw_value)
+	{
+		AtaStorageAttribute attr;
+		attr.raw_value_int = raw_value;
+		attr.raw_value = std::to_string(raw_value);
+		StorageProperty p(StoragePropertySection::AtaAttributes, attr);
+		p.set_name(generic_name, generic_name);
+		return p;
+	}
+
+}
+
+
+
+TEST_CASE("StorageWarningRulesBuiltin", "[app][warning]")
+{
+	const auto& rules = StorageWarningRules::get_builtin();
+
+	auto realloc = make_attribute("attr_reallocated_sector_count", 0);
+	REQUIRE(!rules.apply(realloc));
+	realloc = make_attribute("attr_reallocated_sector_count", 5);
+	REQUIRE(rules.apply(realloc));
+	REQUIRE(realloc.warning_level == WarningLevel::Notice);
+
+	// The names are case-insensitive, the sections must match
+	realloc = make_attribute("Attr_Reallocated_Sector_Count", 5);
+	REQUIRE(rules.apply(realloc));
+	realloc.section = StoragePropertySection::Statistics;
+	REQUIRE(!rules.apply(realloc));
+
+	// Encoded min / max temperatures are not numeric strings
+	auto temp = make_attribute("attr_temperature_celsius", 55);
+	REQUIRE(rules.apply(temp));
+	temp = make_attribute("attr_temperature_celsius", 253403791387);
+	REQUIRE(!rules.apply(temp));
+
+	// The highest triggered level wins
+	AtaStorageStatistic statistic;
+	statistic.value_int = 120;
+	StorageProperty usage(StoragePropertySection::Statistics, statistic);
+	usage.set_name("Utilization Usage Rate", "Utilization Usage Rate");
+	REQUIRE(rules.apply(usage));
+	REQUIRE(usage.warning_level == WarningLevel::Warning);
+
+	StorageProperty health(StoragePropertySection::OverallHealth, false);
+	health.set_name("smart_status/passed", "smart_status/passed");
+	REQUIRE(rules.apply(health));
+	REQUIRE(health.warning_level == WarningLevel::Alert);
+}
+
+
+
+TEST_CASE("StorageWarningRulesJson", "[app][warning]")
+{
+	StorageWarningRules rules = StorageWarningRules::get_builtin();
+	REQUIRE(rules.add_rules_from_json(R"([{"section": "attributes", "name": "attr_reallocated_sector_count",
+			"value": "raw", "min": 100, "level": "warning", "reason": "Site limit"}])").has_value());
+	REQUIRE(rules.size() == StorageWarningRules::get_builtin().size() + 1);
+
+	auto realloc = make_attribute("attr_reallocated_sector_count", 5);
+	REQUIRE(rules.apply(realloc));
+	REQUIRE(realloc.warning_level == WarningLevel::Notice);
+
+	realloc = make_attribute("attr_reallocated_sector_count", 150);
+	REQUIRE(rules.apply(realloc));
+	REQUIRE(realloc.warning_level == WarningLevel::Warning);
+	REQUIRE(realloc.warning_reason == "Site limit");
+
+	REQUIRE(rules.add_rules_from_json("{").error().data() == StorageWarningRulesError::SyntaxError);
+	REQUIRE(rules.add_rules_from_json(R"([{"section": "nosuch", "name": "x"}])").error().data() == StorageWarningRulesError::InvalidRule);
+	REQUIRE(rules.add_rules_from_json(R"([{"section": "info", "name": "x", "level": "panic"}])").error().data() == StorageWarningRulesError::InvalidRule);
+	REQUIRE(rules.add_rules_from_json(R"([{"section": "info"}])").error().data() == StorageWarningRulesError::InvalidRule);
+	REQUIRE(rules.size() == StorageWarningRules::get_builtin().size() + 1);
+}
+
+
+
+/// @}
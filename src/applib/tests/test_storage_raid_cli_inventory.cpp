@@ -0,0 +1,112 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "applib/storage_raid_cli_inventory.h"
+
+
+
+TEST_CASE("TwCliParse", "[app][detector]")
+{
+	const std::string show =
+			"Ctl   Model        (V)Ports  Drives   Units   NotOpt  RRate   VRate  BBU\n"
+			"------------------------------------------------------------------------\n"
+			"c4    9650SE-8LPML 8         4        1       0       1       1      -\n"
+			"c2    9650SE-4LPML 4         2        1       0       1       1      -\n";
+	REQUIRE(tw_cli_parse_controllers(show) == std::vector<int>{2, 4});
+
+	const std::string show_all =
+			"Port   Status           Unit   Size        Blocks        Serial\n"
+			"---------------------------------------------------------------\n"
+			"p0     OK               u0     465.76 GB   976773168     WD-WCAS8\n"
+			"p1     NOT-PRESENT      -      -           -             -\n"
+			"p3\tOK\tu0\t465.76 GB\t976773168\tWD-WCAS9\n";
+	REQUIRE(tw_cli_parse_ports(show_all) == std::vector<int>{0, 3});
+}
+
+
+
+TEST_CASE("ArecaCliParse", "[app][detector]")
+{
+	const std::string noenc =
+			"  # Ch# ModelName                       Capacity  Usage\n"
+			"===============================================================================\n"
+			"  1  1  INTEL SSDSA2M160G2GC             160.0GB  System\n"
+			"  2  2  N.A.                               0.0GB  N.A.\n"
+			"  3  3  Hitachi HDS724040ALE640         4000.8GB  Storage\n"
+			"===============================================================================\n"
+			"GuiErrMsg<0x00>: Success.\n";
+	auto inventory = areca_cli_parse_disk_info(noenc);
+	REQUIRE(inventory.has_value());
+	REQUIRE_FALSE(inventory->has_enclosure);
+	REQUIRE(inventory->disks == std::vector<ArecaCliDisk>{{1, 0}, {3, 0}});
+
+	const std::string enc =
+			"  # Enc# Slot#   ModelName                        Capacity  Usage\n"
+			"===============================================================================\n"
+			"  1  01  Slot#1  N.A.                                0.0GB  N.A.\n"
+			"  2  01  Slot#2  ST910021AS                        100.0GB  Free\n"
+			" 23  02  SLOT 15 WDC WD3200BEVT-75A23T0            320.1GB  HotSpare[Global]\n"
+			"===============================================================================\n"
+			"GuiErrMsg<0x00>: Success.\n";
+	inventory = areca_cli_parse_disk_info(enc);
+	REQUIRE(inventory.has_value());
+	REQUIRE(inventory->has_enclosure);
+	REQUIRE(inventory->disks == std::vector<ArecaCliDisk>{{2, 1}, {15, 2}});
+
+	REQUIRE_FALSE(areca_cli_parse_disk_info("Error: no controller").has_value());
+}
+
+
+
+TEST_CASE("RaidCliInventoryCache", "[app][detector]")
+{
+	rconfig::set_default_data("system/raid_cli_inventory_ttl_sec", 30);
+	raid_cli_inventory_clear();
+
+	REQUIRE(raid_cli_inventory_get("").tw_cli_ports.empty());
+
+	raid_cli_inventory_update("", [](RaidCliInventory& inventory) {
+		inventory.tw_cli_controllers = std::vector<int>{0};
+	});
+	raid_cli_inventory_update("", [](RaidCliInventory& inventory) {
+		inventory.tw_cli_ports[0] = {1, 2};
+	});
+	raid_cli_inventory_update("root@nas", [](RaidCliInventory& inventory) {
+		inventory.tw_cli_ports[0] = {5};
+	});
+
+	const auto local = raid_cli_inventory_get("");
+	REQUIRE(local.tw_cli_controllers == std::vector<int>{0});
+	REQUIRE(local.tw_cli_ports.at(0) == std::vector<int>{1, 2});
+	REQUIRE_FALSE(local.areca.has_value());
+	REQUIRE(raid_cli_inventory_get("root@nas").tw_cli_ports.at(0) == std::vector<int>{5});
+
+	// Expired
+	rconfig::set_data("system/raid_cli_inventory_ttl_sec", 0);
+	REQUIRE_FALSE(raid_cli_inventory_get("").tw_cli_controllers.has_value());
+
+	rconfig::unset_data("system/raid_cli_inventory_ttl_sec");
+	raid_cli_inventory_clear();
+	REQUIRE(raid_cli_inventory_get("root@nas").tw_cli_ports.empty());
+}
+
+
+
+
+
+/// @}
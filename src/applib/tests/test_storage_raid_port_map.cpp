@@ -0,0 +1,75 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "applib/storage_raid_port_map.h"
+
+using namespace std::chrono_literals;
+
+
+
+TEST_CASE("StorageRaidPortMap", "[app][detector]")
+{
+	rconfig::set_default_data("system/raid_port_map", rconfig::json::object());
+
+	const std::string key = storage_raid_port_map_get_key("", "/dev/sg1", "areca,%d/1");
+	REQUIRE(key == "/dev/sg1 areca,%d/1");
+	REQUIRE(storage_raid_port_map_get_key("admin@nas", "/dev/twa0", "3ware,%d") == "admin@nas:/dev/twa0 3ware,%d");
+
+	REQUIRE_FALSE(storage_raid_port_map_lookup(key).has_value());
+
+	StorageRaidPortMapEntry entry;
+	entry.ports = {1, 4, 7};
+	entry.full_sweep_time = 1700000000;
+	storage_raid_port_map_store(key, entry);
+	REQUIRE(storage_raid_port_map_lookup(key) == entry);
+
+	// An empty controller is remembered too
+	const std::string empty_key = storage_raid_port_map_get_key("", "/dev/sg1", "areca,%d/2");
+	storage_raid_port_map_store(empty_key, StorageRaidPortMapEntry{{}, 1700000000});
+	REQUIRE(storage_raid_port_map_lookup(empty_key).has_value());
+	REQUIRE(storage_raid_port_map_lookup(empty_key)->ports.empty());
+	REQUIRE(storage_raid_port_map_lookup(key) == entry);
+
+	rconfig::set_data("system/raid_port_map", rconfig::json {{key, {{"ports", "broken"}}}});
+	REQUIRE_FALSE(storage_raid_port_map_lookup(key).has_value());
+
+	rconfig::unset_data("system/raid_port_map");
+}
+
+
+
+TEST_CASE("StorageRaidPortMapSweepDue", "[app][detector]")
+{
+	const auto last_sweep = std::chrono::system_clock::time_point(1700000000s);
+	StorageRaidPortMapEntry entry;
+	entry.full_sweep_time = 1700000000;
+
+	REQUIRE_FALSE(storage_raid_port_map_get_sweep_due(entry, last_sweep + 1h, 24h));
+	REQUIRE(storage_raid_port_map_get_sweep_due(entry, last_sweep + 24h, 24h));
+	REQUIRE(storage_raid_port_map_get_sweep_due(entry, last_sweep - 1h, 24h));  // clock went back
+	REQUIRE(storage_raid_port_map_get_sweep_due(entry, last_sweep + 1h, 0s));  // disabled
+
+	entry.full_sweep_time = 0;
+	REQUIRE(storage_raid_port_map_get_sweep_due(entry, last_sweep, 24h));
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,83 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_refresh_policy.h"
+#include <string>
+
+
+
+namespace {
+
+	StoragePropertyRepository make_properties(std::int64_t temperature, std::int64_t pending_sectors)
+	{
+		StoragePropertyRepository repo;
+
+		StorageProperty temp(StoragePropertySection::Info, temperature);
+		temp.set_name("temperature/current", "temperature/current");
+		repo.add_property(temp);
+
+		AtaStorageAttribute attr;
+		attr.id = 197;
+		attr.raw_value_int = pending_sectors;
+		StorageProperty pending(StoragePropertySection::AtaAttributes, attr);
+		pending.set_name("Current_Pending_Sector", "attribute_197");
+		repo.add_property(pending);
+
+		return repo;
+	}
+
+}
+
+
+
+TEST_CASE("StorageRefreshPolicyActivityValues", "[app][refresh]")
+{
+	const auto values = StorageRefreshPolicy::get_activity_values(make_properties(35, 2));
+	REQUIRE(values == StorageActivityValues{{"temperature", 35}, {"ata_attr/197", 2}});
+
+	REQUIRE(!StorageRefreshPolicy::get_activity_changed(values, {{"temperature", 36}, {"ata_attr/197", 2}}));
+	REQUIRE(StorageRefreshPolicy::get_activity_changed(values, {{"temperature", 37}, {"ata_attr/197", 2}}));
+	REQUIRE(StorageRefreshPolicy::get_activity_changed(values, {{"temperature", 35}, {"ata_attr/197", 3}}));
+	REQUIRE(StorageRefreshPolicy::get_activity_changed(values, {{"temperature", 35}}));
+}
+
+
+
+TEST_CASE("StorageRefreshPolicyInterval", "[app][refresh]")
+{
+	using namespace std::chrono_literals;
+	StorageRefreshPolicy policy(60s, 300s);
+	REQUIRE(policy.get_interval() == 60s);
+
+	REQUIRE(policy.update(make_properties(35, 0)) == 60s);  // first values
+	REQUIRE(policy.update(make_properties(35, 0)) == 120s);  // stable
+	REQUIRE(policy.update(make_properties(36, 0)) == 240s);
+	REQUIRE(policy.update(make_properties(36, 0)) == 300s);  // capped
+
+	// A slow drift is compared to the values at the last change
+	REQUIRE(policy.update(make_properties(37, 0)) == 60s);
+
+	REQUIRE(policy.update(make_properties(37, 0)) == 120s);
+	REQUIRE(policy.update(make_properties(37, 1)) == 60s);  // pending sectors changed
+}
+
+
+
+
+
+
+/// @}
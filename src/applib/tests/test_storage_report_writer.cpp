@@ -0,0 +1,93 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_report_writer.h"
+#include "nlohmann/json.hpp"
+#include <sstream>
+
+
+
+TEST_CASE("StorageReportWriterJson", "[app][report]")
+{
+	std::ostringstream out;
+	StorageReportWriter writer(out, StorageReportFormat::Json);
+	writer.begin("host1", 1000);
+	writer.add_drive(StorageDevice("/dev/sda", std::string()));
+	writer.add_drive(StorageDevice("/dev/sdb", std::string("sat")), "Fetch failed");
+	writer.end(5);
+	REQUIRE(writer.get_drive_count() == 2);
+	REQUIRE(writer.get_ok());
+
+	const auto doc = nlohmann::json::parse(out.str());
+	REQUIRE(doc["host"] == "host1");
+	REQUIRE(doc["time"] == 1000);
+	REQUIRE(doc["duration_ms"] == 5);
+	REQUIRE(doc["drives"].size() == 2);
+	REQUIRE(doc["drives"][0]["device"] == "/dev/sda");
+	REQUIRE(!doc["drives"][0].contains("error"));
+	REQUIRE(doc["drives"][1]["type_argument"] == "sat");
+	REQUIRE(doc["drives"][1]["error"] == "Fetch failed");
+}
+
+
+
+TEST_CASE("StorageReportWriterEmptyJson", "[app][report]")
+{
+	std::ostringstream out;
+	StorageReportWriter writer(out, StorageReportFormat::Json);
+	writer.begin("host1", 1000);
+	writer.end(0);
+	REQUIRE(nlohmann::json::parse(out.str())["drives"].empty());
+}
+
+
+
+TEST_CASE("StorageReportWriterHtml", "[app][report]")
+{
+	std::ostringstream out;
+	StorageReportWriter writer(out, StorageReportFormat::Html);
+	writer.begin("<host>", 1000);
+	writer.add_drive(StorageDevice("/dev/sda", std::string()), "a & b");
+	writer.end(5);
+
+	const std::string html = out.str();
+	REQUIRE(html.find("&lt;host&gt;") != std::string::npos);
+	REQUIRE(html.find("<host>") == std::string::npos);
+	REQUIRE(html.find("<h2>/dev/sda") != std::string::npos);
+	REQUIRE(html.find("Error: a &amp; b") != std::string::npos);
+	REQUIRE(html.find("</html>") != std::string::npos);
+
+	REQUIRE(StorageReportWriter::html_escape("\"'") == "&quot;&#39;");
+}
+
+
+
+TEST_CASE("StorageReportWriterFormat", "[app][report]")
+{
+	StorageReportFormat format = StorageReportFormat::Json;
+	REQUIRE(StorageReportWriter::get_format_for_file("/tmp/Report.HTML", format));
+	REQUIRE(format == StorageReportFormat::Html);
+	REQUIRE(StorageReportWriter::get_format_for_file("report.json", format));
+	REQUIRE(format == StorageReportFormat::Json);
+	REQUIRE(!StorageReportWriter::get_format_for_file("report.txt", format));
+}
+
+
+
+
+
+/// @}
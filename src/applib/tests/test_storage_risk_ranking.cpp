@@ -0,0 +1,127 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <array>
+
+#include "applib/storage_risk_ranking.h"
+
+
+
+namespace {
+
+	StorageProperty make_ata_attribute(const std::string& generic_name, std::int64_t raw)
+	{
+		AtaStorageAttribute attr;
+		attr.raw_value_int = raw;
+		StorageProperty p(StoragePropertySection::AtaAttributes, attr);
+		p.generic_name = generic_name;
+		return p;
+	}
+
+
+	StorageProperty make_nvme_counter(const std::string& generic_name, std::int64_t value)
+	{
+		StorageProperty p(StoragePropertySection::NvmeAttributes, value);
+		p.generic_name = generic_name;
+		return p;
+	}
+
+}
+
+
+
+TEST_CASE("StorageRiskScore", "[app][risk_ranking]")
+{
+	StoragePropertyRepository properties;
+	properties.add_property(make_ata_attribute("attr_reallocated_sector_count", 8));
+	properties.add_property(make_ata_attribute("attr_current_pending_sector_count", 2));
+	properties.add_property(make_ata_attribute("attr_power_on_hours", 10000));  // not a risk
+	REQUIRE(storage_risk_score(properties) == 8 + 2 * 10);
+
+	AtaStorageSelftestEntry selftest;
+	selftest.status = AtaStorageSelftestEntry::Status::ComplReadFailure;
+	StorageProperty selftest_property(StoragePropertySection::Capabilities, selftest);
+	selftest_property.generic_name = "ata_smart_data/self_test/status/_merged";
+	properties.add_property(selftest_property);
+	REQUIRE(storage_risk_score(properties) == 8 + 2 * 10 + 1000);
+
+	// Only the latest NVMe self-test counts
+	NvmeStorageSelftestEntry nvme_selftest;
+	nvme_selftest.test_num = 2;
+	nvme_selftest.result = NvmeSelfTestResultType::CompletedFailedSegments;
+	REQUIRE(storage_risk_property_score(StorageProperty(StoragePropertySection::SelftestLog, nvme_selftest)) == 0);
+	nvme_selftest.test_num = 1;
+	REQUIRE(storage_risk_property_score(StorageProperty(StoragePropertySection::SelftestLog, nvme_selftest)) == 1000);
+
+	REQUIRE(storage_risk_property_score(make_nvme_counter("nvme_smart_health_information_log/media_errors", 3)) == 30);
+	REQUIRE(storage_risk_property_score(make_nvme_counter("nvme_smart_health_information_log/percentage_used", 42)) == 42);
+	REQUIRE(storage_risk_property_score(make_nvme_counter("nvme_smart_health_information_log/temperature", 42)) == 0);
+}
+
+
+
+TEST_CASE("StorageRiskRanking", "[app][risk_ranking]")
+{
+	// Only used as keys
+	std::array<int, 3> keys = {};
+	const auto* drive_a = reinterpret_cast<const StorageDevice*>(&keys[0]);
+	const auto* drive_b = reinterpret_cast<const StorageDevice*>(&keys[1]);
+	const auto* drive_c = reinterpret_cast<const StorageDevice*>(&keys[2]);
+
+	StorageRiskRanking ranking;
+	REQUIRE(ranking.set_score(drive_a, 10));
+	REQUIRE(!ranking.set_score(drive_a, 10));  // unchanged
+	REQUIRE(ranking.set_score(drive_b, 500));
+	REQUIRE(ranking.set_score(drive_c, 0));
+	REQUIRE(ranking.size() == 3);
+
+	REQUIRE(ranking.get_top(10) == std::vector<StorageRiskEntry>{{drive_b, 500}, {drive_a, 10}});  // no score, no risk
+	REQUIRE(ranking.get_top(1) == std::vector<StorageRiskEntry>{{drive_b, 500}});
+	REQUIRE(ranking.get_top(10, 0).size() == 3);
+	REQUIRE(ranking.get_top(10, 1, [drive_b](const StorageDevice* drive) { return drive != drive_b; })
+			== std::vector<StorageRiskEntry>{{drive_a, 10}});
+
+	// Only the changed properties are looked at
+	StoragePropertyRepository old_properties, new_properties;
+	old_properties.add_property(make_ata_attribute("attr_reallocated_sector_count", 8));
+	old_properties.add_property(make_ata_attribute("attr_current_pending_sector_count", 0));
+	new_properties.add_property(make_ata_attribute("attr_reallocated_sector_count", 8));
+	new_properties.add_property(make_ata_attribute("attr_current_pending_sector_count", 100));
+
+	REQUIRE(ranking.update(drive_c, old_properties));
+	REQUIRE(ranking.get_score(drive_c) == 8);
+	REQUIRE(ranking.apply_diff(drive_c, storage_property_repository_diff(old_properties, new_properties)));
+	REQUIRE(ranking.get_score(drive_c) == 8 + 1000);
+	REQUIRE(ranking.get_score(drive_c) == storage_risk_score(new_properties));
+	REQUIRE(ranking.get_top(1) == std::vector<StorageRiskEntry>{{drive_c, 1008}});
+
+	ranking.remove(drive_c);
+	REQUIRE(!ranking.get_score(drive_c).has_value());
+	REQUIRE(!ranking.apply_diff(drive_c, storage_property_repository_diff(new_properties, old_properties)));  // unknown
+	REQUIRE(ranking.get_top(1) == std::vector<StorageRiskEntry>{{drive_b, 500}});
+
+	ranking.clear();
+	REQUIRE(ranking.size() == 0);
+	REQUIRE(ranking.get_top(10, 0).empty());
+}
+
+
+
+
+
+
+/// @}
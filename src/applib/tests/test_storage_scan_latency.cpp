@@ -0,0 +1,102 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include "applib/storage_scan_latency.h"
+
+
+
+using std::chrono::microseconds;
+
+
+
+TEST_CASE("StorageScanLatencyPercentile", "[app][scan_latency]")
+{
+	std::vector<microseconds> sorted;
+	REQUIRE(storage_scan_latency_percentile(sorted, 0.5) == microseconds(0));
+
+	for (int i = 1; i <= 100; ++i) {
+		sorted.emplace_back(i);
+	}
+	REQUIRE(storage_scan_latency_percentile(sorted, 0.5) == microseconds(50));
+	REQUIRE(storage_scan_latency_percentile(sorted, 0.95) == microseconds(95));
+	REQUIRE(storage_scan_latency_percentile(sorted, 0.99) == microseconds(99));
+	REQUIRE(storage_scan_latency_percentile(sorted, 0.) == microseconds(1));
+	REQUIRE(storage_scan_latency_percentile(sorted, 1.) == microseconds(100));
+
+	// With few samples, the high percentiles are the maximum
+	sorted = {microseconds(10), microseconds(20), microseconds(30)};
+	REQUIRE(storage_scan_latency_percentile(sorted, 0.5) == microseconds(20));
+	REQUIRE(storage_scan_latency_percentile(sorted, 0.95) == microseconds(30));
+}
+
+
+
+TEST_CASE("StorageScanLatencyReport", "[app][scan_latency]")
+{
+	const StorageScanLatencyKey detect_key {"scan_open", "", "detect"};
+	const StorageScanLatencyKey fetch_key {"scan_open", "/dev/sda", "fetch_full"};
+
+	StorageScanLatencyRecorder recorder;
+	for (int i : {30, 10, 20}) {
+		recorder.add(detect_key, microseconds(i * 1000));
+		recorder.add(fetch_key, microseconds(i * 10000));
+	}
+	const auto summaries = recorder.get_summaries();
+	REQUIRE(summaries.size() == 2);
+	REQUIRE(summaries.at(detect_key).count == 3);
+	REQUIRE(summaries.at(detect_key).p50 == microseconds(20000));
+	REQUIRE(summaries.at(detect_key).max == microseconds(30000));
+
+	// Round trip
+	auto parsed = storage_scan_latency_parse(storage_scan_latency_dump(summaries, "host1"));
+	REQUIRE(parsed);
+	REQUIRE(parsed.value().size() == 2);
+	REQUIRE(parsed.value().at(fetch_key).p95 == summaries.at(fetch_key).p95);
+	REQUIRE(parsed.value().at(fetch_key).count == 3);
+
+	REQUIRE(storage_scan_latency_parse("{}").error().data() == StorageScanLatencyError::InvalidFormat);
+	REQUIRE(storage_scan_latency_parse(R"({"format_version": 1, "entries": [{"phase": "x"}]})").error().data()
+			== StorageScanLatencyError::InvalidFormat);
+
+	// Compare with a slower baseline and a faster one
+	StorageScanLatencySummaries baseline = summaries;
+	baseline.at(fetch_key).p95 = microseconds(200000);  // current: 300000
+	baseline.at(detect_key).p95 = microseconds(25000);  // current: 30000, 5 ms slower
+	baseline[{"scan_open", "/dev/sdb", "fetch_full"}] = {};
+
+	const auto comparison = storage_scan_latency_compare(summaries, baseline, 0.2, microseconds(10000));
+	REQUIRE(comparison.size() == 3);
+	REQUIRE(comparison[0].key == detect_key);
+	REQUIRE(!comparison[0].regressed);  // above the tolerance, but below the absolute threshold
+	REQUIRE(comparison[1].key == fetch_key);
+	REQUIRE(comparison[1].regressed);
+	REQUIRE(!comparison[2].current.has_value());  // gone
+	REQUIRE(!comparison[2].regressed);
+
+	REQUIRE(storage_scan_latency_format_comparison(comparison).find("REGRESSION") != std::string::npos);
+	REQUIRE(!storage_scan_latency_format(summaries).empty());
+}
+
+
+
+
+
+
+/// @}
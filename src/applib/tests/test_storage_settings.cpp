@@ -0,0 +1,104 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "rconfig/rconfig.h"
+#include "applib/storage_settings.h"
+
+
+
+TEST_CASE("StorageSettingsDeviceOptions", "[app][settings]")
+{
+	rconfig::set_default_data("system/smartctl_options", std::string("-q noserial"));
+	rconfig::set_default_data("system/smartctl_device_options", AppDeviceOptionMap());
+
+	AppDeviceOptionMap devmap;
+	devmap.value[{"/dev/sda", ""}] = "-d sat -T permissive";
+	devmap.value[{"/dev/sdb", "scsi"}] = "'unbalanced";
+	rconfig::set_data("system/smartctl_device_options", devmap);
+
+	REQUIRE(app_get_device_options("/dev/sda", "") == std::vector<std::string>{"-d", "sat", "-T", "permissive"});
+	REQUIRE(app_get_device_options("/dev/sda", "scsi").empty());
+	REQUIRE(app_get_device_options("/dev/sdb", "scsi").empty());  // unparsable
+	REQUIRE(app_get_smartctl_default_options() == std::vector<std::string>{"-q", "noserial"});
+
+	// Changing the config invalidates the decoded options
+	devmap.value[{"/dev/sda", ""}] = "-d ata";
+	rconfig::set_data("system/smartctl_device_options", devmap);
+	REQUIRE(app_get_device_options("/dev/sda", "") == std::vector<std::string>{"-d", "ata"});
+
+	rconfig::set_data("system/smartctl_options", std::string("\"unbalanced"));
+	REQUIRE_FALSE(app_get_smartctl_default_options().has_value());
+
+	rconfig::unset_data("system/smartctl_options");
+	rconfig::unset_data("system/smartctl_device_options");
+	REQUIRE(app_get_device_options("/dev/sda", "").empty());
+	REQUIRE(app_get_smartctl_default_options() == std::vector<std::string>{"-q", "noserial"});
+}
+
+
+
+
+TEST_CASE("StorageSettingsDelta", "[app][settings]")
+{
+	AppDriveSettings old_settings;
+	old_settings.smartctl_binary = "smartctl";
+	old_settings.blacklist_patterns = "^/dev/sdz$";
+	old_settings.device_options.value[{"/dev/sda", ""}] = "-d sat";
+	old_settings.device_options.value[{"/dev/sdb", ""}] = "-d ata";
+	old_settings.device_options.value[{"/dev/sdc", "scsi"}] = "-T permissive";
+
+	REQUIRE(app_drive_settings_compare(old_settings, old_settings).is_empty());
+
+	SECTION("Per-device options") {
+		AppDriveSettings new_settings = old_settings;
+		new_settings.device_options.value.erase({"/dev/sda", ""});
+		new_settings.device_options.value[{"/dev/sdb", ""}] = "-d sat";
+		new_settings.device_options.value[{"/dev/sdd", ""}] = "-d nvme";
+		const auto delta = app_drive_settings_compare(old_settings, new_settings);
+		REQUIRE_FALSE(delta.rescan);
+		REQUIRE_FALSE(delta.blacklist);
+		REQUIRE(delta.device_options == std::vector<AppDeviceWithType>{{"/dev/sda", ""}, {"/dev/sdb", ""}, {"/dev/sdd", ""}});
+	}
+
+	SECTION("Blacklist and icons") {
+		AppDriveSettings new_settings = old_settings;
+		new_settings.blacklist_patterns = "^/dev/sdy$";
+		new_settings.icons_show_serial_number = true;
+		const auto delta = app_drive_settings_compare(old_settings, new_settings);
+		REQUIRE_FALSE(delta.rescan);
+		REQUIRE(delta.blacklist);
+		REQUIRE(delta.icon_text);
+		REQUIRE_FALSE(delta.visibility);
+		REQUIRE(delta.device_options.empty());
+	}
+
+	SECTION("Smartctl binary") {
+		AppDriveSettings new_settings = old_settings;
+		new_settings.smartctl_binary = "/usr/local/sbin/smartctl";
+		REQUIRE(app_drive_settings_compare(old_settings, new_settings).rescan);
+	}
+
+	REQUIRE(app_device_options_key_matches({"/dev/sdc", "scsi"}, "/dev/sdc", "scsi"));
+	REQUIRE_FALSE(app_device_options_key_matches({"/dev/sdc", "scsi"}, "/dev/sdc", ""));
+	REQUIRE_FALSE(app_device_options_key_matches({"", ""}, "", ""));
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,114 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "applib/storage_smartd_attrlog.h"
+#include "hz/fs.h"
+
+
+
+namespace {
+
+	/// Get a fresh directory for the test files in the temporary directory
+	hz::fs::path get_test_attrlog_dir()
+	{
+		auto dir = hz::fs::temp_directory_path() / "gsmartcontrol_test_attrlog";
+		std::error_code ec;
+		hz::fs::remove_all(dir, ec);
+		hz::fs::create_directories(dir, ec);
+		return dir;
+	}
+
+}
+
+
+
+TEST_CASE("StorageSmartdAttrlogParse", "[app][history][smartd_attrlog]")
+{
+	const auto sample = storage_smartd_attrlog_parse_line("2024-01-15 10:30:00;\t5;200;0;\t9;97;2513;\t194;117;33;\n");
+	REQUIRE(sample.has_value());
+	REQUIRE(sample->values == StorageHistoryValues{{"ata_attr/5/raw", 0}, {"ata_attr/5/value", 200},
+			{"ata_attr/9/raw", 2513}, {"ata_attr/9/value", 97}, {"ata_attr/194/raw", 33}, {"ata_attr/194/value", 117}});
+
+	const auto later = storage_smartd_attrlog_parse_line("2024-01-15 11:00:00;\t9;97;2514;");
+	REQUIRE(later.has_value());
+	REQUIRE(later->time - sample->time == 1800);
+
+	// SCSI counters, broken lines
+	REQUIRE(!storage_smartd_attrlog_parse_line("2024-01-15 10:30:00;\tread-corr-by-ecc-fast;0;\tnon-medium-errors;1;").has_value());
+	REQUIRE(!storage_smartd_attrlog_parse_line("2024-01-15;\t9;97;2513;").has_value());
+	REQUIRE(!storage_smartd_attrlog_parse_line("").has_value());
+
+	REQUIRE(storage_smartd_attrlog_get_drive_id("WDC WD40EFRX-68N32N0", "WD-WCC7K1234567")
+			== "WDC_WD40EFRX_68N32N0-WD_WCC7K1234567");
+}
+
+
+
+TEST_CASE("StorageSmartdAttrlogImport", "[app][history][smartd_attrlog]")
+{
+	const auto dir = get_test_attrlog_dir();
+	const std::string prefix = hz::fs_path_to_string(dir / "attrlog.");
+	const auto log_file = dir / "attrlog.ST1000-S1.ata.csv";
+	const auto state_file = dir / "state.json";
+
+	auto history = std::make_shared<StorageHistory>(dir / "history.dat");
+	REQUIRE(!history->open());
+
+	// The last line is incomplete
+	REQUIRE(!hz::fs_file_put_contents(log_file, "2024-01-15 10:00:00;\t9;97;100;\n"
+			"2024-01-15 10:30:00;\t9;97;101;\n2024-01-15 11:00:00;\t9;9"));
+
+	{
+		StorageSmartdAttrlogImporter importer(history, prefix, state_file);
+		REQUIRE(!importer.load());
+		REQUIRE(!importer.import(std::vector<std::pair<std::string, std::string>>{{"ST1000", "S1"}, {"ST2000", "S2"}}));
+		REQUIRE(importer.get_imported_count() == 2);
+		REQUIRE(history->get_series("S1", "ata_attr/9/raw", 0, std::numeric_limits<std::int64_t>::max()).size() == 2);
+	}
+
+	// The rest of the line is appended. The offset is reloaded from the state file.
+	REQUIRE(!hz::fs_file_put_contents(log_file, "2024-01-15 10:00:00;\t9;97;100;\n"
+			"2024-01-15 10:30:00;\t9;97;101;\n2024-01-15 11:00:00;\t9;97;102;\n"));
+	{
+		StorageSmartdAttrlogImporter importer(history, prefix, state_file);
+		REQUIRE(!importer.load());
+		REQUIRE(!importer.import(std::vector<std::pair<std::string, std::string>>{{"ST1000", "S1"}}));
+		REQUIRE(importer.get_imported_count() == 1);
+		REQUIRE(!importer.import(std::vector<std::pair<std::string, std::string>>{{"ST1000", "S1"}}));
+		REQUIRE(importer.get_imported_count() == 0);
+	}
+	const auto values = history->get_series("S1", "ata_attr/9/raw", 0, std::numeric_limits<std::int64_t>::max());
+	REQUIRE(values.size() == 3);
+	REQUIRE(values.back().value == 102);
+
+	// A replaced file is read from the beginning, but the samples already in the history are skipped.
+	REQUIRE(!hz::fs_file_put_contents(log_file, "2024-01-15 10:30:00;\t9;97;101;\n"));
+	{
+		StorageSmartdAttrlogImporter importer(history, prefix, state_file);
+		REQUIRE(!importer.load());
+		REQUIRE(!importer.import(std::vector<std::pair<std::string, std::string>>{{"ST1000", "S1"}}));
+		REQUIRE(importer.get_imported_count() == 0);
+	}
+}
+
+
+
+/// @}
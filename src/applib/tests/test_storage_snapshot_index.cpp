@@ -0,0 +1,100 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "applib/storage_property_diff.h"
+#include "applib/storage_property_snapshot.h"
+#include "applib/storage_snapshot_index.h"
+
+
+
+namespace {
+
+	/// Get a fresh snapshot directory in the temporary directory
+	hz::fs::path get_test_snapshot_dir()
+	{
+		auto dir = hz::fs::temp_directory_path() / "gsmartcontrol_test_snapshots";
+		std::error_code ec;
+		hz::fs::remove_all(dir, ec);
+		hz::fs::create_directories(dir, ec);
+		return dir;
+	}
+
+
+	/// Write a snapshot of a drive with a temperature property
+	void write_test_snapshot(const hz::fs::path& file, const std::string& serial, std::int64_t temperature)
+	{
+		StoragePropertyRepository repo;
+		StorageProperty serial_prop(StoragePropertySection::Info, serial);
+		serial_prop.set_name("serial_number", "Serial Number");
+		repo.add_property(serial_prop);
+		StorageProperty temperature_prop(StoragePropertySection::Info, temperature);
+		temperature_prop.set_name("temperature/current", "Current Temperature");
+		repo.add_property(temperature_prop);
+		REQUIRE(!hz::fs_file_put_contents(file, storage_property_snapshot_save(repo)));
+	}
+
+}
+
+
+
+TEST_CASE("StorageSnapshotIndex", "[app][snapshot_index]")
+{
+	const auto dir = get_test_snapshot_dir();
+	write_test_snapshot(dir / "1.snapshot", "AAA", 30);
+	write_test_snapshot(dir / "2.snapshot", "AAA", 35);
+	write_test_snapshot(dir / "3.snapshot", "BBB", 40);
+	REQUIRE(!hz::fs_file_put_contents(dir / "4.snapshot", "garbage"));
+
+	std::vector<std::string> errors;
+	StorageSnapshotIndex index;
+	REQUIRE(index.scan(dir, errors));
+	REQUIRE(errors.size() == 1);  // the garbage one
+	REQUIRE(index.get_serials() == std::vector<std::string>{"AAA", "BBB"});
+	REQUIRE(index.get_entries("AAA").size() == 2);
+	REQUIRE(index.get_entries("CCC").empty());
+	REQUIRE(hz::fs::exists(dir / StorageSnapshotIndex::get_index_file_name()));
+
+	// The snapshots are compared without parsing anything
+	const auto entries = index.get_entries("AAA");
+	auto old_repo = index.load(entries[0]);
+	auto new_repo = index.load(entries[1]);
+	REQUIRE(old_repo);
+	REQUIRE(new_repo);
+	const auto diff = storage_property_repository_diff(*old_repo.value(), *new_repo.value());
+	REQUIRE(diff.changes.size() == 1);
+	REQUIRE(diff.changes[0].new_property->generic_name == "temperature/current");
+
+	// A rescan takes the unchanged snapshots from the index file
+	errors.clear();
+	StorageSnapshotIndex index2;
+	REQUIRE(index2.scan(dir, errors));
+	REQUIRE(index2.get_serials() == index.get_serials());
+	REQUIRE(index2.get_entries("BBB").front().serial == "BBB");
+
+	std::error_code ec;
+	hz::fs::remove_all(dir, ec);
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,87 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_temperature_history.h"
+#include <string>
+
+
+
+TEST_CASE("StorageTemperatureHistoryParseSct", "[app][history]")
+{
+	const std::string text =
+			"SCT Temperature History Version:     2\n"
+			"Temperature Sampling Period:         1 minute\n"
+			"Temperature History Size (Index):    478 (361)\n"
+			"\n"
+			"Index    Estimated Time   Temperature Celsius\n"
+			" 362    2017-08-29 08:43    38  *******************\n"
+			" ...    ..(119 skipped).    ..  *******************\n"
+			"   4    2017-08-29 10:43    38  *******************\n"
+			"   5    2017-08-29 10:44    39  ********************\n"
+			"  98    2017-08-29 12:17     ?  -\n"
+			"  99    2017-08-29 12:18    25  ******\n";
+
+	const auto points = storage_temperature_history_parse_sct_table(text);
+	REQUIRE(points.size() == 4);
+	REQUIRE(points[0].value == 38);
+	REQUIRE(points[1].time - points[0].time == 2 * 60 * 60);
+	REQUIRE(points[2].time - points[1].time == 60);
+	REQUIRE(points[2].value == 39);
+	REQUIRE(points[3].value == 25);
+
+	REQUIRE(storage_temperature_history_parse_sct_table("SCT Commands not supported").empty());
+}
+
+
+
+TEST_CASE("StorageTemperatureBuckets", "[app][history]")
+{
+	StorageTemperatureBuckets buckets;
+	buckets.reset(1000, 1999, 10);  // 100 seconds per bucket
+
+	REQUIRE(buckets.get_bucket_index(999) == std::nullopt);
+	REQUIRE(buckets.get_bucket_index(1000) == 0);
+	REQUIRE(buckets.get_bucket_index(1099) == 0);
+	REQUIRE(buckets.get_bucket_index(1100) == 1);
+	REQUIRE(buckets.get_bucket_index(1999) == 9);
+	REQUIRE(buckets.get_bucket_index(2000) == std::nullopt);
+
+	buckets.add(std::vector<StorageHistoryPoint>{{1010, 30}, {1020, 35}, {1050, 32}, {1500, 40}});
+	REQUIRE(buckets.add({3000, 50}) == std::nullopt);
+	REQUIRE(buckets.add({1990, 20}) == 9);
+
+	const auto& b = buckets.get_buckets();
+	REQUIRE(b.size() == 10);
+	REQUIRE(b[0].has_data);
+	REQUIRE(b[0].min == 30);
+	REQUIRE(b[0].max == 35);
+	REQUIRE(!b[1].has_data);
+	REQUIRE(b[5].min == 40);
+	REQUIRE(b[9].max == 20);
+	REQUIRE(buckets.get_value_range() == std::pair<std::int64_t, std::int64_t>(20, 40));
+
+	// Merging keeps the order
+	const auto merged = storage_temperature_history_merge({{1, 10}, {5, 12}}, {{3, 11}, {7, 13}});
+	REQUIRE(merged.size() == 4);
+	REQUIRE(merged[1].time == 3);
+	REQUIRE(merged[3].value == 13);
+}
+
+
+
+
+/// @}
@@ -0,0 +1,110 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/storage_trend.h"
+#include "applib/storage_property.h"
+
+
+
+namespace {
+
+	constexpr std::int64_t day = 86400;
+
+}
+
+
+
+TEST_CASE("StorageTrendEstimate", "[app][trend]")
+{
+	StorageTrend trend;
+	trend.add(0, 10);
+	REQUIRE(trend.samples == 1);
+	REQUIRE(trend.slope_per_day == 0);
+
+	// A steady rate is approached
+	for (std::int64_t i = 1; i <= 200; ++i) {
+		trend.add(i * day, 10 + i * 2);
+	}
+	REQUIRE(trend.slope_per_day == Approx(2.).epsilon(0.01));
+	REQUIRE(trend.increases == 200);
+	REQUIRE(trend.last_value == 410);
+
+	// Flat values bring both the slope and the recent increases down
+	trend.add(400 * day, 410);
+	REQUIRE(trend.slope_per_day < 0.1);
+	REQUIRE(trend.recent_increases < 1.);
+	REQUIRE(trend.increases == 200);
+}
+
+
+
+TEST_CASE("StorageTrendWarnings", "[app][trend]")
+{
+	StorageTrend pending;
+	pending.add(0, 0);
+	REQUIRE(storage_trend_get_warning("ata_attr/197/raw", pending).first == WarningLevel::None);
+	pending.add(day, 1);
+	REQUIRE(storage_trend_get_warning("ata_attr/197/raw", pending).first == WarningLevel::None);  // a single increase
+	pending.add(2 * day, 3);
+	REQUIRE(storage_trend_get_warning("ata_attr/197/raw", pending).first == WarningLevel::Warning);
+	REQUIRE(storage_trend_get_warning("ata_attr/199/raw", pending).first == WarningLevel::Notice);
+	REQUIRE(storage_trend_get_warning("ata_attr/9/raw", pending).first == WarningLevel::None);  // not tracked
+
+	// 1% per 5 days, 60% left
+	StorageTrend wear;
+	for (std::int64_t i = 0; i <= 30; ++i) {
+		wear.add(i * 5 * day, 10 + i);
+	}
+	const auto [level, reason] = storage_trend_get_warning("nvme/nvme_smart_health_information_log/percentage_used", wear);
+	REQUIRE(level == WarningLevel::Notice);
+	REQUIRE(!reason.empty());
+
+	REQUIRE(storage_trend_is_tracked("ata_attr/5/raw"));
+	REQUIRE(!storage_trend_is_tracked("ata_attr/5/value"));
+}
+
+
+
+TEST_CASE("StorageTrendApplyWarnings", "[app][trend]")
+{
+	AtaStorageAttribute attr;
+	attr.id = 197;
+	StorageProperty p(StoragePropertySection::AtaAttributes, attr);
+	p.generic_name = "attr_current_pending_sector_count";
+	StoragePropertyRepository properties;
+	properties.add_property(p);
+
+	StorageTrend trend;
+	trend.add(0, 0);
+	trend.add(day, 1);
+	trend.add(2 * day, 2);
+
+	REQUIRE(!storage_trend_apply_warnings(properties, {{"ata_attr/5/raw", trend}}));
+	REQUIRE(storage_trend_apply_warnings(properties, {{"ata_attr/197/raw", trend}}));
+	REQUIRE(properties.get_properties().front().warning_level == WarningLevel::Warning);
+
+	// Not lowered or applied again
+	REQUIRE(!storage_trend_apply_warnings(properties, {{"ata_attr/197/raw", trend}}));
+	REQUIRE(properties.get_properties().front().warning_level == WarningLevel::Warning);
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,102 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <cstdio>  // std::snprintf
+
+#include "hz/fs.h"
+#include "applib/storage_virtual_import.h"
+
+
+
+namespace {
+
+	/// Append a tar member to \c tar
+	void add_tar_member(std::string& tar, const std::string& name, const std::string& data, char type = '0')
+	{
+		std::string header(512, '\0');
+		header.replace(0, name.size(), name);
+		char size_field[12] = {};
+		std::snprintf(size_field, sizeof(size_field), "%011o", static_cast<unsigned int>(data.size()));
+		header.replace(124, 11, size_field, 11);
+		header[156] = type;
+		header.replace(257, 6, "ustar", 6);
+		tar += header;
+		tar += data;
+		tar.append((512 - data.size() % 512) % 512, '\0');
+	}
+
+}
+
+
+
+TEST_CASE("VirtualImportTar", "[app][virtual]")
+{
+	std::string tar;
+	add_tar_member(tar, "outputs/", "", '5');  // directory
+	add_tar_member(tar, "outputs/sda.json", "{\"a\": 1}");
+	add_tar_member(tar, "././@LongLink", std::string(600, 'x') + ".txt", 'L');
+	add_tar_member(tar, "ignored", std::string(513, 'y'));
+	tar.append(1024, '\0');
+
+	std::vector<VirtualDriveSource> sources;
+	REQUIRE(storage_virtual_import_read_tar(tar, "a.tar", sources));
+	REQUIRE(sources.size() == 2);
+	REQUIRE(sources[0].name == "a.tar/outputs/sda.json");
+	REQUIRE(sources[0].data == "{\"a\": 1}");
+	REQUIRE(sources[1].name == "a.tar/" + std::string(600, 'x') + ".txt");
+	REQUIRE(sources[1].data == std::string(513, 'y'));
+
+	SECTION("Truncated") {
+		sources.clear();
+		REQUIRE(!storage_virtual_import_read_tar(std::string_view(tar).substr(0, 1600), "a.tar", sources));
+	}
+}
+
+
+
+TEST_CASE("VirtualImportDirectory", "[app][virtual]")
+{
+	const hz::fs::path dir = hz::fs::temp_directory_path() / "gsmartcontrol_test_virtual_import";
+	std::error_code ec;
+	hz::fs::remove_all(dir, ec);
+	hz::fs::create_directories(dir / "sub", ec);
+	REQUIRE(!ec);
+
+	std::string tar;
+	add_tar_member(tar, "c.txt", "ccc");
+	tar.append(1024, '\0');
+	REQUIRE(!hz::fs_file_put_contents(dir / "b.txt", "bbb"));
+	REQUIRE(!hz::fs_file_put_contents(dir / "sub" / "a.json", "aaa"));
+	REQUIRE(!hz::fs_file_put_contents(dir / "sub" / "outputs.TAR", tar));
+
+	std::vector<std::string> errors;
+	auto sources = storage_virtual_import_read_sources(dir, errors);
+	REQUIRE(sources);
+	REQUIRE(errors.empty());
+	REQUIRE(sources->size() == 3);
+	REQUIRE(sources->at(0).name == hz::fs_path_to_string(dir / "b.txt"));
+	REQUIRE(sources->at(1).name == hz::fs_path_to_string(dir / "sub" / "a.json"));
+	REQUIRE(sources->at(2).name == hz::fs_path_to_string(dir / "sub" / "outputs.TAR") + "/c.txt");
+	REQUIRE(sources->at(2).data == "ccc");
+
+	hz::fs::remove_all(dir, ec);
+}
+
+
+
+
+/// @}
@@ -0,0 +1,97 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include "applib/text_search_index.h"
+#include <string>
+#include <vector>
+
+
+
+TEST_CASE("TextSearchTokenize", "[app][text_search]")
+{
+	std::vector<std::string> tokens;
+	text_search_tokenize("smartctl -x /dev/sdq: Input/output error", tokens);
+	REQUIRE(tokens == std::vector<std::string>{"smartctl", "x", "dev", "sdq", "input", "output", "error"});
+
+	tokens.clear();
+	text_search_tokenize("", tokens);
+	text_search_tokenize(" -- ", tokens);
+	REQUIRE(tokens.empty());
+
+	text_search_tokenize("abcdef", tokens, 3);
+	REQUIRE(tokens == std::vector<std::string>{"abc"});
+}
+
+
+
+TEST_CASE("TextSearchIndex", "[app][text_search]")
+{
+	TextSearchIndex index;
+	REQUIRE(index.add(1, {"smartctl -x /dev/sda", "SMART overall-health self-assessment test result: PASSED"}));
+	REQUIRE(index.add(2, {"smartctl -x /dev/sdq", "Smartctl open device: /dev/sdq failed: Input/output error"}));
+	REQUIRE(index.add(3, {"smartctl -i /dev/sdb", "Device Model: ST1000"}));
+	REQUIRE(!index.add(3, {"smartctl"}));  // not increasing
+	REQUIRE(index.size() == 3);
+
+	REQUIRE(index.find("sdq input/output error") == std::vector<TextSearchIndex::DocumentId>{2});
+	REQUIRE(index.find("SMARTCTL") == std::vector<TextSearchIndex::DocumentId>{1, 2, 3});
+	REQUIRE(index.find("/dev/sd") == std::vector<TextSearchIndex::DocumentId>{1, 2, 3});  // prefix
+	REQUIRE(index.find("sd smartctl").empty());  // only the last word is a prefix
+	REQUIRE(index.find("passed sdq").empty());
+	REQUIRE(index.find("").empty());
+
+	// Removal, compaction
+	const auto memory_before = index.get_memory_usage();
+	index.remove_before(3);
+	REQUIRE(index.size() == 1);
+	REQUIRE(index.find("smartctl") == std::vector<TextSearchIndex::DocumentId>{3});
+	REQUIRE(index.find("sdq").empty());
+	REQUIRE(index.get_memory_usage() < memory_before);
+
+	REQUIRE(!index.add(2, {"smartctl"}));  // removed IDs can't be reused
+	REQUIRE(index.add(4, {"smartctl -x /dev/sdq"}));
+	REQUIRE(index.find("sdq") == std::vector<TextSearchIndex::DocumentId>{4});
+
+	index.clear();
+	REQUIRE(index.size() == 0);
+	REQUIRE(index.get_token_count() == 0);
+	REQUIRE(index.find("smartctl").empty());
+	REQUIRE(index.add(1, {"smartctl"}));
+	REQUIRE(index.find("smartctl") == std::vector<TextSearchIndex::DocumentId>{1});
+}
+
+
+
+TEST_CASE("TextSearchIndexLarge", "[app][text_search]")
+{
+	TextSearchIndex index;
+	for (TextSearchIndex::DocumentId id = 1; id <= 100000; ++id) {
+		const std::string device = "/dev/sd" + std::to_string(id % 100);
+		REQUIRE(index.add(id, {"smartctl -x " + device, (id % 1000 == 0) ? "Input/output error" : "PASSED"}));
+		if (id % 10000 == 0 && id > 50000) {
+			index.remove_before(id - 50000);  // bounded, like the log
+		}
+	}
+	REQUIRE(index.size() == 50001);
+	const auto found = index.find("sd0 input output");
+	REQUIRE(found.size() == 51);
+	REQUIRE(found.front() == 50000);
+}
+
+
+
+/// @}
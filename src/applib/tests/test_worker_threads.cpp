@@ -0,0 +1,106 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib_tests
+/// \weakgroup applib_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "applib/worker_threads.h"
+
+
+
+TEST_CASE("AppTaskGroup", "[app][worker_threads]")
+{
+	SECTION("All tasks run") {
+		std::vector<int> done(100, 0);
+		{
+			AppTaskGroup group;
+			for (std::size_t i = 0; i < done.size(); ++i) {
+				group.run([&done, i]() { done[i] = 1; });
+			}
+			group.wait(false);
+		}
+		REQUIRE(std::count(done.begin(), done.end(), 1) == 100);
+	}
+
+	SECTION("Concurrency limit") {
+		std::atomic<int> running = 0;
+		std::atomic<int> max_running = 0;
+		AppTaskGroup group(2);
+		for (int i = 0; i < 20; ++i) {
+			group.run([&]() {
+				const int now_running = ++running;
+				int prev = max_running;
+				while (now_running > prev && !max_running.compare_exchange_weak(prev, now_running)) { }
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				--running;
+			});
+		}
+		group.wait(false);
+		REQUIRE(max_running <= 2);
+	}
+
+	SECTION("Nested groups") {
+		// More outer tasks than threads, each waiting for its own inner group
+		std::atomic<std::size_t> inner_done = 0;
+		const std::size_t outer_count = app_get_worker_thread_count() * 2;
+		AppTaskGroup group;
+		for (std::size_t i = 0; i < outer_count; ++i) {
+			group.run([&inner_done]() {
+				AppTaskGroup inner;
+				for (int j = 0; j < 4; ++j) {
+					inner.run([&inner_done]() { ++inner_done; });
+				}
+				inner.wait();
+			});
+		}
+		group.wait(false);
+		REQUIRE(inner_done == outer_count * 4);
+	}
+
+	SECTION("Cancellation") {
+		auto cancellation = std::make_shared<AppCancellation>();
+		cancellation->cancel();
+		std::atomic<int> done = 0;
+		AppTaskGroup group(0, cancellation);
+		for (int i = 0; i < 10; ++i) {
+			group.run([&done]() { ++done; });
+		}
+		group.wait(false);
+		REQUIRE(done == 0);
+	}
+}
+
+
+
+TEST_CASE("AppRunParallelRanges", "[app][worker_threads]")
+{
+	std::vector<int> covered(1000, 0);
+	app_run_parallel_ranges(covered.size(), 10, [&covered](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			++covered[i];
+		}
+	});
+	REQUIRE(std::count(covered.begin(), covered.end(), 1) == 1000);
+}
+
+
+
+
+/// @}
@@ -0,0 +1,235 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <algorithm>
+#include <iterator>
+
+#include "text_search_index.h"
+
+
+
+namespace {
+
+	/// Check if \c c is a part of a token
+	inline bool text_search_is_token_char(char c)
+	{
+		return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+				|| (static_cast<unsigned char>(c) >= 0x80);
+	}
+
+
+
+	/// Get the heap memory of a token (nothing if it fits into the string object)
+	std::size_t text_search_get_token_memory(const std::string& token)
+	{
+		static const std::size_t inline_capacity = std::string().capacity();
+		return (token.capacity() > inline_capacity) ? token.capacity() + 1 : 0;
+	}
+
+}
+
+
+
+void text_search_tokenize(std::string_view text, std::vector<std::string>& tokens, std::size_t max_size)
+{
+	std::size_t pos = 0;
+	while (pos < text.size()) {
+		while (pos < text.size() && !text_search_is_token_char(text[pos])) {
+			++pos;
+		}
+		const std::size_t start = pos;
+		while (pos < text.size() && text_search_is_token_char(text[pos])) {
+			++pos;
+		}
+		if (pos == start) {
+			break;
+		}
+		std::string token(text.substr(start, std::min(pos - start, max_size)));
+		for (char& c : token) {
+			if (c >= 'A' && c <= 'Z') {
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+		}
+		tokens.push_back(std::move(token));
+	}
+}
+
+
+
+bool TextSearchIndex::add(DocumentId id, const std::vector<std::string_view>& texts)
+{
+	if (!documents_.empty() && id <= documents_.back().id) {
+		return false;
+	}
+	if (documents_.empty() && id < first_id_) {
+		return false;
+	}
+
+	std::vector<std::string> tokens;
+	for (const auto& text : texts) {
+		text_search_tokenize(text, tokens);
+	}
+	std::sort(tokens.begin(), tokens.end());
+	tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+
+	for (auto& token : tokens) {
+		auto iter = postings_.find(token);
+		if (iter == postings_.end()) {
+			token_bytes_ += text_search_get_token_memory(token);
+			iter = postings_.emplace(std::move(token), std::vector<DocumentId>()).first;
+		}
+		iter->second.push_back(id);
+	}
+	posting_count_ += tokens.size();
+	documents_.push_back({id, tokens.size()});
+	return true;
+}
+
+
+
+void TextSearchIndex::remove_before(DocumentId id)
+{
+	while (!documents_.empty() && documents_.front().id < id) {
+		removed_posting_count_ += documents_.front().posting_count;
+		documents_.pop_front();
+	}
+	first_id_ = std::max(first_id_, id);
+
+	// Rewriting the lists is linear in the index size, do it when most postings are removed.
+	if (removed_posting_count_ > posting_count_ / 2) {
+		compact();
+	}
+}
+
+
+
+void TextSearchIndex::clear()
+{
+	postings_.clear();
+	documents_.clear();
+	first_id_ = 0;
+	posting_count_ = 0;
+	removed_posting_count_ = 0;
+	token_bytes_ = 0;
+}
+
+
+
+std::vector<TextSearchIndex::DocumentId> TextSearchIndex::find(std::string_view query) const
+{
+	std::vector<std::string> words;
+	text_search_tokenize(query, words);
+	if (words.empty()) {
+		return {};
+	}
+	// The last word may be incomplete
+	const std::string prefix = words.back();
+	words.pop_back();
+	std::sort(words.begin(), words.end());
+	words.erase(std::unique(words.begin(), words.end()), words.end());
+
+	// Start with the shortest list, the intersection can only shrink
+	std::vector<const std::vector<DocumentId>*> lists;
+	for (const auto& word : words) {
+		auto iter = postings_.find(word);
+		if (iter == postings_.end()) {
+			return {};
+		}
+		lists.push_back(&iter->second);
+	}
+	std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+	std::vector<DocumentId> result;
+	bool result_set = false;
+	for (const auto* list : lists) {
+		auto begin = std::lower_bound(list->begin(), list->end(), first_id_);
+		if (!result_set) {
+			result.assign(begin, list->end());
+			result_set = true;
+		} else {
+			std::vector<DocumentId> list_result;
+			std::set_intersection(result.begin(), result.end(), begin, list->end(), std::back_inserter(list_result));
+			result = std::move(list_result);
+		}
+		if (result.empty()) {
+			return {};
+		}
+	}
+
+	// Union of the lists of the tokens starting with the prefix
+	std::vector<DocumentId> prefix_result;
+	for (auto iter = postings_.lower_bound(prefix); iter != postings_.end() && iter->first.starts_with(prefix); ++iter) {
+		auto begin = std::lower_bound(iter->second.begin(), iter->second.end(), first_id_);
+		if (result_set) {
+			// Only the candidates matter
+			std::vector<DocumentId> matching;
+			std::set_intersection(result.begin(), result.end(), begin, iter->second.end(), std::back_inserter(matching));
+			prefix_result.insert(prefix_result.end(), matching.begin(), matching.end());
+		} else {
+			prefix_result.insert(prefix_result.end(), begin, iter->second.end());
+		}
+	}
+	std::sort(prefix_result.begin(), prefix_result.end());
+	prefix_result.erase(std::unique(prefix_result.begin(), prefix_result.end()), prefix_result.end());
+	return prefix_result;
+}
+
+
+
+std::size_t TextSearchIndex::size() const
+{
+	return documents_.size();
+}
+
+
+
+std::size_t TextSearchIndex::get_token_count() const
+{
+	return postings_.size();
+}
+
+
+
+std::size_t TextSearchIndex::get_memory_usage() const
+{
+	// Map nodes (with their strings and vectors), token heap data, postings (without the
+	// vector slack, so that this is cheap enough to call after each addition), documents.
+	// The removed postings are not counted, so that the removals are reflected immediately
+	// (and a size limit loop can end); they are freed by the next compaction.
+	const std::size_t node_size = sizeof(std::string) + sizeof(std::vector<DocumentId>) + 4 * sizeof(void*);
+	return postings_.size() * node_size + token_bytes_ + (posting_count_ - removed_posting_count_) * sizeof(DocumentId)
+			+ documents_.size() * sizeof(Document);
+}
+
+
+
+void TextSearchIndex::compact()
+{
+	token_bytes_ = 0;
+	for (auto iter = postings_.begin(); iter != postings_.end(); ) {
+		auto& ids = iter->second;
+		ids.erase(ids.begin(), std::lower_bound(ids.begin(), ids.end(), first_id_));
+		if (ids.empty()) {
+			iter = postings_.erase(iter);
+			continue;
+		}
+		ids.shrink_to_fit();
+		token_bytes_ += text_search_get_token_memory(iter->first);
+		++iter;
+	}
+	posting_count_ -= removed_posting_count_;
+	removed_posting_count_ = 0;
+}
+
+
+
+
+/// @}
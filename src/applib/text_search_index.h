@@ -0,0 +1,98 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef TEXT_SEARCH_INDEX_H
+#define TEXT_SEARCH_INDEX_H
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+/// Split \c text into lowercase search tokens: the runs of ASCII letters, digits and
+/// non-ASCII (UTF-8) bytes. Tokens longer than \c max_size bytes are truncated.
+/// The tokens are appended to \c tokens, duplicates included.
+void text_search_tokenize(std::string_view text, std::vector<std::string>& tokens, std::size_t max_size = 64);
+
+
+
+/// An inverted index of text documents (e.g. the execution log entries), for finding
+/// the documents containing all the words of a query without scanning their text.
+/// The documents are added with increasing IDs and removed oldest first, so that the
+/// posting lists stay sorted and are only appended to; the removed postings are dropped
+/// in batches. This class is not thread-safe.
+class TextSearchIndex {
+	public:
+
+		/// Document ID
+		using DocumentId = std::uint64_t;
+
+
+		/// Add a document consisting of \c texts. \c id must be larger than the IDs of
+		/// all the documents added before. \return false if it's not.
+		bool add(DocumentId id, const std::vector<std::string_view>& texts);
+
+		/// Remove the documents with IDs smaller than \c id
+		void remove_before(DocumentId id);
+
+		/// Remove all documents. The IDs may start over after this.
+		void clear();
+
+
+		/// Find the documents containing all the words of \c query (tokenized the same way as
+		/// the documents). The last word of the query matches the token prefixes too, so that
+		/// the results can follow the typing. \return the matching IDs, ascending. An empty
+		/// query matches nothing.
+		[[nodiscard]] std::vector<DocumentId> find(std::string_view query) const;
+
+
+		/// Get the number of documents
+		[[nodiscard]] std::size_t size() const;
+
+		/// Get the number of distinct tokens
+		[[nodiscard]] std::size_t get_token_count() const;
+
+		/// Get the approximate memory usage of the (not removed) documents, in bytes
+		[[nodiscard]] std::size_t get_memory_usage() const;
+
+
+	private:
+
+		/// Drop the postings of the removed documents
+		void compact();
+
+
+		/// A document, for removal
+		struct Document {
+			DocumentId id = 0;  ///< Document ID
+			std::size_t posting_count = 0;  ///< Number of its (distinct) tokens
+		};
+
+		std::map<std::string, std::vector<DocumentId>, std::less<>> postings_;  ///< Token -> IDs of the documents containing it, ascending
+		std::deque<Document> documents_;  ///< Documents, ascending
+		DocumentId first_id_ = 0;  ///< Smallest ID of a document which wasn't removed
+		std::size_t posting_count_ = 0;  ///< Number of postings, including the removed ones
+		std::size_t removed_posting_count_ = 0;  ///< Number of postings of the removed documents
+		std::size_t token_bytes_ = 0;  ///< Total size of the tokens in postings_
+
+};
+
+
+
+
+#endif
+
+/// @}
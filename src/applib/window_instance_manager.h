@@ -42,6 +42,14 @@ class WindowInstanceManagerStorage {
 		}
 
 
+		/// Find a previously stored instance. \return nullptr if it's not stored.
+		static std::shared_ptr<Gtk::Window> find_instance(Gtk::Window* window)
+		{
+			auto found = std::find_if(instances_.begin(), instances_.end(), [window](const std::shared_ptr<Gtk::Window>& elem) { return elem.get() == window; });
+			return (found != instances_.end() ? *found : nullptr);
+		}
+
+
 		/// Destroy all stored instances
 		static void destroy_all_instances()
 		{
@@ -96,6 +104,13 @@ class WindowInstanceManager {
 		}
 
 
+		/// Get the stored shared pointer to this instance. \return nullptr if it's not stored.
+		std::shared_ptr<Child> get_stored_instance()
+		{
+			return std::dynamic_pointer_cast<Child>(WindowInstanceManagerStorage::find_instance(dynamic_cast<Gtk::Window*>(this)));  // side-cast
+		}
+
+
 	protected:
 
 		/// Store an instance and keep it alive.
@@ -0,0 +1,382 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2008 - 2021 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#include <glib.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "worker_threads.h"
+
+
+
+namespace {
+
+	/// Minimum number of the pool threads with the automatic thread count
+	constexpr std::size_t min_auto_worker_threads = 8;
+
+
+	/// See app_set_worker_thread_count()
+	std::atomic<std::size_t> s_worker_thread_count = 0;
+
+
+	/// Run \c task with its own thread-default main context
+	void run_task_in_own_context(const std::function<void()>& task)
+	{
+		GMainContext* context = g_main_context_new();
+		g_main_context_push_thread_default(context);
+		task();
+		g_main_context_pop_thread_default(context);
+		g_main_context_unref(context);
+	}
+
+
+
+	/// The process-wide worker pool. The jobs are coarse (they run commands or process
+	/// whole ranges of properties), so one mutex for all the queues is enough.
+	class AppWorkerPool {
+		public:
+
+			/// Constructor, starts the threads
+			explicit AppWorkerPool(std::size_t thread_count)
+					: queues_(thread_count + 1)
+			{
+				threads_.reserve(thread_count);
+				for (std::size_t i = 0; i < thread_count; ++i) {
+					threads_.emplace_back(&AppWorkerPool::thread_main, this, i);
+				}
+			}
+
+			/// Deleted
+			AppWorkerPool(const AppWorkerPool& other) = delete;
+
+			/// Deleted
+			AppWorkerPool(AppWorkerPool&& other) = delete;
+
+			/// Deleted
+			AppWorkerPool& operator=(const AppWorkerPool& other) = delete;
+
+			/// Deleted
+			AppWorkerPool& operator=(AppWorkerPool&& other) = delete;
+
+			/// Destructor, runs the remaining jobs and stops the threads
+			~AppWorkerPool()
+			{
+				{
+					const std::lock_guard lock(mutex_);
+					stopping_ = true;
+				}
+				cond_.notify_all();
+				for (auto& thread : threads_) {
+					thread.join();
+				}
+			}
+
+
+			/// Queue a job. The jobs submitted from a worker thread go to its own queue,
+			/// the others to the shared one.
+			void submit(std::function<void()> job)
+			{
+				{
+					const std::lock_guard lock(mutex_);
+					const std::size_t queue_index = (current_pool_ == this ? current_worker_index_ : queues_.size() - 1);
+					queues_[queue_index].push_back(std::move(job));
+				}
+				cond_.notify_one();
+			}
+
+
+			/// Check whether the calling thread is one of the pool threads
+			[[nodiscard]] static bool get_in_worker_thread()
+			{
+				return current_pool_ != nullptr;
+			}
+
+
+		private:
+
+			/// Take the next job of worker \c worker_index: the newest one of its own queue,
+			/// the oldest shared one, or the oldest one of another worker. The mutex must be locked.
+			bool take_job(std::size_t worker_index, std::function<void()>& job)
+			{
+				auto take = [&job](std::deque<std::function<void()>>& queue, bool newest) {
+					if (queue.empty()) {
+						return false;
+					}
+					job = std::move(newest ? queue.back() : queue.front());
+					if (newest) {
+						queue.pop_back();
+					} else {
+						queue.pop_front();
+					}
+					return true;
+				};
+				if (take(queues_[worker_index], true) || take(queues_.back(), false)) {
+					return true;
+				}
+				const std::size_t worker_count = queues_.size() - 1;  // threads_ may still be growing
+				for (std::size_t i = 1; i < worker_count; ++i) {
+					if (take(queues_[(worker_index + i) % worker_count], false)) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+
+			/// Worker thread function
+			void thread_main(std::size_t worker_index)
+			{
+				current_pool_ = this;
+				current_worker_index_ = worker_index;
+
+				std::unique_lock lock(mutex_);
+				while (true) {
+					std::function<void()> job;
+					if (take_job(worker_index, job)) {
+						lock.unlock();
+						job();
+						job = nullptr;  // destroy the captures outside the lock
+						lock.lock();
+					} else if (stopping_) {
+						break;
+					} else {
+						cond_.wait(lock);
+					}
+				}
+			}
+
+
+			std::mutex mutex_;  ///< Protects the queues and stopping_
+			std::condition_variable cond_;  ///< Notified when a job is queued or the pool stops
+			std::vector<std::deque<std::function<void()>>> queues_;  ///< Per-worker queues, plus the shared one at the end
+			bool stopping_ = false;  ///< Set by the destructor
+			std::vector<std::thread> threads_;  ///< Worker threads
+
+			static thread_local AppWorkerPool* current_pool_;  ///< Pool of the current worker thread, nullptr if not a worker
+			static thread_local std::size_t current_worker_index_;  ///< Index of the current worker thread
+
+	};
+
+
+	thread_local AppWorkerPool* AppWorkerPool::current_pool_ = nullptr;
+	thread_local std::size_t AppWorkerPool::current_worker_index_ = 0;
+
+
+
+	/// Get the worker pool, starting it if needed
+	AppWorkerPool& get_worker_pool()
+	{
+		static AppWorkerPool pool(app_get_worker_thread_count());
+		return pool;
+	}
+
+}
+
+
+
+void app_set_worker_thread_count(std::size_t count)
+{
+	s_worker_thread_count = count;
+}
+
+
+
+std::size_t app_get_worker_thread_count()
+{
+	if (const std::size_t count = s_worker_thread_count; count > 0) {
+		return count;
+	}
+	return std::max<std::size_t>(min_auto_worker_threads, std::thread::hardware_concurrency());
+}
+
+
+
+/// State of a task group, shared with its queued pool jobs
+struct AppTaskGroup::State {
+	std::mutex mutex;  ///< Protects the members below
+	std::condition_variable cond;  ///< Notified when all the tasks are finished
+	std::deque<std::function<void()>> pending;  ///< Tasks not started yet
+	std::size_t running = 0;  ///< Number of the tasks running now
+	std::size_t queued_runners = 0;  ///< Number of the pool jobs queued to run the pending tasks
+	std::size_t unfinished = 0;  ///< Number of the pending and running tasks
+	std::size_t max_concurrency = 0;  ///< See AppTaskGroup::AppTaskGroup()
+	AppCancellationPtr cancellation;  ///< See AppTaskGroup::AppTaskGroup()
+	GMainContext* wait_context = nullptr;  ///< Context iterated by wait(), woken up when all the tasks are finished
+
+
+	/// Run the next pending task, if the concurrency limit allows it. \c lock must hold the mutex.
+	/// \return false if nothing was run.
+	bool run_next(std::unique_lock<std::mutex>& lock)
+	{
+		if (pending.empty() || (max_concurrency > 0 && running >= max_concurrency)) {
+			return false;
+		}
+		std::function<void()> task = std::move(pending.front());
+		pending.pop_front();
+		++running;
+		lock.unlock();
+
+		if (!app_is_cancelled(cancellation)) {
+			run_task_in_own_context(task);
+		}
+		task = nullptr;  // destroy the captures outside the lock
+
+		lock.lock();
+		--running;
+		if (--unfinished == 0) {
+			cond.notify_all();
+			if (wait_context) {
+				g_main_context_wakeup(wait_context);
+			}
+		}
+		return true;
+	}
+};
+
+
+
+AppTaskGroup::AppTaskGroup(std::size_t max_concurrency, AppCancellationPtr cancellation)
+		: state_(std::make_shared<State>())
+{
+	state_->max_concurrency = max_concurrency;
+	state_->cancellation = std::move(cancellation);
+}
+
+
+
+AppTaskGroup::~AppTaskGroup()
+{
+	wait();
+}
+
+
+
+void AppTaskGroup::run(std::function<void()> task)
+{
+	bool add_runner = false;
+	{
+		const std::lock_guard lock(state_->mutex);
+		state_->pending.push_back(std::move(task));
+		++state_->unfinished;
+		// Each runner job runs the pending tasks until there are none left
+		const bool below_limit = (state_->max_concurrency == 0
+				|| state_->running + state_->queued_runners < state_->max_concurrency);
+		if (below_limit && state_->queued_runners < state_->pending.size()) {
+			++state_->queued_runners;
+			add_runner = true;
+		}
+	}
+	if (add_runner) {
+		get_worker_pool().submit([state = state_]() {
+			std::unique_lock lock(state->mutex);
+			--state->queued_runners;
+			while (state->run_next(lock)) { }
+		});
+	}
+}
+
+
+
+void AppTaskGroup::wait(bool iterate_main_context)
+{
+	std::unique_lock lock(state_->mutex);
+	if (state_->unfinished == 0) {
+		return;
+	}
+
+	if (!iterate_main_context || AppWorkerPool::get_in_worker_thread()) {
+		// Help instead of waiting. This also guarantees progress if all the workers are waiting.
+		while (state_->unfinished > 0) {
+			if (!state_->run_next(lock)) {
+				state_->cond.wait(lock);
+			}
+		}
+		return;
+	}
+
+	GMainContext* context = g_main_context_get_thread_default();
+	if (!context) {
+		context = g_main_context_default();
+	}
+	state_->wait_context = context;
+	while (state_->unfinished > 0) {
+		lock.unlock();
+		g_main_context_iteration(context, TRUE);
+		lock.lock();
+	}
+	state_->wait_context = nullptr;
+}
+
+
+
+void app_post_worker_task(std::function<void()> task)
+{
+	get_worker_pool().submit([task = std::move(task)]() {
+		run_task_in_own_context(task);
+	});
+}
+
+
+
+void app_run_worker_tasks(std::size_t task_count, std::size_t max_threads,
+		const std::function<void(std::size_t task_index)>& task)
+{
+	if (std::min(max_threads, task_count) <= 1) {
+		for (std::size_t i = 0; i < task_count; ++i) {
+			task(i);
+		}
+		return;
+	}
+
+	AppTaskGroup group(max_threads);
+	for (std::size_t i = 0; i < task_count; ++i) {
+		group.run([&task, i]() {
+			task(i);
+		});
+	}
+	group.wait();
+}
+
+
+
+void app_run_parallel_ranges(std::size_t count, std::size_t min_range_size,
+		const std::function<void(std::size_t begin, std::size_t end)>& task)
+{
+	const std::size_t max_ranges = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+	const std::size_t range_count = std::min(max_ranges, count / std::max<std::size_t>(1, min_range_size));
+	if (range_count <= 1) {
+		task(0, count);
+		return;
+	}
+
+	// Spread the remainder over the first ranges
+	auto get_range_begin = [count, range_count](std::size_t range_index) {
+		return (count / range_count) * range_index + std::min(range_index, count % range_count);
+	};
+
+	AppTaskGroup group;
+	for (std::size_t i = 1; i < range_count; ++i) {
+		group.run([&task, begin = get_range_begin(i), end = get_range_begin(i + 1)]() {
+			task(begin, end);
+		});
+	}
+	task(0, get_range_begin(1));
+	group.wait(false);
+}
+
+
+
+/// @}
@@ -0,0 +1,128 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2008 - 2021 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup applib
+/// \weakgroup applib
+/// @{
+
+#ifndef WORKER_THREADS_H
+#define WORKER_THREADS_H
+
+#include <cstddef>  // std::size_t
+#include <functional>
+#include <memory>
+
+#include "app_cancellation.h"
+
+
+
+/*
+All the parallel work of applib (detection, fetching, description processing, virtual drive
+loading, bulk operations) runs on one process-wide pool of worker threads, created on first use.
+Each worker has its own queue; the tasks submitted from a worker go to its own queue (and are run
+newest first), and the idle workers steal the oldest tasks from the others. The tasks are submitted
+in groups (AppTaskGroup), which are waited for as a whole. A thread waiting for a group runs
+the group's pending tasks itself instead of sleeping (unless it iterates its main context, see
+AppTaskGroup::wait()), so nested groups cannot starve the pool.
+
+Each task runs with its own thread-default main context, so CommandExecutor (non-GUI) instances
+created inside the task attach their event sources there.
+*/
+
+
+
+/// Set the number of the worker pool threads. 0 means automatic: the number of CPU cores,
+/// but at least 8, since most of the tasks just wait for smartctl. This has no effect
+/// once the pool is started (by the first parallel task), so call it on startup.
+void app_set_worker_thread_count(std::size_t count);
+
+
+/// Get the number of the worker pool threads (the one it has or will have when started)
+[[nodiscard]] std::size_t app_get_worker_thread_count();
+
+
+
+/// A group of tasks run on the worker pool. The group is waited for with wait() (or
+/// in the destructor), so the tasks may safely reference the caller's local variables.
+/// The tasks must not throw. The group itself must only be used from the thread which created it.
+class AppTaskGroup {
+	public:
+
+		/// Constructor. No more than \c max_concurrency tasks of this group run at the same time
+		/// (0 means up to the pool size). If \c cancellation is cancelled, the tasks which didn't
+		/// start yet are skipped (the running ones should check it themselves).
+		explicit AppTaskGroup(std::size_t max_concurrency = 0, AppCancellationPtr cancellation = nullptr);
+
+		/// Deleted
+		AppTaskGroup(const AppTaskGroup& other) = delete;
+
+		/// Deleted
+		AppTaskGroup(AppTaskGroup&& other) = delete;
+
+		/// Deleted
+		AppTaskGroup& operator=(const AppTaskGroup& other) = delete;
+
+		/// Deleted
+		AppTaskGroup& operator=(AppTaskGroup&& other) = delete;
+
+		/// Destructor, waits for the tasks (see wait())
+		~AppTaskGroup();
+
+
+		/// Submit a task
+		void run(std::function<void()> task);
+
+
+		/// Wait until all the submitted tasks are finished (or skipped).
+		/// If \c iterate_main_context is true and this is not a worker thread, the calling thread keeps
+		/// iterating its thread-default main context (the default one if not set), so the GUI stays responsive.
+		/// Otherwise it runs the pending tasks of the group itself, and sleeps when there are none.
+		void wait(bool iterate_main_context = true);
+
+
+	private:
+
+		struct State;
+
+		std::shared_ptr<State> state_;  ///< Shared with the queued pool jobs of the group
+
+};
+
+
+
+/// Run \c task on the worker pool, without waiting for it. It must report its results
+/// itself (e.g. with g_main_context_invoke()). The task must not throw.
+void app_post_worker_task(std::function<void()> task);
+
+
+
+/// Run \c task(i) for each i in [0, task_count) on the worker pool, no more than \c max_threads
+/// at the same time. The calling thread keeps iterating its own thread-default main context
+/// until all the tasks are finished, so the GUI stays responsive (see AppTaskGroup::wait()).
+/// If \c max_threads is 1 or less (or there is only one task), the tasks are run
+/// directly in the calling thread.
+/// The tasks must not throw.
+void app_run_worker_tasks(std::size_t task_count, std::size_t max_threads,
+		const std::function<void(std::size_t task_index)>& task);
+
+
+
+/// Split [0, count) into up to std::thread::hardware_concurrency() ranges of at least
+/// \c min_range_size elements each, and run \c task(begin, end) for them in parallel.
+/// The calling thread runs one of the ranges (and the others too if the pool is busy).
+/// Unlike app_run_worker_tasks(), the calling thread's main context is not iterated,
+/// so this is meant for CPU-only work which doesn't touch the GUI.
+/// If \c count is less than 2 * min_range_size, \c task(0, count) is run directly.
+/// The tasks must not throw.
+void app_run_parallel_ranges(std::size_t count, std::size_t min_range_size,
+		const std::function<void(std::size_t begin, std::size_t end)>& task);
+
+
+
+#endif
+
+/// @}
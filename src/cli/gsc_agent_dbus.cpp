@@ -0,0 +1,323 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "hz/debug.h"
+#include "applib/smartctl_executor.h"
+#include "applib/storage_device_json.h"
+#include "applib/storage_privileged_helper.h"
+#include "applib/storage_property_diff.h"
+#include "applib/worker_threads.h"
+
+#include "gsc_agent_dbus.h"
+
+
+
+namespace {
+
+	/// Introspection data of the service
+	constexpr const char* agent_dbus_introspection_xml =
+		"<node>"
+		"  <interface name='org.gsmartcontrol.Agent1'>"
+		"    <method name='GetDrives'>"
+		"      <arg type='a(tss)' name='drives' direction='out'/>"  // (drive_id, device, type_argument)
+		"    </method>"
+		"    <method name='GetDrive'>"
+		"      <arg type='t' name='drive_id' direction='in'/>"
+		"      <arg type='s' name='json' direction='out'/>"
+		"    </method>"
+		"    <method name='GetAllDrives'>"
+		"      <arg type='s' name='json' direction='out'/>"
+		"    </method>"
+		"    <signal name='DriveChanged'>"
+		"      <arg type='t' name='drive_id'/>"
+		"      <arg type='s' name='changes_json'/>"
+		"    </signal>"
+		"    <signal name='DriveError'>"
+		"      <arg type='t' name='drive_id'/>"
+		"      <arg type='s' name='message'/>"
+		"    </signal>"
+		"  </interface>"
+		"</node>";
+
+}
+
+
+
+AgentDbusService::AgentDbusService(std::vector<StorageDevicePtr> drives)
+		: drives_(std::move(drives)), published_errors_(drives_.size()), published_times_(drives_.size()),
+		published_json_(drives_.size())
+{
+	published_snapshots_.reserve(drives_.size());
+	for (std::size_t i = 0; i < drives_.size(); ++i) {
+		published_snapshots_.push_back(drives_[i]->get_snapshot());
+		if (!published_snapshots_[i]->full_output->empty()) {
+			published_times_[i] = std::chrono::steady_clock::now();
+		}
+		published_json_[i] = get_drive_json(i).dump();
+	}
+	node_info_ = g_dbus_node_info_new_for_xml(agent_dbus_introspection_xml, nullptr);
+}
+
+
+
+AgentDbusService::~AgentDbusService()
+{
+	if (registration_id_ != 0 && connection_) {
+		g_dbus_connection_unregister_object(connection_, registration_id_);
+	}
+	if (owner_id_ != 0) {
+		g_bus_unown_name(owner_id_);
+	}
+	if (node_info_) {
+		g_dbus_node_info_unref(node_info_);
+	}
+}
+
+
+
+bool AgentDbusService::start(GBusType bus_type)
+{
+	if (!node_info_ || owner_id_ != 0) {
+		return false;
+	}
+	owner_id_ = g_bus_own_name(bus_type, storage_helper_dbus_name, G_BUS_NAME_OWNER_FLAGS_NONE,
+			&AgentDbusService::on_bus_acquired, nullptr, &AgentDbusService::on_name_lost, this, nullptr);
+	return owner_id_ != 0;
+}
+
+
+
+bool AgentDbusService::get_name_lost() const
+{
+	return name_lost_;
+}
+
+
+
+void AgentDbusService::publish(const std::vector<std::string>& errors)
+{
+	for (std::size_t i = 0; i < drives_.size(); ++i) {
+		StorageDevice::SnapshotPtr snapshot = drives_[i]->get_snapshot();
+		const StoragePropertyDiff diff = storage_property_repository_diff(
+				published_snapshots_[i]->property_repository, snapshot->property_repository);
+		if (snapshot->full_output != published_snapshots_[i]->full_output && !snapshot->full_output->empty()) {
+			published_times_[i] = std::chrono::steady_clock::now();
+		}
+		std::string error = (i < errors.size() ? errors[i] : std::string());
+		// Most refreshes change nothing, keep the JSON serialized from the same data.
+		const bool json_changed = !diff.empty() || error != published_errors_[i]
+				|| snapshot->in_standby != published_snapshots_[i]->in_standby;
+		published_snapshots_[i] = std::move(snapshot);
+		published_errors_[i] = std::move(error);
+		if (json_changed) {
+			published_json_[i] = get_drive_json(i).dump();
+		}
+
+		const auto drive_id = static_cast<guint64>(i + 1);
+		if (!diff.empty()) {
+			const std::string changes = storage_property_diff_to_json(diff).dump();
+			emit_signal("DriveChanged", g_variant_new("(ts)", drive_id, changes.c_str()));
+		}
+		if (!published_errors_[i].empty()) {
+			emit_signal("DriveError", g_variant_new("(ts)", drive_id, published_errors_[i].c_str()));
+		}
+	}
+}
+
+
+
+nlohmann::json AgentDbusService::get_drive_json(std::size_t index) const
+{
+	nlohmann::json j = storage_device_to_json(*drives_[index], published_snapshots_[index]);
+	j["id"] = index + 1;
+	j["in_standby"] = published_snapshots_[index]->in_standby;
+	if (!published_errors_[index].empty()) {
+		j["error"] = published_errors_[index];
+	}
+	return j;
+}
+
+
+
+std::string AgentDbusService::get_all_drives_json_text() const
+{
+	std::size_t size = 2;
+	for (const auto& json : published_json_) {
+		size += json.size() + 1;
+	}
+	std::string text;
+	text.reserve(size);
+	text += '[';
+	for (std::size_t i = 0; i < published_json_.size(); ++i) {
+		if (i != 0) {
+			text += ',';
+		}
+		text += published_json_[i];
+	}
+	text += ']';
+	return text;
+}
+
+
+
+void AgentDbusService::execute_smartctl_async(std::string device, std::vector<std::string> options,
+		GDBusMethodInvocation* invocation)
+{
+	app_post_worker_task([device = std::move(device), options = std::move(options), invocation]() {
+		auto ex = std::make_shared<SmartctlExecutor>();
+		CommandOutputPtr output;
+		auto status = execute_smartctl(device, {}, options, ex, output);
+		const std::string error_message = status ? std::string() : status.error().message();
+		debug_out_info("app", "Executed smartctl for a D-Bus client on " << device << ": "
+				<< (status ? std::string("success") : error_message) << "\n");
+
+		// Thread-safe, the reply is sent from the connection's thread
+		g_dbus_method_invocation_return_value(invocation, g_variant_new("(bss)", gboolean(status ? TRUE : FALSE),
+				(output ? output->c_str() : ""), error_message.c_str()));
+	});
+}
+
+
+
+void AgentDbusService::emit_signal(const char* signal_name, GVariant* parameters)
+{
+	if (!connection_ || registration_id_ == 0) {
+		// Nobody can receive it yet
+		g_variant_unref(g_variant_ref_sink(parameters));
+		return;
+	}
+	GError* error = nullptr;
+	g_dbus_connection_emit_signal(connection_, nullptr, storage_helper_dbus_object_path, storage_helper_dbus_interface,
+			signal_name, parameters, &error);
+	if (error) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot emit D-Bus signal " << signal_name << ": " << error->message << "\n");
+		g_error_free(error);
+	}
+}
+
+
+
+void AgentDbusService::on_bus_acquired(GDBusConnection* connection, [[maybe_unused]] const gchar* name, gpointer user_data)
+{
+	static const GDBusInterfaceVTable vtable = { &AgentDbusService::on_method_call, nullptr, nullptr, {} };
+
+	auto* self = static_cast<AgentDbusService*>(user_data);
+	self->connection_ = connection;
+
+	GError* error = nullptr;
+	self->registration_id_ = g_dbus_connection_register_object(connection, storage_helper_dbus_object_path,
+			self->node_info_->interfaces[0], &vtable, self, nullptr, &error);
+	if (error) {
+		debug_out_error("app", DBG_FUNC_MSG << "Cannot export the D-Bus object: " << error->message << "\n");
+		g_error_free(error);
+		self->name_lost_ = true;
+	}
+}
+
+
+
+void AgentDbusService::on_name_lost(GDBusConnection* connection, const gchar* name, gpointer user_data)
+{
+	auto* self = static_cast<AgentDbusService*>(user_data);
+	if (!connection) {
+		debug_out_error("app", DBG_FUNC_MSG << "Cannot connect to D-Bus.\n");
+	} else {
+		debug_out_error("app", DBG_FUNC_MSG << "Cannot own the D-Bus name " << name << ", is another agent running?\n");
+	}
+	self->name_lost_ = true;
+}
+
+
+
+void AgentDbusService::on_method_call([[maybe_unused]] GDBusConnection* connection, [[maybe_unused]] const gchar* sender,
+		[[maybe_unused]] const gchar* object_path, [[maybe_unused]] const gchar* interface_name, const gchar* method_name,
+		GVariant* parameters, GDBusMethodInvocation* invocation, gpointer user_data)
+{
+	auto* self = static_cast<AgentDbusService*>(user_data);
+	const std::string method = method_name;
+
+	if (method == "GetDrives") {
+		GVariantBuilder builder;
+		g_variant_builder_init(&builder, G_VARIANT_TYPE("a(tss)"));
+		for (std::size_t i = 0; i < self->drives_.size(); ++i) {
+			g_variant_builder_add(&builder, "(tss)", static_cast<guint64>(i + 1),
+					self->drives_[i]->get_device().c_str(), self->drives_[i]->get_type_argument().c_str());
+		}
+		g_dbus_method_invocation_return_value(invocation, g_variant_new("(a(tss))", &builder));
+
+	} else if (method == "GetDrive") {
+		guint64 drive_id = 0;
+		g_variant_get(parameters, "(t)", &drive_id);
+		if (drive_id == 0 || drive_id > self->drives_.size()) {
+			g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+					"No drive with ID %" G_GUINT64_FORMAT, drive_id);
+			return;
+		}
+		const std::string& json = self->published_json_[static_cast<std::size_t>(drive_id - 1)];
+		g_dbus_method_invocation_return_value(invocation, g_variant_new("(s)", json.c_str()));
+
+	} else if (method == "GetAllDrives") {
+		const std::string json = self->get_all_drives_json_text();
+		g_dbus_method_invocation_return_value(invocation, g_variant_new("(s)", json.c_str()));
+
+	} else if (method == "GetDriveOutputs") {
+		guint64 drive_id = 0;
+		g_variant_get(parameters, "(t)", &drive_id);
+		if (drive_id == 0 || drive_id > self->drives_.size()) {
+			g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+					"No drive with ID %" G_GUINT64_FORMAT, drive_id);
+			return;
+		}
+		const auto index = static_cast<std::size_t>(drive_id - 1);
+		const auto& snapshot = self->published_snapshots_[index];
+		gint64 age = -1;
+		if (self->published_times_[index].has_value()) {
+			age = std::chrono::duration_cast<std::chrono::seconds>(
+					std::chrono::steady_clock::now() - self->published_times_[index].value()).count();
+		}
+		g_dbus_method_invocation_return_value(invocation, g_variant_new("(ssx)",
+				snapshot->basic_output->c_str(), snapshot->full_output->c_str(), age));
+
+	} else if (method == "ExecuteSmartctl") {
+		const gchar* device = nullptr;
+		GVariantIter* options_iter = nullptr;
+		g_variant_get(parameters, "(&sas)", &device, &options_iter);
+		std::vector<std::string> options;
+		const gchar* option = nullptr;
+		while (g_variant_iter_next(options_iter, "&s", &option)) {
+			options.emplace_back(option);
+		}
+		g_variant_iter_free(options_iter);
+
+		// The bus policy decides who may call this, we decide what may be run.
+		if (auto request_status = storage_privileged_helper_check_request(device, options); !request_status) {
+			g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+					"%s", request_status.error().message().c_str());
+			return;
+		}
+		execute_smartctl_async(device, std::move(options), invocation);
+
+	} else {
+		g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+				"Unknown method %s", method_name);
+	}
+}
+
+
+
+
+
+
+/// @}
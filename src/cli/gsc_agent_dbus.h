@@ -0,0 +1,127 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_AGENT_DBUS_H
+#define GSC_AGENT_DBUS_H
+
+#include <gio/gio.h>
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "applib/storage_device.h"
+
+
+
+/// Publishes the drive data cached by gsmartcontrol-agent on D-Bus (see storage_helper_dbus_name),
+/// so that the other tools (applets, inventory agents, the exporter) read it instead of running
+/// smartctl on the same drives themselves.
+/// The method calls are answered from the data as of the last publish(), they never
+/// touch the drives. The JSON of each drive is kept serialized and regenerated only when
+/// its data changes, so GetDrive / GetAllDrives just concatenate it. After each publish(), DriveChanged is emitted with the property
+/// differences (see storage_property_repository_diff()) of each drive which changed,
+/// and DriveError for each drive whose refresh failed.
+/// The drives are numbered from 1, in their order.
+/// Running as root, this is also the privileged helper of the unprivileged GUI (see StoragePrivilegedHelper):
+/// GetDriveOutputs returns the cached smartctl outputs, and ExecuteSmartctl runs smartctl
+/// for the GUI (the bus policy limits it to the "disk" group).
+/// This class must be used in the thread iterating the default main context.
+class AgentDbusService {
+	public:
+
+		/// Constructor. The current snapshots of the drives are published immediately.
+		explicit AgentDbusService(std::vector<StorageDevicePtr> drives);
+
+		/// Deleted
+		AgentDbusService(const AgentDbusService& other) = delete;
+
+		/// Deleted
+		AgentDbusService(AgentDbusService&& other) = delete;
+
+		/// Deleted
+		AgentDbusService& operator=(const AgentDbusService& other) = delete;
+
+		/// Deleted
+		AgentDbusService& operator=(AgentDbusService&& other) = delete;
+
+		/// Destructor, releases the bus name
+		~AgentDbusService();
+
+
+		/// Start owning the bus name on \c bus_type bus. The object is exported once the bus
+		/// is acquired, while the main context is iterated. \return false on error.
+		bool start(GBusType bus_type);
+
+		/// Check whether the bus name couldn't be acquired or was lost (e.g. another
+		/// instance is running). The service is useless then.
+		[[nodiscard]] bool get_name_lost() const;
+
+
+		/// Publish the current snapshots of the drives and emit the change signals.
+		/// \c errors contains the error message of each drive's last refresh, empty if it succeeded.
+		void publish(const std::vector<std::string>& errors);
+
+
+	private:
+
+		/// Convert the published data of a drive to JSON
+		[[nodiscard]] nlohmann::json get_drive_json(std::size_t index) const;
+
+		/// Get the JSON of all the drives as an array, joining the serialized JSON of each one
+		[[nodiscard]] std::string get_all_drives_json_text() const;
+
+		/// Start running smartctl for an ExecuteSmartctl call in a worker thread. The call
+		/// is answered from there.
+		static void execute_smartctl_async(std::string device, std::vector<std::string> options,
+				GDBusMethodInvocation* invocation);
+
+		/// Emit a signal of our interface. \c parameters is consumed if floating.
+		void emit_signal(const char* signal_name, GVariant* parameters);
+
+
+		/// Bus acquired callback, exports the object
+		static void on_bus_acquired(GDBusConnection* connection, const gchar* name, gpointer user_data);
+
+		/// Name lost (or not acquired) callback
+		static void on_name_lost(GDBusConnection* connection, const gchar* name, gpointer user_data);
+
+		/// Method call handler
+		static void on_method_call(GDBusConnection* connection, const gchar* sender,
+				const gchar* object_path, const gchar* interface_name, const gchar* method_name,
+				GVariant* parameters, GDBusMethodInvocation* invocation, gpointer user_data);
+
+
+		std::vector<StorageDevicePtr> drives_;  ///< Drives, the D-Bus drive ID is index + 1
+		std::vector<StorageDevice::SnapshotPtr> published_snapshots_;  ///< Drive snapshots as of the last publish()
+		std::vector<std::string> published_errors_;  ///< Refresh errors as of the last publish()
+		std::vector<std::optional<std::chrono::steady_clock::time_point>> published_times_;  ///< When the full data was last published, unset if never
+		std::vector<std::string> published_json_;  ///< Serialized get_drive_json() of each drive
+
+		GDBusNodeInfo* node_info_ = nullptr;  ///< Parsed introspection data
+		GDBusConnection* connection_ = nullptr;  ///< Bus connection, nullptr until acquired. Not owned.
+		guint owner_id_ = 0;  ///< g_bus_own_name() ID
+		guint registration_id_ = 0;  ///< Object registration ID, 0 if not registered
+		bool name_lost_ = false;  ///< See get_name_lost()
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,418 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+/*
+gsmartcontrol-agent is a non-GUI collection agent. It detects the drives once,
+refreshes their full SMART data periodically, keeps the processed properties
+in memory and writes a binary stream (see storage_agent_protocol.h) to stdout:
+a full snapshot of each drive first, then only the changes. The central side
+runs it over a pipe, e.g. "ssh host gsmartcontrol-agent", and decodes the stream
+with StorageAgentStreamDecoder.
+With --dbus, it publishes the drive data on D-Bus instead (see gsc_agent_dbus.h),
+so that the other local tools read it from one place instead of running smartctl
+on the same drives themselves.
+This program links only to applib_core and GIO, not to Gtk. It writes binary data to
+stdout, so it's not built in Windows.
+*/
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>  // EXIT_*
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "build_config.h"
+#include "hz/main_tools.h"
+#include "hz/string_algo.h"
+#include "libdebug/libdebug.h"
+#include "rconfig/rconfig.h"
+#include "applib/gsc_settings.h"
+#include "applib/command_executor_factory.h"
+#include "applib/storage_agent_protocol.h"
+#include "applib/storage_detector.h"
+#include "applib/storage_device.h"
+#include "applib/storage_fetch_profile.h"
+#include "applib/storage_privileged_helper.h"
+#include "applib/worker_threads.h"
+#include "gsc_agent_dbus.h"
+#include "gsc_cli_tools.h"
+
+
+
+namespace {
+
+
+	/// Set by the signal handler to stop the agent
+	volatile std::sig_atomic_t s_agent_stop_requested = 0;
+
+
+	/// SIGINT / SIGTERM handler
+	extern "C" void agent_on_stop_signal([[maybe_unused]] int sig)
+	{
+		s_agent_stop_requested = 1;
+	}
+
+
+
+	/// Command-line argument values
+	struct CmdArgs {
+		// Note: Use GLib types here:
+		gboolean arg_version = FALSE;  ///< if true, show version and exit
+		gboolean arg_scan = TRUE;  ///< if false, don't scan the system for drives
+		gboolean arg_once = FALSE;  ///< if true, refresh the drives once and exit
+		gboolean arg_dbus = FALSE;  ///< if true, publish the data on D-Bus instead of stdout
+		gchar** arg_add_device = nullptr;  ///< add these device files manually
+		gchar* arg_config = nullptr;  ///< load this config file
+		gint arg_refresh_interval = 0;  ///< refresh interval in seconds. 0 means use the config value.
+		gint arg_jobs = 0;  ///< number of drives to query simultaneously. 0 means use the config value.
+	};
+
+
+
+	/// Parse command-line arguments (fills \c args)
+	inline bool parse_cmdline_args(CmdArgs& args, int& argc, char**& argv)
+	{
+		static const std::vector<GOptionEntry> arg_entries = {
+			{ "version", 'V', 0, G_OPTION_ARG_NONE, &(args.arg_version),
+					N_("Display version information"), nullptr },
+			{ "no-scan", '\0', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &(args.arg_scan),
+					N_("Don't scan for devices, use --add-device devices only"), nullptr },
+			{ "add-device", '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &(args.arg_add_device),
+					N_("Add this device to device list. The format of the device is \"<device>::<type>::<extra_args>\", where type and extra_args are optional."
+					" You can specify this option multiple times."), nullptr },
+			{ "refresh-interval", 'i', 0, G_OPTION_ARG_INT, &(args.arg_refresh_interval),
+					N_("Refresh the data of all drives every this many seconds"), nullptr },
+			{ "jobs", 'j', 0, G_OPTION_ARG_INT, &(args.arg_jobs),
+					N_("Number of drives to query simultaneously"), nullptr },
+			{ "once", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_once),
+					N_("Refresh the drives once and exit"), nullptr },
+			{ "dbus", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_dbus),
+					N_("Publish the drive data and its changes on D-Bus instead of writing them to stdout"), nullptr },
+			{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &(args.arg_config),
+					N_("Load settings (smartctl binary, blacklist, etc.) from this GSmartControl config file"), nullptr },
+			{ nullptr, '\0', 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr }
+		};
+
+		GError* error = nullptr;
+		GOptionContext* context = g_option_context_new("- Stream SMART data changes of all drives to stdout");
+
+		// our options
+		g_option_context_add_main_entries(context, arg_entries.data(), nullptr);
+
+		// libdebug options; this will also automatically apply them
+		g_option_context_add_group(context, debug_get_option_group());
+
+		const bool parsed = static_cast<bool>(g_option_context_parse(context, &argc, &argv, &error));
+
+		if (error) {
+			std::string error_text = "\n" + Glib::ustring::compose(_("Error parsing command-line options: %1"), (error->message ? error->message : "invalid error"));
+			error_text += "\n\n";
+			g_error_free(error);
+
+			gchar* help_text = g_option_context_get_help(context, TRUE, nullptr);
+			if (help_text) {
+				error_text += help_text;
+				g_free(help_text);
+			}
+
+			std::cerr << error_text;
+		}
+		g_option_context_free(context);
+
+		return parsed;
+	}
+
+
+
+	/// Write the stream data to stdout. \return false if the receiving side is gone.
+	inline bool agent_write(const std::string& data)
+	{
+		if (data.empty()) {
+			return true;
+		}
+		return std::fwrite(data.data(), 1, data.size(), stdout) == data.size() && std::fflush(stdout) == 0;
+	}
+
+
+
+	/// Get the refresh interval from the command line or the config
+	inline std::chrono::seconds agent_get_refresh_interval(const CmdArgs& args)
+	{
+		const int config_interval = rconfig::get_data<int>("system/agent_refresh_interval_sec");
+		return std::chrono::seconds(std::max(1, args.arg_refresh_interval > 0 ? args.arg_refresh_interval : config_interval));
+	}
+
+
+
+	/// Get the number of drives to query simultaneously from the command line or the config
+	inline std::size_t agent_get_max_jobs(const CmdArgs& args)
+	{
+		const int config_jobs = rconfig::get_data<int>("system/collect_max_parallel_fetches");
+		return static_cast<std::size_t>(std::max(1, args.arg_jobs > 0 ? args.arg_jobs : config_jobs));
+	}
+
+
+
+	/// Set up the worker threads and the command limits, and create the executor factory
+	inline std::shared_ptr<CommandExecutorFactory> agent_init_execution()
+	{
+		app_set_worker_thread_count(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/worker_threads"))));
+		cmdex_set_max_running_commands(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/max_running_commands"))));
+		cmdex_set_domain_limits(cmdex_get_domain_limits());
+		cmdex_set_priority_aging(std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/command_priority_aging_sec"))));
+
+		auto ex_factory = std::make_shared<CommandExecutorFactory>();
+		ex_factory->set_pooled(true);  // each worker thread reuses the executors
+		ex_factory->set_priority(CommandPriority::BackgroundRefresh);
+		return ex_factory;
+	}
+
+
+
+	/// Detect the drives (and add the manually specified ones) and prepare them for refreshing
+	inline std::vector<StorageDevicePtr> agent_detect_drives(const CmdArgs& args,
+			const std::shared_ptr<CommandExecutorFactory>& ex_factory)
+	{
+		std::vector<StorageDevicePtr> drives;
+		if (args.arg_scan == TRUE) {
+			std::vector<std::string> blacklist_patterns;
+			hz::string_split(rconfig::get_data<std::string>("system/device_blacklist_patterns"), ';', blacklist_patterns, true);
+			StorageDetector sd;
+			sd.add_blacklist_patterns(blacklist_patterns);
+			auto detect_status = sd.detect(drives, ex_factory);
+			if (!detect_status) {
+				debug_out_error("app", "Drive detection failed: " << detect_status.error().message() << "\n");
+			}
+		}
+		for (auto&& drive : cli_get_manual_drives(args.arg_add_device)) {
+			drives.push_back(drive);
+		}
+
+		const auto fetch_profile = StorageFetchProfileExt::get_by_storable_name(
+				rconfig::get_data<std::string>("system/agent_fetch_profile"), StorageFetchProfile::Monitoring);
+		for (const auto& drive : drives) {
+			drive->set_keep_text_output(false);  // we don't send it, and it takes a lot of memory
+			drive->set_fetch_profile(fetch_profile);
+		}
+		return drives;
+	}
+
+
+
+	/// Fetch the full data from all the drives, \c max_jobs at a time. This also processes
+	/// the properties. The drives without a detected type (e.g. the manually added ones) get it
+	/// from the first fetch (see StorageDevice::fetch_all_data_and_parse()).
+	/// \return the error message of each drive, empty if its fetch succeeded.
+	inline std::vector<std::string> agent_refresh_drives(const std::vector<StorageDevicePtr>& drives,
+			const std::shared_ptr<CommandExecutorFactory>& ex_factory, std::size_t max_jobs)
+	{
+		std::vector<std::string> errors(drives.size());
+		app_run_worker_tasks(drives.size(), max_jobs, [&](std::size_t i) {
+			auto smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+			auto fetch_status = drives[i]->fetch_all_data_and_parse(smartctl_ex);
+			if (!fetch_status) {
+				errors[i] = fetch_status.error().message();
+			}
+		});
+		return errors;
+	}
+
+
+
+	/// Detect the drives and stream their data until stopped.
+	/// \return false if writing the stream failed.
+	inline bool agent_run(const CmdArgs& args)
+	{
+		const auto refresh_interval = agent_get_refresh_interval(args);
+		const std::size_t max_jobs = agent_get_max_jobs(args);
+
+		auto ex_factory = agent_init_execution();
+
+		StorageAgentStreamEncoder encoder(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/agent_snapshot_interval"))));
+		if (!agent_write(encoder.encode_start(g_get_host_name()))) {
+			return false;
+		}
+
+		const std::vector<StorageDevicePtr> drives = agent_detect_drives(args, ex_factory);
+		for (std::size_t i = 0; i < drives.size(); ++i) {
+			if (!agent_write(encoder.encode_drive(i + 1, drives[i]->get_device(), drives[i]->get_type_argument()))) {
+				return false;
+			}
+		}
+		debug_out_info("app", "Streaming " << drives.size() << " drives.\n");
+
+		while (s_agent_stop_requested == 0) {
+			const auto start_time = std::chrono::steady_clock::now();
+
+			const std::vector<std::string> errors = agent_refresh_drives(drives, ex_factory, max_jobs);
+
+			for (std::size_t i = 0; i < drives.size(); ++i) {
+				const std::string frame = errors[i].empty() ? encoder.encode_update(i + 1, drives[i]->get_property_repository())
+						: encoder.encode_error(i + 1, errors[i]);
+				if (!agent_write(frame)) {
+					return false;
+				}
+			}
+
+			if (args.arg_once == TRUE) {
+				break;
+			}
+
+			// Sleep until the next refresh, waking up for the stop requests
+			while (s_agent_stop_requested == 0 && std::chrono::steady_clock::now() - start_time < refresh_interval) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			}
+		}
+
+		const StorageAgentStreamStats& stats = encoder.get_stats();
+		debug_out_info("app", "Sent " << stats.snapshots << " snapshots and " << stats.deltas << " deltas ("
+				<< stats.unchanged << " updates without changes), " << stats.bytes << " bytes in total. Full snapshots would take "
+				<< stats.snapshot_bytes << " bytes.\n");
+
+		return true;
+	}
+
+
+
+	/// Detect the drives and publish their data on D-Bus until stopped (see AgentDbusService).
+	/// The drives are refreshed in a separate thread, so the D-Bus calls are answered
+	/// from the cache meanwhile. With --once, the data is refreshed only once, but is
+	/// still served until stopped.
+	/// \return false if the service couldn't be started.
+	inline bool agent_run_dbus(const CmdArgs& args)
+	{
+		const auto refresh_interval = agent_get_refresh_interval(args);
+		const std::size_t max_jobs = agent_get_max_jobs(args);
+		const GBusType bus_type = (rconfig::get_data<std::string>("system/agent_dbus_bus") == "session")
+				? G_BUS_TYPE_SESSION : G_BUS_TYPE_SYSTEM;
+
+		auto ex_factory = agent_init_execution();
+		const std::vector<StorageDevicePtr> drives = agent_detect_drives(args, ex_factory);
+		for (const auto& drive : drives) {
+			// The GUI loads the cached outputs as its own (see GetDriveOutputs), so they must be complete.
+			drive->set_fetch_profile(StorageFetchProfile::Full);
+		}
+
+		AgentDbusService service(drives);
+		if (!service.start(bus_type)) {
+			return false;
+		}
+		debug_out_info("app", "Publishing " << drives.size() << " drives on D-Bus as " << storage_helper_dbus_name << ".\n");
+
+		std::atomic<bool> refresher_stop = false;
+		std::mutex refreshed_mutex;
+		std::optional<std::vector<std::string>> refreshed_errors;  // refresh results not published yet
+
+		std::thread refresher([&]() {
+			// app_run_worker_tasks() iterates the thread-default context, which must not be the main thread's one.
+			GMainContext* context = g_main_context_new();
+			g_main_context_push_thread_default(context);
+
+			while (!refresher_stop) {
+				const auto start_time = std::chrono::steady_clock::now();
+				std::vector<std::string> errors = agent_refresh_drives(drives, ex_factory, max_jobs);
+				{
+					const std::lock_guard<std::mutex> lock(refreshed_mutex);
+					refreshed_errors = std::move(errors);
+				}
+				g_main_context_wakeup(nullptr);  // publish them
+
+				if (args.arg_once == TRUE) {
+					break;
+				}
+				while (!refresher_stop && std::chrono::steady_clock::now() - start_time < refresh_interval) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(200));
+				}
+			}
+
+			g_main_context_pop_thread_default(context);
+			g_main_context_unref(context);
+		});
+
+		// The stop signals don't wake up the main context, check for them periodically.
+		const guint stop_check_id = g_timeout_add(200, [](gpointer) -> gboolean { return TRUE; }, nullptr);
+
+		while (s_agent_stop_requested == 0 && !service.get_name_lost()) {
+			g_main_context_iteration(nullptr, TRUE);
+
+			std::optional<std::vector<std::string>> errors;
+			{
+				const std::lock_guard<std::mutex> lock(refreshed_mutex);
+				errors.swap(refreshed_errors);
+			}
+			if (errors.has_value()) {
+				service.publish(errors.value());
+			}
+		}
+
+		g_source_remove(stop_check_id);
+		refresher_stop = true;
+		refresher.join();  // waits for the running refresh to finish
+
+		return !service.get_name_lost();
+	}
+
+
+}
+
+
+
+/// Application main function
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([&argc, &argv]()
+	{
+		CmdArgs args;
+		if (!parse_cmdline_args(args, argc, argv)) {
+			return EXIT_FAILURE;
+		}
+
+		if (args.arg_version == TRUE) {
+			std::cout << Glib::ustring::compose(_("GSmartControl version %1"), BuildEnv::package_version()) << "\n";
+			return EXIT_SUCCESS;
+		}
+
+		// register libdebug domains
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		if (!cli_init_config(args.arg_config)) {
+			return EXIT_FAILURE;
+		}
+
+		std::signal(SIGINT, &agent_on_stop_signal);
+		std::signal(SIGTERM, &agent_on_stop_signal);
+
+		if (args.arg_dbus == TRUE) {
+			return agent_run_dbus(args) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		return agent_run(args) ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,112 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_CLI_TOOLS_H
+#define GSC_CLI_TOOLS_H
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "build_config.h"
+#include "hz/fs.h"
+#include "hz/string_algo.h"
+#include "hz/debug.h"
+#include "rconfig/rconfig.h"
+#include "rconfig/loadsave.h"
+#include "applib/gsc_settings.h"
+#include "applib/storage_device.h"
+#include "applib/storage_property_warning_rules.h"
+
+
+/**
+\file
+Helpers shared by the command-line programs (gsmartcontrol-agent, gsmartcontrol-collect, gsmartcontrol-exporter, gsmartcontrol-reprocess,
+gsmartcontrol-scan-latency, gsmartcontrol-selftest).
+*/
+
+
+
+/// Load the global config file and the one specified on command line (if any).
+/// Unlike the GUI, the command-line programs never write the config.
+inline bool cli_init_config(const gchar* config_file)
+{
+	hz::fs::path global_config_file;
+	if constexpr(BuildEnv::is_kernel_family_windows()) {
+		global_config_file = hz::fs_path_from_string("gsmartcontrol2.conf");  // CWD, installation dir by default.
+	} else {
+		global_config_file = hz::fs_path_from_string(BuildEnv::package_sysconf_dir()) / "gsmartcontrol2.conf";
+	}
+
+	std::error_code ec;
+	if (hz::fs::exists(global_config_file, ec) && hz::fs_path_is_readable(global_config_file, ec)) {
+		rconfig::load_from_file(global_config_file);
+	}
+
+	if (config_file) {
+		const hz::fs::path file = hz::fs_path_from_string(config_file);
+		if (!rconfig::load_from_file(file)) {
+			std::cerr << Glib::ustring::compose(_("Cannot load config file \"%1\"."), config_file) << "\n";
+			return false;
+		}
+	}
+
+	init_default_settings();  // initialize /default
+
+	storage_warning_rules_init_global(hz::fs_path_from_string(rconfig::get_data<std::string>("system/warning_rules_file")));
+	return true;
+}
+
+
+
+/// Convert the command-line --add-device values to drives
+inline std::vector<StorageDevicePtr> cli_get_manual_drives(gchar** add_device)
+{
+	std::vector<StorageDevicePtr> drives;
+	for (gchar** entry = add_device; entry && *entry; ++entry) {
+		std::vector<std::string> parts;
+		hz::string_split(std::string(*entry), "::", parts, false);
+		const std::string file = (!parts.empty() ? parts.at(0) : std::string());
+		if (file.empty()) {
+			continue;
+		}
+		const std::string extra_args_str = (parts.size() > 2 ? parts.at(2) : std::string());
+		std::vector<std::string> extra_args;
+		if (!extra_args_str.empty()) {
+			try {
+				extra_args = Glib::shell_parse_argv(extra_args_str);
+			}
+			catch(Glib::ShellError& e)
+			{
+				debug_out_warn("app", "Cannot parse extra arguments of device \"" << file << "\": " << std::string(e.what()) << "\n");
+			}
+		}
+
+		auto drive = std::make_shared<StorageDevice>(file);
+		drive->set_type_argument(parts.size() > 1 ? parts.at(1) : std::string());
+		drive->set_extra_arguments(extra_args);
+		drive->set_is_manually_added(true);
+		drives.push_back(drive);
+	}
+	return drives;
+}
+
+
+
+
+
+#endif
+
+/// @}
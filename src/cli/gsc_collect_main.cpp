@@ -0,0 +1,373 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+/*
+gsmartcontrol-collect is a non-GUI batch collector. It detects all drives,
+fetches full SMART data from them in parallel, processes the properties
+the same way the GUI does, and prints one JSON document for this host.
+With --csv-dir, it writes the attribute values (and optionally the SMART
+history) as CSV tables for bulk analytics instead. With --report, it streams
+a JSON or HTML report to a file, writing each drive as soon as it's fetched.
+With --inventory, the drives listed in an inventory file (written with
+--save-inventory) are queried without the detection pass.
+It replaces the contrib/cron-based_noadmin scripts for monitoring purposes.
+This program links only to applib_core, not to Gtk.
+*/
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>  // EXIT_*
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "build_config.h"
+#include "hz/fs.h"
+#include "hz/main_tools.h"
+#include "hz/string_algo.h"
+#include "libdebug/libdebug.h"
+#include "rconfig/rconfig.h"
+#include "applib/gsc_settings.h"
+#include "applib/command_executor_factory.h"
+#include "applib/command_executor_stats.h"
+#include "applib/storage_columnar_export.h"
+#include "applib/storage_detector.h"
+#include "applib/storage_inventory.h"
+#include "applib/storage_device.h"
+#include "applib/storage_device_json.h"
+#include "applib/storage_history.h"
+#include "applib/storage_report_writer.h"
+#include "applib/worker_threads.h"
+#include "gsc_cli_tools.h"
+
+
+
+namespace {
+
+
+	/// Version of the output document format
+	constexpr int collect_format_version = 1;
+
+
+
+	/// Command-line argument values
+	struct CmdArgs {
+		// Note: Use GLib types here:
+		gboolean arg_version = FALSE;  ///< if true, show version and exit
+		gboolean arg_scan = TRUE;  ///< if false, don't scan the system for drives
+		gboolean arg_pretty = FALSE;  ///< if true, indent the output
+		gboolean arg_exec_stats = FALSE;  ///< if true, print command execution statistics to stderr
+		gchar** arg_add_device = nullptr;  ///< add these device files manually
+		gchar* arg_inventory = nullptr;  ///< query the drives listed in this inventory file instead of scanning
+		gchar* arg_save_inventory = nullptr;  ///< write the inventory of the queried drives to this file
+		gchar* arg_config = nullptr;  ///< load this config file
+		gchar* arg_csv_dir = nullptr;  ///< write the CSV tables to this directory instead of JSON
+		gboolean arg_history = FALSE;  ///< if true, add the SMART history to the CSV tables
+		gchar* arg_report = nullptr;  ///< stream a JSON or HTML report to this file instead
+		gint arg_jobs = 0;  ///< number of drives to query simultaneously. 0 means use the config value.
+	};
+
+
+
+	/// Parse command-line arguments (fills \c args)
+	inline bool parse_cmdline_args(CmdArgs& args, int& argc, char**& argv)
+	{
+		static const std::vector<GOptionEntry> arg_entries = {
+			{ "version", 'V', 0, G_OPTION_ARG_NONE, &(args.arg_version),
+					N_("Display version information"), nullptr },
+			{ "no-scan", '\0', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &(args.arg_scan),
+					N_("Don't scan for devices, use --add-device devices only"), nullptr },
+			{ "add-device", '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &(args.arg_add_device),
+					N_("Add this device to device list. The format of the device is \"<device>::<type>::<extra_args>\", where type and extra_args are optional."
+					" You can specify this option multiple times."), nullptr },
+			{ "inventory", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_inventory),
+					N_("Query the drives listed in this inventory file instead of scanning for them"), nullptr },
+			{ "save-inventory", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_save_inventory),
+					N_("Write the list of the queried drives to this inventory file, to be used with --inventory later"), nullptr },
+			{ "jobs", 'j', 0, G_OPTION_ARG_INT, &(args.arg_jobs),
+					N_("Number of drives to query simultaneously"), nullptr },
+			{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &(args.arg_config),
+					N_("Load settings (smartctl binary, blacklist, etc.) from this GSmartControl config file"), nullptr },
+			{ "pretty", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_pretty),
+					N_("Indent the JSON output"), nullptr },
+			{ "exec-stats", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_exec_stats),
+					N_("Print command execution time statistics (per device and per command) to stderr"), nullptr },
+			{ "csv-dir", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_csv_dir),
+					N_("Instead of JSON, write the attribute values to values.csv, drives.csv and models.csv in this directory"), nullptr },
+			{ "history", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_history),
+					N_("With --csv-dir, also write the values recorded in the SMART history of this user"), nullptr },
+			{ "report", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_report),
+					N_("Instead of printing JSON, write a report to this file as the drives are fetched. The format (JSON or HTML) is chosen by the file extension."), nullptr },
+			{ nullptr, '\0', 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr }
+		};
+
+		GError* error = nullptr;
+		GOptionContext* context = g_option_context_new("- Collect SMART data from all drives as JSON");
+
+		// our options
+		g_option_context_add_main_entries(context, arg_entries.data(), nullptr);
+
+		// libdebug options; this will also automatically apply them
+		g_option_context_add_group(context, debug_get_option_group());
+
+		const bool parsed = static_cast<bool>(g_option_context_parse(context, &argc, &argv, &error));
+
+		if (error) {
+			std::string error_text = "\n" + Glib::ustring::compose(_("Error parsing command-line options: %1"), (error->message ? error->message : "invalid error"));
+			error_text += "\n\n";
+			g_error_free(error);
+
+			gchar* help_text = g_option_context_get_help(context, TRUE, nullptr);
+			if (help_text) {
+				error_text += help_text;
+				g_free(help_text);
+			}
+
+			std::cerr << error_text;
+		}
+		g_option_context_free(context);
+
+		return parsed;
+	}
+
+
+
+	/// Write the current values of the drives (and the history, if requested) as CSV tables.
+	inline bool collect_write_csv(const CmdArgs& args, const std::vector<StorageDevicePtr>& drives, std::int64_t time)
+	{
+		const hz::fs::path dir = hz::fs_path_from_string(args.arg_csv_dir);
+		std::error_code ec;
+		hz::fs::create_directories(dir, ec);
+
+		std::ofstream values(dir / "values.csv", std::ios::binary);
+		std::ofstream drives_table(dir / "drives.csv", std::ios::binary);
+		std::ofstream models(dir / "models.csv", std::ios::binary);
+		if (!values || !drives_table || !models) {
+			std::cerr << Glib::ustring::compose(_("Cannot create CSV files in \"%1\"."), hz::fs_path_to_string(dir)) << std::endl;
+			return false;
+		}
+
+		StorageColumnarExport csv(values, drives_table, models);
+		for (const auto& drive : drives) {
+			csv.add_drive(*drive, time);
+		}
+		if (args.arg_history == TRUE) {
+			StorageHistory history(StorageHistory::get_default_file());
+			if (auto open_ec = history.open()) {
+				std::cerr << Glib::ustring::compose(_("Cannot read SMART history: %1"), open_ec.message()) << std::endl;
+				return false;
+			}
+			csv.add_history(history);
+		}
+
+		values.flush();
+		drives_table.flush();
+		models.flush();
+		if (!values || !drives_table || !models) {
+			std::cerr << Glib::ustring::compose(_("Cannot write CSV files in \"%1\"."), hz::fs_path_to_string(dir)) << std::endl;
+			return false;
+		}
+		debug_out_info("app", "Wrote " << csv.get_row_count() << " CSV rows.\n");
+		return true;
+	}
+
+
+
+	/// Fetch the drives and stream them to the report file. Only the drives being
+	/// fetched are kept in memory. \c doc contains the header values.
+	inline bool collect_write_report(const CmdArgs& args, std::vector<StorageDevicePtr> drives,
+			const CommandExecutorFactoryPtr& ex_factory, std::size_t max_jobs, const nlohmann::json& doc)
+	{
+		if (doc.contains("detection_error")) {
+			std::cerr << "Drive detection error: " << doc["detection_error"].get<std::string>() << std::endl;
+		}
+		const std::string filename = args.arg_report;
+		StorageReportFormat format = StorageReportFormat::Json;
+		if (!StorageReportWriter::get_format_for_file(filename, format)) {
+			std::cerr << "Cannot determine the report format of \"" << filename << "\", use a .json or .html extension." << std::endl;
+			return false;
+		}
+		std::ofstream file(hz::fs_path_from_string(filename), std::ios::binary);
+		if (!file) {
+			std::cerr << "Cannot open \"" << filename << "\" for writing." << std::endl;
+			return false;
+		}
+
+		const auto start_time = std::chrono::steady_clock::now();
+		StorageReportWriter writer(file, format);
+		writer.begin(doc["host"].get<std::string>(), doc["time"].get<std::int64_t>());
+		const bool fetch_ok = storage_report_fetch_and_write(writer, std::move(drives), ex_factory, max_jobs);
+		const auto elapsed = std::chrono::steady_clock::now() - start_time;
+		writer.end(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+
+		const bool write_ok = writer.get_ok();
+		if (!write_ok) {
+			std::cerr << "Error writing \"" << filename << "\"." << std::endl;
+		}
+		debug_out_info("app", "Wrote " << writer.get_drive_count() << " drives to the report.\n");
+		if (args.arg_exec_stats == TRUE) {
+			std::cerr << cmdex_stats_format(cmdex_stats_get());
+		}
+		return fetch_ok && write_ok;
+	}
+
+
+
+	/// Detect the drives, fetch and process their data, and print the result.
+	inline bool collect_run(const CmdArgs& args)
+	{
+		const auto start_time = std::chrono::system_clock::now();
+
+		std::vector<std::string> blacklist_patterns;
+		hz::string_split(rconfig::get_data<std::string>("system/device_blacklist_patterns"), ';', blacklist_patterns, true);
+
+		const int config_jobs = rconfig::get_data<int>("system/collect_max_parallel_fetches");
+		const auto max_jobs = static_cast<std::size_t>(std::max(1, args.arg_jobs > 0 ? args.arg_jobs : config_jobs));
+
+		app_set_worker_thread_count(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/worker_threads"))));
+		cmdex_set_max_running_commands(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/max_running_commands"))));
+		cmdex_set_domain_limits(cmdex_get_domain_limits());
+		cmdex_set_priority_aging(std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/command_priority_aging_sec"))));
+
+		auto ex_factory = std::make_shared<CommandExecutorFactory>();
+		ex_factory->set_pooled(true);  // each worker thread reuses the executors
+		ex_factory->set_priority(CommandPriority::Bulk);
+
+		nlohmann::json doc;
+		doc["format_version"] = collect_format_version;
+		doc["program_version"] = BuildEnv::package_version();
+		doc["host"] = g_get_host_name();
+		doc["time"] = std::chrono::duration_cast<std::chrono::seconds>(start_time.time_since_epoch()).count();
+
+		std::vector<StorageDevicePtr> drives;
+		if (args.arg_inventory != nullptr) {
+			auto entries = storage_inventory_load(hz::fs_path_from_string(args.arg_inventory));
+			if (!entries) {
+				std::cerr << "Cannot load drive inventory: " << entries.error().message() << std::endl;
+				return false;
+			}
+			drives = storage_inventory_create_drives(entries.value());
+
+		} else if (args.arg_scan == TRUE) {
+			StorageDetector sd;
+			sd.add_blacklist_patterns(blacklist_patterns);
+			auto detect_status = sd.detect(drives, ex_factory);
+			if (!detect_status) {
+				doc["detection_error"] = detect_status.error().message();
+			}
+		}
+		for (auto&& drive : cli_get_manual_drives(args.arg_add_device)) {
+			drives.push_back(drive);
+		}
+		for (auto& drive : drives) {
+			drive->set_keep_text_output(false);  // we don't output it, and it takes a lot of memory
+		}
+
+		if (args.arg_save_inventory != nullptr) {
+			if (auto save_status = storage_inventory_save(hz::fs_path_from_string(args.arg_save_inventory),
+					storage_inventory_get_entries(drives)); !save_status) {
+				std::cerr << "Cannot save drive inventory: " << save_status.error().message() << std::endl;
+				return false;
+			}
+		}
+
+		if (args.arg_report != nullptr) {
+			return collect_write_report(args, std::move(drives), ex_factory, max_jobs, doc);
+		}
+
+		// Fetch the full data from all the drives. This also processes the properties.
+		// The type of the manually added drives (and the inventory ones) is not known yet,
+		// fetch_all_data_and_parse() detects it from the same smartctl run.
+		std::vector<std::string> errors(drives.size());
+		app_run_worker_tasks(drives.size(), max_jobs, [&](std::size_t i) {
+			auto smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+			auto fetch_status = drives[i]->fetch_all_data_and_parse(smartctl_ex);
+			if (!fetch_status) {
+				errors[i] = fetch_status.error().message();
+			}
+		});
+
+		if (args.arg_csv_dir != nullptr) {
+			const bool csv_ok = collect_write_csv(args, drives, doc["time"].get<std::int64_t>());
+			if (args.arg_exec_stats == TRUE) {
+				std::cerr << cmdex_stats_format(cmdex_stats_get());
+			}
+			return csv_ok && std::all_of(errors.begin(), errors.end(), [](const std::string& e) { return e.empty(); });
+		}
+
+		nlohmann::json& drives_json = doc["drives"];
+		drives_json = nlohmann::json::array();
+		bool all_ok = true;
+		for (std::size_t i = 0; i < drives.size(); ++i) {
+			nlohmann::json drive_json = storage_device_to_json(*drives[i]);
+			if (!errors[i].empty()) {
+				drive_json["error"] = errors[i];
+				all_ok = false;
+			}
+			drives_json.push_back(std::move(drive_json));
+		}
+
+		const auto elapsed = std::chrono::system_clock::now() - start_time;
+		doc["duration_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+
+		std::cout << doc.dump(args.arg_pretty == TRUE ? 4 : -1) << std::endl;
+
+		if (args.arg_exec_stats == TRUE) {
+			std::cerr << cmdex_stats_format(cmdex_stats_get());
+		}
+
+		return all_ok;
+	}
+
+}
+
+
+
+/// Application main function
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([&argc, &argv]()
+	{
+		CmdArgs args;
+		if (!parse_cmdline_args(args, argc, argv)) {
+			return EXIT_FAILURE;
+		}
+
+		if (args.arg_version == TRUE) {
+			std::cout << Glib::ustring::compose(_("GSmartControl version %1"), BuildEnv::package_version()) << "\n";
+			return EXIT_SUCCESS;
+		}
+
+		// register libdebug domains
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		if (!cli_init_config(args.arg_config)) {
+			return EXIT_FAILURE;
+		}
+
+		return collect_run(args) ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+
+/// @}
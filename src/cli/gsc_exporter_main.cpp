@@ -0,0 +1,739 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+/*
+gsmartcontrol-exporter is a non-GUI Prometheus / OpenMetrics exporter.
+It detects the drives once, refreshes their full SMART data on a background
+thread (each drive every refresh interval), and serves the last known values
+over HTTP at /metrics. A scrape never waits for smartctl. Drive data older
+than the staleness limit is not exported. In standby-aware mode, sleeping
+drives are not spun up; their last data is exported until it becomes stale.
+With system/exporter_ioctl_poll, the health, attributes and temperature of local
+Linux ATA and NVMe drives are refreshed with ioctls between the smartctl runs.
+The drives with the highest risk scores (see storage_risk_score()) are ranked,
+the ranking is updated with each refreshed drive only.
+The metrics of each drive are kept pre-serialized and regenerated only when its
+properties change, so a scrape just concatenates them.
+This program links only to applib_core, not to Gtk. It's not built in Windows.
+*/
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>  // EXIT_*
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "build_config.h"
+#include "hz/main_tools.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+#include "libdebug/libdebug.h"
+#include "rconfig/rconfig.h"
+#include "applib/gsc_settings.h"
+#include "applib/command_executor_factory.h"
+#include "applib/storage_alerts.h"
+#include "applib/storage_detector.h"
+#include "applib/storage_device.h"
+#include "applib/storage_fetch_profile.h"
+#include "applib/storage_metrics.h"
+#include "applib/storage_property_diff.h"
+#include "applib/storage_risk_ranking.h"
+#include "applib/worker_threads.h"
+#include "gsc_cli_tools.h"
+
+
+
+namespace {
+
+
+	/// Default listen address
+	constexpr const char* exporter_default_listen = "127.0.0.1:9633";
+
+	/// Maximum size of HTTP request headers we accept
+	constexpr std::size_t exporter_max_request_size = 8UL * 1024UL;
+
+	/// Timeout of reading a request / writing a response
+	constexpr int exporter_socket_timeout_sec = 5;
+
+
+	/// Set by the signal handler to stop the server
+	volatile std::sig_atomic_t s_exporter_stop_requested = 0;
+
+
+	/// SIGINT / SIGTERM handler
+	extern "C" void exporter_on_stop_signal([[maybe_unused]] int sig)
+	{
+		s_exporter_stop_requested = 1;
+	}
+
+
+
+	/// Command-line argument values
+	struct CmdArgs {
+		// Note: Use GLib types here:
+		gboolean arg_version = FALSE;  ///< if true, show version and exit
+		gboolean arg_scan = TRUE;  ///< if false, don't scan the system for drives
+		gchar** arg_add_device = nullptr;  ///< add these device files manually
+		gchar* arg_config = nullptr;  ///< load this config file
+		gchar* arg_listen = nullptr;  ///< listen address, [host:]port
+		gint arg_refresh_interval = 0;  ///< refresh interval in seconds. 0 means use the config value.
+		gint arg_max_age = 0;  ///< staleness limit in seconds. 0 means use the config value.
+		gint arg_jobs = 0;  ///< number of drives to query simultaneously. 0 means use the config value.
+		gboolean arg_standby_aware = FALSE;  ///< if true, don't spin up the drives in standby mode
+	};
+
+
+
+	/// Parse command-line arguments (fills \c args)
+	inline bool parse_cmdline_args(CmdArgs& args, int& argc, char**& argv)
+	{
+		static const std::vector<GOptionEntry> arg_entries = {
+			{ "version", 'V', 0, G_OPTION_ARG_NONE, &(args.arg_version),
+					N_("Display version information"), nullptr },
+			{ "listen", 'l', 0, G_OPTION_ARG_STRING, &(args.arg_listen),
+					N_("Listen on this address, in [host:]port format (default: 127.0.0.1:9633)"), nullptr },
+			{ "no-scan", '\0', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &(args.arg_scan),
+					N_("Don't scan for devices, use --add-device devices only"), nullptr },
+			{ "add-device", '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &(args.arg_add_device),
+					N_("Add this device to device list. The format of the device is \"<device>::<type>::<extra_args>\", where type and extra_args are optional."
+					" You can specify this option multiple times."), nullptr },
+			{ "refresh-interval", 'i', 0, G_OPTION_ARG_INT, &(args.arg_refresh_interval),
+					N_("Refresh the data of each drive every this many seconds"), nullptr },
+			{ "max-age", '\0', 0, G_OPTION_ARG_INT, &(args.arg_max_age),
+					N_("Don't export drive data older than this many seconds"), nullptr },
+			{ "jobs", 'j', 0, G_OPTION_ARG_INT, &(args.arg_jobs),
+					N_("Number of drives to query simultaneously"), nullptr },
+			{ "standby-aware", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_standby_aware),
+					N_("Don't spin up the drives in standby mode, keep exporting their last data"), nullptr },
+			{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &(args.arg_config),
+					N_("Load settings (smartctl binary, blacklist, etc.) from this GSmartControl config file"), nullptr },
+			{ nullptr, '\0', 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr }
+		};
+
+		GError* error = nullptr;
+		GOptionContext* context = g_option_context_new("- Export SMART data of all drives to Prometheus");
+
+		// our options
+		g_option_context_add_main_entries(context, arg_entries.data(), nullptr);
+
+		// libdebug options; this will also automatically apply them
+		g_option_context_add_group(context, debug_get_option_group());
+
+		const bool parsed = static_cast<bool>(g_option_context_parse(context, &argc, &argv, &error));
+
+		if (error) {
+			std::string error_text = "\n" + Glib::ustring::compose(_("Error parsing command-line options: %1"), (error->message ? error->message : "invalid error"));
+			error_text += "\n\n";
+			g_error_free(error);
+
+			gchar* help_text = g_option_context_get_help(context, TRUE, nullptr);
+			if (help_text) {
+				error_text += help_text;
+				g_free(help_text);
+			}
+
+			std::cerr << error_text;
+		}
+		g_option_context_free(context);
+
+		return parsed;
+	}
+
+
+
+	/// Get current time in seconds since epoch
+	inline std::int64_t exporter_get_time()
+	{
+		return std::chrono::duration_cast<std::chrono::seconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+
+
+	/// Refreshes the drive data in a background thread and keeps the last metrics of each drive.
+	class Exporter {
+		public:
+
+			/// Constructor
+			Exporter(std::vector<StorageDevicePtr> manual_drives, bool scan,
+					std::chrono::seconds refresh_interval, std::chrono::seconds max_age, std::size_t max_jobs, bool standby_aware)
+					: manual_drives_(std::move(manual_drives)), scan_(scan),
+					refresh_interval_(refresh_interval), max_age_(max_age), max_jobs_(max_jobs), standby_aware_(standby_aware)
+			{ }
+
+			/// Deleted
+			Exporter(const Exporter& other) = delete;
+
+			/// Deleted
+			Exporter(Exporter&& other) = delete;
+
+			/// Deleted
+			Exporter& operator=(const Exporter& other) = delete;
+
+			/// Deleted
+			Exporter& operator=(Exporter&& other) = delete;
+
+			/// Destructor, stops the refresh thread
+			~Exporter()
+			{
+				stop();
+			}
+
+
+			/// Start the refresh thread
+			void start()
+			{
+				thread_ = std::thread(&Exporter::refresh_thread_main, this);
+			}
+
+
+			/// Stop the refresh thread. It finishes the fetches in progress first.
+			void stop()
+			{
+				{
+					const std::scoped_lock lock(mutex_);
+					stop_requested_ = true;
+				}
+				cond_.notify_all();
+				if (thread_.joinable()) {
+					thread_.join();
+				}
+			}
+
+
+			/// Get the metrics of all the drives. This never waits for smartctl.
+			/// The pre-serialized metrics of the drives are concatenated, only the risk ranks are formatted.
+			[[nodiscard]] std::string get_metrics_text() const
+			{
+				const std::int64_t now = exporter_get_time();
+				std::vector<const StorageMetricsFamilyTexts*> parts;
+
+				const std::scoped_lock lock(mutex_);
+				parts.reserve(states_.size() * 2 + 1);
+				for (const auto& state : states_) {
+					const bool stale = (state.last_success_time == 0 || now - state.last_success_time > max_age_.count());
+					if (!stale) {
+						parts.push_back(&state.metrics_texts);
+					}
+					parts.push_back(&state.status_texts[stale ? 1 : 0]);
+				}
+
+				// The ranking is kept up to date by the refreshes, only the top drives are looked at.
+				const auto top = risk_ranking_.get_top(risk_rank_count_, 1, [&](const StorageDevice* drive) {
+					const DriveState& state = states_[state_indices_.at(drive)];
+					return state.last_success_time != 0 && now - state.last_success_time <= max_age_.count();
+				});
+				StorageMetricsWriter rank_writer;
+				for (std::size_t rank = 0; rank < top.size(); ++rank) {
+					rank_writer.add_sample("gsmartcontrol_risk_rank", states_[state_indices_.at(top[rank].drive)].labels,
+							static_cast<std::int64_t>(rank + 1));
+				}
+				const StorageMetricsFamilyTexts rank_texts = rank_writer.get_family_texts();
+				parts.push_back(&rank_texts);
+
+				return StorageMetricsWriter::join_family_texts(parts);
+			}
+
+
+		private:
+
+			/// State of a drive. The drive object itself is used by the refresh thread only.
+			struct DriveState {
+				StorageDevicePtr drive;  ///< Drive
+				StorageMetricsLabels labels;  ///< Drive labels
+				bool up = false;  ///< Whether the last refresh succeeded
+				bool in_standby = false;  ///< Whether the drive was in standby mode during the last refresh
+				std::int64_t last_success_time = 0;  ///< Time of the last successful refresh, 0 if none
+				double refresh_duration_sec = 0;  ///< Duration of the last refresh
+				std::chrono::steady_clock::time_point last_attempt;  ///< Time of the last refresh attempt
+				std::chrono::steady_clock::time_point last_full_fetch;  ///< Time of the last successful smartctl fetch
+				bool full_fetched = false;  ///< Whether a smartctl fetch succeeded (the ioctl polls need one)
+				bool attempted = false;  ///< Whether a refresh was attempted
+				StorageDevice::SnapshotPtr metrics_snapshot;  ///< Snapshot metrics_texts was generated from
+				StorageMetricsFamilyTexts metrics_texts;  ///< Metrics of the last successful refresh
+				std::array<StorageMetricsFamilyTexts, 2> status_texts;  ///< Refresh status metrics, [1] if the data is stale
+			};
+
+
+			/// Regenerate the refresh status metrics of a drive. Called with mutex_ locked.
+			void update_status_texts(DriveState& state) const
+			{
+				for (const bool stale : {false, true}) {
+					StorageMetricsWriter writer;
+					writer.add_sample("gsmartcontrol_up", state.labels, std::int64_t(state.up ? 1 : 0));
+					writer.add_sample("gsmartcontrol_data_stale", state.labels, std::int64_t(stale ? 1 : 0));
+					if (standby_aware_) {
+						writer.add_sample("gsmartcontrol_in_standby", state.labels, std::int64_t(state.in_standby ? 1 : 0));
+					}
+					if (state.last_success_time != 0) {
+						writer.add_sample("gsmartcontrol_last_refresh_success_timestamp_seconds", state.labels, state.last_success_time);
+					}
+					writer.add_sample("gsmartcontrol_refresh_duration_seconds", state.labels, state.refresh_duration_sec);
+					state.status_texts[stale ? 1 : 0] = writer.get_family_texts();
+				}
+			}
+
+
+			/// Detect the drives and refresh them periodically
+			void refresh_thread_main()
+			{
+				// Our executors (if not run in the worker threads) attach to this.
+				GMainContext* context = g_main_context_new();
+				g_main_context_push_thread_default(context);
+
+				auto ex_factory = std::make_shared<CommandExecutorFactory>();
+				ex_factory->set_pooled(true);
+				ex_factory->set_priority(CommandPriority::BackgroundRefresh);
+
+				std::vector<StorageDevicePtr> drives;
+				if (scan_) {
+					std::vector<std::string> blacklist_patterns;
+					hz::string_split(rconfig::get_data<std::string>("system/device_blacklist_patterns"), ';', blacklist_patterns, true);
+					StorageDetector sd;
+					sd.add_blacklist_patterns(blacklist_patterns);
+					auto detect_status = sd.detect(drives, ex_factory);
+					if (!detect_status) {
+						debug_out_error("app", "Drive detection failed: " << detect_status.error().message() << "\n");
+					}
+				}
+				drives.insert(drives.end(), manual_drives_.begin(), manual_drives_.end());
+
+				{
+					const std::scoped_lock lock(mutex_);
+					const auto fetch_profile = StorageFetchProfileExt::get_by_storable_name(
+							rconfig::get_data<std::string>("system/exporter_fetch_profile"), StorageFetchProfile::Monitoring);
+					ioctl_poll_ = rconfig::get_data<bool>("system/exporter_ioctl_poll");
+					full_refresh_interval_ = std::chrono::seconds(rconfig::get_data<int>("system/exporter_full_refresh_interval_sec"));
+					risk_rank_count_ = static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/exporter_risk_rank_count")));
+					alert_rules_ = storage_alert_configure(alerts_);
+					alert_delivery_ = StorageAlertDelivery::get_from_config();
+					for (const auto& drive : drives) {
+						drive->set_keep_text_output(false);
+						drive->set_fetch_profile(fetch_profile);
+						drive->set_standby_aware(standby_aware_);
+						state_indices_[drive.get()] = states_.size();
+						DriveState& state = states_.emplace_back();
+						state.drive = drive;
+						state.labels = StorageMetricsWriter::get_drive_labels(*drive);
+						update_status_texts(state);
+					}
+				}
+				debug_out_info("app", "Exporting " << drives.size() << " drives.\n");
+
+				std::unique_lock lock(mutex_);
+				while (!stop_requested_) {
+					const auto now = std::chrono::steady_clock::now();
+					std::vector<std::size_t> due;
+					for (std::size_t i = 0; i < states_.size(); ++i) {
+						if (!states_[i].attempted || now - states_[i].last_attempt >= refresh_interval_) {
+							due.push_back(i);
+						}
+					}
+
+					if (!due.empty()) {
+						lock.unlock();
+						app_run_worker_tasks(due.size(), max_jobs_, [&](std::size_t task_index) {
+							refresh_drive(due[task_index], ex_factory);
+						});
+						deliver_alerts(false);
+						lock.lock();
+						continue;
+					}
+
+					lock.unlock();
+					deliver_alerts(false);
+					lock.lock();
+					cond_.wait_for(lock, std::chrono::seconds(1), [this]() { return stop_requested_; });
+				}
+				lock.unlock();
+				deliver_alerts(true);
+
+				g_main_context_pop_thread_default(context);
+				g_main_context_unref(context);
+			}
+
+
+			/// Deliver the batch of alerts if it's due (or \c force is true). Called from the refresh thread only.
+			void deliver_alerts(bool force)
+			{
+				const auto batch = alerts_.take_batch(exporter_get_time(), force);
+				if (!batch.empty()) {
+					debug_out_info("app", "Delivering " << batch.size() << " alerts.\n");
+					storage_alert_deliver(alert_delivery_, batch, alerts_.take_dropped_count());
+				}
+			}
+
+
+			/// Refresh a drive. Called from worker threads; states_ entries are never removed.
+			void refresh_drive(std::size_t index, const CommandExecutorFactoryPtr& ex_factory)
+			{
+				StorageDevicePtr drive;
+				StorageDevice::SnapshotPtr metrics_snapshot;
+				bool try_ioctl_poll = false;
+				{
+					const std::scoped_lock lock(mutex_);
+					if (stop_requested_) {
+						return;
+					}
+					drive = states_[index].drive;
+					metrics_snapshot = states_[index].metrics_snapshot;
+					try_ioctl_poll = ioctl_poll_ && states_[index].full_fetched
+							&& std::chrono::steady_clock::now() - states_[index].last_full_fetch < full_refresh_interval_;
+				}
+
+				// The alerts are raised on the changes since the previous refresh.
+				const auto old_snapshot = drive->get_snapshot();
+				const auto start_time = std::chrono::steady_clock::now();
+
+				// Polling with ioctls is much cheaper, but it refreshes only some of the data,
+				// so smartctl is still used from time to time, and for the drives it can't handle.
+				hz::ExpectedVoid<StorageDeviceError> fetch_status;
+				bool full_fetch = true;
+				if (try_ioctl_poll) {
+					fetch_status = drive->poll_ioctl_data_and_parse();
+					full_fetch = !fetch_status;
+					if (full_fetch) {
+						debug_out_dump("app", "Cannot poll drive " << drive->get_device_with_type() << " directly, using smartctl: "
+								<< fetch_status.error().message() << "\n");
+					}
+				}
+				if (full_fetch) {
+					// The type of the manually added drives is detected by the first fetch,
+					// the later ones (with a known type) use the fetch profile.
+					auto smartctl_ex = ex_factory->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+					fetch_status = drive->fetch_all_data_and_parse(smartctl_ex);
+				}
+				const auto end_time = std::chrono::steady_clock::now();
+
+				// A sleeping drive keeps its last metrics, they become stale eventually.
+				const bool in_standby = (fetch_status && drive->get_in_standby());
+				const auto new_snapshot = drive->get_snapshot();
+				std::optional<StorageMetricsFamilyTexts> metrics_texts;  // unset if unchanged
+				std::int64_t risk_score = 0;
+				if (fetch_status && !in_standby) {
+					// Most refreshes change nothing, keep the metrics serialized from the same properties.
+					if (!metrics_snapshot || (metrics_snapshot != new_snapshot
+							&& !storage_property_repository_diff(metrics_snapshot->property_repository, new_snapshot->property_repository).empty())) {
+						StorageMetricsWriter metrics;
+						metrics.add_drive(*drive);
+						// Only this drive is scored, the ranking of the others is kept.
+						risk_score = storage_risk_score(new_snapshot->property_repository);
+						metrics.add_sample("gsmartcontrol_risk_score", StorageMetricsWriter::get_drive_labels(*drive), risk_score);
+						metrics_texts = metrics.get_family_texts();
+					}
+
+					// The first refresh has nothing to compare with, the existing problems are not alerted on.
+					if (!alert_rules_.empty() && !old_snapshot->property_repository.get_properties().empty()) {
+						const auto diff = storage_property_repository_diff(old_snapshot->property_repository,
+								drive->get_snapshot()->property_repository);
+						const std::string serial = drive->get_serial_number();
+						for (auto& event : storage_alert_evaluate(diff, alert_rules_,
+								serial.empty() ? drive->get_device_with_type() : serial, exporter_get_time())) {
+							alerts_.add(std::move(event));
+						}
+					}
+				} else {
+					debug_out_warn("app", "Cannot refresh drive " << drive->get_device_with_type() << ": " << fetch_status.error().message() << "\n");
+				}
+
+				const std::scoped_lock lock(mutex_);
+				DriveState& state = states_[index];
+				state.attempted = true;
+				state.last_attempt = end_time;
+				state.refresh_duration_sec = std::chrono::duration<double>(end_time - start_time).count();
+				state.up = static_cast<bool>(fetch_status);
+				state.in_standby = in_standby;
+				if (fetch_status && full_fetch && !in_standby) {
+					state.full_fetched = true;
+					state.last_full_fetch = end_time;
+				}
+				if (fetch_status && !in_standby) {
+					state.labels = StorageMetricsWriter::get_drive_labels(*drive);  // the serial may be known only now
+					state.last_success_time = exporter_get_time();
+					state.metrics_snapshot = new_snapshot;
+					if (metrics_texts.has_value()) {
+						state.metrics_texts = std::move(metrics_texts.value());
+						risk_ranking_.set_score(drive.get(), risk_score);
+					}
+				}
+				update_status_texts(state);
+			}
+
+
+			std::vector<StorageDevicePtr> manual_drives_;  ///< Drives specified on command line
+			bool scan_ = true;  ///< Whether to scan for drives
+			std::chrono::seconds refresh_interval_;  ///< Refresh interval of each drive
+			std::chrono::seconds max_age_;  ///< Staleness limit
+			std::size_t max_jobs_ = 1;  ///< Number of drives to refresh simultaneously
+			bool standby_aware_ = false;  ///< Whether the drives in standby mode are left alone
+			bool ioctl_poll_ = false;  ///< Whether to poll the drives with ioctls between smartctl fetches
+			std::chrono::seconds full_refresh_interval_ = {};  ///< Interval of smartctl fetches when polling with ioctls
+			std::size_t risk_rank_count_ = 0;  ///< Number of most at-risk drives to export the rank of
+			std::set<StorageAlertRule> alert_rules_;  ///< Enabled alert rules
+			StorageAlertDelivery alert_delivery_;  ///< Alert delivery settings
+			StorageAlertDispatcher alerts_;  ///< Alerts waiting for delivery (thread-safe)
+
+			mutable std::mutex mutex_;  ///< Protects the members below
+			std::condition_variable cond_;  ///< Wakes up the refresh thread on stop
+			bool stop_requested_ = false;  ///< Stop request for the refresh thread
+			std::vector<DriveState> states_;  ///< Drive states
+			std::unordered_map<const StorageDevice*, std::size_t> state_indices_;  ///< Drive -> index in states_
+			StorageRiskRanking risk_ranking_;  ///< Risk scores of the drives with successful refreshes
+
+			std::thread thread_;  ///< Refresh thread
+
+	};
+
+
+
+	/// Send all the data to a socket. \return false on error.
+	inline bool exporter_send_all(int fd, const std::string& data)
+	{
+		std::size_t sent = 0;
+		while (sent < data.size()) {
+			const ssize_t result = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+			if (result < 0 && errno == EINTR) {
+				continue;
+			}
+			if (result <= 0) {
+				return false;
+			}
+			sent += static_cast<std::size_t>(result);
+		}
+		return true;
+	}
+
+
+
+	/// Read an HTTP request from a client and respond to it
+	inline void exporter_handle_client(int fd, const Exporter& exporter)
+	{
+		timeval timeout = {};
+		timeout.tv_sec = exporter_socket_timeout_sec;
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		std::string request;
+		std::array<char, 1024> buf = {0};
+		while (request.find("\r\n\r\n") == std::string::npos && request.size() < exporter_max_request_size) {
+			const ssize_t result = ::recv(fd, buf.data(), buf.size(), 0);
+			if (result < 0 && errno == EINTR) {
+				continue;
+			}
+			if (result <= 0) {
+				break;  // a client may send just the request line and close its side
+			}
+			request.append(buf.data(), static_cast<std::size_t>(result));
+		}
+
+		// Request line: METHOD PATH VERSION
+		const std::string request_line = request.substr(0, request.find("\r\n"));
+		std::vector<std::string> parts;
+		hz::string_split(request_line, ' ', parts, true);
+		const std::string method = (!parts.empty() ? parts.at(0) : std::string());
+		std::string path = (parts.size() > 1 ? parts.at(1) : std::string());
+		path = path.substr(0, path.find('?'));
+
+		std::string status = "200 OK";
+		std::string content_type = "text/plain; charset=utf-8";
+		std::string body;
+		if (method != "GET" && method != "HEAD") {
+			status = "405 Method Not Allowed";
+			body = "Method not allowed\n";
+		} else if (path == "/metrics") {
+			body = exporter.get_metrics_text();
+			// The body is valid in both formats.
+			if (hz::string_to_lower_copy(request).find("application/openmetrics-text") != std::string::npos) {
+				content_type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+			} else {
+				content_type = "text/plain; version=0.0.4; charset=utf-8";
+			}
+		} else if (path == "/") {
+			content_type = "text/html; charset=utf-8";
+			body = "<html><head><title>GSmartControl Exporter</title></head>"
+					"<body><h1>GSmartControl Exporter</h1><p><a href=\"/metrics\">Metrics</a></p></body></html>\n";
+		} else {
+			status = "404 Not Found";
+			body = "Not found\n";
+		}
+
+		std::string response = "HTTP/1.1 " + status + "\r\n"
+				+ "Content-Type: " + content_type + "\r\n"
+				+ "Content-Length: " + hz::number_to_string_nolocale(body.size()) + "\r\n"
+				+ "Connection: close\r\n\r\n";
+		if (method != "HEAD") {
+			response += body;
+		}
+		exporter_send_all(fd, response);
+	}
+
+
+
+	/// Create a listening socket. \return -1 on error.
+	inline int exporter_create_listen_socket(const std::string& listen_address)
+	{
+		// [host:]port, host may be an IPv6 address in brackets.
+		std::string host, port = listen_address;
+		if (const auto pos = listen_address.rfind(':'); pos != std::string::npos) {
+			host = listen_address.substr(0, pos);
+			port = listen_address.substr(pos + 1);
+		}
+		if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+			host = host.substr(1, host.size() - 2);
+		}
+
+		addrinfo hints = {};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_PASSIVE;
+		addrinfo* addresses = nullptr;
+		if (const int error = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses); error != 0) {
+			std::cerr << Glib::ustring::compose(_("Invalid listen address \"%1\": %2"), listen_address, gai_strerror(error)) << "\n";
+			return -1;
+		}
+
+		int fd = -1;
+		int last_errno = 0;
+		for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+			fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+			if (fd < 0) {
+				last_errno = errno;
+				continue;
+			}
+			const int reuse = 1;
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+			if (::bind(fd, address->ai_addr, address->ai_addrlen) == 0 && ::listen(fd, 16) == 0) {
+				break;
+			}
+			last_errno = errno;
+			::close(fd);
+			fd = -1;
+		}
+		freeaddrinfo(addresses);
+
+		if (fd < 0) {
+			std::cerr << Glib::ustring::compose(_("Cannot listen on \"%1\": %2"), listen_address, std::strerror(last_errno)) << "\n";
+		}
+		return fd;
+	}
+
+
+
+	/// Serve the HTTP requests until SIGINT / SIGTERM is received
+	inline bool exporter_serve(const std::string& listen_address, const Exporter& exporter)
+	{
+		const int listen_fd = exporter_create_listen_socket(listen_address);
+		if (listen_fd < 0) {
+			return false;
+		}
+		debug_out_info("app", "Listening on " << listen_address << ".\n");
+
+		while (s_exporter_stop_requested == 0) {
+			pollfd pfd = {};
+			pfd.fd = listen_fd;
+			pfd.events = POLLIN;
+			// Wake up periodically to check the stop flag
+			if (::poll(&pfd, 1, 1000) <= 0) {
+				continue;
+			}
+			const int client_fd = ::accept(listen_fd, nullptr, nullptr);
+			if (client_fd < 0) {
+				continue;
+			}
+			exporter_handle_client(client_fd, exporter);
+			::close(client_fd);
+		}
+
+		::close(listen_fd);
+		return true;
+	}
+
+}
+
+
+
+/// Application main function
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([&argc, &argv]()
+	{
+		CmdArgs args;
+		if (!parse_cmdline_args(args, argc, argv)) {
+			return EXIT_FAILURE;
+		}
+
+		if (args.arg_version == TRUE) {
+			std::cout << Glib::ustring::compose(_("GSmartControl version %1"), BuildEnv::package_version()) << "\n";
+			return EXIT_SUCCESS;
+		}
+
+		// register libdebug domains
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		if (!cli_init_config(args.arg_config)) {
+			return EXIT_FAILURE;
+		}
+
+		app_set_worker_thread_count(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/worker_threads"))));
+		cmdex_set_max_running_commands(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/max_running_commands"))));
+		cmdex_set_domain_limits(cmdex_get_domain_limits());
+		cmdex_set_priority_aging(std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/command_priority_aging_sec"))));
+
+		const int refresh_interval = (args.arg_refresh_interval > 0 ? args.arg_refresh_interval
+				: rconfig::get_data<int>("system/exporter_refresh_interval_sec"));
+		const int max_age = (args.arg_max_age > 0 ? args.arg_max_age
+				: rconfig::get_data<int>("system/exporter_max_data_age_sec"));
+		const int jobs = (args.arg_jobs > 0 ? args.arg_jobs : rconfig::get_data<int>("system/collect_max_parallel_fetches"));
+
+		std::signal(SIGINT, &exporter_on_stop_signal);
+		std::signal(SIGTERM, &exporter_on_stop_signal);
+
+		Exporter exporter(cli_get_manual_drives(args.arg_add_device), args.arg_scan == TRUE,
+				std::chrono::seconds(std::max(1, refresh_interval)), std::chrono::seconds(std::max(1, max_age)),
+				static_cast<std::size_t>(std::max(1, jobs)),
+				args.arg_standby_aware == TRUE || rconfig::get_data<bool>("system/exporter_standby_aware"));
+		exporter.start();
+
+		const bool served = exporter_serve(args.arg_listen ? args.arg_listen : exporter_default_listen, exporter);
+		exporter.stop();
+
+		return served ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+
+/// @}
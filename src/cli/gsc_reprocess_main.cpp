@@ -0,0 +1,385 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+/*
+gsmartcontrol-reprocess is a non-GUI batch re-processor of archived smartctl
+outputs. It reads the outputs from directories and tar archives (see
+storage_virtual_import_read_sources()), detects their format and drive type,
+parses and processes them in parallel with the current drive database and
+warning rules, and writes one CSV summary row per output. With --snapshot-dir,
+the processed properties of each output are saved as property snapshots too.
+The outputs are processed in batches, and each batch is released before the
+next one is parsed, so the memory use doesn't grow with the archive size
+(except for the compressed ".tar.gz" archives, which are decompressed in memory
+as a whole). The progress and throughput are reported to stderr.
+This program links only to applib_core, not to Gtk.
+*/
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>  // EXIT_*
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "build_config.h"
+#include "hz/format_unit.h"
+#include "hz/fs.h"
+#include "hz/main_tools.h"
+#include "libdebug/libdebug.h"
+#include "rconfig/rconfig.h"
+#include "applib/gsc_settings.h"
+#include "applib/storage_columnar_export.h"
+#include "applib/storage_device.h"
+#include "applib/storage_device_detected_type.h"
+#include "applib/storage_device_json.h"
+#include "applib/storage_output_compression.h"
+#include "applib/storage_property_snapshot.h"
+#include "applib/storage_virtual_import.h"
+#include "applib/worker_threads.h"
+#include "gsc_cli_tools.h"
+
+
+
+namespace {
+
+
+	/// Maximum decompressed size of an output
+	constexpr std::uintmax_t max_output_size = 10*1024*1024;  // 10M
+
+	/// Minimum interval between the progress reports
+	constexpr auto progress_interval = std::chrono::seconds(1);
+
+
+
+	/// Command-line argument values
+	struct CmdArgs {
+		// Note: Use GLib types here:
+		gboolean arg_version = FALSE;  ///< if true, show version and exit
+		gchar* arg_config = nullptr;  ///< load this config file
+		gchar* arg_output = nullptr;  ///< write the summary CSV to this file instead of stdout
+		gchar* arg_snapshot_dir = nullptr;  ///< write the property snapshots to this directory
+		gint arg_batch_size = 256;  ///< number of outputs kept in memory at once
+		gboolean arg_quiet = FALSE;  ///< if true, don't report the progress
+		gchar** arg_paths = nullptr;  ///< directories and archives to process
+	};
+
+
+
+	/// Parse command-line arguments (fills \c args)
+	inline bool parse_cmdline_args(CmdArgs& args, int& argc, char**& argv)
+	{
+		static const std::vector<GOptionEntry> arg_entries = {
+			{ "version", 'V', 0, G_OPTION_ARG_NONE, &(args.arg_version),
+					N_("Display version information"), nullptr },
+			{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &(args.arg_config),
+					N_("Load settings (warning rules file, etc.) from this GSmartControl config file"), nullptr },
+			{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &(args.arg_output),
+					N_("Write the summary CSV to this file instead of stdout"), nullptr },
+			{ "snapshot-dir", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_snapshot_dir),
+					N_("Also write the processed properties of each output as a property snapshot to this directory"), nullptr },
+			{ "batch-size", '\0', 0, G_OPTION_ARG_INT, &(args.arg_batch_size),
+					N_("Number of outputs parsed (and kept in memory) at once (default 256)"), nullptr },
+			{ "quiet", 'q', 0, G_OPTION_ARG_NONE, &(args.arg_quiet),
+					N_("Don't report the progress to stderr"), nullptr },
+			{ G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &(args.arg_paths),
+					nullptr, N_("DIRECTORY_OR_ARCHIVE...") },
+			{ nullptr, '\0', 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr }
+		};
+
+		GError* error = nullptr;
+		GOptionContext* context = g_option_context_new("- Re-process archived smartctl outputs with the current drive database and warning rules");
+
+		// our options
+		g_option_context_add_main_entries(context, arg_entries.data(), nullptr);
+
+		// libdebug options; this will also automatically apply them
+		g_option_context_add_group(context, debug_get_option_group());
+
+		const bool parsed = static_cast<bool>(g_option_context_parse(context, &argc, &argv, &error));
+
+		if (error) {
+			std::string error_text = "\n" + Glib::ustring::compose(_("Error parsing command-line options: %1"), (error->message ? error->message : "invalid error"));
+			error_text += "\n\n";
+			g_error_free(error);
+
+			gchar* help_text = g_option_context_get_help(context, TRUE, nullptr);
+			if (help_text) {
+				error_text += help_text;
+				g_free(help_text);
+			}
+
+			std::cerr << error_text;
+		}
+		g_option_context_free(context);
+
+		return parsed;
+	}
+
+
+
+	/// A source name usable as a file name
+	std::string get_snapshot_file_name(std::size_t index, const std::string& source_name)
+	{
+		std::string name = source_name;
+		std::replace_if(name.begin(), name.end(), [](char c) { return c == '/' || c == '\\' || c == ':'; }, '_');
+		return std::to_string(index) + "_" + name + ".snapshot";
+	}
+
+
+
+	/// Reports the progress and throughput to stderr
+	class ReprocessProgress {
+		public:
+
+			/// Add the processed outputs. The report is written at most once per progress_interval, unless \c force is true.
+			void add(std::size_t outputs, std::size_t errors, std::uintmax_t bytes, bool force)
+			{
+				outputs_ += outputs;
+				errors_ += errors;
+				bytes_ += bytes;
+
+				const auto now = std::chrono::steady_clock::now();
+				if (!force && now - last_report_ < progress_interval) {
+					return;
+				}
+				last_report_ = now;
+
+				const double elapsed = std::max(std::chrono::duration<double>(now - start_).count(), 0.001);
+				std::cerr << "Processed " << outputs_ << " outputs (" << errors_ << " errors, "
+						<< hz::format_size(bytes_, true) << ") in " << std::fixed << std::setprecision(1) << elapsed << " s: "
+						<< static_cast<std::uintmax_t>(static_cast<double>(outputs_) / elapsed) << " outputs/s, "
+						<< hz::format_size(static_cast<std::uint64_t>(static_cast<double>(bytes_) / elapsed), true) << "/s\n";
+			}
+
+
+		private:
+
+			std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();  ///< Start time
+			std::chrono::steady_clock::time_point last_report_ = start_;  ///< Time of the last report
+			std::size_t outputs_ = 0;  ///< Processed outputs
+			std::size_t errors_ = 0;  ///< Outputs which couldn't be processed
+			std::uintmax_t bytes_ = 0;  ///< Processed data size (decompressed)
+
+	};
+
+
+
+	/// Parse result of a source
+	struct ReprocessResult {
+		StorageDevicePtr drive;  ///< Parsed drive, nullptr on error
+		std::string error;  ///< Error message
+		std::uintmax_t size = 0;  ///< Decompressed output size
+	};
+
+
+
+	/// Decompress and parse a source, releasing its data
+	ReprocessResult reprocess_source(VirtualDriveSource& source)
+	{
+		ReprocessResult result;
+		auto output = storage_output_decompress(source.data, max_output_size);
+		source.data = {};
+		source.storage.reset();  // unmap the file as soon as possible
+		if (!output) {
+			result.error = output.error().message();
+			return result;
+		}
+		result.size = output->size();
+
+		// This detects the format and the drive type, parses the output and processes the properties
+		auto drive = std::make_shared<StorageDevice>(source.name, true);
+		drive->set_keep_text_output(false);  // we don't output it
+		drive->set_virtual_output(std::move(output.value()));
+		if (auto parse_status = drive->parse_any_data_for_virtual(); !parse_status) {
+			result.error = parse_status.error().message();
+			return result;
+		}
+		result.drive = std::move(drive);
+		return result;
+	}
+
+
+
+	/// Write the summary CSV row of a source
+	void write_summary_row(std::ostream& os, const std::string& source_name, const ReprocessResult& result)
+	{
+		using Q = StorageColumnarExport;
+		os << Q::quote(source_name) << ',';
+		if (!result.drive) {
+			os << ",,,,,,," << Q::quote(result.error) << '\n';
+			return;
+		}
+		const StorageDevice& drive = *result.drive;
+		const auto& summary = drive.get_property_repository().get_warning_summary();
+		os << Q::quote(StorageDeviceDetectedTypeExt::get_storable_name(drive.get_detected_type())) << ','
+				<< Q::quote(drive.get_model_name()) << ','
+				<< Q::quote(drive.get_serial_number()) << ','
+				<< (drive.get_parse_status() == StorageDevice::ParseStatus::Full ? "full" : "basic") << ','
+				<< warning_level_get_storable_name(drive.get_health_property().warning_level) << ','
+				<< warning_level_get_storable_name(summary.max_level) << ','
+				<< summary.get_warning_count() << ','
+				<< Q::quote(summary.top_reasons.empty() ? std::string() : summary.top_reasons.front()) << '\n';
+	}
+
+
+
+	/// Re-process the outputs and write the results
+	inline bool reprocess_run(const CmdArgs& args)
+	{
+		std::vector<hz::fs::path> paths;
+		for (gchar** entry = args.arg_paths; entry && *entry; ++entry) {
+			paths.push_back(hz::fs_path_from_string(*entry));
+		}
+		if (paths.empty()) {
+			std::cerr << "No directories or archives to process specified.\n";
+			return false;
+		}
+
+		std::ofstream output_file;
+		if (args.arg_output != nullptr) {
+			output_file.open(hz::fs_path_from_string(args.arg_output), std::ios::binary);
+			if (!output_file) {
+				std::cerr << "Cannot open output file \"" << args.arg_output << "\".\n";
+				return false;
+			}
+		}
+		std::ostream& os = (args.arg_output != nullptr ? output_file : std::cout);
+
+		hz::fs::path snapshot_dir;
+		if (args.arg_snapshot_dir != nullptr) {
+			snapshot_dir = hz::fs_path_from_string(args.arg_snapshot_dir);
+			std::error_code ec;
+			hz::fs::create_directories(snapshot_dir, ec);
+			if (ec) {
+				std::cerr << "Cannot create snapshot directory \"" << args.arg_snapshot_dir << "\": " << ec.message() << "\n";
+				return false;
+			}
+		}
+
+		app_set_worker_thread_count(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/worker_threads"))));
+
+		const auto batch_size = static_cast<std::size_t>(std::max(1, args.arg_batch_size));
+		const bool report_progress = (args.arg_quiet == FALSE);
+
+		os << "source,type,model,serial,parse_status,health_warning,warning_level,warning_count,reason_or_error\n";
+
+		ReprocessProgress progress;
+		std::size_t source_index = 0;
+		bool all_ok = true;
+
+		for (const auto& path : paths) {
+			std::vector<std::string> read_errors;
+			auto sources = storage_virtual_import_read_sources(path, read_errors);
+			if (!sources) {
+				std::cerr << "Cannot read \"" << hz::fs_path_to_string(path) << "\": " << sources.error().message() << "\n";
+				all_ok = false;
+				continue;
+			}
+			for (const auto& error : read_errors) {
+				std::cerr << "Cannot read " << error << "\n";
+				all_ok = false;
+			}
+
+			for (std::size_t batch_begin = 0; batch_begin < sources->size(); batch_begin += batch_size) {
+				const std::size_t batch_end = std::min(batch_begin + batch_size, sources->size());
+
+				// Parsing is CPU-only, and each drive is used by one thread only
+				std::vector<ReprocessResult> results(batch_end - batch_begin);
+				app_run_parallel_ranges(results.size(), 4, [&](std::size_t begin, std::size_t end) {
+					for (std::size_t i = begin; i < end; ++i) {
+						results[i] = reprocess_source((*sources)[batch_begin + i]);
+						if (results[i].drive && !snapshot_dir.empty()) {
+							const auto file = snapshot_dir / hz::fs_path_from_string(
+									get_snapshot_file_name(source_index + i, (*sources)[batch_begin + i].name));
+							if (auto ec = hz::fs_file_put_contents(file,
+									storage_property_snapshot_save(results[i].drive->get_property_repository()))) {
+								results[i].error = "Cannot write snapshot: " + ec.message();
+							}
+						}
+					}
+				});
+
+				std::size_t error_count = 0;
+				std::uintmax_t bytes = 0;
+				for (std::size_t i = 0; i < results.size(); ++i) {
+					write_summary_row(os, (*sources)[batch_begin + i].name, results[i]);
+					if (!results[i].error.empty()) {
+						++error_count;
+					}
+					bytes += results[i].size;
+				}
+				all_ok = all_ok && error_count == 0;
+				source_index += results.size();
+
+				if (report_progress) {
+					progress.add(results.size(), error_count, bytes, false);
+				}
+				// The drives of the batch are released here
+			}
+		}
+
+		if (report_progress) {
+			progress.add(0, 0, 0, true);
+		}
+
+		os.flush();
+		if (!os) {
+			std::cerr << "Cannot write the summary.\n";
+			return false;
+		}
+		return all_ok;
+	}
+
+}
+
+
+
+/// Application main function
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([&argc, &argv]()
+	{
+		CmdArgs args;
+		if (!parse_cmdline_args(args, argc, argv)) {
+			return EXIT_FAILURE;
+		}
+
+		if (args.arg_version == TRUE) {
+			std::cout << Glib::ustring::compose(_("GSmartControl version %1"), BuildEnv::package_version()) << "\n";
+			return EXIT_SUCCESS;
+		}
+
+		// register libdebug domains
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		if (!cli_init_config(args.arg_config)) {
+			return EXIT_FAILURE;
+		}
+
+		return reprocess_run(args) ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,348 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+/*
+gsmartcontrol-scan-latency reports how long a standard scan-and-fetch (drive detection,
+then the basic and the full data of each drive) takes on this host. The scan is repeated
+a number of times for each requested detection backend, and the p50 / p95 / p99 durations
+are printed per backend, device and phase (see storage_scan_latency.h).
+With --save-baseline, the result is saved to compare the later runs (e.g. of a new version)
+against it with --baseline; the exit status is non-zero if any phase regressed.
+With --mock-output, the smartctl commands are answered from a captured output instead
+(see CommandExecutorMock), which measures the code above the executors deterministically.
+For a reproducible host-like load, point "system/smartctl_binary" at smartctl_simulator instead.
+This program links only to applib_core, not to Gtk.
+*/
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>  // EXIT_*
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "build_config.h"
+#include "hz/fs.h"
+#include "hz/main_tools.h"
+#include "hz/string_algo.h"
+#include "libdebug/libdebug.h"
+#include "rconfig/rconfig.h"
+#include "applib/command_executor_factory.h"
+#include "applib/command_executor_mock.h"
+#include "applib/gsc_settings.h"
+#include "applib/storage_inventory.h"
+#include "applib/storage_scan_latency.h"
+#include "gsc_cli_tools.h"
+
+
+
+namespace {
+
+
+	/// Command-line argument values
+	struct CmdArgs {
+		// Note: Use GLib types here:
+		gboolean arg_version = FALSE;  ///< if true, show version and exit
+		gboolean arg_scan = TRUE;  ///< if false, don't scan the system for drives
+		gchar** arg_add_device = nullptr;  ///< add these device files manually
+		gchar* arg_inventory = nullptr;  ///< fetch the drives listed in this inventory file too
+		gchar* arg_config = nullptr;  ///< load this config file
+		gchar** arg_backend = nullptr;  ///< detection backends to measure
+		gint arg_repetitions = 10;  ///< number of recorded repetitions
+		gint arg_warmup = 1;  ///< number of repetitions before these
+		gchar* arg_save_baseline = nullptr;  ///< save the result to this file
+		gchar* arg_baseline = nullptr;  ///< compare the result with this file
+		gint arg_tolerance = 20;  ///< allowed p95 increase, percent
+		gint arg_min_delta_ms = 5;  ///< allowed p95 increase, milliseconds
+		gboolean arg_json = FALSE;  ///< if true, print the result as JSON
+		gchar* arg_mock_output = nullptr;  ///< answer the smartctl commands with the contents of this file
+		gint arg_mock_delay_ms = 0;  ///< simulated execution time of the mock commands
+	};
+
+
+
+	/// Parse command-line arguments (fills \c args)
+	inline bool parse_cmdline_args(CmdArgs& args, int& argc, char**& argv)
+	{
+		static const std::vector<GOptionEntry> arg_entries = {
+			{ "version", 'V', 0, G_OPTION_ARG_NONE, &(args.arg_version),
+					N_("Display version information"), nullptr },
+			{ "no-scan", '\0', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &(args.arg_scan),
+					N_("Don't scan for devices, use --add-device and --inventory devices only"), nullptr },
+			{ "add-device", '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &(args.arg_add_device),
+					N_("Add this device to device list. The format of the device is \"<device>::<type>::<extra_args>\", where type and extra_args are optional."
+					" You can specify this option multiple times."), nullptr },
+			{ "inventory", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_inventory),
+					N_("Fetch the drives listed in this inventory file too"), nullptr },
+			{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &(args.arg_config),
+					N_("Load settings (smartctl binary, blacklist, etc.) from this GSmartControl config file"), nullptr },
+			{ "backend", 'b', 0, G_OPTION_ARG_STRING_ARRAY, &(args.arg_backend),
+					N_("Detection backend to measure: configured, scan_open, probe, sysfs or proc (the last two in Linux only)."
+					" You can specify this option multiple times. Default: configured."), nullptr },
+			{ "repetitions", 'n', 0, G_OPTION_ARG_INT, &(args.arg_repetitions),
+					N_("Number of measured scans per backend (default 10)"), nullptr },
+			{ "warmup", '\0', 0, G_OPTION_ARG_INT, &(args.arg_warmup),
+					N_("Number of scans per backend before the measured ones (default 1)"), nullptr },
+			{ "save-baseline", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_save_baseline),
+					N_("Save the result to this file, to be used with --baseline later"), nullptr },
+			{ "baseline", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_baseline),
+					N_("Compare the result with this file and fail if any p95 duration regressed"), nullptr },
+			{ "tolerance", '\0', 0, G_OPTION_ARG_INT, &(args.arg_tolerance),
+					N_("Allowed p95 increase over the baseline, percent (default 20)"), nullptr },
+			{ "min-delta-ms", '\0', 0, G_OPTION_ARG_INT, &(args.arg_min_delta_ms),
+					N_("Allowed p95 increase over the baseline regardless of the percentage, milliseconds (default 5)"), nullptr },
+			{ "json", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_json),
+					N_("Print the result as JSON (in the --save-baseline format)"), nullptr },
+			{ "mock-output", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_mock_output),
+					N_("Don't run smartctl, answer all its commands with the contents of this file (a smartctl -x output). Implies --no-scan."), nullptr },
+			{ "mock-delay-ms", '\0', 0, G_OPTION_ARG_INT, &(args.arg_mock_delay_ms),
+					N_("With --mock-output, the simulated execution time of each command, milliseconds"), nullptr },
+			{ nullptr, '\0', 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr }
+		};
+
+		GError* error = nullptr;
+		GOptionContext* context = g_option_context_new("- Report the drive scan latency percentiles");
+
+		// our options
+		g_option_context_add_main_entries(context, arg_entries.data(), nullptr);
+
+		// libdebug options; this will also automatically apply them
+		g_option_context_add_group(context, debug_get_option_group());
+
+		const bool parsed = static_cast<bool>(g_option_context_parse(context, &argc, &argv, &error));
+
+		if (error) {
+			std::string error_text = "\n" + Glib::ustring::compose(_("Error parsing command-line options: %1"), (error->message ? error->message : "invalid error"));
+			error_text += "\n\n";
+			g_error_free(error);
+
+			gchar* help_text = g_option_context_get_help(context, TRUE, nullptr);
+			if (help_text) {
+				error_text += help_text;
+				g_free(help_text);
+			}
+
+			std::cerr << error_text;
+		}
+		g_option_context_free(context);
+
+		return parsed;
+	}
+
+
+
+	/// Set up the detection config of a backend.
+	/// \return false if the backend is unknown.
+	inline bool apply_detection_backend(const std::string& backend)
+	{
+		if (backend == "configured") {
+			return true;
+		}
+		if (backend == "scan_open") {
+			rconfig::set_data("system/use_scan_open_detection", true);
+			return true;
+		}
+		if (backend == "probe") {
+			rconfig::set_data("system/use_scan_open_detection", false);
+			return true;
+		}
+		if (backend == "sysfs" || backend == "proc") {
+			rconfig::set_data("system/use_scan_open_detection", false);
+			rconfig::set_data("system/linux_detection_backend", backend);
+			return true;
+		}
+		return false;
+	}
+
+
+
+	/// Fill the mock corpus with the command lines used for the drives, all answered with \c output.
+	/// The command lines are learned by running the scan against the corpus until it has all of them
+	/// (the full data commands depend on the drive type, which the basic data answers detect, and
+	/// the scan stops at the first drive with a missing answer).
+	inline void learn_mock_commands(const StorageScanLatencySettings& settings,
+			const std::shared_ptr<CommandExecutorFactoryMock>& ex_factory, const std::string& output,
+			std::chrono::microseconds delay)
+	{
+		const auto& corpus = ex_factory->get_corpus();
+		StorageScanLatencySettings learn_settings = settings;
+		learn_settings.repetitions = 0;
+		learn_settings.warmup = 1;
+		for (std::size_t pass = 0; pass <= 2 * settings.drives.size(); ++pass) {
+			StorageScanLatencyRecorder recorder;
+			[[maybe_unused]] auto status = storage_scan_latency_measure(recorder, learn_settings, ex_factory);
+			const auto misses = corpus->get_misses();
+			if (misses.empty()) {
+				break;
+			}
+			for (const auto& args : misses) {
+				corpus->add(args, output, delay);
+			}
+			corpus->clear_misses();
+		}
+	}
+
+
+
+	/// Measure the scan latency and print or save the result.
+	inline bool scan_latency_run(const CmdArgs& args)
+	{
+		StorageScanLatencySettings settings;
+		settings.repetitions = std::max(1, static_cast<int>(args.arg_repetitions));
+		settings.warmup = std::max(0, static_cast<int>(args.arg_warmup));
+		settings.detect = (args.arg_scan == TRUE && args.arg_mock_output == nullptr);
+		hz::string_split(rconfig::get_data<std::string>("system/device_blacklist_patterns"), ';', settings.blacklist_patterns, true);
+
+		if (args.arg_inventory != nullptr) {
+			auto entries = storage_inventory_load(hz::fs_path_from_string(args.arg_inventory));
+			if (!entries) {
+				std::cerr << "Cannot load drive inventory: " << entries.error().message() << std::endl;
+				return false;
+			}
+			settings.drives = std::move(entries.value());
+		}
+		for (const auto& entry : storage_inventory_get_entries(cli_get_manual_drives(args.arg_add_device))) {
+			settings.drives.push_back(entry);
+		}
+		if (!settings.detect && settings.drives.empty()) {
+			std::cerr << "No drives to measure, use --add-device or --inventory." << std::endl;
+			return false;
+		}
+
+		std::vector<std::string> backends;
+		for (gchar** entry = args.arg_backend; entry && *entry; ++entry) {
+			backends.emplace_back(*entry);
+		}
+		if (args.arg_mock_output != nullptr) {
+			backends = {"mock"};
+		} else if (backends.empty()) {
+			backends = {"configured"};
+		}
+
+		std::string mock_output;
+		if (args.arg_mock_output != nullptr) {
+			const int max_size = 10*1024*1024;  // 10M
+			if (auto ec = hz::fs_file_get_contents(hz::fs_path_from_string(args.arg_mock_output), mock_output, max_size)) {
+				std::cerr << args.arg_mock_output << ": " << ec.message() << std::endl;
+				return false;
+			}
+		}
+
+		// The backends are set up on top of the configured detection
+		const bool configured_scan_open = rconfig::get_data<bool>("system/use_scan_open_detection");
+		const auto configured_linux_backend = rconfig::get_data<std::string>("system/linux_detection_backend");
+
+		StorageScanLatencyRecorder recorder;
+		for (const auto& backend : backends) {
+			settings.backend = backend;
+			rconfig::set_data("system/use_scan_open_detection", configured_scan_open);
+			rconfig::set_data("system/linux_detection_backend", configured_linux_backend);
+
+			CommandExecutorFactoryPtr ex_factory;
+			if (args.arg_mock_output != nullptr) {
+				auto mock_factory = std::make_shared<CommandExecutorFactoryMock>(std::make_shared<CommandExecutorMockCorpus>());
+				learn_mock_commands(settings, mock_factory, mock_output,
+						std::chrono::milliseconds(std::max(0, static_cast<int>(args.arg_mock_delay_ms))));
+				ex_factory = mock_factory;
+			} else {
+				if (!apply_detection_backend(backend)) {
+					std::cerr << "Unknown detection backend \"" << backend << "\"." << std::endl;
+					return false;
+				}
+				ex_factory = std::make_shared<CommandExecutorFactory>();
+			}
+
+			debug_out_info("app", "Measuring the scan latency with the \"" << backend << "\" backend.\n");
+			if (auto status = storage_scan_latency_measure(recorder, settings, ex_factory); !status) {
+				std::cerr << "Backend \"" << backend << "\": " << status.error().message() << std::endl;
+				return false;
+			}
+		}
+
+		const auto summaries = recorder.get_summaries();
+		const std::string host = g_get_host_name();
+		if (args.arg_json == TRUE) {
+			std::cout << storage_scan_latency_dump(summaries, host) << std::endl;
+		} else if (args.arg_baseline == nullptr) {
+			std::cout << storage_scan_latency_format(summaries);
+		}
+
+		if (args.arg_save_baseline != nullptr) {
+			if (auto save_status = storage_scan_latency_save(hz::fs_path_from_string(args.arg_save_baseline), summaries, host); !save_status) {
+				std::cerr << "Cannot save the baseline: " << save_status.error().message() << std::endl;
+				return false;
+			}
+		}
+
+		if (args.arg_baseline != nullptr) {
+			auto baseline = storage_scan_latency_load(hz::fs_path_from_string(args.arg_baseline));
+			if (!baseline) {
+				std::cerr << "Cannot load the baseline: " << baseline.error().message() << std::endl;
+				return false;
+			}
+			const auto comparison = storage_scan_latency_compare(summaries, baseline.value(),
+					static_cast<double>(std::max(0, static_cast<int>(args.arg_tolerance))) / 100.,
+					std::chrono::milliseconds(std::max(0, static_cast<int>(args.arg_min_delta_ms))));
+			if (args.arg_json != TRUE) {
+				std::cout << storage_scan_latency_format_comparison(comparison);
+			}
+			const auto regressions = std::count_if(comparison.begin(), comparison.end(),
+					[](const StorageScanLatencyComparison& entry) { return entry.regressed; });
+			if (regressions > 0) {
+				std::cerr << regressions << " phase(s) regressed against the baseline." << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+}
+
+
+
+/// Application main function
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([&argc, &argv]()
+	{
+		CmdArgs args;
+		if (!parse_cmdline_args(args, argc, argv)) {
+			return EXIT_FAILURE;
+		}
+
+		if (args.arg_version == TRUE) {
+			std::cout << Glib::ustring::compose(_("GSmartControl version %1"), BuildEnv::package_version()) << "\n";
+			return EXIT_SUCCESS;
+		}
+
+		// register libdebug domains
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		if (!cli_init_config(args.arg_config)) {
+			return EXIT_FAILURE;
+		}
+
+		return scan_latency_run(args) ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,306 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+/*
+gsmartcontrol-selftest runs a self-test on many drives, limiting the number
+of tests running at the same time on the same controller and in the same
+enclosure (see SelfTestFleet). The progress is saved to a state file, so
+if this program is interrupted, running it again with the same test type
+continues monitoring the tests it started, and doesn't repeat the finished ones.
+This program links only to applib_core, not to Gtk.
+*/
+
+#include <glib.h>
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>  // EXIT_*
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "build_config.h"
+#include "hz/main_tools.h"
+#include "hz/string_algo.h"
+#include "libdebug/libdebug.h"
+#include "rconfig/rconfig.h"
+#include "applib/gsc_settings.h"
+#include "applib/command_executor_factory.h"
+#include "applib/selftest_fleet.h"
+#include "applib/storage_detector.h"
+#include "applib/storage_device.h"
+#include "applib/worker_threads.h"
+#include "gsc_cli_tools.h"
+
+
+
+namespace {
+
+
+	/// Set by the signal handler to stop monitoring
+	volatile std::sig_atomic_t s_selftest_stop_requested = 0;
+
+
+	/// SIGINT / SIGTERM handler
+	extern "C" void selftest_on_stop_signal([[maybe_unused]] int sig)
+	{
+		s_selftest_stop_requested = 1;
+	}
+
+
+
+	/// Command-line argument values
+	struct CmdArgs {
+		// Note: Use GLib types here:
+		gboolean arg_version = FALSE;  ///< if true, show version and exit
+		gboolean arg_scan = TRUE;  ///< if false, don't scan the system for drives
+		gboolean arg_abort = FALSE;  ///< if true, abort the running tests of the previous run and exit
+		gchar** arg_add_device = nullptr;  ///< add these device files manually
+		gchar* arg_config = nullptr;  ///< load this config file
+		gchar* arg_type = nullptr;  ///< test type
+		gchar* arg_state_file = nullptr;  ///< state file. nullptr means the default one.
+		gint arg_max_running = -1;  ///< -1 means use the config value
+		gint arg_max_per_controller = -1;  ///< -1 means use the config value
+		gint arg_max_per_enclosure = -1;  ///< -1 means use the config value
+		gint arg_jobs = 0;  ///< number of drives to start / poll simultaneously. 0 means use the config value.
+	};
+
+
+
+	/// Parse command-line arguments (fills \c args)
+	inline bool parse_cmdline_args(CmdArgs& args, int& argc, char**& argv)
+	{
+		static const std::vector<GOptionEntry> arg_entries = {
+			{ "version", 'V', 0, G_OPTION_ARG_NONE, &(args.arg_version),
+					N_("Display version information"), nullptr },
+			{ "type", 't', 0, G_OPTION_ARG_STRING, &(args.arg_type),
+					N_("Test type: short, long or conveyance (default: short)"), nullptr },
+			{ "no-scan", '\0', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &(args.arg_scan),
+					N_("Don't scan for devices, use --add-device devices only"), nullptr },
+			{ "add-device", '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &(args.arg_add_device),
+					N_("Add this device to device list. The format of the device is \"<device>::<type>::<extra_args>\", where type and extra_args are optional."
+					" You can specify this option multiple times."), nullptr },
+			{ "max-running", '\0', 0, G_OPTION_ARG_INT, &(args.arg_max_running),
+					N_("Maximum number of tests running at the same time (0 means unlimited)"), nullptr },
+			{ "max-per-controller", '\0', 0, G_OPTION_ARG_INT, &(args.arg_max_per_controller),
+					N_("Maximum number of tests running at the same time on the same controller (0 means unlimited)"), nullptr },
+			{ "max-per-enclosure", '\0', 0, G_OPTION_ARG_INT, &(args.arg_max_per_enclosure),
+					N_("Maximum number of tests running at the same time in the same enclosure (0 means unlimited)"), nullptr },
+			{ "jobs", 'j', 0, G_OPTION_ARG_INT, &(args.arg_jobs),
+					N_("Number of drives to start or poll simultaneously"), nullptr },
+			{ "state-file", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_state_file),
+					N_("Save the progress to this file instead of the default one"), nullptr },
+			{ "abort", '\0', 0, G_OPTION_ARG_NONE, &(args.arg_abort),
+					N_("Abort the tests started by a previous (interrupted) run and exit"), nullptr },
+			{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &(args.arg_config),
+					N_("Load settings (smartctl binary, blacklist, etc.) from this GSmartControl config file"), nullptr },
+			{ nullptr, '\0', 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr }
+		};
+
+		GError* error = nullptr;
+		GOptionContext* context = g_option_context_new("- Run a self-test on many drives");
+
+		// our options
+		g_option_context_add_main_entries(context, arg_entries.data(), nullptr);
+
+		// libdebug options; this will also automatically apply them
+		g_option_context_add_group(context, debug_get_option_group());
+
+		const bool parsed = static_cast<bool>(g_option_context_parse(context, &argc, &argv, &error));
+
+		if (error) {
+			std::string error_text = "\n" + Glib::ustring::compose(_("Error parsing command-line options: %1"), (error->message ? error->message : "invalid error"));
+			error_text += "\n\n";
+			g_error_free(error);
+
+			gchar* help_text = g_option_context_get_help(context, TRUE, nullptr);
+			if (help_text) {
+				error_text += help_text;
+				g_free(help_text);
+			}
+
+			std::cerr << error_text;
+		}
+		g_option_context_free(context);
+
+		return parsed;
+	}
+
+
+
+	/// Get a limit from the command line, or from config if not specified
+	inline std::size_t get_limit(gint arg_value, const std::string& config_key)
+	{
+		return static_cast<std::size_t>(std::max(0, arg_value >= 0 ? arg_value : rconfig::get_data<int>(config_key)));
+	}
+
+
+
+	/// Print the jobs whose state changed since the last call
+	inline void print_changed_jobs(const std::vector<SelfTestFleetJob>& jobs, std::vector<std::string>& last_lines)
+	{
+		last_lines.resize(jobs.size());
+		for (std::size_t i = 0; i < jobs.size(); ++i) {
+			const auto& job = jobs[i];
+			std::string line = job.device + ": " + SelfTestFleetJobStateExt::get_displayable_name(job.state);
+			if (job.state == SelfTestFleetJobState::Running && job.remaining_percent >= 0) {
+				line += Glib::ustring::compose(_(", %1% remaining"), job.remaining_percent).raw();
+			} else if (job.state == SelfTestFleetJobState::Finished) {
+				line += ", " + SelfTestStatusExt::get_displayable_name(job.result);
+			} else if (job.state == SelfTestFleetJobState::Failed) {
+				line += ", " + job.error;
+			}
+			if (line != last_lines[i]) {
+				std::cout << line << std::endl;
+				last_lines[i] = line;
+			}
+		}
+	}
+
+
+
+	/// Detect the drives, and run the tests on them until they're all finished.
+	inline bool selftest_run(const CmdArgs& args)
+	{
+		SelfTest::TestType type = SelfTest::TestType::ShortTest;
+		const std::string type_str = (args.arg_type ? args.arg_type : "short");
+		if (type_str == "long") {
+			type = SelfTest::TestType::LongTest;
+		} else if (type_str == "conveyance") {
+			type = SelfTest::TestType::Conveyance;
+		} else if (type_str != "short") {
+			std::cerr << Glib::ustring::compose(_("Invalid test type \"%1\"."), type_str) << "\n";
+			return false;
+		}
+
+		SelfTestFleet::Limits limits;
+		limits.max_running = get_limit(args.arg_max_running, "system/fleet_selftest_max_running");
+		limits.max_per_controller = get_limit(args.arg_max_per_controller, "system/fleet_selftest_max_per_controller");
+		limits.max_per_enclosure = get_limit(args.arg_max_per_enclosure, "system/fleet_selftest_max_per_enclosure");
+		limits.max_parallel_commands = std::max(std::size_t(1),
+				get_limit(args.arg_jobs > 0 ? args.arg_jobs : -1, "system/fleet_selftest_max_parallel_commands"));
+
+		app_set_worker_thread_count(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/worker_threads"))));
+		cmdex_set_max_running_commands(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/max_running_commands"))));
+		cmdex_set_domain_limits(cmdex_get_domain_limits());
+		cmdex_set_priority_aging(std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/command_priority_aging_sec"))));
+
+		auto ex_factory = std::make_shared<CommandExecutorFactory>();
+		ex_factory->set_pooled(true);  // each worker thread reuses the executors
+
+		const hz::fs::path state_file = (args.arg_state_file ? hz::fs_path_from_string(args.arg_state_file)
+				: SelfTestFleet::get_default_state_file());
+		SelfTestFleet fleet(type, limits, state_file);
+		if (auto ec = fleet.load()) {
+			std::cerr << Glib::ustring::compose(_("Cannot load state file \"%1\": %2"),
+					hz::fs_path_to_string(state_file), ec.message()) << "\n";
+			return false;
+		}
+
+		std::vector<std::string> blacklist_patterns;
+		hz::string_split(rconfig::get_data<std::string>("system/device_blacklist_patterns"), ';', blacklist_patterns, true);
+
+		std::vector<StorageDevicePtr> drives;
+		StorageDetector sd;
+		if (args.arg_scan == TRUE) {
+			sd.add_blacklist_patterns(blacklist_patterns);
+			auto detect_status = sd.detect(drives, ex_factory);
+			if (!detect_status) {
+				std::cerr << detect_status.error().message() << "\n";
+			}
+		}
+		for (auto&& drive : cli_get_manual_drives(args.arg_add_device)) {
+			drives.push_back(drive);
+		}
+		for (auto& drive : drives) {
+			drive->set_keep_text_output(false);  // we don't output it, and it takes a lot of memory
+		}
+
+		// The jobs are keyed by the serial numbers, and the test capabilities depend on the drive
+		// type, so the basic data is needed before scheduling. The drives which fail here fail
+		// their jobs later, with the error reported.
+		sd.set_max_parallel_fetches(limits.max_parallel_commands);
+		static_cast<void>(sd.fetch_basic_data(drives, ex_factory));
+		fleet.set_drives(drives);
+
+		std::vector<std::string> last_lines;
+		if (args.arg_abort == TRUE) {
+			fleet.abort_all(ex_factory);
+			print_changed_jobs(fleet.get_jobs(), last_lines);
+			return !fleet.get_save_error();
+		}
+
+		std::signal(SIGINT, &selftest_on_stop_signal);
+		std::signal(SIGTERM, &selftest_on_stop_signal);
+
+		while (fleet.run_once(ex_factory)) {
+			print_changed_jobs(fleet.get_jobs(), last_lines);
+
+			// Sleep in short steps, so that the signals are handled quickly.
+			const auto wake_time = std::chrono::steady_clock::now() + fleet.get_next_poll_in();
+			while (!s_selftest_stop_requested && std::chrono::steady_clock::now() < wake_time) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			}
+			if (s_selftest_stop_requested) {
+				// The tests continue to run in the drives. The state file lets the next run monitor them.
+				std::cerr << _("Interrupted. The running tests were not aborted, run this program again to continue monitoring them.") << "\n";
+				return false;
+			}
+		}
+		print_changed_jobs(fleet.get_jobs(), last_lines);
+
+		const auto& jobs = fleet.get_jobs();
+		return std::all_of(jobs.cbegin(), jobs.cend(), [](const SelfTestFleetJob& job) {
+			return job.state == SelfTestFleetJobState::Finished && job.result == SelfTestStatus::CompletedNoError;
+		});
+	}
+
+}
+
+
+
+/// Application main function
+int main(int argc, char** argv)
+{
+	return hz::main_exception_wrapper([&argc, &argv]()
+	{
+		CmdArgs args;
+		if (!parse_cmdline_args(args, argc, argv)) {
+			return EXIT_FAILURE;
+		}
+
+		if (args.arg_version == TRUE) {
+			std::cout << Glib::ustring::compose(_("GSmartControl version %1"), BuildEnv::package_version()) << "\n";
+			return EXIT_SUCCESS;
+		}
+
+		// register libdebug domains
+		debug_register_domain("app");
+		debug_register_domain("hz");
+		debug_register_domain("rconfig");
+
+		if (!cli_init_config(args.arg_config)) {
+			return EXIT_FAILURE;
+		}
+
+		return selftest_run(args) ? EXIT_SUCCESS : EXIT_FAILURE;
+	});
+}
+
+
+
+
+
+/// @}
@@ -0,0 +1,325 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>
+#include <gtkmm.h>
+#include <gdk/gdk.h>  // GDK_KEY_Escape
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <limits>
+#include <numeric>  // std::iota
+#include <unordered_set>
+#include <vector>
+
+#include "hz/string_num.h"  // number_to_string_locale
+
+#include "gsc_attribute_matrix_window.h"
+
+
+
+GscAttributeMatrixWindow::GscAttributeMatrixWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui)
+		: AppBuilderWidget<GscAttributeMatrixWindow, false>(gtkcobj, std::move(ui))
+{
+	// Connect callbacks
+
+	Gtk::Button* window_close_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(window_close_button, clicked);
+
+	Gtk::ComboBoxText* field_combo = nullptr;
+	APP_BUILDER_AUTO_CONNECT(field_combo, changed);
+	field_combo_ = field_combo;
+
+	Gtk::SpinButton* filter_min_spinbutton = nullptr;
+	APP_BUILDER_AUTO_CONNECT(filter_min_spinbutton, value_changed);
+	filter_min_spinbutton_ = filter_min_spinbutton;
+
+
+	// Accelerators
+
+	const Glib::RefPtr<Gtk::AccelGroup> accel_group = this->get_accel_group();
+	if (window_close_button) {
+		window_close_button->add_accelerator("clicked", accel_group, GDK_KEY_Escape,
+				Gdk::ModifierType(0), Gtk::AccelFlags(0));
+	}
+
+
+	// --------------- Make a treeview. The attribute columns are added as they appear.
+
+	if (auto* treeview = this->lookup_widget<Gtk::TreeView*>("matrix_treeview")) {
+		Gtk::TreeModelColumnRecord model_columns;
+		model_columns.add(col_drive_);
+
+		list_store_ = Gtk::ListStore::create(model_columns);
+		treeview->set_model(list_store_);
+
+		auto* tcol = Gtk::manage(new Gtk::TreeViewColumn(_("Drive")));
+		auto* renderer = Gtk::manage(new Gtk::CellRendererText());
+		tcol->pack_start(*renderer);
+		tcol->set_cell_data_func(*renderer, [this](Gtk::CellRenderer* cr, const Gtk::TreeModel::iterator& iter) {
+			const StorageDevicePtr drive = (*iter)[col_drive_];
+			auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr);
+			if (drive && crt) {
+				const std::string model = drive->get_model_name();
+				crt->property_text() = drive->get_device_with_type() + (model.empty() ? std::string() : (" - " + model));
+			}
+		});
+		tcol->set_resizable(true);
+		treeview->append_column(*tcol);
+	}
+
+	// The attributes are added as they appear. Connected after the first entry is
+	// added, so that it's not handled before the list store is created.
+	Gtk::ComboBoxText* filter_column_combo = nullptr;
+	if (this->lookup_widget("filter_column_combo", filter_column_combo)) {
+		filter_column_combo->append(_("Any Attributes"));
+		filter_column_combo->set_active(0);
+	}
+	APP_BUILDER_AUTO_CONNECT(filter_column_combo, changed);
+	filter_column_combo_ = filter_column_combo;
+
+	update_status();
+
+	// show();
+}
+
+
+
+void GscAttributeMatrixWindow::set_drives(const std::vector<StorageDevicePtr>& drives)
+{
+	std::unordered_set<const StorageDevice*> new_drives;
+	for (const auto& drive : drives) {
+		if (drive) {
+			new_drives.insert(drive.get());
+		}
+	}
+
+	for (auto iter = drives_.begin(); iter != drives_.end(); ) {
+		if (!new_drives.contains(iter->first)) {
+			iter->second.changed_connection.disconnect();
+			matrix_.remove(iter->first);
+			iter = drives_.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+
+	for (const auto& drive : drives) {
+		if (drive && !drives_.contains(drive.get())) {
+			DriveInfo& info = drives_[drive.get()];
+			info.drive = drive;
+			info.changed_connection = drive->signal_changed_coalesced().connect(
+					sigc::mem_fun(this, &GscAttributeMatrixWindow::on_drive_changed));
+			matrix_.update(*drive);
+		}
+	}
+
+	update_view_columns();
+	update_rows();
+}
+
+
+
+void GscAttributeMatrixWindow::update_view_columns()
+{
+	auto* treeview = this->lookup_widget<Gtk::TreeView*>("matrix_treeview");
+	if (!treeview || !filter_column_combo_) {
+		return;
+	}
+
+	const auto& columns = matrix_.get_columns();
+	for (std::size_t column = num_view_columns_; column < columns.size(); ++column) {
+		auto* tcol = Gtk::manage(new Gtk::TreeViewColumn(columns[column].name));
+		auto* renderer = Gtk::manage(new Gtk::CellRendererText());
+		renderer->property_xalign() = 1.0;
+		tcol->pack_start(*renderer);
+
+		// The values are read from the matrix columns directly
+		tcol->set_cell_data_func(*renderer, [this, column](Gtk::CellRenderer* cr, const Gtk::TreeModel::iterator& iter) {
+			const StorageDevicePtr drive = (*iter)[col_drive_];
+			auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr);
+			if (!crt) {
+				return;
+			}
+			const auto row = matrix_.find_row(drive.get());
+			const auto value = (row.has_value() ? matrix_.get_columns()[column].get(row.value(), get_field()) : std::nullopt);
+			crt->property_text() = (value.has_value() ? hz::number_to_string_locale(value.value()) : std::string("-"));
+		});
+
+		tcol->set_resizable(true);
+		tcol->set_clickable(true);
+		tcol->signal_clicked().connect(sigc::bind(sigc::mem_fun(*this,
+				&GscAttributeMatrixWindow::on_column_header_clicked), column));
+		treeview->append_column(*tcol);
+
+		filter_column_combo_->append(columns[column].name);
+	}
+	num_view_columns_ = columns.size();
+}
+
+
+
+void GscAttributeMatrixWindow::update_rows()
+{
+	if (!list_store_) {
+		return;
+	}
+	const int filter_index = get_filter_column_index();
+	const StorageAttributeMatrixField field = get_field();
+
+	std::vector<std::size_t> rows;
+	if (filter_index > 0 && filter_min_spinbutton_) {
+		const auto min_value = static_cast<std::int64_t>(filter_min_spinbutton_->get_value());
+		rows = matrix_.filter_rows(static_cast<std::size_t>(filter_index - 1), field,
+				min_value, std::numeric_limits<std::int64_t>::max());
+	} else {
+		rows.resize(matrix_.get_row_count());
+		std::iota(rows.begin(), rows.end(), std::size_t(0));
+	}
+	if (sort_column_.has_value()) {
+		matrix_.sort_rows(rows, sort_column_.value(), field, sort_descending_);
+	}
+
+	list_store_->clear();
+	for (const std::size_t row : rows) {
+		auto drive_iter = drives_.find(matrix_.get_row_drive(row));
+		if (drive_iter != drives_.end()) {
+			(*list_store_->append())[col_drive_] = drive_iter->second.drive;
+		}
+	}
+
+	update_status();
+}
+
+
+
+void GscAttributeMatrixWindow::update_status()
+{
+	if (auto* status_label = this->lookup_widget<Gtk::Label*>("status_label")) {
+		status_label->set_text(Glib::ustring::compose(_("%1 of %2 drives shown, %3 attributes"),
+				list_store_ ? list_store_->children().size() : 0, matrix_.get_row_count(), matrix_.get_columns().size()));
+	}
+}
+
+
+
+StorageAttributeMatrixField GscAttributeMatrixWindow::get_field() const
+{
+	switch (field_combo_ ? field_combo_->get_active_row_number() : 0) {
+		case 1:
+			return StorageAttributeMatrixField::Value;
+		case 2:
+			return StorageAttributeMatrixField::Worst;
+		default:
+			break;
+	}
+	return StorageAttributeMatrixField::Raw;
+}
+
+
+
+int GscAttributeMatrixWindow::get_filter_column_index() const
+{
+	return filter_column_combo_ ? filter_column_combo_->get_active_row_number() : 0;
+}
+
+
+
+void GscAttributeMatrixWindow::on_drive_changed(StorageDevice* drive, StorageDeviceChange changes)
+{
+	if (!storage_device_change_has(changes, StorageDeviceChange::Properties) || !matrix_.update(*drive)) {
+		return;
+	}
+	update_view_columns();
+
+	// The drive may change its place or start / stop passing the filter
+	if (sort_column_.has_value() || get_filter_column_index() > 0) {
+		update_rows();
+		return;
+	}
+
+	// Otherwise, only its row is redrawn
+	for (const auto& row : list_store_->children()) {
+		const StorageDevicePtr row_drive = row[col_drive_];
+		if (row_drive.get() == drive) {
+			list_store_->row_changed(list_store_->get_path(row), row);
+			break;
+		}
+	}
+}
+
+
+
+void GscAttributeMatrixWindow::on_column_header_clicked(std::size_t column)
+{
+	// Descending first, the drives with the highest values are usually the interesting ones
+	sort_descending_ = (sort_column_ != column || !sort_descending_);
+	sort_column_ = column;
+
+	if (auto* treeview = this->lookup_widget<Gtk::TreeView*>("matrix_treeview")) {
+		const auto tcols = treeview->get_columns();
+		for (std::size_t i = 0; i < tcols.size(); ++i) {
+			tcols[i]->set_sort_indicator(i == column + 1);  // the first one is the drive column
+			if (i == column + 1) {
+				tcols[i]->set_sort_order(sort_descending_ ? Gtk::SORT_DESCENDING : Gtk::SORT_ASCENDING);
+			}
+		}
+	}
+	update_rows();
+}
+
+
+
+bool GscAttributeMatrixWindow::on_delete_event([[maybe_unused]] GdkEventAny* e)
+{
+	on_window_close_button_clicked();
+	return true;  // event handled
+}
+
+
+
+void GscAttributeMatrixWindow::on_window_close_button_clicked()
+{
+	// Don't keep the drives (and follow their changes) while hidden
+	set_drives({});
+	this->hide();  // hide only, don't destroy
+}
+
+
+
+void GscAttributeMatrixWindow::on_field_combo_changed()
+{
+	if (sort_column_.has_value() || get_filter_column_index() > 0) {
+		update_rows();
+	} else if (auto* treeview = this->lookup_widget<Gtk::TreeView*>("matrix_treeview")) {
+		treeview->queue_draw();
+	}
+}
+
+
+
+void GscAttributeMatrixWindow::on_filter_column_combo_changed()
+{
+	update_rows();
+}
+
+
+
+void GscAttributeMatrixWindow::on_filter_min_spinbutton_value_changed()
+{
+	update_rows();
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,130 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_ATTRIBUTE_MATRIX_WINDOW_H
+#define GSC_ATTRIBUTE_MATRIX_WINDOW_H
+
+#include <cstddef>  // std::size_t
+#include <gtkmm.h>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "applib/app_builder_widget.h"
+#include "applib/storage_attribute_matrix.h"
+#include "applib/storage_device.h"
+
+
+
+/// The "Attribute Comparison" window, showing the attributes of all the drives side by
+/// side (one row per drive, one column per attribute), backed by StorageAttributeMatrix.
+/// Use create() / destroy() with this class instead of new / delete!
+class GscAttributeMatrixWindow : public AppBuilderWidget<GscAttributeMatrixWindow, false> {
+	public:
+
+		// name of ui file (without .ui extension) for AppBuilderWidget
+		static inline const std::string_view ui_name = "gsc_attribute_matrix_window";
+
+
+		/// Constructor, GtkBuilder needs this.
+		GscAttributeMatrixWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui);
+
+
+		/// Set the drives to compare. The drives which stay are not re-read; the changes
+		/// in the drives are followed through StorageDevice::signal_changed_coalesced().
+		void set_drives(const std::vector<StorageDevicePtr>& drives);
+
+
+	protected:
+
+		/// Add the tree view columns of the matrix columns which don't have them yet
+		void update_view_columns();
+
+
+		/// Refill the rows according to the filter and sort order
+		void update_rows();
+
+
+		/// Update the status label
+		void update_status();
+
+
+		/// Get the currently shown field
+		[[nodiscard]] StorageAttributeMatrixField get_field() const;
+
+
+		/// Get the filter combo index: 0 if not filtering, matrix column + 1 otherwise
+		[[nodiscard]] int get_filter_column_index() const;
+
+
+		/// Callback attached to StorageDevice, updates its row.
+		void on_drive_changed(StorageDevice* drive, StorageDeviceChange changes);
+
+
+		/// Callback of the attribute column headers
+		void on_column_header_clicked(std::size_t column);
+
+
+		// ---------- overridden virtual methods
+
+		/// Hide the window, don't destroy.
+		/// Reimplemented from Gtk::Window.
+		bool on_delete_event(GdkEventAny* e) override;
+
+
+		// ---------- other callbacks
+
+		/// Button click callback
+		void on_window_close_button_clicked();
+
+		/// Combo change callback
+		void on_field_combo_changed();
+
+		/// Combo change callback
+		void on_filter_column_combo_changed();
+
+		/// Spin button change callback
+		void on_filter_min_spinbutton_value_changed();
+
+
+	private:
+
+		/// A compared drive
+		struct DriveInfo {
+			StorageDevicePtr drive;  ///< The drive
+			sigc::connection changed_connection;  ///< Connection to StorageDevice::signal_changed_coalesced()
+		};
+
+		StorageAttributeMatrix matrix_;  ///< Attributes of the drives
+		std::unordered_map<const StorageDevice*, DriveInfo> drives_;  ///< Compared drives
+
+		std::optional<std::size_t> sort_column_;  ///< Matrix column to sort the drives by
+		bool sort_descending_ = true;  ///< Sort order
+		std::size_t num_view_columns_ = 0;  ///< Number of matrix columns which have tree view columns
+
+		Gtk::ComboBoxText* field_combo_ = nullptr;  ///< Shown field combobox
+		Gtk::ComboBoxText* filter_column_combo_ = nullptr;  ///< Filter attribute combobox
+		Gtk::SpinButton* filter_min_spinbutton_ = nullptr;  ///< Filter minimum value
+
+		Glib::RefPtr<Gtk::ListStore> list_store_;  ///< List store
+		Gtk::TreeModelColumn<StorageDevicePtr> col_drive_;  ///< Tree column
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,367 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>
+#include <gtkmm.h>
+#include <gdk/gdk.h>  // GDK_KEY_Escape
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hz/debug.h"
+#include "hz/format_unit.h"  // format_size
+#include "hz/fs.h"
+#include "rconfig/rconfig.h"
+
+#include "applib/app_gtkmm_tools.h"  // app_gtkmm_*
+#include "applib/app_main_loop_watchdog.h"
+#include "applib/app_trace.h"
+#include "applib/gui_utils.h"  // gui_show_error_dialog
+#include "applib/storage_device.h"
+
+#include "gsc_diagnostics_window.h"
+#include "gsc_executor_log_window.h"
+#include "gsc_info_window.h"
+#include "gsc_main_window_iconview.h"
+
+
+
+namespace {
+
+	/// Add a size column with a formatted size to the tree view
+	void diagnostics_append_size_column(Gtk::TreeView& treeview, const Gtk::TreeModelColumn<std::uint64_t>& column,
+			const Glib::ustring& title, const Glib::ustring& tooltip)
+	{
+		auto* tcol = Gtk::manage(new Gtk::TreeViewColumn(title));
+		auto* renderer = Gtk::manage(new Gtk::CellRendererText());
+		renderer->property_xalign() = 1.0;
+		tcol->pack_start(*renderer);
+		tcol->set_cell_data_func(*renderer, [column](Gtk::CellRenderer* cr, const Gtk::TreeModel::iterator& iter) {
+			if (auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr)) {
+				crt->property_text() = hz::format_size((*iter)[column], true);
+			}
+		});
+		tcol->set_sort_column(column);
+		tcol->set_reorderable(true);
+		tcol->set_resizable(true);
+		treeview.append_column(*tcol);
+
+		app_gtkmm_labelize_column(*tcol);
+		if (Gtk::Widget* header = app_gtkmm_get_column_header(*tcol)) {
+			app_gtkmm_set_widget_tooltip(*header, tooltip, false);
+		}
+	}
+
+}
+
+
+
+GscDiagnosticsWindow::GscDiagnosticsWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui)
+		: AppBuilderWidget<GscDiagnosticsWindow, false>(gtkcobj, std::move(ui))
+{
+	// Connect callbacks
+
+	Gtk::Button* window_close_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(window_close_button, clicked);
+
+	Gtk::Button* window_refresh_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(window_refresh_button, clicked);
+
+	Gtk::CheckButton* trace_enabled_check = nullptr;
+	APP_BUILDER_AUTO_CONNECT(trace_enabled_check, toggled);
+
+	Gtk::Button* trace_save_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(trace_save_button, clicked);
+
+
+	// Accelerators
+
+	const Glib::RefPtr<Gtk::AccelGroup> accel_group = this->get_accel_group();
+	if (window_close_button) {
+		window_close_button->add_accelerator("clicked", accel_group, GDK_KEY_Escape,
+				Gdk::ModifierType(0), Gtk::AccelFlags(0));
+	}
+
+
+	// --------------- Make a treeview
+
+	if (auto* treeview = this->lookup_widget<Gtk::TreeView*>("memory_treeview")) {
+		Gtk::TreeModelColumnRecord model_columns;
+		model_columns.add(col_drive_);
+		model_columns.add(col_outputs_);
+		model_columns.add(col_properties_);
+		model_columns.add(col_property_count_);
+		model_columns.add(col_executor_log_);
+		model_columns.add(col_gui_);
+		model_columns.add(col_other_);
+		model_columns.add(col_total_);
+
+		list_store_ = Gtk::ListStore::create(model_columns);
+		treeview->set_model(list_store_);
+
+		app_gtkmm_create_tree_view_column(col_drive_, *treeview, _("Drive"), _("Drive"), true);
+		diagnostics_append_size_column(*treeview, col_outputs_, _("Outputs"), _("Raw smartctl outputs"));
+		diagnostics_append_size_column(*treeview, col_properties_, _("Properties"), _("Parsed properties"));
+		app_gtkmm_create_tree_view_column(col_property_count_, *treeview, _("Count"), _("Number of parsed properties"), true);
+		diagnostics_append_size_column(*treeview, col_executor_log_, _("Execution Log"),
+				_("Execution log entries of the drive, with their outputs"));
+		diagnostics_append_size_column(*treeview, col_gui_, _("GUI"),
+				_("Icon view entry and the open information windows of the drive"));
+		diagnostics_append_size_column(*treeview, col_other_, _("Other"), _("Other drive data"));
+		diagnostics_append_size_column(*treeview, col_total_, _("Total"), _("Total memory usage of the drive"));
+
+		list_store_->set_sort_column(col_total_, Gtk::SORT_DESCENDING);
+	}
+
+	// show();
+}
+
+
+
+void GscDiagnosticsWindow::set_iconview(const GscMainWindowIconView* iconview)
+{
+	iconview_ = iconview;
+}
+
+
+
+void GscDiagnosticsWindow::refresh()
+{
+	update_memory_usage();
+	update_statistics();
+	update_trace_status();
+}
+
+
+
+void GscDiagnosticsWindow::update_memory_usage()
+{
+	if (!list_store_) {
+		return;
+	}
+	list_store_->clear();
+
+	const std::vector<StorageDevicePtr> drives = (iconview_ ? iconview_->get_drives() : std::vector<StorageDevicePtr>());
+	const std::unordered_map<std::string, std::size_t> log_usage = GscExecutorLog::get().get_memory_usage_by_device();
+
+	std::uint64_t total = 0;
+	for (const auto& drive : drives) {
+		const StorageDeviceMemoryUsage usage = drive->get_memory_usage();
+		const auto log_iter = (drive->get_is_virtual() ? log_usage.end() : log_usage.find(drive->get_device()));
+		const std::size_t log_size = (log_iter != log_usage.end() ? log_iter->second : 0);
+		const std::size_t gui_size = iconview_->get_entry_memory_usage(drive.get())
+				+ GscInfoWindow::get_drive_ui_memory_usage(drive.get());
+
+		const std::string model = drive->get_model_name();
+		Gtk::TreeRow row = *(list_store_->append());
+		row[col_drive_] = drive->get_device_with_type() + (model.empty() ? std::string() : (" - " + model));
+		row[col_outputs_] = usage.outputs;
+		row[col_properties_] = usage.properties;
+		row[col_property_count_] = usage.property_count;
+		row[col_executor_log_] = log_size;
+		row[col_gui_] = gui_size;
+		row[col_other_] = usage.other;
+		row[col_total_] = usage.get_total() + log_size + gui_size;
+		total += usage.get_total() + log_size + gui_size;
+	}
+
+	if (auto* memory_total_label = this->lookup_widget<Gtk::Label*>("memory_total_label")) {
+		memory_total_label->set_text(Glib::ustring::compose(_("%1 drives, %2 total. Execution log: %3 total."),
+				drives.size(), hz::format_size(total, true), hz::format_size(GscExecutorLog::get().get_memory_usage(), true)));
+	}
+}
+
+
+
+void GscDiagnosticsWindow::update_statistics()
+{
+	auto* statistics_textview = this->lookup_widget<Gtk::TextView*>("statistics_textview");
+	const Glib::RefPtr<Gtk::TextBuffer> buffer = (statistics_textview ? statistics_textview->get_buffer() : Glib::RefPtr<Gtk::TextBuffer>());
+	if (!buffer) {
+		return;
+	}
+	std::string text = GscExecutorLog::format_statistics();
+	if (const auto watchdog = app_main_loop_watchdog_get_global()) {
+		text += "\n" + watchdog->format_stalls();
+	} else {
+		text += "\nMain loop stalls: not watched (see gui/main_loop_stall_threshold_msec)\n";
+	}
+	buffer->set_text(app_make_valid_utf8_from_command_output(text));
+
+	Glib::RefPtr<Gtk::TextTag> tag;
+	if (const Glib::RefPtr<Gtk::TextTagTable> table = buffer->get_tag_table()) {
+		tag = table->lookup("font");
+	}
+	if (!tag) {
+		tag = buffer->create_tag("font");
+	}
+	tag->property_family() = "Monospace";
+	buffer->apply_tag(tag, buffer->begin(), buffer->end());
+}
+
+
+
+void GscDiagnosticsWindow::update_trace_status()
+{
+	const bool enabled = app_trace_get_enabled();
+	updating_trace_status_ = true;
+	if (auto* trace_enabled_check = this->lookup_widget<Gtk::CheckButton*>("trace_enabled_check")) {
+		trace_enabled_check->set_active(enabled);
+	}
+	updating_trace_status_ = false;
+
+	if (auto* trace_status_label = this->lookup_widget<Gtk::Label*>("trace_status_label")) {
+		trace_status_label->set_text(enabled
+				? _("Drive detection, command execution and parsing are being traced.")
+				: _("Tracing is disabled."));
+	}
+}
+
+
+
+bool GscDiagnosticsWindow::on_delete_event([[maybe_unused]] GdkEventAny* e)
+{
+	on_window_close_button_clicked();
+	return true;  // event handled
+}
+
+
+
+void GscDiagnosticsWindow::on_window_close_button_clicked()
+{
+	// Don't keep the (large) table while hidden
+	if (list_store_) {
+		list_store_->clear();
+	}
+	this->hide();  // hide only, don't destroy
+}
+
+
+
+void GscDiagnosticsWindow::on_window_refresh_button_clicked()
+{
+	refresh();
+}
+
+
+
+void GscDiagnosticsWindow::on_trace_enabled_check_toggled()
+{
+	if (updating_trace_status_) {
+		return;
+	}
+	auto* trace_enabled_check = this->lookup_widget<Gtk::CheckButton*>("trace_enabled_check");
+	if (trace_enabled_check && trace_enabled_check->get_active() != app_trace_get_enabled()) {
+		app_trace_set_enabled(trace_enabled_check->get_active());  // clears the recorded spans
+	}
+	update_trace_status();
+}
+
+
+
+void GscDiagnosticsWindow::on_trace_save_button_clicked()
+{
+	static std::string last_dir;
+	if (last_dir.empty()) {
+		last_dir = rconfig::get_data<std::string>("gui/drive_data_open_save_dir");
+	}
+	int result = 0;
+
+	const Glib::RefPtr<Gtk::FileFilter> specific_filter = Gtk::FileFilter::create();
+	specific_filter->set_name(_("JSON Files"));
+	specific_filter->add_pattern("*.json");
+
+	const Glib::RefPtr<Gtk::FileFilter> all_filter = Gtk::FileFilter::create();
+	all_filter->set_name(_("All Files"));
+	all_filter->add_pattern("*");
+
+#if GTK_CHECK_VERSION(3, 20, 0)
+	const std::unique_ptr<GtkFileChooserNative, decltype(&g_object_unref)> dialog(gtk_file_chooser_native_new(
+			_("Save Trace As..."), this->gobj(), GTK_FILE_CHOOSER_ACTION_SAVE, nullptr, nullptr),
+			&g_object_unref);
+
+	gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(dialog.get()), TRUE);
+
+	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog.get()), specific_filter->gobj());
+	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog.get()), all_filter->gobj());
+
+	if (!last_dir.empty())
+		gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(dialog.get()), last_dir.c_str());
+
+	gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog.get()), "gsmartcontrol-trace.json");
+
+	result = gtk_native_dialog_run(GTK_NATIVE_DIALOG(dialog.get()));
+
+#else
+	Gtk::FileChooserDialog dialog(*this, _("Save Trace As..."),
+			Gtk::FILE_CHOOSER_ACTION_SAVE);
+
+	// Add response buttons the the dialog
+	dialog.add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+	dialog.add_button(Gtk::Stock::SAVE, Gtk::RESPONSE_ACCEPT);
+
+	dialog.set_do_overwrite_confirmation(true);
+
+	dialog.add_filter(specific_filter);
+	dialog.add_filter(all_filter);
+
+	if (!last_dir.empty())
+		dialog.set_current_folder(last_dir);
+
+	dialog.set_current_name("gsmartcontrol-trace.json");
+
+	// Show the dialog and wait for a user response
+	result = dialog.run();  // the main cycle blocks here
+#endif
+
+	// Handle the response
+	switch (result) {
+		case Gtk::RESPONSE_ACCEPT:
+		{
+			hz::fs::path file;
+#if GTK_CHECK_VERSION(3, 20, 0)
+			file = hz::fs_path_from_string(app_string_from_gchar(gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog.get()))));
+			last_dir = hz::fs_path_to_string(file.parent_path());
+#else
+			file = hz::fs_path_from_string(dialog.get_filename());  // in fs encoding
+			last_dir = dialog.get_current_folder();  // save for the future
+#endif
+			rconfig::set_data("gui/drive_data_open_save_dir", last_dir);
+
+			if (file.extension() != ".json") {
+				file += ".json";
+			}
+
+			if (auto ec = app_trace_write_chrome_json(file)) {
+				gui_show_error_dialog(_("Cannot save trace to file"), ec.message(), this);
+			}
+			break;
+		}
+
+		case Gtk::RESPONSE_CANCEL: case Gtk::RESPONSE_DELETE_EVENT:
+			// nothing, the dialog is closed already
+			break;
+
+		default:
+			debug_out_error("app", DBG_FUNC_MSG << "Unknown dialog response code: " << result << ".\n");
+			break;
+	}
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,110 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_DIAGNOSTICS_WINDOW_H
+#define GSC_DIAGNOSTICS_WINDOW_H
+
+#include <cstdint>
+#include <gtkmm.h>
+
+#include "applib/app_builder_widget.h"
+
+
+class GscMainWindowIconView;  // defined in gsc_main_window_iconview.h
+
+
+
+/// The "Diagnostics" window, showing the approximate memory usage of each drive
+/// (per subsystem), the command execution statistics, and the tracing controls.
+/// The data is collected when the window is shown and on Refresh.
+/// Use create() / destroy() with this class instead of new / delete!
+class GscDiagnosticsWindow : public AppBuilderWidget<GscDiagnosticsWindow, false> {
+	public:
+
+		// name of ui file (without .ui extension) for AppBuilderWidget
+		static inline const std::string_view ui_name = "gsc_diagnostics_window";
+
+
+		/// Constructor, GtkBuilder needs this.
+		GscDiagnosticsWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui);
+
+
+		/// Set the icon view to take the drives (and their GUI memory usage) from
+		void set_iconview(const GscMainWindowIconView* iconview);
+
+
+		/// Collect the data again and show it
+		void refresh();
+
+
+	protected:
+
+		/// Fill the memory usage table
+		void update_memory_usage();
+
+
+		/// Fill the execution statistics
+		void update_statistics();
+
+
+		/// Update the tracing controls
+		void update_trace_status();
+
+
+		// ---------- overridden virtual methods
+
+		/// Hide the window, don't destroy.
+		/// Reimplemented from Gtk::Window.
+		bool on_delete_event(GdkEventAny* e) override;
+
+
+		// ---------- other callbacks
+
+		/// Button click callback
+		void on_window_close_button_clicked();
+
+		/// Button click callback
+		void on_window_refresh_button_clicked();
+
+		/// Toggle button callback
+		void on_trace_enabled_check_toggled();
+
+		/// Button click callback
+		void on_trace_save_button_clicked();
+
+
+	private:
+
+		const GscMainWindowIconView* iconview_ = nullptr;  ///< Icon view with the drives
+
+		Glib::RefPtr<Gtk::ListStore> list_store_;  ///< Memory usage list store
+
+		Gtk::TreeModelColumn<std::string> col_drive_;  ///< Tree column
+		Gtk::TreeModelColumn<std::uint64_t> col_outputs_;  ///< Tree column
+		Gtk::TreeModelColumn<std::uint64_t> col_properties_;  ///< Tree column
+		Gtk::TreeModelColumn<std::uint64_t> col_property_count_;  ///< Tree column
+		Gtk::TreeModelColumn<std::uint64_t> col_executor_log_;  ///< Tree column
+		Gtk::TreeModelColumn<std::uint64_t> col_gui_;  ///< Tree column
+		Gtk::TreeModelColumn<std::uint64_t> col_other_;  ///< Tree column
+		Gtk::TreeModelColumn<std::uint64_t> col_total_;  ///< Tree column
+
+		bool updating_trace_status_ = false;  ///< Set while update_trace_status() changes the check button
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -13,12 +13,25 @@ Copyright:
 #include <glibmm.h>
 #include <gtkmm.h>
 #include <gdk/gdk.h>  // GDK_KEY_Escape
+#include <gio/gio.h>  // GZlibCompressor
+#include <algorithm>
+#include <array>
 #include <sstream>
 #include <cstddef>  // std::size_t
+#include <functional>  // std::hash
+#include <iterator>  // std::next
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "applib/app_gtkmm_tools.h"  // app_gtkmm_create_tree_view_column
+#include "applib/command_executor_stats.h"
+#include "applib/storage_device.h"
 #include "hz/fs.h"
 #include "rconfig/rconfig.h"
 
@@ -28,6 +41,519 @@ Copyright:
 
 
 
+namespace {
+
+	/// Number of the most recent entries which are never packed (they're the ones usually looked at)
+	constexpr std::size_t executor_log_uncompressed_entries = 8;
+
+	/// Maximum number of the matching entries shown while searching (the newest ones)
+	constexpr std::size_t executor_log_max_search_rows = 1000;
+
+
+	/// Maximum number of deltas to apply to unpack an output. Longer chains are cut by compressing instead.
+	constexpr std::size_t executor_log_max_delta_depth = 16;
+
+
+	/// Number of base lines to look ahead for the current line when delta-encoding
+	constexpr std::size_t executor_log_delta_lookahead = 32;
+
+
+	/// Run the data through a zlib (de)compressor. \return std::nullopt on error.
+	std::optional<std::string> executor_log_convert(GConverter* converter, std::string_view input)
+	{
+		std::string output;
+		std::array<char, 16UL * 1024UL> buf = {0};
+		while (true) {
+			gsize bytes_read = 0, bytes_written = 0;
+			GError* error = nullptr;
+			const GConverterResult result = g_converter_convert(converter, input.data(), input.size(),
+					buf.data(), buf.size(), G_CONVERTER_INPUT_AT_END, &bytes_read, &bytes_written, &error);
+			if (result == G_CONVERTER_ERROR) {
+				debug_out_error("app", DBG_FUNC_MSG << "Cannot (de)compress the execution log data: "
+						<< (error ? error->message : "unknown error") << "\n");
+				if (error) {
+					g_error_free(error);
+				}
+				return std::nullopt;
+			}
+			input.remove_prefix(bytes_read);
+			output.append(buf.data(), bytes_written);
+			if (result == G_CONVERTER_FINISHED) {
+				break;
+			}
+		}
+		return output;
+	}
+
+
+	/// Compress the data. \return std::nullopt on error.
+	std::optional<std::string> executor_log_compress(std::string_view input)
+	{
+		GZlibCompressor* compressor = g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, -1);
+		auto output = executor_log_convert(G_CONVERTER(compressor), input);
+		g_object_unref(compressor);
+		return output;
+	}
+
+
+	/// Decompress the data compressed with executor_log_compress()
+	std::string executor_log_decompress(std::string_view input)
+	{
+		GZlibDecompressor* decompressor = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB);
+		auto output = executor_log_convert(G_CONVERTER(decompressor), input);
+		g_object_unref(decompressor);
+		return output.value_or(std::string());
+	}
+
+
+	/// Split the data into lines, keeping the line endings
+	std::vector<std::string_view> executor_log_split_lines(std::string_view data)
+	{
+		std::vector<std::string_view> lines;
+		while (!data.empty()) {
+			const std::size_t end = data.find('\n');
+			const std::size_t len = (end == std::string_view::npos ? data.size() : end + 1);
+			lines.push_back(data.substr(0, len));
+			data.remove_prefix(len);
+		}
+		return lines;
+	}
+
+
+	/// Hash of the output contents
+	std::size_t executor_log_hash(std::string_view data)
+	{
+		return std::hash<std::string_view>()(data);
+	}
+
+}
+
+
+
+GscExecutorLogOutput::GscExecutorLogOutput(CommandOutputPtr output, std::size_t hash, std::size_t& size_counter)
+		: output_(std::move(output)), hash_(hash), full_size_(output_->size()), size_counter_(size_counter)
+{
+	update_size_counter();
+}
+
+
+
+GscExecutorLogOutput::~GscExecutorLogOutput()
+{
+	size_counter_ -= size_;
+}
+
+
+
+std::string GscExecutorLogOutput::get() const
+{
+	if (output_) {
+		return *output_;
+	}
+	if (!base_) {
+		return executor_log_decompress(compressed_);
+	}
+	const std::string base = base_->get();
+	const std::vector<std::string_view> base_lines = executor_log_split_lines(base);
+	std::string output;
+	output.reserve(full_size_);
+	for (const auto& op : delta_) {
+		if (op.base_count == 0) {
+			output.append(op.literal);
+			continue;
+		}
+		for (std::size_t i = op.base_line; i < op.base_line + op.base_count && i < base_lines.size(); ++i) {
+			output.append(base_lines[i]);
+		}
+	}
+	return output;
+}
+
+
+
+bool GscExecutorLogOutput::equals(std::string_view other, std::size_t other_hash) const
+{
+	if (hash_ != other_hash || full_size_ != other.size()) {
+		return false;
+	}
+	return output_ ? (*output_ == other) : (get() == other);
+}
+
+
+
+std::size_t GscExecutorLogOutput::get_hash() const
+{
+	return hash_;
+}
+
+
+
+std::size_t GscExecutorLogOutput::get_size() const
+{
+	std::size_t size = sizeof(GscExecutorLogOutput) + (output_ ? output_->size() : 0) + compressed_.size();
+	for (const auto& op : delta_) {
+		size += sizeof(DeltaOp) + op.literal.size();
+	}
+	return size;
+}
+
+
+
+std::size_t GscExecutorLogOutput::get_delta_depth() const
+{
+	return base_ ? (base_->get_delta_depth() + 1) : 0;
+}
+
+
+
+void GscExecutorLogOutput::pack(std::shared_ptr<const GscExecutorLogOutput> base, bool compress)
+{
+	if (packed_ || !output_ || output_->empty()) {
+		return;
+	}
+	packed_ = true;
+
+	// The base may have been delta-encoded against this output (if the latter is
+	// shared by a newer entry), don't make a cycle.
+	bool usable_base = (base != nullptr && base->get_delta_depth() < executor_log_max_delta_depth);
+	for (const GscExecutorLogOutput* p = base.get(); usable_base && p != nullptr; p = p->base_.get()) {
+		usable_base = (p != this);
+	}
+
+	if (usable_base) {
+		const std::string base_data = base->get();
+		const std::vector<std::string_view> base_lines = executor_log_split_lines(base_data);
+		std::vector<DeltaOp> delta;
+		std::size_t delta_size = 0;
+		std::size_t base_pos = 0;
+		for (const auto& line : executor_log_split_lines(*output_)) {
+			std::size_t found = base_lines.size();
+			for (std::size_t i = base_pos; i < base_lines.size() && i < base_pos + executor_log_delta_lookahead; ++i) {
+				if (base_lines[i] == line) {
+					found = i;
+					break;
+				}
+			}
+			if (found == base_lines.size()) {
+				if (delta.empty() || delta.back().base_count != 0) {
+					delta.emplace_back();
+					delta_size += sizeof(DeltaOp);
+				}
+				delta.back().literal.append(line);
+				delta_size += line.size();
+				continue;
+			}
+			if (delta.empty() || delta.back().base_count == 0
+					|| delta.back().base_line + delta.back().base_count != found) {
+				delta.push_back(DeltaOp{found, 0, {}});
+				delta_size += sizeof(DeltaOp);
+			}
+			++delta.back().base_count;
+			base_pos = found + 1;
+		}
+		// Keep the delta only if it's much smaller, the base has to be kept and unpacked too.
+		if (delta_size < output_->size() / 2) {
+			base_ = std::move(base);
+			delta_ = std::move(delta);
+			output_.reset();
+			update_size_counter();
+			return;
+		}
+	}
+
+	if (compress) {
+		auto compressed = executor_log_compress(*output_);
+		if (compressed && compressed->size() < output_->size()) {
+			compressed_ = std::move(compressed.value());
+			output_.reset();
+			update_size_counter();
+		}
+	}
+}
+
+
+
+void GscExecutorLogOutput::update_size_counter()
+{
+	size_counter_ -= size_;
+	size_ = get_size();
+	size_counter_ += size_;
+}
+
+
+
+std::size_t GscExecutorLogEntry::get_size() const
+{
+	std::size_t size = sizeof(GscExecutorLogEntry) + command.size() + error_message.size() + std_error.size();
+	for (const auto& param : parameters) {
+		size += sizeof(std::string) + param.size();
+	}
+	return size;
+}
+
+
+
+std::string GscExecutorLogEntry::get_command_line() const
+{
+	std::vector<std::string> command_line = {command};
+	command_line.insert(command_line.end(), parameters.begin(), parameters.end());
+	std::string str = hz::string_join(command_line, " ");
+	if (repeat_count > 1) {
+		str += " [" + std::to_string(repeat_count) + "x, last #" + std::to_string(last_number) + "]";
+	}
+	return str;
+}
+
+
+
+std::string GscExecutorLogEntry::get_std_output() const
+{
+	return std_output->get();
+}
+
+
+
+std::string GscExecutorLogEntry::get_std_error() const
+{
+	return compressed ? executor_log_decompress(std_error) : std_error;
+}
+
+
+
+void GscExecutorLogEntry::pack(bool compress)
+{
+	std_output->pack(previous_output.lock(), compress);
+	previous_output.reset();
+
+	if (!compress || compressed) {
+		return;
+	}
+	auto new_error = executor_log_compress(std_error);
+	if (new_error && new_error->size() < std_error.size()) {
+		std_error = std::move(new_error.value());
+		compressed = true;
+	}
+}
+
+
+
+GscExecutorLog& GscExecutorLog::get()
+{
+	static GscExecutorLog log;
+	return log;
+}
+
+
+
+void GscExecutorLog::start()
+{
+	if (started_) {
+		return;
+	}
+	started_ = true;
+	cmdex_sync_signal_execute_finish().connect(sigc::mem_fun(*this,
+			&GscExecutorLog::on_command_output_received));
+}
+
+
+
+const std::deque<GscExecutorLog::EntryPtr>& GscExecutorLog::get_entries() const
+{
+	return entries_;
+}
+
+
+
+void GscExecutorLog::clear()
+{
+	entries_.clear();
+	last_entries_.clear();
+	outputs_.clear();
+	entries_size_ = 0;
+	num_received_ = 0;
+	search_index_.clear();
+}
+
+
+
+std::vector<GscExecutorLog::EntryPtr> GscExecutorLog::find(std::string_view query, std::size_t after_number) const
+{
+	const std::vector<TextSearchIndex::DocumentId> numbers = search_index_.find(query);
+	std::vector<EntryPtr> found;
+	// Both are ascending, each search continues from the previous match
+	auto entry_iter = entries_.begin();
+	for (auto iter = std::upper_bound(numbers.begin(), numbers.end(), after_number); iter != numbers.end(); ++iter) {
+		entry_iter = std::lower_bound(entry_iter, entries_.end(), *iter,
+				[](const EntryPtr& entry, TextSearchIndex::DocumentId number) { return entry->number < number; });
+		if (entry_iter == entries_.end()) {
+			break;
+		}
+		if ((*entry_iter)->number == *iter) {
+			found.push_back(*entry_iter);
+		}
+	}
+	return found;
+}
+
+
+
+std::string GscExecutorLog::format_statistics()
+{
+	const StorageDeviceParseSkipStats skip_stats = StorageDevice::get_parse_skip_stats();
+	return cmdex_stats_format(cmdex_stats_get())
+			+ "\nFull data fetches with unchanged output (not parsed): "
+			+ std::to_string(skip_stats.hits) + " of " + std::to_string(skip_stats.hits + skip_stats.misses) + "\n";
+}
+
+
+
+std::size_t GscExecutorLog::get_memory_usage() const
+{
+	return entries_size_ + outputs_size_ + search_index_.get_memory_usage();
+}
+
+
+
+std::unordered_map<std::string, std::size_t> GscExecutorLog::get_memory_usage_by_device() const
+{
+	std::unordered_map<std::string, std::size_t> sizes;
+	std::unordered_map<std::string, std::unordered_set<const GscExecutorLogOutput*>> counted_outputs;
+	for (const auto& entry : entries_) {
+		if (entry->parameters.empty()) {
+			continue;
+		}
+		const std::string& device = entry->parameters.back();
+		std::size_t& size = sizes[device];
+		size += entry->get_size();
+		if (counted_outputs[device].insert(entry->std_output.get()).second) {
+			size += entry->std_output->get_size();
+		}
+	}
+	return sizes;
+}
+
+
+
+sigc::signal<void, GscExecutorLog::EntryPtr>& GscExecutorLog::signal_entry_added()
+{
+	return signal_entry_added_;
+}
+
+
+
+sigc::signal<void, GscExecutorLog::EntryPtr>& GscExecutorLog::signal_entry_changed()
+{
+	return signal_entry_changed_;
+}
+
+
+
+sigc::signal<void, GscExecutorLog::EntryPtr>& GscExecutorLog::signal_entry_removed()
+{
+	return signal_entry_removed_;
+}
+
+
+
+void GscExecutorLog::on_command_output_received(const CommandExecutorResult& info)
+{
+	auto std_output = store_output(info.std_output);
+
+	std::vector<std::string> command_line = {info.command};
+	command_line.insert(command_line.end(), info.parameters.begin(), info.parameters.end());
+	CommandKey key = hz::string_join(command_line, " ");
+
+	// Periodic refreshes and self-test polls often repeat the same results, collapse them.
+	auto last_entry = last_entries_[key].lock();
+	if (last_entry && last_entry->std_output == std_output
+			&& last_entry->error_message == info.error_message && last_entry->get_std_error() == info.std_error) {
+		last_entry->last_number = ++num_received_;
+		++last_entry->repeat_count;
+		signal_entry_changed_.emit(last_entry);
+		return;
+	}
+
+	auto entry = std::make_shared<GscExecutorLogEntry>();
+	entry->number = ++num_received_;
+	entry->last_number = entry->number;
+	entry->command = info.command;
+	entry->parameters = info.parameters;
+	entry->error_message = info.error_message;
+	entry->std_output = std::move(std_output);
+	entry->std_error = info.std_error;
+	if (last_entry) {
+		entry->previous_output = last_entry->std_output;
+	}
+
+	// The collapsed executions have the same text, so only the new entries are indexed
+	search_index_.add(entry->number, {key, info.error_message, info.std_error, *info.std_output});
+	last_entries_[std::move(key)] = entry;
+
+	entries_.push_back(entry);
+	entries_size_ += entry->get_size();
+	signal_entry_added_.emit(entry);
+	enforce_size_limit();
+}
+
+
+
+std::shared_ptr<GscExecutorLogOutput> GscExecutorLog::store_output(const CommandOutputPtr& output)
+{
+	const std::size_t hash = executor_log_hash(*output);
+	auto [begin, end] = outputs_.equal_range(hash);
+	for (auto iter = begin; iter != end; ) {
+		auto stored = iter->second.lock();
+		if (!stored) {
+			iter = outputs_.erase(iter);
+			continue;
+		}
+		if (stored->equals(*output, hash)) {
+			return stored;
+		}
+		++iter;
+	}
+	auto stored = std::make_shared<GscExecutorLogOutput>(output, hash, outputs_size_);
+	outputs_.emplace(hash, stored);
+	return stored;
+}
+
+
+
+void GscExecutorLog::enforce_size_limit()
+{
+	if (entries_.size() > executor_log_uncompressed_entries) {
+		auto& entry = entries_[entries_.size() - executor_log_uncompressed_entries - 1];
+		entries_size_ -= entry->get_size();
+		entry->pack(rconfig::get_data<bool>("gui/executor_log/compress"));
+		entries_size_ += entry->get_size();
+	}
+
+	const int max_size_kb = rconfig::get_data<int>("gui/executor_log/max_size_kb");
+	if (max_size_kb > 0) {
+		const auto max_size = static_cast<std::size_t>(max_size_kb) * 1024UL;
+		while (entries_.size() > 1  // always keep the last one
+				&& entries_size_ + outputs_size_ + search_index_.get_memory_usage() > max_size) {
+			const EntryPtr entry = entries_.front();
+			entries_.pop_front();
+			entries_size_ -= entry->get_size();
+			search_index_.remove_before(entries_.front()->number);
+			signal_entry_removed_.emit(entry);
+		}
+	}
+
+	// Forget the outputs and command lines of the dropped entries
+	if (outputs_.size() > 2 * entries_.size() + 16) {
+		for (auto iter = outputs_.begin(); iter != outputs_.end(); ) {
+			iter = (iter->second.expired() ? outputs_.erase(iter) : std::next(iter));
+		}
+		for (auto iter = last_entries_.begin(); iter != last_entries_.end(); ) {
+			iter = (iter->second.expired() ? last_entries_.erase(iter) : std::next(iter));
+		}
+	}
+}
+
+
+
 GscExecutorLogWindow::GscExecutorLogWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui)
 		: AppBuilderWidget<GscExecutorLogWindow, false>(gtkcobj, std::move(ui))
 {
@@ -42,10 +568,16 @@ GscExecutorLogWindow::GscExecutorLogWindow(BaseObjectType* gtkcobj, Glib::RefPtr
 	Gtk::Button* window_save_all_button = nullptr;
 	APP_BUILDER_AUTO_CONNECT(window_save_all_button, clicked);
 
+	Gtk::Button* window_statistics_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(window_statistics_button, clicked);
+
 
 	Gtk::Button* clear_command_list_button = nullptr;
 	APP_BUILDER_AUTO_CONNECT(clear_command_list_button, clicked);
 
+	Gtk::SearchEntry* command_search_entry = nullptr;
+	APP_BUILDER_AUTO_CONNECT(command_search_entry, search_changed);
+
 
 
 	// Accelerators
@@ -104,9 +636,14 @@ GscExecutorLogWindow::GscExecutorLogWindow(BaseObjectType* gtkcobj, Glib::RefPtr
 
 	// ---------------
 
-	// Connect to CommandExecutor signal
-	cmdex_sync_signal_execute_finish().connect(sigc::mem_fun(*this,
-			&GscExecutorLogWindow::on_command_output_received));
+	// Show the entries collected before the window was created, and follow the new ones
+	fill_entry_rows();
+	GscExecutorLog::get().signal_entry_added().connect(sigc::mem_fun(*this,
+			&GscExecutorLogWindow::on_log_entry_added));
+	GscExecutorLog::get().signal_entry_changed().connect(sigc::mem_fun(*this,
+			&GscExecutorLogWindow::on_log_entry_changed));
+	GscExecutorLog::get().signal_entry_removed().connect(sigc::mem_fun(*this,
+			&GscExecutorLogWindow::on_log_entry_removed));
 
 	// show();
 }
@@ -149,22 +686,111 @@ void GscExecutorLogWindow::clear_view_widgets()
 
 
 
-void GscExecutorLogWindow::on_command_output_received(const CommandExecutorResult& info)
+Gtk::TreeRow GscExecutorLogWindow::append_entry_row(const GscExecutorLog::EntryPtr& entry)
 {
-	auto entry = std::make_shared<CommandExecutorResult>(info);
-	entries_.push_back(entry);
-
-	std::vector<std::string> command = {info.command};
-	command.insert(command.end(), info.parameters.begin(), info.parameters.end());
-
-	// update tree model
 	const Gtk::TreeRow row = *(list_store_->append());
-	row[col_num_] = entries_.size();
-	row[col_command_] = hz::string_join(command, " ");
+	row[col_num_] = entry->number;
+	row[col_command_] = entry->get_command_line();
 	row[col_entry_] = entry;
+	entry->row = row;
+	return row;
+}
+
+
+
+void GscExecutorLogWindow::fill_entry_rows()
+{
+	// Entries not shown anymore must not refer to the rows
+	for (const auto& row : list_store_->children()) {
+		const GscExecutorLog::EntryPtr entry = row[col_entry_];
+		entry->row = Gtk::TreeIter();
+	}
+	list_store_->clear();  // this will unselect & clear widgets too.
+
+	const GscExecutorLog& log = GscExecutorLog::get();
+	search_last_number_ = log.get_entries().empty() ? 0 : log.get_entries().back()->number;
+	if (search_query_.empty()) {
+		for (const auto& entry : log.get_entries()) {
+			append_entry_row(entry);
+		}
+	} else {
+		// Only the newest matches are shown, a long list is better narrowed down by the query
+		const std::vector<GscExecutorLog::EntryPtr> matches = log.find(search_query_);
+		search_match_count_ = matches.size();
+		const std::size_t shown = std::min(matches.size(), executor_log_max_search_rows);
+		for (auto iter = matches.end() - static_cast<std::ptrdiff_t>(shown); iter != matches.end(); ++iter) {
+			append_entry_row(*iter);
+		}
+	}
+	update_search_status();
+}
+
+
+
+void GscExecutorLogWindow::schedule_search_update()
+{
+	if (search_update_scheduled_) {
+		return;
+	}
+	search_update_scheduled_ = true;
+	// Once for many log changes (e.g. a scan executing a lot of commands)
+	Glib::signal_idle().connect_once([this]() {
+		search_update_scheduled_ = false;
+		if (search_query_.empty()) {
+			return;
+		}
+		const GscExecutorLog& log = GscExecutorLog::get();
+		const std::vector<GscExecutorLog::EntryPtr> matches = log.find(search_query_);
+		search_match_count_ = matches.size();
+		auto iter = std::upper_bound(matches.begin(), matches.end(), search_last_number_,
+				[](std::size_t number, const GscExecutorLog::EntryPtr& entry) { return number < entry->number; });
+		for (; iter != matches.end(); ++iter) {
+			append_entry_row(*iter);
+		}
+		search_last_number_ = log.get_entries().empty() ? 0 : log.get_entries().back()->number;
+
+		while (list_store_->children().size() > executor_log_max_search_rows) {
+			const Gtk::TreeIter row = list_store_->children().begin();
+			GscExecutorLog::EntryPtr entry = (*row)[col_entry_];
+			entry->row = Gtk::TreeIter();
+			list_store_->erase(row);
+		}
+		update_search_status();
+	});
+}
+
+
+
+void GscExecutorLogWindow::update_search_status()
+{
+	auto* search_status_label = this->lookup_widget<Gtk::Label*>("search_status_label");
+	if (!search_status_label) {
+		return;
+	}
+	if (search_query_.empty()) {
+		search_status_label->set_text("");
+	} else if (search_match_count_ > list_store_->children().size()) {
+		search_status_label->set_text(Glib::ustring::compose(_("Newest %1 of %2 matches"),
+				list_store_->children().size(), search_match_count_));
+	} else {
+		search_status_label->set_text(Glib::ustring::compose(_("%1 matches"), search_match_count_));
+	}
+}
+
+
 
-	// if visible, set the selection to it
-	if (auto* treeview = this->lookup_widget<Gtk::TreeView*>("command_list_treeview")) {
+void GscExecutorLogWindow::on_log_entry_added(const GscExecutorLog::EntryPtr& entry)
+{
+	if (!search_query_.empty()) {
+		schedule_search_update();
+		return;
+	}
+
+	const Gtk::TreeRow row = append_entry_row(entry);
+
+	// If visible, set the selection to it. The text view is filled for the
+	// selected entry only, so don't do it while hidden (show_last() selects it).
+	if (auto* treeview = this->lookup_widget<Gtk::TreeView*>("command_list_treeview"); treeview && this->get_visible()) {
 		selection_->select(row);
 		treeview->scroll_to_row(list_store_->get_path(row));
 	}
@@ -172,6 +798,28 @@ void GscExecutorLogWindow::on_command_output_received(const CommandExecutorResul
 
 
 
+void GscExecutorLogWindow::on_log_entry_changed(const GscExecutorLog::EntryPtr& entry)
+{
+	if (entry->row) {
+		(*entry->row)[col_command_] = entry->get_command_line();
+	}
+}
+
+
+
+void GscExecutorLogWindow::on_log_entry_removed(const GscExecutorLog::EntryPtr& entry)
+{
+	if (entry->row) {
+		list_store_->erase(entry->row);  // this will unselect & clear widgets if needed.
+		entry->row = Gtk::TreeIter();
+	}
+	if (!search_query_.empty()) {
+		schedule_search_update();  // update the number of matches
+	}
+}
+
+
+
 bool GscExecutorLogWindow::on_delete_event([[maybe_unused]] GdkEventAny* e)
 {
 	on_window_close_button_clicked();
@@ -193,7 +841,7 @@ void GscExecutorLogWindow::on_window_save_current_button_clicked()
 		return;
 
 	const Gtk::TreeIter iter = selection_->get_selected();
-	const std::shared_ptr<CommandExecutorResult> entry = (*iter)[col_entry_];
+	const std::shared_ptr<GscExecutorLogEntry> entry = (*iter)[col_entry_];
 
 	static std::string last_dir;
 	if (last_dir.empty()) {
@@ -267,7 +915,7 @@ void GscExecutorLogWindow::on_window_save_current_button_clicked()
 				file += ".json";
 			}
 
-			auto ec = hz::fs_file_put_contents(file, entry->std_output);
+			auto ec = hz::fs_file_put_contents(file, entry->get_std_output());
 			if (ec) {
 				gui_show_error_dialog(_("Cannot save data to file"), ec.message(), this);
 			}
@@ -299,22 +947,29 @@ void GscExecutorLogWindow::on_window_save_all_button_clicked()
 
 	exss << "\n\n\n------------------------- EXECUTION LOG -------------------------\n\n\n";
 
-	for (std::size_t i = 0; i < entries_.size(); ++i) {
-		exss << "\n\n\n------------------------- EXECUTED COMMAND " << (i+1) << " -------------------------\n\n";
+	for (const auto& entry : GscExecutorLog::get().get_entries()) {
+		exss << "\n\n\n------------------------- EXECUTED COMMAND " << entry->number << " -------------------------\n\n";
 		exss << "\n---------------" << "Command" << "---------------\n";
-		exss << entries_[i]->command << "\n";
+		exss << entry->command << "\n";
 		exss << "\n---------------" << "Parameters" << "---------------\n";
-		for (const auto& param : entries_[i]->parameters) {
+		for (const auto& param : entry->parameters) {
 			exss << param << "\n";
 		}
+		if (entry->repeat_count > 1) {
+			exss << "\n---------------" << "Repeated" << "---------------\n";
+			exss << entry->repeat_count << " times, last as command " << entry->last_number << "\n";
+		}
 		exss << "\n---------------" << "STDOUT" << "---------------\n";
-		exss << entries_[i]->std_output << "\n\n";
+		exss << entry->get_std_output() << "\n\n";
 		exss << "\n---------------" << "STDERR" << "---------------\n";
-		exss << entries_[i]->std_error << "\n\n";
+		exss << entry->get_std_error() << "\n\n";
 		exss << "\n---------------" << "Error Message" << "---------------\n";
-		exss << entries_[i]->error_message << "\n\n";
+		exss << entry->error_message << "\n\n";
 	}
 
+	exss << "\n\n\n------------------------- EXECUTION STATISTICS -------------------------\n\n\n";
+	exss << GscExecutorLog::format_statistics() << "\n";
+
 
 	static std::string last_dir;
 	if (last_dir.empty()) {
@@ -407,10 +1062,40 @@ void GscExecutorLogWindow::on_window_save_all_button_clicked()
 
 
 
+void GscExecutorLogWindow::on_window_statistics_button_clicked()
+{
+	if (selection_) {
+		selection_->unselect_all();
+	}
+	this->clear_view_widgets();
+
+	if (auto* output_textview = this->lookup_widget<Gtk::TextView*>("output_textview")) {
+		const Glib::RefPtr<Gtk::TextBuffer> buffer = output_textview->get_buffer();
+		if (buffer) {
+			buffer->set_text(app_make_valid_utf8_from_command_output(GscExecutorLog::format_statistics()));
+
+			Glib::RefPtr<Gtk::TextTag> tag;
+			const Glib::RefPtr<Gtk::TextTagTable> table = buffer->get_tag_table();
+			if (table)
+				tag = table->lookup("font");
+			if (!tag)
+				tag = buffer->create_tag("font");
+
+			tag->property_family() = "Monospace";
+			buffer->apply_tag(tag, buffer->begin(), buffer->end());
+		}
+	}
+}
+
+
+
 void GscExecutorLogWindow::on_clear_command_list_button_clicked()
 {
-	entries_.clear();
+	GscExecutorLog::get().clear();
 	list_store_->clear();  // this will unselect & clear widgets too.
+	search_match_count_ = 0;
+	search_last_number_ = 0;
+	update_search_status();
 }
 
 
@@ -423,12 +1108,12 @@ void GscExecutorLogWindow::on_tree_selection_changed()
 		const Gtk::TreeIter iter = selection_->get_selected();
 		const Gtk::TreeRow& row = *iter;
 
-		const std::shared_ptr<CommandExecutorResult> entry = row[col_entry_];
+		const std::shared_ptr<GscExecutorLogEntry> entry = row[col_entry_];
 
 		if (auto* output_textview = this->lookup_widget<Gtk::TextView*>("output_textview")) {
 			const Glib::RefPtr<Gtk::TextBuffer> buffer = output_textview->get_buffer();
 			if (buffer) {
-				buffer->set_text(app_make_valid_utf8_from_command_output(entry->std_output));
+				buffer->set_text(app_make_valid_utf8_from_command_output(entry->get_std_output()));
 
 				Glib::RefPtr<Gtk::TextTag> tag;
 				const Glib::RefPtr<Gtk::TextTagTable> table = buffer->get_tag_table();
@@ -456,6 +1141,15 @@ void GscExecutorLogWindow::on_tree_selection_changed()
 
 
 
+void GscExecutorLogWindow::on_command_search_entry_search_changed()
+{
+	auto* command_search_entry = this->lookup_widget<Gtk::SearchEntry*>("command_search_entry");
+	search_query_ = hz::string_trim_copy(command_search_entry ? command_search_entry->get_text().raw() : std::string());
+	fill_entry_rows();
+}
+
+
+
 
 
 
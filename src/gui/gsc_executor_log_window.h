@@ -14,16 +14,224 @@ Copyright:
 
 #include <vector>
 #include <cstddef>  // std::size_t
+#include <deque>
 #include <gtkmm.h>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include "applib/app_builder_widget.h"
 #include "applib/command_executor.h"
+#include "applib/text_search_index.h"
 
 
 
 
-/// The "Execution Log" window.
+/// Stored stdout data of the execution log entries. Identical outputs are stored once
+/// (see GscExecutorLog). Older outputs are packed: kept as a line delta against the
+/// previous output of the same command, or compressed.
+class GscExecutorLogOutput {
+	public:
+
+		/// Constructor. \c size_counter is updated with the memory usage of this object
+		/// during its lifetime.
+		GscExecutorLogOutput(CommandOutputPtr output, std::size_t hash, std::size_t& size_counter);
+
+		/// Destructor
+		~GscExecutorLogOutput();
+
+		/// Deleted
+		GscExecutorLogOutput(const GscExecutorLogOutput& other) = delete;
+
+		/// Deleted
+		GscExecutorLogOutput(GscExecutorLogOutput&& other) = delete;
+
+		/// Deleted
+		GscExecutorLogOutput& operator=(const GscExecutorLogOutput&) = delete;
+
+		/// Deleted
+		GscExecutorLogOutput& operator=(GscExecutorLogOutput&&) = delete;
+
+
+		/// Get the output, unpacking it if needed
+		[[nodiscard]] std::string get() const;
+
+		/// Check whether the output equals \c other
+		[[nodiscard]] bool equals(std::string_view other, std::size_t other_hash) const;
+
+		/// Get the content hash of the (unpacked) output
+		[[nodiscard]] std::size_t get_hash() const;
+
+		/// Get the approximate memory usage, not including the delta base
+		[[nodiscard]] std::size_t get_size() const;
+
+		/// Get the number of deltas to apply to unpack the output
+		[[nodiscard]] std::size_t get_delta_depth() const;
+
+		/// Pack the output: encode it as a delta against \c base (if not nullptr and it makes
+		/// it smaller), or compress it (if \c compress is true). Does nothing if already packed.
+		void pack(std::shared_ptr<const GscExecutorLogOutput> base, bool compress);
+
+
+	private:
+
+		/// Delta operation: copy \c base_count lines of the base starting at \c base_line if
+		/// \c base_count is not 0, append \c literal otherwise.
+		struct DeltaOp {
+			std::size_t base_line = 0;  ///< First base line to copy
+			std::size_t base_count = 0;  ///< Number of base lines to copy
+			std::string literal;  ///< Literal data
+		};
+
+		/// Update the size counter after the data has changed
+		void update_size_counter();
+
+
+		CommandOutputPtr output_;  ///< Unpacked output, shared with the command's users. nullptr if packed.
+		std::string compressed_;  ///< Compressed output, if compressed
+		std::shared_ptr<const GscExecutorLogOutput> base_;  ///< Delta base, if delta-encoded
+		std::vector<DeltaOp> delta_;  ///< Delta against base_, if delta-encoded
+		std::size_t hash_ = 0;  ///< Content hash
+		std::size_t full_size_ = 0;  ///< Size of the unpacked output
+		bool packed_ = false;  ///< Whether pack() was called
+		std::size_t size_ = 0;  ///< Memory usage, as added to size_counter_
+		std::size_t& size_counter_;  ///< Total memory usage of the outputs
+
+};
+
+
+
+/// An execution log entry. The executions of the same command line with the same
+/// results are collapsed into its last entry.
+struct GscExecutorLogEntry {
+	std::size_t number = 0;  ///< 1-based command number
+	std::size_t last_number = 0;  ///< 1-based command number of the last collapsed execution
+	std::size_t repeat_count = 1;  ///< Number of collapsed executions
+	std::string command;  ///< Executed command
+	std::vector<std::string> parameters;  ///< Command parameters
+	std::string error_message;  ///< Execution error message
+	std::shared_ptr<GscExecutorLogOutput> std_output;  ///< Stdout data, possibly shared with other entries. Never nullptr.
+	std::weak_ptr<const GscExecutorLogOutput> previous_output;  ///< Previous stdout data of the same command line (delta base), until packed
+	std::string std_error;  ///< Stderr data (compressed if \c compressed is true)
+	bool compressed = false;  ///< Whether std_error is compressed
+	Gtk::TreeIter row;  ///< Tree row of this entry, if the window exists (list store iterators are persistent)
+
+	/// Get the approximate memory usage of the entry, not including std_output (see GscExecutorLog)
+	[[nodiscard]] std::size_t get_size() const;
+
+	/// Get the command line, with the number of collapsed executions
+	[[nodiscard]] std::string get_command_line() const;
+
+	/// Get stdout data, unpacking it if needed
+	[[nodiscard]] std::string get_std_output() const;
+
+	/// Get stderr data, decompressing it if needed
+	[[nodiscard]] std::string get_std_error() const;
+
+	/// Pack the stdout data against previous_output (see GscExecutorLogOutput::pack()) and
+	/// compress the stderr data if \c compress is true.
+	void pack(bool compress);
+};
+
+
+
+/// Collects the command executor results shown in the "Execution Log" window.
+/// It's started on application startup, so that the window itself can be created
+/// only when it's shown for the first time.
+class GscExecutorLog {
+	public:
+
+		/// Entry pointer
+		using EntryPtr = std::shared_ptr<GscExecutorLogEntry>;
+
+
+		/// Get the application-wide log
+		static GscExecutorLog& get();
+
+
+		/// Start collecting the command executor results. Does nothing if already started.
+		void start();
+
+
+		/// Get the entries, oldest first
+		[[nodiscard]] const std::deque<EntryPtr>& get_entries() const;
+
+
+		/// Remove all entries
+		void clear();
+
+
+		/// Find the entries containing all the words of \c query in their command line, error message,
+		/// stderr or stdout data (see TextSearchIndex::find()), oldest first. Only the entries with
+		/// numbers larger than \c after_number are returned.
+		[[nodiscard]] std::vector<EntryPtr> find(std::string_view query, std::size_t after_number = 0) const;
+
+
+		/// Format the command execution statistics and the unchanged-output statistics of the drives
+		[[nodiscard]] static std::string format_statistics();
+
+
+		/// Get the approximate memory usage of the entries, the stored outputs and the search index
+		[[nodiscard]] std::size_t get_memory_usage() const;
+
+
+		/// Get the approximate memory usage of the entries of each device (the last command parameter,
+		/// see execute_smartctl()), with their outputs. An output shared by several entries of
+		/// a device is counted once for it, but it may be counted for several devices.
+		[[nodiscard]] std::unordered_map<std::string, std::size_t> get_memory_usage_by_device() const;
+
+
+		/// Emitted after an entry has been added
+		sigc::signal<void, EntryPtr>& signal_entry_added();
+
+
+		/// Emitted after another execution has been collapsed into an entry
+		sigc::signal<void, EntryPtr>& signal_entry_changed();
+
+
+		/// Emitted after an entry has been dropped to keep the log within its size limit
+		sigc::signal<void, EntryPtr>& signal_entry_removed();
+
+
+	private:
+
+		/// Callback attached to CommandExecutor, adds entries in real time.
+		void on_command_output_received(const CommandExecutorResult& info);
+
+
+		/// Get the stored output equal to \c output, adding it to the store if needed
+		std::shared_ptr<GscExecutorLogOutput> store_output(const CommandOutputPtr& output);
+
+
+		/// Pack old entries and drop the oldest ones to keep the log within its size limit
+		void enforce_size_limit();
+
+
+		/// Output store key (content hash)
+		using OutputKey = std::size_t;
+
+		/// Command line, as in GscExecutorLogEntry::get_command_line() of a single execution
+		using CommandKey = std::string;
+
+		bool started_ = false;  ///< Whether start() was called
+		std::size_t outputs_size_ = 0;  ///< Total size of the stored outputs (declared before the users)
+		std::unordered_multimap<OutputKey, std::weak_ptr<GscExecutorLogOutput>> outputs_;  ///< Content-addressed output store, keyed by hash
+		std::unordered_map<CommandKey, std::weak_ptr<GscExecutorLogEntry>> last_entries_;  ///< Last entry of each command line
+		std::deque<EntryPtr> entries_;  ///< Command information entries, oldest first
+		std::size_t entries_size_ = 0;  ///< Total size of entries_, see GscExecutorLogEntry::get_size()
+		std::size_t num_received_ = 0;  ///< Number of commands received since the last clear
+		TextSearchIndex search_index_;  ///< Search index of the entries, by their numbers
+
+		sigc::signal<void, EntryPtr> signal_entry_added_;  ///< Signal
+		sigc::signal<void, EntryPtr> signal_entry_changed_;  ///< Signal
+		sigc::signal<void, EntryPtr> signal_entry_removed_;  ///< Signal
+
+};
+
+
+
+/// The "Execution Log" window, showing the entries of GscExecutorLog.
 /// Use create() / destroy() with this class instead of new / delete!
 class GscExecutorLogWindow : public AppBuilderWidget<GscExecutorLogWindow, false> {
 	public:
@@ -50,8 +258,32 @@ class GscExecutorLogWindow : public AppBuilderWidget<GscExecutorLogWindow, false
 
 		// -------------------- callbacks
 
-		/// Callback attached to external source, adds entries in real time.
-		void on_command_output_received(const CommandExecutorResult& info);
+		/// Add a row for a log entry
+		Gtk::TreeRow append_entry_row(const GscExecutorLog::EntryPtr& entry);
+
+
+		/// Fill the list with the entries matching the search query (all of them if it's empty)
+		void fill_entry_rows();
+
+
+		/// Append the rows of the new entries matching the search query, in idle time
+		void schedule_search_update();
+
+
+		/// Show the number of the entries matching the search query
+		void update_search_status();
+
+
+		/// Callback attached to GscExecutorLog, adds entries in real time.
+		void on_log_entry_added(const GscExecutorLog::EntryPtr& entry);
+
+
+		/// Callback attached to GscExecutorLog
+		void on_log_entry_changed(const GscExecutorLog::EntryPtr& entry);
+
+
+		/// Callback attached to GscExecutorLog
+		void on_log_entry_removed(const GscExecutorLog::EntryPtr& entry);
 
 
 
@@ -73,24 +305,32 @@ class GscExecutorLogWindow : public AppBuilderWidget<GscExecutorLogWindow, false
 		/// Button click callback
 		void on_window_save_all_button_clicked();
 
+		/// Button click callback
+		void on_window_statistics_button_clicked();
+
 		/// Button click callback
 		void on_clear_command_list_button_clicked();
 
 		/// Callback
 		void on_tree_selection_changed();
 
+		/// Search entry callback
+		void on_command_search_entry_search_changed();
 
-	private:
-
-		std::vector<std::shared_ptr<CommandExecutorResult>> entries_;  ///< Command information entries
 
+	private:
 
 		Glib::RefPtr<Gtk::ListStore> list_store_;  ///< List store
 		Glib::RefPtr<Gtk::TreeSelection> selection_;  ///< Tree selection
 
 		Gtk::TreeModelColumn<std::size_t> col_num_;  ///< Tree column
 		Gtk::TreeModelColumn<std::string> col_command_;  ///< Tree column
-		Gtk::TreeModelColumn<std::shared_ptr<CommandExecutorResult>> col_entry_;  ///< Tree column
+		Gtk::TreeModelColumn<std::shared_ptr<GscExecutorLogEntry>> col_entry_;  ///< Tree column
+
+		std::string search_query_;  ///< Current search query, empty if not searching
+		std::size_t search_match_count_ = 0;  ///< Number of the entries matching search_query_
+		std::size_t search_last_number_ = 0;  ///< Number of the last entry checked against search_query_
+		bool search_update_scheduled_ = false;  ///< Whether the search update is scheduled
 
 
 };
@@ -0,0 +1,442 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <gtkmm.h>
+#include <gdk/gdk.h>  // GDK_KEY_Escape
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+#include "hz/debug.h"
+#include "hz/format_unit.h"  // format_size
+#include "hz/string_algo.h"  // string_join
+#include "hz/string_num.h"  // number_to_string_locale
+#include "rconfig/rconfig.h"
+
+#include "applib/app_gtkmm_tools.h"  // app_gtkmm_*
+#include "applib/gui_utils.h"  // gui_show_error_dialog
+#include "applib/warning_colors.h"
+
+#include "gsc_fleet_window.h"
+#include "gsc_main_window.h"
+
+
+
+namespace {
+
+	/// Format an optional summary counter, empty if unknown
+	template<typename T>
+	Glib::ustring fleet_format_counter(const std::optional<T>& value)
+	{
+		return value.has_value() ? Glib::ustring(hz::number_to_string_locale(value.value())) : Glib::ustring();
+	}
+
+}
+
+
+
+GscFleetWindow::GscFleetWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui)
+		: AppBuilderWidget<GscFleetWindow, false>(gtkcobj, std::move(ui))
+{
+	// Connect callbacks
+
+	Gtk::Button* window_close_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(window_close_button, clicked);
+
+	Gtk::Button* previous_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(previous_button, clicked);
+
+	Gtk::Button* next_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(next_button, clicked);
+
+	if (auto* search_entry = this->lookup_widget<Gtk::SearchEntry*>("search_entry")) {
+		search_entry->signal_search_changed().connect(sigc::mem_fun(*this, &GscFleetWindow::on_search_entry_changed));
+	}
+	if (auto* problems_only_check = this->lookup_widget<Gtk::CheckButton*>("problems_only_check")) {
+		problems_only_check->signal_toggled().connect(sigc::mem_fun(*this, &GscFleetWindow::on_search_entry_changed));
+	}
+
+
+	// Accelerators
+
+	const Glib::RefPtr<Gtk::AccelGroup> accel_group = this->get_accel_group();
+	if (window_close_button) {
+		window_close_button->add_accelerator("clicked", accel_group, GDK_KEY_Escape,
+				Gdk::ModifierType(0), Gtk::AccelFlags(0));
+	}
+
+
+	// --------------- Make a treeview
+
+	treeview_ = this->lookup_widget<Gtk::TreeView*>("fleet_treeview");
+	if (treeview_) {
+		Gtk::TreeModelColumnRecord model_columns;
+
+		// Highlight the rows by their warnings
+		const auto add_column = [&](const Gtk::TreeModelColumn<Glib::ustring>& column,
+				const Glib::ustring& title, const Glib::ustring& tooltip) {
+			model_columns.add(column);
+			const int num_tree_cols = app_gtkmm_create_tree_view_column(column, *treeview_, title, tooltip, false);
+			Gtk::TreeViewColumn* tcol = treeview_->get_column(num_tree_cols - 1);
+			tcol->set_cell_data_func(*(tcol->get_first_cell()), [this](Gtk::CellRenderer* cr, const Gtk::TreeModel::iterator& iter) {
+				auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr);
+				if (!crt) {
+					return;
+				}
+				std::string fg, bg;
+				if (app_property_get_row_highlight_colors(static_cast<WarningLevel>(int((*iter)[col_warning_])), fg, bg)) {
+					crt->property_cell_background() = bg;
+					crt->property_foreground() = fg;
+				} else {
+					crt->property_cell_background().reset_value();
+					crt->property_foreground().reset_value();
+				}
+			});
+		};
+
+		add_column(col_host_, _("Host"), _("Remote host of the drive"));
+		add_column(col_device_, _("Device"), _("Device on the remote host"));
+		add_column(col_model_, _("Model"), _("Drive model"));
+		add_column(col_serial_, _("Serial Number"), _("Drive serial number"));
+		add_column(col_health_, _("Health"), _("SMART overall health self-assessment"));
+		add_column(col_temperature_, _("Temperature"), _("Current temperature, in degrees Celsius"));
+		add_column(col_power_on_hours_, _("Power-On Hours"), _("Power-on time, in hours"));
+		add_column(col_percentage_used_, _("Used"), _("Percentage of the rated endurance used (SSDs)"));
+		add_column(col_risk_, _("Risk Score"), _("Sum of the risk weights of the failure-predicting attributes"));
+
+		model_columns.add(col_tooltip_);
+		treeview_->set_tooltip_column(col_tooltip_.index());
+
+		model_columns.add(col_warning_);
+		model_columns.add(col_index_);
+
+		list_store_ = Gtk::ListStore::create(model_columns);
+		treeview_->set_model(list_store_);
+
+		treeview_->signal_row_activated().connect(sigc::mem_fun(*this, &GscFleetWindow::on_tree_row_activated));
+	}
+
+	// show();
+}
+
+
+
+GscFleetWindow::~GscFleetWindow()
+{
+	for (auto& agent : agents_) {
+		agent->executor->set_output_chunk_callback(nullptr);
+		agent->executor->set_exited_callback(nullptr);
+		if (agent->executor->is_running()) {
+			agent->executor->try_kill();
+			// Its child watch still refers to it, so it can't be destroyed before the process exits.
+			static_cast<void>(agent->executor.release());
+		}
+	}
+}
+
+
+
+void GscFleetWindow::set_main_window(GscMainWindow* main_window)
+{
+	main_window_ = main_window;
+}
+
+
+
+void GscFleetWindow::start_agents()
+{
+	remote_hosts_ = remote_hosts_get_configured();
+	if (remote_hosts_.empty()) {
+		gui_show_error_dialog(_("No remote hosts are configured"),
+				_("Add the SSH destinations of the hosts running gsmartcontrol-agent to the remote hosts in the preferences."), this);
+		return;
+	}
+
+	const auto agent_binary = rconfig::get_data<std::string>("system/remote_agent_binary");
+	for (const auto& remote_host : remote_hosts_) {
+		const std::size_t host = table_.add_host(remote_host->get_destination());
+		if (std::any_of(agents_.begin(), agents_.end(), [host](const auto& agent) { return agent->host == host; })) {
+			continue;  // still running (or stopping)
+		}
+
+		// The drive IDs are per stream, the new stream sends all the drives again.
+		table_.clear_host(host);
+		table_.set_host_error(host, std::string());
+
+		auto agent = std::make_unique<Agent>();
+		agent->host = host;
+		agent->decoder = std::make_unique<StorageAgentStreamDecoder>(StorageAgentDecoderMode::Summary);
+		agent->executor = std::make_unique<AsyncCommandExecutor>();
+
+		auto [command, args] = remote_host->wrap_command(agent_binary, {});
+		agent->executor->set_command(std::move(command), std::move(args));
+
+		// The stream never ends, so it's consumed as it arrives instead of being accumulated.
+		agent->executor->set_streaming(true);
+		Agent* agent_ptr = agent.get();
+		agent->executor->set_output_chunk_callback([this, agent_ptr](AsyncCommandExecutor::Channel channel, std::string_view chunk) {
+			on_agent_output(*agent_ptr, channel, chunk);
+		});
+		// This is called from the child watch handler, which may not clean up after itself.
+		agent->executor->set_exited_callback([this, agent_ptr]() {
+			Glib::signal_idle().connect_once([this, agent_ptr]() {
+				on_agent_exited(*agent_ptr);
+			});
+		});
+
+		if (!agent->executor->execute()) {
+			const auto errors = agent->executor->get_errors();
+			table_.set_host_error(host, errors.empty() ? std::string(_("Cannot run ssh.")) : errors.back()->get_message());
+			continue;
+		}
+		debug_out_info("app", DBG_FUNC_MSG << "Started the agent on \"" << remote_host->get_destination() << "\".\n");
+		agents_.push_back(std::move(agent));
+	}
+
+	update_page();
+}
+
+
+
+void GscFleetWindow::stop_agents()
+{
+	// The agents are removed when they exit, see on_agent_exited().
+	for (auto& agent : agents_) {
+		agent->executor->try_stop();
+	}
+}
+
+
+
+void GscFleetWindow::on_agent_output(Agent& agent, AsyncCommandExecutor::Channel channel, std::string_view chunk)
+{
+	if (channel == AsyncCommandExecutor::Channel::StandardError) {
+		agent.last_stderr = chunk;
+		static_cast<void>(agent.executor->get_stderr_str(true));
+		return;
+	}
+
+	const std::string data = agent.executor->take_stdout_str();  // includes the chunk
+	if (!table_.get_hosts().at(agent.host).error.empty()) {
+		return;  // the stream is broken, the agent is being stopped
+	}
+	if (auto status = agent.decoder->feed(data); !status) {
+		table_.set_host_error(agent.host, status.error().message());
+		agent.executor->try_stop();
+	}
+	if (table_.update(agent.host, *agent.decoder)) {
+		schedule_page_update();
+	}
+}
+
+
+
+void GscFleetWindow::on_agent_exited(Agent& agent)
+{
+	agent.executor->stopped_cleanup();
+
+	if (table_.get_hosts().at(agent.host).error.empty() && agent.executor->get_execution_timing().kill_signal == 0) {
+		std::string message = hz::string_trim_copy(agent.last_stderr);
+		if (message.empty()) {
+			const auto errors = agent.executor->get_errors();
+			message = errors.empty() ? std::string(_("The agent exited.")) : errors.back()->get_message();
+		}
+		table_.set_host_error(agent.host, message);
+	}
+	debug_out_info("app", DBG_FUNC_MSG << "The agent on \"" << table_.get_hosts().at(agent.host).destination << "\" exited.\n");
+
+	std::erase_if(agents_, [&agent](const auto& a) { return a.get() == &agent; });
+	schedule_page_update();
+}
+
+
+
+void GscFleetWindow::schedule_page_update()
+{
+	if (page_update_scheduled_) {
+		return;
+	}
+	page_update_scheduled_ = true;
+	// Many updates arrive at once after each refresh of the agents
+	Glib::signal_timeout().connect_once([this]() {
+		page_update_scheduled_ = false;
+		update_page();
+	}, 500);
+}
+
+
+
+void GscFleetWindow::update_page()
+{
+	if (!list_store_) {
+		return;
+	}
+	const auto page_size = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("gui/fleet_page_size")));
+
+	StorageFleetPage page = table_.get_page(filter_, page_offset_, page_size);
+	if (page_offset_ >= page.total && page.total > 0) {  // the drives at the end are gone
+		page_offset_ = (page.total - 1) / page_size * page_size;
+		page = table_.get_page(filter_, page_offset_, page_size);
+	}
+	const std::vector<StorageFleetRow> old_rows = std::exchange(page_rows_, std::move(page.rows));
+	page_total_ = page.total;
+
+	// Keep the selected drive selected
+	std::optional<std::pair<std::size_t, std::uint64_t>> selected;
+	if (treeview_) {
+		if (auto iter = treeview_->get_selection()->get_selected()) {
+			// page_rows_ still has the old page here
+			const auto old_index = static_cast<std::size_t>(int((*iter)[col_index_]));
+			if (old_index < old_rows.size()) {
+				selected = std::pair(old_rows[old_index].host, old_rows[old_index].drive_id);
+			}
+		}
+	}
+
+	list_store_->clear();
+	for (std::size_t i = 0; i < page_rows_.size(); ++i) {
+		const StorageFleetRow& fleet_row = page_rows_[i];
+		const StorageAgentDriveSummary& summary = fleet_row.summary;
+		Gtk::TreeRow row = *(list_store_->append());
+		row[col_host_] = table_.get_hosts().at(fleet_row.host).destination;
+		row[col_device_] = fleet_row.device + (fleet_row.type_argument.empty() ? std::string() : (" (" + fleet_row.type_argument + ")"));
+		row[col_model_] = summary.model;
+		row[col_serial_] = summary.serial;
+		switch (summary.health) {
+			case StorageAgentDriveHealth::Unknown: row[col_health_] = Glib::ustring(); break;
+			case StorageAgentDriveHealth::Passed: row[col_health_] = _("PASSED"); break;
+			case StorageAgentDriveHealth::Failed: row[col_health_] = _("FAILED"); break;
+		}
+		row[col_temperature_] = fleet_format_counter(summary.temperature);
+		row[col_power_on_hours_] = fleet_format_counter(summary.power_on_hours);
+		row[col_percentage_used_] = summary.percentage_used.has_value()
+				? Glib::ustring::compose("%1%%", summary.percentage_used.value()) : Glib::ustring();
+		row[col_risk_] = (summary.risk_score != 0) ? hz::number_to_string_locale(summary.risk_score) : std::string();
+		row[col_tooltip_] = fleet_row.error.empty() ? Glib::ustring()
+				: Glib::ustring::compose(_("The last update failed: %1"), fleet_row.error);
+		row[col_warning_] = static_cast<int>(summary.worst_warning);
+		row[col_index_] = static_cast<int>(i);
+	}
+	if (selected.has_value() && treeview_) {
+		auto row_iter = std::find_if(page_rows_.begin(), page_rows_.end(), [&selected](const StorageFleetRow& fleet_row) {
+			return fleet_row.host == selected->first && fleet_row.drive_id == selected->second;
+		});
+		if (row_iter != page_rows_.end()) {
+			treeview_->get_selection()->select(list_store_->children()[static_cast<unsigned int>(row_iter - page_rows_.begin())]);
+		}
+	}
+
+	if (auto* previous_button = this->lookup_widget<Gtk::Button*>("previous_button")) {
+		previous_button->set_sensitive(page_offset_ > 0);
+	}
+	if (auto* next_button = this->lookup_widget<Gtk::Button*>("next_button")) {
+		next_button->set_sensitive(page_offset_ + page_size < page_total_);
+	}
+
+	if (auto* status_label = this->lookup_widget<Gtk::Label*>("status_label")) {
+		std::vector<std::string> host_errors;
+		for (const auto& host : table_.get_hosts()) {
+			if (!host.error.empty()) {
+				host_errors.push_back(host.destination + ": " + host.error);
+			}
+		}
+		Glib::ustring text = (page_total_ == 0) ? Glib::ustring(_("No drives."))
+				: Glib::ustring::compose(_("Drives %1-%2 of %3 (%4 in total, %5 of memory)."),
+						page_offset_ + 1, page_offset_ + page_rows_.size(), page_total_, table_.size(),
+						hz::format_size(table_.get_memory_usage(), true));
+		if (!host_errors.empty()) {
+			text += " " + Glib::ustring::compose(_("%1 of %2 hosts have errors."), host_errors.size(), table_.get_hosts().size());
+		}
+		status_label->set_text(text);
+		status_label->set_tooltip_text(hz::string_join(host_errors, "\n"));
+	}
+}
+
+
+
+bool GscFleetWindow::on_delete_event([[maybe_unused]] GdkEventAny* e)
+{
+	on_window_close_button_clicked();
+	return true;  // event handled
+}
+
+
+
+void GscFleetWindow::on_window_close_button_clicked()
+{
+	// The summaries are kept, but they're not updated while hidden.
+	stop_agents();
+	this->hide();  // hide only, don't destroy
+}
+
+
+
+void GscFleetWindow::on_previous_button_clicked()
+{
+	const auto page_size = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("gui/fleet_page_size")));
+	page_offset_ -= std::min(page_offset_, page_size);
+	update_page();
+}
+
+
+
+void GscFleetWindow::on_next_button_clicked()
+{
+	const auto page_size = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("gui/fleet_page_size")));
+	if (page_offset_ + page_size < page_total_) {
+		page_offset_ += page_size;
+	}
+	update_page();
+}
+
+
+
+void GscFleetWindow::on_search_entry_changed()
+{
+	auto* search_entry = this->lookup_widget<Gtk::SearchEntry*>("search_entry");
+	auto* problems_only_check = this->lookup_widget<Gtk::CheckButton*>("problems_only_check");
+	filter_ = StorageDeviceFilter::create(search_entry ? search_entry->get_text().raw() : std::string(),
+			(problems_only_check && problems_only_check->get_active()) ? WarningLevel::Notice : WarningLevel::None);
+	page_offset_ = 0;
+	update_page();
+}
+
+
+
+void GscFleetWindow::on_tree_row_activated(const Gtk::TreeModel::Path& path, [[maybe_unused]] Gtk::TreeViewColumn* column)
+{
+	auto iter = list_store_->get_iter(path);
+	if (!iter || !main_window_) {
+		return;
+	}
+	const auto index = static_cast<std::size_t>(int((*iter)[col_index_]));
+	if (index >= page_rows_.size()) {
+		return;
+	}
+
+	// Only the summary is here, the full data is fetched from the host.
+	auto drive = table_.make_drive(page_rows_[index], remote_hosts_);
+	if (!drive) {
+		gui_show_error_dialog(_("Cannot open the drive"),
+				_("The host of the drive is not in the remote hosts anymore."), this);
+		return;
+	}
+	main_window_->open_remote_drive(drive);
+}
+
+
+
+
+
+
+/// @}
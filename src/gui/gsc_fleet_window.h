@@ -0,0 +1,148 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_FLEET_WINDOW_H
+#define GSC_FLEET_WINDOW_H
+
+#include <gtkmm.h>
+#include <cstddef>  // std::size_t
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "applib/app_builder_widget.h"
+#include "applib/async_command_executor.h"
+#include "applib/storage_fleet.h"
+
+
+class GscMainWindow;
+
+
+
+/// The "Fleet View" window. It runs gsmartcontrol-agent on each configured remote host
+/// over SSH and keeps only the summary of each drive (see StorageFleetTable), updated
+/// as the agent streams the changes. The drives are shown a page at a time, the most
+/// troubled first. Opening a drive fetches its full data from its host into the main window.
+/// Use create() / destroy() with this class instead of new / delete!
+class GscFleetWindow : public AppBuilderWidget<GscFleetWindow, false> {
+	public:
+
+		// name of ui file (without .ui extension) for AppBuilderWidget
+		static inline const std::string_view ui_name = "gsc_fleet_window";
+
+
+		/// Constructor, GtkBuilder needs this.
+		GscFleetWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui);
+
+		/// Destructor, stops the agents.
+		~GscFleetWindow() override;
+
+
+		/// Set the main window to open the drives in
+		void set_main_window(GscMainWindow* main_window);
+
+
+		/// Start the agents of the configured remote hosts which are not running yet
+		void start_agents();
+
+
+	protected:
+
+		/// An agent running on a remote host
+		struct Agent {
+			std::size_t host = 0;  ///< Host index in table_
+			std::unique_ptr<AsyncCommandExecutor> executor;  ///< ssh process
+			std::unique_ptr<StorageAgentStreamDecoder> decoder;  ///< Decoder of its stdout
+			std::string last_stderr;  ///< The last stderr chunk, for the error message
+		};
+
+
+		/// Stop all agents
+		void stop_agents();
+
+		/// Feed the received stdout data to the decoder of an agent
+		void on_agent_output(Agent& agent, AsyncCommandExecutor::Channel channel, std::string_view chunk);
+
+		/// Clean up after an agent exited
+		void on_agent_exited(Agent& agent);
+
+		/// Update the page in idle time, once for many stream updates
+		void schedule_page_update();
+
+		/// Fill the tree view with the current page
+		void update_page();
+
+
+		// ---------- overridden virtual methods
+
+		/// Hide the window, don't destroy.
+		/// Reimplemented from Gtk::Window.
+		bool on_delete_event(GdkEventAny* e) override;
+
+
+		// ---------- other callbacks
+
+		/// Button click callback
+		void on_window_close_button_clicked();
+
+		/// Button click callback
+		void on_previous_button_clicked();
+
+		/// Button click callback
+		void on_next_button_clicked();
+
+		/// Entry change callback
+		void on_search_entry_changed();
+
+		/// Row activation callback, opens the drive in the main window
+		void on_tree_row_activated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
+
+
+	private:
+
+		GscMainWindow* main_window_ = nullptr;  ///< The main window to open the drives in
+
+		StorageFleetTable table_;  ///< Drive summaries
+		std::vector<RemoteHostPtr> remote_hosts_;  ///< Remote hosts the agents run on
+		std::vector<std::unique_ptr<Agent>> agents_;  ///< Running agents
+
+		StorageDeviceFilter filter_;  ///< Filter of the shown drives
+		std::size_t page_offset_ = 0;  ///< Index of the first shown drive
+		std::size_t page_total_ = 0;  ///< Number of drives matching filter_
+		std::vector<StorageFleetRow> page_rows_;  ///< Shown drives
+		bool page_update_scheduled_ = false;  ///< Whether update_page() is scheduled
+
+		Gtk::TreeView* treeview_ = nullptr;  ///< Tree view
+		Glib::RefPtr<Gtk::ListStore> list_store_;  ///< List store
+		Gtk::TreeModelColumn<Glib::ustring> col_host_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_device_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_model_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_serial_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_health_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_temperature_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_power_on_hours_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_percentage_used_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_risk_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_tooltip_;  ///< Tree column
+		Gtk::TreeModelColumn<int> col_warning_;  ///< Tree column, WarningLevel
+		Gtk::TreeModelColumn<int> col_index_;  ///< Tree column, index in page_rows_
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,284 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined __linux__
+	#include <unistd.h>  // sysconf
+#endif
+
+#include "fmt/format.h"
+
+#include "hz/debug.h"
+#include "hz/fs.h"
+#include "hz/string_num.h"
+#include "applib/storage_device.h"
+#include "applib/storage_output_compression.h"
+
+#include "gsc_init.h"  // app_quit()
+#include "gsc_info_window.h"
+#include "gsc_main_window.h"
+#include "gsc_gui_benchmark.h"
+
+
+
+namespace {
+
+
+	/// Main loop heartbeat interval. The stalls are the heartbeats late by more than that.
+	constexpr std::chrono::milliseconds heartbeat_interval{10};
+
+	/// A heartbeat late by this much is a noticeable stall
+	constexpr std::chrono::milliseconds noticeable_stall{100};
+
+
+
+	/// Get the resident set size of the process in bytes, 0 if unsupported
+	std::uint64_t get_resident_bytes()
+	{
+#if defined __linux__
+		std::string statm;
+		if (hz::fs_file_get_contents_unseekable(hz::fs_path_from_string("/proc/self/statm"), statm)) {
+			return 0;
+		}
+		// "size resident shared ...", in pages
+		std::uint64_t resident_pages = 0;
+		const auto begin = statm.find(' ');
+		if (begin == std::string::npos
+				|| !hz::string_is_numeric_nolocale(statm.substr(begin + 1, statm.find(' ', begin + 1) - begin - 1), resident_pages, false)) {
+			return 0;
+		}
+		return resident_pages * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+		return 0;
+#endif
+	}
+
+
+
+	/// Get the time since \c start in milliseconds
+	double get_elapsed_ms(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+
+
+	/// State of a running benchmark, shared by its main loop callbacks
+	struct GuiBenchmark {
+		GscMainWindow* main_window = nullptr;  ///< Main window
+		std::vector<std::string> templates;  ///< Outputs the drives are copies of
+		std::size_t drive_count = 0;  ///< Number of drives
+		std::size_t info_window_count = 0;  ///< Number of info windows
+
+		std::vector<StorageDevicePtr> drives;  ///< Created drives
+		std::vector<std::shared_ptr<GscInfoWindow>> info_windows;  ///< Opened info windows
+
+		double parse_ms = 0;  ///< Time to create and parse the drives
+		std::uint64_t drives_resident_bytes = 0;  ///< Memory taken by the drives, before adding them to the window
+		std::uint64_t total_resident_bytes = 0;  ///< Memory taken by the drives, with the icons and the info windows
+		std::uint64_t start_resident_bytes = 0;  ///< Resident set size at the start
+		double populate_ms = 0;  ///< Time to add the drives to the icon view
+		double populate_until_idle_ms = 0;  ///< Same, until the main loop is idle again (the icons are laid out and drawn)
+		double info_open_ms = 0;  ///< Total time to open the info windows
+		double info_open_max_ms = 0;  ///< Longest info window open time
+		double info_refresh_ms = 0;  ///< Total time of refresh_info() of the info windows
+		double info_fill_pending_ms = 0;  ///< Total time to fill the lazy tabs of the info windows
+
+		sigc::connection heartbeat_conn;  ///< Main loop heartbeat
+		std::chrono::steady_clock::time_point last_heartbeat;  ///< Last heartbeat time
+		std::chrono::milliseconds max_stall{0};  ///< Longest stall
+		std::uint64_t noticeable_stalls = 0;  ///< Number of stalls longer than noticeable_stall
+		std::chrono::milliseconds total_stall{0};  ///< Total time of the stalls longer than noticeable_stall
+	};
+
+	using GuiBenchmarkPtr = std::shared_ptr<GuiBenchmark>;
+
+
+
+	/// Record the main loop stall since the last heartbeat
+	bool on_heartbeat(const GuiBenchmarkPtr& b)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const auto stall = std::chrono::duration_cast<std::chrono::milliseconds>(now - b->last_heartbeat) - heartbeat_interval;
+		b->last_heartbeat = now;
+		b->max_stall = std::max(b->max_stall, stall);
+		if (stall >= noticeable_stall) {
+			++b->noticeable_stalls;
+			b->total_stall += stall;
+		}
+		return true;  // continue
+	}
+
+
+
+	/// Print the results and quit
+	void finish(const GuiBenchmarkPtr& b)
+	{
+		b->heartbeat_conn.disconnect();
+		on_heartbeat(b);  // the last step
+
+		const auto drive_count = static_cast<double>(b->drives.size());
+		const auto info_count = static_cast<double>(std::max<std::size_t>(1, b->info_windows.size()));
+
+		std::cout << fmt::format("GUI benchmark: {} drives, {} info windows\n", b->drives.size(), b->info_windows.size());
+		std::cout << fmt::format("  create and parse drives:   {:10.1f} ms ({:.1f} us/drive)\n", b->parse_ms, b->parse_ms * 1000. / drive_count);
+		std::cout << fmt::format("  icon view population:      {:10.1f} ms ({:.1f} us/drive), {:.1f} ms until idle\n",
+				b->populate_ms, b->populate_ms * 1000. / drive_count, b->populate_until_idle_ms);
+		std::cout << fmt::format("  info window open:          {:10.1f} ms/window (max {:.1f} ms)\n",
+				b->info_open_ms / info_count, b->info_open_max_ms);
+		std::cout << fmt::format("  info window refresh_info:  {:10.1f} ms/window\n", b->info_refresh_ms / info_count);
+		std::cout << fmt::format("  info window lazy tabs:     {:10.1f} ms/window\n", b->info_fill_pending_ms / info_count);
+		for (const auto& stats : GscInfoWindow::get_tab_fill_stats()) {
+			if (stats.fills > 0) {
+				std::cout << fmt::format("    {:<32} {:8} fills {:10.1f} ms/fill (max {:.1f} ms)\n", stats.tab, stats.fills,
+						static_cast<double>(stats.total_time.count()) / 1000. / static_cast<double>(stats.fills),
+						static_cast<double>(stats.max_time.count()) / 1000.);
+			}
+		}
+		if (b->start_resident_bytes > 0) {
+			std::cout << fmt::format("  memory per drive:          {:10.1f} KiB (parsed), {:.1f} KiB (with icons and info windows)\n",
+					static_cast<double>(b->drives_resident_bytes) / 1024. / drive_count,
+					static_cast<double>(b->total_resident_bytes) / 1024. / drive_count);
+		}
+		std::cout << fmt::format("  main loop stalls:          {:10} over {} ms, {} ms total, {} ms max\n",
+				b->noticeable_stalls, noticeable_stall.count(), b->total_stall.count(), b->max_stall.count());
+		std::cout.flush();
+
+		b->info_windows.clear();
+		app_quit();
+	}
+
+
+
+	/// Open the next info window, or finish
+	void open_next_info_window(const GuiBenchmarkPtr& b)
+	{
+		const std::size_t index = b->info_windows.size();
+		if (index >= std::min(b->info_window_count, b->drives.size())) {
+			const std::uint64_t resident_bytes = get_resident_bytes();
+			b->total_resident_bytes = (resident_bytes > b->start_resident_bytes ? resident_bytes - b->start_resident_bytes : 0);
+			finish(b);
+			return;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		auto win = b->main_window->show_device_info_window(b->drives[index]);
+		const double open_ms = get_elapsed_ms(start);
+		b->info_open_ms += open_ms;
+		b->info_open_max_ms = std::max(b->info_open_max_ms, open_ms);
+
+		if (win) {
+			start = std::chrono::steady_clock::now();
+			win->refresh_info();
+			b->info_refresh_ms += get_elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			win->fill_pending_tabs();
+			b->info_fill_pending_ms += get_elapsed_ms(start);
+		}
+		b->info_windows.push_back(win);
+
+		// Let the window be drawn before the next one
+		Glib::signal_idle().connect_once([b]() { open_next_info_window(b); }, Glib::PRIORITY_LOW);
+	}
+
+
+
+	/// Add the drives to the main window
+	void populate_icon_view(const GuiBenchmarkPtr& b)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		b->main_window->add_virtual_drives(b->drives);
+		b->populate_ms = get_elapsed_ms(start);
+
+		// The low priority idle callbacks run after the layout and the redraw
+		Glib::signal_idle().connect_once([b, start]() {
+			b->populate_until_idle_ms = get_elapsed_ms(start);
+			GscInfoWindow::reset_tab_fill_stats();
+			open_next_info_window(b);
+		}, Glib::PRIORITY_LOW);
+	}
+
+
+
+	/// Create and parse the drives
+	void create_drives(const GuiBenchmarkPtr& b)
+	{
+		b->start_resident_bytes = get_resident_bytes();
+
+		const auto start = std::chrono::steady_clock::now();
+		b->drives.reserve(b->drive_count);
+		for (std::size_t i = 0; i < b->drive_count; ++i) {
+			auto drive = std::make_shared<StorageDevice>(fmt::format("gui-benchmark-{}", i), true);
+			drive->set_virtual_output(b->templates[i % b->templates.size()]);  // a copy, like with separate files
+			if (auto parse_status = drive->parse_any_data_for_virtual(); !parse_status) {
+				std::cerr << "GUI benchmark: Cannot parse the template output: " << parse_status.error().message() << "\n";
+				finish(b);
+				return;
+			}
+			b->drives.push_back(std::move(drive));
+		}
+		b->parse_ms = get_elapsed_ms(start);
+
+		const std::uint64_t resident_bytes = get_resident_bytes();
+		b->drives_resident_bytes = (resident_bytes > b->start_resident_bytes ? resident_bytes - b->start_resident_bytes : 0);
+
+		Glib::signal_idle().connect_once([b]() { populate_icon_view(b); }, Glib::PRIORITY_LOW);
+	}
+
+
+}
+
+
+
+void gsc_gui_benchmark_start(GscMainWindow* main_window, const std::vector<std::string>& template_files,
+		std::size_t drive_count, std::size_t info_window_count)
+{
+	auto b = std::make_shared<GuiBenchmark>();
+	b->main_window = main_window;
+	b->drive_count = drive_count;
+	b->info_window_count = info_window_count;
+
+	const int max_size = 10*1024*1024;  // 10M, after decompression
+	for (const auto& file : template_files) {
+		auto loaded = storage_output_load(hz::fs_path_from_string(file), max_size);
+		if (!loaded) {
+			std::cerr << "GUI benchmark: Cannot open \"" << file << "\": " << loaded.error().message() << "\n";
+			continue;
+		}
+		b->templates.push_back(std::move(loaded.value()));
+	}
+	if (b->templates.empty()) {
+		std::cerr << "GUI benchmark: No smartctl outputs to create the drives from, specify them with --add-virtual.\n";
+		Glib::signal_idle().connect_once([]() { app_quit(); });
+		return;
+	}
+	debug_out_info("app", "Starting the GUI benchmark with " << drive_count << " drives.\n");
+
+	b->last_heartbeat = std::chrono::steady_clock::now();
+	b->heartbeat_conn = Glib::signal_timeout().connect([b]() { return on_heartbeat(b); },
+			static_cast<unsigned int>(heartbeat_interval.count()));
+
+	Glib::signal_idle().connect_once([b]() { create_drives(b); }, Glib::PRIORITY_LOW);
+}
+
+
+
+
+/// @}
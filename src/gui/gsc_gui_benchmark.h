@@ -0,0 +1,38 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_GUI_BENCHMARK_H
+#define GSC_GUI_BENCHMARK_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+class GscMainWindow;  // defined in gsc_main_window.h
+
+
+
+/// Start the GUI benchmark (see the --benchmark-drives command-line option). It runs from
+/// the main loop: it loads \c drive_count virtual drives (copies of the outputs in
+/// \c template_files) into the main window, opens the info windows of the first
+/// \c info_window_count drives, prints the icon view population time, the info window
+/// fill and refresh times (per tab), the memory per drive and the main loop stalls
+/// to stdout, and quits the application.
+void gsc_gui_benchmark_start(GscMainWindow* main_window, const std::vector<std::string>& template_files,
+		std::size_t drive_count, std::size_t info_window_count);
+
+
+
+
+#endif
+
+/// @}
@@ -13,9 +13,16 @@ Copyright:
 #include <gtkmm.h>
 #include <gdk/gdk.h>  // GDK_KEY_Escape
 #include <vector>  // better use vector, it's needed by others too
-#include <algorithm>  // std::min, std::max
+#include <array>
+#include <algorithm>  // std::min, std::max, std::find
+#include <chrono>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include "hz/string_num.h"  // number_to_string
 #include "hz/string_sprintf.h"  // string_sprintf
@@ -24,17 +31,28 @@ Copyright:
 #include "hz/format_unit.h"  // format_time_length
 #include "rconfig/rconfig.h"  // rconfig::*
 
+#include "applib/app_trace.h"
 #include "applib/app_gtkmm_tools.h"  // app_gtkmm_*
+#include "applib/command_executor_factory_gui.h"
 #include "applib/warning_colors.h"
 #include "applib/gui_utils.h"  // gui_show_error_dialog
-#include "applib/smartctl_executor_gui.h"
+#include "applib/smartctl_executor.h"
 #include "applib/storage_property.h"
 #include "applib/storage_device_detected_type.h"
+#include "applib/storage_history.h"
+#include "applib/storage_temperature_history.h"
+#include "applib/storage_hwmon_temperature.h"
+#include "applib/storage_io_load.h"
+#include "applib/storage_output_compression.h"
+#include "applib/storage_refresh_policy.h"
 
 #include "gsc_text_window.h"
 #include "gsc_info_window.h"
+#include "gsc_refresh_scheduler.h"
 #include "gsc_executor_error_dialog.h"
 #include "gsc_startup_settings.h"
+#include "gsc_temperature_graph.h"
+#include "gsc_io_performance_view.h"
 
 
 
@@ -60,6 +78,32 @@ struct PropertyLabel {
 namespace {
 
 
+	/// Closed info windows kept for reuse, see GscInfoWindow::release_to_pool().
+	/// The instance manager keeps them alive, and destroys them on exit.
+	std::vector<std::weak_ptr<GscInfoWindow>>& info_window_get_pool()
+	{
+		static std::vector<std::weak_ptr<GscInfoWindow>> pool;
+		std::erase_if(pool, [](const auto& win) { return win.expired(); });
+		return pool;
+	}
+
+
+	/// Info windows which show a drive, see GscInfoWindow::get_drive_ui_memory_usage()
+	std::vector<GscInfoWindow*>& info_window_get_bound()
+	{
+		static std::vector<GscInfoWindow*> bound;
+		return bound;
+	}
+
+
+	/// Get the maximum number of windows in the pool
+	std::size_t info_window_get_max_pool_size()
+	{
+		return static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("gui/info_window/pool_size")));
+	}
+
+
+
 	/// Set "top" labels - the generic text at the top of each tab page.
 	inline void app_set_top_labels(Gtk::Box* vbox, const std::vector<PropertyLabel>& label_strings)
 	{
@@ -135,6 +179,169 @@ namespace {
 
 
 
+	/// Check whether two properties are displayed the same way
+	inline bool app_property_display_equal(const StorageProperty& a, const StorageProperty& b)
+	{
+		return a.generic_name == b.generic_name
+				&& a.displayable_name == b.displayable_name
+				&& a.reported_value == b.reported_value
+				&& a.readable_value == b.readable_value
+				&& a.warning_level == b.warning_level
+				&& a.warning_reason == b.warning_reason
+				&& a.description == b.description
+				&& a.show_in_ui == b.show_in_ui
+				&& a.format_value() == b.format_value();
+	}
+
+
+
+	/// Check whether two property lists are displayed the same way
+	inline bool app_properties_display_equal(const StoragePropertyRepository& a, const StoragePropertyRepository& b)
+	{
+		const auto& a_props = a.get_properties();
+		const auto& b_props = b.get_properties();
+		return std::equal(a_props.begin(), a_props.end(), b_props.begin(), b_props.end(), &app_property_display_equal);
+	}
+
+
+
+	/// Check whether two property lists have the same properties in the same order,
+	/// ignoring their values. If so, the table rows showing them correspond to each other.
+	inline bool app_properties_same_rows(const StoragePropertyRepository& a, const StoragePropertyRepository& b)
+	{
+		const auto& a_props = a.get_properties();
+		const auto& b_props = b.get_properties();
+		return std::equal(a_props.begin(), a_props.end(), b_props.begin(), b_props.end(),
+				[](const StorageProperty& pa, const StorageProperty& pb) {
+					return pa.section == pb.section && pa.generic_name == pb.generic_name
+							&& pa.show_in_ui == pb.show_in_ui && pa.value.index() == pb.value.index();
+				});
+	}
+
+
+
+	/// Update the rows of a table in place. The rows point to properties in \c old_repo,
+	/// which must have the same rows as \c new_repo (see app_properties_same_rows()).
+	/// The rows are made to point to \c new_repo, and \c set_row is called for the changed ones.
+	inline void app_update_table_rows(Gtk::TreeView& treeview, const Gtk::TreeModelColumn<const StorageProperty*>& property_column,
+			const StoragePropertyRepository& old_repo, const StoragePropertyRepository& new_repo,
+			const std::function<void(Gtk::TreeRow& row, const StorageProperty& p)>& set_row)
+	{
+		Glib::RefPtr<Gtk::TreeModel> model = treeview.get_model();
+		if (!model)
+			return;
+
+		const auto& old_props = old_repo.get_properties();
+		const auto& new_props = new_repo.get_properties();
+
+		for (Gtk::TreeRow row : model->children()) {
+			const StorageProperty* old_p = row[property_column];
+			if (!old_p)
+				continue;
+			// The table may be sorted differently, so use the property index, not the row number.
+			const auto index = static_cast<std::size_t>(old_p - old_props.data());
+			if (index >= old_props.size() || index >= new_props.size()) {
+				DBG_ASSERT(0);  // shouldn't happen with the same rows
+				row[property_column] = nullptr;
+				continue;
+			}
+
+			const StorageProperty& p = new_props[index];
+			if (!app_property_display_equal(*old_p, p)) {
+				set_row(row, p);
+			}
+			row[property_column] = &p;
+		}
+	}
+
+
+
+	/// Formats a table cell of a property (escaped markup). Returns std::nullopt for the columns
+	/// whose values are stored in the model.
+	using PropertyCellFormatter = std::function<std::optional<Glib::ustring>(const StorageProperty& p, int column_index)>;
+
+
+
+	/// Sort function for a table column formatted by a PropertyCellFormatter
+	inline int on_property_column_compare(const Gtk::TreeModel::iterator& a, const Gtk::TreeModel::iterator& b,
+			const Gtk::TreeModelColumn<const StorageProperty*>& property_column, int column_index,
+			const PropertyCellFormatter& format)
+	{
+		const StorageProperty* pa = (*a)[property_column];
+		const StorageProperty* pb = (*b)[property_column];
+		if (!pa || !pb) {
+			return int(pa != nullptr) - int(pb != nullptr);
+		}
+		return format(*pa, column_index).value_or(Glib::ustring()).compare(format(*pb, column_index).value_or(Glib::ustring()));
+	}
+
+
+
+	/// Make a column (formatted by \c format) of a table sortable.
+	inline void app_set_property_sort_func(const Glib::RefPtr<Gtk::ListStore>& list_store,
+			const Gtk::TreeModelColumn<const StorageProperty*>& property_column, int column_index,
+			const PropertyCellFormatter& format)
+	{
+		list_store->set_sort_func(column_index, sigc::bind(sigc::ptr_fun(on_property_column_compare),
+				property_column, column_index, format));
+	}
+
+
+
+	/// Search function for tables whose names are formatted on demand. Like the default search function,
+	/// this matches the beginning of the name, case-insensitively. Returns false on match.
+	inline bool on_property_search_equal([[maybe_unused]] const Glib::RefPtr<Gtk::TreeModel>& model, [[maybe_unused]] int column,
+			const Glib::ustring& key, const Gtk::TreeModel::iterator& iter,
+			const Gtk::TreeModelColumn<const StorageProperty*>& property_column)
+	{
+		const StorageProperty* p = (*iter)[property_column];
+		return !p || Glib::ustring(p->displayable_name).casefold().find(key.casefold()) != 0;
+	}
+
+
+
+	/// Show the property description as a row tooltip
+	inline bool on_property_query_tooltip(int x, int y, bool keyboard_tooltip, const Glib::RefPtr<Gtk::Tooltip>& tooltip,
+			Gtk::TreeView* treeview, const Gtk::TreeModelColumn<const StorageProperty*>& property_column)
+	{
+		Gtk::TreeModel::iterator iter;
+		if (!treeview->get_tooltip_context_iter(x, y, keyboard_tooltip, iter)) {
+			return false;
+		}
+		const StorageProperty* p = (*iter)[property_column];
+		if (!p) {
+			return false;
+		}
+		const std::string description = p->get_description();  // markup
+		if (description.empty()) {
+			return false;
+		}
+		tooltip->set_markup(description);
+		treeview->set_tooltip_row(tooltip, Gtk::TreePath(iter));
+		return true;
+	}
+
+
+
+	/// Set up a table whose cells are formatted on demand (in the cell renderer function)
+	/// instead of being stored in the model. Large logs don't duplicate their strings this way.
+	/// The search is done on property names, and the tooltips show property descriptions.
+	inline void app_set_property_table_callbacks(Gtk::TreeView& treeview,
+			const Gtk::TreeModelColumn<const StorageProperty*>& property_column)
+	{
+		treeview.set_search_equal_func(sigc::bind(sigc::ptr_fun(on_property_search_equal), property_column));
+
+		// The treeview outlives its models and columns, so connect the tooltip handler once.
+		if (!treeview.get_data("gsc_property_tooltips")) {
+			treeview.set_data("gsc_property_tooltips", &treeview);
+			treeview.set_has_tooltip(true);
+			treeview.signal_query_tooltip().connect(
+					sigc::bind(sigc::ptr_fun(on_property_query_tooltip), &treeview, property_column));
+		}
+	}
+
+
+
 	/// Scroll to appropriate error in text when row is selected in tree.
 	inline void on_error_log_treeview_row_selected(GscInfoWindow* window,
 			Gtk::TreeModelColumn<Glib::ustring> mark_name_column)
@@ -180,6 +387,33 @@ GscInfoWindow::GscInfoWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder>
 		device_name_hbox->pack_start(*device_name_label_, true, true);
 	}
 
+	// Between the temperature labels and the SCT log text
+	auto* temperature_log_tab_vbox = lookup_widget<Gtk::Box*>("temperature_log_tab_vbox");
+	if (temperature_log_tab_vbox) {
+		temperature_graph_ = Gtk::manage(new GscTemperatureGraph());
+		temperature_log_tab_vbox->pack_start(*temperature_graph_, false, true);
+		temperature_log_tab_vbox->reorder_child(*temperature_graph_, 1);
+
+		// The connection is broken automatically when we're destroyed (sigc::trackable).
+		if (auto hwmon_monitor = storage_hwmon_temperature_get_global()) {
+			hwmon_monitor->signal_sampled().connect(sigc::mem_fun(*this, &GscInfoWindow::on_drive_temperature_sampled));
+		}
+	}
+
+	// Live I/O performance, after the Temperature tab. Shown for the local drives only (see set_drive()).
+	if (auto io_performance_monitor = storage_io_performance_get_global()) {
+		auto* main_notebook = lookup_widget<Gtk::Notebook*>("main_notebook");
+		auto* temperature_page = lookup_widget("temperature_log_tab_vbox");
+		if (main_notebook && temperature_page) {
+			io_performance_view_ = Gtk::manage(new GscIoPerformanceView());
+			auto* tab_label = Gtk::manage(new Gtk::Label(_("_Performance"), true));
+			main_notebook->insert_page(*io_performance_view_, *tab_label, main_notebook->page_num(*temperature_page) + 1);
+			io_performance_view_->hide();
+			// The connection is broken automatically when we're destroyed (sigc::trackable).
+			io_performance_monitor->signal_sampled().connect(sigc::mem_fun(*this, &GscInfoWindow::on_io_performance_sampled));
+		}
+	}
+
 
 	// Connect callbacks
 
@@ -237,6 +471,15 @@ GscInfoWindow::GscInfoWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder>
 	}
 
 
+	// Fill the tabs when they are shown for the first time
+	if (auto* main_notebook = lookup_widget<Gtk::Notebook*>("main_notebook")) {
+		main_notebook->signal_switch_page().connect(sigc::mem_fun(*this, &GscInfoWindow::on_notebook_switch_page));
+	}
+	if (auto* advanced_notebook = lookup_widget<Gtk::Notebook*>("advanced_notebook")) {
+		advanced_notebook->signal_switch_page().connect(sigc::mem_fun(*this, &GscInfoWindow::on_notebook_switch_page));
+	}
+
+
 	// ---------------
 
 	// Create columns of treeviews
@@ -327,34 +570,107 @@ GscInfoWindow::GscInfoWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder>
 
 GscInfoWindow::~GscInfoWindow()
 {
-	// Store window size. We don't store position to avoid overlaps.
-	{
-		int window_w = 0, window_h = 0;
-		get_size(window_w, window_h);
-		rconfig::set_data("gui/info_window/default_size_w", window_w);
-		rconfig::set_data("gui/info_window/default_size_h", window_h);
-	}
+	store_window_size();
+	std::erase(info_window_get_bound(), this);
 
 	for (auto& iter : treeview_menus_) {
 		delete iter.second;
 	}
+
+	if (refresh_scheduler_ && drive_) {
+		refresh_scheduler_->remove_drive(drive_);
+	}
+	if (auto io_performance_monitor = storage_io_performance_get_global(); io_performance_monitor && io_performance_user_) {
+		io_performance_monitor->remove_user();
+	}
+}
+
+
+
+std::shared_ptr<GscInfoWindow> GscInfoWindow::acquire()
+{
+	auto& pool = info_window_get_pool();
+	if (!pool.empty()) {
+		auto win = pool.back().lock();  // not expired, see info_window_get_pool()
+		pool.pop_back();
+		return win;
+	}
+	return create();
+}
+
+
+
+void GscInfoWindow::prebuild_pooled()
+{
+	auto& pool = info_window_get_pool();
+	if (pool.size() >= info_window_get_max_pool_size()) {
+		return;
+	}
+	if (auto win = create()) {  // not shown until acquired
+		pool.push_back(win);
+	}
 }
 
 
 
 void GscInfoWindow::set_drive(StorageDevicePtr d)
 {
-	if (drive_)  // if an old drive is present, disconnect our callback from it.
+	if (drive_) {  // if an old drive is present, disconnect our callback from it.
 		drive_changed_connection_.disconnect();
+		if (refresh_scheduler_) {
+			refresh_scheduler_->remove_drive(drive_);
+		}
+	}
 	drive_ = std::move(d);
-	drive_changed_connection_ = drive_->signal_changed().connect(sigc::mem_fun(this,
+	drive_changed_connection_ = drive_->signal_changed_coalesced().connect(sigc::mem_fun(this,
 			&GscInfoWindow::on_drive_changed));
+	if (auto& bound = info_window_get_bound(); std::find(bound.begin(), bound.end(), this) == bound.end()) {
+		bound.push_back(this);
+	}
+	if (refresh_scheduler_) {
+		refresh_scheduler_->add_drive(drive_);
+	}
+
+	// Sample /proc/diskstats only while a window of a local drive is open
+	if (auto io_performance_monitor = storage_io_performance_get_global(); io_performance_monitor && io_performance_view_) {
+		const bool local = !drive_->get_is_virtual() && drive_->get_remote_host_name().empty();
+		if (local && !io_performance_user_) {
+			io_performance_monitor->add_user();
+		} else if (!local && io_performance_user_) {
+			io_performance_monitor->remove_user();
+		}
+		io_performance_user_ = local;
+		io_performance_view_->set_performance(local ? io_performance_monitor->get_performance(*drive_) : std::nullopt);
+	}
+}
+
+
+
+void GscInfoWindow::set_refresh_scheduler(std::shared_ptr<GscRefreshScheduler> scheduler)
+{
+	if (scheduler && scheduler == refresh_scheduler_) {  // a reused window, set_drive() has added the drive to it
+		return;
+	}
+	DBG_ASSERT_RETURN_NONE(!refresh_scheduler_);
+	refresh_scheduler_ = std::move(scheduler);
+	if (!refresh_scheduler_) {
+		return;
+	}
+	// The connections are broken automatically when we're destroyed (sigc::trackable).
+	refresh_scheduler_->signal_refresh_started().connect(sigc::mem_fun(*this,
+			&GscInfoWindow::on_scheduled_refresh_started));
+	refresh_scheduler_->signal_refresh_finished().connect(sigc::mem_fun(*this,
+			&GscInfoWindow::on_scheduled_refresh_finished));
+	if (drive_) {
+		refresh_scheduler_->add_drive(drive_);
+	}
 }
 
 
 
 void GscInfoWindow::fill_ui_with_info(bool scan, bool clear_ui, bool clear_tests)
 {
+	const AppTraceSpan trace_span("GscInfoWindow::fill_ui_with_info", "gui");
 	debug_out_info("app", DBG_FUNC_MSG << "Scan " << (scan ? "" : "not ") << "requested.\n");
 
 	if (clear_ui) {
@@ -364,8 +680,8 @@ void GscInfoWindow::fill_ui_with_info(bool scan, bool clear_ui, bool clear_tests
 	if (!drive_->get_is_virtual()) {
 		// fetch all smartctl info, even if it already has it (to refresh it).
 		if (scan) {
-			std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-			ex->create_running_dialog(this, Glib::ustring::compose(_("Running {command} on %1..."), drive_->get_device_with_type()));
+			auto ex = create_smartctl_executor();
+			ex->set_running_msg(Glib::ustring::compose(_("Running {command} on %1..."), drive_->get_device_with_type()));
 			auto fetch_status = drive_->fetch_full_data_and_parse(ex);  // run it with GUI support
 
 			if (!fetch_status) {
@@ -384,159 +700,481 @@ void GscInfoWindow::fill_ui_with_info(bool scan, bool clear_ui, bool clear_tests
 		}
 	}
 
+	// Hiding the tabs may switch the current page. Don't fill the pending tabs until we're done.
+	filling_ui_ = true;
+
 	// Hide tabs which have no properties associated with them
+	update_tab_visibility();
+
+	// Top label - short device information
 	{
-		const auto& prop_repo = drive_->get_property_repository();
-		Gtk::Widget* note_page_box = nullptr;
+		const std::string device = Glib::Markup::escape_text(drive_->get_device_with_type());
+		const std::string model = Glib::Markup::escape_text(drive_->get_model_name().empty() ? _("Unknown model") : drive_->get_model_name());
+		const std::string drive_letters = Glib::Markup::escape_text(drive_->format_drive_letters(false));
 
-		const bool has_ata_attributes = prop_repo.has_properties_for_section(StoragePropertySection::AtaAttributes);
-		if (note_page_box = lookup_widget("attributes_tab_vbox"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_ata_attributes);
-		}
+		/// Translators: %1 is device name, %2 is device model.
+		this->set_title(Glib::ustring::compose(_("Device Information - %1: %2 - GSmartControl"), device, model));
 
-		const bool has_nvme_attributes = prop_repo.has_properties_for_section(StoragePropertySection::NvmeAttributes);
-		if (note_page_box = lookup_widget("nvme_attributes_tab_vbox"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_nvme_attributes);
+		// Gtk::Label* device_name_label = lookup_widget<Gtk::Label*>("device_name_label");
+		if (device_name_label_) {
+			/// Translators: %1 is device name, %2 is drive letters (if not empty), %3 is device model.
+			Glib::ustring markup = Glib::ustring::compose(_("<b>Device:</b> %1%2  <b>Model:</b> %3"),
+					device, (drive_letters.empty() ? "" : (" (<b>" + drive_letters + "</b>)")), model);
+			if (drive_->get_in_standby()) {
+				markup += Glib::ustring("  ") + _("<i>(In standby mode, showing the data from before)</i>");
+			}
+			device_name_label_->set_markup(markup);
 		}
+	}
 
-		const bool has_statistics = prop_repo.has_properties_for_section(StoragePropertySection::Statistics);
-		if (note_page_box = lookup_widget("statistics_tab_vbox"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_statistics);
-		}
 
-		const bool has_selftest = (drive_->get_self_test_support_status() == StorageDevice::SelfTestSupportStatus::Supported);
-		if (note_page_box = lookup_widget("test_tab_vbox"); note_page_box != nullptr) {
-			// Some USB flash drives erroneously report SMART as enabled.
-			// note_page_box->set_visible(drive->get_smart_status() == StorageDevice::Status::Enabled);
-			note_page_box->set_visible(has_selftest);
-			if (has_selftest) {
-				book_selftest_page_no_ = 4;
-			} else {
-				book_selftest_page_no_ = -1;
-			}
-		}
+	// Fill the tabs with info.
+	// The tree models point to our copies of the properties, so that they stay
+	// valid until the next update (the drive replaces its properties on each fetch).
+	displayed_properties_ = split_properties_by_tab(drive_->get_property_repository());
+	displayed_properties_valid_ = true;
 
-		const bool has_ata_error_log = prop_repo.has_properties_for_section(StoragePropertySection::AtaErrorLog);
-		if (note_page_box = lookup_widget("error_log_tab_vbox"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_ata_error_log);
+	if (clear_tests) {
+		fill_ui_self_test_info();
+	}
+	// The tabs which are not shown are filled when they are shown for the first time.
+	for (std::size_t i = 0; i < info_tab_count; ++i) {
+		const auto tab = static_cast<InfoTab>(i);
+		if (get_tab_is_lazy(tab) && !get_tab_is_shown(tab)) {
+			set_tab_pending(tab);
+		} else {
+			fill_ui_tab(tab, nullptr);
 		}
+	}
 
-		const bool has_nvme_error_log = prop_repo.has_properties_for_section(StoragePropertySection::NvmeErrorLog);
-		if (note_page_box = lookup_widget("nvme_error_log_tab_vbox"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_nvme_error_log);
-		}
+	// Advanced tab label
+	update_advanced_tab_label();
 
-		const bool has_temperature_log = prop_repo.has_properties_for_section(StoragePropertySection::TemperatureLog);
-		if (note_page_box = lookup_widget("temperature_log_tab_vbox"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_temperature_log);
-		}
+	filling_ui_ = false;
+	fill_shown_pending_tabs();  // in case the current page was hidden
+}
 
-		// Advanced tab's subtabs
-		const bool has_capabilities = prop_repo.has_properties_for_section(StoragePropertySection::Capabilities);
-		if (note_page_box = lookup_widget("capabilities_scrolledwindow"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_capabilities);
-		}
 
-		const bool has_erc = prop_repo.has_properties_for_section(StoragePropertySection::ErcLog);
-		if (note_page_box = lookup_widget("erc_scrolledwindow"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_erc);
+
+void GscInfoWindow::update_ui_with_info(bool clear_tests)
+{
+	if (!displayed_properties_valid_) {
+		fill_ui_with_info(false, true, clear_tests);
+		return;
+	}
+
+	auto new_properties = split_properties_by_tab(drive_->get_property_repository());
+
+	std::array<bool, info_tab_count> changed = {};
+	for (std::size_t i = 0; i < info_tab_count; ++i) {
+		changed[i] = !app_properties_display_equal(displayed_properties_[i], new_properties[i]);
+	}
+
+	// The tables can be updated in place only if they show the same rows.
+	// Otherwise (e.g. a new self-test log entry), rebuild everything.
+	for (const InfoTab tab : {InfoTab::AtaAttributes, InfoTab::NvmeAttributes, InfoTab::Statistics,
+			InfoTab::SelfTestLog, InfoTab::AtaErrorLog, InfoTab::Capabilities}) {
+		const auto i = static_cast<std::size_t>(tab);
+		const bool in_place = (tab == InfoTab::AtaAttributes || tab == InfoTab::NvmeAttributes || tab == InfoTab::Statistics);
+		if (changed[i] && tab_filled_[i] && (!in_place || !app_properties_same_rows(displayed_properties_[i], new_properties[i]))) {
+			debug_out_dump("app", DBG_FUNC_MSG << "Table rows changed, refilling all tabs.\n");
+			fill_ui_with_info(false, true, clear_tests);
+			return;
 		}
+	}
+
+	filling_ui_ = true;
+
+	update_tab_visibility();
+
+	if (clear_tests) {
+		clear_ui_self_test_info();
+		fill_ui_self_test_info();
+	}
 
-		const bool has_selective = prop_repo.has_properties_for_section(StoragePropertySection::SelectiveSelftestLog);
-		if (note_page_box = lookup_widget("selective_selftest_scrolledwindow"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_selective);
+	// Untouched tabs are skipped entirely.
+	for (std::size_t i = 0; i < info_tab_count; ++i) {
+		if (!changed[i]) {
+			continue;
+		}
+		debug_out_dump("app", DBG_FUNC_MSG << "Updating tab " << i << ".\n");
+		// Keep the old properties alive until the rows are updated to point to the new ones.
+		const StoragePropertyRepository old_properties = std::move(displayed_properties_[i]);
+		displayed_properties_[i] = std::move(new_properties[i]);
+		const auto tab = static_cast<InfoTab>(i);
+		if (!tab_filled_[i]) {  // not shown yet, only the header needs updating
+			set_tab_pending(tab);
+			continue;
+		}
+		// A partially filled table is rebuilt, the rest of its rows would point to the old properties.
+		const bool in_place = (tab == InfoTab::AtaAttributes || tab == InfoTab::NvmeAttributes
+				|| (tab == InfoTab::Statistics && !statistics_filler_.is_running()));
+		if (!in_place) {
+			clear_ui_tab(tab);
 		}
+		fill_ui_tab(tab, in_place ? &old_properties : nullptr);
+	}
+
+	update_advanced_tab_label();
+
+	filling_ui_ = false;
+	fill_shown_pending_tabs();  // in case the current page was hidden
+}
+
 
-		const bool has_phy = prop_repo.has_properties_for_section(StoragePropertySection::PhyLog);
-		if (note_page_box = lookup_widget("phy_scrolledwindow"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_phy);
+
+std::array<StoragePropertyRepository, GscInfoWindow::info_tab_count> GscInfoWindow::split_properties_by_tab(
+		const StoragePropertyRepository& property_repo)
+{
+	std::array<std::vector<StorageProperty>, info_tab_count> tab_properties;
+
+	for (const auto& p : property_repo.get_properties()) {
+		std::optional<InfoTab> tab;
+		switch (p.section) {
+			case StoragePropertySection::Info:
+			case StoragePropertySection::OverallHealth:
+			case StoragePropertySection::NvmeHealth:
+				tab = InfoTab::General;
+				break;
+			case StoragePropertySection::AtaAttributes: tab = InfoTab::AtaAttributes; break;
+			case StoragePropertySection::NvmeAttributes: tab = InfoTab::NvmeAttributes; break;
+			case StoragePropertySection::Statistics: tab = InfoTab::Statistics; break;
+			case StoragePropertySection::SelftestLog: tab = InfoTab::SelfTestLog; break;
+			case StoragePropertySection::AtaErrorLog: tab = InfoTab::AtaErrorLog; break;
+			case StoragePropertySection::NvmeErrorLog: tab = InfoTab::NvmeErrorLog; break;
+			case StoragePropertySection::TemperatureLog: tab = InfoTab::TemperatureLog; break;
+			case StoragePropertySection::Capabilities: tab = InfoTab::Capabilities; break;
+			case StoragePropertySection::ErcLog: tab = InfoTab::ErcLog; break;
+			case StoragePropertySection::SelectiveSelftestLog: tab = InfoTab::SelectiveSelfTestLog; break;
+			case StoragePropertySection::PhyLog: tab = InfoTab::PhyLog; break;
+			case StoragePropertySection::DirectoryLog: tab = InfoTab::DirectoryLog; break;
+			case StoragePropertySection::Unknown:
+				break;
+		}
+		if (tab.has_value()) {
+			tab_properties[static_cast<std::size_t>(tab.value())].push_back(p);
 		}
 
-		const bool has_dir = prop_repo.has_properties_for_section(StoragePropertySection::DirectoryLog);
-		if (note_page_box = lookup_widget("directory_scrolledwindow"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_dir);
+		// The temperature tab shows the current temperature from the other sections too
+		if (tab != InfoTab::TemperatureLog && (p.generic_name == "temperature/current"
+				|| p.generic_name == "ata_sct_status/temperature/current"
+				|| p.generic_name == "stat_temperature_celsius"
+				|| p.generic_name == "attr_temperature_celsius"
+				|| p.generic_name == "attr_temperature_celsius_x10")) {
+			tab_properties[static_cast<std::size_t>(InfoTab::TemperatureLog)].push_back(p);
 		}
+	}
+
+	std::array<StoragePropertyRepository, info_tab_count> repos;
+	for (std::size_t i = 0; i < info_tab_count; ++i) {
+		repos[i].set_properties(std::move(tab_properties[i]));
+	}
+	return repos;
+}
+
+
+
+void GscInfoWindow::fill_ui_tab(InfoTab tab, const StoragePropertyRepository* displayed_repo)
+{
+	const AppTraceSpan trace_span("GscInfoWindow::fill_ui_tab", "gui");
+	const auto& property_repo = displayed_properties_[static_cast<std::size_t>(tab)];
+	tab_filled_[static_cast<std::size_t>(tab)] = true;
+
+	const auto start_time = std::chrono::steady_clock::now();
+
+	switch (tab) {
+		case InfoTab::General: fill_ui_general(property_repo); break;
+		case InfoTab::AtaAttributes: fill_ui_ata_attributes(property_repo, displayed_repo); break;
+		case InfoTab::NvmeAttributes: fill_ui_nvme_attributes(property_repo, displayed_repo); break;
+		case InfoTab::Statistics: fill_ui_statistics(property_repo, displayed_repo); break;
+		case InfoTab::SelfTestLog: fill_ui_self_test_log(property_repo); break;
+		case InfoTab::AtaErrorLog: fill_ui_ata_error_log(property_repo); break;
+		case InfoTab::NvmeErrorLog: fill_ui_nvme_error_log(property_repo); break;
+		case InfoTab::TemperatureLog: fill_ui_temperature_log(property_repo); break;
+		// Advanced tab
+		case InfoTab::Capabilities: advanced_tab_warnings_[0] = fill_ui_capabilities(property_repo); break;
+		case InfoTab::ErcLog: advanced_tab_warnings_[1] = fill_ui_error_recovery(property_repo); break;
+		case InfoTab::SelectiveSelfTestLog: advanced_tab_warnings_[2] = fill_ui_selective_self_test_log(property_repo); break;
+		case InfoTab::PhyLog: advanced_tab_warnings_[3] = fill_ui_physical(property_repo); break;
+		case InfoTab::DirectoryLog: advanced_tab_warnings_[4] = fill_ui_directory(property_repo); break;
+	}
+
+	auto& stats = get_tab_fill_stats_storage()[static_cast<std::size_t>(tab)];
+	const auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+	++stats.fills;
+	stats.total_time += time;
+	stats.max_time = std::max(stats.max_time, time);
+}
+
+
 
-		const bool has_advanced =
-				has_capabilities
-				|| has_erc
-				|| has_selective
-				|| has_phy
-				|| has_dir;
-		if (note_page_box = lookup_widget("advanced_tab_vbox"); note_page_box != nullptr) {
-			note_page_box->set_visible(has_advanced);
+void GscInfoWindow::update_advanced_tab_label()
+{
+	const auto max_advanced_tab_warning = *std::max_element(advanced_tab_warnings_.begin(), advanced_tab_warnings_.end());
+	app_highlight_tab_label(lookup_widget("advanced_tab_label"), max_advanced_tab_warning, tab_names_.advanced);
+}
+
+
+
+bool GscInfoWindow::get_tab_is_lazy(InfoTab tab)
+{
+	// The General tab is shown first, and the Temperature tab is cheap
+	// (and its header highlighting depends on the selected temperature source).
+	return tab != InfoTab::General && tab != InfoTab::TemperatureLog;
+}
+
+
+
+bool GscInfoWindow::get_tab_is_shown(InfoTab tab)
+{
+	auto* main_notebook = lookup_widget<Gtk::Notebook*>("main_notebook");
+	if (!main_notebook) {
+		return true;
+	}
+	Gtk::Widget* main_page = main_notebook->get_nth_page(main_notebook->get_current_page());
+	if (!main_page) {
+		return false;
+	}
+
+	const std::string page_name = get_tab_page_widget_name(tab);
+	if (main_page == lookup_widget(page_name)) {
+		return true;
+	}
+
+	// Advanced sub-tab
+	if (main_page == lookup_widget("advanced_tab_vbox")) {
+		if (auto* advanced_notebook = lookup_widget<Gtk::Notebook*>("advanced_notebook")) {
+			Gtk::Widget* sub_page = advanced_notebook->get_nth_page(advanced_notebook->get_current_page());
+			return sub_page != nullptr && sub_page == lookup_widget(page_name);
 		}
+	}
+	return false;
+}
+
+
+
+void GscInfoWindow::set_tab_pending(InfoTab tab)
+{
+	const auto i = static_cast<std::size_t>(tab);
+	tab_filled_[i] = false;
+
+	// Highlight the header using the per-tab warning summary, which doesn't need
+	// the tab contents.
+	const WarningLevel warning = get_tab_warning_summary(tab);
+	if (tab >= InfoTab::Capabilities) {
+		advanced_tab_warnings_[i - static_cast<std::size_t>(InfoTab::Capabilities)] = warning;
+	}
+	auto [label_name, label_text] = get_tab_label(tab);
+	app_highlight_tab_label(lookup_widget(label_name), warning, label_text);
+}
+
 
-		// Hide tab titles if only one tab is visible
-		if (auto* notebook = lookup_widget<Gtk::Notebook*>("main_notebook")) {
-			notebook->set_show_tabs(
-					has_ata_attributes
-					|| has_nvme_attributes
-					|| has_statistics
-					|| has_selftest
-					|| has_ata_error_log
-					|| has_nvme_error_log
-					|| has_temperature_log
-					|| has_advanced);
+
+void GscInfoWindow::fill_shown_pending_tabs()
+{
+	if (!displayed_properties_valid_ || filling_ui_) {
+		return;
+	}
+	for (std::size_t i = 0; i < info_tab_count; ++i) {
+		const auto tab = static_cast<InfoTab>(i);
+		if (!tab_filled_[i] && get_tab_is_shown(tab)) {
+			debug_out_dump("app", DBG_FUNC_MSG << "Filling tab " << i << " on first show.\n");
+			clear_ui_tab(tab);
+			fill_ui_tab(tab, nullptr);
 		}
 	}
+	update_advanced_tab_label();
+}
 
-	// Top label - short device information
-	{
-		const std::string device = Glib::Markup::escape_text(drive_->get_device_with_type());
-		const std::string model = Glib::Markup::escape_text(drive_->get_model_name().empty() ? _("Unknown model") : drive_->get_model_name());
-		const std::string drive_letters = Glib::Markup::escape_text(drive_->format_drive_letters(false));
 
-		/// Translators: %1 is device name, %2 is device model.
-		this->set_title(Glib::ustring::compose(_("Device Information - %1: %2 - GSmartControl"), device, model));
 
-		// Gtk::Label* device_name_label = lookup_widget<Gtk::Label*>("device_name_label");
-		if (device_name_label_) {
-			/// Translators: %1 is device name, %2 is drive letters (if not empty), %3 is device model.
-			device_name_label_->set_markup(Glib::ustring::compose(_("<b>Device:</b> %1%2  <b>Model:</b> %3"),
-					device, (drive_letters.empty() ? "" : (" (<b>" + drive_letters + "</b>)")), model));
+std::array<GscInfoWindowTabFillStats, GscInfoWindow::info_tab_count>& GscInfoWindow::get_tab_fill_stats_storage()
+{
+	// Only used from the main thread
+	static std::array<GscInfoWindowTabFillStats, info_tab_count> stats = []() {
+		std::array<GscInfoWindowTabFillStats, info_tab_count> s;
+		for (std::size_t i = 0; i < info_tab_count; ++i) {
+			s[i].tab = get_tab_page_widget_name(static_cast<InfoTab>(i));
+		}
+		return s;
+	}();
+	return stats;
+}
+
+
+
+WarningLevel GscInfoWindow::get_tab_warning_summary(InfoTab tab) const
+{
+	switch (tab) {
+		// These show text logs only, and are never highlighted.
+		case InfoTab::NvmeErrorLog:
+		case InfoTab::ErcLog:
+		case InfoTab::SelectiveSelfTestLog:
+		case InfoTab::PhyLog:
+		case InfoTab::DirectoryLog:
+			return WarningLevel::None;
+		default:
+			break;
+	}
+
+	return displayed_properties_[static_cast<std::size_t>(tab)].get_warning_summary().max_level;
+}
+
+
+
+std::string GscInfoWindow::get_tab_page_widget_name(InfoTab tab)
+{
+	switch (tab) {
+		case InfoTab::General: return "general_tab_vbox";
+		case InfoTab::AtaAttributes: return "attributes_tab_vbox";
+		case InfoTab::NvmeAttributes: return "nvme_attributes_tab_vbox";
+		case InfoTab::Statistics: return "statistics_tab_vbox";
+		case InfoTab::SelfTestLog: return "test_tab_vbox";
+		case InfoTab::AtaErrorLog: return "error_log_tab_vbox";
+		case InfoTab::NvmeErrorLog: return "nvme_error_log_tab_vbox";
+		case InfoTab::TemperatureLog: return "temperature_log_tab_vbox";
+		case InfoTab::Capabilities: return "capabilities_scrolledwindow";
+		case InfoTab::ErcLog: return "erc_scrolledwindow";
+		case InfoTab::SelectiveSelfTestLog: return "selective_selftest_scrolledwindow";
+		case InfoTab::PhyLog: return "phy_scrolledwindow";
+		case InfoTab::DirectoryLog: return "directory_scrolledwindow";
+	}
+	return {};
+}
+
+
+
+std::pair<std::string, Glib::ustring> GscInfoWindow::get_tab_label(InfoTab tab) const
+{
+	switch (tab) {
+		case InfoTab::General: return {"general_tab_label", tab_names_.identity};
+		case InfoTab::AtaAttributes: return {"attributes_tab_label", tab_names_.ata_attributes};
+		case InfoTab::NvmeAttributes: return {"nvme_attributes_tab_label", tab_names_.nvme_attributes};
+		case InfoTab::Statistics: return {"statistics_tab_label", tab_names_.statistics};
+		case InfoTab::SelfTestLog: return {"test_tab_label", tab_names_.test};
+		case InfoTab::AtaErrorLog: return {"error_log_tab_label", tab_names_.ata_error_log};
+		case InfoTab::NvmeErrorLog: return {"nvme_error_log_tab_label", tab_names_.nvme_error_log};
+		case InfoTab::TemperatureLog: return {"temperature_log_tab_label", tab_names_.temperature};
+		case InfoTab::Capabilities: return {"capabilities_tab_label", tab_names_.capabilities};
+		case InfoTab::ErcLog: return {"erc_tab_label", tab_names_.erc};
+		case InfoTab::SelectiveSelfTestLog: return {"selective_selftest_tab_label", tab_names_.selective_selftest};
+		case InfoTab::PhyLog: return {"phy_tab_label", tab_names_.phy};
+		case InfoTab::DirectoryLog: return {"directory_tab_label", tab_names_.directory};
+	}
+	return {};
+}
+
+
+
+void GscInfoWindow::update_tab_visibility()
+{
+	const auto& prop_repo = drive_->get_property_repository();
+	Gtk::Widget* note_page_box = nullptr;
+
+	const bool has_ata_attributes = prop_repo.has_properties_for_section(StoragePropertySection::AtaAttributes);
+	if (note_page_box = lookup_widget("attributes_tab_vbox"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_ata_attributes);
+	}
+
+	const bool has_nvme_attributes = prop_repo.has_properties_for_section(StoragePropertySection::NvmeAttributes);
+	if (note_page_box = lookup_widget("nvme_attributes_tab_vbox"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_nvme_attributes);
+	}
+
+	const bool has_statistics = prop_repo.has_properties_for_section(StoragePropertySection::Statistics);
+	if (note_page_box = lookup_widget("statistics_tab_vbox"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_statistics);
+	}
+
+	const bool has_selftest = (drive_->get_self_test_support_status() == StorageDevice::SelfTestSupportStatus::Supported);
+	if (note_page_box = lookup_widget("test_tab_vbox"); note_page_box != nullptr) {
+		// Some USB flash drives erroneously report SMART as enabled.
+		// note_page_box->set_visible(drive->get_smart_status() == StorageDevice::Status::Enabled);
+		note_page_box->set_visible(has_selftest);
+		if (has_selftest) {
+			book_selftest_page_no_ = 4;
+		} else {
+			book_selftest_page_no_ = -1;
 		}
 	}
 
+	const bool has_ata_error_log = prop_repo.has_properties_for_section(StoragePropertySection::AtaErrorLog);
+	if (note_page_box = lookup_widget("error_log_tab_vbox"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_ata_error_log);
+	}
 
-	// Fill the tabs with info
+	const bool has_nvme_error_log = prop_repo.has_properties_for_section(StoragePropertySection::NvmeErrorLog);
+	if (note_page_box = lookup_widget("nvme_error_log_tab_vbox"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_nvme_error_log);
+	}
 
-	// we need reference here - we take addresses of the elements
-	const auto& property_repo = drive_->get_property_repository();  // it's a vector
+	const bool has_temperature_log = prop_repo.has_properties_for_section(StoragePropertySection::TemperatureLog);
+	if (note_page_box = lookup_widget("temperature_log_tab_vbox"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_temperature_log);
+	}
 
-	fill_ui_general(property_repo);
-	fill_ui_ata_attributes(property_repo);
-	fill_ui_nvme_attributes(property_repo);
-	fill_ui_statistics(property_repo);
-	if (clear_tests) {
-		fill_ui_self_test_info();
+	const bool has_io_performance = (io_performance_view_ != nullptr && io_performance_user_);
+	if (io_performance_view_) {
+		io_performance_view_->set_visible(has_io_performance);
+		update_io_performance_counters(prop_repo);
 	}
-	fill_ui_self_test_log(property_repo);
-	fill_ui_ata_error_log(property_repo);
-	fill_ui_nvme_error_log(property_repo);
-	fill_ui_temperature_log(property_repo);
-
-	// Advanced tab
-	auto caps_warning_level = fill_ui_capabilities(property_repo);
-	auto errc_warning_level = fill_ui_error_recovery(property_repo);
-	auto selective_warning_level = fill_ui_selective_self_test_log(property_repo);
-	auto dir_warning_level = fill_ui_directory(property_repo);
-	auto phy_warning_level = fill_ui_physical(property_repo);
-
-	auto max_advanced_tab_warning = std::max({
-		caps_warning_level,
-		errc_warning_level,
-		selective_warning_level,
-		dir_warning_level,
-		phy_warning_level
-	});
 
-	// Advanced tab label
-	app_highlight_tab_label(lookup_widget("advanced_tab_label"), max_advanced_tab_warning, tab_names_.advanced);
+	// Advanced tab's subtabs
+	const bool has_capabilities = prop_repo.has_properties_for_section(StoragePropertySection::Capabilities);
+	if (note_page_box = lookup_widget("capabilities_scrolledwindow"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_capabilities);
+	}
+
+	const bool has_erc = prop_repo.has_properties_for_section(StoragePropertySection::ErcLog);
+	if (note_page_box = lookup_widget("erc_scrolledwindow"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_erc);
+	}
+
+	const bool has_selective = prop_repo.has_properties_for_section(StoragePropertySection::SelectiveSelftestLog);
+	if (note_page_box = lookup_widget("selective_selftest_scrolledwindow"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_selective);
+	}
+
+	const bool has_phy = prop_repo.has_properties_for_section(StoragePropertySection::PhyLog);
+	if (note_page_box = lookup_widget("phy_scrolledwindow"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_phy);
+	}
+
+	const bool has_dir = prop_repo.has_properties_for_section(StoragePropertySection::DirectoryLog);
+	if (note_page_box = lookup_widget("directory_scrolledwindow"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_dir);
+	}
+
+	const bool has_advanced =
+			has_capabilities
+			|| has_erc
+			|| has_selective
+			|| has_phy
+			|| has_dir;
+	if (note_page_box = lookup_widget("advanced_tab_vbox"); note_page_box != nullptr) {
+		note_page_box->set_visible(has_advanced);
+	}
+
+	// Hide tab titles if only one tab is visible
+	if (auto* notebook = lookup_widget<Gtk::Notebook*>("main_notebook")) {
+		notebook->set_show_tabs(
+				has_ata_attributes
+				|| has_nvme_attributes
+				|| has_statistics
+				|| has_selftest
+				|| has_ata_error_log
+				|| has_nvme_error_log
+				|| has_temperature_log
+				|| has_io_performance
+				|| has_advanced);
+	}
 }
 
 
 
+
+
+
 void GscInfoWindow::clear_ui_info(bool clear_tests_too)
 {
 	// Note: We do NOT show/hide the notebook tabs here.
@@ -551,248 +1189,386 @@ void GscInfoWindow::clear_ui_info(bool clear_tests_too)
 		}
 	}
 
-	{
-		auto* identity_table = lookup_widget<Gtk::Grid*>("identity_table");
-		if (identity_table) {
-			// manually remove all children. without this visual corruption occurs.
-			auto children = identity_table->get_children();
-			for (auto& widget : children) {
-				identity_table->remove(*widget);
-			}
-		}
+	for (std::size_t i = 0; i < info_tab_count; ++i) {
+		clear_ui_tab(static_cast<InfoTab>(i));
+	}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("general_tab_label"), WarningLevel::None, tab_names_.identity);
+	if (clear_tests_too) {
+		clear_ui_self_test_info();
 	}
 
-	{
-		auto* label_vbox = lookup_widget<Gtk::Box*>("attributes_label_vbox");
-		app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+	// tab label
+	app_highlight_tab_label(lookup_widget("advanced_tab_label"), WarningLevel::None, tab_names_.advanced);
 
-		if (auto* treeview = lookup_widget<Gtk::TreeView*>("attributes_treeview")) {
-// 			Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
-// 			if (model)
-// 				model->clear();
-			treeview->remove_all_columns();
-			treeview->unset_model();
-		}
+	// Delete columns. We need to do this because otherwise,
+	// the column objects store their old indexes and will break when re-added
+	columns_.reset();
+	columns_ = std::make_unique<GscInfoWindowColumns>();
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("attributes_tab_label"), WarningLevel::None, tab_names_.ata_attributes);
-	}
+	displayed_properties_valid_ = false;
+	tab_filled_ = {};
+}
 
-	{
-		auto* label_vbox = lookup_widget<Gtk::Box*>("nvme_attributes_label_vbox");
-		app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
 
-		if (auto* treeview = lookup_widget<Gtk::TreeView*>("nvme_attributes_treeview")) {
-// 			Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
-// 			if (model)
-// 				model->clear();
-			treeview->remove_all_columns();
-			treeview->unset_model();
+
+void GscInfoWindow::clear_ui_tab(InfoTab tab)
+{
+	switch (tab) {
+		case InfoTab::General:
+		{
+			auto* identity_table = lookup_widget<Gtk::Grid*>("identity_table");
+			if (identity_table) {
+				// manually remove all children. without this visual corruption occurs.
+				auto children = identity_table->get_children();
+				for (auto& widget : children) {
+					identity_table->remove(*widget);
+				}
+			}
+
+			// tab label
+			app_highlight_tab_label(lookup_widget("general_tab_label"), WarningLevel::None, tab_names_.identity);
+			break;
 		}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("nvme_attributes_tab_label"), WarningLevel::None, tab_names_.nvme_attributes);
-	}
+		case InfoTab::AtaAttributes:
+		{
+			auto* label_vbox = lookup_widget<Gtk::Box*>("attributes_label_vbox");
+			app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+
+			if (auto* treeview = lookup_widget<Gtk::TreeView*>("attributes_treeview")) {
+// 				Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
+// 				if (model)
+// 					model->clear();
+				treeview->remove_all_columns();
+				treeview->unset_model();
+			}
 
-	{
-		auto* label_vbox = lookup_widget<Gtk::Box*>("statistics_label_vbox");
-		app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+			// tab label
+			app_highlight_tab_label(lookup_widget("attributes_tab_label"), WarningLevel::None, tab_names_.ata_attributes);
+			break;
+		}
 
-		if (auto* treeview = lookup_widget<Gtk::TreeView*>("statistics_treeview")) {
-			treeview->remove_all_columns();
-			treeview->unset_model();
+		case InfoTab::NvmeAttributes:
+		{
+			auto* label_vbox = lookup_widget<Gtk::Box*>("nvme_attributes_label_vbox");
+			app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+
+			if (auto* treeview = lookup_widget<Gtk::TreeView*>("nvme_attributes_treeview")) {
+// 				Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
+// 				if (model)
+// 					model->clear();
+				treeview->remove_all_columns();
+				treeview->unset_model();
+			}
+
+			// tab label
+			app_highlight_tab_label(lookup_widget("nvme_attributes_tab_label"), WarningLevel::None, tab_names_.nvme_attributes);
+			break;
 		}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("statistics_tab_label"), WarningLevel::None, tab_names_.statistics);
-	}
+		case InfoTab::Statistics:
+		{
+			statistics_filler_.cancel();
 
-	{
-		auto* label_vbox = lookup_widget<Gtk::Box*>("selftest_log_label_vbox");
-		app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
-
-		if (auto* treeview = lookup_widget<Gtk::TreeView*>("selftest_log_treeview")) {
-// 			Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
-// 			if (model)
-// 				model->clear();
-			treeview->remove_all_columns();
-			treeview->unset_model();
-		}
-
-		if (clear_tests_too) {
-			auto* test_type_combo = lookup_widget<Gtk::ComboBox*>("test_type_combo");
-			if (test_type_combo) {
-				test_type_combo->set_sensitive(false);  // true if testing is possible and not active.
-				// test_type_combo->clear();  // clear cellrenderers
-				if (test_combo_model_)
-					test_combo_model_->clear();
-			}
+			auto* label_vbox = lookup_widget<Gtk::Box*>("statistics_label_vbox");
+			app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
 
-			if (auto* min_duration_label = lookup_widget<Gtk::Label*>("min_duration_label"))
-				min_duration_label->set_text("N/A");  // set on test selection
+			if (auto* treeview = lookup_widget<Gtk::TreeView*>("statistics_treeview")) {
+				treeview->remove_all_columns();
+				treeview->unset_model();
+			}
 
-			if (auto* test_execute_button = lookup_widget<Gtk::Button*>("test_execute_button"))
-				test_execute_button->set_sensitive(false);  // true if testing is possible and not active
+			// tab label
+			app_highlight_tab_label(lookup_widget("statistics_tab_label"), WarningLevel::None, tab_names_.statistics);
+			break;
+		}
 
+		case InfoTab::SelfTestLog:
+		{
+			auto* label_vbox = lookup_widget<Gtk::Box*>("selftest_log_label_vbox");
+			app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+
+			if (auto* treeview = lookup_widget<Gtk::TreeView*>("selftest_log_treeview")) {
+// 				Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
+// 				if (model)
+// 					model->clear();
+				treeview->remove_all_columns();
+				treeview->unset_model();
+			}
 
-			auto* test_description_textview = lookup_widget<Gtk::TextView*>("test_description_textview");
-			if (test_description_textview != nullptr && test_description_textview->get_buffer())
-				test_description_textview->get_buffer()->set_text("");  // set on test selection
+			// tab label
+			app_highlight_tab_label(lookup_widget("test_tab_label"), WarningLevel::None, tab_names_.test);
+			break;
+		}
 
-			if (auto* test_completion_progressbar = lookup_widget<Gtk::ProgressBar*>("test_completion_progressbar")) {
-				test_completion_progressbar->set_text("");  // set when test is run or completed
-				test_completion_progressbar->set_sensitive(false);  // set when test is run or completed
-				test_completion_progressbar->hide();
+		case InfoTab::AtaErrorLog:
+		{
+			error_log_filler_.cancel();
+
+			auto* label_vbox = lookup_widget<Gtk::Box*>("error_log_label_vbox");
+			app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+
+			auto* treeview = lookup_widget<Gtk::TreeView*>("error_log_treeview");
+			if (treeview) {
+// 				Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
+// 				if (model)
+// 					model->clear();
+				treeview->remove_all_columns();
+				treeview->unset_model();
 			}
 
-			if (auto* test_stop_button = lookup_widget<Gtk::Button*>("test_stop_button")) {
-				test_stop_button->set_sensitive(false);  // true when test is active
-				test_stop_button->hide();
+			auto* textview = lookup_widget<Gtk::TextView*>("error_log_textview");
+			if (textview) {
+				// we re-create the buffer to get rid of all the Marks
+				textview->set_buffer(Gtk::TextBuffer::create());
+				textview->get_buffer()->set_text("\n"s + _("No data available"));
 			}
 
-			if (auto* test_result_hbox = lookup_widget<Gtk::Box*>("test_result_hbox"))
-				test_result_hbox->hide();  // hide by default. show when test is completed.
+			// tab label
+			app_highlight_tab_label(lookup_widget("error_log_tab_label"), WarningLevel::None, tab_names_.ata_error_log);
+			break;
 		}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("test_tab_label"), WarningLevel::None, tab_names_.test);
-	}
+		case InfoTab::NvmeErrorLog:
+		{
+			auto* label_vbox = lookup_widget<Gtk::Box*>("nvme_error_log_label_vbox");
+			app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
 
-	{
-		auto* label_vbox = lookup_widget<Gtk::Box*>("error_log_label_vbox");
-		app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+			auto* textview = lookup_widget<Gtk::TextView*>("nvme_error_log_textview");
+			if (textview) {
+				Glib::RefPtr<Gtk::TextBuffer> buffer = textview->get_buffer();
+				buffer->set_text("\n"s + _("No data available"));
+			}
 
-		auto* treeview = lookup_widget<Gtk::TreeView*>("error_log_treeview");
-		if (treeview) {
-// 			Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
-// 			if (model)
-// 				model->clear();
-			treeview->remove_all_columns();
-			treeview->unset_model();
+			// tab label
+			app_highlight_tab_label(lookup_widget("nvme_error_log_tab_label"), WarningLevel::None, tab_names_.nvme_error_log);
+			break;
 		}
 
-		auto* textview = lookup_widget<Gtk::TextView*>("error_log_textview");
-		if (textview) {
-			// we re-create the buffer to get rid of all the Marks
-			textview->set_buffer(Gtk::TextBuffer::create());
-			textview->get_buffer()->set_text("\n"s + _("No data available"));
-		}
+		case InfoTab::TemperatureLog:
+		{
+			auto* textview = lookup_widget<Gtk::TextView*>("temperature_log_textview");
+			if (textview) {
+				Glib::RefPtr<Gtk::TextBuffer> buffer = textview->get_buffer();
+				buffer->set_text("\n"s + _("No data available"));
+			}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("error_log_tab_label"), WarningLevel::None, tab_names_.ata_error_log);
-	}
+			// tab label
+			app_highlight_tab_label(lookup_widget("temperature_log_tab_label"), WarningLevel::None, tab_names_.temperature);
+			break;
+		}
 
-	{
-		auto* label_vbox = lookup_widget<Gtk::Box*>("nvme_error_log_label_vbox");
-		app_set_top_labels(label_vbox, std::vector<PropertyLabel>());
+		case InfoTab::Capabilities:
+		{
+			if (auto* treeview = lookup_widget<Gtk::TreeView*>("capabilities_treeview")) {
+				// It's better to clear the model rather than unset it. If we unset it, we'll have
+				// to deattach the callbacks too. But if we clear it, we have to remember column vars.
+// 				Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
+// 				if (model)
+// 					model->clear();
+				treeview->remove_all_columns();
+				treeview->unset_model();
+			}
 
-		auto* textview = lookup_widget<Gtk::TextView*>("nvme_error_log_textview");
-		if (textview) {
-			Glib::RefPtr<Gtk::TextBuffer> buffer = textview->get_buffer();
-			buffer->set_text("\n"s + _("No data available"));
+			// tab label
+			app_highlight_tab_label(lookup_widget("capabilities_tab_label"), WarningLevel::None, tab_names_.capabilities);
+			break;
 		}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("nvme_error_log_tab_label"), WarningLevel::None, tab_names_.nvme_error_log);
-	}
+		case InfoTab::ErcLog:
+		{
+			if (auto* textview = lookup_widget<Gtk::TextView*>("erc_log_textview")) {
+				textview->get_buffer()->set_text("\n"s + _("No data available"));
+			}
 
-	{
-		auto* textview = lookup_widget<Gtk::TextView*>("temperature_log_textview");
-		if (textview) {
-			Glib::RefPtr<Gtk::TextBuffer> buffer = textview->get_buffer();
-			buffer->set_text("\n"s + _("No data available"));
+			// tab label
+			app_highlight_tab_label(lookup_widget("erc_tab_label"), WarningLevel::None, tab_names_.erc);
+			break;
 		}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("temperature_log_tab_label"), WarningLevel::None, tab_names_.temperature);
-	}
+		case InfoTab::SelectiveSelfTestLog:
+		{
+			if (auto* textview = lookup_widget<Gtk::TextView*>("selective_selftest_log_textview")) {
+				textview->get_buffer()->set_text("\n"s + _("No data available"));
+			}
 
-	// tab label
-	app_highlight_tab_label(lookup_widget("advanced_tab_label"), WarningLevel::None, tab_names_.advanced);
+			// tab label
+			app_highlight_tab_label(lookup_widget("selective_selftest_tab_label"), WarningLevel::None, tab_names_.selective_selftest);
+			break;
+		}
 
-	{
-		if (auto* treeview = lookup_widget<Gtk::TreeView*>("capabilities_treeview")) {
-			// It's better to clear the model rather than unset it. If we unset it, we'll have
-			// to deattach the callbacks too. But if we clear it, we have to remember column vars.
-// 			Glib::RefPtr<Gtk::ListStore> model = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
-// 			if (model)
-// 				model->clear();
-			treeview->remove_all_columns();
-			treeview->unset_model();
+		case InfoTab::PhyLog:
+		{
+			if (auto* textview = lookup_widget<Gtk::TextView*>("phy_log_textview")) {
+				textview->get_buffer()->set_text("\n"s + _("No data available"));
+			}
+
+			// tab label
+			app_highlight_tab_label(lookup_widget("phy_tab_label"), WarningLevel::None, tab_names_.phy);
+			break;
 		}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("capabilities_tab_label"), WarningLevel::None, tab_names_.capabilities);
-	}
+		case InfoTab::DirectoryLog:
+		{
+			if (auto* textview = lookup_widget<Gtk::TextView*>("directory_log_textview")) {
+				textview->get_buffer()->set_text("\n"s + _("No data available"));
+			}
 
-	{
-		if (auto* textview = lookup_widget<Gtk::TextView*>("erc_log_textview")) {
-			textview->get_buffer()->set_text("\n"s + _("No data available"));
+			// tab label
+			app_highlight_tab_label(lookup_widget("directory_tab_label"), WarningLevel::None, tab_names_.directory);
+			break;
 		}
+	}
+}
+
+
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("erc_tab_label"), WarningLevel::None, tab_names_.erc);
+void GscInfoWindow::clear_ui_self_test_info()
+{
+	auto* test_type_combo = lookup_widget<Gtk::ComboBox*>("test_type_combo");
+	if (test_type_combo) {
+		test_type_combo->set_sensitive(false);  // true if testing is possible and not active.
+		// test_type_combo->clear();  // clear cellrenderers
+		if (test_combo_model_)
+			test_combo_model_->clear();
 	}
 
-	{
-		if (auto* textview = lookup_widget<Gtk::TextView*>("selective_selftest_log_textview")) {
-			textview->get_buffer()->set_text("\n"s + _("No data available"));
-		}
+	if (auto* min_duration_label = lookup_widget<Gtk::Label*>("min_duration_label"))
+		min_duration_label->set_text("N/A");  // set on test selection
+
+	if (auto* test_execute_button = lookup_widget<Gtk::Button*>("test_execute_button"))
+		test_execute_button->set_sensitive(false);  // true if testing is possible and not active
+
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("selective_selftest_tab_label"), WarningLevel::None, tab_names_.selective_selftest);
+	auto* test_description_textview = lookup_widget<Gtk::TextView*>("test_description_textview");
+	if (test_description_textview != nullptr && test_description_textview->get_buffer())
+		test_description_textview->get_buffer()->set_text("");  // set on test selection
+
+	if (auto* test_completion_progressbar = lookup_widget<Gtk::ProgressBar*>("test_completion_progressbar")) {
+		test_completion_progressbar->set_text("");  // set when test is run or completed
+		test_completion_progressbar->set_sensitive(false);  // set when test is run or completed
+		test_completion_progressbar->hide();
 	}
 
-	{
-		if (auto* textview = lookup_widget<Gtk::TextView*>("phy_log_textview")) {
-			textview->get_buffer()->set_text("\n"s + _("No data available"));
-		}
+	if (auto* test_stop_button = lookup_widget<Gtk::Button*>("test_stop_button")) {
+		test_stop_button->set_sensitive(false);  // true when test is active
+		test_stop_button->hide();
+	}
+
+	if (auto* test_result_hbox = lookup_widget<Gtk::Box*>("test_result_hbox"))
+		test_result_hbox->hide();  // hide by default. show when test is completed.
+}
+
+
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("phy_tab_label"), WarningLevel::None, tab_names_.phy);
+void GscInfoWindow::refresh_info(bool clear_tests_too)
+{
+	if (drive_->get_is_virtual()) {
+		this->fill_ui_with_info(true, true, clear_tests_too);  // nothing to fetch
+		return;
+	}
+	if (drive_->get_fetch_in_progress()) {
+		return;
 	}
 
-	{
-		if (auto* textview = lookup_widget<Gtk::TextView*>("directory_log_textview")) {
-			textview->get_buffer()->set_text("\n"s + _("No data available"));
+	// make insensitive until filled. helps with pressed F5 problem.
+	// This also prevents access to the drive data while it's being fetched.
+	this->set_sensitive(false);
+
+	// Fetch the data in a worker thread, so that the main loop (and
+	// the other windows) are not blocked while smartctl is running.
+	auto ex = std::make_shared<SmartctlExecutor>();
+	drive_->fetch_full_data_and_parse_async(ex, sigc::bind(
+			sigc::mem_fun(*this, &GscInfoWindow::on_drive_fetch_finished), clear_tests_too));
+}
+
+
+
+void GscInfoWindow::show_tests()
+{
+	if (auto* book = lookup_widget<Gtk::Notebook*>("main_notebook")) {
+		if (book_selftest_page_no_ >= 0) {
+			book->set_current_page(book_selftest_page_no_);  // the Tests tab
+		} else {
+			gui_show_warn_dialog(_("Self-Tests Not Supported"), _("Self-tests are not supported on this drive."), this);
 		}
+	}
+}
 
-		// tab label
-		app_highlight_tab_label(lookup_widget("directory_tab_label"), WarningLevel::None, tab_names_.directory);
+
+
+void GscInfoWindow::fill_pending_tabs()
+{
+	if (!displayed_properties_valid_ || filling_ui_) {
+		return;
 	}
+	for (std::size_t i = 0; i < info_tab_count; ++i) {
+		if (!tab_filled_[i]) {
+			const auto tab = static_cast<InfoTab>(i);
+			clear_ui_tab(tab);
+			fill_ui_tab(tab, nullptr);
+		}
+	}
+	update_advanced_tab_label();
+}
 
-	// Delete columns. We need to do this because otherwise,
-	// the column objects store their old indexes and will break when re-added
-	columns_.reset();
-	columns_ = std::make_unique<GscInfoWindowColumns>();
+
+
+std::vector<GscInfoWindowTabFillStats> GscInfoWindow::get_tab_fill_stats()
+{
+	const auto& stats = get_tab_fill_stats_storage();
+	return {stats.begin(), stats.end()};
 }
 
 
 
-void GscInfoWindow::refresh_info(bool clear_tests_too)
+void GscInfoWindow::reset_tab_fill_stats()
 {
-	this->set_sensitive(false);  // make insensitive until filled. helps with pressed F5 problem.
+	for (auto& stats : get_tab_fill_stats_storage()) {
+		stats.fills = 0;
+		stats.total_time = {};
+		stats.max_time = {};
+	}
+}
 
-	// this->clear_ui_info();  // no need, fill_ui_with_info() will call it.
-	this->fill_ui_with_info(true, true, clear_tests_too);
 
-	this->set_sensitive(true);  // make sensitive again.
+
+bool GscInfoWindow::get_drive_shown(const StorageDevice* drive)
+{
+	const auto& bound = info_window_get_bound();
+	return std::any_of(bound.begin(), bound.end(), [drive](const GscInfoWindow* win) {
+		return win->drive_.get() == drive;
+	});
 }
 
 
 
-void GscInfoWindow::show_tests()
+std::size_t GscInfoWindow::get_drive_ui_memory_usage(const StorageDevice* drive)
 {
-	if (auto* book = lookup_widget<Gtk::Notebook*>("main_notebook")) {
-		if (book_selftest_page_no_ >= 0) {
-			book->set_current_page(book_selftest_page_no_);  // the Tests tab
-		} else {
-			gui_show_warn_dialog(_("Self-Tests Not Supported"), _("Self-tests are not supported on this drive."), this);
+	// A list store row is a sequence node with a GValue per column. The strings
+	// in the rows are mostly copies of the property strings, estimated by these.
+	constexpr std::size_t row_overhead = 64;
+	constexpr std::size_t cell_size = 24 + 16;
+
+	std::size_t size = 0;
+	for (GscInfoWindow* win : info_window_get_bound()) {
+		if (win->drive_.get() != drive) {
+			continue;
+		}
+		for (const auto& props : win->displayed_properties_) {
+			size += props.get_memory_usage();
+		}
+		for (const char* name : {"attributes_treeview", "nvme_attributes_treeview", "statistics_treeview",
+				"selftest_log_treeview", "error_log_treeview", "capabilities_treeview"}) {
+			auto* treeview = win->lookup_widget<Gtk::TreeView*>(name);
+			const Glib::RefPtr<Gtk::TreeModel> model = (treeview ? treeview->get_model() : Glib::RefPtr<Gtk::TreeModel>());
+			if (model) {
+				const auto rows = static_cast<std::size_t>(model->children().size());
+				size += rows * (row_overhead + static_cast<std::size_t>(model->get_n_columns()) * cell_size);
+			}
 		}
 	}
+	return size;
 }
 
 
@@ -817,9 +1593,11 @@ void GscInfoWindow::on_view_output_button_clicked()
 	auto win = GscTextWindow<SmartctlOutputInstance>::create();
 	// make save visible and enable monospace font
 
-	std::string output = this->drive_->get_full_output();
-	if (output.empty()) {
-		output = this->drive_->get_basic_output();
+	// JSON outputs don't embed the text one by default, so it may have to be fetched now.
+	const std::string& full_output = this->drive_->get_full_output();
+	std::string output = (full_output.empty() ? this->drive_->get_basic_output() : full_output);
+	if (auto text_output = get_drive_text_output()) {
+		output = std::move(text_output.value());
 	}
 
 	win->set_text_from_command(_("Smartctl Output"), output);
@@ -833,6 +1611,34 @@ void GscInfoWindow::on_view_output_button_clicked()
 
 
 
+std::optional<std::string> GscInfoWindow::get_drive_text_output()
+{
+	auto ex = create_smartctl_executor();
+	ex->set_running_msg(Glib::ustring::compose(_("Running {command} on %1..."), drive_->get_device_with_type()));
+	auto text_output = drive_->get_text_output(ex);
+	if (!text_output) {
+		// Virtual drives may not have it, nothing to report.
+		if (text_output.error().data() != StorageDeviceError::CannotExecuteOnVirtual) {
+			gsc_executor_error_dialog_show(_("Cannot retrieve SMART data"), text_output.error().message(), this);
+		}
+		return std::nullopt;
+	}
+	return std::move(text_output.value());
+}
+
+
+
+std::shared_ptr<CommandExecutor> GscInfoWindow::create_smartctl_executor()
+{
+	if (!ex_factory_) {
+		ex_factory_ = std::make_shared<CommandExecutorFactoryGui>(this);  // pass this as dialog parent
+		ex_factory_->set_pooled(true);
+	}
+	return ex_factory_->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+}
+
+
+
 void GscInfoWindow::on_save_info_button_clicked()
 {
 	static std::string last_dir;
@@ -856,6 +1662,11 @@ void GscInfoWindow::on_save_info_button_clicked()
 	txt_filter->set_name(_("Text Files"));
 	txt_filter->add_pattern("*.txt");
 
+	Glib::RefPtr<Gtk::FileFilter> gz_filter = Gtk::FileFilter::create();
+	gz_filter->set_name(_("Compressed JSON and Text Files"));
+	gz_filter->add_pattern("*.json.gz");
+	gz_filter->add_pattern("*.txt.gz");
+
 	Glib::RefPtr<Gtk::FileFilter> all_filter = Gtk::FileFilter::create();
 	all_filter->set_name(_("All Files"));
 	all_filter->add_pattern("*");
@@ -870,6 +1681,7 @@ void GscInfoWindow::on_save_info_button_clicked()
 	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog.get()), specific_filter->gobj());
 	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog.get()), json_filter->gobj());
 	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog.get()), txt_filter->gobj());
+	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog.get()), gz_filter->gobj());
 	gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog.get()), all_filter->gobj());
 
 	if (!last_dir.empty())
@@ -893,6 +1705,7 @@ void GscInfoWindow::on_save_info_button_clicked()
 	dialog.add_filter(specific_filter);
 	dialog.add_filter(json_filter);
 	dialog.add_filter(txt_filter);
+	dialog.add_filter(gz_filter);
 	dialog.add_filter(all_filter);
 
 	if (!last_dir.empty())
@@ -920,29 +1733,33 @@ void GscInfoWindow::on_save_info_button_clicked()
 			rconfig::set_data("gui/drive_data_open_save_dir", last_dir);
 
 			bool txt_selected = gtk_file_chooser_get_filter(GTK_FILE_CHOOSER(dialog.get())) == txt_filter->gobj();
+			bool gz_selected = gtk_file_chooser_get_filter(GTK_FILE_CHOOSER(dialog.get())) == gz_filter->gobj();
+
+			// "name.json.gz" is saved compressed, with the format chosen by "name.json".
+			const bool compress = gz_selected || storage_output_get_file_compression(file) == StorageOutputCompression::Gzip;
+			file = storage_output_strip_compression_extension(file);
 
 			if (file.extension() != ".json" && file.extension() != ".txt") {
 				file += (txt_selected ? ".txt" : ".json");
 			}
 
 			bool save_txt = txt_selected || file.extension() == ".txt";
-
-			std::string data = this->drive_->get_full_output();
-			if (data.empty()) {
-				data = this->drive_->get_basic_output();
+			if (compress) {
+				file += ".gz";
 			}
+
+			const std::string& full_output = this->drive_->get_full_output();
+			std::string_view data = (full_output.empty() ? this->drive_->get_basic_output() : full_output);
+			std::string text_output;
 			if (save_txt) {
-				if (auto p = this->drive_->get_property_repository().lookup_property("smartctl/output"); !p.empty()) {
-					const std::string text_output = p.get_value<std::string>();
-					if (!text_output.empty()) {
-						data = text_output;
-					}
+				if (auto text = get_drive_text_output()) {
+					text_output = std::move(text.value());
+					data = text_output;
 				}
 			}
 
-			const std::error_code ec = hz::fs_file_put_contents(file, data);
-			if (ec) {
-				gui_show_error_dialog(_("Cannot save SMART data to file"), ec.message(), this);
+			if (auto status = storage_output_save(file, data); !status) {
+				gui_show_error_dialog(_("Cannot save SMART data to file"), status.error().message(), this);
 			}
 			break;
 		}
@@ -963,13 +1780,63 @@ void GscInfoWindow::on_close_window_button_clicked()
 {
 	if (drive_ && drive_->get_test_is_active()) {  // disallow close if test is active.
 		gui_show_warn_dialog(_("Please wait until all tests are finished."), this);
-	} else {
+	} else if (!release_to_pool()) {
 		destroy_instance();  // deletes this object and nullifies instance
 	}
 }
 
 
 
+bool GscInfoWindow::release_to_pool()
+{
+	auto& pool = info_window_get_pool();
+	auto self = get_stored_instance();
+	if (!self || pool.size() >= info_window_get_max_pool_size()) {
+		return false;
+	}
+	hide();
+	store_window_size();
+	unbind_drive();
+	pool.push_back(self);
+	return true;
+}
+
+
+
+void GscInfoWindow::unbind_drive()
+{
+	if (drive_) {
+		drive_changed_connection_.disconnect();
+		if (refresh_scheduler_) {
+			refresh_scheduler_->remove_drive(drive_);
+		}
+	}
+	if (auto io_performance_monitor = storage_io_performance_get_global(); io_performance_monitor && io_performance_user_) {
+		io_performance_monitor->remove_user();
+	}
+	io_performance_user_ = false;
+
+	clear_ui_info(true);
+	if (auto* book = lookup_widget<Gtk::Notebook*>("main_notebook")) {
+		book->set_current_page(0);
+	}
+	this->set_sensitive(true);  // in case a refresh was in progress, its result is ignored
+	drive_.reset();
+	std::erase(info_window_get_bound(), this);
+}
+
+
+
+void GscInfoWindow::store_window_size()
+{
+	int window_w = 0, window_h = 0;
+	get_size(window_w, window_h);
+	rconfig::set_data("gui/info_window/default_size_w", window_w);
+	rconfig::set_data("gui/info_window/default_size_h", window_h);
+}
+
+
+
 void GscInfoWindow::on_test_type_combo_changed()
 {
 	auto* test_type_combo = lookup_widget<Gtk::ComboBox*>("test_type_combo");
@@ -1097,82 +1964,97 @@ void GscInfoWindow::fill_ui_general(const StoragePropertyRepository& property_re
 
 
 
-void GscInfoWindow::fill_ui_ata_attributes(const StoragePropertyRepository& property_repo)
+void GscInfoWindow::fill_ui_ata_attributes(const StoragePropertyRepository& property_repo,
+		const StoragePropertyRepository* displayed_repo)
 {
 	const auto& props = property_repo.get_properties();
 
 	auto* treeview = lookup_widget<Gtk::TreeView*>("attributes_treeview");
 
-	Gtk::TreeModelColumnRecord model_columns;
-	[[maybe_unused]] int num_tree_col = 0;
+	Glib::RefPtr<Gtk::ListStore> list_store;
+
+	if (displayed_repo) {
+		// Same rows as before, update the changed ones in place. This keeps the scroll position and selection.
+		app_update_table_rows(*treeview, columns_->ata_attribute_table_columns.storage_property, *displayed_repo, property_repo,
+				[this](Gtk::TreeRow& row, const StorageProperty& p) { set_ata_attribute_row(row, p); });
+
+	} else {
+		Gtk::TreeModelColumnRecord model_columns;
+		[[maybe_unused]] int num_tree_col = 0;
 
-	// ID (int), Name, Flag (hex), Normalized Value (uint8), Worst (uint8), Thresh (uint8), Raw (int64), Type (string),
-	// Updated (string), When Failed (string)
+		// ID (int), Name, Flag (hex), Normalized Value (uint8), Worst (uint8), Thresh (uint8), Raw (int64), Type (string),
+		// Updated (string), When Failed (string)
 
-	model_columns.add(columns_->ata_attribute_table_columns.id);  // we can use the column variable by value after this.
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.id, *treeview, _("ID"), _("Attribute ID"), true);
+		model_columns.add(columns_->ata_attribute_table_columns.id);  // we can use the column variable by value after this.
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.id, *treeview, _("ID"), _("Attribute ID"), true);
 
-	model_columns.add(columns_->ata_attribute_table_columns.displayable_name);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.displayable_name, *treeview,
-			_("Name"), _("Attribute name (this is deduced from ID by smartctl and may be incorrect, as it's highly vendor-specific)"), true);
-	treeview->set_search_column(columns_->ata_attribute_table_columns.displayable_name.index());
+		model_columns.add(columns_->ata_attribute_table_columns.displayable_name);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.displayable_name, *treeview,
+				_("Name"), _("Attribute name (this is deduced from ID by smartctl and may be incorrect, as it's highly vendor-specific)"), true);
+		treeview->set_search_column(columns_->ata_attribute_table_columns.displayable_name.index());
 
-	model_columns.add(columns_->ata_attribute_table_columns.when_failed);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.when_failed, *treeview,
-			_("Failed"), _("When failed (that is, the normalized value became equal to or less than threshold)"), true, true);
+		model_columns.add(columns_->ata_attribute_table_columns.when_failed);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.when_failed, *treeview,
+				_("Failed"), _("When failed (that is, the normalized value became equal to or less than threshold)"), true, true);
 
-	model_columns.add(columns_->ata_attribute_table_columns.normalized_value);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.normalized_value, *treeview,
-			C_("value", "Normalized"), _("Normalized value (highly vendor-specific; converted from Raw value by the drive's firmware)"), false);
+		model_columns.add(columns_->ata_attribute_table_columns.normalized_value);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.normalized_value, *treeview,
+				C_("value", "Normalized"), _("Normalized value (highly vendor-specific; converted from Raw value by the drive's firmware)"), false);
 
-	model_columns.add(columns_->ata_attribute_table_columns.worst);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.worst, *treeview,
-			C_("value", "Worst"), _("The worst normalized value recorded for this attribute during the drive's lifetime (with SMART enabled)"), false);
+		model_columns.add(columns_->ata_attribute_table_columns.worst);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.worst, *treeview,
+				C_("value", "Worst"), _("The worst normalized value recorded for this attribute during the drive's lifetime (with SMART enabled)"), false);
 
-	model_columns.add(columns_->ata_attribute_table_columns.threshold);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.threshold, *treeview,
-			C_("value", "Threshold"), _("Threshold for normalized value. Normalized value should be greater than threshold (unless vendor thinks otherwise)."), false);
+		model_columns.add(columns_->ata_attribute_table_columns.threshold);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.threshold, *treeview,
+				C_("value", "Threshold"), _("Threshold for normalized value. Normalized value should be greater than threshold (unless vendor thinks otherwise)."), false);
 
-	model_columns.add(columns_->ata_attribute_table_columns.raw);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.raw, *treeview,
-			_("Raw value"), _("Raw value as reported by drive. May or may not be sensible."), false);
+		model_columns.add(columns_->ata_attribute_table_columns.raw);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.raw, *treeview,
+				_("Raw value"), _("Raw value as reported by drive. May or may not be sensible."), false);
 
-	model_columns.add(columns_->ata_attribute_table_columns.type);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.type, *treeview,
-			_("Type"), _("Alarm condition is reached when normalized value becomes less than or equal to threshold. Type indicates whether it's a signal of drive's pre-failure time or just an old age."), false, true);
+		model_columns.add(columns_->ata_attribute_table_columns.type);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.type, *treeview,
+				_("Type"), _("Alarm condition is reached when normalized value becomes less than or equal to threshold. Type indicates whether it's a signal of drive's pre-failure time or just an old age."), false, true);
 
-	// Doesn't carry that much info. Advanced users can look at the flags.
+		// Doesn't carry that much info. Advanced users can look at the flags.
 // 		model_columns.add(attribute_table_columns.updated);
 // 		tree_col = app_gtkmm_create_tree_view_column(attribute_table_columns.updated, *treeview,
 // 				"Updated", "The attribute is usually updated continuously, or during Offline Data Collection only. This column indicates that.", true);
 
-	model_columns.add(columns_->ata_attribute_table_columns.flag_value);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.flag_value, *treeview,
-			_("Flags"), _("Flags") + "\n\n"s
-					+ Glib::ustring::compose(_("If given in %1 format, the presence of each letter indicates that the flag is on."), "POSRCK+") + "\n"
-					+ _("P: pre-failure attribute (if the attribute failed, the drive is failing)") + "\n"
-					+ _("O: updated continuously (as opposed to updated on offline data collection)") + "\n"
-					+ _("S: speed / performance attribute") + "\n"
-					+ _("R: error rate") + "\n"
-					+ _("C: event count") + "\n"
-					+ _("K: auto-keep") + "\n"
-					+ _("+: undocumented bits present"), false);
-
-	model_columns.add(columns_->ata_attribute_table_columns.tooltip);
-	treeview->set_tooltip_column(columns_->ata_attribute_table_columns.tooltip.index());
-
-	model_columns.add(columns_->ata_attribute_table_columns.storage_property);
-
-
-	// create a TreeModel (ListStore)
-	Glib::RefPtr<Gtk::ListStore> list_store = Gtk::ListStore::create(model_columns);
-	list_store->set_sort_column(columns_->ata_attribute_table_columns.id, Gtk::SORT_ASCENDING);  // default sort
-	treeview->set_model(list_store);
+		model_columns.add(columns_->ata_attribute_table_columns.flag_value);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->ata_attribute_table_columns.flag_value, *treeview,
+				_("Flags"), _("Flags") + "\n\n"s
+						+ Glib::ustring::compose(_("If given in %1 format, the presence of each letter indicates that the flag is on."), "POSRCK+") + "\n"
+						+ _("P: pre-failure attribute (if the attribute failed, the drive is failing)") + "\n"
+						+ _("O: updated continuously (as opposed to updated on offline data collection)") + "\n"
+						+ _("S: speed / performance attribute") + "\n"
+						+ _("R: error rate") + "\n"
+						+ _("C: event count") + "\n"
+						+ _("K: auto-keep") + "\n"
+						+ _("+: undocumented bits present"), false);
+
+		model_columns.add(columns_->ata_attribute_table_columns.storage_property);
+
+
+		// create a TreeModel (ListStore). Only the ID and the property are stored, the rest is formatted on demand.
+		list_store = Gtk::ListStore::create(model_columns);
+		list_store->set_sort_column(columns_->ata_attribute_table_columns.id, Gtk::SORT_ASCENDING);  // default sort
+		const PropertyCellFormatter format = [this](const StorageProperty& p, int column_index) {
+			return format_ata_attribute_cell(p, column_index);
+		};
+		app_set_property_sort_func(list_store, columns_->ata_attribute_table_columns.storage_property,
+				columns_->ata_attribute_table_columns.displayable_name.index(), format);
+		app_set_property_sort_func(list_store, columns_->ata_attribute_table_columns.storage_property,
+				columns_->ata_attribute_table_columns.when_failed.index(), format);
+		treeview->set_model(list_store);
+		app_set_property_table_callbacks(*treeview, columns_->ata_attribute_table_columns.storage_property);
 
-	for (int i = 0; i < int(treeview->get_n_columns()); ++i) {
-		Gtk::TreeViewColumn* tcol = treeview->get_column(i);
-		tcol->set_cell_data_func(*(tcol->get_first_cell()),
-				sigc::bind(sigc::mem_fun(*this, &GscInfoWindow::cell_renderer_for_ata_attributes), i));
+		for (int i = 0; i < int(treeview->get_n_columns()); ++i) {
+			Gtk::TreeViewColumn* tcol = treeview->get_column(i);
+			tcol->set_cell_data_func(*(tcol->get_first_cell()),
+					sigc::bind(sigc::mem_fun(*this, &GscInfoWindow::cell_renderer_for_ata_attributes), i));
+		}
 	}
 
 
@@ -1192,23 +2074,10 @@ void GscInfoWindow::fill_ui_ata_attributes(const StoragePropertyRepository& prop
 			continue;
 		}
 
-		const auto& attr = p.get_value<AtaStorageAttribute>();
-
-		Gtk::TreeRow row = *(list_store->append());
-		row[columns_->ata_attribute_table_columns.id] = attr.id;
-		row[columns_->ata_attribute_table_columns.displayable_name] = Glib::Markup::escape_text(p.displayable_name);
-		row[columns_->ata_attribute_table_columns.flag_value] = Glib::Markup::escape_text(attr.flag);  // it's a string, not int.
-		row[columns_->ata_attribute_table_columns.normalized_value] = Glib::Markup::escape_text(attr.value.has_value() ? hz::number_to_string_locale(attr.value.value()) : "-");
-		row[columns_->ata_attribute_table_columns.worst] = Glib::Markup::escape_text(attr.worst.has_value() ? hz::number_to_string_locale(attr.worst.value()) : "-");
-		row[columns_->ata_attribute_table_columns.threshold] = Glib::Markup::escape_text(attr.threshold.has_value() ? hz::number_to_string_locale(attr.threshold.value()) : "-");
-		row[columns_->ata_attribute_table_columns.raw] = Glib::Markup::escape_text(attr.format_raw_value());
-		row[columns_->ata_attribute_table_columns.type] = Glib::Markup::escape_text(
-				AtaStorageAttribute::get_readable_attribute_type_name(attr.attr_type));
-// 		row[attribute_table_columns.updated] = Glib::Markup::escape_text(AtaStorageAttribute::get_update_type_name(attr.update_type));
-		row[columns_->ata_attribute_table_columns.when_failed] = Glib::Markup::escape_text(
-				AtaStorageAttribute::get_readable_fail_time_name(attr.when_failed));
-		row[columns_->ata_attribute_table_columns.tooltip] = p.get_description();  // markup
-		row[columns_->ata_attribute_table_columns.storage_property] = &p;
+		if (!displayed_repo) {
+			Gtk::TreeRow row = *(list_store->append());
+			set_ata_attribute_row(row, p);
+		}
 
 		if (int(p.warning_level) > int(max_tab_warning))
 			max_tab_warning = p.warning_level;
@@ -1224,40 +2093,93 @@ void GscInfoWindow::fill_ui_ata_attributes(const StoragePropertyRepository& prop
 
 
 
-void GscInfoWindow::fill_ui_nvme_attributes(const StoragePropertyRepository& property_repo)
+void GscInfoWindow::set_ata_attribute_row(Gtk::TreeRow& row, const StorageProperty& p)
+{
+	const auto& attr = p.get_value<AtaStorageAttribute>();
+
+	// The other columns are formatted in cell_renderer_for_ata_attributes().
+	row[columns_->ata_attribute_table_columns.id] = attr.id;
+	row[columns_->ata_attribute_table_columns.storage_property] = &p;
+}
+
+
+
+std::optional<Glib::ustring> GscInfoWindow::format_ata_attribute_cell(const StorageProperty& p, int column_index) const
+{
+	const auto& columns = columns_->ata_attribute_table_columns;
+	const auto& attr = p.get_value<AtaStorageAttribute>();
+
+	std::string text;
+	if (column_index == columns.displayable_name.index()) {
+		text = p.displayable_name;
+	} else if (column_index == columns.flag_value.index()) {
+		text = attr.flag;  // it's a string, not int.
+	} else if (column_index == columns.normalized_value.index()) {
+		text = attr.value.has_value() ? hz::number_to_string_locale(attr.value.value()) : "-";
+	} else if (column_index == columns.worst.index()) {
+		text = attr.worst.has_value() ? hz::number_to_string_locale(attr.worst.value()) : "-";
+	} else if (column_index == columns.threshold.index()) {
+		text = attr.threshold.has_value() ? hz::number_to_string_locale(attr.threshold.value()) : "-";
+	} else if (column_index == columns.raw.index()) {
+		text = attr.format_raw_value();
+	} else if (column_index == columns.type.index()) {
+		text = AtaStorageAttribute::get_readable_attribute_type_name(attr.attr_type);
+	} else if (column_index == columns.when_failed.index()) {
+		text = AtaStorageAttribute::get_readable_fail_time_name(attr.when_failed);
+	} else {
+		return std::nullopt;
+	}
+	return Glib::Markup::escape_text(text);
+}
+
+
+
+void GscInfoWindow::fill_ui_nvme_attributes(const StoragePropertyRepository& property_repo,
+		const StoragePropertyRepository* displayed_repo)
 {
 	const auto& props = property_repo.get_properties();
 
 	auto* treeview = lookup_widget<Gtk::TreeView*>("nvme_attributes_treeview");
 
-	Gtk::TreeModelColumnRecord model_columns;
-	[[maybe_unused]] int num_tree_col = 0;
+	Glib::RefPtr<Gtk::ListStore> list_store;
 
-	model_columns.add(columns_->nvme_attribute_table_columns.displayable_name);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->nvme_attribute_table_columns.displayable_name, *treeview,
-			_("Description"), _("Entry description"), true);
-	treeview->set_search_column(columns_->nvme_attribute_table_columns.displayable_name.index());
+	if (displayed_repo) {
+		// Same rows as before, update the changed ones in place. This keeps the scroll position and selection.
+		app_update_table_rows(*treeview, columns_->nvme_attribute_table_columns.storage_property, *displayed_repo, property_repo,
+				[this](Gtk::TreeRow& row, const StorageProperty& p) { set_nvme_attribute_row(row, p); });
 
-	model_columns.add(columns_->nvme_attribute_table_columns.value);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->nvme_attribute_table_columns.value, *treeview,
-			_("Value"), _("Value"), false);
+	} else {
+		Gtk::TreeModelColumnRecord model_columns;
+		[[maybe_unused]] int num_tree_col = 0;
 
-	model_columns.add(columns_->nvme_attribute_table_columns.tooltip);
-	treeview->set_tooltip_column(columns_->nvme_attribute_table_columns.tooltip.index());
+		model_columns.add(columns_->nvme_attribute_table_columns.displayable_name);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->nvme_attribute_table_columns.displayable_name, *treeview,
+				_("Description"), _("Entry description"), true);
+		treeview->set_search_column(columns_->nvme_attribute_table_columns.displayable_name.index());
 
-	model_columns.add(columns_->nvme_attribute_table_columns.storage_property);
+		model_columns.add(columns_->nvme_attribute_table_columns.value);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->nvme_attribute_table_columns.value, *treeview,
+				_("Value"), _("Value"), false);
 
+		model_columns.add(columns_->nvme_attribute_table_columns.storage_property);
 
-	// create a TreeModel (ListStore)
-	Glib::RefPtr<Gtk::ListStore> list_store = Gtk::ListStore::create(model_columns);
-	treeview->set_model(list_store);
 
-	for (int i = 0; i < int(treeview->get_n_columns()); ++i) {
-		Gtk::TreeViewColumn* tcol = treeview->get_column(i);
-		tcol->set_cell_data_func(*(tcol->get_first_cell()),
-				sigc::bind(sigc::mem_fun(*this, &GscInfoWindow::cell_renderer_for_nvme_attributes), i));
+		// create a TreeModel (ListStore). Only the property is stored, the cells are formatted on demand.
+		list_store = Gtk::ListStore::create(model_columns);
+		app_set_property_sort_func(list_store, columns_->nvme_attribute_table_columns.storage_property,
+				columns_->nvme_attribute_table_columns.displayable_name.index(),
+				[this](const StorageProperty& p, int column_index) { return format_nvme_attribute_cell(p, column_index); });
+		treeview->set_model(list_store);
+		app_set_property_table_callbacks(*treeview, columns_->nvme_attribute_table_columns.storage_property);
+
+		for (int i = 0; i < int(treeview->get_n_columns()); ++i) {
+			Gtk::TreeViewColumn* tcol = treeview->get_column(i);
+			tcol->set_cell_data_func(*(tcol->get_first_cell()),
+					sigc::bind(sigc::mem_fun(*this, &GscInfoWindow::cell_renderer_for_nvme_attributes), i));
+		}
 	}
 
+
 	WarningLevel max_tab_warning = WarningLevel::None;
 	std::vector<PropertyLabel> label_strings;  // outside-of-tree properties
 
@@ -1265,13 +2187,10 @@ void GscInfoWindow::fill_ui_nvme_attributes(const StoragePropertyRepository& pro
 		if (p.section != StoragePropertySection::NvmeAttributes || !p.show_in_ui)
 			continue;
 
-		Gtk::TreeRow row = *(list_store->append());
-
-		const auto& value = p.format_value();
-		row[columns_->nvme_attribute_table_columns.displayable_name] = Glib::Markup::escape_text(p.displayable_name);
-		row[columns_->nvme_attribute_table_columns.value] = Glib::Markup::escape_text(value);
-		row[columns_->nvme_attribute_table_columns.tooltip] = p.get_description();  // markup
-		row[columns_->nvme_attribute_table_columns.storage_property] = &p;
+		if (!displayed_repo) {
+			Gtk::TreeRow row = *(list_store->append());
+			set_nvme_attribute_row(row, p);
+		}
 
 		if (int(p.warning_level) > int(max_tab_warning))
 			max_tab_warning = p.warning_level;
@@ -1286,56 +2205,91 @@ void GscInfoWindow::fill_ui_nvme_attributes(const StoragePropertyRepository& pro
 
 
 
-void GscInfoWindow::fill_ui_statistics(const StoragePropertyRepository& property_repo)
+void GscInfoWindow::set_nvme_attribute_row(Gtk::TreeRow& row, const StorageProperty& p)
+{
+	// The cells are formatted in cell_renderer_for_nvme_attributes().
+	row[columns_->nvme_attribute_table_columns.storage_property] = &p;
+}
+
+
+
+std::optional<Glib::ustring> GscInfoWindow::format_nvme_attribute_cell(const StorageProperty& p, int column_index) const
+{
+	const auto& columns = columns_->nvme_attribute_table_columns;
+	if (column_index == columns.displayable_name.index()) {
+		return Glib::Markup::escape_text(p.displayable_name);
+	}
+	if (column_index == columns.value.index()) {
+		return Glib::Markup::escape_text(p.format_value());
+	}
+	return std::nullopt;
+}
+
+
+
+void GscInfoWindow::fill_ui_statistics(const StoragePropertyRepository& property_repo,
+		const StoragePropertyRepository* displayed_repo)
 {
 	const auto& props = property_repo.get_properties();
 
 	auto* treeview = lookup_widget<Gtk::TreeView*>("statistics_treeview");
 
-	Gtk::TreeModelColumnRecord model_columns;
-	[[maybe_unused]] int num_tree_col = 0;
+	Glib::RefPtr<Gtk::ListStore> list_store;
 
-	model_columns.add(columns_->statistics_table_columns.displayable_name);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.displayable_name, *treeview,
-			_("Description"), _("Entry description"), true);
-	treeview->set_search_column(columns_->statistics_table_columns.displayable_name.index());
+	if (displayed_repo) {
+		// Same rows as before, update the changed ones in place. This keeps the scroll position and selection.
+		app_update_table_rows(*treeview, columns_->statistics_table_columns.storage_property, *displayed_repo, property_repo,
+				[this](Gtk::TreeRow& row, const StorageProperty& p) { set_statistics_row(row, p); });
 
-	model_columns.add(columns_->statistics_table_columns.value);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.value, *treeview,
-			_("Value"), Glib::ustring::compose(_("Value (can be normalized if '%1' flag is present)"), "N"), false);
+	} else {
+		Gtk::TreeModelColumnRecord model_columns;
+		[[maybe_unused]] int num_tree_col = 0;
 
-	model_columns.add(columns_->statistics_table_columns.flags);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.flags, *treeview,
-			_("Flags"), _("Flags") + "\n\n"s
-					+ _("V: valid") + "\n"
-					+ _("N: value is normalized") + "\n"
-					+ _("D: supports Device Statistics Notification (DSN)") + "\n"
-					+ _("C: monitored condition met") + "\n"  // Related to DSN? From the specification, it looks like something user-controllable.
-					+ _("+: undocumented bits present"), false);
+		model_columns.add(columns_->statistics_table_columns.displayable_name);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.displayable_name, *treeview,
+				_("Description"), _("Entry description"), true);
+		treeview->set_search_column(columns_->statistics_table_columns.displayable_name.index());
 
-	model_columns.add(columns_->statistics_table_columns.page_offset);
-	num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.page_offset, *treeview,
-			_("Page, Offset"), _("Page and offset of the entry"), false);
+		model_columns.add(columns_->statistics_table_columns.value);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.value, *treeview,
+				_("Value"), Glib::ustring::compose(_("Value (can be normalized if '%1' flag is present)"), "N"), false);
 
-	model_columns.add(columns_->statistics_table_columns.tooltip);
-	treeview->set_tooltip_column(columns_->statistics_table_columns.tooltip.index());
+		model_columns.add(columns_->statistics_table_columns.flags);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.flags, *treeview,
+				_("Flags"), _("Flags") + "\n\n"s
+						+ _("V: valid") + "\n"
+						+ _("N: value is normalized") + "\n"
+						+ _("D: supports Device Statistics Notification (DSN)") + "\n"
+						+ _("C: monitored condition met") + "\n"  // Related to DSN? From the specification, it looks like something user-controllable.
+						+ _("+: undocumented bits present"), false);
 
-	model_columns.add(columns_->statistics_table_columns.storage_property);
+		model_columns.add(columns_->statistics_table_columns.page_offset);
+		num_tree_col = app_gtkmm_create_tree_view_column(columns_->statistics_table_columns.page_offset, *treeview,
+				_("Page, Offset"), _("Page and offset of the entry"), false);
 
+		model_columns.add(columns_->statistics_table_columns.storage_property);
 
-	// create a TreeModel (ListStore)
-	Glib::RefPtr<Gtk::ListStore> list_store = Gtk::ListStore::create(model_columns);
-	treeview->set_model(list_store);
-	// No sorting (we don't want to screw up the headers).
 
-	for (int i = 0; i < int(treeview->get_n_columns()); ++i) {
-		Gtk::TreeViewColumn* tcol = treeview->get_column(i);
-		tcol->set_cell_data_func(*(tcol->get_first_cell()),
-				sigc::bind(sigc::mem_fun(*this, &GscInfoWindow::cell_renderer_for_statistics), i));
+		// create a TreeModel (ListStore). Only the property is stored, the cells are formatted on demand.
+		list_store = Gtk::ListStore::create(model_columns);
+		app_set_property_sort_func(list_store, columns_->statistics_table_columns.storage_property,
+				columns_->statistics_table_columns.displayable_name.index(),
+				[this](const StorageProperty& p, int column_index) { return format_statistics_cell(p, column_index); });
+		treeview->set_model(list_store);
+		app_set_property_table_callbacks(*treeview, columns_->statistics_table_columns.storage_property);
+		// No sorting (we don't want to screw up the headers).
+
+		for (int i = 0; i < int(treeview->get_n_columns()); ++i) {
+			Gtk::TreeViewColumn* tcol = treeview->get_column(i);
+			tcol->set_cell_data_func(*(tcol->get_first_cell()),
+					sigc::bind(sigc::mem_fun(*this, &GscInfoWindow::cell_renderer_for_statistics), i));
+		}
 	}
 
+
 	WarningLevel max_tab_warning = WarningLevel::None;
 	std::vector<PropertyLabel> label_strings;  // outside-of-tree properties
+	std::vector<const StorageProperty*> row_props;  // in display order
 
 	for (const auto& p : props) {
 		if (p.section != StoragePropertySection::Statistics || !p.show_in_ui)
@@ -1350,21 +2304,23 @@ void GscInfoWindow::fill_ui_statistics(const StoragePropertyRepository& property
 			continue;
 		}
 
-		Gtk::TreeRow row = *(list_store->append());
-
-		const auto& st = p.get_value<AtaStorageStatistic>();
-		row[columns_->statistics_table_columns.displayable_name] = Glib::Markup::escape_text(st.is_header ? p.displayable_name : ("    " + p.displayable_name));
-		row[columns_->statistics_table_columns.value] = Glib::Markup::escape_text(st.format_value());
-		row[columns_->statistics_table_columns.flags] = Glib::Markup::escape_text(st.flags);  // it's a string, not int.
-		row[columns_->statistics_table_columns.page_offset] = Glib::Markup::escape_text(st.is_header ? std::string()
-				: hz::string_sprintf("0x%02x, 0x%03x", int(st.page), int(st.offset)));
-		row[columns_->statistics_table_columns.tooltip] = p.get_description();  // markup
-		row[columns_->statistics_table_columns.storage_property] = &p;
+		if (!displayed_repo) {
+			row_props.push_back(&p);
+		}
 
 		if (int(p.warning_level) > int(max_tab_warning))
 			max_tab_warning = p.warning_level;
 	}
 
+	// The rows point to displayed_properties_, the fill is cancelled in clear_ui_tab() before they change.
+	if (!displayed_repo) {
+		const std::size_t row_count = row_props.size();
+		statistics_filler_.start(list_store, row_count,
+				[this, row_props = std::move(row_props)](Gtk::TreeRow& row, std::size_t index) {
+					set_statistics_row(row, *row_props[index]);
+				});
+	}
+
 	auto* label_vbox = lookup_widget<Gtk::Box*>("statistics_label_vbox");
 	app_set_top_labels(label_vbox, label_strings);
 
@@ -1374,6 +2330,36 @@ void GscInfoWindow::fill_ui_statistics(const StoragePropertyRepository& property
 
 
 
+void GscInfoWindow::set_statistics_row(Gtk::TreeRow& row, const StorageProperty& p)
+{
+	// The cells are formatted in cell_renderer_for_statistics().
+	row[columns_->statistics_table_columns.storage_property] = &p;
+}
+
+
+
+std::optional<Glib::ustring> GscInfoWindow::format_statistics_cell(const StorageProperty& p, int column_index) const
+{
+	const auto& columns = columns_->statistics_table_columns;
+	const auto& st = p.get_value<AtaStorageStatistic>();
+
+	std::string text;
+	if (column_index == columns.displayable_name.index()) {
+		text = st.is_header ? p.displayable_name : ("    " + p.displayable_name);
+	} else if (column_index == columns.value.index()) {
+		text = st.format_value();
+	} else if (column_index == columns.flags.index()) {
+		text = st.flags;  // it's a string, not int.
+	} else if (column_index == columns.page_offset.index()) {
+		text = st.is_header ? std::string() : hz::string_sprintf("0x%02x, 0x%03x", int(st.page), int(st.offset));
+	} else {
+		return std::nullopt;
+	}
+	return Glib::Markup::escape_text(text);
+}
+
+
+
 void GscInfoWindow::fill_ui_self_test_info()
 {
 	auto* test_type_combo = lookup_widget<Gtk::ComboBox*>("test_type_combo");
@@ -1445,6 +2431,42 @@ void GscInfoWindow::fill_ui_self_test_info()
 		row[test_combo_columns_.self_test] = test_conveyance;
 	}
 
+	// Test only the areas around the recorded errors, this takes minutes instead of hours.
+	// The logs keep only the latest errors, so the older ones are taken from history.
+	const auto& property_repo = drive_->get_property_repository();
+	auto error_lbas = selftest_get_error_lbas(property_repo);
+	if (auto history = storage_history_get_global(); history && !drive_->get_serial_number().empty()) {
+		if (auto history_lbas = history->get_error_lbas(drive_->get_serial_number())) {
+			const auto lbas = history_lbas->get_lbas();
+			error_lbas.insert(error_lbas.end(), lbas.begin(), lbas.end());
+			std::sort(error_lbas.begin(), error_lbas.end());
+			error_lbas.erase(std::unique(error_lbas.begin(), error_lbas.end()), error_lbas.end());
+		}
+	}
+	if (!error_lbas.empty()) {
+		const std::uint64_t sector_size = selftest_get_logical_sector_size(property_repo);
+		const std::uint64_t radius = std::max<std::uint64_t>(1,
+				static_cast<std::uint64_t>(std::max(0, rconfig::get_data<int>("gui/selective_selftest_radius_mib"))) * 1024 * 1024 / sector_size);
+		auto test_selective = std::make_shared<SelfTest>(drive_, SelfTest::TestType::Selective);
+		test_selective->set_selective_spans(selftest_plan_selective_spans(error_lbas, radius, selftest_get_max_lba(property_repo)));
+		if (test_selective->is_supported()) {
+			std::vector<std::string> span_strs;
+			for (const auto& span : test_selective->get_selective_spans()) {
+				span_strs.push_back(hz::number_to_string_locale(span.start) + " - " + hz::number_to_string_locale(span.end));
+			}
+			row = *(test_combo_model_->append());
+			row[test_combo_columns_.name] = _("Selective Self-Test of Error Areas");
+			/// Translators: %1 is the number of error LBAs, %2 is a list of LBA spans, %3 is size
+			row[test_combo_columns_.description] = Glib::ustring::compose(
+					_("Selective self-test reads only the areas around the %1 LBAs recorded in the Error Log and the Self-Test Log:"
+					" %2 (%3 in total). This verifies the suspect areas much faster than the Extended self-test."
+					" Its result is reported in the Self-Test Log."),
+					error_lbas.size(), hz::string_join(span_strs, ", "),
+					hz::format_size(selftest_get_spans_sector_count(test_selective->get_selective_spans()) * sector_size, true));
+			row[test_combo_columns_.self_test] = test_selective;
+		}
+	}
+
 	if (!test_combo_model_->children().empty()) {
 		test_type_combo->set_sensitive(true);
 		test_type_combo->set_active(test_combo_model_->children().begin());  // select first entry
@@ -1613,18 +2635,24 @@ void GscInfoWindow::fill_ui_ata_error_log(const StoragePropertyRepository& prope
 	num_tree_col = app_gtkmm_create_tree_view_column(columns_->error_log_table_columns.details, *treeview,
 			_("Details"), _("Additional details"), true);
 
-	model_columns.add(columns_->error_log_table_columns.tooltip);
-	treeview->set_tooltip_column(columns_->error_log_table_columns.tooltip.index());
-
 	model_columns.add(columns_->error_log_table_columns.storage_property);
 
 	model_columns.add(columns_->error_log_table_columns.mark_name);
 
 
-	// create a TreeModel (ListStore)
+	// create a TreeModel (ListStore). Only the error number, the property and the text mark are stored,
+	// the other cells are formatted on demand (the extended error log may have thousands of entries).
 	Glib::RefPtr<Gtk::ListStore> list_store = Gtk::ListStore::create(model_columns);
 	list_store->set_sort_column(columns_->error_log_table_columns.log_entry_index, Gtk::SORT_DESCENDING);  // default sort
+	const PropertyCellFormatter format = [this](const StorageProperty& p, int column_index) {
+		return format_error_log_cell(p, column_index);
+	};
+	for (const int column_index : {columns_->error_log_table_columns.hours.index(),
+			columns_->error_log_table_columns.lba.index(), columns_->error_log_table_columns.details.index()}) {
+		app_set_property_sort_func(list_store, columns_->error_log_table_columns.storage_property, column_index, format);
+	}
 	treeview->set_model(list_store);
+	app_set_property_table_callbacks(*treeview, columns_->error_log_table_columns.storage_property);
 
 	for (int i = 0; i < int(treeview->get_n_columns()); ++i) {
 		Gtk::TreeViewColumn* tcol = treeview->get_column(i);
@@ -1635,6 +2663,7 @@ void GscInfoWindow::fill_ui_ata_error_log(const StoragePropertyRepository& prope
 
 	WarningLevel max_tab_warning = WarningLevel::None;
 	std::vector<PropertyLabel> label_strings;  // outside-of-tree properties
+	std::vector<const StorageProperty*> row_props;
 
 	bool supports_details = false;
 
@@ -1684,29 +2713,30 @@ void GscInfoWindow::fill_ui_ata_error_log(const StoragePropertyRepository& prope
 				label_strings.back().label += " "s + _("(Note: The number of entries may be limited to the newest ones)");
 
 		} else {
-			const auto& eb = p.get_value<AtaStorageErrorBlock>();
-
-			Gtk::TreeRow row = *(list_store->append());
-			row[columns_->error_log_table_columns.log_entry_index] = eb.error_num;
-			row[columns_->error_log_table_columns.hours] = Glib::Markup::escape_text(hz::number_to_string_locale(eb.lifetime_hours));
-			row[columns_->error_log_table_columns.state] = Glib::Markup::escape_text(eb.device_state);
-
-			std::string details_str = eb.type_more_info;  // parsed in JSON
-			if (details_str.empty()) {
-				details_str = AtaStorageErrorBlock::format_readable_error_types(eb.reported_types);  // parsed in Text
-			}
-
-			row[columns_->error_log_table_columns.lba] = Glib::Markup::escape_text(hz::number_to_string_locale(eb.lba));
-			row[columns_->error_log_table_columns.details] = Glib::Markup::escape_text(details_str.empty() ? "-" : details_str);
-			row[columns_->error_log_table_columns.tooltip] = p.get_description();  // markup
-			row[columns_->error_log_table_columns.storage_property] = &p;
-			row[columns_->error_log_table_columns.mark_name] = Glib::ustring::compose(_("Error %1"), eb.error_num);
+			row_props.push_back(&p);
 		}
 
 		if (int(p.warning_level) > int(max_tab_warning))
 			max_tab_warning = p.warning_level;
 	}
 
+	// Append the rows in the default (newest first) order, so that the first screenful is the
+	// one shown, and the sorted list store doesn't have to move them.
+	std::stable_sort(row_props.begin(), row_props.end(), [](const StorageProperty* a, const StorageProperty* b) {
+		return a->get_value<AtaStorageErrorBlock>().error_num > b->get_value<AtaStorageErrorBlock>().error_num;
+	});
+	// The rows point to displayed_properties_, the fill is cancelled in clear_ui_tab() before they change.
+	const std::size_t row_count = row_props.size();
+	error_log_filler_.start(list_store, row_count,
+			[this, row_props = std::move(row_props)](Gtk::TreeRow& row, std::size_t index) {
+				const StorageProperty& p = *row_props[index];
+				const auto& eb = p.get_value<AtaStorageErrorBlock>();
+				// The other columns are formatted in cell_renderer_for_error_log().
+				row[columns_->error_log_table_columns.log_entry_index] = eb.error_num;
+				row[columns_->error_log_table_columns.storage_property] = &p;
+				row[columns_->error_log_table_columns.mark_name] = Glib::ustring::compose(_("Error %1"), eb.error_num);
+			});
+
 	// JSON parser does not support details, so hide the bottom area.
 	auto* details_area = lookup_widget<Gtk::ScrolledWindow*>("error_log_details_scrolledwindow");
 	details_area->set_visible(supports_details);
@@ -1720,6 +2750,34 @@ void GscInfoWindow::fill_ui_ata_error_log(const StoragePropertyRepository& prope
 
 
 
+std::optional<Glib::ustring> GscInfoWindow::format_error_log_cell(const StorageProperty& p, int column_index) const
+{
+	const auto& columns = columns_->error_log_table_columns;
+	const auto& eb = p.get_value<AtaStorageErrorBlock>();
+
+	std::string text;
+	if (column_index == columns.hours.index()) {
+		text = hz::number_to_string_locale(eb.lifetime_hours);
+	} else if (column_index == columns.state.index()) {
+		text = eb.device_state;
+	} else if (column_index == columns.lba.index()) {
+		text = hz::number_to_string_locale(eb.lba);
+	} else if (column_index == columns.details.index()) {
+		text = eb.type_more_info;  // parsed in JSON
+		if (text.empty()) {
+			text = AtaStorageErrorBlock::format_readable_error_types(eb.reported_types);  // parsed in Text
+		}
+		if (text.empty()) {
+			text = "-";
+		}
+	} else {
+		return std::nullopt;
+	}
+	return Glib::Markup::escape_text(text);
+}
+
+
+
 void GscInfoWindow::fill_ui_nvme_error_log(const StoragePropertyRepository& property_repo)
 {
 	const auto& props = property_repo.get_properties();
@@ -1834,12 +2892,31 @@ void GscInfoWindow::fill_ui_temperature_log(const StoragePropertyRepository& pro
 	auto* label_vbox = lookup_widget<Gtk::Box*>("temperature_log_label_vbox");
 	app_set_top_labels(label_vbox, label_strings);
 
+	update_temperature_graph(property_repo);
+
 	// tab label
 	app_highlight_tab_label(lookup_widget("temperature_log_tab_label"), max_tab_warning, tab_names_.temperature);
 }
 
 
 
+void GscInfoWindow::update_temperature_graph(const StoragePropertyRepository& property_repo)
+{
+	// Graph of the SCT log and the samples recorded on each refresh (and by the hwmon monitor).
+	// When new samples arrive, they extend the old ones and the graph is updated incrementally.
+	if (temperature_graph_) {
+		std::vector<StorageHistoryPoint> samples = storage_temperature_history_get_sct_samples(property_repo);
+		if (auto history = storage_history_get_global(); history && drive_ && !drive_->get_serial_number().empty()) {
+			samples = storage_temperature_history_merge(samples, storage_temperature_history_get_stored_samples(
+					*history, drive_->get_serial_number(), 0, std::numeric_limits<std::int64_t>::max()));
+		}
+		temperature_graph_->set_samples(std::move(samples));
+		temperature_graph_->set_visible(temperature_graph_->has_samples());
+	}
+}
+
+
+
 WarningLevel GscInfoWindow::fill_ui_capabilities(const StoragePropertyRepository& property_repo)
 {
 	const auto& props = property_repo.get_properties();
@@ -2083,7 +3160,7 @@ inline void cell_renderer_set_warning_fg_bg(Gtk::CellRendererText* crt, const St
 
 
 void GscInfoWindow::cell_renderer_for_ata_attributes(Gtk::CellRenderer* cr,
-		const Gtk::TreeModel::iterator& iter, [[maybe_unused]] int column_index) const
+		const Gtk::TreeModel::iterator& iter, int column_index) const
 {
 	const StorageProperty* prop = (*iter)[columns_->ata_attribute_table_columns.storage_property];
 	if (!prop) {
@@ -2094,6 +3171,10 @@ void GscInfoWindow::cell_renderer_for_ata_attributes(Gtk::CellRenderer* cr,
 	if (auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr)) {
 		cell_renderer_set_warning_fg_bg(crt, *prop);
 
+		if (auto markup = format_ata_attribute_cell(*prop, column_index)) {
+			crt->property_markup() = *markup;
+		}
+
 		if (column_index == columns_->ata_attribute_table_columns.displayable_name.index()) {
 			crt->property_weight() = Pango::WEIGHT_BOLD;
 		}
@@ -2145,6 +3226,10 @@ void GscInfoWindow::cell_renderer_for_nvme_attributes(Gtk::CellRenderer* cr,
 	if (auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr)) {
 		cell_renderer_set_warning_fg_bg(crt, *prop);
 
+		if (auto markup = format_nvme_attribute_cell(*prop, column_index)) {
+			crt->property_markup() = *markup;
+		}
+
 		if (column_index == columns_->nvme_attribute_table_columns.displayable_name.index()) {
 			crt->property_weight() = Pango::WEIGHT_BOLD;
 		}
@@ -2159,7 +3244,7 @@ void GscInfoWindow::cell_renderer_for_nvme_attributes(Gtk::CellRenderer* cr,
 
 
 void GscInfoWindow::cell_renderer_for_statistics(Gtk::CellRenderer* cr,
-		const Gtk::TreeModel::iterator& iter, [[maybe_unused]] int column_index) const
+		const Gtk::TreeModel::iterator& iter, int column_index) const
 {
 	const StorageProperty* prop = (*iter)[this->columns_->statistics_table_columns.storage_property];
 	if (!prop) {
@@ -2170,6 +3255,10 @@ void GscInfoWindow::cell_renderer_for_statistics(Gtk::CellRenderer* cr,
 	if (auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr)) {
 		cell_renderer_set_warning_fg_bg(crt, *prop);
 
+		if (auto markup = format_statistics_cell(*prop, column_index)) {
+			crt->property_markup() = *markup;
+		}
+
 		if (statistic.is_header) {  // subheader
 			crt->property_weight() = Pango::WEIGHT_BOLD;
 		} else {  // reset to default value if reloading
@@ -2226,7 +3315,7 @@ void GscInfoWindow::cell_renderer_for_self_test_log(Gtk::CellRenderer* cr,
 
 
 void GscInfoWindow::cell_renderer_for_error_log(Gtk::CellRenderer* cr,
-		const Gtk::TreeModel::iterator& iter, [[maybe_unused]] int column_index) const
+		const Gtk::TreeModel::iterator& iter, int column_index) const
 {
 	const StorageProperty* prop = (*iter)[this->columns_->error_log_table_columns.storage_property];
 	if (!prop) {
@@ -2236,6 +3325,10 @@ void GscInfoWindow::cell_renderer_for_error_log(Gtk::CellRenderer* cr,
 	if (auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr)) {
 		cell_renderer_set_warning_fg_bg(crt, *prop);
 
+		if (auto markup = format_error_log_cell(*prop, column_index)) {
+			crt->property_markup() = *markup;
+		}
+
 		if (column_index == columns_->error_log_table_columns.log_entry_index.index()) {
 			crt->property_weight() = Pango::WEIGHT_BOLD;
 		}
@@ -2350,8 +3443,8 @@ gboolean GscInfoWindow::test_idle_callback(void* data)
 				break;
 			}
 
-			std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-			ex->create_running_dialog(self);
+			auto ex = self->create_smartctl_executor();
+			ex->set_priority(CommandPriority::SelfTestPoll);
 
 			auto test_status = self->current_test_->update(ex);
 			self->test_error_msg_ = (!test_status ? test_status.error().message() : "");
@@ -2512,13 +3605,13 @@ void GscInfoWindow::on_test_execute_button_clicked()
 	auto test = std::make_shared<SelfTest>(drive_, test_from_combo->get_test_type());
 	if (!test)
 		return;
+	test->set_selective_spans(test_from_combo->get_selective_spans());
 
 	// hide previous test results from GUI
 	if (auto* test_result_hbox = this->lookup_widget<Gtk::Box*>("test_result_hbox"))
 		test_result_hbox->hide();
 
-	std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-	ex->create_running_dialog(this);
+	auto ex = create_smartctl_executor();
 
 	auto test_status = test->start(ex);  // this runs update() too.
 	if (!test_status) {
@@ -2578,8 +3671,7 @@ void GscInfoWindow::on_test_stop_button_clicked()
 	if (!current_test_)
 		return;
 
-	std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-	ex->create_running_dialog(this);
+	auto ex = create_smartctl_executor();
 
 	auto test_status = current_test_->force_stop(ex);
 	if (!test_status) {
@@ -2596,18 +3688,20 @@ void GscInfoWindow::on_test_stop_button_clicked()
 
 
 // Callback attached to StorageDevice.
-// We don't refresh automatically (that would make it impossible to do
-// several same-drive info window comparisons side by side).
+// We don't refresh on drive changes (that would make it impossible to do
+// several same-drive info window comparisons side by side). The periodic
+// refreshes are done by GscRefreshScheduler, only if enabled in the config.
 // But we need to look for testing status change, to avoid aborting it.
-void GscInfoWindow::on_drive_changed([[maybe_unused]] StorageDevice* pdrive)
+void GscInfoWindow::on_drive_changed([[maybe_unused]] StorageDevice* pdrive, StorageDeviceChange changes)
 {
-	if (!drive_)
+	// The tabs are filled by the fetch callbacks, only the button states follow the drive here
+	if (!drive_ || !storage_device_change_has(changes, StorageDeviceChange::Activity))
 		return;
 	const bool test_active = drive_->get_test_is_active();
 
 	// disable refresh button if test is active or if it's a virtual drive
 	if (auto* refresh_info_button = lookup_widget<Gtk::Button*>("refresh_info_button"))
-		refresh_info_button->set_sensitive(!test_active && !drive_->get_is_virtual());
+		refresh_info_button->set_sensitive(!test_active && !drive_->get_is_virtual() && !drive_->get_fetch_in_progress());
 
 	// disallow close. usually modal dialogs are used for this, but we can't have
 	// per-drive modal dialogs.
@@ -2621,6 +3715,108 @@ void GscInfoWindow::on_drive_changed([[maybe_unused]] StorageDevice* pdrive)
 
 
 
+void GscInfoWindow::on_notebook_switch_page([[maybe_unused]] Gtk::Widget* page, [[maybe_unused]] guint page_number)
+{
+	fill_shown_pending_tabs();
+}
+
+
+
+void GscInfoWindow::on_drive_fetch_finished(StorageDevice* pdrive,
+		const hz::ExpectedVoid<StorageDeviceError>& fetch_status, bool clear_tests_too)
+{
+	this->set_sensitive(true);  // make sensitive again.
+
+	if (!drive_ || pdrive != drive_.get()) {  // the drive was replaced in the meantime
+		return;
+	}
+
+	if (!fetch_status) {
+		clear_ui_info(clear_tests_too);
+		gsc_executor_error_dialog_show(_("Cannot retrieve SMART data"), fetch_status.error().message(), this);
+		return;
+	}
+
+	this->update_ui_with_info(clear_tests_too);  // already fetched
+}
+
+
+
+void GscInfoWindow::on_scheduled_refresh_started(StorageDevice* pdrive)
+{
+	if (drive_ && pdrive == drive_.get()) {
+		this->set_sensitive(false);  // the drive data must not be accessed until it's fetched
+	}
+}
+
+
+
+void GscInfoWindow::on_scheduled_refresh_finished(StorageDevice* pdrive,
+		const hz::ExpectedVoid<StorageDeviceError>& fetch_status)
+{
+	if (!drive_ || pdrive != drive_.get()) {
+		return;
+	}
+	this->set_sensitive(true);
+
+	// Keep showing the old data on errors. There's no point in showing
+	// error dialogs for refreshes the user didn't ask for.
+	if (fetch_status) {
+		this->update_ui_with_info(false);  // don't clear the tests tab
+	}
+}
+
+
+
+void GscInfoWindow::update_io_performance_counters(const StoragePropertyRepository& property_repo)
+{
+	// The same counters the refresh scheduler watches, with their displayable names
+	std::vector<GscIoPerformanceView::Counter> counters;
+	for (const auto& [key, value] : StorageRefreshPolicy::get_activity_values(property_repo)) {
+		const StorageProperty* counter_prop = nullptr;
+		if (key.starts_with("ata_attr/")) {
+			for (const auto& p : property_repo.get_properties()) {
+				if (p.section == StoragePropertySection::AtaAttributes && p.is_value_type<AtaStorageAttribute>()
+						&& key == "ata_attr/" + hz::number_to_string_nolocale(p.get_value<AtaStorageAttribute>().id)) {
+					counter_prop = &p;
+					break;
+				}
+			}
+		} else if (key.starts_with("nvme/")) {
+			counter_prop = property_repo.find_property("nvme_smart_health_information_log/" + key.substr(std::string_view("nvme/").size()));
+		}
+		if (counter_prop) {
+			counters.emplace_back(counter_prop->displayable_name, hz::number_to_string_locale(value));
+		}
+	}
+	io_performance_view_->set_counters(counters);
+}
+
+
+
+void GscInfoWindow::on_io_performance_sampled()
+{
+	if (!drive_ || !io_performance_view_ || !io_performance_user_) {
+		return;
+	}
+	if (auto io_performance_monitor = storage_io_performance_get_global()) {
+		io_performance_view_->set_performance(io_performance_monitor->get_performance(*drive_));
+	}
+}
+
+
+
+void GscInfoWindow::on_drive_temperature_sampled(StorageDevice* pdrive)
+{
+	if (!drive_ || pdrive != drive_.get()) {
+		return;
+	}
+	// The snapshot is consistent even if the drive is being refreshed
+	update_temperature_graph(drive_->get_snapshot()->property_repository);
+}
+
+
+
 bool GscInfoWindow::on_treeview_button_press_event(GdkEventButton* button_event, Gtk::Menu* menu, Gtk::TreeView* treeview)
 {
 	if (button_event->type == GDK_BUTTON_PRESS && button_event->button == 3) {
@@ -2649,21 +3845,19 @@ void GscInfoWindow::on_treeview_menu_copy_clicked(Gtk::TreeView* treeview)
 	}
 	text += hz::string_join(col_texts, ',') + "\n";
 
+	// Most of the cells are formatted on demand, so take the texts from the cell renderers,
+	// not the model. This also gathers data only from tree columns, not model columns (like helper data).
+	Glib::RefPtr<Gtk::TreeModel> model = treeview->get_model();
 	auto selection = treeview->get_selection()->get_selected_rows();
-	auto list_store = Glib::RefPtr<Gtk::ListStore>::cast_dynamic(treeview->get_model());
 	for (const auto& path : selection) {
 		std::vector<std::string> cell_texts;
-		Gtk::TreeRow row = *(list_store->get_iter(path));
-
-		for (int j = 0; j < num_cols; ++j) {  // gather data only from tree columns, not model columns (like tooltips and helper data)
-			const GType type = list_store->get_column_type(j);
-			if (type == G_TYPE_INT) {
-				int32_t value = 0;
-				row.get_value(j, value);
-				cell_texts.push_back(hz::number_to_string_nolocale(value));  // no locale for export
-			} else if (type == G_TYPE_STRING) {
-				std::string value;
-				row.get_value(j, value);
+		const Gtk::TreeModel::iterator iter = model->get_iter(path);
+
+		for (int j = 0; j < num_cols; ++j) {
+			Gtk::TreeViewColumn* tcol = treeview->get_column(j);
+			tcol->cell_set_cell_data(model, iter, false, false);
+			if (auto* crt = dynamic_cast<Gtk::CellRendererText*>(tcol->get_first_cell())) {
+				const std::string value = crt->property_text().get_value();  // plain text, even if markup was set
 				cell_texts.push_back("\"" + hz::string_replace_copy(value, "\"", "\"\"") + "\"");
 			}
 		}
@@ -2680,5 +3874,4 @@ void GscInfoWindow::on_treeview_menu_copy_clicked(Gtk::TreeView* treeview)
 
 
 
-
 /// @}
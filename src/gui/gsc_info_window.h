@@ -13,16 +13,33 @@ Copyright:
 #define GSC_INFO_WINDOW_H
 
 #include <gtkmm.h>
+#include <array>
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "applib/app_builder_widget.h"
+#include "applib/app_list_store_filler.h"
+#include "applib/command_executor_factory.h"
 #include "applib/storage_device.h"
 #include "applib/selftest.h"
 
 
+class GscRefreshScheduler;  // defined in gsc_refresh_scheduler.h
+class GscTemperatureGraph;  // defined in gsc_temperature_graph.h
+class GscIoPerformanceView;  // defined in gsc_io_performance_view.h
 
-/// Columns of treeviews inside GscInfoWindow
+
+
+/// Columns of treeviews inside GscInfoWindow.
+/// The ATA / NVMe attributes, statistics and error log tables only store the properties
+/// (and the sort keys) in their models, the text columns are formatted on demand by the cell renderer functions.
 struct GscInfoWindowColumns {
 
 	/// ATA Attributes table model columns
@@ -37,7 +54,6 @@ struct GscInfoWindowColumns {
 		Gtk::TreeModelColumn<Glib::ustring> type;
 		// Gtk::TreeModelColumn<Glib::ustring> updated;
 		Gtk::TreeModelColumn<std::string> flag_value;
-		Gtk::TreeModelColumn<Glib::ustring> tooltip;
 		Gtk::TreeModelColumn<const StorageProperty*> storage_property;
 	} ata_attribute_table_columns;
 
@@ -45,7 +61,6 @@ struct GscInfoWindowColumns {
 	struct {
 		Gtk::TreeModelColumn<Glib::ustring> displayable_name;
 		Gtk::TreeModelColumn<std::string> value;
-		Gtk::TreeModelColumn<Glib::ustring> tooltip;
 		Gtk::TreeModelColumn<const StorageProperty*> storage_property;
 	} nvme_attribute_table_columns;
 
@@ -55,7 +70,6 @@ struct GscInfoWindowColumns {
 		Gtk::TreeModelColumn<std::string> value;
 		Gtk::TreeModelColumn<std::string> flags;
 		Gtk::TreeModelColumn<std::string> page_offset;
-		Gtk::TreeModelColumn<Glib::ustring> tooltip;
 		Gtk::TreeModelColumn<const StorageProperty*> storage_property;
 	} statistics_table_columns;
 
@@ -78,7 +92,6 @@ struct GscInfoWindowColumns {
 		Gtk::TreeModelColumn<std::string> state;
 		Gtk::TreeModelColumn<std::string> lba;
 		Gtk::TreeModelColumn<std::string> details;
-		Gtk::TreeModelColumn<Glib::ustring> tooltip;
 		Gtk::TreeModelColumn<const StorageProperty*> storage_property;
 		Gtk::TreeModelColumn<Glib::ustring> mark_name;
 	} error_log_table_columns;
@@ -99,6 +112,16 @@ struct GscInfoWindowColumns {
 
 
 
+/// Time spent filling a tab of GscInfoWindow (in all windows), see GscInfoWindow::get_tab_fill_stats()
+struct GscInfoWindowTabFillStats {
+	std::string tab;  ///< Notebook page widget name of the tab
+	std::uint64_t fills = 0;  ///< Number of times the tab was filled
+	std::chrono::microseconds total_time{0};  ///< Total time spent filling it
+	std::chrono::microseconds max_time{0};  ///< Longest fill
+};
+
+
+
 /// The "Drive Information" window.
 /// Use create() / destroy() with this class instead of new / delete!
 class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
@@ -115,15 +138,34 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 		~GscInfoWindow() override;
 
 
+		/// Get a window for showing a drive: a closed one from the pool (see release_to_pool()),
+		/// or a newly created one. Call set_drive() on it as usual.
+		static std::shared_ptr<GscInfoWindow> acquire();
+
+
+		/// Build a window in advance and put it into the pool, unless the pool is full.
+		/// This way even the first acquire() doesn't have to build the widget tree.
+		static void prebuild_pooled();
+
+
 		/// Set the drive to show
 		void set_drive(StorageDevicePtr d);
 
+		/// Set the scheduler which refreshes the drive periodically (if enabled in settings).
+		/// Call this after set_drive().
+		void set_refresh_scheduler(std::shared_ptr<GscRefreshScheduler> scheduler);
+
 		/// Fill the dialog with info from the drive
 		void fill_ui_with_info(bool scan = true, bool clear_ui = true, bool clear_tests = true);
 
 		/// Clear all info in UI
 		void clear_ui_info(bool clear_tests_too = true);
 
+		/// Update the UI after the drive data was fetched again. Only the tabs whose
+		/// properties changed are updated; the rows of the ATA attributes, NVMe attributes
+		/// and statistics tables are updated in place if the set of rows is the same.
+		void update_ui_with_info(bool clear_tests = true);
+
 		/// Refresh the drive information in UI
 		void refresh_info(bool clear_tests_too = true);
 
@@ -132,19 +174,139 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 		void show_tests();
 
 
+		/// Fill the tabs which are filled lazily and weren't shown yet. Used by the GUI benchmark.
+		void fill_pending_tabs();
+
+
+		/// Get the tab fill statistics since program start (or reset_tab_fill_stats()), one entry per tab
+		[[nodiscard]] static std::vector<GscInfoWindowTabFillStats> get_tab_fill_stats();
+
+
+		/// Reset the tab fill statistics
+		static void reset_tab_fill_stats();
+
+
+		/// Get the approximate memory usage of the info windows showing \c drive:
+		/// their copies of the properties and their table rows.
+		[[nodiscard]] static std::size_t get_drive_ui_memory_usage(const StorageDevice* drive);
+
+
+		/// Check whether an info window shows \c drive
+		[[nodiscard]] static bool get_drive_shown(const StorageDevice* drive);
+
+
 	protected:
 
+		/// Hide the window, detach it from its drive and keep it for reuse by acquire(),
+		/// so that it doesn't have to be built again. \return false if the pool is full.
+		bool release_to_pool();
+
+
+		/// Detach from the drive, clearing the UI
+		void unbind_drive();
+
+
+		/// Store the window size for the next windows. We don't store position to avoid overlaps.
+		void store_window_size();
+
+
+		/// Tabs (and Advanced sub-tabs) of the window. Each one shows its own subset of the properties.
+		enum class InfoTab {
+			General,
+			AtaAttributes,
+			NvmeAttributes,
+			Statistics,
+			SelfTestLog,
+			AtaErrorLog,
+			NvmeErrorLog,
+			TemperatureLog,
+			Capabilities,
+			ErcLog,
+			SelectiveSelfTestLog,
+			PhyLog,
+			DirectoryLog,
+		};
+
+		/// Number of InfoTab values
+		static constexpr std::size_t info_tab_count = static_cast<std::size_t>(InfoTab::DirectoryLog) + 1;
+
+		/// Split the properties into per-tab lists
+		[[nodiscard]] static std::array<StoragePropertyRepository, info_tab_count> split_properties_by_tab(
+				const StoragePropertyRepository& property_repo);
+
+		/// Fill a tab with the properties in displayed_properties_. If \c displayed_repo is not null,
+		/// the table rows (which show it) are updated in place (supported by the tables
+		/// of ATA attributes, NVMe attributes and statistics only).
+		void fill_ui_tab(InfoTab tab, const StoragePropertyRepository* displayed_repo);
+
+		/// Clear a tab in UI
+		void clear_ui_tab(InfoTab tab);
+
+		/// Clear the test controls in UI
+		void clear_ui_self_test_info();
+
+		/// Show or hide the tabs depending on whether their properties are present
+		void update_tab_visibility();
+
+		/// Highlight the Advanced tab label according to its sub-tabs
+		void update_advanced_tab_label();
+
+		/// Whether a tab is filled only when it's shown for the first time
+		[[nodiscard]] static bool get_tab_is_lazy(InfoTab tab);
+
+		/// Check whether a tab is the current one (for Advanced sub-tabs, when the Advanced tab is current too)
+		[[nodiscard]] bool get_tab_is_shown(InfoTab tab);
+
+		/// Mark a tab as not filled, highlighting its header according to get_tab_warning_summary()
+		void set_tab_pending(InfoTab tab);
+
+		/// Fill the pending tabs which are shown now
+		void fill_shown_pending_tabs();
+
+		/// Get the tab fill statistics storage, indexed by InfoTab
+		[[nodiscard]] static std::array<GscInfoWindowTabFillStats, info_tab_count>& get_tab_fill_stats_storage();
+
+		/// Get the highest warning of the displayed properties of a tab, without filling it
+		[[nodiscard]] WarningLevel get_tab_warning_summary(InfoTab tab) const;
+
+		/// Get the name of the notebook page widget of a tab
+		[[nodiscard]] static std::string get_tab_page_widget_name(InfoTab tab);
+
+		/// Get the label widget name and the original label text of a tab
+		[[nodiscard]] std::pair<std::string, Glib::ustring> get_tab_label(InfoTab tab) const;
+
 		/// fill_ui_with_info() helper
 		void fill_ui_general(const StoragePropertyRepository& property_repo);
 
-		/// fill_ui_with_info() helper
-		void fill_ui_ata_attributes(const StoragePropertyRepository& property_repo);
+		/// fill_ui_with_info() helper. If \c displayed_repo is not null, the rows are updated in place.
+		void fill_ui_ata_attributes(const StoragePropertyRepository& property_repo,
+				const StoragePropertyRepository* displayed_repo = nullptr);
 
-		/// fill_ui_with_info() helper
-		void fill_ui_nvme_attributes(const StoragePropertyRepository& property_repo);
+		/// fill_ui_ata_attributes() helper
+		void set_ata_attribute_row(Gtk::TreeRow& row, const StorageProperty& p);
 
-		/// fill_ui_with_info() helper
-		void fill_ui_statistics(const StoragePropertyRepository& property_repo);
+		/// Format a cell of the ATA attributes table (escaped markup). Returns std::nullopt for the model-stored columns.
+		[[nodiscard]] std::optional<Glib::ustring> format_ata_attribute_cell(const StorageProperty& p, int column_index) const;
+
+		/// fill_ui_with_info() helper. If \c displayed_repo is not null, the rows are updated in place.
+		void fill_ui_nvme_attributes(const StoragePropertyRepository& property_repo,
+				const StoragePropertyRepository* displayed_repo = nullptr);
+
+		/// fill_ui_nvme_attributes() helper
+		void set_nvme_attribute_row(Gtk::TreeRow& row, const StorageProperty& p);
+
+		/// Format a cell of the NVMe attributes table (escaped markup). Returns std::nullopt for the model-stored columns.
+		[[nodiscard]] std::optional<Glib::ustring> format_nvme_attribute_cell(const StorageProperty& p, int column_index) const;
+
+		/// fill_ui_with_info() helper. If \c displayed_repo is not null, the rows are updated in place.
+		void fill_ui_statistics(const StoragePropertyRepository& property_repo,
+				const StoragePropertyRepository* displayed_repo = nullptr);
+
+		/// fill_ui_statistics() helper
+		void set_statistics_row(Gtk::TreeRow& row, const StorageProperty& p);
+
+		/// Format a cell of the statistics table (escaped markup). Returns std::nullopt for the model-stored columns.
+		[[nodiscard]] std::optional<Glib::ustring> format_statistics_cell(const StorageProperty& p, int column_index) const;
 
 		/// fill_ui_with_info() helper
 		void fill_ui_self_test_info();
@@ -155,12 +317,21 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 		/// fill_ui_with_info() helper
 		void fill_ui_ata_error_log(const StoragePropertyRepository& property_repo);
 
+		/// Format a cell of the ATA error log table (escaped markup). Returns std::nullopt for the model-stored columns.
+		[[nodiscard]] std::optional<Glib::ustring> format_error_log_cell(const StorageProperty& p, int column_index) const;
+
 		/// fill_ui_with_info() helper
 		void fill_ui_nvme_error_log(const StoragePropertyRepository& property_repo);
 
 		/// fill_ui_with_info() helper
 		void fill_ui_temperature_log(const StoragePropertyRepository& property_repo);
 
+		/// Set the temperature graph samples (the SCT log and the history store)
+		void update_temperature_graph(const StoragePropertyRepository& property_repo);
+
+		/// Set the SMART error counters of the Performance tab
+		void update_io_performance_counters(const StoragePropertyRepository& property_repo);
+
 		/// fill_ui_with_info() helper
 		WarningLevel fill_ui_capabilities(const StoragePropertyRepository& property_repo);
 
@@ -226,6 +397,14 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 		/// Button click callback
 		void on_view_output_button_clicked();
 
+		/// Get the text output of the drive, fetching it if needed (see StorageDevice::get_text_output()).
+		/// Returns nothing (after reporting the error, if any) if it's not available.
+		[[nodiscard]] std::optional<std::string> get_drive_text_output();
+
+		/// Get a smartctl executor (with a "running" dialog over this window) from the pooled
+		/// executor factory of the window, so that the executors and their buffers are reused.
+		[[nodiscard]] std::shared_ptr<CommandExecutor> create_smartctl_executor();
+
 		/// Button click callback
 		void on_save_info_button_clicked();
 
@@ -243,8 +422,27 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 		void on_test_stop_button_clicked();
 
 
-		/// Callback attached to StorageDevice change signal.
-		void on_drive_changed(StorageDevice* pdrive);
+		/// Callback attached to StorageDevice coalesced change signal.
+		void on_drive_changed(StorageDevice* pdrive, StorageDeviceChange changes);
+
+		/// Callback
+		void on_notebook_switch_page(Gtk::Widget* page, guint page_number);
+
+		/// Called when the asynchronous fetch started by refresh_info() is finished
+		void on_drive_fetch_finished(StorageDevice* pdrive,
+				const hz::ExpectedVoid<StorageDeviceError>& fetch_status, bool clear_tests_too);
+
+		/// Called when the refresh scheduler starts fetching a drive
+		void on_scheduled_refresh_started(StorageDevice* pdrive);
+
+		/// Called when the refresh scheduler finishes fetching a drive
+		void on_scheduled_refresh_finished(StorageDevice* pdrive, const hz::ExpectedVoid<StorageDeviceError>& fetch_status);
+
+		/// Called when a new hwmon temperature sample of a drive is recorded, updates the graph
+		void on_drive_temperature_sampled(StorageDevice* pdrive);
+
+		/// Called when /proc/diskstats is sampled, updates the Performance tab
+		void on_io_performance_sampled();
 
 		/// Callback
 		bool on_treeview_button_press_event(GdkEventButton* button_event, Gtk::Menu* menu, Gtk::TreeView* treeview);
@@ -261,7 +459,7 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 
 		sigc::connection test_type_combo_changed_conn_;  ///< Callback connection
 
-		sigc::connection drive_changed_connection_;  // Callback connection of drive's signal_changed callback
+		sigc::connection drive_changed_connection_;  // Callback connection of drive's signal_changed_coalesced callback
 
 
 		// ---------- Data members
@@ -289,8 +487,15 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 
 		Gtk::Label* device_name_label_ = nullptr;  ///< Top label
 
+		GscTemperatureGraph* temperature_graph_ = nullptr;  ///< Temperature history graph of the Temperature tab
+
+		GscIoPerformanceView* io_performance_view_ = nullptr;  ///< Performance tab page, nullptr if not supported
+		bool io_performance_user_ = false;  ///< Whether we're a user of the I/O performance monitor (the drive is local)
+
 		StorageDevicePtr drive_;  ///< The drive we're showing
 
+		std::shared_ptr<GscRefreshScheduler> refresh_scheduler_;  ///< Periodic refreshes, may be nullptr
+
 		std::shared_ptr<SelfTest> current_test_;  ///< Currently running test, or 0.
 
 		// Test idle callback temporaries
@@ -312,6 +517,24 @@ class GscInfoWindow : public AppBuilderWidget<GscInfoWindow, true> {
 		std::unique_ptr<GscInfoWindowColumns> columns_;
 
 		int book_selftest_page_no_ = -1;  ///< The page number of the self-test log in the notebook
+
+		/// Displayed properties of each tab. The table rows point to them.
+		std::array<StoragePropertyRepository, info_tab_count> displayed_properties_;
+
+		bool displayed_properties_valid_ = false;  ///< Whether displayed_properties_ corresponds to the UI
+
+		/// Warning levels of the Advanced sub-tabs (Capabilities to DirectoryLog)
+		std::array<WarningLevel, 5> advanced_tab_warnings_ = {};
+
+		/// Whether each tab is filled. The lazy tabs are filled when they are shown.
+		std::array<bool, info_tab_count> tab_filled_ = {};
+
+		bool filling_ui_ = false;  ///< Set while filling / updating the UI, to avoid filling the pending tabs
+
+		AppListStoreFiller error_log_filler_;  ///< Appends the error log rows in idle time
+		AppListStoreFiller statistics_filler_;  ///< Appends the statistics rows in idle time
+
+		CommandExecutorFactoryPtr ex_factory_;  ///< See create_smartctl_executor()
 };
 
 
@@ -15,6 +15,8 @@
 #include <gtkmm.h>
 #include <glib.h>  // g_, G*
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 // #include <locale.h>  // _configthreadlocale (win32)
 #include <stdexcept>  // std::runtime_error
@@ -24,12 +26,15 @@
 #include <memory>
 #include <cmath>
 #include <iostream>
+#include <utility>
 
 
 
 #ifdef _WIN32
 	#include <windows.h>
 	#include <versionhelpers.h>
+#else
+	#include <unistd.h>  // geteuid()
 #endif
 
 #include "libdebug/libdebug.h"  // include full libdebug here (to add domains, etc.)
@@ -47,8 +52,20 @@
 
 #include "applib/window_instance_manager.h"
 #include "applib/gsc_settings.h"
+#include "applib/app_main_loop_watchdog.h"
+#include "applib/app_regex.h"
+#include "applib/app_trace.h"
+#include "applib/command_executor.h"
+#include "applib/smartctl_executor.h"  // get_smartctl_binary()
+#include "applib/smartctl_version_probe.h"
+#include "applib/storage_history.h"
+#include "applib/storage_history_sink.h"
+#include "applib/storage_privileged_helper.h"
+#include "applib/storage_property_warning_rules.h"
+#include "applib/worker_threads.h"
 #include "gsc_main_window.h"
 #include "gsc_executor_log_window.h"
+#include "gsc_privileged_helper.h"
 #include "gsc_init.h"
 #include "gsc_startup_settings.h"
 
@@ -159,6 +176,42 @@ namespace {
 	}
 */
 
+
+
+	/// Measures the startup phases, for the startup timing report
+	class AppStartupTimer {
+		public:
+
+			/// Finish the current phase and start the next one
+			void finish_phase(const char* name)
+			{
+				const auto now = std::chrono::steady_clock::now();
+				phases_.emplace_back(name, std::chrono::duration_cast<std::chrono::microseconds>(now - phase_start_));
+				phase_start_ = now;
+			}
+
+
+			/// Output the durations of the finished phases
+			void report() const
+			{
+				std::ostringstream ss;
+				std::chrono::microseconds total {0};
+				for (const auto& [name, duration] : phases_) {
+					ss << "\t" << name << ": " << duration.count() << " usec\n";
+					total += duration;
+				}
+				debug_out_info("app", "Startup timing, " << total.count() << " usec total:\n" << ss.str());
+			}
+
+
+		private:
+
+			std::chrono::steady_clock::time_point phase_start_ = std::chrono::steady_clock::now();  ///< Start of the current phase
+			std::vector<std::pair<const char*, std::chrono::microseconds>> phases_;  ///< Finished phases
+
+	};
+
+
 }  // anon. ns
 
 
@@ -208,8 +261,12 @@ namespace {
 		gboolean arg_scan = TRUE;  ///< if false, don't scan the system for drives on startup
 		gchar** arg_add_virtual = nullptr;  ///< load smartctl data from these files as virtual drives
 		gchar** arg_add_device = nullptr;  ///< add these device files manually
+		gchar* arg_inventory = nullptr;  ///< query the drives listed in this inventory file instead of scanning
 		double arg_gdk_scale = std::numeric_limits<double>::quiet_NaN();  ///< The value of GDK_SCALE environment variable
 		double arg_gdk_dpi_scale = std::numeric_limits<double>::quiet_NaN();  ///< The value of GDK_DPI_SCALE environment variable
+		gchar* arg_trace_file = nullptr;  ///< write Chrome trace JSON of detection, execution and parsing to this file on exit
+		gint arg_benchmark_drives = 0;  ///< run the GUI benchmark with this many synthetic virtual drives
+		gint arg_benchmark_info_windows = 10;  ///< number of info windows opened by the GUI benchmark
 	};
 
 
@@ -230,6 +287,17 @@ namespace {
 					N_("Add this device to device list. The format of the device is \"<device>::<type>::<extra_args>\", where type and extra_args are optional."
 					" This option is useful with --no-scan to list certain drives only. You can specify this option multiple times."
 					" Example: --add-device /dev/sda --add-device /dev/twa0::3ware,2 --add-device '/dev/sdb::::-T permissive'"), nullptr },
+			{ "inventory", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_inventory),
+					N_("Query the drives listed in this inventory file on startup instead of scanning for them"
+					" (see \"system/inventory_file\" config key)"), nullptr },
+			{ "trace-file", '\0', 0, G_OPTION_ARG_FILENAME, &(args.arg_trace_file),
+					N_("Trace drive detection, command execution and parsing, and write the trace to this file"
+					" (in Chrome trace format) on exit"), nullptr },
+			{ "benchmark-drives", '\0', 0, G_OPTION_ARG_INT, &(args.arg_benchmark_drives),
+					N_("Run the GUI benchmark: load this many synthetic virtual drives (copies of the --add-virtual files),"
+					" open info windows for some of them, print the timings and exit. Use with --no-scan."), nullptr },
+			{ "benchmark-info-windows", '\0', 0, G_OPTION_ARG_INT, &(args.arg_benchmark_info_windows),
+					N_("Number of info windows opened by the GUI benchmark (default 10)"), nullptr },
 #ifndef _WIN32
 			// X11-specific
 			{ "gdk-scale", 'l', 0, G_OPTION_ARG_DOUBLE, &(args.arg_gdk_scale),
@@ -297,6 +365,8 @@ namespace {
 
 bool app_init_and_loop(int& argc, char**& argv)
 {
+	AppStartupTimer startup_timer;
+
 	if constexpr(BuildEnv::is_kernel_family_windows()) {
 		std::string csd_value;
 		if (!hz::env_get_value("GTK_CSD", csd_value)) {  // if not set
@@ -372,6 +442,13 @@ bool app_init_and_loop(int& argc, char**& argv)
 	}
 	const std::string load_devices_str = hz::string_join(load_devices, "; ");  // for display purposes only
 
+	const std::string inventory_file = (args.arg_inventory ? args.arg_inventory : "");
+
+	const std::string trace_file = (args.arg_trace_file ? args.arg_trace_file : "");
+	if (!trace_file.empty()) {
+		app_trace_set_enabled(true);
+	}
+
 
 	// it's here because earlier there are no domains
 	debug_out_dump("app", "Application options:\n"
@@ -381,7 +458,11 @@ bool app_init_and_loop(int& argc, char**& argv)
 		<< "\targ_add_virtual: " << (load_virtuals_str.empty() ? "[empty]" : load_virtuals_str) << "\n"
 		<< "\targ_add_device: " << (load_devices_str.empty() ? "[empty]" : load_devices_str) << "\n"
 		<< "\targ_gdk_scale: " << args.arg_gdk_scale << "\n"
-		<< "\targ_gdk_dpi_scale: " << args.arg_gdk_dpi_scale << "\n");
+		<< "\targ_gdk_dpi_scale: " << args.arg_gdk_dpi_scale << "\n"
+		<< "\targ_inventory: " << (inventory_file.empty() ? "[empty]" : inventory_file) << "\n"
+		<< "\targ_trace_file: " << (trace_file.empty() ? "[empty]" : trace_file) << "\n"
+		<< "\targ_benchmark_drives: " << args.arg_benchmark_drives << "\n"
+		<< "\targ_benchmark_info_windows: " << args.arg_benchmark_info_windows << "\n");
 
 	debug_out_dump("app", "LibDebug options:\n" << debug_get_cmd_args_dump());
 
@@ -395,9 +476,56 @@ bool app_init_and_loop(int& argc, char**& argv)
 	}
 
 
+	startup_timer.finish_phase("command line");
+
 	// Load config files
 	app_init_config();
 
+	app_set_worker_thread_count(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/worker_threads"))));
+	cmdex_set_max_running_commands(static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/max_running_commands"))));
+	cmdex_set_domain_limits(cmdex_get_domain_limits());
+	cmdex_set_priority_aging(std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/command_priority_aging_sec"))));
+
+	storage_warning_rules_init_global(hz::fs_path_from_string(rconfig::get_data<std::string>("system/warning_rules_file")));
+
+	if (rconfig::get_data<bool>("system/smart_history_enabled")) {
+		auto history = std::make_shared<StorageHistory>(StorageHistory::get_default_file());
+		if (auto ec = history->open()) {
+			debug_out_warn("app", "Cannot open SMART history file, history is disabled: " << ec.message() << "\n");
+		} else {
+			storage_history_set_global(history);
+		}
+	}
+
+	// Replicate the history to a central collector
+	std::unique_ptr<StorageHistorySink> history_sink;
+	if (auto history = storage_history_get_global(); history && !rconfig::get_data<std::string>("system/history_sink_url").empty()) {
+		history_sink = std::make_unique<StorageHistorySink>(history, StorageHistorySinkSettings::get_from_config());
+		if (auto status = history_sink->open(); !status) {
+			debug_out_warn("app", "Cannot open the history spool, history upload is disabled: " << status.error().message() << "\n");
+			history_sink.reset();
+		} else {
+			history_sink->start(std::chrono::seconds(60));
+		}
+	}
+
+#ifndef _WIN32
+	// Let the root-owned agent open the drives, so that the GUI doesn't need root.
+	if (geteuid() != 0 && rconfig::get_data<bool>("system/use_privileged_helper")) {
+		const GBusType bus_type = (rconfig::get_data<std::string>("system/agent_dbus_bus") == "session")
+				? G_BUS_TYPE_SESSION : G_BUS_TYPE_SYSTEM;
+		storage_privileged_helper_set_global(std::make_shared<GscPrivilegedHelper>(bus_type));
+	}
+#endif
+
+	startup_timer.finish_phase("configuration");
+
+	// Running smartctl may take a while, so find out its version in the background while
+	// GTK initializes and the main window is built. The main window waits for it before scanning.
+	smartctl_version_probe_start(get_smartctl_binary());
+
+	startup_timer.finish_phase("smartctl version probe start");
+
 
 	// Redirect all GTK+/Glib and related messages to libdebug.
 	// Do this before GTK+ init, to capture its possible warnings as well.
@@ -430,6 +558,8 @@ bool app_init_and_loop(int& argc, char**& argv)
 	// Restore the locale
 	hz::locale_cpp_set(final_loc_cpp);
 
+	startup_timer.finish_phase("GTK initialization");
+
 
 	debug_out_info("app", "Current C locale: " << hz::locale_c_get() << "\n");
 	debug_out_info("app", "Current C++ locale: " << hz::locale_cpp_get<std::string>() << "\n");
@@ -557,11 +687,19 @@ bool app_init_and_loop(int& argc, char**& argv)
 	// add devices to the list on startup if specified.
 	get_startup_settings().add_devices = load_devices;
 
+	// query the inventory drives instead of scanning, if specified.
+	get_startup_settings().inventory_file = inventory_file;
 
-	// Create executor log window, but don't show it.
-	// It will track all command executor outputs.
-	// The window is destroyed by the instance manager.
-	GscExecutorLogWindow::create();
+	// GUI benchmark mode
+	get_startup_settings().benchmark_drives = args.arg_benchmark_drives;
+	get_startup_settings().benchmark_info_windows = args.arg_benchmark_info_windows;
+
+
+	startup_timer.finish_phase("data paths and theme");
+
+	// Track all command executor outputs. The log window is created when it's
+	// first shown, since parsing its UI here would only delay the startup.
+	GscExecutorLog::get().start();
 
 
 	// Open the main window.
@@ -573,18 +711,68 @@ bool app_init_and_loop(int& argc, char**& argv)
 			return false;  // cannot create main window
 		}
 
+		// The main window constructor starts the initial scan
+		startup_timer.finish_phase("main window, up to the initial scan");
+		Glib::signal_idle().connect_once([&startup_timer]() {
+			startup_timer.finish_phase("main window shown, up to the first idle main loop iteration");
+			startup_timer.report();
+		});
+
 		// first-boot message
 		// app_show_first_boot_message(win);
 
+		// Watch the main loop for UI-blocking paths
+		auto stall_threshold = rconfig::get_data<int>("gui/main_loop_stall_threshold_msec");
+		if (stall_threshold <= 0 && !trace_file.empty()) {
+			stall_threshold = 50;
+		}
+		if (stall_threshold > 0) {
+			auto watchdog = std::make_shared<AppMainLoopWatchdog>();
+			watchdog->start(std::chrono::milliseconds(stall_threshold));
+			app_main_loop_watchdog_set_global(watchdog);
+		}
+
 		// The Main Loop
 		debug_out_info("app", "Entering main loop.\n");
 		Gtk::Main::run();
 		debug_out_info("app", "Main loop exited.\n");
+
+		if (auto watchdog = app_main_loop_watchdog_get_global()) {
+			watchdog->stop();
+			debug_out_info("app", watchdog->format_stalls());
+			app_main_loop_watchdog_set_global(nullptr);
+		}
+	}
+
+	{
+		const auto regex_stats = app_regex_get_cache_stats();
+		debug_out_info("app", "Regex cache: " << regex_stats.size << " patterns, " << regex_stats.hits << " hits, "
+				<< regex_stats.misses << " misses, " << regex_stats.compile_time.count() << " usec spent compiling.\n");
+	}
+
+	{
+		const auto queue_stats = cmdex_get_queue_stats();
+		debug_out_info("app", "Command queue: " << queue_stats.waits << " waits (max depth " << queue_stats.max_queued
+				<< "), " << queue_stats.total_wait_time.count() << " usec total, " << queue_stats.max_wait_time.count() << " usec max, "
+				<< queue_stats.collapsed << " collapsed.\n");
 	}
 
 	// Destroy all windows manually, to avoid surprises
 	WindowInstanceManagerStorage::destroy_all_instances();
 
+	if (!trace_file.empty()) {
+		if (auto ec = app_trace_write_chrome_json(hz::fs_path_from_string(trace_file))) {
+			debug_out_warn("app", "Cannot write the trace file \"" << trace_file << "\": " << ec.message() << "\n");
+		}
+		app_trace_set_enabled(false);
+	}
+
+	if (history_sink) {
+		history_sink->stop();  // spools the samples read so far
+	}
+	storage_history_set_global(nullptr);
+	storage_privileged_helper_set_global(nullptr);
+
 	// std::cerr << app_get_debug_buffer_str();  // this will output everything that went through libdebug.
 
 	return true;
@@ -0,0 +1,143 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <gtkmm.h>
+#include <cmath>  // std::lround
+
+#include "hz/format_unit.h"  // format_size
+#include "hz/string_num.h"  // number_to_string_locale
+
+#include "gsc_io_performance_view.h"
+
+
+
+namespace {
+
+	/// Format the operations per second and the throughput of one direction
+	Glib::ustring io_performance_format_rate(double iops, double bytes_per_sec)
+	{
+		/// Translators: %1 is the number of I/O operations per second, %2 is a size (e.g. 1.5 MiB).
+		return Glib::ustring::compose(_("%1 IOPS, %2/s"),
+				hz::number_to_string_locale(std::lround(iops)),
+				hz::format_size(static_cast<std::uint64_t>(std::llround(bytes_per_sec))));
+	}
+
+
+	/// Create a bold section header label
+	Gtk::Label* io_performance_create_header(const Glib::ustring& text)
+	{
+		auto* label = Gtk::manage(new Gtk::Label());
+		label->set_markup("<b>" + Glib::Markup::escape_text(text) + "</b>");
+		label->set_halign(Gtk::ALIGN_START);
+		return label;
+	}
+
+
+	/// Create a grid for the "name: value" rows
+	Gtk::Grid* io_performance_create_grid()
+	{
+		auto* grid = Gtk::manage(new Gtk::Grid());
+		grid->set_row_spacing(4);
+		grid->set_column_spacing(12);
+		grid->set_margin_start(12);
+		return grid;
+	}
+
+}
+
+
+
+GscIoPerformanceView::GscIoPerformanceView()
+		: Gtk::Box(Gtk::ORIENTATION_VERTICAL, 6)
+{
+	set_border_width(12);
+
+	pack_start(*io_performance_create_header(_("Current I/O performance")), false, false);
+	auto* grid = io_performance_create_grid();
+	reads_label_ = add_row(*grid, 0, _("Reads:"));
+	writes_label_ = add_row(*grid, 1, _("Writes:"));
+	service_time_label_ = add_row(*grid, 2, _("Average service time:"));
+	queue_depth_label_ = add_row(*grid, 3, _("Average queue depth:"));
+	utilization_label_ = add_row(*grid, 4, _("Utilization:"));
+	pack_start(*grid, false, false);
+
+	auto* counters_header = io_performance_create_header(_("SMART error counters (as of the last refresh)"));
+	counters_header->set_margin_top(12);
+	pack_start(*counters_header, false, false);
+	counters_grid_ = io_performance_create_grid();
+	pack_start(*counters_grid_, false, false);
+
+	set_performance(std::nullopt);
+	set_counters({});
+	show_all();
+}
+
+
+
+void GscIoPerformanceView::set_performance(const std::optional<StorageIoPerformance>& performance)
+{
+	if (!performance) {
+		const Glib::ustring none = _("No data available");
+		for (auto* label : {reads_label_, writes_label_, service_time_label_, queue_depth_label_, utilization_label_}) {
+			label->set_text(none);
+		}
+		return;
+	}
+	reads_label_->set_text(io_performance_format_rate(performance->read_iops, performance->read_bytes_per_sec));
+	writes_label_->set_text(io_performance_format_rate(performance->write_iops, performance->write_bytes_per_sec));
+	service_time_label_->set_text(performance->service_time_msec.has_value()
+			? Glib::ustring::compose(_("%1 ms"), hz::number_to_string_locale(performance->service_time_msec.value(), 2, true))
+			: Glib::ustring("-"));
+	queue_depth_label_->set_text(hz::number_to_string_locale(performance->queue_depth, 2, true));
+	utilization_label_->set_text(hz::number_to_string_locale(std::lround(performance->utilization * 100.)) + "%");
+}
+
+
+
+void GscIoPerformanceView::set_counters(const std::vector<Counter>& counters)
+{
+	if (counters == counters_ && !counters_grid_->get_children().empty()) {
+		return;
+	}
+	counters_ = counters;
+	for (auto* child : counters_grid_->get_children()) {
+		counters_grid_->remove(*child);  // managed, deleted when removed
+	}
+	if (counters_.empty()) {
+		auto* label = Gtk::manage(new Gtk::Label(_("No data available"), Gtk::ALIGN_START));
+		counters_grid_->attach(*label, 0, 0);
+	}
+	for (std::size_t i = 0; i < counters_.size(); ++i) {
+		add_row(*counters_grid_, static_cast<int>(i), counters_[i].first + ":")->set_text(counters_[i].second);
+	}
+	counters_grid_->show_all();
+}
+
+
+
+Gtk::Label* GscIoPerformanceView::add_row(Gtk::Grid& grid, int row, const Glib::ustring& name)
+{
+	auto* name_label = Gtk::manage(new Gtk::Label(name, Gtk::ALIGN_START));
+	auto* value_label = Gtk::manage(new Gtk::Label("", Gtk::ALIGN_START));
+	value_label->set_selectable(true);
+	grid.attach(*name_label, 0, row);
+	grid.attach(*value_label, 1, row);
+	return value_label;
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,70 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_IO_PERFORMANCE_VIEW_H
+#define GSC_IO_PERFORMANCE_VIEW_H
+
+#include <gtkmm.h>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "applib/storage_io_load.h"
+
+
+
+/// Live I/O performance of a drive (see StorageIoPerformanceMonitor), shown next to
+/// the SMART counters which grow when a drive is failing (reallocated / pending sectors,
+/// media errors), so that a rising latency can be correlated with them.
+class GscIoPerformanceView : public Gtk::Box {
+	public:
+
+		/// A SMART counter: displayable name and value
+		using Counter = std::pair<Glib::ustring, Glib::ustring>;
+
+
+		/// Constructor
+		GscIoPerformanceView();
+
+
+		/// Show the performance between the last two samples. std::nullopt shows "No data available".
+		void set_performance(const std::optional<StorageIoPerformance>& performance);
+
+
+		/// Set the SMART counters, as of the last data refresh
+		void set_counters(const std::vector<Counter>& counters);
+
+
+	private:
+
+		/// Add a "name: value" row to a grid. \return the value label.
+		Gtk::Label* add_row(Gtk::Grid& grid, int row, const Glib::ustring& name);
+
+
+		Gtk::Label* reads_label_ = nullptr;  ///< Reads per second and throughput
+		Gtk::Label* writes_label_ = nullptr;  ///< Writes per second and throughput
+		Gtk::Label* service_time_label_ = nullptr;  ///< Average service time
+		Gtk::Label* queue_depth_label_ = nullptr;  ///< Average queue depth
+		Gtk::Label* utilization_label_ = nullptr;  ///< Utilization
+
+		Gtk::Grid* counters_grid_ = nullptr;  ///< SMART counters
+		std::vector<Counter> counters_;  ///< Counters shown in counters_grid_
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -12,9 +12,12 @@ Copyright:
 #include <glibmm.h>
 #include <gtkmm.h>
 #include <system_error>
+#include <unordered_set>
 #include <vector>
+#include <map>
 #include <memory>
 #include <algorithm>
+#include <utility>  // std::exchange
 
 #include "hz/string_algo.h"  // string_split
 #include "hz/string_num.h"
@@ -22,26 +25,45 @@ Copyright:
 #include "hz/launch_url.h"
 #include "hz/fs.h"
 #include "rconfig/rconfig.h"
+#include "applib/storage_bulk_operation.h"
 #include "applib/storage_detector.h"
+#include "applib/storage_device_cache.h"
+#include "applib/storage_device_index.h"
+#include "applib/storage_drivedb.h"
+#include "applib/storage_hwmon_temperature.h"
+#include "applib/storage_io_load.h"
+#include "applib/storage_output_compression.h"
+#include "applib/storage_smartd_attrlog.h"
+#include "applib/storage_detector_linux.h"  // is_ignored_device_linux()
 #include "applib/gui_utils.h"  // gui_show_error_dialog
 #include "applib/smartctl_executor.h"  // get_smartctl_binary()
 #include "applib/smartctl_executor_gui.h"
 #include "applib/app_gtkmm_tools.h"  // app_gtkmm_*
 #include "applib/warning_colors.h"  // app_property_get_label_highlight_color
 #include "applib/app_regex.h"
+#include "applib/smartctl_version_cache.h"
 #include "applib/smartctl_version_parser.h"
+#include "applib/smartctl_version_probe.h"
+#include "applib/worker_threads.h"  // app_post_worker_task()
 
 #include "gsc_init.h"  // app_quit()
 #include "gsc_about_dialog.h"
+#include "gsc_attribute_matrix_window.h"
+#include "gsc_diagnostics_window.h"
 #include "gsc_info_window.h"
+#include "gsc_refresh_scheduler.h"
+#include "gsc_prefetcher.h"
 #include "gsc_preferences_window.h"
+#include "gsc_snapshot_compare_window.h"
+#include "gsc_fleet_window.h"
 #include "gsc_executor_log_window.h"
 #include "gsc_executor_error_dialog.h"  // gsc_executor_error_dialog_show
+#include "gsc_gui_benchmark.h"
 
 #include "gsc_main_window_iconview.h"
 #include "gsc_main_window.h"
 #include "gsc_add_device_window.h"
-#include "applib/command_executor_factory.h"
+#include "applib/command_executor_factory_gui.h"
 #include "gsc_startup_settings.h"
 #include "build_config.h"
 
@@ -50,6 +72,15 @@ Copyright:
 using namespace std::literals;
 
 
+
+namespace {
+
+	/// How often the memory budget of the drive data is enforced, seconds
+	constexpr guint memory_budget_check_interval_sec = 30;
+
+}
+
+
 GscMainWindow::GscMainWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui)
 		: AppBuilderWidget<GscMainWindow, false>(gtkcobj, std::move(ui))
 {
@@ -84,8 +115,67 @@ GscMainWindow::GscMainWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder>
 	// Check if smartctl is executable
 	bool smartctl_valid = check_smartctl_version_and_set_format();
 
+	// Delay the smartctl commands to the drives busy with I/O, if enabled.
+	storage_io_load_guard_set_global(storage_io_load_guard_create_from_settings());
+
+	// Fetch the full data of the selected drive in advance. Needed by the scan already (the drives with warnings).
+	prefetcher_ = std::make_unique<GscPrefetcher>();
+
+	// Compact the data of the drives nobody looks at, if it takes too much memory
+	memory_budget_ = storage_memory_budget_create_from_settings();
+	if (memory_budget_.get_budget() > 0) {
+		memory_budget_timeout_id_ = g_timeout_add_seconds(memory_budget_check_interval_sec,
+				&GscMainWindow::on_memory_budget_timeout, this);
+	}
+
 	// Scan
 	populate_iconview_on_startup(smartctl_valid);
+
+	// Follow the disks being plugged in and out, so that a full rescan isn't needed.
+	if (smartctl_valid && rconfig::get_data<bool>("gui/hotplug_rescan")) {
+		hotplug_monitor_ = std::make_unique<StorageHotplugMonitor>();
+		if (hotplug_monitor_->start()) {
+			hotplug_monitor_->signal_event().connect(sigc::mem_fun(*this, &GscMainWindow::on_hotplug_event));
+		} else {
+			hotplug_monitor_.reset();
+		}
+	}
+
+	// Show the smartctl outputs written by other programs (e.g. a cron job) as virtual drives,
+	// re-parsing them when they're rewritten. This doesn't need smartctl at all.
+	if (const auto watch_dir = rconfig::get_data<std::string>("gui/watch_output_directory"); !watch_dir.empty()) {
+		start_output_watcher(hz::fs_path_from_string(watch_dir));
+	}
+
+	// Refresh the open info windows (and optionally, all the drives) periodically, if enabled.
+	refresh_scheduler_ = std::make_shared<GscRefreshScheduler>();
+	refresh_scheduler_->set_icon_drives_slot([this]() { return drives_; });
+
+	// Sample the temperatures (icon tooltips, temperature graphs) more often than the refreshes.
+	if constexpr(BuildEnv::is_kernel_linux()) {
+		auto hwmon_monitor = std::make_shared<StorageHwmonTemperatureMonitor>(
+				hz::fs_path_from_string(rconfig::get_data<std::string>("system/linux_sysfs_path")));
+		const auto interval = std::chrono::seconds(rconfig::get_data<int>("gui/hwmon_temperature_interval_sec"));
+		if (smartctl_valid && hwmon_monitor->start(interval, [this]() { return drives_; })) {
+			hwmon_monitor->signal_sampled().connect(sigc::mem_fun(*this, &GscMainWindow::on_drive_temperature_sampled));
+			hwmon_monitor->sample(drives_);
+			storage_hwmon_temperature_set_global(hwmon_monitor);
+		}
+	}
+
+	// Live I/O performance of the drives (info window tabs, optionally the icons), sampled only while displayed.
+	if (auto io_performance_monitor = storage_io_performance_create_from_settings()) {
+		storage_io_performance_set_global(io_performance_monitor);
+		if (rconfig::get_data<bool>("gui/icons_show_io_performance")) {
+			io_performance_monitor->signal_sampled().connect(sigc::mem_fun(*this, &GscMainWindow::on_io_performance_sampled));
+			io_performance_monitor->add_user();
+			io_performance_icons_ = true;
+		}
+	}
+
+	// Build an info window in advance, once the startup work is done, so that showing
+	// the first drive doesn't wait for it. The monitors above must be set up by then.
+	Glib::signal_idle().connect_once([]() { GscInfoWindow::prebuild_pooled(); }, Glib::PRIORITY_LOW);
 }
 
 
@@ -96,6 +186,27 @@ GscMainWindow::~GscMainWindow()
 	// on_iconview_selection_changed() is called even after the window is deleted,
 	// causing crash on exit.
 	// iconview_->clear_all();
+	if (hotplug_timeout_id_ != 0) {
+		g_source_remove(hotplug_timeout_id_);
+	}
+	if (bulk_test_timeout_id_ != 0) {
+		g_source_remove(bulk_test_timeout_id_);  // the tests keep running, as when quitting during a test
+	}
+	if (memory_budget_timeout_id_ != 0) {
+		g_source_remove(memory_budget_timeout_id_);
+	}
+	hotplug_monitor_.reset();
+	output_watcher_.reset();
+	prefetcher_.reset();  // cancels the running prefetch
+	if (refresh_scheduler_) {  // the info windows may keep it alive
+		refresh_scheduler_->set_icon_drives_slot({});
+	}
+	storage_hwmon_temperature_set_global(nullptr);
+	storage_io_load_guard_set_global(nullptr);
+	if (auto io_performance_monitor = storage_io_performance_get_global(); io_performance_monitor && io_performance_icons_) {
+		io_performance_monitor->remove_user();
+	}
+	storage_io_performance_set_global(nullptr);  // the info windows may keep it alive
 	delete iconview_;
 }
 
@@ -109,6 +220,11 @@ void GscMainWindow::populate_iconview_on_startup(bool smartctl_valid)
 		while (Gtk::Main::events_pending())  // give expose event the time it needs
 			Gtk::Main::iteration();
 
+	} else if (const std::string inventory_file = !get_startup_settings().inventory_file.empty()
+			? get_startup_settings().inventory_file : rconfig::get_data<std::string>("system/inventory_file");
+			!inventory_file.empty() && load_inventory_drives(inventory_file)) {
+		// The inventory drives are shown, no detection needed
+
 	} else if (rconfig::get_data<bool>("gui/scan_on_startup")  // config option
 			&& !get_startup_settings().no_scan) {  // command-line option
 		rescan_devices(true);  // scan for devices and fill the iconview
@@ -148,9 +264,16 @@ void GscMainWindow::populate_iconview_on_startup(bool smartctl_valid)
 		}
 	}
 
-	for (auto&& virt : get_startup_settings().load_virtuals) {
-		if (!virt.empty()) {
-			add_virtual_drive(virt);
+	// In the GUI benchmark mode, the virtual drive files are the templates of the synthetic drives
+	if (get_startup_settings().benchmark_drives > 0) {
+		gsc_gui_benchmark_start(this, get_startup_settings().load_virtuals,
+				static_cast<std::size_t>(get_startup_settings().benchmark_drives),
+				static_cast<std::size_t>(std::max(0, get_startup_settings().benchmark_info_windows)));
+	} else {
+		for (auto&& virt : get_startup_settings().load_virtuals) {
+			if (!virt.empty()) {
+				add_virtual_drive(virt);
+			}
 		}
 	}
 
@@ -162,6 +285,52 @@ void GscMainWindow::populate_iconview_on_startup(bool smartctl_valid)
 
 
 
+namespace {
+
+	/// A choice of the drive filter warning level combobox
+	struct MainWindowWarningFilter {
+		WarningLevel level = WarningLevel::None;  ///< Minimum warning level
+		const char* id = nullptr;  ///< Combobox item ID
+		Glib::ustring label;  ///< Displayed text
+	};
+
+
+	/// Get the choices of the drive filter warning level combobox
+	inline const std::vector<MainWindowWarningFilter>& main_window_get_warning_filters()
+	{
+		static const std::vector<MainWindowWarningFilter> filters = {
+			{WarningLevel::None, "none", _("All drives")},
+			{WarningLevel::Notice, "notice", _("Notices and worse")},
+			{WarningLevel::Warning, "warning", _("Warnings and worse")},
+			{WarningLevel::Alert, "alert", _("Alerts only")},
+		};
+		return filters;
+	}
+
+
+	/// A choice of the drive grouping combobox. The ID is stored in "gui/icons_grouping".
+	struct MainWindowGrouping {
+		StorageDeviceGrouping grouping = StorageDeviceGrouping::None;  ///< Grouping
+		const char* id = nullptr;  ///< Combobox item ID
+		Glib::ustring label;  ///< Displayed text
+	};
+
+
+	/// Get the choices of the drive grouping combobox
+	inline const std::vector<MainWindowGrouping>& main_window_get_groupings()
+	{
+		static const std::vector<MainWindowGrouping> groupings = {
+			{StorageDeviceGrouping::None, "none", _("No grouping")},
+			{StorageDeviceGrouping::Controller, "controller", _("Group by controller")},
+			{StorageDeviceGrouping::Host, "host", _("Group by host")},
+		};
+		return groupings;
+	}
+
+}
+
+
+
 // pass enum elements here
 #define APP_ACTION_NAME(a) #a
 
@@ -175,6 +344,29 @@ bool GscMainWindow::create_widgets()
 
 	iconview_->set_main_window(this);
 
+	// --------------------------------- Filter bar
+
+	drive_filter_entry_ = lookup_widget<Gtk::SearchEntry*>("drive_filter_entry");
+	drive_filter_warning_combo_ = lookup_widget<Gtk::ComboBoxText*>("drive_filter_warning_combo");
+	drive_grouping_combo_ = lookup_widget<Gtk::ComboBoxText*>("drive_grouping_combo");
+
+	for (const auto& filter : main_window_get_warning_filters()) {
+		drive_filter_warning_combo_->append(filter.id, filter.label);
+	}
+	drive_filter_warning_combo_->set_active_id(main_window_get_warning_filters().front().id);
+
+	for (const auto& grouping : main_window_get_groupings()) {
+		drive_grouping_combo_->append(grouping.id, grouping.label);
+	}
+	if (!drive_grouping_combo_->set_active_id(rconfig::get_data<std::string>("gui/icons_grouping"))) {
+		drive_grouping_combo_->set_active_id(main_window_get_groupings().front().id);
+	}
+	on_drive_grouping_changed();
+
+	drive_filter_entry_->signal_search_changed().connect(sigc::mem_fun(*this, &GscMainWindow::on_drive_filter_changed));
+	drive_filter_warning_combo_->signal_changed().connect(sigc::mem_fun(*this, &GscMainWindow::on_drive_filter_changed));
+	drive_grouping_combo_->signal_changed().connect(sigc::mem_fun(*this, &GscMainWindow::on_drive_grouping_changed));
+
 	// --------------------------------- Action widgets
 
 	static const Glib::ustring ui_info =
@@ -193,15 +385,28 @@ bool GscMainWindow::create_widgets()
 	"		<menuitem action='" APP_ACTION_NAME(action_perform_tests) "' />"
 	"		<menuitem action='" APP_ACTION_NAME(action_remove_device) "' />"
 	"		<menuitem action='" APP_ACTION_NAME(action_remove_virtual_device) "' />"
+	"		<separator />"
+	"		<menu action='selection_menu'>"
+	"			<menuitem action='" APP_ACTION_NAME(action_bulk_enable_smart) "' />"
+	"			<menuitem action='" APP_ACTION_NAME(action_bulk_reread_data) "' />"
+	"			<menuitem action='" APP_ACTION_NAME(action_bulk_short_test) "' />"
+	"			<menuitem action='" APP_ACTION_NAME(action_bulk_save_output) "' />"
+	"		</menu>"
+	"		<menuitem action='" APP_ACTION_NAME(action_compare_attributes) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_compare_snapshots) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_fleet_view) "' />"
 
 	"		<separator />"
 	"		<menuitem action='" APP_ACTION_NAME(action_add_device) "' />"
 	"		<menuitem action='" APP_ACTION_NAME(action_load_virtual) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_load_virtual_directory) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_find_imported_drives) "' />"
 	"		<menuitem action='" APP_ACTION_NAME(action_rescan_devices) "' />"
 	"	</menu>"
 
 	"	<menu action='options_menu'>"
 	"		<menuitem action='" APP_ACTION_NAME(action_executor_log) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_diagnostics) "' />"
 	"		<menuitem action='" APP_ACTION_NAME(action_update_drivedb) "' />"
 	"		<menuitem action='" APP_ACTION_NAME(action_preferences) "' />"
 	"	</menu>"
@@ -223,11 +428,19 @@ bool GscMainWindow::create_widgets()
 	"	<menuitem action='" APP_ACTION_NAME(action_perform_tests) "' />"
 	"	<menuitem action='" APP_ACTION_NAME(action_remove_device) "' />"
 	"	<menuitem action='" APP_ACTION_NAME(action_remove_virtual_device) "' />"
+	"	<separator />"
+	"	<menu action='selection_menu'>"
+	"		<menuitem action='" APP_ACTION_NAME(action_bulk_enable_smart) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_bulk_reread_data) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_bulk_short_test) "' />"
+	"		<menuitem action='" APP_ACTION_NAME(action_bulk_save_output) "' />"
+	"	</menu>"
 	"</popup>"
 
 	"<popup name='empty_area_popup'>"
 	"	<menuitem action='" APP_ACTION_NAME(action_add_device) "' />"
 	"	<menuitem action='" APP_ACTION_NAME(action_load_virtual) "' />"
+	"	<menuitem action='" APP_ACTION_NAME(action_load_virtual_directory) "' />"
 	"	<menuitem action='" APP_ACTION_NAME(action_rescan_devices) "' />"
 	"</popup>";
 
@@ -235,6 +448,7 @@ bool GscMainWindow::create_widgets()
 	// Action groups
 	actiongroup_main_ = Gtk::ActionGroup::create("main_actions");
 	actiongroup_device_ = Gtk::ActionGroup::create("device_actions");
+	actiongroup_selection_ = Gtk::ActionGroup::create("selection_actions");
 
 	Glib::RefPtr<Gtk::Action> action;
 
@@ -279,6 +493,29 @@ bool GscMainWindow::create_widgets()
 		actiongroup_device_->add((action_map_[action_remove_virtual_device] = action), Gtk::AccelKey("Delete"),
 				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_remove_virtual_device));
 
+		// --- operations on all the selected drives
+		actiongroup_selection_->add(Gtk::Action::create("selection_menu", _("_Selected Drives")));
+
+		action = Gtk::Action::create(APP_ACTION_NAME(action_bulk_enable_smart), _("_Enable SMART"),
+				_("Enable SMART on all the selected drives"));
+		actiongroup_selection_->add((action_map_[action_bulk_enable_smart] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_bulk_enable_smart));
+
+		action = Gtk::Action::create(APP_ACTION_NAME(action_bulk_reread_data), Gtk::Stock::REFRESH, _("_Re-read Data"),
+				_("Re-read basic SMART data of all the selected drives"));
+		actiongroup_selection_->add((action_map_[action_bulk_reread_data] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_bulk_reread_data));
+
+		action = Gtk::Action::create(APP_ACTION_NAME(action_bulk_short_test), _("Start _Short Self-Test"),
+				_("Start a short self-test on all the selected drives. The results are shown when all the tests are finished."));
+		actiongroup_selection_->add((action_map_[action_bulk_short_test] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_bulk_short_test));
+
+		action = Gtk::Action::create(APP_ACTION_NAME(action_bulk_save_output), Gtk::Stock::SAVE_AS, _("Save _Outputs to Directory..."),
+				_("Save the smartctl output of each selected drive to a directory"));
+		actiongroup_selection_->add((action_map_[action_bulk_save_output] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_bulk_save_output));
+
 		// ---
 		action = Gtk::Action::create(APP_ACTION_NAME(action_add_device), Gtk::Stock::OPEN, _("_Add Device..."),
 				_("Manually add device to device list"));
@@ -290,6 +527,17 @@ bool GscMainWindow::create_widgets()
 		actiongroup_main_->add((action_map_[action_load_virtual] = action), Gtk::AccelKey("<control>O"),
 				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_load_virtual));
 
+		action = Gtk::Action::create(APP_ACTION_NAME(action_load_virtual_directory), Gtk::Stock::DIRECTORY, _("Load Smartctl Outputs from _Directory..."),
+				_("Load all smartctl outputs in a directory or a tar archive as read-only virtual devices"));
+		actiongroup_main_->add((action_map_[action_load_virtual_directory] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_load_virtual_directory));
+
+		action = Gtk::Action::create(APP_ACTION_NAME(action_find_imported_drives), Gtk::Stock::FIND, _("_Find Loaded Virtual Devices..."),
+				_("Search the virtual devices loaded from a directory by model, serial number and warning level"));
+		action->set_sensitive(false);  // until something is imported
+		actiongroup_main_->add((action_map_[action_find_imported_drives] = action), Gtk::AccelKey("<control>F"),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_find_imported_drives));
+
 		action = Gtk::Action::create(APP_ACTION_NAME(action_rescan_devices), Gtk::Stock::REFRESH, _("_Re-scan Device List"),
 				_("Re-scan device list"));
 		actiongroup_main_->add((action_map_[action_rescan_devices] = action), Gtk::AccelKey("<control>R"),
@@ -297,10 +545,30 @@ bool GscMainWindow::create_widgets()
 
 	actiongroup_main_->add(Gtk::Action::create("options_menu", _("_Options")));
 
+		action = Gtk::Action::create(APP_ACTION_NAME(action_compare_attributes), _("Compare _Attributes"),
+				_("Compare the attributes of all the drives side by side"));
+		actiongroup_main_->add((action_map_[action_compare_attributes] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_compare_attributes));
+
+		action = Gtk::Action::create(APP_ACTION_NAME(action_compare_snapshots), _("Compare _Snapshots..."),
+				_("Compare the saved property snapshots of a drive, e.g. the ones written by gsmartcontrol-reprocess"));
+		actiongroup_main_->add((action_map_[action_compare_snapshots] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_compare_snapshots));
+
+		action = Gtk::Action::create(APP_ACTION_NAME(action_fleet_view), _("_Fleet View"),
+				_("Show the summaries of the drives of all the remote hosts, as streamed by gsmartcontrol-agent"));
+		actiongroup_main_->add((action_map_[action_fleet_view] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_fleet_view));
+
 		action = Gtk::Action::create(APP_ACTION_NAME(action_executor_log), _("View Execution Log"));
 		actiongroup_main_->add((action_map_[action_executor_log] = action),
 				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_executor_log));
 
+		action = Gtk::Action::create(APP_ACTION_NAME(action_diagnostics), _("_Diagnostics"),
+				_("Show the memory usage of the drives, the execution statistics and the tracing controls"));
+		actiongroup_main_->add((action_map_[action_diagnostics] = action),
+				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_diagnostics));
+
 		action = Gtk::Action::create(APP_ACTION_NAME(action_update_drivedb), _("Update Drive Database"));
 		actiongroup_main_->add((action_map_[action_update_drivedb] = action),
 				sigc::bind(sigc::mem_fun(*this, &GscMainWindow::on_action_activated), action_update_drivedb));
@@ -329,6 +597,7 @@ bool GscMainWindow::create_widgets()
 	ui_manager_ = Gtk::UIManager::create();
 	ui_manager_->insert_action_group(actiongroup_main_);
 	ui_manager_->insert_action_group(actiongroup_device_);
+	ui_manager_->insert_action_group(actiongroup_selection_);
 
 	// add accelerator group to our window so that they work
 	add_accel_group(ui_manager_->get_accel_group());
@@ -400,6 +669,17 @@ bool GscMainWindow::create_widgets()
 	family_label_->show();
 	family_label_box->pack_start(*family_label_, true, true);
 
+	auto* at_risk_label_box = lookup_widget<Gtk::Box*>("status_at_risk_label_hbox");
+	at_risk_label_ = Gtk::manage(new Gtk::Label(_("None"), Gtk::ALIGN_START));
+	at_risk_label_->set_line_wrap(true);
+	at_risk_label_->set_selectable(true);
+	at_risk_label_->show();
+	at_risk_label_box->pack_start(*at_risk_label_, true, true);
+	app_gtkmm_set_widget_tooltip(*at_risk_label_, _("The drives with the highest risk scores. "
+			"Each pending or uncorrectable sector and NVMe media error adds 10 points, "
+			"each reallocated sector and NVMe \"percentage used\" percent adds 1 point, "
+			"a failed last self-test adds 1000 points."), false);
+
 	return true;
 }
 
@@ -407,6 +687,74 @@ bool GscMainWindow::create_widgets()
 
 namespace {
 
+	/// Check whether a bulk short self-test can be started on a drive
+	inline bool main_window_get_can_start_bulk_test(const StorageDevicePtr& drive)
+	{
+		return !drive->get_is_virtual() && !drive->get_test_is_active() && !drive->get_fetch_in_progress()
+				&& drive->get_self_test_support_status() != StorageDevice::SelfTestSupportStatus::Unsupported;
+	}
+
+
+
+	/// Show a directory chooser dialog, starting in \c last_dir.
+	/// \return The chosen directory (also stored in \c last_dir), or an empty string if cancelled.
+	inline std::string main_window_choose_directory(Gtk::Window& parent, const Glib::ustring& title, std::string& last_dir)
+	{
+		int result = 0;
+
+#if GTK_CHECK_VERSION(3, 20, 0)
+		std::unique_ptr<GtkFileChooserNative, decltype(&g_object_unref)> dialog(gtk_file_chooser_native_new(
+				title.c_str(), parent.gobj(), GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER, nullptr, nullptr),
+				&g_object_unref);
+
+		if (!last_dir.empty()) {
+			gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(dialog.get()), last_dir.c_str());
+		}
+
+		result = gtk_native_dialog_run(GTK_NATIVE_DIALOG(dialog.get()));
+
+#else
+		Gtk::FileChooserDialog dialog(parent, title, Gtk::FILE_CHOOSER_ACTION_SELECT_FOLDER);
+
+		// Add response buttons the the dialog
+		dialog.add_button(Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+		dialog.add_button(Gtk::Stock::OPEN, Gtk::RESPONSE_ACCEPT);
+
+		if (!last_dir.empty())
+			dialog.set_current_folder(last_dir);
+
+		// Show the dialog and wait for a user response
+		result = dialog.run();  // the main cycle blocks here
+#endif
+
+		// Handle the response
+		switch (result) {
+			case Gtk::RESPONSE_ACCEPT:
+			{
+#if GTK_CHECK_VERSION(3, 20, 0)
+				const std::string dir = app_ustring_from_gchar(gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog.get())));
+#else
+				const std::string dir = dialog.get_filename();  // in fs encoding
+#endif
+				if (!dir.empty()) {
+					last_dir = dir;
+				}
+				return dir;
+			}
+
+			case Gtk::RESPONSE_CANCEL: case Gtk::RESPONSE_DELETE_EVENT:
+				// nothing, the dialog is closed already
+				break;
+
+			default:
+				debug_out_error("app", DBG_FUNC_MSG << "Unknown dialog response code: " << result << ".\n");
+				break;
+		}
+		return {};
+	}
+
+
+
 	/// Return true if the user agrees to quit
 	inline bool ask_about_quit_on_test(Gtk::Window& parent)
 	{
@@ -505,10 +853,70 @@ void GscMainWindow::on_action_activated(GscMainWindow::action_t action_type)
 			this->show_load_virtual_file_chooser();
 			break;
 
+		case action_load_virtual_directory:
+			this->show_load_virtual_directory_chooser();
+			break;
+
+		case action_find_imported_drives:
+			this->show_find_imported_drives_dialog();
+			break;
+
 		case action_rescan_devices:
 			rescan_devices(false);
 			break;
 
+		case action_bulk_enable_smart:
+			run_bulk_operation(StorageBulkOperation::EnableSmart);
+			break;
+
+		case action_bulk_reread_data:
+			run_bulk_operation(StorageBulkOperation::Refresh);
+			break;
+
+		case action_bulk_short_test:
+			run_bulk_short_test();
+			break;
+
+		case action_bulk_save_output:
+			run_bulk_operation(StorageBulkOperation::SaveOutput);
+			break;
+
+		case action_compare_attributes:
+		{
+			// this one will only hide on close.
+			auto win = GscAttributeMatrixWindow::create();
+			restore_drive_data(iconview_->get_drives());
+			win->set_drives(iconview_->get_drives());
+			win->show();
+			break;
+		}
+
+		case action_compare_snapshots:
+		{
+			static std::string last_dir;
+			const std::string dir = main_window_choose_directory(*this, _("Snapshot Directory..."), last_dir);
+			if (dir.empty()) {
+				break;
+			}
+			// this one will only hide on close.
+			auto win = GscSnapshotCompareWindow::create();
+			restore_drive_data(iconview_->get_drives());
+			win->set_drives(iconview_->get_drives());
+			win->show();
+			win->open_directory(hz::fs_path_from_string(dir));
+			break;
+		}
+
+		case action_fleet_view:
+		{
+			// this one will only hide on close.
+			auto win = GscFleetWindow::create();
+			win->set_main_window(this);
+			win->show();
+			win->start_agents();
+			break;
+		}
+
 		case action_executor_log:
 		{
 			// this one will only hide on close.
@@ -518,6 +926,16 @@ void GscMainWindow::on_action_activated(GscMainWindow::action_t action_type)
 			break;
 		}
 
+		case action_diagnostics:
+		{
+			// this one will only hide on close.
+			auto win = GscDiagnosticsWindow::create();
+			win->set_iconview(iconview_);
+			win->refresh();
+			win->show();
+			break;
+		}
+
 		case action_update_drivedb:
 		{
 			run_update_drivedb();
@@ -587,8 +1005,7 @@ void GscMainWindow::on_action_enable_smart_toggled(Gtk::ToggleAction* action)
 	if ( (toggle_active && status == StorageDevice::SmartStatus::Disabled)
 			|| (!toggle_active && status == StorageDevice::SmartStatus::Enabled) ) {
 
-		std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-		ex->create_running_dialog(this);
+		auto ex = get_executor_factory()->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
 
 		auto command_status = drive->set_smart_enabled(toggle_active, ex);  // run it with GUI support
 
@@ -611,8 +1028,7 @@ void GscMainWindow::on_action_reread_device_data()
 	StorageDevicePtr drive = iconview_->get_selected_drive();
 
 	if (!drive->get_is_virtual() && !drive->get_test_is_active()) {  // disallow on virtual and testing
-		std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-		ex->create_running_dialog(this);
+		auto ex = get_executor_factory()->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
 
 		// note: this will clear the non-basic properties!
 		auto fetch_status = drive->fetch_basic_data_and_parse(ex);  // run it with GUI support
@@ -707,6 +1123,29 @@ void GscMainWindow::set_drive_menu_status(const StorageDevicePtr& drive)
 
 
 
+void GscMainWindow::set_selection_menu_status(const std::vector<StorageDevicePtr>& drives)
+{
+	if (!actiongroup_selection_)  // the widgets are not created yet
+		return;
+
+	// The bulk operations are sensitive if they can be run on at least one of the drives.
+	actiongroup_selection_->set_sensitive(!drives.empty() && !scanning_);
+
+	const std::vector<std::pair<action_t, StorageBulkOperation>> bulk_actions = {
+		{action_bulk_enable_smart, StorageBulkOperation::EnableSmart},
+		{action_bulk_reread_data, StorageBulkOperation::Refresh},
+		{action_bulk_save_output, StorageBulkOperation::SaveOutput},
+	};
+	for (const auto& [action_type, operation] : bulk_actions) {
+		action_map_[action_type]->set_sensitive(std::any_of(drives.cbegin(), drives.cend(),
+				[operation = operation](const StorageDevicePtr& drive) { return storage_bulk_get_is_applicable(operation, *drive); }));
+	}
+	action_map_[action_bulk_short_test]->set_sensitive(!bulk_test_fleet_
+			&& std::any_of(drives.cbegin(), drives.cend(), &main_window_get_can_start_bulk_test));
+}
+
+
+
 // update statusbar with selected drive info
 void GscMainWindow::update_status_widgets()
 {
@@ -731,15 +1170,18 @@ void GscMainWindow::update_status_widgets()
 		return;
 	}
 
+	// A consistent view, even if the drive is being refreshed
+	const StorageDevice::SnapshotPtr snapshot = drive->get_snapshot();
+
 	/// Translators: %1 is filename
 	const std::string device = Glib::Markup::escape_text(drive->get_is_virtual()
 			? Glib::ustring::compose(_("Virtual: %1"), drive->get_virtual_filename()) : Glib::ustring(drive->get_device_with_type()));
-	const std::string size = Glib::Markup::escape_text(drive->get_device_size_str());
-	const std::string model = Glib::Markup::escape_text(drive->get_model_name().empty()
-			? std::string(_("Unknown model")) : drive->get_model_name());
-	const std::string family = Glib::Markup::escape_text(drive->get_family_name().empty()
-			? C_("model_family", "Unknown") : drive->get_family_name());
-	const std::string family_fallback = Glib::Markup::escape_text(drive->get_family_name().empty() ? model : drive->get_family_name());
+	const std::string size = Glib::Markup::escape_text(snapshot->size);
+	const std::string model = Glib::Markup::escape_text(snapshot->model_name.empty()
+			? std::string(_("Unknown model")) : snapshot->model_name);
+	const std::string family = Glib::Markup::escape_text(snapshot->family_name.empty()
+			? C_("model_family", "Unknown") : snapshot->family_name);
+	const std::string family_fallback = Glib::Markup::escape_text(snapshot->family_name.empty() ? model : snapshot->family_name);
 	const std::string drive_letters_str = Glib::Markup::escape_text(drive->format_drive_letters(false));
 
 	const std::string info_str = device
@@ -751,7 +1193,7 @@ void GscMainWindow::update_status_widgets()
 		app_gtkmm_set_widget_tooltip(*name_label_, info_str, false);  // in case it doesn't fit
 	}
 
-	const StorageProperty health_prop = drive->get_health_property();
+	const StorageProperty& health_prop = snapshot->health_property;
 
 	if (health_label_) {
 		if (health_prop.generic_name == "smart_status/passed") {
@@ -791,9 +1233,16 @@ void GscMainWindow::update_status_widgets()
 
 void GscMainWindow::rescan_devices(bool startup)
 {
-	// ignore double-scan (may happen because we use gtk loop iterations here).
-	if (this->scanning_)
+	// A new scan supersedes the running one (which may be stuck on a controller): stop its
+	// commands and start over once it returns. This may happen because we use gtk loop iterations here.
+	if (this->scanning_) {
+		if (scan_cancellation_) {
+			debug_out_info("app", DBG_FUNC_MSG << "Cancelling the running scan, a new one was requested.\n");
+			scan_cancellation_->cancel();
+			rescan_pending_ = true;
+		}
 		return;
+	}
 
 	// If we're not in startup, smartctl version may have changed (by specifying a different binary in Preferences)
 	// so we need to re-validate the output format:
@@ -823,6 +1272,11 @@ void GscMainWindow::rescan_devices(bool startup)
 
 	this->scanning_ = true;
 
+	// The device files may belong to other drives now
+	if (auto hwmon_monitor = storage_hwmon_temperature_get_global()) {
+		hwmon_monitor->clear_cache();
+	}
+
 // 	std::string match_str = rconfig::get_data<std::string>("system/device_match_patterns");
 	auto blacklist_str = rconfig::get_data<std::string>("system/device_blacklist_patterns");
 
@@ -831,23 +1285,84 @@ void GscMainWindow::rescan_devices(bool startup)
 // 	hz::string_split(match_str, ';', match_patterns, true);
 	hz::string_split(blacklist_str, ';', blacklist_patterns, true);
 
+	const bool use_cache = rconfig::get_data<bool>("gui/use_drive_cache");
+	const bool smart_capable_only = rconfig::get_data<bool>("gui/show_smart_capable_only");
+	auto should_show = [smart_capable_only](const StorageDevicePtr& drive)
+	{
+		return !smart_capable_only || drive->get_smart_status() != StorageDevice::SmartStatus::Unsupported;
+	};
+
+	// On startup, show the drives from the previous run right away. On re-scan, keep showing
+	// the currently detected drives (virtual drives are removed, as before). They are revalidated
+	// once the detection below finishes, and the changed ones are updated through signal_changed,
+	// so the icons don't flash or change their order.
+	std::vector<StorageDevicePtr> cached_drives;
+	if (startup && use_cache) {
+		cached_drives = storage_device_cache_load(storage_device_cache_get_default_file());
+	} else if (!startup) {
+		for (const auto& drive : drives_) {
+			if (!drive->get_is_virtual())
+				cached_drives.push_back(drive);
+		}
+	}
+
 	iconview_->set_empty_view_message(GscMainWindowIconView::Message::Scanning);
 
-	iconview_->clear_all();  // clear previous icons, invalidate region to update the message.
+	if (cached_drives.empty()) {
+		iconview_->clear_all();  // clear previous icons, invalidate region to update the message.
+	} else {
+		iconview_->update_entries(cached_drives, should_show);
+	}
+
+	this->drives_ = cached_drives;
+
 	while (Gtk::Main::events_pending())  // give expose event the time it needs
 		Gtk::Main::iteration();
 
-	this->drives_.clear();
-
 	// populate the icon area with drive icons
 	StorageDetector sd;
 // 	sd.add_match_patterns(match_patterns);
 	sd.add_blacklist_patterns(blacklist_patterns);
+	sd.set_max_parallel_fetches(static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/smartctl_max_parallel_fetches"))));
+
+
+	// With nothing shown yet, show each drive as soon as it's found: a placeholder first,
+	// filled in (or removed, if it shouldn't be shown) as soon as its basic data arrives.
+	if (cached_drives.empty()) {
+		sd.set_drive_callback([this, &should_show](const StorageDevicePtr& drive, StorageDetector::DriveStage stage)
+		{
+			if (stage == StorageDetector::DriveStage::Detected) {
+				this->drives_.push_back(drive);
+				iconview_->add_entry(drive);
+				iconview_->set_entry_pending(drive.get(), drive->get_basic_output().empty());
+				return;
+			}
+			iconview_->set_entry_pending(drive.get(), false);
+			if (!should_show(drive)) {
+				iconview_->remove_entry(drive.get());
+			}
+		});
+	}
+
+	auto ex_factory = get_executor_factory();  // run it with GUI support
 
+	// Cancelled by a new scan or when the deadline passes, keeping the drives found so far
+	const auto scan_cancellation = std::make_shared<AppCancellation>();
+	scan_cancellation->set_timeout(std::chrono::seconds(rconfig::get_data<int>("system/scan_timeout_sec")));
+	scan_cancellation_ = scan_cancellation;
+	ex_factory->set_cancellation(scan_cancellation);
 
-	auto ex_factory = std::make_shared<CommandExecutorFactory>(true, this);  // run it with GUI support
+	std::vector<StorageDevicePtr> detected_drives;
+	auto fetch_status = sd.detect_and_fetch_basic_data(detected_drives, ex_factory);
+	blacklisted_drives_ = sd.get_blacklisted_drives();  // for apply_prefs_changes()
 
-	auto fetch_status = sd.detect_and_fetch_basic_data(drives_, ex_factory);
+	ex_factory->set_cancellation(nullptr);
+	scan_cancellation_.reset();
+	const bool cancelled = (!fetch_status && fetch_status.error().data() == StorageDetectorError::Cancelled);
+
+	for (const auto& drive : detected_drives) {
+		iconview_->set_entry_pending(drive.get(), false);  // in case the fetch stopped early
+	}
 
 	bool error = false;
 
@@ -865,142 +1380,1109 @@ void GscMainWindow::rescan_devices(bool startup)
 		}
 	}
 
-	if (!error && !fetch_status) {  // generic scan error. smartctl errors are not reported during scan at all.
+	if (!error && cancelled && !rescan_pending_) {  // the deadline passed, show what we have
+		gsc_executor_error_dialog_show(_("The scan was stopped"), fetch_status.error().message(), this, false, false);
+
+	} else if (!error && !fetch_status && !cancelled) {  // generic scan error. smartctl errors are not reported during scan at all.
 		// we don't show output button here
 		gsc_executor_error_dialog_show(_("An error occurred while scanning the system"),
 				fetch_status.error().message(), this, false, false);
 		// error = true;
+	}
 
-	// add them anyway, in case the error was only on one drive.
-	} else { // if (!error) {
-		// add them to iconview
-		for (auto& drive : drives_) {
-			if (rconfig::get_data<bool>("gui/show_smart_capable_only")) {
-				if (drive->get_smart_status() != StorageDevice::SmartStatus::Unsupported)
-					iconview_->add_entry(drive);
-			} else {
-				iconview_->add_entry(drive);
+	const bool scan_ok = (!error && fetch_status);
+
+	if (!scan_ok || cached_drives.empty()) {
+		// the cached (or previous) drives (if any) can't be validated, replace them with whatever we found.
+		this->drives_ = detected_drives;
+		if (error || fetch_status || cancelled) {
+			// add them anyway, in case the error was only on one drive.
+			// The entries added during the scan stay, the duplicates and the hidden ones are removed.
+			iconview_->update_entries(drives_, should_show);
+		} else {
+			iconview_->clear_all();
+		}
+
+	} else {
+		// Keep the cached drive objects which are still present (the icons and any
+		// windows opened during the scan refer to them), updating their data if it changed.
+		std::map<std::string, StorageDevicePtr> cached_by_key;
+		for (const auto& drive : cached_drives) {
+			cached_by_key.emplace(storage_device_cache_get_key(*drive), drive);
+		}
+
+		std::vector<StorageDevicePtr> merged_drives;
+		for (const auto& drive : detected_drives) {
+			auto iter = cached_by_key.find(storage_device_cache_get_key(*drive));
+			if (iter == cached_by_key.end()) {
+				merged_drives.push_back(drive);
+				continue;
+			}
+
+			StorageDevicePtr cached = iter->second;
+			cached_by_key.erase(iter);
+			merged_drives.push_back(cached);
+
+			cached->set_extra_arguments(drive->get_extra_arguments());
+			cached->set_drive_letters(drive->get_drive_letters());
+			// Drives with full data (e.g. with an open info window) keep it, it's newer than the basic data.
+			if (cached->get_basic_output() != drive->get_basic_output() && !cached->get_test_is_active()
+					&& cached->get_full_output().empty()) {
+				cached->set_info_output(drive->get_basic_output());
+				static_cast<void>(cached->parse_basic_data());  // this emits signal_changed(), updating the icon if needed.
 			}
 		}
+
+		// This removes the drives which are gone (or hidden now) and appends the new ones.
+		iconview_->update_entries(merged_drives, should_show);
+
+		this->drives_ = merged_drives;
+	}
+
+	if (scan_ok && use_cache) {
+		if (auto ec = storage_device_cache_save(storage_device_cache_get_default_file(), drives_)) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot save drive cache: " << ec.message() << "\n");
+		}
+	}
+
+	// Pick up the samples smartd recorded since the last scan
+	if (auto history = storage_history_get_global(); history && scan_ok) {
+		StorageSmartdAttrlogImporter attrlog_importer(history,
+				rconfig::get_data<std::string>("system/smartd_attrlog_prefix"), StorageSmartdAttrlogImporter::get_default_state_file());
+		std::error_code ec = attrlog_importer.load();
+		if (!ec) {
+			ec = attrlog_importer.import(drives_);
+		}
+		if (ec) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot import smartd attribute logs: " << ec.message() << "\n");
+		} else if (attrlog_importer.get_imported_count() > 0) {
+			debug_out_info("app", DBG_FUNC_MSG << "Imported " << attrlog_importer.get_imported_count() << " samples from smartd attribute logs.\n");
+		}
 	}
 
+	// The scan removed the virtual drives, including the watched ones
+	show_watched_drives();
+
 	// in case there are no drives in the system.
 	if (iconview_->get_num_icons() == 0)
 		iconview_->set_empty_view_message(GscMainWindowIconView::Message::NoDrivesFound);
 
+	// The user is likely to look at the drives with warnings first
+	std::vector<StorageDevicePtr> warning_drives;
+	for (const auto& drive : drives_) {
+		if (!drive->get_fetch_in_progress() && drive->get_health_property().warning_level != WarningLevel::None) {
+			warning_drives.push_back(drive);
+		}
+	}
+	prefetcher_->set_background_drives(warning_drives);
+
 	this->scanning_ = false;
+
+	// Start the superseding scan outside of this one's stack
+	if (rescan_pending_) {
+		rescan_pending_ = false;
+		Glib::signal_idle().connect_once([this]() { this->rescan_devices(false); });
+	}
 }
 
 
 
-void GscMainWindow::run_update_drivedb()
+bool GscMainWindow::load_inventory_drives(const std::string& file)
 {
-	auto smartctl_binary = get_smartctl_binary();
-
-	if (smartctl_binary.empty()) {
-		gui_show_error_dialog(_("Error Updating Drive Database"), _("Smartctl binary is not specified in configuration."), this);
-		return;
+	auto entries = storage_inventory_load(hz::fs_path_from_string(file));
+	if (!entries) {
+		debug_out_warn("app", "Cannot load drive inventory \"" << file << "\": " << entries.error().message() << "\n");
+		gui_show_error_dialog(_("Cannot load drive inventory"),
+				entries.error().message() + "\n\n" + _("The drives will be scanned for instead."), this);
+		return false;
 	}
+	debug_out_info("app", "Loaded " << entries->size() << " drives from inventory \"" << file << "\", skipping detection.\n");
 
-	std::vector<std::string> argv;
+	this->scanning_ = true;  // the executors iterate the main loop, don't allow a rescan meanwhile
 
-	if constexpr (BuildEnv::is_kernel_family_windows()) {
-		hz::fs::path update_binary_path = hz::fs_path_from_string("update-smart-drivedb.ps1");
-		if (smartctl_binary.is_absolute()) {
-			update_binary_path = smartctl_binary.parent_path() / update_binary_path;
-		}
-		argv = {"powershell.exe", "-ExecutionPolicy", "Bypass", "-File", hz::fs_path_to_string(update_binary_path)};
+	iconview_->set_empty_view_message(GscMainWindowIconView::Message::Scanning);
+	iconview_->clear_all();
+	drives_.clear();
 
-	} else {  // X11
-		// TODO Wayland
-		hz::fs::path update_binary_path = hz::fs_path_from_string("update-smart-drivedb");
-		if (smartctl_binary.is_absolute()) {
-			update_binary_path = smartctl_binary.parent_path() / update_binary_path;
+	// Show each drive right away, filled in as soon as its basic data arrives
+	StorageDetector sd;
+	sd.set_max_parallel_fetches(static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/smartctl_max_parallel_fetches"))));
+	const bool smart_capable_only = rconfig::get_data<bool>("gui/show_smart_capable_only");
+	sd.set_drive_callback([this, smart_capable_only](const StorageDevicePtr& drive, StorageDetector::DriveStage stage)
+	{
+		if (stage == StorageDetector::DriveStage::Detected) {
+			return;
 		}
-		argv = {"xterm", "-hold", "-e", hz::fs_path_to_string(update_binary_path)};
+		iconview_->set_entry_pending(drive.get(), false);
+		if (smart_capable_only && drive->get_smart_status() == StorageDevice::SmartStatus::Unsupported) {
+			iconview_->remove_entry(drive.get());
+		}
+	});
+
+	std::vector<StorageDevicePtr> drives = storage_inventory_create_drives(entries.value());
+	for (const auto& drive : drives) {
+		drives_.push_back(drive);
+		iconview_->add_entry(drive);
+		iconview_->set_entry_pending(drive.get(), true);
 	}
 
-	try {
-		Glib::spawn_async(Glib::get_current_dir(), argv, Glib::SPAWN_SEARCH_PATH);
+	auto fetch_status = sd.fetch_basic_data(drives, get_executor_factory());
+	if (!fetch_status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot read some of the inventory drives: " << fetch_status.error().message() << "\n");
 	}
-	catch(Glib::Error& e) {
-		gui_show_error_dialog(_("Error Updating Drive Database"), e.what(), this);
+	for (const auto& error : sd.get_fetch_data_errors()) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Inventory drive error: " << error << "\n");
 	}
-}
 
+	if (iconview_->get_num_icons() == 0)
+		iconview_->set_empty_view_message(GscMainWindowIconView::Message::NoDrivesFound);
 
+	iconview_->update_menu_actions();
+	this->update_status_widgets();
+	this->scanning_ = false;
 
-bool GscMainWindow::add_device(const std::string& file, const std::string& type_arg, const std::vector<std::string>& extra_args)
-{
-	// win32 doesn't have device files, so skip the check in Windows.
-	if constexpr(!BuildEnv::is_kernel_family_windows()) {
-		std::error_code ec;
-		if (!hz::fs::exists(hz::fs_path_from_string(file), ec)) {
-			gui_show_error_dialog(_("Cannot add device"),
-					(ec.message().empty() ? Glib::ustring::compose(_("Device \"%1\" doesn't exist."), file).raw() : ec.message()), this);
-			return false;
-		}
+	if (rconfig::get_data<bool>("system/inventory_reconcile")) {
+		// Let the window show the inventory drives first
+		Glib::signal_idle().connect_once([this, inventory = std::move(entries.value())]() { this->reconcile_inventory(inventory); },
+				Glib::PRIORITY_LOW);
 	}
+	return true;
+}
 
-	auto drive = std::make_shared<StorageDevice>(file);
-	drive->set_type_argument(type_arg);
-	drive->set_extra_arguments(extra_args);
-	drive->set_is_manually_added(true);
 
-	auto ex_factory = std::make_shared<CommandExecutorFactory>(true, this);  // pass this as dialog parent
+
+void GscMainWindow::reconcile_inventory(const std::vector<StorageInventoryEntry>& entries)
+{
+	if (this->scanning_) {
+		return;  // a rescan was requested meanwhile, it replaces the drives anyway
+	}
+	this->scanning_ = true;
+
+	std::vector<std::string> blacklist_patterns;
+	hz::string_split(rconfig::get_data<std::string>("system/device_blacklist_patterns"), ';', blacklist_patterns, true);
+
+	StorageDetector sd;
+	sd.add_blacklist_patterns(blacklist_patterns);
+
+	auto ex_factory = get_executor_factory();
+
+	std::vector<StorageDevicePtr> detected_drives;
+	auto detect_status = sd.detect(detected_drives, ex_factory);
+	if (!detect_status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot scan for drives to reconcile the inventory with: "
+				<< detect_status.error().message() << "\n");
+		this->scanning_ = false;
+		return;
+	}
+
+	auto result = storage_inventory_reconcile(entries, detected_drives);
+	for (const auto& entry : result.missing) {
+		debug_out_warn("app", "Inventory drive " << entry.device
+				<< (entry.type_argument.empty() ? std::string() : " (" + entry.type_argument + ")") << " was not detected.\n");
+	}
+
+	if (!result.unlisted.empty()) {
+		for (const auto& drive : result.unlisted) {
+			debug_out_warn("app", "Drive " << drive->get_device_with_type() << " is not in the inventory, adding it.\n");
+		}
+		sd.set_max_parallel_fetches(static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/smartctl_max_parallel_fetches"))));
+		static_cast<void>(sd.fetch_basic_data(result.unlisted, ex_factory));
+
+		const bool smart_capable_only = rconfig::get_data<bool>("gui/show_smart_capable_only");
+		for (const auto& drive : result.unlisted) {
+			if (!smart_capable_only || drive->get_smart_status() != StorageDevice::SmartStatus::Unsupported) {
+				drives_.push_back(drive);
+				iconview_->add_entry(drive);
+			}
+		}
+		iconview_->update_menu_actions();
+		this->update_status_widgets();
+	}
+
+	this->scanning_ = false;
+}
+
+
+
+void GscMainWindow::run_update_drivedb()
+{
+	auto smartctl_binary = get_smartctl_binary();
+
+	if (smartctl_binary.empty()) {
+		gui_show_error_dialog(_("Error Updating Drive Database"), _("Smartctl binary is not specified in configuration."), this);
+		return;
+	}
+
+	std::vector<std::string> argv;
+
+	if constexpr (BuildEnv::is_kernel_family_windows()) {
+		hz::fs::path update_binary_path = hz::fs_path_from_string("update-smart-drivedb.ps1");
+		if (smartctl_binary.is_absolute()) {
+			update_binary_path = smartctl_binary.parent_path() / update_binary_path;
+		}
+		argv = {"powershell.exe", "-ExecutionPolicy", "Bypass", "-File", hz::fs_path_to_string(update_binary_path)};
+
+	} else {  // X11
+		// TODO Wayland
+		hz::fs::path update_binary_path = hz::fs_path_from_string("update-smart-drivedb");
+		if (smartctl_binary.is_absolute()) {
+			update_binary_path = smartctl_binary.parent_path() / update_binary_path;
+		}
+		argv = {"xterm", "-hold", "-e", hz::fs_path_to_string(update_binary_path)};
+	}
+
+	if (drivedb_update_running_) {
+		return;
+	}
+
+	// Remember the drive database, to find out what the update changed.
+	drivedb_files_ = storage_drivedb_get_default_files(smartctl_binary);
+	drivedb_before_update_ = storage_drivedb_take_snapshot(drivedb_files_);
+
+	Glib::Pid pid{};
+	try {
+		Glib::spawn_async(Glib::get_current_dir(), argv, Glib::SPAWN_SEARCH_PATH | Glib::SPAWN_DO_NOT_REAP_CHILD,
+				Glib::SlotSpawnChildSetup(), &pid);
+	}
+	catch(Glib::Error& e) {
+		drivedb_before_update_.clear();
+		gui_show_error_dialog(_("Error Updating Drive Database"), e.what(), this);
+		return;
+	}
+
+	// The updater runs in the background, the window stays usable.
+	drivedb_update_running_ = true;
+	action_map_[action_update_drivedb]->set_sensitive(false);
+	Glib::signal_child_watch().connect(sigc::mem_fun(*this, &GscMainWindow::on_update_drivedb_finished), pid);
+}
+
+
+
+void GscMainWindow::on_update_drivedb_finished(Glib::Pid pid, int child_status)
+{
+	Glib::spawn_close_pid(pid);
+	debug_out_info("app", DBG_FUNC_MSG << "Drive database updater exited with status " << child_status << ".\n");
+
+	drivedb_update_running_ = false;
+	action_map_[action_update_drivedb]->set_sensitive(true);
+
+	// The exit status of the terminal doesn't tell whether the update succeeded, the files do.
+	const auto changed_entries = storage_drivedb_get_changed_entries(drivedb_before_update_,
+			storage_drivedb_take_snapshot(drivedb_files_));
+	drivedb_before_update_.clear();
+	this->apply_drivedb_changes(changed_entries);
+}
+
+
+
+void GscMainWindow::apply_drivedb_changes(const std::vector<StorageDriveDbEntry>& changed_entries)
+{
+	if (changed_entries.empty()) {
+		debug_out_info("app", DBG_FUNC_MSG << "The drive database is unchanged.\n");
+		return;
+	}
+	if (scanning_) {  // the scan re-reads all the drives anyway
+		return;
+	}
+
+	std::vector<StorageDevicePtr> fetch_drives;
+	std::size_t num_reparsed = 0;
+	for (const auto& drive : drives_) {
+		if (drive->get_test_is_active() || drive->get_fetch_in_progress()) {
+			continue;
+		}
+		std::string firmware;
+		if (const auto* prop = drive->get_property_repository().find_property("firmware_version");
+				prop && prop->is_value_type<std::string>()) {
+			firmware = prop->get_value<std::string>();
+		}
+		const bool affected = !drive->get_is_virtual() && std::any_of(changed_entries.cbegin(), changed_entries.cend(),
+				[&](const StorageDriveDbEntry& entry) { return storage_drivedb_entry_matches(entry, drive->get_model_name(), firmware); });
+		if (affected) {
+			fetch_drives.push_back(drive);
+		} else if (auto parse_status = drive->reparse_outputs(); !parse_status) {  // emits signal_changed()
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot re-parse the data of " << drive->get_device_with_type()
+					<< ": " << parse_status.error().message() << "\n");
+		} else {
+			++num_reparsed;
+		}
+	}
+	debug_out_info("app", DBG_FUNC_MSG << changed_entries.size() << " drive database entries changed. Re-reading "
+			<< fetch_drives.size() << " drive(s), re-parsed " << num_reparsed << " drive(s).\n");
+
+	if (!fetch_drives.empty()) {
+		StorageDetector sd;
+		sd.set_max_parallel_fetches(static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/smartctl_max_parallel_fetches"))));
+		this->scanning_ = true;  // the executors iterate the main loop, don't allow a rescan meanwhile.
+		static_cast<void>(sd.fetch_basic_data(fetch_drives, get_executor_factory()));  // emits signal_changed()
+		this->scanning_ = false;
+	}
+
+	iconview_->update_menu_actions();
+	this->update_status_widgets();
+}
+
+
+
+bool GscMainWindow::add_device(const std::string& file, const std::string& type_arg, const std::vector<std::string>& extra_args)
+{
+	// win32 doesn't have device files, so skip the check in Windows.
+	if constexpr(!BuildEnv::is_kernel_family_windows()) {
+		std::error_code ec;
+		if (!hz::fs::exists(hz::fs_path_from_string(file), ec)) {
+			gui_show_error_dialog(_("Cannot add device"),
+					(ec.message().empty() ? Glib::ustring::compose(_("Device \"%1\" doesn't exist."), file).raw() : ec.message()), this);
+			return false;
+		}
+	}
+
+	auto drive = std::make_shared<StorageDevice>(file);
+	drive->set_type_argument(type_arg);
+	drive->set_extra_arguments(extra_args);
+	drive->set_is_manually_added(true);
+
+	auto ex_factory = get_executor_factory();
 
 	std::vector<StorageDevicePtr> tmp_drives;
 	tmp_drives.push_back(drive);
 
-	StorageDetector sd;
-	auto fetch_error = sd.fetch_basic_data(tmp_drives, ex_factory, true);  // return its first error
-	if (!fetch_error) {
-		gsc_executor_error_dialog_show(_("An error occurred while adding the device"), fetch_error.error().message(), this);
+	StorageDetector sd;
+	auto fetch_error = sd.fetch_basic_data(tmp_drives, ex_factory, true);  // return its first error
+	if (!fetch_error) {
+		gsc_executor_error_dialog_show(_("An error occurred while adding the device"), fetch_error.error().message(), this);
+
+	} else {
+		this->drives_.push_back(drive);
+		this->iconview_->add_entry(drive, true);  // add it, scroll and select it.
+	}
+
+	return true;
+}
+
+
+
+bool GscMainWindow::open_remote_drive(const StorageDevicePtr& drive)
+{
+	for (const auto& existing : drives_) {
+		if (existing->get_remote_host_name() == drive->get_remote_host_name()
+				&& existing->get_device() == drive->get_device() && existing->get_type_argument() == drive->get_type_argument()) {
+			this->show_device_info_window(existing);
+			return true;
+		}
+	}
+
+	std::vector<StorageDevicePtr> tmp_drives;
+	tmp_drives.push_back(drive);
+
+	StorageDetector sd;
+	auto fetch_error = sd.fetch_basic_data(tmp_drives, get_executor_factory(), true);  // return its first error
+	if (!fetch_error) {
+		gsc_executor_error_dialog_show(_("An error occurred while adding the device"), fetch_error.error().message(), this);
+		return false;
+	}
+
+	this->drives_.push_back(drive);
+	this->iconview_->add_entry(drive, true);  // add it, scroll and select it.
+	this->show_device_info_window(drive);  // fetches the full data
+	return true;
+}
+
+
+
+bool GscMainWindow::add_virtual_drive(const std::string& file)
+{
+	const int max_size = 10*1024*1024;  // 10M, after decompression
+	auto loaded = storage_output_load(hz::fs_path_from_string(file), max_size);  // gzip-compressed files too
+	if (!loaded) {
+		debug_out_warn("app", "Cannot open virtual drive file \"" << file << "\": " << loaded.error().message() << "\n");
+		gui_show_error_dialog(_("Cannot load data file"), loaded.error().message(), this);
+		return false;
+	}
+	std::string output = std::move(loaded.value());
+
+	// we have to use smart pointers here, because a pointer may be invalidated
+	// on vector reallocation
+	auto drive = std::make_shared<StorageDevice>(file, true);
+
+	drive->set_virtual_output(std::move(output));  // info can be parsed from full output string too.
+
+	// this will set the type and add the properties
+	auto parse_error = drive->parse_any_data_for_virtual();
+	if (!parse_error) {
+		gui_show_error_dialog(_("Cannot interpret SMART data"), parse_error.error().message(), this);
+		return false;
+	}
+
+	this->drives_.push_back(drive);
+
+	this->iconview_->add_entry(drives_.back(), true);  // add it, scroll and select it.
+
+	return true;
+}
+
+
+
+
+void GscMainWindow::add_virtual_drives(const std::vector<StorageDevicePtr>& drives)
+{
+	drives_.insert(drives_.end(), drives.begin(), drives.end());
+	for (const auto& drive : drives) {
+		iconview_->add_entry(drive);
+	}
+	iconview_->update_menu_actions();
+	this->update_status_widgets();
+}
+
+
+
+
+namespace {
+
+	/// State of GscMainWindow::import_virtual_drives(), passed to the worker thread
+	struct MainWindowVirtualImport {
+		std::string path;  ///< Directory or tar archive
+		sigc::slot<void, hz::ExpectedValue<VirtualDriveImportResult, VirtualDriveImportError>&> finished_slot;  ///< Called when finished
+		hz::ExpectedValue<VirtualDriveImportResult, VirtualDriveImportError> result;  ///< Import result, written by the worker thread
+	};
+
+}
+
+
+
+void GscMainWindow::import_virtual_drives(const std::string& path)
+{
+	// Each import replaces the previous one, so only the last requested one matters
+	if (virtual_import_in_progress_) {
+		pending_virtual_import_path_ = path;
+		return;
+	}
+	virtual_import_in_progress_ = true;
+
+	auto* task = new MainWindowVirtualImport();
+	task->path = path;
+	// Bound in this thread, and called in the main context. Empty if the window is destroyed.
+	task->finished_slot = sigc::mem_fun(*this, &GscMainWindow::on_virtual_drives_imported);
+
+	// Reading and parsing thousands of files takes a while, don't freeze the window
+	app_post_worker_task([task]() {
+		task->result = storage_virtual_import(hz::fs_path_from_string(task->path));
+
+		// Don't touch task after this, it's owned by the main context.
+		g_main_context_invoke_full(g_main_context_default(), G_PRIORITY_DEFAULT, [](gpointer data) -> gboolean {
+			auto* i = static_cast<MainWindowVirtualImport*>(data);
+			if (i->finished_slot) {
+				i->finished_slot(i->result);
+			}
+			return FALSE;
+		}, task, [](gpointer data) {
+			delete static_cast<MainWindowVirtualImport*>(data);
+		});
+	});
+}
+
+
+
+void GscMainWindow::on_virtual_drives_imported(hz::ExpectedValue<VirtualDriveImportResult, VirtualDriveImportError>& import_result)
+{
+	virtual_import_in_progress_ = false;
+	if (!pending_virtual_import_path_.empty()) {
+		// Superseded by a newer import
+		import_virtual_drives(std::exchange(pending_virtual_import_path_, std::string()));
+		return;
+	}
+
+	if (!import_result) {
+		gui_show_error_dialog(_("Cannot load data files"), import_result.error().message(), this);
+		return;
+	}
+	for (const auto& error : import_result->errors) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot import virtual drive: " << error << "\n");
+	}
+
+	const std::size_t source_count = import_result->source_count;
+	const std::size_t error_count = import_result->errors.size();
+	const std::size_t duplicate_count = import_result->index.get_duplicate_count();
+	imported_drives_index_ = std::make_unique<VirtualDriveIndex>(std::move(import_result->index));
+	if (auto iter = action_map_.find(action_find_imported_drives); iter != action_map_.end()) {
+		iter->second->set_sensitive(true);
+	}
+
+	const std::size_t shown = std::min(show_imported_drives(std::string(), WarningLevel::None),
+			static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("gui/virtual_import_page_size"))));
+
+	gui_show_info_dialog(_("Virtual devices loaded"),
+			Glib::ustring::compose(_("Loaded %1 devices from %2 files (%3 older outputs of the same devices skipped, %4 files could not be read)."
+			" Showing %5 of them, the ones with the highest warnings first. Use \"Find Loaded Virtual Devices\" to search them."),
+					imported_drives_index_->size(), source_count, duplicate_count, error_count, shown), this);
+}
+
+
+
+std::size_t GscMainWindow::show_imported_drives(const std::string& text, WarningLevel min_level)
+{
+	// Remove the previous page, unless the user closed them already
+	for (const auto& drive : imported_drives_shown_) {
+		iconview_->remove_entry(drive.get());
+		drives_.erase(std::remove(drives_.begin(), drives_.end(), drive), drives_.end());
+	}
+	imported_drives_shown_.clear();
+
+	if (!imported_drives_index_) {
+		return 0;
+	}
+	const auto found = imported_drives_index_->find(text, min_level);
+	const auto page_size = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("gui/virtual_import_page_size")));
+	for (std::size_t i = 0; i < found.size() && i < page_size; ++i) {
+		imported_drives_shown_.push_back(found[i]->drive);
+		drives_.push_back(found[i]->drive);
+		iconview_->add_entry(found[i]->drive, i == 0);  // scroll to the first one
+	}
+	return found.size();
+}
+
+
+
+void GscMainWindow::show_find_imported_drives_dialog()
+{
+	if (!imported_drives_index_) {
+		return;
+	}
+	static std::string last_text;
+	std::string text;
+	if (!gui_show_text_entry_dialog(_("Find Loaded Virtual Devices"), _("Model or serial number:"),
+			_("Add <b>level:notice</b>, <b>level:warning</b> or <b>level:alert</b> to show only the devices with such warnings."),
+			text, last_text, this, true)) {
+		return;
+	}
+	last_text = text;
+
+	// Extract the level:* token
+	WarningLevel min_level = WarningLevel::None;
+	std::vector<std::string> words, search_words;
+	hz::string_split(text, ' ', words, true);
+	for (const auto& word : words) {
+		const std::string lower = hz::string_to_lower_copy(word);
+		if (lower == "level:notice") {
+			min_level = WarningLevel::Notice;
+		} else if (lower == "level:warning") {
+			min_level = WarningLevel::Warning;
+		} else if (lower == "level:alert") {
+			min_level = WarningLevel::Alert;
+		} else {
+			search_words.push_back(word);
+		}
+	}
+
+	const std::size_t found = show_imported_drives(hz::string_join(search_words, " "), min_level);
+	const auto page_size = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("gui/virtual_import_page_size")));
+	if (found == 0) {
+		gui_show_info_dialog(_("No loaded virtual devices match the search."), this);
+	} else if (found > page_size) {
+		gui_show_info_dialog(Glib::ustring::compose(_("%1 devices match the search, showing the first %2 of them."),
+				found, page_size), this);
+	}
+}
+
+
+
+void GscMainWindow::start_output_watcher(const hz::fs::path& dir)
+{
+	output_watcher_ = std::make_unique<StorageOutputWatcher>();
+	if (!output_watcher_->start(dir)) {
+		output_watcher_.reset();
+		return;
+	}
+	output_watcher_->signal_event().connect(sigc::mem_fun(*this, &GscMainWindow::on_output_file_event));
+
+	for (const auto& file : output_watcher_->get_files()) {
+		if (auto drive = load_watched_output(file, nullptr)) {
+			watched_drives_.emplace(file, drive);
+		}
+	}
+	// The initial scan (if any) is done by now
+	show_watched_drives();
+}
+
+
+
+void GscMainWindow::on_output_file_event(const StorageOutputFileEvent& event)
+{
+	auto iter = watched_drives_.find(event.file);
+
+	if (event.action == StorageOutputFileEvent::Action::Removed) {
+		if (iter != watched_drives_.end()) {
+			debug_out_info("app", "Watched output file " << event.file << " was removed.\n");
+			iconview_->remove_entry(iter->second.get());
+			drives_.erase(std::remove(drives_.begin(), drives_.end(), iter->second), drives_.end());
+			watched_drives_.erase(iter);
+			iconview_->update_menu_actions();
+			this->update_status_widgets();
+		}
+		return;
+	}
+
+	// Only this file is re-parsed. The drive emits signal_changed(), updating its icon and info window.
+	if (iter != watched_drives_.end()) {
+		static_cast<void>(load_watched_output(event.file, iter->second));
+		return;
+	}
+	if (auto drive = load_watched_output(event.file, nullptr)) {
+		watched_drives_.emplace(event.file, drive);
+		show_watched_drives();
+	}
+}
+
+
+
+StorageDevicePtr GscMainWindow::load_watched_output(const hz::fs::path& file, StorageDevicePtr drive)
+{
+	const int max_size = 10*1024*1024;  // 10M, after decompression
+	auto loaded = storage_output_load(file, max_size);
+	if (!loaded) {
+		debug_out_warn("app", "Cannot open watched output file " << file << ": " << loaded.error().message() << "\n");
+		return nullptr;
+	}
+	if (!drive) {
+		drive = std::make_shared<StorageDevice>(hz::fs_path_to_string(file), true);
+	}
+	drive->set_virtual_output(std::move(loaded.value()));
+
+	// This emits signal_changed()
+	if (auto parse_status = drive->parse_any_data_for_virtual(); !parse_status) {
+		debug_out_warn("app", "Cannot parse watched output file " << file << ": " << parse_status.error().message() << "\n");
+		return nullptr;
+	}
+	return drive;
+}
+
+
+
+void GscMainWindow::show_watched_drives()
+{
+	bool added = false;
+	for (const auto& [file, drive] : watched_drives_) {
+		if (std::find(drives_.begin(), drives_.end(), drive) == drives_.end()) {
+			drives_.push_back(drive);
+			iconview_->add_entry(drive);
+			added = true;
+		}
+	}
+	if (added) {
+		iconview_->update_menu_actions();
+		this->update_status_widgets();
+	}
+}
+
+
+
+void GscMainWindow::on_hotplug_event(const StorageHotplugEvent& event)
+{
+	pending_hotplug_events_.push_back(event);
+	if (hotplug_timeout_id_ == 0) {
+		// The kernel reports the devices before udev sets up their nodes and permissions,
+		// so wait a bit. This also merges the bursts of events when a bay is swapped.
+		hotplug_timeout_id_ = g_timeout_add(2000, &GscMainWindow::on_hotplug_timeout, this);
+	}
+}
+
+
+
+bool GscMainWindow::process_hotplug_events()
+{
+	// The running scan will see the changes anyway, but wait for it to finish
+	// to avoid modifying the drive list under it.
+	if (this->scanning_)
+		return true;
+
+	// Only the last event of each device matters
+	std::vector<StorageHotplugEvent> events;
+	for (auto iter = pending_hotplug_events_.rbegin(); iter != pending_hotplug_events_.rend(); ++iter) {
+		if (std::none_of(events.cbegin(), events.cend(), [&iter](const auto& e) { return e.device == iter->device; })) {
+			events.insert(events.begin(), *iter);
+		}
+	}
+	pending_hotplug_events_.clear();
+
+	std::vector<std::string> blacklist_patterns;
+	hz::string_split(rconfig::get_data<std::string>("system/device_blacklist_patterns"), ';', blacklist_patterns, true);
+
+	StorageDetector sd;
+	sd.add_blacklist_patterns(blacklist_patterns);
+
+	auto ex_factory = get_executor_factory();
+	bool changed = false;
+
+	// The executors iterate the main loop, don't allow a rescan meanwhile.
+	this->scanning_ = true;
+
+	for (const auto& event : events) {
+		auto existing = std::find_if(drives_.begin(), drives_.end(), [&event](const StorageDevicePtr& drive)
+		{
+			return !drive->get_is_virtual() && drive->get_device() == event.device;
+		});
+		if (existing != drives_.end() && (*existing)->get_test_is_active()) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Ignoring hotplug event for " << event.device << ", a test is running on it.\n");
+			continue;
+		}
+
+		if (event.action == StorageHotplugEvent::Action::Remove) {
+			if (existing != drives_.end()) {
+				debug_out_info("app", "Device " << event.device << " was removed.\n");
+				iconview_->remove_entry(existing->get());
+				drives_.erase(existing);
+				changed = true;
+			}
+			continue;
+		}
+
+		// Add: re-read the drive if we have it already (e.g. it was swapped faster than we noticed).
+		if (existing != drives_.end()) {
+			std::vector<StorageDevicePtr> tmp_drives = {*existing};
+			static_cast<void>(sd.fetch_basic_data(tmp_drives, ex_factory, true));  // emits signal_changed()
+			changed = true;
+			continue;
+		}
+
+		const std::string dev_base = hz::fs_path_to_string(hz::fs_path_from_string(event.device).filename());
+		if (is_ignored_device_linux(dev_base) || sd.is_blacklisted(event.device)) {
+			continue;
+		}
+
+		auto drive = std::make_shared<StorageDevice>(event.device);
+		std::vector<StorageDevicePtr> tmp_drives = {drive};
+		auto fetch_status = sd.fetch_basic_data(tmp_drives, ex_factory, true);
+		if (!fetch_status) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot read the hotplugged device " << event.device << ": "
+					<< fetch_status.error().message() << "\n");
+			continue;
+		}
+
+		// The full scan may have found it under another name (e.g. NVMe without the namespace).
+		const std::string serial = drive->get_serial_number();
+		const bool duplicate = !serial.empty() && std::any_of(drives_.cbegin(), drives_.cend(),
+				[&serial](const StorageDevicePtr& d) { return !d->get_is_virtual() && d->get_serial_number() == serial; });
+		if (duplicate) {
+			continue;
+		}
+
+		debug_out_info("app", "Device " << event.device << " was added.\n");
+		drives_.push_back(drive);
+		static const rconfig::Key<bool> smart_capable_only("gui/show_smart_capable_only");
+		if (!smart_capable_only.get()
+				|| drive->get_smart_status() != StorageDevice::SmartStatus::Unsupported) {
+			iconview_->add_entry(drive);
+		}
+		changed = true;
+	}
+
+	this->scanning_ = false;
+
+	if (changed) {
+		if (auto hwmon_monitor = storage_hwmon_temperature_get_global()) {
+			hwmon_monitor->clear_cache();
+		}
+		if (iconview_->get_num_icons() == 0)
+			iconview_->set_empty_view_message(GscMainWindowIconView::Message::NoDrivesFound);
+
+		if (rconfig::get_data<bool>("gui/use_drive_cache")) {
+			if (auto ec = storage_device_cache_save(storage_device_cache_get_default_file(), drives_)) {
+				debug_out_warn("app", DBG_FUNC_MSG << "Cannot save drive cache: " << ec.message() << "\n");
+			}
+		}
+
+		iconview_->update_menu_actions();
+		this->update_status_widgets();
+	}
+
+	return false;
+}
+
+
+
+gboolean GscMainWindow::on_hotplug_timeout(gpointer data)
+{
+	auto* self = static_cast<GscMainWindow*>(data);
+	// More events may have arrived while processing
+	if (self->process_hotplug_events() || !self->pending_hotplug_events_.empty()) {
+		return TRUE;  // call again later
+	}
+	self->hotplug_timeout_id_ = 0;
+	return FALSE;
+}
+
+
+
+gboolean GscMainWindow::on_memory_budget_timeout(gpointer data)
+{
+	auto* self = static_cast<GscMainWindow*>(data);
+	// The attribute comparison shows the attributes of all the drives
+	const auto matrix_win = GscAttributeMatrixWindow::instance();
+	if (self->scanning_ || !self->iconview_ || (matrix_win && matrix_win->get_visible())) {
+		return TRUE;
+	}
+	const std::size_t compacted = self->memory_budget_.enforce(self->iconview_->get_drives(), [](const StorageDevice& drive) {
+		return GscInfoWindow::get_drive_shown(&drive);
+	});
+	if (compacted > 0) {
+		debug_out_info("app", DBG_FUNC_MSG << "Compacted the data of " << compacted << " drives to fit the memory budget.\n");
+	}
+	return TRUE;
+}
+
+
+
+void GscMainWindow::restore_drive_data(const std::vector<StorageDevicePtr>& drives)
+{
+	for (const auto& drive : drives) {
+		if (drive && drive->get_data_compacted()) {
+			if (auto status = drive->restore_compacted_data(); !status) {
+				debug_out_warn("app", DBG_FUNC_MSG << status.error().message() << "\n");
+			}
+		}
+	}
+}
+
+
+
+void GscMainWindow::on_drive_temperature_sampled(StorageDevice* drive)
+{
+	iconview_->refresh_entry(drive);  // nothing is done if the displayed temperature didn't change
+}
+
+
+
+void GscMainWindow::on_io_performance_sampled()
+{
+	for (const auto& drive : drives_) {
+		if (drive->get_is_virtual()) {
+			continue;
+		}
+		iconview_->refresh_entry(drive.get());  // nothing is done if the displayed values didn't change
+	}
+}
+
 
+
+void GscMainWindow::on_drive_properties_changed(StorageDevice* drive, const StoragePropertyDiff& diff)
+{
+	auto iter = risk_ranking_drives_.find(drive);
+	if (iter == risk_ranking_drives_.end()) {
+		return;
+	}
+	// The first differences after connecting may be relative to nothing (see
+	// StorageDevice::signal_properties_changed()), so the score is computed in full once.
+	bool changed = false;
+	if (!iter->second.diff_received) {
+		iter->second.diff_received = true;
+		changed = risk_ranking_.update(drive, drive->get_snapshot()->property_repository);
 	} else {
-		this->drives_.push_back(drive);
-		this->iconview_->add_entry(drive, true);  // add it, scroll and select it.
+		changed = risk_ranking_.apply_diff(drive, diff);
 	}
+	if (changed) {
+		update_risk_ranking_label();
+	}
+}
 
-	return true;
+
+
+void GscMainWindow::on_drive_filter_changed()
+{
+	WarningLevel min_level = WarningLevel::None;
+	for (const auto& filter : main_window_get_warning_filters()) {
+		if (drive_filter_warning_combo_->get_active_id() == filter.id) {
+			min_level = filter.level;
+		}
+	}
+	iconview_->set_filter(StorageDeviceFilter::create(drive_filter_entry_->get_text().raw(), min_level));
 }
 
 
 
-bool GscMainWindow::add_virtual_drive(const std::string& file)
+void GscMainWindow::on_drive_grouping_changed()
 {
-	std::string output;
-	const int max_size = 10*1024*1024;  // 10M
-	auto ec = hz::fs_file_get_contents(hz::fs_path_from_string(file), output, max_size);
-	if (ec) {
-		debug_out_warn("app", "Cannot open virtual drive file \"" << file << "\": " << ec.message() << "\n");
-		gui_show_error_dialog(_("Cannot load data file"), ec.message(), this);
-		return false;
+	for (const auto& grouping : main_window_get_groupings()) {
+		if (drive_grouping_combo_->get_active_id() == grouping.id) {
+			rconfig::set_data("gui/icons_grouping", std::string(grouping.id));
+			iconview_->set_grouping(grouping.grouping);
+		}
 	}
+}
 
-	// we have to use smart pointers here, because a pointer may be invalidated
-	// on vector reallocation
-	auto drive = std::make_shared<StorageDevice>(file, true);
 
-	drive->set_full_output(output);
-	drive->set_info_output(output);  // info can be parsed from full output string too.
 
-	// this will set the type and add the properties
-	auto parse_error = drive->parse_any_data_for_virtual();
-	if (!parse_error) {
-		gui_show_error_dialog(_("Cannot interpret SMART data"), parse_error.error().message(), this);
+void GscMainWindow::reset_drive_filter()
+{
+	drive_filter_entry_->set_text("");
+	drive_filter_warning_combo_->set_active_id(main_window_get_warning_filters().front().id);
+	iconview_->set_filter(StorageDeviceFilter());  // don't wait for the delayed search-changed signal
+}
+
+
+
+void GscMainWindow::run_bulk_operation(StorageBulkOperation operation)
+{
+	if (!iconview_ || scanning_)
+		return;
+	const std::vector<StorageDevicePtr> drives = iconview_->get_selected_drives();
+	if (drives.empty())
+		return;
+	restore_drive_data(drives);
+
+	hz::fs::path output_dir;
+	if (operation == StorageBulkOperation::SaveOutput) {
+		static std::string last_dir;
+		if (last_dir.empty()) {
+			last_dir = rconfig::get_data<std::string>("gui/drive_data_open_save_dir");
+		}
+		const std::string dir = main_window_choose_directory(*this, _("Save Data To Directory..."), last_dir);
+		if (dir.empty())
+			return;
+		rconfig::set_data("gui/drive_data_open_save_dir", last_dir);
+		output_dir = hz::fs_path_from_string(dir);
+	}
+
+	// A single (modal) progress dialog for all the drives. The executors don't show their own dialogs.
+	Gtk::Dialog dialog(storage_bulk_get_displayable_name(operation), *this, true);
+	dialog.set_deletable(false);
+	dialog.set_default_size(350, -1);
+	Gtk::ProgressBar progress_bar;
+	progress_bar.set_show_text(true);
+	progress_bar.set_text(Glib::ustring::compose(_("%1 of %2 drives"), 0, drives.size()));
+	progress_bar.set_margin_start(12);
+	progress_bar.set_margin_end(12);
+	progress_bar.set_margin_top(12);
+	progress_bar.set_margin_bottom(12);
+	dialog.get_content_area()->pack_start(progress_bar, true, true);
+	dialog.show_all();
+
+	this->scanning_ = true;  // the main loop is iterated meanwhile, don't allow a rescan.
+	const auto max_parallel = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("gui/bulk_operations_max_parallel")));
+	const std::vector<StorageBulkResult> results = storage_bulk_run(operation, drives, get_executor_factory(),
+			max_parallel, output_dir, [&progress_bar](std::size_t finished, std::size_t total)
+	{
+		progress_bar.set_fraction(total > 0 ? static_cast<double>(finished) / static_cast<double>(total) : 1.);
+		progress_bar.set_text(Glib::ustring::compose(_("%1 of %2 drives"), finished, total));
+	});
+	this->scanning_ = false;
+	dialog.hide();
+
+	// The icons are updated through the drives' signal_changed callbacks.
+	iconview_->update_menu_actions();
+	this->update_status_widgets();
+
+	if (const std::string errors = storage_bulk_format_errors(results); !errors.empty()) {
+		gsc_executor_error_dialog_show(Glib::ustring::compose(_("%1: the operation failed on some of the drives"),
+				storage_bulk_get_displayable_name(operation)), errors, this, false, false);
+	}
+}
+
+
+
+void GscMainWindow::run_bulk_short_test()
+{
+	if (!iconview_ || bulk_test_fleet_)
+		return;
+	std::vector<StorageDevicePtr> drives = iconview_->get_selected_drives();
+	drives.erase(std::remove_if(drives.begin(), drives.end(),
+			[](const StorageDevicePtr& drive) { return !main_window_get_can_start_bulk_test(drive); }), drives.end());
+	if (drives.empty())
+		return;
+
+	// SelfTestFleet keeps the tests on the same controller / in the same enclosure from piling up.
+	SelfTestFleet::Limits limits;
+	limits.max_running = static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/fleet_selftest_max_running")));
+	limits.max_per_controller = static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/fleet_selftest_max_per_controller")));
+	limits.max_per_enclosure = static_cast<std::size_t>(std::max(0, rconfig::get_data<int>("system/fleet_selftest_max_per_enclosure")));
+	limits.max_parallel_commands = static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/fleet_selftest_max_parallel_commands")));
+
+	// Not the gsmartcontrol-selftest state file, so that its runs are not disturbed. This is a new run,
+	// nothing is loaded from it.
+	const hz::fs::path state_file = SelfTestFleet::get_default_state_file().parent_path() / "selftest_bulk.json";
+	bulk_test_fleet_ = std::make_unique<SelfTestFleet>(SelfTest::TestType::ShortTest, limits, state_file);
+	bulk_test_fleet_->set_drives(drives);
+	bulk_test_drives_ = std::move(drives);
+
+	this->poll_bulk_short_test();
+}
+
+
+
+bool GscMainWindow::poll_bulk_short_test()
+{
+	if (!bulk_test_fleet_)
 		return false;
+
+	// The tests are started and polled in worker threads, which must not emit signal_changed().
+	for (const auto& drive : bulk_test_drives_) {
+		drive->begin_worker_fetch();
+	}
+	const bool running = bulk_test_fleet_->run_once(command_executor_factory_for_worker_threads(get_executor_factory()));
+	for (const auto& drive : bulk_test_drives_) {
+		drive->end_worker_fetch();  // updates the icons
+	}
+	if (iconview_) {
+		iconview_->update_menu_actions();
+		this->update_status_widgets();
 	}
 
-	this->drives_.push_back(drive);
+	if (running) {
+		const auto poll_in = std::max(std::chrono::seconds(1), bulk_test_fleet_->get_next_poll_in());
+		bulk_test_timeout_id_ = g_timeout_add_seconds(static_cast<guint>(poll_in.count()),
+				&GscMainWindow::on_bulk_short_test_timeout, this);
+		return true;
+	}
 
-	this->iconview_->add_entry(drives_.back(), true);  // add it, scroll and select it.
+	// All done, show the results of all the drives at once.
+	std::string results;
+	bool failed = false;
+	for (const auto& job : bulk_test_fleet_->get_jobs()) {
+		results += job.device + ": ";
+		if (job.state == SelfTestFleetJobState::Failed) {
+			results += job.error;
+			failed = true;
+		} else {
+			results += SelfTestStatusExt::get_displayable_name(job.result);
+			failed = failed || (job.result != SelfTestStatus::CompletedNoError);
+		}
+		results += "\n";
+	}
+	bulk_test_fleet_.reset();
+	bulk_test_drives_.clear();
+	if (iconview_) {
+		iconview_->update_menu_actions();
+	}
 
-	return true;
+	if (failed) {
+		gui_show_error_dialog(_("Some of the short self-tests failed"), results, this);
+	} else {
+		gui_show_info_dialog(_("The short self-tests completed successfully"), results, this);
+	}
+	return false;
+}
+
+
+
+gboolean GscMainWindow::on_bulk_short_test_timeout(gpointer data)
+{
+	auto* self = static_cast<GscMainWindow*>(data);
+	self->bulk_test_timeout_id_ = 0;
+	self->poll_bulk_short_test();  // schedules the next poll
+	return FALSE;
 }
 
 
 
+CommandExecutorFactoryPtr GscMainWindow::get_executor_factory()
+{
+	// The executors are kept between the scans, together with their output buffers.
+	if (!ex_factory_) {
+		ex_factory_ = std::make_shared<CommandExecutorFactoryGui>(this);  // pass this as dialog parent
+		ex_factory_->set_pooled(true);
+	}
+	return ex_factory_;
+}
+
+
 
 bool GscMainWindow::testing_active() const
 {
@@ -1043,8 +2525,8 @@ std::shared_ptr<GscInfoWindow> GscMainWindow::show_device_info_window(const Stor
 		}
 
 		if (status == Gtk::RESPONSE_YES) {
-			std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-			ex->create_running_dialog(this, Glib::ustring::compose(_("Running {command} on %1..."), drive->get_device_with_type()));
+			auto ex = get_executor_factory()->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+			ex->set_running_msg(Glib::ustring::compose(_("Running {command} on %1..."), drive->get_device_with_type()));
 			auto command_status = drive->set_smart_enabled(true, ex);  // run it with GUI support
 
 			if (!command_status) {
@@ -1054,11 +2536,19 @@ std::shared_ptr<GscInfoWindow> GscMainWindow::show_device_info_window(const Stor
 	}
 
 
+	// A background fetch (e.g. a prefetch) is running, its data is as good as ours.
+	while (drive->get_fetch_in_progress()) {
+		Gtk::Main::iteration();
+	}
+	memory_budget_.touch(drive.get());
+	restore_drive_data({drive});
+
 	// Virtual drives are parsed at load time.
-	// Parse non-virtual, smart-supporting drives here.
-	if (!drive->get_is_virtual() && drive->get_smart_status() != StorageDevice::SmartStatus::Unsupported) {
-		std::shared_ptr<SmartctlExecutorGui> ex(new SmartctlExecutorGui());
-		ex->create_running_dialog(this, Glib::ustring::compose(_("Running {command} on %1..."), drive->get_device_with_type()));
+	// Parse non-virtual, smart-supporting drives here, unless they were fetched recently (e.g. prefetched).
+	if (!drive->get_is_virtual() && drive->get_smart_status() != StorageDevice::SmartStatus::Unsupported
+			&& !prefetcher_->get_data_fresh(*drive)) {
+		auto ex = get_executor_factory()->create_executor(CommandExecutorFactory::ExecutorType::Smartctl);
+		ex->set_running_msg(Glib::ustring::compose(_("Running {command} on %1..."), drive->get_device_with_type()));
 		auto command_status = drive->fetch_full_data_and_parse(ex);  // run it with GUI support
 
 		if (!command_status) {
@@ -1078,9 +2568,10 @@ std::shared_ptr<GscInfoWindow> GscMainWindow::show_device_info_window(const Stor
 	}
 
 
-	auto win = GscInfoWindow::create();  // self-destroyed
+	auto win = GscInfoWindow::acquire();  // self-destroyed or returned to the pool on close
 
 	win->set_drive(drive);
+	win->set_refresh_scheduler(refresh_scheduler_);
 	win->fill_ui_with_info(false);  // already scanned. "refresh" will scan it again in the info window.
 
 	// win->set_transient_for(*this);  // for "destroy with parent", always-on-top
@@ -1103,6 +2594,179 @@ void GscMainWindow::show_prefs_updated_message()
 
 
 
+void GscMainWindow::update_attribute_matrix_window()
+{
+	if (attribute_matrix_update_pending_) {
+		return;
+	}
+	attribute_matrix_update_pending_ = true;
+	Glib::signal_idle().connect_once([this]() {
+		attribute_matrix_update_pending_ = false;
+		const std::vector<StorageDevicePtr> drives = iconview_->get_drives();
+		set_risk_ranking_drives(drives);
+		if (auto win = GscAttributeMatrixWindow::instance(); win && win->get_visible()) {
+			win->set_drives(drives);
+		}
+	});
+}
+
+
+
+void GscMainWindow::set_risk_ranking_drives(const std::vector<StorageDevicePtr>& drives)
+{
+	std::unordered_set<const StorageDevice*> new_drives;
+	for (const auto& drive : drives) {
+		if (drive) {
+			new_drives.insert(drive.get());
+		}
+	}
+
+	bool changed = false;
+	for (auto iter = risk_ranking_drives_.begin(); iter != risk_ranking_drives_.end(); ) {
+		if (!new_drives.contains(iter->first)) {
+			iter->second.properties_changed_connection.disconnect();
+			risk_ranking_.remove(iter->first);
+			iter = risk_ranking_drives_.erase(iter);
+			changed = true;
+		} else {
+			++iter;
+		}
+	}
+
+	for (const auto& drive : drives) {
+		if (drive && !risk_ranking_drives_.contains(drive.get())) {
+			RiskRankingDrive& info = risk_ranking_drives_[drive.get()];
+			info.drive = drive;
+			info.properties_changed_connection = drive->signal_properties_changed().connect(
+					sigc::mem_fun(this, &GscMainWindow::on_drive_properties_changed));
+			risk_ranking_.update(drive.get(), drive->get_snapshot()->property_repository);
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		update_risk_ranking_label();
+	}
+}
+
+
+
+void GscMainWindow::update_risk_ranking_label()
+{
+	if (!at_risk_label_) {
+		return;
+	}
+	constexpr std::size_t max_shown_drives = 5;
+
+	std::vector<std::string> texts;
+	for (const auto& entry : risk_ranking_.get_top(max_shown_drives)) {
+		auto iter = risk_ranking_drives_.find(entry.drive);
+		if (iter != risk_ranking_drives_.end()) {
+			/// Translators: %1 is a device name, %2 is its risk score
+			texts.emplace_back(Glib::ustring::compose(_("%1 (score %2)"),
+					iter->second.drive->get_device_with_type(), hz::number_to_string_locale(entry.score)));
+		}
+	}
+	at_risk_label_->set_text(texts.empty() ? Glib::ustring(_("None")) : Glib::ustring(hz::string_join(texts, ", ")));
+}
+
+
+
+void GscMainWindow::apply_prefs_changes(const AppDriveSettings& old_settings)
+{
+	const AppDriveSettingsDelta delta = app_drive_settings_compare(old_settings, AppDriveSettings::get_current());
+	if (delta.is_empty()) {
+		return;
+	}
+	// The running scan uses the old settings, and the drives detected with a different
+	// smartctl may not be valid anymore.
+	if (delta.rescan || this->scanning_) {
+		show_prefs_updated_message();
+		return;
+	}
+
+	std::vector<StorageDevicePtr> fetch_drives;  // drives to re-read with the new settings
+	std::vector<StorageDevicePtr> added_drives;  // not blacklisted anymore
+
+	StorageDetector sd;
+	if (delta.blacklist) {
+		std::vector<std::string> blacklist_patterns;
+		hz::string_split(AppDriveSettings::get_current().blacklist_patterns, ';', blacklist_patterns, true);
+		sd.add_blacklist_patterns(blacklist_patterns);
+
+		for (auto iter = drives_.begin(); iter != drives_.end(); ) {
+			const StorageDevicePtr drive = *iter;
+			if (!drive->get_is_virtual() && !drive->get_test_is_active() && sd.is_blacklisted(drive->get_device())) {
+				debug_out_info("app", "Device " << drive->get_device_with_type() << " is blacklisted now, removing it.\n");
+				iconview_->remove_entry(drive.get());
+				blacklisted_drives_.push_back(drive);
+				iter = drives_.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+		for (auto iter = blacklisted_drives_.begin(); iter != blacklisted_drives_.end(); ) {
+			if (!sd.is_blacklisted((*iter)->get_device())) {
+				added_drives.push_back(*iter);
+				iter = blacklisted_drives_.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+		fetch_drives = added_drives;
+	}
+
+	for (const auto& key : delta.device_options) {
+		for (const auto& drive : drives_) {
+			if (!drive->get_is_virtual() && !drive->get_test_is_active()
+					&& app_device_options_key_matches(key, drive->get_device(), drive->get_type_argument())
+					&& std::find(fetch_drives.cbegin(), fetch_drives.cend(), drive) == fetch_drives.cend()) {
+				fetch_drives.push_back(drive);
+			}
+		}
+	}
+
+	if (!fetch_drives.empty()) {
+		debug_out_info("app", DBG_FUNC_MSG << "Re-reading " << fetch_drives.size() << " drive(s) affected by the preferences.\n");
+		sd.set_max_parallel_fetches(static_cast<std::size_t>(std::max(1, rconfig::get_data<int>("system/smartctl_max_parallel_fetches"))));
+		this->scanning_ = true;  // the executors iterate the main loop, don't allow a rescan meanwhile.
+		static_cast<void>(sd.fetch_basic_data(fetch_drives, get_executor_factory()));  // emits signal_changed()
+		this->scanning_ = false;
+	}
+
+	const bool smart_capable_only = rconfig::get_data<bool>("gui/show_smart_capable_only");
+	auto should_show = [smart_capable_only](const StorageDevicePtr& drive)
+	{
+		return !smart_capable_only || drive->get_smart_status() != StorageDevice::SmartStatus::Unsupported;
+	};
+	drives_.insert(drives_.end(), added_drives.begin(), added_drives.end());
+	if (delta.visibility || !added_drives.empty()) {
+		iconview_->update_entries(drives_, should_show);
+	}
+	if (delta.icon_text) {
+		for (const auto& drive : drives_) {
+			iconview_->refresh_entry(drive.get());
+		}
+	}
+
+	if (iconview_->get_num_icons() == 0) {
+		iconview_->set_empty_view_message(GscMainWindowIconView::Message::NoDrivesFound);
+	}
+	if ((delta.blacklist || !fetch_drives.empty()) && rconfig::get_data<bool>("gui/use_drive_cache")) {
+		if (auto ec = storage_device_cache_save(storage_device_cache_get_default_file(), drives_)) {
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot save drive cache: " << ec.message() << "\n");
+		}
+	}
+	if (auto hwmon_monitor = storage_hwmon_temperature_get_global(); hwmon_monitor && (delta.blacklist || !fetch_drives.empty())) {
+		hwmon_monitor->clear_cache();
+	}
+
+	iconview_->update_menu_actions();
+	this->update_status_widgets();
+}
+
+
+
 void GscMainWindow::show_add_device_chooser()
 {
 	auto window = GscAddDeviceWindow::create();
@@ -1134,28 +2798,59 @@ bool GscMainWindow::check_smartctl_version_and_set_format()
 // 		if (!smartctl_def_options.empty())
 // 			smartctl_def_options += " ";
 
-		SmartctlExecutorGui ex;
-		ex.create_running_dialog(this);
-		ex.set_running_msg(_("Checking if smartctl is executable..."));
+		std::optional<SmartctlVersionInfo> version_info;
 
-		ex.set_command(smartctl_binary, {"-V"});  // --version
-
-		if (!ex.execute() || !ex.get_error_msg().empty()) {
-			error_msg = ex.get_error_msg();
-			break;
+		// On startup, the version is probed in the background while the windows are built
+		if (auto probed = smartctl_version_probe_take(hz::fs_path_from_string(smartctl_binary)); probed.has_value()) {
+			if (!probed->info.has_value()) {
+				error_msg = probed->error_msg;
+				break;
+			}
+			version_info = probed->info;
+			debug_out_info("app", "Using the " << (probed->from_cache ? "cached" : "probed") << " smartctl version: "
+					<< version_info->version_full << "\n");
 		}
 
-		const std::string output = ex.get_stdout_str();
-		if (output.empty()) {
-			error_msg = _("Smartctl returned an empty output.");
-			break;
+		// Spawning smartctl may be slow, so skip it if the binary hasn't changed since the last time.
+		std::optional<SmartctlBinaryStamp> binary_stamp;
+		if (!version_info.has_value()) {
+			binary_stamp = smartctl_version_cache_get_stamp(hz::fs_path_from_string(smartctl_binary));
+			if (binary_stamp.has_value()) {
+				version_info = smartctl_version_cache_lookup(binary_stamp.value());
+			}
+			if (version_info.has_value()) {
+				debug_out_info("app", "Using the cached smartctl version: " << version_info->version_full << "\n");
+			}
 		}
 
-		std::string version, version_full;
-		if (!SmartctlVersionParser::parse_version_text(output, version, version_full)) {
-			error_msg = _("Smartctl returned invalid output.");
-			break;
+		if (!version_info.has_value()) {
+			SmartctlExecutorGui ex;
+			ex.create_running_dialog(this);
+			ex.set_running_msg(_("Checking if smartctl is executable..."));
+
+			ex.set_command(smartctl_binary, {"-V"});  // --version
+
+			if (!ex.execute() || !ex.get_error_msg().empty()) {
+				error_msg = ex.get_error_msg();
+				break;
+			}
+
+			const std::string output = ex.get_stdout_str();
+			if (output.empty()) {
+				error_msg = _("Smartctl returned an empty output.");
+				break;
+			}
+
+			version_info = SmartctlVersionInfo();
+			if (!SmartctlVersionParser::parse_version_text(output, version_info->version, version_info->version_full)) {
+				error_msg = _("Smartctl returned invalid output.");
+				break;
+			}
+			if (binary_stamp.has_value()) {
+				smartctl_version_cache_store(binary_stamp.value(), version_info.value());
+			}
 		}
+		const std::string& version = version_info->version;
 
 		// Check smartctl runtime version
 		if (double version_double = 0; hz::string_is_numeric_nolocale<double>(version, version_double, false)) {
@@ -1201,6 +2896,8 @@ void GscMainWindow::show_load_virtual_file_chooser()
 	specific_filter->set_name(_("JSON and Text Files"));
 	specific_filter->add_pattern("*.json");
 	specific_filter->add_pattern("*.txt");
+	specific_filter->add_pattern("*.json.gz");
+	specific_filter->add_pattern("*.txt.gz");
 
 	Glib::RefPtr<Gtk::FileFilter> all_filter = Gtk::FileFilter::create();
 	all_filter->set_name(_("All Files"));
@@ -1265,7 +2962,13 @@ void GscMainWindow::show_load_virtual_file_chooser()
 			rconfig::set_data("gui/drive_data_open_save_dir", last_dir);
 			for (const auto& file : files) {
 				std::error_code ec;
-				if (!hz::fs::is_directory(hz::fs_path_from_string(file), ec)) {  // file chooser returns selected directories as well, ignore them.
+				const hz::fs::path path = hz::fs_path_from_string(file);
+				if (hz::fs::is_directory(path, ec)) {  // file chooser returns selected directories as well, ignore them.
+					continue;
+				}
+				if (hz::string_to_lower_copy(hz::fs_path_to_string(path.extension())) == ".tar") {
+					this->import_virtual_drives(file);
+				} else {
 					this->add_virtual_drive(file);
 				}
 			}
@@ -1284,6 +2987,21 @@ void GscMainWindow::show_load_virtual_file_chooser()
 
 
 
+void GscMainWindow::show_load_virtual_directory_chooser()
+{
+	static std::string last_dir;
+	if (last_dir.empty()) {
+		last_dir = rconfig::get_data<std::string>("gui/drive_data_open_save_dir");
+	}
+	const std::string dir = main_window_choose_directory(*this, _("Load Data From Directory..."), last_dir);
+	if (!dir.empty()) {
+		rconfig::set_data("gui/drive_data_open_save_dir", last_dir);
+		this->import_virtual_drives(dir);
+	}
+}
+
+
+
 void GscMainWindow::quit_requested()
 {
 	// if at least one drive is having a test performed, disallow.
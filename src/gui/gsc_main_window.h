@@ -12,11 +12,27 @@ Copyright:
 #ifndef GSC_MAIN_WINDOW_H
 #define GSC_MAIN_WINDOW_H
 
+#include <cstddef>  // std::size_t
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <gtkmm.h>
 
 #include "applib/app_builder_widget.h"
+#include "applib/app_cancellation.h"
+#include "applib/command_executor_factory.h"
+#include "applib/selftest_fleet.h"
+#include "applib/storage_bulk_operation.h"
 #include "applib/storage_device.h"
+#include "applib/storage_drivedb.h"
+#include "applib/storage_hotplug_monitor.h"
+#include "applib/storage_inventory.h"
+#include "applib/storage_memory_budget.h"
+#include "applib/storage_output_watcher.h"
+#include "applib/storage_risk_ranking.h"
+#include "applib/storage_settings.h"
+#include "applib/storage_virtual_import.h"
 
 
 
@@ -24,6 +40,10 @@ class GscMainWindowIconView;  // defined in gsc_main_window_iconview.h
 
 class GscInfoWindow;  // declared in gsc_info_window.h
 
+class GscRefreshScheduler;  // declared in gsc_refresh_scheduler.h
+
+class GscPrefetcher;  // declared in gsc_prefetcher.h
+
 
 
 /// The main window.
@@ -44,22 +64,50 @@ class GscMainWindow : public AppBuilderWidget<GscMainWindow, false> {
 		virtual ~GscMainWindow();
 
 
-		/// Scan for devices and fill the iconview
+		/// Scan for devices and fill the iconview. If a scan is already running, it's cancelled
+		/// and a new one is started as soon as it stops.
 		void rescan_devices(bool startup);
 
+		/// Query the drives listed in a drive inventory file (see storage_inventory.h) instead of
+		/// scanning for them. If "system/inventory_reconcile" is set, a scan follows in background.
+		/// \return false if the inventory cannot be loaded.
+		bool load_inventory_drives(const std::string& file);
 
-		/// Execute update-smart-drivedb
+
+		/// Execute update-smart-drivedb. It runs in a terminal window; when it exits,
+		/// apply_drivedb_changes() is called with the drive database entries it changed.
 		void run_update_drivedb();
 
+		/// Re-read the drives matching the changed drive database entries (their attribute names,
+		/// presets, etc. may be different now), and re-parse the outputs of the others without
+		/// running smartctl.
+		void apply_drivedb_changes(const std::vector<StorageDriveDbEntry>& changed_entries);
+
 
 		/// Manually add device file to icon list
 		bool add_device(const std::string& file, const std::string& type_arg, const std::vector<std::string>& extra_args);
 
 
+		/// Add a drive of a remote host (e.g. opened in the fleet view) to the icon list and show
+		/// its info window. If the drive is already in the list, just show it.
+		bool open_remote_drive(const StorageDevicePtr& drive);
+
+
 		/// Read smartctl data from file, add it as a virtual drive to icon list
 		bool add_virtual_drive(const std::string& file);
 
 
+		/// Add already parsed virtual drives to the icon list
+		void add_virtual_drives(const std::vector<StorageDevicePtr>& drives);
+
+
+		/// Load all smartctl outputs in a directory or a tar archive as virtual drives (see
+		/// storage_virtual_import()), and show the first page of them (highest warnings first).
+		/// The files are loaded in a worker thread; this returns immediately. If an import is
+		/// already running, this one replaces it when it finishes.
+		void import_virtual_drives(const std::string& path);
+
+
 		/// If at least one drive is having a test performed, return true.
 		bool testing_active() const;
 
@@ -70,6 +118,16 @@ class GscMainWindow : public AppBuilderWidget<GscMainWindow, false> {
 		/// Show "Preferences updated, please rescan" message
 		void show_prefs_updated_message();
 
+		/// Update the drives of the "Compare Attributes" window (if it's shown) and of the
+		/// most at-risk drives list with the drives of the icon view. This is called after
+		/// the icon view entries change, and runs once in idle time.
+		void update_attribute_matrix_window();
+
+		/// Apply the changed preferences to the affected drives only: re-apply the blacklist,
+		/// re-fetch the drives whose per-device options changed, update the icons.
+		/// If everything has to be detected again, show_prefs_updated_message() is called.
+		void apply_prefs_changes(const AppDriveSettings& old_settings);
+
 
 	protected:
 
@@ -85,9 +143,20 @@ class GscMainWindow : public AppBuilderWidget<GscMainWindow, false> {
 			action_remove_virtual_device,
 			action_add_device,
 			action_load_virtual,
+			action_load_virtual_directory,
+			action_find_imported_drives,
 			action_rescan_devices,
 
+			action_bulk_enable_smart,
+			action_bulk_reread_data,
+			action_bulk_short_test,
+			action_bulk_save_output,
+			action_compare_attributes,
+			action_compare_snapshots,
+			action_fleet_view,
+
 			action_executor_log,
+			action_diagnostics,
 			action_update_drivedb,
 			action_preferences,
 
@@ -100,12 +169,21 @@ class GscMainWindow : public AppBuilderWidget<GscMainWindow, false> {
 		/// Enable/disable items in Drive menu, set toggles in menu items
 		void set_drive_menu_status(const StorageDevicePtr& drive);
 
+		/// Enable/disable items in "Selected Drives" menu
+		void set_selection_menu_status(const std::vector<StorageDevicePtr>& drives);
+
 		/// Get popup menu for a drive
 		[[nodiscard]] Gtk::Menu* get_popup_menu(const StorageDevicePtr& drive);
 
 		/// Update status widgets (status area, etc.)
 		void update_status_widgets();
 
+		/// Follow the risk scores of the given drives, forgetting the others
+		void set_risk_ranking_drives(const std::vector<StorageDevicePtr>& drives);
+
+		/// Update the "Most at-risk drives" status label
+		void update_risk_ranking_label();
+
 
 		/// Create the widgets - iconview, gtkuimanager stuff (menus), custom labels
 		bool create_widgets();
@@ -113,12 +191,30 @@ class GscMainWindow : public AppBuilderWidget<GscMainWindow, false> {
 		/// scan and populate iconview widget with drive icons
 		void populate_iconview_on_startup(bool smartctl_valid);
 
+		/// Scan for drives and compare them with the inventory loaded by load_inventory_drives().
+		/// The drives missing from the inventory are added, the inventory drives not found are reported.
+		void reconcile_inventory(const std::vector<StorageInventoryEntry>& entries);
+
 		/// Show "Add Device" window
 		void show_add_device_chooser();
 
 		/// Show "Load Virtual File" dialog
 		void show_load_virtual_file_chooser();
 
+		/// Show "Load Virtual Files from Directory" dialog
+		void show_load_virtual_directory_chooser();
+
+		/// Ask for a search text and show the matching imported drives
+		void show_find_imported_drives_dialog();
+
+		/// Called in the main context when import_virtual_drives() has loaded the files
+		void on_virtual_drives_imported(hz::ExpectedValue<VirtualDriveImportResult, VirtualDriveImportError>& import_result);
+
+		/// Replace the shown imported drives with the first page of the ones matching
+		/// \c text (see VirtualDriveIndex::find()).
+		/// \return the number of matching drives.
+		std::size_t show_imported_drives(const std::string& text, WarningLevel min_level);
+
 
 		/// Check smartctl version and set default parser format accordingly.
 		/// An error dialog is shown if there is an error with smartctl.
@@ -154,22 +250,148 @@ class GscMainWindow : public AppBuilderWidget<GscMainWindow, false> {
 		void on_action_reread_device_data();
 
 
+		/// Queue a hotplug event for processing. The events are processed after a short
+		/// delay, so that the device nodes are ready and the bursts are coalesced.
+		void on_hotplug_event(const StorageHotplugEvent& event);
+
+		/// Process the queued hotplug events: add, remove or re-read only the affected drives.
+		/// \return false if the events were processed, true if they have to be retried later.
+		bool process_hotplug_events();
+
+		/// Timeout callback for process_hotplug_events()
+		static gboolean on_hotplug_timeout(gpointer data);
+
+		/// Start watching a directory of smartctl outputs written by other programs ("gui/watch_output_directory"),
+		/// showing each output file as a virtual drive.
+		void start_output_watcher(const hz::fs::path& dir);
+
+		/// Re-parse, add or remove the virtual drive of a changed file in the watched directory
+		void on_output_file_event(const StorageOutputFileEvent& event);
+
+		/// Load (or reload, if \c drive is not nullptr) a watched output file into a virtual drive.
+		/// \return nullptr on error.
+		StorageDevicePtr load_watched_output(const hz::fs::path& file, StorageDevicePtr drive);
+
+		/// Add the drives of the watched directory to the drive list and the icon view, if not there.
+		/// Used after the scans, which remove the virtual drives.
+		void show_watched_drives();
+
+		/// Timeout callback, compacts the least recently viewed drives if they take too much memory
+		static gboolean on_memory_budget_timeout(gpointer data);
+
+		/// Restore the compacted data (see StorageMemoryBudget) of the drives about to be used in full
+		void restore_drive_data(const std::vector<StorageDevicePtr>& drives);
+
+		/// Update the icon tooltip of a drive with a new hwmon temperature sample
+		void on_drive_temperature_sampled(StorageDevice* drive);
+
+		/// Update the I/O performance texts of the icons with a new /proc/diskstats sample
+		void on_io_performance_sampled();
+
+		/// Update the risk score of a drive from the differences of its properties
+		void on_drive_properties_changed(StorageDevice* drive, const StoragePropertyDiff& diff);
+
+		/// Callback for the filter bar search entry and warning level combobox
+		void on_drive_filter_changed();
+
+		/// Callback for the filter bar grouping combobox
+		void on_drive_grouping_changed();
+
+		/// Clear the filter bar, showing all the drives
+		void reset_drive_filter();
+
+
+		/// Run a bulk operation on the selected drives, showing a progress dialog and
+		/// a single dialog with all the errors.
+		void run_bulk_operation(StorageBulkOperation operation);
+
+		/// Start a short self-test on the selected drives (see SelfTestFleet).
+		/// The results are shown in a single dialog when all the tests are finished.
+		void run_bulk_short_test();
+
+		/// Poll the bulk self-tests started by run_bulk_short_test()
+		bool poll_bulk_short_test();
+
+		/// Child watch callback of run_update_drivedb()
+		void on_update_drivedb_finished(Glib::Pid pid, int child_status);
+
+		/// Timeout callback for poll_bulk_short_test()
+		static gboolean on_bulk_short_test_timeout(gpointer data);
+
+
+		/// Get the (pooled) GUI executor factory used for scanning and adding the drives, and for
+		/// the other smartctl commands of the main window
+		CommandExecutorFactoryPtr get_executor_factory();
+
+
 	private:
 
 		GscMainWindowIconView* iconview_ = nullptr;  ///< The main icon view
 		std::vector<StorageDevicePtr> drives_;  ///< Scanned drives
+		std::vector<StorageDevicePtr> blacklisted_drives_;  ///< Drives left out of the last scan because they're blacklisted
 
 		Glib::RefPtr<Gtk::UIManager> ui_manager_;  ///< UI manager
 		Glib::RefPtr<Gtk::ActionGroup> actiongroup_main_;  ///< Action group
 		Glib::RefPtr<Gtk::ActionGroup> actiongroup_device_;  ///< Action group
+		Glib::RefPtr<Gtk::ActionGroup> actiongroup_selection_;  ///< Action group of the bulk operations
 		bool action_handling_enabled_ = true;  ///< Whether action handling is enabled or not
 		std::map<action_t, Glib::RefPtr<Gtk::Action> > action_map_;  ///< Used by on_action_activated().
 
 		Gtk::Label* name_label_ = nullptr;  ///< A UI label
 		Gtk::Label* health_label_ = nullptr;  ///< A UI label
 		Gtk::Label* family_label_ = nullptr;  ///< A UI label
+		Gtk::Label* at_risk_label_ = nullptr;  ///< "Most at-risk drives" label
+
+		Gtk::SearchEntry* drive_filter_entry_ = nullptr;  ///< Filter bar search entry
+		Gtk::ComboBoxText* drive_filter_warning_combo_ = nullptr;  ///< Filter bar warning level combobox
+		Gtk::ComboBoxText* drive_grouping_combo_ = nullptr;  ///< Filter bar grouping combobox
 
 		bool scanning_ = false;  ///< If the scanning is in process or not
+		AppCancellationPtr scan_cancellation_;  ///< Cancellation token of the running rescan_devices(), nullptr if none
+		bool rescan_pending_ = false;  ///< rescan_devices() was called during a scan, rescan when it stops
+
+		std::unique_ptr<StorageHotplugMonitor> hotplug_monitor_;  ///< Hotplug listener (Linux only)
+		std::vector<StorageHotplugEvent> pending_hotplug_events_;  ///< Events waiting for process_hotplug_events()
+		guint hotplug_timeout_id_ = 0;  ///< Pending on_hotplug_timeout() source
+
+		std::unique_ptr<StorageOutputWatcher> output_watcher_;  ///< Watcher of "gui/watch_output_directory" (Linux only)
+		std::map<hz::fs::path, StorageDevicePtr> watched_drives_;  ///< Output file -> its virtual drive
+
+		CommandExecutorFactoryPtr ex_factory_;  ///< See get_executor_factory()
+
+		std::shared_ptr<GscRefreshScheduler> refresh_scheduler_;  ///< Periodic refreshes of the drives, shared with the info windows
+
+		std::unique_ptr<GscPrefetcher> prefetcher_;  ///< Background fetches of the drives likely to be opened next
+
+		StorageMemoryBudget memory_budget_;  ///< Compacts the data of the drives nobody has viewed for a while
+		guint memory_budget_timeout_id_ = 0;  ///< on_memory_budget_timeout() source
+
+		bool io_performance_icons_ = false;  ///< Whether we're a user of the I/O performance monitor ("gui/icons_show_io_performance")
+
+		std::unique_ptr<VirtualDriveIndex> imported_drives_index_;  ///< Drives loaded by import_virtual_drives()
+		std::vector<StorageDevicePtr> imported_drives_shown_;  ///< Imported drives currently in the icon view
+		bool virtual_import_in_progress_ = false;  ///< Whether import_virtual_drives() is loading the files
+		std::string pending_virtual_import_path_;  ///< Path to import after the running import, empty if none
+
+		std::unique_ptr<SelfTestFleet> bulk_test_fleet_;  ///< Self-tests started by run_bulk_short_test(), nullptr if none
+		std::vector<StorageDevicePtr> bulk_test_drives_;  ///< Drives of bulk_test_fleet_
+		guint bulk_test_timeout_id_ = 0;  ///< Pending on_bulk_short_test_timeout() source
+
+		bool attribute_matrix_update_pending_ = false;  ///< update_attribute_matrix_window() idle callback is pending
+
+		/// A drive followed by risk_ranking_
+		struct RiskRankingDrive {
+			StorageDevicePtr drive;  ///< The drive
+			sigc::connection properties_changed_connection;  ///< Connection to StorageDevice::signal_properties_changed()
+			bool diff_received = false;  ///< Whether on_drive_properties_changed() was called since connecting
+		};
+
+		StorageRiskRanking risk_ranking_;  ///< Risk scores of the icon view drives
+		std::unordered_map<const StorageDevice*, RiskRankingDrive> risk_ranking_drives_;  ///< Drives of risk_ranking_
+
+		bool drivedb_update_running_ = false;  ///< Whether update-smart-drivedb started by run_update_drivedb() is running
+		std::vector<hz::fs::path> drivedb_files_;  ///< Drive database files watched by run_update_drivedb()
+		StorageDriveDbSnapshot drivedb_before_update_;  ///< Drive database before update-smart-drivedb was run
 
 };
 
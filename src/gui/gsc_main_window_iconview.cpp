@@ -15,17 +15,23 @@ Copyright:
 #include <gtkmm.h>
 #include <vector>
 #include <cmath>  // std::floor
+#include <algorithm>  // std::sort
+#include <iterator>  // std::next
 #include <unordered_map>
 #include <cairomm/cairomm.h>
 
 #include "applib/warning_level.h"
 #include "hz/string_algo.h"  // string_join
+#include "hz/string_num.h"  // number_to_string_locale
 #include "hz/debug.h"
 #include "hz/data_file.h"  // data_file_find
 #include "applib/app_gtkmm_tools.h"
 #include "applib/warning_colors.h"
+#include "applib/storage_hwmon_temperature.h"
+#include "applib/storage_io_load.h"
 
 #include "gsc_main_window.h"
+#include "gsc_prefetcher.h"
 #include "rconfig/rconfig.h"
 #include "build_config.h"
 
@@ -43,6 +49,7 @@ std::string GscMainWindowIconView::get_message_string(Message type)
 			{Message::NoDrivesFound, _("No drives found.")},
 			{Message::NoSmartctl,    _("Please specify the correct smartctl binary in\nPreferences and press Ctrl-R to re-scan.")},
 			{Message::PleaseRescan,  _("Preferences changed.\nPress Ctrl-R to re-scan.")},
+			{Message::NoDrivesMatchFilter, _("No drives match the filter.")},
 	};
 	if (auto iter = m.find(type); iter != m.end()) {
 		return iter->second;
@@ -58,8 +65,6 @@ GscMainWindowIconView::GscMainWindowIconView(BaseObjectType* gtkcobj, [[maybe_un
 	columns_.add(col_name_);  // we can use the col_name variable by value after this.
 	this->set_markup_column(col_name_);
 
-	columns_.add(col_description_);
-
 	columns_.add(col_pixbuf_);
 
 	// For high quality rendering with GDK_SCALE=2
@@ -71,16 +76,23 @@ GscMainWindowIconView::GscMainWindowIconView(BaseObjectType* gtkcobj, [[maybe_un
 
 	columns_.add(col_populated_);
 
+	columns_.add(col_group_);
+
+	columns_.add(col_group_header_);
+
 	// create a Tree Model
 	ref_list_model_ = Gtk::ListStore::create(columns_);
 // 			ref_list_model->set_sort_column(col_name, Gtk::SORT_ASCENDING);
 	this->set_model(ref_list_model_);
 
-	// we add it here because list model must be created already
-	set_tooltip_column(col_description_.index());
+	// The tooltips are built when they're shown, not for every entry update
+	this->set_has_tooltip(true);
 
 	this->load_icon_pixbufs();
 
+	// Several drives can be selected for the bulk operations (see GscMainWindow::run_bulk_operation()).
+	this->set_selection_mode(Gtk::SELECTION_MULTIPLE);
+
 	this->signal_item_activated().connect(sigc::mem_fun(*this,
 			&GscMainWindowIconView::on_iconview_item_activated) );
 
@@ -89,6 +101,17 @@ GscMainWindowIconView::GscMainWindowIconView(BaseObjectType* gtkcobj, [[maybe_un
 
 	this->signal_button_press_event().connect(sigc::mem_fun(*this,
 			&GscMainWindowIconView::on_iconview_button_press_event) );
+
+	this->add_events(Gdk::POINTER_MOTION_MASK | Gdk::LEAVE_NOTIFY_MASK);
+
+	this->signal_motion_notify_event().connect(sigc::mem_fun(*this,
+			&GscMainWindowIconView::on_iconview_motion_notify_event) );
+
+	this->signal_leave_notify_event().connect(sigc::mem_fun(*this,
+			&GscMainWindowIconView::on_iconview_leave_notify_event) );
+
+	this->signal_query_tooltip().connect(sigc::mem_fun(*this,
+			&GscMainWindowIconView::on_iconview_query_tooltip) );
 }
 
 
@@ -109,7 +132,36 @@ void GscMainWindowIconView::set_empty_view_message(Message message)
 
 int GscMainWindowIconView::get_num_icons() const
 {
-	return num_icons_;
+	return static_cast<int>(entries_.size());
+}
+
+
+
+void GscMainWindowIconView::set_filter(const StorageDeviceFilter& filter)
+{
+	if (filter == filter_) {
+		return;
+	}
+	filter_ = filter;
+	this->rebuild_rows();
+}
+
+
+
+const StorageDeviceFilter& GscMainWindowIconView::get_filter() const
+{
+	return filter_;
+}
+
+
+
+void GscMainWindowIconView::set_grouping(StorageDeviceGrouping grouping)
+{
+	if (grouping == grouping_) {
+		return;
+	}
+	grouping_ = grouping;
+	this->rebuild_rows();
 }
 
 
@@ -119,10 +171,23 @@ bool GscMainWindowIconView::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 	if (in_destruction()) {
 		return true;
 	}
-	if (empty_view_message_ != Message::None && this->num_icons_ == 0) {  // no icons
+
+	// Decorate the entries which were scrolled into view (or shown) since the last decoration
+	if (num_entries_needing_decoration_ > 0 && !decorate_idle_connection_.connected()) {
+		decorate_idle_connection_ = Glib::signal_idle().connect(
+				sigc::mem_fun(*this, &GscMainWindowIconView::on_decorate_visible_entries_idle));
+	}
+
+	Message message = Message::None;
+	if (this->entries_.empty()) {  // no icons
+		message = empty_view_message_;
+	} else if (ref_list_model_->children().empty()) {
+		message = Message::NoDrivesMatchFilter;
+	}
+	if (message != Message::None) {
 		Glib::RefPtr<Pango::Layout> layout = this->create_pango_layout("");
 		layout->set_alignment(Pango::ALIGN_CENTER);
-		layout->set_markup(get_message_string(empty_view_message_));
+		layout->set_markup(get_message_string(message));
 
 		int layout_w = 0, layout_h = 0;
 		layout->get_pixel_size(layout_w, layout_h);
@@ -175,17 +240,38 @@ void GscMainWindowIconView::add_entry(StorageDevicePtr drive, bool scroll_to_it)
 	if (!drive)
 		return;
 
-	Gtk::TreeModel::Row row = *(ref_list_model_->append());
-	row[col_drive_ptr_] = drive;
-
-	this->decorate_entry(row);
-
-	row[col_populated_] = true;  // triggers rendering
-
-	drive->signal_changed().connect(sigc::mem_fun(this, &GscMainWindowIconView::on_drive_changed));
+	auto entry_iter = entries_.find(drive.get());
+	if (entry_iter == entries_.end()) {
+		entry_iter = entries_.try_emplace(drive.get()).first;
+		EntryInfo& info = entry_iter->second;
+		info.drive = drive;
+		info.order = next_entry_order_++;
+		info.changed_connection = drive->signal_changed_coalesced().connect(
+				sigc::mem_fun(this, &GscMainWindowIconView::on_drive_changed));
+		++num_entries_needing_decoration_;  // decoration_needed is initially set
+
+		index_.update(*drive);
+		this->update_entry_visibility(info);
+		if (main_window_) {
+			main_window_->update_attribute_matrix_window();
+		}
+	}
 
 	if (scroll_to_it) {
-		const Gtk::TreeModel::Path tpath(row);
+		// The drive was explicitly requested, so don't let the filter or its collapsed group hide it
+		if (!index_.matches(drive.get(), filter_)) {
+			if (main_window_) {
+				main_window_->reset_drive_filter();
+			}
+			this->set_filter(StorageDeviceFilter());
+		}
+		if (collapsed_groups_.erase({grouping_, entry_iter->second.group}) > 0) {
+			this->rebuild_rows();
+		}
+		const Gtk::TreePath tpath = entry_iter->second.row_ref.get_path();
+		if (tpath.empty()) {
+			return;
+		}
 		// scroll_to_path() and set/get_cursor() are since gtkmm 2.8.
 
 		this->scroll_to_path(tpath, true, 0.5, 0.5);
@@ -194,10 +280,51 @@ void GscMainWindowIconView::add_entry(StorageDevicePtr drive, bool scroll_to_it)
 		if (this->get_cursor(cell) && cell) {
 			this->set_cursor(tpath, *cell, false);
 		}
+		this->unselect_all();  // selection is multiple
 		this->select_path(tpath);  // highlight it
 	}
+}
+
+
+
+void GscMainWindowIconView::set_entry_pending(const StorageDevice* drive, bool pending)
+{
+	auto entry_iter = entries_.find(drive);
+	if (entry_iter == entries_.end() || entry_iter->second.pending == pending) {
+		return;
+	}
+	entry_iter->second.pending = pending;
+	this->refresh_entry(drive);
+}
+
+
+
+void GscMainWindowIconView::update_entries(const std::vector<StorageDevicePtr>& drives,
+		const std::function<bool(const StorageDevicePtr&)>& should_show)
+{
+	std::unordered_map<const StorageDevice*, bool> shown;
+	for (const auto& drive : drives) {
+		if (drive) {
+			shown.emplace(drive.get(), should_show(drive));
+		}
+	}
+
+	std::vector<const StorageDevice*> removed_drives;
+	for (const auto& [drive, info] : entries_) {
+		auto iter = shown.find(drive);
+		if (iter == shown.end() || !iter->second) {
+			removed_drives.push_back(drive);
+		}
+	}
+	for (const auto* drive : removed_drives) {
+		this->remove_entry(drive);
+	}
 
-	++num_icons_;
+	for (const auto& drive : drives) {
+		if (drive && shown[drive.get()] && !entries_.contains(drive.get())) {
+			this->add_entry(drive);
+		}
+	}
 }
 
 
@@ -220,123 +347,275 @@ void GscMainWindowIconView::decorate_entry(Gtk::TreeModel::Row& row)
 		return;
 	}
 
+	DecorationInputs inputs = get_decoration_inputs(*drive);
+	auto entry_iter = entries_.find(drive.get());
+	if (entry_iter != entries_.end()) {
+		inputs.pending = entry_iter->second.pending;
+		this->set_decoration_needed(entry_iter->second, false);
+		if (entry_iter->second.decoration == inputs) {
+			return;  // e.g. only the test status or unrelated properties changed
+		}
+	}
+
 	// it needs this space to be symmetric (why?);
 	std::string name;  // = "<big>" + drive->get_device_with_type() + " </big>\n";
 	Glib::ustring drive_letters = Glib::Markup::escape_text(drive->format_drive_letters(false));
 	if (drive_letters.empty()) {
 		drive_letters = C_("media", "not mounted");
 	}
-	Glib::ustring drive_letters_with_volname = Glib::Markup::escape_text(drive->format_drive_letters(true));
-	if (drive_letters_with_volname.empty()) {
-		drive_letters_with_volname = C_("media", "not mounted");
-	}
-
 	// note: if this wraps, it becomes left-aligned in gtk <= 2.10.
-	name += (drive->get_model_name().empty() ? Glib::ustring("Unknown model") : Glib::Markup::escape_text(drive->get_model_name()));
-	if (rconfig::get_data<bool>("gui/icons_show_device_name")) {
+	if (inputs.pending) {  // nothing but the device name is known yet
+		name += Glib::Markup::escape_text(inputs.device) + "\n<small>" + Glib::Markup::escape_text(_("Retrieving information...")) + "</small>";
+	} else {
+		name += (inputs.model.empty() ? Glib::ustring("Unknown model") : Glib::Markup::escape_text(inputs.model));
+	}
+	if (inputs.show_device_name && !inputs.pending) {
 		if (!drive->get_is_virtual()) {
-			const std::string dev = Glib::Markup::escape_text(drive->get_device_with_type());
+			const std::string dev = Glib::Markup::escape_text(inputs.device);
 			if constexpr(BuildEnv::is_kernel_family_windows()) {
 				name += "\n" + Glib::ustring::compose(_("%1 (%2)"), dev, drive_letters);
 			} else {
 				name += "\n" + dev;
 			}
-		} else if (!drive->get_virtual_filename().empty()) {
-			name += "\n" + Glib::Markup::escape_text(drive->get_virtual_filename());
+		} else if (!inputs.virtual_filename.empty()) {
+			name += "\n" + Glib::Markup::escape_text(inputs.virtual_filename);
 		}
 	}
-	if (rconfig::get_data<bool>("gui/icons_show_serial_number") && !drive->get_serial_number().empty()) {
-		name += "\n" + Glib::Markup::escape_text(drive->get_serial_number());
+	if (!inputs.remote_host.empty() && !inputs.show_device_name) {  // the device name includes the host
+		name += "\n" + Glib::Markup::escape_text(inputs.remote_host);
+	}
+	if (inputs.show_serial_number && !inputs.serial.empty()) {
+		name += "\n" + Glib::Markup::escape_text(inputs.serial);
+	}
+	if (drive->get_is_virtual() && !inputs.scan_time.empty()) {
+		name += "\n" + Glib::Markup::escape_text(inputs.scan_time);
+	}
+	if (!inputs.io_performance.empty()) {
+		name += "\n<small>" + Glib::Markup::escape_text(inputs.io_performance) + "</small>";
+	}
+
+	Glib::RefPtr<Gdk::Pixbuf> icon = get_icon_pixbuf(inputs.detected_type, inputs.health_failing);
+
+
+	// we use all these if-s because changing the data (without actually changing it)
+	// sometimes leads to screwed up icons in iconview (blame gtk).
+
+	if (row.get_value(col_name_) != name) {
+		row[col_name_] = name;  // markup
+	}
+
+	if (row.get_value(col_pixbuf_) != icon) {
+		row[col_pixbuf_] = icon;
+	}
+
+	if (entry_iter != entries_.end()) {
+		EntryInfo& info = entry_iter->second;
+		info.decoration = std::move(inputs);
+		info.decorated_name = name;
+		++info.decoration_generation;  // invalidates the tooltip
+		info.decorated_pixbuf = icon;
 	}
-	StorageProperty scan_time_prop;
-	if (drive->get_is_virtual()) {
-		scan_time_prop = drive->get_property_repository().lookup_property("local_time/asctime");
-		if (!scan_time_prop.empty() && !scan_time_prop.get_value<std::string>().empty()) {
-			name += "\n" + Glib::Markup::escape_text(scan_time_prop.get_value<std::string>());
+}
+
+
+
+void GscMainWindowIconView::refresh_entry(const StorageDevice* drive)
+{
+	auto entry_iter = entries_.find(drive);
+	if (entry_iter == entries_.end()) {
+		return;
+	}
+	EntryInfo& info = entry_iter->second;
+	const Gtk::TreePath model_path = info.row_ref.is_valid() ? info.row_ref.get_path() : Gtk::TreePath();
+	if (!model_path.empty() && this->is_path_visible(model_path)) {
+		this->decorate_entry(model_path);
+	} else {
+		this->set_decoration_needed(info, true);  // when it's scrolled into view
+	}
+}
+
+
+
+GscMainWindowIconView::DecorationInputs GscMainWindowIconView::get_decoration_inputs(const StorageDevice& drive)
+{
+	static const rconfig::Key<bool> show_device_name("gui/icons_show_device_name");
+	static const rconfig::Key<bool> show_serial_number("gui/icons_show_serial_number");
+	static const rconfig::Key<bool> show_io_performance("gui/icons_show_io_performance");
+
+	// A consistent view, even if the drive is being refreshed
+	const StorageDevice::SnapshotPtr snapshot = drive.get_snapshot();
+
+	DecorationInputs inputs;
+	inputs.model = snapshot->model_name;
+	inputs.device = drive.get_device_with_type();
+	inputs.remote_host = drive.get_remote_host_name();
+	inputs.virtual_filename = drive.get_virtual_filename();
+	inputs.serial = snapshot->serial_number;
+	inputs.drive_letters = drive.format_drive_letters(true);
+	if (drive.get_is_virtual()) {
+		if (const auto* scan_time_prop = snapshot->property_repository.find_property("local_time/asctime");
+				scan_time_prop && scan_time_prop->is_value_type<std::string>()) {
+			inputs.scan_time = scan_time_prop->get_value<std::string>();
+		}
+	}
+	inputs.smart_status = snapshot->smart_status;
+	inputs.detected_type = snapshot->detected_type;
+
+	const StorageProperty& health_prop = snapshot->health_property;
+	inputs.health_warning = health_prop.warning_level;
+	inputs.health_failing = (health_prop.warning_level != WarningLevel::None && health_prop.generic_name == "smart_status/passed");
+	if (inputs.health_failing) {
+		inputs.health_warning_reason = storage_property_get_warning_reason(health_prop);
+	}
+	inputs.warning_count = snapshot->property_repository.get_warning_summary().get_warning_count();
+	if (auto hwmon_monitor = storage_hwmon_temperature_get_global()) {
+		if (auto sample = hwmon_monitor->get_last_sample(drive)) {
+			inputs.temperature = sample->value;
 		}
 	}
+	if (auto io_performance_monitor = storage_io_performance_get_global(); io_performance_monitor && show_io_performance.get()) {
+		if (auto perf = io_performance_monitor->get_performance(drive)) {
+			// Rounded, so that the icon isn't updated on every insignificant change
+			const auto iops = static_cast<std::int64_t>(std::lround(perf->read_iops + perf->write_iops));
+			const std::string latency = (perf->service_time_msec.has_value()
+					? hz::number_to_string_locale(std::round(perf->service_time_msec.value() * 10.) / 10., 1, true) : "-");
+			inputs.io_performance = Glib::ustring::compose(_("%1 IOPS, %2 ms"), iops, latency);
+		}
+	}
+	inputs.show_device_name = show_device_name.get();
+	inputs.show_serial_number = show_serial_number.get();
+	return inputs;
+}
+
+
 
+Glib::ustring GscMainWindowIconView::format_entry_tooltip(const StorageDevice& drive, const DecorationInputs& inputs)
+{
 	std::vector<std::string> tooltip_strs;
 
-	if (drive->get_is_virtual()) {
-		const std::string vfile = drive->get_virtual_filename();
+	if (drive.get_is_virtual()) {
+		const std::string& vfile = inputs.virtual_filename;
 		tooltip_strs.push_back(Glib::ustring::compose(_("Loaded from: %1"), (vfile.empty() ? (Glib::ustring("[") + C_("name", "empty") + "]") : Glib::Markup::escape_text(vfile))));
-		if (!scan_time_prop.empty() && !scan_time_prop.get_value<std::string>().empty()) {
-			tooltip_strs.push_back(Glib::ustring::compose(_("Scanned on: "), Glib::Markup::escape_text(scan_time_prop.get_value<std::string>())));
+		if (!inputs.scan_time.empty()) {
+			tooltip_strs.push_back(Glib::ustring::compose(_("Scanned on: "), Glib::Markup::escape_text(inputs.scan_time)));
 		}
 	} else {
-		tooltip_strs.push_back(Glib::ustring::compose(_("Device: %1"), "<b>" + Glib::Markup::escape_text(drive->get_device_with_type()) + "</b>"));
+		tooltip_strs.push_back(Glib::ustring::compose(_("Device: %1"), "<b>" + Glib::Markup::escape_text(inputs.device) + "</b>"));
+		if (!inputs.remote_host.empty()) {
+			tooltip_strs.push_back(Glib::ustring::compose(_("Host: %1"), "<b>" + Glib::Markup::escape_text(inputs.remote_host) + "</b>"));
+		}
 	}
 
 	if constexpr(BuildEnv::is_kernel_family_windows()) {
+		Glib::ustring drive_letters_with_volname = Glib::Markup::escape_text(inputs.drive_letters);
+		if (drive_letters_with_volname.empty()) {
+			drive_letters_with_volname = C_("media", "not mounted");
+		}
 		tooltip_strs.push_back(Glib::ustring::compose(_("Drive letters: %1"), "<b>" + drive_letters_with_volname + "</b>"));
 	}
 
-	if (!drive->get_serial_number().empty()) {
-		tooltip_strs.push_back(Glib::ustring::compose(_("Serial number: %1"), "<b>" + Glib::Markup::escape_text(drive->get_serial_number()) + "</b>"));
+	if (!inputs.serial.empty()) {
+		tooltip_strs.push_back(Glib::ustring::compose(_("Serial number: %1"), "<b>" + Glib::Markup::escape_text(inputs.serial) + "</b>"));
 	}
 	tooltip_strs.push_back(Glib::ustring::compose(_("SMART status: %1"),
-			"<b>" + Glib::Markup::escape_text(StorageDevice::get_status_displayable_name(drive->get_smart_status())) + "</b>"));
+			"<b>" + Glib::Markup::escape_text(StorageDevice::get_status_displayable_name(inputs.smart_status)) + "</b>"));
+	if (inputs.temperature.has_value()) {
+		tooltip_strs.push_back(Glib::ustring::compose(_("Temperature: %1"),
+				"<b>" + Glib::ustring::compose(C_("temperature", "%1° C"), inputs.temperature.value()) + "</b>"));
+	}
+	if (inputs.warning_count > 0) {
+		tooltip_strs.push_back(Glib::ustring::compose(_("Properties with warnings: %1"), "<b>" + hz::number_to_string_locale(inputs.warning_count) + "</b>"));
+	}
 
 	std::string tooltip_str = hz::string_join(tooltip_strs, '\n');
+	if (inputs.health_failing) {
+		tooltip_str += "\n\n" + inputs.health_warning_reason
+				+ "\n\n" + _("View details for more information.");
+	}
+	return tooltip_str;
+}
+
+
+
+Glib::ustring GscMainWindowIconView::format_group_tooltip(const std::string& group) const
+{
+	return Glib::Markup::escape_text(is_group_collapsed(group)
+			? _("Double-click to show the drives of this group.") : _("Double-click to hide the drives of this group."));
+}
+
 
 
+Glib::RefPtr<Gdk::Pixbuf> GscMainWindowIconView::get_icon_pixbuf(StorageDeviceDetectedType type, bool failing)
+{
 	Glib::RefPtr<Gdk::Pixbuf> icon;
-	if (icon_pixbufs_.contains(drive->get_detected_type())) {
-		icon = icon_pixbufs_[drive->get_detected_type()];
+	if (icon_pixbufs_.contains(type)) {
+		icon = icon_pixbufs_[type];
 	} else {
 		icon = default_icon_;
 	}
+	if (!failing || !icon) {
+		return icon;
+	}
 
-	const StorageProperty health_prop = drive->get_health_property();
-	if (health_prop.warning_level != WarningLevel::None && health_prop.generic_name == "smart_status/passed") {
-		if (icon) {
-			icon = icon->copy();  // work on a copy
-			if (icon->get_colorspace() == Gdk::COLORSPACE_RGB && icon->get_bits_per_sample() == 8) {
-				const std::ptrdiff_t n_channels = icon->get_n_channels();
-				const std::ptrdiff_t icon_width = icon->get_width();
-				const std::ptrdiff_t icon_height = icon->get_height();
-				const std::ptrdiff_t rowstride = icon->get_rowstride();
-				guint8* pixels = icon->get_pixels();
-
-				for (std::ptrdiff_t y = 0; y < icon_height; ++y) {
-					for (std::ptrdiff_t x = 0; x < icon_width; ++x) {
-						guint8* p = pixels + y * rowstride + x * n_channels;
-						auto avg = static_cast<uint8_t>(std::floor((p[0] * 0.30) + (p[1] * 0.59) + (p[2] * 0.11) + 0.001 + 0.5));
-						p[0] = avg;  // R
-						p[1] = 0;  // G
-						p[2] = 0;  // B
-					}
-				}
+	if (auto iter = failing_icon_pixbufs_.find(type); iter != failing_icon_pixbufs_.end()) {
+		return iter->second;
+	}
+
+	icon = icon->copy();  // work on a copy
+	if (icon->get_colorspace() == Gdk::COLORSPACE_RGB && icon->get_bits_per_sample() == 8) {
+		const std::ptrdiff_t n_channels = icon->get_n_channels();
+		const std::ptrdiff_t icon_width = icon->get_width();
+		const std::ptrdiff_t icon_height = icon->get_height();
+		const std::ptrdiff_t rowstride = icon->get_rowstride();
+		guint8* pixels = icon->get_pixels();
+
+		for (std::ptrdiff_t y = 0; y < icon_height; ++y) {
+			for (std::ptrdiff_t x = 0; x < icon_width; ++x) {
+				guint8* p = pixels + y * rowstride + x * n_channels;
+				auto avg = static_cast<uint8_t>(std::floor((p[0] * 0.30) + (p[1] * 0.59) + (p[2] * 0.11) + 0.001 + 0.5));
+				p[0] = avg;  // R
+				p[1] = 0;  // G
+				p[2] = 0;  // B
 			}
 		}
-
-		tooltip_str += "\n\n" + storage_property_get_warning_reason(health_prop)
-				+ "\n\n" + _("View details for more information.");
 	}
+	failing_icon_pixbufs_.emplace(type, icon);  // shared by all the failing drives of this type
+	return icon;
+}
 
 
-	// we use all these if-s because changing the data (without actually changing it)
-	// sometimes leads to screwed up icons in iconview (blame gtk).
-
-	if (row.get_value(col_name_) != name) {
-		row[col_name_] = name;  // markup
-	}
-	if (row.get_value(col_description_) != tooltip_str) {
-		row[col_description_] = tooltip_str;  // markup
-	}
 
-	if (row.get_value(col_pixbuf_) != icon) {
-		row[col_pixbuf_] = icon;
+void GscMainWindowIconView::remove_entry(const Gtk::TreePath& model_path)
+{
+	const Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(model_path));
+	const StorageDevicePtr drive = row[col_drive_ptr_];
+	if (drive) {  // not a group header
+		this->remove_entry(drive.get());
 	}
 }
 
 
 
-void GscMainWindowIconView::remove_entry(const Gtk::TreePath& model_path)
+void GscMainWindowIconView::remove_entry(const StorageDevice* drive)
 {
-	const Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(model_path));
-	ref_list_model_->erase(row);
+	auto iter = entries_.find(drive);
+	if (iter == entries_.end()) {
+		return;
+	}
+	EntryInfo& info = iter->second;
+	if (info.counted) {
+		this->change_group_count(info.group, -1);
+	}
+	if (info.row_ref.is_valid()) {
+		this->hide_entry_row(info);
+	}
+	this->set_decoration_needed(info, false);
+	info.changed_connection.disconnect();
+	index_.remove(drive);
+	entries_.erase(iter);
+	if (main_window_) {
+		main_window_->update_attribute_matrix_window();
+	}
 }
 
 
@@ -354,8 +633,17 @@ void GscMainWindowIconView::remove_selected_drive()
 
 void GscMainWindowIconView::clear_all()
 {
-	num_icons_ = 0;
+	for (auto& [drive, info] : entries_) {
+		info.changed_connection.disconnect();
+	}
+	entries_.clear();
+	index_.clear();
+	groups_.clear();
+	num_entries_needing_decoration_ = 0;
 	ref_list_model_->clear();
+	if (main_window_) {
+		main_window_->update_attribute_matrix_window();
+	}
 
 	// this is needed to update the label from "disabled" to "scanning"
 	if (this->get_realized()) {
@@ -382,13 +670,75 @@ StorageDevicePtr GscMainWindowIconView::get_selected_drive()
 
 
 
+std::vector<StorageDevicePtr> GscMainWindowIconView::get_selected_drives()
+{
+	std::vector<StorageDevicePtr> drives;
+	for (const auto& model_path : this->get_selected_items()) {
+		const Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(model_path));
+		if (row[col_group_header_] || !row[col_populated_]) {
+			continue;
+		}
+		StorageDevicePtr drive = row[col_drive_ptr_];
+		if (drive) {
+			drives.push_back(std::move(drive));
+		}
+	}
+	return drives;
+}
+
+
+
+std::vector<StorageDevicePtr> GscMainWindowIconView::get_drives() const
+{
+	std::vector<const EntryInfo*> infos;
+	infos.reserve(entries_.size());
+	for (const auto& [drive, info] : entries_) {
+		infos.push_back(&info);
+	}
+	std::sort(infos.begin(), infos.end(), [](const EntryInfo* a, const EntryInfo* b) { return a->order < b->order; });
+
+	std::vector<StorageDevicePtr> drives;
+	drives.reserve(infos.size());
+	for (const auto* info : infos) {
+		drives.push_back(info->drive);
+	}
+	return drives;
+}
+
+
+
+std::size_t GscMainWindowIconView::get_entry_memory_usage(const StorageDevice* drive) const
+{
+	auto iter = entries_.find(drive);
+	if (iter == entries_.end()) {
+		return 0;
+	}
+	const EntryInfo& info = iter->second;
+
+	// Map node, entry data and its strings
+	std::size_t size = 2 * sizeof(void*) + sizeof(const StorageDevice*) + sizeof(EntryInfo)
+			+ info.decorated_name.size() + info.tooltip_markup.bytes() + info.group.size();
+	if (info.decoration.has_value()) {
+		const DecorationInputs& d = info.decoration.value();
+		size += d.model.size() + d.device.size() + d.remote_host.size() + d.virtual_filename.size() + d.serial.size()
+				+ d.drive_letters.size() + d.scan_time.size() + d.health_warning_reason.size() + d.io_performance.size();
+	}
+
+	// The model row (a sequence node with a GValue per column) has copies of the strings.
+	// The pixbufs are shared.
+	if (info.row_ref.is_valid()) {
+		size += 64 + static_cast<std::size_t>(columns_.size()) * 24
+				+ info.decorated_name.size() + info.group.size();
+	}
+	return size;
+}
+
+
+
 Gtk::TreePath GscMainWindowIconView::get_path_by_drive(StorageDevice* drive)
 {
-	const Gtk::TreeNodeChildren children = ref_list_model_->children();
-	for (const auto& row : children) {
-		// convert iter to row (iter is row's base, but can we cast it?)
-		if (drive == row.get_value(col_drive_ptr_).get())
-			return ref_list_model_->get_path(row);
+	if (auto iter = entries_.find(drive); iter != entries_.end() && iter->second.row_ref.is_valid()) {
+		return iter->second.row_ref.get_path();
 	}
 	return {};  // check with .empty()
 }
@@ -397,6 +747,8 @@ Gtk::TreePath GscMainWindowIconView::get_path_by_drive(StorageDevice* drive)
 
 void GscMainWindowIconView::update_menu_actions()
 {
+	main_window_->set_selection_menu_status(this->get_selected_drives());
+
 	// if there's nothing selected, disable items from "Drives" menu
 	if (this->get_selected_items().empty()) {
 		main_window_->set_drive_menu_status(nullptr);
@@ -404,6 +756,10 @@ void GscMainWindowIconView::update_menu_actions()
 	} else {  // enable drives menu, set proper smart toggles
 		const Gtk::TreePath model_path = *(this->get_selected_items().begin());
 		const Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(model_path));
+		if (row[col_group_header_]) {
+			main_window_->set_drive_menu_status(nullptr);
+			return;
+		}
 		if (!row[col_populated_]) {  // protect against using incomplete model entry
 			return;
 		}
@@ -421,6 +777,14 @@ void GscMainWindowIconView::on_iconview_item_activated(const Gtk::TreePath& mode
 		return;
 
 	const Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(model_path));
+	if (row[col_group_header_]) {  // collapse or expand the group
+		const std::pair<StorageDeviceGrouping, std::string> group = {grouping_, row.get_value(col_group_)};
+		if (collapsed_groups_.erase(group) == 0) {
+			collapsed_groups_.insert(group);
+		}
+		this->rebuild_rows();
+		return;
+	}
 	if (!row[col_populated_]) {  // protect against using incomplete model entry
 		return;
 	}
@@ -438,6 +802,13 @@ void GscMainWindowIconView::on_iconview_selection_changed()
 	this->update_menu_actions();
 
 	main_window_->update_status_widgets();  // status area, etc.
+
+	// The selected drives are the recently used ones, compact the others first
+	for (const auto& drive : this->get_selected_drives()) {
+		main_window_->memory_budget_.touch(drive.get());
+	}
+
+	this->update_prefetch_target();
 }
 
 
@@ -462,8 +833,11 @@ bool GscMainWindowIconView::on_iconview_button_press_event(GdkEventButton* event
 				gtk_icon_view_set_cursor(GTK_ICON_VIEW(this->gobj()), tpath.gobj(), cell->gobj(), FALSE);
 			}
 
-			// select the icon
-			this->select_path(tpath);
+			// select the icon, keeping the multiple selection if it's a part of it
+			if (!this->path_is_selected(tpath)) {
+				this->unselect_all();
+				this->select_path(tpath);
+			}
 
 			const Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(tpath));
 			drive = row[col_drive_ptr_];
@@ -486,16 +860,358 @@ bool GscMainWindowIconView::on_iconview_button_press_event(GdkEventButton* event
 
 
 
-void GscMainWindowIconView::on_drive_changed(StorageDevice* drive)
+bool GscMainWindowIconView::on_iconview_motion_notify_event(GdkEventMotion* event_motion)
+{
+	StorageDevicePtr drive;
+	const Gtk::TreePath tpath = this->get_path_at_pos(static_cast<int>(event_motion->x),
+			static_cast<int>(event_motion->y));
+	if (tpath.gobj() && !tpath.empty()) {
+		const Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(tpath));
+		if (!row[col_group_header_] && row[col_populated_]) {
+			drive = row[col_drive_ptr_];
+		}
+	}
+	if (drive != hovered_drive_.lock()) {
+		hovered_drive_ = drive;
+		this->update_prefetch_target();
+	}
+	return false;  // continue handling (prelight, tooltips)
+}
+
+
+
+bool GscMainWindowIconView::on_iconview_leave_notify_event([[maybe_unused]] GdkEventCrossing* event_crossing)
+{
+	if (!hovered_drive_.expired()) {
+		hovered_drive_.reset();
+		this->update_prefetch_target();
+	}
+	return false;
+}
+
+
+
+bool GscMainWindowIconView::on_iconview_query_tooltip(int x, int y, bool keyboard_tooltip, const Glib::RefPtr<Gtk::Tooltip>& tooltip)
+{
+	Gtk::TreeModel::iterator iter;
+	if (!this->get_tooltip_context_iter(x, y, keyboard_tooltip, iter) || !iter) {
+		return false;
+	}
+	Gtk::TreeModel::Row row = *iter;
+	if (!row[col_populated_]) {
+		return false;
+	}
+
+	Glib::ustring markup;
+	if (row[col_group_header_]) {
+		markup = format_group_tooltip(row.get_value(col_group_));
+
+	} else {
+		const StorageDevicePtr drive = row[col_drive_ptr_];
+		auto entry_iter = (drive ? entries_.find(drive.get()) : entries_.end());
+		if (entry_iter == entries_.end()) {
+			return false;
+		}
+		EntryInfo& info = entry_iter->second;
+		if (!info.decoration.has_value()) {  // not scrolled into view yet
+			this->decorate_entry(row);
+		}
+		if (!info.decoration.has_value()) {
+			return false;
+		}
+		// This is called on each pointer motion over the entry, so the tooltip is only
+		// rebuilt after the entry has been decorated with changed data.
+		if (info.tooltip_generation != info.decoration_generation || info.tooltip_markup.empty()) {
+			info.tooltip_markup = format_entry_tooltip(*drive, info.decoration.value());
+			info.tooltip_generation = info.decoration_generation;
+		}
+		markup = info.tooltip_markup;
+	}
+
+	tooltip->set_markup(markup);
+	this->set_tooltip_item(tooltip, ref_list_model_->get_path(iter));
+	return true;
+}
+
+
+
+void GscMainWindowIconView::update_prefetch_target()
+{
+	if (!main_window_ || !main_window_->prefetcher_) {
+		return;
+	}
+	StorageDevicePtr drive = hovered_drive_.lock();
+	if (!drive) {
+		if (auto selected = this->get_selected_drives(); selected.size() == 1) {
+			drive = selected.front();
+		}
+	}
+	main_window_->prefetcher_->set_target(drive);
+}
+
+
+
+void GscMainWindowIconView::on_drive_changed(StorageDevice* drive, StorageDeviceChange changes)
 {
-	const Gtk::TreePath model_path = this->get_path_by_drive(drive);
-	this->decorate_entry(model_path);
+	auto entry_iter = entries_.find(drive);
+	if (entry_iter == entries_.end()) {
+		return;
+	}
+	// The entry shows the drive data only. The test status affects the menus and the status bar.
+	if (storage_device_change_has(changes, StorageDeviceChange::Properties)) {
+		// Only this drive is re-indexed. It may start or stop passing the filter, or change its group.
+		if (index_.update(*drive)) {
+			this->update_entry_visibility(entry_iter->second);
+		}
+		if (!entry_iter->second.row_ref.is_valid()) {  // not shown
+			this->set_decoration_needed(entry_iter->second, true);
+			return;
+		}
+		this->refresh_entry(drive);
+	}
 	this->update_menu_actions();
 	main_window_->update_status_widgets();
 }
 
 
 
+void GscMainWindowIconView::update_entry_visibility(EntryInfo& info)
+{
+	const bool matches = index_.matches(info.drive.get(), filter_);
+	std::string group = index_.get_group(info.drive.get(), grouping_);
+
+	if (info.counted && (!matches || group != info.group)) {
+		this->change_group_count(info.group, -1);
+		info.counted = false;
+	}
+	const bool show = matches && !is_group_collapsed(group);
+	if (info.row_ref.is_valid() && (!show || group != info.group)) {
+		this->hide_entry_row(info);
+	}
+	info.group = std::move(group);
+
+	if (matches && !info.counted) {
+		this->change_group_count(info.group, 1);
+		info.counted = true;
+	}
+	if (show && !info.row_ref.is_valid()) {
+		this->show_entry_row(info);
+	}
+}
+
+
+
+void GscMainWindowIconView::show_entry_row(EntryInfo& info)
+{
+	const auto num_rows = static_cast<int>(ref_list_model_->children().size());
+	int begin_index = 0, end_index = num_rows;
+	if (grouping_ != StorageDeviceGrouping::None) {
+		auto group_iter = groups_.find(info.group);  // created by change_group_count()
+		DBG_ASSERT_RETURN_NONE(group_iter != groups_.end());
+		begin_index = group_iter->second.row_ref.get_path().front() + 1;
+		if (auto next_group_iter = std::next(group_iter); next_group_iter != groups_.end()) {
+			end_index = next_group_iter->second.row_ref.get_path().front();
+		}
+	}
+
+	// Keep the order of addition. The new entries are usually the last ones, so search from the end.
+	int insert_index = end_index;
+	while (insert_index > begin_index) {
+		const Gtk::TreeModel::Row prev_row = *(ref_list_model_->get_iter(Gtk::TreePath(1, insert_index - 1)));
+		const StorageDevicePtr prev_drive = prev_row[col_drive_ptr_];
+		auto prev_iter = entries_.find(prev_drive.get());
+		if (prev_iter == entries_.end() || prev_iter->second.order < info.order) {
+			break;
+		}
+		--insert_index;
+	}
+
+	Gtk::TreeModel::Row row = *(insert_index < num_rows
+			? ref_list_model_->insert(ref_list_model_->get_iter(Gtk::TreePath(1, insert_index)))
+			: ref_list_model_->append());
+	row[col_drive_ptr_] = info.drive;
+	row[col_group_] = info.group;
+	info.row_ref = Gtk::TreeRowReference(ref_list_model_, ref_list_model_->get_path(row));
+
+	if (info.decoration.has_value()) {  // shown before
+		row[col_name_] = info.decorated_name;
+		row[col_pixbuf_] = info.decorated_pixbuf;
+	} else {
+		row[col_name_] = std::string(Glib::Markup::escape_text(info.drive->get_device_with_type()));
+		row[col_pixbuf_] = default_icon_;
+	}
+	if (info.decoration_needed && this->is_path_visible(ref_list_model_->get_path(row))) {
+		this->decorate_entry(row);
+	}
+
+	row[col_populated_] = true;  // triggers rendering
+}
+
+
+
+void GscMainWindowIconView::hide_entry_row(EntryInfo& info)
+{
+	if (const Gtk::TreePath model_path = info.row_ref.get_path(); !model_path.empty()) {
+		ref_list_model_->erase(ref_list_model_->get_iter(model_path));
+	}
+	info.row_ref = Gtk::TreeRowReference();
+}
+
+
+
+void GscMainWindowIconView::rebuild_rows()
+{
+	const std::vector<StorageDevicePtr> selected_drives = this->get_selected_drives();
+
+	ref_list_model_->clear();
+	groups_.clear();
+
+	std::vector<EntryInfo*> sorted_entries;
+	sorted_entries.reserve(entries_.size());
+	for (auto& [drive, info] : entries_) {
+		info.row_ref = Gtk::TreeRowReference();
+		info.counted = false;
+		sorted_entries.push_back(&info);
+	}
+	// In the order of addition, so that each row is appended to its group
+	std::sort(sorted_entries.begin(), sorted_entries.end(),
+			[](const EntryInfo* a, const EntryInfo* b) { return a->order < b->order; });
+	for (auto* info : sorted_entries) {
+		this->update_entry_visibility(*info);
+	}
+
+	for (const auto& selected_drive : selected_drives) {
+		if (const Gtk::TreePath model_path = this->get_path_by_drive(selected_drive.get()); !model_path.empty()) {
+			this->select_path(model_path);
+		}
+	}
+	this->update_menu_actions();
+}
+
+
+
+void GscMainWindowIconView::change_group_count(const std::string& group, int delta)
+{
+	if (grouping_ == StorageDeviceGrouping::None) {
+		return;
+	}
+	auto group_iter = groups_.try_emplace(group).first;
+	GroupInfo& info = group_iter->second;
+	info.num_entries += delta;
+
+	if (info.num_entries <= 0) {
+		if (const Gtk::TreePath model_path = info.row_ref.get_path(); !model_path.empty()) {
+			ref_list_model_->erase(ref_list_model_->get_iter(model_path));
+		}
+		groups_.erase(group_iter);
+		return;
+	}
+
+	if (!info.row_ref.is_valid()) {
+		// The headers are in the order of groups_
+		Gtk::TreeModel::Row row;
+		if (auto next_group_iter = std::next(group_iter); next_group_iter != groups_.end()) {
+			row = *(ref_list_model_->insert(ref_list_model_->get_iter(next_group_iter->second.row_ref.get_path())));
+		} else {
+			row = *(ref_list_model_->append());
+		}
+		row[col_group_] = group;
+		row[col_group_header_] = true;
+		info.row_ref = Gtk::TreeRowReference(ref_list_model_, ref_list_model_->get_path(row));
+	}
+	this->decorate_group_header(group, info);
+}
+
+
+
+void GscMainWindowIconView::decorate_group_header(const std::string& group, const GroupInfo& info)
+{
+	const Gtk::TreePath model_path = info.row_ref.get_path();
+	if (model_path.empty()) {
+		return;
+	}
+	Gtk::TreeModel::Row row = *(ref_list_model_->get_iter(model_path));
+
+	Glib::ustring label = group;
+	if (label.empty()) {
+		label = (grouping_ == StorageDeviceGrouping::Host) ? _("Local drives") : _("Direct-attached drives");
+	}
+	const bool collapsed = is_group_collapsed(group);
+	Glib::ustring markup = "<b>";
+	markup += (collapsed ? "\u25B8 " : "\u25BE ");  // small triangles pointing right and down
+	markup += Glib::Markup::escape_text(label) + "</b>\n<small>"
+			+ Glib::Markup::escape_text(Glib::ustring::compose(_("Drives: %1"), info.num_entries)) + "</small>";
+	const std::string name = markup.raw();
+
+	if (row.get_value(col_name_) != name) {
+		row[col_name_] = name;  // markup
+	}
+	row[col_pixbuf_] = (grouping_ == StorageDeviceGrouping::Host) ? host_group_icon_ : controller_group_icon_;
+	row[col_populated_] = true;
+}
+
+
+
+bool GscMainWindowIconView::is_group_collapsed(const std::string& group) const
+{
+	return grouping_ != StorageDeviceGrouping::None && collapsed_groups_.contains({grouping_, group});
+}
+
+
+
+void GscMainWindowIconView::set_decoration_needed(EntryInfo& info, bool needed)
+{
+	if (info.decoration_needed == needed) {
+		return;
+	}
+	info.decoration_needed = needed;
+	if (needed) {
+		++num_entries_needing_decoration_;
+		this->queue_draw();  // on_draw() decorates it if it's visible
+	} else {
+		--num_entries_needing_decoration_;
+	}
+}
+
+
+
+bool GscMainWindowIconView::is_path_visible(const Gtk::TreePath& model_path)
+{
+	if (auto vadjustment = this->get_vadjustment();
+			!vadjustment || vadjustment->get_upper() <= vadjustment->get_page_size()) {
+		return true;  // everything fits, no need to look at the layout (which may be stale)
+	}
+	Gtk::TreePath start_path, end_path;
+	if (!this->get_visible_range(start_path, end_path)) {
+		return true;
+	}
+	return !(model_path < start_path) && !(end_path < model_path);
+}
+
+
+
+bool GscMainWindowIconView::on_decorate_visible_entries_idle()
+{
+	Gtk::TreePath start_path, end_path;
+	if (num_entries_needing_decoration_ == 0 || !this->get_visible_range(start_path, end_path)) {
+		return false;  // one-time call
+	}
+	for (Gtk::TreePath model_path = start_path; !(end_path < model_path); model_path.next()) {
+		auto iter = ref_list_model_->get_iter(model_path);
+		if (!iter) {
+			break;
+		}
+		Gtk::TreeModel::Row row = *iter;
+		const StorageDevicePtr drive = row[col_drive_ptr_];
+		if (auto entry_iter = entries_.find(drive.get()); entry_iter != entries_.end() && entry_iter->second.decoration_needed) {
+			this->decorate_entry(row);
+		}
+	}
+	return false;  // one-time call
+}
+
+
+
 void GscMainWindowIconView::load_icon_pixbufs()
 {
 	Glib::RefPtr<Gtk::IconTheme> default_icon_theme;
@@ -507,6 +1223,16 @@ void GscMainWindowIconView::load_icon_pixbufs()
 
 	default_icon_ = load_icon_pixbuf(default_icon_theme, "drive-harddisk", "drive-harddisk.png");
 
+	// Not in XDG, but available in some icon themes
+	controller_group_icon_ = load_icon_pixbuf(default_icon_theme, "drive-multidisk", "");
+	if (!controller_group_icon_) {
+		controller_group_icon_ = default_icon_;
+	}
+	host_group_icon_ = load_icon_pixbuf(default_icon_theme, "network-server", "");
+	if (!host_group_icon_) {
+		host_group_icon_ = default_icon_;
+	}
+
 	for (auto type : StorageDeviceDetectedTypeExt::get_all_values()) {
 		Glib::RefPtr<Gdk::Pixbuf> type_icon;
 		switch(type) {
@@ -15,16 +15,30 @@ Copyright:
 #include <glibmm.h>
 #include <gtkmm.h>
 #include <cairomm/cairomm.h>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "gsc_main_window.h"
 #include "applib/storage_device.h"
+#include "applib/storage_device_index.h"
+#include "applib/warning_level.h"
 
 
 
 /// The icon view of the main window (shows a drive list).
 /// Note: The IconView must have a fixed icon width set (e.g. in .ui file).
 /// Otherwise, it doesn't re-compute it when clearing and adding new icons.
+/// The entries may be filtered and grouped (see set_filter() and set_grouping()), and
+/// only the entries in the visible area are decorated, so that thousands of drives stay usable.
 class GscMainWindowIconView : public Gtk::IconView {
 	public:
 
@@ -36,6 +50,7 @@ class GscMainWindowIconView : public Gtk::IconView {
 			NoDrivesFound,  ///< No drives found
 			NoSmartctl,  ///< No smartctl installed
 			PleaseRescan,  ///< Re-scan to see the drives
+			NoDrivesMatchFilter,  ///< All the drives are filtered out
 		};
 
 
@@ -55,10 +70,22 @@ class GscMainWindowIconView : public Gtk::IconView {
 		void set_empty_view_message(Message message);
 
 
-		/// Get the number of icons currently displayed
+		/// Get the number of drive entries, including the ones hidden by the filter or in collapsed groups
 		[[nodiscard]] int get_num_icons() const;
 
 
+		/// Show only the drives which pass the filter
+		void set_filter(const StorageDeviceFilter& filter);
+
+
+		/// Get the current filter
+		[[nodiscard]] const StorageDeviceFilter& get_filter() const;
+
+
+		/// Group the drives. Each group has a header entry, activating which collapses or expands the group.
+		void set_grouping(StorageDeviceGrouping grouping);
+
+
 		// Overridden from Gtk::Widget
 		bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
 
@@ -68,10 +95,23 @@ class GscMainWindowIconView : public Gtk::IconView {
 		void on_cell_data_render(const Gtk::TreeModel::const_iterator& iter);
 
 
-		/// Add a drive entry to the icon view
+		/// Add a drive entry to the icon view. If the drive is already shown, its entry is kept.
 		void add_entry(StorageDevicePtr drive, bool scroll_to_it = false);
 
 
+		/// Mark a drive entry as a placeholder whose basic data is still being retrieved (during
+		/// a scan), or unmark it. Placeholders show the device name instead of the model.
+		void set_entry_pending(const StorageDevice* drive, bool pending);
+
+
+		/// Synchronize the entries with \c drives, without touching the entries which stay.
+		/// The entries of the drives which are not in \c drives (or for which \c should_show returns false)
+		/// are removed, the missing ones are appended. The remaining entries keep their position,
+		/// the changes in their drives arrive through StorageDevice::signal_changed_coalesced().
+		void update_entries(const std::vector<StorageDevicePtr>& drives,
+				const std::function<bool(const StorageDevicePtr&)>& should_show);
+
+
 		/// Decorate a drive entry (colorize it if it has errors, etc.).
 		/// This should be called to update the icon of already refreshed drive.
 		void decorate_entry(const Gtk::TreePath& model_path);
@@ -79,13 +119,23 @@ class GscMainWindowIconView : public Gtk::IconView {
 
 		/// Decorate a drive entry (colorize it if it has errors, etc.).
 		/// This should be called to update the icon of already refreshed drive.
+		/// Nothing is regenerated if none of the displayed drive properties changed since the last call.
 		void decorate_entry(Gtk::TreeModel::Row& row);
 
 
+		/// Re-decorate a drive entry if it's in the visible area. Other entries (including the
+		/// hidden ones) are decorated when they're scrolled into view.
+		void refresh_entry(const StorageDevice* drive);
+
+
 		/// Remove drive entry
 		void remove_entry(const Gtk::TreePath& model_path);
 
 
+		/// Remove drive entry, even if it's hidden by the filter or in a collapsed group
+		void remove_entry(const StorageDevice* drive);
+
+
 		/// Remove selected drive entry
 		void remove_selected_drive();
 
@@ -94,14 +144,27 @@ class GscMainWindowIconView : public Gtk::IconView {
 		void clear_all();
 
 
-		/// Get selected drive
+		/// Get selected drive. If several drives are selected, the first one is returned.
 		[[nodiscard]] StorageDevicePtr get_selected_drive();
 
 
+		/// Get all the selected drives, without the group headers and the incomplete entries
+		[[nodiscard]] std::vector<StorageDevicePtr> get_selected_drives();
+
+
+		/// Get the drives of all the entries (including the hidden ones), in the order of their addition
+		[[nodiscard]] std::vector<StorageDevicePtr> get_drives() const;
+
+
 		/// Get tree path by a drive
 		[[nodiscard]] Gtk::TreePath get_path_by_drive(StorageDevice* drive);
 
 
+		/// Get the approximate memory usage of the entry of a drive: its model row and
+		/// decoration data. 0 if the drive is not added.
+		[[nodiscard]] std::size_t get_entry_memory_usage(const StorageDevice* drive) const;
+
+
 		/// Update menu actions in the Drives menu
 		void update_menu_actions();
 
@@ -120,8 +183,26 @@ class GscMainWindowIconView : public Gtk::IconView {
 		bool on_iconview_button_press_event(GdkEventButton* event_button);
 
 
+		/// Callback, follows the hovered drive
+		bool on_iconview_motion_notify_event(GdkEventMotion* event_motion);
+
+
+		/// Callback, forgets the hovered drive
+		bool on_iconview_leave_notify_event(GdkEventCrossing* event_crossing);
+
+
+		/// Callback, shows the tooltip of the hovered entry. The drive tooltips are built
+		/// only here, and cached until the entry is decorated with changed data.
+		bool on_iconview_query_tooltip(int x, int y, bool keyboard_tooltip, const Glib::RefPtr<Gtk::Tooltip>& tooltip);
+
+
+		/// Tell the prefetcher of the main window which drive is likely to be opened next:
+		/// the hovered one, or the selected one if it's the only selected drive.
+		void update_prefetch_target();
+
+
 		/// Callback attached to StorageDevice, updates its view.
-		void on_drive_changed(StorageDevice* drive);
+		void on_drive_changed(StorageDevice* drive, StorageDeviceChange changes);
 
 
 		/// Load drive-type-specific icons
@@ -135,17 +216,125 @@ class GscMainWindowIconView : public Gtk::IconView {
 
 	private:
 
+		/// Drive data displayed in an entry. The entry is only re-decorated when it changes.
+		struct DecorationInputs {
+			std::string model;  ///< Model name
+			std::string device;  ///< Device with type
+			std::string remote_host;  ///< Remote host, empty if local
+			std::string virtual_filename;  ///< Virtual file name
+			std::string serial;  ///< Serial number
+			std::string drive_letters;  ///< Drive letters with volume names
+			std::string scan_time;  ///< Scan time of a virtual drive
+			StorageDevice::SmartStatus smart_status = StorageDevice::SmartStatus::Unsupported;  ///< SMART status
+			StorageDeviceDetectedType detected_type = StorageDeviceDetectedType::Unknown;  ///< Detected type
+			WarningLevel health_warning = WarningLevel::None;  ///< Warning level of the health property
+			bool health_failing = false;  ///< Whether the health property colors the icon
+			std::string health_warning_reason;  ///< Warning reason of the health property, if it colors the icon
+			std::size_t warning_count = 0;  ///< Number of shown properties with warnings
+			std::optional<std::int64_t> temperature;  ///< Last hwmon temperature sample, Celsius
+			std::string io_performance;  ///< Current IOPS and latency, rounded. Empty if not shown.
+			bool pending = false;  ///< The entry is a placeholder, see set_entry_pending()
+			bool show_device_name = false;  ///< "gui/icons_show_device_name" setting
+			bool show_serial_number = false;  ///< "gui/icons_show_serial_number" setting
+
+			/// Comparison
+			bool operator==(const DecorationInputs& other) const = default;
+		};
+
+
+		/// Icon view data of a drive
+		struct EntryInfo {
+			StorageDevicePtr drive;  ///< The drive
+			std::uint64_t order = 0;  ///< Entries are shown in the order of their addition
+			Gtk::TreeRowReference row_ref;  ///< The model row, invalid if the entry is hidden
+			sigc::connection changed_connection;  ///< Connection to StorageDevice::signal_changed_coalesced()
+			std::optional<DecorationInputs> decoration;  ///< Data the entry was last decorated with
+			std::string decorated_name;  ///< Markup generated from \c decoration, restored when the entry is shown again
+			std::uint64_t decoration_generation = 0;  ///< Incremented each time \c decoration changes
+			Glib::ustring tooltip_markup;  ///< Tooltip built from \c decoration when it was last shown
+			std::uint64_t tooltip_generation = 0;  ///< \c decoration_generation which \c tooltip_markup was built for
+			Glib::RefPtr<Gdk::Pixbuf> decorated_pixbuf;  ///< Icon chosen from \c decoration
+			bool decoration_needed = true;  ///< The drive changed since the entry was decorated
+			bool pending = false;  ///< See set_entry_pending()
+			std::string group;  ///< Group of the entry (see set_grouping())
+			bool counted = false;  ///< The entry passes the filter and is counted in its group
+		};
+
+
+		/// A group of entries
+		struct GroupInfo {
+			Gtk::TreeRowReference row_ref;  ///< The header row
+			int num_entries = 0;  ///< Number of entries which pass the filter
+		};
+
+
+		/// Show or hide the entry according to the filter, its group and whether the group is collapsed
+		void update_entry_visibility(EntryInfo& info);
+
+		/// Insert the model row of an entry into its group, keeping the order of addition
+		void show_entry_row(EntryInfo& info);
+
+		/// Remove the model row of an entry
+		void hide_entry_row(EntryInfo& info);
+
+		/// Recreate all the model rows (after the filter or grouping change), keeping the selection
+		void rebuild_rows();
+
+		/// Change the number of the entries of a group, creating or removing its header
+		void change_group_count(const std::string& group, int delta);
+
+		/// Update the header text of a group
+		void decorate_group_header(const std::string& group, const GroupInfo& info);
+
+		/// Check whether the entries of a group are hidden
+		[[nodiscard]] bool is_group_collapsed(const std::string& group) const;
+
+		/// Mark an entry as needing decoration
+		void set_decoration_needed(EntryInfo& info, bool needed);
+
+		/// Check whether a model row is in the visible area (or the view doesn't scroll at all)
+		[[nodiscard]] bool is_path_visible(const Gtk::TreePath& model_path);
+
+		/// Decorate the entries in the visible area which need it. Idle callback.
+		bool on_decorate_visible_entries_idle();
+
+
+		/// Get the drive data which decorate_entry() displays
+		[[nodiscard]] static DecorationInputs get_decoration_inputs(const StorageDevice& drive);
+
+
+		/// Build the tooltip markup of a drive entry decorated with \c inputs
+		[[nodiscard]] static Glib::ustring format_entry_tooltip(const StorageDevice& drive, const DecorationInputs& inputs);
+
+		/// Get the tooltip markup of a group header
+		[[nodiscard]] Glib::ustring format_group_tooltip(const std::string& group) const;
+
+
+		/// Get the icon for a drive type, tinted red if \c failing is true
+		[[nodiscard]] Glib::RefPtr<Gdk::Pixbuf> get_icon_pixbuf(StorageDeviceDetectedType type, bool failing);
+
+
 		Gtk::TreeModel::ColumnRecord columns_;  ///< Model columns
 		Gtk::CellRendererPixbuf cell_renderer_pixbuf_;  ///< Cell renderer for icons.
 
 		Gtk::TreeModelColumn<std::string> col_name_;  ///< Model column
-		Gtk::TreeModelColumn<Glib::ustring> col_description_;  ///< Model column
 		Gtk::TreeModelColumn<Glib::RefPtr<Gdk::Pixbuf> > col_pixbuf_;  ///< Model column
 		Gtk::TreeModelColumn<StorageDevicePtr> col_drive_ptr_;  ///< Model column
 		Gtk::TreeModelColumn<bool> col_populated_;  ///< Model column, indicates whether the model entry has been fully populated.
+		Gtk::TreeModelColumn<std::string> col_group_;  ///< Model column, the group of the entry
+		Gtk::TreeModelColumn<bool> col_group_header_;  ///< Model column, the row is a group header, not a drive
 
 		Glib::RefPtr<Gtk::ListStore> ref_list_model_;  ///< The icon view model
-		int num_icons_ = 0;  ///< Track the number of icons, because liststore makes it difficult to count them.
+		std::unordered_map<const StorageDevice*, EntryInfo> entries_;  ///< Added drives, shown or not. Also tracks the number of icons, because liststore makes it difficult to count them.
+		std::uint64_t next_entry_order_ = 0;  ///< EntryInfo::order of the next added entry
+		std::size_t num_entries_needing_decoration_ = 0;  ///< Number of entries with EntryInfo::decoration_needed set
+		sigc::connection decorate_idle_connection_;  ///< Pending on_decorate_visible_entries_idle()
+
+		StorageDeviceIndex index_;  ///< Searchable data of the added drives, updated when they change
+		StorageDeviceFilter filter_;  ///< Current filter
+		StorageDeviceGrouping grouping_ = StorageDeviceGrouping::None;  ///< Current grouping
+		std::map<std::string, GroupInfo> groups_;  ///< Groups with headers, in their display order
+		std::set<std::pair<StorageDeviceGrouping, std::string>> collapsed_groups_;  ///< Collapsed groups
 
 		/// Adwaita's drive-harddisk icons are tiny at 48, so 64 is better.
 		/// Plus, 64 scales well to 128 and 256 (if using GDK_SCALE).
@@ -153,9 +342,14 @@ class GscMainWindowIconView : public Gtk::IconView {
 
 		Glib::RefPtr<Gdk::Pixbuf> default_icon_;  ///< Icon pixbuf, used when type-specific icon is missing
 		std::unordered_map<StorageDeviceDetectedType, Glib::RefPtr<Gdk::Pixbuf>> icon_pixbufs_;  ///< Icons for different drive types
+		std::unordered_map<StorageDeviceDetectedType, Glib::RefPtr<Gdk::Pixbuf>> failing_icon_pixbufs_;  ///< Red-tinted icons, created on demand
+		Glib::RefPtr<Gdk::Pixbuf> controller_group_icon_;  ///< Icon of the controller group headers
+		Glib::RefPtr<Gdk::Pixbuf> host_group_icon_;  ///< Icon of the host group headers
 
 		GscMainWindow* main_window_ = nullptr;  ///< The main window, our parent
 
+		std::weak_ptr<StorageDevice> hovered_drive_;  ///< Drive under the mouse pointer, if any
+
 		Message empty_view_message_ = Message::None;  ///< Message type to display when not showing any icons
 
 };
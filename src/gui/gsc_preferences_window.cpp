@@ -485,10 +485,11 @@ void GscPreferencesWindow::on_window_ok_button_clicked()
 		}
 	}
 
+	const AppDriveSettings old_settings = AppDriveSettings::get_current();
 	export_config();
 
 	if (main_window_) {
-		main_window_->show_prefs_updated_message();
+		main_window_->apply_prefs_changes(old_settings);
 	}
 
 	destroy_instance();
@@ -0,0 +1,169 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <algorithm>
+#include <utility>
+
+#include "hz/debug.h"
+#include "rconfig/rconfig.h"
+#include "applib/smartctl_executor.h"
+
+#include "gsc_prefetcher.h"
+
+
+
+GscPrefetcher::GscPrefetcher()
+{
+	enabled_ = rconfig::get_data<bool>("gui/prefetch_full_data");
+	delay_msec_ = static_cast<guint>(std::max(0, rconfig::get_data<int>("gui/prefetch_delay_msec")));
+	max_age_ = std::chrono::seconds(std::max(0, rconfig::get_data<int>("gui/prefetch_max_age_sec")));
+}
+
+
+
+GscPrefetcher::~GscPrefetcher()
+{
+	// The running fetch keeps its drive alive, and won't call us (we're sigc::trackable).
+	if (running_cancellation_) {
+		running_cancellation_->cancel();
+	}
+	if (delay_timeout_id_ != 0) {
+		g_source_remove(delay_timeout_id_);
+	}
+}
+
+
+
+void GscPrefetcher::set_target(const StorageDevicePtr& drive)
+{
+	if (!enabled_ || drive == target_.lock()) {
+		return;
+	}
+
+	// The user has moved on, the old target may not be opened after all
+	if (running_drive_ && running_for_target_ && running_drive_ != drive && running_cancellation_) {
+		debug_out_dump("app", DBG_FUNC_MSG << "Cancelling the prefetch of " << running_drive_->get_device_with_type() << ".\n");
+		running_cancellation_->cancel();
+	}
+
+	if (delay_timeout_id_ != 0) {
+		g_source_remove(delay_timeout_id_);
+		delay_timeout_id_ = 0;
+	}
+	target_ = drive;
+	target_due_ = false;
+	if (drive && get_prefetch_needed(*drive)) {
+		delay_timeout_id_ = g_timeout_add(delay_msec_, &GscPrefetcher::on_delay_timeout, this);
+	}
+}
+
+
+
+void GscPrefetcher::set_background_drives(const std::vector<StorageDevicePtr>& drives)
+{
+	if (!enabled_) {
+		return;
+	}
+	background_drives_.assign(drives.begin(), drives.end());
+	start_next();
+}
+
+
+
+bool GscPrefetcher::get_data_fresh(const StorageDevice& drive) const
+{
+	if (!enabled_) {
+		return false;
+	}
+	const auto full_data_time = drive.get_full_data_time();
+	return full_data_time.has_value() && std::chrono::steady_clock::now() - full_data_time.value() <= max_age_;
+}
+
+
+
+bool GscPrefetcher::get_prefetch_needed(const StorageDevice& drive) const
+{
+	// Same as GscMainWindow::show_device_info_window(): the others have nothing to fetch.
+	return !drive.get_is_virtual() && drive.get_smart_status() != StorageDevice::SmartStatus::Unsupported
+			&& !drive.get_test_is_active() && !drive.get_fetch_in_progress() && !get_data_fresh(drive);
+}
+
+
+
+void GscPrefetcher::start_next()
+{
+	if (running_drive_) {
+		return;  // on_fetch_finished() calls us again
+	}
+
+	StorageDevicePtr drive;
+	bool for_target = false;
+	if (auto target = target_.lock(); target && target_due_) {
+		target_due_ = false;
+		if (get_prefetch_needed(*target)) {
+			drive = target;
+			for_target = true;
+		}
+	}
+	while (!drive && !background_drives_.empty()) {
+		auto candidate = background_drives_.front().lock();
+		background_drives_.pop_front();
+		if (candidate && get_prefetch_needed(*candidate)) {
+			drive = candidate;
+		}
+	}
+	if (!drive) {
+		return;
+	}
+
+	debug_out_dump("app", DBG_FUNC_MSG << "Prefetching " << drive->get_device_with_type() << ".\n");
+	running_drive_ = drive;
+	running_for_target_ = for_target;
+	running_cancellation_ = std::make_shared<AppCancellation>();
+
+	drive->set_standby_aware(true);  // don't spin up a drive just because the mouse passed over it
+	auto smartctl_ex = std::make_shared<SmartctlExecutor>();
+	smartctl_ex->set_priority(CommandPriority::BackgroundRefresh);  // the user's own commands go first
+	smartctl_ex->set_cancellation(running_cancellation_);
+	drive->fetch_full_data_and_parse_async(smartctl_ex, sigc::mem_fun(*this, &GscPrefetcher::on_fetch_finished));
+}
+
+
+
+void GscPrefetcher::on_fetch_finished(StorageDevice* drive, const hz::ExpectedVoid<StorageDeviceError>& status)
+{
+	drive->set_standby_aware(false);
+	if (!status) {
+		debug_out_dump("app", DBG_FUNC_MSG << "Prefetch of " << drive->get_device_with_type()
+				<< " failed: " << status.error().message() << "\n");
+	}
+	running_drive_.reset();
+	running_cancellation_.reset();
+	start_next();
+}
+
+
+
+gboolean GscPrefetcher::on_delay_timeout(gpointer data)
+{
+	auto* self = static_cast<GscPrefetcher*>(data);
+	self->delay_timeout_id_ = 0;
+	self->target_due_ = true;
+	self->start_next();
+	return FALSE;
+}
+
+
+
+
+
+
+/// @}
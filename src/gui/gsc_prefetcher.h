@@ -0,0 +1,107 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_PREFETCHER_H
+#define GSC_PREFETCHER_H
+
+#include <glib.h>
+#include <sigc++/sigc++.h>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "applib/app_cancellation.h"
+#include "applib/storage_device.h"
+
+
+
+/// Fetches the full data of the drives the user is likely to open next in the background,
+/// so that their info windows open without waiting for smartctl. These are the selected or
+/// hovered drive (once it stays so for "gui/prefetch_delay_msec"), and the drives whose
+/// basic data has health warnings. One drive is fetched at a time, below the user's own
+/// commands (CommandPriority::BackgroundRefresh), and the sleeping drives are not spun up.
+/// The prefetch of the selected drive is cancelled when the selection moves on.
+class GscPrefetcher : public sigc::trackable {
+	public:
+
+		/// Constructor. Reads the settings.
+		GscPrefetcher();
+
+		/// Deleted
+		GscPrefetcher(const GscPrefetcher& other) = delete;
+
+		/// Deleted
+		GscPrefetcher(GscPrefetcher&& other) = delete;
+
+		/// Deleted
+		GscPrefetcher& operator=(const GscPrefetcher& other) = delete;
+
+		/// Deleted
+		GscPrefetcher& operator=(GscPrefetcher&& other) = delete;
+
+		/// Destructor, cancels the running prefetch
+		~GscPrefetcher();
+
+
+		/// Set the selected or hovered drive (nullptr if none). It's prefetched after the delay,
+		/// unless another one is set before that. The running prefetch of the previous one is cancelled.
+		void set_target(const StorageDevicePtr& drive);
+
+		/// Prefetch the drives which need attention (e.g. with health warnings), after the target.
+		/// This replaces the drives queued by the previous call.
+		void set_background_drives(const std::vector<StorageDevicePtr>& drives);
+
+
+		/// Check whether the full data of a drive was fetched recently enough ("gui/prefetch_max_age_sec")
+		/// to be shown without fetching it again. Always false if prefetching is disabled.
+		/// The drive must not have a fetch in progress.
+		[[nodiscard]] bool get_data_fresh(const StorageDevice& drive) const;
+
+
+	private:
+
+		/// Check whether a drive can and should be prefetched now
+		[[nodiscard]] bool get_prefetch_needed(const StorageDevice& drive) const;
+
+		/// Start the next prefetch (the target first), if none is running
+		void start_next();
+
+		/// Called when the asynchronous fetch is finished
+		void on_fetch_finished(StorageDevice* drive, const hz::ExpectedVoid<StorageDeviceError>& status);
+
+		/// Timeout callback, the target stayed long enough
+		static gboolean on_delay_timeout(gpointer data);
+
+
+		bool enabled_ = false;  ///< "gui/prefetch_full_data"
+		guint delay_msec_ = 0;  ///< "gui/prefetch_delay_msec"
+		std::chrono::seconds max_age_;  ///< "gui/prefetch_max_age_sec"
+
+		std::weak_ptr<StorageDevice> target_;  ///< See set_target()
+		bool target_due_ = false;  ///< The target delay has passed
+		guint delay_timeout_id_ = 0;  ///< on_delay_timeout() source
+		std::deque<std::weak_ptr<StorageDevice>> background_drives_;  ///< See set_background_drives()
+
+		StorageDevicePtr running_drive_;  ///< Drive being prefetched, nullptr if none
+		bool running_for_target_ = false;  ///< Whether running_drive_ is (was) the target
+		AppCancellationPtr running_cancellation_;  ///< Cancellation token of the running prefetch
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
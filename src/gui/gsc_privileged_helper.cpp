@@ -0,0 +1,237 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>  // compose()
+#include <glibmm/i18n.h>
+#include <memory>
+#include <utility>
+
+#include "hz/debug.h"
+
+#include "gsc_privileged_helper.h"
+
+
+
+namespace {
+
+	/// How often a call checks whether it was cancelled
+	constexpr guint privileged_helper_cancel_poll_msec = 100;
+
+
+	/// State of a pending call, filled by its callback
+	struct PrivilegedHelperCallState {
+		GVariant* reply = nullptr;  ///< Reply, nullptr on error
+		GError* error = nullptr;  ///< Error, nullptr on success
+		bool done = false;  ///< The callback was called
+	};
+
+
+	/// Convert a call error. The errors the helper itself returns are forwarded as they are.
+	hz::ErrorContainer<StoragePrivilegedHelperError> privileged_helper_convert_error(GError* error, bool cancelled)
+	{
+		if (cancelled) {
+			return {StoragePrivilegedHelperError::ExecutionError, _("The operation was cancelled.")};
+		}
+		// Not installed, cannot be started, or denied by the bus policy, unless the helper refused the request itself.
+		const bool refused = g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+		g_dbus_error_strip_remote_error(error);
+		return {refused ? StoragePrivilegedHelperError::InvalidRequest : StoragePrivilegedHelperError::Unavailable,
+				Glib::ustring::compose(_("Privileged helper error: %1"), error->message)};
+	}
+
+}
+
+
+
+GscPrivilegedHelper::GscPrivilegedHelper(GBusType bus_type)
+		: bus_type_(bus_type)
+{ }
+
+
+
+GscPrivilegedHelper::~GscPrivilegedHelper()
+{
+	if (connection_) {
+		g_object_unref(connection_);
+	}
+}
+
+
+
+hz::ExpectedValue<std::vector<StoragePrivilegedHelper::CachedDrive>, StoragePrivilegedHelperError>
+		GscPrivilegedHelper::get_drives()
+{
+	auto drives_reply = call("GetDrives", nullptr, "(a(tss))", -1, nullptr);
+	if (!drives_reply) {
+		return hz::UnexpectedFrom(drives_reply);
+	}
+
+	std::vector<guint64> drive_ids;
+	std::vector<CachedDrive> drives;
+	{
+		GVariantIter* iter = nullptr;
+		g_variant_get(drives_reply.value(), "(a(tss))", &iter);
+		guint64 drive_id = 0;
+		const gchar* device = nullptr;
+		const gchar* type_argument = nullptr;
+		while (g_variant_iter_next(iter, "(t&s&s)", &drive_id, &device, &type_argument)) {
+			drive_ids.push_back(drive_id);
+			CachedDrive drive;
+			drive.device = device;
+			drive.type_argument = type_argument;
+			drives.push_back(std::move(drive));
+		}
+		g_variant_iter_free(iter);
+		g_variant_unref(drives_reply.value());
+	}
+
+	for (std::size_t i = 0; i < drives.size(); ++i) {
+		auto outputs_reply = call("GetDriveOutputs", g_variant_new("(t)", drive_ids[i]), "(ssx)", -1, nullptr);
+		if (!outputs_reply) {
+			// The drive is fetched as usual then
+			debug_out_warn("app", DBG_FUNC_MSG << "Cannot get the cached outputs of " << drives[i].device
+					<< ": " << outputs_reply.error().message() << "\n");
+			continue;
+		}
+		const gchar* basic_output = nullptr;
+		const gchar* full_output = nullptr;
+		gint64 full_output_age = -1;
+		g_variant_get(outputs_reply.value(), "(&s&sx)", &basic_output, &full_output, &full_output_age);
+		drives[i].basic_output = basic_output;
+		drives[i].full_output = full_output;
+		if (full_output_age >= 0 && !drives[i].full_output.empty()) {
+			drives[i].full_output_age = std::chrono::seconds(full_output_age);
+		}
+		g_variant_unref(outputs_reply.value());
+	}
+
+	return drives;
+}
+
+
+
+hz::ExpectedVoid<StoragePrivilegedHelperError> GscPrivilegedHelper::execute_smartctl(const std::string& device,
+		const std::vector<std::string>& options, CommandOutputPtr& smartctl_output,
+		const AppCancellationPtr& cancellation)
+{
+	GVariantBuilder options_builder;
+	g_variant_builder_init(&options_builder, G_VARIANT_TYPE("as"));
+	for (const auto& option : options) {
+		g_variant_builder_add(&options_builder, "s", option.c_str());
+	}
+
+	// No timeout, the tests and the sleeping drives may take a while.
+	auto reply = call("ExecuteSmartctl", g_variant_new("(sas)", device.c_str(), &options_builder),
+			"(bss)", G_MAXINT, cancellation);
+	if (!reply) {
+		return hz::UnexpectedFrom(reply);
+	}
+
+	gboolean success = FALSE;
+	const gchar* output = nullptr;
+	const gchar* error_message = nullptr;
+	g_variant_get(reply.value(), "(b&s&s)", &success, &output, &error_message);
+	smartctl_output = std::make_shared<const std::string>(output);
+	const std::string error_str = error_message;
+	g_variant_unref(reply.value());
+
+	if (success == FALSE) {
+		return hz::Unexpected(StoragePrivilegedHelperError::ExecutionError, error_str);
+	}
+	return {};
+}
+
+
+
+hz::ExpectedValue<GDBusConnection*, StoragePrivilegedHelperError> GscPrivilegedHelper::get_connection()
+{
+	const std::scoped_lock lock(connection_mutex_);
+	if (!connection_) {
+		GError* error = nullptr;
+		connection_ = g_bus_get_sync(bus_type_, nullptr, &error);
+		if (!connection_) {
+			const std::string message = (error ? error->message : "");
+			if (error) {
+				g_error_free(error);
+			}
+			return hz::Unexpected(StoragePrivilegedHelperError::Unavailable,
+					Glib::ustring::compose(_("Cannot connect to D-Bus: %1"), message));
+		}
+	}
+	return connection_;
+}
+
+
+
+hz::ExpectedValue<GVariant*, StoragePrivilegedHelperError> GscPrivilegedHelper::call(const char* method_name,
+		GVariant* parameters, const char* reply_type, int timeout_msec, const AppCancellationPtr& cancellation)
+{
+	auto connection = get_connection();
+	if (!connection) {
+		if (parameters) {
+			g_variant_unref(g_variant_ref_sink(parameters));
+		}
+		return hz::UnexpectedFrom(connection);
+	}
+
+	// The reply callback is invoked in the calling thread's context, which we iterate below.
+	GMainContext* context = g_main_context_ref_thread_default();
+	GCancellable* cancellable = g_cancellable_new();
+	PrivilegedHelperCallState state;
+
+	g_dbus_connection_call(connection.value(), storage_helper_dbus_name, storage_helper_dbus_object_path,
+			storage_helper_dbus_interface, method_name, parameters, G_VARIANT_TYPE(reply_type),
+			G_DBUS_CALL_FLAGS_NONE, timeout_msec, cancellable,
+			[](GObject* source, GAsyncResult* result, gpointer user_data) {
+				auto* call_state = static_cast<PrivilegedHelperCallState*>(user_data);
+				call_state->reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &call_state->error);
+				call_state->done = true;
+			}, &state);
+
+	// Wake up periodically to check the cancellation
+	GSource* poll_source = nullptr;
+	if (cancellation) {
+		poll_source = g_timeout_source_new(privileged_helper_cancel_poll_msec);
+		g_source_set_callback(poll_source, [](gpointer) -> gboolean { return TRUE; }, nullptr, nullptr);
+		g_source_attach(poll_source, context);
+	}
+
+	bool cancelled = false;
+	while (!state.done) {
+		if (!cancelled && app_is_cancelled(cancellation)) {
+			g_cancellable_cancel(cancellable);  // the callback is still called
+			cancelled = true;
+		}
+		g_main_context_iteration(context, TRUE);
+	}
+
+	if (poll_source) {
+		g_source_destroy(poll_source);
+		g_source_unref(poll_source);
+	}
+	g_object_unref(cancellable);
+	g_main_context_unref(context);
+
+	if (!state.reply) {
+		auto error = privileged_helper_convert_error(state.error, cancelled);
+		debug_out_warn("app", DBG_FUNC_MSG << "D-Bus call " << method_name << " failed: " << error.message() << "\n");
+		g_error_free(state.error);
+		return hz::UnexpectedFromContainer(error);
+	}
+	return state.reply;
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,83 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_PRIVILEGED_HELPER_H
+#define GSC_PRIVILEGED_HELPER_H
+
+#include <gio/gio.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "applib/storage_privileged_helper.h"
+
+
+
+/// D-Bus client of "gsmartcontrol-agent --dbus" (see AgentDbusService), which the bus
+/// starts as root on the first call. Used when the GUI runs unprivileged.
+/// The connection is opened on the first call, so creating this is cheap.
+class GscPrivilegedHelper : public StoragePrivilegedHelper {
+	public:
+
+		/// Constructor. \c bus_type is the bus the agent is on (see "system/agent_dbus_bus").
+		explicit GscPrivilegedHelper(GBusType bus_type);
+
+		/// Deleted
+		GscPrivilegedHelper(const GscPrivilegedHelper& other) = delete;
+
+		/// Deleted
+		GscPrivilegedHelper(GscPrivilegedHelper&& other) = delete;
+
+		/// Deleted
+		GscPrivilegedHelper& operator=(const GscPrivilegedHelper& other) = delete;
+
+		/// Deleted
+		GscPrivilegedHelper& operator=(GscPrivilegedHelper&& other) = delete;
+
+		/// Destructor
+		~GscPrivilegedHelper() override;
+
+
+		// Reimplemented
+		[[nodiscard]] hz::ExpectedValue<std::vector<CachedDrive>, StoragePrivilegedHelperError> get_drives() override;
+
+		// Reimplemented
+		[[nodiscard]] hz::ExpectedVoid<StoragePrivilegedHelperError> execute_smartctl(const std::string& device,
+				const std::vector<std::string>& options, CommandOutputPtr& smartctl_output,
+				const AppCancellationPtr& cancellation) override;
+
+
+	private:
+
+		/// Get the bus connection, connecting if needed. Not owned by the caller.
+		[[nodiscard]] hz::ExpectedValue<GDBusConnection*, StoragePrivilegedHelperError> get_connection();
+
+		/// Call a method of the helper and wait for the reply, iterating the thread-default
+		/// main context. \c timeout_msec is as in g_dbus_connection_call(). \c parameters is
+		/// consumed if floating. \return the reply, which the caller must unref.
+		[[nodiscard]] hz::ExpectedValue<GVariant*, StoragePrivilegedHelperError> call(const char* method_name,
+				GVariant* parameters, const char* reply_type, int timeout_msec, const AppCancellationPtr& cancellation);
+
+
+		GBusType bus_type_ = G_BUS_TYPE_SYSTEM;  ///< Bus of the helper
+		std::mutex connection_mutex_;  ///< Protects connection_
+		GDBusConnection* connection_ = nullptr;  ///< Bus connection, nullptr until the first call
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
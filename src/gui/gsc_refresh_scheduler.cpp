@@ -0,0 +1,265 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <algorithm>
+#include <utility>
+
+#include "hz/debug.h"
+#include "rconfig/rconfig.h"
+#include "applib/smartctl_executor.h"
+#include "applib/storage_io_load.h"
+
+#include "gsc_refresh_scheduler.h"
+
+
+
+namespace {
+
+	/// How often the due refreshes are checked, milliseconds
+	constexpr guint refresh_check_interval_msec = 5000;
+
+}
+
+
+
+GscRefreshScheduler::GscRefreshScheduler()
+{
+	enabled_windows_ = rconfig::get_data<bool>("gui/auto_refresh_info_windows");
+	enabled_icons_ = rconfig::get_data<bool>("gui/auto_refresh_icons");
+	min_interval_ = std::chrono::seconds(std::max(1, rconfig::get_data<int>("gui/auto_refresh_min_interval_sec")));
+	max_interval_ = std::chrono::seconds(std::max(1, rconfig::get_data<int>("gui/auto_refresh_max_interval_sec")));
+	max_running_ = rconfig::get_data<int>("gui/auto_refresh_max_parallel");
+	standby_aware_ = rconfig::get_data<bool>("gui/auto_refresh_standby_aware");
+	io_load_max_defer_ = std::chrono::seconds(std::max(0, rconfig::get_data<int>("system/io_load_refresh_max_defer_sec")));
+
+	// request_refresh() works even if the periodic refreshes are disabled.
+	if (enabled_windows_ || enabled_icons_) {
+		timeout_id_ = g_timeout_add(refresh_check_interval_msec, &GscRefreshScheduler::on_timeout, this);
+	}
+}
+
+
+
+GscRefreshScheduler::~GscRefreshScheduler()
+{
+	// The running fetches keep their drives alive, and won't call us (we're sigc::trackable).
+	if (timeout_id_ != 0) {
+		g_source_remove(timeout_id_);
+	}
+}
+
+
+
+void GscRefreshScheduler::add_drive(const StorageDevicePtr& drive)
+{
+	if (!enabled_windows_) {
+		return;
+	}
+	if (auto* entry = get_entry(drive, true)) {
+		++entry->window_refs;
+	}
+}
+
+
+
+void GscRefreshScheduler::remove_drive(const StorageDevicePtr& drive)
+{
+	if (!enabled_windows_) {
+		return;
+	}
+	if (auto* entry = get_entry(drive, false)) {
+		entry->window_refs = std::max(0, entry->window_refs - 1);
+	}
+}
+
+
+
+void GscRefreshScheduler::set_icon_drives_slot(drives_slot_t slot)
+{
+	icon_drives_slot_ = std::move(slot);
+}
+
+
+
+void GscRefreshScheduler::request_refresh(const StorageDevicePtr& drive)
+{
+	auto* entry = get_entry(drive, true);
+	if (!entry || entry->running) {
+		return;  // the running fetch will have the fresh data
+	}
+	entry->requested = true;
+	entry->due = std::chrono::steady_clock::now();
+	run_due_refreshes();
+}
+
+
+
+sigc::signal<void, StorageDevice*>& GscRefreshScheduler::signal_refresh_started()
+{
+	return signal_refresh_started_;
+}
+
+
+
+sigc::signal<void, StorageDevice*, hz::ExpectedVoid<StorageDeviceError>>& GscRefreshScheduler::signal_refresh_finished()
+{
+	return signal_refresh_finished_;
+}
+
+
+
+GscRefreshScheduler::Entry* GscRefreshScheduler::get_entry(const StorageDevicePtr& drive, bool create)
+{
+	if (!drive || drive->get_is_virtual()) {
+		return nullptr;
+	}
+	auto iter = entries_.find(drive.get());
+	if (iter != entries_.end() && iter->second.drive.lock() != drive) {  // a destroyed drive at the same address
+		entries_.erase(iter);
+		iter = entries_.end();
+	}
+	if (iter == entries_.end()) {
+		if (!create) {
+			return nullptr;
+		}
+		// The drive has just been fetched (or it's an icon), so wait for the first interval.
+		Entry entry {drive, 0, false, false, StorageRefreshPolicy(min_interval_, max_interval_),
+				std::chrono::steady_clock::now() + min_interval_, false, std::nullopt};
+		iter = entries_.emplace(drive.get(), std::move(entry)).first;
+	}
+	return &iter->second;
+}
+
+
+
+void GscRefreshScheduler::run_due_refreshes()
+{
+	if (enabled_icons_ && icon_drives_slot_) {
+		for (auto& [ptr, entry] : entries_) {
+			entry.from_icons = false;
+		}
+		for (const auto& drive : icon_drives_slot_()) {
+			if (drive && drive->get_smart_status() == StorageDevice::SmartStatus::Enabled) {
+				if (auto* entry = get_entry(drive, true)) {
+					entry->from_icons = true;
+				}
+			}
+		}
+	}
+
+	// Drop the entries nobody needs anymore
+	for (auto iter = entries_.begin(); iter != entries_.end(); ) {
+		const Entry& entry = iter->second;
+		if (!entry.running && (entry.drive.expired()
+				|| (entry.window_refs == 0 && !entry.from_icons && !entry.requested))) {
+			iter = entries_.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+
+	// Start the due refreshes, the most overdue first
+	const auto now = std::chrono::steady_clock::now();
+	std::vector<Entry*> due;
+	for (auto& [ptr, entry] : entries_) {
+		if (!entry.running && entry.due <= now) {
+			due.push_back(&entry);
+		}
+	}
+	std::sort(due.begin(), due.end(), [](const Entry* a, const Entry* b) { return a->due < b->due; });
+
+	const auto io_load_guard = storage_io_load_guard_get_global();
+
+	for (Entry* entry : due) {
+		if (max_running_ > 0 && running_ >= max_running_) {
+			break;  // the rest stay due until a running fetch finishes
+		}
+		StorageDevicePtr drive = entry->drive.lock();
+		if (drive->get_test_is_active() || drive->get_fetch_in_progress()) {
+			// Tests refresh the data themselves, and a manual refresh has fresh data.
+			entry->due = now + entry->policy.get_interval();
+			entry->requested = false;
+			continue;
+		}
+
+		// Don't compete with a latency-sensitive workload, unless asked to or deferred for too long
+		if (io_load_guard && !entry->requested && io_load_guard->get_busy(*drive)) {
+			if (!entry->deferred_since) {
+				entry->deferred_since = now;
+			}
+			if (now - entry->deferred_since.value() < io_load_max_defer_) {
+				debug_out_dump("app", DBG_FUNC_MSG << "Deferring the refresh of busy " << drive->get_device_with_type() << ".\n");
+				continue;  // still due, checked again on the next timeout
+			}
+		}
+		entry->deferred_since.reset();
+
+		debug_out_dump("app", DBG_FUNC_MSG << "Refreshing " << drive->get_device_with_type() << ".\n");
+		entry->running = true;
+		entry->requested = false;
+		++running_;
+
+		signal_refresh_started_.emit(drive.get());
+		drive->set_standby_aware(standby_aware_);  // reset when finished, a manual refresh should wake it up
+		auto smartctl_ex = std::make_shared<SmartctlExecutor>();
+		smartctl_ex->set_priority(CommandPriority::BackgroundRefresh);  // the user's own commands go first
+		drive->fetch_full_data_and_parse_async(smartctl_ex,
+				sigc::mem_fun(*this, &GscRefreshScheduler::on_fetch_finished));
+	}
+}
+
+
+
+void GscRefreshScheduler::on_fetch_finished(StorageDevice* drive, const hz::ExpectedVoid<StorageDeviceError>& status)
+{
+	--running_;
+	drive->set_standby_aware(false);
+
+	if (auto iter = entries_.find(drive); iter != entries_.end()) {
+		Entry& entry = iter->second;
+		entry.running = false;
+		// Keep the old interval if the fetch failed. Sleeping drives are checked
+		// often (this doesn't wake them up), to catch the moment they wake up.
+		std::chrono::seconds interval = entry.policy.get_interval();
+		if (status && drive->get_in_standby()) {
+			interval = min_interval_;
+		} else if (status) {
+			interval = entry.policy.update(drive->get_property_repository());
+		}
+		entry.due = std::chrono::steady_clock::now() + interval;
+		debug_out_dump("app", DBG_FUNC_MSG << "Next refresh of " << drive->get_device_with_type()
+				<< " in " << interval.count() << " seconds.\n");
+	}
+	if (!status) {
+		debug_out_warn("app", DBG_FUNC_MSG << "Cannot refresh " << drive->get_device_with_type()
+				<< ": " << status.error().message() << "\n");
+	}
+
+	signal_refresh_finished_.emit(drive, status);
+
+	run_due_refreshes();  // start the queued ones
+}
+
+
+
+gboolean GscRefreshScheduler::on_timeout(gpointer data)
+{
+	auto* self = static_cast<GscRefreshScheduler*>(data);
+	self->run_due_refreshes();
+	return TRUE;  // keep checking
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,141 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_REFRESH_SCHEDULER_H
+#define GSC_REFRESH_SCHEDULER_H
+
+#include <glib.h>
+#include <sigc++/sigc++.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "applib/storage_device.h"
+#include "applib/storage_refresh_policy.h"
+
+
+
+/// Periodically re-fetches the full data of the drives with open info windows
+/// (and optionally, of all the drives in the main window), with adaptive intervals
+/// (see StorageRefreshPolicy).
+/// At most "gui/auto_refresh_max_parallel" drives are refreshed at the same time,
+/// and the refresh requests for a drive which is queued or being refreshed are coalesced.
+/// With "gui/auto_refresh_standby_aware", the periodic refreshes don't spin up sleeping
+/// drives. These are checked every minimum interval instead (which doesn't wake them up),
+/// so that they are refreshed soon after something else wakes them up.
+/// The periodic refreshes of the drives busy with I/O (see storage_io_load_guard_get_global())
+/// are deferred, for at most "system/io_load_refresh_max_defer_sec".
+class GscRefreshScheduler : public sigc::trackable {
+	public:
+
+		/// Slot providing all the drives of the main window
+		using drives_slot_t = sigc::slot<std::vector<StorageDevicePtr>>;
+
+		/// Constructor. Reads the settings.
+		GscRefreshScheduler();
+
+		/// Deleted
+		GscRefreshScheduler(const GscRefreshScheduler& other) = delete;
+
+		/// Deleted
+		GscRefreshScheduler(GscRefreshScheduler&& other) = delete;
+
+		/// Deleted
+		GscRefreshScheduler& operator=(const GscRefreshScheduler& other) = delete;
+
+		/// Deleted
+		GscRefreshScheduler& operator=(GscRefreshScheduler&& other) = delete;
+
+		/// Destructor
+		~GscRefreshScheduler();
+
+
+		/// Refresh a drive periodically (an info window is open for it) until remove_drive().
+		/// Each add_drive() must be paired with remove_drive(). Does nothing if disabled in settings.
+		void add_drive(const StorageDevicePtr& drive);
+
+		/// Undo add_drive()
+		void remove_drive(const StorageDevicePtr& drive);
+
+		/// Set the slot providing the main window drives. They are refreshed
+		/// if "gui/auto_refresh_icons" is enabled.
+		void set_icon_drives_slot(drives_slot_t slot);
+
+
+		/// Refresh a drive as soon as possible. A request for a drive which is already
+		/// queued or being refreshed is merged with it.
+		void request_refresh(const StorageDevicePtr& drive);
+
+
+		/// Emitted (in the main thread) before our fetch of the drive is started.
+		/// The drive data must not be accessed until signal_refresh_finished().
+		sigc::signal<void, StorageDevice*>& signal_refresh_started();
+
+		/// Emitted when our fetch of the drive is finished
+		sigc::signal<void, StorageDevice*, hz::ExpectedVoid<StorageDeviceError>>& signal_refresh_finished();
+
+
+	private:
+
+		/// A scheduled drive
+		struct Entry {
+			std::weak_ptr<StorageDevice> drive;  ///< The drive
+			int window_refs = 0;  ///< Number of add_drive() calls
+			bool from_icons = false;  ///< Whether it comes from the icons slot
+			bool requested = false;  ///< Whether request_refresh() was called for it
+			StorageRefreshPolicy policy;  ///< Interval calculation
+			std::chrono::steady_clock::time_point due;  ///< When the next refresh is due
+			bool running = false;  ///< Whether our fetch is running
+			std::optional<std::chrono::steady_clock::time_point> deferred_since;  ///< When the refresh was first deferred because of I/O load
+		};
+
+
+		/// Find or create an entry. \return nullptr if it cannot be refreshed (e.g. a virtual drive).
+		Entry* get_entry(const StorageDevicePtr& drive, bool create);
+
+		/// Update the icon drives, start the refreshes which are due, drop the unused entries
+		void run_due_refreshes();
+
+		/// Called when the asynchronous fetch is finished
+		void on_fetch_finished(StorageDevice* drive, const hz::ExpectedVoid<StorageDeviceError>& status);
+
+		/// Timeout callback
+		static gboolean on_timeout(gpointer data);
+
+
+		bool enabled_windows_ = false;  ///< "gui/auto_refresh_info_windows"
+		bool enabled_icons_ = false;  ///< "gui/auto_refresh_icons"
+		std::chrono::seconds min_interval_;  ///< "gui/auto_refresh_min_interval_sec"
+		std::chrono::seconds max_interval_;  ///< "gui/auto_refresh_max_interval_sec"
+		int max_running_ = 1;  ///< "gui/auto_refresh_max_parallel"
+		bool standby_aware_ = false;  ///< "gui/auto_refresh_standby_aware"
+		std::chrono::seconds io_load_max_defer_;  ///< "system/io_load_refresh_max_defer_sec"
+
+		drives_slot_t icon_drives_slot_;  ///< See set_icon_drives_slot()
+		std::map<StorageDevice*, Entry> entries_;  ///< Scheduled drives
+		int running_ = 0;  ///< Number of running fetches
+		guint timeout_id_ = 0;  ///< on_timeout() source
+
+		sigc::signal<void, StorageDevice*> signal_refresh_started_;  ///< Signal
+		sigc::signal<void, StorageDevice*, hz::ExpectedVoid<StorageDeviceError>> signal_refresh_finished_;  ///< Signal
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,327 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <gtkmm.h>
+#include <gdk/gdk.h>  // GDK_KEY_Escape
+#include <ctime>
+#include <utility>
+
+#include "hz/format_unit.h"  // format_date
+#include "hz/string_algo.h"  // string_join
+
+#include "applib/app_gtkmm_tools.h"  // app_gtkmm_*
+#include "applib/gui_utils.h"  // gui_show_error_dialog
+#include "applib/storage_property_diff.h"
+#include "applib/warning_colors.h"
+#include "applib/worker_threads.h"
+
+#include "gsc_snapshot_compare_window.h"
+
+
+
+GscSnapshotCompareWindow::GscSnapshotCompareWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui)
+		: AppBuilderWidget<GscSnapshotCompareWindow, false>(gtkcobj, std::move(ui))
+{
+	// Connect callbacks
+
+	Gtk::Button* window_close_button = nullptr;
+	APP_BUILDER_AUTO_CONNECT(window_close_button, clicked);
+
+	Gtk::ComboBoxText* serial_combo = nullptr;
+	APP_BUILDER_AUTO_CONNECT(serial_combo, changed);
+	serial_combo_ = serial_combo;
+
+	Gtk::ComboBoxText* old_combo = nullptr;
+	APP_BUILDER_AUTO_CONNECT(old_combo, changed);
+	old_combo_ = old_combo;
+
+	Gtk::ComboBoxText* new_combo = nullptr;
+	APP_BUILDER_AUTO_CONNECT(new_combo, changed);
+	new_combo_ = new_combo;
+
+
+	// Accelerators
+
+	const Glib::RefPtr<Gtk::AccelGroup> accel_group = this->get_accel_group();
+	if (window_close_button) {
+		window_close_button->add_accelerator("clicked", accel_group, GDK_KEY_Escape,
+				Gdk::ModifierType(0), Gtk::AccelFlags(0));
+	}
+
+
+	// --------------- Make a treeview
+
+	if (auto* treeview = this->lookup_widget<Gtk::TreeView*>("diff_treeview")) {
+		Gtk::TreeModelColumnRecord model_columns;
+
+		// Highlight the rows by their warnings
+		const auto add_column = [&](const Gtk::TreeModelColumn<Glib::ustring>& column,
+				const Glib::ustring& title, const Glib::ustring& tooltip) {
+			model_columns.add(column);
+			const int num_tree_cols = app_gtkmm_create_tree_view_column(column, *treeview, title, tooltip, true);
+			Gtk::TreeViewColumn* tcol = treeview->get_column(num_tree_cols - 1);
+			tcol->set_cell_data_func(*(tcol->get_first_cell()), [this](Gtk::CellRenderer* cr, const Gtk::TreeModel::iterator& iter) {
+				auto* crt = dynamic_cast<Gtk::CellRendererText*>(cr);
+				if (!crt) {
+					return;
+				}
+				std::string fg, bg;
+				if (app_property_get_row_highlight_colors(static_cast<WarningLevel>(int((*iter)[col_warning_])), fg, bg)) {
+					crt->property_cell_background() = bg;
+					crt->property_foreground() = fg;
+				} else {
+					crt->property_cell_background().reset_value();
+					crt->property_foreground().reset_value();
+				}
+			});
+		};
+
+		add_column(col_change_, _("Change"), _("Whether the property was added, removed or changed"));
+		add_column(col_section_, _("Section"), _("Section of the property"));
+		add_column(col_name_, _("Property"), _("Property name"));
+		add_column(col_old_value_, _("Old Value"), _("Value in the older snapshot"));
+		add_column(col_new_value_, _("New Value"), _("Value in the newer snapshot"));
+
+		model_columns.add(col_tooltip_);
+		treeview->set_tooltip_column(col_tooltip_.index());
+
+		model_columns.add(col_warning_);
+
+		list_store_ = Gtk::ListStore::create(model_columns);
+		treeview->set_model(list_store_);
+	}
+
+	// show();
+}
+
+
+
+void GscSnapshotCompareWindow::set_drives(std::vector<StorageDevicePtr> drives)
+{
+	drives_ = std::move(drives);
+	update_snapshot_combos();
+}
+
+
+
+void GscSnapshotCompareWindow::open_directory(const hz::fs::path& dir)
+{
+	this->set_title(Glib::ustring::compose(_("Snapshot Comparison - %1 - GSmartControl"), hz::fs_path_to_string(dir)));
+
+	// Only the new snapshots are read, but there may be many of them
+	std::vector<std::string> errors;
+	hz::ExpectedVoid<StorageSnapshotIndexError> scan_status;
+	this->set_sensitive(false);
+	{
+		AppTaskGroup group(1);
+		group.run([&]() {
+			scan_status = index_.scan(dir, errors);
+		});
+		group.wait();
+	}
+	this->set_sensitive(true);
+
+	if (!scan_status) {
+		gui_show_error_dialog(_("Cannot read the snapshots"), scan_status.error().message(), this);
+	} else if (!errors.empty()) {
+		gui_show_error_dialog(_("Some snapshots cannot be read"), hz::string_join(errors, "\n"), this);
+	}
+
+	updating_combos_ = true;
+	serials_ = index_.get_serials();
+	if (serial_combo_) {
+		serial_combo_->remove_all();
+		for (const auto& serial : serials_) {
+			const auto entries = index_.get_entries(serial);
+			const std::string model = entries.empty() ? std::string() : entries.back().model;
+			serial_combo_->append(Glib::ustring::compose(_("%1 (%2 snapshots)"),
+					(serial.empty() ? Glib::ustring(_("No Serial Number")) : Glib::ustring(serial))
+					+ (model.empty() ? Glib::ustring() : Glib::ustring(" - " + model)), entries.size()));
+		}
+		serial_combo_->set_active(serials_.empty() ? -1 : 0);
+	}
+	updating_combos_ = false;
+
+	update_snapshot_combos();
+}
+
+
+
+void GscSnapshotCompareWindow::update_snapshot_combos()
+{
+	if (!serial_combo_ || !old_combo_ || !new_combo_) {
+		return;
+	}
+	const int serial_index = serial_combo_->get_active_row_number();
+	const std::string serial = (serial_index >= 0 && static_cast<std::size_t>(serial_index) < serials_.size())
+			? serials_[static_cast<std::size_t>(serial_index)] : std::string();
+
+	sources_.clear();
+	if (serial_index >= 0) {
+		for (const auto& entry : index_.get_entries(serial)) {
+			sources_.push_back({&entry, nullptr});
+		}
+		if (!serial.empty()) {
+			for (const auto& drive : drives_) {
+				if (drive->get_serial_number() == serial) {
+					sources_.push_back({nullptr, drive});
+				}
+			}
+		}
+	}
+
+	updating_combos_ = true;
+	for (auto* combo : {old_combo_, new_combo_}) {
+		combo->remove_all();
+		for (const auto& source : sources_) {
+			if (source.entry) {
+				combo->append(hz::format_date("%Y-%m-%d %H:%M:%S", static_cast<std::time_t>(source.entry->time), false)
+						+ " - " + hz::fs_path_to_string(source.entry->file));
+			} else {
+				combo->append(Glib::ustring::compose(_("Current Data - %1"), source.drive->get_device_with_type()));
+			}
+		}
+	}
+	// The newest ones by default
+	const auto count = static_cast<int>(sources_.size());
+	old_combo_->set_active(count >= 2 ? count - 2 : count - 1);
+	new_combo_->set_active(count - 1);
+	updating_combos_ = false;
+
+	update_diff();
+}
+
+
+
+void GscSnapshotCompareWindow::update_diff()
+{
+	if (!list_store_ || !old_combo_ || !new_combo_) {
+		return;
+	}
+	list_store_->clear();
+
+	auto* status_label = this->lookup_widget<Gtk::Label*>("status_label");
+	const int old_index = old_combo_->get_active_row_number();
+	const int new_index = new_combo_->get_active_row_number();
+	if (old_index < 0 || new_index < 0) {
+		if (status_label) {
+			status_label->set_text(_("No snapshots to compare."));
+		}
+		return;
+	}
+
+	const auto old_repo = load_source(old_index);
+	const auto new_repo = load_source(new_index);
+	if (!old_repo || !new_repo) {
+		if (status_label) {
+			status_label->set_text(_("Cannot load the snapshots."));
+		}
+		return;
+	}
+
+	const StoragePropertyDiff diff = storage_property_repository_diff(*old_repo, *new_repo);
+	for (const auto& change : diff.changes) {
+		const StorageProperty& p = (change.new_property.has_value() ? change.new_property.value() : change.old_property.value());
+		Gtk::TreeRow row = *(list_store_->append());
+		switch (change.type) {
+			case StoragePropertyChange::Type::Added: row[col_change_] = _("Added"); break;
+			case StoragePropertyChange::Type::Removed: row[col_change_] = _("Removed"); break;
+			case StoragePropertyChange::Type::Changed: row[col_change_] = _("Changed"); break;
+		}
+		row[col_section_] = StoragePropertySectionExt::get_displayable_name(p.section);
+		row[col_name_] = p.displayable_name.empty() ? p.generic_name : p.displayable_name;
+		row[col_old_value_] = change.old_property.has_value() ? change.old_property->format_value() : std::string();
+		row[col_new_value_] = change.new_property.has_value() ? change.new_property->format_value() : std::string();
+		row[col_tooltip_] = p.generic_name;
+		row[col_warning_] = static_cast<int>(change.type == StoragePropertyChange::Type::Removed
+				? change.get_old_warning_level() : change.get_new_warning_level());
+	}
+
+	if (status_label) {
+		status_label->set_text(Glib::ustring::compose(_("%1 of %2 properties differ."),
+				diff.changes.size(), new_repo->get_properties().size()));
+	}
+}
+
+
+
+std::shared_ptr<const StoragePropertyRepository> GscSnapshotCompareWindow::load_source(int index)
+{
+	const Source& source = sources_.at(static_cast<std::size_t>(index));
+	if (source.drive) {
+		// Keep the snapshot alive as long as its properties are used
+		const StorageDevice::SnapshotPtr snapshot = source.drive->get_snapshot();
+		return {snapshot, &snapshot->property_repository};
+	}
+	auto repository = index_.load(*source.entry);
+	if (!repository) {
+		gui_show_error_dialog(_("Cannot load the snapshot"), repository.error().message(), this);
+		return nullptr;
+	}
+	return repository.value();
+}
+
+
+
+bool GscSnapshotCompareWindow::on_delete_event([[maybe_unused]] GdkEventAny* e)
+{
+	on_window_close_button_clicked();
+	return true;  // event handled
+}
+
+
+
+void GscSnapshotCompareWindow::on_window_close_button_clicked()
+{
+	// Don't keep the drives while hidden
+	drives_.clear();
+	sources_.clear();
+	if (list_store_) {
+		list_store_->clear();
+	}
+	this->hide();  // hide only, don't destroy
+}
+
+
+
+void GscSnapshotCompareWindow::on_serial_combo_changed()
+{
+	if (!updating_combos_) {
+		update_snapshot_combos();
+	}
+}
+
+
+
+void GscSnapshotCompareWindow::on_old_combo_changed()
+{
+	if (!updating_combos_) {
+		update_diff();
+	}
+}
+
+
+
+void GscSnapshotCompareWindow::on_new_combo_changed()
+{
+	if (!updating_combos_) {
+		update_diff();
+	}
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,122 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_SNAPSHOT_COMPARE_WINDOW_H
+#define GSC_SNAPSHOT_COMPARE_WINDOW_H
+
+#include <gtkmm.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "applib/app_builder_widget.h"
+#include "applib/storage_device.h"
+#include "applib/storage_snapshot_index.h"
+
+
+
+/// The "Snapshot Comparison" window. It indexes a directory of property snapshots
+/// (see StorageSnapshotIndex) and shows the differing properties of any two snapshots
+/// of the same drive (see storage_property_repository_diff()). The current data of a
+/// loaded drive with the same serial number can be compared too. Nothing is parsed.
+/// Use create() / destroy() with this class instead of new / delete!
+class GscSnapshotCompareWindow : public AppBuilderWidget<GscSnapshotCompareWindow, false> {
+	public:
+
+		// name of ui file (without .ui extension) for AppBuilderWidget
+		static inline const std::string_view ui_name = "gsc_snapshot_compare_window";
+
+
+		/// Constructor, GtkBuilder needs this.
+		GscSnapshotCompareWindow(BaseObjectType* gtkcobj, Glib::RefPtr<Gtk::Builder> ui);
+
+
+		/// Set the drives whose current data may be compared with their snapshots
+		void set_drives(std::vector<StorageDevicePtr> drives);
+
+
+		/// Index the snapshots in a directory and show the first drive
+		void open_directory(const hz::fs::path& dir);
+
+
+	protected:
+
+		/// Fill the snapshot combos with the snapshots of the selected drive
+		void update_snapshot_combos();
+
+
+		/// Compare the selected snapshots and fill the tree view
+		void update_diff();
+
+
+		/// Get the properties of a combo entry (see sources_). Shows an error and returns nullptr on error.
+		[[nodiscard]] std::shared_ptr<const StoragePropertyRepository> load_source(int index);
+
+
+		// ---------- overridden virtual methods
+
+		/// Hide the window, don't destroy.
+		/// Reimplemented from Gtk::Window.
+		bool on_delete_event(GdkEventAny* e) override;
+
+
+		// ---------- other callbacks
+
+		/// Button click callback
+		void on_window_close_button_clicked();
+
+		/// Combo change callback
+		void on_serial_combo_changed();
+
+		/// Combo change callback
+		void on_old_combo_changed();
+
+		/// Combo change callback
+		void on_new_combo_changed();
+
+
+	private:
+
+		/// A comparable snapshot: an indexed snapshot file or the current data of a drive
+		struct Source {
+			const StorageSnapshotIndexEntry* entry = nullptr;  ///< Indexed snapshot, if not a drive
+			StorageDevicePtr drive;  ///< Drive with the current data, if not a snapshot
+		};
+
+		StorageSnapshotIndex index_;  ///< Snapshot index
+		std::vector<std::string> serials_;  ///< Serial numbers in serial_combo
+		std::vector<Source> sources_;  ///< Entries of old_combo and new_combo
+		std::vector<StorageDevicePtr> drives_;  ///< Loaded drives
+		bool updating_combos_ = false;  ///< Whether the combos are being filled (their callbacks do nothing)
+
+		Gtk::ComboBoxText* serial_combo_ = nullptr;  ///< Drive combobox
+		Gtk::ComboBoxText* old_combo_ = nullptr;  ///< Old snapshot combobox
+		Gtk::ComboBoxText* new_combo_ = nullptr;  ///< New snapshot combobox
+
+		Glib::RefPtr<Gtk::ListStore> list_store_;  ///< List store
+		Gtk::TreeModelColumn<Glib::ustring> col_change_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_section_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_name_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_old_value_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_new_value_;  ///< Tree column
+		Gtk::TreeModelColumn<Glib::ustring> col_tooltip_;  ///< Tree column
+		Gtk::TreeModelColumn<int> col_warning_;  ///< Tree column, WarningLevel after the change (before it if removed)
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
@@ -20,6 +20,9 @@ struct GscStartupSettings {
 	bool no_scan = false;  ///< No scanning on startup
 	std::vector<std::string> load_virtuals;  ///< Virtual files to load
 	std::vector<std::string> add_devices;  ///< Devices to add (with options)
+	std::string inventory_file;  ///< Drive inventory to use instead of scanning, overrides "system/inventory_file"
+	int benchmark_drives = 0;  ///< If positive, run the GUI benchmark with this many synthetic virtual drives
+	int benchmark_info_windows = 0;  ///< Number of info windows opened by the GUI benchmark
 
 };
 
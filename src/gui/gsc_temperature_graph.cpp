@@ -0,0 +1,260 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#include <glibmm.h>
+#include <glibmm/i18n.h>
+#include <gtkmm.h>
+#include <cairomm/cairomm.h>
+#include <algorithm>  // std::max, std::equal
+#include <cmath>  // std::floor, std::ceil
+#include <cstddef>  // std::ptrdiff_t
+#include <ctime>
+
+#include "hz/format_unit.h"  // format_date
+#include "hz/string_num.h"  // number_to_string_locale
+
+#include "gsc_temperature_graph.h"
+
+
+
+namespace {
+
+	/// Margins around the plot area, in pixels. The left and bottom ones hold the axis labels.
+	constexpr int graph_margin_left = 56;
+	constexpr int graph_margin_right = 8;
+	constexpr int graph_margin_top = 8;
+	constexpr int graph_margin_bottom = 22;
+
+	/// Minimal visible time range and the free space after the last sample (for the
+	/// incremental additions), in seconds.
+	constexpr std::int64_t graph_min_headroom = 60 * 60;
+
+
+	/// Format a temperature axis label
+	Glib::ustring temperature_graph_format_value(std::int64_t value)
+	{
+		return Glib::ustring::compose(C_("temperature", "%1° C"), hz::number_to_string_locale(value));
+	}
+
+
+	/// Format a time axis label
+	Glib::ustring temperature_graph_format_time(std::int64_t time)
+	{
+		return hz::format_date("%Y-%m-%d %H:%M", static_cast<std::time_t>(time), false);
+	}
+
+
+	/// Draw a text at (x, y), optionally aligning its right / bottom edge to it
+	void temperature_graph_draw_text(Gtk::Widget& widget, const Cairo::RefPtr<Cairo::Context>& cr,
+			const Glib::ustring& text, double x, double y, bool align_right = false, bool align_bottom = false)
+	{
+		Glib::RefPtr<Pango::Layout> layout = widget.create_pango_layout(text);
+		int layout_w = 0, layout_h = 0;
+		layout->get_pixel_size(layout_w, layout_h);
+		cr->move_to(align_right ? x - layout_w : x, align_bottom ? y - layout_h : y);
+		layout->show_in_cairo_context(cr);
+	}
+
+}
+
+
+
+GscTemperatureGraph::GscTemperatureGraph()
+{
+	set_size_request(-1, 160);
+}
+
+
+
+void GscTemperatureGraph::set_samples(std::vector<StorageHistoryPoint> samples)
+{
+	// The usual case for the auto-refresh: the old samples are a prefix of the new ones,
+	// and the new ones fit into the headroom of the time range.
+	const bool is_extension = !samples_.empty() && !buckets_.get_buckets().empty()
+			&& samples.size() >= samples_.size()
+			&& std::equal(samples_.begin(), samples_.end(), samples.begin(),
+					[](const StorageHistoryPoint& a, const StorageHistoryPoint& b) {
+						return a.time == b.time && a.value == b.value;
+					})
+			&& std::all_of(samples.begin() + static_cast<std::ptrdiff_t>(samples_.size()), samples.end(),
+					[this](const StorageHistoryPoint& p) { return buckets_.get_bucket_index(p.time).has_value(); });
+
+	if (!is_extension) {
+		samples_ = std::move(samples);
+		rebuild_buckets();
+		queue_draw();
+		return;
+	}
+
+	std::optional<std::size_t> first_changed, last_changed;
+	for (std::size_t i = samples_.size(); i < samples.size(); ++i) {
+		if (auto index = buckets_.add(samples[i])) {
+			first_changed = std::min(first_changed.value_or(index.value()), index.value());
+			last_changed = std::max(last_changed.value_or(index.value()), index.value());
+		}
+	}
+	samples_ = std::move(samples);
+
+	if (!first_changed.has_value()) {
+		return;
+	}
+
+	// The vertical scale changed, everything moves.
+	const auto value_range = buckets_.get_value_range();
+	if (value_range != value_range_) {
+		value_range_ = value_range;
+		queue_draw();
+		return;
+	}
+
+	// Include the neighbouring columns, the polyline connects to them.
+	const int x_begin = get_bucket_x(first_changed.value() > 0 ? first_changed.value() - 1 : 0);
+	const int x_end = get_bucket_x(std::min(last_changed.value() + 1, buckets_.get_buckets().size() - 1)) + 1;
+	queue_draw_area(x_begin, 0, x_end - x_begin + 1, get_allocated_height());
+}
+
+
+
+bool GscTemperatureGraph::has_samples() const
+{
+	return !samples_.empty();
+}
+
+
+
+bool GscTemperatureGraph::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
+{
+	const int width = get_allocated_width();
+	const int height = get_allocated_height();
+	const int plot_w = get_plot_width();
+	const int plot_h = height - graph_margin_top - graph_margin_bottom;
+	if (plot_w <= 0 || plot_h <= 0) {
+		return true;
+	}
+
+	const Gdk::RGBA color = get_style_context()->get_color(get_state_flags());
+	cr->set_line_width(1.);
+
+	// Plot frame
+	cr->set_source_rgba(color.get_red(), color.get_green(), color.get_blue(), color.get_alpha() * 0.3);
+	cr->rectangle(graph_margin_left + 0.5, graph_margin_top + 0.5, plot_w - 1, plot_h - 1);
+	cr->stroke();
+
+	if (!value_range_.has_value()) {
+		return true;
+	}
+
+	// Keep some space above and below the line
+	const std::int64_t value_low = value_range_->first - 1;
+	const std::int64_t value_high = value_range_->second + 1;
+	auto get_y = [&](std::int64_t value) {
+		return graph_margin_top + 0.5 + double(value_high - value) * (plot_h - 1) / double(value_high - value_low);
+	};
+
+	// Axis labels
+	cr->set_source_rgba(color.get_red(), color.get_green(), color.get_blue(), color.get_alpha());
+	temperature_graph_draw_text(*this, cr, temperature_graph_format_value(value_range_->second),
+			graph_margin_left - 4, get_y(value_range_->second) - 8, true);
+	temperature_graph_draw_text(*this, cr, temperature_graph_format_value(value_range_->first),
+			graph_margin_left - 4, get_y(value_range_->first) - 8, true);
+	temperature_graph_draw_text(*this, cr, temperature_graph_format_time(buckets_.get_from()),
+			graph_margin_left, height, false, true);
+	temperature_graph_draw_text(*this, cr, temperature_graph_format_time(buckets_.get_to()),
+			width - graph_margin_right, height, true, true);
+
+	// Only walk the columns inside the clip region (set by queue_draw_area()).
+	double clip_x1 = 0, clip_y1 = 0, clip_x2 = 0, clip_y2 = 0;
+	cr->get_clip_extents(clip_x1, clip_y1, clip_x2, clip_y2);
+
+	const auto& buckets = buckets_.get_buckets();
+	const auto first_index = static_cast<std::size_t>(std::max(0., std::floor(clip_x1) - graph_margin_left - 1));
+	const auto last_index = static_cast<std::size_t>(std::max(0., std::ceil(clip_x2) - graph_margin_left + 1));
+
+	// Start the polyline at the last non-empty column before the clip region
+	std::optional<std::size_t> prev_index;
+	for (std::size_t i = std::min(first_index, buckets.size()); i > 0; --i) {
+		if (buckets[i - 1].has_data) {
+			prev_index = i - 1;
+			break;
+		}
+	}
+
+	cr->set_line_width(1.5);
+	for (std::size_t i = first_index; i < buckets.size() && i <= last_index; ++i) {
+		const auto& bucket = buckets[i];
+		if (!bucket.has_data) {
+			continue;
+		}
+		const double x = get_bucket_x(i) + 0.5;
+		if (prev_index.has_value()) {
+			const auto& prev = buckets[prev_index.value()];
+			cr->move_to(get_bucket_x(prev_index.value()) + 0.5, get_y(bucket.min >= prev.max ? prev.max : prev.min));
+			cr->line_to(x, get_y(bucket.min >= prev.max ? bucket.min : bucket.max));
+		}
+		// The min/max segment of the column (at least a dot)
+		cr->move_to(x, get_y(bucket.max) - (bucket.min == bucket.max ? 0.75 : 0.));
+		cr->line_to(x, get_y(bucket.min) + (bucket.min == bucket.max ? 0.75 : 0.));
+		prev_index = i;
+	}
+	cr->stroke();
+
+	return true;
+}
+
+
+
+void GscTemperatureGraph::on_size_allocate(Gtk::Allocation& allocation)
+{
+	const int old_plot_width = get_plot_width();
+	Gtk::DrawingArea::on_size_allocate(allocation);
+	if (get_plot_width() != old_plot_width) {
+		rebuild_buckets();
+	}
+}
+
+
+
+void GscTemperatureGraph::rebuild_buckets()
+{
+	const int plot_w = get_plot_width();
+	if (samples_.empty() || plot_w <= 0) {
+		buckets_.reset(0, 0, 0);
+		value_range_ = std::nullopt;
+		return;
+	}
+
+	const std::int64_t from = samples_.front().time;
+	const std::int64_t span = std::max(samples_.back().time - from, graph_min_headroom);
+	buckets_.reset(from, from + span + std::max(span / 10, graph_min_headroom), static_cast<std::size_t>(plot_w));
+	buckets_.add(samples_);
+	value_range_ = buckets_.get_value_range();
+}
+
+
+
+int GscTemperatureGraph::get_plot_width() const
+{
+	return get_allocated_width() - graph_margin_left - graph_margin_right;
+}
+
+
+
+int GscTemperatureGraph::get_bucket_x(std::size_t index) const
+{
+	return graph_margin_left + static_cast<int>(index);
+}
+
+
+
+
+
+
+/// @}
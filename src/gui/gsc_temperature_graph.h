@@ -0,0 +1,84 @@
+/******************************************************************************
+License: GNU General Public License v3.0 only
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup gsc
+/// \weakgroup gsc
+/// @{
+
+#ifndef GSC_TEMPERATURE_GRAPH_H
+#define GSC_TEMPERATURE_GRAPH_H
+
+#include <gtkmm.h>
+#include <cairomm/cairomm.h>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "applib/storage_history.h"
+#include "applib/storage_temperature_history.h"
+
+
+
+/// Temperature history graph (SCT temperature log and the stored samples).
+/// The samples are downsampled to one min/max bucket per pixel column, so drawing
+/// is O(width) regardless of the number of samples. When new samples are appended
+/// (e.g. by the auto-refresh), only the affected columns are redrawn.
+class GscTemperatureGraph : public Gtk::DrawingArea {
+	public:
+
+		/// Constructor
+		GscTemperatureGraph();
+
+
+		/// Set the samples (sorted by time). If \c samples extends the previous
+		/// samples, only the new ones are added to the buckets.
+		void set_samples(std::vector<StorageHistoryPoint> samples);
+
+
+		/// Check if there is anything to show
+		[[nodiscard]] bool has_samples() const;
+
+
+	protected:
+
+		/// Draw the graph
+		bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
+
+
+		/// Rebuild the buckets if the plot width changed
+		void on_size_allocate(Gtk::Allocation& allocation) override;
+
+
+	private:
+
+		/// Recompute the time range and rebuild the buckets from all samples
+		void rebuild_buckets();
+
+
+		/// Get the plot width for the current allocation
+		[[nodiscard]] int get_plot_width() const;
+
+
+		/// Get the x coordinate of a bucket column
+		[[nodiscard]] int get_bucket_x(std::size_t index) const;
+
+
+		std::vector<StorageHistoryPoint> samples_;  ///< All samples, sorted by time
+		StorageTemperatureBuckets buckets_;  ///< Per-column downsampled values
+		std::optional<std::pair<std::int64_t, std::int64_t>> value_range_;  ///< Value range the graph was drawn with
+
+};
+
+
+
+
+
+
+#endif
+
+/// @}
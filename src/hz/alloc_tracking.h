@@ -0,0 +1,155 @@
+/******************************************************************************
+License: Zlib
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz
+/// \weakgroup hz
+/// @{
+
+#ifndef HZ_ALLOC_TRACKING_H
+#define HZ_ALLOC_TRACKING_H
+
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+
+
+namespace hz {
+
+
+/*
+Process-wide allocation counters. A binary opts in by replacing the global operator new
+(see HZ_ALLOC_TRACKING_DEFINE_OPERATORS()), which counts each allocation here.
+Without it, the counters stay at zero and alloc_tracking_get_installed() returns false,
+so the allocation budgets (see AllocTrackingScope) can be checked conditionally.
+The counters include the allocations of all threads.
+*/
+
+
+/// Number and size of allocations
+struct AllocStats {
+	std::uint64_t count = 0;  ///< Number of allocations
+	std::uint64_t bytes = 0;  ///< Number of allocated bytes
+};
+
+
+namespace internal {
+
+	inline std::atomic<bool> alloc_tracking_installed = false;  ///< Whether the operator new counts the allocations
+	inline std::atomic<std::uint64_t> alloc_tracking_count = 0;  ///< Number of allocations since program start
+	inline std::atomic<std::uint64_t> alloc_tracking_bytes = 0;  ///< Number of allocated bytes since program start
+
+}
+
+
+/// Count an allocation. Called by the replaced operator new.
+inline void alloc_tracking_record(std::size_t size) noexcept
+{
+	internal::alloc_tracking_count.fetch_add(1, std::memory_order_relaxed);
+	internal::alloc_tracking_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+
+/// Mark the allocation counting as installed (call this from main())
+inline void alloc_tracking_set_installed(bool installed) noexcept
+{
+	internal::alloc_tracking_installed = installed;
+}
+
+
+/// Check whether the allocations are counted
+[[nodiscard]] inline bool alloc_tracking_get_installed() noexcept
+{
+	return internal::alloc_tracking_installed;
+}
+
+
+/// Get the allocation counts since program start
+[[nodiscard]] inline AllocStats alloc_tracking_get_stats() noexcept
+{
+	return {internal::alloc_tracking_count.load(std::memory_order_relaxed),
+			internal::alloc_tracking_bytes.load(std::memory_order_relaxed)};
+}
+
+
+
+/// Counts the allocations since construction. E.g.:
+/// \code
+/// hz::AllocTrackingScope allocs;
+/// parser->parse(output);
+/// if (allocs.get_installed()) {
+/// 	REQUIRE(allocs.get_stats().count < 2000);
+/// }
+/// \endcode
+class AllocTrackingScope {
+	public:
+
+		/// Start counting
+		AllocTrackingScope() noexcept
+				: start_(alloc_tracking_get_stats())
+		{ }
+
+		/// Check whether the allocations are counted (see alloc_tracking_get_installed())
+		[[nodiscard]] bool get_installed() const noexcept
+		{
+			return alloc_tracking_get_installed();
+		}
+
+		/// Get the allocations since construction
+		[[nodiscard]] AllocStats get_stats() const noexcept
+		{
+			const AllocStats now = alloc_tracking_get_stats();
+			return {now.count - start_.count, now.bytes - start_.bytes};
+		}
+
+	private:
+		AllocStats start_;  ///< Counts at construction
+};
+
+
+
+}  // ns
+
+
+
+/// Define the global operator new / delete replacements which count the allocations.
+/// Use this once in the binary, at global scope, and call hz::alloc_tracking_set_installed(true) from main().
+/// Needs <cstdlib> and <new>.
+#define HZ_ALLOC_TRACKING_DEFINE_OPERATORS() \
+	void* operator new(std::size_t size) \
+	{ \
+		hz::alloc_tracking_record(size); \
+		if (void* p = std::malloc(size == 0 ? 1 : size)) { \
+			return p; \
+		} \
+		throw std::bad_alloc(); \
+	} \
+	void* operator new[](std::size_t size) \
+	{ \
+		return operator new(size); \
+	} \
+	void operator delete(void* p) noexcept \
+	{ \
+		std::free(p); \
+	} \
+	void operator delete[](void* p) noexcept \
+	{ \
+		std::free(p); \
+	} \
+	void operator delete(void* p, [[maybe_unused]] std::size_t size) noexcept \
+	{ \
+		std::free(p); \
+	} \
+	void operator delete[](void* p, [[maybe_unused]] std::size_t size) noexcept \
+	{ \
+		std::free(p); \
+	}
+
+
+
+#endif
+
+/// @}
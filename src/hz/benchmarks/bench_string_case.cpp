@@ -0,0 +1,135 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz_benchmarks
+/// \weakgroup hz_benchmarks
+/// @{
+
+/*
+Case and newline conversion benchmark. Converts a generated smartctl-like output
+(about 300 KB, with and without CRLF line endings) with the per-character
+std::tolower() loop and the two-pass string_replace() newline conversion used
+before, and with the current hz::string_to_lower_copy() / hz::string_any_to_unix_copy().
+
+Usage: bench_string_case [iterations]
+*/
+
+// disable libdebug, we don't link to it
+#undef HZ_USE_LIBDEBUG
+#define HZ_USE_LIBDEBUG 0
+// enable libdebug emulation through std::cerr
+#undef HZ_EMULATE_LIBDEBUG
+#define HZ_EMULATE_LIBDEBUG 1
+
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+
+
+namespace {
+
+
+	/// Generate the input text, with LF line endings
+	std::string generate_input()
+	{
+		std::string text;
+		std::size_t line_no = 0;
+		while (text.size() < 300 * 1024) {
+			text += "  5 Reallocated_Sector_Ct   0x0033   100   100   036    Pre-fail  Always       -       ";
+			text += std::to_string(line_no++);
+			text += '\n';
+		}
+		return text;
+	}
+
+
+
+	/// Run \c func over \c input \c iterations times, and print ns per KB
+	template<typename Func>
+	void run(const char* name, std::size_t iterations, const std::string& input, Func&& func)
+	{
+		std::uint64_t checksum = 0;
+
+		const auto start_time = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			checksum += func(input).size();
+		}
+		const auto end_time = std::chrono::steady_clock::now();
+
+		const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+		const double ns_per_kb = static_cast<double>(ns) / static_cast<double>(iterations) / (static_cast<double>(input.size()) / 1024.);
+		std::cout << name << ": " << ns_per_kb << " ns/KB (checksum " << checksum << ")\n";
+	}
+
+
+
+	/// Lowercase with std::tolower(), as done before
+	std::string to_lower_tolower(const std::string& s)
+	{
+		std::string ret(s);
+		for (auto& c : ret) {
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		}
+		return ret;
+	}
+
+
+
+	/// Convert newlines with string_replace(), as done before
+	std::string any_to_unix_two_pass(const std::string& s)
+	{
+		std::string ret(s);
+		hz::string_replace(ret, "\r\n", "\n");
+		hz::string_replace(ret, '\r', '\n');
+		return ret;
+	}
+
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	std::size_t iterations = 200;
+	if (argc > 1) {
+		iterations = hz::string_to_number_nolocale<std::size_t>(argv[1]);
+	}
+	if (iterations == 0) {
+		std::cerr << "Usage: " << argv[0] << " [iterations]\n";
+		return EXIT_FAILURE;
+	}
+
+	const std::string unix_input = generate_input();
+	const std::string dos_input = hz::string_any_to_dos_copy(unix_input);
+
+	if (to_lower_tolower(unix_input) != hz::string_to_lower_copy(unix_input)
+			|| any_to_unix_two_pass(dos_input) != hz::string_any_to_unix_copy(dos_input)
+			|| hz::string_any_to_unix_copy(dos_input) != unix_input) {
+		std::cerr << "Results differ.\n";
+		return EXIT_FAILURE;
+	}
+
+	run("std::tolower loop", iterations, unix_input, to_lower_tolower);
+	run("string_to_lower_copy", iterations, unix_input, [](const std::string& s) { return hz::string_to_lower_copy(s); });
+	run("string_replace, LF input", iterations, unix_input, any_to_unix_two_pass);
+	run("string_any_to_unix_copy, LF input", iterations, unix_input, [](const std::string& s) { return hz::string_any_to_unix_copy(s); });
+	run("string_replace, CRLF input", iterations, dos_input, any_to_unix_two_pass);
+	run("string_any_to_unix_copy, CRLF input", iterations, dos_input, [](const std::string& s) { return hz::string_any_to_unix_copy(s); });
+
+	return EXIT_SUCCESS;
+}
+
+
+
+/// @}
@@ -0,0 +1,126 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz_benchmarks
+/// \weakgroup hz_benchmarks
+/// @{
+
+/*
+String to number conversion benchmark. Compares hz::string_is_numeric_nolocale()
+(std::from_chars() fast path) with the stream-based implementation it falls back to,
+over values typical for smartctl output (attribute values, raw values, table cells).
+
+Usage: bench_string_num [iterations]
+*/
+
+// disable libdebug, we don't link to it
+#undef HZ_USE_LIBDEBUG
+#define HZ_USE_LIBDEBUG 0
+// enable libdebug emulation through std::cerr
+#undef HZ_EMULATE_LIBDEBUG
+#define HZ_EMULATE_LIBDEBUG 1
+
+#include "hz/string_num.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+
+	/// Sample inputs
+	const std::vector<std::string>& get_inputs()
+	{
+		static const std::vector<std::string> inputs = {
+			"0", "1", "100", "253", "4", "36", "239", "12345678", "-1", "65535",
+			"253403791387", "0x0032", "7 (Min/Max 20/45)", "1.5", "-3E4", " 42", "abc", "",
+		};
+		return inputs;
+	}
+
+
+
+	/// Run \c func over all the inputs \c iterations times, and print ns per conversion
+	template<typename Func>
+	void run(const char* name, std::size_t iterations, Func&& func)
+	{
+		const auto& inputs = get_inputs();
+		std::uint64_t checksum = 0;
+
+		const auto start_time = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			for (const auto& input : inputs) {
+				checksum += func(input);
+			}
+		}
+		const auto end_time = std::chrono::steady_clock::now();
+
+		const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+		const double ns_per_op = static_cast<double>(ns) / static_cast<double>(iterations * inputs.size());
+		std::cout << name << ": " << ns_per_op << " ns/op (checksum " << checksum << ")\n";
+	}
+
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	std::size_t iterations = 200000;
+	if (argc > 1) {
+		iterations = hz::string_to_number_nolocale<std::size_t>(argv[1]);
+	}
+	if (iterations == 0) {
+		std::cerr << "Usage: " << argv[0] << " [iterations]\n";
+		return EXIT_FAILURE;
+	}
+
+	run("int64 strict, from_chars", iterations, [](const std::string& s) {
+		std::int64_t value = 0;
+		return hz::string_is_numeric_nolocale(s, value, true) ? static_cast<std::uint64_t>(value) : 0U;
+	});
+	run("int64 strict, streams", iterations, [](const std::string& s) {
+		std::int64_t value = 0;
+		hz::ScopedCLocale loc;
+		return hz::internal::string_is_numeric_impl_global_locale(s, value, true, 0, std::locale::classic())
+				? static_cast<std::uint64_t>(value) : 0U;
+	});
+
+	run("int64 non-strict, from_chars", iterations, [](const std::string& s) {
+		std::int64_t value = 0;
+		return hz::string_is_numeric_nolocale(s, value, false) ? static_cast<std::uint64_t>(value) : 0U;
+	});
+	run("int64 non-strict, streams", iterations, [](const std::string& s) {
+		std::int64_t value = 0;
+		hz::ScopedCLocale loc;
+		return hz::internal::string_is_numeric_impl_global_locale(s, value, false, 0, std::locale::classic())
+				? static_cast<std::uint64_t>(value) : 0U;
+	});
+
+	run("double non-strict, from_chars", iterations, [](const std::string& s) {
+		double value = 0;
+		return hz::string_is_numeric_nolocale(s, value, false) ? static_cast<std::uint64_t>(value) : 0U;
+	});
+	run("double non-strict, streams", iterations, [](const std::string& s) {
+		double value = 0;
+		hz::ScopedCLocale loc;
+		return hz::internal::string_is_numeric_impl_global_locale(s, value, false, 0, std::locale::classic())
+				? static_cast<std::uint64_t>(value) : 0U;
+	});
+
+	return EXIT_SUCCESS;
+}
+
+
+
+/// @}
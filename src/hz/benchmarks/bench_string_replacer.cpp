@@ -0,0 +1,149 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz_benchmarks
+/// \weakgroup hz_benchmarks
+/// @{
+
+/*
+Multi-pattern replacement benchmark. Humanizes smartctl attribute names the way
+the attribute description code does, with hz::string_replace_array() (one pass
+per pattern) and with hz::StringReplacer (one pass in total).
+
+Usage: bench_string_replacer [iterations]
+*/
+
+// disable libdebug, we don't link to it
+#undef HZ_USE_LIBDEBUG
+#define HZ_USE_LIBDEBUG 0
+// enable libdebug emulation through std::cerr
+#undef HZ_EMULATE_LIBDEBUG
+#define HZ_EMULATE_LIBDEBUG 1
+
+#include "hz/string_replacer.h"
+#include "hz/string_algo.h"
+#include "hz/string_num.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+namespace {
+
+
+	/// Sample inputs
+	const std::vector<std::string>& get_inputs()
+	{
+		static const std::vector<std::string> inputs = {
+			"Raw_Read_Error_Rate", "Spin_Up_Time", "Start_Stop_Count", "Reallocated_Sector_Ct",
+			"Seek_Error_Rate", "Power_On_Hours", "Spin_Retry_Count", "Power_Cycle_Count",
+			"Runtime_Bad_Block", "End-to-End_Error", "Reported_Uncorrect", "Command_Timeout",
+			"Airflow_Temperature_Cel", "Power-Off_Retract_Count", "Load_Cycle_Count",
+			"Temperature_Celsius", "Hardware_ECC_Recovered", "Current_Pending_Sector",
+			"Offline_Uncorrectable", "UDMA_CRC_Error_Count", "Erase_Fail_Count_Total",
+			"Avg_Write/Erase_Count", "Unexpect_Power_Loss_Ct", "Total_LBAs_Written",
+		};
+		return inputs;
+	}
+
+
+
+	/// Run \c func over all the inputs \c iterations times, and print ns per name
+	template<typename Func>
+	void run(const char* name, std::size_t iterations, Func&& func)
+	{
+		const auto& inputs = get_inputs();
+		std::uint64_t checksum = 0;
+
+		const auto start_time = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			for (const auto& input : inputs) {
+				checksum += func(input).size();
+			}
+		}
+		const auto end_time = std::chrono::steady_clock::now();
+
+		const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+		const double ns_per_op = static_cast<double>(ns) / static_cast<double>(iterations * inputs.size());
+		std::cout << name << ": " << ns_per_op << " ns/op (checksum " << checksum << ")\n";
+	}
+
+
+
+	/// Humanize with string_replace_array()
+	std::string humanize_multi_pass(const std::string& name)
+	{
+		static const std::vector<std::pair<std::string, std::string>> replacements = {
+				{"_", " "}, {"/", " / "},
+				{" Ct ", " Count "}, {" Tot ", " Total "}, {" Blk ", " Block "}, {" Cel ", " Celsius "},
+				{" Uncorrect ", " Uncorrectable "}, {" Cnt ", " Count "}, {" Offl ", " Offline "},
+				{" UNC ", " Uncorrectable "}, {" Err ", " Error "}, {" Errs ", " Errors "},
+				{" Perc ", " Percent "}, {" Avg ", " Average "}, {" Max ", " Maximum "}, {" Min ", " Minimum "},
+		};
+		std::string s = " " + name + " ";
+		hz::string_replace_array(s, replacements);
+		hz::string_trim(s);
+		return s;
+	}
+
+
+
+	/// Humanize with StringReplacer
+	std::string humanize_single_pass(const std::string& name)
+	{
+		static const hz::StringReplacer separator_replacer = {
+				{"_", " "}, {"/", " / "},
+		};
+		static const hz::StringReplacer word_replacer({
+				{"Ct", "Count"}, {"Tot", "Total"}, {"Blk", "Block"}, {"Cel", "Celsius"},
+				{"Uncorrect", "Uncorrectable"}, {"Cnt", "Count"}, {"Offl", "Offline"},
+				{"UNC", "Uncorrectable"}, {"Err", "Error"}, {"Errs", "Errors"},
+				{"Perc", "Percent"}, {"Avg", "Average"}, {"Max", "Maximum"}, {"Min", "Minimum"},
+		}, hz::StringReplacer::Mode::Words);
+		std::string s = separator_replacer.replace_copy(name);
+		word_replacer.replace(s);
+		return s;
+	}
+
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	std::size_t iterations = 100000;
+	if (argc > 1) {
+		iterations = hz::string_to_number_nolocale<std::size_t>(argv[1]);
+	}
+	if (iterations == 0) {
+		std::cerr << "Usage: " << argv[0] << " [iterations]\n";
+		return EXIT_FAILURE;
+	}
+
+	for (const auto& input : get_inputs()) {
+		if (humanize_multi_pass(input) != humanize_single_pass(input)) {
+			std::cerr << "Results differ for " << input << ": \"" << humanize_multi_pass(input)
+					<< "\" vs \"" << humanize_single_pass(input) << "\"\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	run("string_replace_array", iterations, humanize_multi_pass);
+	run("StringReplacer", iterations, humanize_single_pass);
+
+	return EXIT_SUCCESS;
+}
+
+
+
+/// @}
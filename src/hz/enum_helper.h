@@ -13,10 +13,18 @@ Copyright:
 #define ENUM_HELPER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility>
 #include <unordered_map>
 #include <algorithm>
+#include <array>
+#include <cstddef>  // std::size_t
+#include <type_traits>
+
+#ifdef ENABLE_GLIB
+	#include <glibmm/i18n.h>
+#endif
 
 
 
@@ -120,6 +128,145 @@ class EnumHelper {
 
 
 
+/// An enum member in the table of EnumTableHelper
+template <typename Enum>
+struct EnumTableEntry {
+	Enum value;  ///< Enum member
+	std::string_view storable_name;  ///< Storable name
+	const char* displayable_name;  ///< Untranslated displayable name (mark it with N_() to translate it)
+};
+
+
+
+/// Helper class for defining enum-related functions, with the names in a constexpr table
+/// instead of maps built at runtime. The members are looked up by index, and the displayable
+/// names are translated when requested.
+/// In EnumExtClass it expects the following (accessible) members:
+/// - static constexpr EnumType default_value = ...;
+/// - static constexpr std::array<hz::EnumTableEntry<EnumType>, N> enum_table = {...};
+/// The enum values must be within 256 of each other.
+template <typename Enum, typename EnumExtClass>
+class EnumTableHelper {
+	public:
+
+		using EnumType = Enum;
+
+
+		/// Return storable name of an enum member
+		[[nodiscard]] static std::string get_storable_name(EnumType enum_value)
+		{
+			return std::string(get_storable_name_view(enum_value));
+		}
+
+
+		/// Return storable name of an enum member, without allocating
+		[[nodiscard]] static std::string_view get_storable_name_view(EnumType enum_value)
+		{
+			const auto* entry = find_entry(enum_value);
+			return entry ? entry->storable_name : std::string_view();
+		}
+
+
+		/// Return an enum member by its storable name
+		[[nodiscard]] static EnumType get_by_storable_name(std::string_view storable_name,
+				EnumType default_value = EnumExtClass::default_value)
+		{
+			// The tables are short, comparing the names is faster than hashing them.
+			for (const auto& entry : EnumExtClass::enum_table) {
+				if (entry.storable_name == storable_name) {
+					return entry.value;
+				}
+			}
+			return default_value;
+		}
+
+
+		/// Return displayable name of an enum member, translated
+		[[nodiscard]] static std::string get_displayable_name(EnumType enum_value)
+		{
+			const auto* entry = find_entry(enum_value);
+			if (!entry) {
+				return {};
+			}
+#ifdef ENABLE_GLIB
+			return _(entry->displayable_name);
+#else
+			return entry->displayable_name;
+#endif
+		}
+
+
+		/// Return all possible members of an enum
+		[[nodiscard]] static std::vector<EnumType> get_all_values()
+		{
+			std::vector<EnumType> v;
+			v.reserve(EnumExtClass::enum_table.size());
+			for (const auto& entry : EnumExtClass::enum_table) {
+				v.push_back(entry.value);
+			}
+			std::sort(v.begin(), v.end());
+			return v;
+		}
+
+
+	private:
+
+		using UnderlyingType = std::underlying_type_t<EnumType>;
+
+
+		/// Table index of each enum value, from the lowest one
+		struct EnumTableIndex {
+			UnderlyingType min_value = 0;  ///< Lowest enum value in the table
+			std::array<unsigned char, 256> positions = {};  ///< Table index of (value - min_value), table size if none
+			bool valid = true;  ///< False if the enum values are too far apart or duplicated
+		};
+
+
+		/// Build the index of the table at compile time
+		static constexpr EnumTableIndex build_index()
+		{
+			constexpr const auto& table = EnumExtClass::enum_table;
+			static_assert(!table.empty() && table.size() < 256, "Enum table size must be between 1 and 255");
+
+			EnumTableIndex index;
+			index.min_value = static_cast<UnderlyingType>(table[0].value);
+			for (const auto& entry : table) {
+				index.min_value = std::min(index.min_value, static_cast<UnderlyingType>(entry.value));
+			}
+			index.positions.fill(static_cast<unsigned char>(table.size()));
+			for (std::size_t i = 0; i < table.size(); ++i) {
+				const auto offset = static_cast<std::size_t>(static_cast<UnderlyingType>(table[i].value) - index.min_value);
+				if (offset >= index.positions.size() || index.positions[offset] != table.size()) {
+					index.valid = false;
+					break;
+				}
+				index.positions[offset] = static_cast<unsigned char>(i);
+			}
+			return index;
+		}
+
+
+		/// Find the table entry of an enum member, nullptr if not found
+		[[nodiscard]] static const EnumTableEntry<EnumType>* find_entry(EnumType enum_value)
+		{
+			static constexpr EnumTableIndex index = build_index();
+			static_assert(index.valid, "Enum table values must be unique and within 256 of each other");
+
+			const auto value = static_cast<UnderlyingType>(enum_value);
+			if (value < index.min_value) {
+				return nullptr;
+			}
+			const auto offset = static_cast<std::size_t>(value - index.min_value);
+			if (offset >= index.positions.size() || index.positions[offset] >= EnumExtClass::enum_table.size()) {
+				return nullptr;
+			}
+			return &EnumExtClass::enum_table[index.positions[offset]];
+		}
+
+};
+
+
+
 }
 
 
@@ -12,6 +12,7 @@ Copyright:
 #ifndef HZ_ERROR_HOLDER_H
 #define HZ_ERROR_HOLDER_H
 
+#include <cstddef>  // std::size_t, std::ptrdiff_t
 #include <vector>
 #include <memory>
 #include <string>
@@ -108,7 +109,7 @@ class ErrorBase {
 		{
 			if (get_code_type_info() != typeid(CodeMemberType))
 				throw type_mismatch(get_code_type_info(), typeid(CodeMemberType));
-			return static_cast<const Error<CodeMemberType>*>(this)->code;
+			return static_cast<const Error<CodeMemberType>*>(this)->get_code_member();
 		}
 
 		/// Get error code of type \c CodeMemberType
@@ -146,20 +147,28 @@ class ErrorBase {
 
 
 		/// Get error type
-		[[nodiscard]] std::string get_type() const
+		[[nodiscard]] const std::string& get_type() const
 		{
 			return type_;
 		}
 
-		/// Get error message
+		/// Get error message. If none was given, it's formatted from the code now (see format_message()).
 		[[nodiscard]] std::string get_message() const
 		{
-			return message_;
+			return message_.empty() ? format_message() : message_;
 		}
 
 
 	protected:
 
+		/// Format the message from the error code. Called by get_message() if no message was given,
+		/// so that the errors which are never looked at don't pay for the formatting.
+		[[nodiscard]] virtual std::string format_message() const
+		{
+			return {};
+		}
+
+
 		/// Set error type
 		void set_type(std::string type)
 		{
@@ -271,8 +280,7 @@ class Error : public ErrorCodeHolder<CodeType> {
 		// Reimplemented from ErrorBase
 		ErrorBase* clone() override
 		{
-			return new Error(ErrorCodeHolder<CodeType>::get_type(), ErrorCodeHolder<CodeType>::get_level(),
-					ErrorCodeHolder<CodeType>::get_code_member(), ErrorCodeHolder<CodeType>::get_message());
+			return new Error(*this);
 		}
 };
 
@@ -291,8 +299,7 @@ class Error<void> : public ErrorCodeHolder<void> {
 		// Reimplemented from ErrorBase
 		ErrorBase* clone() override
 		{
-			return new Error(ErrorCodeHolder<void>::get_type(), ErrorCodeHolder<void>::get_level(),
-					ErrorCodeHolder<void>::get_message());
+			return new Error(*this);
 		}
 };
 
@@ -300,7 +307,7 @@ class Error<void> : public ErrorCodeHolder<void> {
 
 
 /// Error class specialization for int (can be used for signals, errno).
-/// Message is automatically constructed if not provided.
+/// Message is automatically formatted (when requested) if not provided.
 template<>
 class Error<int> : public ErrorCodeHolder<int> {
 	public:
@@ -314,23 +321,29 @@ class Error<int> : public ErrorCodeHolder<int> {
 		Error(const std::string& type, ErrorLevel level, int code)
 			: ErrorCodeHolder<int>(type, level, code)
 		{
-			if (type == "errno") {
-				this->set_message(std::error_code(code, std::system_category()).message());
-
-			} else if (type == "signal") {
-				// hz::signal_string should be translated already
-				this->set_message("Child exited with signal: " + hz::signal_to_string(code));
-
-			} else {  // nothing else supported here. use constructor with a message.
-				DBG_ASSERT(0);
-			}
+			// nothing else supported here. use constructor with a message.
+			DBG_ASSERT(type == "errno" || type == "signal");
 		}
 
 		// Reimplemented from ErrorBase
 		ErrorBase* clone() override
 		{
-			return new Error(ErrorCodeHolder<int>::get_type(), ErrorCodeHolder<int>::get_level(),
-					ErrorCodeHolder<int>::get_code_member(), ErrorCodeHolder<int>::get_message());
+			return new Error(*this);
+		}
+
+	protected:
+
+		// Reimplemented from ErrorBase
+		[[nodiscard]] std::string format_message() const override
+		{
+			if (get_type() == "errno") {
+				return std::error_code(get_code_member(), std::system_category()).message();
+			}
+			if (get_type() == "signal") {
+				// hz::signal_string should be translated already
+				return "Child exited with signal: " + hz::signal_to_string(get_code_member());
+			}
+			return {};
 		}
 };
 
@@ -357,6 +370,8 @@ namespace {
 
 
 /// A class wishing to implement Error holding storage should inherit this.
+/// The list is unbounded by default. With set_max_errors(), it becomes a ring which keeps
+/// only the newest errors, so that a long-lived holder (e.g. a reused executor) doesn't grow.
 class ErrorHolder {
 	public:
 
@@ -381,13 +396,20 @@ class ErrorHolder {
 		virtual ~ErrorHolder() = default;
 
 
-		/// Add an error to the error list
+		/// Add an error to the error list. If the list is full (see set_max_errors()),
+		/// the oldest error is replaced.
 		template<class E>
 		void push_error(const E& e)
 		{
 			auto cloned = std::make_shared<E>(e);
-			errors_.push_back(cloned);
 			error_warn(cloned.get());
+			if (max_errors_ != 0 && errors_.size() >= max_errors_) {
+				errors_[ring_start_] = std::move(cloned);
+				ring_start_ = (ring_start_ + 1) % errors_.size();
+				++dropped_error_count_;
+			} else {
+				errors_.push_back(std::move(cloned));
+			}
 		}
 
 
@@ -398,10 +420,14 @@ class ErrorHolder {
 		}
 
 
-		/// Get a list of errors.
+		/// Get a list of errors, the newest at the end.
 		[[nodiscard]] error_list_t get_errors() const
 		{
-			return errors_;
+			error_list_t errors;
+			errors.reserve(errors_.size());
+			errors.insert(errors.end(), errors_.begin() + static_cast<std::ptrdiff_t>(ring_start_), errors_.end());
+			errors.insert(errors.end(), errors_.begin(), errors_.begin() + static_cast<std::ptrdiff_t>(ring_start_));
+			return errors;
 		}
 
 
@@ -409,6 +435,36 @@ class ErrorHolder {
 		void clear_errors()
 		{
 			errors_.clear();
+			ring_start_ = 0;
+			dropped_error_count_ = 0;
+		}
+
+
+		/// Keep only the newest \c max_errors errors (0 means unlimited, the default).
+		/// The older ones are dropped right away if there are too many.
+		void set_max_errors(std::size_t max_errors)
+		{
+			errors_ = get_errors();
+			ring_start_ = 0;
+			if (max_errors != 0 && errors_.size() > max_errors) {
+				dropped_error_count_ += errors_.size() - max_errors;
+				errors_.erase(errors_.begin(), errors_.end() - static_cast<std::ptrdiff_t>(max_errors));
+			}
+			max_errors_ = max_errors;
+		}
+
+
+		/// Get the maximum number of kept errors (0 means unlimited)
+		[[nodiscard]] std::size_t get_max_errors() const
+		{
+			return max_errors_;
+		}
+
+
+		/// Get the number of errors dropped because of set_max_errors() since the last clear_errors()
+		[[nodiscard]] std::size_t get_dropped_error_count() const
+		{
+			return dropped_error_count_;
 		}
 
 
@@ -434,7 +490,10 @@ class ErrorHolder {
 
 	private:
 
-		error_list_t errors_;  ///< Error list. The newest errors at the end.
+		error_list_t errors_;  ///< Error list. The newest errors at the end (before ring_start_ if the ring is full).
+		std::size_t ring_start_ = 0;  ///< Index of the oldest error in errors_
+		std::size_t max_errors_ = 0;  ///< Maximum number of errors, 0 means unlimited
+		std::size_t dropped_error_count_ = 0;  ///< Number of errors dropped by the ring
 
 };
 
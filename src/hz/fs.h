@@ -368,6 +368,44 @@ inline std::error_code fs_file_put_contents(const fs::path& file, const std::str
 
 
 
+/// Same as fs_file_put_contents(), but writes to a temporary file in the same directory first,
+/// and renames it over the file. This way the file is never left partially written.
+/// If \c file_or_link is a symlink, its target is replaced.
+/// \return Empty (zero) error code on success.
+inline std::error_code fs_file_put_contents_atomic(const fs::path& file_or_link, const std::string_view& data)
+{
+	if (file_or_link.empty()) {
+		return std::make_error_code(std::errc::invalid_argument);
+	}
+
+	std::error_code ec;
+	fs::path file = file_or_link;
+	if (fs::is_symlink(file_or_link, ec)) {
+		file = fs::canonical(file_or_link, ec);
+		if (ec) {
+			return ec;
+		}
+	}
+
+	fs::path temp_file = file;
+	temp_file += ".tmp";
+
+	if (auto put_ec = fs_file_put_contents(temp_file, data)) {
+		std::error_code remove_ec;
+		fs::remove(temp_file, remove_ec);
+		return put_ec;
+	}
+
+	fs::rename(temp_file, file, ec);
+	if (ec) {
+		std::error_code remove_ec;
+		fs::remove(temp_file, remove_ec);
+	}
+	return ec;
+}
+
+
+
 
 
 /// Get the current user's home directory.
@@ -0,0 +1,198 @@
+/******************************************************************************
+License: Zlib
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz
+/// \weakgroup hz
+/// @{
+
+#ifndef HZ_FS_MAPPED_FILE_H
+#define HZ_FS_MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+	#include <windows.h>  // CreateFileW(), CreateFileMappingW(), MapViewOfFile()
+#else
+	#include <fcntl.h>  // open()
+	#include <sys/mman.h>  // mmap()
+	#include <sys/stat.h>  // fstat()
+	#include <unistd.h>  // close()
+#endif
+
+#include "fs.h"
+
+
+
+namespace hz {
+
+
+
+/// A read-only memory-mapped file. Large files (e.g. archives or many
+/// saved outputs) can be read through get_view() without copying them into memory.
+/// The view is valid while the object is alive. Move-only.
+class FsMappedFile {
+	public:
+
+		/// Constructor. Call open() to map a file.
+		FsMappedFile() = default;
+
+		/// Deleted
+		FsMappedFile(const FsMappedFile& other) = delete;
+
+		/// Move constructor
+		FsMappedFile(FsMappedFile&& other) noexcept
+				: data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+		{ }
+
+		/// Deleted
+		FsMappedFile& operator=(const FsMappedFile& other) = delete;
+
+		/// Move operator
+		FsMappedFile& operator=(FsMappedFile&& other) noexcept
+		{
+			if (this != &other) {
+				close();
+				data_ = std::exchange(other.data_, nullptr);
+				size_ = std::exchange(other.size_, 0);
+			}
+			return *this;
+		}
+
+		/// Destructor
+		~FsMappedFile()
+		{
+			close();
+		}
+
+
+		/// Map the file. If the file is larger than \c max_size, std::errc::file_too_large is returned.
+		/// \return Empty (zero) error code on success.
+		std::error_code open(const fs::path& file, std::uintmax_t max_size)
+		{
+			close();
+			if (file.empty()) {
+				return std::make_error_code(std::errc::invalid_argument);
+			}
+
+#ifdef _WIN32
+			HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+					nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle == INVALID_HANDLE_VALUE) {
+				return {static_cast<int>(GetLastError()), std::system_category()};
+			}
+			LARGE_INTEGER file_size = {};
+			if (!GetFileSizeEx(handle, &file_size)) {
+				std::error_code ec(static_cast<int>(GetLastError()), std::system_category());
+				CloseHandle(handle);
+				return ec;
+			}
+			if (static_cast<std::uintmax_t>(file_size.QuadPart) > max_size) {
+				CloseHandle(handle);
+				return std::make_error_code(std::errc::file_too_large);
+			}
+			if (file_size.QuadPart == 0) {  // empty files cannot be mapped
+				CloseHandle(handle);
+				return {};
+			}
+			HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			std::error_code ec;
+			if (mapping) {
+				data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			}
+			if (!data_) {
+				ec = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+			}
+			if (mapping) {
+				CloseHandle(mapping);  // the view keeps the mapping alive
+			}
+			CloseHandle(handle);
+			if (data_) {
+				size_ = static_cast<std::size_t>(file_size.QuadPart);
+			}
+			return ec;
+
+#else
+			const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd == -1) {
+				return {errno, std::system_category()};
+			}
+			struct stat st = {};
+			if (fstat(fd, &st) == -1) {
+				std::error_code ec(errno, std::system_category());
+				::close(fd);
+				return ec;
+			}
+			if (!S_ISREG(st.st_mode)) {
+				::close(fd);
+				return std::make_error_code(std::errc::invalid_argument);
+			}
+			if (static_cast<std::uintmax_t>(st.st_size) > max_size) {
+				::close(fd);
+				return std::make_error_code(std::errc::file_too_large);
+			}
+			if (st.st_size == 0) {  // empty files cannot be mapped
+				::close(fd);
+				return {};
+			}
+			void* addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			std::error_code ec;
+			if (addr == MAP_FAILED) {
+				ec = std::error_code(errno, std::system_category());
+			} else {
+				data_ = static_cast<const char*>(addr);
+				size_ = static_cast<std::size_t>(st.st_size);
+			}
+			::close(fd);  // the mapping stays valid
+			return ec;
+#endif
+		}
+
+
+		/// Unmap the file
+		void close()
+		{
+			if (data_) {
+#ifdef _WIN32
+				UnmapViewOfFile(data_);
+#else
+				munmap(const_cast<char*>(data_), size_);
+#endif
+			}
+			data_ = nullptr;
+			size_ = 0;
+		}
+
+
+		/// Get the file contents. Empty if no file is mapped or the file is empty.
+		[[nodiscard]] std::string_view get_view() const
+		{
+			return {data_, size_};
+		}
+
+
+	private:
+
+		const char* data_ = nullptr;  ///< Mapped data
+		std::size_t size_ = 0;  ///< Mapped size
+
+};
+
+
+
+
+}  // ns
+
+
+
+#endif
+
+/// @}
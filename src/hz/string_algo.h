@@ -12,10 +12,22 @@ Copyright:
 #ifndef HZ_STRING_ALGO_H
 #define HZ_STRING_ALGO_H
 
+#include <algorithm>  // std::copy, std::min
+#include <array>
+#include <cstddef>  // std::ptrdiff_t
+#include <cstdint>
+#include <cstring>  // std::memcmp
 #include <string>
-#include <cctype>  // std::tolower, std::toupper
+#include <cctype>
+#include <iterator>  // std::forward_iterator_tag, std::default_sentinel_t
 #include <string_view>
 
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+	#include <arm_neon.h>
+#endif
+
 
 
 namespace hz {
@@ -65,7 +77,7 @@ void string_split(std::string_view str, char delimiter,
 	while (true) {
 		if (last >= end) {  // last is past the end
 			if (!skip_empty)  // no need to check num here
-				append_here.push_back(std::string());
+				append_here.emplace_back();
 			break;
 		}
 
@@ -110,7 +122,7 @@ void string_split(std::string_view str, const std::string& delimiter,
 	while (true) {
 		if (last >= end) {  // last is past the end
 			if (!skip_empty)  // no need to check num here
-				append_here.push_back(std::string());
+				append_here.emplace_back();
 			break;
 		}
 
@@ -149,7 +161,7 @@ void string_split_by_chars(std::string_view str, std::string_view delimiter_char
 	while (true) {
 		if (last >= end) {  // last is past the end
 			if (!skip_empty)  // no need to check num here
-				append_here.emplace_back({});
+				append_here.emplace_back();
 			break;
 		}
 
@@ -173,6 +185,220 @@ void string_split_by_chars(std::string_view str, std::string_view delimiter_char
 
 
 
+/// Delimiter of string_split_view(): a single character
+struct StringSplitCharDelimiter {
+	char delimiter = '\0';  ///< Delimiter character
+
+	/// Find the delimiter in \c str starting at \c pos
+	[[nodiscard]] std::string_view::size_type find(std::string_view str, std::string_view::size_type pos) const
+	{
+		return str.find(delimiter, pos);
+	}
+
+	/// Get the delimiter size
+	[[nodiscard]] std::string_view::size_type size() const
+	{
+		return 1;
+	}
+};
+
+
+
+/// Delimiter of string_split_view(): a string
+struct StringSplitStringDelimiter {
+	std::string_view delimiter;  ///< Delimiter string. An empty one never matches.
+
+	/// Find the delimiter in \c str starting at \c pos
+	[[nodiscard]] std::string_view::size_type find(std::string_view str, std::string_view::size_type pos) const
+	{
+		return delimiter.empty() ? std::string_view::npos : str.find(delimiter, pos);
+	}
+
+	/// Get the delimiter size
+	[[nodiscard]] std::string_view::size_type size() const
+	{
+		return delimiter.size();
+	}
+};
+
+
+
+/// Delimiter of string_split_view_by_chars(): any of the characters
+struct StringSplitCharsDelimiter {
+	std::string_view delimiter_chars;  ///< Delimiter characters
+
+	/// Find the delimiter in \c str starting at \c pos
+	[[nodiscard]] std::string_view::size_type find(std::string_view str, std::string_view::size_type pos) const
+	{
+		return str.find_first_of(delimiter_chars, pos);
+	}
+
+	/// Get the delimiter size
+	[[nodiscard]] std::string_view::size_type size() const
+	{
+		return 1;
+	}
+};
+
+
+
+/// A lazy range of components of a string, split by a delimiter. The components
+/// are views into the original string, which must outlive the range. No allocations are made.
+/// The components are the same as the ones string_split() produces (without the "limit" support).
+template<class Delimiter>
+class StringSplitView {
+	public:
+
+		/// Forward iterator over the components
+		class Iterator {
+			public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = std::string_view;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const std::string_view*;
+				using reference = const std::string_view&;
+
+				/// Constructor, creates an end iterator
+				Iterator() = default;
+
+				/// Constructor, finds the first component
+				Iterator(std::string_view str, Delimiter delimiter, bool skip_empty)
+						: str_(str), delimiter_(delimiter), skip_empty_(skip_empty), next_(0), at_end_(false)
+				{
+					advance();
+				}
+
+				/// Get the current component
+				reference operator*() const
+				{
+					return component_;
+				}
+
+				/// Get the current component
+				pointer operator->() const
+				{
+					return &component_;
+				}
+
+				/// Go to the next component
+				Iterator& operator++()
+				{
+					advance();
+					return *this;
+				}
+
+				/// Go to the next component
+				Iterator operator++(int)
+				{
+					Iterator old = *this;
+					advance();
+					return old;
+				}
+
+				/// Compare iterators of the same range
+				bool operator==(const Iterator& other) const
+				{
+					return at_end_ == other.at_end_ && (at_end_ || (component_.data() == other.component_.data() && next_ == other.next_));
+				}
+
+				/// Check whether the iterator is past the last component
+				bool operator==(std::default_sentinel_t /*unused*/) const
+				{
+					return at_end_;
+				}
+
+			private:
+
+				/// Find the next component
+				void advance()
+				{
+					while (true) {
+						if (next_ == std::string_view::npos) {  // the last component was the final one
+							at_end_ = true;
+							return;
+						}
+						if (next_ >= str_.size()) {  // past the delimiter at the end
+							next_ = std::string_view::npos;
+							component_ = str_.substr(str_.size());
+							if (!skip_empty_) {
+								return;
+							}
+							continue;
+						}
+						const auto curr = delimiter_.find(str_, next_);
+						component_ = str_.substr(next_, (curr == std::string_view::npos ? curr : (curr - next_)));
+						next_ = (curr == std::string_view::npos ? curr : curr + delimiter_.size());
+						if (!skip_empty_ || !component_.empty()) {
+							return;
+						}
+					}
+				}
+
+				std::string_view str_;  ///< String to split
+				Delimiter delimiter_;  ///< Delimiter
+				bool skip_empty_ = false;  ///< Skip empty components
+				std::string_view component_;  ///< Current component
+				std::string_view::size_type next_ = std::string_view::npos;  ///< Position after the current component's delimiter, npos if none
+				bool at_end_ = true;  ///< Past the last component
+		};
+
+
+		/// Constructor
+		StringSplitView(std::string_view str, Delimiter delimiter, bool skip_empty)
+				: str_(str), delimiter_(delimiter), skip_empty_(skip_empty)
+		{ }
+
+		/// Get the iterator of the first component
+		[[nodiscard]] Iterator begin() const
+		{
+			return Iterator(str_, delimiter_, skip_empty_);
+		}
+
+		/// Get the end sentinel
+		[[nodiscard]] std::default_sentinel_t end() const
+		{
+			return std::default_sentinel;
+		}
+
+	private:
+
+		std::string_view str_;  ///< String to split
+		Delimiter delimiter_;  ///< Delimiter
+		bool skip_empty_ = false;  ///< Skip empty components
+
+};
+
+
+
+/// Split a string into components by character (delimiter) lazily, without allocations.
+/// If skip_empty is true, then empty components will be omitted.
+/// Example: for (std::string_view line : hz::string_split_view(output, '\n', true)) { ... }
+inline StringSplitView<StringSplitCharDelimiter> string_split_view(std::string_view str, char delimiter, bool skip_empty = false)
+{
+	return {str, StringSplitCharDelimiter{delimiter}, skip_empty};
+}
+
+
+
+/// Split a string into components by another string (delimiter) lazily, without allocations.
+/// If skip_empty is true, then empty components will be omitted.
+inline StringSplitView<StringSplitStringDelimiter> string_split_view(std::string_view str, std::string_view delimiter, bool skip_empty = false)
+{
+	return {str, StringSplitStringDelimiter{delimiter}, skip_empty};
+}
+
+
+
+/// Split a string into components by any of the characters (delimiters) lazily, without allocations.
+/// If skip_empty is true, then empty components will be omitted.
+inline StringSplitView<StringSplitCharsDelimiter> string_split_view_by_chars(std::string_view str, std::string_view delimiter_chars, bool skip_empty = false)
+{
+	return {str, StringSplitCharsDelimiter{delimiter_chars}, skip_empty};
+}
+
+
+
+
 // --------------------------------------------- Join
 
 
@@ -246,6 +472,19 @@ inline std::string string_trim_copy(std::string_view s, const std::string& trim_
 
 
 
+/// Trim a string s from both sides, returning a view into s.
+/// Trimming removes all trim_chars that occur on either side of the string s.
+inline std::string_view string_trim_view(std::string_view s, std::string_view trim_chars = " \t\r\n")
+{
+	const std::string_view::size_type first = s.find_first_not_of(trim_chars);
+	if (first == std::string_view::npos)
+		return {};
+	return s.substr(first, s.find_last_not_of(trim_chars) - first + 1);
+}
+
+
+
+
 /// Trim a string s from the left (modifying s). Return true if s was modified.
 /// Trimming removes all trim_chars that occur on the left side of the string s.
 inline bool string_trim_left(std::string& s, const std::string& trim_chars = " \t\r\n")
@@ -799,11 +1038,30 @@ inline bool string_ends_with(std::string_view str, char ch)
 
 /// Auto-detect and convert mac/dos/unix newline formats in s (modifying s) to unix format.
 /// Returns true if \c s was changed.
+/// Note: This is a single pass, and \c s is not touched if there is no '\\r' in it.
 inline bool string_any_to_unix(std::string& s)
 {
-	std::string::size_type n = hz::string_replace(s, "\r\n", "\n");  // dos
-	n += hz::string_replace(s, '\r', '\n');  // mac
-	return bool(n);
+	// std::string::find() uses memchr(), which is vectorized by the C library
+	std::string::size_type in = s.find('\r');
+	if (in == std::string::npos) {
+		return false;
+	}
+	std::string::size_type out = in;
+	while (in < s.size()) {  // s[in] is '\r' here
+		s[out++] = '\n';
+		in += (in + 1 < s.size() && s[in + 1] == '\n') ? 2 : 1;  // dos or mac
+
+		std::string::size_type next = s.find('\r', in);
+		if (next == std::string::npos) {
+			next = s.size();
+		}
+		std::copy(s.begin() + static_cast<std::ptrdiff_t>(in), s.begin() + static_cast<std::ptrdiff_t>(next),
+				s.begin() + static_cast<std::ptrdiff_t>(out));
+		out += next - in;
+		in = next;
+	}
+	s.resize(out);
+	return true;
 }
 
 
@@ -812,8 +1070,24 @@ inline bool string_any_to_unix(std::string& s)
 /// Returns the result string.
 inline std::string string_any_to_unix_copy(std::string_view s)
 {
-	std::string ret(s);
-	string_any_to_unix(ret);
+	std::string::size_type in = s.find('\r');
+	if (in == std::string_view::npos) {
+		return std::string(s);
+	}
+	std::string ret;
+	ret.reserve(s.size());
+	ret.append(s.substr(0, in));
+	while (in < s.size()) {  // s[in] is '\r' here
+		ret += '\n';
+		in += (in + 1 < s.size() && s[in + 1] == '\n') ? 2 : 1;  // dos or mac
+
+		std::string::size_type next = s.find('\r', in);
+		if (next == std::string_view::npos) {
+			next = s.size();
+		}
+		ret.append(s.substr(in, next - in));
+		in = next;
+	}
 	return ret;
 }
 
@@ -840,50 +1114,115 @@ inline std::string string_any_to_dos_copy(std::string_view s)
 
 
 
+namespace internal {
+
+	/// Convert the ASCII letters of \c n bytes of \c in to lowercase (or uppercase if \c to_upper is true),
+	/// writing them to \c out, which may be the same as \c in. The other bytes are copied as is.
+	/// This processes 16 bytes at a time with SSE2 or NEON, if available.
+	inline void string_ascii_convert_case(const char* in, char* out, std::size_t n, bool to_upper)
+	{
+		const unsigned char first = to_upper ? 'a' : 'A';
+		std::size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+		// Signed comparison, so the non-ASCII bytes (negative) are never letters
+		const __m128i before_first = _mm_set1_epi8(static_cast<char>(first - 1));
+		const __m128i after_last = _mm_set1_epi8(static_cast<char>(first + 26));
+		const __m128i case_bit = _mm_set1_epi8(0x20);
+		for (; i + 16 <= n; i += 16) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+			const __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(v, before_first), _mm_cmplt_epi8(v, after_last));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(v, _mm_and_si128(is_letter, case_bit)));
+		}
+#elif defined(__ARM_NEON)
+		// Unsigned comparison of the distance from the first letter
+		const uint8x16_t first_v = vdupq_n_u8(first);
+		const uint8x16_t last_offset = vdupq_n_u8(25);
+		const uint8x16_t case_bit = vdupq_n_u8(0x20);
+		for (; i + 16 <= n; i += 16) {
+			const uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t*>(in + i));
+			const uint8x16_t is_letter = vcleq_u8(vsubq_u8(v, first_v), last_offset);
+			vst1q_u8(reinterpret_cast<std::uint8_t*>(out + i), veorq_u8(v, vandq_u8(is_letter, case_bit)));
+		}
+#endif
+
+		for (; i < n; ++i) {
+			const auto c = static_cast<unsigned char>(in[i]);
+			out[i] = static_cast<char>(static_cast<unsigned char>(c - first) < 26 ? (c ^ 0x20U) : c);
+		}
+	}
+
+}
+
+
+
 /// Convert s to lowercase (modifying s). Return size of the string.
+/// Only ASCII letters are converted, independently of the locale.
 inline std::string::size_type string_to_lower(std::string& s)
 {
-	const std::string::size_type len = s.size();
-	for(std::string::size_type i = 0; i != len; ++i) {
-		s[i] = static_cast<char>(std::tolower(s[i]));
-	}
-	return len;
+	internal::string_ascii_convert_case(s.data(), s.data(), s.size(), false);
+	return s.size();
 }
 
 
 
 /// Convert s to lowercase, not modifying s, returning the changed string.
+/// Only ASCII letters are converted, independently of the locale.
 inline std::string string_to_lower_copy(std::string_view s)
 {
-	std::string ret(s);
-	string_to_lower(ret);
+	std::string ret(s.size(), '\0');
+	internal::string_ascii_convert_case(s.data(), ret.data(), s.size(), false);
 	return ret;
 }
 
 
 
 /// Convert s to uppercase (modifying s). Return size of the string.
+/// Only ASCII letters are converted, independently of the locale.
 inline std::string::size_type string_to_upper(std::string& s)
 {
-	const std::string::size_type len = s.size();
-	for(std::string::size_type i = 0; i != len; ++i) {
-		s[i] = static_cast<char>(std::toupper(s[i]));
-	}
-	return len;
+	internal::string_ascii_convert_case(s.data(), s.data(), s.size(), true);
+	return s.size();
 }
 
 
 
 /// Convert s to uppercase, not modifying s, returning the changed string.
+/// Only ASCII letters are converted, independently of the locale.
 inline std::string string_to_upper_copy(std::string_view s)
 {
-	std::string ret(s);
-	string_to_upper(ret);
+	std::string ret(s.size(), '\0');
+	internal::string_ascii_convert_case(s.data(), ret.data(), s.size(), true);
 	return ret;
 }
 
 
 
+/// Compare two strings, ignoring the case of ASCII letters.
+/// This is the same as comparing the string_to_lower_copy() results, without allocations.
+inline bool string_iequals(std::string_view a, std::string_view b)
+{
+	if (a.size() != b.size()) {
+		return false;
+	}
+	constexpr std::size_t block_size = 64;  // small enough for the stack, large enough for SIMD
+	std::array<char, block_size> a_block {}, b_block {};
+	for (std::size_t pos = 0; pos < a.size(); pos += block_size) {
+		const std::size_t n = std::min(block_size, a.size() - pos);
+		if (std::memcmp(a.data() + pos, b.data() + pos, n) == 0) {
+			continue;
+		}
+		internal::string_ascii_convert_case(a.data() + pos, a_block.data(), n, false);
+		internal::string_ascii_convert_case(b.data() + pos, b_block.data(), n, false);
+		if (std::memcmp(a_block.data(), b_block.data(), n) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
 
 
 }  // ns
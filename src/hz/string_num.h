@@ -13,6 +13,9 @@ Copyright:
 #define HZ_STRING_NUM_H
 
 #include <string>
+#include <charconv>  // std::from_chars
+#include <optional>
+#include <system_error>  // std::errc
 #include <sstream>
 #include <iomanip>  // setbase, setprecision, setw
 #include <ios>  // std::fixed, std::internal
@@ -205,11 +208,100 @@ namespace internal {
 
 
 
+	/// isspace() in classic locale
+	constexpr bool is_classic_space(char c)
+	{
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
+
+
+	/// std::from_chars() version of string_is_numeric_impl_global_locale() in classic locale,
+	/// for integral and float / double types. It handles the common cases only;
+	/// the rest (explicit '+' sign, base prefixes, hexadecimal floats) is left to the stream-based version.
+	/// \return std::nullopt if the string wasn't handled.
+	template<typename T>
+	std::optional<bool> string_is_numeric_impl_from_chars(const std::string& s, T& number, bool strict, int base)
+	{
+		const char* begin = s.data();
+		const char* const end = s.data() + s.size();
+
+		if (begin == end || (strict && is_classic_space(*begin)))  // sto* functions skip leading space
+			return false;
+		while (begin != end && is_classic_space(*begin)) {
+			++begin;
+		}
+		if (begin == end)
+			return false;
+		if (*begin == '+')
+			return std::nullopt;
+
+		const char* digits = (*begin == '-' ? begin + 1 : begin);
+		const bool zero_prefixed = (end - digits > 1 && digits[0] == '0');
+		const bool hex_prefixed = zero_prefixed && (digits[1] == 'x' || digits[1] == 'X');
+
+		if constexpr(std::is_integral_v<T>) {
+			if ((base == 0 && zero_prefixed) || (base == 16 && hex_prefixed) || (base != 0 && (base < 2 || base > 36))) {
+				return std::nullopt;  // octal / hexadecimal prefix, or invalid base
+			}
+			// Same intermediate types as in string_is_numeric_impl_global_locale()
+			constexpr bool parse_as_int = std::is_same_v<T, char>
+					|| std::is_same_v<T, unsigned char>
+					|| std::is_same_v<T, signed char>
+					|| std::is_same_v<T, wchar_t>
+					|| std::is_same_v<T, char16_t>
+					|| std::is_same_v<T, char32_t>
+					|| std::is_same_v<T, short>
+					|| std::is_same_v<T, int>;
+			using WideType = std::conditional_t<parse_as_int, int,
+					std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>;
+			if (*begin == '-' && std::is_unsigned_v<WideType>) {
+				return false;  // "out of range" for unsigned, see string_starts_with_minus()
+			}
+			WideType value = 0;
+			auto [ptr, ec] = std::from_chars(begin, end, value, (base == 0 ? 10 : base));
+			if (ec != std::errc() || value != static_cast<T>(value)) {
+				return false;  // no number or out of range
+			}
+			if (strict && ptr != end) {
+				return false;
+			}
+			number = static_cast<T>(value);
+			return true;
+
+		} else if constexpr(std::is_same_v<T, float> || std::is_same_v<T, double>) {
+#if defined __cpp_lib_to_chars
+			if (hex_prefixed) {
+				return std::nullopt;  // hexadecimal float
+			}
+			T value = T();
+			auto [ptr, ec] = std::from_chars(begin, end, value);
+			if (ec != std::errc()) {
+				return false;  // no number or out of range
+			}
+			if (strict && ptr != end) {
+				return false;
+			}
+			number = value;
+			return true;
+#else
+			return std::nullopt;  // no floating point std::from_chars()
+#endif
+
+		} else {
+			return std::nullopt;
+		}
+	}
+
+
+
 	// Version for integral / floating point types
 	template<typename T>
 	bool string_is_numeric_impl_classic_locale(const std::string& s, T& number, bool strict,  [[maybe_unused]] int base)
 	{
-		// TODO port to std::from_chars().
+		if (auto fast_status = string_is_numeric_impl_from_chars(s, number, strict, base); fast_status.has_value()) {
+			return fast_status.value();
+		}
 		ScopedCLocale loc;
 		return string_is_numeric_impl_global_locale(s, number, strict, base, std::locale::classic());
 	}
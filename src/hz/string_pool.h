@@ -0,0 +1,111 @@
+/******************************************************************************
+License: Zlib
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz
+/// \weakgroup hz
+/// @{
+
+#ifndef HZ_STRING_POOL_H
+#define HZ_STRING_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+
+namespace hz {
+
+
+
+/// A thread-safe pool of shared immutable strings. Interning the same text twice
+/// returns the same string object, so many objects holding the same (possibly long)
+/// text share one copy of it. A string is removed from the pool when the last
+/// pointer to it is destroyed.
+class StringPool {
+	public:
+
+		/// Shared string pointer. Never nullptr if returned by intern().
+		using StringPtr = std::shared_ptr<const std::string>;
+
+
+		/// Get the process-wide pool. It's never destroyed, so the strings may outlive main().
+		static StringPool& get_default()
+		{
+			static auto* pool = new StringPool();
+			return *pool;
+		}
+
+
+		/// Get a shared string with the same contents as \c str
+		StringPtr intern(std::string_view str)
+		{
+			const std::scoped_lock lock(mutex_);
+
+			if (auto iter = strings_.find(str); iter != strings_.end()) {
+				if (StringPtr existing = iter->second.ptr.lock()) {
+					return existing;
+				}
+				// Expired, but its deleter hasn't removed it yet. The key points to the
+				// dying string, so replace the entry together with its key.
+				strings_.erase(iter);
+			}
+
+			auto* new_str = new std::string(str);
+			StringPtr ptr(new_str, [this](const std::string* s) { release(s); });
+			strings_.emplace(std::string_view(*new_str), Entry{new_str, ptr});
+			return ptr;
+		}
+
+
+		/// Get the number of strings in the pool
+		[[nodiscard]] std::size_t size() const
+		{
+			const std::scoped_lock lock(mutex_);
+			return strings_.size();
+		}
+
+
+	private:
+
+		/// Called by the deleter of the last pointer to \c str
+		void release(const std::string* str)
+		{
+			{
+				const std::scoped_lock lock(mutex_);
+				auto iter = strings_.find(std::string_view(*str));
+				if (iter != strings_.end() && iter->second.str == str) {  // not replaced by intern()
+					strings_.erase(iter);
+				}
+			}
+			delete str;
+		}
+
+
+		/// Pool entry
+		struct Entry {
+			const std::string* str = nullptr;  ///< The string the key points to
+			std::weak_ptr<const std::string> ptr;  ///< Pointer to the same string
+		};
+
+		mutable std::mutex mutex_;  ///< Protects strings_
+		std::unordered_map<std::string_view, Entry> strings_;  ///< Keys point to the strings in the entries
+
+};
+
+
+
+}  // ns
+
+
+
+#endif
+
+/// @}
@@ -0,0 +1,209 @@
+/******************************************************************************
+License: Zlib
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz
+/// \weakgroup hz
+/// @{
+
+#ifndef HZ_STRING_REPLACER_H
+#define HZ_STRING_REPLACER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+
+namespace hz {
+
+
+
+/// A set of replacements, compiled once into a trie, which are all performed in a single
+/// pass over the subject. Unlike string_replace_array(), the output of one replacement is
+/// never matched again by the others. At each position the longest matching pattern wins.
+/// Construct it once (e.g. as a "static const" object) and use it many times.
+/// It's immutable after construction, so it may be used by several threads at once.
+class StringReplacer {
+	public:
+
+		/// What the patterns match
+		enum class Mode {
+			Substrings,  ///< Anywhere in the subject
+			Words,  ///< Only whole whitespace-separated words of the subject
+		};
+
+
+		/// Constructor. If a pattern is given more than once, the first replacement is used.
+		/// Empty patterns are ignored.
+		StringReplacer(std::initializer_list<std::pair<std::string_view, std::string_view>> replacements,
+				Mode mode = Mode::Substrings)
+				: mode_(mode)
+		{
+			nodes_.emplace_back();  // root
+			for (const auto& [from, to] : replacements) {
+				add(from, to);
+			}
+		}
+
+
+		/// Replace all the patterns in \c s (modifying s).
+		/// \return The number of replacements performed.
+		std::string::size_type replace(std::string& s) const
+		{
+			std::string out;
+			const std::string::size_type count = replace_into(s, out);
+			if (count != 0) {
+				s = std::move(out);
+			}
+			return count;
+		}
+
+
+		/// Replace all the patterns in \c s, returning the changed string.
+		[[nodiscard]] std::string replace_copy(std::string_view s) const
+		{
+			std::string out;
+			if (replace_into(s, out) == 0) {
+				return std::string(s);
+			}
+			return out;
+		}
+
+
+		/// Replace all the patterns in \c s, writing the result to \c out (which is cleared first).
+		/// If nothing is replaced, \c out is left empty.
+		/// \return The number of replacements performed.
+		std::string::size_type replace_into(std::string_view s, std::string& out) const
+		{
+			out.clear();
+			std::string::size_type count = 0;
+			std::string::size_type copied = 0;  // s is copied to out up to here
+			std::string::size_type pos = 0;
+
+			while (pos < s.size()) {
+				if (!first_chars_[static_cast<unsigned char>(s[pos])]
+						|| (mode_ == Mode::Words && pos > 0 && !is_space(s[pos - 1]))) {
+					++pos;
+					continue;
+				}
+				const auto [replacement_index, match_size] = match_at(s, pos);
+				if (match_size == 0) {
+					++pos;
+					continue;
+				}
+				if (count == 0) {
+					out.reserve(s.size() + s.size() / 4);
+				}
+				out.append(s.substr(copied, pos - copied));
+				out.append(replacements_[replacement_index]);
+				++count;
+				pos += match_size;
+				copied = pos;
+			}
+
+			if (count != 0) {
+				out.append(s.substr(copied));
+			}
+			return count;
+		}
+
+
+	private:
+
+		/// Trie node
+		struct Node {
+			std::vector<std::pair<unsigned char, std::uint32_t>> children;  ///< Child node indices by character
+			std::int32_t replacement_index = -1;  ///< Index in replacements_ if a pattern ends here, -1 if not
+		};
+
+
+		/// Whitespace check for Words mode, locale-independent
+		static bool is_space(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+		}
+
+
+		/// Find the child of \c node_index for character \c c. \return 0 (root) if there is none.
+		[[nodiscard]] std::uint32_t find_child(std::uint32_t node_index, unsigned char c) const
+		{
+			for (const auto& [child_char, child_index] : nodes_[node_index].children) {
+				if (child_char == c) {
+					return child_index;
+				}
+			}
+			return 0;
+		}
+
+
+		/// Add a replacement
+		void add(std::string_view from, std::string_view to)
+		{
+			if (from.empty()) {
+				return;
+			}
+			std::uint32_t node_index = 0;
+			for (const char c : from) {
+				const auto uc = static_cast<unsigned char>(c);
+				std::uint32_t child_index = find_child(node_index, uc);
+				if (child_index == 0) {
+					child_index = static_cast<std::uint32_t>(nodes_.size());
+					nodes_[node_index].children.emplace_back(uc, child_index);
+					nodes_.emplace_back();  // may invalidate the references to nodes_
+				}
+				node_index = child_index;
+			}
+			if (nodes_[node_index].replacement_index == -1) {
+				nodes_[node_index].replacement_index = static_cast<std::int32_t>(replacements_.size());
+				replacements_.emplace_back(to);
+			}
+			first_chars_[static_cast<unsigned char>(from.front())] = true;
+		}
+
+
+		/// Find the longest pattern starting at \c pos.
+		/// \return The replacement index and the pattern size, which is 0 if nothing matched.
+		[[nodiscard]] std::pair<std::size_t, std::size_t> match_at(std::string_view s, std::size_t pos) const
+		{
+			std::pair<std::size_t, std::size_t> result = {0, 0};
+			std::uint32_t node_index = 0;
+			for (std::size_t i = pos; i < s.size(); ++i) {
+				node_index = find_child(node_index, static_cast<unsigned char>(s[i]));
+				if (node_index == 0) {
+					break;
+				}
+				const std::int32_t replacement_index = nodes_[node_index].replacement_index;
+				const bool at_word_end = (mode_ == Mode::Substrings || i + 1 == s.size() || is_space(s[i + 1]));
+				if (replacement_index != -1 && at_word_end) {
+					result = {static_cast<std::size_t>(replacement_index), i + 1 - pos};
+				}
+			}
+			return result;
+		}
+
+
+		Mode mode_ = Mode::Substrings;  ///< What the patterns match
+		std::vector<Node> nodes_;  ///< Trie nodes, the first one is the root
+		std::vector<std::string> replacements_;  ///< Replacement strings
+		std::array<bool, 256> first_chars_ = {};  ///< Characters the patterns start with
+
+};
+
+
+
+}  // ns
+
+
+
+#endif
+
+/// @}
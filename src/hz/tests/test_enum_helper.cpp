@@ -0,0 +1,79 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz_tests
+/// \weakgroup hz_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+// The first header should be then one we're testing, to avoid missing
+// header pitfalls.
+#include "hz/enum_helper.h"
+
+#include <string>
+#include <vector>
+
+
+
+namespace {
+
+	/// Sparse enum, like the NVMe self-test codes
+	enum class TestColor {
+		Unknown = -1,
+		Red = 0x1,
+		Green = 0x2,
+		Blue = 0xe,
+	};
+
+
+	/// Helper structure for enum-related functions
+	struct TestColorExt
+			: public hz::EnumTableHelper<
+					TestColor,
+					TestColorExt>
+	{
+		static constexpr TestColor default_value = TestColor::Unknown;
+
+		static constexpr auto enum_table = std::to_array<hz::EnumTableEntry<EnumType>>({
+			{TestColor::Blue, "blue", "Blue"},
+			{TestColor::Unknown, "unknown", "Unknown"},
+			{TestColor::Red, "red", "Red"},
+			{TestColor::Green, "green", "Green"},
+		});
+	};
+
+}
+
+
+
+TEST_CASE("EnumTableHelper", "[hz][enum_helper]")
+{
+	REQUIRE(TestColorExt::get_storable_name(TestColor::Blue) == "blue");
+	REQUIRE(TestColorExt::get_storable_name_view(TestColor::Unknown) == "unknown");
+	REQUIRE(TestColorExt::get_displayable_name(TestColor::Green) == "Green");
+
+	// Not in the table
+	REQUIRE(TestColorExt::get_storable_name(static_cast<TestColor>(0x3)).empty());
+	REQUIRE(TestColorExt::get_storable_name(static_cast<TestColor>(-5)).empty());
+	REQUIRE(TestColorExt::get_displayable_name(static_cast<TestColor>(1000)).empty());
+
+	REQUIRE(TestColorExt::get_by_storable_name("red") == TestColor::Red);
+	REQUIRE(TestColorExt::get_by_storable_name("purple") == TestColor::Unknown);
+	REQUIRE(TestColorExt::get_by_storable_name("purple", TestColor::Green) == TestColor::Green);
+
+	const std::vector<TestColor> all = {TestColor::Unknown, TestColor::Red, TestColor::Green, TestColor::Blue};
+	REQUIRE(TestColorExt::get_all_values() == all);
+}
+
+
+
+/// @}
@@ -0,0 +1,78 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz_tests
+/// \weakgroup hz_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+// The first header should be then one we're testing, to avoid missing
+// header pitfalls.
+#include "hz/error_holder.h"
+
+#include <cerrno>
+#include <memory>
+#include <string>
+
+
+
+TEST_CASE("ErrorHolder", "[hz][error_holder]")
+{
+	hz::ErrorHolder holder;
+	REQUIRE(!holder.has_errors());
+
+	SECTION("Unbounded") {
+		for (int i = 0; i < 10; ++i) {
+			holder.push_error(hz::Error<int>("custom", hz::ErrorLevel::Dump, i, std::to_string(i)));
+		}
+		REQUIRE(holder.get_errors().size() == 10);
+		REQUIRE(holder.get_dropped_error_count() == 0);
+	}
+
+	SECTION("Ring") {
+		holder.set_max_errors(3);
+		for (int i = 0; i < 10; ++i) {
+			holder.push_error(hz::Error<int>("custom", hz::ErrorLevel::Dump, i, std::to_string(i)));
+		}
+		const auto errors = holder.get_errors();
+		REQUIRE(errors.size() == 3);
+		REQUIRE(errors[0]->get_message() == "7");
+		REQUIRE(errors[2]->get_message() == "9");
+		REQUIRE(holder.get_dropped_error_count() == 7);
+
+		// Shrinking keeps the newest ones
+		holder.set_max_errors(1);
+		REQUIRE(holder.get_errors().size() == 1);
+		REQUIRE(holder.get_errors().back()->get_message() == "9");
+
+		holder.clear_errors();
+		REQUIRE(!holder.has_errors());
+		REQUIRE(holder.get_dropped_error_count() == 0);
+	}
+
+	SECTION("LazyMessage") {
+		holder.push_error(hz::Error<int>("errno", hz::ErrorLevel::Dump, ENOENT));
+		const auto errors = holder.get_errors();
+		REQUIRE(errors.back()->get_code<int>() == ENOENT);
+		REQUIRE(!errors.back()->get_message().empty());
+
+		std::unique_ptr<hz::ErrorBase> cloned(errors.back()->clone());
+		REQUIRE(cloned->get_message() == errors.back()->get_message());
+	}
+}
+
+
+
+
+
+
+/// @}
@@ -26,6 +26,7 @@ Copyright:
 // header pitfalls.
 #include "hz/string_algo.h"
 
+#include <string_view>
 #include <vector>
 
 
@@ -82,6 +83,51 @@ TEST_CASE("StringAlgorithms", "[hz][string]")
 		});
 	}
 
+	SECTION("string_split into views") {
+		std::vector<std::string_view> result;
+		hz::string_split("aa\n\nbb\n\n", "\n\n", result, false);
+		REQUIRE(result == std::vector<std::string_view> {"aa", "bb", ""});
+	}
+
+	SECTION("string_split_view") {
+		auto to_vector = [](const auto& range) {
+			std::vector<std::string_view> result;
+			for (const std::string_view component : range) {
+				result.push_back(component);
+			}
+			return result;
+		};
+		for (const std::string_view s : {"", "/", "aa", "/aa/bbb/ccccc//dsada//", "aa//b"}) {
+			for (const bool skip_empty : {false, true}) {
+				std::vector<std::string_view> expected;
+				string_split(s, '/', expected, skip_empty);
+				REQUIRE(to_vector(string_split_view(s, '/', skip_empty)) == expected);
+
+				expected.clear();
+				string_split_by_chars(s, "/b", expected, skip_empty);
+				REQUIRE(to_vector(string_split_view_by_chars(s, "/b", skip_empty)) == expected);
+			}
+		}
+		REQUIRE(to_vector(string_split_view("//aa////bbb/ccccc//dsada////", "//"))
+				== std::vector<std::string_view> {"", "aa", "", "bbb/ccccc", "dsada", "", ""});
+		REQUIRE(to_vector(string_split_view("aa\n\nbb\n\n", "\n\n", true)) == std::vector<std::string_view> {"aa", "bb"});
+		REQUIRE(to_vector(string_split_view("aa", "")) == std::vector<std::string_view> {"aa"});
+
+		std::size_t count = 0;
+		for (const std::string_view line : string_split_view("a\nb\n", '\n', true)) {
+			REQUIRE(line.size() == 1);
+			++count;
+		}
+		REQUIRE(count == 2);
+	}
+
+	SECTION("string_trim_view") {
+		REQUIRE(hz::string_trim_view(" \t aa b\r\n") == "aa b");
+		REQUIRE(hz::string_trim_view("aa") == "aa");
+		REQUIRE(hz::string_trim_view(" \n ").empty());
+		REQUIRE(hz::string_trim_view("\tab\t", "\t") == "ab");
+	}
+
 	SECTION("string_remove_adjacent_duplicates") {
 		std::string s = "  a b bb  c     d   ";
 		REQUIRE(string_remove_adjacent_duplicates_copy(s, ' ') == " a b bb c d ");
@@ -124,6 +170,37 @@ TEST_CASE("StringAlgorithms", "[hz][string]")
 		string_replace_array(s, from, ":");
 		REQUIRE(s == ":345678:defg : ab");
 	}
+
+	SECTION("string_to_lower, string_to_upper") {
+		// Longer than a SIMD block, with the characters around the letter ranges and non-ASCII bytes
+		const std::string mixed = "@AZ[`az{ Reallocated_Sector_Ct \xc3\x84\xff 0x0033 Pre-fail";
+		REQUIRE(string_to_lower_copy(mixed) == "@az[`az{ reallocated_sector_ct \xc3\x84\xff 0x0033 pre-fail");
+		REQUIRE(string_to_upper_copy(mixed) == "@AZ[`AZ{ REALLOCATED_SECTOR_CT \xc3\x84\xff 0X0033 PRE-FAIL");
+		std::string s = mixed;
+		REQUIRE(string_to_lower(s) == mixed.size());
+		REQUIRE(s == string_to_lower_copy(mixed));
+		REQUIRE(string_to_lower_copy("").empty());
+	}
+
+	SECTION("string_iequals") {
+		REQUIRE(string_iequals("Airflow_Temperature_Cel", "airflow_temperature_cel"));
+		REQUIRE(string_iequals(std::string(100, 'a') + "Z", std::string(100, 'A') + "z"));
+		REQUIRE(!string_iequals(std::string(100, 'a') + "Z", std::string(100, 'A') + "y"));
+		REQUIRE(!string_iequals("abc", "abcd"));
+		REQUIRE(!string_iequals("[", "{"));  // differ in the case bit, but are not letters
+		REQUIRE(string_iequals("", ""));
+	}
+
+	SECTION("string_any_to_unix") {
+		std::string s = "a\r\nb\rc\n\r\r\nd\r";
+		REQUIRE(string_any_to_unix(s));
+		REQUIRE(s == "a\nb\nc\n\n\nd\n");
+		REQUIRE(!string_any_to_unix(s));
+		REQUIRE(string_any_to_unix_copy("a\r\nb\rc\n\r\r\nd\r") == "a\nb\nc\n\n\nd\n");
+		REQUIRE(string_any_to_unix_copy("\r\n") == "\n");
+		REQUIRE(string_any_to_unix_copy("abc") == "abc");
+		REQUIRE(string_any_to_dos_copy("a\nb\r\n") == "a\r\nb\r\n");
+	}
 }
 
 
@@ -174,6 +174,42 @@ TEST_CASE("NumericStrings", "[hz][parser]")
 		d = 10;
 		REQUIRE(string_is_numeric_nolocale("e+3", d) == false);
 		REQUIRE(std::abs(10 - d) <= eps);
+
+		// Not handled by std::from_chars(), see string_is_numeric_impl_from_chars()
+		d = 10;
+		REQUIRE(string_is_numeric_nolocale("+2.5", d) == true);
+		REQUIRE(std::abs(2.5 - d) <= eps);
+
+		d = 10;
+		REQUIRE(string_is_numeric_nolocale("0x1p3", d) == true);
+		REQUIRE(std::abs(8 - d) <= eps);
+	}
+	{
+		// Base prefixes and explicit '+' go through the stream-based version
+		int i = 10;
+		REQUIRE(string_is_numeric_nolocale("0x1f", i, true, 16) == true);
+		REQUIRE(i == 31);
+		REQUIRE(string_is_numeric_nolocale("1f", i, true, 16) == true);
+		REQUIRE(i == 31);
+		REQUIRE(string_is_numeric_nolocale("017", i, true, 0) == true);
+		REQUIRE(i == 15);
+		REQUIRE(string_is_numeric_nolocale("017", i, true, 10) == true);
+		REQUIRE(i == 17);
+		REQUIRE(string_is_numeric_nolocale("+5", i) == true);
+		REQUIRE(i == 5);
+		REQUIRE(string_is_numeric_nolocale("-", i) == false);
+		REQUIRE(string_is_numeric_nolocale("", i) == false);
+		REQUIRE(string_is_numeric_nolocale("12abc", i) == false);  // strict
+		REQUIRE(string_is_numeric_nolocale("12abc", i, false) == true);
+		REQUIRE(i == 12);
+
+		unsigned char uchar_ = 10;
+		REQUIRE(string_is_numeric_nolocale("-0", uchar_) == true);  // parsed as int
+		REQUIRE(uchar_ == 0);
+
+		unsigned short ushort_ = 10;
+		REQUIRE(string_is_numeric_nolocale("-0", ushort_) == false);  // parsed as unsigned long
+		REQUIRE(ushort_ == 10);
 	}
 	{
 
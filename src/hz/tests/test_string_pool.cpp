@@ -0,0 +1,57 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz_tests
+/// \weakgroup hz_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+// The first header should be then one we're testing, to avoid missing
+// header pitfalls.
+#include "hz/string_pool.h"
+
+#include <string>
+
+
+
+TEST_CASE("StringPool", "[hz][string_pool]")
+{
+	hz::StringPool pool;
+
+	auto a = pool.intern("Some long description text, shared by many properties");
+	auto b = pool.intern(std::string("Some long description text, shared by many properties"));
+	auto c = pool.intern("Other text");
+
+	REQUIRE(a.get() == b.get());
+	REQUIRE(*a == "Some long description text, shared by many properties");
+	REQUIRE(*c == "Other text");
+	REQUIRE(pool.size() == 2);
+
+	c.reset();
+	REQUIRE(pool.size() == 1);
+
+	a.reset();
+	REQUIRE(pool.size() == 1);  // still held by b
+	b.reset();
+	REQUIRE(pool.size() == 0);
+
+	auto d = pool.intern("Other text");
+	REQUIRE(*d == "Other text");
+	REQUIRE(pool.size() == 1);
+}
+
+
+
+
+
+
+/// @}
@@ -0,0 +1,68 @@
+/******************************************************************************
+License: BSD Zero Clause License
+Copyright:
+	(C) 2024 Alexander Shaduri <ashaduri@gmail.com>
+******************************************************************************/
+/// \file
+/// \author Alexander Shaduri
+/// \ingroup hz_tests
+/// \weakgroup hz_tests
+/// @{
+
+// Catch2 v3
+//#include "catch2/catch_test_macros.hpp"
+
+// Catch2 v2
+#include "catch2/catch.hpp"
+
+// The first header should be then one we're testing, to avoid missing
+// header pitfalls.
+#include "hz/string_replacer.h"
+
+#include <string>
+
+
+
+TEST_CASE("StringReplacer", "[hz][string]")
+{
+	SECTION("substrings") {
+		const hz::StringReplacer replacer = {
+				{"a", "1"},
+				{"ab", "2"},
+				{"abc", "3"},
+				{"b", "bb"},
+				{"a", "ignored"},
+				{"", "ignored"},
+		};
+		REQUIRE(replacer.replace_copy("abcd ab a b xyz abab") == "3d 2 1 bb xyz 22");
+		REQUIRE(replacer.replace_copy("xyz") == "xyz");
+		REQUIRE(replacer.replace_copy("") == "");
+
+		// The replaced text is not matched again
+		std::string s = "bab";
+		REQUIRE(replacer.replace(s) == 2);
+		REQUIRE(s == "bb2");
+
+		std::string unchanged = "xyz";
+		REQUIRE(replacer.replace(unchanged) == 0);
+		REQUIRE(unchanged == "xyz");
+	}
+
+	SECTION("words") {
+		const hz::StringReplacer replacer({
+				{"Ct", "Count"},
+				{"Err", "Error"},
+				{"Errs", "Errors"},
+		}, hz::StringReplacer::Mode::Words);
+		REQUIRE(replacer.replace_copy("Err Ct") == "Error Count");
+		REQUIRE(replacer.replace_copy("Read Errs Ct\tErr") == "Read Errors Count\tError");
+		REQUIRE(replacer.replace_copy("Ctl Errors xErr Ct_") == "Ctl Errors xErr Ct_");
+	}
+}
+
+
+
+
+
+
+/// @}
@@ -81,6 +81,106 @@ std::string debug_format_message(debug_level::flag level, const std::string& dom
 
 
 
+DebugChannelAsyncOStream::DebugChannelAsyncOStream(std::ostream& os)
+		: os_(os), writer_thread_(&DebugChannelAsyncOStream::writer_loop, this)
+{ }
+
+
+
+DebugChannelAsyncOStream::~DebugChannelAsyncOStream()
+{
+	stop_.store(true, std::memory_order_release);
+	wakeup_.fetch_add(1, std::memory_order_release);
+	wakeup_.notify_one();
+	writer_thread_.join();
+}
+
+
+
+void DebugChannelAsyncOStream::send(debug_level::flag level, const std::string& domain,
+		debug_format::flags& format_flags, int indent_level, bool is_first_line, const std::string& msg)
+{
+	std::string text = debug_format_message(level, domain, format_flags, indent_level, is_first_line, msg);
+	if (text.empty())
+		return;
+
+	// Count before pushing, so that the written count never exceeds the sent count (see flush()).
+	sent_count_.fetch_add(1, std::memory_order_acq_rel);
+
+	auto* record = new Record{std::move(text), head_.load(std::memory_order_relaxed)};
+	while (!head_.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+		// record->next is updated with the current head, retry
+	}
+
+	wakeup_.fetch_add(1, std::memory_order_release);
+	wakeup_.notify_one();
+
+	// The program may be terminated right after a fatal message
+	if (level == debug_level::fatal) {
+		flush();
+	}
+}
+
+
+
+void DebugChannelAsyncOStream::flush()
+{
+	const std::uint64_t target = sent_count_.load(std::memory_order_acquire);
+	std::uint64_t written = written_count_.load(std::memory_order_acquire);
+	while (written < target) {
+		written_count_.wait(written, std::memory_order_acquire);
+		written = written_count_.load(std::memory_order_acquire);
+	}
+}
+
+
+
+void DebugChannelAsyncOStream::writer_loop()
+{
+	while (true) {
+		const std::uint32_t wakeup = wakeup_.load(std::memory_order_acquire);
+		write_queued();
+		if (stop_.load(std::memory_order_acquire)) {
+			write_queued();  // anything sent while stopping
+			break;
+		}
+		wakeup_.wait(wakeup, std::memory_order_acquire);
+	}
+}
+
+
+
+void DebugChannelAsyncOStream::write_queued()
+{
+	Record* head = head_.exchange(nullptr, std::memory_order_acquire);
+	if (!head)
+		return;
+
+	// Reverse the list to get the records in the order they were sent
+	Record* first = nullptr;
+	while (head) {
+		Record* next = head->next;
+		head->next = first;
+		first = head;
+		head = next;
+	}
+
+	std::uint64_t count = 0;
+	while (first) {
+		os_ << first->text;
+		Record* next = first->next;
+		delete first;
+		first = next;
+		++count;
+	}
+	os_.flush();
+
+	written_count_.fetch_add(count, std::memory_order_release);
+	written_count_.notify_all();
+}
+
+
+
 
 
 
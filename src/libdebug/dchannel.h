@@ -15,6 +15,9 @@ Copyright:
 #include <string>
 #include <ostream>  // std::ostream (iosfwd is not enough for win32 and suncc)
 #include <memory>
+#include <atomic>
+#include <cstdint>
+#include <thread>
 
 #include "dflags.h"
 
@@ -97,6 +100,65 @@ class DebugChannelOStream : public DebugChannelBase {
 
 
 
+/// Asynchronous std::ostream wrapper as a DebugChannel.
+/// The messages are formatted in the calling thread and pushed to a lock-free
+/// multiple-producer queue, which is drained into the ostream by a writer thread.
+/// send() may be called from any thread. Fatal messages are written before send() returns.
+/// The remaining messages are written when the channel is destroyed.
+class DebugChannelAsyncOStream : public DebugChannelBase {
+	public:
+
+		/// Constructor, starts the writer thread
+		explicit DebugChannelAsyncOStream(std::ostream& os);
+
+		/// Destructor, writes the queued messages and stops the writer thread
+		~DebugChannelAsyncOStream() override;
+
+		/// Reimplemented from DebugChannelBase.
+		void send(debug_level::flag level, const std::string& domain,
+				debug_format::flags& format_flags, int indent_level, bool is_first_line, const std::string& msg) override;
+
+
+		// Non-debug-API members:
+
+		/// Wait until all the messages sent so far are written to the ostream.
+		void flush();
+
+		/// Get the ostream. Do not write to it directly, the writer thread may be using it.
+		[[nodiscard]] std::ostream& get_ostream()
+		{
+			return os_;
+		}
+
+
+	private:
+
+		/// A queued preformatted message
+		struct Record {
+			std::string text;  ///< Formatted message
+			Record* next = nullptr;  ///< Next (earlier sent) record
+		};
+
+		/// Writer thread function
+		void writer_loop();
+
+		/// Write all the queued records to the ostream.
+		void write_queued();
+
+
+		std::ostream& os_;  ///< Wrapped ostream
+
+		std::atomic<Record*> head_ = nullptr;  ///< Last sent record (the queue is a reverse-ordered list)
+		std::atomic<std::uint64_t> sent_count_ = 0;  ///< Number of records pushed to the queue
+		std::atomic<std::uint64_t> written_count_ = 0;  ///< Number of records written to the ostream
+		std::atomic<std::uint32_t> wakeup_ = 0;  ///< Changed to wake up the writer thread
+		std::atomic<bool> stop_ = false;  ///< Set when the writer thread has to exit
+
+		std::thread writer_thread_;  ///< Writer thread
+};
+
+
+
 
 
 
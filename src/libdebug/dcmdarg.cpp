@@ -18,10 +18,13 @@ Copyright:
 #include <sstream>
 #include <ios>  // std::boolalpha
 #include <algorithm>  // std::find
+#include <iostream>  // std::cerr
+#include <memory>
 
 #include "hz/string_algo.h"  // string_split()
 
 #include "dcmdarg.h"
+#include "dchannel.h"
 #include "dflags.h"
 #include "dstate.h"
 
@@ -145,6 +148,13 @@ static gboolean debug_internal_post_parse_func([[maybe_unused]] GOptionContext*
 
 	const bool color_enabled = static_cast<bool>(args->debug_colorize);
 
+	// Dump-level output (full file contents, command outputs) is large enough to slow down
+	// its producers when written synchronously, so write std::cerr output from a separate thread.
+	DebugChannelBasePtr async_cerr_channel;
+	if (args->levels_enabled.test(debug_level::dump)) {
+		async_cerr_channel = std::make_shared<DebugChannelAsyncOStream>(std::cerr);
+	}
+
 
 	debug_internal::DebugState::DomainMap& domain_map = debug_internal::get_debug_state_ref().get_domain_map_ref();
 
@@ -155,6 +165,15 @@ static gboolean debug_internal_post_parse_func([[maybe_unused]] GOptionContext*
 			debug_format::flags format = stream->get_format();
 			format.set(debug_format::color, color_enabled);
 			stream->set_format(format);
+
+			if (async_cerr_channel) {
+				for (auto& channel : stream->get_channels()) {
+					auto ostream_channel = std::dynamic_pointer_cast<DebugChannelOStream>(channel);
+					if (ostream_channel && &ostream_channel->get_ostream() == &std::cerr) {
+						channel = async_cerr_channel;
+					}
+				}
+			}
 		}
 	}
 
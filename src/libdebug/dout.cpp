@@ -34,7 +34,7 @@ std::ostream& debug_out(debug_level::flag level, const std::string& domain)
 	}
 
 	auto os = level_map->second.find(level);
-	if (level_map == dm.end()) {
+	if (os == level_map->second.end()) {
 		const std::string msg = std::string("debug_out(): Debug state doesn't contain the requested level ") +
 				debug_level::get_name(level) + " in domain: \"" + domain + "\".";
 
@@ -42,7 +42,30 @@ std::ostream& debug_out(debug_level::flag level, const std::string& domain)
 		throw debug_internal_error(msg.c_str());
 	}
 
-	return *(os->second);
+	return os->second->get_thread_stream();
+}
+
+
+
+namespace debug_internal {
+
+
+	bool debug_out_enabled_in_domain(debug_level::flag level, const std::string& domain)
+	{
+		auto& dm = get_debug_state_ref().get_domain_map_ref();
+
+		auto level_map = dm.find(domain);
+		if (level_map == dm.end()) {
+			return true;  // let debug_out() report it
+		}
+		auto os = level_map->second.find(level);
+		if (os == level_map->second.end()) {
+			return true;
+		}
+		return os->second->get_enabled();
+	}
+
+
 }
 
 
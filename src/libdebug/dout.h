@@ -12,7 +12,10 @@ Copyright:
 #ifndef LIBDEBUG_DOUT_H
 #define LIBDEBUG_DOUT_H
 
+#include <array>
+#include <atomic>
 #include <string>
+#include <string_view>
 // Note: Sun compiler refuses to compile without <ostream> (iosfwd is not enough).
 // Since every useful operator << is defined in ostream, we include it here anyway.
 #include <ostream>  // std::ostream
@@ -25,44 +28,87 @@ Copyright:
 
 
 /// Get a libdebug-handled stream for \c level and \c domain.
+/// Each thread gets its own stream, and every complete line is sent to the channels
+/// as a single record, so the threads may write without any locking.
 /// \throw debug_usage_error if invalid domain or level.
 std::ostream& debug_out(debug_level::flag level, const std::string& domain);
 
 
 
+namespace debug_internal {
+
+	/// Number of enabled debug streams (in all domains) for each level, maintained by DebugOutStream.
+	inline std::array<std::atomic<int>, debug_level::bits> enabled_stream_counts = {};
+
+	/// Check whether the stream for \c level and \c domain is enabled.
+	/// \return true also for unknown domains, so that debug_out() reports them.
+	[[nodiscard]] bool debug_out_enabled_in_domain(debug_level::flag level, const std::string& domain);
+
+}
+
+
+/// Check whether the output sent to \c level and \c domain would be emitted.
+/// This is a single atomic load if the level is disabled in all domains.
+[[nodiscard]] inline bool debug_out_enabled(debug_level::flag level, std::string_view domain)
+{
+	if (debug_internal::enabled_stream_counts[level].load(std::memory_order_relaxed) == 0) {
+		return false;
+	}
+	return debug_internal::debug_out_enabled_in_domain(level, std::string(domain));
+}
+
+
+
 // These are macros to be able to easily compile-out per-level output.
+// The output expression is evaluated only if the domain / level is enabled.
+// If LIBDEBUG_DISABLE_DUMP is defined to 1, the dump-level output is removed at compile time.
 
+/// \def debug_out_dump(domain, output)
 /// Send an output to debug stream. For example:
 /// \code
 /// debug_out_error("app", DBG_FUNC_MSG << "Error in structure consistency.\n");
 /// debug_out_dump("app", "Error value: " << value << ".\n");
 /// \endcode
-#define debug_out_dump(domain, output) \
-	debug_out(debug_level::dump, domain) << output
+#if defined LIBDEBUG_DISABLE_DUMP && LIBDEBUG_DISABLE_DUMP
+	// The output is not evaluated (sizeof), but still referenced to avoid unused variable warnings.
+	#define debug_out_dump(domain, output) \
+		static_cast<void>(sizeof(debug_out(debug_level::dump, (domain)) << output))
+#else
+	#define debug_out_dump(domain, output) \
+		debug_internal_out_if_enabled(debug_level::dump, domain, output)
+#endif
 
 /// Send an output to debug stream. \see debug_out_dump().
 #define debug_out_info(domain, output) \
-	debug_out(debug_level::info, domain) << output
+	debug_internal_out_if_enabled(debug_level::info, domain, output)
 
 /// Send an output to debug stream. \see debug_out_dump().
 #define debug_out_warn(domain, output) \
-	debug_out(debug_level::warn, domain) << output
+	debug_internal_out_if_enabled(debug_level::warn, domain, output)
 
 /// Send an output to debug stream. \see debug_out_dump().
 #define debug_out_error(domain, output) \
-	debug_out(debug_level::error, domain) << output
+	debug_internal_out_if_enabled(debug_level::error, domain, output)
 
 /// Send an output to debug stream. \see debug_out_dump().
 #define debug_out_fatal(domain, output) \
-	debug_out(debug_level::fatal, domain) << output
+	debug_internal_out_if_enabled(debug_level::fatal, domain, output)
+
+
+/// Implementation of debug_out_*() macros. This is an expression (not an if statement),
+/// so that the macros can be used as unbraced if / else bodies.
+#define debug_internal_out_if_enabled(level, domain, output) \
+	(debug_out_enabled((level), (domain)) \
+		? static_cast<void>(debug_out((level), (domain)) << output) \
+		: static_cast<void>(0))
 
 
 
 /// Start prefix printing. Useful for large dumps where you don't want prefixes to
-/// be printed on each debug_* call.
+/// be printed on each debug_* call. This affects the calling thread only.
 void debug_begin();
 
-/// Stop prefix printing.
+/// Stop prefix printing in the calling thread.
 void debug_end();
 
 
@@ -230,13 +276,13 @@ namespace debug_internal {
 
 
 
-/// Increase indentation level for all debug levels
+/// Increase indentation level for all debug levels (in the calling thread)
 void debug_indent_inc(int by = 1);
 
-/// Decrease indentation level for all debug levels
+/// Decrease indentation level for all debug levels (in the calling thread)
 void debug_indent_dec(int by = 1);
 
-/// Reset indentation level to 0 for all debug levels
+/// Reset indentation level to 0 for all debug levels (in the calling thread)
 void debug_indent_reset();
 
 
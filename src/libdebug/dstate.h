@@ -32,7 +32,8 @@ namespace debug_internal {
 	// domain name "all" - used for manipulating all domains.
 
 
-	/// Libdebug global state
+	/// Libdebug global state.
+	/// The indentation level and the debug_begin() / debug_end() contexts are per-thread.
 	class DebugState {
 		public:
 
@@ -62,25 +63,25 @@ namespace debug_internal {
 			}
 
 
-			/// Get current indentation level.
+			/// Get current indentation level of the calling thread.
 			[[nodiscard]] int get_indent_level() const
 			{
 				return indent_level_;
 			}
 
-			/// Set current indentation level.
+			/// Set current indentation level of the calling thread.
 			void set_indent_level(int indent_level)
 			{
 				indent_level_ = indent_level;
 			}
 
-			/// Open a debug_begin() context.
+			/// Open a debug_begin() context in the calling thread.
 			void push_inside_begin(bool value = true)
 			{
 				inside_begin_.push(value);
 			}
 
-			/// Close a debug_begin() context.
+			/// Close a debug_begin() context in the calling thread.
 			bool pop_inside_begin()
 			{
 				if (inside_begin_.empty())
@@ -90,7 +91,7 @@ namespace debug_internal {
 				return val;
 			}
 
-			/// Check if we're inside a debug_begin() context.
+			/// Check if the calling thread is inside a debug_begin() context.
 			[[nodiscard]] bool get_inside_begin() const
 			{
 				if (inside_begin_.empty())
@@ -99,7 +100,7 @@ namespace debug_internal {
 			}
 
 
-			/// Flush all the stream buffers. This will write prefixes too.
+			/// Flush all the stream buffers of the calling thread. This will write prefixes too.
 			void force_output()
 			{
 				for (auto& iter : domain_map) {
@@ -111,8 +112,8 @@ namespace debug_internal {
 
 		private:
 
-			int indent_level_ = 0;  ///< Current indentation level
-			std::stack<bool> inside_begin_;  ///< True if inside debug_begin() / debug_end() block
+			static inline thread_local int indent_level_ = 0;  ///< Current indentation level
+			static inline thread_local std::stack<bool> inside_begin_;  ///< True if inside debug_begin() / debug_end() block
 
 			DomainMap domain_map;  ///< Domain / debug level mapping.
 
@@ -10,6 +10,7 @@ Copyright:
 /// @{
 
 #include <ostream>  // std::ostream definition
+#include <unordered_map>
 
 #include "dstream.h"
 #include "dstate.h"
@@ -49,30 +50,78 @@ namespace debug_internal {
 
 	void DebugStreamBuf::flush_to_channel()
 	{
-		debug_format::flags flags = dos_->format_;
+		const std::shared_ptr<DebugOutStream> dos = dos_.lock();
+		if (!dos) {  // the domain was unregistered
+			buffer_.clear();
+			return;
+		}
+
+		debug_format::flags flags = dos->format_;
 		bool is_first_line = false;
 		if (get_debug_state_ref().get_inside_begin()) {
 			flags.set(debug_format::first_line_only);
-			if (dos_->get_is_first_line()) {
-				dos_->set_is_first_line(false);  // tls
+			if (is_first_line_) {
+				is_first_line_ = false;
 				is_first_line = true;
 			}
 		} else {
-			dos_->set_is_first_line(true);
+			is_first_line_ = true;
 			is_first_line = true;
 		}
 
-		for (auto& channel : dos_->channels_) {
+		if (buffer_.empty()) {
+			return;
+		}
+		for (auto& channel : dos->channels_) {
 			// send() locks the channel if needed
-			channel->send(dos_->level_, dos_->domain_, flags,
-					get_debug_state_ref().get_indent_level(), is_first_line, oss_.str());
+			channel->send(dos->level_, dos->domain_, flags,
+					get_debug_state_ref().get_indent_level(), is_first_line, buffer_);
+		}
+		buffer_.clear();
+	}
+
+
+
+	namespace {
+
+		/// Per-thread streams of the calling thread, by DebugOutStream ID
+		std::unordered_map<std::uint64_t, std::unique_ptr<DebugThreadStream>>& get_thread_streams()
+		{
+			thread_local std::unordered_map<std::uint64_t, std::unique_ptr<DebugThreadStream>> streams;
+			return streams;
+		}
+
+	}
+
+
+
+	std::ostream& DebugOutStream::get_thread_stream()
+	{
+		auto& stream = get_thread_streams()[id_];
+		if (!stream) {
+			stream = std::make_unique<DebugThreadStream>(weak_from_this());
+		}
+		stream->set_enabled(get_enabled());
+		return *stream;
+	}
+
+
+
+	void DebugOutStream::force_output()
+	{
+		auto& streams = get_thread_streams();
+		if (auto iter = streams.find(id_); iter != streams.end()) {
+			iter->second->force_output();
 		}
-		oss_.str("");  // clear the buffer
-		oss_.clear();  // clear the flags
 	}
 
 
 
+	std::uint64_t DebugOutStream::get_new_id()
+	{
+		static std::atomic<std::uint64_t> next_id = 0;
+		return next_id.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
 
@@ -12,16 +12,19 @@ Copyright:
 #ifndef LIBDEBUG_DSTREAM_H
 #define LIBDEBUG_DSTREAM_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <ostream>  // std::ostream definition
 #include <streambuf>  // std::streambuf definition
-#include <cstdio>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "dflags.h"
 #include "dchannel.h"
+#include "dout.h"
 
 
 
@@ -44,24 +47,17 @@ namespace debug_internal {
 	class DebugOutStream;
 
 
-	/// Streambuf for libdebug, used in DebugOutStream implementation.
+	/// Streambuf for libdebug, used in the per-thread streams of DebugOutStream.
+	/// The data is accumulated in a per-thread buffer, and each complete line
+	/// is sent to the channels as a whole record, so that the output of different
+	/// threads never interleaves within a line.
 	class DebugStreamBuf : public std::streambuf {
 		public:
 
 			/// Constructor
-			explicit DebugStreamBuf(DebugOutStream* dos) : dos_(dos)
+			explicit DebugStreamBuf(std::weak_ptr<DebugOutStream> dos) : dos_(std::move(dos))
 			{
-				// in case of overflow for output, overflow() will be called to _output_ the data.
-
-				// no buffers here - we process it char-by-char.
-				// std::size_t buf_size = 0;
-				// if (buf_size) {
-				// 	char* buf = new char[buf_size];  // further accessible through pbase().
-				// 	setp(buf, buf + buf_size);  // Set output sequence pointers, aka output buffer
-				// } else {
-					setp(nullptr, nullptr);
-				// }
-
+				setp(nullptr, nullptr);  // no put area, the data goes to buffer_ through overflow() / xsputn().
 				setg(nullptr, nullptr, nullptr);  // Set input sequence pointers; not relevant in this class.
 			}
 
@@ -79,15 +75,14 @@ namespace debug_internal {
 			DebugStreamBuf& operator=(DebugStreamBuf&&) = delete;
 
 
-			/// Virtual destructor
+			/// Virtual destructor, sends the unterminated line (if any).
 			~DebugStreamBuf() override
 			{
-				sync();
-				delete[] pbase();  // delete the buffer
+				flush_to_channel();
 			}
 
 
-			/// Force output of the stringstream's contents to the channels.
+			/// Force output of the buffer's contents to the channels.
 			void force_output()
 			{
 				flush_to_channel();
@@ -96,47 +91,37 @@ namespace debug_internal {
 
 		protected:
 
-			/// Overflow happens when a new character is to be written at the put
-			/// pointer pptr position, but this has reached the end pointer epptr.
+			/// Called for each character written, since there is no put area.
 			/// Reimplemented.
 			int overflow(int c) override
 			{
-				sync();  // write the buffer contents if available
 				if (c != traits_type::eof()) {
-					if (pbase() == epptr()) {  // no buffer, write it char-by-char (epptr() - buffer end pointer)
-	// 					std::string tmp;
-	// 					tmp += char(c);
-	// 					write_out(tmp);
-						write_char(char(c));
-					} else {  // we have a buffer
-						// put c into buffer (the overflowed char); the rest is written in sync() earlier.
-						sputc(static_cast<char>(c));
-					}
+					const char ch = traits_type::to_char_type(c);
+					write_data(std::string_view(&ch, 1));
 				}
 				return 0;
 			}
 
 
-			/// Sort-of flush the buffer. Only makes sense if there is a buffer.
+			/// Write a character sequence.
 			/// Reimplemented.
-			int sync() final
+			std::streamsize xsputn(const char* s, std::streamsize count) override
 			{
-				if (pbase() != pptr()) {  // pptr() - current position; condition is true only if there is something in the buffer.
-	// 				write_out(std::string(pbase(), pptr() - pbase()));
-					for (char* pos = pbase(); pos != pptr(); ++pos)
-						write_char(*pos);
-					setp(pbase(), epptr());  // reset the buffer's current pointer (?)
-				}
-				return 0;
+				write_data(std::string_view(s, static_cast<std::size_t>(count)));
+				return count;
 			}
 
 
-			/// Write contents if necessary.
-			void write_char(char c)
+			/// Append the data to the buffer, sending each complete line to the channels.
+			void write_data(std::string_view data)
 			{
-				oss_ << c;
-				if (c == '\n')  // send to channels on newline
+				std::string_view::size_type pos = 0;
+				while ((pos = data.find('\n')) != std::string_view::npos) {  // send to channels on newline
+					buffer_.append(data.substr(0, pos + 1));
 					flush_to_channel();
+					data.remove_prefix(pos + 1);
+				}
+				buffer_.append(data);
 			}
 
 
@@ -146,55 +131,108 @@ namespace debug_internal {
 
 		private:
 
-			DebugOutStream* dos_ = nullptr;  ///< Debug output stream
+			std::weak_ptr<DebugOutStream> dos_;  ///< Debug output stream. May expire before this thread exits.
+
+			std::string buffer_;  ///< Unsent data of the current line, this thread only.
+
+			bool is_first_line_ = true;  ///< Whether it's the first line of output in this thread
+	};
+
+
+
+	/// Per-thread ostream of a DebugOutStream, returned by debug_out().
+	class DebugThreadStream : public std::ostream {
+		public:
+
+			/// Constructor
+			explicit DebugThreadStream(std::weak_ptr<DebugOutStream> dos)
+					: std::ostream(nullptr), buf_(std::move(dos))
+			{ }
+
+			/// Deleted
+			DebugThreadStream(const DebugThreadStream& other) = delete;
+
+			/// Deleted
+			DebugThreadStream(DebugThreadStream&& other) = delete;
+
+			/// Deleted
+			DebugThreadStream& operator=(const DebugThreadStream&) = delete;
+
+			/// Deleted
+			DebugThreadStream& operator=(DebugThreadStream&&) = delete;
+
+			/// Defaulted
+			~DebugThreadStream() override = default;
+
+
+			/// Enable or disable output. If disabled, any data sent to this
+			/// stream is discarded.
+			void set_enabled(bool enabled)
+			{
+				rdbuf(enabled ? &buf_ : &get_null_streambuf());
+			}
+
 
-			std::ostringstream oss_;  ///< A buffer for output storage.
+			/// Force output of buf_'s contents to the channels.
+			void force_output()
+			{
+				buf_.force_output();
+			}
+
+
+		private:
 
+			DebugStreamBuf buf_;  ///< Streambuf for implementation.
 	};
 
 
 
 
-	/// Debug output stream (inherits std::ostream).
-	/// This is returned by debug_out().
-	class DebugOutStream : public std::ostream {
+	/// Debug output stream for a domain / level pair. This holds the settings,
+	/// while the data is written to the per-thread streams returned by get_thread_stream().
+	/// The settings (format, channels) must be changed only when no other thread is writing
+	/// to the stream; the enabled status may be changed at any time.
+	/// Must be owned by std::shared_ptr.
+	class DebugOutStream : public std::enable_shared_from_this<DebugOutStream> {
 		public:
 
 			friend class DebugStreamBuf;
 
 			/// Constructor
 			DebugOutStream(debug_level::flag level, std::string domain, const debug_format::flags& format_flags)
-					: std::ostream(nullptr), level_(level), domain_(std::move(domain)), format_(format_flags), buf_(this)
+					: level_(level), domain_(std::move(domain)), format_(format_flags), id_(get_new_id())
 			{
-				set_enabled(true);  // sets ostream's rdbuf
+				set_enabled(true);
 			}
 
-// 			DebugOutStream() : std::ostream(nullptr), buf_(this)
-// 			{
-// 				set_enabled(false);
-// 			}
-
 			/// Construct with settings from another DebugOutStream.
 			DebugOutStream(const DebugOutStream& other, std::string domain)
-					: std::ostream(nullptr), level_(other.level_), domain_(std::move(domain)), format_(other.format_), buf_(this)
+					: level_(other.level_), domain_(std::move(domain)), format_(other.format_), id_(get_new_id())
 			{
-				set_enabled(other.get_enabled());  // sets ostream's rdbuf
+				set_enabled(other.get_enabled());
 				for (const auto& channel : other.channels_) {
 					channels_.push_back(channel);
 				}
 			}
 
-/*
-			void set_level(debug_level::flag level)
-			{
-				level_ = level;
-			}
+			/// Deleted
+			DebugOutStream(const DebugOutStream& other) = delete;
+
+			/// Deleted
+			DebugOutStream(DebugOutStream&& other) = delete;
+
+			/// Deleted
+			DebugOutStream& operator=(const DebugOutStream&) = delete;
 
-			void set_domain(const std::string& domain)
+			/// Deleted
+			DebugOutStream& operator=(DebugOutStream&&) = delete;
+
+			/// Destructor
+			~DebugOutStream()
 			{
-				domain_ = domain;
+				set_enabled(false);  // update the enabled stream counts
 			}
-*/
+
 
 			/// Set format flags
 			void set_format(const debug_format::flags& format_flags)
@@ -213,17 +251,16 @@ namespace debug_internal {
 			/// stream is discarded.
 			void set_enabled(bool enabled)
 			{
-				if (enabled) {
-					rdbuf(&buf_);
-				} else {
-					rdbuf(&get_null_streambuf());
+				const bool was_enabled = enabled_.exchange(enabled, std::memory_order_relaxed);
+				if (enabled != was_enabled) {
+					enabled_stream_counts[level_].fetch_add(enabled ? 1 : -1, std::memory_order_relaxed);
 				}
 			}
 
 			/// Check whether the stream is enabled or not.
 			[[nodiscard]] bool get_enabled() const
 			{
-				return (rdbuf() == &buf_);
+				return enabled_.load(std::memory_order_relaxed);
 			}
 
 
@@ -247,40 +284,29 @@ namespace debug_internal {
 			}
 
 
-			/// Check if the last sent output is still on the same line
-			/// as the first one.
-			[[nodiscard]] bool get_is_first_line() const
-			{
-				return is_first_line_;
-			}
-
-			/// Set whether we're on the first line of the output or not.
-			void set_is_first_line(bool b)
-			{
-				is_first_line_ = b;
-			}
+			/// Get the stream of the calling thread, creating it if needed.
+			/// The stream is destroyed (sending any unterminated line) when the thread exits.
+			[[nodiscard]] std::ostream& get_thread_stream();
 
 
-			/// Force output of buf_'s contents to the channels.
+			/// Force output of the calling thread's buffer to the channels.
 			/// This also outputs a prefix if needed.
-			std::ostream& force_output()
-			{
-				buf_.force_output();
-				return *this;
-			}
+			void force_output();
 
 
 		private:
 
+			/// Get a unique stream ID, used to find the per-thread streams
+			static std::uint64_t get_new_id();
+
+
 			debug_level::flag level_ = debug_level::dump;  ///< Debug level of this stream
 			std::string domain_;  ///< Domain of this stream
 			debug_format::flags format_;  ///< Format flags
-
-			bool is_first_line_ = true;  ///< Whether it's the first line of output or not
+			std::uint64_t id_ = 0;  ///< Unique ID, never reused
+			std::atomic<bool> enabled_ = false;  ///< Whether the output is enabled
 
 			std::vector<DebugChannelBasePtr> channels_;  ///< Channels that the output is sent to
-
-			DebugStreamBuf buf_;  /// Streambuf for implementation.
 	};
 
 
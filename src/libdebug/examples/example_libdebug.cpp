@@ -124,7 +124,7 @@ int main_impl()
 
 
 
-	std::ostream& os = debug_out_dump("default", "");  // get the ostream
+	std::ostream& os = debug_out(debug_level::dump, "default");  // get the ostream
 	os << "";
 
 
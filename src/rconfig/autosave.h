@@ -63,6 +63,10 @@ extern "C" {
 		if (!force && !impl::autosave_enabled)  // no more autosaves
 			return FALSE;  // remove timeout, disable autosave for real.
 
+		if (!force && !rconfig::has_unsaved_changes()) {
+			return TRUE;  // nothing to save, continue timeouts
+		}
+
 		auto file = impl::autosave_config_file;
 		debug_out_info("rconfig", "Autosaving config to \"" << file << "\"." << std::endl);
 
@@ -12,6 +12,8 @@ Copyright:
 #ifndef RCONFIG_LOADSAVE_H
 #define RCONFIG_LOADSAVE_H
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 #include "hz/debug.h"
@@ -24,6 +26,13 @@ Copyright:
 namespace rconfig {
 
 
+namespace impl {
+
+	inline std::atomic<std::uint64_t> saved_generation = 0;  ///< Config generation at the last load or save
+
+}
+
+
 
 /// Load the config branch from file.
 inline bool load_from_file(const hz::fs::path& file)
@@ -38,6 +47,8 @@ inline bool load_from_file(const hz::fs::path& file)
 
 	try {
 		get_config_branch() = json::parse(json_str);
+		++impl::generation;
+		impl::saved_generation = impl::generation.load();
 	}
 	catch (json::parse_error& e) {
 		debug_out_warn("rconfig", "Cannot load config file \""
@@ -49,22 +60,32 @@ inline bool load_from_file(const hz::fs::path& file)
 
 
 
-/// Save the config branch to a file.
+/// Save the config branch to a file. The file is replaced atomically.
 inline bool save_to_file(const hz::fs::path& file)
 {
+	const std::uint64_t generation = get_generation();
 	const std::string json_str = get_config_branch().dump(4);
 
-	auto ec = hz::fs_file_put_contents(file, json_str);
+	auto ec = hz::fs_file_put_contents_atomic(file, json_str);
 	if (ec) {
 		debug_out_error("rconfig", DBG_FUNC_MSG
 				<< "Unable to write to file \"" << file << "\": " << ec.message() << "." << std::endl);
 		return false;
 	}
+	impl::saved_generation = generation;
 	return true;
 }
 
 
 
+/// Check whether the config was modified since it was last loaded or saved.
+[[nodiscard]] inline bool has_unsaved_changes()
+{
+	return impl::saved_generation.load() != get_generation();
+}
+
+
+
 
 
 }  // ns
@@ -14,8 +14,13 @@ Copyright:
 
 #include "nlohmann/json.hpp"
 
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <stdexcept>  // std::runtime_error
 
@@ -35,25 +40,26 @@ namespace impl {
 
 	inline std::unique_ptr<json> config_node;  ///< Node for serializable branch
 	inline std::unique_ptr<json> default_node;  ///< Node for default branch
+	inline std::atomic<std::uint64_t> generation = 0;  ///< Incremented on each modification, see get_generation()
 
 
 	template<typename T>
 	inline void set_node_data(json& root, const std::string& path, T&& value)
 	{
-		std::vector<std::string> components;
-		hz::string_split(path, '/', components, true);
+		const auto components = hz::string_split_view(path, '/', true);
 
 		json* curr = &root;
-		for (std::size_t comp_index = 0; comp_index < components.size(); ++comp_index) {
-			const std::string& comp_name = components[comp_index];
+		for (auto comp_iter = components.begin(); comp_iter != components.end(); ) {
+			const std::string_view comp_name = *comp_iter;
+			const bool is_last = (++comp_iter == components.end());  // it's the "value" component
 
 			// we can't have non-object values in the middle of a path
 			if (!curr->is_object()) {
-				throw std::runtime_error("Cannot set node data \""s + path + "\", component \"" + comp_name + "\" is not an object.");
+				throw std::runtime_error("Cannot set node data \""s + path + "\", component \"" + std::string(comp_name) + "\" is not an object.");
 			}
 			if (auto iter = curr->find(comp_name); iter != curr->end()) {  // path component exists
 				json& jval = iter.value();
-				if (comp_index + 1 == components.size()) {  // it's the "value" component
+				if (is_last) {
 					jval = json(std::forward<T>(value));
 					break;
 				}
@@ -61,23 +67,30 @@ namespace impl {
 				curr = &jval;
 
 			} else {  // path component doesn't exist
-				if (comp_index + 1 == components.size()) {  // it's the "value" component
-					(*curr)[comp_name] = json(std::forward<T>(value));
+				if (is_last) {
+					(*curr)[std::string(comp_name)] = json(std::forward<T>(value));
 					break;
 				}
-				curr = &((*curr)[comp_name] = json::object());
+				curr = &((*curr)[std::string(comp_name)] = json::object());
 			}
 		}
 	}
 
 
 
-	template<typename T>
-	bool get_node_data(json& root, const std::string& path, T& value)
+	/// Split the path into components
+	[[nodiscard]] inline std::vector<std::string> split_path(const std::string& path)
 	{
 		std::vector<std::string> components;
 		hz::string_split(path, '/', components, true);
+		return components;
+	}
 
+
+
+	template<typename T>
+	bool get_node_data(json& root, const std::vector<std::string>& components, const std::string& path, T& value)
+	{
 		json* curr = &root;
 		for (std::size_t comp_index = 0; comp_index < components.size(); ++comp_index) {
 			const std::string& comp_name = components[comp_index];
@@ -102,24 +115,53 @@ namespace impl {
 	}
 
 
+
+	template<typename T>
+	bool get_node_data(json& root, const std::string& path, T& value)
+	{
+		const auto components = hz::string_split_view(path, '/', true);
+
+		json* curr = &root;
+		for (auto comp_iter = components.begin(); comp_iter != components.end(); ) {
+			const std::string_view comp_name = *comp_iter;
+			const bool is_last = (++comp_iter == components.end());  // it's the "value" component
+
+			if (!curr->is_object()) {  // we can't have non-object values in the middle of a path
+				throw std::runtime_error("Cannot get node data \""s + path + "\", component \"" + std::string(comp_name) + "\" is not an object.");
+			}
+			auto iter = curr->find(comp_name);
+			if (iter == curr->end()) {  // path component doesn't exist
+				break;
+			}
+			if (is_last) {
+				value = iter.value().get<T>();  // may throw json::type_error
+				return true;
+			}
+			// continue to the next component
+			curr = &iter.value();
+		}
+		return false;
+	}
+
+
 	inline void unset_node_data(json& root, const std::string& path)
 	{
-		std::vector<std::string> components;
-		hz::string_split(path, '/', components, true);
+		const auto components = hz::string_split_view(path, '/', true);
 
 		json* curr = &root;
-		for (std::size_t comp_index = 0; comp_index < components.size(); ++comp_index) {
-			const std::string& comp_name = components[comp_index];
+		for (auto comp_iter = components.begin(); comp_iter != components.end(); ) {
+			const std::string_view comp_name = *comp_iter;
+			const bool is_last = (++comp_iter == components.end());  // it's the "value" component
 
 			if (auto iter = curr->find(comp_name); iter != curr->end()) {  // path component exists
 				json& jval = iter.value();
-				if (comp_index + 1 == components.size()) {  // it's the "value" component
-					curr->erase(comp_name);
+				if (is_last) {
+					curr->erase(iter);
 					break;
 				}
 				if (!jval.is_object()) {  // we can't have non-object values in the middle of a path
-					debug_out_error("rconfig", "Component \""s + comp_name + "\" in path \"" + path + "\" is not an object, removing it.");
-					curr->erase(comp_name);
+					debug_out_error("rconfig", "Component \""s + std::string(comp_name) + "\" in path \"" + path + "\" is not an object, removing it.");
+					curr->erase(iter);
 					break;
 				}
 				// continue to the next component
@@ -140,6 +182,7 @@ namespace impl {
 inline void clear_config()
 {
 	impl::config_node = std::make_unique<json>(json::object());
+	++impl::generation;
 }
 
 
@@ -147,6 +190,7 @@ inline void clear_config()
 inline void clear_defaults()
 {
 	impl::default_node = std::make_unique<json>(json::object());
+	++impl::generation;
 }
 
 
@@ -182,6 +226,16 @@ inline bool init_root()
 
 
 
+/// Get the config generation. It changes each time the config or the defaults are modified
+/// through rconfig functions, so that the values decoded from config can be cached
+/// by the callers and invalidated when it changes.
+[[nodiscard]] inline std::uint64_t get_generation()
+{
+	return impl::generation.load();
+}
+
+
+
 /// Set the data in path
 template<typename T>
 bool set_data(const std::string& path, T data)
@@ -193,8 +247,10 @@ bool set_data(const std::string& path, T data)
 	}
 	catch (std::exception& e) {
 		debug_out_error("rconfig", e.what());
+		++impl::generation;  // the node may have been partially modified
 		return false;
 	}
+	++impl::generation;
 	return true;
 }
 
@@ -206,6 +262,7 @@ void set_default_data(const std::string& path, T data)
 {
 	// Default data branch must always be valid, so abort if anything is wrong.
 	impl::set_node_data(get_default_branch(), path, std::move(data));
+	++impl::generation;
 }
 
 
@@ -251,10 +308,91 @@ template<typename T>
 inline void unset_data(const std::string& path)
 {
 	impl::unset_node_data(get_config_branch(), path);
+	++impl::generation;
 }
 
 
 
+/// A typed config key. The path is split once, and the value is cached until
+/// the config changes (see get_generation()), so this is cheap enough to use in loops
+/// and cell renderers. Thread-safe, as long as the config itself is not modified concurrently.
+/// Usually declared as a function-local static:
+/// \code
+/// static const rconfig::Key<bool> show_smart_capable_only("gui/show_smart_capable_only");
+/// if (show_smart_capable_only.get()) { ... }
+/// \endcode
+template<typename T>
+class Key {
+	public:
+
+		/// Constructor
+		explicit Key(std::string path)
+				: path_(std::move(path)), components_(impl::split_path(path_))
+		{ }
+
+
+		/// Get the path
+		[[nodiscard]] const std::string& get_path() const
+		{
+			return path_;
+		}
+
+
+		/// Get the data from config, or from defaults if there's no such node in config.
+		/// Same as get_data<T>(get_path()).
+		[[nodiscard]] T get() const
+		{
+			const std::scoped_lock lock(mutex_);
+			// Read the generation before the data, so that a concurrent change re-reads it next time.
+			const std::uint64_t generation = get_generation();
+			if (!value_.has_value() || generation_ != generation) {
+				value_ = read();
+				generation_ = generation;
+			}
+			return value_.value();
+		}
+
+
+		/// Set the data in config. Same as set_data(get_path(), data).
+		bool set(T data) const
+		{
+			return set_data(path_, std::move(data));
+		}
+
+
+	private:
+
+		/// Read the data from config, falling back to defaults
+		[[nodiscard]] T read() const
+		{
+			T data = {};
+			bool found = false;
+			try {
+				// This can possibly throw because the user config file is incorrect
+				found = impl::get_node_data(get_config_branch(), components_, path_, data);
+			}
+			catch(std::exception& e) {
+				debug_out_error("rconfig", e.what());
+			}
+
+			// This can throw only for errors within the program.
+			if (!found && !impl::get_node_data(get_default_branch(), components_, path_, data)) {
+				throw std::runtime_error("No such node: "s + path_);
+			}
+			return data;
+		}
+
+
+		std::string path_;  ///< Config path
+		std::vector<std::string> components_;  ///< Path components
+		mutable std::mutex mutex_;  ///< Mutex for the cached value
+		mutable std::optional<T> value_;  ///< Cached value
+		mutable std::uint64_t generation_ = 0;  ///< Config generation of the cached value
+
+};
+
+
+
 /// Dump config to debug output
 inline void dump_config(bool print_defaults = false)
 {
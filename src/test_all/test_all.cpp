@@ -17,13 +17,58 @@ Copyright:
 #define CATCH_CONFIG_RUNNER
 #include "catch2/catch.hpp"
 
+#include <cstdlib>
+#include <iostream>
+#include <new>
 
+#include "hz/alloc_tracking.h"
 #include "libdebug/libdebug.h"
 
 
 
+#ifdef APP_TEST_ALLOCATION_TRACKING
+
+// Count the allocations, enabling the allocation budget checks (see hz::AllocTrackingScope).
+HZ_ALLOC_TRACKING_DEFINE_OPERATORS()
+
+
+namespace {
+
+	/// Reports the allocations of each test case
+	struct AllocationReporter : Catch::TestEventListenerBase {
+		using TestEventListenerBase::TestEventListenerBase;
+
+		void testCaseStarting(const Catch::TestCaseInfo& test_info) override
+		{
+			TestEventListenerBase::testCaseStarting(test_info);
+			start_ = hz::alloc_tracking_get_stats();
+		}
+
+		void testCaseEnded(const Catch::TestCaseStats& test_case_stats) override
+		{
+			const hz::AllocStats now = hz::alloc_tracking_get_stats();
+			std::cout << "Allocations in \"" << test_case_stats.testInfo.name << "\": "
+					<< (now.count - start_.count) << " (" << (now.bytes - start_.bytes) << " bytes)\n";
+			TestEventListenerBase::testCaseEnded(test_case_stats);
+		}
+
+		hz::AllocStats start_;  ///< Counts at the start of the current test case
+	};
+
+}
+
+CATCH_REGISTER_LISTENER(AllocationReporter)
+
+#endif
+
+
+
 int main(int argc, char* argv[])
 {
+#ifdef APP_TEST_ALLOCATION_TRACKING
+	hz::alloc_tracking_set_installed(true);
+#endif
+
 	debug_register_domain("gtk");
 	debug_register_domain("app");
 	debug_register_domain("hz");